@@ -0,0 +1,49 @@
+#ifndef APP_ARENA_H
+#define APP_ARENA_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Static memory arena.
+ *
+ * Carves buffers out of one caller-owned static pool instead of giving each
+ * its own static array, so buffers that are never live together can share
+ * the same bytes. Allocation is a bump pointer, 8-byte aligned; nothing is
+ * freed one by one, a layout is rebuilt from Init(). Control side only (boot
+ * or preset time): the audio path only ever sees the pointers.
+ *
+ * An overlay groups members that exclude each other: each OverlayNext()
+ * starts the next member at the overlay's base again, and OverlayEnd()
+ * continues after the largest one. Which member may touch the shared bytes
+ * at a given time is the owner's business, not the arena's.
+ */
+typedef struct
+{
+  uint8_t *base;
+  uint32_t size;
+  uint32_t used;       /* bytes carved so far, overlays counted once */
+  uint32_t wanted;     /* bytes the same carves would take without overlays */
+  uint32_t ov_base;    /* start of the open overlay */
+  uint32_t ov_top;     /* end of its largest member so far */
+  uint8_t ov_open;
+} AppArena;
+
+#define APP_ARENA_ALIGN(bytes)  (((uint32_t)(bytes) + 7u) & ~7u)
+
+void AppArena_Init(AppArena *a, void *pool, uint32_t size);
+
+/* NULL when it does not fit (the arena is left as it was). */
+void *AppArena_Alloc(AppArena *a, uint32_t bytes);
+
+void AppArena_OverlayBegin(AppArena *a);
+void AppArena_OverlayNext(AppArena *a);
+void AppArena_OverlayEnd(AppArena *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_ARENA_H */
@@ -2,16 +2,462 @@
 #define APP_AUDIO_H
 
 #include <stdint.h>
+#include "app_dsp.h"
+#include "app_mem.h"
 #include "main.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Nominal I2S frame rate (MX_I2S{2,3}_Init switch to I2S_AUDIOFREQ_96K for
+ * a 96 kHz build).
+ */
+#define APP_AUDIO_SAMPLE_RATE_HZ APP_DSP_SAMPLE_RATE_HZ
+
+/* Single clock domain: I2S3 (DAC) runs as slave on the I2S2 (ADC) bit and
+ * word clocks (wire PB13->PC10 CK and PB12->PA4 WS). Both streams then move
+ * in lockstep, so the DSP output is packed straight into the TX half-buffer
+ * and the ring + adaptive resampler are compiled out.
+ */
+#ifndef APP_AUDIO_SYNC_CLOCK
+#define APP_AUDIO_SYNC_CLOCK 0
+#endif
+
+/* Zero-copy pipeline (needs APP_AUDIO_SYNC_CLOCK): RX and TX DMA share one
+ * buffer. Each RX half is processed in place and TX, started one block late,
+ * plays it from the same memory. Saves the TX buffer and about one block of
+ * latency.
+ */
+#ifndef APP_AUDIO_PIPELINE
+#define APP_AUDIO_PIPELINE 0
+#endif
+
+#if APP_AUDIO_PIPELINE && !APP_AUDIO_SYNC_CLOCK
+#error "APP_AUDIO_PIPELINE requires APP_AUDIO_SYNC_CLOCK"
+#endif
+
+/* External I2S kernel clock: both I2S masters run from an audio crystal on
+ * I2S_CKIN (PC9, EXTERNAL_CLOCK_VALUE in stm32g4xx_hal_conf.h) instead of
+ * SYSCLK, which no I2S divider splits into 48 kHz exactly. The crystal must
+ * be a multiple of 64 x the frame rate, so I2S2 drops its MCLK output (the
+ * codecs take MCLK from the crystal too). With both dividers equal the rates
+ * are identical: AppAudio_Start() sees that from the registers and the TX
+ * fill copies the ring unresampled (CLOCK exact=1).
+ */
+#ifndef APP_AUDIO_EXT_CLOCK
+#define APP_AUDIO_EXT_CLOCK 0
+#endif
+
+#if APP_AUDIO_EXT_CLOCK
+#if ((EXTERNAL_CLOCK_VALUE % (64u * APP_AUDIO_SAMPLE_RATE_HZ)) != 0u) || \
+    ((EXTERNAL_CLOCK_VALUE / (64u * APP_AUDIO_SAMPLE_RATE_HZ)) < 4u)
+#error "APP_AUDIO_EXT_CLOCK: EXTERNAL_CLOCK_VALUE must be 4 or more times 64 x APP_AUDIO_SAMPLE_RATE_HZ"
+#endif
+#endif
+
+/* Run the DSP block from PendSV (lowest priority) instead of the I2S RX DMA
+ * ISR, so TX refill and UART interrupts can preempt it. Set to 0 to process
+ * inside the DMA callback as before.
+ */
+#ifndef APP_AUDIO_DEFER_DSP
+#define APP_AUDIO_DEFER_DSP 1
+#endif
+
+/* Lean DMA interrupts: the I2S DMA channel handlers (stm32g4xx_it.c) read
+ * and clear the half/full-transfer flags themselves and go straight to the
+ * audio path, instead of HAL_DMA_IRQHandler() -> the HAL I2S DMA callbacks
+ * -> HAL_I2S_*CpltCallback() -> AppAudio_On*() with its handle compare.
+ * Shorter and steadier interrupt entry, which counts at 16-frame blocks.
+ * Transfer errors still take the HAL path, so AppAudio_OnError() and the
+ * restart in AppAudio_Poll() are unchanged.
+ */
+#ifndef APP_AUDIO_LEAN_IRQ
+#define APP_AUDIO_LEAN_IRQ 0
+#endif
+
+/* Deadline misses: after each DSP block the RX DMA position is checked; if
+ * DMA is back in the half just processed, the next half completed while it
+ * ran and is already late. That half then skips the DSP and plays the last
+ * block again, crossfaded in and out over APP_AUDIO_JOIN_FRAMES, so the
+ * audio path catches up with a repeat instead of whatever the late buffer
+ * holds. Misses are counted (COM LOAD miss=) and count as blocks over
+ * budget for load shedding (APP_DSP_SHED). 0 only counts them.
+ */
+#ifndef APP_AUDIO_MISS_REPEAT
+#define APP_AUDIO_MISS_REPEAT 1
+#endif
+
+/* Crossfade at each end of a repeated block; at most the smallest profile. */
+#ifndef APP_AUDIO_JOIN_FRAMES
+#define APP_AUDIO_JOIN_FRAMES 16u
+#endif
+
+/* Callback jitter (COM JITTER): a DWT stamp at every RX and TX half-complete
+ * and a histogram, per stream, of how far each interval between two of
+ * them strays from the nominal half period (frames / sample rate). Shows
+ * what the TIM2 timebase, the UART and the PendSV handoff do to the
+ * callbacks.
+ */
+#ifndef APP_AUDIO_JITTER
+#define APP_AUDIO_JITTER 1
+#endif
+
+/* Bin 0: under 1 us; bin k: [2^(k-1), 2^k) us; the last bin takes the rest. */
+#define APP_AUDIO_JITTER_BINS 10u
+
+/* Largest DMA half-buffer the build reserves RAM for (power of two).
+ * The ring is sized 4x this, so 128 costs ~4 KB more RAM than 64.
+ */
+#ifndef APP_AUDIO_MAX_FRAMES_PER_HALF
+#define APP_AUDIO_MAX_FRAMES_PER_HALF 64u
+#endif
+
+/* Static RAM share (app_profile.h), 72 bytes per frame of the largest
+ * half: the RX and TX DMA buffers (both halves), the 4x ring and the block.
+ */
+#define APP_AUDIO_RAM_BYTES (APP_AUDIO_MAX_FRAMES_PER_HALF * 72u)
+
+/* Latency profiles: frames per DMA half-buffer; the ring target starts at
+ * 2 halves (see APP_AUDIO_RING_ADAPT).
+ */
+typedef enum
+{
+  APP_AUDIO_LATENCY_LOW = 0,  /* 16 frames: live monitoring, light FX */
+  APP_AUDIO_LATENCY_MID,      /* 32 frames */
+  APP_AUDIO_LATENCY_SAFE,     /* 64 frames: heavy FX chains (default) */
+  APP_AUDIO_LATENCY_LARGE,    /* 128 frames: needs APP_AUDIO_MAX_FRAMES_PER_HALF >= 128 */
+  APP_AUDIO_LATENCY_COUNT
+} AppAudioLatency;
+
+#ifndef APP_AUDIO_LATENCY_DEFAULT
+#define APP_AUDIO_LATENCY_DEFAULT APP_AUDIO_LATENCY_SAFE
+#endif
+
+/* Adaptive ring target (not in sync-clock mode). A profile starts at two
+ * halves of fill; every APP_AUDIO_RING_ADAPT_MS without an underrun the
+ * target drops APP_AUDIO_RING_ADAPT_STEP frames, down to one half plus
+ * APP_AUDIO_RING_FLOOR_MARGIN. An underrun raises it by half a block (up to
+ * APP_AUDIO_RING_CEIL_HALVES halves) and keeps it a step above the level
+ * that failed until the next start, so each board settles on the smallest
+ * fill its clock mismatch and DSP load allow. 0 keeps the fixed two halves.
+ */
+#ifndef APP_AUDIO_RING_ADAPT
+#define APP_AUDIO_RING_ADAPT 1
+#endif
+
+#ifndef APP_AUDIO_RING_ADAPT_MS
+#define APP_AUDIO_RING_ADAPT_MS 1000u
+#endif
+
+#ifndef APP_AUDIO_RING_ADAPT_STEP
+#define APP_AUDIO_RING_ADAPT_STEP 4u
+#endif
+
+#ifndef APP_AUDIO_RING_FLOOR_MARGIN
+#define APP_AUDIO_RING_FLOOR_MARGIN 8u
+#endif
+
+#ifndef APP_AUDIO_RING_CEIL_HALVES
+#define APP_AUDIO_RING_CEIL_HALVES 3u
+#endif
+
+/* Just-in-time TX phase (not in sync-clock mode). Started together, the
+ * RX events fall just behind the TX ones, so each processed block lands in
+ * the ring right after the TX fill that could have taken it and waits
+ * almost a whole half for the next. Instead RX starts alone: its first
+ * APP_AUDIO_TX_ALIGN_WARMUP blocks measure how long after the DMA event a
+ * block is in the ring, and TX is started that long plus
+ * APP_AUDIO_TX_ALIGN_MARGIN_US after an RX event, so every TX fill finds
+ * the block that just landed. Up to one half less latency (1.3 ms at 64
+ * frames) for no CPU. A preset heavier than the one running at start
+ * underruns the ring and the adaptive target absorbs it. LATENCY reports
+ * the lead; 0 starts TX first as before.
+ */
+#ifndef APP_AUDIO_TX_ALIGN
+#define APP_AUDIO_TX_ALIGN 1
+#endif
+
+#ifndef APP_AUDIO_TX_ALIGN_WARMUP
+#define APP_AUDIO_TX_ALIGN_WARMUP 8u
+#endif
+
+#ifndef APP_AUDIO_TX_ALIGN_MARGIN_US
+#define APP_AUDIO_TX_ALIGN_MARGIN_US 100u
+#endif
+
+/* Drift-compensation resampler used by the TX fill (not in sync-clock mode).
+ * Cycle costs are rough Cortex-M4 figures per stereo output frame; check the
+ * real number with the COM LOAD "tx=" field.
+ */
+typedef enum
+{
+  APP_AUDIO_RESAMPLER_LINEAR = 0,  /* 2-tap linear:   ~25 cycles, error -15 dB at 9.6 kHz */
+  APP_AUDIO_RESAMPLER_HERMITE,     /* 4-point cubic:  ~50 cycles, -26 dB at 9.6 kHz */
+  APP_AUDIO_RESAMPLER_FIR,         /* 8-tap polyphase sinc, 32 phases blended: ~150 cycles, -48 dB */
+  APP_AUDIO_RESAMPLER_COUNT
+} AppAudioResampler;
+
+#ifndef APP_AUDIO_RESAMPLER_DEFAULT
+#define APP_AUDIO_RESAMPLER_DEFAULT APP_AUDIO_RESAMPLER_LINEAR
+#endif
+
 void AppAudio_Init(I2S_HandleTypeDef *rx_i2s, I2S_HandleTypeDef *tx_i2s);
 void AppAudio_Start(void);
 
+/* Stops both I2S streams for main-loop work that needs the DSP to itself
+ * (COM BENCH) and lends the DSP block buffer as scratch, *frames long.
+ * AppAudio_Resume() restarts the streams if they were running.
+ */
+AppStereoS24 *AppAudio_Pause(uint32_t *frames);
+void AppAudio_Resume(void);
+
+/* Kernel microbenchmarks of the audio path (COM BENCH KERNEL, while
+ * paused): the DMA slot conversions and the TX fill's resampler engines,
+ * 'blocks' blocks of 'frames' frames (at most the AppAudio_Pause() count)
+ * of noise, once per frame (per_frame != 0) or once per block. Returns the
+ * DWT cycles spent inside, 0 for an engine the build does not have.
+ */
+typedef enum
+{
+  APP_AUDIO_KERNEL_LJ24_UNPACK = 0,   /* lj24_unpack_block, RX slots -> s24 */
+  APP_AUDIO_KERNEL_LJ24_PACK,         /* lj24_pack_block, s24 -> TX slots */
+  APP_AUDIO_KERNEL_RESAMPLE_LINEAR,   /* resample_frames(), each engine, */
+  APP_AUDIO_KERNEL_RESAMPLE_HERMITE,  /* TX slots out */
+  APP_AUDIO_KERNEL_RESAMPLE_FIR,
+  APP_AUDIO_KERNEL_COUNT
+} AppAudioKernel;
+
+const char *AppAudio_KernelName(AppAudioKernel kernel);
+uint64_t AppAudio_BenchKernel(AppAudioKernel kernel, uint8_t per_frame, uint32_t frames, uint32_t blocks);
+
 uint8_t AppAudio_StartFailed(void);
+uint8_t AppAudio_RuntimeFailed(void);
+
+/* Select a latency profile. Safe from the main loop: if audio is running the
+ * I2S DMA streams are stopped and restarted with the new block size.
+ * Returns 0 if the profile does not fit this build or the restart failed.
+ */
+uint8_t AppAudio_SetLatency(AppAudioLatency profile);
+AppAudioLatency AppAudio_GetLatency(void);
+uint32_t AppAudio_GetFramesPerHalf(void);
+uint32_t AppAudio_GetRingTargetFrames(void);
+/* Adaptive target bounds for the current profile: floor and ceiling, and
+ * the lowest level it may still try (a step above the last underrun).
+ * All 0 when the target is fixed.
+ */
+void AppAudio_GetRingTargetRange(uint32_t *floor_frames, uint32_t *ceil_frames, uint32_t *low_frames);
+/* Returns 0 if the engine is unknown or the build has no resampler. */
+uint8_t AppAudio_SetResampler(AppAudioResampler engine);
+AppAudioResampler AppAudio_GetResampler(void);
+
+/* Estimated input->output buffering in frames for the current profile. */
+uint32_t AppAudio_GetLatencyFrames(void);
+
+/* RX event to TX event offset the last start aligned to (APP_AUDIO_TX_ALIGN),
+ * us; 0 when not aligned.
+ */
+uint32_t AppAudio_GetTxLeadUs(void);
+
+/* Round-trip latency test (COM LTEST): with a cable from the output to the
+ * input, the DSP is bypassed and APP_AUDIO_LTEST_RUNS impulses are played
+ * into silence and found again on RX. The delay is counted in RX frames
+ * from the output position of the impulse to the peak it comes back as:
+ * the same number as the analog-to-analog latency of the pedal. Set to 0
+ * to compile it out (COM answers ERR LTEST DISABLED).
+ */
+#ifndef APP_AUDIO_LTEST_ENABLE
+#define APP_AUDIO_LTEST_ENABLE 1
+#endif
+
+#ifndef APP_AUDIO_LTEST_RUNS
+#define APP_AUDIO_LTEST_RUNS 8u
+#endif
+
+typedef enum
+{
+  APP_AUDIO_LTEST_IDLE = 0,
+  APP_AUDIO_LTEST_RUNNING,
+  APP_AUDIO_LTEST_DONE,
+  APP_AUDIO_LTEST_NO_SIGNAL, /* an impulse did not come back (no loopback?) */
+  APP_AUDIO_LTEST_NOISY,     /* input too loud in the silence before the first impulse */
+  APP_AUDIO_LTEST_ABORTED    /* audio restarted or a DSP block was dropped */
+} AppAudioLtestState;
+
+typedef struct
+{
+  AppAudioLtestState state;
+  uint32_t runs;            /* impulses found so far */
+  uint32_t min_frames;      /* analog-to-analog latency over the runs */
+  uint32_t max_frames;      /* (max - min: ring fill jitter, async clocks) */
+  uint32_t avg_frames_x10;
+  uint32_t dma_frames;      /* DMA halves: RX capture + TX queue (AppAudio_GetLatencyFrames() - ring) */
+  uint32_t ring_frames;     /* ring fill target, 0 with APP_AUDIO_SYNC_CLOCK */
+  int32_t  conv_frames_x10; /* the rest: ADC + DAC group delay (avg - dma - ring) */
+  uint32_t dwt_us;          /* DWT time from the emitting to the detecting block, avg */
+  uint32_t noise_peak;      /* s24 input peak in the settle silence */
+  uint32_t level;           /* s24 peak of the returned impulse, last run */
+} AppAudioLtest;
+
+/* Starts a test. Returns 0 if audio is not running, a test already runs or
+ * the build has none.
+ */
+uint8_t AppAudio_StartLatencyTest(void);
+void AppAudio_GetLatencyTest(AppAudioLtest *out);
+
+/* Audio-path integrity test (COM ITEST), for proving that control traffic
+ * does not disturb the audio: from a cleared DSP state (audio stops for the
+ * reset, as for COM BENCH), 'blocks' blocks of a fixed pattern (a 110 Hz
+ * saw at -24 dBFS plus noise at -48 dBFS) replace the input, and the chain
+ * output is hashed (FNV-1a, before the start fade). With the parameters
+ * left alone, runs of the same length and block size must hash alike,
+ * whatever the COM links did meanwhile: ref/match compare with the last
+ * finished run. A half dropped for lateness is not hashed (the pattern
+ * goes on from where it was), but shows in dsp_late and miss; a chain
+ * that sheds load changes the hash. The counters are deltas over the run.
+ * The pattern plays through to the DAC. Set to 0 to compile it out (COM
+ * answers ERR ITEST DISABLED).
+ */
+#ifndef APP_AUDIO_ITEST_ENABLE
+#define APP_AUDIO_ITEST_ENABLE 1
+#endif
+
+typedef enum
+{
+  APP_AUDIO_ITEST_IDLE = 0,
+  APP_AUDIO_ITEST_RUNNING,
+  APP_AUDIO_ITEST_DONE,
+  APP_AUDIO_ITEST_ABORTED   /* audio restarted or stopped during the run */
+} AppAudioItestState;
+
+typedef struct
+{
+  AppAudioItestState state;
+  uint32_t blocks;          /* hashed so far */
+  uint32_t total;           /* asked for */
+  uint32_t frames;          /* block size of the run */
+  uint32_t hash;
+  uint32_t ref_hash;        /* the last finished run's, if ref_blocks != 0 */
+  uint32_t ref_blocks;      /* its length (0: none yet) */
+  uint32_t ref_frames;
+  uint32_t underrun;        /* over the run: ring underruns, */
+  uint32_t overflow;        /* overflows, */
+  uint32_t i2s_errors;      /* I2S error incidents, */
+  uint32_t dsp_late;        /* halves overtaken by DMA, */
+  uint32_t deadline_miss;   /* DSP blocks run into the next half */
+  uint32_t sheds;           /* and load-shedding steps */
+} AppAudioItest;
+
+/* Starts a test (main loop). Returns 0 if audio is not running, a test
+ * (this or LTEST) already runs, blocks is 0 or the build has none.
+ */
+uint8_t AppAudio_StartIntegrityTest(uint32_t blocks);
+void AppAudio_GetIntegrityTest(AppAudioItest *out);
+
+/* Audio-path health counters and ISR timing (DWT cycles, see app_prof.h). */
+typedef struct
+{
+  uint32_t period_cycles;   /* cycles in one half-buffer period */
+  uint32_t rx_avg_cycles;   /* process_rx_half(), smoothed (PendSV when deferred) */
+  uint32_t rx_max_cycles;
+  uint32_t tx_avg_cycles;   /* tx_fill_half(), smoothed */
+  uint32_t tx_max_cycles;
+  uint32_t isr_max_cycles;  /* worst single audio callback since boot */
+  uint32_t ring_underrun;
+  uint32_t ring_overflow;
+  uint32_t i2s_error_count;
+  uint32_t dsp_late;        /* RX halves overtaken by DMA before PendSV processed them */
+  uint32_t deadline_miss;   /* DSP blocks that ran into the next half (APP_AUDIO_MISS_REPEAT) */
+  uint32_t i2s_recoveries;  /* incidents AppAudio_Poll() restarted the streams for */
+  uint32_t glitch_us;       /* total error-to-restart time of those */
+  uint32_t ring_frames;     /* TX ring size, 0 in APP_AUDIO_SYNC_CLOCK builds */
+  uint32_t ring_peak;       /* highest ring fill since boot / AppAudio_ResetRingPeak() */
+} AppAudioStats;
+
+void AppAudio_GetStats(AppAudioStats *out);
+
+/* I2S error recovery. A DMA error (HAL error callback), or an RX overrun,
+ * TX underrun or frame error seen at a half-buffer callback, is logged and
+ * handed to the main loop: AppAudio_Poll() restarts both streams on a ring
+ * pre-filled to its target, keeping the drift estimate, and the output
+ * fades back in over APP_AUDIO_RECOVER_FADE_MS (>= 1; every start fades).
+ * Only a failed restart leaves AppAudio_RuntimeFailed() set.
+ */
+#ifndef APP_AUDIO_RECOVER_FADE_MS
+#define APP_AUDIO_RECOVER_FADE_MS 10u
+#endif
+
+#define APP_AUDIO_ERR_LOG_LEN 8u
+
+typedef enum
+{
+  APP_AUDIO_ERR_DMA = 0,  /* DMA transfer error: the stream stopped */
+  APP_AUDIO_ERR_OVR,      /* RX overrun: samples lost, L/R may be swapped */
+  APP_AUDIO_ERR_UDR,      /* TX underrun */
+  APP_AUDIO_ERR_FRE       /* frame error (slave stream lost WS sync) */
+} AppAudioErrKind;
+
+typedef struct
+{
+  uint32_t seq;       /* incident number since boot, from 1 */
+  uint32_t tick_ms;   /* HAL_GetTick() at the error */
+  uint32_t gap_us;    /* error to restarted streams, 0 if not recovered */
+  uint16_t hal_code;  /* HAL_I2S_ERROR_* of the stream */
+  uint8_t  tx;        /* 0: RX stream (I2S2), 1: TX stream (I2S3) */
+  uint8_t  kind;      /* AppAudioErrKind */
+  uint8_t  recovered;
+} AppAudioErrEvent;
+
+/* Main-loop work of the audio path (error recovery). */
+void AppAudio_Poll(void);
+
+/* Copies up to 'max' of the last APP_AUDIO_ERR_LOG_LEN incidents, oldest
+ * first. Returns the count.
+ */
+uint32_t AppAudio_GetErrLog(AppAudioErrEvent *out, uint32_t max);
+void AppAudio_ResetRingPeak(void);
+
+/* After SystemCoreClock changed (AppPower clock steps): rescales the
+ * cycle counts the audio path keeps from AppAudio_Start().
+ */
+void AppAudio_ClockChanged(void);
+
+/* Large static buffers of the module for COM MEM MAP. */
+uint32_t AppAudio_MemMap(const AppMemItem **items);
+
+/* Clock-drift telemetry from the TX resampler. Positive ppm means the ADC
+ * side (I2S2) runs faster than the DAC side (I2S3). ppm values are x10.
+ */
+typedef struct
+{
+  uint8_t  sync_clock;      /* 1: single clock domain, no resampler */
+  uint8_t  locked;          /* step inside the limit and fill error < 1/2 block */
+  uint8_t  exact;           /* identical I2S dividers: ring copied, resampler idle */
+  int32_t  step_q16;        /* last read step, 65536 = 1.0 */
+  int32_t  ppm_x10;         /* instantaneous, from step_q16 */
+  int32_t  est_ppm_x10;     /* integrator: steady-state mismatch estimate */
+  int32_t  est_min_ppm_x10; /* since start / CLOCK RESET */
+  int32_t  est_max_ppm_x10;
+  int32_t  fill_err;        /* smoothed fill - target, frames */
+  uint32_t limit_hits;      /* half-buffers with the step clamped at +/-0.20% */
+} AppAudioClockStats;
+
+void AppAudio_GetClock(AppAudioClockStats *out);
+
+/* Interval deviation of the half-complete callbacks (APP_AUDIO_JITTER),
+ * since the last start or AppAudio_ResetJitter().
+ */
+typedef struct
+{
+  uint32_t count;       /* intervals measured */
+  uint32_t max_us;      /* largest |interval - period| */
+  uint32_t hist[APP_AUDIO_JITTER_BINS];
+} AppAudioJitter;
+
+/* period_us: the nominal interval. Returns 0 when compiled out. */
+uint8_t AppAudio_GetJitter(AppAudioJitter *rx, AppAudioJitter *tx, uint32_t *period_us);
+void AppAudio_ResetJitter(void);
+void AppAudio_ResetClockStats(void);
 
 void AppAudio_OnRxHalfCplt(I2S_HandleTypeDef *hi2s);
 void AppAudio_OnRxCplt(I2S_HandleTypeDef *hi2s);
@@ -19,6 +465,16 @@ void AppAudio_OnTxHalfCplt(I2S_HandleTypeDef *hi2s);
 void AppAudio_OnTxCplt(I2S_HandleTypeDef *hi2s);
 void AppAudio_OnError(I2S_HandleTypeDef *hi2s);
 
+/* APP_AUDIO_LEAN_IRQ: the whole DMA channel interrupt of the RX (ADC) or TX
+ * (DAC) stream. Returns 0, flags untouched, on a transfer error: the
+ * handler then runs HAL_DMA_IRQHandler() as usual.
+ */
+uint32_t AppAudio_OnRxDmaIrq(void);
+uint32_t AppAudio_OnTxDmaIrq(void);
+
+/* Deferred DSP work; call from PendSV_Handler(). */
+void AppAudio_OnPendSV(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,99 @@
+#ifndef APP_BLE_H
+#define APP_BLE_H
+
+#include <stdint.h>
+
+#include "app_mem.h"
+#include "stm32g4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* BLE UART module (a transparent-UART bridge such as an nRF52 running the
+ * Nordic UART Service, or an HM-10 style module) on USART3: PB10 TX to the
+ * module's RX, PB11 RX from its TX, at APP_BLE_BAUD. It is one more COM
+ * link (app_com.c), so a phone speaks the same protocol as the desktop,
+ * binary frames and CREDIT included; the module turns what it receives
+ * into notifications and the phone's writes into bytes on the line.
+ *
+ * DMA1 has no channel left, so both directions run on the USART's FIFOs
+ * with interrupts at their thresholds (a few per 8 bytes, not one per
+ * byte): RX is ReceiveToIdle IT copied into a ring, so a write from the
+ * phone arrives in one event when the line goes idle; TX drains a ring in
+ * contiguous chunks by HAL_UART_Transmit_IT(). The replies to a batch of
+ * commands leave back to back, so the module packs them into as few
+ * notifications as its MTU allows instead of one per reply.
+ *
+ * With APP_BLE_STATE_PORT/APP_BLE_STATE_PIN defined (the module's
+ * connection output, high while a central is connected) the link opens and
+ * closes with the phone: READY on connect, streams stopped on disconnect.
+ * Without it the link counts as always open, like the UART.
+ */
+#ifndef APP_BLE_ENABLE
+#define APP_BLE_ENABLE 1
+#endif
+
+/* The module's UART rate (most default to 9600 or 115200; set it once with
+ * the module's AT commands).
+ */
+#ifndef APP_BLE_BAUD
+#define APP_BLE_BAUD 115200u
+#endif
+
+/* Powers of two (free-running indices). RX is also the CREDIT window: a
+ * phone writes up to this much ahead of the parser. A build without the
+ * module keeps a token pair.
+ */
+#ifndef APP_BLE_RX_RING_SIZE
+#define APP_BLE_RX_RING_SIZE (APP_BLE_ENABLE ? 512u : 16u)
+#endif
+
+#ifndef APP_BLE_TX_RING_SIZE
+#define APP_BLE_TX_RING_SIZE (APP_BLE_ENABLE ? 512u : 16u)
+#endif
+
+/* Staging buffer of ReceiveToIdle IT: the most one RX event carries. */
+#ifndef APP_BLE_RX_IT_SIZE
+#define APP_BLE_RX_IT_SIZE 64u
+#endif
+
+/* Static RAM share (app_profile.h). */
+#define APP_BLE_RAM_BYTES (APP_BLE_RX_RING_SIZE + APP_BLE_TX_RING_SIZE + APP_BLE_RX_IT_SIZE)
+
+typedef struct
+{
+  uint8_t open;              /* AppBle_IsOpen() */
+  uint32_t rx_bytes;
+  uint32_t tx_bytes;
+  uint32_t rx_lost;          /* arrived with the RX ring full */
+  uint32_t errors;           /* line errors (framing, noise, overrun) */
+} AppBleInfo;
+
+/* Starts RX (huart: USART3 set up by MX_USART3_UART_Init()). */
+void AppBle_Init(UART_HandleTypeDef *huart);
+
+/* Main loop (app_com.c). Read takes up to max received bytes; Write queues
+ * all n bytes or none (returns 0 when the ring has no room; 1 also when
+ * the link is closed and they were discarded); TxFree is the room Write
+ * has. Pending is safe with interrupts masked (AppPower_Idle()).
+ */
+uint8_t AppBle_IsOpen(void);
+uint32_t AppBle_Read(uint8_t *dst, uint32_t max);
+uint8_t AppBle_Pending(void);
+uint8_t AppBle_Write(const uint8_t *p, uint32_t n);
+uint32_t AppBle_TxFree(void);
+
+void AppBle_Get(AppBleInfo *out);
+uint32_t AppBle_MemMap(const AppMemItem **items);
+
+/* Hooks from the HAL callbacks (main.c); other UARTs are ignored. */
+void AppBle_OnUartRxEvent(UART_HandleTypeDef *huart, uint16_t size);
+void AppBle_OnUartTxCplt(UART_HandleTypeDef *huart);
+void AppBle_OnUartError(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_BLE_H */
@@ -0,0 +1,203 @@
+#ifndef APP_CABIR_H
+#define APP_CABIR_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cabinet impulse-response convolution, in place of the fixed cab-sim
+ * lowpass inside the distortion stage.
+ *
+ * Uniformly partitioned overlap-save: the IR is cut into partitions of
+ * APP_CABIR_PARTITION taps, each kept as the spectrum of a 2 * PARTITION
+ * real FFT. Every PARTITION frames one forward FFT of the last two input
+ * partitions goes into a frequency-domain delay line, the line is
+ * multiplied with the IR spectra and summed, and one inverse FFT gives the
+ * next PARTITION outputs: two FFTs plus one complex multiply-add per bin
+ * and partition, against taps MACs per sample for a direct FIR.
+ * The FFTs are CMSIS-DSP arm_rfft_fast_f32() on the FPU; host builds run
+ * a plain DFT in the same packed layout instead.
+ *
+ * Latency: with the DMA half-block a multiple of the partition (64 and 128
+ * frames at the default 64) each partition is convolved in the block it
+ * arrives in and the cab adds none. Smaller blocks fill a partition over
+ * several blocks and the cab output lags by one partition
+ * (1.3 ms at 64 and 48 kHz). The taps are taken at the frame rate
+ * (APP_DSP_SAMPLE_RATE_HZ): a 96 kHz build needs a 96 kHz IR.
+ *
+ * The spectra live in flash (APP_CABIR_FLASH_ADDR), 8 bytes per tap, and
+ * are computed once when an upload is committed: COM CABIR BEGIN, binary
+ * CABW frames with the q15 taps, CABIR COMMIT. The taps are taken as given;
+ * the host scales the IR to the gain it wants. The pages hold a bank of
+ * APP_CABIR_SLOTS IRs behind a one-page index, and the convolver reads the
+ * slot the cab_ir parameter selects in place: flash holds the IRs, RAM
+ * only the convolution state. While the selected slot is empty, or being
+ * uploaded, the biquad cab runs.
+ *
+ * RAM: per channel a delay line of 8 bytes per tap plus 768 bytes at the
+ * default partition, 1 KB shared and 2 bytes per tap of upload staging.
+ * The delay line (4 KB of the ~7 KB at 256 taps stereo) comes from the DSP
+ * arena in an overlay with the reverb tank, so the two do not run at the
+ * same time: while the reverb is selected or ringing the biquad cab plays
+ * (see AppDsp_GetArena()). The ~3 KB share fits the BENCH profile
+ * (app_profile.h): build it with APP_CABIR_ENABLE=1. With the default 0
+ * nothing is compiled in and COM answers ERR CABIR DISABLED.
+ * Control side (main loop) except where marked audio side.
+ */
+#ifndef APP_CABIR_ENABLE
+#define APP_CABIR_ENABLE 0
+#endif
+
+/* Longest IR; a multiple of the partition, at most 1024. */
+#ifndef APP_CABIR_TAPS_MAX
+#define APP_CABIR_TAPS_MAX 256u
+#endif
+
+/* Partition length in frames: 32, 64 or 128 (FFT of twice that). */
+#ifndef APP_CABIR_PARTITION
+#define APP_CABIR_PARTITION 64u
+#endif
+
+#ifndef APP_CABIR_USE_CMSIS
+#if defined(__ARM_ARCH)
+#define APP_CABIR_USE_CMSIS 1
+#else
+#define APP_CABIR_USE_CMSIS 0
+#endif
+#endif
+
+/* IR pages (the 10 KB below the preset bank): the index page, then the
+ * slots, each APP_CABIR_SLOT_PAGES 2 KB pages for APP_CABIR_TAPS_MAX taps.
+ * Four slots of 256 taps, one of 1024. Reserved in the MDK targets and
+ * stm32g431_ccm.sct whether or not the convolver is built in.
+ */
+#ifndef APP_CABIR_FLASH_ADDR
+#define APP_CABIR_FLASH_ADDR 0x0801B800u
+#endif
+
+#ifndef APP_CABIR_FLASH_PAGES
+#define APP_CABIR_FLASH_PAGES 5u
+#endif
+
+#define APP_CABIR_SLOT_PAGES (((APP_CABIR_TAPS_MAX * 8u) + 2047u) / 2048u)
+
+/* As many slots as the pages hold, up to the APP_DSP_CAB_IR_SLOTS cab_ir
+ * can name.
+ */
+#ifndef APP_CABIR_SLOTS
+#define APP_CABIR_SLOTS ((((APP_CABIR_FLASH_PAGES - 1u) / APP_CABIR_SLOT_PAGES) < APP_DSP_CAB_IR_SLOTS) ? \
+                         ((APP_CABIR_FLASH_PAGES - 1u) / APP_CABIR_SLOT_PAGES) : APP_DSP_CAB_IR_SLOTS)
+#endif
+
+/* Leading partitions of the selected IR copied to RAM (CCM with
+ * APP_USE_CCM) when it is selected, 8 bytes per tap each. The ART caches
+ * hold little of a partition, so the rest stream from flash at its wait
+ * states; 0 reads them all in place. Worth raising only when COM PROF shows
+ * the distortion stage gaining from it.
+ */
+#ifndef APP_CABIR_RAM_PARTS
+#define APP_CABIR_RAM_PARTS 0u
+#endif
+
+#define APP_CABIR_CHANNELS (APP_DSP_MONO_INPUT ? 1u : 2u)
+
+/* Frequency-domain delay line, lent by the DSP arena. */
+#define APP_CABIR_FDL_BYTES (APP_CABIR_CHANNELS * APP_CABIR_TAPS_MAX * 8u)
+
+/* Static RAM share (app_profile.h), the line aside: the upload staging, the
+ * time and output buffers per channel, two FFT work buffers and the
+ * partitions held in RAM.
+ */
+#define APP_CABIR_RAM_BYTES \
+  (APP_CABIR_ENABLE ? ((APP_CABIR_TAPS_MAX * 2u) + (APP_CABIR_CHANNELS * APP_CABIR_PARTITION * 12u) + \
+                       (APP_CABIR_PARTITION * 16u) + (APP_CABIR_RAM_PARTS * APP_CABIR_PARTITION * 8u)) : 0u)
+
+typedef enum
+{
+  APP_CABIR_EMPTY = 0,   /* no IR stored: biquad cab */
+  APP_CABIR_LOADING,     /* upload staged in RAM: biquad cab */
+  APP_CABIR_ACTIVE,      /* convolving with the stored IR */
+} AppCabIrState;
+
+typedef struct
+{
+  AppCabIrState state;   /* EMPTY: no slot holds an IR */
+  uint32_t slot;         /* being uploaded, else the one last selected */
+  uint32_t taps;         /* that slot's IR, or the upload being staged */
+  uint32_t partitions;
+  uint16_t slot_taps[APP_CABIR_SLOTS];   /* stored IRs, 0 = empty */
+} AppCabIrInfo;
+
+/* Reads the index and checks each slot's CRC. Call once at boot; also
+ * drops an unfinished upload.
+ */
+void AppCabIr_Init(void);
+void AppCabIr_GetInfo(AppCabIrInfo *out);
+
+/* Starts an upload of 'taps' (1..APP_CABIR_TAPS_MAX) zeroed taps into
+ * 'slot'. The slot plays the biquad cab from here until COMMIT; the others
+ * keep theirs.
+ */
+uint8_t AppCabIr_Begin(uint32_t slot, uint32_t taps);
+
+/* Writes n q15 taps at 'offset' of the upload. Returns 0 unless loading
+ * and the range fits.
+ */
+uint8_t AppCabIr_Write(uint32_t offset, const int16_t *taps, uint32_t n);
+
+/* Computes the partition spectra, replaces the slot's flash copy and
+ * indexes it. Flash reads stall while the pages are erased and programmed
+ * (~100 ms): the audio path glitches. Returns 0 on a flash error; the slot
+ * is then empty.
+ */
+uint8_t AppCabIr_Commit(void);
+
+/* Drops the slot's IR from the index; the biquad cab comes back there. */
+uint8_t AppCabIr_Clear(uint32_t slot);
+
+/* Audio side. Active() is sampled once per block with the cab_ir slot and
+ * returns 0 while that slot has no IR. A block is convolved in
+ * chunks: Chunk() returns how many of the next n frames go in (up to the
+ * partition boundary) and where to write them, float s24, one pointer per
+ * channel; after they are written Convolve() returns where the m outputs
+ * are.
+ */
+uint8_t AppCabIr_Active(uint32_t slot);
+uint32_t AppCabIr_Chunk(uint32_t n, float *in[APP_CABIR_CHANNELS]);
+void AppCabIr_Convolve(uint32_t m, const float *out[APP_CABIR_CHANNELS]);
+
+/* Audio side, once per block: convolve with only the first partitions
+ * >> shift of the IR (at least one), a shorter cab for load shedding.
+ */
+void AppCabIr_Limit(uint32_t shift);
+
+/* Clears the convolution history (not the upload), on the audio side at
+ * the next Active().
+ */
+void AppCabIr_Reset(void);
+
+/* Audio side, at a block boundary: lends the APP_CABIR_FDL_BYTES delay line
+ * (history cleared before first use) or, with NULL, takes it back; the
+ * biquad cab runs until one is attached.
+ */
+void AppCabIr_Attach(void *fdl);
+
+/* Convolver buffers for COM MEM MAP (no entries when disabled). */
+uint32_t AppCabIr_MemMap(const AppMemItem **items);
+
+static inline int32_t AppCabIr_ToS24(float v)
+{
+  if (v >= 8388607.0f) return 8388607;
+  if (v <= -8388608.0f) return -8388608;
+  return (int32_t)(v + ((v >= 0.0f) ? 0.5f : -0.5f));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_CABIR_H */
@@ -0,0 +1,98 @@
+#ifndef APP_CAPTURE_H
+#define APP_CAPTURE_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+#include "app_meter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Debug capture / injection of the DSP chain for offline analysis.
+ *
+ * Capture records one chain point (the AppMeterTap positions) as 16-bit mono
+ * into a RAM buffer, averaged over 'decim' frames (1, 2, 4 or 8: 48, 24, 12
+ * or 6 kHz), once, starting at the next block. COM DUMP streams it out.
+ * Injection replays uploaded 16-bit samples on both inputs in place of the
+ * ADC (then silence) while the same run captures, so a test signal and the
+ * response it produced come back from one buffer: capture only ever writes
+ * samples injection has already read.
+ *
+ * Needs APP_CAPTURE_SAMPLES * 2 bytes of RAM, which the default builds do
+ * not have spare: build with APP_CAPTURE_ENABLE=1 in the BENCH profile
+ * (app_profile.h), which takes 1536 samples (32 ms at 48 kHz, 256 ms at
+ * 6 kHz), or give the RAM back elsewhere for the 8 KB default (4096
+ * samples: 85 ms at 48 kHz, 680 ms at 6 kHz). With the default 0 the
+ * hooks compile to nothing and COM answers ERR CAP DISABLED.
+ */
+#ifndef APP_CAPTURE_ENABLE
+#define APP_CAPTURE_ENABLE 0
+#endif
+
+#ifndef APP_CAPTURE_SAMPLES
+#define APP_CAPTURE_SAMPLES 4096u
+#endif
+
+/* Static RAM share (app_profile.h). */
+#define APP_CAPTURE_RAM_BYTES (APP_CAPTURE_ENABLE ? (APP_CAPTURE_SAMPLES * 2u) : 0u)
+
+#define APP_CAPTURE_DECIM_MAX 8u
+
+typedef enum
+{
+  APP_CAPTURE_IDLE = 0,   /* nothing armed, buffer may be written */
+  APP_CAPTURE_ARMED,      /* starts at the next block */
+  APP_CAPTURE_RUNNING,
+  APP_CAPTURE_DONE,       /* buffer holds the capture */
+} AppCaptureState;
+
+typedef struct
+{
+  AppCaptureState state;
+  AppMeterTap tap;
+  uint32_t decim;
+  uint32_t count;    /* samples requested */
+  uint32_t done;     /* samples captured so far */
+  uint32_t inject;   /* samples injected ahead of the capture, 0 = live input */
+} AppCaptureInfo;
+
+/* Control side (main loop). Arm returns 0 if a capture is already armed or
+ * running, or on a bad tap / decim / count (0 = the whole buffer).
+ * 'inject' of the uploaded samples replace the input, 0 keeps the ADC.
+ */
+uint8_t AppCapture_Arm(AppMeterTap tap, uint32_t decim, uint32_t count, uint32_t inject);
+void AppCapture_Abort(void);
+void AppCapture_GetInfo(AppCaptureInfo *out);
+
+/* Writes injection samples at 'offset'. Returns 0 unless the capture is
+ * idle or done, or if the range does not fit the buffer.
+ */
+uint8_t AppCapture_Write(uint32_t offset, const int16_t *s, uint32_t n);
+
+/* The buffer (capture result or uploaded samples), APP_CAPTURE_SAMPLES long. */
+const int16_t *AppCapture_Data(void);
+
+/* Audio side (AppDsp_ProcessBlock()): Input at the head of the chain, Tap at
+ * every meter tap ('mono' as for AppMeter_Block()).
+ */
+void AppCapture_Input(AppStereoS24 *x, uint32_t n);
+void AppCapture_Tap(AppMeterTap tap, const AppStereoS24 *x, uint32_t n, uint8_t mono);
+
+/* The capture buffer for COM MEM MAP (no entries when disabled). */
+uint32_t AppCapture_MemMap(const AppMemItem **items);
+
+#if APP_CAPTURE_ENABLE
+#define APP_CAPTURE_INPUT(x, n)          AppCapture_Input((x), (n))
+#define APP_CAPTURE_TAP(tap, x, n, mono) AppCapture_Tap((tap), (x), (n), (mono))
+#else
+#define APP_CAPTURE_INPUT(x, n)          do { } while (0)
+#define APP_CAPTURE_TAP(tap, x, n, mono) do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_CAPTURE_H */
@@ -0,0 +1,100 @@
+#ifndef APP_CDC_H
+#define APP_CDC_H
+
+#include <stdint.h>
+
+#include "app_mem.h"
+#include "app_uac.h"
+#include "app_usb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* USB CDC-ACM virtual COM port: the COM command protocol over USB, next to
+ * the UART. The host sees a serial port (no driver on Linux, macOS or
+ * Windows 10+); the baud rate it sets is stored and reported back but has
+ * no effect, the bulk endpoints run at whatever the bus gives them.
+ *
+ * Bytes from the host land in an RX ring straight from the bulk OUT
+ * interrupt; when the ring has less than a packet free, the endpoint is
+ * left un-armed so the host is NAKed until AppCdc_Read() made room (no
+ * byte is ever dropped on the way in). Replies go into a TX ring that the
+ * bulk IN endpoint drains a 64-byte packet per interrupt; a full last
+ * packet is followed by a zero-length one so the host's read returns.
+ *
+ * The port counts as open while the host holds DTR (every terminal and
+ * pyserial do on open); writes while it is closed are discarded, so a
+ * host that is not listening never stalls the command layer.
+ */
+#ifndef APP_CDC_ENABLE
+#define APP_CDC_ENABLE APP_USB_ENABLE
+#endif
+
+/* Powers of two; a build without the port keeps a token pair. */
+#ifndef APP_CDC_RX_RING_SIZE
+#define APP_CDC_RX_RING_SIZE (APP_CDC_ENABLE ? 256u : 16u)
+#endif
+
+#ifndef APP_CDC_TX_RING_SIZE
+#define APP_CDC_TX_RING_SIZE (APP_CDC_ENABLE ? 1024u : 16u)
+#endif
+
+#define APP_CDC_EP_NOTIFY      0x82u
+#define APP_CDC_EP_OUT         0x03u
+#define APP_CDC_EP_IN          0x83u
+#define APP_CDC_NOTIFY_SIZE    16u
+#define APP_CDC_EP_SIZE        64u
+
+/* OUT packet buffer; a placeholder byte without the CDC. */
+#define APP_CDC_PKT_SIZE       (APP_CDC_ENABLE ? APP_CDC_EP_SIZE : 1u)
+
+/* Static RAM share (app_profile.h): both rings and the OUT packet. */
+#define APP_CDC_RAM_BYTES      (APP_CDC_RX_RING_SIZE + APP_CDC_TX_RING_SIZE + APP_CDC_PKT_SIZE)
+
+/* Interface numbers, after the audio ones. */
+#define APP_CDC_IF_COMM        (APP_UAC_ENABLE ? 2u : 0u)
+#define APP_CDC_IF_DATA        (APP_CDC_IF_COMM + 1u)
+
+typedef struct
+{
+  uint8_t open;              /* configured and DTR held */
+  uint32_t baud;             /* as the host set it, unused */
+  uint32_t rx_bytes;
+  uint32_t tx_bytes;
+  uint32_t tx_drops;         /* writes discarded: TX ring full */
+  uint32_t rx_stalls;        /* times the OUT endpoint was held off: RX ring full */
+} AppCdcInfo;
+
+/* USB interrupt (app_usb.c). Start arms the OUT endpoint once the
+ * configuration opened the endpoints; Reset is a bus reset or the
+ * configuration going away. Setup returns 0 for a request it does not
+ * answer.
+ */
+void AppCdc_Start(void);
+void AppCdc_Reset(void);
+uint8_t AppCdc_Setup(const AppUsbSetup *req);
+void AppCdc_CtlOut(const uint8_t *data, uint16_t len);
+void AppCdc_DataOut(uint16_t len);
+void AppCdc_DataIn(void);
+
+/* Main loop (app_com.c). Read takes up to max received bytes; Write queues
+ * all len bytes or none (returns 0 when the ring has no room; 1 also when
+ * the port is closed and they were discarded); TxFree is the room Write
+ * has, the whole ring while closed.
+ */
+uint8_t AppCdc_IsOpen(void);
+uint32_t AppCdc_Read(uint8_t *dst, uint32_t max);
+uint8_t AppCdc_Pending(void);
+uint8_t AppCdc_Write(const uint8_t *data, uint32_t len);
+uint32_t AppCdc_TxFree(void);
+
+/* Control side (COM USB). */
+void AppCdc_Get(AppCdcInfo *out);
+uint32_t AppCdc_MemMap(const AppMemItem **items);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_CDC_H */
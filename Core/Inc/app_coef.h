@@ -0,0 +1,67 @@
+#ifndef APP_COEF_H
+#define APP_COEF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Filter coefficients designed at compile time.
+ *
+ * Each macro is a constant expression of its corner, Q and sample rate, so
+ * a fixed filter is written down by its design values and the compiler
+ * folds it to one rounded integer for the build rate: no hand-computed
+ * numbers, nothing evaluated at run time. exp(), sin() and cos() are not
+ * constant expressions in C, so they are replaced by series that are exact
+ * to well below one Q28 step over the range given at each macro.
+ *
+ * Results are double; APP_COEF_Q15()/APP_COEF_Q28() round them to the
+ * fixed-point formats the kernels take.
+ */
+#define APP_COEF_PI          3.14159265358979323846
+
+/* Round to nearest, halves away from zero. */
+#define APP_COEF_Q(v, bits) \
+  ((int32_t)(((v) * (double)(1L << (bits))) + (((v) < 0.0) ? -0.5 : 0.5)))
+#define APP_COEF_Q15(v)      APP_COEF_Q((v), 15)
+#define APP_COEF_Q28(v)      APP_COEF_Q((v), 28)
+
+/* exp(-x) for 0 <= x <= 0.2 (one-pole corners up to fs/30). */
+#define APP_COEF_EXPNEG(x) \
+  (1.0 - (x) * (1.0 - (x) / 2.0 * (1.0 - (x) / 3.0 * (1.0 - (x) / 4.0 * \
+  (1.0 - (x) / 5.0 * (1.0 - (x) / 6.0 * (1.0 - (x) / 7.0 * (1.0 - (x) / 8.0))))))))
+
+/* cos(w) and sin(w) for 0 <= w <= pi/2 (biquad corners up to fs/4). */
+#define APP_COEF_COS(w) \
+  (1.0 - (w) * (w) / 2.0 * (1.0 - (w) * (w) / 12.0 * (1.0 - (w) * (w) / 30.0 * \
+  (1.0 - (w) * (w) / 56.0 * (1.0 - (w) * (w) / 90.0 * (1.0 - (w) * (w) / 132.0 * \
+  (1.0 - (w) * (w) / 182.0)))))))
+#define APP_COEF_SIN(w) \
+  ((w) * (1.0 - (w) * (w) / 6.0 * (1.0 - (w) * (w) / 20.0 * (1.0 - (w) * (w) / 42.0 * \
+  (1.0 - (w) * (w) / 72.0 * (1.0 - (w) * (w) / 110.0 * (1.0 - (w) * (w) / 156.0)))))))
+
+#define APP_COEF_W(fc, fs)   (2.0 * APP_COEF_PI * (double)(fc) / (double)(fs))
+
+/* One-pole pole r = exp(-2 pi fc / fs): the leak of a DC blocker or 1st
+ * order HPF, y = x - x1 + r y1.
+ */
+#define APP_COEF_POLE(fc, fs)    APP_COEF_EXPNEG(APP_COEF_W((fc), (fs)))
+
+/* One-pole lowpass step a = 1 - r, y += a (x - y). */
+#define APP_COEF_STEP(fc, fs)    (1.0 - APP_COEF_POLE((fc), (fs)))
+
+/* 2nd order lowpass (bilinear, RBJ cookbook), normalised to a0 = 1:
+ * y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2, with b1 = 2 b0 and b2 = b0.
+ */
+#define APP_COEF_LPF_ALPHA(fc, q, fs) (APP_COEF_SIN(APP_COEF_W((fc), (fs))) / (2.0 * (double)(q)))
+#define APP_COEF_LPF_B0(fc, q, fs) \
+  ((1.0 - APP_COEF_COS(APP_COEF_W((fc), (fs)))) / (2.0 * (1.0 + APP_COEF_LPF_ALPHA((fc), (q), (fs)))))
+#define APP_COEF_LPF_A1(fc, q, fs) \
+  ((-2.0 * APP_COEF_COS(APP_COEF_W((fc), (fs)))) / (1.0 + APP_COEF_LPF_ALPHA((fc), (q), (fs))))
+#define APP_COEF_LPF_A2(fc, q, fs) \
+  ((1.0 - APP_COEF_LPF_ALPHA((fc), (q), (fs))) / (1.0 + APP_COEF_LPF_ALPHA((fc), (q), (fs))))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_COEF_H */
@@ -3,20 +3,26 @@
 
 #include <stdint.h>
 
-#include "stm32g4xx_hal.h"
-
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void AppCom_Init(UART_HandleTypeDef *huart);
+/* After the links' transports: AppSerial_Init(), AppUsb_Init(),
+ * AppMidi_Init(). Greets the UART with READY.
+ */
+void AppCom_Init(void);
 void AppCom_Poll(void);
 
-/* Hook from HAL callbacks (main.c). */
-void AppCom_OnUartRxCplt(UART_HandleTypeDef *huart);
-void AppCom_OnUartRxEvent(UART_HandleTypeDef *huart, uint16_t size);
-void AppCom_OnUartTxCplt(UART_HandleTypeDef *huart);
-void AppCom_OnUartError(UART_HandleTypeDef *huart);
+/* Control-rate task: the SUB topics that are due, each to the link that
+ * subscribed.
+ */
+void AppCom_Publish(void);
+
+/* Nonzero while the main loop has COM work: received bytes not parsed yet
+ * on any link, a link opened or closed, or a UART event since the last
+ * AppCom_Poll(). Safe with interrupts masked (AppPower_Idle()).
+ */
+uint8_t AppCom_Pending(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,453 @@
+#ifndef APP_DLINE_H
+#define APP_DLINE_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "cmsis_compiler.h"
+#define APP_DLINE_ARM_DSP 1
+#else
+#define APP_DLINE_ARM_DSP 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Delay-line sample storage shared by the echo delay and the reverb tank.
+ *
+ * A line is a plain uint32_t array sized with APP_DLINE_WORDS(); samples go
+ * in and come out as signed 24-bit, the format only decides what is kept:
+ *
+ *   S32   32 bit/sample  exact
+ *   S16   16 bit/sample  24->16 truncation (~96 dB)
+ *   S12   12 bit/sample  two samples per 3 bytes (~72 dB), 1.33x S16 length
+ *   ULAW   8 bit/sample  G.711 mu-law on the top 16 bits (~38 dB SNR,
+ *                        companded), 2x S16 length
+ *   BFP16 16.25 bit/sample  block floating point: int16 mantissas, one
+ *                        exponent per 32 samples; exact below -48 dBFS,
+ *                        ~96 dB under the loudest sample of the segment
+ *
+ * Every format is random access, so modulated and multi-tap reads work on
+ * any of them (ADPCM is left out: it can only be decoded sequentially).
+ * Stereo lines store L/R of one frame next to each other; the *2 accessors
+ * move a whole frame. The format argument is always a compile-time constant,
+ * so each call folds to one code path.
+ *
+ * A stereo S16 frame is one word, L in the low half: the writer packs it
+ * with one PKHBT on the M4. Fractional S16 reads, stereo or mono,
+ * interpolate straight from the 16-bit samples in 32-bit arithmetic (no
+ * 64-bit products), exactly as the 24-bit path would.
+ */
+#define APP_DLINE_S32   0
+#define APP_DLINE_S16   1
+#define APP_DLINE_S12   2
+#define APP_DLINE_ULAW  3
+#define APP_DLINE_BFP16 4
+
+/* Sample bits (BFP16: the mantissa, the exponents come on top). */
+#define APP_DLINE_BITS(fmt) \
+  (((fmt) == APP_DLINE_S32) ? 32U : (((fmt) == APP_DLINE_S16) || ((fmt) == APP_DLINE_BFP16)) ? 16U : \
+   ((fmt) == APP_DLINE_S12) ? 12U : 8U)
+
+/* BFP16 is laid out in groups of 128 samples: 256 bytes of mantissas, then
+ * the four segment exponents, one byte each (65 words).
+ */
+#define APP_DLINE_BFP_GROUP      128U
+#define APP_DLINE_BFP_SEG        32U
+#define APP_DLINE_BFP_GROUP_WORDS 65U
+
+/* Frames of 'ch' channels that fit in 'bytes' (BFP16: whole groups). */
+#define APP_DLINE_FRAMES(bytes, ch, fmt) \
+  (((fmt) == APP_DLINE_BFP16) ? \
+   ((((bytes) / (APP_DLINE_BFP_GROUP_WORDS * 4U)) * APP_DLINE_BFP_GROUP) / (ch)) : \
+   (((bytes) * 8U) / ((ch) * APP_DLINE_BITS(fmt))))
+
+/* Storage words for 'frames' frames (S12 rounds up to a whole 3-byte pair,
+ * BFP16 to a whole group).
+ */
+#define APP_DLINE_WORDS(frames, ch, fmt) \
+  (((fmt) == APP_DLINE_BFP16) ? \
+   (((((frames) * (ch)) + APP_DLINE_BFP_GROUP - 1U) / APP_DLINE_BFP_GROUP) * APP_DLINE_BFP_GROUP_WORDS) : \
+   (((((frames) * (ch) + 1U) & ~1U) * APP_DLINE_BITS(fmt) + 31U) / 32U))
+
+/* A storage word of silence: 0 decodes to 0 except in mu-law, where the
+ * zero code is 0xFF (a 0x00 byte is full scale negative).
+ */
+#define APP_DLINE_SILENCE(fmt)  (((fmt) == APP_DLINE_ULAW) ? 0xFFFFFFFFU : 0U)
+
+/* Whole line to silence, for resets outside the audio path. */
+static inline void AppDline_Clear(uint32_t *buf, uint32_t words, uint32_t fmt)
+{
+  for (uint32_t i = 0; i < words; i++)
+  {
+    buf[i] = APP_DLINE_SILENCE(fmt);
+  }
+}
+
+/* Incremental clear for the audio path: AppDline_ClearBegin() arms it,
+ * each AppDline_ClearStep() silences up to 'budget' further words, from
+ * 'from' onwards and wrapping once round the line, so the oldest content
+ * of a ring goes first. left is 0 when idle or done.
+ */
+typedef struct
+{
+  uint32_t *buf;
+  uint32_t words;
+  uint32_t pos;
+  uint32_t left;
+  uint32_t fill;
+} AppDlineClear;
+
+static inline void AppDline_ClearBegin(AppDlineClear *c, uint32_t *buf, uint32_t words, uint32_t from, uint32_t fmt)
+{
+  c->buf = buf;
+  c->words = words;
+  c->pos = (from < words) ? from : 0U;
+  c->left = words;
+  c->fill = APP_DLINE_SILENCE(fmt);
+}
+
+/* Returns the words still to clear. */
+static inline uint32_t AppDline_ClearStep(AppDlineClear *c, uint32_t budget)
+{
+  uint32_t k = (budget < c->left) ? budget : c->left;
+  c->left -= k;
+  while (k > 0U)
+  {
+    uint32_t run = c->words - c->pos;
+    run = (k < run) ? k : run;
+    for (uint32_t i = 0; i < run; i++)
+    {
+      c->buf[c->pos + i] = c->fill;
+    }
+    k -= run;
+    c->pos += run;
+    if (c->pos == c->words)
+    {
+      c->pos = 0U;
+    }
+  }
+  return c->left;
+}
+
+static inline uint32_t AppDline_UlawEncode(int32_t s24)
+{
+  int32_t x = s24 >> 8;
+  uint32_t sign = (x < 0) ? 0x80U : 0U;
+  uint32_t mag = (uint32_t)((x < 0) ? -x : x);
+  if (mag > 32635U) mag = 32635U;
+  mag += 0x84U;
+
+  /* mag >= 0x84 so bit 7 is set: exponent 0..7 from the top set bit. */
+  uint32_t exp = (31U - (uint32_t)__builtin_clz(mag)) - 7U;
+  uint32_t mant = (mag >> (exp + 3U)) & 0x0FU;
+  return (~(sign | (exp << 4) | mant)) & 0xFFU;
+}
+
+static inline int32_t AppDline_UlawDecode(uint32_t u)
+{
+  u = ~u;
+  uint32_t exp = (u >> 4) & 0x07U;
+  int32_t mag = (int32_t)((((u & 0x0FU) << 3) + 0x84U) << exp) - 0x84;
+  return ((u & 0x80U) ? -mag : mag) * 256;
+}
+
+/* S12 pair (a, b) in 3 bytes: a[11:0] | b[11:0] << 12. */
+static inline uint32_t AppDline_S12Get(const uint32_t *buf, uint32_t pair)
+{
+  const uint8_t *p = (const uint8_t *)buf + (pair * 3U);
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static inline void AppDline_S12Put(uint32_t *buf, uint32_t pair, uint32_t v)
+{
+  uint8_t *p = (uint8_t *)buf + (pair * 3U);
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+}
+
+static inline int32_t AppDline_S12Lo(uint32_t v)
+{
+  return ((int32_t)(v << 20)) >> 8;
+}
+
+static inline int32_t AppDline_S12Hi(uint32_t v)
+{
+  return (((int32_t)(v << 8)) >> 8) & ~0xFFF;
+}
+
+/* BFP16 sample s: mantissa m[s] of its group, exponent *e of its segment;
+ * the value is m << e, e in 0..8.
+ */
+static inline int16_t *AppDline_BfpMant(uint32_t *buf, uint32_t s)
+{
+  return (int16_t *)buf + ((s / APP_DLINE_BFP_GROUP) * (APP_DLINE_BFP_GROUP_WORDS * 2U)) + (s % APP_DLINE_BFP_GROUP);
+}
+
+static inline uint8_t *AppDline_BfpExp(uint32_t *buf, uint32_t s)
+{
+  return (uint8_t *)buf + ((s / APP_DLINE_BFP_GROUP) * (APP_DLINE_BFP_GROUP_WORDS * 4U)) + (APP_DLINE_BFP_GROUP * 2U) +
+         ((s % APP_DLINE_BFP_GROUP) / APP_DLINE_BFP_SEG);
+}
+
+static inline int32_t AppDline_BfpGet(const uint32_t *buf, uint32_t s)
+{
+  const int32_t m = *AppDline_BfpMant((uint32_t *)buf, s);
+  return m * (1 << *AppDline_BfpExp((uint32_t *)buf, s));
+}
+
+/* Exponent an s24 value needs (0 while it fits int16). */
+static inline uint32_t AppDline_BfpNeed(int32_t x)
+{
+  const uint32_t m = (uint32_t)(x ^ (x >> 31));
+  return (m < 0x8000U) ? 0U : ((32U - (uint32_t)__builtin_clz(m)) - 15U);
+}
+
+/* Puts an s24 sample into its segment. The other 31 samples keep their
+ * values: a louder sample raises the exponent and shifts them down with
+ * it, and a write at the start of a segment (where a ring's writer enters
+ * it) lowers the exponent again as far as all of them allow, so a quiet
+ * passage gets its low bits back one segment after a loud one.
+ */
+static inline void AppDline_BfpPut(uint32_t *buf, uint32_t s, int32_t x)
+{
+  int16_t *m = AppDline_BfpMant(buf, s & ~(APP_DLINE_BFP_SEG - 1U));
+  uint8_t *pe = AppDline_BfpExp(buf, s);
+  const uint32_t pos = s % APP_DLINE_BFP_SEG;
+  const uint32_t e = *pe;
+  uint32_t ne = AppDline_BfpNeed(x);
+
+  if (pos == 0U)
+  {
+    uint32_t used = 0;
+    for (uint32_t k = 1; k < APP_DLINE_BFP_SEG; k++)
+    {
+      used |= (uint32_t)(m[k] ^ (m[k] >> 15));
+    }
+    const uint32_t room = (used == 0U) ? e : ((uint32_t)__builtin_clz(used) - 17U);
+    const uint32_t low = (room < e) ? (e - room) : 0U;
+    ne = (ne > low) ? ne : low;
+  }
+  else if (ne < e)
+  {
+    ne = e;
+  }
+
+  if (ne != e)
+  {
+    for (uint32_t k = 0; k < APP_DLINE_BFP_SEG; k++)
+    {
+      m[k] = (int16_t)((ne > e) ? (m[k] >> (ne - e)) : (m[k] * (1 << (e - ne))));
+    }
+    *pe = (uint8_t)ne;
+  }
+  m[pos] = (int16_t)(x >> ne);
+}
+
+/* ------------------------------ Stereo lines ------------------------------ */
+
+/* Inputs must already be clamped to s24. */
+static inline void AppDline_Write2(uint32_t *buf, uint32_t frame, int32_t l, int32_t r, uint32_t fmt)
+{
+  switch (fmt)
+  {
+    case APP_DLINE_S32:
+      ((AppStereoS24 *)buf)[frame].l = l;
+      ((AppStereoS24 *)buf)[frame].r = r;
+      break;
+    case APP_DLINE_S16:
+#if APP_DLINE_ARM_DSP
+      buf[frame] = __PKHBT((uint32_t)(l >> 8), (uint32_t)r, 8);
+#else
+      buf[frame] = ((uint32_t)(l >> 8) & 0xFFFFU) | ((uint32_t)(r >> 8) << 16);
+#endif
+      break;
+    case APP_DLINE_S12:
+      AppDline_S12Put(buf, frame, (((uint32_t)l >> 12) & 0xFFFU) | ((((uint32_t)r >> 12) & 0xFFFU) << 12));
+      break;
+    case APP_DLINE_BFP16:
+      AppDline_BfpPut(buf, 2U * frame, l);
+      AppDline_BfpPut(buf, (2U * frame) + 1U, r);
+      break;
+    default:
+      ((uint16_t *)buf)[frame] = (uint16_t)(AppDline_UlawEncode(l) | (AppDline_UlawEncode(r) << 8));
+      break;
+  }
+}
+
+static inline AppStereoS24 AppDline_Read2(const uint32_t *buf, uint32_t frame, uint32_t fmt)
+{
+  AppStereoS24 f;
+  switch (fmt)
+  {
+    case APP_DLINE_S32:
+      f = ((const AppStereoS24 *)buf)[frame];
+      break;
+    case APP_DLINE_S16:
+    {
+      uint32_t w = buf[frame];
+      f.l = ((int32_t)(w << 16)) >> 8;
+      f.r = ((int32_t)(w & 0xFFFF0000U)) >> 8;
+      break;
+    }
+    case APP_DLINE_S12:
+    {
+      uint32_t v = AppDline_S12Get(buf, frame);
+      f.l = AppDline_S12Lo(v);
+      f.r = AppDline_S12Hi(v);
+      break;
+    }
+    case APP_DLINE_BFP16:
+      f.l = AppDline_BfpGet(buf, 2U * frame);
+      f.r = AppDline_BfpGet(buf, (2U * frame) + 1U);
+      break;
+    default:
+    {
+      uint32_t u = ((const uint16_t *)buf)[frame];
+      f.l = AppDline_UlawDecode(u & 0xFFU);
+      f.r = AppDline_UlawDecode(u >> 8);
+      break;
+    }
+  }
+  return f;
+}
+
+/* Stereo S16 frames w0 and w1 mixed (65536 - frac) : frac. The 16-bit
+ * samples leave room for it in 32 bits: s0 * 65536 + (s1 - s0) * frac is a
+ * mix of s0 and s1 scaled by 65536, so it is exact even where the product
+ * alone would wrap, and >> 8 gives what the s24 lerp of the same frames
+ * gives (the 256 factor goes through the floor unchanged).
+ */
+static inline int32_t AppDline_S16Lerp(int32_t s0, int32_t s1, uint32_t frac)
+{
+  return (int32_t)(((uint32_t)s0 << 16) + ((uint32_t)(s1 - s0) * frac)) >> 8;
+}
+
+static inline AppStereoS24 AppDline_S16Lerp2(uint32_t w0, uint32_t w1, uint32_t frac)
+{
+  AppStereoS24 f;
+  f.l = AppDline_S16Lerp((int16_t)w0, (int16_t)w1, frac);
+  f.r = AppDline_S16Lerp((int32_t)w0 >> 16, (int32_t)w1 >> 16, frac);
+  return f;
+}
+
+/* Fractional read 'dist_q16' frames (Q16) behind write position i of a
+ * len-frame ring, linear interpolation towards the older neighbour. Any
+ * distance works, so modulated reads use it as well; len and beyond read
+ * the oldest frame (the slot about to be overwritten), nothing older.
+ */
+static inline AppStereoS24 AppDline_Tap2(const uint32_t *buf, uint32_t len, uint32_t i, uint32_t dist_q16,
+                                         uint32_t fmt)
+{
+  uint32_t n = dist_q16 >> 16;
+  uint32_t frac = dist_q16 & 0xFFFFU;
+  if (n >= len)
+  {
+    n = len;
+    frac = 0;
+  }
+
+  uint32_t r0 = (i >= n) ? (i - n) : (i + len - n);
+  if ((fmt == APP_DLINE_S16) && (frac != 0U))
+  {
+    uint32_t r1 = (r0 > 0U) ? (r0 - 1U) : (len - 1U);
+    return AppDline_S16Lerp2(buf[r0], buf[r1], frac);
+  }
+  AppStereoS24 y0 = AppDline_Read2(buf, r0, fmt);
+  if (frac == 0U)
+  {
+    return y0;
+  }
+
+  uint32_t r1 = (r0 > 0U) ? (r0 - 1U) : (len - 1U);
+  AppStereoS24 y1 = AppDline_Read2(buf, r1, fmt);
+  y0.l += (int32_t)(((int64_t)(y1.l - y0.l) * (int64_t)frac) >> 16);
+  y0.r += (int32_t)(((int64_t)(y1.r - y0.r) * (int64_t)frac) >> 16);
+  return y0;
+}
+
+/* ------------------------------- Mono lines ------------------------------- */
+
+static inline void AppDline_Write1(uint32_t *buf, uint32_t i, int32_t x, uint32_t fmt)
+{
+  switch (fmt)
+  {
+    case APP_DLINE_S32:
+      ((int32_t *)buf)[i] = x;
+      break;
+    case APP_DLINE_S16:
+      ((int16_t *)buf)[i] = (int16_t)(x >> 8);
+      break;
+    case APP_DLINE_S12:
+    {
+      uint32_t v = AppDline_S12Get(buf, i >> 1);
+      uint32_t s = ((uint32_t)x >> 12) & 0xFFFU;
+      v = (i & 1U) ? ((v & 0x000FFFU) | (s << 12)) : ((v & 0xFFF000U) | s);
+      AppDline_S12Put(buf, i >> 1, v);
+      break;
+    }
+    case APP_DLINE_BFP16:
+      AppDline_BfpPut(buf, i, x);
+      break;
+    default:
+      ((uint8_t *)buf)[i] = (uint8_t)AppDline_UlawEncode(x);
+      break;
+  }
+}
+
+static inline int32_t AppDline_Read1(const uint32_t *buf, uint32_t i, uint32_t fmt)
+{
+  switch (fmt)
+  {
+    case APP_DLINE_S32:
+      return ((const int32_t *)buf)[i];
+    case APP_DLINE_S16:
+      return (int32_t)((const int16_t *)buf)[i] * 256;
+    case APP_DLINE_S12:
+    {
+      uint32_t v = AppDline_S12Get(buf, i >> 1);
+      return (i & 1U) ? AppDline_S12Hi(v) : AppDline_S12Lo(v);
+    }
+    case APP_DLINE_BFP16:
+      return AppDline_BfpGet(buf, i);
+    default:
+      return AppDline_UlawDecode(((const uint8_t *)buf)[i]);
+  }
+}
+
+/* AppDline_Tap2() on a mono line. */
+static inline int32_t AppDline_Tap1(const uint32_t *buf, uint32_t len, uint32_t i, uint32_t dist_q16, uint32_t fmt)
+{
+  uint32_t n = dist_q16 >> 16;
+  uint32_t frac = dist_q16 & 0xFFFFU;
+  if (n >= len)
+  {
+    n = len;
+    frac = 0;
+  }
+
+  uint32_t r0 = (i >= n) ? (i - n) : (i + len - n);
+  if ((fmt == APP_DLINE_S16) && (frac != 0U))
+  {
+    uint32_t r1 = (r0 > 0U) ? (r0 - 1U) : (len - 1U);
+    return AppDline_S16Lerp(((const int16_t *)buf)[r0], ((const int16_t *)buf)[r1], frac);
+  }
+  int32_t y0 = AppDline_Read1(buf, r0, fmt);
+  if (frac == 0U)
+  {
+    return y0;
+  }
+
+  uint32_t r1 = (r0 > 0U) ? (r0 - 1U) : (len - 1U);
+  return y0 + (int32_t)(((int64_t)(AppDline_Read1(buf, r1, fmt) - y0) * (int64_t)frac) >> 16);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_DLINE_H */
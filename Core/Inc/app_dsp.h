@@ -3,10 +3,339 @@
 
 #include <stdint.h>
 
+#include "app_mem.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Frame rate of the whole chain: 48000 or 96000. The I2S interfaces run at
+ * this rate and AppDsp_Init() maps the per-sample filter, envelope and
+ * smoothing coefficients (tuned at 48 kHz) to it, so corners and time
+ * constants stay put in Hz and ms. Delay times are set in ms; at 96 kHz the
+ * same delay RAM holds half the time. At 96 kHz the reverb runs half rate
+ * (a 48 kHz tank) unless told otherwise.
+ */
+#ifndef APP_DSP_SAMPLE_RATE_HZ
+#define APP_DSP_SAMPLE_RATE_HZ 48000u
+#endif
+
+#if (APP_DSP_SAMPLE_RATE_HZ != 48000u) && (APP_DSP_SAMPLE_RATE_HZ != 96000u)
+#error "APP_DSP_SAMPLE_RATE_HZ must be 48000 or 96000"
+#endif
+
+/* Mono in / stereo out: the guitar is taken from the left ADC input, the dry
+ * chain (conditioning, compressor, distortion, cab) runs once and only the
+ * delay (ping-pong) and reverb (decorrelated taps) produce two channels.
+ * Roughly halves the dry-chain load and halves the reverb budget (8 KB less
+ * RAM, see APP_DSP_REVERB_RAM_BYTES).
+ */
+#ifndef APP_DSP_MONO_INPUT
+#define APP_DSP_MONO_INPUT 0
+#endif
+
+/* Sample storage of the echo delay line and the reverb tank, one of the
+ * APP_DLINE_* formats in app_dline.h (S32, S16, S12, ULAW, BFP16). A smaller
+ * format stretches the same RAM budget: S12 gives 1.33x and ULAW 2x the S16
+ * time. BFP16 keeps quiet tails at 24 bits for 1/64 more RAM than S16 and a
+ * few cycles per write. The reverb FDN picks the longest line set that
+ * fits its own budget below.
+ */
+#ifndef APP_DSP_DELAY_STORAGE
+#define APP_DSP_DELAY_STORAGE APP_DLINE_S16
+#endif
+
+#ifndef APP_DSP_REVERB_STORAGE
+#define APP_DSP_REVERB_STORAGE APP_DLINE_S16
+#endif
+
+/* Looper storage. S12 keeps overdubs ~72 dB clean at 1.5 bytes per stored
+ * step, ~9 KB per second of loop.
+ */
+#ifndef APP_DSP_LOOP_STORAGE
+#define APP_DSP_LOOP_STORAGE APP_DLINE_S12
+#endif
+
+/* RAM given to the four reverb FDN lines. At S16, 16 KB holds 33..51 ms
+ * lines and 8 KB 17..26 ms lines.
+ */
+#ifndef APP_DSP_REVERB_RAM_BYTES
+#if APP_DSP_MONO_INPUT
+#define APP_DSP_REVERB_RAM_BYTES 8192u
+#else
+#define APP_DSP_REVERB_RAM_BYTES 16384u
+#endif
+#endif
+
+/* RAM given to the echo delay line (at 1/8 rate and S16 storage, 4 bytes
+ * per stored step, ~5.9 KB per second). The default hands the 8 KB freed
+ * by the mono reverb tank to the delay: ~170 ms stereo, ~510 ms mono.
+ */
+#ifndef APP_DSP_DELAY_RAM_BYTES
+#if APP_DSP_MONO_INPUT
+#define APP_DSP_DELAY_RAM_BYTES 12288u
+#else
+#define APP_DSP_DELAY_RAM_BYTES 4096u
+#endif
+#endif
+
+/* Line storage cleared in the audio path (the reverb tank when it takes
+ * the arena back from the cab IR) goes a slice per block: words per frame,
+ * 4 = 16 bytes per frame, the 16 KB tank in ~21 ms at 48 kHz.
+ */
+#ifndef APP_DSP_LINE_CLEAR_WORDS
+#define APP_DSP_LINE_CLEAR_WORDS 4u
+#endif
+
+/* Run the reverb (FDN, diffusers and wet filters) at half the frame rate
+ * (24 kHz at 48 kHz) behind a halfband decimator/interpolator. Halves the
+ * reverb CPU cost and doubles the tail time the same lines hold
+ * (66..102 ms lines at the 16 KB default), for a wet path that is rolled
+ * off well below 12 kHz anyway.
+ */
+#ifndef APP_DSP_REVERB_HALF_RATE
+#if APP_DSP_SAMPLE_RATE_HZ > 48000u
+#define APP_DSP_REVERB_HALF_RATE 1
+#else
+#define APP_DSP_REVERB_HALF_RATE 0
+#endif
+#endif
+
+/* Sum the reverb send to mono ahead of the tank. The FDN's output taps
+ * and diffusers stay stereo, so the tail keeps its width; the input's own
+ * panning goes, and with it the second channel of the half-rate
+ * decimator and of the line inputs. Implied by APP_DSP_MONO_INPUT.
+ */
+#ifndef APP_DSP_REVERB_MONO_SEND
+#define APP_DSP_REVERB_MONO_SEND 0
+#endif
+
+/* Most diffuser stages reverb_diffusion can ask for, 2..6. Their lines
+ * come from the FX arena with the tank: 1 KB at 2, 2 KB at 6.
+ */
+#ifndef APP_DSP_REVERB_AP_STAGES
+#define APP_DSP_REVERB_AP_STAGES 6u
+#endif
+
+/* Reverb line modulation: depth in samples at the reverb rate (0 = off,
+ * the tuned unmodulated tank) and LFO rate in mHz. A few samples at under
+ * 1 Hz breaks up the metallic ring of long tails; the LFO costs one CORDIC
+ * call per block (app_lfo.h), each line one extra read per sample.
+ */
+#ifndef APP_DSP_REVERB_MOD_SAMPLES
+#define APP_DSP_REVERB_MOD_SAMPLES 0u
+#endif
+
+#ifndef APP_DSP_REVERB_MOD_RATE_MHZ
+#define APP_DSP_REVERB_MOD_RATE_MHZ 700u
+#endif
+
+/* Build the spring tank (reverb_type spring). Its line and state live in
+ * the FDN buffer, so it costs code only. 0 leaves it out: reverb_type
+ * keeps its range and AppDsp_ParamBuilt() refuses the spring.
+ */
+#ifndef APP_DSP_SPRING_ENABLE
+#define APP_DSP_SPRING_ENABLE 1
+#endif
+
+/* Longest chorus/flanger centre delay (chorus_time_us). The line is mono
+ * S16 at half the frame rate and holds twice this for full depth: ~1 KB
+ * of the FX arena at the 10 ms default and 48 kHz.
+ */
+#ifndef APP_DSP_CHORUS_TIME_MAX_US
+#define APP_DSP_CHORUS_TIME_MAX_US 10000u
+#endif
+
+/* Build the chorus/flanger. 0 leaves its line and state out: "chorus"
+ * keeps its place in chain specs, AppDsp_SetFxMask() drops
+ * APP_FX_BIT_CHORUS and AppDsp_ParamBuilt() its params.
+ */
+#ifndef APP_DSP_CHORUS_ENABLE
+#define APP_DSP_CHORUS_ENABLE 1
+#endif
+
+/* Longest pitch shifter window (pitch_window_ms). Its line is mono S16 at
+ * half the frame rate and holds one window: ~1.9 KB of the FX arena at
+ * the 40 ms default and 48 kHz.
+ */
+#ifndef APP_DSP_PITCH_WINDOW_MAX_MS
+#define APP_DSP_PITCH_WINDOW_MAX_MS 40u
+#endif
+
+/* Build the pitch shifter. 0 leaves its line and state out: "pitch" keeps
+ * its place in chain specs, AppDsp_ParamBuilt() drops its params and CAPS
+ * leaves out its feat flag.
+ */
+#ifndef APP_DSP_PITCH_ENABLE
+#define APP_DSP_PITCH_ENABLE 1
+#endif
+
+/* Run the cab-sim lowpass on the FMAC accelerator (app_fmac.h) in parallel
+ * with the distortion instead of as a Q28 biquad on the core. The cab path
+ * then carries 16 bits; falls back to the software filter if the FMAC
+ * cannot be started.
+ */
+#ifndef APP_DSP_CAB_FMAC
+#define APP_DSP_CAB_FMAC 0
+#endif
+
+/* IR slots cab_ir can select (app_cabir.h). Presets store the number, so
+ * it does not follow the build: slots the flash does not hold play the
+ * biquad cab.
+ */
+#define APP_DSP_CAB_IR_SLOTS 8u
+
+/* Single-precision FPU kernels for the filter-heavy stages: DC blocker and
+ * HPFs, the wet and feedback low-passes, the cab biquad and the reverb FDN
+ * core and diffusers keep float state and coefficients. Block I/O, the line
+ * storage, the clipper, compressor and limiter stay fixed point, so the
+ * AppDsp_ API and RAM use do not change; the audio ISR stacks the FP
+ * context. COM BENCH on the target and tools/dsp_host (dsp_host_float,
+ * -c, THD+N on -s sine) compare the two builds.
+ */
+#ifndef APP_DSP_FLOAT
+#define APP_DSP_FLOAT 0
+#endif
+
+/* Distortion oversampling factor at boot (runtime: APP_DSP_PARAM_DIST_OVERSAMPLE).
+ * 1 is the original two-point average of the clipped sample, 2 and 4 run the
+ * clipper behind halfband FIRs. The hard clipper's harmonics fall off slowly,
+ * so 2x only helps at moderate drive; 4x takes the fold-back below 12 kHz
+ * down by ~7-12 dB at high drive. PROF reports each factor as its own stage
+ * (distortion / dist_os2 / dist_os4).
+ */
+#ifndef APP_DSP_DIST_OVERSAMPLE_DEFAULT
+#define APP_DSP_DIST_OVERSAMPLE_DEFAULT 4u
+#endif
+
+/* Oversampled island: when nothing runs between the always-on input
+ * coloration and the distortion (the modules ahead of it in the chain are
+ * idle, e.g. wah and pitch at mix 0), the coloration moves onto the
+ * distortion's halfband pair, ahead of the clipper at the same 2x/4x, and
+ * the base-rate pass is skipped. The two nonlinearities then alias-filter
+ * together for one up/down pair; the distortion's input high-pass follows
+ * the coloration at the high rate. A module at work in between, a parallel
+ * group or a wet bus keeps them apart, and so does the distortion's
+ * switching crossfade. PROF counts the coloration under the distortion's
+ * stage while it is on the island.
+ */
+#ifndef APP_DSP_DIST_ISLAND
+#define APP_DSP_DIST_ISLAND 1
+#endif
+
+/* Output limiter with lookahead: the gain comes from the peak of the next
+ * 16 frames (a sliding max over 8-frame sub-block peaks, one reciprocal per
+ * sub-block) and glides down over a sub-block ahead of a transient instead
+ * of clamping at it. Adds 16 frames of latency (0.33 ms at 48 kHz); 0 is
+ * the original instant-attack limiter.
+ */
+#ifndef APP_DSP_LIMITER_LOOKAHEAD
+#define APP_DSP_LIMITER_LOOKAHEAD 1
+#endif
+
+/* Fused conditioning: the DC blocker, the clean HPF and the input gain run
+ * as one second-order section precomputed at init (the gain folded into its
+ * numerator), and the makeup gain and master volume as one multiply. One
+ * rounding and one clamp where the separate stages had three, so the output
+ * is not bit-exact with the default build; PROF's dc_block stage then times
+ * the fused section and the comp stage no longer includes the input gain.
+ */
+#ifndef APP_DSP_FUSED_COND
+#define APP_DSP_FUSED_COND 0
+#endif
+
+/* Headroom tracking: the stages after the dry chain (delay, reverb, looper,
+ * output, limiter) carry a bound on the block's peak and skip their clamps
+ * when it proves they cannot clip. Bit-exact with 0, which clamps every
+ * sample as before.
+ */
+#ifndef APP_DSP_HEADROOM
+#define APP_DSP_HEADROOM 1
+#endif
+
+/* Preset spillover (AppDsp_CommitParamsSpill()): the longest a delay or
+ * reverb tail holds the outgoing preset's settings when the new one
+ * selects the same FX, whose input waits meanwhile. 0 makes a spill commit
+ * a plain one and drops the second block-parameter copy per context
+ * (~0.7 KB).
+ */
+#ifndef APP_DSP_SPILL_MS
+#define APP_DSP_SPILL_MS 1500u
+#endif
+
+/* Frames of the two block buses behind parallel FX groups (AppDsp_SetChain()):
+ * 8 bytes each per frame, shared with the wet bus of '+' groups. A longer
+ * block runs in pieces of this size while the chain has a parallel group;
+ * 0 drops the buses and rejects '|' and '+' specs.
+ */
+#ifndef APP_DSP_BUS_FRAMES
+#define APP_DSP_BUS_FRAMES 64u
+#endif
+
+/* Depth of the timed parameter queue (AppDsp_CommitParamsAt()). Each entry
+ * costs a parameter copy and a schedule bank, ~1 KB together (1.6 KB
+ * with the chorus and the pitch shifter built); 0 drops the queue and a
+ * timed commit lands at the next block boundary.
+ */
+#ifndef APP_DSP_PARAM_EVENTS
+#define APP_DSP_PARAM_EVENTS 1u
+#endif
+
+/* Static RAM share (app_profile.h): the delay and reverb budgets, the
+ * chorus and pitch lines with their states (1.2 and 2 KB), the reverb
+ * diffuser lines (1 KB at two stages, 2 KB beyond), the rest of the
+ * context (~2.1 KB plus its buses, the spill copies and the cab
+ * sections), and per parameter copy (two and the queue) the copy, its
+ * schedule bank and a part of the name hashes (~1 KB, 0.55 KB more for
+ * the chorus's schedule slots, and the pitch shifter's steps in each).
+ * Each term is measured and rounded up.
+ */
+#define APP_DSP_RAM_BYTES \
+  (APP_DSP_DELAY_RAM_BYTES + APP_DSP_REVERB_RAM_BYTES + (APP_DSP_CHORUS_ENABLE ? 1248u : 0u) + \
+   (APP_DSP_PITCH_ENABLE ? 2064u : 0u) + ((APP_DSP_REVERB_AP_STAGES > 2u) ? 2096u : 1024u) + \
+   2176u + ((APP_DSP_SPILL_MS > 0u) ? 720u : 0u) + (APP_DSP_CAB_SECTIONS_MAX * 28u) + \
+   ((APP_DSP_BUS_FRAMES > 0u) ? ((APP_DSP_BUS_FRAMES * 16u) + 32u) : 0u) + \
+   ((2u + APP_DSP_PARAM_EVENTS) * \
+    (992u + (APP_DSP_CHORUS_ENABLE ? 560u : 0u) + \
+     (APP_DSP_PITCH_ENABLE ? (APP_DSP_CHORUS_ENABLE ? 128u : 64u) : 0u) + \
+     (APP_DSP_CAB_SECTIONS_MAX * 20u))))
+
+/* Load shedding: when a block takes more than SHED_HIGH_PERMILLE of its
+ * period (AppDsp_ReportLoad()), the next blocks run one quality tier lower,
+ * each FX module swapping in its cheaper fallbacks (distortion oversampling
+ * capped at 2x then 1x, a cab IR cut to half then a quarter of its
+ * partitions). A tier is given back once blocks stayed under
+ * SHED_LOW_PERMILLE for SHED_HOLD_MS. 0 always runs at full quality.
+ * A switch to a dearer distortion (model, oversampling or the FX itself)
+ * steps down ahead of its first block when its declared cost
+ * (AppDspDistModel) added to the last block's load passes the high mark.
+ */
+#ifndef APP_DSP_SHED
+#define APP_DSP_SHED 1
+#endif
+
+#ifndef APP_DSP_SHED_HIGH_PERMILLE
+#define APP_DSP_SHED_HIGH_PERMILLE 850u
+#endif
+
+#ifndef APP_DSP_SHED_LOW_PERMILLE
+#define APP_DSP_SHED_LOW_PERMILLE 600u
+#endif
+
+#ifndef APP_DSP_SHED_HOLD_MS
+#define APP_DSP_SHED_HOLD_MS 2000u
+#endif
+
+/* Clip counters: per chain stage (AppProfStage), the blocks in which one
+ * of its clamps saturated, for gain staging. On the M4 this is the sticky
+ * APSR.Q flag every saturating SSAT sets, read and cleared once per stage
+ * and block, so the clamps themselves stay as they are; a host build marks
+ * the clamp's saturating branch instead. COM CLIP reads them.
+ */
+#ifndef APP_DSP_CLIP
+#define APP_DSP_CLIP 0
+#endif
+
 typedef enum
 {
   APP_FX_MODE_BYPASS = 0,
@@ -21,22 +350,297 @@ typedef enum
   APP_FX_BIT_DISTORTION = (1u << 0),
   APP_FX_BIT_REVERB     = (1u << 1),
   APP_FX_BIT_DELAY      = (1u << 2),
+  APP_FX_BIT_CHORUS     = (1u << 3),
+  APP_FX_BIT_PHASER     = (1u << 4),
 } AppFxBit;
 
 typedef uint32_t AppFxMask;
 
+/* Runtime parameters, one line each:
+ *   X(ID, name, min, max, unit, smoothed, clamp)
+ * The position is the AppDspParamId value, which presets and binary COM
+ * frames store, so new parameters go at the end. 'smoothed' params glide
+ * over ~21 ms (AppDsp_ProcessBlock()); out-of-range values are clamped when
+ * 'clamp' is 1 and ignored when it is 0 (discrete selections).
+ * delay_time_ms has no static max: it is AppDsp_GetDelayMaxMs().
+ */
+#define APP_DSP_PARAM_LIST(X) \
+  X(DIST_DRIVE_Q8,       "dist_drive_q8",       0, 131072,                            "q8",   1, 1) \
+  X(DELAY_MIX_Q15,       "delay_mix_q15",       0, 32768,                             "q15",  1, 1) \
+  X(DELAY_FEEDBACK_Q15,  "delay_feedback_q15",  0, 32768,                             "q15",  1, 1) \
+  X(REVERB_MIX_Q15,      "reverb_mix_q15",      0, 32768,                             "q15",  1, 1) \
+  X(REVERB_FEEDBACK_Q15, "reverb_feedback_q15", 0, 32768,                             "q15",  1, 1) \
+  X(REVERB_DAMP_Q15,     "reverb_damp_q15",     0, 32768,                             "q15",  1, 1) \
+  X(GAIN_Q15,            "gain_q15",            0, 65536,                             "q15",  1, 1) \
+  X(DELAY_TIME_MS,       "delay_time_ms",       1, 0,                                 "ms",   0, 1) \
+  X(DELAY_PATTERN,       "delay_pattern",       0, (APP_DSP_DELAY_PATTERN_COUNT - 1), "enum", 0, 0) \
+  X(DIST_OVERSAMPLE,     "dist_os",             1, 4,                                 "x",    0, 0) \
+  X(DIST_CURVE,          "dist_curve",          0, (APP_SHAPER_CURVE_COUNT - 1),      "enum", 0, 0) \
+  X(COLOR_CURVE,         "color_curve",         0, (APP_SHAPER_CURVE_COUNT - 1),      "enum", 0, 0) \
+  X(EQ_LOW_GAIN_DB10,    "eq_low_gain_db10",    -150, 150,                            "db10", 0, 1) \
+  X(EQ_LOW_FREQ_HZ,      "eq_low_freq_hz",      40, 1000,                             "hz",   0, 1) \
+  X(EQ_MID1_GAIN_DB10,   "eq_mid1_gain_db10",   -150, 150,                            "db10", 0, 1) \
+  X(EQ_MID1_FREQ_HZ,     "eq_mid1_freq_hz",     100, 8000,                            "hz",   0, 1) \
+  X(EQ_MID1_Q100,        "eq_mid1_q100",        30, 1000,                             "q100", 0, 1) \
+  X(EQ_MID2_GAIN_DB10,   "eq_mid2_gain_db10",   -150, 150,                            "db10", 0, 1) \
+  X(EQ_MID2_FREQ_HZ,     "eq_mid2_freq_hz",     200, 12000,                           "hz",   0, 1) \
+  X(EQ_MID2_Q100,        "eq_mid2_q100",        30, 1000,                             "q100", 0, 1) \
+  X(EQ_HIGH_GAIN_DB10,   "eq_high_gain_db10",   -150, 150,                            "db10", 0, 1) \
+  X(EQ_HIGH_FREQ_HZ,     "eq_high_freq_hz",     1000, 16000,                          "hz",   0, 1) \
+  X(GATE_THRESH_DB10,    "gate_thresh_db10",    -900, 0,                              "db10", 0, 1) \
+  X(GATE_RELEASE_MS,     "gate_release_ms",     5, 2000,                              "ms",   0, 1) \
+  X(COMP_THRESH_DB10,    "comp_thresh_db10",    -600, 0,                              "db10", 0, 1) \
+  X(COMP_RATIO_X10,      "comp_ratio_x10",      10, 200,                              "x10",  0, 1) \
+  X(COMP_KNEE_DB10,      "comp_knee_db10",      0, 240,                               "db10", 0, 1) \
+  X(COMP_MAKEUP_DB10,    "comp_makeup_db10",    0, 240,                               "db10", 0, 1) \
+  X(CHORUS_MIX_Q15,      "chorus_mix_q15",      0, 32768,                             "q15",  1, 1) \
+  X(CHORUS_RATE_MHZ,     "chorus_rate_mhz",     50, 10000,                            "mhz",  0, 1) \
+  X(CHORUS_DEPTH_Q15,    "chorus_depth_q15",    0, 32768,                             "q15",  1, 1) \
+  X(CHORUS_TIME_US,      "chorus_time_us",      300, APP_DSP_CHORUS_TIME_MAX_US,      "us",   0, 1) \
+  X(CHORUS_FEEDBACK_Q15, "chorus_feedback_q15", 0, 29491,                             "q15",  1, 1) \
+  X(CHORUS_SPREAD_DEG,   "chorus_spread_deg",   0, 180,                               "deg",  0, 1) \
+  X(PHASER_MIX_Q15,      "phaser_mix_q15",      0, 32768,                             "q15",  1, 1) \
+  X(PHASER_RATE_MHZ,     "phaser_rate_mhz",     50, 10000,                            "mhz",  0, 1) \
+  X(PHASER_DEPTH_Q15,    "phaser_depth_q15",    0, 32768,                             "q15",  1, 1) \
+  X(PHASER_FREQ_HZ,      "phaser_freq_hz",      50, 2000,                             "hz",   0, 1) \
+  X(PHASER_STAGES,       "phaser_stages",       4, 8,                                 "x",    0, 0) \
+  X(PHASER_SPREAD_DEG,   "phaser_spread_deg",   0, 180,                               "deg",  0, 1) \
+  X(TREMOLO_DEPTH_Q15,   "tremolo_depth_q15",   0, 32768,                             "q15",  1, 1) \
+  X(TREMOLO_PAN_Q15,     "tremolo_pan_q15",     0, 32768,                             "q15",  1, 1) \
+  X(TREMOLO_DIV,         "tremolo_div",         0, (APP_DSP_TREMOLO_DIV_COUNT - 1),   "enum", 0, 0) \
+  X(TEMPO_BPM,           "tempo_bpm",           20, 300,                              "bpm",  0, 1) \
+  X(WAH_MIX_Q15,         "wah_mix_q15",         0, 32768,                             "q15",  1, 1) \
+  X(WAH_FREQ_HZ,         "wah_freq_hz",         100, 1500,                            "hz",   0, 1) \
+  X(WAH_DEPTH_Q15,       "wah_depth_q15",       0, 32768,                             "q15",  1, 1) \
+  X(WAH_SENS_DB10,       "wah_sens_db10",       -600, 0,                              "db10", 0, 1) \
+  X(WAH_Q100,            "wah_q100",            70, 1000,                             "q100", 0, 1) \
+  X(PITCH_MIX_Q15,       "pitch_mix_q15",       0, 32768,                             "q15",  1, 1) \
+  X(PITCH_CENTS,         "pitch_cents",         -1200, 1200,                          "cent", 0, 1) \
+  X(PITCH_WINDOW_MS,     "pitch_window_ms",     10, APP_DSP_PITCH_WINDOW_MAX_MS,      "ms",   0, 1) \
+  X(TONE_MODEL,          "tone_model",          0, (APP_DSP_TONE_MODEL_COUNT - 1),    "enum", 0, 0) \
+  X(TONE_BASS_Q15,       "tone_bass_q15",       0, 32768,                             "q15",  1, 1) \
+  X(TONE_MID_Q15,        "tone_mid_q15",        0, 32768,                             "q15",  1, 1) \
+  X(TONE_TREBLE_Q15,     "tone_treble_q15",     0, 32768,                             "q15",  1, 1) \
+  X(REVERB_ROOM,         "reverb_room",         0, (APP_DSP_REVERB_ROOM_COUNT - 1),   "enum", 0, 0) \
+  X(REVERB_ER_Q15,       "reverb_er_q15",       0, 32768,                             "q15",  1, 1) \
+  X(REVERB_DECAY_MS,     "reverb_decay_ms",     0, 20000,                             "ms",   0, 1) \
+  X(REVERB_HF_DAMP_HZ,   "reverb_hf_damp_hz",   0, 12000,                             "hz",   0, 1) \
+  X(REVERB_TYPE,         "reverb_type",         0, (APP_DSP_REVERB_TYPE_COUNT - 1),   "enum", 0, 0) \
+  X(DELAY_SYNC,          "delay_sync",          0, (APP_DSP_SYNC_COUNT - 1),          "enum", 0, 0) \
+  X(CHORUS_SYNC,         "chorus_sync",         0, (APP_DSP_SYNC_COUNT - 1),          "enum", 0, 0) \
+  X(PHASER_SYNC,         "phaser_sync",         0, (APP_DSP_SYNC_COUNT - 1),          "enum", 0, 0) \
+  X(DELAY_DUCK_Q15,      "delay_duck_q15",      0, 32768,                             "q15",  0, 1) \
+  X(REVERB_DIFFUSION,    "reverb_diffusion",    2, APP_DSP_REVERB_AP_STAGES,          "x",    0, 1) \
+  X(WET_WIDTH_Q15,       "wet_width_q15",       0, 65536,                             "q15",  1, 1) \
+  X(CAB_IR,              "cab_ir",              0, (APP_DSP_CAB_IR_SLOTS - 1),        "enum", 0, 0) \
+  X(DIST_MODEL,          "dist_model",          0, (APP_DSP_DIST_MODEL_COUNT - 1),    "enum", 0, 0) \
+  X(REVERB_FREEZE,       "reverb_freeze",       0, 1,                                 "enum", 0, 0)
+
+/* DELAY_PATTERN: AppDspDelayPattern. DIST_OVERSAMPLE: 1, 2 or 4.
+ * PHASER_STAGES: 4, 6 or 8 allpass stages.
+ * TREMOLO_*: tremolo / auto-pan in the output stage, off at depth 0. Pan
+ * 0 moves both sides together, 32768 in opposition. TREMOLO_DIV:
+ * AppDspTremoloDiv, one cycle per that note at tempo_bpm (the pedal's
+ * tempo, set directly or by AppDsp_TapTempo()).
+ * DELAY_SYNC / CHORUS_SYNC / PHASER_SYNC: AppDspSyncDiv, off at 0. While on,
+ * delay_time_ms is that note at tempo_bpm (halved until the line holds
+ * it) and chorus_rate_mhz / phaser_rate_mhz one LFO cycle per note; a
+ * direct set of those lasts until the next tempo change. The delay glides
+ * to a new tempo like any delay_time_ms change.
+ * WAH_*: envelope-following auto-wah ahead of the distortion, off at mix
+ * 0. The input envelope (the compressor's detector) sweeps a resonant
+ * bandpass from wah_freq_hz up to depth * 4 octaves, reaching the top at
+ * wah_sens_db10 (dBFS); Q * 100.
+ * PITCH_*: pitch shifter / octaver ahead of the distortion, off at mix 0
+ * (32768 = shifted signal only). pitch_cents: -1200 (octave down) to
+ * +1200 (octave up); pitch_window_ms: grain length, longer is smoother on
+ * chords, shorter follows single notes more tightly.
+ * TONE_*: amp tone stack between the clipper and the cab, off at
+ * tone_model 0 (AppDspToneModel). Knob positions 0..32768 (noon 16384),
+ * bass on an audio taper; noon is 0 dB at the stack's peak, full boost
+ * adds up to ~4.5 dB.
+ * REVERB_ROOM / REVERB_ER_Q15: early reflections ahead of the reverb tail,
+ * off at reverb_room 0 (AppDspReverbRoom), reverb_er_q15 their level.
+ * REVERB_DECAY_MS / REVERB_HF_DAMP_HZ: RT60 of the tail and the frequency
+ * where it is half as long, the same on any tank size or reverb rate;
+ * 0 leaves reverb_feedback_q15 / reverb_damp_q15 in charge of that part.
+ * REVERB_TYPE: AppDspReverbType. The spring has its own fixed damping and
+ * no early reflections; its decay follows reverb_feedback_q15 or
+ * reverb_decay_ms. Without APP_DSP_SPRING_ENABLE the spring is refused
+ * (AppDsp_ParamBuilt()).
+ * REVERB_DIFFUSION: allpass stages behind the FDN (2 up to
+ * APP_DSP_REVERB_AP_STAGES); each one smooths the tail's onset a little
+ * more for one stereo allpass per reverb frame.
+ * REVERB_FREEZE: 1 holds the tail as an endless pad: the tank's feedback
+ * glides to unity with its damping open and its input to silence, over
+ * the usual parameter glide, and back at 0. Once there, the reverb skips
+ * its input path and the line dampers, so a frozen pad costs less than
+ * the live reverb. The reverb still needs to be in the FX mask.
+ * DIST_CURVE / COLOR_CURVE: AppShaperCurve (app_shaper.h), default hard / soft.
+ * DIST_MODEL: AppDspDistModel, the circuit around the clipper; overdrive
+ * and crush clip on dist_curve, tube and fuzz on their own curve.
+ * EQ_*: post-cab EQ (app_eq.h), low shelf, two peaking bands, high shelf;
+ * gain in 0.1 dB (0 = band off), Q * 100. Not smoothed: a new design is
+ * swapped in at the next block boundary.
+ * GATE_*: noise gate ahead of the input gain. It opens when a block's RMS
+ * reaches gate_thresh_db10 (dBFS, 0 = gate off) and closes over
+ * gate_release_ms once the RMS stayed 6 dB lower for 50 ms. While it is shut
+ * and the delay and reverb tails have gone to sleep, the rest of the chain
+ * is skipped.
+ * COMP_*: input compressor after the input gain, on the peak envelope:
+ * threshold in dBFS, ratio * 10 (10 = 1:1, off), soft-knee width and
+ * makeup gain in 0.1 dB. Not smoothed themselves: the compressor's own
+ * gain smoothing glides to the new curve.
+ * DELAY_DUCK_Q15: how far the delay's wet drops while the input is loud
+ * (0 = off, 32768 = silent repeats). It follows the block RMS the gate
+ * uses, a block late, from -45 dBFS (no duck) to -21 dBFS (full), and
+ * comes back over ~400 ms once the playing stops.
+ * WET_WIDTH_Q15: stereo width of the summed wet of a '+' group
+ * (AppDsp_SetChain()), e.g. delay+reverb: the side of the sum times
+ * wet_width_q15, the mid as it is. 0 = mono wet, 32768 = as the FX leave
+ * it, 65536 = twice the side. The dry and serial FX are not touched.
+ * Refused (AppDsp_ParamBuilt()) without the buses, APP_DSP_BUS_FRAMES 0.
+ * CAB_IR: the IR slot the distortion's cab convolves with (app_cabir.h,
+ * APP_CABIR_ENABLE builds); an empty slot plays the biquad cab. Switching
+ * slots keeps the convolution history, so the new cab takes over at once.
+ */
 typedef enum
 {
-  APP_DSP_PARAM_DIST_DRIVE_Q8 = 0,
-  APP_DSP_PARAM_DELAY_MIX_Q15,
-  APP_DSP_PARAM_DELAY_FEEDBACK_Q15,
-  APP_DSP_PARAM_REVERB_MIX_Q15,
-  APP_DSP_PARAM_REVERB_FEEDBACK_Q15,
-  APP_DSP_PARAM_REVERB_DAMP_Q15,
-  APP_DSP_PARAM_GAIN_Q15,
+#define APP_DSP_PARAM_ENUM(id, name, min, max, unit, smoothed, clamp) APP_DSP_PARAM_##id,
+  APP_DSP_PARAM_LIST(APP_DSP_PARAM_ENUM)
+#undef APP_DSP_PARAM_ENUM
+  APP_DSP_PARAM_COUNT
 } AppDspParamId;
 
+typedef struct
+{
+  const char *name;        /* COM name (PSET, STATUS) */
+  const char *unit;        /* q8, q15, ms, us, x, x10, enum, db10, hz, mhz, deg, bpm, q100 or cent */
+  int32_t min;
+  int32_t max;
+  int32_t def;             /* boot value of this build */
+  uint16_t smooth_ms;      /* glide time, 0 = steps at the block boundary */
+  uint8_t clamp;           /* 1: out-of-range values clamp, 0: ignored */
+} AppDspParamDesc;
+
+/* Delay tap patterns. All taps read the one delay line; tap times are
+ * fractions of delay_time_ms (one beat) and the full-time read always drives
+ * the feedback. Selecting a pattern overwrites the tap table.
+ */
+typedef enum
+{
+  APP_DSP_DELAY_SINGLE = 0,   /* one tap at the delay time */
+  APP_DSP_DELAY_PINGPONG,     /* input enters on L, repeats cross sides */
+  APP_DSP_DELAY_DOTTED,       /* dotted eighth (3/4 beat) L + quarter R */
+  APP_DSP_DELAY_QUAD,         /* 1/4, 2/4, 3/4, 4/4 beat, spread L/R */
+  APP_DSP_DELAY_REVERSE,      /* the line played backwards in crossfaded
+                               * windows of the delay time (at most half the
+                               * line); the tap table is not read */
+  APP_DSP_DELAY_PATTERN_COUNT
+} AppDspDelayPattern;
+
+/* Tremolo rate as a note value at tempo_bpm (TREMOLO_DIV), one LFO cycle
+ * per note: 20..300 bpm spans 0.17 Hz (half notes) to 20 Hz (sixteenths).
+ */
+typedef enum
+{
+  APP_DSP_TREMOLO_HALF = 0,
+  APP_DSP_TREMOLO_QUARTER,      /* one cycle per beat */
+  APP_DSP_TREMOLO_EIGHTH,
+  APP_DSP_TREMOLO_TRIPLET,      /* eighth-note triplets */
+  APP_DSP_TREMOLO_SIXTEENTH,
+  APP_DSP_TREMOLO_DIV_COUNT
+} AppDspTremoloDiv;
+
+/* Note values of DELAY_SYNC, CHORUS_SYNC and PHASER_SYNC at tempo_bpm. */
+typedef enum
+{
+  APP_DSP_SYNC_OFF = 0,         /* the time / rate parameter as set */
+  APP_DSP_SYNC_HALF,
+  APP_DSP_SYNC_QUARTER,         /* one beat */
+  APP_DSP_SYNC_DOTTED_EIGHTH,
+  APP_DSP_SYNC_EIGHTH,
+  APP_DSP_SYNC_TRIPLET,         /* eighth-note triplet */
+  APP_DSP_SYNC_SIXTEENTH,
+  APP_DSP_SYNC_COUNT
+} AppDspSyncDiv;
+
+/* Tone stack circuit (TONE_MODEL): the passive bass/mid/treble network of
+ * the amp, its response tabulated over the knobs (app_tables.h).
+ */
+typedef enum
+{
+  APP_DSP_TONE_OFF = 0,
+  APP_DSP_TONE_FENDER,          /* '59 Bassman: 250k/1M/25k, 56k slope, 250p/20n/20n */
+  APP_DSP_TONE_MARSHALL,        /* JCM800: 220k/1M/22k, 33k slope, 470p/22n/22n */
+  APP_DSP_TONE_MODEL_COUNT
+} AppDspToneModel;
+
+/* Distortion circuit (DIST_MODEL). Each is a block kernel on the shared
+ * waveshaper tables (app_shaper.h) with a declared cost, the cycles it
+ * takes per sample at each oversampling factor
+ * (AppDsp_GetDistModel()): the load shedder steps down ahead of a switch
+ * that would not fit the last block's load, and COM DMODEL lists the cost
+ * of each before one is picked.
+ */
+typedef enum
+{
+  APP_DSP_DIST_OVERDRIVE = 0,   /* the original circuit: 150 Hz HPF, clipper, ~3.5 kHz LPF */
+  APP_DSP_DIST_TUBE,            /* biased tube curve, asymmetric, darker LPF */
+  APP_DSP_DIST_FUZZ,            /* biased fuzz curve at 4x the drive */
+  APP_DSP_DIST_CRUSH,           /* bitcrusher / decimator behind the clipper, never oversampled */
+  APP_DSP_DIST_MODEL_COUNT
+} AppDspDistModel;
+
+/* Early-reflection pattern of the reverb (REVERB_ROOM): four sparse taps
+ * per side, spread wider and sparser as the room grows. The delays scale
+ * with the tank, i.e. with APP_DSP_REVERB_RAM_BYTES.
+ */
+typedef enum
+{
+  APP_DSP_REVERB_ROOM_OFF = 0,
+  APP_DSP_REVERB_ROOM_SMALL,    /* taps at ~9..35% of the tank lines */
+  APP_DSP_REVERB_ROOM_MEDIUM,   /* ~16..59% */
+  APP_DSP_REVERB_ROOM_LARGE,    /* ~28..91% */
+  APP_DSP_REVERB_ROOM_COUNT
+} AppDspReverbRoom;
+
+/* Reverb tank (REVERB_TYPE). Both share one buffer, so a switch cuts the
+ * tail.
+ */
+typedef enum
+{
+  APP_DSP_REVERB_TYPE_FDN = 0,  /* 4-line feedback delay network: room / hall */
+  APP_DSP_REVERB_TYPE_SPRING,   /* one dispersive spring: amp-style drip */
+  APP_DSP_REVERB_TYPE_COUNT
+} AppDspReverbType;
+
+#define APP_DSP_DELAY_TAPS_MAX 4u
+
+typedef struct
+{
+  uint16_t time_q12;   /* 0..4096 = 0..1x delay_time_ms */
+  uint16_t pan_q15;    /* 0 = left, 16384 = centre, 32768 = right (balance) */
+  int32_t gain_q15;    /* 0 disables the tap */
+} AppDspDelayTap;
+
+/* One interleaved stereo frame (L then R, signed 24-bit in int32_t).
+ * Block buffers, the audio ring and the stereo delay lines all use this
+ * layout, so a frame moves with a single LDRD/STRD.
+ */
+typedef struct
+{
+  int32_t l;
+  int32_t r;
+} AppStereoS24;
+
 void AppDsp_Init(void);
+/* AppDsp_Init() for the first call after reset: the C startup has zeroed
+ * the delay lines, reverb and distortion state, so only the state that is
+ * not zero is set and the ~22 KB clear is skipped on the way to the first
+ * audio block.
+ */
+void AppDsp_InitAtBoot(void);
 
 /* Debounced mode cycle for a single user action.
  * Pass a monotonically increasing millisecond tick (e.g. HAL_GetTick()).
@@ -45,18 +649,356 @@ void AppDsp_OnButtonPress(uint32_t now_ms);
 
 AppFxMode AppDsp_GetMode(void);
 
+/* Tap tempo (COM TAP, a footswitch): one call per tap with a millisecond
+ * tick (e.g. HAL_GetTick()). From the second tap on, tempo_bpm follows the
+ * mean of the last four intervals, rounded to a whole bpm; a tap within
+ * 200 ms of the last one (over 300 bpm) is a bounce and ignored, and a gap
+ * over 3 s (under 20 bpm) starts a new count. Returns the tempo set, 0
+ * while waiting for a second tap. Control side only (main loop).
+ */
+uint32_t AppDsp_TapTempo(uint32_t now_ms);
+
 /* New control API: effect combinations + runtime parameters (for COM control). */
 void AppDsp_SetFxMask(AppFxMask mask);
 AppFxMask AppDsp_GetFxMask(void);
 
+/* FX mask bits of modules left out of the build: AppDsp_SetFxMask() drops
+ * them, so a control link refuses them instead (COM FXMASK).
+ */
+#define APP_DSP_FX_BITS_MISSING ((APP_DSP_CHORUS_ENABLE ? 0u : (uint32_t)APP_FX_BIT_CHORUS))
+
+/* Bypass tier (COM BYPASS), on top of the FX mask, which it leaves alone:
+ * - OFF: the chain as the mask selects it.
+ * - COND: conditioning only: DC block, gate, compressor, coloration,
+ *   output gains and limiter run, the FX fade out as with mask 0 and
+ *   fade back in on OFF. Any context.
+ * - TRUE: AppDsp_ProcessBlock() passes its input through untouched, the
+ *   chain, meters, tuner and capture stopped. Its tails are cut: on the
+ *   way out the lines and filters start over cleared.
+ * Into and out of TRUE the output is joined over a few frames, so the
+ * switch does not click. Taken at the next block.
+ */
+typedef enum
+{
+  APP_DSP_BYPASS_OFF = 0,
+  APP_DSP_BYPASS_COND,
+  APP_DSP_BYPASS_TRUE,
+  APP_DSP_BYPASS_COUNT
+} AppDspBypass;
+
+void AppDsp_SetBypass(AppDspBypass tier);
+AppDspBypass AppDsp_GetBypass(void);
+
 void AppDsp_SetParam(AppDspParamId id, int32_t value);
 int32_t AppDsp_GetParam(AppDspParamId id);
 
+/* 0 if setting id to value would ask for a module left out of the build
+ * (its params change nothing there), for a control link to refuse.
+ */
+uint8_t AppDsp_ParamBuilt(AppDspParamId id, int32_t value);
+
+/* Descriptor of one parameter (limits resolved for this build). Returns 0
+ * if id is out of range.
+ */
+uint8_t AppDsp_GetParamDesc(AppDspParamId id, AppDspParamDesc *out);
+
+/* Name -> id lookup (hash compare, one strcmp to confirm). */
+uint8_t AppDsp_FindParam(const char *name, AppDspParamId *out);
+
+/* Parameter batch for multi-parameter changes (presets). Between Begin and
+ * Commit, AppDsp_SetParam()/AppDsp_SetDelayTap() only edit a back copy that
+ * the audio path picks up as a whole at the next block boundary; outside a
+ * batch each call is published on its own. Get returns the edited values.
+ * Control side only (main loop), like the setters.
+ */
+void AppDsp_BeginParams(void);
+void AppDsp_CommitParams(void);
+
+/* AppDsp_CommitParams() for a preset switch (AppPreset_Load()): the delay
+ * and reverb tails ring out on the outgoing settings instead of taking the
+ * new ones, their input shut, while the rest of the chain switches. An FX
+ * the new preset also selects gets its input back once its old tail has
+ * died away, or after APP_DSP_SPILL_MS.
+ */
+void AppDsp_CommitParamsSpill(void);
+
+/* Parameter-set versions: every set published (a setter outside a batch,
+ * a commit, a timed commit as it is queued) is stamped with the next
+ * number, 1 the first after boot; a re-init does not start over. A host
+ * compares one integer to tell whether a reply covers its latest command.
+ * AppDsp_ParamsVersion() is the newest published set's. Control side
+ * only, like the setters.
+ *
+ * AppDsp_SnapshotParams() pins the set the audio path runs from its next
+ * block on (the front copy, which the audio path only reads) and returns
+ * its version; AppDsp_SnapshotParam() / AppDsp_SnapshotFxMask() then read
+ * that one set, never a half-applied batch, until the next edit.
+ */
+uint32_t AppDsp_ParamsVersion(void);
+uint32_t AppDsp_SnapshotParams(void);
+int32_t AppDsp_SnapshotParam(AppDspParamId id);
+AppFxMask AppDsp_SnapshotFxMask(void);
+
+/* Control latency (COM's "@<t>" probe): AppDsp_WatchParams() waits for the
+ * block that first runs on the given version or a later one, and
+ * AppDsp_WatchedBlock() returns 1 with that block's start in
+ * AppProf_Cycles() once it has run. A new watch replaces the old one.
+ */
+void AppDsp_WatchParams(uint32_t version);
+uint8_t AppDsp_WatchedBlock(uint32_t *cycles);
+
+/* Timed commits: a batch that lands at an exact frame instead of the next
+ * block boundary, for tap tempo, MIDI clock and scripted automation.
+ * AppDsp_Now() counts the frames AppDsp_ProcessBlock() has run since
+ * AppDsp_Init() (block index times block length plus the offset in the
+ * block), and wraps; a frame must lie within 2^31 of it. The block is cut
+ * at that frame: stepped values apply from its first sample and glides
+ * start there. A frame already past lands at the next block boundary.
+ *
+ * Commits land in call order: a later event never overtakes an earlier
+ * one, and an untimed publish made while events are pending queues behind
+ * them. With the queue full (APP_DSP_PARAM_EVENTS), CommitParamsAt returns
+ * 0 and leaves the batch open: retry, or AppDsp_CommitParams() to land it
+ * untimed. AppDsp_Poll() (main loop) publishes an untimed change that
+ * found the queue full. Control side only, like the setters.
+ */
+uint32_t AppDsp_Now(void);
+uint8_t AppDsp_CommitParamsAt(uint32_t frame);
+uint8_t AppDsp_SetParamAt(AppDspParamId id, int32_t value, uint32_t frame);
+void AppDsp_Poll(void);
+
+/* FX chain order. A spec names every FX module once ("wah", "pitch",
+ * "distortion", "eq", "phaser", "chorus", "delay", "reverb"): '>' feeds
+ * the next module the previous one's output, '|' runs a module in parallel
+ * with the one before it, both on the same input, the dry signal passing
+ * once and their wet parts added
+ * ("wah>pitch>distortion>eq>phaser>chorus>delay|reverb"). '+' is the same
+ * routing on a shared wet bus
+ * ("wah>pitch>distortion>eq>phaser>chorus>delay+reverb", delay and reverb
+ * only): the members' raw wet outputs are summed, each at its mix, and one
+ * wet HPF/LPF pair conditions the sum where each member would run its own.
+ * The default is "wah>pitch>distortion>eq>phaser>chorus>delay>reverb".
+ * Returns 0 for a malformed spec, a group joined by both '|' and '+' and,
+ * with APP_DSP_MONO_INPUT, for one that puts the wah, pitch shifter,
+ * distortion or EQ after (or beside) phaser, chorus, delay or reverb.
+ * Published like a parameter, batches included.
+ */
+#define APP_DSP_CHAIN_SPEC_MAX 64u
+uint8_t AppDsp_SetChain(const char *spec);
+void AppDsp_GetChain(char *out, uint32_t size);
+
+/* Longest delay time this build's delay line can hold. */
+uint32_t AppDsp_GetDelayMaxMs(void);
+
+/* Edit one entry of the current tap table (values are clamped).
+ * Returns 0 if index >= APP_DSP_DELAY_TAPS_MAX.
+ */
+uint8_t AppDsp_SetDelayTap(uint32_t index, const AppDspDelayTap *tap);
+uint8_t AppDsp_GetDelayTap(uint32_t index, AppDspDelayTap *out);
+
+/* User cab: a cascade of up to APP_DSP_CAB_SECTIONS_MAX biquads in place of
+ * the fixed 5 kHz cab lowpass, e.g. a cabinet IR fitted by
+ * tools/dsp_host/cab_fit.c. A section is {b0, b1, b2, a1, a2} in Q28
+ * (|c| < 8), y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2. SetCabSection()
+ * returns 0 for an index out of range or an unstable section;
+ * SetCabSections() sets how many run, 0 = the lowpass again. Published like
+ * a parameter, batches included. An IR in the cab_ir slot (app_cabir.h)
+ * still wins, and the FMAC only takes the lowpass. RAM only: presets do
+ * not carry it and a reset brings the lowpass back.
+ * Each section costs 20 bytes per parameter copy and 28 of state; 0 builds
+ * without the user cab (every index is out of range).
+ */
+#ifndef APP_DSP_CAB_SECTIONS_MAX
+#define APP_DSP_CAB_SECTIONS_MAX 6u
+#endif
+uint8_t AppDsp_SetCabSection(uint32_t index, const int32_t sos[5]);
+uint8_t AppDsp_GetCabSection(uint32_t index, int32_t sos[5]);
+uint8_t AppDsp_SetCabSections(uint32_t count);
+uint32_t AppDsp_GetCabSections(void);
+
+/* Looper, mixed into the FX output ahead of the master volume. It records
+ * the mono sum at the delay line's 1/8 rate through the same resampler, so
+ * the loop is band-limited to ~2.4 kHz like the echoes. The buffer is
+ * whatever RAM main.c has left (AppMem_ClaimFree()); without one every
+ * command fails.
+ *
+ *   REC    empty: record; recording: close the loop and overdub;
+ *          playing or stopped: overdub; overdubbing: back to play
+ *   PLAY   recording: close the loop and play; stopped: play from the top
+ *   STOP   recording: close the loop; playback fades out
+ *   CLEAR  drop the loop
+ *
+ * A recording that fills the buffer closes the loop and plays. Commands are
+ * taken at the next block boundary, one per block.
+ */
+typedef enum
+{
+  APP_DSP_LOOP_EMPTY = 0,
+  APP_DSP_LOOP_RECORD,
+  APP_DSP_LOOP_PLAY,
+  APP_DSP_LOOP_OVERDUB,
+  APP_DSP_LOOP_STOPPED,
+} AppDspLoopState;
+
+typedef enum
+{
+  APP_DSP_LOOP_CMD_REC = 0,
+  APP_DSP_LOOP_CMD_PLAY,
+  APP_DSP_LOOP_CMD_STOP,
+  APP_DSP_LOOP_CMD_CLEAR,
+} AppDspLoopCmd;
+
+typedef struct
+{
+  AppDspLoopState state;
+  uint32_t len_ms;     /* loop length, or recorded so far */
+  uint32_t pos_ms;
+  uint32_t max_ms;     /* longest loop the buffer holds, 0 = no buffer */
+  uint32_t bytes;
+} AppDspLoopInfo;
+
+/* Hands the looper its storage; once at boot, before audio starts. */
+void AppDsp_SetLoopBuffer(uint32_t *buf, uint32_t bytes);
+
+/* Queues a command for the audio side. Returns 0 without a buffer. */
+uint8_t AppDsp_LoopCommand(AppDspLoopCmd cmd);
+void AppDsp_GetLoopInfo(AppDspLoopInfo *out);
+
 /* In-place processing of one stereo frame.
  * Samples are signed 24-bit in int32_t (range: [-8388608, 8388607]).
  */
 void AppDsp_ProcessFrame(int32_t *l_s24, int32_t *r_s24);
 
+/* In-place processing of n interleaved stereo frames (same sample format as
+ * AppDsp_ProcessFrame()).
+ * FX mask and parameters are sampled once at the start of the block, so a
+ * change made mid-block takes effect on the next block boundary (a timed
+ * commit, AppDsp_CommitParamsAt(), at its frame). Level,
+ * drive, feedback and damping then glide to the new value over ~21 ms.
+ */
+void AppDsp_ProcessBlock(AppStereoS24 *x, uint32_t n);
+
+/* DSP contexts: the chain's state (filters, gate, compressor, limiter,
+ * ramps, FX states, the compiled steps) as one object, so several chains
+ * can run side by side, e.g. dual mono with one instrument on each input,
+ * or many instances in a host harness. AppDsp_ProcessBlock() runs the
+ * default context.
+ *
+ * The others (secondary) share the parameters, FX mask and chain order
+ * with it, but only run what keeps all its state in the context: the input
+ * conditioning, gate, compressor, coloration, distortion with the biquad
+ * cab, output gain and limiter. The delay, reverb, EQ and looper, the
+ * IR/FMAC cab and the meter, capture, tuner and self-test taps stay with
+ * the default context. Contexts are independent, so they may run from
+ * different threads; the PROF and CLIP counters add up all of them.
+ *
+ * ContextCreate places one in mem (AppDsp_ContextBytes(), 8-byte aligned;
+ * NULL if it does not fit) and resets it. ContextReset clears a context
+ * (the default one with its delay line, tank and looper) and must not run
+ * while it is processing.
+ */
+typedef struct AppDspContext AppDspContext;
+
+AppDspContext *AppDsp_DefaultContext(void);
+uint32_t AppDsp_ContextBytes(void);
+AppDspContext *AppDsp_ContextCreate(void *mem, uint32_t bytes);
+void AppDsp_ContextReset(AppDspContext *ctx);
+void AppDsp_ContextProcess(AppDspContext *ctx, AppStereoS24 *x, uint32_t n);
+
+/* Cycle benchmark (COM BENCH; audio must be stopped). Runs 'blocks' blocks
+ * of n frames of a fixed synthetic input through one stage kernel
+ * (AppProfStage, all FX sends open) or one whole chain, in x as scratch,
+ * and returns the DWT cycles spent inside it. Each run starts from and
+ * leaves a cleared DSP state; parameters and FX mask are kept.
+ */
+uint64_t AppDsp_BenchStage(uint32_t stage, AppStereoS24 *x, uint32_t n, uint32_t blocks);
+uint64_t AppDsp_BenchChain(AppFxMask mask, AppStereoS24 *x, uint32_t n, uint32_t blocks);
+
+/* Kernel microbenchmarks (COM BENCH KERNEL): one per-sample DSP kernel on
+ * its own, stereo, over the same input and with the same state handling
+ * as AppDsp_BenchStage(). per_frame != 0 calls it once per frame, as the
+ * AppDsp_ProcessFrame() path does, else once per n-frame block.
+ */
+typedef enum
+{
+  APP_DSP_KERNEL_DC_BLOCK = 0,      /* dc_block_s24 */
+  APP_DSP_KERNEL_HPF1,              /* hpf1_s24, clean HPF corner */
+  APP_DSP_KERNEL_CAB_BIQUAD,        /* cab_biquad_s24, the fixed cab lowpass */
+  APP_DSP_KERNEL_ALLPASS1,          /* allpass1_process_s24_len, one phaser stage */
+  APP_DSP_KERNEL_ALLPASS_STEREO,    /* allpass_process_stereo_s24, one reverb diffuser stage */
+  APP_DSP_KERNEL_REVERB,            /* reverb_process_s24, FDN + ER + diffuser */
+  APP_DSP_KERNEL_DISTORTION,        /* distortion_process_s24, os 1 */
+  APP_DSP_KERNEL_DISTORTION_OS4,    /* same, 4x oversampled */
+  APP_DSP_KERNEL_DIST_TUBE_OS4,     /* the tube model's kernel, 4x oversampled */
+  APP_DSP_KERNEL_DIST_FUZZ_OS4,     /* the fuzz model's kernel, 4x oversampled */
+  APP_DSP_KERNEL_DIST_CRUSH,        /* the crush model's kernel */
+  APP_DSP_KERNEL_COUNT,
+} AppDspKernel;
+
+const char *AppDsp_KernelName(AppDspKernel kernel);
+uint64_t AppDsp_BenchKernel(AppDspKernel kernel, uint8_t per_frame, AppStereoS24 *x, uint32_t n, uint32_t blocks);
+
+/* Large static buffers of the module for COM MEM MAP. */
+uint32_t AppDsp_MemMap(const AppMemItem **items);
+
+/* The FX arena pool as raw RAM for a caller that has stopped the audio
+ * for good (the firmware update, app_update.h): whatever DSP state it held
+ * is gone.
+ */
+void *AppDsp_ArenaScratch(uint32_t *bytes);
+
+/* FX arena (COM MEM): the delay line and reverb tank are carved from one
+ * pool at init rather than kept as separate statics, and effects that never
+ * run together overlay the same bytes (reverb tank and cab IR line, see
+ * app_cabir.h). 'shared' is what the overlays save; 'owner' is the member
+ * currently holding the overlay.
+ */
+typedef struct
+{
+  uint32_t size;
+  uint32_t used;
+  uint32_t shared;
+  const char *owner;
+} AppDspArenaInfo;
+
+void AppDsp_GetArena(AppDspArenaInfo *out);
+
+/* Load shedding (APP_DSP_SHED). Audio side, after each block: the cycles
+ * its processing took, the cycles its n frames last (the deadline), and n.
+ */
+void AppDsp_ReportLoad(uint32_t cycles, uint32_t budget, uint32_t n);
+
+typedef struct
+{
+  uint32_t tier;       /* 0 = full quality */
+  uint32_t tier_max;   /* lowest tier the modules offer */
+  uint32_t sheds;      /* steps down since boot */
+  uint32_t restores;   /* steps back up */
+} AppDspShedInfo;
+
+void AppDsp_GetShed(AppDspShedInfo *out);
+
+/* A distortion model's name and declared cost: cycles per channel sample
+ * on the M4 at oversampling 1, 2 and 4 (crush: the same at every factor).
+ * Returns 0 past the last model. Cycles() is the cost of one frame, both
+ * channels, at the factor os.
+ */
+typedef struct
+{
+  const char *name;
+  uint16_t cyc_sample[3];
+} AppDspDistModelInfo;
+
+uint8_t AppDsp_GetDistModel(uint32_t model, AppDspDistModelInfo *out);
+uint32_t AppDsp_DistModelCycles(uint32_t model, uint32_t os);
+
+/* Clip counters (APP_DSP_CLIP): blocks in which 'stage' (AppProfStage)
+ * saturated, out of 'runs' chain runs since boot / AppDsp_ResetClip().
+ * Returns 0 for a bad stage or without the counters.
+ */
+uint8_t AppDsp_GetClip(uint32_t stage, uint32_t *blocks, uint32_t *runs);
+void AppDsp_ResetClip(void);
+
 #ifdef __cplusplus
 }
 #endif
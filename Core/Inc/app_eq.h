@@ -0,0 +1,101 @@
+#ifndef APP_EQ_H
+#define APP_EQ_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Four-band EQ: low shelf, two peaking bands, high shelf (RBJ cookbook
+ * shapes), run as one biquad cascade per channel on whole block buffers.
+ *
+ * The audio path runs CMSIS-DSP arm_biquad_cascade_df1_fast_q31() (one
+ * SMMLAR per tap on the M4, state kept in registers across a chunk) over
+ * deinterleaved chunks of the block. Its 32-bit accumulator rounds at the
+ * s24 LSB and the poles of a low band amplify that noise by w0^-2: a
+ * +15 dB shelf at 40 Hz would sit at -75 dBFS. Bands below
+ * APP_EQ_FAST_MIN_HZ therefore run on arm_biquad_cas_df1_32x64_q31(),
+ * which keeps the feedback state in 64 bits for two more multiplies per
+ * sample.
+ * Coefficients come from
+ * AppEq_Design() in the main loop (single-precision float on the FPU); the
+ * audio path only ever sees finished Q28 sets, swapped in at a block
+ * boundary.
+ *
+ * Bands at 0 dB are left out of the cascade, so a flat EQ costs nothing.
+ * The filtered path carries s24 << APP_EQ_HEADROOM_BITS, leaving 24 dB for
+ * stacked boosts before the 32-bit accumulator wraps.
+ *
+ * Without CMSIS-DSP (host builds) a C copy of the kernel does the same
+ * arithmetic; the two may differ in the last bit of the accumulator
+ * rounding order.
+ */
+#ifndef APP_EQ_USE_CMSIS
+#if defined(__ARM_ARCH)
+#define APP_EQ_USE_CMSIS 1
+#else
+#define APP_EQ_USE_CMSIS 0
+#endif
+#endif
+
+#define APP_EQ_BANDS         4u
+#define APP_EQ_POST_SHIFT    3u   /* coefficients in Q28, |c| < 8 */
+#define APP_EQ_HEADROOM_BITS 4u
+
+/* Fast-kernel noise at this centre and above stays under -110 dBFS. */
+#ifndef APP_EQ_FAST_MIN_HZ
+#define APP_EQ_FAST_MIN_HZ   1000u
+#endif
+
+typedef enum
+{
+  APP_EQ_LOW_SHELF = 0,
+  APP_EQ_MID1,
+  APP_EQ_MID2,
+  APP_EQ_HIGH_SHELF,
+} AppEqBandId;
+
+/* One band as the parameters give it. q100 is ignored by the shelves
+ * (slope S = 1).
+ */
+typedef struct
+{
+  int16_t gain_db10;   /* tenths of a dB, 0 = band off */
+  uint16_t freq_hz;
+  uint16_t q100;       /* Q * 100 */
+} AppEqBand;
+
+/* A designed cascade: {b0, b1, b2, a1, a2} per active stage in the CMSIS
+ * layout (feedback terms negated, y = sum(b x) + sum(a y)). The first
+ * 'stages_hp' stages run on the 64-bit state kernel, the rest on the fast
+ * one.
+ */
+typedef struct
+{
+  int32_t coeff[5u * APP_EQ_BANDS];
+  uint32_t stages;     /* 0 = flat, the stage is skipped */
+  uint32_t stages_hp;
+} AppEqCoeffs;
+
+/* Control side (main loop): designs the cascade for bands[APP_EQ_BANDS]
+ * at fs_hz.
+ */
+void AppEq_Design(const AppEqBand *bands, uint32_t fs_hz, AppEqCoeffs *out);
+
+/* Audio side: clears the filter state. */
+void AppEq_Reset(void);
+
+/* Filters n frames in place with c. 'channels' is 1 (left only, mono
+ * input) or 2. A change of c takes effect at the call; the filter state
+ * is cleared whenever the stage split changes.
+ */
+void AppEq_Process(const AppEqCoeffs *c, AppStereoS24 *x, uint32_t n, uint32_t channels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_EQ_H */
@@ -5,7 +5,10 @@
 extern "C" {
 #endif
 
-/* Blinks PA5 forever; used from Error_Handler(). */
+/* Blinks PA5 forever; used from Error_Handler(). With the watchdog
+ * running (app_restart.h) "forever" ends in a reset after
+ * APP_RESTART_WDG_MS.
+ */
 void AppError_BlinkForever(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,118 @@
+#ifndef APP_EVLOG_H
+#define APP_EVLOG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Persistent event log: audio-path trouble kept in flash over power
+ * cycles, for reading back after the gig (COM EVLOG).
+ *
+ * The counters behind LOAD (ring underruns and overflows, I2S errors, late
+ * DSP blocks, deadline misses, load sheds) start from 0 at every power-up.
+ * AppEvLog_Poll() looks at them every APP_EVLOG_POLL_MS, and a type that
+ * moved gets a 16-byte record: ms since boot, boot number, how many since
+ * its last record, the preset slot last loaded, the FX mask, the audio-path
+ * load and HCLK at the time. A type is written at most once per
+ * APP_EVLOG_HOLD_MS; what comes in between is counted into its next record,
+ * so a burst costs one or two. Each boot starts with a BOOT record (the
+ * reset cause and boot kind in count, app_restart.h).
+ *
+ * The records go into a ring of APP_EVLOG_PAGES flash pages below the cab
+ * IR, each page headed by a sequence number, and the oldest page is erased
+ * for the next, so the erases rotate over the ring. A record is two
+ * double-word writes (~0.2 ms of stalled flash reads, like a preset
+ * last-slot mark); a page erase stalls ~20 ms, which the audio would hear,
+ * so erases happen only in AppEvLog_Init(), before the audio starts, and
+ * on AppEvLog_Clear(). Init moves on to a fresh page once the current one
+ * is half full, so a running pedal always has half a page (63 records) or
+ * more; past that the log stops until the next boot and counts what it
+ * could not write.
+ *
+ * Control side (main loop) only; never from an interrupt. With
+ * APP_EVLOG_ENABLE=0 nothing is recorded and COM answers ERR EVLOG
+ * DISABLED; the pages stay reserved.
+ */
+#ifndef APP_EVLOG_ENABLE
+#define APP_EVLOG_ENABLE 1
+#endif
+
+/* The pages below the cab IR (APP_CABIR_FLASH_ADDR). The application image
+ * ends below them: IROM1 in both MDK targets and ER_IROM1 in
+ * stm32g431_ccm.sct, and the updater's limit (app_update.h).
+ */
+#ifndef APP_EVLOG_FLASH_ADDR
+#define APP_EVLOG_FLASH_ADDR 0x0801A800u
+#endif
+
+#ifndef APP_EVLOG_PAGES
+#define APP_EVLOG_PAGES 2u
+#endif
+
+#ifndef APP_EVLOG_POLL_MS
+#define APP_EVLOG_POLL_MS 100u
+#endif
+
+#ifndef APP_EVLOG_HOLD_MS
+#define APP_EVLOG_HOLD_MS 10000u
+#endif
+
+typedef enum
+{
+  APP_EVLOG_BOOT = 0,      /* count: reset cause | boot kind << 8 */
+  APP_EVLOG_UNDERRUN,      /* TX ring underruns */
+  APP_EVLOG_OVERFLOW,      /* TX ring overflows */
+  APP_EVLOG_I2S_ERROR,     /* I2S error incidents */
+  APP_EVLOG_DSP_LATE,      /* RX halves overtaken by DMA */
+  APP_EVLOG_MISS,          /* DSP blocks into the next half */
+  APP_EVLOG_SHED,          /* load-shedding steps down */
+  APP_EVLOG_TYPE_COUNT
+} AppEvLogType;
+
+/* One record as stored: two flash double-words. */
+typedef struct
+{
+  uint32_t ms;             /* since boot */
+  uint16_t boot;           /* boots since the log was first used */
+  uint8_t type;            /* AppEvLogType */
+  uint8_t preset;          /* slot last loaded */
+  uint8_t fx_mask;
+  uint8_t hclk_mhz;
+  uint16_t load;           /* audio path, 0.1 % of the half-buffer period */
+  uint32_t count;          /* events since the type's last record */
+} AppEvLogRecord;
+
+typedef struct
+{
+  uint32_t records;        /* held, over every page */
+  uint32_t room;           /* left before the log stops this boot */
+  uint32_t lost;           /* events it could not write this boot */
+  uint16_t boot;           /* this boot's number */
+  uint8_t pages;
+} AppEvLogInfo;
+
+/* Boot (main.c), after AppRestart_Restore() and before the audio starts:
+ * scans the pages, erases ahead if needed and writes the BOOT record.
+ */
+void AppEvLog_Init(void);
+
+/* Scheduler task (app_sched.h), every APP_EVLOG_POLL_MS. */
+void AppEvLog_Poll(void);
+
+/* Record i, 0 = oldest held. Returns 0 past the last. */
+uint8_t AppEvLog_Get(uint32_t i, AppEvLogRecord *out);
+void AppEvLog_GetInfo(AppEvLogInfo *out);
+const char *AppEvLog_TypeName(uint32_t type);
+
+/* Erases every page (audible: APP_EVLOG_PAGES x ~20 ms); the log goes on
+ * with this boot's number. Returns 0 on a flash error.
+ */
+uint8_t AppEvLog_Clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_EVLOG_H */
@@ -0,0 +1,86 @@
+#ifndef APP_EXPR_H
+#define APP_EXPR_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+#include "stm32g4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Expression pedal on PA0 (ADC1_IN1, A0 on the Nucleo): the pot's wiper
+ * between 3V3 and ground.
+ *
+ * ADC1 converts continuously with 32x hardware oversampling (16-bit
+ * results, ~2 kHz) into a circular DMA buffer that raises no interrupt.
+ * The 1 kHz TIM2 time base (AppExpr_Sample()) averages the buffer, runs a
+ * one-pole low-pass (APP_EXPR_SMOOTH_SHIFT) and scales the result between
+ * the heel and toe calibration points to 0..32768. The main loop
+ * (AppExpr_Poll()) maps that to the target parameter between lo and hi
+ * once it has moved by APP_EXPR_DEADBAND_Q15, so a resting pedal publishes
+ * nothing. Smoothed parameters glide to each new value (~21 ms), so the
+ * sweep stays smooth between control steps. The target can instead be a
+ * preset morph, heel at preset a and toe at preset b (AppPreset_Morph()).
+ */
+#ifndef APP_EXPR_ENABLE
+#define APP_EXPR_ENABLE 1
+#endif
+
+/* Low-pass time constant in 1 kHz ticks: 2^shift (8 ms at 3). */
+#ifndef APP_EXPR_SMOOTH_SHIFT
+#define APP_EXPR_SMOOTH_SHIFT 3u
+#endif
+
+/* Movement that republishes, 1/512 of the travel by default. */
+#ifndef APP_EXPR_DEADBAND_Q15
+#define APP_EXPR_DEADBAND_Q15 64
+#endif
+
+typedef enum
+{
+  APP_EXPR_TARGET_OFF = 0,
+  APP_EXPR_TARGET_PARAM,
+  APP_EXPR_TARGET_MORPH,
+  APP_EXPR_TARGET_COUNT
+} AppExprTarget;
+
+typedef struct
+{
+  uint32_t raw;            /* filtered ADC reading, 0..65535 */
+  int32_t pos_q15;         /* 0 at heel .. 32768 at toe */
+  uint32_t heel;
+  uint32_t toe;
+  AppExprTarget target;
+  AppDspParamId param;
+  int32_t lo;              /* parameter value at heel */
+  int32_t hi;              /* ... at toe */
+  uint8_t morph_a;         /* preset at heel (target morph) */
+  uint8_t morph_b;         /* ... at toe */
+} AppExprInfo;
+
+/* Starts the conversions (hadc: ADC1 set up by MX_ADC1_Init()). */
+void AppExpr_Init(ADC_HandleTypeDef *hadc);
+
+/* TIM2 update interrupt, once per ms. */
+void AppExpr_Sample(void);
+
+/* Main loop: publishes the mapped value when the pedal moved. */
+void AppExpr_Poll(void);
+
+/* Control side (COM EXP). MapParam returns 0 for an unknown parameter,
+ * MapMorph for an empty preset slot or a build without morphing.
+ */
+uint8_t AppExpr_MapParam(AppDspParamId id, int32_t lo, int32_t hi);
+uint8_t AppExpr_MapMorph(uint32_t a, uint32_t b);
+void AppExpr_Off(void);
+/* Takes the current reading as the heel (toe = 0) or toe (toe = 1) end. */
+void AppExpr_Calibrate(uint8_t toe);
+void AppExpr_Get(AppExprInfo *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_EXPR_H */
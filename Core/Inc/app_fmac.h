@@ -0,0 +1,68 @@
+#ifndef APP_FMAC_H
+#define APP_FMAC_H
+
+#include <stdint.h>
+
+#include "stm32g4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* IIR filtering on the FMAC accelerator.
+ *
+ * The FMAC runs one direct-form-1 IIR at a time on a q1.15 stream. Stereo
+ * runs as one stream of interleaved L/R samples through H(z^2) (every tap
+ * spaced by two), which is exactly two independent filters sharing the
+ * coefficients, so the filter state never has to be swapped per channel.
+ *
+ * Samples go through WDATA/RDATA from the audio code itself: a stage writes
+ * frame i, keeps the CPU on its own work for frame i+1 and collects frame
+ * i's output one frame later, by which time the FMAC (~2 cycles per tap)
+ * has long finished. That keeps the filter off the core without the 16-bit
+ * staging buffers a DMA transfer would need.
+ *
+ * Coefficients are given in Q28 like the software biquads and stored
+ * halved (R = 1) so |a1| up to 2 still fits q1.15. Data is s24 >> 8 in and
+ * << 8 out: the filtered path carries 16 bits.
+ */
+#define APP_FMAC_ORDER_MAX 3u
+
+/* Call once after MX_FMAC_Init(). */
+void AppFmac_Init(FMAC_HandleTypeDef *hfmac);
+
+/* (Re)starts the filter with cleared state. b has order+1 feed-forward
+ * coefficients, a the 'order' feedback ones (a[0] is a1, a0 = 1 implied),
+ * in the y = sum(b x) - sum(a y) convention. 'channels' is 1 or 2
+ * (interleaved). Returns 0 if the FMAC is not available or the
+ * configuration is rejected; nothing may be written then.
+ */
+uint8_t AppFmac_IirStart(const int32_t *b_q28, const int32_t *a_q28, uint32_t order, uint32_t channels);
+void AppFmac_Stop(void);
+
+/* One sample in / out. Put must stay at most APP_FMAC_AHEAD samples ahead
+ * of Get; both only ever wait for the FMAC itself.
+ */
+#define APP_FMAC_AHEAD 4u
+
+static inline void AppFmac_Put(int32_t s24)
+{
+  while ((FMAC->SR & FMAC_SR_X1FULL) != 0u)
+  {
+  }
+  FMAC->WDATA = (uint32_t)(uint16_t)(int16_t)(s24 >> 8);
+}
+
+static inline int32_t AppFmac_Get(void)
+{
+  while ((FMAC->SR & FMAC_SR_YEMPTY) != 0u)
+  {
+  }
+  return (int32_t)(int16_t)FMAC->RDATA * 256;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_FMAC_H */
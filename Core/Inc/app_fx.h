@@ -0,0 +1,66 @@
+#ifndef APP_FX_H
+#define APP_FX_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+#include "app_prof.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Effect module interface.
+ *
+ * Each effect of the FX chain is one AppFxModule: a descriptor in flash and
+ * a state block of state_size bytes. The engine keeps the state blocks of
+ * all registered modules back to back (DSP_FX_REGISTRY in app_dsp.c, which
+ * is also the chain order) and walks the registry once per block, calling
+ * process_block() for each module that is selected by its mask bit or still
+ * fading out or ringing. Adding an effect is a descriptor, a state type and
+ * one registry line; the chain itself does not change.
+ *
+ * A module with a mask bit starts its state with the engine's fade record
+ * (send ramp, tail sleep counter); the chain crossfades the send on mask
+ * changes and, for modules with a tail, puts them to sleep once input and
+ * output stayed under the floor for tail_frames().
+ */
+
+struct DspBlockParams;   /* runtime parameters, sampled once per block (app_dsp.c) */
+
+/* Runs one block in place. peak bounds the input's magnitude (headroom
+ * tracking, APP_DSP_HEADROOM); the return value bounds the output's.
+ */
+typedef int32_t (*AppFxProcessFn)(void *state, AppStereoS24 *x, uint32_t n,
+                                  const struct DspBlockParams *p, int32_t peak);
+
+typedef struct
+{
+  const char *name;
+  AppFxMask bit;                 /* APP_FX_BIT_* that selects it, 0 = always in the chain */
+  uint8_t stereo;                /* uses both channels: mono input copies L to R ahead of it */
+  int8_t meter_tap;              /* AppMeterTap taken after it, -1 = none */
+  uint32_t state_size;           /* bytes of its state block */
+  void (*init)(void *state);     /* once in AppDsp_Init(), before reset(); NULL = none */
+  void (*reset)(void *state, uint32_t zeroed);  /* zeroed: the block is all-zero already; NULL = none */
+  AppFxProcessFn process_block;  /* NULL = left out of the build: never scheduled */
+  AppFxProcessFn bus_block;      /* on a wet bus ('+'): wet to the bus, x left dry; NULL = cannot join one */
+  AppProfStage (*prof_stage)(const struct DspBlockParams *p);
+  uint32_t (*tail_frames)(const struct DspBlockParams *p);  /* ring-out, NULL = none */
+  uint8_t (*idle)(const struct DspBlockParams *p);          /* leaves this block as it is, NULL = never */
+  /* Tail FX: once per block, awake or not. Silences a bounded slice of
+   * stale line storage (AppDline_ClearStep()), never a whole line in the
+   * audio path. NULL = none.
+   */
+  void (*clear_step)(void *state, uint32_t n);
+  void (*shed)(struct DspBlockParams *p, uint32_t tier);    /* cheaper fallbacks, NULL = none */
+  uint8_t shed_tiers;
+  const AppDspParamId *params;   /* runtime parameters it reads */
+  uint32_t param_count;
+} AppFxModule;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_FX_H */
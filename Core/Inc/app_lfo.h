@@ -0,0 +1,74 @@
+#ifndef APP_LFO_H
+#define APP_LFO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Shared sine LFOs for modulation (reverb line modulation, chorus, later
+ * tremolo, vibrato).
+ *
+ * Each LFO is a Q32 phase accumulator. Once per block AppLfo_Block() gets
+ * sine and cosine at the end of the block from the CORDIC in zero-overhead
+ * mode (one write, one stalled read, ~30 cycles), and hands the consumer a
+ * linear segment from the previous end point: one add per sample and
+ * output, no per-sample tables in RAM. At LFO rates the chord error over a
+ * 128-frame block stays below -60 dB at 5 Hz.
+ *
+ * Without the CORDIC (host builds) the shared quarter-wave table
+ * (AppTab_Sin(), app_tables.h) gives the same segments to within a few LSB.
+ */
+#ifndef APP_LFO_USE_CORDIC
+#if defined(__ARM_ARCH)
+#define APP_LFO_USE_CORDIC 1
+#else
+#define APP_LFO_USE_CORDIC 0
+#endif
+#endif
+
+typedef struct
+{
+  uint32_t phase;     /* turns, Q32 */
+  uint32_t inc;       /* turns per sample, Q32 */
+  int32_t sin_q15;    /* value at 'phase' */
+  int32_t cos_q15;
+} AppLfo;
+
+/* Per-sample sine and cosine across one block, Q15 in the upper bits of a
+ * Q31 value so the per-sample step keeps its fraction: sample j of the
+ * block is (sin_q31 + j * dsin_q31) >> 16.
+ */
+typedef struct
+{
+  int32_t sin_q31;
+  int32_t cos_q31;
+  int32_t dsin_q31;
+  int32_t dcos_q31;
+} AppLfoSeg;
+
+#if APP_LFO_USE_CORDIC
+#include "stm32g4xx_hal.h"
+
+/* Call once after MX_CORDIC_Init(), before the first AppLfo_Block(). */
+void AppLfo_Init(CORDIC_HandleTypeDef *hcordic);
+#endif
+
+/* Rate in mHz at sample rate fs; phase in turns (Q32). */
+void AppLfo_Reset(AppLfo *lfo, uint32_t rate_mhz, uint32_t fs_hz, uint32_t phase);
+
+/* New rate from the current phase on (no jump in the output). */
+void AppLfo_SetRate(AppLfo *lfo, uint32_t rate_mhz, uint32_t fs_hz);
+
+/* Advances by n samples and returns the segment for them. */
+void AppLfo_Block(AppLfo *lfo, uint32_t n, AppLfoSeg *seg);
+
+/* sin/cos of a Q32 phase, Q15. */
+void AppLfo_SinCos(uint32_t phase, int32_t *sin_q15, int32_t *cos_q15);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_LFO_H */
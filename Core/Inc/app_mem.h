@@ -0,0 +1,99 @@
+#ifndef APP_MEM_H
+#define APP_MEM_H
+
+#include <stdint.h>
+
+#include "app_profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Memory placement for the hot audio path.
+ *
+ * With APP_USE_CCM=1 (the "DSP legacy CCM" MDK target, linked with
+ * MDK-ARM/stm32g431_ccm.sct) DSP buffers and the block-processing code are
+ * placed in the 10 KB CCM SRAM at 0x10000000: zero wait states for code and
+ * no contention with DMA traffic. Every DMA buffer (I2S, UART, ADC) is
+ * pinned to SRAM2, which the rest of the data only fills once SRAM1 and
+ * CCM are full: DMA bursts then never compete with the CPU for the SRAM1
+ * or CCM port. The scatter file fails the link if they outgrow SRAM2's
+ * 6 KB (~3.8 KB by default, ~5.8 KB at APP_AUDIO_MAX_FRAMES_PER_HALF 128).
+ *
+ * With the default 0 every macro is empty and the default memory layout
+ * from the target dialog is used.
+ */
+#ifndef APP_USE_CCM
+#define APP_USE_CCM 0
+#endif
+
+#if APP_USE_CCM
+/* Zero-initialised data (".bss" prefix keeps it out of the load image). */
+#define APP_CCM_BSS   __attribute__((section(".bss.ccmram")))
+/* Code copied from flash to CCM by the scatter loader at startup. */
+#define APP_CCM_CODE  __attribute__((section(".ccmram_text"), noinline))
+/* Buffers accessed by DMA: SRAM2. */
+#define APP_DMA_BSS   __attribute__((section(".bss.dmaram")))
+#else
+#define APP_CCM_BSS
+#define APP_CCM_CODE
+#define APP_DMA_BSS
+#endif
+
+/* Retained RAM (app_restart.h): the top APP_MEM_RETAIN_BYTES of CCM SRAM,
+ * left out of every linker region so neither the scatter loader nor the C
+ * library zeroes it. The default target's IRAM ends below it in the target
+ * dialog (0x20000000-0x20007DFF, CCM through its 0x20005800 alias),
+ * RW_CCMRAM in stm32g431_ccm.sct at 0x10002600. CCM SRAM keeps its content
+ * over a system reset (watchdog, software, pin) while the CCMSRAM_RST
+ * option bit has its default; a power-up or brown-out leaves noise.
+ */
+#define APP_MEM_RETAIN_BYTES  512u
+#define APP_MEM_RETAIN_ADDR   0x20007E00u
+
+/* RAM usage telemetry (COM MEM).
+ *
+ * AppMem_PaintStack() fills the unused part of the main stack (shared by
+ * the main loop and every ISR) with a pattern; the peak is the deepest word
+ * found overwritten since. Used RAM comes from the linker's region limits
+ * and each module lists its large static buffers as AppMemItem entries for
+ * MEM MAP (sizes are compile-time, the list costs flash only).
+ */
+typedef struct
+{
+  const char *name;
+  uint32_t bytes;
+} AppMemItem;
+
+#define APP_MEM_ITEM(name, var) {(name), (uint32_t)sizeof(var)}
+
+typedef struct
+{
+  uint32_t ram_size;     /* SRAM1+SRAM2 (+ CCM alias less the retained block unless APP_USE_CCM) */
+  uint32_t ram_used;     /* RW + ZI of that region, stack and heap included */
+  uint32_t ccm_size;     /* separate CCM region less the retained block (APP_USE_CCM builds), else 0 */
+  uint32_t ccm_used;
+  uint32_t stack_size;
+  uint32_t stack_peak;   /* deepest use since the last paint */
+  uint32_t heap_size;
+} AppMemStats;
+
+/* Paints the stack below the caller. Call first thing in main() and again
+ * (main loop only) to restart the peak.
+ */
+void AppMem_PaintStack(void);
+void AppMem_GetStats(AppMemStats *out);
+
+/* The SRAM the image leaves free above its ZI limit, for one large buffer
+ * sized at boot rather than at build time (the looper); with the CCM
+ * scatter file the larger of the SRAM1 and SRAM2 tails. The first call takes
+ * it all, word aligned, and it counts as used from then on; later calls and
+ * builds without the linker symbols get NULL and 0 bytes.
+ */
+void *AppMem_ClaimFree(uint32_t *bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_MEM_H */
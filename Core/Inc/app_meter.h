@@ -0,0 +1,86 @@
+#ifndef APP_METER_H
+#define APP_METER_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Block-level level metering of the DSP chain.
+ * app_dsp.c feeds every processed block at a few points of the chain (peak
+ * and sum of squares, L and R pooled) plus the compressor and limiter gains
+ * at the block end. The main loop takes the accumulated window with
+ * AppMeter_Take(), which also restarts it, so the meter values cover
+ * whatever period the reader polls at (COM METER streaming).
+ *
+ * Costs one extra read pass over the block per tap while enabled. Build with
+ * APP_METER_ENABLE=0 to drop the hooks; the header stays HAL-independent
+ * so app_dsp.c can include it.
+ */
+#ifndef APP_METER_ENABLE
+#define APP_METER_ENABLE 1
+#endif
+
+typedef enum
+{
+  APP_METER_TAP_INPUT = 0,  /* ADC input, after the DC blocker (app_dsp.c's level detector) */
+  APP_METER_TAP_DIST,       /* after distortion + cab (or its bypass) */
+  APP_METER_TAP_DELAY,      /* after the delay mix */
+  APP_METER_TAP_REVERB,     /* after the reverb mix */
+  APP_METER_TAP_OUTPUT,     /* after the limiter, as sent to the DAC */
+  APP_METER_TAP_COUNT,
+} AppMeterTap;
+
+typedef struct
+{
+  uint32_t peak[APP_METER_TAP_COUNT];     /* max |s24| in the window */
+  uint32_t rms[APP_METER_TAP_COUNT];      /* s24 RMS over the window */
+  int32_t comp_gain_q15;                  /* lowest compressor gain (L/R) */
+  int32_t limiter_gain_q15;               /* lowest limiter gain */
+  uint32_t frames;                        /* frames in the window */
+} AppMeterLevels;
+
+void AppMeter_Reset(void);
+
+/* The taps cost nothing while metering is off (the default); COM METER
+ * turns it on for as long as a stream runs.
+ */
+void AppMeter_Enable(uint8_t on);
+
+/* Audio side (AppDsp_ProcessBlock()). 'mono' meters the left channel only,
+ * for the taps ahead of mono_to_stereo_block() in APP_DSP_MONO_INPUT builds.
+ */
+void AppMeter_Block(AppMeterTap tap, const AppStereoS24 *x, uint32_t n, uint8_t mono);
+
+/* A tap whose levels the DSP already has: the block's peak and sum of
+ * squares over 'samples' values. IsOn lets it skip detecting them.
+ */
+void AppMeter_Level(AppMeterTap tap, uint32_t peak, uint64_t sum_sq, uint32_t samples);
+uint8_t AppMeter_IsOn(void);
+void AppMeter_Gains(int32_t comp_gain_q15, int32_t limiter_gain_q15, uint32_t n);
+
+/* Main loop: copies the current window into 'out' and starts a new one.
+ * Returns 0 if no block arrived since the previous call.
+ */
+uint8_t AppMeter_Take(AppMeterLevels *out);
+
+#if APP_METER_ENABLE
+#define APP_METER_BLOCK(tap, x, n, mono)  AppMeter_Block((tap), (x), (n), (mono))
+#define APP_METER_GAINS(comp, lim, n)     AppMeter_Gains((comp), (lim), (n))
+#define APP_METER_LEVEL(tap, pk, sq, k)   AppMeter_Level((tap), (pk), (sq), (k))
+#define APP_METER_ON()                    AppMeter_IsOn()
+#else
+#define APP_METER_BLOCK(tap, x, n, mono)  do { } while (0)
+#define APP_METER_GAINS(comp, lim, n)     do { } while (0)
+#define APP_METER_LEVEL(tap, pk, sq, k)   do { } while (0)
+#define APP_METER_ON()                    0u
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_METER_H */
@@ -0,0 +1,109 @@
+#ifndef APP_MIDI_H
+#define APP_MIDI_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+#include "stm32g4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* MIDI in on USART1 RX, PA10 (D2 on the Nucleo), 31250 baud, behind the
+ * usual optocoupler (DIN or TRS jack; the pin has its pull-up on).
+ *
+ * The UART writes into a circular DMA buffer that raises no interrupt.
+ * The 1 kHz TIM2 time base (AppMidi_Sample()) counts the bytes that
+ * arrived and picks out the real-time bytes, which may sit anywhere in the
+ * stream: every 24th clock (a quarter note) is stamped with the tick, so
+ * the tempo does not depend on how late the main loop gets to it. The main
+ * loop (AppMidi_Poll()) parses the rest, with running status, and acts on
+ * the messages of the receive channel:
+ *
+ * - Program Change n loads preset slot n if it is stored (the whole preset
+ *   lands in one DSP block, the one after the message was parsed).
+ * - Control Change runs through the CC map: value 0..127 sets the mapped
+ *   parameter from lo to hi. Smoothed parameters glide, so a CC sweep does
+ *   not zipper.
+ * - Clock sets tempo_bpm through AppDsp_TapTempo(), one tap per beat.
+ * - System exclusive with ID APP_MIDI_SYSEX_ID carries COM text: the data
+ *   bytes are command lines, as on the UART (app_com.c; the end of the
+ *   SysEx also ends a line), and the replies go out on USART1 TX, PA9
+ *   (D8), one SysEx per line. Binary frames do not fit 7-bit SysEx data and
+ *   are not sent here. The tick feeds MIDI out from the UART's TX FIFO, so
+ *   there is no TX interrupt either.
+ *
+ * Other SysEx and the other system messages are skipped.
+ */
+#ifndef APP_MIDI_ENABLE
+#define APP_MIDI_ENABLE 1
+#endif
+
+/* Receive channel at boot: 1..16, 0 = omni. */
+#ifndef APP_MIDI_CHANNEL
+#define APP_MIDI_CHANNEL 0u
+#endif
+
+/* Manufacturer ID of the COM SysEx: the non-commercial one. */
+#ifndef APP_MIDI_SYSEX_ID
+#define APP_MIDI_SYSEX_ID 0x7Du
+#endif
+
+/* Entries in the CC map; a build without MIDI keeps the boot ones. */
+#ifndef APP_MIDI_CC_MAPS
+#define APP_MIDI_CC_MAPS (APP_MIDI_ENABLE ? 8u : 2u)
+#endif
+
+typedef struct
+{
+  uint8_t cc;              /* controller number, 0..127 */
+  AppDspParamId param;
+  int32_t lo;              /* parameter value at CC 0 */
+  int32_t hi;              /* ... at CC 127 */
+} AppMidiCcMap;
+
+typedef struct
+{
+  uint8_t channel;         /* 1..16, 0 = omni */
+  uint32_t bytes;          /* received since start */
+  uint32_t lost;           /* overwritten before the main loop parsed them */
+  uint32_t errors;         /* framing / noise errors on the line */
+  uint32_t programs;       /* Program Changes acted on */
+  uint32_t controls;       /* mapped Control Changes acted on */
+  uint32_t beats;          /* quarter notes of clock */
+  uint8_t running;         /* between Start / Continue and Stop */
+} AppMidiInfo;
+
+/* Starts reception (huart: USART1 set up by MX_USART1_UART_Init()). */
+void AppMidi_Init(UART_HandleTypeDef *huart);
+
+/* TIM2 update interrupt, once per ms. */
+void AppMidi_Sample(void);
+
+/* Main loop: parses what arrived and applies it. */
+void AppMidi_Poll(void);
+
+/* Control side (COM MIDI). MapCc replaces the entry for cc or takes a free
+ * one; it returns 0 for a bad cc or parameter or when the map is full.
+ */
+uint8_t AppMidi_SetChannel(uint8_t channel);
+uint8_t AppMidi_MapCc(uint8_t cc, AppDspParamId id, int32_t lo, int32_t hi);
+void AppMidi_UnmapCc(uint8_t cc);
+/* Entry i of the map, 0 when it is free. */
+uint8_t AppMidi_GetCcMap(uint32_t i, AppMidiCcMap *out);
+void AppMidi_Get(AppMidiInfo *out);
+
+/* COM link (app_com.c), main loop. ComRead takes received COM text;
+ * ComWrite queues all n bytes, framed into SysEx, or none (0: no room).
+ */
+uint32_t AppMidi_ComRead(uint8_t *dst, uint32_t max);
+uint8_t AppMidi_ComPending(void);
+uint8_t AppMidi_ComWrite(const uint8_t *p, uint32_t n);
+uint32_t AppMidi_ComTxFree(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_MIDI_H */
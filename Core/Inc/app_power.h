@@ -0,0 +1,103 @@
+#ifndef APP_POWER_H
+#define APP_POWER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Main-loop idle: sleep (WFI, Sleep mode) until the next interrupt when the
+ * COM side has nothing pending. Every source of main-loop work already
+ * interrupts: the UART and USB interrupts flag AppCom_Pending(), and the 1 kHz TIM2
+ * time base wakes the loop for the LED, COM timeouts and the METER stream.
+ * The audio DMA, PendSV and the UART DMA keep running in Sleep mode, as
+ * does the debugger.
+ *
+ * The time spent asleep is measured on the TIM2 counter (1 us) and read
+ * back as a share of the elapsed time, so LOAD can report how much of the
+ * core is really left. With APP_POWER_SLEEP=0 the loop spins as before and
+ * the idle share reads 0.
+ */
+#ifndef APP_POWER_SLEEP
+#define APP_POWER_SLEEP 1
+#endif
+
+/* Called once per main-loop pass, after the polling work. */
+void AppPower_Idle(void);
+
+/* Share of the time asleep since the last call, in 0.1 % (0..1000), and
+ * the window length in ms.
+ */
+uint32_t AppPower_TakeIdle(uint32_t *window_ms);
+
+/* Clock governor: HCLK (core, buses, DWT, TIM2) at SYSCLK / 1 or / 2, by
+ * DSP load. SYSCLK stays at 170 MHz, and I2S (RCC_I2SCLKSOURCE_SYSCLK) and
+ * the USARTs (SYSCLK kernel clock, see stm32g4xx_hal_msp.c) take it ahead
+ * of the AHB prescaler, so the sample rate and the baud rates are exactly
+ * those of the full clock at either step. The prescaler is the only divider
+ * that leaves them alone: a slower PLL retunes the I2S dividers (and stops
+ * the streams while SYSCLK moves), and HCLK / 4 = 42.5 MHz has no whole
+ * prescaler for the 1 us TIM2 time base. The ADC, on PCLK / 4, converts at
+ * half rate at the low step, still well ahead of the expression pedal.
+ *
+ * AppPower_Poll() steps down once the audio path (RX and TX callbacks,
+ * smoothed) has used less than APP_POWER_DOWN_PERMILLE of the half-buffer
+ * period for APP_POWER_HOLD_MS at full clock, so about twice that at half.
+ * It steps back up when the load at half clock passes
+ * APP_POWER_UP_PERMILLE, on a deadline miss, late block or shed, and when
+ * the effect mask or bypass tier changes. Code that turns stages on (preset
+ * load, FX, CHAIN, BYPASS, the bypass footswitch) calls AppPower_Boost()
+ * first, so the bigger chain starts at full clock; the load shedder
+ * (app_dsp.h) covers other paths until the next poll. With
+ * APP_POWER_GOVERNOR=0 the clock stays at full.
+ */
+#ifndef APP_POWER_GOVERNOR
+#define APP_POWER_GOVERNOR 1
+#endif
+
+#ifndef APP_POWER_DOWN_PERMILLE
+#define APP_POWER_DOWN_PERMILLE 300u
+#endif
+
+#ifndef APP_POWER_UP_PERMILLE
+#define APP_POWER_UP_PERMILLE 700u
+#endif
+
+#ifndef APP_POWER_HOLD_MS
+#define APP_POWER_HOLD_MS 2000u
+#endif
+
+typedef enum
+{
+  APP_POWER_CLOCK_AUTO = 0,   /* governor */
+  APP_POWER_CLOCK_FULL,       /* pinned */
+  APP_POWER_CLOCK_HALF
+} AppPowerClockMode;
+
+typedef struct
+{
+  AppPowerClockMode mode;
+  uint32_t hclk_hz;
+  uint32_t load_permille;     /* audio path at the current step, smoothed */
+  uint32_t steps_up;
+  uint32_t steps_down;
+  uint32_t full_ms;           /* time at each step since boot */
+  uint32_t half_ms;
+} AppPowerClockInfo;
+
+/* Main loop (app_sched.h). */
+void AppPower_Poll(void);
+
+/* Full clock now, and the hold restarted (main loop). */
+void AppPower_Boost(void);
+
+/* Returns 0 when the build has no governor. */
+uint8_t AppPower_SetClockMode(AppPowerClockMode mode);
+void AppPower_GetClock(AppPowerClockInfo *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_POWER_H */
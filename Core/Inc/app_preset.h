@@ -0,0 +1,180 @@
+#ifndef APP_PRESET_H
+#define APP_PRESET_H
+
+#include <stdint.h>
+
+#include "app_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Preset bank in the last pages of the on-chip flash.
+ *
+ * A preset holds the FX mask, every AppDspParamId value and the delay tap
+ * table. Records are appended to a ring of APP_PRESET_PAGES flash pages with
+ * a sequence number and a CRC-32; the newest valid record of a slot wins.
+ * When the current page is full the next one is erased and the live records
+ * are copied forward, so the erases rotate over the whole ring and a power
+ * loss at any point leaves the previous copy readable.
+ *
+ * Recall only reads flash and lands in the DSP as one parameter batch, i.e.
+ * in a single block. Saving stalls flash reads while a page is programmed or
+ * erased (up to ~20 ms), which the audio path will hear: save between songs.
+ * Control side (main loop) only.
+ *
+ * The bank also remembers the slot last in use, so a power-up comes back
+ * on it (AppPreset_LastSlot()): once a recall or a morph end has stayed
+ * put for APP_PRESET_LAST_SETTLE_MS, a one double-word mark is written in
+ * the spare tail of a page (~0.1 ms of stalled flash reads). Scrolling
+ * through slots writes nothing. A mark never erases a page: once every
+ * page tail is used (about every 50 settled changes) it waits for the next
+ * save, whose page erase frees a tail, and a power-up meanwhile comes back
+ * on the slot marked before.
+ */
+#ifndef APP_PRESET_COUNT
+#define APP_PRESET_COUNT 8u
+#endif
+
+#ifndef APP_PRESET_LAST_SETTLE_MS
+#define APP_PRESET_LAST_SETTLE_MS 3000u
+#endif
+
+#ifndef APP_PRESET_PAGES
+#define APP_PRESET_PAGES 4u
+#endif
+
+/* Start of the preset pages (last 8 KB of the 128 KB G431RB flash). The
+ * application image must end below it, the cab IR pages
+ * (APP_CABIR_FLASH_ADDR) and the event log (APP_EVLOG_FLASH_ADDR): IROM1 in
+ * both MDK targets and ER_IROM1 in stm32g431_ccm.sct are sized to match.
+ */
+#ifndef APP_PRESET_FLASH_ADDR
+#define APP_PRESET_FLASH_ADDR 0x0801E000u
+#endif
+
+/* Scans the bank; call once before the first Load/Save. */
+void AppPreset_Init(void);
+
+/* Stores the current DSP settings in 'slot'. Returns 0 on a flash error or
+ * an out-of-range slot.
+ */
+uint8_t AppPreset_Save(uint32_t slot);
+
+/* Applies 'slot' at the next block boundary, the outgoing delay and reverb
+ * tails spilling over (AppDsp_CommitParamsSpill()). Returns 0 if it is
+ * empty.
+ */
+uint8_t AppPreset_Load(uint32_t slot);
+
+uint8_t AppPreset_IsStored(uint32_t slot);
+
+/* Slot last loaded (or the nearer end of a morph), 0 before any
+ * (footswitch next / previous).
+ */
+uint32_t AppPreset_Current(void);
+
+/* Slot the newest last-slot mark names (the boot recall), 0 without one. */
+uint32_t AppPreset_LastSlot(void);
+
+/* Preset morph: every continuous parameter of the two stored presets a
+ * and b interpolated, a + (b - a) * pos / 32768, and published as one
+ * parameter batch. Parameters that are choices or counts (units enum and
+ * x), the FX mask and the delay taps come from the nearer end, so they
+ * switch at the midpoint. Smoothed parameters glide between steps; the
+ * others step at the block boundary. Morph publishes now and stops a
+ * glide; MorphGlide moves from the current position (0 for a new pair)
+ * to pos over ms, advanced by AppPreset_Poll() at control rate. A position that
+ * did not change publishes nothing. Load stops a glide. Return 0 if a
+ * slot is empty or its record fails the CRC, or without
+ * APP_PRESET_MORPH_ENABLE (~0.1 KB of RAM), which leaves morphing out.
+ */
+#ifndef APP_PRESET_MORPH_ENABLE
+#define APP_PRESET_MORPH_ENABLE 1
+#endif
+
+typedef struct
+{
+  uint8_t a;
+  uint8_t b;
+  uint8_t active;          /* a morph position has been published */
+  uint8_t gliding;
+  int32_t pos_q15;         /* last published */
+  int32_t to_q15;          /* glide target (pos_q15 when not gliding) */
+} AppPresetMorphInfo;
+
+uint8_t AppPreset_Morph(uint32_t a, uint32_t b, int32_t pos_q15);
+uint8_t AppPreset_MorphGlide(uint32_t a, uint32_t b, int32_t pos_q15, uint32_t ms);
+/* Scheduler task (app_sched.h), every 10 ms: the morph glide and the
+ * last-slot mark.
+ */
+void AppPreset_Poll(void);
+void AppPreset_GetMorph(AppPresetMorphInfo *out);
+
+/* Preset file: one binary layout for the flash records, the bulk
+ * transfer (COM PBANK and the PREAD/PSTAGE/PCOMMIT frames), the retained
+ * warm-restart copy and the app's library files (.pst, the app may append
+ * the names it was written with; JSON is only an export). All little-endian:
+ *
+ *   u16 magic APP_PRESET_FILE_MAGIC ("PF"), u8 version, u8 section count,
+ *   u32 param hash (AppPreset_ParamHash()), then per section
+ *   u8 type, u8 info, u16 payload bytes (a multiple of 4), the payload:
+ *     1 FX      the FX mask (u32)
+ *     2 PARAMS  info = the wide count: the params whose range spans more
+ *               than 65536 values (s32), the others as value - min (u16),
+ *               each group in AppDspParamId order, zero-padded
+ *     3 TAPS    info = the tap count: per delay tap time_q12 (u16),
+ *               pan_q15 (u16), gain_q15 (s32)
+ *   and the CRC-32 (reflected 0xEDB88320) of everything before it.
+ *
+ * The param hash is FNV-1a over each param in id order: its name and a NUL,
+ * its min (s32) and its width (one byte, 2 or 4), from PLIST names, min and
+ * max. Equal hashes mean the PARAMS payload reads the same; the pedal only
+ * takes files of its own hash, version and section sizes, which it checks
+ * in one compare and then reads at fixed offsets. A reader that knows the
+ * names can remap another build's file and skips section types it does not
+ * know.
+ *
+ * An upload is staged in RAM chunk by chunk and only reaches flash at
+ * Commit, which checks the file's CRC-32 so a lost chunk cannot be stored.
+ */
+#define APP_PRESET_FILE_MAGIC   0x4650u  /* "PF" */
+#define APP_PRESET_FILE_VERSION 1u
+
+/* File size (AppPreset_ImageSize() bytes) and param hash of this build. */
+uint32_t AppPreset_ImageSize(void);
+uint32_t AppPreset_ParamHash(void);
+
+/* Copies n bytes at 'offset' of the stored image of 'slot'. Returns 0 if
+ * the slot is empty or the range does not fit.
+ */
+uint8_t AppPreset_ReadImage(uint32_t slot, uint32_t offset, uint8_t *dst, uint32_t n);
+
+/* Writes n bytes at 'offset' of the staged image. Returns 0 unless the
+ * range fits.
+ */
+uint8_t AppPreset_StageImage(uint32_t offset, const uint8_t *src, uint32_t n);
+
+/* Stores the staged file in 'slot' if it ends in the CRC-32 'crc' of its
+ * bytes and has this build's headers. Stalls flash reads like Save.
+ * Returns 0 on a CRC or header mismatch, a flash error or an out-of-range
+ * slot.
+ */
+uint8_t AppPreset_CommitImage(uint32_t slot, uint32_t crc);
+
+/* Warm restart (app_restart.h): the current DSP settings as a file
+ * (AppPreset_ImageSize() bytes, the layout above) and back. Apply publishes
+ * it as one batch without a spill and makes 'slot' the current one; it
+ * returns 0 and changes nothing for a file of another build.
+ */
+void AppPreset_CaptureImage(uint8_t *dst);
+uint8_t AppPreset_ApplyImage(const uint8_t *src, uint32_t slot);
+
+/* Staging buffer for COM MEM MAP. */
+uint32_t AppPreset_MemMap(const AppMemItem **items);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_PRESET_H */
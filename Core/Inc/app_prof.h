@@ -0,0 +1,107 @@
+#ifndef APP_PROF_H
+#define APP_PROF_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Optional per-stage DSP profiling based on the Cortex-M4 DWT cycle counter.
+ * Build with APP_PROF_ENABLE=1 (e.g. in the MDK "Define" list) to record
+ * min/avg/max cycles per block for every stage of AppDsp_ProcessBlock().
+ * With the default 0 the stage hooks compile to nothing.
+ *
+ * The header stays HAL-independent so app_dsp.c can include it.
+ */
+#ifndef APP_PROF_ENABLE
+#define APP_PROF_ENABLE 0
+#endif
+
+typedef enum
+{
+  APP_PROF_STAGE_DC_BLOCK = 0,  /* dc_block_s24 + clean HPF */
+  APP_PROF_STAGE_GATE,          /* noise gate detector + gain */
+  APP_PROF_STAGE_COMP,          /* input gain + clean_comp_process */
+  APP_PROF_STAGE_COLOR,         /* input_color_process_s24 */
+  APP_PROF_STAGE_WAH,           /* envelope-swept SVF bandpass + mix */
+  APP_PROF_STAGE_PITCH,         /* half-rate dual-head pitch shifter + mix */
+  APP_PROF_STAGE_DISTORTION,    /* distortion_process_s24 + cab-sim, dist_os 1 */
+  APP_PROF_STAGE_DIST_OS2,      /* same, 2x oversampled */
+  APP_PROF_STAGE_DIST_OS4,      /* same, 4x oversampled */
+  APP_PROF_STAGE_EQ,            /* post-cab EQ cascade (AppEq_Process) */
+  APP_PROF_STAGE_PHASER,        /* allpass cascade, 4-8 stages, + mix */
+  APP_PROF_STAGE_CHORUS,        /* half-rate chorus line + halfband pair + mix */
+  APP_PROF_STAGE_DELAY,         /* delay_process_s24 + wet filters + mix */
+  APP_PROF_STAGE_REVERB,        /* reverb_process_s24 + wet filters + mix */
+  APP_PROF_STAGE_LOOP,          /* looper resampler + line pass + mix */
+  APP_PROF_STAGE_OUTPUT,        /* makeup + master gain + tremolo */
+  APP_PROF_STAGE_LIMITER,       /* limiter_process_s24 */
+  APP_PROF_STAGE_COUNT,
+} AppProfStage;
+
+/* One FX mask per combination of the 5 AppFxBit flags. */
+#define APP_PROF_MASK_COUNT 32u
+
+typedef struct
+{
+  uint32_t count;   /* blocks recorded */
+  uint32_t min;     /* cycles per block */
+  uint32_t max;
+  uint32_t last;
+  uint64_t sum;
+  uint64_t frames;  /* frames covered by the recorded blocks */
+} AppProfStat;
+
+#if defined(__arm__)
+/* DWT->CYCCNT, read by address to avoid pulling CMSIS into app_dsp.c. */
+#define APP_PROF_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004UL)
+
+static inline uint32_t AppProf_Cycles(void)
+{
+  return APP_PROF_DWT_CYCCNT;
+}
+#else
+#include <time.h>
+
+/* Host builds (tools/dsp_host): nanoseconds stand in for the cycles, so the
+ * benchmarks run there too.
+ */
+static inline uint32_t AppProf_Cycles(void)
+{
+  struct timespec ts;
+  (void)timespec_get(&ts, TIME_UTC);
+  return ((uint32_t)ts.tv_sec * 1000000000u) + (uint32_t)ts.tv_nsec;
+}
+#endif
+
+/* Enables the DWT cycle counter. Always available (LOAD telemetry uses it). */
+void AppProf_Init(void);
+
+void AppProf_Reset(void);
+void AppProf_RecordStage(AppProfStage stage, uint32_t cycles, uint32_t frames);
+void AppProf_RecordChain(uint32_t fx_mask, uint32_t cycles, uint32_t frames);
+
+/* Snapshot readers for COM; return 0 if the index is out of range. */
+uint8_t AppProf_GetStage(AppProfStage stage, AppProfStat *out);
+uint8_t AppProf_GetChain(uint32_t fx_mask, AppProfStat *out);
+const char *AppProf_StageName(AppProfStage stage);
+
+/* Cycles available per audio frame at the current core clock. */
+uint32_t AppProf_CyclesPerFrame(void);
+
+#if APP_PROF_ENABLE
+#define APP_PROF_DECLARE(t)              uint32_t t = AppProf_Cycles()
+#define APP_PROF_STAGE(t, stage, frames) do { uint32_t now_ = AppProf_Cycles(); AppProf_RecordStage((stage), now_ - (t), (frames)); (t) = now_; } while (0)
+#define APP_PROF_CHAIN(t0, mask, frames) AppProf_RecordChain((mask), AppProf_Cycles() - (t0), (frames))
+#else
+#define APP_PROF_DECLARE(t)              do { } while (0)
+#define APP_PROF_STAGE(t, stage, frames) do { } while (0)
+#define APP_PROF_CHAIN(t0, mask, frames) do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_PROF_H */
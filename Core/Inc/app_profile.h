@@ -0,0 +1,275 @@
+#ifndef APP_PROFILE_H
+#define APP_PROFILE_H
+
+/* Build profiles: APP_PROFILE picks the module set, the block size and the
+ * buffer sizes of a build in one place. Each setting below is only a
+ * default: a target or a -D that defines the switch itself still wins, and
+ * the module headers keep their own defaults for anything a profile leaves
+ * alone. app_mem.h includes this, so it comes ahead of every module header
+ * that has one of these switches (app_usb.h includes it itself).
+ *
+ *   MINIMAL  the pedal on its own: FX chain, footswitches, expression,
+ *            presets and COM on the UART. No USB, BLE or MIDI, and in
+ *            their RAM the chorus, spill-over, the parallel buses (16
+ *            frames) and the six-section user cab;
+ *            32-frame halves (0.67 ms at 48 kHz) and no timed parameter
+ *            queue make the room.
+ *   LIVE     MINIMAL's I/O plus MIDI and the BLE app link (the default),
+ *            on 32-frame halves: 64 would cost 2.3 KB. Of the FX
+ *            extras only the buses fit next to the links. With
+ *            -DAPP_USB_ENABLE=1 the USB COM port replaces BLE.
+ *   STUDIO   USB audio and the CDC COM port on a desk, without BLE, MIDI
+ *            or preset morphing; 32-frame halves, and the USB FIFOs and
+ *            the UART rings are cut down to make room for the USB handle
+ *            and endpoints.
+ *   BENCH    MINIMAL without its FX extras, for bring-up and measurement:
+ *            their ~3.8 KB take one opt-in diagnostic per build (tuner,
+ *            IR cab, spectrum, self-test, trace, RTT telemetry or a
+ *            1536-sample capture), e.g. -DAPP_PROFILE=4
+ *            -DAPP_TUNER_ENABLE=1. tools/dsp_host's ctest compiles each.
+ *
+ * All of them keep the delay and reverb of the original single-FX build:
+ * the 4 KB S16 delay line (~170 ms) and an 8 KB S16 tank at full rate
+ * (17..26 ms lines, as many samples as the original two 2048-step lines)
+ * with two diffuser stages, also with APP_DSP_MONO_INPUT (its tank is
+ * this size already, so there are no 8 KB for its longer delay). All
+ * build the spring tank, which lives in the FDN buffer. LIVE and
+ * STUDIO keep the module default's one-entry timed parameter queue and
+ * leave chorus, spill-over and the user cab out (STUDIO the buses too);
+ * the 16 KB tank, six diffuser stages and the pitch shifter fit none of
+ * them. A build that wants one back turns it on and pays for it
+ * elsewhere; the pitch shifter fits MINIMAL in the chorus's place
+ * (-DAPP_DSP_PITCH_ENABLE=1 -DAPP_DSP_CHORUS_ENABLE=0).
+ *
+ * Budgets, checked at compile time:
+ * - Static RAM: each module with large buffers declares its share from its
+ *   own switches (APP_<MODULE>_RAM_BYTES in its header) and asserts that
+ *   what it allocates stays inside it; app_mem.c asserts that the shares,
+ *   APP_PROFILE_RAM_OTHER_BYTES for everything else (HAL handles, COM
+ *   parsers, MIDI, presets, the scheduler: ~6.2..8.2 KB, measured per
+ *   profile), the stack and the heap fit APP_PROFILE_RAM_BYTES. The linker
+ *   remains the last word: it also fails a build whose CCM or SRAM2 part
+ *   overflows (app_mem.h).
+ * - Cycles: each FX module declares its worst case in cycles per frame
+ *   (DSP_FX_REGISTRY in app_dsp.c); with the chain's fixed stages the sum
+ *   has to fit one frame at full HCLK less the load shedder's headroom
+ *   (APP_DSP_SHED_HIGH_PERMILLE), so every mask runs at full quality
+ *   without shedding.
+ */
+#define APP_PROFILE_MINIMAL 1
+#define APP_PROFILE_LIVE    2
+#define APP_PROFILE_STUDIO  3
+#define APP_PROFILE_BENCH   4
+
+#ifndef APP_PROFILE
+#define APP_PROFILE APP_PROFILE_LIVE
+#endif
+
+#if APP_PROFILE == APP_PROFILE_MINIMAL
+
+#ifndef APP_USB_ENABLE
+#define APP_USB_ENABLE 0
+#endif
+#ifndef APP_BLE_ENABLE
+#define APP_BLE_ENABLE 0
+#endif
+#ifndef APP_MIDI_ENABLE
+#define APP_MIDI_ENABLE 0
+#endif
+#ifndef APP_AUDIO_MAX_FRAMES_PER_HALF
+#define APP_AUDIO_MAX_FRAMES_PER_HALF 32u
+#endif
+#ifndef APP_AUDIO_LATENCY_DEFAULT
+#define APP_AUDIO_LATENCY_DEFAULT APP_AUDIO_LATENCY_MID
+#endif
+#ifndef APP_DSP_CHORUS_ENABLE
+#define APP_DSP_CHORUS_ENABLE 1
+#endif
+#ifndef APP_DSP_SPILL_MS
+#define APP_DSP_SPILL_MS 1500u
+#endif
+#ifndef APP_DSP_BUS_FRAMES
+#define APP_DSP_BUS_FRAMES 16u
+#endif
+#ifndef APP_DSP_CAB_SECTIONS_MAX
+#define APP_DSP_CAB_SECTIONS_MAX 6u
+#endif
+#ifndef APP_DSP_PARAM_EVENTS
+#define APP_DSP_PARAM_EVENTS 0u
+#endif
+#ifndef APP_PROFILE_RAM_OTHER_BYTES
+#define APP_PROFILE_RAM_OTHER_BYTES 6336u
+#endif
+
+#elif APP_PROFILE == APP_PROFILE_LIVE
+
+#ifndef APP_USB_ENABLE
+#define APP_USB_ENABLE 0
+#endif
+#if APP_USB_ENABLE
+/* -DAPP_USB_ENABLE=1: the CDC COM port in place of the BLE link, without
+ * STUDIO's USB audio; the buses and half the UART rings pay for the USB
+ * handle.
+ */
+#ifndef APP_BLE_ENABLE
+#define APP_BLE_ENABLE 0
+#endif
+#ifndef APP_UAC_ENABLE
+#define APP_UAC_ENABLE 0
+#endif
+#ifndef APP_CDC_TX_RING_SIZE
+#define APP_CDC_TX_RING_SIZE 256u
+#endif
+#ifndef APP_SERIAL_RX_RING_SIZE
+#define APP_SERIAL_RX_RING_SIZE 128u
+#endif
+#ifndef APP_SERIAL_TX_RING_SIZE
+#define APP_SERIAL_TX_RING_SIZE 128u
+#endif
+#ifndef APP_DSP_BUS_FRAMES
+#define APP_DSP_BUS_FRAMES 0u
+#endif
+#ifndef APP_PROFILE_RAM_OTHER_BYTES
+#define APP_PROFILE_RAM_OTHER_BYTES 8864u
+#endif
+#endif
+#ifndef APP_BLE_ENABLE
+#define APP_BLE_ENABLE 1
+#endif
+#ifndef APP_MIDI_ENABLE
+#define APP_MIDI_ENABLE 1
+#endif
+#ifndef APP_AUDIO_MAX_FRAMES_PER_HALF
+#define APP_AUDIO_MAX_FRAMES_PER_HALF 32u
+#endif
+#ifndef APP_AUDIO_LATENCY_DEFAULT
+#define APP_AUDIO_LATENCY_DEFAULT APP_AUDIO_LATENCY_MID
+#endif
+#ifndef APP_BLE_RX_RING_SIZE
+#define APP_BLE_RX_RING_SIZE (APP_BLE_ENABLE ? 256u : 16u)
+#endif
+#ifndef APP_BLE_TX_RING_SIZE
+#define APP_BLE_TX_RING_SIZE (APP_BLE_ENABLE ? 256u : 16u)
+#endif
+#ifndef APP_DSP_BUS_FRAMES
+#define APP_DSP_BUS_FRAMES 16u
+#endif
+#ifndef APP_PROFILE_RAM_OTHER_BYTES
+#define APP_PROFILE_RAM_OTHER_BYTES 8320u
+#endif
+
+#elif APP_PROFILE == APP_PROFILE_STUDIO
+
+#ifndef APP_USB_ENABLE
+#define APP_USB_ENABLE 1
+#endif
+#ifndef APP_BLE_ENABLE
+#define APP_BLE_ENABLE 0
+#endif
+#ifndef APP_MIDI_ENABLE
+#define APP_MIDI_ENABLE 0
+#endif
+#ifndef APP_PRESET_MORPH_ENABLE
+#define APP_PRESET_MORPH_ENABLE 0
+#endif
+#ifndef APP_AUDIO_MAX_FRAMES_PER_HALF
+#define APP_AUDIO_MAX_FRAMES_PER_HALF 32u
+#endif
+#ifndef APP_AUDIO_LATENCY_DEFAULT
+#define APP_AUDIO_LATENCY_DEFAULT APP_AUDIO_LATENCY_MID
+#endif
+#ifndef APP_CDC_TX_RING_SIZE
+#define APP_CDC_TX_RING_SIZE (APP_CDC_ENABLE ? 256u : 16u)
+#endif
+#ifndef APP_UAC_FIFO_FRAMES
+#define APP_UAC_FIFO_FRAMES (APP_UAC_ENABLE ? 128u : 1u)
+#endif
+#ifndef APP_SERIAL_RX_RING_SIZE
+#define APP_SERIAL_RX_RING_SIZE 128u
+#endif
+#ifndef APP_SERIAL_TX_RING_SIZE
+#define APP_SERIAL_TX_RING_SIZE 128u
+#endif
+#ifndef APP_PROFILE_RAM_OTHER_BYTES
+#define APP_PROFILE_RAM_OTHER_BYTES 7424u
+#endif
+
+#elif APP_PROFILE == APP_PROFILE_BENCH
+
+#ifndef APP_USB_ENABLE
+#define APP_USB_ENABLE 0
+#endif
+#ifndef APP_BLE_ENABLE
+#define APP_BLE_ENABLE 0
+#endif
+#ifndef APP_MIDI_ENABLE
+#define APP_MIDI_ENABLE 0
+#endif
+#ifndef APP_AUDIO_MAX_FRAMES_PER_HALF
+#define APP_AUDIO_MAX_FRAMES_PER_HALF 32u
+#endif
+#ifndef APP_AUDIO_LATENCY_DEFAULT
+#define APP_AUDIO_LATENCY_DEFAULT APP_AUDIO_LATENCY_MID
+#endif
+#ifndef APP_DSP_PARAM_EVENTS
+#define APP_DSP_PARAM_EVENTS 0u
+#endif
+#ifndef APP_CAPTURE_SAMPLES
+#define APP_CAPTURE_SAMPLES 1536u
+#endif
+#ifndef APP_PROFILE_RAM_OTHER_BYTES
+#define APP_PROFILE_RAM_OTHER_BYTES 6336u
+#endif
+
+#else
+#error "APP_PROFILE must be APP_PROFILE_MINIMAL, APP_PROFILE_LIVE, APP_PROFILE_STUDIO or APP_PROFILE_BENCH"
+#endif
+
+/* Common to every profile. */
+#ifndef APP_DSP_DELAY_RAM_BYTES
+#define APP_DSP_DELAY_RAM_BYTES 4096u
+#endif
+#ifndef APP_DSP_REVERB_RAM_BYTES
+#define APP_DSP_REVERB_RAM_BYTES 8192u
+#endif
+#ifndef APP_DSP_REVERB_AP_STAGES
+#define APP_DSP_REVERB_AP_STAGES 2u
+#endif
+#ifndef APP_DSP_CHORUS_ENABLE
+#define APP_DSP_CHORUS_ENABLE 0
+#endif
+#ifndef APP_DSP_PITCH_ENABLE
+#define APP_DSP_PITCH_ENABLE 0
+#endif
+#ifndef APP_DSP_SPILL_MS
+#define APP_DSP_SPILL_MS 0u
+#endif
+#ifndef APP_DSP_BUS_FRAMES
+#define APP_DSP_BUS_FRAMES 0u
+#endif
+#ifndef APP_DSP_CAB_SECTIONS_MAX
+#define APP_DSP_CAB_SECTIONS_MAX 0u
+#endif
+#ifndef APP_SERIAL_RX_RING_SIZE
+#define APP_SERIAL_RX_RING_SIZE 256u
+#endif
+#ifndef APP_SERIAL_TX_RING_SIZE
+#define APP_SERIAL_TX_RING_SIZE 256u
+#endif
+
+/* The RAM the image may fill: IRAM1 of the default target, below the
+ * retained block (app_mem.h). Stack and heap as in startup_stm32g431xx.s
+ * (Stack_Size, Heap_Size).
+ */
+#define APP_PROFILE_RAM_BYTES   0x7E00u
+#define APP_PROFILE_STACK_BYTES 0x400u
+#define APP_PROFILE_HEAP_BYTES  0x200u
+
+/* Cycles of one frame at full HCLK (app_power.h) less the shedder's
+ * headroom, for the declared FX costs.
+ */
+#define APP_PROFILE_HCLK_HZ 170000000u
+#define APP_PROFILE_FRAME_CYCLES(rate_hz, permille) \
+  (((APP_PROFILE_HCLK_HZ / (rate_hz)) * (permille)) / 1000u)
+
+#endif /* APP_PROFILE_H */
@@ -0,0 +1,114 @@
+#ifndef APP_RESTART_H
+#define APP_RESTART_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Warm restart: a watchdog so a hang or a fault does not silence the
+ * pedal for good, and the live sound kept over the reset.
+ *
+ * The current settings (FX mask, every parameter, the delay taps: the
+ * preset image, app_preset.h) and the slot last loaded are copied into the
+ * retained RAM block (APP_MEM_RETAIN_ADDR, app_mem.h) whenever they
+ * changed, at most every APP_RESTART_SAVE_MS. Two copies alternate, each
+ * with a sequence number and a CRC-32, so a reset in the middle of a write
+ * leaves the other one. At boot the reset flags decide: a power-up or
+ * brown-out is a cold boot (the last slot in use, AppPreset_LastSlot());
+ * any other reset with a valid copy restores it instead, so a tweak that
+ * was never saved survives too.
+ *
+ * The independent watchdog (IWDG, its own 32 kHz clock) resets the MCU
+ * when the main loop stops feeding it for APP_RESTART_WDG_MS:
+ * Error_Handler(), the fault handlers and a task that never returns all
+ * end there. More than APP_RESTART_MAX warm restarts in a row, each before
+ * APP_RESTART_STABLE_MS of uptime, means the fault comes back with the
+ * state: that boot is cold and leaves the watchdog off, so the next fault
+ * stays in the blink (app_error.h) for someone to see. Once started the
+ * IWDG cannot be stopped until the next reset; the debugger's halt freezes
+ * it.
+ *
+ * What is not a parameter (chain order, bypass tier, tuner, MIDI map) is
+ * not retained: it comes back at its boot default. Control side (main
+ * loop) only.
+ */
+#ifndef APP_RESTART_ENABLE
+#define APP_RESTART_ENABLE 1
+#endif
+
+/* Watchdog timeout; the LSI runs 29.5..34 kHz, so this is nominal. */
+#ifndef APP_RESTART_WDG_MS
+#define APP_RESTART_WDG_MS 500u
+#endif
+
+/* Shortest interval between two copies of the settings. */
+#ifndef APP_RESTART_SAVE_MS
+#define APP_RESTART_SAVE_MS 100u
+#endif
+
+#ifndef APP_RESTART_MAX
+#define APP_RESTART_MAX 3u
+#endif
+
+#ifndef APP_RESTART_STABLE_MS
+#define APP_RESTART_STABLE_MS 10000u
+#endif
+
+/* Room for the preset image in each copy (app_preset.c checks it fits). */
+#define APP_RESTART_IMAGE_MAX 224u
+
+typedef enum
+{
+  APP_RESTART_BOOT_COLD = 0,   /* last slot: power-up or nothing retained */
+  APP_RESTART_BOOT_WARM,       /* retained settings restored */
+  APP_RESTART_BOOT_FALLBACK    /* too many warm restarts: preset 0, no watchdog */
+} AppRestartBoot;
+
+typedef enum
+{
+  APP_RESTART_RESET_POWER = 0, /* power-up or brown-out */
+  APP_RESTART_RESET_PIN,
+  APP_RESTART_RESET_WATCHDOG,
+  APP_RESTART_RESET_SOFTWARE,
+  APP_RESTART_RESET_OTHER      /* window watchdog, low-power, option load */
+} AppRestartReset;
+
+typedef struct
+{
+  uint8_t boot;                /* AppRestartBoot */
+  uint8_t reset;               /* AppRestartReset */
+  uint8_t restarts;            /* warm restarts in a row, this one included */
+  uint8_t wdg;                 /* the watchdog runs */
+} AppRestartInfo;
+
+/* Boot sequence (main.c): Init reads and clears the reset flags right
+ * after SystemClock_Config(); Restore makes the boot recall and
+ * returns AppRestartBoot; Start arms the watchdog before the main loop.
+ */
+void AppRestart_Init(void);
+AppRestartBoot AppRestart_Restore(void);
+void AppRestart_Start(void);
+
+/* Scheduler task (app_sched.h), every 10 ms: feeds the watchdog and
+ * copies the settings when they changed.
+ */
+void AppRestart_Poll(void);
+
+/* Feeds the watchdog only, for a main-loop path that legitimately runs
+ * longer than APP_RESTART_WDG_MS without coming back to the scheduler
+ * (COM BENCH, a reply waiting for room on a slow link). Call it once per
+ * unit of work well under the timeout, never from an idle wait loop.
+ */
+void AppRestart_Feed(void);
+
+/* COM BOOT. Reboot resets the MCU now (a software reset: warm). */
+void AppRestart_GetInfo(AppRestartInfo *out);
+void AppRestart_Reboot(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_RESTART_H */
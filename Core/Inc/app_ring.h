@@ -0,0 +1,71 @@
+#ifndef APP_RING_H
+#define APP_RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "stm32g4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Single-producer single-consumer byte rings of the COM transports.
+ *
+ * The size is a power of two, so an index maps to its slot with a mask and
+ * runs free or wraps at the size alike. Each side owns one index and moves
+ * data in at most two contiguous chunks (up to the ring end, then from its
+ * start); a barrier orders the data against the index that publishes or
+ * frees it. Neither side masks interrupts, so queueing a reply never
+ * delays the I2S DMA interrupts.
+ */
+
+/* Producer: copies n bytes in at index w. The caller has checked the room
+ * and publishes w + n afterwards.
+ */
+static inline void AppRing_Write(uint8_t *buf, uint32_t size, uint32_t w, const uint8_t *p, uint32_t n)
+{
+  const uint32_t at = w & (size - 1u);
+  const uint32_t first = ((size - at) < n) ? (size - at) : n;
+  memcpy(&buf[at], p, first);
+  memcpy(&buf[0], &p[first], n - first);
+  __DMB(); /* data before the index that publishes it */
+}
+
+/* Consumer: copies n bytes out from index r. The caller has read the
+ * producer's index and frees r + n afterwards.
+ */
+static inline void AppRing_Read(const uint8_t *buf, uint32_t size, uint32_t r, uint8_t *dst, uint32_t n)
+{
+  const uint32_t at = r & (size - 1u);
+  const uint32_t first = ((size - at) < n) ? (size - at) : n;
+  __DMB(); /* the producer's index before the data it published */
+  memcpy(dst, &buf[at], first);
+  memcpy(&dst[first], &buf[0], n - first);
+  __DMB(); /* data read before the index that frees it */
+}
+
+/* Claims a busy flag (0 -> 1), from the main loop or an interrupt. An
+ * interrupt between the exclusive load and store clears the monitor and
+ * the store retries, so the flag needs no interrupt masking. Returns 1
+ * when the caller owns it; it gives it back by storing 0.
+ */
+static inline uint8_t AppRing_Claim(volatile uint8_t *flag)
+{
+  do
+  {
+    if (__LDREXB(flag) != 0u)
+    {
+      __CLREX();
+      return 0u;
+    }
+  } while (__STREXB(1u, flag) != 0u);
+  __DMB();
+  return 1u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_RING_H */
@@ -0,0 +1,71 @@
+#ifndef APP_SCHED_H
+#define APP_SCHED_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cooperative main-loop scheduler.
+ *
+ * Audio itself runs in the DMA interrupts and PendSV; what is left for the
+ * main loop is registered here as tasks with a priority, a period in
+ * 1 kHz TIM2 ticks (HAL_GetTick()) and a time budget. Each main-loop pass
+ * (AppSched_Run(), then AppPower_Idle() until the next interrupt) runs the
+ * due tasks highest priority first. A task with period 0 is a poll: due on
+ * every pass, and due again after each slower task of lower priority, so a
+ * COM command never waits behind more than one housekeeping task.
+ *
+ * Tasks run to completion. The budget does not stop a task: a run over it
+ * is counted, next to the run count and the average and longest run times
+ * (DWT cycles, including any interrupt that preempted the task). A
+ * periodic task that starts a whole period late is counted as late and
+ * picks up from now rather than running the missed periods back to back.
+ */
+#ifndef APP_SCHED_MAX_TASKS
+#define APP_SCHED_MAX_TASKS 12u
+#endif
+
+typedef enum
+{
+  APP_SCHED_PRIO_HIGH = 0,    /* audio recovery, COM */
+  APP_SCHED_PRIO_CONTROL,     /* MIDI, footswitches, pedal, parameter publish */
+  APP_SCHED_PRIO_HOUSEKEEPING,
+  APP_SCHED_PRIO_COUNT
+} AppSchedPrio;
+
+typedef void (*AppSchedFn)(void);
+
+typedef struct
+{
+  const char *name;
+  AppSchedPrio prio;
+  uint16_t period_ms;      /* 0 = every pass */
+  uint16_t budget_us;
+  uint32_t runs;
+  uint32_t over;           /* runs longer than budget_us */
+  uint32_t late;           /* periodic starts a period or more behind */
+  uint32_t avg_us;
+  uint32_t max_us;
+} AppSchedInfo;
+
+/* Registers a task at boot; tasks of the same priority run in the order
+ * added. Returns 0 when the table is full.
+ */
+uint8_t AppSched_Add(const char *name, AppSchedFn fn, AppSchedPrio prio, uint16_t period_ms,
+                     uint16_t budget_us);
+
+/* Main loop: runs the tasks due now. */
+void AppSched_Run(void);
+
+/* Control side (COM SCHED). Get returns 0 past the last task. */
+uint32_t AppSched_Count(void);
+uint8_t AppSched_Get(uint32_t i, AppSchedInfo *out);
+void AppSched_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SCHED_H */
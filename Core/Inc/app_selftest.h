@@ -0,0 +1,138 @@
+#ifndef APP_SELFTEST_H
+#define APP_SELFTEST_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+#include "app_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* On-target self-test: a signal generator in place of the ADC and an
+ * analyzer on the chain output, so frequency response and distortion of
+ * the chain as built can be measured over COM without audio test gear.
+ *
+ * Stimuli: one tone, a stepped log sweep of up to APP_SELFTEST_POINTS
+ * tones, or white noise, on both inputs at a level in dBFS. Each tone
+ * plays APP_SELFTEST_SETTLE samples for the chain to settle, then
+ * APP_SELFTEST_LEN samples are measured. Tones sit on the centre of a
+ * bin of that length (a whole number of periods), so the analyzer
+ * correlates the output (mid, (L + R) / 2) with the generator's own sine
+ * and cosine at the fundamental and harmonics 2..5: a Goertzel bin with no
+ * leakage and no window. Per tone it reports the gain and phase at the
+ * fundamental, THD (harmonics 2..5) and THD+N (everything but the
+ * fundamental and DC). Noise reports the broadband gain only.
+ *
+ * The sine comes from AppLfo_SinCos() (CORDIC on target), 16 bits, which
+ * puts the floor of THD+N at about -90 dB. Analysis costs about six
+ * sin/cos per sample while measuring, plus some double precision maths
+ * once per tone. COM STEST also resets the PROF and CLIP counters as it
+ * starts a run, so those cover exactly the test signal afterwards. The
+ * stimulus plays through to the DAC.
+ *
+ * Build with APP_SELFTEST_ENABLE=1, e.g. in the BENCH profile
+ * (app_profile.h); with the default 0 the hooks compile to nothing and COM
+ * answers ERR STEST DISABLED.
+ */
+#ifndef APP_SELFTEST_ENABLE
+#define APP_SELFTEST_ENABLE 0
+#endif
+
+/* Samples measured per tone: a power of two, 1024..16384 (bin width
+ * fs / LEN, 5.9 Hz at 48 kHz for 8192).
+ */
+#ifndef APP_SELFTEST_LEN
+#define APP_SELFTEST_LEN 8192u
+#endif
+
+/* Samples played before each measurement (filters, comp and EQ settle). */
+#ifndef APP_SELFTEST_SETTLE
+#define APP_SELFTEST_SETTLE 4096u
+#endif
+
+#ifndef APP_SELFTEST_POINTS
+#define APP_SELFTEST_POINTS 32u
+#endif
+
+#if APP_SELFTEST_SETTLE < 256u
+#error "APP_SELFTEST_SETTLE must cover a block (256 or more)"
+#endif
+#if ((APP_SELFTEST_LEN & (APP_SELFTEST_LEN - 1u)) != 0u) || (APP_SELFTEST_LEN < 1024u) || (APP_SELFTEST_LEN > 16384u)
+#error "APP_SELFTEST_LEN must be a power of two, 1024..16384"
+#endif
+
+typedef enum
+{
+  APP_SELFTEST_TONE = 0,
+  APP_SELFTEST_SWEEP,
+  APP_SELFTEST_NOISE,
+  APP_SELFTEST_MODE_COUNT,
+} AppSelfTestMode;
+
+typedef enum
+{
+  APP_SELFTEST_IDLE = 0,
+  APP_SELFTEST_RUNNING,
+  APP_SELFTEST_DONE,
+} AppSelfTestState;
+
+typedef struct
+{
+  AppSelfTestState state;
+  AppSelfTestMode mode;
+  int32_t level_db;  /* stimulus peak, dBFS */
+  uint32_t points;   /* tones in the run (1 for TONE and NOISE) */
+  uint32_t done;     /* points measured so far */
+} AppSelfTestInfo;
+
+/* One measured point. Fixed point: freq in 0.1 Hz, gain in 0.01 dB, the
+ * rest in 0.1 (degrees, dB). Noise points have freq 0 and only a gain.
+ */
+typedef struct
+{
+  uint32_t freq_x10;
+  int32_t gain_x100;
+  int32_t phase_x10;   /* output vs stimulus, -180..180 */
+  int32_t thd_x10;
+  int32_t thdn_x10;
+} AppSelfTestPoint;
+
+/* Static RAM share (app_profile.h). */
+#define APP_SELFTEST_RAM_BYTES (APP_SELFTEST_ENABLE ? (APP_SELFTEST_POINTS * sizeof(AppSelfTestPoint)) : 0u)
+
+/* Control side (main loop). Start returns 0 while a run is going, or on
+ * bad arguments: f1/f2 in Hz below fs / 2 (f2 and points for SWEEP only,
+ * points 2..APP_SELFTEST_POINTS), level -90..0 dBFS. Tones are rounded to
+ * the nearest bin.
+ */
+uint8_t AppSelfTest_Start(AppSelfTestMode mode, uint32_t f1, uint32_t f2, uint32_t points, int32_t level_db);
+void AppSelfTest_Stop(void);
+void AppSelfTest_GetInfo(AppSelfTestInfo *out);
+
+/* Returns 0 unless point 'index' has been measured. */
+uint8_t AppSelfTest_GetPoint(uint32_t index, AppSelfTestPoint *out);
+
+/* Audio side (AppDsp_ProcessBlock()): Input replaces the block ahead of
+ * the chain, Output analyses what the chain made of it.
+ */
+void AppSelfTest_Input(AppStereoS24 *x, uint32_t n);
+void AppSelfTest_Output(const AppStereoS24 *x, uint32_t n);
+
+/* The result table for COM MEM MAP (no entries when disabled). */
+uint32_t AppSelfTest_MemMap(const AppMemItem **items);
+
+#if APP_SELFTEST_ENABLE
+#define APP_SELFTEST_INPUT(x, n)         AppSelfTest_Input((x), (n))
+#define APP_SELFTEST_OUTPUT(x, n)        AppSelfTest_Output((x), (n))
+#else
+#define APP_SELFTEST_INPUT(x, n)         do { } while (0)
+#define APP_SELFTEST_OUTPUT(x, n)        do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SELFTEST_H */
@@ -0,0 +1,101 @@
+#ifndef APP_SERIAL_H
+#define APP_SERIAL_H
+
+#include <stdint.h>
+
+#include "app_mem.h"
+#include "stm32g4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The COM link on USART2 (the ST-LINK virtual COM port): byte transport
+ * only, the protocol on top is app_com.c's.
+ *
+ * RX prefers circular ReceiveToIdle DMA straight into the ring, so the DMA
+ * counter is the write index and nothing is copied per burst; without an
+ * RX DMA channel it falls back to ReceiveToIdle IT, then to a byte per
+ * interrupt. TX never blocks the MCU when the host sends a lot of commands
+ * (PSET/FXMASK): writes go into a ring drained in contiguous chunks by
+ * HAL_UART_Transmit_DMA() (one interrupt per chunk), or
+ * HAL_UART_Transmit_IT() when the UART has no TX DMA channel linked. Both
+ * rings are single-producer single-consumer (app_ring.h): neither side
+ * masks interrupts.
+ */
+
+/* Ring sizes are powers of two. */
+#ifndef APP_SERIAL_RX_RING_SIZE
+/* Larger RX ring so we don't corrupt commands when the audio/DSP load is high.
+ * Dropping bytes can turn valid commands into garbage, leading to ERR UNKNOWN.
+ * A backlog larger than the ring is overwritten (DMA) or dropped (IT).
+ */
+#define APP_SERIAL_RX_RING_SIZE 1024u
+#endif
+
+#ifndef APP_SERIAL_TX_RING_SIZE
+#define APP_SERIAL_TX_RING_SIZE 512u
+#endif
+
+/* Staging buffer of the ReceiveToIdle IT fallback (no RX DMA linked). */
+#ifndef APP_SERIAL_RX_IT_SIZE
+#define APP_SERIAL_RX_IT_SIZE 128u
+#endif
+
+/* Static RAM share (app_profile.h). */
+#define APP_SERIAL_RAM_BYTES (APP_SERIAL_RX_RING_SIZE + APP_SERIAL_TX_RING_SIZE + APP_SERIAL_RX_IT_SIZE)
+
+typedef struct
+{
+  uint16_t rx_peak;        /* highest ring fills in bytes */
+  uint16_t tx_peak;
+} AppSerialInfo;
+
+/* Starts RX (huart: set up by MX_USART2_UART_Init()). */
+void AppSerial_Init(UART_HandleTypeDef *huart);
+
+/* Main loop. Read takes up to max received bytes. Restarted returns 1 once
+ * after the RX DMA started over at the ring start (a line error or a baud
+ * switch): what was still unread is dropped, and so should a partial line
+ * be. Write queues all n bytes or none (returns 0 when the ring has no
+ * room).
+ */
+uint32_t AppSerial_Read(uint8_t *dst, uint32_t max);
+uint8_t AppSerial_Restarted(void);
+uint8_t AppSerial_Write(const uint8_t *p, uint32_t n);
+uint32_t AppSerial_TxFree(void);
+
+/* Nonzero while there are received bytes not read yet, or after a UART
+ * event since the last Read. Safe with interrupts masked (AppPower_Idle()).
+ */
+uint8_t AppSerial_Pending(void);
+
+/* The DWT cycle count of the last RX interrupt, when one came since the
+ * previous call (returns 1): when the bytes a Read just took arrived, for
+ * the COM latency probe.
+ */
+uint8_t AppSerial_RxStamp(uint32_t *cyc);
+
+/* BAUD: TxDone once everything queued has left the shift register;
+ * SetBaud switches right away (and restarts RX).
+ */
+uint32_t AppSerial_Baud(void);
+uint8_t AppSerial_TxDone(void);
+void AppSerial_SetBaud(uint32_t rate);
+
+/* COM MEM. */
+void AppSerial_Get(AppSerialInfo *out);
+void AppSerial_ResetPeaks(void);
+uint32_t AppSerial_MemMap(const AppMemItem **items);
+
+/* Hooks from the HAL callbacks (main.c). */
+void AppSerial_OnUartRxCplt(UART_HandleTypeDef *huart);
+void AppSerial_OnUartRxEvent(UART_HandleTypeDef *huart, uint16_t size);
+void AppSerial_OnUartTxCplt(UART_HandleTypeDef *huart);
+void AppSerial_OnUartError(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SERIAL_H */
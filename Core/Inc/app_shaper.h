@@ -0,0 +1,54 @@
+#ifndef APP_SHAPER_H
+#define APP_SHAPER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Table-driven waveshaper shared by the input colour stage and the
+ * distortion clipper.
+ *
+ * Each curve is a 513-entry Q15 table in flash (AppTab_ShaperLut, defined
+ * in the generated app_tables.c) covering the signed 24-bit input range in
+ * 512 steps; a lookup is one pair of halfword loads and a
+ * linear interpolation on the low 15 input bits. The distortion curves
+ * saturate near the old hard clip level (~1.2M) so switching curves keeps
+ * the loudness roughly constant.
+ */
+typedef enum
+{
+  APP_SHAPER_SOFT = 0,   /* cubic x - x^3/3 (input colour) */
+  APP_SHAPER_HARD,       /* original hard_tube_clip_s24 knees (distortion default) */
+  APP_SHAPER_TUBE,       /* tanh knee, asymmetric saturation */
+  APP_SHAPER_DIODE,      /* sharper symmetric knee */
+  APP_SHAPER_FUZZ,       /* near-square, asymmetric */
+  APP_SHAPER_ASYM,       /* tanh on +, soft on -: even harmonics */
+  APP_SHAPER_CURVE_COUNT
+} AppShaperCurve;
+
+#define APP_SHAPER_LUT_BITS  9u
+#define APP_SHAPER_LUT_SIZE  ((1u << APP_SHAPER_LUT_BITS) + 1u)
+#define APP_SHAPER_FRAC_BITS (24u - APP_SHAPER_LUT_BITS)
+
+/* Returns the table of a curve (APP_SHAPER_SOFT for an unknown id). */
+const int16_t *AppShaper_Table(AppShaperCurve curve);
+const char *AppShaper_Name(AppShaperCurve curve);
+
+/* x must already be clamped to s24; the result is s24. */
+static inline int32_t AppShaper_S24(const int16_t *lut, int32_t x_s24)
+{
+  uint32_t u = (uint32_t)(x_s24 + 8388608);
+  uint32_t i = u >> APP_SHAPER_FRAC_BITS;
+  int32_t frac = (int32_t)(u & ((1u << APP_SHAPER_FRAC_BITS) - 1u));
+  int32_t y0 = lut[i];
+  int32_t y1 = lut[i + 1u];
+  return (y0 + (((y1 - y0) * frac) >> APP_SHAPER_FRAC_BITS)) * 256;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SHAPER_H */
@@ -0,0 +1,90 @@
+#ifndef APP_SPECTRUM_H
+#define APP_SPECTRUM_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Spectrum analyzer on the output, for the app's EQ and cab display.
+ *
+ * The audio side only decimates: the output (L + R) / 2 is averaged over
+ * APP_SPECTRUM_DECIM frames into a window of APP_SPECTRUM_FFT_LEN int16
+ * samples, and once the window is full it is left alone until the control
+ * side took it. The transform runs in the main loop (COM "spectrum" topic):
+ * Hann window, a real FFT of APP_SPECTRUM_FFT_LEN points, then the peak bin
+ * of each of APP_SPECTRUM_BANDS log-spaced bands in dBFS (a full-scale sine
+ * reads 0 dB in its band). A window is ~11 ms of audio at the default 24
+ * kHz analysis rate; it is at most one publish period old when taken.
+ *
+ * ~3 kB of RAM: build with APP_SPECTRUM_ENABLE=1, e.g. in the BENCH
+ * profile (app_profile.h). With the default 0 the hook compiles away and
+ * the topic is not offered.
+ */
+#ifndef APP_SPECTRUM_ENABLE
+#define APP_SPECTRUM_ENABLE 0
+#endif
+
+/* 24 kHz analysis rate (2 at 48 kHz, 4 at 96 kHz): 12 kHz span, 94 Hz
+ * bins with the 256-point FFT.
+ */
+#ifndef APP_SPECTRUM_DECIM
+#define APP_SPECTRUM_DECIM (APP_DSP_SAMPLE_RATE_HZ / 24000u)
+#endif
+
+#define APP_SPECTRUM_FFT_LEN 256u
+
+/* Static RAM share (app_profile.h): the int16 window, two float work
+ * buffers and half a Hann window.
+ */
+#define APP_SPECTRUM_RAM_BYTES \
+  (APP_SPECTRUM_ENABLE ? ((APP_SPECTRUM_FFT_LEN * 10u) + (((APP_SPECTRUM_FFT_LEN / 2u) + 1u) * 4u)) : 0u)
+
+/* Bands from the first bin to Nyquist; a COM frame carries up to 30. */
+#ifndef APP_SPECTRUM_BANDS
+#define APP_SPECTRUM_BANDS 24u
+#endif
+
+/* arm_rfft_fast_f32() on the target, a plain DFT on host builds. */
+#ifndef APP_SPECTRUM_USE_CMSIS
+#if defined(__ARM_ARCH)
+#define APP_SPECTRUM_USE_CMSIS 1
+#else
+#define APP_SPECTRUM_USE_CMSIS 0
+#endif
+#endif
+
+typedef struct
+{
+  uint16_t bin_chz;                       /* width of one FFT bin, 0.01 Hz */
+  uint8_t top[APP_SPECTRUM_BANDS];        /* last FFT bin of each band; band 0 starts at bin 1 */
+  uint8_t level[APP_SPECTRUM_BANDS];      /* peak, 0.5 dB steps: 255 = 0 dBFS, 0 = -127.5 or less */
+} AppSpectrumFrame;
+
+/* Control side (main loop). Enable starts (or stops) filling windows;
+ * Take transforms the latest full window and returns 0 if there is none
+ * since the last Take.
+ */
+void AppSpectrum_Enable(uint8_t on);
+uint8_t AppSpectrum_Take(AppSpectrumFrame *out);
+
+/* Audio side (AppDsp_ProcessBlock()), at the output tap. */
+void AppSpectrum_Block(const AppStereoS24 *x, uint32_t n);
+
+/* Window and FFT buffers for COM MEM MAP (no entries when disabled). */
+uint32_t AppSpectrum_MemMap(const AppMemItem **items);
+
+#if APP_SPECTRUM_ENABLE
+#define APP_SPECTRUM_BLOCK(x, n) AppSpectrum_Block((x), (n))
+#else
+#define APP_SPECTRUM_BLOCK(x, n) do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SPECTRUM_H */
@@ -0,0 +1,67 @@
+#ifndef APP_SWITCH_H
+#define APP_SWITCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Footswitches on GPIO inputs, so the pedal plays without a laptop.
+ *
+ * The 1 kHz TIM2 time base samples every input (AppSwitch_Sample(), no
+ * EXTI). A contact that has rested released for APP_SWITCH_HOLDOFF_MS
+ * counts as pressed on the first sample that reads it closed, then is not
+ * looked at again for APP_SWITCH_HOLDOFF_MS; the release is handled the
+ * same way. That swallows contact bounce without delaying the press: it is
+ * seen within 1 ms. The main loop (AppSwitch_Poll(), woken by the same
+ * tick) runs the action, which lands in the DSP at the next block boundary
+ * as one parameter batch.
+ *
+ * Actions: the stored preset after / before the one last loaded (empty
+ * slots skipped, the number wraps), bypass (FX mask 0; the next press
+ * restores the mask from before), tap tempo (AppDsp_TapTempo()) and
+ * reverb freeze (toggles reverb_freeze).
+ */
+#ifndef APP_SWITCH_ENABLE
+#define APP_SWITCH_ENABLE 1
+#endif
+
+#ifndef APP_SWITCH_HOLDOFF_MS
+#define APP_SWITCH_HOLDOFF_MS 20u
+#endif
+
+/* Inputs in app_switch.c's pin table: B1 on the Nucleo and three jacks. */
+#define APP_SWITCH_COUNT 4u
+
+typedef enum
+{
+  APP_SWITCH_NONE = 0,
+  APP_SWITCH_PRESET_NEXT,
+  APP_SWITCH_PRESET_PREV,
+  APP_SWITCH_BYPASS,
+  APP_SWITCH_TAP,
+  APP_SWITCH_FREEZE,
+  APP_SWITCH_ACTION_COUNT
+} AppSwitchAction;
+
+/* Configures the pins; call before the time base samples them. */
+void AppSwitch_Init(void);
+
+/* TIM2 update interrupt, once per ms. */
+void AppSwitch_Sample(void);
+
+/* Main loop: runs the actions of the presses since the last call. */
+void AppSwitch_Poll(void);
+
+/* Control side (COM FSW). */
+uint8_t AppSwitch_SetAction(uint32_t sw, AppSwitchAction action);
+AppSwitchAction AppSwitch_GetAction(uint32_t sw);
+uint32_t AppSwitch_Presses(uint32_t sw);
+uint8_t AppSwitch_Pressed(uint32_t sw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SWITCH_H */
@@ -0,0 +1,170 @@
+#ifndef APP_TABLES_H
+#define APP_TABLES_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+#include "app_shaper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lookup tables shared by the DSP modules, const in flash.
+ *
+ * app_tables.c is generated by tools/dsp_host/gen_tables.c and checked in
+ * (the Keil project has no pre-build step); after changing the generator:
+ *   cmake --build build/dsp_host --target app_tables
+ * Nothing is filled at boot and nothing is copied to RAM. Each table exists
+ * once, whatever number of modules read it; the inline lookups below are
+ * the only intended readers.
+ */
+#define APP_TAB_LOG2_BITS    5u      /* log2 / exp2: 32 steps per octave */
+#define APP_TAB_SIN_BITS     8u      /* sine: 256 steps per quarter wave */
+#define APP_TAB_RECIP_BITS   8u      /* reciprocal: 256 steps per octave */
+#define APP_TAB_TONE_GRID    9u      /* tone stack: 9 x 9 bass/mid knob positions */
+
+/* Waveshaper curves (app_shaper.h). */
+extern const int16_t AppTab_ShaperLut[APP_SHAPER_CURVE_COUNT][APP_SHAPER_LUT_SIZE];
+/* log2(1 + i/32) in Q16 and 2^(i/32) in Q15, i = 0..32. */
+extern const int32_t AppTab_Log2Lut[(1u << APP_TAB_LOG2_BITS) + 1u];
+extern const int32_t AppTab_Exp2Lut[(1u << APP_TAB_LOG2_BITS) + 1u];
+/* sin(pi/2 * i/256) in Q15, i = 0..256. */
+extern const uint16_t AppTab_SinLut[(1u << APP_TAB_SIN_BITS) + 1u];
+/* 1 / (1 + i/256) in Q30, i = 0..256. */
+extern const uint32_t AppTab_RecipLut[(1u << APP_TAB_RECIP_BITS) + 1u];
+
+/* Amp tone stack at the build rate, as
+ *   H(z) = (1 - z^-1) / (1 - p z^-1) * (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+ * The passive network has a zero at DC and three real poles, p the
+ * lowest. Its numerator is linear in the treble pot, so a node keeps b at
+ * treble 0 and the slope bt: treble is exact, only bass and mid are
+ * interpolated. Linear interpolation cannot make a node unstable: real
+ * poles in (-1, 1) and biquad denominators in the stability triangle both
+ * form convex sets.
+ */
+typedef struct
+{
+  int32_t p_q30;
+  int32_t a_q28[2];
+  int32_t b_q28[3];
+  int32_t bt_q28[3];
+} AppTabToneNode;
+
+typedef struct
+{
+  int32_t p_q30;
+  int32_t a_q28[2];
+  int32_t b_q28[3];
+} AppTabTone;
+
+/* [model - 1][bass][mid], knob i at i/8 of its travel. */
+extern const AppTabToneNode AppTab_ToneLut[APP_DSP_TONE_MODEL_COUNT - 1u][APP_TAB_TONE_GRID][APP_TAB_TONE_GRID];
+
+/* x > 0 in s24 counts -> log2(x / 2^23) in Q16 octaves (within 0.002 dB). */
+static inline int32_t AppTab_Log2(int32_t x)
+{
+  const uint32_t z = (uint32_t)__builtin_clz((uint32_t)x);
+  const uint32_t m = (uint32_t)x << z;
+  const uint32_t idx = (m >> 26) & 31U;
+  const int32_t t = (int32_t)((m >> 10) & 0xFFFFU);
+  const int32_t a = AppTab_Log2Lut[idx];
+  return ((8 - (int32_t)z) * 65536) + a + (((AppTab_Log2Lut[idx + 1U] - a) * t) >> 16);
+}
+
+/* l2 <= 0 in Q16 octaves -> 2^l2 in Q15 (within 0.002 dB). */
+static inline int32_t AppTab_Exp2(int32_t l2)
+{
+  const int32_t sh = -(l2 >> 16);
+  if (sh > 16)
+  {
+    return 0;
+  }
+  const uint32_t f = (uint32_t)l2 & 0xFFFFU;
+  const uint32_t idx = f >> 11;
+  const int32_t t = (int32_t)(f & 0x7FFU);
+  const int32_t a = AppTab_Exp2Lut[idx];
+  return (a + (((AppTab_Exp2Lut[idx + 1U] - a) * t) >> 11)) >> sh;
+}
+
+/* 0.1 dB steps -> Q16 octaves: 65536 * log2(10) / 200 = 1088.51 per step. */
+#define APP_TAB_DB10_TO_L2(db10)       (((db10) * 69665) / 64)
+
+/* db10 <= 0 tenths of a dB -> linear gain in Q15. */
+static inline int32_t AppTab_Db10ToQ15(int32_t db10)
+{
+  return AppTab_Exp2(APP_TAB_DB10_TO_L2(db10));
+}
+
+/* sin(2 pi * phase / 2^32) in Q15, clamped to +-32767 (within 1.2 LSB). */
+static inline int32_t AppTab_Sin(uint32_t phase)
+{
+  /* Quarter waves 1 and 3 read the table backwards. */
+  uint32_t p = phase & 0x3FFFFFFFu;
+  if ((phase & 0x40000000u) != 0u)
+  {
+    p = 0x3FFFFFFFu - p;
+  }
+  const uint32_t idx = p >> (30u - APP_TAB_SIN_BITS);
+  const int32_t t = (int32_t)((p >> (14u - APP_TAB_SIN_BITS)) & 0xFFFFu);
+  const int32_t a = (int32_t)AppTab_SinLut[idx];
+  int32_t s = a + (int32_t)(((((int32_t)AppTab_SinLut[idx + 1u] - a) * t) + 32768) >> 16);
+  s = (s > 32767) ? 32767 : s;
+  return ((phase & 0x80000000u) != 0u) ? -s : s;
+}
+
+/* (num << 15) / den without a divide, for den > 0 and a result under
+ * 2^31. Relative error under 4e-6: within 1 of the truncated quotient up
+ * to 2^17, which covers any Q15 gain.
+ */
+static inline uint32_t AppTab_DivQ15(uint32_t num, uint32_t den)
+{
+  const uint32_t z = (uint32_t)__builtin_clz(den);
+  const uint32_t m = den << z;
+  const uint32_t idx = (m >> (31u - APP_TAB_RECIP_BITS)) & ((1u << APP_TAB_RECIP_BITS) - 1u);
+  const uint32_t t = (m >> (15u - APP_TAB_RECIP_BITS)) & 0xFFFFu;
+  const uint32_t a = AppTab_RecipLut[idx];
+  const uint32_t r = a - (uint32_t)(((uint64_t)(a - AppTab_RecipLut[idx + 1u]) * t) >> 16);
+  return (uint32_t)(((uint64_t)num * r) >> (46u - z));
+}
+
+static inline int32_t app_tab_lerp_q15(int32_t a, int32_t b, int32_t f)
+{
+  return a + (int32_t)(((int64_t)(b - a) * f) >> 15);
+}
+
+/* Coefficients of model (1..APP_DSP_TONE_MODEL_COUNT - 1) at knob
+ * positions 0..32768: bilinear over the bass/mid cell, then the treble
+ * slope. ~40 multiplies, cheap enough for every block.
+ */
+static inline void AppTab_Tone(uint32_t model, int32_t bass_q15, int32_t mid_q15, int32_t treble_q15, AppTabTone *out)
+{
+  const uint32_t xb = (uint32_t)bass_q15 * (APP_TAB_TONE_GRID - 1u);
+  const uint32_t xm = (uint32_t)mid_q15 * (APP_TAB_TONE_GRID - 1u);
+  const uint32_t ib = (xb >> 15) < (APP_TAB_TONE_GRID - 1u) ? (xb >> 15) : (APP_TAB_TONE_GRID - 2u);
+  const uint32_t im = (xm >> 15) < (APP_TAB_TONE_GRID - 1u) ? (xm >> 15) : (APP_TAB_TONE_GRID - 2u);
+  const int32_t fb = (int32_t)(xb - (ib << 15));
+  const int32_t fm = (int32_t)(xm - (im << 15));
+  const AppTabToneNode *n0 = &AppTab_ToneLut[model - 1u][ib][im];
+  const AppTabToneNode *n1 = &AppTab_ToneLut[model - 1u][ib + 1u][im];
+
+#define APP_TAB_TONE_LERP(f) \
+  app_tab_lerp_q15(app_tab_lerp_q15(n0[0].f, n0[1].f, fm), app_tab_lerp_q15(n1[0].f, n1[1].f, fm), fb)
+  out->p_q30 = APP_TAB_TONE_LERP(p_q30);
+  for (uint32_t k = 0; k < 2u; k++)
+  {
+    out->a_q28[k] = APP_TAB_TONE_LERP(a_q28[k]);
+  }
+  for (uint32_t k = 0; k < 3u; k++)
+  {
+    out->b_q28[k] = APP_TAB_TONE_LERP(b_q28[k]) +
+                    (int32_t)(((int64_t)APP_TAB_TONE_LERP(bt_q28[k]) * treble_q15) >> 15);
+  }
+#undef APP_TAB_TONE_LERP
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_TABLES_H */
@@ -0,0 +1,121 @@
+#ifndef APP_TELEM_H
+#define APP_TELEM_H
+
+#include <stdint.h>
+
+#include "app_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Telemetry transport for the bench: moves the streams (METER frames, DUMP
+ * and TRACE DUMP frames, and with APP_TRACE_ENABLE every trace event live)
+ * off the COM link that started them onto the debug probe, so they neither
+ * compete with control traffic nor shift the COM timing being measured.
+ * Text replies always stay on the link. Selected at run time with COM
+ * TELEM; the link (APP_TELEM_UART) after boot.
+ *
+ * ITM: one SWO stimulus port per channel (APP_TELEM_ITM_PORT + channel),
+ * carrying the same 0xA5 frames as the UART; a live trace event is its
+ * AppTraceEvent word alone, timed by the ITM local timestamps (enable them
+ * with SWO in the debugger). A port the debugger left disabled drops its
+ * writes.
+ * RTT: a SEGGER RTT control block in RAM ("SEGGER RTT" id, found by the
+ * probe's RAM scan) with up buffer 0 "Telemetry" for the frames and up
+ * buffer 1 "Trace" for the live events (whole 8-byte AppTraceEvent
+ * records). A full buffer drops a live event or METER frame; DUMP streams
+ * wait for room. Up buffer 2 and down buffer 0, both "Commands", carry the
+ * COM protocol itself as one more link of app_com.c (a terminal on RTT
+ * channel 0 sees the telemetry instead; open channel 2 up / 0 down); the
+ * link opens with the first command byte from the probe.
+ */
+#ifndef APP_TELEM_ITM
+#define APP_TELEM_ITM 1
+#endif
+
+/* Costs APP_TELEM_RTT_BYTES + APP_TELEM_RTT_TRACE_BYTES
+ * + 2 * APP_TELEM_RTT_COM_BYTES of RAM, which the BENCH profile has
+ * (app_profile.h).
+ */
+#ifndef APP_TELEM_RTT
+#define APP_TELEM_RTT 0
+#endif
+
+#ifndef APP_TELEM_RTT_BYTES
+#define APP_TELEM_RTT_BYTES 1024u
+#endif
+
+#ifndef APP_TELEM_RTT_TRACE_BYTES
+#define APP_TELEM_RTT_TRACE_BYTES 1024u
+#endif
+
+#ifndef APP_TELEM_RTT_COM_BYTES
+#define APP_TELEM_RTT_COM_BYTES 512u
+#endif
+
+/* Static RAM share (app_profile.h). */
+#define APP_TELEM_RAM_BYTES \
+  (APP_TELEM_RTT ? (APP_TELEM_RTT_BYTES + APP_TELEM_RTT_TRACE_BYTES + (2u * APP_TELEM_RTT_COM_BYTES)) : 0u)
+
+/* First stimulus port (0 is left to printf-style terminals). */
+#ifndef APP_TELEM_ITM_PORT
+#define APP_TELEM_ITM_PORT 1u
+#endif
+
+typedef enum
+{
+  APP_TELEM_UART = 0,
+  APP_TELEM_ITM_SWO,
+  APP_TELEM_RTT_MEM,
+  APP_TELEM_TRANSPORT_COUNT,
+} AppTelemTransport;
+
+typedef enum
+{
+  APP_TELEM_CH_METER = 0,
+  APP_TELEM_CH_DUMP,       /* DUMP and TRACE DUMP frames */
+  APP_TELEM_CH_TRACE,      /* live trace events */
+  APP_TELEM_CH_COUNT,
+} AppTelemChannel;
+
+typedef struct
+{
+  AppTelemTransport transport;
+  uint8_t attached;        /* ITM enabled by a debugger / RTT buffer read lately */
+  uint32_t frames;         /* sent over the transport since it was selected */
+  uint32_t events;         /* live trace events sent */
+  uint32_t dropped;        /* frames and events dropped */
+} AppTelemStats;
+
+/* Returns 0 if the transport is not in this build. */
+uint8_t AppTelem_Select(AppTelemTransport t);
+AppTelemTransport AppTelem_Transport(void);
+void AppTelem_GetStats(AppTelemStats *out);
+
+/* Main loop: one whole frame on a channel or nothing. Returns 0 when it
+ * has to wait for room (RTT); dropped writes return 1.
+ */
+uint8_t AppTelem_Write(AppTelemChannel ch, const uint8_t *p, uint32_t n);
+
+/* Any context (AppTrace_Log()): one trace event, never waits. */
+void AppTelem_Event(uint32_t cyc, uint32_t word);
+
+/* COM link over the RTT "Commands" buffers (app_com.c), main loop; never
+ * open without APP_TELEM_RTT. ComWrite puts all n bytes or none (returns 0
+ * when the up buffer has no room; 1 also while closed, discarded).
+ */
+uint32_t AppTelem_ComRead(uint8_t *dst, uint32_t max);
+uint8_t AppTelem_ComPending(void);
+uint8_t AppTelem_ComIsOpen(void);
+uint8_t AppTelem_ComWrite(const uint8_t *p, uint32_t n);
+uint32_t AppTelem_ComTxFree(void);
+
+/* The RTT buffers for COM MEM MAP (no entries without APP_TELEM_RTT). */
+uint32_t AppTelem_MemMap(const AppMemItem **items);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_TELEM_H */
@@ -0,0 +1,126 @@
+#ifndef APP_TRACE_H
+#define APP_TRACE_H
+
+#include <stdint.h>
+
+#include "app_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event trace for post-mortem timelines.
+ *
+ * A RAM ring of the last APP_TRACE_EVENTS events (DMA halves, DSP blocks,
+ * UART bursts, parameter changes, underruns...), each a DWT cycle stamp, an
+ * AppTraceId and a 24-bit argument. It runs from boot. An event whose bit is
+ * set in the trigger mask (underruns, overflows, deadline misses and I2S
+ * errors by default) freezes it APP_TRACE_POST events later, so the ring
+ * keeps what led up to the anomaly; COM TRACE DUMP streams it out in binary
+ * and TRACE ARM starts the next recording.
+ *
+ * Logging is one call that masks IRQs for the slot claim and two stores
+ * (about 20 cycles), from any interrupt level. Needs APP_TRACE_EVENTS * 8
+ * bytes of RAM, so the default builds leave it out: build with
+ * APP_TRACE_ENABLE=1 (e.g. in the BENCH profile, app_profile.h). With
+ * the default 0 the hooks compile to nothing and COM answers ERR TRACE
+ * DISABLED.
+ */
+#ifndef APP_TRACE_ENABLE
+#define APP_TRACE_ENABLE 0
+#endif
+
+/* Power of two. */
+#ifndef APP_TRACE_EVENTS
+#define APP_TRACE_EVENTS 256u
+#endif
+
+/* Events still recorded after a trigger, 1..APP_TRACE_EVENTS. */
+#ifndef APP_TRACE_POST
+#define APP_TRACE_POST 32u
+#endif
+
+#if (APP_TRACE_EVENTS & (APP_TRACE_EVENTS - 1u)) != 0u
+#error "APP_TRACE_EVENTS must be a power of two"
+#endif
+#if (APP_TRACE_POST == 0u) || (APP_TRACE_POST > APP_TRACE_EVENTS)
+#error "APP_TRACE_POST must be 1..APP_TRACE_EVENTS"
+#endif
+
+/* Event ids, fixed: host tools decode dumps by them. */
+typedef enum
+{
+  APP_TRACE_RX_HALF = 0,   /* RX DMA half complete, arg: half */
+  APP_TRACE_TX_HALF,       /* TX DMA half complete, arg: half */
+  APP_TRACE_DSP_START,     /* arg: half */
+  APP_TRACE_DSP_END,       /* arg: block cycles */
+  APP_TRACE_UART_RX,       /* UART RX event, arg: DMA position or bytes */
+  APP_TRACE_PARAM,         /* AppDsp_SetParam(), arg: id << 16 | value & 0xFFFF */
+  APP_TRACE_FXMASK,        /* arg: mask */
+  APP_TRACE_PRESET,        /* preset recalled, arg: slot */
+  APP_TRACE_UNDERRUN,      /* TX fill ran dry, arg: frames short */
+  APP_TRACE_OVERFLOW,      /* TX fill re-centred after a ring overflow */
+  APP_TRACE_MISS,          /* DSP deadline miss, arg: block cycles */
+  APP_TRACE_I2S_ERR,       /* arg: AppAudioErrKind */
+  APP_TRACE_ID_COUNT,
+} AppTraceId;
+
+#define APP_TRACE_BIT(id)        (1u << (uint32_t)(id))
+#define APP_TRACE_TRIG_DEFAULT   (APP_TRACE_BIT(APP_TRACE_UNDERRUN) | APP_TRACE_BIT(APP_TRACE_OVERFLOW) | \
+                                  APP_TRACE_BIT(APP_TRACE_MISS) | APP_TRACE_BIT(APP_TRACE_I2S_ERR))
+
+typedef struct
+{
+  uint32_t cyc;    /* DWT->CYCCNT */
+  uint32_t word;   /* id | arg << 8 */
+} AppTraceEvent;
+
+/* Static RAM share (app_profile.h). */
+#define APP_TRACE_RAM_BYTES (APP_TRACE_ENABLE ? (APP_TRACE_EVENTS * sizeof(AppTraceEvent)) : 0u)
+
+typedef enum
+{
+  APP_TRACE_RUNNING = 0,
+  APP_TRACE_TRIGGERED,     /* recording the post-trigger events */
+  APP_TRACE_FROZEN,
+} AppTraceState;
+
+typedef struct
+{
+  AppTraceState state;
+  uint32_t trig_mask;
+  uint32_t seq;      /* events logged since the last arm */
+  uint32_t held;     /* events in the ring, min(seq, APP_TRACE_EVENTS) */
+  uint32_t trig;     /* ring index (0 = oldest) of the trigger, held if none */
+  uint32_t trig_id;  /* its AppTraceId */
+} AppTraceInfo;
+
+/* Any context. */
+void AppTrace_Log(AppTraceId id, uint32_t arg);
+
+/* Control side. Arm clears the ring and records again, freezing on the ids
+ * in trig_mask (0 = only by AppTrace_Freeze()).
+ */
+void AppTrace_Arm(uint32_t trig_mask);
+void AppTrace_Freeze(void);
+void AppTrace_GetInfo(AppTraceInfo *out);
+
+/* Copies up to n held events from ring index 'first' (0 = oldest) while
+ * frozen. Returns the number copied.
+ */
+uint32_t AppTrace_Read(uint32_t first, AppTraceEvent *out, uint32_t n);
+
+/* The ring for COM MEM MAP (no entries when disabled). */
+uint32_t AppTrace_MemMap(const AppMemItem **items);
+
+#if APP_TRACE_ENABLE
+#define APP_TRACE(id, arg)       AppTrace_Log((id), (uint32_t)(arg))
+#else
+#define APP_TRACE(id, arg)       do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_TRACE_H */
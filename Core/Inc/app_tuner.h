@@ -0,0 +1,121 @@
+#ifndef APP_TUNER_H
+#define APP_TUNER_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Chromatic tuner on the input, ahead of the gate and the FX.
+ *
+ * The left input is lowpassed and decimated by APP_TUNER_DECIM to 4 kHz
+ * into a frame of APP_TUNER_WINDOW + lags samples. Once a frame is full the
+ * YIN difference function is computed a few lags per audio block
+ * (APP_TUNER_LAGS_PER_16 per 16 frames, ~130 multiply-adds per lag), so a
+ * block never pays for more than a slice of the search: one estimate every
+ * ~70 ms at any block size. The first dip of the cumulative mean normalised
+ * difference under the threshold, parabola-refined, is the period; a frame
+ * under APP_TUNER_MIN_LEVEL or without a clear dip reports no pitch.
+ *
+ * The main loop turns the tuner on (optionally muting the output through
+ * the master volume ramp) and reads the latest period, converted to note
+ * and cents against APP_TUNER_A4_HZ.
+ *
+ * ~800 bytes of RAM: build with APP_TUNER_ENABLE=1, e.g. in the BENCH
+ * profile (app_profile.h). With the default 0 the hooks compile away and
+ * COM answers ERR TUNER DISABLED.
+ */
+#ifndef APP_TUNER_ENABLE
+#define APP_TUNER_ENABLE 0
+#endif
+
+/* 4 kHz analysis rate (12 at 48 kHz, 24 at 96 kHz). */
+#ifndef APP_TUNER_DECIM
+#define APP_TUNER_DECIM (APP_DSP_SAMPLE_RATE_HZ / 4000u)
+#endif
+
+/* Lowest pitch searched (a 5-string bass B is 31 Hz; the guitar range
+ * needs only 60).
+ */
+#ifndef APP_TUNER_FMIN_HZ
+#define APP_TUNER_FMIN_HZ 60u
+#endif
+
+/* Highest pitch searched (four samples a period at 4 kHz). */
+#ifndef APP_TUNER_FMAX_HZ
+#define APP_TUNER_FMAX_HZ 1000u
+#endif
+
+/* Difference-function window in decimated samples (32 ms at 4 kHz). */
+#ifndef APP_TUNER_WINDOW
+#define APP_TUNER_WINDOW 128u
+#endif
+
+#ifndef APP_TUNER_LAGS_PER_16
+#define APP_TUNER_LAGS_PER_16 1u
+#endif
+
+/* Frames whose RMS is under this (s16 units, ~-50 dBFS) report no pitch. */
+#ifndef APP_TUNER_MIN_LEVEL
+#define APP_TUNER_MIN_LEVEL 100u
+#endif
+
+#ifndef APP_TUNER_A4_HZ
+#define APP_TUNER_A4_HZ 440u
+#endif
+
+/* Longest lag searched, in decimated samples (the lowest note's period). */
+#define APP_TUNER_TAU_MAX \
+  (((APP_DSP_SAMPLE_RATE_HZ / APP_TUNER_DECIM) + APP_TUNER_FMIN_HZ - 1u) / APP_TUNER_FMIN_HZ)
+
+/* Static RAM share (app_profile.h): the int16 frame and the float
+ * difference function.
+ */
+#define APP_TUNER_RAM_BYTES \
+  (APP_TUNER_ENABLE ? (((APP_TUNER_WINDOW + APP_TUNER_TAU_MAX + 1u) * 2u) + ((APP_TUNER_TAU_MAX + 2u) * 4u)) : 0u)
+
+typedef enum
+{
+  APP_TUNER_OFF = 0,
+  APP_TUNER_ON,      /* detecting, output as usual */
+  APP_TUNER_MUTE,    /* detecting, output muted */
+} AppTunerMode;
+
+typedef struct
+{
+  AppTunerMode mode;
+  uint32_t seq;        /* estimates made since the tuner was switched on */
+  uint32_t freq_mhz;   /* 0 = no pitch */
+  int32_t note;        /* MIDI note (69 = A4), -1 = no pitch */
+  int32_t cents;       /* -50..+50 from that note */
+} AppTunerReading;
+
+/* Control side (main loop). */
+void AppTuner_SetMode(AppTunerMode mode);
+void AppTuner_Get(AppTunerReading *out);
+
+/* Audio side (AppDsp_ProcessBlock()): Block at the head of the chain (only
+ * the left channel is read), Muted at the block snapshot.
+ */
+void AppTuner_Block(const AppStereoS24 *x, uint32_t n);
+uint8_t AppTuner_Muted(void);
+
+/* Tuner frame for COM MEM MAP (no entries when disabled). */
+uint32_t AppTuner_MemMap(const AppMemItem **items);
+
+#if APP_TUNER_ENABLE
+#define APP_TUNER_BLOCK(x, n) AppTuner_Block((x), (n))
+#define APP_TUNER_MUTED()     AppTuner_Muted()
+#else
+#define APP_TUNER_BLOCK(x, n) do { } while (0)
+#define APP_TUNER_MUTED()     0u
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_TUNER_H */
@@ -0,0 +1,124 @@
+#ifndef APP_UAC_H
+#define APP_UAC_H
+
+#include <stdint.h>
+
+#include "app_dsp.h"
+#include "app_mem.h"
+#include "app_usb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* USB Audio Class 1 recording interface: with USB plugged in, the pedal is
+ * a 48 kHz, 24-bit, two-channel input on the host, and a DAW records what
+ * the pedal plays.
+ *
+ * The audio interrupt hands each processed block to AppUac_Block() (and
+ * the input to AppUac_DryBlock() before the chain runs on it), which packs
+ * it straight into the FIFO the packets are sent from: 3-byte little-
+ * endian samples, frames interleaved. The FIFO mirrors its first packet's
+ * worth past the end, so every packet is one contiguous read that goes
+ * directly into packet memory.
+ *
+ * The endpoint is isochronous IN, asynchronous, double buffered. The audio
+ * runs from the I2S clock (HSI), not the host's, so the device sets the
+ * rate the way an asynchronous source does: each 1 ms packet carries 47,
+ * 48 or 49 frames, chosen so the FIFO fill (averaged over ~32 ms) holds at
+ * half a DSP block above 96 frames, about 2 ms. The loop learns the offset
+ * between the clocks, so once settled the fill sits on the target; 100 ppm
+ * is one extra or missing frame every 200 ms. If the FIFO still runs dry
+ * (the audio stopped, or the host stalled), the packet is silence and the
+ * stream waits until it is filled to the target again.
+ *
+ * Channels: APP_UAC_SOURCE_WET sends the processed left and right, the
+ * signal on the output jack; APP_UAC_SOURCE_WET_DRY sends the processed
+ * left and the unprocessed left input (the DI track, for re-amping).
+ */
+#ifndef APP_UAC_ENABLE
+#define APP_UAC_ENABLE (APP_USB_ENABLE && (APP_DSP_SAMPLE_RATE_HZ == 48000u))
+#endif
+
+#if APP_UAC_ENABLE && (APP_DSP_SAMPLE_RATE_HZ != 48000u)
+#error "APP_UAC_ENABLE: the USB audio interface is described as 48 kHz"
+#endif
+
+#define APP_UAC_EP_IN          0x81u
+#define APP_UAC_CHANNELS       2u
+#define APP_UAC_SAMPLE_BYTES   3u
+#define APP_UAC_FRAME_BYTES    (APP_UAC_CHANNELS * APP_UAC_SAMPLE_BYTES)
+/* Frames per 1 ms packet: nominal and the most a packet carries. */
+#define APP_UAC_PACKET_FRAMES  48u
+#define APP_UAC_PACKET_MAX     (APP_UAC_PACKET_FRAMES + 1u)
+#define APP_UAC_EP_SIZE        (APP_UAC_PACKET_MAX * APP_UAC_FRAME_BYTES)
+
+/* Send FIFO, frames (a power of two); a build without the interface keeps
+ * a token one.
+ */
+#ifndef APP_UAC_FIFO_FRAMES
+#define APP_UAC_FIFO_FRAMES    (APP_UAC_ENABLE ? 256u : 1u)
+#endif
+
+/* Static RAM share (app_profile.h): the FIFO with its one-packet mirror
+ * (none without the interface) and the dry block of WET_DRY.
+ */
+#define APP_UAC_RAM_BYTES      (((APP_UAC_FIFO_FRAMES + (APP_UAC_ENABLE ? APP_UAC_PACKET_MAX : 0u)) * \
+                                 APP_UAC_FRAME_BYTES) + \
+                                ((APP_UAC_ENABLE ? APP_AUDIO_MAX_FRAMES_PER_HALF : 1u) * 4u))
+
+/* The streaming interface's number in the configuration. */
+#define APP_UAC_IF_CONTROL     0u
+#define APP_UAC_IF_STREAM      1u
+
+typedef enum
+{
+  APP_UAC_SOURCE_WET = 0,
+  APP_UAC_SOURCE_WET_DRY,
+  APP_UAC_SOURCE_COUNT
+} AppUacSource;
+
+/* Source at boot. */
+#ifndef APP_UAC_SOURCE
+#define APP_UAC_SOURCE APP_UAC_SOURCE_WET
+#endif
+
+typedef struct
+{
+  uint8_t streaming;         /* the host selected the streaming setting */
+  AppUacSource source;
+  uint32_t fill;             /* FIFO fill, frames */
+  uint32_t target;           /* ... it is held at */
+  uint32_t packets;          /* sent since boot */
+  uint32_t short_packets;    /* 47 frames: the codec clock runs slow */
+  uint32_t long_packets;     /* 49 frames: ... fast */
+  uint32_t underruns;        /* packets sent as silence: FIFO ran dry */
+  uint32_t overflows;        /* blocks dropped: FIFO full */
+} AppUacInfo;
+
+/* Audio interrupt (app_audio.c), every block: the input before the chain
+ * runs on it, and the output.
+ */
+void AppUac_DryBlock(const AppStereoS24 *x, uint32_t frames);
+void AppUac_Block(const AppStereoS24 *x, uint32_t frames);
+
+/* USB interrupt (app_usb.c). Setup returns 0 for a request it does not
+ * answer.
+ */
+void AppUac_Reset(void);
+uint8_t AppUac_SetInterface(uint16_t iface, uint16_t alt);
+uint8_t AppUac_GetInterface(uint16_t iface, uint8_t *alt);
+uint8_t AppUac_Setup(const AppUsbSetup *req);
+void AppUac_CtlOut(const uint8_t *data, uint16_t len);
+void AppUac_DataIn(void);
+
+/* Control side (COM USB). */
+uint8_t AppUac_SetSource(AppUacSource source);
+void AppUac_Get(AppUacInfo *out);
+uint32_t AppUac_MemMap(const AppMemItem **items);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_UAC_H */
@@ -0,0 +1,68 @@
+#ifndef APP_UPDATE_H
+#define APP_UPDATE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Field firmware update over the COM UART (COM UPDATE, then
+ * tools/dsp_host/fw_update.c on the host); no ST-LINK or MDK.
+ *
+ * The G431 has no room for a second image, so the new one is written over
+ * the running one: the updater is copied from flash into the FX arena
+ * (AppDsp_ArenaScratch()), interrupts and audio stop, and from there on it
+ * runs from RAM and calls nothing in flash. It polls USART2 at the current
+ * rate (BAUD first for speed) for frames carrying LZ4 blocks, decodes them
+ * straight into a page buffer, and a full page whose bytes differ from
+ * what flash holds is erased and programmed; an equal page is skipped. The
+ * blocks may copy from anything decoded before, which is read back from
+ * flash, so no history window is kept. At the end the CRC-32 of the
+ * written image is checked and the MCU resets into it.
+ *
+ * Only the application pages below the event log (APP_EVLOG_FLASH_ADDR)
+ * are written; the log, presets and IRs stay. An update that fails half-way stays in
+ * the updater for the host to start over; losing power then leaves a
+ * broken image, for the ST-LINK or the ROM bootloader (BOOT0) to recover.
+ * The watchdog (app_restart.h) is fed throughout.
+ *
+ * Link protocol, once the pedal has sent 'R' (all little-endian):
+ *   host:  'U' <type u8> <len u16> <payload> <crc32 of type..payload u32>
+ *          'B' <image bytes u32> <image crc32 u32>   start (or start over)
+ *          'D' <seq u8> <LZ4 block>                   next part, seq from 0
+ *          'E'                                        end: check and reset
+ *          'X'                                        reset now
+ *   pedal: 'K' taken (a repeated D frame is acked again, not decoded twice),
+ *          'E' frame damaged or timed out: send it again,
+ *          'S' out of sequence, bad block or too large: start over with B,
+ *          'C' image CRC mismatch: start over with B,
+ *          'D' done, resetting.
+ */
+#ifndef APP_UPDATE_ENABLE
+#define APP_UPDATE_ENABLE 1
+#endif
+
+/* Longest frame payload (an LZ4 block plus its seq byte). */
+#ifndef APP_UPDATE_FRAME_MAX
+#define APP_UPDATE_FRAME_MAX 1024u
+#endif
+
+/* Largest image: everything below the event log pages
+ * (APP_EVLOG_FLASH_ADDR, themselves below the cab IR pages).
+ */
+uint32_t AppUpdate_MaxBytes(void);
+
+/* 1 if an image of 'bytes' fits and this build can run the updater (the
+ * updater and its buffers fit the FX arena, armlink section symbols).
+ */
+uint8_t AppUpdate_Check(uint32_t bytes);
+
+/* Stops everything and runs the updater; returns only if Check fails. */
+void AppUpdate_Enter(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_UPDATE_H */
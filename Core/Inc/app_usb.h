@@ -0,0 +1,95 @@
+#ifndef APP_USB_H
+#define APP_USB_H
+
+#include <stdint.h>
+
+#include "app_profile.h"
+#include "stm32g4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* USB full-speed device on PA11 / PA12, clocked from HSI48, which the CRS
+ * trims to the host's start-of-frame.
+ *
+ * A small device core on the HAL PCD driver (there is no USB middleware in
+ * the tree): EP0 enumeration (device, configuration and string
+ * descriptors, SET_ADDRESS / CONFIGURATION / INTERFACE) and the class
+ * requests, which go to the function owning the interface: app_uac.c for
+ * the audio input, app_cdc.c for the virtual COM port. The device is a
+ * composite of the two, each under an interface association. Everything
+ * runs in the USB_LP interrupt, priority 1: above the DSP in PendSV, below
+ * the I2S DMA.
+ *
+ * Packet memory (1 KB, byte addresses):
+ *   0x000  buffer table
+ *   0x040  EP0 OUT, 64
+ *   0x080  EP0 IN, 64
+ *   0x0C0  EP1 IN (audio), two buffers of 296 for the isochronous double
+ *          buffer
+ *   0x310  EP2 IN (CDC notifications), 16
+ *   0x320  EP3 OUT (CDC data), 64
+ *   0x360  EP3 IN (CDC data), 64
+ *   0x3A0  free
+ */
+#ifndef APP_USB_ENABLE
+#define APP_USB_ENABLE 1
+#endif
+
+#define APP_USB_EP0_SIZE 64u
+
+typedef enum
+{
+  APP_USB_STATE_OFF = 0,     /* not started, or no bus reset seen yet */
+  APP_USB_STATE_DEFAULT,
+  APP_USB_STATE_ADDRESSED,
+  APP_USB_STATE_CONFIGURED,
+  APP_USB_STATE_SUSPENDED
+} AppUsbState;
+
+/* SETUP packet, fields in host order. */
+typedef struct
+{
+  uint8_t type;              /* bmRequestType */
+  uint8_t request;
+  uint16_t value;
+  uint16_t index;
+  uint16_t length;
+} AppUsbSetup;
+
+typedef struct
+{
+  AppUsbState state;
+  uint32_t resets;           /* bus resets */
+  uint32_t setups;           /* SETUP packets */
+  uint32_t stalls;           /* requests answered with a STALL */
+} AppUsbInfo;
+
+/* Starts the device (hpcd: set up by MX_USB_PCD_Init()). */
+void AppUsb_Init(PCD_HandleTypeDef *hpcd);
+
+/* Control side (COM USB). */
+void AppUsb_Get(AppUsbInfo *out);
+
+/* For the class code, from the USB interrupt while it answers a request.
+ * CtlSend sends a data stage (at most the length the host asked for; data
+ * must stay valid until the transfer ends), CtlRecv arms one of up to 64
+ * bytes, handed back to the class once it arrived, and CtlStatus ends a
+ * request that has no data stage.
+ */
+void AppUsb_CtlSend(const uint8_t *data, uint16_t len);
+void AppUsb_CtlRecv(uint16_t len);
+void AppUsb_CtlStatus(void);
+
+/* One packet on an IN endpoint; the data is in packet memory on return. */
+void AppUsb_Transmit(uint8_t ep, const uint8_t *data, uint16_t len);
+
+/* Arms an OUT endpoint for one packet of up to len bytes into buf. */
+void AppUsb_Receive(uint8_t ep, uint8_t *buf, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_USB_H */
@@ -0,0 +1,69 @@
+#include "app_arena.h"
+
+#include <stddef.h>
+
+/*
+ * Bump allocator.
+ * - Offsets are rounded up to 8 bytes; the pool base is the caller's (a
+ *   uint64_t array keeps it aligned).
+ * - Inside an overlay 'used' is the top of the current member and ov_top
+ *   the highest top of the members so far; ending the overlay leaves
+ *   'used' at the larger of the two.
+ */
+
+void AppArena_Init(AppArena *a, void *pool, uint32_t size)
+{
+  a->base = (uint8_t *)pool;
+  a->size = size;
+  a->used = 0u;
+  a->wanted = 0u;
+  a->ov_base = 0u;
+  a->ov_top = 0u;
+  a->ov_open = 0u;
+}
+
+void *AppArena_Alloc(AppArena *a, uint32_t bytes)
+{
+  const uint32_t off = APP_ARENA_ALIGN(a->used);
+  bytes = APP_ARENA_ALIGN(bytes);
+  if ((off > a->size) || (bytes > (a->size - off)))
+  {
+    return NULL;
+  }
+  a->used = off + bytes;
+  a->wanted += bytes;
+  return &a->base[off];
+}
+
+void AppArena_OverlayBegin(AppArena *a)
+{
+  a->ov_base = APP_ARENA_ALIGN(a->used);
+  a->ov_top = a->ov_base;
+  a->ov_open = 1u;
+}
+
+void AppArena_OverlayNext(AppArena *a)
+{
+  if (!a->ov_open)
+  {
+    return;
+  }
+  if (a->used > a->ov_top)
+  {
+    a->ov_top = a->used;
+  }
+  a->used = a->ov_base;
+}
+
+void AppArena_OverlayEnd(AppArena *a)
+{
+  if (!a->ov_open)
+  {
+    return;
+  }
+  if (a->ov_top > a->used)
+  {
+    a->used = a->ov_top;
+  }
+  a->ov_open = 0u;
+}
@@ -5,49 +5,117 @@
 #include <string.h>
 
 #include "app_dsp.h"
+#include "app_mem.h"
+#include "app_prof.h"
+#include "app_trace.h"
+#include "app_uac.h"
 
 /*
  * This file contains the "audio IO glue":
  * - I2S DMA buffers (RX from ADC, TX to DAC)
- * - RX callback: unpack -> AppDsp_ProcessFrame() -> push into ring
+ * - RX callback: unpack half-buffer -> AppDsp_ProcessBlock() -> push into ring
+ *   (by default the DMA ISR only posts the half and PendSV does the work)
  * - TX callback: adaptive resample from ring -> pack into TX DMA buffer
  *
  * The resampler exists because I2S2 and I2S3 are independent masters, so tiny
  * clock mismatch is inevitable. Without this, you'd hear periodic glitches.
+ * With APP_AUDIO_SYNC_CLOCK=1 I2S3 is a slave of I2S2's clocks instead and the
+ * RX callback writes the processed block directly into the TX half-buffer.
+ * APP_AUDIO_PIPELINE=1 goes one step further and lets TX play the RX buffer.
+ *
+ * The half-buffer size is chosen at runtime from a latency profile
+ * (AppAudio_SetLatency); buffers are sized for APP_AUDIO_MAX_FRAMES_PER_HALF.
  */
 
 /* Audio format:
  * - I2S left-justified (I2S_STANDARD_MSB)
  * - 24-bit sample in 32-bit slot
- * - HAL I2S uses a uint16_t DMA buffer; each 32-bit slot is 2 halfwords.
+ * - HAL I2S uses a uint16_t DMA buffer; each 32-bit slot is 2 halfwords,
+ *   MSB half first. The buffers are declared as uint32_t so the CPU reads
+ *   and writes whole slots; one ROR #16 puts the halves in order.
  */
 
 #define AUDIO_CHANNELS                 2U
-#define AUDIO_FRAMES_PER_HALF          64U
-#define AUDIO_HALFWORDS_PER_SAMPLE32   2U
-#define AUDIO_HALFWORDS_PER_FRAME      (AUDIO_CHANNELS * AUDIO_HALFWORDS_PER_SAMPLE32)
-#define AUDIO_HALFWORDS_PER_HALF       (AUDIO_FRAMES_PER_HALF * AUDIO_HALFWORDS_PER_FRAME)
-#define AUDIO_HALFWORDS_TOTAL          (2U * AUDIO_HALFWORDS_PER_HALF)
+#define AUDIO_MAX_FRAMES_PER_HALF      APP_AUDIO_MAX_FRAMES_PER_HALF
+#define AUDIO_WORDS_PER_FRAME          AUDIO_CHANNELS
+#define AUDIO_WORDS_TOTAL              (2U * AUDIO_MAX_FRAMES_PER_HALF * AUDIO_WORDS_PER_FRAME)
+
+#if ((AUDIO_MAX_FRAMES_PER_HALF & (AUDIO_MAX_FRAMES_PER_HALF - 1U)) != 0U)
+#error "APP_AUDIO_MAX_FRAMES_PER_HALF must be a power of two"
+#endif
 
-/* Size parameter for HAL_I2S_{Receive,Transmit}_DMA(): number of 24/32-bit data lengths */
-#define I2S_DMA_SIZE_SAMPLE32_TOTAL    (AUDIO_HALFWORDS_TOTAL / AUDIO_HALFWORDS_PER_SAMPLE32)
+/* Frames per half-buffer for each AppAudioLatency profile. */
+static const uint16_t k_latency_frames[APP_AUDIO_LATENCY_COUNT] = {16U, 32U, 64U, 128U};
+
+static volatile AppAudioLatency s_latency = APP_AUDIO_LATENCY_DEFAULT;
+static volatile uint32_t s_frames_per_half = 64U;
+static volatile uint32_t s_ring_target = 128U;
 
 static I2S_HandleTypeDef *s_rx_i2s = NULL;
 static I2S_HandleTypeDef *s_tx_i2s = NULL;
 
-static uint16_t s_i2s_rx_buf[AUDIO_HALFWORDS_TOTAL];
-static uint16_t s_i2s_tx_buf[AUDIO_HALFWORDS_TOTAL];
+APP_DMA_BSS static uint32_t s_i2s_rx_buf[AUDIO_WORDS_TOTAL];
+#if APP_AUDIO_PIPELINE
+/* TX DMA reads the processed RX halves in place. */
+#define s_i2s_tx_buf                   s_i2s_rx_buf
+static volatile uint32_t s_tx_started = 0;
+#else
+APP_DMA_BSS static uint32_t s_i2s_tx_buf[AUDIO_WORDS_TOTAL];
+#endif
+
+static volatile uint32_t s_ring_underrun = 0;
+static volatile uint32_t s_ring_overflow = 0;
 
-/* Must be power-of-two for fast wrap. */
-#define AUDIO_RING_FRAMES              256U
+#if !APP_AUDIO_SYNC_CLOCK
+/* Must be power-of-two for fast wrap (256 frames for 64-frame halves). */
+#define AUDIO_RING_FRAMES              (4U * AUDIO_MAX_FRAMES_PER_HALF)
 #define AUDIO_RING_MASK                (AUDIO_RING_FRAMES - 1U)
 
-static int32_t s_ring_l[AUDIO_RING_FRAMES];
-static int32_t s_ring_r[AUDIO_RING_FRAMES];
+/* Frames the writer keeps clear behind the read index (FIR taps look back 3). */
+#define AUDIO_RING_GUARD_FRAMES        4U
+
+static AppStereoS24 s_ring[AUDIO_RING_FRAMES];
+/* Single-producer/single-consumer: the RX side (producer) is the only writer
+ * of s_ring_w and s_ring_overflow, the TX fill (consumer) the only writer of
+ * s_ring_r_q16. Each index is published with one aligned 32-bit store after
+ * the data it covers, so neither side needs IRQ masking or LDREX/STREX.
+ */
 static volatile uint32_t s_ring_w = 0;       /* frame index */
 static volatile uint32_t s_ring_r_q16 = 0;   /* Q16.16 frame index */
-static volatile uint32_t s_ring_underrun = 0;
-static volatile uint32_t s_ring_overflow = 0;
+static uint32_t s_ring_overflow_seen = 0;    /* consumer's copy of s_ring_overflow */
+static volatile uint32_t s_ring_peak = 0;    /* highest fill the producer saw (COM MEM) */
+static int32_t s_fill_err_filt = 0;
+static int32_t s_pi_integ_q12 = 0;
+
+/* Both I2S masters divide the same kernel clock by the same ratio (checked
+ * at each start): no drift, the TX fill copies the ring (tx_copy_half()).
+ */
+static volatile uint32_t s_rate_exact = 0;
+
+/* Drift telemetry (see AppAudio_GetClock). */
+#if APP_AUDIO_RING_ADAPT
+/* Adaptive target (ring_adapt()): written by the TX fill while running and
+ * by AppAudio_Start() while stopped.
+ */
+static volatile uint32_t s_rt_floor = 0;
+static volatile uint32_t s_rt_ceil = 0;
+static volatile uint32_t s_rt_low = 0;
+static uint32_t s_rt_hold = 0;          /* halves per step down */
+static uint32_t s_rt_halves = 0;
+static uint32_t s_rt_underrun_seen = 0;
+#endif
+
+static volatile int32_t s_rs_step_q16 = 65536;
+static volatile int32_t s_rs_est_min_q12 = 0;
+static volatile int32_t s_rs_est_max_q12 = 0;
+static volatile uint32_t s_rs_limit_hits = 0;
+static volatile uint32_t s_rs_clamped = 0;
+#endif
+
+static volatile AppAudioResampler s_resampler = APP_AUDIO_RESAMPLER_DEFAULT;
+
+/* Scratch for one half-buffer, handed to the DSP as a block. */
+static AppStereoS24 s_blk[AUDIO_MAX_FRAMES_PER_HALF];
 
 static volatile uint32_t s_audio_overrun_count = 0;
 static volatile uint32_t s_audio_start_fail = 0;
@@ -55,39 +123,180 @@ static volatile uint32_t s_audio_runtime_fail = 0;
 static volatile uint32_t s_audio_started = 0;
 static volatile uint32_t s_audio_start_tx_status = 0;
 static volatile uint32_t s_audio_start_rx_status = 0;
+static uint32_t s_audio_paused = 0;   /* AppAudio_Pause() stopped running streams */
 
-static inline uint32_t ring_fill_frames(uint32_t w, uint32_t r_int)
+/* Gain ramp after every (re)start, Q16 (65536 = unity, ramp done). */
+#define AUDIO_FADE_UNITY               65536U
+#define AUDIO_FADE_STEP                (AUDIO_FADE_UNITY / (APP_AUDIO_RECOVER_FADE_MS * (APP_AUDIO_SAMPLE_RATE_HZ / 1000U)))
+static volatile uint32_t s_fade_q16 = AUDIO_FADE_UNITY;
+
+/* I2S errors: the ISRs log an incident and raise s_recover_pending, the
+ * main loop restarts the streams (AppAudio_Poll). Further errors before the
+ * restart belong to the same incident and are only counted.
+ */
+static volatile uint32_t s_recover_pending = 0;
+static uint32_t s_recover_cyc = 0;    /* DWT at the error */
+static volatile uint32_t s_recoveries = 0;
+static volatile uint32_t s_glitch_us = 0;
+static AppAudioErrEvent s_err_log[APP_AUDIO_ERR_LOG_LEN];
+static volatile uint32_t s_err_seq = 0;
+static volatile uint32_t s_tx_sr_armed = 0;
+
+#if APP_AUDIO_DEFER_DSP
+/* RX DMA ISR -> PendSV handoff without IRQ masking: the ISR publishes
+ * (post count << 1 | half) in one word, PendSV keeps its own done count.
+ */
+static volatile uint32_t s_rx_post = 0;
+static uint32_t s_rx_done = 0;
+#endif
+static volatile uint32_t s_dsp_late = 0;
+
+/* Deadline misses (APP_AUDIO_MISS_REPEAT). s_rx_late makes the next half a
+ * repeat of s_blk; s_join fades the block after it in from the last frame.
+ */
+static volatile uint32_t s_deadline_miss = 0;
+static uint32_t s_rx_late = 0;
+static uint32_t s_join = 0;
+static AppStereoS24 s_blk_last;
+
+#if APP_AUDIO_JITTER
+/* Callback jitter per stream (0 = RX, 1 = TX): the previous stamp and the
+ * deviation histogram. The nominal period is taken at each start.
+ */
+typedef struct
 {
-  return (w - r_int) & AUDIO_RING_MASK;
+  uint32_t last;
+  uint32_t armed;     /* last is a stamp of this run */
+  AppAudioJitter st;
+} AudioJitter;
+
+static AudioJitter s_jit[2];
+static uint32_t s_jit_period = 0;     /* cycles */
+static uint32_t s_jit_cyc_us = 1;
+#endif
+
+#define AUDIO_TX_ALIGN                 (APP_AUDIO_TX_ALIGN && !APP_AUDIO_SYNC_CLOCK)
+
+#if AUDIO_TX_ALIGN
+/* TX start held back (APP_AUDIO_TX_ALIGN): RX blocks still to measure, 0
+ * once TX runs; the latest RX DMA event and the longest event-to-ring time.
+ */
+static uint32_t s_align_wait = 0;
+static uint32_t s_align_land_max = 0;
+static uint32_t s_rx_event_cyc = 0;
+static volatile uint32_t s_tx_lead_us = 0;
+#endif
+
+#if (APP_AUDIO_JOIN_FRAMES == 0U) || (APP_AUDIO_JOIN_FRAMES > 16U)
+#error "APP_AUDIO_JOIN_FRAMES must be 1..16 (the LOW latency profile)"
+#endif
+
+#if APP_AUDIO_LTEST_ENABLE
+/* Latency test. The whole state machine runs in process_rx_half(); the main
+ * loop only starts it and reads the results once the state has left
+ * RUNNING (published last).
+ */
+#define LTEST_FRAMES_MS(ms)            ((APP_AUDIO_SAMPLE_RATE_HZ / 1000U) * (ms))
+#define LTEST_SETTLE_FRAMES            LTEST_FRAMES_MS(50U)   /* silence before the first impulse */
+#define LTEST_GAP_FRAMES               LTEST_FRAMES_MS(50U)   /* between impulses: let the return ring out */
+#define LTEST_TIMEOUT_FRAMES           LTEST_FRAMES_MS(100U)  /* the largest profile is ~11 ms */
+#define LTEST_PEAK_FRAMES              32U                    /* peak search after the threshold crossing */
+#define LTEST_IMPULSE                  (1 << 22)              /* -6 dBFS */
+#define LTEST_THRESH_MIN               (1 << 15)              /* -48 dBFS */
+
+typedef enum
+{
+  LTEST_PHASE_QUIET = 0,  /* settle / gap: measure the noise, wait for s_lt_next */
+  LTEST_PHASE_LISTEN      /* impulse out at s_lt_emit, looking for it */
+} LtestPhase;
+
+static volatile AppAudioLtestState s_lt_state = APP_AUDIO_LTEST_IDLE;
+static LtestPhase s_lt_phase = LTEST_PHASE_QUIET;
+static uint32_t s_lt_pos = 0;       /* RX frame index of the current block */
+static uint32_t s_lt_next = 0;      /* QUIET: frame index of the next impulse */
+static uint32_t s_lt_emit = 0;
+static uint32_t s_lt_emit_cyc = 0;
+static uint32_t s_lt_hit = 0;       /* LISTEN: threshold crossed, s_lt_hit_end ends the peak search */
+static uint32_t s_lt_hit_end = 0;
+static uint32_t s_lt_peak_pos = 0;
+static int32_t s_lt_thresh = 0;
+static uint32_t s_lt_late0 = 0;
+static uint32_t s_lt_sum = 0;
+static uint32_t s_lt_cyc_sum = 0;
+static AppAudioLtest s_lt;
+#endif
+
+#if APP_AUDIO_ITEST_ENABLE
+#define ITEST_FNV_BASIS                2166136261U
+#define ITEST_FNV_PRIME                16777619U
+
+static volatile AppAudioItestState s_it_state = APP_AUDIO_ITEST_IDLE;
+static uint32_t s_it_armed = 0;     /* set up, starts with the restart */
+static uint32_t s_it_phase = 0;     /* pattern saw */
+static uint32_t s_it_rng = 1;
+static AppAudioItest s_it;
+static AppAudioItest s_it0;         /* the counters at the first block */
+#endif
+
+/* ISR timing in DWT cycles. Averages are one-pole smoothed (1/16). */
+static volatile uint32_t s_rx_avg_cycles = 0;
+static volatile uint32_t s_rx_max_cycles = 0;
+static volatile uint32_t s_tx_avg_cycles = 0;
+static volatile uint32_t s_tx_max_cycles = 0;
+static volatile uint32_t s_isr_max_cycles = 0;
+
+static inline void isr_time_update(uint32_t cycles, volatile uint32_t *avg, volatile uint32_t *max)
+{
+  int32_t a = (int32_t)*avg;
+  a += ((int32_t)cycles - a) >> 4;
+  *avg = (uint32_t)a;
+  if (cycles > *max) *max = cycles;
+  if (cycles > s_isr_max_cycles) s_isr_max_cycles = cycles;
+}
+
+/* Signed 24-bit sample from a left-justified 24-in-32 DMA slot. */
+static inline int32_t lj24in32_to_s24(uint32_t slot)
+{
+  return ((int32_t)__ROR(slot, 16U)) >> 8;
+}
+
+/* Saturated signed 24-bit sample to a left-justified 24-in-32 DMA slot. */
+static inline uint32_t s24_to_lj24in32(int32_t s24)
+{
+  return __ROR((uint32_t)__SSAT(s24, 24U) << 8, 16U);
 }
 
-static inline int32_t clamp_s24(int32_t x)
+/* Whole half-buffer: DMA slots <-> s24 frames (same L/R order). */
+static void lj24_unpack_block(const uint32_t *src, AppStereoS24 *x, uint32_t frames)
 {
-  if (x > 8388607) return 8388607;
-  if (x < -8388608) return -8388608;
-  return x;
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    x[i].l = lj24in32_to_s24(src[0]);
+    x[i].r = lj24in32_to_s24(src[1]);
+    src += AUDIO_WORDS_PER_FRAME;
+  }
 }
 
-/* Extract signed 24-bit sample from left-justified 24-in-32 slot (two halfwords). */
-static inline int32_t lj24in32_to_s24(const uint16_t *p)
+static void lj24_pack_block(uint32_t *dst, const AppStereoS24 *x, uint32_t frames)
 {
-  uint32_t w = ((uint32_t)p[0] << 16) | (uint32_t)p[1];
-  return ((int32_t)w) >> 8;
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    dst[0] = s24_to_lj24in32(x[i].l);
+    dst[1] = s24_to_lj24in32(x[i].r);
+    dst += AUDIO_WORDS_PER_FRAME;
+  }
 }
 
-/* Pack signed 24-bit sample into left-justified 24-in-32 slot (two halfwords). */
-static inline void s24_to_lj24in32(uint16_t *p, int32_t s24)
+#if !APP_AUDIO_SYNC_CLOCK
+static inline uint32_t ring_fill_frames(uint32_t w, uint32_t r_int)
 {
-  int32_t x = clamp_s24(s24);
-  uint32_t w = (uint32_t)(x << 8);
-  p[0] = (uint16_t)(w >> 16);
-  p[1] = (uint16_t)(w & 0xFFFFU);
+  return (w - r_int) & AUDIO_RING_MASK;
 }
 
-static inline void ring_push_frames_s24(int32_t l, int32_t r)
+static inline void ring_push_frame_s24(const AppStereoS24 *f)
 {
   /* IMPORTANT:
-   * This function is called at audio rate (64 frames per half-buffer).
+   * This function is called at audio rate (once per frame of every half-buffer).
    * Disabling global IRQs here can starve UART RX interrupts and make COM
    * commands (FXMASK/PSET) feel slow or get corrupted.
    *
@@ -100,200 +309,1752 @@ static inline void ring_push_frames_s24(int32_t l, int32_t r)
   uint32_t r_int = s_ring_r_q16 >> 16;
   uint32_t fill = ring_fill_frames(w, r_int);
 
-  /* Ensure at least 2 frames of headroom to allow interpolation at the read side. */
-  if (fill >= (AUDIO_RING_FRAMES - 2U))
+  if (fill > s_ring_peak)
+  {
+    s_ring_peak = fill;
+  }
+
+  /* Keep headroom behind the read index for the interpolator's past taps.
+   * When full, drop the new frame and signal the consumer, which owns the
+   * read index and re-centres it on its next fill.
+   */
+  if (fill >= (AUDIO_RING_FRAMES - AUDIO_RING_GUARD_FRAMES))
   {
-    /* Best-effort drop: may race with TX callback but is safe. */
-    s_ring_r_q16 += (1U << 16);
     s_ring_overflow++;
+    return;
   }
 
-  s_ring_l[w] = l;
-  s_ring_r[w] = r;
+  s_ring[w] = *f;
   __DMB();
   s_ring_w = (w + 1U) & AUDIO_RING_MASK;
 }
 
-static void tx_fill_half(uint32_t half_index)
+/* Drift controller: PI on the smoothed fill error, in Q16 step units
+ * (1 frame of error -> 1/65536 ratio, ~15 ppm). The one-pole smoothing
+ * hides the block-sized jumps of the fill level; the integrator removes the
+ * steady-state offset a plain P loop needs to hold a ppm mismatch.
+ * Gains give a damping of ~0.7 at 64 frames per half.
+ */
+#define RESAMPLER_STEP_LIMIT_Q16       128     /* +/-0.20% */
+#define RESAMPLER_PI_KP_Q8             512     /* 2.0 */
+#define RESAMPLER_PI_KI_Q12            4       /* ~0.001 per half-buffer */
+
+/* 8-tap windowed-sinc (Blackman) phases in Q15, taps at -3..+4 around idx0.
+ * Each row sums to 32768; rows 0 and 32 are the identity at idx0 / idx0+1,
+ * so the blend between neighbouring rows never needs a wrap.
+ */
+#define RESAMPLER_FIR_TAPS             8U
+#define RESAMPLER_FIR_PHASES           32U
+
+static const int32_t k_rs_fir_q15[RESAMPLER_FIR_PHASES + 1U][RESAMPLER_FIR_TAPS] = {
+  {     0,      0,      0,  32768,      0,      0,      0,      0},
+  {   -21,    165,   -754,  32706,    830,   -183,     25,      0},
+  {   -38,    312,  -1432,  32523,   1733,   -383,     53,      0},
+  {   -52,    440,  -2034,  32222,   2707,   -600,     85,      0},
+  {   -63,    549,  -2560,  31803,   3750,   -831,    121,     -1},
+  {   -71,    641,  -3011,  31269,   4857,  -1076,    161,     -2},
+  {   -76,    715,  -3389,  30625,   6024,  -1332,    204,     -3},
+  {   -78,    773,  -3696,  29875,   7246,  -1597,    250,     -5},
+  {   -79,    814,  -3935,  29029,   8516,  -1869,    299,     -7},
+  {   -78,    841,  -4109,  28087,   9830,  -2144,    351,    -10},
+  {   -75,    854,  -4223,  27062,  11178,  -2419,    404,    -13},
+  {   -72,    855,  -4278,  25958,  12555,  -2691,    458,    -17},
+  {   -67,    845,  -4281,  24782,  13952,  -2955,    513,    -21},
+  {   -62,    825,  -4236,  23548,  15360,  -3208,    567,    -26},
+  {   -56,    796,  -4146,  22261,  16771,  -3446,    620,    -32},
+  {   -50,    760,  -4018,  20930,  18176,  -3663,    671,    -38},
+  {   -44,    718,  -3855,  19565,  19565,  -3855,    718,    -44},
+  {   -38,    671,  -3663,  18176,  20930,  -4018,    760,    -50},
+  {   -32,    620,  -3446,  16771,  22261,  -4146,    796,    -56},
+  {   -26,    567,  -3208,  15360,  23548,  -4236,    825,    -62},
+  {   -21,    513,  -2955,  13952,  24782,  -4281,    845,    -67},
+  {   -17,    458,  -2691,  12555,  25958,  -4278,    855,    -72},
+  {   -13,    404,  -2419,  11178,  27062,  -4223,    854,    -75},
+  {   -10,    351,  -2144,   9830,  28087,  -4109,    841,    -78},
+  {    -7,    299,  -1869,   8516,  29029,  -3935,    814,    -79},
+  {    -5,    250,  -1597,   7246,  29875,  -3696,    773,    -78},
+  {    -3,    204,  -1332,   6024,  30625,  -3389,    715,    -76},
+  {    -2,    161,  -1076,   4857,  31269,  -3011,    641,    -71},
+  {    -1,    121,   -831,   3750,  31803,  -2560,    549,    -63},
+  {     0,     85,   -600,   2707,  32222,  -2034,    440,    -52},
+  {     0,     53,   -383,   1733,  32523,  -1432,    312,    -38},
+  {     0,     25,   -183,    830,  32706,   -754,    165,    -21},
+  {     0,      0,      0,      0,  32768,      0,      0,      0},
+};
+
+/* Frames needed at and after idx0 for each engine. */
+static const uint8_t k_rs_lookahead[APP_AUDIO_RESAMPLER_COUNT] = {2U, 3U, 5U};
+
+static inline int32_t mul_q31(int32_t a, int32_t b_q31)
 {
-  uint32_t base = half_index ? AUDIO_HALFWORDS_PER_HALF : 0U;
-  uint16_t *tx = &s_i2s_tx_buf[base];
+  return (int32_t)(((int64_t)a * (int64_t)b_q31) >> 31);
+}
 
-  /* Target fill around half the ring. */
-  const int32_t target = (int32_t)(AUDIO_RING_FRAMES / 2U);
-  const int32_t step_base_q16 = (1 << 16);
-  const int32_t step_limit = 128; /* +/-0.20% */
+static inline int32_t rs_lerp(int32_t y0, int32_t y1, uint32_t frac)
+{
+  /* (y1 - y0) * frac >> 16, taken from the high word of one SMULL. */
+  return y0 + (int32_t)(((int64_t)((y1 - y0) * 2) * (int64_t)(frac << 15)) >> 32);
+}
 
-  static int32_t fill_err_filt = 0;
+static inline AppStereoS24 rs_linear(const AppStereoS24 *ring, uint32_t i0, uint32_t frac)
+{
+  AppStereoS24 y0 = ring[i0];
+  AppStereoS24 y1 = ring[(i0 + 1U) & AUDIO_RING_MASK];
+  AppStereoS24 out = {rs_lerp(y0.l, y1.l, frac), rs_lerp(y0.r, y1.r, frac)};
+  return out;
+}
 
-  uint32_t primask = __get_PRIMASK();
-  __disable_irq();
-  uint32_t w_snapshot = s_ring_w;
-  uint32_t r_q16 = s_ring_r_q16;
-  if (!primask)
-  {
-    __enable_irq();
-  }
+static inline int32_t rs_catmull_rom(int32_t ym1, int32_t y0, int32_t y1, int32_t y2, int32_t t)
+{
+  /* Horner form with t in Q31. */
+  int32_t d = y0 - y1;
+  int32_t c1 = (y1 - ym1) >> 1;
+  int32_t c2 = ym1 - (2 * y0) - (y0 >> 1) + (2 * y1) - (y2 >> 1);
+  int32_t c3 = ((y2 - ym1) >> 1) + d + (d >> 1);
 
-  uint32_t r_int = r_q16 >> 16;
-  int32_t fill = (int32_t)ring_fill_frames(w_snapshot, r_int);
+  return y0 + mul_q31(c1 + mul_q31(c2 + mul_q31(c3, t), t), t);
+}
 
-  int32_t err = (fill - target);
-  fill_err_filt += (err - fill_err_filt) >> 4;
+static inline AppStereoS24 rs_hermite(const AppStereoS24 *ring, uint32_t i0, uint32_t frac)
+{
+  AppStereoS24 ym1 = ring[(i0 - 1U) & AUDIO_RING_MASK];
+  AppStereoS24 y0 = ring[i0];
+  AppStereoS24 y1 = ring[(i0 + 1U) & AUDIO_RING_MASK];
+  AppStereoS24 y2 = ring[(i0 + 2U) & AUDIO_RING_MASK];
+  int32_t t = (int32_t)(frac << 15);
+
+  AppStereoS24 out = {rs_catmull_rom(ym1.l, y0.l, y1.l, y2.l, t), rs_catmull_rom(ym1.r, y0.r, y1.r, y2.r, t)};
+  return out;
+}
+
+static inline int32_t rs_fir_blend(int64_t acc_a, int64_t acc_b, uint32_t frac)
+{
+  int32_t ya = (int32_t)(acc_a >> 15);
+  int32_t yb = (int32_t)(acc_b >> 15);
+  return ya + (int32_t)(((int64_t)(yb - ya) * (int64_t)(frac & 0x7FFU)) >> 11);
+}
+
+static inline AppStereoS24 rs_fir(const AppStereoS24 *ring, uint32_t i0, uint32_t frac)
+{
+  /* Evaluate the two neighbouring phases and blend them linearly. */
+  const int32_t *ha = k_rs_fir_q15[frac >> 11];
+  const int32_t *hb = ha + RESAMPLER_FIR_TAPS;
+  uint32_t i = i0 - 3U;
+  int64_t acc_al = 0;
+  int64_t acc_bl = 0;
+  int64_t acc_ar = 0;
+  int64_t acc_br = 0;
+  for (uint32_t k = 0; k < RESAMPLER_FIR_TAPS; k++)
+  {
+    AppStereoS24 x = ring[(i + k) & AUDIO_RING_MASK];
+    acc_al += (int64_t)x.l * ha[k];
+    acc_bl += (int64_t)x.l * hb[k];
+    acc_ar += (int64_t)x.r * ha[k];
+    acc_br += (int64_t)x.r * hb[k];
+  }
+  AppStereoS24 out = {rs_fir_blend(acc_al, acc_bl, frac), rs_fir_blend(acc_ar, acc_br, frac)};
+  return out;
+}
 
-  int32_t step_q16 = step_base_q16 + fill_err_filt;
-  if (step_q16 < (step_base_q16 - step_limit)) step_q16 = (step_base_q16 - step_limit);
-  if (step_q16 > (step_base_q16 + step_limit)) step_q16 = (step_base_q16 + step_limit);
+/* Inner loop, instantiated once per engine so the per-frame path has no
+ * engine dispatch.
+ */
+__STATIC_FORCEINLINE uint32_t resample_frames(AppAudioResampler engine,
+                                              uint32_t *tx,
+                                              uint32_t frames,
+                                              uint32_t r_q16,
+                                              uint32_t step_q16,
+                                              uint32_t w_snapshot)
+{
+  const uint32_t need = k_rs_lookahead[engine];
 
-  for (uint32_t frame = 0; frame < AUDIO_FRAMES_PER_HALF; frame++)
+  for (uint32_t frame = 0; frame < frames; frame++)
   {
     uint32_t idx0 = (r_q16 >> 16) & AUDIO_RING_MASK;
-    uint32_t idx1 = (idx0 + 1U) & AUDIO_RING_MASK;
     uint32_t frac = r_q16 & 0xFFFFU;
 
-    /* Need at least 2 frames buffered for interpolation.
-     * Use the initial write-pointer snapshot to avoid per-frame IRQ masking.
+    /* Use the initial write-pointer snapshot to avoid per-frame IRQ masking.
      * This is conservative (writer may advance after snapshot) and ensures we
      * never read beyond what was available when the fill started.
      */
     uint32_t have = ring_fill_frames(w_snapshot, (r_q16 >> 16));
 
-    int32_t l_out = 0;
-    int32_t r_out = 0;
-    if (have >= 2U)
+    AppStereoS24 out = {0, 0};
+    if (have >= need)
     {
-      int32_t l0 = s_ring_l[idx0];
-      int32_t l1 = s_ring_l[idx1];
-      int32_t r0s = s_ring_r[idx0];
-      int32_t r1s = s_ring_r[idx1];
-
-      l_out = l0 + (int32_t)(((int64_t)(l1 - l0) * (int64_t)frac) >> 16);
-      r_out = r0s + (int32_t)(((int64_t)(r1s - r0s) * (int64_t)frac) >> 16);
+      if (engine == APP_AUDIO_RESAMPLER_FIR)
+      {
+        out = rs_fir(s_ring, idx0, frac);
+      }
+      else if (engine == APP_AUDIO_RESAMPLER_HERMITE)
+      {
+        out = rs_hermite(s_ring, idx0, frac);
+      }
+      else
+      {
+        out = rs_linear(s_ring, idx0, frac);
+      }
     }
     else
     {
       s_ring_underrun++;
     }
 
-    uint32_t o = frame * AUDIO_HALFWORDS_PER_FRAME;
-    s24_to_lj24in32(&tx[o + 0], l_out);
-    s24_to_lj24in32(&tx[o + 2], r_out);
+    uint32_t o = frame * AUDIO_WORDS_PER_FRAME;
+    tx[o + 0] = s24_to_lj24in32(out.l);
+    tx[o + 1] = s24_to_lj24in32(out.r);
 
-    r_q16 += (uint32_t)step_q16;
+    r_q16 += step_q16;
   }
 
-  uint32_t primask3 = __get_PRIMASK();
-  __disable_irq();
-  s_ring_r_q16 = r_q16;
-  if (!primask3)
+  return r_q16;
+}
+
+#if APP_AUDIO_RING_ADAPT
+/* Once per TX half, before the fill error is taken: steps the target down
+ * after a quiet hold and up after an underrun. The drift loop slews the
+ * read position to a new target; a step is small enough to stay inside
+ * its rate limit for a few hundred frames.
+ */
+static void ring_adapt(uint32_t frames)
+{
+  uint32_t target = s_ring_target;
+  uint32_t underrun = s_ring_underrun;
+
+  if (underrun != s_rt_underrun_seen)
   {
-    __enable_irq();
+    s_rt_underrun_seen = underrun;
+    if ((target + APP_AUDIO_RING_ADAPT_STEP) > s_rt_low)
+    {
+      s_rt_low = target + APP_AUDIO_RING_ADAPT_STEP;
+    }
+    target += frames / 2U;
+    s_rt_halves = 0;
+  }
+  else if (++s_rt_halves >= s_rt_hold)
+  {
+    s_rt_halves = 0;
+    if (target >= (s_rt_low + APP_AUDIO_RING_ADAPT_STEP))
+    {
+      target -= APP_AUDIO_RING_ADAPT_STEP;
+    }
   }
+
+  if (target > s_rt_ceil) target = s_rt_ceil;
+  if (s_rt_low > s_rt_ceil) s_rt_low = s_rt_ceil;
+  s_ring_target = target;
 }
+#endif
 
-static void process_rx_half(uint32_t half_index)
+/* Identical rates: each TX half takes exactly the frames one RX half
+ * brought, bit for bit. The fill stays where the start put it; only an
+ * underrun or overflow moves the reader, back to the target fill.
+ */
+static void tx_copy_half(uint32_t *tx, uint32_t frames)
 {
-  uint32_t base = half_index ? AUDIO_HALFWORDS_PER_HALF : 0U;
-  const uint16_t *rx = &s_i2s_rx_buf[base];
+  uint32_t w_snapshot = s_ring_w;
+  __DMB(); /* samples up to w_snapshot are visible before we read them */
+  uint32_t r = s_ring_r_q16 >> 16;
 
-  for (uint32_t frame = 0; frame < AUDIO_FRAMES_PER_HALF; frame++)
+  uint32_t overflow = s_ring_overflow;
+  if (overflow != s_ring_overflow_seen)
   {
-    uint32_t o = frame * AUDIO_HALFWORDS_PER_FRAME;
-
-    int32_t l = lj24in32_to_s24(&rx[o + 0]);
-    int32_t r = lj24in32_to_s24(&rx[o + 2]);
+    s_ring_overflow_seen = overflow;
+    r = (w_snapshot - s_ring_target) & AUDIO_RING_MASK;
+    APP_TRACE(APP_TRACE_OVERFLOW, 0U);
+  }
+  else if (ring_fill_frames(w_snapshot, r) < frames)
+  {
+    s_ring_underrun++;
+    APP_TRACE(APP_TRACE_UNDERRUN, frames - ring_fill_frames(w_snapshot, r));
+    r = (w_snapshot - s_ring_target) & AUDIO_RING_MASK;
+  }
 
-    AppDsp_ProcessFrame(&l, &r);
-    ring_push_frames_s24(l, r);
+  for (uint32_t frame = 0; frame < frames; frame++)
+  {
+    const AppStereoS24 *f = &s_ring[(r + frame) & AUDIO_RING_MASK];
+    uint32_t o = frame * AUDIO_WORDS_PER_FRAME;
+    tx[o + 0] = s24_to_lj24in32(f->l);
+    tx[o + 1] = s24_to_lj24in32(f->r);
   }
-}
 
-void AppAudio_Init(I2S_HandleTypeDef *rx_i2s, I2S_HandleTypeDef *tx_i2s)
-{
-  s_rx_i2s = rx_i2s;
-  s_tx_i2s = tx_i2s;
+  s_ring_r_q16 = ((r + frames) & AUDIO_RING_MASK) << 16;
 }
 
-void AppAudio_Start(void)
+static void tx_fill_half(uint32_t half_index)
 {
-  if ((s_rx_i2s == NULL) || (s_tx_i2s == NULL))
+  const uint32_t frames = s_frames_per_half;
+  uint32_t base = half_index ? (frames * AUDIO_WORDS_PER_FRAME) : 0U;
+  uint32_t *tx = &s_i2s_tx_buf[base];
+
+  if (s_rate_exact)
   {
-    s_audio_start_fail = 1;
-    s_audio_runtime_fail = 1;
-    s_audio_started = 0;
+    tx_copy_half(tx, frames);
     return;
   }
 
-  memset(s_i2s_rx_buf, 0, sizeof(s_i2s_rx_buf));
-  memset(s_i2s_tx_buf, 0, sizeof(s_i2s_tx_buf));
+#if APP_AUDIO_RING_ADAPT
+  ring_adapt(frames);
+#endif
 
-  s_ring_w = 0;
-  s_ring_r_q16 = 0;
-  s_ring_underrun = 0;
-  s_ring_overflow = 0;
-  s_audio_runtime_fail = 0;
+  /* Target fill: two half-buffers (half the ring at the largest size), or
+   * wherever ring_adapt() has taken it.
+   */
+  const int32_t target = (int32_t)s_ring_target;
+  const int32_t step_base_q16 = (1 << 16);
+  const int32_t step_limit = RESAMPLER_STEP_LIMIT_Q16;
 
-  /* TX first so DAC sees continuous clocks/data; buffer is initially zeros. */
-  s_audio_start_tx_status = (uint32_t)HAL_I2S_Transmit_DMA(s_tx_i2s, s_i2s_tx_buf, (uint16_t)I2S_DMA_SIZE_SAMPLE32_TOTAL);
-  s_audio_start_rx_status = (uint32_t)HAL_I2S_Receive_DMA(s_rx_i2s, s_i2s_rx_buf, (uint16_t)I2S_DMA_SIZE_SAMPLE32_TOTAL);
+  uint32_t w_snapshot = s_ring_w;
+  __DMB(); /* samples up to w_snapshot are visible before we read them */
+  uint32_t r_q16 = s_ring_r_q16;
 
-  if ((s_audio_start_tx_status != (uint32_t)HAL_OK) || (s_audio_start_rx_status != (uint32_t)HAL_OK))
+  uint32_t overflow = s_ring_overflow;
+  if (overflow != s_ring_overflow_seen)
   {
-    s_audio_start_fail = 1;
-    s_audio_runtime_fail = 1;
-    s_audio_started = 0;
-    return;
+    /* Producer hit the guard: jump back to the target fill. */
+    s_ring_overflow_seen = overflow;
+    r_q16 = ((w_snapshot - s_ring_target) & AUDIO_RING_MASK) << 16;
+    APP_TRACE(APP_TRACE_OVERFLOW, 0U);
   }
 
-  s_audio_start_fail = 0;
-  s_audio_started = 1;
+  uint32_t r_int = r_q16 >> 16;
+  int32_t fill = (int32_t)ring_fill_frames(w_snapshot, r_int);
+
+  int32_t err = (fill - target);
+  s_fill_err_filt += (err - s_fill_err_filt) >> 4;
+
+  /* Clamp the integrator to the step range (anti-windup). */
+  s_pi_integ_q12 += RESAMPLER_PI_KI_Q12 * s_fill_err_filt;
+  if (s_pi_integ_q12 > (step_limit << 12)) s_pi_integ_q12 = (step_limit << 12);
+  if (s_pi_integ_q12 < -(step_limit << 12)) s_pi_integ_q12 = -(step_limit << 12);
+
+  int32_t step_q16 = step_base_q16 + ((RESAMPLER_PI_KP_Q8 * s_fill_err_filt) >> 8) + (s_pi_integ_q12 >> 12);
+  uint32_t clamped = 0;
+  if (step_q16 < (step_base_q16 - step_limit)) { step_q16 = (step_base_q16 - step_limit); clamped = 1; }
+  if (step_q16 > (step_base_q16 + step_limit)) { step_q16 = (step_base_q16 + step_limit); clamped = 1; }
+
+  s_rs_step_q16 = step_q16;
+  s_rs_clamped = clamped;
+  if (clamped) s_rs_limit_hits++;
+  if (s_pi_integ_q12 < s_rs_est_min_q12) s_rs_est_min_q12 = s_pi_integ_q12;
+  if (s_pi_integ_q12 > s_rs_est_max_q12) s_rs_est_max_q12 = s_pi_integ_q12;
+
+#if APP_TRACE_ENABLE
+  const uint32_t underrun0 = s_ring_underrun;
+#endif
+  switch (s_resampler)
+  {
+    case APP_AUDIO_RESAMPLER_FIR:
+      r_q16 = resample_frames(APP_AUDIO_RESAMPLER_FIR, tx, frames, r_q16, (uint32_t)step_q16, w_snapshot);
+      break;
+    case APP_AUDIO_RESAMPLER_HERMITE:
+      r_q16 = resample_frames(APP_AUDIO_RESAMPLER_HERMITE, tx, frames, r_q16, (uint32_t)step_q16, w_snapshot);
+      break;
+    default:
+      r_q16 = resample_frames(APP_AUDIO_RESAMPLER_LINEAR, tx, frames, r_q16, (uint32_t)step_q16, w_snapshot);
+      break;
+  }
+
+#if APP_TRACE_ENABLE
+  if (s_ring_underrun != underrun0)
+  {
+    APP_TRACE(APP_TRACE_UNDERRUN, s_ring_underrun - underrun0);
+  }
+#endif
+
+  /* Publish the consumer index (single aligned store). */
+  s_ring_r_q16 = r_q16;
 }
+#endif /* !APP_AUDIO_SYNC_CLOCK */
 
-uint8_t AppAudio_StartFailed(void)
+#if APP_AUDIO_LTEST_ENABLE
+static void ltest_finish(AppAudioLtestState state)
 {
-  return (uint8_t)(s_audio_start_fail ? 1U : 0U);
+  if (s_lt.runs != 0U)
+  {
+    s_lt.avg_frames_x10 = ((s_lt_sum * 10U) + (s_lt.runs / 2U)) / s_lt.runs;
+    s_lt.conv_frames_x10 = (int32_t)s_lt.avg_frames_x10 - (int32_t)(10U * (s_lt.dma_frames + s_lt.ring_frames));
+    s_lt.dwt_us = (uint32_t)(((uint64_t)(s_lt_cyc_sum / s_lt.runs) * 1000000u) / SystemCoreClock);
+  }
+  __DMB();
+  s_lt_state = state;
 }
 
-uint8_t AppAudio_RuntimeFailed(void)
+/* Runs the test on one unpacked RX block in place of the DSP and leaves the
+ * block to play: silence, with the impulse at the start of an emitting one.
+ */
+static void ltest_block(AppStereoS24 *x, uint32_t frames)
 {
-  return (uint8_t)(s_audio_runtime_fail ? 1U : 0U);
+  if (s_dsp_late != s_lt_late0)
+  {
+    /* A skipped half breaks the frame count. */
+    ltest_finish(APP_AUDIO_LTEST_ABORTED);
+    memset(x, 0, frames * sizeof(*x));
+    return;
+  }
+
+  const uint32_t pos = s_lt_pos;
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    int32_t l = x[i].l;
+    int32_t r = x[i].r;
+    int32_t a = (l < 0) ? -l : l;
+    if (r > a) a = r;
+    if (-r > a) a = -r;
+
+    if (s_lt_phase == LTEST_PHASE_QUIET)
+    {
+      /* Settle silence only: the gaps still carry the tail of a return. */
+      if ((s_lt.runs == 0U) && ((uint32_t)a > s_lt.noise_peak))
+      {
+        s_lt.noise_peak = (uint32_t)a;
+      }
+    }
+    else if (!s_lt_hit)
+    {
+      if (a > s_lt_thresh)
+      {
+        s_lt_hit = 1U;
+        s_lt_hit_end = pos + i + LTEST_PEAK_FRAMES;
+        s_lt_peak_pos = pos + i;
+        s_lt.level = (uint32_t)a;
+      }
+    }
+    else if ((uint32_t)a > s_lt.level)
+    {
+      s_lt.level = (uint32_t)a;
+      s_lt_peak_pos = pos + i;
+    }
+  }
+  memset(x, 0, frames * sizeof(*x));
+  if ((s_lt_phase == LTEST_PHASE_LISTEN) && (pos == s_lt_emit))
+  {
+    x[0].l = LTEST_IMPULSE;
+    x[0].r = LTEST_IMPULSE;
+    s_lt_emit_cyc = AppProf_Cycles();
+  }
+  s_lt_pos = pos + frames;
+
+  if (s_lt_phase == LTEST_PHASE_LISTEN)
+  {
+    if (s_lt_hit && ((int32_t)(s_lt_pos - s_lt_hit_end) >= 0))
+    {
+      const uint32_t d = s_lt_peak_pos - s_lt_emit;
+      if ((s_lt.runs == 0U) || (d < s_lt.min_frames)) s_lt.min_frames = d;
+      if (d > s_lt.max_frames) s_lt.max_frames = d;
+      s_lt_sum += d;
+      s_lt_cyc_sum += AppProf_Cycles() - s_lt_emit_cyc;
+      s_lt.runs++;
+      if (s_lt.runs >= APP_AUDIO_LTEST_RUNS)
+      {
+        ltest_finish(APP_AUDIO_LTEST_DONE);
+        return;
+      }
+      s_lt_phase = LTEST_PHASE_QUIET;
+      s_lt_next = s_lt_pos + LTEST_GAP_FRAMES;
+    }
+    else if (!s_lt_hit && ((s_lt_pos - s_lt_emit) > LTEST_TIMEOUT_FRAMES))
+    {
+      ltest_finish(APP_AUDIO_LTEST_NO_SIGNAL);
+    }
+    return;
+  }
+
+  if ((int32_t)(s_lt_pos - s_lt_next) < 0)
+  {
+    return;
+  }
+  if (s_lt.runs == 0U)
+  {
+    /* End of the settle silence: set the threshold above its noise. */
+    if (s_lt.noise_peak >= (uint32_t)(LTEST_IMPULSE / 8))
+    {
+      ltest_finish(APP_AUDIO_LTEST_NOISY);
+      return;
+    }
+    s_lt_thresh = (int32_t)(4U * s_lt.noise_peak);
+    if (s_lt_thresh < LTEST_THRESH_MIN) s_lt_thresh = LTEST_THRESH_MIN;
+  }
+  /* The next block carries the impulse; it starts at RX frame s_lt_pos. */
+  s_lt_phase = LTEST_PHASE_LISTEN;
+  s_lt_hit = 0U;
+  s_lt.level = 0U;
+  s_lt_emit = s_lt_pos;
 }
+#endif
 
-void AppAudio_OnRxHalfCplt(I2S_HandleTypeDef *hi2s)
+/* Ramps the first APP_AUDIO_RECOVER_FADE_MS after a start up from silence,
+ * so a restart mid-note does not click.
+ */
+static void fade_in_block(AppStereoS24 *x, uint32_t frames)
 {
-  if (hi2s == s_rx_i2s)
+  uint32_t g = s_fade_q16;
+  for (uint32_t i = 0; i < frames; i++)
   {
-    process_rx_half(0U);
+    x[i].l = (int32_t)(((int64_t)x[i].l * g) >> 16);
+    x[i].r = (int32_t)(((int64_t)x[i].r * g) >> 16);
+    g += AUDIO_FADE_STEP;
+    if (g >= AUDIO_FADE_UNITY)
+    {
+      g = AUDIO_FADE_UNITY;
+      break;
+    }
   }
+  s_fade_q16 = g;
 }
 
-void AppAudio_OnRxCplt(I2S_HandleTypeDef *hi2s)
+/* Crossfades the head of a block from the last frame played, so a repeat
+ * and the block after it start without a step.
+ */
+static void join_block(AppStereoS24 *x)
 {
-  if (hi2s == s_rx_i2s)
+  const AppStereoS24 from = s_blk_last;
+  for (uint32_t i = 0; i < APP_AUDIO_JOIN_FRAMES; i++)
   {
-    process_rx_half(1U);
+    const int32_t g = (int32_t)(((i + 1U) * 32768U) / APP_AUDIO_JOIN_FRAMES);
+    x[i].l = from.l + (int32_t)(((int64_t)(x[i].l - from.l) * g) >> 15);
+    x[i].r = from.r + (int32_t)(((int64_t)(x[i].r - from.r) * g) >> 15);
   }
 }
 
-void AppAudio_OnTxHalfCplt(I2S_HandleTypeDef *hi2s)
+/* repeat: the block before was late, so this half skips the DSP and plays
+ * s_blk (the last block) again.
+ */
+#if APP_AUDIO_JITTER
+static void jitter_stamp(AudioJitter *j)
 {
-  if (hi2s == s_tx_i2s)
+  const uint32_t now = AppProf_Cycles();
+  if (j->armed)
   {
-    tx_fill_half(0U);
+    const uint32_t dt = now - j->last;
+    const uint32_t dev = (dt > s_jit_period) ? (dt - s_jit_period) : (s_jit_period - dt);
+    const uint32_t us = dev / s_jit_cyc_us;
+    uint32_t bin = (us == 0U) ? 0U : (32U - __CLZ(us));
+    if (bin >= APP_AUDIO_JITTER_BINS)
+    {
+      bin = APP_AUDIO_JITTER_BINS - 1U;
+    }
+    j->st.hist[bin]++;
+    j->st.count++;
+    if (us > j->st.max_us)
+    {
+      j->st.max_us = us;
+    }
   }
+  j->last = now;
+  j->armed = 1U;
 }
+#endif
 
-void AppAudio_OnTxCplt(I2S_HandleTypeDef *hi2s)
+#if APP_AUDIO_ITEST_ENABLE
+static void itest_counters(AppAudioItest *c)
 {
-  if (hi2s == s_tx_i2s)
+  c->underrun = s_ring_underrun;
+  c->overflow = s_ring_overflow;
+  c->i2s_errors = s_audio_overrun_count;
+  c->dsp_late = s_dsp_late;
+  c->deadline_miss = s_deadline_miss;
+  AppDspShedInfo sh;
+  AppDsp_GetShed(&sh);
+  c->sheds = sh.sheds;
+}
+
+/* Runs the test on one unpacked RX block in place of the plain DSP call:
+ * the pattern in, the chain, its output into the hash.
+ */
+static void itest_block(AppStereoS24 *x, uint32_t frames)
+{
+  if (s_it.blocks == 0U)
+  {
+    itest_counters(&s_it0);
+  }
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    s_it_phase += (uint32_t)((110ull << 32) / APP_AUDIO_SAMPLE_RATE_HZ);
+    s_it_rng = (s_it_rng * 1664525U) + 1013904223U;
+    const int32_t saw = (int32_t)s_it_phase >> 12;
+    const int32_t noise = (int32_t)s_it_rng >> 16;
+    x[i].l = saw + noise;
+    x[i].r = saw - noise;
+  }
+
+  AppDsp_ProcessBlock(x, frames);
+
+  uint32_t h = s_it.hash;
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    h = (h ^ (uint32_t)x[i].l) * ITEST_FNV_PRIME;
+    h = (h ^ (uint32_t)x[i].r) * ITEST_FNV_PRIME;
+  }
+  s_it.hash = h;
+  s_it.blocks++;
+  if (s_it.blocks == s_it.total)
   {
-    tx_fill_half(1U);
+    AppAudioItest c;
+    itest_counters(&c);
+    s_it.underrun = c.underrun - s_it0.underrun;
+    s_it.overflow = c.overflow - s_it0.overflow;
+    s_it.i2s_errors = c.i2s_errors - s_it0.i2s_errors;
+    s_it.dsp_late = c.dsp_late - s_it0.dsp_late;
+    s_it.deadline_miss = c.deadline_miss - s_it0.deadline_miss;
+    s_it.sheds = c.sheds - s_it0.sheds;
+    __DMB();
+    s_it_state = APP_AUDIO_ITEST_DONE;
   }
 }
+#endif
 
-void AppAudio_OnError(I2S_HandleTypeDef *hi2s)
+static void process_rx_half(uint32_t half_index, uint32_t repeat)
 {
-  (void)hi2s;
-  s_audio_overrun_count++;
-  s_audio_runtime_fail = 1;
+  const uint32_t frames = s_frames_per_half;
+  uint32_t base = half_index ? (frames * AUDIO_WORDS_PER_FRAME) : 0U;
+  uint32_t *rx = &s_i2s_rx_buf[base];
+
+  if (repeat)
+  {
+    join_block(s_blk);
+    s_join = 1U;
+  }
+  else
+  {
+    lj24_unpack_block(rx, s_blk, frames);
+#if APP_UAC_ENABLE
+    AppUac_DryBlock(s_blk, frames);
+#endif
+
+#if APP_AUDIO_LTEST_ENABLE
+    if (s_lt_state == APP_AUDIO_LTEST_RUNNING)
+    {
+      ltest_block(s_blk, frames);
+    }
+    else
+#endif
+#if APP_AUDIO_ITEST_ENABLE
+    if (s_it_state == APP_AUDIO_ITEST_RUNNING)
+    {
+      itest_block(s_blk, frames);
+    }
+    else
+#endif
+    {
+      AppDsp_ProcessBlock(s_blk, frames);
+    }
+
+    if (s_fade_q16 < AUDIO_FADE_UNITY)
+    {
+      fade_in_block(s_blk, frames);
+    }
+    if (s_join)
+    {
+      s_join = 0U;
+      join_block(s_blk);
+    }
+  }
+  s_blk_last = s_blk[frames - 1U];
+#if APP_UAC_ENABLE
+  /* The USB recording stream packs the block as it leaves for the DAC. */
+  AppUac_Block(s_blk, frames);
+#endif
+
+#if APP_AUDIO_SYNC_CLOCK
+#if APP_AUDIO_PIPELINE
+  /* Write back in place. TX lags RX by one block plus this DSP time, so it
+   * reaches this half after it is processed and leaves it before the next
+   * RX pass overwrites it.
+   */
+  uint32_t *tx = rx;
+#else
+  /* Lockstep: while RX filled this half, TX played the same half; TX is now
+   * on the other one, so this half is free until the next period.
+   */
+  uint32_t *tx = &s_i2s_tx_buf[base];
+#endif
+  lj24_pack_block(tx, s_blk, frames);
+#else
+  for (uint32_t frame = 0; frame < frames; frame++)
+  {
+    ring_push_frame_s24(&s_blk[frame]);
+  }
+#endif
+
+#if APP_AUDIO_PIPELINE
+  if (!s_tx_started && (half_index == 0U))
+  {
+    /* First block is ready: start the slave on the next frame of the running
+     * clocks. From here on the TX read position trails RX by a fixed offset.
+     */
+    s_tx_started = 1;
+    uint16_t dma_size = (uint16_t)(2U * frames * AUDIO_CHANNELS);
+    s_audio_start_tx_status = (uint32_t)HAL_I2S_Transmit_DMA(s_tx_i2s, (uint16_t *)s_i2s_tx_buf, dma_size);
+    if (s_audio_start_tx_status != (uint32_t)HAL_OK)
+    {
+      s_audio_start_fail = 1;
+      s_audio_runtime_fail = 1;
+    }
+  }
+#endif
+}
+
+void AppAudio_Init(I2S_HandleTypeDef *rx_i2s, I2S_HandleTypeDef *tx_i2s)
+{
+  s_rx_i2s = rx_i2s;
+  s_tx_i2s = tx_i2s;
+
+#if APP_AUDIO_DEFER_DSP
+  /* Below every peripheral IRQ so DMA and UART always preempt the DSP. */
+  HAL_NVIC_SetPriority(PendSV_IRQn, 15, 0);
+#endif
+
+  if (!AppAudio_SetLatency((AppAudioLatency)APP_AUDIO_LATENCY_DEFAULT))
+  {
+    (void)AppAudio_SetLatency(APP_AUDIO_LATENCY_SAFE);
+  }
+}
+
+/* fresh = 0 restarts after an I2S error (AppAudio_Poll): the counters, the
+ * drift estimate and the adaptive target carry on.
+ */
+#if !APP_AUDIO_SYNC_CLOCK
+/* Kernel clocks per I2S frame of a master (RM0440 I2S clock generator):
+ * (2 * I2SDIV + ODD) times 256 with MCLK out, else times the frame's bits.
+ */
+static uint32_t i2s_frame_div(const SPI_TypeDef *spi)
+{
+  const uint32_t pr = spi->I2SPR;
+  const uint32_t div = (2U * (pr & SPI_I2SPR_I2SDIV)) + (((pr & SPI_I2SPR_ODD) != 0U) ? 1U : 0U);
+  const uint32_t per = ((pr & SPI_I2SPR_MCKOE) != 0U) ? 256U
+                     : (((spi->I2SCFGR & SPI_I2SCFGR_CHLEN) != 0U) ? 64U : 32U);
+  return per * div;
+}
+#endif
+
+static void audio_start(uint32_t fresh)
+{
+  if ((s_rx_i2s == NULL) || (s_tx_i2s == NULL))
+  {
+    s_audio_start_fail = 1;
+    s_audio_runtime_fail = 1;
+    s_audio_started = 0;
+    return;
+  }
+
+#if APP_AUDIO_LTEST_ENABLE
+  if (s_lt_state == APP_AUDIO_LTEST_RUNNING)
+  {
+    s_lt_state = APP_AUDIO_LTEST_ABORTED;
+  }
+#endif
+#if APP_AUDIO_ITEST_ENABLE
+  if ((s_it_state == APP_AUDIO_ITEST_RUNNING) && !s_it_armed)
+  {
+    s_it_state = APP_AUDIO_ITEST_ABORTED;
+  }
+  s_it_armed = 0U;
+#endif
+
+  memset(s_i2s_rx_buf, 0, sizeof(s_i2s_rx_buf));
+#if APP_AUDIO_PIPELINE
+  s_tx_started = 0;
+#else
+  memset(s_i2s_tx_buf, 0, sizeof(s_i2s_tx_buf));
+#endif
+
+#if !APP_AUDIO_SYNC_CLOCK
+  /* Start the reader exactly at the target fill (on silence) so the drift
+   * loop only has to trim ppm instead of slewing in a whole ring target.
+   */
+#if APP_AUDIO_RING_ADAPT
+  /* Keep the target a previous run reached, relearn how low it may go. */
+  if (fresh)
+  {
+    const uint32_t f = s_frames_per_half;
+    const uint32_t room = AUDIO_RING_FRAMES - f - AUDIO_RING_GUARD_FRAMES - RESAMPLER_FIR_TAPS;
+    s_rt_floor = f + APP_AUDIO_RING_FLOOR_MARGIN;
+    s_rt_ceil = (APP_AUDIO_RING_CEIL_HALVES * f < room) ? (APP_AUDIO_RING_CEIL_HALVES * f) : room;
+    if (s_rt_ceil < s_rt_floor) s_rt_ceil = s_rt_floor;
+    s_rt_low = s_rt_floor;
+    if (s_ring_target < s_rt_floor) s_ring_target = s_rt_floor;
+    if (s_ring_target > s_rt_ceil) s_ring_target = s_rt_ceil;
+    s_rt_hold = ((APP_AUDIO_RING_ADAPT_MS * (APP_AUDIO_SAMPLE_RATE_HZ / 1000U)) + f - 1U) / f;
+    s_rt_halves = 0;
+    s_rt_underrun_seen = 0;
+  }
+#endif
+  memset(s_ring, 0, sizeof(s_ring));
+  s_ring_w = 0;
+  s_ring_r_q16 = ((AUDIO_RING_FRAMES - s_ring_target) & AUDIO_RING_MASK) << 16;
+  s_fill_err_filt = 0;
+  s_rs_clamped = 0;
+  if (fresh)
+  {
+    s_pi_integ_q12 = 0;
+    s_rs_step_q16 = 65536;
+    s_ring_underrun = 0;
+    s_ring_overflow = 0;
+    AppAudio_ResetClockStats();
+  }
+  s_ring_overflow_seen = s_ring_overflow;
+  /* I2S2 and I2S3 share the I2S kernel clock, so equal dividers are equal
+   * rates (APP_AUDIO_EXT_CLOCK sets them up that way).
+   */
+  s_rate_exact = (i2s_frame_div(s_rx_i2s->Instance) == i2s_frame_div(s_tx_i2s->Instance)) ? 1U : 0U;
+  if (s_rate_exact)
+  {
+    s_rs_step_q16 = 65536;
+  }
+#else
+  if (fresh)
+  {
+    s_ring_underrun = 0;
+    s_ring_overflow = 0;
+  }
+#endif
+  s_fade_q16 = 0;
+  s_tx_sr_armed = 0;
+  s_rx_late = 0;
+  s_join = 0;
+#if APP_AUDIO_JITTER
+  s_jit_period = (uint32_t)(((uint64_t)SystemCoreClock * s_frames_per_half) / APP_AUDIO_SAMPLE_RATE_HZ);
+  s_jit_cyc_us = SystemCoreClock / 1000000U;
+  memset(s_jit, 0, sizeof(s_jit));
+#endif
+#if APP_AUDIO_DEFER_DSP
+  s_rx_post = 0;
+  s_rx_done = 0;
+#endif
+  s_audio_runtime_fail = 0;
+
+  /* Size parameter for HAL_I2S_{Receive,Transmit}_DMA(): number of 24/32-bit
+   * data lengths over both halves.
+   */
+  uint16_t dma_size = (uint16_t)(2U * s_frames_per_half * AUDIO_CHANNELS);
+
+  /* TX first so DAC sees continuous clocks/data; buffer is initially zeros.
+   * In sync-clock mode this also arms the slave before the RX master starts
+   * the shared clocks, so both DMA streams begin on the same frame.
+   * The pipeline mode defers TX to the first RX block (process_rx_half),
+   * APP_AUDIO_TX_ALIGN to the end of the RX warmup.
+   */
+#if APP_AUDIO_PIPELINE
+  s_audio_start_tx_status = (uint32_t)HAL_OK;
+#elif AUDIO_TX_ALIGN
+  /* Started from the RX path once aligned (tx_align_block()). */
+  s_align_wait = APP_AUDIO_TX_ALIGN_WARMUP;
+  s_align_land_max = 0;
+  s_tx_lead_us = 0;
+  s_audio_start_tx_status = (uint32_t)HAL_OK;
+#else
+  s_audio_start_tx_status = (uint32_t)HAL_I2S_Transmit_DMA(s_tx_i2s, (uint16_t *)s_i2s_tx_buf, dma_size);
+#endif
+  s_audio_start_rx_status = (uint32_t)HAL_I2S_Receive_DMA(s_rx_i2s, (uint16_t *)s_i2s_rx_buf, dma_size);
+
+  if ((s_audio_start_tx_status != (uint32_t)HAL_OK) || (s_audio_start_rx_status != (uint32_t)HAL_OK))
+  {
+    s_audio_start_fail = 1;
+    s_audio_runtime_fail = 1;
+    s_audio_started = 0;
+    return;
+  }
+
+  s_audio_start_fail = 0;
+  s_audio_started = 1;
+}
+
+void AppAudio_Start(void)
+{
+  audio_start(1U);
+}
+
+uint8_t AppAudio_StartFailed(void)
+{
+  return (uint8_t)(s_audio_start_fail ? 1U : 0U);
+}
+
+uint8_t AppAudio_RuntimeFailed(void)
+{
+  return (uint8_t)(s_audio_runtime_fail ? 1U : 0U);
+}
+
+uint8_t AppAudio_SetLatency(AppAudioLatency profile)
+{
+  if ((uint32_t)profile >= (uint32_t)APP_AUDIO_LATENCY_COUNT)
+  {
+    return 0;
+  }
+
+  uint32_t frames = k_latency_frames[profile];
+  if (frames > AUDIO_MAX_FRAMES_PER_HALF)
+  {
+    return 0;
+  }
+
+  uint32_t was_started = s_audio_started;
+  if (was_started)
+  {
+    (void)HAL_I2S_DMAStop(s_rx_i2s);
+    (void)HAL_I2S_DMAStop(s_tx_i2s);
+    s_audio_started = 0;
+  }
+
+  s_latency = profile;
+  s_frames_per_half = frames;
+#if APP_AUDIO_SYNC_CLOCK
+  s_ring_target = 0U;
+#else
+  s_ring_target = 2U * frames;
+#endif
+
+  if (was_started)
+  {
+    AppAudio_Start();
+    return (uint8_t)(s_audio_start_fail ? 0U : 1U);
+  }
+  return 1;
+}
+
+AppStereoS24 *AppAudio_Pause(uint32_t *frames)
+{
+  if (s_audio_started)
+  {
+    (void)HAL_I2S_DMAStop(s_rx_i2s);
+    (void)HAL_I2S_DMAStop(s_tx_i2s);
+    s_audio_started = 0;
+    s_audio_paused = 1;
+  }
+#if APP_AUDIO_LTEST_ENABLE
+  if (s_lt_state == APP_AUDIO_LTEST_RUNNING)
+  {
+    s_lt_state = APP_AUDIO_LTEST_ABORTED;
+  }
+#endif
+#if APP_AUDIO_ITEST_ENABLE
+  if ((s_it_state == APP_AUDIO_ITEST_RUNNING) && !s_it_armed)
+  {
+    s_it_state = APP_AUDIO_ITEST_ABORTED;
+  }
+#endif
+  /* A deferred block posted before the stop has already run: PendSV
+   * preempts the main loop as soon as it is pended.
+   */
+  if (frames != NULL)
+  {
+    *frames = AUDIO_MAX_FRAMES_PER_HALF;
+  }
+  return s_blk;
+}
+
+void AppAudio_Resume(void)
+{
+  if (s_audio_paused)
+  {
+    s_audio_paused = 0;
+    AppAudio_Start();
+  }
+}
+
+/* Kernel benches (AppAudioKernel), run between AppAudio_Pause() and
+ * AppAudio_Resume(): s_blk, the RX DMA buffer and the ring as scratch,
+ * all cleared again by the restart. The frame variants call the kernel
+ * once per frame through a pointer, as in AppDsp_BenchKernel().
+ */
+typedef void (*AudioKernelFn)(uint32_t *words, AppStereoS24 *x, uint32_t frames);
+
+static void kernel_lj24_unpack(uint32_t *words, AppStereoS24 *x, uint32_t frames)
+{
+  lj24_unpack_block(words, x, frames);
+}
+
+static void kernel_lj24_pack(uint32_t *words, AppStereoS24 *x, uint32_t frames)
+{
+  lj24_pack_block(words, x, frames);
+}
+
+#if !APP_AUDIO_SYNC_CLOCK
+/* The read position walks the ring a little faster than 1:1, so frac
+ * takes every value; the write index is always half a ring ahead.
+ */
+static uint32_t s_bench_r_q16;
+#define AUDIO_BENCH_STEP_Q16           (65536U + 7U)
+
+static void kernel_resample_linear(uint32_t *words, AppStereoS24 *x, uint32_t frames)
+{
+  const uint32_t w = (s_bench_r_q16 >> 16) + (AUDIO_RING_FRAMES / 2U);
+  s_bench_r_q16 = resample_frames(APP_AUDIO_RESAMPLER_LINEAR, words, frames, s_bench_r_q16, AUDIO_BENCH_STEP_Q16, w);
+}
+
+static void kernel_resample_hermite(uint32_t *words, AppStereoS24 *x, uint32_t frames)
+{
+  const uint32_t w = (s_bench_r_q16 >> 16) + (AUDIO_RING_FRAMES / 2U);
+  s_bench_r_q16 = resample_frames(APP_AUDIO_RESAMPLER_HERMITE, words, frames, s_bench_r_q16, AUDIO_BENCH_STEP_Q16, w);
+}
+
+static void kernel_resample_fir(uint32_t *words, AppStereoS24 *x, uint32_t frames)
+{
+  const uint32_t w = (s_bench_r_q16 >> 16) + (AUDIO_RING_FRAMES / 2U);
+  s_bench_r_q16 = resample_frames(APP_AUDIO_RESAMPLER_FIR, words, frames, s_bench_r_q16, AUDIO_BENCH_STEP_Q16, w);
+}
+#endif
+
+static const struct
+{
+  const char *name;
+  AudioKernelFn fn;
+} k_audio_kernels[APP_AUDIO_KERNEL_COUNT] =
+{
+  {"lj24_unpack", kernel_lj24_unpack},
+  {"lj24_pack", kernel_lj24_pack},
+#if APP_AUDIO_SYNC_CLOCK
+  {"resample_linear", NULL},
+  {"resample_hermite", NULL},
+  {"resample_fir", NULL},
+#else
+  {"resample_linear", kernel_resample_linear},
+  {"resample_hermite", kernel_resample_hermite},
+  {"resample_fir", kernel_resample_fir},
+#endif
+};
+
+/* Full-scale-ish noise, for both the frames and the ring. */
+static void bench_noise(AppStereoS24 *x, uint32_t frames, uint32_t *rng)
+{
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    *rng = (*rng * 1664525u) + 1013904223u;
+    x[i].l = (int32_t)*rng >> 9;
+    x[i].r = -x[i].l;
+  }
+}
+
+const char *AppAudio_KernelName(AppAudioKernel kernel)
+{
+  return ((uint32_t)kernel < (uint32_t)APP_AUDIO_KERNEL_COUNT) ? k_audio_kernels[kernel].name : "?";
+}
+
+uint64_t AppAudio_BenchKernel(AppAudioKernel kernel, uint8_t per_frame, uint32_t frames, uint32_t blocks)
+{
+  if ((frames == 0u) || (frames > AUDIO_MAX_FRAMES_PER_HALF) || ((uint32_t)kernel >= (uint32_t)APP_AUDIO_KERNEL_COUNT) ||
+      (k_audio_kernels[kernel].fn == NULL))
+  {
+    return 0u;
+  }
+  AudioKernelFn volatile fn = k_audio_kernels[kernel].fn;
+  uint32_t *words = s_i2s_rx_buf;
+  uint32_t rng = 1u;
+  uint64_t cycles = 0;
+#if !APP_AUDIO_SYNC_CLOCK
+  bench_noise(s_ring, AUDIO_RING_FRAMES, &rng);
+  s_bench_r_q16 = 0;
+#endif
+
+  for (uint32_t b = 0; b < blocks; b++)
+  {
+    bench_noise(s_blk, frames, &rng);
+    lj24_pack_block(words, s_blk, frames);
+
+    const uint32_t t0 = AppProf_Cycles();
+    if (per_frame != 0u)
+    {
+      for (uint32_t i = 0; i < frames; i++)
+      {
+        fn(&words[i * AUDIO_WORDS_PER_FRAME], &s_blk[i], 1u);
+      }
+    }
+    else
+    {
+      fn(words, s_blk, frames);
+    }
+    cycles += AppProf_Cycles() - t0;
+  }
+  return cycles;
+}
+
+uint8_t AppAudio_SetResampler(AppAudioResampler engine)
+{
+#if APP_AUDIO_SYNC_CLOCK
+  (void)engine;
+  return 0;
+#else
+  if ((uint32_t)engine >= (uint32_t)APP_AUDIO_RESAMPLER_COUNT)
+  {
+    return 0;
+  }
+  s_resampler = engine;
+  return 1;
+#endif
+}
+
+AppAudioResampler AppAudio_GetResampler(void)
+{
+  return s_resampler;
+}
+
+AppAudioLatency AppAudio_GetLatency(void)
+{
+  return s_latency;
+}
+
+uint32_t AppAudio_GetFramesPerHalf(void)
+{
+  return s_frames_per_half;
+}
+
+uint32_t AppAudio_GetRingTargetFrames(void)
+{
+  return s_ring_target;
+}
+
+void AppAudio_GetRingTargetRange(uint32_t *floor_frames, uint32_t *ceil_frames, uint32_t *low_frames)
+{
+#if APP_AUDIO_RING_ADAPT && !APP_AUDIO_SYNC_CLOCK
+  *floor_frames = s_rt_floor;
+  *ceil_frames = s_rt_ceil;
+  *low_frames = s_rt_low;
+#else
+  *floor_frames = 0;
+  *ceil_frames = 0;
+  *low_frames = 0;
+#endif
+}
+
+uint32_t AppAudio_GetLatencyFrames(void)
+{
+#if APP_AUDIO_PIPELINE
+  /* One RX half to capture; TX trails by that plus the DSP time of a block. */
+  return s_frames_per_half;
+#else
+  /* One RX half to capture, then (async) the ring target, then one TX half
+   * queued ahead of the half being played.
+   */
+  return (2U * s_frames_per_half) + s_ring_target;
+#endif
+}
+
+uint32_t AppAudio_GetTxLeadUs(void)
+{
+#if AUDIO_TX_ALIGN
+  return s_tx_lead_us;
+#else
+  return 0;
+#endif
+}
+
+uint8_t AppAudio_StartLatencyTest(void)
+{
+#if APP_AUDIO_LTEST_ENABLE
+  if (!s_audio_started || (s_lt_state == APP_AUDIO_LTEST_RUNNING)
+#if APP_AUDIO_ITEST_ENABLE
+      || (s_it_state == APP_AUDIO_ITEST_RUNNING)
+#endif
+     )
+  {
+    return 0;
+  }
+
+  memset(&s_lt, 0, sizeof(s_lt));
+  s_lt.ring_frames = s_ring_target;
+  s_lt.dma_frames = AppAudio_GetLatencyFrames() - s_ring_target;
+  s_lt_phase = LTEST_PHASE_QUIET;
+  s_lt_pos = 0U;
+  s_lt_next = LTEST_SETTLE_FRAMES;
+  s_lt_sum = 0U;
+  s_lt_cyc_sum = 0U;
+  s_lt_late0 = s_dsp_late;
+  __DMB(); /* the block handler sees a complete setup */
+  s_lt_state = APP_AUDIO_LTEST_RUNNING;
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+void AppAudio_GetLatencyTest(AppAudioLtest *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+#if APP_AUDIO_LTEST_ENABLE
+  AppAudioLtestState state = s_lt_state;
+  __DMB();
+  *out = s_lt;
+  out->state = state;
+#else
+  memset(out, 0, sizeof(*out));
+#endif
+}
+
+uint8_t AppAudio_StartIntegrityTest(uint32_t blocks)
+{
+#if APP_AUDIO_ITEST_ENABLE
+  if (!s_audio_started || (blocks == 0U) || (s_it_state == APP_AUDIO_ITEST_RUNNING)
+#if APP_AUDIO_LTEST_ENABLE
+      || (s_lt_state == APP_AUDIO_LTEST_RUNNING)
+#endif
+     )
+  {
+    return 0;
+  }
+
+  /* The last finished run is the reference for this one. */
+  uint32_t ref_hash = s_it.ref_hash;
+  uint32_t ref_blocks = s_it.ref_blocks;
+  uint32_t ref_frames = s_it.ref_frames;
+  if (s_it_state == APP_AUDIO_ITEST_DONE)
+  {
+    ref_hash = s_it.hash;
+    ref_blocks = s_it.total;
+    ref_frames = s_it.frames;
+  }
+
+  (void)AppAudio_Pause(NULL);
+  AppDsp_ContextReset(AppDsp_DefaultContext());
+  memset(&s_it, 0, sizeof(s_it));
+  s_it.total = blocks;
+  s_it.frames = s_frames_per_half;
+  s_it.hash = ITEST_FNV_BASIS;
+  s_it.ref_hash = ref_hash;
+  s_it.ref_blocks = ref_blocks;
+  s_it.ref_frames = ref_frames;
+  s_it_phase = 0U;
+  s_it_rng = 1U;
+  s_it_armed = 1U;
+  s_it_state = APP_AUDIO_ITEST_RUNNING;
+  AppAudio_Resume();
+  if (s_audio_start_fail)
+  {
+    s_it_state = APP_AUDIO_ITEST_ABORTED;
+    return 0;
+  }
+  return 1;
+#else
+  (void)blocks;
+  return 0;
+#endif
+}
+
+void AppAudio_GetIntegrityTest(AppAudioItest *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+#if APP_AUDIO_ITEST_ENABLE
+  AppAudioItestState state = s_it_state;
+  __DMB();
+  *out = s_it;
+  out->state = state;
+#else
+  memset(out, 0, sizeof(*out));
+#endif
+}
+
+void AppAudio_GetStats(AppAudioStats *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+
+  out->period_cycles = (uint32_t)(((uint64_t)SystemCoreClock * s_frames_per_half) / APP_AUDIO_SAMPLE_RATE_HZ);
+  out->rx_avg_cycles = s_rx_avg_cycles;
+  out->rx_max_cycles = s_rx_max_cycles;
+  out->tx_avg_cycles = s_tx_avg_cycles;
+  out->tx_max_cycles = s_tx_max_cycles;
+  out->isr_max_cycles = s_isr_max_cycles;
+  out->ring_underrun = s_ring_underrun;
+  out->ring_overflow = s_ring_overflow;
+  out->i2s_error_count = s_audio_overrun_count;
+  out->dsp_late = s_dsp_late;
+  out->deadline_miss = s_deadline_miss;
+  out->i2s_recoveries = s_recoveries;
+  out->glitch_us = s_glitch_us;
+#if !APP_AUDIO_SYNC_CLOCK
+  out->ring_frames = AUDIO_RING_FRAMES;
+  out->ring_peak = s_ring_peak;
+#else
+  out->ring_frames = 0;
+  out->ring_peak = 0;
+#endif
+}
+
+void AppAudio_ResetRingPeak(void)
+{
+#if !APP_AUDIO_SYNC_CLOCK
+  s_ring_peak = 0;
+#endif
+}
+
+void AppAudio_ClockChanged(void)
+{
+#if APP_AUDIO_JITTER
+  s_jit_period = (uint32_t)(((uint64_t)SystemCoreClock * s_frames_per_half) / APP_AUDIO_SAMPLE_RATE_HZ);
+  s_jit_cyc_us = SystemCoreClock / 1000000U;
+#endif
+}
+
+static const AppMemItem k_audio_mem[] =
+{
+  APP_MEM_ITEM("audio.i2s_rx", s_i2s_rx_buf),
+#if !APP_AUDIO_PIPELINE
+  APP_MEM_ITEM("audio.i2s_tx", s_i2s_tx_buf),
+#endif
+#if !APP_AUDIO_SYNC_CLOCK
+  APP_MEM_ITEM("audio.ring", s_ring),
+#endif
+  APP_MEM_ITEM("audio.blk", s_blk),
+};
+
+#if APP_AUDIO_SYNC_CLOCK
+#define AUDIO_RING_BYTES               0U
+#else
+#define AUDIO_RING_BYTES               sizeof(s_ring)
+#endif
+
+_Static_assert((sizeof(s_i2s_rx_buf) + sizeof(s_i2s_tx_buf) + AUDIO_RING_BYTES + sizeof(s_blk)) <= APP_AUDIO_RAM_BYTES,
+               "the audio buffers outgrew APP_AUDIO_RAM_BYTES");
+
+uint32_t AppAudio_MemMap(const AppMemItem **items)
+{
+  *items = k_audio_mem;
+  return (uint32_t)(sizeof(k_audio_mem) / sizeof(k_audio_mem[0]));
+}
+
+#if !APP_AUDIO_SYNC_CLOCK
+/* Q16 step deviation (optionally with 12 extra fraction bits) to ppm x10. */
+static int32_t step_dev_to_ppm_x10(int32_t dev, uint32_t frac_bits)
+{
+  return (int32_t)(((int64_t)dev * 10000000) >> (16U + frac_bits));
+}
+#endif
+
+void AppAudio_GetClock(AppAudioClockStats *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+
+  memset(out, 0, sizeof(*out));
+#if APP_AUDIO_SYNC_CLOCK
+  out->sync_clock = 1;
+  out->locked = 1;
+  out->step_q16 = 65536;
+#else
+  int32_t step = s_rs_step_q16;
+  int32_t filt = s_fill_err_filt;
+  int32_t half_block = (int32_t)(s_frames_per_half / 2U);
+
+  out->step_q16 = step;
+  out->ppm_x10 = step_dev_to_ppm_x10(step - 65536, 0U);
+  out->est_ppm_x10 = step_dev_to_ppm_x10(s_pi_integ_q12, 12U);
+  out->est_min_ppm_x10 = step_dev_to_ppm_x10(s_rs_est_min_q12, 12U);
+  out->est_max_ppm_x10 = step_dev_to_ppm_x10(s_rs_est_max_q12, 12U);
+  out->fill_err = filt;
+  out->limit_hits = s_rs_limit_hits;
+  out->locked = (uint8_t)((!s_rs_clamped && (filt < half_block) && (filt > -half_block)) ? 1U : 0U);
+  out->exact = (uint8_t)(s_rate_exact ? 1U : 0U);
+#endif
+}
+
+void AppAudio_ResetClockStats(void)
+{
+#if !APP_AUDIO_SYNC_CLOCK
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  s_rs_est_min_q12 = s_pi_integ_q12;
+  s_rs_est_max_q12 = s_pi_integ_q12;
+  s_rs_limit_hits = 0;
+  if (!primask)
+  {
+    __enable_irq();
+  }
+#endif
+}
+
+uint8_t AppAudio_GetJitter(AppAudioJitter *rx, AppAudioJitter *tx, uint32_t *period_us)
+{
+#if APP_AUDIO_JITTER
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (rx != NULL)
+  {
+    *rx = s_jit[0].st;
+  }
+  if (tx != NULL)
+  {
+    *tx = s_jit[1].st;
+  }
+  if (!primask)
+  {
+    __enable_irq();
+  }
+  if (period_us != NULL)
+  {
+    *period_us = (uint32_t)(((uint64_t)s_frames_per_half * 1000000U) / APP_AUDIO_SAMPLE_RATE_HZ);
+  }
+  return 1;
+#else
+  (void)rx;
+  (void)tx;
+  (void)period_us;
+  return 0;
+#endif
+}
+
+/* Also re-arms the stamps, so the first interval after is not counted. */
+void AppAudio_ResetJitter(void)
+{
+#if APP_AUDIO_JITTER
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  memset(s_jit, 0, sizeof(s_jit));
+  if (!primask)
+  {
+    __enable_irq();
+  }
+#endif
+}
+
+static void audio_error(I2S_HandleTypeDef *hi2s, AppAudioErrKind kind)
+{
+  s_audio_overrun_count++;
+  APP_TRACE(APP_TRACE_I2S_ERR, kind);
+  if (s_recover_pending || !s_audio_started)
+  {
+    return;
+  }
+
+  AppAudioErrEvent *e = &s_err_log[s_err_seq % APP_AUDIO_ERR_LOG_LEN];
+  e->seq = s_err_seq + 1U;
+  e->tick_ms = HAL_GetTick();
+  e->gap_us = 0;
+  e->hal_code = (uint16_t)hi2s->ErrorCode;
+  e->tx = (uint8_t)((hi2s == s_tx_i2s) ? 1U : 0U);
+  e->kind = (uint8_t)kind;
+  e->recovered = 0;
+  s_err_seq = e->seq;
+  s_recover_cyc = AppProf_Cycles();
+  s_recover_pending = 1;
+}
+
+/* Status flags the DMA path never reports (the HAL raises an error callback
+ * for them only in interrupt mode). Reading SR clears UDR and FRE; OVR stays
+ * set until the restart clears it.
+ */
+static void audio_check_sr(I2S_HandleTypeDef *hi2s)
+{
+  uint32_t sr = hi2s->Instance->SR;
+  if ((hi2s == s_tx_i2s) && !s_tx_sr_armed)
+  {
+    /* First TX half of a run: drop what the start left behind (a slave
+     * enabled on running clocks may flag its first frame).
+     */
+    s_tx_sr_armed = 1;
+    return;
+  }
+  if ((sr & (I2S_FLAG_OVR | I2S_FLAG_UDR | I2S_FLAG_FRE)) == 0U)
+  {
+    return;
+  }
+  audio_error(hi2s, ((sr & I2S_FLAG_OVR) != 0U) ? APP_AUDIO_ERR_OVR :
+                    ((sr & I2S_FLAG_UDR) != 0U) ? APP_AUDIO_ERR_UDR : APP_AUDIO_ERR_FRE);
+}
+
+/* Half the RX DMA is writing: its counter runs down over both halves, in
+ * halfwords (two per 24-in-32 slot).
+ */
+static inline uint32_t rx_dma_half(void)
+{
+  const uint32_t left = __HAL_DMA_GET_COUNTER(s_rx_i2s->hdmarx);
+  return (left > (s_frames_per_half * AUDIO_WORDS_PER_FRAME * 2U)) ? 0U : 1U;
+}
+
+#if AUDIO_TX_ALIGN
+/* After each RX block while TX waits. The last warmup block starts TX the
+ * measured landing time plus the margin after its RX event (a short spin,
+ * unless the block is already past that), with the reader placed so the
+ * first TX fill, one half later, sees the target fill.
+ */
+static void tx_align_block(void)
+{
+  const uint32_t frames = s_frames_per_half;
+  const uint32_t land = AppProf_Cycles() - s_rx_event_cyc;
+  if (land > s_align_land_max)
+  {
+    s_align_land_max = land;
+  }
+  if (--s_align_wait != 0U)
+  {
+    /* No reader yet: keep the ring from filling up. */
+    s_ring_r_q16 = ((s_ring_w - frames) & AUDIO_RING_MASK) << 16;
+    return;
+  }
+
+  const uint32_t cyc_us = SystemCoreClock / 1000000U;
+  const uint32_t period = AppProf_CyclesPerFrame() * frames;
+  uint32_t lead = s_align_land_max + (APP_AUDIO_TX_ALIGN_MARGIN_US * cyc_us);
+  if (lead < period)
+  {
+    while ((AppProf_Cycles() - s_rx_event_cyc) < lead)
+    {
+    }
+  }
+  else
+  {
+    lead = 0;   /* no room for a lead: start now, unaligned */
+  }
+  s_ring_r_q16 = ((s_ring_w + frames - s_ring_target) & AUDIO_RING_MASK) << 16;
+  __DMB();
+  uint16_t dma_size = (uint16_t)(2U * frames * AUDIO_CHANNELS);
+  s_audio_start_tx_status = (uint32_t)HAL_I2S_Transmit_DMA(s_tx_i2s, (uint16_t *)s_i2s_tx_buf, dma_size);
+  if (s_audio_start_tx_status != (uint32_t)HAL_OK)
+  {
+    s_audio_start_fail = 1;
+    s_audio_runtime_fail = 1;
+  }
+  s_tx_lead_us = lead / cyc_us;
+}
+#endif
+
+/* One RX half through the DSP, timed. DMA back in the half just processed
+ * means the other half completed meanwhile: its block is late whatever this
+ * one's own time, so it counts as over budget for load shedding and plays a
+ * repeat instead.
+ */
+static void rx_half_run(uint32_t half)
+{
+  const uint32_t repeat = s_rx_late;
+  s_rx_late = 0U;
+
+  APP_TRACE(APP_TRACE_DSP_START, half);
+  uint32_t t0 = AppProf_Cycles();
+  process_rx_half(half, repeat);
+  uint32_t cycles = AppProf_Cycles() - t0;
+  isr_time_update(cycles, &s_rx_avg_cycles, &s_rx_max_cycles);
+  APP_TRACE(APP_TRACE_DSP_END, cycles);
+  if (repeat)
+  {
+    return;
+  }
+
+  const uint32_t budget = AppProf_CyclesPerFrame() * s_frames_per_half;
+  if (rx_dma_half() == half)
+  {
+    s_deadline_miss++;
+    APP_TRACE(APP_TRACE_MISS, cycles);
+#if APP_AUDIO_MISS_REPEAT
+    s_rx_late = 1U;
+#endif
+    if (cycles < budget)
+    {
+      cycles = budget;
+    }
+  }
+  AppDsp_ReportLoad(cycles, budget, s_frames_per_half);
+#if AUDIO_TX_ALIGN
+  if (s_align_wait != 0U)
+  {
+    tx_align_block();
+  }
+#endif
+}
+
+static void rx_half_ready(uint32_t half_index)
+{
+#if APP_AUDIO_JITTER
+  jitter_stamp(&s_jit[0]);
+#endif
+  APP_TRACE(APP_TRACE_RX_HALF, half_index);
+#if AUDIO_TX_ALIGN
+  s_rx_event_cyc = AppProf_Cycles();
+#endif
+#if APP_AUDIO_DEFER_DSP
+  uint32_t n = (s_rx_post >> 1) + 1U;
+  s_rx_post = (n << 1) | (half_index & 1U);
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#else
+  rx_half_run(half_index);
+#endif
+}
+
+void AppAudio_OnPendSV(void)
+{
+#if APP_AUDIO_DEFER_DSP
+  uint32_t post = s_rx_post;
+  uint32_t n = post >> 1;
+  if (n == s_rx_done)
+  {
+    return;
+  }
+
+  if ((uint32_t)(n - s_rx_done) > 1U)
+  {
+    /* Older halves were overtaken by DMA; keep only the newest one. */
+    s_dsp_late += (n - s_rx_done) - 1U;
+  }
+  s_rx_done = n;
+  uint32_t half = post & 1U;
+
+  /* Includes time spent in any ISR that preempted the block. */
+  rx_half_run(half);
+#endif
+}
+
+void AppAudio_OnRxHalfCplt(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == s_rx_i2s)
+  {
+    audio_check_sr(hi2s);
+    rx_half_ready(0U);
+  }
+}
+
+void AppAudio_OnRxCplt(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == s_rx_i2s)
+  {
+    audio_check_sr(hi2s);
+    rx_half_ready(1U);
+  }
+}
+
+static void tx_half_ready(uint32_t half_index)
+{
+#if APP_AUDIO_JITTER
+  jitter_stamp(&s_jit[1]);
+#endif
+  APP_TRACE(APP_TRACE_TX_HALF, half_index);
+  audio_check_sr(s_tx_i2s);
+#if APP_AUDIO_SYNC_CLOCK
+  /* TX half-buffers are filled from the RX callback. */
+  (void)half_index;
+#else
+  uint32_t t0 = AppProf_Cycles();
+  tx_fill_half(half_index);
+  isr_time_update(AppProf_Cycles() - t0, &s_tx_avg_cycles, &s_tx_max_cycles);
+#endif
+}
+
+void AppAudio_OnTxHalfCplt(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == s_tx_i2s)
+  {
+    tx_half_ready(0U);
+  }
+}
+
+void AppAudio_OnTxCplt(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == s_tx_i2s)
+  {
+    tx_half_ready(1U);
+  }
+}
+
+#if APP_AUDIO_LEAN_IRQ
+/* Pending and enabled interrupts of the channel behind a HAL DMA handle.
+ * ChannelIndex is the channel's shift in ISR/IFCR, and the TC/HT/TE flags
+ * there sit at the same bits as their enables in CCR.
+ */
+static inline uint32_t dma_irq_pending(const DMA_HandleTypeDef *hdma)
+{
+  const uint32_t flags = hdma->DmaBaseAddress->ISR >> (hdma->ChannelIndex & 0x1FU);
+  return flags & hdma->Instance->CCR & (DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1);
+}
+
+static inline void dma_irq_clear(const DMA_HandleTypeDef *hdma, uint32_t flags)
+{
+  hdma->DmaBaseAddress->IFCR = flags << (hdma->ChannelIndex & 0x1FU);
+}
+
+/* Both halves pending means one of them is late: taken in order. */
+uint32_t AppAudio_OnRxDmaIrq(void)
+{
+  const DMA_HandleTypeDef *hdma = s_rx_i2s->hdmarx;
+  const uint32_t f = dma_irq_pending(hdma);
+  if ((f & DMA_ISR_TEIF1) != 0U)
+  {
+    return 0U;
+  }
+  dma_irq_clear(hdma, f);
+  if ((f & DMA_ISR_HTIF1) != 0U)
+  {
+    audio_check_sr(s_rx_i2s);
+    rx_half_ready(0U);
+  }
+  if ((f & DMA_ISR_TCIF1) != 0U)
+  {
+    audio_check_sr(s_rx_i2s);
+    rx_half_ready(1U);
+  }
+  return 1U;
+}
+
+uint32_t AppAudio_OnTxDmaIrq(void)
+{
+  const DMA_HandleTypeDef *hdma = s_tx_i2s->hdmatx;
+  const uint32_t f = dma_irq_pending(hdma);
+  if ((f & DMA_ISR_TEIF1) != 0U)
+  {
+    return 0U;
+  }
+  dma_irq_clear(hdma, f);
+  if ((f & DMA_ISR_HTIF1) != 0U)
+  {
+    tx_half_ready(0U);
+  }
+  if ((f & DMA_ISR_TCIF1) != 0U)
+  {
+    tx_half_ready(1U);
+  }
+  return 1U;
+}
+#endif
+
+void AppAudio_OnError(I2S_HandleTypeDef *hi2s)
+{
+  /* DMA transfer error: the HAL has already dropped the DMA requests. */
+  audio_error(hi2s, APP_AUDIO_ERR_DMA);
+}
+
+void AppAudio_Poll(void)
+{
+  if (!s_recover_pending)
+  {
+    return;
+  }
+
+  AppAudioErrEvent *e = &s_err_log[(s_err_seq - 1U) % APP_AUDIO_ERR_LOG_LEN];
+  if (s_audio_started)
+  {
+    (void)HAL_I2S_DMAStop(s_rx_i2s);
+    (void)HAL_I2S_DMAStop(s_tx_i2s);
+    s_audio_started = 0;
+    audio_start(0U);
+    if (s_audio_started)
+    {
+      uint32_t us = (uint32_t)(((uint64_t)(AppProf_Cycles() - s_recover_cyc) * 1000000u) / SystemCoreClock);
+      e->gap_us = us;
+      e->recovered = 1;
+      s_recoveries++;
+      s_glitch_us += us;
+    }
+  }
+  /* Errors the stop itself raised are part of this incident. */
+  s_recover_pending = 0;
+}
+
+uint32_t AppAudio_GetErrLog(AppAudioErrEvent *out, uint32_t max)
+{
+  uint32_t seq = s_err_seq;
+  uint32_t n = (seq < APP_AUDIO_ERR_LOG_LEN) ? seq : APP_AUDIO_ERR_LOG_LEN;
+  if (n > max)
+  {
+    n = max;
+  }
+  for (uint32_t i = 0; i < n; i++)
+  {
+    out[i] = s_err_log[(seq - n + i) % APP_AUDIO_ERR_LOG_LEN];
+  }
+  return n;
 }
@@ -0,0 +1,217 @@
+#include "app_ble.h"
+
+#include <stddef.h>
+
+#include "app_ring.h"
+
+#if (APP_BLE_RX_RING_SIZE & (APP_BLE_RX_RING_SIZE - 1u)) || (APP_BLE_TX_RING_SIZE & (APP_BLE_TX_RING_SIZE - 1u))
+#error "APP_BLE ring sizes must be powers of two"
+#endif
+
+static UART_HandleTypeDef *s_uart = NULL;
+
+/* Indices run free; the ISR moves w (RX) and r (TX), the main loop the
+ * other one. tx_busy is claimed by whichever side starts a chunk
+ * (AppRing_Claim()).
+ */
+static uint8_t s_rx_ring[APP_BLE_RX_RING_SIZE];
+static volatile uint32_t s_rx_w;
+static volatile uint32_t s_rx_r;
+static uint8_t s_rx_chunk[APP_BLE_RX_IT_SIZE];
+
+static uint8_t s_tx_ring[APP_BLE_TX_RING_SIZE];
+static volatile uint32_t s_tx_w;
+static volatile uint32_t s_tx_r;
+static volatile uint16_t s_tx_len;        /* in flight, 0 = idle */
+static volatile uint8_t s_tx_busy;
+
+static volatile uint32_t s_rx_lost;
+static volatile uint32_t s_errors;
+static uint32_t s_rx_bytes;
+static uint32_t s_tx_bytes;
+
+static void rx_start(void)
+{
+  (void)HAL_UARTEx_ReceiveToIdle_IT(s_uart, s_rx_chunk, (uint16_t)APP_BLE_RX_IT_SIZE);
+}
+
+/* Starts the next contiguous chunk unless one is in flight; from the main
+ * loop after a write and from the UART interrupt.
+ */
+static void tx_kick(void)
+{
+  if ((s_uart == NULL) || !AppRing_Claim(&s_tx_busy))
+  {
+    return;
+  }
+  const uint32_t r = s_tx_r;
+  const uint32_t queued = s_tx_w - r;
+  if (queued == 0u)
+  {
+    s_tx_busy = 0u;
+    return;
+  }
+  const uint32_t at = r & (APP_BLE_TX_RING_SIZE - 1u);
+  const uint32_t to_end = APP_BLE_TX_RING_SIZE - at;
+  const uint16_t len = (uint16_t)((queued < to_end) ? queued : to_end);
+  s_tx_len = len;
+  if (HAL_UART_Transmit_IT(s_uart, &s_tx_ring[at], len) != HAL_OK)
+  {
+    s_tx_len = 0u;
+    s_tx_busy = 0u;
+  }
+}
+
+void AppBle_Init(UART_HandleTypeDef *huart)
+{
+  s_rx_w = 0u;
+  s_rx_r = 0u;
+  s_tx_w = 0u;
+  s_tx_r = 0u;
+  s_tx_len = 0u;
+  s_tx_busy = 0u;
+#if APP_BLE_ENABLE
+  if (huart == NULL)
+  {
+    return;
+  }
+#if defined(APP_BLE_STATE_PORT) && defined(APP_BLE_STATE_PIN)
+  GPIO_InitTypeDef gpio = {0};
+  gpio.Pin = APP_BLE_STATE_PIN;
+  gpio.Mode = GPIO_MODE_INPUT;
+  gpio.Pull = GPIO_PULLDOWN;
+  HAL_GPIO_Init(APP_BLE_STATE_PORT, &gpio);
+#endif
+  s_uart = huart;
+  rx_start();
+#else
+  (void)huart;
+#endif
+}
+
+uint8_t AppBle_IsOpen(void)
+{
+#if defined(APP_BLE_STATE_PORT) && defined(APP_BLE_STATE_PIN)
+  return ((s_uart != NULL) && (HAL_GPIO_ReadPin(APP_BLE_STATE_PORT, APP_BLE_STATE_PIN) == GPIO_PIN_SET)) ? 1u : 0u;
+#else
+  return (s_uart != NULL) ? 1u : 0u;
+#endif
+}
+
+uint32_t AppBle_Read(uint8_t *dst, uint32_t max)
+{
+  const uint32_t r = s_rx_r;
+  const uint32_t fill = s_rx_w - r;
+  const uint32_t n = (fill < max) ? fill : max;
+  AppRing_Read(s_rx_ring, APP_BLE_RX_RING_SIZE, r, dst, n);
+  s_rx_r = r + n;
+  s_rx_bytes += n;
+  return n;
+}
+
+uint8_t AppBle_Pending(void)
+{
+  return (s_rx_w != s_rx_r) ? 1u : 0u;
+}
+
+uint8_t AppBle_Write(const uint8_t *p, uint32_t n)
+{
+  if ((p == NULL) || (n == 0u) || !AppBle_IsOpen())
+  {
+    return 1u;
+  }
+  if (AppBle_TxFree() < n)
+  {
+    return 0u;
+  }
+  const uint32_t w = s_tx_w;
+  AppRing_Write(s_tx_ring, APP_BLE_TX_RING_SIZE, w, p, n);
+  s_tx_w = w + n;
+  s_tx_bytes += n;
+  tx_kick();
+  return 1u;
+}
+
+uint32_t AppBle_TxFree(void)
+{
+  return APP_BLE_TX_RING_SIZE - (s_tx_w - s_tx_r);
+}
+
+void AppBle_Get(AppBleInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->open = AppBle_IsOpen();
+  out->rx_bytes = s_rx_bytes;
+  out->tx_bytes = s_tx_bytes;
+  out->rx_lost = s_rx_lost;
+  out->errors = s_errors;
+}
+
+static const AppMemItem k_ble_mem[] =
+{
+  APP_MEM_ITEM("ble.rx_ring", s_rx_ring),
+  APP_MEM_ITEM("ble.tx_ring", s_tx_ring),
+  APP_MEM_ITEM("ble.rx_chunk", s_rx_chunk),
+};
+
+_Static_assert((sizeof(s_rx_ring) + sizeof(s_tx_ring) + sizeof(s_rx_chunk)) <= APP_BLE_RAM_BYTES,
+               "the BLE buffers outgrew APP_BLE_RAM_BYTES");
+
+uint32_t AppBle_MemMap(const AppMemItem **items)
+{
+  *items = k_ble_mem;
+  return (uint32_t)(sizeof(k_ble_mem) / sizeof(k_ble_mem[0]));
+}
+
+void AppBle_OnUartRxEvent(UART_HandleTypeDef *huart, uint16_t size)
+{
+  if ((s_uart == NULL) || (huart != s_uart))
+  {
+    return;
+  }
+  const uint32_t n = (size > (uint16_t)APP_BLE_RX_IT_SIZE) ? APP_BLE_RX_IT_SIZE : size;
+  const uint32_t w = s_rx_w;
+  const uint32_t room = APP_BLE_RX_RING_SIZE - (w - s_rx_r);
+  const uint32_t k = (n < room) ? n : room;
+  /* Only a host ignoring CREDIT loses bytes here. */
+  s_rx_lost += n - k;
+  AppRing_Write(s_rx_ring, APP_BLE_RX_RING_SIZE, w, s_rx_chunk, k);
+  s_rx_w = w + k;
+  rx_start();
+}
+
+void AppBle_OnUartTxCplt(UART_HandleTypeDef *huart)
+{
+  if ((s_uart == NULL) || (huart != s_uart))
+  {
+    return;
+  }
+  s_tx_r += s_tx_len;
+  s_tx_len = 0u;
+  __DMB();
+  s_tx_busy = 0u;
+  tx_kick();
+}
+
+void AppBle_OnUartError(UART_HandleTypeDef *huart)
+{
+  if ((s_uart == NULL) || (huart != s_uart))
+  {
+    return;
+  }
+  s_errors++;
+  /* The HAL aborted the transfers the error hit; start both again (the
+   * chunk in flight goes out whole once more).
+   */
+  (void)HAL_UART_AbortReceive(s_uart);
+  rx_start();
+  if (s_uart->gState == HAL_UART_STATE_READY)
+  {
+    s_tx_len = 0u;
+    s_tx_busy = 0u;
+    tx_kick();
+  }
+}
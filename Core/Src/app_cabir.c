@@ -0,0 +1,738 @@
+#include "app_cabir.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if APP_CABIR_ENABLE
+
+#include <math.h>
+
+#include "stm32g4xx_hal.h"
+
+#if APP_CABIR_USE_CMSIS
+#include "arm_common_tables.h"
+#include "arm_const_structs.h"
+#include "arm_math.h"
+#endif
+
+/*
+ * Partitioned convolution.
+ * - Flash: an index page of CabIrRecords, then the slots, each one packed
+ *   spectrum of CABIR_FFT_LEN floats per partition. Records are appended:
+ *   the last one naming a slot describes it (taps 0 = cleared), and it is
+ *   programmed after the spectra, so a record whose CRC-32 matches them
+ *   means the whole set made it. A full index page is compacted to the
+ *   live records. Init checks every slot once; the audio side only looks
+ *   up s_slot_parts.
+ * - The convolver reads the selected slot's spectra in place, each IR
+ *   value loaded once for both channels; only the first
+ *   APP_CABIR_RAM_PARTS partitions are copied to s_ram when the slot is
+ *   selected or rewritten (s_gen).
+ * - s_tbuf[ch] holds the time window [previous partition | current one];
+ *   the current half fills from the audio path.
+ * - s_fdl is a ring of input spectra, newest at s_head. Output spectrum =
+ *   sum over p of fdl[head - p] * ir[p]; of its inverse FFT only the last
+ *   PARTITION samples are linear convolution (overlap-save).
+ * - s_fdl is not ours: the DSP arena lends it (AppCabIr_Attach()), in an
+ *   overlay with the reverb tank, and takes it back while the reverb runs.
+ *   Only the audio side touches it; Reset() just flags the history, and the
+ *   next Active() clears it.
+ * - The staged taps have their own buffer, as the line may be lent out
+ *   while an upload runs; COMMIT uses the FFT work buffers.
+ * - The inverse FFT writes into the oldest spectrum of the line: the MACs
+ *   are done with it and the next run overwrites it first.
+ * - Direct mode (block a multiple of the partition, s_pos at 0): each
+ *   Convolve() runs the partition just written. Otherwise the outputs come
+ *   from the previous partition and the next Chunk() after the boundary
+ *   runs the full one.
+ */
+
+#define CABIR_MAGIC          0x32494243u  /* "CBI2" */
+#define CABIR_FFT_LEN        (2u * APP_CABIR_PARTITION)
+#define CABIR_PARTS_MAX      (APP_CABIR_TAPS_MAX / APP_CABIR_PARTITION)
+#define CABIR_RAM_PARTS      ((APP_CABIR_RAM_PARTS < CABIR_PARTS_MAX) ? APP_CABIR_RAM_PARTS : CABIR_PARTS_MAX)
+
+_Static_assert((APP_CABIR_TAPS_MAX % APP_CABIR_PARTITION) == 0u, "APP_CABIR_TAPS_MAX must be a multiple of the partition");
+_Static_assert(APP_CABIR_TAPS_MAX <= 1024u, "APP_CABIR_TAPS_MAX is at most 1024");
+_Static_assert(FLASH_PAGE_SIZE == 2048u, "APP_CABIR_SLOT_PAGES assumes 2 KB pages");
+_Static_assert((APP_CABIR_SLOTS >= 1u) && (APP_CABIR_SLOTS <= APP_DSP_CAB_IR_SLOTS),
+               "APP_CABIR_SLOTS must be 1..APP_DSP_CAB_IR_SLOTS");
+_Static_assert((1u + (APP_CABIR_SLOTS * APP_CABIR_SLOT_PAGES)) <= APP_CABIR_FLASH_PAGES,
+               "the IR pages cannot hold the index and APP_CABIR_SLOTS slots");
+
+typedef struct
+{
+  uint32_t magic;
+  uint8_t slot;
+  uint8_t reserved0;
+  uint16_t taps;           /* 0: the slot was cleared */
+  uint16_t partition;      /* APP_CABIR_PARTITION the spectra were made for */
+  uint16_t reserved1;
+  uint32_t crc;            /* CRC-32 of the spectra */
+} CabIrRecord;
+
+_Static_assert((sizeof(CabIrRecord) % 8u) == 0u, "CabIrRecord must be a whole number of double-words");
+
+#define CABIR_RECORDS        (FLASH_PAGE_SIZE / sizeof(CabIrRecord))
+#define CABIR_INDEX          ((const CabIrRecord *)(uintptr_t)APP_CABIR_FLASH_ADDR)
+#define CABIR_SLOT_PAGE(s)   (1u + ((s) * APP_CABIR_SLOT_PAGES))
+#define CABIR_IR(s)          ((const float *)(uintptr_t)(APP_CABIR_FLASH_ADDR + (CABIR_SLOT_PAGE(s) * FLASH_PAGE_SIZE)))
+
+_Static_assert(APP_CABIR_FDL_BYTES == (APP_CABIR_CHANNELS * CABIR_PARTS_MAX * CABIR_FFT_LEN * sizeof(float)),
+               "APP_CABIR_FDL_BYTES does not match the line");
+
+static float (*s_fdl)[CABIR_PARTS_MAX][CABIR_FFT_LEN] = NULL;
+static int16_t s_stage[APP_CABIR_TAPS_MAX];   /* upload staging, LOADING only */
+
+static float s_tbuf[APP_CABIR_CHANNELS][CABIR_FFT_LEN];
+static float s_out[APP_CABIR_CHANNELS][APP_CABIR_PARTITION];
+static float s_work[CABIR_FFT_LEN];
+static float s_spec[CABIR_FFT_LEN];
+#if CABIR_RAM_PARTS > 0u
+APP_CCM_BSS static float s_ram[CABIR_RAM_PARTS][CABIR_FFT_LEN];
+#endif
+
+static volatile AppCabIrState s_state = APP_CABIR_EMPTY;
+static volatile uint32_t s_slot_parts[APP_CABIR_SLOTS];  /* 0 = no IR to run */
+static uint16_t s_slot_taps[APP_CABIR_SLOTS];
+static volatile uint32_t s_gen = 0;   /* bumped when a slot is rewritten */
+static uint32_t s_records = 0;        /* index records in use */
+static uint32_t s_load_slot = 0;
+static uint32_t s_load_taps = 0;
+static volatile uint32_t s_sel = 0;   /* audio side from here */
+static uint32_t s_sel_gen = 0;
+static const float *s_ir = NULL;
+static uint32_t s_parts = 0;
+static uint32_t s_run_parts = 0;  /* of those, convolved (AppCabIr_Limit()) */
+static uint32_t s_head = 0;
+static uint32_t s_pos = 0;       /* frames of the current partition written */
+static uint8_t s_direct = 0;
+static uint8_t s_pending = 0;    /* a full partition waits for its FFTs */
+static volatile uint8_t s_clear = 1;  /* history to clear before the next run */
+
+#if APP_CABIR_USE_CMSIS
+/* N = 2 * PARTITION over the CFFT of N / 2. Filled by hand:
+ * arm_rfft_fast_init_f32() references the tables of every length and would
+ * pull all of them into the image.
+ */
+#if APP_CABIR_PARTITION == 32u
+#define CABIR_CFFT           arm_cfft_sR_f32_len32
+#define CABIR_RFFT_TWIDDLE   twiddleCoef_rfft_64
+#elif APP_CABIR_PARTITION == 64u
+#define CABIR_CFFT           arm_cfft_sR_f32_len64
+#define CABIR_RFFT_TWIDDLE   twiddleCoef_rfft_128
+#elif APP_CABIR_PARTITION == 128u
+#define CABIR_CFFT           arm_cfft_sR_f32_len128
+#define CABIR_RFFT_TWIDDLE   twiddleCoef_rfft_256
+#else
+#error "APP_CABIR_PARTITION must be 32, 64 or 128"
+#endif
+
+static arm_rfft_fast_instance_f32 s_rfft;
+
+static void cabir_fft_init(void)
+{
+  s_rfft.Sint = CABIR_CFFT;
+  s_rfft.fftLenRFFT = (uint16_t)CABIR_FFT_LEN;
+  s_rfft.pTwiddleRFFT = (float32_t *)CABIR_RFFT_TWIDDLE;
+}
+
+/* Packed spectrum {X0.re, X(N/2).re, X1.re, X1.im, ...}; 'in' is used as
+ * scratch. The inverse scales by 1/N.
+ */
+static inline void cabir_rfft(float *in, float *out, uint8_t inverse)
+{
+  arm_rfft_fast_f32(&s_rfft, in, out, inverse);
+}
+#else
+/* arm_rfft_fast_f32() as a plain DFT, O(N^2): host builds only. */
+static float s_dft_cos[CABIR_FFT_LEN];
+
+static void cabir_fft_init(void)
+{
+  for (uint32_t i = 0; i < CABIR_FFT_LEN; i++)
+  {
+    s_dft_cos[i] = (float)cos((6.283185307179586 * (double)i) / (double)CABIR_FFT_LEN);
+  }
+}
+
+static void cabir_rfft(float *in, float *out, uint8_t inverse)
+{
+  const uint32_t n = CABIR_FFT_LEN;
+  const uint32_t quarter = n / 4u;   /* sin(a) = cos(a - pi/2) */
+  if (!inverse)
+  {
+    for (uint32_t k = 0; k <= (n / 2u); k++)
+    {
+      float re = 0.0f;
+      float im = 0.0f;
+      for (uint32_t t = 0; t < n; t++)
+      {
+        const uint32_t a = (k * t) % n;
+        re += in[t] * s_dft_cos[a];
+        im -= in[t] * s_dft_cos[(a + n - quarter) % n];
+      }
+      if (k == 0u)
+      {
+        out[0] = re;
+      }
+      else if (k == (n / 2u))
+      {
+        out[1] = re;
+      }
+      else
+      {
+        out[2u * k] = re;
+        out[(2u * k) + 1u] = im;
+      }
+    }
+    return;
+  }
+  for (uint32_t t = 0; t < n; t++)
+  {
+    float acc = in[0] + (((t & 1u) != 0u) ? -in[1] : in[1]);
+    for (uint32_t k = 1; k < (n / 2u); k++)
+    {
+      const uint32_t a = (k * t) % n;
+      acc += 2.0f * ((in[2u * k] * s_dft_cos[a]) - (in[(2u * k) + 1u] * s_dft_cos[(a + n - quarter) % n]));
+    }
+    out[t] = acc / (float)n;
+  }
+}
+#endif
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++)
+  {
+    crc ^= p[i];
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return crc;
+}
+
+static uint32_t ir_bytes(uint32_t parts)
+{
+  return parts * CABIR_FFT_LEN * (uint32_t)sizeof(float);
+}
+
+static uint32_t ir_parts(uint32_t taps)
+{
+  return (taps + APP_CABIR_PARTITION - 1u) / APP_CABIR_PARTITION;
+}
+
+/* 'page' of the IR region. */
+static uint8_t flash_erase(uint32_t page, uint32_t pages)
+{
+  FLASH_EraseInitTypeDef erase = {0};
+  uint32_t bad_page = 0;
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Banks = FLASH_BANK_1;
+  erase.Page = ((APP_CABIR_FLASH_ADDR - FLASH_BASE) / FLASH_PAGE_SIZE) + page;
+  erase.NbPages = pages;
+
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  HAL_StatusTypeDef st = HAL_FLASHEx_Erase(&erase, &bad_page);
+  HAL_FLASH_Lock();
+  return (st == HAL_OK) ? 1u : 0u;
+}
+
+/* len is a multiple of 8. */
+static uint8_t flash_program(uint32_t addr, const void *src, uint32_t len)
+{
+  HAL_StatusTypeDef st = HAL_OK;
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  for (uint32_t i = 0; (i < (len / 8u)) && (st == HAL_OK); i++)
+  {
+    uint64_t dw;
+    memcpy(&dw, (const uint8_t *)src + (i * 8u), sizeof(dw));
+    st = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, addr + (i * 8u), dw);
+  }
+  HAL_FLASH_Lock();
+  return ((st == HAL_OK) && (memcmp((const void *)(uintptr_t)addr, src, len) == 0)) ? 1u : 0u;
+}
+
+static uint8_t record_blank(const CabIrRecord *r)
+{
+  const uint32_t *w = (const uint32_t *)r;
+  for (uint32_t i = 0; i < (sizeof(*r) / 4u); i++)
+  {
+    if (w[i] != 0xFFFFFFFFu)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* The last record of each slot, NULL for none; returns the records in use
+ * (all of the page if one is neither blank nor valid).
+ */
+static uint32_t index_scan(const CabIrRecord *last[APP_CABIR_SLOTS])
+{
+  for (uint32_t s = 0; s < APP_CABIR_SLOTS; s++)
+  {
+    last[s] = NULL;
+  }
+  for (uint32_t i = 0; i < CABIR_RECORDS; i++)
+  {
+    const CabIrRecord *r = &CABIR_INDEX[i];
+    if (record_blank(r))
+    {
+      return i;
+    }
+    if (r->magic != CABIR_MAGIC)
+    {
+      return CABIR_RECORDS;
+    }
+    if (r->slot < APP_CABIR_SLOTS)
+    {
+      last[r->slot] = r;
+    }
+  }
+  return CABIR_RECORDS;
+}
+
+/* Taps of the slot's IR if its record and spectra check out, else 0. */
+static uint32_t slot_check(uint32_t slot, const CabIrRecord *r)
+{
+  if ((r == NULL) || (r->partition != APP_CABIR_PARTITION) ||
+      (r->taps == 0u) || (r->taps > APP_CABIR_TAPS_MAX))
+  {
+    return 0;
+  }
+  if (r->crc != ~crc32_update(0xFFFFFFFFu, (const uint8_t *)CABIR_IR(slot), ir_bytes(ir_parts(r->taps))))
+  {
+    return 0;
+  }
+  return r->taps;
+}
+
+/* Appends a record; a full page is first rewritten with the last record of
+ * every other slot that still has one.
+ */
+static uint8_t index_append(const CabIrRecord *rec)
+{
+  if (s_records >= CABIR_RECORDS)
+  {
+    const CabIrRecord *last[APP_CABIR_SLOTS];
+    CabIrRecord keep[APP_CABIR_SLOTS];
+    uint32_t n = 0;
+    (void)index_scan(last);
+    for (uint32_t s = 0; s < APP_CABIR_SLOTS; s++)
+    {
+      if ((s != rec->slot) && (s_slot_parts[s] != 0u) && (last[s] != NULL))
+      {
+        keep[n++] = *last[s];
+      }
+    }
+    if (!flash_erase(0u, 1u) ||
+        ((n != 0u) && !flash_program(APP_CABIR_FLASH_ADDR, keep, n * (uint32_t)sizeof(keep[0]))))
+    {
+      s_records = CABIR_RECORDS;
+      return 0;
+    }
+    s_records = n;
+  }
+  const uint8_t ok = flash_program((uint32_t)(uintptr_t)&CABIR_INDEX[s_records], rec, (uint32_t)sizeof(*rec));
+  s_records++;
+  return ok;
+}
+
+void AppCabIr_Reset(void)
+{
+  s_clear = 1;
+}
+
+void AppCabIr_Attach(void *fdl)
+{
+  s_fdl = (float (*)[CABIR_PARTS_MAX][CABIR_FFT_LEN])fdl;
+  s_clear = 1;
+}
+
+void AppCabIr_Init(void)
+{
+  const CabIrRecord *last[APP_CABIR_SLOTS];
+  cabir_fft_init();
+  s_state = APP_CABIR_LOADING;
+  s_records = index_scan(last);
+  uint8_t any = 0;
+  for (uint32_t s = 0; s < APP_CABIR_SLOTS; s++)
+  {
+    const uint32_t taps = slot_check(s, last[s]);
+    s_slot_taps[s] = (uint16_t)taps;
+    s_slot_parts[s] = ir_parts(taps);
+    any |= (taps != 0u) ? 1u : 0u;
+  }
+  s_gen = s_gen + 1u;
+  s_state = any ? APP_CABIR_ACTIVE : APP_CABIR_EMPTY;
+}
+
+void AppCabIr_GetInfo(AppCabIrInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->state = s_state;
+  out->slot = (s_state == APP_CABIR_LOADING) ? s_load_slot : s_sel;
+  out->taps = (s_state == APP_CABIR_LOADING) ? s_load_taps : s_slot_taps[out->slot];
+  out->partitions = ir_parts(out->taps);
+  memcpy(out->slot_taps, s_slot_taps, sizeof(out->slot_taps));
+}
+
+uint8_t AppCabIr_Begin(uint32_t slot, uint32_t taps)
+{
+  if ((slot >= APP_CABIR_SLOTS) || (taps == 0u) || (taps > APP_CABIR_TAPS_MAX))
+  {
+    return 0;
+  }
+  s_state = APP_CABIR_LOADING;
+  s_slot_parts[slot] = 0u;
+  s_slot_taps[slot] = 0u;
+  memset(s_stage, 0, sizeof(s_stage));
+  s_load_slot = slot;
+  s_load_taps = taps;
+  return 1;
+}
+
+uint8_t AppCabIr_Write(uint32_t offset, const int16_t *taps, uint32_t n)
+{
+  if ((s_state != APP_CABIR_LOADING) || (taps == NULL) ||
+      (offset > s_load_taps) || (n > (s_load_taps - offset)))
+  {
+    return 0;
+  }
+  memcpy(&s_stage[offset], taps, n * sizeof(taps[0]));
+  return 1;
+}
+
+uint8_t AppCabIr_Commit(void)
+{
+  if (s_state != APP_CABIR_LOADING)
+  {
+    return 0;
+  }
+  const uint32_t slot = s_load_slot;
+  const uint32_t parts = ir_parts(s_load_taps);
+  const float *ir = CABIR_IR(slot);
+  if (!flash_erase(CABIR_SLOT_PAGE(slot), APP_CABIR_SLOT_PAGES))
+  {
+    AppCabIr_Init();
+    return 0;
+  }
+
+  /* Partition p: taps [p * PARTITION, +PARTITION), zero-padded to N. */
+  uint32_t crc = 0xFFFFFFFFu;
+  uint8_t ok = 1;
+  for (uint32_t p = 0; (p < parts) && ok; p++)
+  {
+    memset(s_work, 0, sizeof(s_work));
+    for (uint32_t k = 0; k < APP_CABIR_PARTITION; k++)
+    {
+      const uint32_t t = (p * APP_CABIR_PARTITION) + k;
+      s_work[k] = (t < s_load_taps) ? ((float)s_stage[t] * (1.0f / 32768.0f)) : 0.0f;
+    }
+    cabir_rfft(s_work, s_spec, 0u);
+    crc = crc32_update(crc, (const uint8_t *)s_spec, (uint32_t)sizeof(s_spec));
+    ok = flash_program((uint32_t)(uintptr_t)(ir + (p * CABIR_FFT_LEN)), s_spec, (uint32_t)sizeof(s_spec));
+  }
+
+  CabIrRecord r;
+  memset(&r, 0xFF, sizeof(r));
+  r.magic = CABIR_MAGIC;
+  r.slot = (uint8_t)slot;
+  r.taps = (uint16_t)s_load_taps;
+  r.partition = (uint16_t)APP_CABIR_PARTITION;
+  r.crc = ~crc;
+  if (ok)
+  {
+    ok = index_append(&r);
+  }
+
+  /* Whatever made it to flash is what runs. */
+  AppCabIr_Init();
+  return (ok && (s_slot_parts[slot] != 0u)) ? 1u : 0u;
+}
+
+uint8_t AppCabIr_Clear(uint32_t slot)
+{
+  if (slot >= APP_CABIR_SLOTS)
+  {
+    return 0;
+  }
+  s_state = APP_CABIR_LOADING;
+  s_slot_parts[slot] = 0u;
+  CabIrRecord r;
+  memset(&r, 0xFF, sizeof(r));
+  r.magic = CABIR_MAGIC;
+  r.slot = (uint8_t)slot;
+  r.taps = 0u;
+  const uint8_t ok = index_append(&r);
+  AppCabIr_Init();
+  return ok;
+}
+
+uint8_t AppCabIr_Active(uint32_t slot)
+{
+  if ((slot >= APP_CABIR_SLOTS) || (s_fdl == NULL))
+  {
+    return 0;
+  }
+  const uint32_t parts = s_slot_parts[slot];
+  if (parts == 0u)
+  {
+    return 0;
+  }
+  const uint32_t gen = s_gen;
+  if ((slot != s_sel) || (gen != s_sel_gen) || (s_ir == NULL))
+  {
+    /* The history is input spectra: it carries over to the new IR. */
+    s_sel = slot;
+    s_sel_gen = gen;
+    s_ir = CABIR_IR(slot);
+#if CABIR_RAM_PARTS > 0u
+    memcpy(s_ram, s_ir, sizeof(s_ram));
+#endif
+  }
+  s_parts = parts;
+  if (s_clear)
+  {
+    s_clear = 0;
+    memset(s_fdl, 0, APP_CABIR_FDL_BYTES);
+    memset(s_tbuf, 0, sizeof(s_tbuf));
+    memset(s_out, 0, sizeof(s_out));
+    s_head = 0;
+    s_pos = 0;
+    s_direct = 0;
+    s_pending = 0;
+  }
+  return 1;
+}
+
+/* acc[ch] += x[ch] * h on packed spectra: bins 0 and N/2 are real. h is
+ * flash: each value is loaded once for every channel.
+ */
+static inline void cabir_mac(float *const acc[APP_CABIR_CHANNELS], const float *const x[APP_CABIR_CHANNELS],
+                             const float *h)
+{
+  const float h0 = h[0];
+  const float h1 = h[1];
+  for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+  {
+    acc[ch][0] += x[ch][0] * h0;
+    acc[ch][1] += x[ch][1] * h1;
+  }
+  for (uint32_t k = 2; k < CABIR_FFT_LEN; k += 2u)
+  {
+    const float hr = h[k];
+    const float hi = h[k + 1u];
+    for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+    {
+      const float xr = x[ch][k];
+      const float xi = x[ch][k + 1u];
+      acc[ch][k] += (xr * hr) - (xi * hi);
+      acc[ch][k + 1u] += (xr * hi) + (xi * hr);
+    }
+  }
+}
+
+/* Partition p of the selected IR, from RAM if it was copied there. */
+static inline const float *cabir_part(uint32_t p)
+{
+#if CABIR_RAM_PARTS > 0u
+  if (p < CABIR_RAM_PARTS)
+  {
+    return s_ram[p];
+  }
+#endif
+  return &s_ir[p * CABIR_FFT_LEN];
+}
+
+/* Both forward FFTs first: s_work is scratch for them, then the second
+ * channel's accumulator.
+ */
+APP_CCM_CODE static void cabir_run(void)
+{
+  float *acc[APP_CABIR_CHANNELS];
+  const float *x[APP_CABIR_CHANNELS];
+  const uint32_t next = (s_head + 1u) % CABIR_PARTS_MAX;
+  for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+  {
+    memcpy(s_work, s_tbuf[ch], sizeof(s_work));
+    cabir_rfft(s_work, s_fdl[ch][s_head], 0u);
+    memcpy(s_tbuf[ch], &s_tbuf[ch][APP_CABIR_PARTITION], APP_CABIR_PARTITION * sizeof(float));
+  }
+  acc[0] = s_spec;
+#if APP_CABIR_CHANNELS > 1u
+  acc[1] = s_work;
+#endif
+  for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+  {
+    memset(acc[ch], 0, CABIR_FFT_LEN * sizeof(float));
+  }
+
+  for (uint32_t p = 0; p < s_run_parts; p++)
+  {
+    const uint32_t slot = (s_head + CABIR_PARTS_MAX - p) % CABIR_PARTS_MAX;
+    for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+    {
+      x[ch] = s_fdl[ch][slot];
+    }
+    cabir_mac(acc, x, cabir_part(p));
+  }
+  for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+  {
+    cabir_rfft(acc[ch], s_fdl[ch][next], 1u);
+    memcpy(s_out[ch], &s_fdl[ch][next][APP_CABIR_PARTITION], sizeof(s_out[ch]));
+  }
+  s_head = next;
+}
+
+APP_CCM_CODE void AppCabIr_Limit(uint32_t shift)
+{
+  const uint32_t parts = s_parts >> shift;
+  s_run_parts = (parts != 0u) ? parts : 1u;
+}
+
+APP_CCM_CODE uint32_t AppCabIr_Chunk(uint32_t n, float *in[APP_CABIR_CHANNELS])
+{
+  if (s_pending)
+  {
+    cabir_run();
+    s_pending = 0;
+    s_pos = 0;
+  }
+  s_direct = ((s_pos == 0u) && ((n % APP_CABIR_PARTITION) == 0u)) ? 1u : 0u;
+  const uint32_t room = APP_CABIR_PARTITION - s_pos;
+  for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+  {
+    in[ch] = &s_tbuf[ch][APP_CABIR_PARTITION + s_pos];
+  }
+  return (n < room) ? n : room;
+}
+
+APP_CCM_CODE void AppCabIr_Convolve(uint32_t m, const float *out[APP_CABIR_CHANNELS])
+{
+  if (s_direct)
+  {
+    cabir_run();
+  }
+  for (uint32_t ch = 0; ch < APP_CABIR_CHANNELS; ch++)
+  {
+    out[ch] = &s_out[ch][s_direct ? 0u : s_pos];
+  }
+  if (!s_direct)
+  {
+    s_pos += m;
+    s_pending = (s_pos == APP_CABIR_PARTITION) ? 1u : 0u;
+  }
+}
+
+static const AppMemItem k_cabir_mem[] =
+{
+  APP_MEM_ITEM("cabir.stage", s_stage),
+  APP_MEM_ITEM("cabir.tbuf", s_tbuf),
+  APP_MEM_ITEM("cabir.out", s_out),
+  APP_MEM_ITEM("cabir.work", s_work),
+  APP_MEM_ITEM("cabir.spec", s_spec),
+#if CABIR_RAM_PARTS > 0u
+  APP_MEM_ITEM("cabir.ram", s_ram),
+#endif
+};
+
+_Static_assert((sizeof(s_stage) + sizeof(s_tbuf) + sizeof(s_out) + sizeof(s_work) + sizeof(s_spec) +
+                (CABIR_RAM_PARTS * CABIR_FFT_LEN * sizeof(float))) <= APP_CABIR_RAM_BYTES,
+               "the cab IR buffers outgrew APP_CABIR_RAM_BYTES");
+
+uint32_t AppCabIr_MemMap(const AppMemItem **items)
+{
+  *items = k_cabir_mem;
+  return (uint32_t)(sizeof(k_cabir_mem) / sizeof(k_cabir_mem[0]));
+}
+
+#else
+
+void AppCabIr_Init(void)
+{
+}
+
+void AppCabIr_GetInfo(AppCabIrInfo *out)
+{
+  if (out != NULL)
+  {
+    memset(out, 0, sizeof(*out));
+  }
+}
+
+uint8_t AppCabIr_Begin(uint32_t slot, uint32_t taps)
+{
+  (void)slot;
+  (void)taps;
+  return 0;
+}
+
+uint8_t AppCabIr_Write(uint32_t offset, const int16_t *taps, uint32_t n)
+{
+  (void)offset;
+  (void)taps;
+  (void)n;
+  return 0;
+}
+
+uint8_t AppCabIr_Commit(void)
+{
+  return 0;
+}
+
+uint8_t AppCabIr_Clear(uint32_t slot)
+{
+  (void)slot;
+  return 0;
+}
+
+uint8_t AppCabIr_Active(uint32_t slot)
+{
+  (void)slot;
+  return 0;
+}
+
+uint32_t AppCabIr_Chunk(uint32_t n, float *in[APP_CABIR_CHANNELS])
+{
+  (void)n;
+  (void)in;
+  return 0;
+}
+
+void AppCabIr_Convolve(uint32_t m, const float *out[APP_CABIR_CHANNELS])
+{
+  (void)m;
+  (void)out;
+}
+
+void AppCabIr_Limit(uint32_t shift)
+{
+  (void)shift;
+}
+
+void AppCabIr_Reset(void)
+{
+}
+
+void AppCabIr_Attach(void *fdl)
+{
+  (void)fdl;
+}
+
+uint32_t AppCabIr_MemMap(const AppMemItem **items)
+{
+  *items = NULL;
+  return 0u;
+}
+
+#endif /* APP_CABIR_ENABLE */
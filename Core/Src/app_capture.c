@@ -0,0 +1,208 @@
+#include "app_capture.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Capture / injection buffer.
+ * - The main loop sets the run up and flips s_state to ARMED last; the audio
+ *   side starts it at the head of the next block and ends it (DONE), so
+ *   each field has one writer at a time.
+ * - Injection reads s_buf[s_inj_pos] at the chain head, capture writes
+ *   s_buf[s_cap_pos] later in the same block; s_cap_pos * decim never passes
+ *   s_inj_pos, so the response overwrites only stimulus already played.
+ */
+
+#if APP_CAPTURE_ENABLE
+
+static int16_t s_buf[APP_CAPTURE_SAMPLES];
+static volatile AppCaptureState s_state = APP_CAPTURE_IDLE;
+static AppMeterTap s_tap = APP_METER_TAP_OUTPUT;
+static uint32_t s_decim_shift = 0;
+static uint32_t s_count = 0;
+static uint32_t s_inject = 0;
+static uint32_t s_inj_pos = 0;
+static volatile uint32_t s_cap_pos = 0;
+static int32_t s_acc = 0;
+static uint32_t s_acc_n = 0;
+
+uint8_t AppCapture_Arm(AppMeterTap tap, uint32_t decim, uint32_t count, uint32_t inject)
+{
+  uint32_t shift = 0;
+  while ((shift < 4u) && ((1u << shift) != decim))
+  {
+    shift++;
+  }
+  if (count == 0u)
+  {
+    count = APP_CAPTURE_SAMPLES;
+  }
+  if ((s_state == APP_CAPTURE_ARMED) || (s_state == APP_CAPTURE_RUNNING) ||
+      ((uint32_t)tap >= (uint32_t)APP_METER_TAP_COUNT) || (shift >= 4u) ||
+      (count > APP_CAPTURE_SAMPLES) || (inject > APP_CAPTURE_SAMPLES))
+  {
+    return 0;
+  }
+
+  s_tap = tap;
+  s_decim_shift = shift;
+  s_count = count;
+  s_inject = inject;
+  s_inj_pos = 0;
+  s_cap_pos = 0;
+  s_acc = 0;
+  s_acc_n = 0;
+  s_state = APP_CAPTURE_ARMED;
+  return 1;
+}
+
+void AppCapture_Abort(void)
+{
+  s_state = APP_CAPTURE_IDLE;
+}
+
+void AppCapture_GetInfo(AppCaptureInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->state = s_state;
+  out->tap = s_tap;
+  out->decim = 1u << s_decim_shift;
+  out->count = s_count;
+  out->done = s_cap_pos;
+  out->inject = s_inject;
+}
+
+uint8_t AppCapture_Write(uint32_t offset, const int16_t *s, uint32_t n)
+{
+  if ((s_state == APP_CAPTURE_ARMED) || (s_state == APP_CAPTURE_RUNNING) ||
+      (offset > APP_CAPTURE_SAMPLES) || (n > (APP_CAPTURE_SAMPLES - offset)))
+  {
+    return 0;
+  }
+  memcpy(&s_buf[offset], s, n * sizeof(s_buf[0]));
+  return 1;
+}
+
+const int16_t *AppCapture_Data(void)
+{
+  return s_buf;
+}
+
+void AppCapture_Input(AppStereoS24 *x, uint32_t n)
+{
+  if (s_state == APP_CAPTURE_ARMED)
+  {
+    s_state = APP_CAPTURE_RUNNING;
+  }
+  if ((s_state != APP_CAPTURE_RUNNING) || (s_inject == 0u))
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const int32_t v = (s_inj_pos < s_inject) ? ((int32_t)s_buf[s_inj_pos] * 256) : 0;
+    s_inj_pos++;
+    x[i].l = v;
+    x[i].r = v;
+  }
+}
+
+void AppCapture_Tap(AppMeterTap tap, const AppStereoS24 *x, uint32_t n, uint8_t mono)
+{
+  if ((tap != s_tap) || (s_state != APP_CAPTURE_RUNNING))
+  {
+    return;
+  }
+  const uint32_t decim = 1u << s_decim_shift;
+  uint32_t pos = s_cap_pos;
+  for (uint32_t i = 0; (i < n) && (pos < s_count); i++)
+  {
+    s_acc += mono ? x[i].l : ((x[i].l + x[i].r) >> 1);
+    if (++s_acc_n == decim)
+    {
+      /* Box average, then s24 -> s16. */
+      s_buf[pos++] = (int16_t)(s_acc >> (s_decim_shift + 8u));
+      s_acc = 0;
+      s_acc_n = 0;
+    }
+  }
+  s_cap_pos = pos;
+  if (pos >= s_count)
+  {
+    s_state = APP_CAPTURE_DONE;
+  }
+}
+
+static const AppMemItem k_capture_mem[] =
+{
+  APP_MEM_ITEM("capture.buf", s_buf),
+};
+
+_Static_assert(sizeof(s_buf) <= APP_CAPTURE_RAM_BYTES, "the capture buffer outgrew APP_CAPTURE_RAM_BYTES");
+
+uint32_t AppCapture_MemMap(const AppMemItem **items)
+{
+  *items = k_capture_mem;
+  return 1u;
+}
+
+#else
+
+uint8_t AppCapture_Arm(AppMeterTap tap, uint32_t decim, uint32_t count, uint32_t inject)
+{
+  (void)tap;
+  (void)decim;
+  (void)count;
+  (void)inject;
+  return 0;
+}
+
+void AppCapture_Abort(void)
+{
+}
+
+void AppCapture_GetInfo(AppCaptureInfo *out)
+{
+  if (out != NULL)
+  {
+    memset(out, 0, sizeof(*out));
+  }
+}
+
+uint8_t AppCapture_Write(uint32_t offset, const int16_t *s, uint32_t n)
+{
+  (void)offset;
+  (void)s;
+  (void)n;
+  return 0;
+}
+
+const int16_t *AppCapture_Data(void)
+{
+  return NULL;
+}
+
+void AppCapture_Input(AppStereoS24 *x, uint32_t n)
+{
+  (void)x;
+  (void)n;
+}
+
+void AppCapture_Tap(AppMeterTap tap, const AppStereoS24 *x, uint32_t n, uint8_t mono)
+{
+  (void)tap;
+  (void)x;
+  (void)n;
+  (void)mono;
+}
+
+uint32_t AppCapture_MemMap(const AppMemItem **items)
+{
+  *items = NULL;
+  return 0u;
+}
+
+#endif /* APP_CAPTURE_ENABLE */
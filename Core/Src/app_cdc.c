@@ -0,0 +1,272 @@
+#include "app_cdc.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if ((APP_CDC_RX_RING_SIZE & (APP_CDC_RX_RING_SIZE - 1u)) != 0u) || \
+    ((APP_CDC_TX_RING_SIZE & (APP_CDC_TX_RING_SIZE - 1u)) != 0u)
+#error "APP_CDC_RX_RING_SIZE and APP_CDC_TX_RING_SIZE must be powers of two"
+#endif
+
+/* CDC PSTN requests (PSTN120 6.3). */
+#define CDC_REQ_SET_LINE_CODING        0x20u
+#define CDC_REQ_GET_LINE_CODING        0x21u
+#define CDC_REQ_SET_CONTROL_LINE_STATE 0x22u
+#define CDC_REQ_SEND_BREAK             0x23u
+#define CDC_LINE_CODING_LEN            7u
+#define CDC_DTR                        0x0001u
+
+/* RX ring: written by the USB interrupt, read by the main loop; the TX
+ * ring the other way round. Running byte counts, masked to index.
+ */
+static uint8_t s_rx_ring[APP_CDC_RX_RING_SIZE];
+static volatile uint32_t s_rx_w;
+static volatile uint32_t s_rx_r;
+static volatile uint8_t s_rx_held;       /* OUT not armed until the ring has a packet free */
+static uint8_t s_rx_pkt[APP_CDC_PKT_SIZE];
+
+static uint8_t s_tx_ring[APP_CDC_TX_RING_SIZE];
+static volatile uint32_t s_tx_w;
+static volatile uint32_t s_tx_r;
+static volatile uint8_t s_tx_busy;       /* a packet is on the endpoint */
+static uint8_t s_tx_zlp;                 /* the last one was full: end with a zero-length one */
+
+static volatile uint8_t s_configured;
+static volatile uint8_t s_dtr;
+/* dwDTERate, bCharFormat, bParityType, bDataBits: 115200 8N1 until set. */
+static uint8_t s_coding[CDC_LINE_CODING_LEN] = {0x00u, 0xC2u, 0x01u, 0x00u, 0u, 0u, 8u};
+
+static volatile uint32_t s_rx_bytes;
+static volatile uint32_t s_tx_bytes;
+static volatile uint32_t s_tx_drops;
+static volatile uint32_t s_rx_stalls;
+
+static uint32_t rx_free(void)
+{
+  return APP_CDC_RX_RING_SIZE - (s_rx_w - s_rx_r);
+}
+
+/* USB interrupt, or the main loop with it masked. */
+static void rx_arm(void)
+{
+  if (rx_free() < APP_CDC_EP_SIZE)
+  {
+    if (!s_rx_held)
+    {
+      s_rx_stalls++;
+    }
+    s_rx_held = 1u;
+    return;
+  }
+  s_rx_held = 0u;
+  AppUsb_Receive(APP_CDC_EP_OUT, s_rx_pkt, APP_CDC_PKT_SIZE);
+}
+
+/* Next IN packet: up to 64 bytes, as far as the ring end. */
+static void tx_send(void)
+{
+  const uint32_t r = s_tx_r;
+  uint32_t n = s_tx_w - r;
+  if (n == 0u)
+  {
+    s_tx_busy = 0u;
+    if (s_tx_zlp)
+    {
+      s_tx_zlp = 0u;
+      s_tx_busy = 1u;
+      AppUsb_Transmit(APP_CDC_EP_IN, NULL, 0u);
+    }
+    return;
+  }
+  const uint32_t at = r & (APP_CDC_TX_RING_SIZE - 1u);
+  if (n > (APP_CDC_TX_RING_SIZE - at))
+  {
+    n = APP_CDC_TX_RING_SIZE - at;
+  }
+  if (n > APP_CDC_EP_SIZE)
+  {
+    n = APP_CDC_EP_SIZE;
+  }
+  s_tx_busy = 1u;
+  s_tx_zlp = (n == APP_CDC_EP_SIZE);
+  AppUsb_Transmit(APP_CDC_EP_IN, &s_tx_ring[at], (uint16_t)n);
+  s_tx_r = r + n;
+  s_tx_bytes += n;
+}
+
+void AppCdc_Start(void)
+{
+  s_configured = 1u;
+  s_tx_busy = 0u;
+  s_tx_zlp = 0u;
+  rx_arm();
+}
+
+void AppCdc_Reset(void)
+{
+  s_configured = 0u;
+  s_dtr = 0u;
+  s_rx_held = 0u;
+  s_tx_busy = 0u;
+  s_tx_zlp = 0u;
+  s_tx_r = s_tx_w;
+}
+
+uint8_t AppCdc_Setup(const AppUsbSetup *req)
+{
+  if (((req->type & 0x1Fu) != 0x01u) || ((req->index & 0xFFu) != APP_CDC_IF_COMM))
+  {
+    return 0u;
+  }
+  switch (req->request)
+  {
+    case CDC_REQ_SET_LINE_CODING:
+      AppUsb_CtlRecv(CDC_LINE_CODING_LEN);
+      return 1u;
+    case CDC_REQ_GET_LINE_CODING:
+      AppUsb_CtlSend(s_coding, CDC_LINE_CODING_LEN);
+      return 1u;
+    case CDC_REQ_SET_CONTROL_LINE_STATE:
+      s_dtr = ((req->value & CDC_DTR) != 0u) ? 1u : 0u;
+      if (!s_dtr)
+      {
+        /* Closed: what the host did not read yet is nobody's now. */
+        s_tx_r = s_tx_w;
+      }
+      AppUsb_CtlStatus();
+      return 1u;
+    case CDC_REQ_SEND_BREAK:
+      AppUsb_CtlStatus();
+      return 1u;
+    default:
+      return 0u;
+  }
+}
+
+void AppCdc_CtlOut(const uint8_t *data, uint16_t len)
+{
+  if (len >= CDC_LINE_CODING_LEN)
+  {
+    memcpy(s_coding, data, CDC_LINE_CODING_LEN);
+  }
+}
+
+void AppCdc_DataOut(uint16_t len)
+{
+  uint32_t w = s_rx_w;
+  for (uint32_t i = 0; i < len; i++, w++)
+  {
+    s_rx_ring[w & (APP_CDC_RX_RING_SIZE - 1u)] = s_rx_pkt[i];
+  }
+  s_rx_w = w;
+  s_rx_bytes += len;
+  rx_arm();
+}
+
+void AppCdc_DataIn(void)
+{
+  tx_send();
+}
+
+uint8_t AppCdc_IsOpen(void)
+{
+  return (s_configured && s_dtr) ? 1u : 0u;
+}
+
+uint32_t AppCdc_Read(uint8_t *dst, uint32_t max)
+{
+  uint32_t r = s_rx_r;
+  uint32_t n = s_rx_w - r;
+  if (n > max)
+  {
+    n = max;
+  }
+  for (uint32_t i = 0; i < n; i++, r++)
+  {
+    dst[i] = s_rx_ring[r & (APP_CDC_RX_RING_SIZE - 1u)];
+  }
+  s_rx_r = r;
+
+  if (s_rx_held && (rx_free() >= APP_CDC_EP_SIZE))
+  {
+    NVIC_DisableIRQ(USB_LP_IRQn);
+    if (s_rx_held && s_configured)
+    {
+      rx_arm();
+    }
+    NVIC_EnableIRQ(USB_LP_IRQn);
+  }
+  return n;
+}
+
+uint8_t AppCdc_Pending(void)
+{
+  return (s_rx_w != s_rx_r) ? 1u : 0u;
+}
+
+uint8_t AppCdc_Write(const uint8_t *data, uint32_t len)
+{
+  if (!AppCdc_IsOpen())
+  {
+    return 1u;
+  }
+  if (len > AppCdc_TxFree())
+  {
+    s_tx_drops++;
+    return 0u;
+  }
+  uint32_t w = s_tx_w;
+  for (uint32_t i = 0; i < len; i++, w++)
+  {
+    s_tx_ring[w & (APP_CDC_TX_RING_SIZE - 1u)] = data[i];
+  }
+  s_tx_w = w;
+
+  NVIC_DisableIRQ(USB_LP_IRQn);
+  if (!s_tx_busy && s_configured)
+  {
+    tx_send();
+  }
+  NVIC_EnableIRQ(USB_LP_IRQn);
+  return 1u;
+}
+
+uint32_t AppCdc_TxFree(void)
+{
+  if (!AppCdc_IsOpen())
+  {
+    return APP_CDC_TX_RING_SIZE;
+  }
+  return APP_CDC_TX_RING_SIZE - (s_tx_w - s_tx_r);
+}
+
+void AppCdc_Get(AppCdcInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->open = AppCdc_IsOpen();
+  out->baud = (uint32_t)s_coding[0] | ((uint32_t)s_coding[1] << 8) | ((uint32_t)s_coding[2] << 16) |
+              ((uint32_t)s_coding[3] << 24);
+  out->rx_bytes = s_rx_bytes;
+  out->tx_bytes = s_tx_bytes;
+  out->tx_drops = s_tx_drops;
+  out->rx_stalls = s_rx_stalls;
+}
+
+static const AppMemItem k_cdc_mem[] =
+{
+  APP_MEM_ITEM("cdc.rx", s_rx_ring),
+  APP_MEM_ITEM("cdc.tx", s_tx_ring),
+  APP_MEM_ITEM("cdc.pkt", s_rx_pkt),
+};
+
+_Static_assert((sizeof(s_rx_ring) + sizeof(s_tx_ring) + sizeof(s_rx_pkt)) <= APP_CDC_RAM_BYTES,
+               "the CDC buffers outgrew APP_CDC_RAM_BYTES");
+
+uint32_t AppCdc_MemMap(const AppMemItem **items)
+{
+  *items = k_cdc_mem;
+  return (uint32_t)(sizeof(k_cdc_mem) / sizeof(k_cdc_mem[0]));
+}
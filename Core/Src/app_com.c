@@ -6,183 +6,919 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "app_audio.h"
+#include "app_ble.h"
+#include "app_cabir.h"
+#include "app_capture.h"
+#include "app_cdc.h"
 #include "app_dsp.h"
+#include "app_evlog.h"
+#include "app_expr.h"
+#include "app_mem.h"
+#include "app_meter.h"
+#include "app_midi.h"
+#include "app_power.h"
+#include "app_preset.h"
+#include "app_prof.h"
+#include "app_restart.h"
+#include "app_sched.h"
+#include "app_selftest.h"
+#include "app_serial.h"
+#include "app_spectrum.h"
+#include "app_switch.h"
+#include "app_telem.h"
+#include "app_trace.h"
+#include "app_tuner.h"
+#include "app_uac.h"
+#include "app_update.h"
 
-/* TX is interrupt-driven to avoid stalling the MCU when the host sends a lot
- * of commands (PSET/FXMASK). Replies are enqueued into a ring buffer and
- * drained via HAL_UART_Transmit_IT(). */
-
-#ifndef APP_COM_TX_RING_SIZE
-#define APP_COM_TX_RING_SIZE 512u
-#endif
-
-/* Simple, line-based ASCII protocol over UART.
+/* Simple, line-based ASCII protocol, the same on every link at once: the
+ * UART (app_serial.h), with USB plugged in the virtual COM port
+ * (app_cdc.h), SysEx on MIDI (app_midi.h, text lines only), the RTT
+ * "Commands" buffers (app_telem.h, with APP_TELEM_RTT) and a BLE UART
+ * module on USART3 (app_ble.h). A link is a byte
+ * transport only: each has its own line and frame parser state here, and
+ * its own TX queue in the transport, and never copies through another
+ * ring. Replies go back on the link the command came from, streams (METER,
+ * EVT, DUMP, TRACE) to the one that last started them. A link greets with
+ * READY when it opens (the UART at boot), and its streams stop when it
+ * closes.
  * Commands (\n terminated):
- *   PING                       -> PONG
- *   STATUS                     -> STATUS FXMASK=<n> ...
- *   FXMASK <n>                 -> OK FXMASK <n>
- *   PSET <param> <value>       -> OK PSET <param> <value>
+ *   PING [<seq>]               -> PONG / PONG <seq> ms=<tick> cyc=<DWT>
+ *                              (with <seq>, the pedal's time as it parsed
+ *                              the line: HAL tick and cycle counter)
+ *   STATUS [<since>]           -> STATUS V=<ver> P=<pver> FXMASK=<n> <param>=<value> ... delay_max_ms=<n>
+ *                              (with <since>, only the fields changed after
+ *                              version <since>; all of them if <since> is
+ *                              ahead, i.e. the firmware restarted)
+ *   EVT [ON|OFF]               -> EVT <on|off> V=<ver> / OK EVT <on|off> V=<ver>;
+ *                              while on, every change to a STATUS field is
+ *                              pushed within APP_COM_EVT_MS as
+ *                              EVT V=<ver> P=<pver> <field>=<value> ... (untagged)
+ *   PLIST [<first>]            -> PLIST <id> <param> min=<n> max=<n> def=<n> unit=<u> smooth_ms=<n> clamp=<0|1>
+ *                              lines, then OK PLIST next=<id> count=<n>; the
+ *                              lines stop early when the TX ring is full:
+ *                              continue with PLIST <next> while next < count
+ *   FXMASK <n>                 -> OK FXMASK <n> P=<pver>; ERR FXMASK DISABLED for a bit
+ *                              of a module left out of the build (APP_DSP_FX_BITS_MISSING)
+ *   BYPASS [OFF|COND|TRUE]     -> BYPASS <off|cond|true> / OK BYPASS ... (bypass
+ *                              tier over the FX mask: conditioning only, or
+ *                              input straight to output; see AppDsp_SetBypass())
+ *   BOOT                       -> BOOT <cold|warm|fallback> reset=<power|pin|watchdog|software|other>
+ *                              restarts=<n> wdg=<0|1> (how this boot came up,
+ *                              see app_restart.h)
+ *   BOOT RESTART               -> OK BOOT RESTART, then a software reset once
+ *                              the reply has left (a warm boot: the live
+ *                              settings come back)
+ *   UPDATE <bytes>             -> OK UPDATE max=<n> frame=<n> page=<n>, then the
+ *                              firmware updater takes the UART once the reply
+ *                              has left (UART link only; see app_update.h and
+ *                              tools/dsp_host/fw_update.c)
+ *   CHAIN [<spec>]             -> CHAIN <spec> / OK CHAIN <spec> (FX order,
+ *                              e.g. wah>pitch>distortion>eq>phaser>chorus>delay|reverb:
+ *                              '>' serial, '|' parallel, '+' parallel on a
+ *                              shared wet bus; see AppDsp_SetChain())
+ *   PSET <param> <value> [<param> <value> ...] -> OK PSET <param> <value> ... P=<pver>
+ *                              (all pairs land in the same DSP block; a param
+ *                              of a module left out of the build is an ERR,
+ *                              AppDsp_ParamBuilt())
+ *   PSETM <param>=<value> [<param>=<value> ...] -> OK PSETM <param>=<value> ... P=<pver>
+ *                              (same batch, one token per pair; a whole
+ *                              preset fits one line and one ack)
+ *   LOAD                       -> LOAD rx=<%> ... underrun=<n> ... recov=<n> ... idle=<%> (main loop
+ *                              asleep since the last LOAD, app_power.h)
+ *                              miss=<n> (DSP blocks that overran into the next half
+ *                              and were replaced by a repeat, APP_AUDIO_MISS_REPEAT)
+ *                              tier=<n>/<max> shed=<n> restore=<n> (load shedding:
+ *                              quality tier now, steps down/up, APP_DSP_SHED)
+ *                              hclk=<MHz> (core clock the percentages are of)
+ *   CPU                        -> CPU mode=<auto|full|half> hclk=<MHz> load=<%>
+ *                              up=<n> down=<n> full_ms=<ms> half_ms=<ms> (clock
+ *                              governor, app_power.h: load is the audio path's
+ *                              share at the current step, up/down the steps taken)
+ *   CPU <AUTO|FULL|HALF>       -> OK CPU ... (FULL/HALF pin the step; ERR CPU
+ *                              DISABLED without APP_POWER_GOVERNOR)
+ *   DMODEL                     -> DMODEL <id> <name> cyc=<os1>/<os2>/<os4> cyc_frame=<n>
+ *                              load=<%> lines, then OK DMODEL count=<n> sel=<id> os=<n>
+ *                              (distortion models for dist_model, app_dsp.h: declared
+ *                              cycles per channel sample, and per frame and as a
+ *                              share of the frame at the current dist_os and hclk)
+ *   AERR                       -> AERR <seq> t=<ms> src=<rx|tx> kind=<dma|ovr|udr|fre> code=<hal>
+ *                              recovered=<0|1> gap_us=<n> lines (last incidents, see
+ *                              AppAudio_Poll), then OK AERR count=<n> recov=<n> glitch_us=<n> now=<ms>
+ *   EVLOG                      -> EVLOG n=<records> boot=<this boot> room=<n> lost=<n>
+ *                              pages=<n> (flash event log over power cycles,
+ *                              app_evlog.h; ERR EVLOG DISABLED without it)
+ *   EVLOG DUMP [<first>]       -> EVLOG <i> boot=<n> t=<ms> type=<boot|underrun|overflow|
+ *                              i2s_err|dsp_late|miss|shed> n=<count> preset=<n>
+ *                              mask=<n> load=<%> hclk=<MHz> lines, oldest first,
+ *                              while the TX ring has room, then OK EVLOG DUMP
+ *                              next=<i> count=<n> (boot records: n = reset | kind << 8)
+ *   EVLOG CLEAR                -> OK EVLOG CLEAR (erases the pages: ~20 ms of
+ *                              audio stall each, between songs)
+ *   LATENCY                    -> LATENCY <profile> frames=<n> target=<n> est_us=<n>
+ *                              floor=<n> ceil=<n> low=<n> (adaptive ring target:
+ *                              its bounds and the lowest level it may still try,
+ *                              0 when fixed; see APP_AUDIO_RING_ADAPT) lead_us=<n>
+ *                              (RX to TX event offset set at start, APP_AUDIO_TX_ALIGN)
+ *   LATENCY <profile>          -> OK LATENCY <profile> ... (low/mid/safe/large)
+ *   LTEST                      -> LTEST <idle|running|done|nosignal|noisy|aborted> runs=<n>/<N>
+ *                              total=<min>/<avg>/<max> dma=<n> ring=<n> conv=<n> us=<n>
+ *                              dwt_us=<n> noise=<s24> level=<s24> (frames unless _us)
+ *   LTEST RUN                  -> OK LTEST RUN (round-trip impulse test, needs a
+ *                              loopback cable; DSP bypassed ~0.5 s; poll LTEST)
+ *   ITEST                      -> ITEST <idle|running|done|aborted> blocks=<n>/<N> frames=<n>
+ *                              hash=<hex> ref=<hex|none> match=<1|0|-1> underrun=<n>
+ *                              overflow=<n> i2s_err=<n> dsp_late=<n> miss=<n> shed=<n>
+ *   ITEST RUN [<blocks>]       -> OK ITEST RUN (audio integrity test: a fixed pattern
+ *                              through the chain from a cleared state, output
+ *                              hashed, default 2000 blocks; match= compares with
+ *                              the last finished run of the same size; poll ITEST)
+ *   RESAMPLER [linear|hermite|fir] -> RESAMPLER <engine> / OK RESAMPLER <engine>
+ *   CLOCK                      -> CLOCK ppm=<x.y> est=<x.y> ... locked=<0|1> exact=<0|1>
+ *                              (exact=1: identical I2S rates, ring copied unresampled)
+ *   CLOCK RESET                -> OK CLOCK RESET
+ *   JITTER                     -> JITTER <rx|tx> n=<n> max_us=<n> hist=<b0>,...,<b9> lines,
+ *                              then OK JITTER period_us=<n> (half-complete callback
+ *                              interval minus the nominal period; bin 0 < 1 us, bin k
+ *                              < 2^k us, the last the rest; since start or RESET)
+ *   JITTER RESET               -> OK JITTER RESET
+ *   PROF                       -> PROF <stage> ... lines, then OK PROF
+ *   PROF RESET                 -> OK PROF RESET
+ *   CLIP                       -> CLIP <stage> blocks=<n> lines, then OK CLIP runs=<n>
+ *                              (blocks in which the stage saturated, out of runs
+ *                              chain runs; APP_DSP_CLIP)
+ *   CLIP RESET                 -> OK CLIP RESET
+ *   BENCH [<blocks>] [<frames>] -> BENCH stage|chain <name> cyc_frame=<x.y> load=<x.y>%
+ *                              lines, then OK BENCH ...; stops audio while
+ *                              every stage kernel and FX chain runs <blocks>
+ *                              (default 100) blocks of a fixed input, in
+ *                              pieces of APP_COM_BENCH_FEED_FRAMES
+ *   BENCH KERNEL [<blocks>] [<frames>] -> BENCH kernel <name>/frame|block cyc_frame=<x.y>
+ *                              load=<x.y>% lines, then OK BENCH KERNEL ...;
+ *                              each DSP and audio-path kernel alone, called
+ *                              per frame and per block
+ *   MEM                        -> MEM ram=<used>/<size> ccm=<used>/<size> free=<n>
+ *                              stack=<peak>/<size> heap=<n> com_rx=<peak>/<size>
+ *                              com_tx=<peak>/<size> audio_ring=<peak>/<frames>
+ *                              arena=<used>/<size> shared=<n> overlay=<owner>
+ *                              (FX buffer pool, see AppDsp_GetArena())
+ *   MEM MAP                    -> MEM <module.buffer> <bytes> lines, then OK MEM MAP total=<n>
+ *   MEM RESET                  -> OK MEM RESET (repaints the stack, clears ring peaks)
+ *   DTAP                       -> DTAP <i> time_q12=<n> pan_q15=<n> gain_q15=<n> lines, then OK DTAP
+ *   DTAP <i> <time_q12> <pan_q15> <gain_q15> -> OK DTAP <i> ... (edit one delay tap)
+ *   PSAVE <n>                  -> OK PSAVE <n> (FX mask, params and taps to flash slot n)
+ *   PLOAD <n>                  -> OK PLOAD <n> (recall in one block; ERR if empty)
+ *   PBANK                      -> PBANK slots=<n> image=<bytes> params=<n> taps=<n> stored=<mask>
+ *                              fmt=<version> hash=<param hash> (the preset
+ *                              files PREAD/PSTAGE/PCOMMIT move, app_preset.h)
+ *   METER <hz>                 -> OK METER <hz> (0 = off, up to APP_COM_METER_HZ_MAX);
+ *                              then a binary METER frame every 1/<hz> s
+ *                              (same as SUB meter <hz>)
+ *   SUB                        -> SUB <topic> hz=<n> max=<n> link=<link> lines, then
+ *                              OK SUB count=<n> (max=0: not in this build)
+ *   SUB <topic> <hz>           -> OK SUB <topic> <hz> (0 = off; samples to the
+ *                              asking link, see below)
+ *   UNSUB <topic>|ALL          -> OK UNSUB <topic>|ALL
+ *   CAP                        -> CAP <idle|armed|running|done> tap=<t> decim=<n> n=<done>/<count> inject=<n>
+ *   CAP <tap> [<decim>] [<n>]  -> OK CAP ... (capture n samples, 0 = all, of
+ *                              in/dist/delay/reverb/out at the frame rate / decim;
+ *                              needs APP_CAPTURE_ENABLE, see app_capture.h)
+ *   CAP STOP                   -> OK CAP STOP
+ *   INJ <m> [<tap> [<decim>] [<n>]] -> OK INJ ... (play the first m uploaded
+ *                              samples, CAPW frames, in place of the input
+ *                              and capture the tap, default out, meanwhile)
+ *   DUMP [<first>]             -> OK DUMP <first> <count> rate=<hz>, binary
+ *                              DUMP frames as the TX ring drains, then
+ *                              DUMP END <count>
+ *   STEST                      -> STEST <idle|running|done> mode=<tone|sweep|noise>
+ *                              n=<done>/<points> level=<dBFS>
+ *   STEST TONE <hz> [<dBFS>]   -> OK STEST ... (self-test: a generated
+ *   STEST SWEEP <f1> <f2> [<points>] [<dBFS>]   stimulus in place of the
+ *   STEST NOISE [<dBFS>]                        input, analysed at the
+ *                              output; default -20 dBFS and 16 points; also
+ *                              resets PROF and CLIP; needs
+ *                              APP_SELFTEST_ENABLE, see app_selftest.h)
+ *   STEST STOP                 -> OK STEST STOP
+ *   STEST RESULT [<first>]     -> STEST <i> f=<hz> gain=<dB> phase=<deg> thd=<dB>
+ *                              thdn=<dB> lines (noise: STEST <i> noise gain=<dB>)
+ *                              while the TX ring has room, then OK STEST RESULT
+ *                              next=<n> done=<n>
+ *   TRACE                      -> TRACE <running|triggered|frozen> n=<held> seq=<n>
+ *                              trig=<index> id=<event> mask=<trigger mask>
+ *                              (index 0 = oldest held, n = no trigger)
+ *   TRACE ARM [<mask>]         -> OK TRACE ARM ... (clear, record, freeze
+ *                              APP_TRACE_POST events after an event in
+ *                              <mask>, bits by AppTraceId; default
+ *                              underrun|overflow|miss|i2s error)
+ *   TRACE FREEZE               -> OK TRACE FREEZE ...
+ *   TRACE DUMP [<first>]       -> OK TRACE DUMP <first> <n> trig=<index> hz=<core>,
+ *                              binary TRACE frames, then TRACE END <n>
+ *                              (freezes first; needs APP_TRACE_ENABLE, see
+ *                              app_trace.h)
+ *   TELEM                      -> TELEM <uart|itm|rtt> attached=<0|1> frames=<n> events=<n>
+ *                              drop=<n> itm=<built> rtt=<built>
+ *   TELEM uart|itm|rtt         -> OK TELEM ... (METER, DUMP and TRACE frames,
+ *                              and live trace events, over SWO stimulus ports
+ *                              or SEGGER RTT instead of the UART; replies stay
+ *                              here, see app_telem.h)
+ *   CABIR                      -> CABIR <empty|loading|active> slot=<n> taps=<n>
+ *                              max=<n> part=<n> slots=<taps>,... (per slot,
+ *                              0 = empty; cab_ir selects the one that plays)
+ *   CABIR BEGIN <taps> [<slot>] -> OK CABIR BEGIN ... (start an IR upload of
+ *                              <taps> zeroed q15 taps into slot 0 or <slot>,
+ *                              CABW frames; that slot plays the biquad cab
+ *                              meanwhile)
+ *   CABIR COMMIT               -> OK CABIR COMMIT ... (to flash, convolver
+ *                              on; audio stalls while flash is written)
+ *   CABIR ABORT                -> OK CABIR ABORT ... (back to the stored IR)
+ *   CABIR CLEAR [<slot>]       -> OK CABIR CLEAR ... (drop slot 0 or <slot>:
+ *                              biquad cab there)
+ *                              Needs APP_CABIR_ENABLE, see app_cabir.h.
+ *   CABIIR                     -> CABIIR sections=<n> max=<n>, one
+ *                              CABIIR <k> <b0> <b1> <b2> <a1> <a2> line per
+ *                              section, then OK CABIIR
+ *   CABIIR <k> <b0> <b1> <b2> <a1> <a2>
+ *                              -> OK CABIIR <k> ... (user cab section, Q28,
+ *                              AppDsp_SetCabSection(); ERR for an unstable one)
+ *   CABIIR N <n>               -> OK CABIIR sections=<n> ... (run the first
+ *                              <n>, 0 = the fixed lowpass; RAM only)
+ *                              Every CABIIR is ERR CABIIR DISABLED without
+ *                              the user cab (APP_DSP_CAB_SECTIONS_MAX 0).
+ *   LOOP                       -> LOOP <empty|rec|play|overdub|stopped> len=<ms> pos=<ms> max=<ms>
+ *   LOOP REC|PLAY|STOP|CLEAR   -> OK LOOP <cmd> (taken at the next block, see
+ *                              app_dsp.h; ERR LOOP NORAM if the image left
+ *                              no SRAM for the buffer)
+ *   TUNER                      -> TUNER <off|on|mute> note=<name><octave>|- cents=<c>
+ *                              freq=<hz> seq=<n> (latest estimate, ~14/s)
+ *   TUNER ON|MUTE|OFF          -> OK TUNER ... (MUTE also silences the output)
+ *                              Needs APP_TUNER_ENABLE, see app_tuner.h.
+ *   TAP                        -> OK TAP bpm=<n> (tap tempo, see AppDsp_TapTempo();
+ *                              bpm=0 until the second tap)
+ *   FSW                        -> FSW <i> <none|next|prev|bypass|tap|freeze> presses=<n>
+ *                              closed=<0|1> lines, then OK FSW count=<n>
+ *   FSW <i> <action>           -> OK FSW <i> <action> (footswitch i's action,
+ *                              RAM only; see app_switch.h)
+ *   EXP                        -> EXP pos=<q15> raw=<n> heel=<n> toe=<n> target=<off|param|morph>
+ *                              [<param> lo=<n> hi=<n> | a=<n> b=<n>] (expression
+ *                              pedal, app_expr.h)
+ *   EXP <param> <lo> <hi>      -> OK EXP ... (the pedal sweeps <param> from <lo>
+ *                              at heel to <hi> at toe)
+ *   EXP MORPH <a> <b>          -> OK EXP ... (the pedal morphs from preset a at
+ *                              heel to preset b at toe)
+ *   EXP OFF                    -> OK EXP ...
+ *   EXP HEEL|TOE               -> OK EXP ... (the current position becomes that end)
+ *   MIDI                       -> MIDI ch=<1..16|omni> bytes=<n> lost=<n> err=<n> pc=<n>
+ *                              cc=<n> beats=<n> run=<0|1> (MIDI in, app_midi.h)
+ *   MIDI CH <n>                -> OK MIDI ... (receive channel, 0 = omni)
+ *   MIDI CC                    -> MIDI CC <cc> <param> lo=<n> hi=<n> lines, then
+ *                              OK MIDI CC count=<n>
+ *   MIDI CC <cc> <param> [<lo> <hi>] -> OK MIDI CC <cc> <param> lo=<n> hi=<n>
+ *                              (CC 0..127 sets <param> from <lo> to <hi>,
+ *                              default its whole range; RAM only)
+ *   MIDI CC <cc> OFF           -> OK MIDI CC <cc> OFF
+ *   SCHED                      -> SCHED <task> prio=<high|control|housekeeping> period=<ms>
+ *                              runs=<n> avg_us=<n> max_us=<n> budget_us=<n> over=<n>
+ *                              late=<n> lines, then OK SCHED tasks=<n> (main-loop
+ *                              tasks, app_sched.h; period 0 = every pass)
+ *   SCHED RESET                -> OK SCHED RESET
+ *   USB                        -> USB state=<off|default|addressed|configured|suspended>
+ *                              resets=<n> setups=<n> stalls=<n> stream=<0|1>
+ *                              src=<wet|dry> fill=<n>/<target> packets=<n> short=<n>
+ *                              long=<n> under=<n> over=<n> (USB audio input,
+ *                              app_uac.h; short/long: 47/49-frame packets)
+ *                              com=<0|1> com_rx=<n> com_tx=<n> com_drop=<n>
+ *                              com_hold=<n> (virtual COM port open, bytes
+ *                              each way, replies dropped on a full TX ring,
+ *                              times the host was held off, app_cdc.h)
+ *   USB SRC <wet|dry>          -> OK USB ... (wet: processed L/R; dry: processed L
+ *                              and the unprocessed input)
+ *   BLE                        -> BLE open=<0|1> baud=<n> rx=<n> tx=<n> lost=<n> err=<n>
+ *                              (the BLE module's link, app_ble.h: connected,
+ *                              bytes each way, lost on a full RX ring, line
+ *                              errors)
+ *   MORPH                      -> MORPH a=<n> b=<n> pos=<q15> to=<q15> active=<0|1> glide=<0|1>
+ *   MORPH <a> <b> <pos> [<ms>] -> OK MORPH ... (continuous params of presets a
+ *                              and b interpolated at pos, 0..32768, in one
+ *                              block; with <ms>, a glide there from the
+ *                              current position; see AppPreset_Morph())
+ *   LINK                       -> LINK <uart|usb|midi|rtt|ble> open=<0|1> rx=<n> tx=<n> drop=<n>
+ *                              lines, then OK LINK this=<link> count=<n> (bytes
+ *                              parsed and queued per link, replies dropped on a
+ *                              full TX queue; this= is the asking link)
+ *   CREDIT                     -> CREDIT <on|off> win=<n> cr=<limit>
+ *   CREDIT ON|OFF              -> OK CREDIT ... (flow control on the asking
+ *                              link, see below; ERR CREDIT on MIDI)
+ *   QUIET                      -> QUIET <on|off>
+ *   QUIET ON|OFF               -> OK QUIET <on|off> (coalesced acks on the asking
+ *                              link, see below)
+ *   CAPS                       -> CAPS fw=<version> proto=<n> feat=<name>,... baud=<max>
+ *                              rate=<hz> block=<frames> line=<n> bin=<n> rx=<n>
+ *                              tx=<n> params=<n> hash=<n> (what this build
+ *                              speaks, see below)
+ *   BAUD                       -> BAUD <rate>
+ *   BAUD <rate>                -> OK BAUD <rate> (sent at the old rate, then
+ *                              the UART switches, whichever link asked; the host reopens at <rate>
+ *                              and sends PING within APP_COM_BAUD_CONFIRM_MS,
+ *                              else the old rate comes back)
  *
- * Params:
+ * Params (APP_DSP_PARAM_LIST in app_dsp.h; PLIST reports limits and units):
  *   dist_drive_q8       (0..131072)
+ *   dist_os             (1, 2 or 4: distortion oversampling)
+ *   dist_curve          (0=soft 1=hard 2=tube 3=diode 4=fuzz 5=asym)
+ *   dist_model          (0=overdrive 1=tube 2=fuzz 3=crush, costs: DMODEL)
+ *   color_curve         (same curves, input colour stage)
  *   gain_q15            (0..65536)
  *   delay_mix_q15       (0..32768)
  *   delay_feedback_q15  (0..32768)
+ *   delay_time_ms       (1..delay_max_ms from STATUS)
+ *   delay_pattern       (0=single 1=pingpong 2=dotted 3=quad 4=reverse,
+ *                        resets DTAP)
  *   reverb_mix_q15      (0..32768)
  *   reverb_feedback_q15 (0..32768)
  *   reverb_damp_q15     (0..32768)
+ *   reverb_freeze       (0/1: hold the tail, input shut; FSW freeze toggles it)
+ *   eq_<band>_gain_db10 (-150..150 tenths of a dB, 0 = band off; band is
+ *                        low, mid1, mid2 or high)
+ *   eq_<band>_freq_hz   (low 40..1000, mid1 100..8000, mid2 200..12000,
+ *                        high 1000..16000)
+ *   eq_mid1_q100, eq_mid2_q100 (30..1000: Q * 100)
+ *   gate_thresh_db10    (-900..0 tenths of a dBFS block RMS, 0 = gate off)
+ *   gate_release_ms     (5..2000)
+ *   comp_thresh_db10    (-600..0 tenths of a dBFS)
+ *   comp_ratio_x10      (10..200: ratio * 10, 10 = compressor off)
+ *   comp_knee_db10      (0..240 tenths of a dB, 0 = hard knee)
+ *   comp_makeup_db10    (0..240 tenths of a dB)
+ *   chorus_mix_q15      (0..32768)
+ *   chorus_rate_mhz     (50..10000: LFO rate in mHz)
+ *   chorus_depth_q15    (0..32768: sweep as a share of the centre delay)
+ *   chorus_time_us      (300..APP_DSP_CHORUS_TIME_MAX_US: centre delay,
+ *                        short with feedback for flanging)
+ *   chorus_feedback_q15 (0..29491)
+ *   chorus_spread_deg   (0..180: right tap's LFO phase lead, 90 = quadrature)
+ *   phaser_mix_q15      (0..32768, 16384 = deepest notches)
+ *   phaser_rate_mhz     (50..10000: LFO rate in mHz)
+ *   phaser_depth_q15    (0..32768: sweep width, full = 5 octaves up from
+ *                        phaser_freq_hz)
+ *   phaser_freq_hz      (50..2000: bottom of the sweep)
+ *   phaser_stages       (4, 6 or 8 allpass stages: 2, 3 or 4 notches)
+ *   phaser_spread_deg   (0..180: right channel's LFO phase lead)
+ *   tremolo_depth_q15   (0..32768, 0 = tremolo off)
+ *   tremolo_pan_q15     (0..32768: 0 = tremolo, 32768 = auto-pan)
+ *   tremolo_div         (0..4: one cycle per half, quarter, eighth, eighth
+ *                        triplet or sixteenth note)
+ *   tempo_bpm           (20..300: quarter notes per minute; TAP sets it)
+ *   wah_mix_q15         (0..32768, 0 = auto-wah off)
+ *   wah_freq_hz         (100..1500: bottom of the sweep)
+ *   wah_depth_q15       (0..32768: sweep width, full = 4 octaves up from
+ *                        wah_freq_hz)
+ *   wah_sens_db10       (-600..0 tenths of a dBFS: input envelope that
+ *                        reaches the top of the sweep)
+ *   wah_q100            (70..1000: Q * 100)
+ *   pitch_mix_q15       (0..32768, 0 = pitch shifter off, 32768 = shifted
+ *                        only)
+ *   pitch_cents         (-1200..1200: shift, -1200 = octave down)
+ *   pitch_window_ms     (10..APP_DSP_PITCH_WINDOW_MAX_MS: grain length)
+ *   tone_model          (0..2: off, fender or marshall amp tone stack after
+ *                        the clipper)
+ *   tone_bass_q15       (0..32768: knob position, 16384 = noon)
+ *   tone_mid_q15        (0..32768)
+ *   tone_treble_q15     (0..32768)
+ *   reverb_room         (0..3: off, small, medium or large room early
+ *                        reflections ahead of the reverb tail)
+ *   reverb_er_q15       (0..32768: early-reflection level)
+ *   reverb_decay_ms     (0..20000: tail RT60, 0 = reverb_feedback_q15)
+ *   reverb_hf_damp_hz   (0..12000: the tail decays twice as fast here,
+ *                        0 = reverb_damp_q15)
+ *   reverb_type         (0..1: fdn or spring tank)
+ *   delay_sync          (0..6: delay time from tempo_bpm, off, half,
+ *                        quarter, dotted eighth, eighth, eighth triplet
+ *                        or sixteenth note)
+ *   chorus_sync         (0..6: chorus rate, one cycle per that note)
+ *   phaser_sync         (0..6: phaser rate, one cycle per that note)
+ *
+ * Sequence tags: any command may start with "#<seq> " (1..8 digits). Every
+ * text line it produces then starts with the same "#<seq> ", so a host can
+ * keep several commands in flight and match each ack to its command. Lines
+ * the firmware sends on its own (READY, EVT) and binary frames carry no tag.
+ *
+ * Flow control: without it a full RX ring loses input (the UART overwrites
+ * its DMA ring) and a full TX queue drops whole replies. After CREDIT ON
+ * the host counts the bytes it sends from the one after that line's
+ * newline and never goes past <limit>: cr= in the ack, then each untagged
+ * "CR <limit>" line as the parser frees the window (win=, the input the
+ * link holds unread). The firmware in turn takes the next command only
+ * while the link's TX queue has room for a whole reply line, so a slow
+ * reader throttles its own input and no reply is dropped. An RX restart
+ * or a BAUD switch ends it with an untagged "CREDIT off"; so do the link
+ * closing and reopening, silently. Counts are mod 2^32.
+ *
+ * Quiet mode: after QUIET ON, PSET, PSETM and FXMASK (text or binary)
+ * that worked send no line of their own; errors still do. Instead one
+ * untagged "QACK <seq> n=<n> V=<ver> P=<pver>" line goes out at most
+ * APP_COM_EVT_MS after the first of them: n commands done since the last
+ * QACK, <seq> the tag of the last tagged one (0: none), V= the STATUS
+ * version and P= the parameter-set version at that point. A host reconciles its values against EVT or
+ * STATUS <since> rather than per-command echoes, which during a knob sweep
+ * carry as many bytes back as the commands themselves.
+ *
+ * Capabilities: CAPS lets a host pick its path on connect instead of
+ * probing for ERR UNKNOWN. proto= goes up when an existing reply or frame
+ * changes; commands that are only added show up in feat= (tag, bin,
+ * credit, evt, psetm, sub, quiet, pingts, lat always; usb, uac, midi, rtt, ble, exp, morph,
+ * pitch, chorus, spring, spill, bus ('|' and '+' chains), ucab (CABIIR),
+ * cap, trace, cabir, tuner, stest and spectrum as built; update where the
+ * updater can run). The FX flags name what app_profile.h builds, so a host
+ * hides the controls a pedal would refuse. baud= is the fastest BAUD
+ * rate, block= the frames per DSP block, line= and bin= the longest command line and binary payload
+ * taken, rx= the asking link's CREDIT
+ * window and tx= the room its TX queue has now. hash= is FNV-1a over the PLIST descriptors
+ * and the PROF stage names: a host that cached them under the same
+ * params= and hash= can skip PLIST.
+ *
+ * Topics: SUB streams what a host is showing, each topic at its own rate
+ * and only while subscribed; nothing is built for the others. Samples go
+ * out from the control-rate "pub" task (AppCom_Publish()), untagged, and
+ * are skipped rather than queued when the TX queue has no room:
+ *   meter    binary METER frames (below), up to APP_COM_METER_HZ_MAX
+ *   load     PUB load rx=<x.y> rx_max=<x.y> tx=<x.y> miss=<n> under=<n> tier=<n>
+ *            preset=<n> P=<pver> (% of the block period as in LOAD, without
+ *            resetting its idle window; preset: the slot last recalled, from
+ *            here, a footswitch or MIDI), up to 10 Hz
+ *   clock    PUB clock ppm=<x.y> est=<x.y> locked=<0|1> (as CLOCK), up to 10 Hz
+ *   tuner    PUB tuner <off|on|mute> note=<name><octave>|- cents=<c> freq=<hz>
+ *            (a new estimate only, as TUNER; APP_TUNER_ENABLE), up to 20 Hz
+ *   spectrum binary SPECTRUM frames (below) of the output, a new window
+ *            only (APP_SPECTRUM_ENABLE, see app_spectrum.h), up to 20 Hz
+ * A link closing ends its subscriptions.
+ *
+ * Versions: the STATUS fields are compared with their last seen values
+ * every APP_COM_EVT_MS (and before a STATUS reply), whatever changed them
+ * (PSET, PLOAD, binary frames); a round with changes moves V up by one
+ * and stamps those fields with it. V is 1 after boot. A host keeps the
+ * highest V it has seen and resyncs with STATUS <V>.
+ *
+ * Parameter-set version (P=, AppDsp_ParamsVersion()): each set of
+ * parameters the DSP publishes gets the next number. STATUS and EVT read
+ * their values from one published set, never a batch half through, and
+ * give its P=; the acks of PSET, PSETM, FXMASK (and QACK) give the P= of
+ * the set their command landed in, so STATUS or EVT reporting that P= or
+ * a later one has applied it. PUB load carries the last scanned P=.
+ *
+ * Latency probe: "@<t> " after the tag (<t> a u32 off the host's clock,
+ * echoed as is) follows a PSET or PSETM that worked from the wire to the
+ * audio path: once the first block has run on its set, one untagged
+ *   LAT <t> rd=<us> ap=<us> blk=<us> tx=<us> ramp=<us> P=<pver>
+ * goes out, times after the line arrived (the UART's RX interrupt; the
+ * read on the other links): rd the parser took it, ap its batch was
+ * committed, blk that block started, tx this line was queued (so the host
+ * can take the pedal's dwell out of its round trip). ramp is the longest
+ * glide among its params, 0 when they all step. Only the last probe is
+ * followed, a newer one replaces it, and none reports when no block ran
+ * within COM_LAT_TIMEOUT_MS (audio stopped); "@<t>" on other commands is
+ * ignored. Times are DWT cycles at the current HCLK.
+ *
+ * Binary frames share the link with the ASCII lines: a 0xA5 byte at the
+ * start of a line begins a frame instead of a command.
+ *   0xA5 <len> <cmd> <payload: len-1 bytes> <crc16 lo> <crc16 hi>
+ * crc16 is CRC-16/CCITT-FALSE over <len> .. the last payload byte. Values
+ * are zigzag LEB128 varints (1..5 bytes), param ids are AppDspParamId.
+ *   0x01 PING [<seq u32>]                   -> 0x81 <st> [<seq u32> <ms u32> <cyc u32>]
+ *   0x02 PSET (<id> <varint>)...            -> 0x82 <st> [<pver varint>] (one batch, all or none)
+ *   0x03 PGET <id>                          -> 0x83 <st> <varint>
+ *   0x04 FXMASK <mask>                      -> 0x84 <st> [<pver varint>]
+ *        (PSET and FXMASK: FAILED for a module left out of the build)
+ *   0x05 PLOAD <n>                          -> 0x85 <st>
+ *   0x06 PSAVE <n>                          -> 0x86 <st>
+ *   0x40 METER (firmware -> host, unsolicited, no status byte):
+ *        <peak u16> <rms u16> for input, dist, delay, reverb, output
+ *        (AppMeterTap order), then <comp gain u16> <limiter gain u16>.
+ *        Levels are s24 >> 7 (65535 = full scale), gains q15 (32768 =
+ *        unity, lowest in the window), all little-endian.
+ *   0x07 CAPW <offset u16> <s16> ...        -> 0x87 <st> (injection samples)
+ *   0x08 CABW <offset u16> <s16> ...        -> 0x88 <st> (cab IR taps, q15)
+ *   0x09 PREAD <slot> <offset u16> <n>      -> 0x89 <st> <slot> <offset u16> <n bytes>
+ *        (n <= 59 bytes of the stored image of a preset slot)
+ *   0x0A PSTAGE <offset u16> <bytes> ...    -> 0x8A <st> (into the upload image)
+ *   0x0B PCOMMIT <slot> <crc32 u32>         -> 0x8B <st> (staged file to the
+ *        slot if it ends in this CRC-32 of its bytes and has this build's
+ *        version and param hash; flash stalls audio)
+ *        A host moves the whole bank in one burst of frames: every PREAD at
+ *        once, or per slot its PSTAGE chunks and the PCOMMIT.
+ *   0x41 DUMP (firmware -> host, after DUMP, no status byte):
+ *        <offset u16> <s16> ... (up to 30 samples, little-endian)
+ *   0x42 TRACE (firmware -> host, after TRACE DUMP, no status byte):
+ *        <index u16> then per event <cycles u32> <id | arg << 8 u32>
+ *        (up to 7 events, little-endian; DWT cycles at hz=, ids are
+ *        AppTraceId in app_trace.h)
+ *   0x43 SPECTRUM (firmware -> host, "spectrum" topic, no status byte):
+ *        <bin width u16, 0.01 Hz> <bands> then per band <top bin> <level>;
+ *        band b covers FFT bins top[b-1]+1 .. top[b] (band 0 from bin
+ *        1), level is its peak in 0.5 dB steps, 255 = 0 dBFS
+ *        (little-endian)
+ * <st>: 0 ok, 1 bad crc, 2 bad payload, 3 unknown cmd, 4 failed (empty
+ * preset, flash error, no upload in progress). A frame not completed within
+ * APP_COM_BIN_TIMEOUT_MS is dropped.
  */
 
-#ifndef APP_COM_RX_RING_SIZE
-/* Larger RX ring so we don't corrupt commands when the audio/DSP load is high.
- * Dropping bytes can turn valid commands into garbage, leading to ERR UNKNOWN.
+/* Most <param> <value> pairs one PSET/PSETM line may carry. */
+#ifndef APP_COM_PSET_MAX
+#define APP_COM_PSET_MAX 8u
+#endif
+
+/* Largest <cmd> + payload of a binary frame. */
+#ifndef APP_COM_BIN_MAX
+#define APP_COM_BIN_MAX 48u
+#endif
+
+#ifndef APP_COM_BIN_TIMEOUT_MS
+#define APP_COM_BIN_TIMEOUT_MS 50u
+#endif
+
+/* Most blocks one BENCH item may run. */
+#ifndef APP_COM_BENCH_BLOCKS_MAX
+#define APP_COM_BENCH_BLOCKS_MAX 2000u
+#endif
+
+/* Frames a BENCH item runs between two watchdog feeds (app_restart.h):
+ * 100 ms of audio, under the timeout even for a chain at twice the
+ * budget. Each piece starts from cleared effect state, as a whole item
+ * does.
  */
-#define APP_COM_RX_RING_SIZE 1024u
+#ifndef APP_COM_BENCH_FEED_FRAMES
+#define APP_COM_BENCH_FEED_FRAMES 4800u
 #endif
 
-#ifndef APP_COM_LINE_MAX
-#define APP_COM_LINE_MAX 160u
+/* Highest METER stream rate. */
+#ifndef APP_COM_METER_HZ_MAX
+#define APP_COM_METER_HZ_MAX 60u
+#endif
+
+/* Change scan and EVT push period; a knob sweep is coalesced to one EVT
+ * per period.
+ */
+#ifndef APP_COM_EVT_MS
+#define APP_COM_EVT_MS 20u
 #endif
 
-#ifndef APP_COM_RX_DMA_SIZE
-#define APP_COM_RX_DMA_SIZE 512u
+/* CAPS fw=, set by the build. */
+#ifndef APP_FW_VERSION
+#define APP_FW_VERSION "dev"
 #endif
 
-static UART_HandleTypeDef *s_uart = NULL;
+/* CAPS proto=: bumped when an existing reply or frame changes. */
+#define COM_PROTO_VERSION       3u
 
-static volatile uint8_t s_rx_ring[APP_COM_RX_RING_SIZE];
-static volatile uint16_t s_rx_wr = 0;
-static volatile uint16_t s_rx_rd = 0;
+/* Time the host has to confirm a BAUD switch at the new rate. */
+#ifndef APP_COM_BAUD_CONFIRM_MS
+#define APP_COM_BAUD_CONFIRM_MS 3000u
+#endif
+
+#define COM_BIN_SYNC            0xA5u
+#define COM_BIN_PING            0x01u
+#define COM_BIN_PSET            0x02u
+#define COM_BIN_PGET            0x03u
+#define COM_BIN_FXMASK          0x04u
+#define COM_BIN_PLOAD           0x05u
+#define COM_BIN_PSAVE           0x06u
+#define COM_BIN_CAPW            0x07u
+#define COM_BIN_CABW            0x08u
+#define COM_BIN_PREAD           0x09u
+#define COM_BIN_PSTAGE          0x0Au
+#define COM_BIN_PCOMMIT         0x0Bu
+#define COM_BIN_METER           0x40u  /* unsolicited, see METER */
+#define COM_BIN_DUMP            0x41u  /* unsolicited, see DUMP */
+#define COM_BIN_TRACE           0x42u  /* unsolicited, see TRACE DUMP */
+#define COM_BIN_SPECTRUM        0x43u  /* unsolicited, "spectrum" topic */
+#define COM_BIN_REPLY           0x80u
 
-static uint8_t s_rx_byte = 0;
+/* Largest <cmd> + payload the firmware sends. */
+#define COM_BIN_TX_MAX          64u
 
-static char s_line[APP_COM_LINE_MAX];
-static uint16_t s_line_len = 0;
+#define COM_BIN_ST_OK           0u
+#define COM_BIN_ST_CRC          1u
+#define COM_BIN_ST_PAYLOAD      2u
+#define COM_BIN_ST_UNKNOWN      3u
+#define COM_BIN_ST_FAILED       4u
 
-static volatile uint8_t s_tx_ring[APP_COM_TX_RING_SIZE];
-static volatile uint16_t s_tx_wr = 0;
-static volatile uint16_t s_tx_rd = 0;
-static volatile uint8_t s_tx_busy = 0;
-static volatile uint16_t s_tx_last_len = 0;
+/* Fits a PSETM with all eight pairs of long param names (~210 chars). */
+#ifndef APP_COM_LINE_MAX
+#define APP_COM_LINE_MAX 256u
+#endif
 
-static uint8_t s_rx_dma[APP_COM_RX_DMA_SIZE];
+/* Bytes a link's transport is read by at a time. */
+#define COM_RX_CHUNK            64u
 
+/* The links commands arrive on, each with its own parser state. */
 typedef enum
 {
-  APP_COM_RX_MODE_BYTE = 0,
-  APP_COM_RX_MODE_IDLE_IT = 1,
-  APP_COM_RX_MODE_IDLE_DMA = 2,
-} AppComRxMode;
+  COM_LINK_UART = 0,
+  COM_LINK_USB,
+  COM_LINK_MIDI,
+  COM_LINK_RTT,
+  COM_LINK_BLE,
+  COM_LINK_COUNT
+} ComLink;
 
-static volatile AppComRxMode s_rx_mode = APP_COM_RX_MODE_BYTE;
+/* A link's transport. write queues all n bytes or none (0: no room);
+ * is_open NULL: always open; restarted (may be NULL) reports input lost
+ * under a partial line; rx_stamp (may be NULL) gives the DWT cycles the
+ * bytes of the last read arrived at, or returns 0 and the read's own time
+ * stands in. rx_max bounds the bytes taken per pass, so a host that keeps
+ * sending cannot hold the main loop. rx_window is the input the
+ * transport holds unread without losing any, the CREDIT window (0: no
+ * CREDIT on this link).
+ */
+typedef struct
+{
+  const char *name;
+  uint32_t (*read)(uint8_t *dst, uint32_t max);
+  uint8_t (*write)(const uint8_t *p, uint32_t n);
+  uint32_t (*tx_free)(void);
+  uint8_t (*pending)(void);
+  uint8_t (*is_open)(void);
+  uint8_t (*restarted)(void);
+  uint8_t (*rx_stamp)(uint32_t *cyc);
+  uint32_t rx_max;
+  uint32_t rx_window;
+} ComLinkOps;
 
-static inline uint16_t ring_next(uint16_t idx)
+static const ComLinkOps k_links[COM_LINK_COUNT] =
 {
-  return (uint16_t)((idx + 1u) % APP_COM_RX_RING_SIZE);
-}
+  {"uart", AppSerial_Read, AppSerial_Write, AppSerial_TxFree, AppSerial_Pending, NULL, AppSerial_Restarted,
+   AppSerial_RxStamp, APP_SERIAL_RX_RING_SIZE, APP_SERIAL_RX_RING_SIZE - 1u},
+  {"usb", AppCdc_Read, AppCdc_Write, AppCdc_TxFree, AppCdc_Pending, AppCdc_IsOpen, NULL, NULL, APP_CDC_RX_RING_SIZE,
+   APP_CDC_RX_RING_SIZE},
+  {"midi", AppMidi_ComRead, AppMidi_ComWrite, AppMidi_ComTxFree, AppMidi_ComPending, NULL, NULL, NULL, 128u, 0u},
+  {"rtt", AppTelem_ComRead, AppTelem_ComWrite, AppTelem_ComTxFree, AppTelem_ComPending, AppTelem_ComIsOpen, NULL, NULL,
+   APP_TELEM_RTT_COM_BYTES, APP_TELEM_RTT_COM_BYTES - 1u},
+  {"ble", AppBle_Read, AppBle_Write, AppBle_TxFree, AppBle_Pending, AppBle_IsOpen, NULL, NULL, APP_BLE_RX_RING_SIZE,
+   APP_BLE_RX_RING_SIZE},
+};
 
-static inline uint16_t tx_ring_next(uint16_t idx)
+typedef struct
 {
-  return (uint16_t)((idx + 1u) % APP_COM_TX_RING_SIZE);
-}
+  char line[APP_COM_LINE_MAX];
+  uint16_t line_len;
+  /* Binary frame being received: <len> <cmd> <payload> <crc lo> <crc hi>. */
+  uint8_t bin[APP_COM_BIN_MAX + 3u];
+  uint16_t bin_len;
+  uint8_t bin_active;
+  uint32_t bin_t0;
+  /* Read from the transport, not parsed yet (held back by CREDIT). */
+  uint8_t hold[COM_RX_CHUNK];
+  uint8_t hold_len;
+  uint8_t hold_pos;
+  uint32_t hold_cyc;  /* when hold[] arrived, for the latency probe */
+} ComRx;
 
-static uint16_t tx_ring_free(void)
+/* Parser state per link, for the links built. The ones left out never
+ * read a byte, so they share one more slot, which stays idle.
+ */
+#define COM_RX_USB              1u
+#define COM_RX_MIDI             (COM_RX_USB + (APP_CDC_ENABLE ? 1u : 0u))
+#define COM_RX_RTT              (COM_RX_MIDI + (APP_MIDI_ENABLE ? 1u : 0u))
+#define COM_RX_BLE              (COM_RX_RTT + (APP_TELEM_RTT ? 1u : 0u))
+#define COM_RX_IDLE             (COM_RX_BLE + (APP_BLE_ENABLE ? 1u : 0u))
+#define COM_RX_SLOTS            (COM_RX_IDLE + ((COM_RX_IDLE < COM_LINK_COUNT) ? 1u : 0u))
+
+static ComRx s_rx[COM_RX_SLOTS];
+
+static ComRx *const k_rx[COM_LINK_COUNT] =
 {
-  uint16_t rd = s_tx_rd;
-  uint16_t wr = s_tx_wr;
-  if (wr >= rd)
-  {
-    return (uint16_t)((APP_COM_TX_RING_SIZE - (wr - rd)) - 1u);
-  }
-  return (uint16_t)((rd - wr) - 1u);
-}
+  &s_rx[0],
+  &s_rx[APP_CDC_ENABLE ? COM_RX_USB : COM_RX_IDLE],
+  &s_rx[APP_MIDI_ENABLE ? COM_RX_MIDI : COM_RX_IDLE],
+  &s_rx[APP_TELEM_RTT ? COM_RX_RTT : COM_RX_IDLE],
+  &s_rx[APP_BLE_ENABLE ? COM_RX_BLE : COM_RX_IDLE],
+};
+
+/* Per link: open as last seen, and the LINK counters. */
+static uint8_t s_link_open[COM_LINK_COUNT];
+static uint32_t s_link_rx[COM_LINK_COUNT];
+static uint32_t s_link_tx[COM_LINK_COUNT];
+static uint32_t s_link_drop[COM_LINK_COUNT];
 
-static void tx_kick(void)
+/* CREDIT per link: s_link_rx at CREDIT ON, and the last limit sent. */
+static uint8_t s_credit_on[COM_LINK_COUNT];
+static uint32_t s_credit_base[COM_LINK_COUNT];
+static uint32_t s_credit_sent[COM_LINK_COUNT];
+
+/* QUIET per link: acks owed, since when, and the last tag among them. */
+static uint8_t s_quiet[COM_LINK_COUNT];
+static uint32_t s_quiet_n[COM_LINK_COUNT];
+static uint32_t s_quiet_t0[COM_LINK_COUNT];
+static uint32_t s_quiet_seq[COM_LINK_COUNT];
+
+/* Latency probe: "@<t>" of the command being handled (s_lat_line, when
+ * the parser took it), then the last PSET/PSETM that carried one until its
+ * LAT line goes out. Stamps in DWT cycles.
+ */
+#define COM_LAT_TIMEOUT_MS      1000u
+
+typedef struct
 {
-  if (s_uart == NULL)
-  {
-    return;
-  }
+  uint32_t host_t;
+  uint32_t pver;
+  uint32_t rx_cyc;     /* the line arrived */
+  uint32_t rd_cyc;     /* the parser took it */
+  uint32_t ap_cyc;     /* its batch was committed */
+  uint32_t t0;         /* HAL_GetTick() at the commit */
+  uint16_t ramp_ms;    /* longest glide among its params */
+  uint8_t link;
+  uint8_t wait;        /* for the block and the LAT line */
+} ComLat;
 
-  if (s_tx_busy)
-  {
-    return;
-  }
+static ComLat s_lat;
+static uint8_t s_lat_line;
+static uint32_t s_lat_t;
+static uint32_t s_lat_rd;
+
+/* Where output goes: the link of the command being handled, or of the
+ * stream being polled. Each stream remembers the link that started it.
+ */
+static ComLink s_link = COM_LINK_UART;
+static ComLink s_evt_link = COM_LINK_UART;
+static ComLink s_dump_link = COM_LINK_UART;
+static ComLink s_trace_link = COM_LINK_UART;
+
+/* "#<seq> " of the command being handled, empty outside handle_line();
+ * put in front of every line it sends (s_tx_bol: at a line start).
+ */
+#define COM_TAG_DIGITS_MAX      8u
+static char s_reply_tag[COM_TAG_DIGITS_MAX + 3u];
+static uint8_t s_tx_bol = 1;
+
+/* The reply line being built (out_*()): no printf and no stack buffer; it
+ * leaves as one write, tag and newline included, so a full TX queue drops
+ * a whole line or nothing. Longer lines (STATUS, EVT) go in pieces.
+ */
+#define COM_OUT_MAX             (COM_TAG_DIGITS_MAX + 3u + APP_COM_LINE_MAX)
+static char s_out[COM_OUT_MAX];
+static uint16_t s_out_len = 0;
+
+/* In-place tokenizer of the command being handled: tok_next() cuts the
+ * next space/tab separated token out of the line (a NUL over the
+ * separator). s_tok_line..s_tok_end spans the whole line, so an error
+ * reply can show it again without a copy made up front (tok_line()).
+ */
+static char *s_tok_pos = NULL;
+static char *s_tok_line = NULL;
+static char *s_tok_end = NULL;
+
+/* BAUD switch: requested -> pending until the OK has left the wire, then on
+ * trial until the host confirms at the new rate.
+ */
+static const uint32_t k_com_baud_rates[] = {115200u, 230400u, 460800u, 921600u, 1000000u, 2000000u};
+static uint32_t s_baud_pending = 0;
+static uint32_t s_baud_prev = 0;
+static uint32_t s_baud_t0 = 0;
+static uint8_t s_baud_trial = 0;
+
+/* BOOT RESTART: set when the OK went out, the reset follows once it has
+ * left the UART and a USB frame or two had the time to carry it.
+ */
+#define COM_REBOOT_DELAY_MS 20u
+static uint8_t s_reboot = 0;
+static uint32_t s_reboot_t0 = 0;
+
+/* UPDATE: the same wait, then AppUpdate_Enter() instead of the reset. */
+static uint8_t s_update = 0;
+
+/* SUB topics: rate (0 = off), when the last sample went, and the link
+ * that asked.
+ */
+typedef enum
+{
+  COM_TOPIC_METER = 0,
+  COM_TOPIC_LOAD,
+  COM_TOPIC_CLOCK,
+  COM_TOPIC_TUNER,
+  COM_TOPIC_SPECTRUM,
+  COM_TOPIC_COUNT
+} ComTopic;
+
+static uint32_t s_sub_hz[COM_TOPIC_COUNT];
+static uint32_t s_sub_t0[COM_TOPIC_COUNT];
+static ComLink s_sub_link[COM_TOPIC_COUNT];
+static uint32_t s_sub_tuner_seq = 0;
+
+/* DUMP stream: next sample to send and end of the capture. */
+static uint32_t s_dump_pos = 0;
+static uint32_t s_dump_end = 0;
+
+/* TRACE DUMP stream: next event (ring index) and end of the held ones. */
+static uint32_t s_trace_pos = 0;
+static uint32_t s_trace_end = 0;
+
+/* STATUS fields (FXMASK, the params, delay_max_ms) as last scanned, with
+ * the version each last changed at; s_sync_now is the highest version,
+ * 0 before the first scan. s_evt_ver: pushed as EVT up to this version.
+ */
+#define COM_SYNC_FIELDS         ((uint32_t)APP_DSP_PARAM_COUNT + 2u)
+#define COM_SYNC_ITEM_MAX       48u     /* longest " <name>=<value>" */
+static int32_t s_sync_val[COM_SYNC_FIELDS];
+static uint32_t s_sync_ver[COM_SYNC_FIELDS];
+static uint32_t s_sync_now = 0;
+static uint32_t s_sync_pver = 0;  /* parameter-set version the fields were read from */
+static uint32_t s_sync_t0 = 0;
+static uint8_t s_evt_on = 0;
+static uint32_t s_evt_ver = 0;
 
-  uint16_t rd = s_tx_rd;
-  uint16_t wr = s_tx_wr;
-  if (rd == wr)
+/* Room for output on the current link. */
+static uint16_t tx_ring_free(void)
+{
+  const uint32_t n = k_links[s_link].tx_free();
+  return (n > 0xFFFFu) ? 0xFFFFu : (uint16_t)n;
+}
+
+static void tx_enqueue_bytes(const uint8_t *data, uint16_t len)
+{
+  if (data == NULL || len == 0)
   {
     return;
   }
-
-  /* Send the largest contiguous chunk (until wrap or wr). */
-  uint16_t len = 0;
-  if (wr > rd)
+  /* Drop if the link's TX queue is full; prefer dropping replies over
+   * blocking audio/DSP.
+   */
+  if (k_links[s_link].write(data, len))
   {
-    len = (uint16_t)(wr - rd);
+    s_link_tx[s_link] += len;
   }
   else
   {
-    len = (uint16_t)(APP_COM_TX_RING_SIZE - rd);
+    s_link_drop[s_link]++;
   }
+}
 
-  s_tx_busy = 1;
-  s_tx_last_len = len;
-  if (HAL_UART_Transmit_IT(s_uart, (uint8_t *)&s_tx_ring[rd], len) != HAL_OK)
+/* Appends; what does not fit is cut off, as snprintf() would. One byte
+ * stays free for the newline.
+ */
+static void out_str(const char *str)
+{
+  while ((*str != 0) && (s_out_len < (COM_OUT_MAX - 1u)))
   {
-    s_tx_busy = 0;
-    s_tx_last_len = 0;
+    s_out[s_out_len++] = *str++;
   }
 }
 
-static void tx_enqueue_bytes(const uint8_t *data, uint16_t len)
+static void out_u32(uint32_t v)
 {
-  if (s_uart == NULL || data == NULL || len == 0)
+  char d[10];
+  uint32_t n = 0;
+  do
   {
-    return;
-  }
-
-  uint32_t primask = __get_PRIMASK();
-  __disable_irq();
-
-  if (tx_ring_free() < len)
+    d[n++] = (char)('0' + (v % 10u));
+    v /= 10u;
+  } while (v != 0u);
+  while ((n > 0u) && (s_out_len < (COM_OUT_MAX - 1u)))
   {
-    /* Drop if TX ring is full; prefer dropping replies over blocking audio/DSP. */
-    if (!primask)
-    {
-      __enable_irq();
-    }
-    return;
+    s_out[s_out_len++] = d[--n];
   }
+}
 
-  for (uint16_t i = 0; i < len; i++)
+static void out_i32(int32_t v)
+{
+  if (v < 0)
   {
-    s_tx_ring[s_tx_wr] = data[i];
-    s_tx_wr = tx_ring_next(s_tx_wr);
+    out_str("-");
+    out_u32((uint32_t)0u - (uint32_t)v);
+    return;
   }
+  out_u32((uint32_t)v);
+}
 
-  if (!primask)
+/* Starts a line (with the tag) or, after out_part(), goes on with it. */
+static void out_begin(const char *str)
+{
+  s_out_len = 0;
+  if (s_tx_bol)
   {
-    __enable_irq();
+    out_str(s_reply_tag);
   }
+  out_str(str);
+}
 
-  tx_kick();
+static void out_line(void)
+{
+  s_out[s_out_len++] = '\n';
+  tx_enqueue_bytes((const uint8_t *)s_out, s_out_len);
+  s_out_len = 0;
+  s_tx_bol = 1;
 }
 
-static void uart_send_line(const char *line)
+static void send_line(const char *line)
 {
-  if (s_uart == NULL || line == NULL)
+  if (line == NULL)
   {
     return;
   }
-
-  const uint16_t n = (uint16_t)strlen(line);
-  tx_enqueue_bytes((const uint8_t *)line, n);
-  tx_enqueue_bytes((const uint8_t *)"\n", 1);
+  out_begin(line);
+  out_line();
 }
 
-static void trim_inplace(char *s)
+/* Cuts trailing blanks and returns the first non-blank. */
+static char *trim_inplace(char *s)
 {
   size_t n = strlen(s);
   while (n > 0 && (s[n - 1] == '\r' || s[n - 1] == '\n' || isspace((unsigned char)s[n - 1])))
@@ -190,17 +926,60 @@ static void trim_inplace(char *s)
     s[n - 1] = 0;
     n--;
   }
+  while (isspace((unsigned char)*s))
+  {
+    s++;
+  }
+  return s;
+}
+
+static void tok_begin(char *line)
+{
+  s_tok_pos = line;
+  s_tok_line = line;
+  s_tok_end = line + strlen(line);
+}
 
-  size_t i = 0;
-  while (s[i] != 0 && isspace((unsigned char)s[i]))
+static char *tok_next(void)
+{
+  char *p = s_tok_pos;
+  if (p == NULL)
+  {
+    return NULL;
+  }
+  while ((*p == ' ') || (*p == '\t'))
+  {
+    p++;
+  }
+  if (*p == 0)
+  {
+    s_tok_pos = p;
+    return NULL;
+  }
+  char *tok = p;
+  while ((*p != 0) && (*p != ' ') && (*p != '\t'))
+  {
+    p++;
+  }
+  if (*p != 0)
   {
-    i++;
+    *p++ = 0;
   }
+  s_tok_pos = p;
+  return tok;
+}
 
-  if (i > 0)
+/* The command line as received, separators put back. */
+static const char *tok_line(void)
+{
+  for (char *p = s_tok_line; p < s_tok_end; p++)
   {
-    memmove(s, s + i, strlen(s + i) + 1);
+    if (*p == 0)
+    {
+      *p = ' ';
+    }
   }
+  return s_tok_line;
 }
 
 static bool parse_u32(const char *s, uint32_t *out)
@@ -239,350 +1018,4206 @@ static bool parse_i32(const char *s, int32_t *out)
 
 static bool map_param(const char *name, AppDspParamId *out)
 {
-  if (name == NULL || out == NULL)
-  {
-    return false;
-  }
+  return AppDsp_FindParam(name, out) != 0u;
+}
 
-  if (strcmp(name, "dist_drive_q8") == 0)
-  {
-    *out = APP_DSP_PARAM_DIST_DRIVE_Q8;
-    return true;
-  }
-  if (strcmp(name, "gain_q15") == 0)
-  {
-    *out = APP_DSP_PARAM_GAIN_Q15;
-    return true;
-  }
-  if (strcmp(name, "delay_mix_q15") == 0)
-  {
-    *out = APP_DSP_PARAM_DELAY_MIX_Q15;
-    return true;
-  }
-  if (strcmp(name, "delay_feedback_q15") == 0)
-  {
-    *out = APP_DSP_PARAM_DELAY_FEEDBACK_Q15;
-    return true;
-  }
-  if (strcmp(name, "reverb_mix_q15") == 0)
-  {
-    *out = APP_DSP_PARAM_REVERB_MIX_Q15;
-    return true;
-  }
-  if (strcmp(name, "reverb_feedback_q15") == 0)
-  {
-    *out = APP_DSP_PARAM_REVERB_FEEDBACK_Q15;
-    return true;
-  }
-  if (strcmp(name, "reverb_damp_q15") == 0)
+#if APP_PROF_ENABLE
+static void send_prof_stat(const char *kind, const char *name, const AppProfStat *st)
+{
+  char buf[128];
+  uint32_t avg = (st->count != 0u) ? (uint32_t)(st->sum / st->count) : 0u;
+
+  /* Load of this stage/chain as a share of the per-frame cycle budget (x0.1%). */
+  uint32_t budget = AppProf_CyclesPerFrame();
+  uint32_t load_pm = 0u;
+  if ((st->frames != 0u) && (budget != 0u))
   {
-    *out = APP_DSP_PARAM_REVERB_DAMP_Q15;
-    return true;
+    load_pm = (uint32_t)((st->sum * 1000u) / (st->frames * (uint64_t)budget));
   }
 
-  return false;
+  (void)snprintf(buf, sizeof(buf), "PROF %s %s n=%lu min=%lu avg=%lu max=%lu load=%lu.%lu%%",
+                 kind,
+                 name,
+                 (unsigned long)st->count,
+                 (unsigned long)st->min,
+                 (unsigned long)avg,
+                 (unsigned long)st->max,
+                 (unsigned long)(load_pm / 10u),
+                 (unsigned long)(load_pm % 10u));
+  send_line(buf);
 }
+#endif
 
-static void handle_line(char *line)
+static void handle_prof(const char *arg)
 {
-  trim_inplace(line);
-  if (line[0] == 0)
+#if APP_PROF_ENABLE
+  if (arg != NULL)
   {
+    if (strcmp(arg, "RESET") == 0)
+    {
+      AppProf_Reset();
+      send_line("OK PROF RESET");
+      return;
+    }
+    send_line("ERR PROF");
     return;
   }
 
-  /* Keep a copy for debug error replies. */
-  char line_copy[APP_COM_LINE_MAX];
-  (void)snprintf(line_copy, sizeof(line_copy), "%s", line);
-
-  char *cmd = strtok(line, " \t");
-  if (cmd == NULL)
+  AppProfStat st;
+  for (uint32_t i = 0; i < (uint32_t)APP_PROF_STAGE_COUNT; i++)
   {
-    return;
+    if (AppProf_GetStage((AppProfStage)i, &st))
+    {
+      send_prof_stat("stage", AppProf_StageName((AppProfStage)i), &st);
+    }
   }
 
-  if (strcmp(cmd, "PING") == 0)
+  for (uint32_t m = 0; m < APP_PROF_MASK_COUNT; m++)
   {
-    uart_send_line("PONG");
-    return;
+    if (AppProf_GetChain(m, &st) && (st.count != 0u))
+    {
+      char name[16];
+      (void)snprintf(name, sizeof(name), "fxmask=%lu", (unsigned long)m);
+      send_prof_stat("chain", name, &st);
+    }
   }
 
-  if (strcmp(cmd, "STATUS") == 0)
-  {
-    char buf[200];
-    uint32_t mask = AppDsp_GetFxMask();
-    int32_t dist_drive = AppDsp_GetParam(APP_DSP_PARAM_DIST_DRIVE_Q8);
-    int32_t gain_q15 = AppDsp_GetParam(APP_DSP_PARAM_GAIN_Q15);
-    int32_t delay_mix = AppDsp_GetParam(APP_DSP_PARAM_DELAY_MIX_Q15);
-    int32_t delay_fb = AppDsp_GetParam(APP_DSP_PARAM_DELAY_FEEDBACK_Q15);
-    int32_t rev_mix = AppDsp_GetParam(APP_DSP_PARAM_REVERB_MIX_Q15);
-    int32_t rev_fb = AppDsp_GetParam(APP_DSP_PARAM_REVERB_FEEDBACK_Q15);
-    int32_t rev_damp = AppDsp_GetParam(APP_DSP_PARAM_REVERB_DAMP_Q15);
+  send_line("OK PROF");
+#else
+  (void)arg;
+  send_line("ERR PROF DISABLED");
+#endif
+}
 
-    (void)snprintf(buf, sizeof(buf),
-                   "STATUS FXMASK=%lu dist_drive_q8=%ld gain_q15=%ld delay_mix_q15=%ld delay_feedback_q15=%ld reverb_mix_q15=%ld reverb_feedback_q15=%ld reverb_damp_q15=%ld",
-                   (unsigned long)mask,
-                   (long)dist_drive,
-                   (long)gain_q15,
-                   (long)delay_mix,
-                   (long)delay_fb,
-                   (long)rev_mix,
-                   (long)rev_fb,
-                   (long)rev_damp);
-    uart_send_line(buf);
+static void handle_clip(const char *arg)
+{
+  uint32_t blocks = 0u;
+  uint32_t runs = 0u;
+  if (!AppDsp_GetClip(0u, &blocks, &runs))
+  {
+    send_line("ERR CLIP DISABLED");
     return;
   }
-
-  if (strcmp(cmd, "FXMASK") == 0)
+  if (arg != NULL)
   {
-    char *arg = strtok(NULL, " \t");
-    uint32_t mask = 0;
-    if (!parse_u32(arg, &mask))
+    if (strcmp(arg, "RESET") == 0)
     {
-      uart_send_line("ERR FXMASK");
+      AppDsp_ResetClip();
+      send_line("OK CLIP RESET");
       return;
     }
-    AppDsp_SetFxMask(mask);
-
-    char buf[48];
-    (void)snprintf(buf, sizeof(buf), "OK FXMASK %lu", (unsigned long)mask);
-    uart_send_line(buf);
+    send_line("ERR CLIP");
     return;
   }
 
-  if (strcmp(cmd, "PSET") == 0)
+  char buf[64];
+  for (uint32_t i = 0; i < (uint32_t)APP_PROF_STAGE_COUNT; i++)
   {
-    char *pname = strtok(NULL, " \t");
-    char *pval = strtok(NULL, " \t");
-
-    AppDspParamId id;
-    int32_t v = 0;
-    if (!map_param(pname, &id) || !parse_i32(pval, &v))
+    if (AppDsp_GetClip(i, &blocks, &runs))
     {
-      char buf[160];
-      (void)snprintf(buf, sizeof(buf), "ERR PSET name=%s val=%s", (pname != NULL) ? pname : "?", (pval != NULL) ? pval : "?");
-      uart_send_line(buf);
-      return;
+      (void)snprintf(buf, sizeof(buf), "CLIP %s blocks=%lu",
+                     AppProf_StageName((AppProfStage)i),
+                     (unsigned long)blocks);
+      send_line(buf);
     }
-
-    AppDsp_SetParam(id, v);
-
-    char buf[96];
-    (void)snprintf(buf, sizeof(buf), "OK PSET %s %ld", pname, (long)v);
-    uart_send_line(buf);
-    return;
-  }
-
-  {
-    char buf[160];
-    (void)snprintf(buf, sizeof(buf), "ERR UNKNOWN cmd=%s line=%s", (cmd != NULL) ? cmd : "?", line_copy);
-    uart_send_line(buf);
   }
+  (void)snprintf(buf, sizeof(buf), "OK CLIP runs=%lu", (unsigned long)runs);
+  send_line(buf);
 }
 
-void AppCom_Init(UART_HandleTypeDef *huart)
+/* One line per parameter descriptor, from 'arg' (default 0) on, as long as
+ * the TX ring has room; the closing OK names the next id so the host can
+ * continue with PLIST <next> (next == count when the list is complete).
+ */
+static void handle_plist(const char *arg)
 {
-  s_uart = huart;
-  s_rx_wr = 0;
-  s_rx_rd = 0;
-  s_line_len = 0;
-
-  s_tx_wr = 0;
-  s_tx_rd = 0;
-  s_tx_busy = 0;
-  s_tx_last_len = 0;
-
-  if (s_uart != NULL)
+  uint32_t id = 0;
+  if ((arg != NULL) && !parse_u32(arg, &id))
   {
-    /* Robust RX without spamming byte IRQs:
-     * - Prefer ReceiveToIdle DMA when DMA is configured.
-     * - Else use ReceiveToIdle IT (no DMA required).
-     * - Fall back to byte-by-byte RX only if idle-mode can't start.
-     */
-    s_rx_mode = APP_COM_RX_MODE_BYTE;
-
-    if (s_uart->hdmarx != NULL)
-    {
-      if (HAL_UARTEx_ReceiveToIdle_DMA(s_uart, s_rx_dma, (uint16_t)APP_COM_RX_DMA_SIZE) == HAL_OK)
-      {
-        s_rx_mode = APP_COM_RX_MODE_IDLE_DMA;
-        __HAL_DMA_DISABLE_IT(s_uart->hdmarx, DMA_IT_HT);
-      }
-    }
+    send_line("ERR PLIST");
+    return;
+  }
 
-    if (s_rx_mode == APP_COM_RX_MODE_BYTE)
+  char buf[128];
+  AppDspParamDesc d;
+  for (; id < (uint32_t)APP_DSP_PARAM_COUNT; id++)
+  {
+    if (!AppDsp_GetParamDesc((AppDspParamId)id, &d))
     {
-      if (HAL_UARTEx_ReceiveToIdle_IT(s_uart, s_rx_dma, (uint16_t)APP_COM_RX_DMA_SIZE) == HAL_OK)
-      {
-        s_rx_mode = APP_COM_RX_MODE_IDLE_IT;
-      }
+      break;
     }
-
-    if (s_rx_mode == APP_COM_RX_MODE_BYTE)
+    int len = snprintf(buf, sizeof(buf), "PLIST %lu %s min=%ld max=%ld def=%ld unit=%s smooth_ms=%u clamp=%u",
+                       (unsigned long)id, d.name, (long)d.min, (long)d.max, (long)d.def, d.unit,
+                       (unsigned)d.smooth_ms, (unsigned)d.clamp);
+    /* Keep room for this line and the closing OK. */
+    if ((len <= 0) || (tx_ring_free() < (uint16_t)(len + 1 + 32)))
     {
-      (void)HAL_UART_Receive_IT(s_uart, &s_rx_byte, 1);
+      break;
     }
-    uart_send_line("READY");
+    send_line(buf);
   }
+
+  (void)snprintf(buf, sizeof(buf), "OK PLIST next=%lu count=%lu", (unsigned long)id, (unsigned long)APP_DSP_PARAM_COUNT);
+  send_line(buf);
 }
 
-void AppCom_OnUartTxCplt(UART_HandleTypeDef *huart)
+/* BENCH result lines can outnumber the TX ring: wait for the ring to drain
+ * (the bench has held the main loop anyway) rather than drop them. The
+ * pieces of one long line wait the same way, so none is dropped.
+ */
+static void out_wait(uint16_t n)
 {
-  if (s_uart == NULL || huart != s_uart)
+  /* One wait is at most 200 ms; a long reply is many of them. */
+  AppRestart_Feed();
+  const uint32_t t0 = HAL_GetTick();
+  while ((tx_ring_free() < n) && ((HAL_GetTick() - t0) < 200u))
   {
-    return;
   }
+}
 
-  uint32_t primask = __get_PRIMASK();
-  __disable_irq();
+/* The built line so far, no newline; out_str() goes on with the rest. */
+static void out_part_wait(void)
+{
+  out_wait(s_out_len);
+  tx_enqueue_bytes((const uint8_t *)s_out, s_out_len);
+  s_out_len = 0;
+  s_tx_bol = 0;
+}
 
-  /* Advance read pointer by the actual length we started transmitting. */
-  const uint16_t sent = s_tx_last_len;
-  if (sent > 0)
-  {
-    s_tx_rd = (uint16_t)((s_tx_rd + sent) % APP_COM_TX_RING_SIZE);
-  }
-  s_tx_last_len = 0;
+static void out_line_wait(void)
+{
+  out_wait((uint16_t)(s_out_len + 1u));
+  out_line();
+}
 
-  s_tx_busy = 0;
+static void send_line_wait(const char *line)
+{
+  out_begin(line);
+  out_line_wait();
+}
 
-  if (!primask)
-  {
-    __enable_irq();
-  }
+static void send_bench(const char *kind, const char *name, uint64_t cycles, uint64_t frames)
+{
+  const uint32_t cyc_x10 = (frames != 0u) ? (uint32_t)((cycles * 10u) / frames) : 0u;
+  const uint32_t budget = AppProf_CyclesPerFrame();
+  const uint32_t load_pm = (budget != 0u) ? (uint32_t)((cyc_x10 * 100ull) / budget) : 0u;
 
-  tx_kick();
+  char buf[96];
+  (void)snprintf(buf, sizeof(buf), "BENCH %s %s cyc_frame=%lu.%lu load=%lu.%lu%%",
+                 kind, name,
+                 (unsigned long)(cyc_x10 / 10u), (unsigned long)(cyc_x10 % 10u),
+                 (unsigned long)(load_pm / 10u), (unsigned long)(load_pm % 10u));
+  send_line_wait(buf);
 }
 
-void AppCom_OnUartRxCplt(UART_HandleTypeDef *huart)
+typedef enum
+{
+  COM_BENCH_STAGE = 0,
+  COM_BENCH_CHAIN,
+  COM_BENCH_DSP_KERNEL,
+  COM_BENCH_AUDIO_KERNEL
+} ComBench;
+
+/* One BENCH item, run in pieces of APP_COM_BENCH_FEED_FRAMES with the
+ * watchdog fed in between: audio is paused, so nothing else feeds it.
+ */
+static uint64_t bench_item(ComBench kind, uint32_t id, uint8_t per_frame, AppStereoS24 *x,
+                           uint32_t frames, uint32_t blocks)
 {
-  if (s_uart == NULL || huart != s_uart)
+  const uint32_t piece = (frames < APP_COM_BENCH_FEED_FRAMES) ? (APP_COM_BENCH_FEED_FRAMES / frames) : 1u;
+  uint64_t cycles = 0;
+  for (uint32_t done = 0; done < blocks; )
   {
-    return;
+    const uint32_t n = ((blocks - done) < piece) ? (blocks - done) : piece;
+    AppRestart_Feed();
+    switch (kind)
+    {
+      case COM_BENCH_STAGE: cycles += AppDsp_BenchStage(id, x, frames, n); break;
+      case COM_BENCH_CHAIN: cycles += AppDsp_BenchChain((AppFxMask)id, x, frames, n); break;
+      case COM_BENCH_DSP_KERNEL: cycles += AppDsp_BenchKernel((AppDspKernel)id, per_frame, x, frames, n); break;
+      default: cycles += AppAudio_BenchKernel((AppAudioKernel)id, per_frame, frames, n); break;
+    }
+    done += n;
   }
+  return cycles;
+}
 
-  if (s_rx_mode != APP_COM_RX_MODE_BYTE)
+/* BENCH KERNEL: the kernels of AppDsp_BenchKernel() and
+ * AppAudio_BenchKernel(), each per frame and per block, in x as scratch.
+ */
+static void bench_kernels(AppStereoS24 *x, uint32_t frames, uint32_t blocks)
+{
+  const uint64_t total = (uint64_t)blocks * frames;
+  char name[40];
+  for (uint32_t k = 0; k < (uint32_t)APP_DSP_KERNEL_COUNT; k++)
   {
-    /* RX is handled by RxEvent callback in idle mode. */
-    return;
+    for (uint32_t v = 0; v < 2u; v++)
+    {
+      const uint8_t per_frame = (v == 0u) ? 1u : 0u;
+      (void)snprintf(name, sizeof(name), "%s/%s", AppDsp_KernelName((AppDspKernel)k), per_frame ? "frame" : "block");
+      send_bench("kernel", name, bench_item(COM_BENCH_DSP_KERNEL, k, per_frame, x, frames, blocks), total);
+    }
   }
-
-  uint16_t next = ring_next(s_rx_wr);
-  if (next != s_rx_rd)
+  for (uint32_t k = 0; k < (uint32_t)APP_AUDIO_KERNEL_COUNT; k++)
   {
-    s_rx_ring[s_rx_wr] = s_rx_byte;
-    s_rx_wr = next;
+    for (uint32_t v = 0; v < 2u; v++)
+    {
+      const uint8_t per_frame = (v == 0u) ? 1u : 0u;
+      (void)snprintf(name, sizeof(name), "%s/%s", AppAudio_KernelName((AppAudioKernel)k), per_frame ? "frame" : "block");
+      send_bench("kernel", name, bench_item(COM_BENCH_AUDIO_KERNEL, k, per_frame, x, frames, blocks), total);
+    }
   }
-
-  (void)HAL_UART_Receive_IT(s_uart, &s_rx_byte, 1);
 }
 
-void AppCom_OnUartRxEvent(UART_HandleTypeDef *huart, uint16_t size)
+/* BENCH [KERNEL] [<blocks>] [<frames>]: audio stops for the run (a few
+ * seconds at most) and restarts afterwards with cleared effect tails.
+ */
+static void handle_bench(const char *arg)
 {
-  if (s_uart == NULL || huart != s_uart)
+  uint32_t blocks = 100u;
+  uint32_t frames = AppAudio_GetFramesPerHalf();
+  const uint8_t kernels = ((arg != NULL) && (strcmp(arg, "KERNEL") == 0)) ? 1u : 0u;
+  if (kernels)
   {
-    return;
+    arg = tok_next();
   }
-
-  if (s_rx_mode == APP_COM_RX_MODE_BYTE)
+  const char *arg2 = tok_next();
+  if (((arg != NULL) && !parse_u32(arg, &blocks)) || ((arg2 != NULL) && !parse_u32(arg2, &frames)) ||
+      (blocks == 0u) || (blocks > APP_COM_BENCH_BLOCKS_MAX) || (frames == 0u))
   {
+    send_line("ERR BENCH");
     return;
   }
 
-  const uint16_t n = (size > (uint16_t)APP_COM_RX_DMA_SIZE) ? (uint16_t)APP_COM_RX_DMA_SIZE : size;
-  for (uint16_t i = 0; i < n; i++)
+  uint32_t scratch_frames = 0;
+  AppStereoS24 *x = AppAudio_Pause(&scratch_frames);
+  if (frames > scratch_frames)
   {
-    const uint8_t b = s_rx_dma[i];
-    uint16_t next = ring_next(s_rx_wr);
-    if (next != s_rx_rd)
-    {
-      s_rx_ring[s_rx_wr] = b;
-      s_rx_wr = next;
-    }
+    AppAudio_Resume();
+    send_line("ERR BENCH FRAMES");
+    return;
   }
 
-  /* Restart RX-to-idle DMA for next burst. */
-  if (s_rx_mode == APP_COM_RX_MODE_IDLE_DMA && s_uart->hdmarx != NULL)
+  const uint64_t total = (uint64_t)blocks * frames;
+  if (kernels)
   {
-    (void)HAL_UARTEx_ReceiveToIdle_DMA(s_uart, s_rx_dma, (uint16_t)APP_COM_RX_DMA_SIZE);
-    __HAL_DMA_DISABLE_IT(s_uart->hdmarx, DMA_IT_HT);
+    bench_kernels(x, frames, blocks);
   }
   else
   {
-    (void)HAL_UARTEx_ReceiveToIdle_IT(s_uart, s_rx_dma, (uint16_t)APP_COM_RX_DMA_SIZE);
+    for (uint32_t i = 0; i < (uint32_t)APP_PROF_STAGE_COUNT; i++)
+    {
+      send_bench("stage", AppProf_StageName((AppProfStage)i), bench_item(COM_BENCH_STAGE, i, 0u, x, frames, blocks), total);
+    }
+    for (uint32_t m = 0; m < APP_PROF_MASK_COUNT; m++)
+    {
+      char name[16];
+      (void)snprintf(name, sizeof(name), "fxmask=%lu", (unsigned long)m);
+      send_bench("chain", name, bench_item(COM_BENCH_CHAIN, m, 0u, x, frames, blocks), total);
+    }
   }
+  AppAudio_Resume();
+
+  char buf[80];
+  (void)snprintf(buf, sizeof(buf), "OK BENCH%s blocks=%lu frames=%lu budget_cyc=%lu", kernels ? " KERNEL" : "",
+                 (unsigned long)blocks, (unsigned long)frames, (unsigned long)AppProf_CyclesPerFrame());
+  send_line_wait(buf);
 }
 
-void AppCom_OnUartError(UART_HandleTypeDef *huart)
+static const AppMemItem k_com_mem[] =
 {
-  if (s_uart == NULL || huart != s_uart)
+  APP_MEM_ITEM("com.parse", s_rx),
+  APP_MEM_ITEM("com.sync_val", s_sync_val),
+  APP_MEM_ITEM("com.sync_ver", s_sync_ver),
+};
+
+static uint32_t send_mem_items(const AppMemItem *items, uint32_t n)
+{
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < n; i++)
   {
-    return;
+    char line[48];
+    (void)snprintf(line, sizeof(line), "MEM %s %lu", items[i].name, (unsigned long)items[i].bytes);
+    send_line_wait(line);
+    total += items[i].bytes;
   }
+  return total;
+}
 
-  /* Try to recover by restarting RX. */
-  (void)HAL_UART_AbortReceive_IT(s_uart);
-  (void)HAL_UART_AbortReceive(s_uart);
+static void handle_mem(const char *arg)
+{
+  char line[200];
 
-  if (s_rx_mode == APP_COM_RX_MODE_IDLE_DMA && s_uart->hdmarx != NULL)
+  if (arg != NULL)
   {
-    if (HAL_UARTEx_ReceiveToIdle_DMA(s_uart, s_rx_dma, (uint16_t)APP_COM_RX_DMA_SIZE) == HAL_OK)
+    if (strcmp(arg, "RESET") == 0)
     {
-      __HAL_DMA_DISABLE_IT(s_uart->hdmarx, DMA_IT_HT);
-      goto rx_ok;
+      AppMem_PaintStack();
+      AppAudio_ResetRingPeak();
+      AppSerial_ResetPeaks();
+      send_line("OK MEM RESET");
+      return;
     }
-    /* DMA path failed, degrade. */
-    s_rx_mode = APP_COM_RX_MODE_IDLE_IT;
-  }
-
-  if (s_rx_mode == APP_COM_RX_MODE_IDLE_IT)
-  {
-    if (HAL_UARTEx_ReceiveToIdle_IT(s_uart, s_rx_dma, (uint16_t)APP_COM_RX_DMA_SIZE) == HAL_OK)
+    if (strcmp(arg, "MAP") == 0)
     {
-      goto rx_ok;
+      const AppMemItem *items;
+      uint32_t total = 0;
+      uint32_t n = AppDsp_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppAudio_MemMap(&items);
+      total += send_mem_items(items, n);
+      total += send_mem_items(k_com_mem, (uint32_t)(sizeof(k_com_mem) / sizeof(k_com_mem[0])));
+      n = AppSerial_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppCapture_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppSelfTest_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppTrace_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppTelem_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppCabIr_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppTuner_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppSpectrum_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppPreset_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppUac_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppCdc_MemMap(&items);
+      total += send_mem_items(items, n);
+      n = AppBle_MemMap(&items);
+      total += send_mem_items(items, n);
+      AppDspLoopInfo li;
+      AppDsp_GetLoopInfo(&li);
+      const AppMemItem loop_item = {"dsp.loop", li.bytes};
+      total += send_mem_items(&loop_item, (li.bytes != 0u) ? 1u : 0u);
+      (void)snprintf(line, sizeof(line), "OK MEM MAP total=%lu", (unsigned long)total);
+      send_line_wait(line);
+      return;
     }
-    /* Idle IT failed, degrade to byte mode. */
-    s_rx_mode = APP_COM_RX_MODE_BYTE;
+    send_line("ERR MEM");
+    return;
   }
 
-  (void)HAL_UART_Receive_IT(s_uart, &s_rx_byte, 1);
-
-rx_ok:
+  AppMemStats m;
+  AppAudioStats a;
+  AppDspArenaInfo ar;
+  AppSerialInfo si;
+  AppMem_GetStats(&m);
+  AppSerial_Get(&si);
+  AppAudio_GetStats(&a);
+  AppDsp_GetArena(&ar);
+  const uint32_t total = m.ram_size + m.ccm_size;
+  const uint32_t used = m.ram_used + m.ccm_used;
+  (void)snprintf(line, sizeof(line),
+                 "MEM ram=%lu/%lu ccm=%lu/%lu free=%lu stack=%lu/%lu heap=%lu "
+                 "com_rx=%u/%u com_tx=%u/%u audio_ring=%lu/%lu "
+                 "arena=%lu/%lu shared=%lu overlay=%s",
+                 (unsigned long)m.ram_used, (unsigned long)m.ram_size,
+                 (unsigned long)m.ccm_used, (unsigned long)m.ccm_size,
+                 (unsigned long)((used < total) ? (total - used) : 0u),
+                 (unsigned long)m.stack_peak, (unsigned long)m.stack_size,
+                 (unsigned long)m.heap_size,
+                 (unsigned)si.rx_peak, (unsigned)APP_SERIAL_RX_RING_SIZE,
+                 (unsigned)si.tx_peak, (unsigned)APP_SERIAL_TX_RING_SIZE,
+                 (unsigned long)a.ring_peak, (unsigned long)a.ring_frames,
+                 (unsigned long)ar.used, (unsigned long)ar.size,
+                 (unsigned long)ar.shared, ar.owner);
+  send_line(line);
+}
 
-  /* Also recover TX if it got stuck. */
-  (void)HAL_UART_AbortTransmit_IT(s_uart);
-  s_tx_busy = 0;
-  tx_kick();
+/* Share of the half-buffer period in x0.1% units. */
+static uint32_t load_permille(uint32_t cycles, uint32_t period)
+{
+  if (period == 0u)
+  {
+    return 0u;
+  }
+  return (uint32_t)(((uint64_t)cycles * 1000u) / period);
 }
 
-void AppCom_Poll(void)
+/* DMODEL: each distortion model's declared cost, so a client can show it
+ * before switching; cyc_frame= and load= at the dist_os set now.
+ */
+static void handle_dmodel(void)
 {
-  while (s_rx_rd != s_rx_wr)
+  const uint32_t os = (uint32_t)AppDsp_GetParam(APP_DSP_PARAM_DIST_OVERSAMPLE);
+  const uint32_t budget = AppProf_CyclesPerFrame();
+  char buf[112];
+  AppDspDistModelInfo mi;
+  uint32_t id = 0;
+  for (; AppDsp_GetDistModel(id, &mi); id++)
   {
-    uint8_t b = s_rx_ring[s_rx_rd];
-    s_rx_rd = ring_next(s_rx_rd);
+    const uint32_t cyc = AppDsp_DistModelCycles(id, os);
+    const uint32_t load_pm = (budget != 0u) ? (uint32_t)(((uint64_t)cyc * 1000u) / budget) : 0u;
+    (void)snprintf(buf, sizeof(buf), "DMODEL %lu %s cyc=%u/%u/%u cyc_frame=%lu load=%lu.%lu%%",
+                   (unsigned long)id, mi.name,
+                   (unsigned)mi.cyc_sample[0], (unsigned)mi.cyc_sample[1], (unsigned)mi.cyc_sample[2],
+                   (unsigned long)cyc, (unsigned long)(load_pm / 10u), (unsigned long)(load_pm % 10u));
+    send_line(buf);
+  }
+  (void)snprintf(buf, sizeof(buf), "OK DMODEL count=%lu sel=%ld os=%lu", (unsigned long)id,
+                 (long)AppDsp_GetParam(APP_DSP_PARAM_DIST_MODEL), (unsigned long)os);
+  send_line(buf);
+}
 
-    if (b == '\n')
+static void handle_load(void)
+{
+  AppAudioStats st;
+  AppAudio_GetStats(&st);
+
+  uint32_t rx = load_permille(st.rx_avg_cycles, st.period_cycles);
+  uint32_t rx_max = load_permille(st.rx_max_cycles, st.period_cycles);
+  uint32_t tx = load_permille(st.tx_avg_cycles, st.period_cycles);
+  uint32_t tx_max = load_permille(st.tx_max_cycles, st.period_cycles);
+  uint32_t idle = AppPower_TakeIdle(NULL);
+  AppDspShedInfo sh;
+  AppDsp_GetShed(&sh);
+
+  char buf[320];
+  (void)snprintf(buf, sizeof(buf),
+                 "LOAD rx=%lu.%lu%% rx_max=%lu.%lu%% tx=%lu.%lu%% tx_max=%lu.%lu%% isr_max_cyc=%lu period_cyc=%lu underrun=%lu overflow=%lu i2s_err=%lu recov=%lu glitch_us=%lu dsp_late=%lu miss=%lu idle=%lu.%lu%% tier=%lu/%lu shed=%lu restore=%lu hclk=%lu",
+                 (unsigned long)(rx / 10u), (unsigned long)(rx % 10u),
+                 (unsigned long)(rx_max / 10u), (unsigned long)(rx_max % 10u),
+                 (unsigned long)(tx / 10u), (unsigned long)(tx % 10u),
+                 (unsigned long)(tx_max / 10u), (unsigned long)(tx_max % 10u),
+                 (unsigned long)st.isr_max_cycles,
+                 (unsigned long)st.period_cycles,
+                 (unsigned long)st.ring_underrun,
+                 (unsigned long)st.ring_overflow,
+                 (unsigned long)st.i2s_error_count,
+                 (unsigned long)st.i2s_recoveries,
+                 (unsigned long)st.glitch_us,
+                 (unsigned long)st.dsp_late,
+                 (unsigned long)st.deadline_miss,
+                 (unsigned long)(idle / 10u), (unsigned long)(idle % 10u),
+                 (unsigned long)sh.tier, (unsigned long)sh.tier_max,
+                 (unsigned long)sh.sheds, (unsigned long)sh.restores,
+                 (unsigned long)(SystemCoreClock / 1000000u));
+  send_line(buf);
+}
+
+static const char *const k_cpu_args[] = {"AUTO", "FULL", "HALF"};
+static const char *const k_cpu_modes[] = {"auto", "full", "half"};
+
+/* CPU [AUTO | FULL | HALF] */
+static void handle_cpu(const char *arg)
+{
+  if (arg != NULL)
+  {
+    uint32_t mode = 0;
+    while ((mode < 3u) && (strcmp(arg, k_cpu_args[mode]) != 0))
+    {
+      mode++;
+    }
+    if (mode >= 3u)
+    {
+      send_line("ERR CPU");
+      return;
+    }
+    if (!AppPower_SetClockMode((AppPowerClockMode)mode))
+    {
+      send_line("ERR CPU DISABLED");
+      return;
+    }
+  }
+  AppPowerClockInfo c;
+  AppPower_GetClock(&c);
+  char buf[160];
+  (void)snprintf(buf, sizeof(buf), "%sCPU mode=%s hclk=%lu load=%lu.%lu%% up=%lu down=%lu full_ms=%lu half_ms=%lu",
+                 (arg != NULL) ? "OK " : "", k_cpu_modes[c.mode], (unsigned long)(c.hclk_hz / 1000000u),
+                 (unsigned long)(c.load_permille / 10u), (unsigned long)(c.load_permille % 10u),
+                 (unsigned long)c.steps_up, (unsigned long)c.steps_down, (unsigned long)c.full_ms,
+                 (unsigned long)c.half_ms);
+  send_line(buf);
+}
+
+static const char *const k_aerr_kind_names[] = {"dma", "ovr", "udr", "fre"};
+
+/* AERR: the I2S error incidents the audio path logged, oldest first. */
+/* EVLOG [DUMP [<first>] | CLEAR] */
+static void handle_evlog(const char *arg)
+{
+#if APP_EVLOG_ENABLE
+  char buf[128];
+  if ((arg != NULL) && (strcmp(arg, "CLEAR") == 0))
+  {
+    send_line(AppEvLog_Clear() ? "OK EVLOG CLEAR" : "ERR EVLOG FLASH");
+    return;
+  }
+  AppEvLogInfo info;
+  AppEvLog_GetInfo(&info);
+  if ((arg != NULL) && (strcmp(arg, "DUMP") == 0))
+  {
+    uint32_t i = 0;
+    const char *f = tok_next();
+    if ((f != NULL) && !parse_u32(f, &i))
+    {
+      send_line("ERR EVLOG");
+      return;
+    }
+    AppEvLogRecord r;
+    for (; AppEvLog_Get(i, &r); i++)
+    {
+      const int len = snprintf(buf, sizeof(buf),
+                               "EVLOG %lu boot=%u t=%lu type=%s n=%lu preset=%u mask=%u load=%u.%u%% hclk=%u",
+                               (unsigned long)i, (unsigned)r.boot, (unsigned long)r.ms,
+                               AppEvLog_TypeName(r.type), (unsigned long)r.count, (unsigned)r.preset,
+                               (unsigned)r.fx_mask, (unsigned)(r.load / 10u), (unsigned)(r.load % 10u),
+                               (unsigned)r.hclk_mhz);
+      /* Keep room for this line and the closing OK. */
+      if ((len <= 0) || (tx_ring_free() < (uint16_t)(len + 1 + 48)))
+      {
+        break;
+      }
+      send_line(buf);
+    }
+    (void)snprintf(buf, sizeof(buf), "OK EVLOG DUMP next=%lu count=%lu", (unsigned long)i,
+                   (unsigned long)info.records);
+    send_line(buf);
+    return;
+  }
+  if (arg != NULL)
+  {
+    send_line("ERR EVLOG");
+    return;
+  }
+  (void)snprintf(buf, sizeof(buf), "EVLOG n=%lu boot=%u room=%lu lost=%lu pages=%u",
+                 (unsigned long)info.records, (unsigned)info.boot, (unsigned long)info.room,
+                 (unsigned long)info.lost, (unsigned)info.pages);
+  send_line(buf);
+#else
+  (void)arg;
+  send_line("ERR EVLOG DISABLED");
+#endif
+}
+
+static void handle_aerr(void)
+{
+  AppAudioErrEvent ev[APP_AUDIO_ERR_LOG_LEN];
+  uint32_t n = AppAudio_GetErrLog(ev, APP_AUDIO_ERR_LOG_LEN);
+  char buf[112];
+  for (uint32_t i = 0; i < n; i++)
+  {
+    (void)snprintf(buf, sizeof(buf), "AERR %lu t=%lu src=%s kind=%s code=0x%02x recovered=%u gap_us=%lu",
+                   (unsigned long)ev[i].seq,
+                   (unsigned long)ev[i].tick_ms,
+                   ev[i].tx ? "tx" : "rx",
+                   (ev[i].kind < (sizeof(k_aerr_kind_names) / sizeof(k_aerr_kind_names[0]))) ? k_aerr_kind_names[ev[i].kind] : "?",
+                   (unsigned)ev[i].hal_code,
+                   (unsigned)ev[i].recovered,
+                   (unsigned long)ev[i].gap_us);
+    send_line(buf);
+  }
+
+  AppAudioStats st;
+  AppAudio_GetStats(&st);
+  (void)snprintf(buf, sizeof(buf), "OK AERR count=%lu recov=%lu glitch_us=%lu now=%lu",
+                 (unsigned long)((n != 0u) ? ev[n - 1u].seq : 0u),
+                 (unsigned long)st.i2s_recoveries,
+                 (unsigned long)st.glitch_us,
+                 (unsigned long)HAL_GetTick());
+  send_line(buf);
+}
+
+static const char *const k_latency_names[APP_AUDIO_LATENCY_COUNT] = {"low", "mid", "safe", "large"};
+
+static void send_latency(const char *prefix)
+{
+  AppAudioLatency lat = AppAudio_GetLatency();
+  uint32_t frames = AppAudio_GetFramesPerHalf();
+  uint32_t target = AppAudio_GetRingTargetFrames();
+  uint32_t est_us = (uint32_t)(((uint64_t)AppAudio_GetLatencyFrames() * 1000000u) / APP_AUDIO_SAMPLE_RATE_HZ);
+  uint32_t rt_floor = 0;
+  uint32_t rt_ceil = 0;
+  uint32_t rt_low = 0;
+  AppAudio_GetRingTargetRange(&rt_floor, &rt_ceil, &rt_low);
+
+  char buf[128];
+  (void)snprintf(buf, sizeof(buf), "%s %s frames=%lu target=%lu est_us=%lu floor=%lu ceil=%lu low=%lu lead_us=%lu",
+                 prefix,
+                 ((uint32_t)lat < (uint32_t)APP_AUDIO_LATENCY_COUNT) ? k_latency_names[lat] : "?",
+                 (unsigned long)frames,
+                 (unsigned long)target,
+                 (unsigned long)est_us,
+                 (unsigned long)rt_floor,
+                 (unsigned long)rt_ceil,
+                 (unsigned long)rt_low,
+                 (unsigned long)AppAudio_GetTxLeadUs());
+  send_line(buf);
+}
+
+static void handle_latency(const char *arg)
+{
+  if (arg == NULL)
+  {
+    send_latency("LATENCY");
+    return;
+  }
+
+  for (uint32_t i = 0; i < (uint32_t)APP_AUDIO_LATENCY_COUNT; i++)
+  {
+    if (strcmp(arg, k_latency_names[i]) == 0)
+    {
+      if (!AppAudio_SetLatency((AppAudioLatency)i))
+      {
+        send_line("ERR LATENCY UNAVAILABLE");
+        return;
+      }
+      send_latency("OK LATENCY");
+      return;
+    }
+  }
+
+  send_line("ERR LATENCY");
+}
+
+static const char *const k_resampler_names[APP_AUDIO_RESAMPLER_COUNT] = {"linear", "hermite", "fir"};
+
+static void handle_resampler(const char *arg)
+{
+  char buf[48];
+
+  if (arg == NULL)
+  {
+    AppAudioResampler cur = AppAudio_GetResampler();
+    (void)snprintf(buf, sizeof(buf), "RESAMPLER %s",
+                   ((uint32_t)cur < (uint32_t)APP_AUDIO_RESAMPLER_COUNT) ? k_resampler_names[cur] : "?");
+    send_line(buf);
+    return;
+  }
+
+  for (uint32_t i = 0; i < (uint32_t)APP_AUDIO_RESAMPLER_COUNT; i++)
+  {
+    if (strcmp(arg, k_resampler_names[i]) == 0)
+    {
+      if (!AppAudio_SetResampler((AppAudioResampler)i))
+      {
+        send_line("ERR RESAMPLER UNAVAILABLE");
+        return;
+      }
+      (void)snprintf(buf, sizeof(buf), "OK RESAMPLER %s", k_resampler_names[i]);
+      send_line(buf);
+      return;
+    }
+  }
+
+  send_line("ERR RESAMPLER");
+}
+
+/* Signed x10 fixed value as "-12.3". */
+static void fmt_x10(char *dst, size_t n, int32_t v)
+{
+  uint32_t a = (v < 0) ? (uint32_t)(-v) : (uint32_t)v;
+  (void)snprintf(dst, n, "%s%lu.%lu", (v < 0) ? "-" : "", (unsigned long)(a / 10u), (unsigned long)(a % 10u));
+}
+
+/* Signed x100 fixed value as "-1.23". */
+static void fmt_x100(char *dst, size_t n, int32_t v)
+{
+  uint32_t a = (v < 0) ? (uint32_t)(-v) : (uint32_t)v;
+  (void)snprintf(dst, n, "%s%lu.%02lu", (v < 0) ? "-" : "", (unsigned long)(a / 100u), (unsigned long)(a % 100u));
+}
+
+/* JITTER: one line per stream, the histogram as comma-separated bin counts
+ * (bin edges 1, 2, 4, ... us, see APP_AUDIO_JITTER_BINS).
+ */
+static void send_jitter(const char *name, const AppAudioJitter *j)
+{
+  char buf[160];
+  int len = snprintf(buf, sizeof(buf), "JITTER %s n=%lu max_us=%lu hist=",
+                     name, (unsigned long)j->count, (unsigned long)j->max_us);
+  for (uint32_t i = 0; (i < APP_AUDIO_JITTER_BINS) && (len > 0) && ((size_t)len < sizeof(buf)); i++)
+  {
+    len += snprintf(&buf[len], sizeof(buf) - (size_t)len, (i == 0u) ? "%lu" : ",%lu", (unsigned long)j->hist[i]);
+  }
+  send_line(buf);
+}
+
+static void handle_jitter(const char *arg)
+{
+  if (arg != NULL)
+  {
+    if (strcmp(arg, "RESET") == 0)
+    {
+      AppAudio_ResetJitter();
+      send_line("OK JITTER RESET");
+      return;
+    }
+    send_line("ERR JITTER");
+    return;
+  }
+
+  AppAudioJitter rx;
+  AppAudioJitter tx;
+  uint32_t period_us = 0;
+  if (!AppAudio_GetJitter(&rx, &tx, &period_us))
+  {
+    send_line("ERR JITTER DISABLED");
+    return;
+  }
+  send_jitter("rx", &rx);
+  send_jitter("tx", &tx);
+
+  char buf[48];
+  (void)snprintf(buf, sizeof(buf), "OK JITTER period_us=%lu", (unsigned long)period_us);
+  send_line(buf);
+}
+
+static void handle_clock(const char *arg)
+{
+  if (arg != NULL)
+  {
+    if (strcmp(arg, "RESET") == 0)
+    {
+      AppAudio_ResetClockStats();
+      send_line("OK CLOCK RESET");
+      return;
+    }
+    send_line("ERR CLOCK");
+    return;
+  }
+
+  AppAudioClockStats st;
+  AppAudio_GetClock(&st);
+
+  if (st.sync_clock)
+  {
+    send_line("CLOCK sync=1 ppm=0.0 locked=1");
+    return;
+  }
+
+  char ppm[16];
+  char est[16];
+  char mn[16];
+  char mx[16];
+  fmt_x10(ppm, sizeof(ppm), st.ppm_x10);
+  fmt_x10(est, sizeof(est), st.est_ppm_x10);
+  fmt_x10(mn, sizeof(mn), st.est_min_ppm_x10);
+  fmt_x10(mx, sizeof(mx), st.est_max_ppm_x10);
+
+  char buf[176];
+  (void)snprintf(buf, sizeof(buf), "CLOCK sync=0 ppm=%s est=%s min=%s max=%s step_q16=%ld fill_err=%ld locked=%u limit_hits=%lu exact=%u",
+                 ppm, est, mn, mx,
+                 (long)st.step_q16,
+                 (long)st.fill_err,
+                 (unsigned)st.locked,
+                 (unsigned long)st.limit_hits,
+                 (unsigned)st.exact);
+  send_line(buf);
+}
+
+#if APP_AUDIO_LTEST_ENABLE
+static const char *const k_ltest_state_names[] = {"idle", "running", "done", "nosignal", "noisy", "aborted"};
+
+static void send_ltest(const char *prefix)
+{
+  AppAudioLtest lt;
+  AppAudio_GetLatencyTest(&lt);
+
+  char avg[16];
+  char conv[16];
+  fmt_x10(avg, sizeof(avg), (int32_t)lt.avg_frames_x10);
+  fmt_x10(conv, sizeof(conv), lt.conv_frames_x10);
+  uint32_t us = (uint32_t)(((uint64_t)lt.avg_frames_x10 * 100000u) / APP_AUDIO_SAMPLE_RATE_HZ);
+
+  char buf[200];
+  (void)snprintf(buf, sizeof(buf), "%s %s runs=%lu/%lu total=%lu/%s/%lu dma=%lu ring=%lu conv=%s us=%lu dwt_us=%lu noise=%lu level=%lu",
+                 prefix,
+                 k_ltest_state_names[lt.state],
+                 (unsigned long)lt.runs,
+                 (unsigned long)APP_AUDIO_LTEST_RUNS,
+                 (unsigned long)lt.min_frames,
+                 avg,
+                 (unsigned long)lt.max_frames,
+                 (unsigned long)lt.dma_frames,
+                 (unsigned long)lt.ring_frames,
+                 conv,
+                 (unsigned long)us,
+                 (unsigned long)lt.dwt_us,
+                 (unsigned long)lt.noise_peak,
+                 (unsigned long)lt.level);
+  send_line(buf);
+}
+#endif
+
+static void handle_ltest(const char *arg)
+{
+#if APP_AUDIO_LTEST_ENABLE
+  if (arg == NULL)
+  {
+    send_ltest("LTEST");
+    return;
+  }
+  if ((strcmp(arg, "RUN") != 0) || !AppAudio_StartLatencyTest())
+  {
+    send_line("ERR LTEST");
+    return;
+  }
+  send_line("OK LTEST RUN");
+#else
+  (void)arg;
+  send_line("ERR LTEST DISABLED");
+#endif
+}
+
+#if APP_AUDIO_ITEST_ENABLE
+static const char *const k_itest_state_names[] = {"idle", "running", "done", "aborted"};
+#endif
+
+static void handle_itest(const char *arg)
+{
+#if APP_AUDIO_ITEST_ENABLE
+  if (arg == NULL)
+  {
+    AppAudioItest it;
+    AppAudio_GetIntegrityTest(&it);
+    const uint8_t same = (it.ref_blocks == it.total) && (it.ref_frames == it.frames);
+    const int match = ((it.state != APP_AUDIO_ITEST_DONE) || !same) ? -1 : (it.hash == it.ref_hash) ? 1 : 0;
+    char ref[12] = "none";
+    if (it.ref_blocks != 0u)
+    {
+      (void)snprintf(ref, sizeof(ref), "%08lx", (unsigned long)it.ref_hash);
+    }
+    char buf[200];
+    (void)snprintf(buf, sizeof(buf),
+                   "ITEST %s blocks=%lu/%lu frames=%lu hash=%08lx ref=%s match=%d underrun=%lu overflow=%lu i2s_err=%lu dsp_late=%lu miss=%lu shed=%lu",
+                   k_itest_state_names[it.state],
+                   (unsigned long)it.blocks, (unsigned long)it.total, (unsigned long)it.frames,
+                   (unsigned long)it.hash, ref, match,
+                   (unsigned long)it.underrun, (unsigned long)it.overflow, (unsigned long)it.i2s_errors,
+                   (unsigned long)it.dsp_late, (unsigned long)it.deadline_miss, (unsigned long)it.sheds);
+    send_line(buf);
+    return;
+  }
+  uint32_t blocks = 2000u;
+  const char *n = tok_next();
+  if ((strcmp(arg, "RUN") != 0) || ((n != NULL) && !parse_u32(n, &blocks)) || !AppAudio_StartIntegrityTest(blocks))
+  {
+    send_line("ERR ITEST");
+    return;
+  }
+  send_line("OK ITEST RUN");
+#else
+  (void)arg;
+  send_line("ERR ITEST DISABLED");
+#endif
+}
+
+static void send_dtap(const char *prefix, uint32_t index)
+{
+  char buf[80];
+  AppDspDelayTap t;
+  if (!AppDsp_GetDelayTap(index, &t))
+  {
+    return;
+  }
+  (void)snprintf(buf, sizeof(buf), "%s %lu time_q12=%u pan_q15=%u gain_q15=%ld",
+                 prefix,
+                 (unsigned long)index,
+                 (unsigned)t.time_q12,
+                 (unsigned)t.pan_q15,
+                 (long)t.gain_q15);
+  send_line(buf);
+}
+
+static void handle_dtap(const char *arg)
+{
+  if (arg == NULL)
+  {
+    for (uint32_t i = 0; i < APP_DSP_DELAY_TAPS_MAX; i++)
+    {
+      send_dtap("DTAP", i);
+    }
+    send_line("OK DTAP");
+    return;
+  }
+
+  uint32_t index = 0;
+  uint32_t time_q12 = 0;
+  uint32_t pan_q15 = 0;
+  int32_t gain_q15 = 0;
+  if (!parse_u32(arg, &index) ||
+      !parse_u32(tok_next(), &time_q12) ||
+      !parse_u32(tok_next(), &pan_q15) ||
+      !parse_i32(tok_next(), &gain_q15))
+  {
+    send_line("ERR DTAP");
+    return;
+  }
+
+  AppDspDelayTap t;
+  t.time_q12 = (uint16_t)((time_q12 > 4096u) ? 4096u : time_q12);
+  t.pan_q15 = (uint16_t)((pan_q15 > 32768u) ? 32768u : pan_q15);
+  t.gain_q15 = gain_q15;
+  if (!AppDsp_SetDelayTap(index, &t))
+  {
+    send_line("ERR DTAP");
+    return;
+  }
+  send_dtap("OK DTAP", index);
+}
+
+/* PSAVE/PLOAD <n>: preset slots 0..APP_PRESET_COUNT-1 in flash. */
+static void handle_preset(const char *cmd, const char *arg, bool save)
+{
+  char buf[48];
+  uint32_t slot = 0;
+  bool ok = parse_u32(arg, &slot);
+  if (ok)
+  {
+    ok = save ? (AppPreset_Save(slot) != 0u) : (AppPreset_Load(slot) != 0u);
+  }
+  (void)snprintf(buf, sizeof(buf), "%s %s %s", ok ? "OK" : "ERR", cmd, (arg != NULL) ? arg : "?");
+  send_line(buf);
+}
+
+static void handle_pbank(void)
+{
+  uint32_t stored = 0;
+  for (uint32_t slot = 0; slot < APP_PRESET_COUNT; slot++)
+  {
+    if (AppPreset_IsStored(slot))
+    {
+      stored |= 1uL << slot;
+    }
+  }
+  char buf[128];
+  (void)snprintf(buf, sizeof(buf), "PBANK slots=%lu image=%lu params=%lu taps=%lu stored=%lu fmt=%lu hash=%lu",
+                 (unsigned long)APP_PRESET_COUNT, (unsigned long)AppPreset_ImageSize(),
+                 (unsigned long)APP_DSP_PARAM_COUNT, (unsigned long)APP_DSP_DELAY_TAPS_MAX,
+                 (unsigned long)stored, (unsigned long)APP_PRESET_FILE_VERSION,
+                 (unsigned long)AppPreset_ParamHash());
+  send_line(buf);
+}
+
+#if APP_CAPTURE_ENABLE
+static const char *const k_cap_tap_names[APP_METER_TAP_COUNT] = {"in", "dist", "delay", "reverb", "out"};
+static const char *const k_cap_state_names[] = {"idle", "armed", "running", "done"};
+
+static void send_cap(const char *prefix)
+{
+  AppCaptureInfo ci;
+  AppCapture_GetInfo(&ci);
+
+  char buf[112];
+  (void)snprintf(buf, sizeof(buf), "%s %s tap=%s decim=%lu n=%lu/%lu inject=%lu",
+                 prefix,
+                 k_cap_state_names[ci.state],
+                 k_cap_tap_names[ci.tap],
+                 (unsigned long)ci.decim,
+                 (unsigned long)ci.done,
+                 (unsigned long)ci.count,
+                 (unsigned long)ci.inject);
+  send_line(buf);
+}
+#endif
+
+/* CAP [STOP | <tap> [<decim>] [<n>]] and INJ <m> [<tap> [<decim>] [<n>]]
+ * (inject != 0); the tap is "out" and decim 1 unless given. The arguments
+ * after 'arg' follow in tok_next().
+ */
+static void handle_cap(const char *cmd, const char *arg, uint32_t inject)
+{
+#if APP_CAPTURE_ENABLE
+  if ((inject == 0u) && (arg == NULL))
+  {
+    send_cap("CAP");
+    return;
+  }
+  if ((inject == 0u) && (strcmp(arg, "STOP") == 0))
+  {
+    AppCapture_Abort();
+    s_dump_end = 0;
+    send_line("OK CAP STOP");
+    return;
+  }
+
+  char err[16];
+  (void)snprintf(err, sizeof(err), "ERR %s", cmd);
+
+  uint32_t tap = (uint32_t)APP_METER_TAP_OUTPUT;
+  uint32_t decim = 1u;
+  uint32_t count = 0u;
+  if (arg != NULL)
+  {
+    for (tap = 0; tap < (uint32_t)APP_METER_TAP_COUNT; tap++)
+    {
+      if (strcmp(arg, k_cap_tap_names[tap]) == 0)
+      {
+        break;
+      }
+    }
+    const char *a = tok_next();
+    const char *b = tok_next();
+    if ((tap >= (uint32_t)APP_METER_TAP_COUNT) ||
+        ((a != NULL) && !parse_u32(a, &decim)) ||
+        ((b != NULL) && !parse_u32(b, &count)))
+    {
+      send_line(err);
+      return;
+    }
+  }
+  if (!AppCapture_Arm((AppMeterTap)tap, decim, count, inject))
+  {
+    send_line(err);
+    return;
+  }
+  s_dump_end = 0; /* a stale DUMP stream would read the new run */
+  char prefix[16];
+  (void)snprintf(prefix, sizeof(prefix), "OK %s", cmd);
+  send_cap(prefix);
+#else
+  (void)arg;
+  (void)inject;
+  char buf[32];
+  (void)snprintf(buf, sizeof(buf), "ERR %s DISABLED", cmd);
+  send_line(buf);
+#endif
+}
+
+/* DUMP [<first>]: queues the finished capture from 'first' on; dump_poll()
+ * frames it as the TX ring drains.
+ */
+static void handle_dump(const char *arg)
+{
+#if APP_CAPTURE_ENABLE
+  AppCaptureInfo ci;
+  AppCapture_GetInfo(&ci);
+  uint32_t first = 0;
+  if ((ci.state != APP_CAPTURE_DONE) ||
+      ((arg != NULL) && (!parse_u32(arg, &first) || (first > ci.done))))
+  {
+    send_line("ERR DUMP");
+    return;
+  }
+  char buf[64];
+  (void)snprintf(buf, sizeof(buf), "OK DUMP %lu %lu rate=%lu",
+                 (unsigned long)first,
+                 (unsigned long)ci.done,
+                 (unsigned long)(APP_AUDIO_SAMPLE_RATE_HZ / ci.decim));
+  send_line(buf);
+  s_dump_pos = first;
+  s_dump_end = ci.done;
+  s_dump_link = s_link;
+#else
+  (void)arg;
+  send_line("ERR DUMP DISABLED");
+#endif
+}
+
+#if APP_SELFTEST_ENABLE
+static const char *const k_stest_state_names[] = {"idle", "running", "done"};
+static const char *const k_stest_mode_names[APP_SELFTEST_MODE_COUNT] = {"tone", "sweep", "noise"};
+
+static void send_stest(const char *prefix)
+{
+  AppSelfTestInfo si;
+  AppSelfTest_GetInfo(&si);
+
+  char buf[96];
+  (void)snprintf(buf, sizeof(buf), "%s %s mode=%s n=%lu/%lu level=%ld",
+                 prefix,
+                 k_stest_state_names[si.state],
+                 k_stest_mode_names[si.mode],
+                 (unsigned long)si.done,
+                 (unsigned long)si.points,
+                 (long)si.level_db);
+  send_line(buf);
+}
+
+/* STEST RESULT [<first>]: one line per measured point, paged like PLIST. */
+static void send_stest_result(const char *arg)
+{
+  uint32_t i = 0;
+  if ((arg != NULL) && !parse_u32(arg, &i))
+  {
+    send_line("ERR STEST");
+    return;
+  }
+
+  char buf[112];
+  AppSelfTestPoint pt;
+  for (; AppSelfTest_GetPoint(i, &pt); i++)
+  {
+    char gain[16];
+    fmt_x100(gain, sizeof(gain), pt.gain_x100);
+    int len;
+    if (pt.freq_x10 == 0u)
+    {
+      len = snprintf(buf, sizeof(buf), "STEST %lu noise gain=%s", (unsigned long)i, gain);
+    }
+    else
+    {
+      char freq[16];
+      char phase[16];
+      char thd[16];
+      char thdn[16];
+      fmt_x10(freq, sizeof(freq), (int32_t)pt.freq_x10);
+      fmt_x10(phase, sizeof(phase), pt.phase_x10);
+      fmt_x10(thd, sizeof(thd), pt.thd_x10);
+      fmt_x10(thdn, sizeof(thdn), pt.thdn_x10);
+      len = snprintf(buf, sizeof(buf), "STEST %lu f=%s gain=%s phase=%s thd=%s thdn=%s",
+                     (unsigned long)i, freq, gain, phase, thd, thdn);
+    }
+    /* Keep room for this line and the closing OK. */
+    if ((len <= 0) || (tx_ring_free() < (uint16_t)(len + 1 + 48)))
+    {
+      break;
+    }
+    send_line(buf);
+  }
+
+  AppSelfTestInfo si;
+  AppSelfTest_GetInfo(&si);
+  (void)snprintf(buf, sizeof(buf), "OK STEST RESULT next=%lu done=%lu", (unsigned long)i, (unsigned long)si.done);
+  send_line(buf);
+}
+#endif
+
+/* STEST [TONE <hz> | SWEEP <f1> <f2> [<points>] | NOISE] [<dBFS>],
+ * STEST STOP, STEST RESULT [<first>].
+ */
+static void handle_stest(const char *arg)
+{
+#if APP_SELFTEST_ENABLE
+  if (arg == NULL)
+  {
+    send_stest("STEST");
+    return;
+  }
+  if (strcmp(arg, "STOP") == 0)
+  {
+    AppSelfTest_Stop();
+    send_line("OK STEST STOP");
+    return;
+  }
+  if (strcmp(arg, "RESULT") == 0)
+  {
+    send_stest_result(tok_next());
+    return;
+  }
+
+  AppSelfTestMode mode;
+  uint32_t f1 = 0u;
+  uint32_t f2 = 0u;
+  uint32_t points = 16u;
+  int32_t level = -20;
+  bool ok = true;
+  if (strcmp(arg, "TONE") == 0)
+  {
+    mode = APP_SELFTEST_TONE;
+    const char *a = tok_next();
+    ok = (a != NULL) && parse_u32(a, &f1);
+  }
+  else if (strcmp(arg, "SWEEP") == 0)
+  {
+    mode = APP_SELFTEST_SWEEP;
+    const char *a = tok_next();
+    const char *b = tok_next();
+    const char *c = tok_next();
+    ok = (a != NULL) && (b != NULL) && parse_u32(a, &f1) && parse_u32(b, &f2) &&
+         ((c == NULL) || parse_u32(c, &points));
+  }
+  else if (strcmp(arg, "NOISE") == 0)
+  {
+    mode = APP_SELFTEST_NOISE;
+  }
+  else
+  {
+    send_line("ERR STEST");
+    return;
+  }
+  const char *l = tok_next();
+  if (!ok || ((l != NULL) && !parse_i32(l, &level)) || !AppSelfTest_Start(mode, f1, f2, points, level))
+  {
+    send_line("ERR STEST");
+    return;
+  }
+  AppProf_Reset();
+  AppDsp_ResetClip();
+  send_stest("OK STEST");
+#else
+  (void)arg;
+  send_line("ERR STEST DISABLED");
+#endif
+}
+
+#if APP_TRACE_ENABLE
+static const char *const k_trace_state_names[] = {"running", "triggered", "frozen"};
+
+static void send_trace(const char *prefix)
+{
+  AppTraceInfo ti;
+  AppTrace_GetInfo(&ti);
+
+  char buf[112];
+  (void)snprintf(buf, sizeof(buf), "%s %s n=%lu seq=%lu trig=%lu id=%lu mask=%lu",
+                 prefix,
+                 k_trace_state_names[ti.state],
+                 (unsigned long)ti.held,
+                 (unsigned long)ti.seq,
+                 (unsigned long)ti.trig,
+                 (unsigned long)ti.trig_id,
+                 (unsigned long)ti.trig_mask);
+  send_line(buf);
+}
+#endif
+
+/* TRACE [ARM [<mask>] | FREEZE | DUMP [<first>]]. DUMP freezes a running
+ * trace first and queues the held events for trace_poll().
+ */
+static void handle_trace(const char *arg)
+{
+#if APP_TRACE_ENABLE
+  if (arg == NULL)
+  {
+    send_trace("TRACE");
+    return;
+  }
+  if (strcmp(arg, "ARM") == 0)
+  {
+    uint32_t mask = APP_TRACE_TRIG_DEFAULT;
+    const char *m = tok_next();
+    if ((m != NULL) && !parse_u32(m, &mask))
+    {
+      send_line("ERR TRACE");
+      return;
+    }
+    s_trace_end = 0;
+    AppTrace_Arm(mask);
+    send_trace("OK TRACE ARM");
+    return;
+  }
+  if (strcmp(arg, "FREEZE") == 0)
+  {
+    AppTrace_Freeze();
+    send_trace("OK TRACE FREEZE");
+    return;
+  }
+  if (strcmp(arg, "DUMP") == 0)
+  {
+    AppTrace_Freeze();
+    AppTraceInfo ti;
+    AppTrace_GetInfo(&ti);
+    uint32_t first = 0;
+    const char *f = tok_next();
+    if ((f != NULL) && (!parse_u32(f, &first) || (first > ti.held)))
+    {
+      send_line("ERR TRACE");
+      return;
+    }
+    char buf[80];
+    (void)snprintf(buf, sizeof(buf), "OK TRACE DUMP %lu %lu trig=%lu hz=%lu",
+                   (unsigned long)first,
+                   (unsigned long)ti.held,
+                   (unsigned long)ti.trig,
+                   (unsigned long)SystemCoreClock);
+    send_line(buf);
+    s_trace_pos = first;
+    s_trace_end = ti.held;
+    s_trace_link = s_link;
+    return;
+  }
+  send_line("ERR TRACE");
+#else
+  (void)arg;
+  send_line("ERR TRACE DISABLED");
+#endif
+}
+
+static const char *const k_telem_names[APP_TELEM_TRANSPORT_COUNT] = {"uart", "itm", "rtt"};
+
+static void send_telem(const char *prefix)
+{
+  AppTelemStats ts;
+  AppTelem_GetStats(&ts);
+
+  char buf[112];
+  (void)snprintf(buf, sizeof(buf), "%s %s attached=%u frames=%lu events=%lu drop=%lu itm=%u rtt=%u",
+                 prefix,
+                 k_telem_names[ts.transport],
+                 (unsigned)ts.attached,
+                 (unsigned long)ts.frames,
+                 (unsigned long)ts.events,
+                 (unsigned long)ts.dropped,
+                 (unsigned)APP_TELEM_ITM,
+                 (unsigned)APP_TELEM_RTT);
+  send_line(buf);
+}
+
+/* TELEM [uart|itm|rtt]: where the stream frames and live trace go. */
+static void handle_telem(const char *arg)
+{
+  if (arg == NULL)
+  {
+    send_telem("TELEM");
+    return;
+  }
+  uint32_t t = 0;
+  while ((t < (uint32_t)APP_TELEM_TRANSPORT_COUNT) && (strcmp(arg, k_telem_names[t]) != 0))
+  {
+    t++;
+  }
+  if ((t >= (uint32_t)APP_TELEM_TRANSPORT_COUNT) || !AppTelem_Select((AppTelemTransport)t))
+  {
+    send_line("ERR TELEM");
+    return;
+  }
+  send_telem("OK TELEM");
+}
+
+#if APP_CABIR_ENABLE
+static const char *const k_cabir_state_names[] = {"empty", "loading", "active"};
+
+static void send_cabir(const char *prefix)
+{
+  AppCabIrInfo ci;
+  AppCabIr_GetInfo(&ci);
+
+  char buf[128];
+  int len = snprintf(buf, sizeof(buf), "%s %s slot=%lu taps=%lu max=%lu part=%lu slots=",
+                     prefix,
+                     k_cabir_state_names[ci.state],
+                     (unsigned long)ci.slot,
+                     (unsigned long)ci.taps,
+                     (unsigned long)APP_CABIR_TAPS_MAX,
+                     (unsigned long)APP_CABIR_PARTITION);
+  for (uint32_t s = 0; (s < APP_CABIR_SLOTS) && (len > 0) && ((size_t)len < sizeof(buf)); s++)
+  {
+    len += snprintf(&buf[len], sizeof(buf) - (size_t)len, (s == 0u) ? "%u" : ",%u", (unsigned)ci.slot_taps[s]);
+  }
+  send_line(buf);
+}
+#endif
+
+/* CABIR [BEGIN <taps> [<slot>] | COMMIT | ABORT | CLEAR [<slot>]]; the
+ * taps come in CABW frames between BEGIN and COMMIT.
+ */
+static void handle_cabir(const char *arg)
+{
+#if APP_CABIR_ENABLE
+  if (arg == NULL)
+  {
+    send_cabir("CABIR");
+    return;
+  }
+  bool ok = true;
+  if (strcmp(arg, "BEGIN") == 0)
+  {
+    uint32_t taps = 0;
+    uint32_t slot = 0;
+    const char *a = tok_next();
+    const char *b = tok_next();
+    ok = parse_u32(a, &taps) && ((b == NULL) || parse_u32(b, &slot)) &&
+         (AppCabIr_Begin(slot, taps) != 0u);
+  }
+  else if (strcmp(arg, "COMMIT") == 0)
+  {
+    ok = (AppCabIr_Commit() != 0u);
+  }
+  else if (strcmp(arg, "ABORT") == 0)
+  {
+    AppCabIr_Init();
+  }
+  else if (strcmp(arg, "CLEAR") == 0)
+  {
+    uint32_t slot = 0;
+    const char *t = tok_next();
+    ok = ((t == NULL) || parse_u32(t, &slot)) && (AppCabIr_Clear(slot) != 0u);
+  }
+  else
+  {
+    ok = false;
+  }
+  if (!ok)
+  {
+    send_line("ERR CABIR");
+    return;
+  }
+  char prefix[24];
+  (void)snprintf(prefix, sizeof(prefix), "OK CABIR %s", arg);
+  send_cabir(prefix);
+#else
+  (void)arg;
+  send_line("ERR CABIR DISABLED");
+#endif
+}
+
+static void send_cabiir_section(const char *prefix, uint32_t index)
+{
+  char buf[96];
+  int32_t c[5];
+  if (!AppDsp_GetCabSection(index, c))
+  {
+    return;
+  }
+  (void)snprintf(buf, sizeof(buf), "%s %lu %ld %ld %ld %ld %ld", prefix, (unsigned long)index,
+                 (long)c[0], (long)c[1], (long)c[2], (long)c[3], (long)c[4]);
+  send_line(buf);
+}
+
+/* CABIIR [<k> <b0> <b1> <b2> <a1> <a2> | N <n>]: the user cab, as printed
+ * by tools/dsp_host/cab_fit.
+ */
+static void handle_cabiir(const char *arg)
+{
+  char buf[48];
+  if (APP_DSP_CAB_SECTIONS_MAX == 0u)
+  {
+    send_line("ERR CABIIR DISABLED");
+    return;
+  }
+  if (arg == NULL)
+  {
+    (void)snprintf(buf, sizeof(buf), "CABIIR sections=%lu max=%lu",
+                   (unsigned long)AppDsp_GetCabSections(), (unsigned long)APP_DSP_CAB_SECTIONS_MAX);
+    send_line(buf);
+    for (uint32_t i = 0; i < AppDsp_GetCabSections(); i++)
+    {
+      send_cabiir_section("CABIIR", i);
+    }
+    send_line("OK CABIIR");
+    return;
+  }
+
+  if (strcmp(arg, "N") == 0)
+  {
+    uint32_t count = 0;
+    if (!parse_u32(tok_next(), &count) || !AppDsp_SetCabSections(count))
+    {
+      send_line("ERR CABIIR");
+      return;
+    }
+    (void)snprintf(buf, sizeof(buf), "OK CABIIR sections=%lu max=%lu",
+                   (unsigned long)count, (unsigned long)APP_DSP_CAB_SECTIONS_MAX);
+    send_line(buf);
+    return;
+  }
+
+  uint32_t index = 0;
+  int32_t c[5];
+  bool ok = parse_u32(arg, &index);
+  for (uint32_t k = 0; ok && (k < 5u); k++)
+  {
+    ok = parse_i32(tok_next(), &c[k]);
+  }
+  if (!ok || !AppDsp_SetCabSection(index, c))
+  {
+    send_line("ERR CABIIR");
+    return;
+  }
+  send_cabiir_section("OK CABIIR", index);
+}
+
+#if APP_TUNER_ENABLE
+static const char *const k_tuner_mode_names[] = {"off", "on", "mute"};
+static const char *const k_note_names[12] =
+{
+  "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B",
+};
+
+static void send_tuner(const char *prefix)
+{
+  AppTunerReading r;
+  AppTuner_Get(&r);
+
+  char note[8] = "-";
+  if (r.note >= 0)
+  {
+    (void)snprintf(note, sizeof(note), "%s%ld", k_note_names[r.note % 12], (long)((r.note / 12) - 1));
+  }
+  char buf[80];
+  (void)snprintf(buf, sizeof(buf), "%s %s note=%s cents=%ld freq=%lu.%03lu seq=%lu",
+                 prefix,
+                 k_tuner_mode_names[r.mode],
+                 note,
+                 (long)r.cents,
+                 (unsigned long)(r.freq_mhz / 1000u),
+                 (unsigned long)(r.freq_mhz % 1000u),
+                 (unsigned long)r.seq);
+  send_line(buf);
+}
+#endif
+
+/* CHAIN [<spec>] */
+static void handle_chain(const char *arg)
+{
+  if (arg != NULL)
+  {
+    AppPower_Boost();
+  }
+  if ((arg != NULL) && !AppDsp_SetChain(arg))
+  {
+    send_line("ERR CHAIN");
+    return;
+  }
+  char spec[APP_DSP_CHAIN_SPEC_MAX];
+  char buf[APP_DSP_CHAIN_SPEC_MAX + 16u];
+  AppDsp_GetChain(spec, sizeof(spec));
+  (void)snprintf(buf, sizeof(buf), "%sCHAIN %s", (arg != NULL) ? "OK " : "", spec);
+  send_line(buf);
+}
+
+static const char *const k_loop_state_names[] = {"empty", "rec", "play", "overdub", "stopped"};
+static const char *const k_loop_cmd_names[] = {"REC", "PLAY", "STOP", "CLEAR"};
+
+/* LOOP [REC | PLAY | STOP | CLEAR] */
+static void handle_loop(const char *arg)
+{
+  char buf[80];
+  if (arg == NULL)
+  {
+    AppDspLoopInfo li;
+    AppDsp_GetLoopInfo(&li);
+    (void)snprintf(buf, sizeof(buf), "LOOP %s len=%lu pos=%lu max=%lu",
+                   k_loop_state_names[li.state],
+                   (unsigned long)li.len_ms,
+                   (unsigned long)li.pos_ms,
+                   (unsigned long)li.max_ms);
+    send_line(buf);
+    return;
+  }
+
+  uint32_t cmd = 0;
+  while ((cmd < (uint32_t)(sizeof(k_loop_cmd_names) / sizeof(k_loop_cmd_names[0]))) &&
+         (strcmp(arg, k_loop_cmd_names[cmd]) != 0))
+  {
+    cmd++;
+  }
+  if (cmd >= (uint32_t)(sizeof(k_loop_cmd_names) / sizeof(k_loop_cmd_names[0])))
+  {
+    send_line("ERR LOOP");
+    return;
+  }
+  if (AppDsp_LoopCommand((AppDspLoopCmd)cmd) == 0u)
+  {
+    send_line("ERR LOOP NORAM");
+    return;
+  }
+  (void)snprintf(buf, sizeof(buf), "OK LOOP %s", k_loop_cmd_names[cmd]);
+  send_line(buf);
+}
+
+static const char *const k_bypass_names[] = {"off", "cond", "true"};
+static const char *const k_bypass_args[] = {"OFF", "COND", "TRUE"};
+
+/* BYPASS [OFF | COND | TRUE] */
+static void handle_bypass(const char *arg)
+{
+  if (arg != NULL)
+  {
+    uint32_t tier = 0;
+    while ((tier < (uint32_t)APP_DSP_BYPASS_COUNT) && (strcmp(arg, k_bypass_args[tier]) != 0))
+    {
+      tier++;
+    }
+    if (tier >= (uint32_t)APP_DSP_BYPASS_COUNT)
+    {
+      send_line("ERR BYPASS");
+      return;
+    }
+    AppPower_Boost();
+    AppDsp_SetBypass((AppDspBypass)tier);
+  }
+  char buf[24];
+  (void)snprintf(buf, sizeof(buf), "%sBYPASS %s", (arg != NULL) ? "OK " : "", k_bypass_names[AppDsp_GetBypass()]);
+  send_line(buf);
+}
+
+static const char *const k_boot_names[] = {"cold", "warm", "fallback"};
+static const char *const k_reset_names[] = {"power", "pin", "watchdog", "software", "other"};
+
+/* BOOT [RESTART] */
+static void handle_boot(const char *arg)
+{
+  if (arg != NULL)
+  {
+    if (strcmp(arg, "RESTART") != 0)
+    {
+      send_line("ERR BOOT");
+      return;
+    }
+    s_reboot = 1u;
+    s_reboot_t0 = HAL_GetTick();
+    send_line("OK BOOT RESTART");
+    return;
+  }
+  AppRestartInfo info;
+  AppRestart_GetInfo(&info);
+  char buf[80];
+  (void)snprintf(buf, sizeof(buf), "BOOT %s reset=%s restarts=%u wdg=%u", k_boot_names[info.boot],
+                 k_reset_names[info.reset], (unsigned)info.restarts, (unsigned)info.wdg);
+  send_line(buf);
+}
+
+/* UPDATE <bytes>: the updater polls USART2 itself, so only the UART link. */
+static void handle_update(const char *arg)
+{
+  if (s_link != COM_LINK_UART)
+  {
+    send_line("ERR UPDATE link");
+    return;
+  }
+  uint32_t bytes = 0;
+  if ((arg == NULL) || !parse_u32(arg, &bytes) || !AppUpdate_Check(bytes))
+  {
+    send_line("ERR UPDATE");
+    return;
+  }
+  char buf[64];
+  (void)snprintf(buf, sizeof(buf), "OK UPDATE max=%lu frame=%u page=%u", (unsigned long)AppUpdate_MaxBytes(),
+                 (unsigned)APP_UPDATE_FRAME_MAX, (unsigned)FLASH_PAGE_SIZE);
+  send_line(buf);
+  s_update = 1u;
+  s_reboot_t0 = HAL_GetTick();
+}
+
+static void reboot_poll(void)
+{
+  if ((s_reboot || s_update) && AppSerial_TxDone() && ((HAL_GetTick() - s_reboot_t0) >= COM_REBOOT_DELAY_MS))
+  {
+    if (s_update)
+    {
+      s_update = 0;
+      AppUpdate_Enter();
+      send_line("ERR UPDATE");
+      return;
+    }
+    AppRestart_Reboot();
+  }
+}
+
+/* TUNER [ON | MUTE | OFF] */
+static void handle_tuner(const char *arg)
+{
+#if APP_TUNER_ENABLE
+  if (arg == NULL)
+  {
+    send_tuner("TUNER");
+    return;
+  }
+  if (strcmp(arg, "ON") == 0)
+  {
+    AppTuner_SetMode(APP_TUNER_ON);
+  }
+  else if (strcmp(arg, "MUTE") == 0)
+  {
+    AppTuner_SetMode(APP_TUNER_MUTE);
+  }
+  else if (strcmp(arg, "OFF") == 0)
+  {
+    AppTuner_SetMode(APP_TUNER_OFF);
+  }
+  else
+  {
+    send_line("ERR TUNER");
+    return;
+  }
+  send_tuner("OK TUNER");
+#else
+  (void)arg;
+  send_line("ERR TUNER DISABLED");
+#endif
+}
+
+static void send_expr(const char *tag)
+{
+  char buf[128];
+  AppExprInfo ei;
+  AppExpr_Get(&ei);
+  int n = snprintf(buf, sizeof(buf), "%s pos=%ld raw=%lu heel=%lu toe=%lu target=%s",
+                   tag,
+                   (long)ei.pos_q15,
+                   (unsigned long)ei.raw,
+                   (unsigned long)ei.heel,
+                   (unsigned long)ei.toe,
+                   (ei.target == APP_EXPR_TARGET_PARAM) ? "param" :
+                   ((ei.target == APP_EXPR_TARGET_MORPH) ? "morph" : "off"));
+  AppDspParamDesc d;
+  if ((n > 0) && ((size_t)n < sizeof(buf)))
+  {
+    if ((ei.target == APP_EXPR_TARGET_PARAM) && AppDsp_GetParamDesc(ei.param, &d))
+    {
+      (void)snprintf(&buf[n], sizeof(buf) - (size_t)n, " %s lo=%ld hi=%ld", d.name, (long)ei.lo, (long)ei.hi);
+    }
+    else if (ei.target == APP_EXPR_TARGET_MORPH)
+    {
+      (void)snprintf(&buf[n], sizeof(buf) - (size_t)n, " a=%u b=%u", (unsigned)ei.morph_a, (unsigned)ei.morph_b);
+    }
+  }
+  send_line(buf);
+}
+
+/* EXP [OFF | HEEL | TOE | MORPH <a> <b> | <param> <lo> <hi>] */
+static void handle_expr(const char *arg)
+{
+  if (arg == NULL)
+  {
+    send_expr("EXP");
+    return;
+  }
+  if (strcmp(arg, "OFF") == 0)
+  {
+    AppExpr_Off();
+  }
+  else if ((strcmp(arg, "HEEL") == 0) || (strcmp(arg, "TOE") == 0))
+  {
+    AppExpr_Calibrate(arg[0] == 'T');
+  }
+  else if (strcmp(arg, "MORPH") == 0)
+  {
+    uint32_t a;
+    uint32_t b;
+    if (!parse_u32(tok_next(), &a) || !parse_u32(tok_next(), &b) || !AppExpr_MapMorph(a, b))
+    {
+      send_line("ERR EXP");
+      return;
+    }
+  }
+  else
+  {
+    AppDspParamId id;
+    int32_t lo;
+    int32_t hi;
+    if (!map_param(arg, &id) || !parse_i32(tok_next(), &lo) ||
+        !parse_i32(tok_next(), &hi) || !AppExpr_MapParam(id, lo, hi))
+    {
+      send_line("ERR EXP");
+      return;
+    }
+  }
+  send_expr("OK EXP");
+}
+
+static void send_midi(const char *tag)
+{
+  char buf[128];
+  char ch[8];
+  AppMidiInfo mi;
+  AppMidi_Get(&mi);
+  if (mi.channel == 0u)
+  {
+    (void)snprintf(ch, sizeof(ch), "omni");
+  }
+  else
+  {
+    (void)snprintf(ch, sizeof(ch), "%u", (unsigned)mi.channel);
+  }
+  (void)snprintf(buf, sizeof(buf), "%s ch=%s bytes=%lu lost=%lu err=%lu pc=%lu cc=%lu beats=%lu run=%u",
+                 tag,
+                 ch,
+                 (unsigned long)mi.bytes,
+                 (unsigned long)mi.lost,
+                 (unsigned long)mi.errors,
+                 (unsigned long)mi.programs,
+                 (unsigned long)mi.controls,
+                 (unsigned long)mi.beats,
+                 (unsigned)mi.running);
+  send_line(buf);
+}
+
+static void send_midi_cc(const char *tag, const AppMidiCcMap *m)
+{
+  char buf[96];
+  AppDspParamDesc d;
+  (void)snprintf(buf, sizeof(buf), "%s %u %s lo=%ld hi=%ld",
+                 tag,
+                 (unsigned)m->cc,
+                 AppDsp_GetParamDesc(m->param, &d) ? d.name : "?",
+                 (long)m->lo,
+                 (long)m->hi);
+  send_line(buf);
+}
+
+/* MIDI CC [<cc> OFF | <cc> <param> [<lo> <hi>]] */
+static void handle_midi_cc(const char *cc_arg)
+{
+  char buf[48];
+  AppMidiCcMap m;
+  if (cc_arg == NULL)
+  {
+    uint32_t count = 0u;
+    for (uint32_t i = 0; i < APP_MIDI_CC_MAPS; i++)
+    {
+      if (AppMidi_GetCcMap(i, &m))
+      {
+        send_midi_cc("MIDI CC", &m);
+        count++;
+      }
+    }
+    (void)snprintf(buf, sizeof(buf), "OK MIDI CC count=%lu", (unsigned long)count);
+    send_line(buf);
+    return;
+  }
+
+  uint32_t cc;
+  const char *name = tok_next();
+  if (!parse_u32(cc_arg, &cc) || (cc > 127u) || (name == NULL))
+  {
+    send_line("ERR MIDI CC");
+    return;
+  }
+  if (strcmp(name, "OFF") == 0)
+  {
+    AppMidi_UnmapCc((uint8_t)cc);
+    (void)snprintf(buf, sizeof(buf), "OK MIDI CC %lu OFF", (unsigned long)cc);
+    send_line(buf);
+    return;
+  }
+
+  AppDspParamDesc d;
+  const char *lo_arg = tok_next();
+  const char *hi_arg = tok_next();
+  if (!map_param(name, &m.param) || !AppDsp_GetParamDesc(m.param, &d))
+  {
+    send_line("ERR MIDI CC");
+    return;
+  }
+  m.cc = (uint8_t)cc;
+  m.lo = d.min;
+  m.hi = d.max;
+  if (((lo_arg != NULL) && (!parse_i32(lo_arg, &m.lo) || !parse_i32(hi_arg, &m.hi))) ||
+      !AppMidi_MapCc(m.cc, m.param, m.lo, m.hi))
+  {
+    send_line("ERR MIDI CC");
+    return;
+  }
+  send_midi_cc("OK MIDI CC", &m);
+}
+
+/* MIDI [CH <n> | CC ...] */
+static void handle_midi(const char *arg)
+{
+  if (arg == NULL)
+  {
+    send_midi("MIDI");
+    return;
+  }
+  if (strcmp(arg, "CC") == 0)
+  {
+    handle_midi_cc(tok_next());
+    return;
+  }
+  uint32_t ch;
+  if ((strcmp(arg, "CH") != 0) || !parse_u32(tok_next(), &ch) || (ch > 16u) ||
+      !AppMidi_SetChannel((uint8_t)ch))
+  {
+    send_line("ERR MIDI");
+    return;
+  }
+  send_midi("OK MIDI");
+}
+
+static void send_morph(const char *tag)
+{
+  char buf[96];
+  AppPresetMorphInfo mi;
+  AppPreset_GetMorph(&mi);
+  (void)snprintf(buf, sizeof(buf), "%s a=%u b=%u pos=%ld to=%ld active=%u glide=%u",
+                 tag,
+                 (unsigned)mi.a,
+                 (unsigned)mi.b,
+                 (long)mi.pos_q15,
+                 (long)mi.to_q15,
+                 (unsigned)mi.active,
+                 (unsigned)mi.gliding);
+  send_line(buf);
+}
+
+/* MORPH [<a> <b> <pos> [<ms>]] */
+static void handle_morph(const char *arg)
+{
+  if (arg == NULL)
+  {
+    send_morph("MORPH");
+    return;
+  }
+  uint32_t a;
+  uint32_t b;
+  int32_t pos;
+  uint32_t ms = 0u;
+  const bool ok = parse_u32(arg, &a) && parse_u32(tok_next(), &b) &&
+                  parse_i32(tok_next(), &pos);
+  const char *ms_arg = tok_next();
+  if (!ok || ((ms_arg != NULL) && !parse_u32(ms_arg, &ms)) ||
+      !((ms_arg != NULL) ? AppPreset_MorphGlide(a, b, pos, ms) : AppPreset_Morph(a, b, pos)))
+  {
+    send_line("ERR MORPH");
+    return;
+  }
+  send_morph("OK MORPH");
+}
+
+static const char *const k_sched_prio_names[APP_SCHED_PRIO_COUNT] = {
+  "high", "control", "housekeeping",
+};
+
+/* SCHED [RESET] */
+static void handle_sched(const char *arg)
+{
+  char buf[160];
+  if (arg != NULL)
+  {
+    if (strcmp(arg, "RESET") != 0)
+    {
+      send_line("ERR SCHED");
+      return;
+    }
+    AppSched_Reset();
+    send_line("OK SCHED RESET");
+    return;
+  }
+  AppSchedInfo si;
+  for (uint32_t i = 0; AppSched_Get(i, &si); i++)
+  {
+    (void)snprintf(buf, sizeof(buf),
+                   "SCHED %s prio=%s period=%u runs=%lu avg_us=%lu max_us=%lu budget_us=%u over=%lu late=%lu",
+                   si.name,
+                   k_sched_prio_names[si.prio],
+                   (unsigned)si.period_ms,
+                   (unsigned long)si.runs,
+                   (unsigned long)si.avg_us,
+                   (unsigned long)si.max_us,
+                   (unsigned)si.budget_us,
+                   (unsigned long)si.over,
+                   (unsigned long)si.late);
+    send_line(buf);
+  }
+  (void)snprintf(buf, sizeof(buf), "OK SCHED tasks=%lu", (unsigned long)AppSched_Count());
+  send_line(buf);
+}
+
+static const char *const k_usb_state_names[] = {
+  "off", "default", "addressed", "configured", "suspended",
+};
+
+static const char *const k_uac_source_names[APP_UAC_SOURCE_COUNT] = {
+  "wet", "dry",
+};
+
+static void send_usb(const char *tag)
+{
+  char buf[256];
+  AppUsbInfo ui;
+  AppUacInfo ai;
+  AppCdcInfo ci;
+  AppUsb_Get(&ui);
+  AppUac_Get(&ai);
+  AppCdc_Get(&ci);
+  (void)snprintf(buf, sizeof(buf),
+                 "%s state=%s resets=%lu setups=%lu stalls=%lu stream=%u src=%s fill=%lu/%lu "
+                 "packets=%lu short=%lu long=%lu under=%lu over=%lu "
+                 "com=%u com_rx=%lu com_tx=%lu com_drop=%lu com_hold=%lu",
+                 tag,
+                 k_usb_state_names[ui.state],
+                 (unsigned long)ui.resets,
+                 (unsigned long)ui.setups,
+                 (unsigned long)ui.stalls,
+                 (unsigned)ai.streaming,
+                 k_uac_source_names[ai.source],
+                 (unsigned long)ai.fill,
+                 (unsigned long)ai.target,
+                 (unsigned long)ai.packets,
+                 (unsigned long)ai.short_packets,
+                 (unsigned long)ai.long_packets,
+                 (unsigned long)ai.underruns,
+                 (unsigned long)ai.overflows,
+                 (unsigned)ci.open,
+                 (unsigned long)ci.rx_bytes,
+                 (unsigned long)ci.tx_bytes,
+                 (unsigned long)ci.tx_drops,
+                 (unsigned long)ci.rx_stalls);
+  send_line(buf);
+}
+
+/* USB [SRC <wet|dry>] */
+static void handle_ble(void)
+{
+  char buf[96];
+  AppBleInfo bi;
+  AppBle_Get(&bi);
+  (void)snprintf(buf, sizeof(buf), "BLE open=%u baud=%lu rx=%lu tx=%lu lost=%lu err=%lu",
+                 (unsigned)bi.open,
+                 (unsigned long)(APP_BLE_ENABLE ? APP_BLE_BAUD : 0u),
+                 (unsigned long)bi.rx_bytes,
+                 (unsigned long)bi.tx_bytes,
+                 (unsigned long)bi.rx_lost,
+                 (unsigned long)bi.errors);
+  send_line(buf);
+}
+
+static void handle_usb(const char *arg)
+{
+  if (arg == NULL)
+  {
+    send_usb("USB");
+    return;
+  }
+  const char *name = tok_next();
+  uint32_t src = APP_UAC_SOURCE_COUNT;
+  for (uint32_t i = 0; (name != NULL) && (i < APP_UAC_SOURCE_COUNT); i++)
+  {
+    if (strcmp(name, k_uac_source_names[i]) == 0)
+    {
+      src = i;
+    }
+  }
+  if ((strcmp(arg, "SRC") != 0) || !AppUac_SetSource((AppUacSource)src))
+  {
+    send_line("ERR USB");
+    return;
+  }
+  send_usb("OK USB");
+}
+
+static const char *const k_fsw_action_names[APP_SWITCH_ACTION_COUNT] = {
+  "none", "next", "prev", "bypass", "tap", "freeze",
+};
+
+/* LINK: every link, whether or not open. */
+static void handle_link(void)
+{
+  for (uint32_t i = 0; i < COM_LINK_COUNT; i++)
+  {
+    char line[96];
+    const uint8_t open = (k_links[i].is_open == NULL) ? 1u : s_link_open[i];
+    (void)snprintf(line, sizeof(line), "LINK %s open=%u rx=%lu tx=%lu drop=%lu", k_links[i].name,
+                   (unsigned)open, (unsigned long)s_link_rx[i], (unsigned long)s_link_tx[i],
+                   (unsigned long)s_link_drop[i]);
+    send_line_wait(line);
+  }
+  char line[48];
+  (void)snprintf(line, sizeof(line), "OK LINK this=%s count=%u", k_links[s_link].name, (unsigned)COM_LINK_COUNT);
+  send_line_wait(line);
+}
+
+/* The host may send up to byte <limit> counted from the CREDIT ON line:
+ * what the parser took plus the window.
+ */
+static uint32_t credit_limit(ComLink l)
+{
+  return (s_link_rx[l] - s_credit_base[l]) + k_links[l].rx_window;
+}
+
+/* Input lost under the count (RX restart, BAUD): the host has to start
+ * over with CREDIT ON.
+ */
+static void credit_stop(ComLink l)
+{
+  if (!s_credit_on[l])
+  {
+    return;
+  }
+  s_credit_on[l] = 0;
+  const ComLink prev = s_link;
+  s_link = l;
+  send_line("CREDIT off");
+  s_link = prev;
+}
+
+static void send_credit(const char *tag)
+{
+  out_begin(tag);
+  out_str(s_credit_on[s_link] ? " on win=" : " off win=");
+  out_u32(k_links[s_link].rx_window);
+  out_str(" cr=");
+  out_u32(s_credit_on[s_link] ? credit_limit(s_link) : 0u);
+  out_line();
+}
+
+/* CREDIT [ON|OFF], for the asking link. */
+static void handle_credit(const char *arg)
+{
+  if (arg == NULL)
+  {
+    send_credit("CREDIT");
+    return;
+  }
+  if ((k_links[s_link].rx_window == 0u) || ((strcmp(arg, "ON") != 0) && (strcmp(arg, "OFF") != 0)))
+  {
+    send_line("ERR CREDIT");
+    return;
+  }
+  s_credit_on[s_link] = (arg[1] == 'N') ? 1u : 0u;
+  /* Counted from the byte after this line's newline. */
+  s_credit_base[s_link] = s_link_rx[s_link];
+  s_credit_sent[s_link] = credit_limit(s_link);
+  send_credit("OK CREDIT");
+}
+
+typedef struct
+{
+  const char *name;
+  uint32_t max_hz;           /* 0: not in this build */
+} ComTopicInfo;
+
+static const ComTopicInfo k_topics[COM_TOPIC_COUNT] =
+{
+  {"meter", APP_COM_METER_HZ_MAX},
+  {"load", 10u},
+  {"clock", 10u},
+  {"tuner", APP_TUNER_ENABLE ? 20u : 0u},
+  {"spectrum", APP_SPECTRUM_ENABLE ? 20u : 0u},
+};
+
+/* Subscribes the asking link (0 Hz: unsubscribes); 0 past the topic's
+ * max.
+ */
+static bool sub_set(ComTopic t, uint32_t hz)
+{
+  if (hz > k_topics[t].max_hz)
+  {
+    return false;
+  }
+  s_sub_hz[t] = hz;
+  s_sub_t0[t] = HAL_GetTick();
+  s_sub_link[t] = s_link;
+  if (t == COM_TOPIC_METER)
+  {
+    AppMeter_Enable(hz != 0u); /* also starts a fresh window */
+  }
+  else if (t == COM_TOPIC_TUNER)
+  {
+    s_sub_tuner_seq = 0;
+  }
+  else if (t == COM_TOPIC_SPECTRUM)
+  {
+    AppSpectrum_Enable(hz != 0u);
+  }
+  return true;
+}
+
+static bool sub_find(const char *name, ComTopic *out)
+{
+  for (uint32_t t = 0; t < COM_TOPIC_COUNT; t++)
+  {
+    if (strcmp(name, k_topics[t].name) == 0)
+    {
+      *out = (ComTopic)t;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* SUB [<topic> <hz>] */
+static void handle_sub(const char *name, const char *rate)
+{
+  if (name == NULL)
+  {
+    for (uint32_t t = 0; t < COM_TOPIC_COUNT; t++)
+    {
+      out_begin("SUB ");
+      out_str(k_topics[t].name);
+      out_str(" hz=");
+      out_u32(s_sub_hz[t]);
+      out_str(" max=");
+      out_u32(k_topics[t].max_hz);
+      out_str(" link=");
+      out_str(k_links[s_sub_link[t]].name);
+      out_line_wait();
+    }
+    out_begin("OK SUB count=");
+    out_u32(COM_TOPIC_COUNT);
+    out_line();
+    return;
+  }
+  ComTopic t;
+  uint32_t hz = 0;
+  if (!sub_find(name, &t) || !parse_u32(rate, &hz) || !sub_set(t, hz))
+  {
+    send_line("ERR SUB");
+    return;
+  }
+  out_begin("OK SUB ");
+  out_str(k_topics[t].name);
+  out_str(" ");
+  out_u32(hz);
+  out_line();
+}
+
+/* UNSUB <topic>|ALL */
+static void handle_unsub(const char *name)
+{
+  ComTopic t;
+  if ((name != NULL) && (strcmp(name, "ALL") == 0))
+  {
+    for (uint32_t i = 0; i < COM_TOPIC_COUNT; i++)
+    {
+      (void)sub_set((ComTopic)i, 0u);
+    }
+  }
+  else if ((name == NULL) || !sub_find(name, &t))
+  {
+    send_line("ERR UNSUB");
+    return;
+  }
+  else
+  {
+    (void)sub_set(t, 0u);
+  }
+  out_begin("OK UNSUB ");
+  out_str(name);
+  out_line();
+}
+
+static uint32_t fnv1a(uint32_t h, const void *p, uint32_t n)
+{
+  const uint8_t *b = (const uint8_t *)p;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    h = (h ^ b[i]) * 16777619u;
+  }
+  return h;
+}
+
+static uint32_t fnv1a_str(uint32_t h, const char *str)
+{
+  return fnv1a(h, str, (uint32_t)strlen(str) + 1u);
+}
+
+/* Changes with any param's name, unit, limits, default or clamp, and with
+ * the stage list; not with the order in which values are stored.
+ */
+static uint32_t caps_hash(void)
+{
+  uint32_t h = 2166136261u;
+  for (uint32_t i = 0; i < (uint32_t)APP_DSP_PARAM_COUNT; i++)
+  {
+    AppDspParamDesc d;
+    if (!AppDsp_GetParamDesc((AppDspParamId)i, &d))
+    {
+      continue;
+    }
+    const int32_t v[3] = {d.min, d.max, d.def};
+    h = fnv1a_str(h, d.name);
+    h = fnv1a_str(h, d.unit);
+    h = fnv1a(h, v, sizeof(v));
+    h = fnv1a(h, &d.clamp, 1u);
+  }
+  for (uint32_t i = 0; i < (uint32_t)APP_PROF_STAGE_COUNT; i++)
+  {
+    h = fnv1a_str(h, AppProf_StageName((AppProfStage)i));
+  }
+  return h;
+}
+
+static void handle_caps(void)
+{
+  out_begin("CAPS fw=");
+  out_str(APP_FW_VERSION);
+  out_str(" proto=");
+  out_u32(COM_PROTO_VERSION);
+  out_str(" feat=tag,bin,credit,evt,psetm,sub,quiet,pingts,lat");
+#if APP_CDC_ENABLE
+  out_str(",usb");
+#endif
+#if APP_UAC_ENABLE
+  out_str(",uac");
+#endif
+#if APP_MIDI_ENABLE
+  out_str(",midi");
+#endif
+#if APP_TELEM_RTT
+  out_str(",rtt");
+#endif
+#if APP_BLE_ENABLE
+  out_str(",ble");
+#endif
+#if APP_EXPR_ENABLE
+  out_str(",exp");
+#endif
+#if APP_PRESET_MORPH_ENABLE
+  out_str(",morph");
+#endif
+#if APP_DSP_PITCH_ENABLE
+  out_str(",pitch");
+#endif
+#if APP_DSP_CHORUS_ENABLE
+  out_str(",chorus");
+#endif
+#if APP_DSP_SPRING_ENABLE
+  out_str(",spring");
+#endif
+#if APP_DSP_SPILL_MS > 0
+  out_str(",spill");
+#endif
+#if APP_DSP_BUS_FRAMES > 0
+  out_str(",bus");
+#endif
+#if APP_DSP_CAB_SECTIONS_MAX > 0
+  out_str(",ucab");
+#endif
+#if APP_CAPTURE_ENABLE
+  out_str(",cap");
+#endif
+#if APP_TRACE_ENABLE
+  out_str(",trace");
+#endif
+#if APP_CABIR_ENABLE
+  out_str(",cabir");
+#endif
+#if APP_TUNER_ENABLE
+  out_str(",tuner");
+#endif
+#if APP_SELFTEST_ENABLE
+  out_str(",stest");
+#endif
+#if APP_SPECTRUM_ENABLE
+  out_str(",spectrum");
+#endif
+  if (AppUpdate_Check(1u))
+  {
+    out_str(",update");
+  }
+  out_str(" baud=");
+  out_u32(k_com_baud_rates[(sizeof(k_com_baud_rates) / sizeof(k_com_baud_rates[0])) - 1u]);
+  out_str(" rate=");
+  out_u32(APP_DSP_SAMPLE_RATE_HZ);
+  out_str(" block=");
+  out_u32(AppAudio_GetFramesPerHalf());
+  out_str(" line=");
+  out_u32(APP_COM_LINE_MAX - 1u);
+  out_str(" bin=");
+  out_u32(APP_COM_BIN_MAX);
+  out_str(" rx=");
+  out_u32(k_links[s_link].rx_window);
+  out_str(" tx=");
+  out_u32(k_links[s_link].tx_free());
+  out_str(" params=");
+  out_u32(APP_DSP_PARAM_COUNT);
+  out_str(" hash=");
+  out_u32(caps_hash());
+  out_line();
+}
+
+/* FSW [<i> <action>] */
+static void handle_fsw(const char *idx, const char *name)
+{
+  char buf[64];
+  if (idx == NULL)
+  {
+    for (uint32_t i = 0; i < APP_SWITCH_COUNT; i++)
+    {
+      (void)snprintf(buf, sizeof(buf), "FSW %lu %s presses=%lu closed=%u",
+                     (unsigned long)i,
+                     k_fsw_action_names[AppSwitch_GetAction(i)],
+                     (unsigned long)AppSwitch_Presses(i),
+                     (unsigned)AppSwitch_Pressed(i));
+      send_line(buf);
+    }
+    (void)snprintf(buf, sizeof(buf), "OK FSW count=%lu", (unsigned long)APP_SWITCH_COUNT);
+    send_line(buf);
+    return;
+  }
+
+  uint32_t action = 0;
+  while ((name != NULL) && (action < (uint32_t)APP_SWITCH_ACTION_COUNT) &&
+         (strcmp(name, k_fsw_action_names[action]) != 0))
+  {
+    action++;
+  }
+  const uint32_t sw = (uint32_t)strtoul(idx, NULL, 10);
+  if ((name == NULL) || !AppSwitch_SetAction(sw, (AppSwitchAction)action))
+  {
+    send_line("ERR FSW");
+    return;
+  }
+  (void)snprintf(buf, sizeof(buf), "OK FSW %lu %s", (unsigned long)sw, name);
+  send_line(buf);
+}
+
+static bool baud_supported(uint32_t rate)
+{
+  for (uint32_t i = 0; i < (sizeof(k_com_baud_rates) / sizeof(k_com_baud_rates[0])); i++)
+  {
+    if (k_com_baud_rates[i] == rate)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Whatever arrived around a BAUD switch is garbage. */
+static void baud_apply(uint32_t rate)
+{
+  AppSerial_SetBaud(rate);
+  k_rx[COM_LINK_UART]->line_len = 0;
+  k_rx[COM_LINK_UART]->bin_active = 0;
+  credit_stop(COM_LINK_UART);
+}
+
+/* Switches once the OK BAUD reply has fully left the shift register, and
+ * reverts if the host never confirms at the new rate.
+ */
+static void baud_poll(void)
+{
+  if (s_baud_pending != 0u)
+  {
+    if (!AppSerial_TxDone())
+    {
+      return;
+    }
+    s_baud_prev = AppSerial_Baud();
+    baud_apply(s_baud_pending);
+    s_baud_pending = 0;
+    s_baud_trial = 1;
+    s_baud_t0 = HAL_GetTick();
+    return;
+  }
+
+  if (s_baud_trial && ((HAL_GetTick() - s_baud_t0) > APP_COM_BAUD_CONFIRM_MS))
+  {
+    s_baud_trial = 0;
+    baud_apply(s_baud_prev);
+  }
+}
+
+/* With QUIET on, a command that worked owes no line of its own: it is
+ * counted for the next QACK. Returns false when it has to reply.
+ */
+static bool quiet_ack(void)
+{
+  if (!s_quiet[s_link])
+  {
+    return false;
+  }
+  if (s_reply_tag[0] == '#')
+  {
+    s_quiet_seq[s_link] = (uint32_t)strtoul(&s_reply_tag[1], NULL, 10);
+  }
+  if (s_quiet_n[s_link] == 0u)
+  {
+    s_quiet_t0[s_link] = HAL_GetTick();
+  }
+  s_quiet_n[s_link]++;
+  return true;
+}
+
+/* QUIET [ON|OFF], for the asking link. Acks owed still go out after OFF. */
+static void handle_quiet(const char *arg)
+{
+  if ((arg != NULL) && (strcmp(arg, "ON") != 0) && (strcmp(arg, "OFF") != 0))
+  {
+    send_line("ERR QUIET");
+    return;
+  }
+  if (arg != NULL)
+  {
+    s_quiet[s_link] = (arg[1] == 'N') ? 1u : 0u;
+  }
+  out_begin((arg != NULL) ? "OK QUIET " : "QUIET ");
+  out_str(s_quiet[s_link] ? "on" : "off");
+  out_line();
+}
+
+/* After a probed command's commit: the probe follows it from here. */
+static void lat_arm(const AppDspParamId *ids, uint32_t count)
+{
+  if (!s_lat_line)
+  {
+    return;
+  }
+  s_lat.host_t = s_lat_t;
+  s_lat.rx_cyc = k_rx[s_link]->hold_cyc;
+  s_lat.rd_cyc = s_lat_rd;
+  s_lat.ap_cyc = DWT->CYCCNT;
+  s_lat.pver = AppDsp_ParamsVersion();
+  s_lat.t0 = HAL_GetTick();
+  s_lat.link = (uint8_t)s_link;
+  s_lat.ramp_ms = 0;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    AppDspParamDesc d;
+    if (AppDsp_GetParamDesc(ids[i], &d) && (d.smooth_ms > s_lat.ramp_ms))
+    {
+      s_lat.ramp_ms = d.smooth_ms;
+    }
+  }
+  s_lat.wait = 1u;
+  AppDsp_WatchParams(s_lat.pver);
+}
+
+/* The LAT line of the probed command once a block ran on its set; it
+ * waits for room rather than being dropped, up to COM_LAT_TIMEOUT_MS.
+ */
+static void lat_poll(void)
+{
+  if (!s_lat.wait)
+  {
+    return;
+  }
+  if ((HAL_GetTick() - s_lat.t0) > COM_LAT_TIMEOUT_MS)
+  {
+    s_lat.wait = 0;
+    AppDsp_WatchParams(0u);
+    return;
+  }
+  uint32_t blk;
+  if (!AppDsp_WatchedBlock(&blk))
+  {
+    return;
+  }
+  s_link = (ComLink)s_lat.link;
+  const uint32_t per_us = SystemCoreClock / 1000000u;
+  out_begin("LAT ");
+  out_u32(s_lat.host_t);
+  out_str(" rd=");
+  out_u32((s_lat.rd_cyc - s_lat.rx_cyc) / per_us);
+  out_str(" ap=");
+  out_u32((s_lat.ap_cyc - s_lat.rx_cyc) / per_us);
+  out_str(" blk=");
+  out_u32((blk - s_lat.rx_cyc) / per_us);
+  out_str(" tx=");
+  out_u32((DWT->CYCCNT - s_lat.rx_cyc) / per_us);
+  out_str(" ramp=");
+  out_u32((uint32_t)s_lat.ramp_ms * 1000u);
+  out_str(" P=");
+  out_u32(s_lat.pver);
+  if (tx_ring_free() <= s_out_len)
+  {
+    s_out_len = 0;
+    return;
+  }
+  out_line();
+  s_lat.wait = 0;
+}
+
+/* PSET <param> <value> ... and PSETM <param>=<value> ... share one path.
+ * Every pair is validated first, then all of them are applied as one batch:
+ * either the whole set reaches the DSP in the same block or nothing changes.
+ * Tokens come from tok_next(), where handle_command() left it.
+ */
+static void handle_pset(const char *cmd, bool kv)
+{
+  const char *names[APP_COM_PSET_MAX];
+  AppDspParamId ids[APP_COM_PSET_MAX];
+  int32_t vals[APP_COM_PSET_MAX];
+  uint32_t count = 0;
+  char *pname = tok_next();
+  do
+  {
+    char *pval = NULL;
+    if (!kv)
+    {
+      pval = tok_next();
+    }
+    else if (pname != NULL)
+    {
+      pval = strchr(pname, '=');
+      if (pval != NULL)
+      {
+        *pval++ = 0;
+      }
+    }
+    if ((count == APP_COM_PSET_MAX) || !map_param(pname, &ids[count]) || !parse_i32(pval, &vals[count]) ||
+        !AppDsp_ParamBuilt(ids[count], vals[count]))
+    {
+      out_begin("ERR ");
+      out_str(cmd);
+      out_str(" name=");
+      out_str((pname != NULL) ? pname : "?");
+      out_str(" val=");
+      out_str((pval != NULL) ? pval : "?");
+      out_line();
+      return;
+    }
+    names[count] = pname;
+    count++;
+    pname = tok_next();
+  } while (pname != NULL);
+
+  AppDsp_BeginParams();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    AppDsp_SetParam(ids[i], vals[i]);
+    APP_TRACE(APP_TRACE_PARAM, ((uint32_t)ids[i] << 16) | ((uint32_t)vals[i] & 0xFFFFu));
+  }
+  AppDsp_CommitParams();
+  lat_arm(ids, count);
+  if (quiet_ack())
+  {
+    return;
+  }
+
+  out_begin("OK ");
+  out_str(cmd);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    out_str(" ");
+    out_str(names[i]);
+    out_str(kv ? "=" : " ");
+    out_i32(vals[i]);
+  }
+  out_str(" P=");
+  out_u32(AppDsp_ParamsVersion());
+  out_line();
+}
+
+/* From the set AppDsp_SnapshotParams() pinned. */
+static int32_t sync_value(uint32_t field)
+{
+  if (field == 0u)
+  {
+    return (int32_t)AppDsp_SnapshotFxMask();
+  }
+  if (field <= (uint32_t)APP_DSP_PARAM_COUNT)
+  {
+    return AppDsp_SnapshotParam((AppDspParamId)(field - 1u));
+  }
+  return (int32_t)AppDsp_GetDelayMaxMs();
+}
+
+static void sync_scan(void)
+{
+  const uint32_t ver = s_sync_now + 1u;
+  uint8_t changed = 0;
+  s_sync_pver = AppDsp_SnapshotParams();
+  for (uint32_t f = 0; f < COM_SYNC_FIELDS; f++)
+  {
+    const int32_t v = sync_value(f);
+    if ((s_sync_now == 0u) || (v != s_sync_val[f]))
+    {
+      s_sync_val[f] = v;
+      s_sync_ver[f] = ver;
+      changed = 1u;
+    }
+  }
+  if (changed)
+  {
+    s_sync_now = ver;
+  }
+}
+
+/* Appends " <name>=<value>" of a scanned field; nothing for a param
+ * without a descriptor.
+ */
+static void out_sync_item(uint32_t field)
+{
+  if (field == 0u)
+  {
+    out_str(" FXMASK=");
+    out_u32((uint32_t)s_sync_val[0]);
+    return;
+  }
+  if (field > (uint32_t)APP_DSP_PARAM_COUNT)
+  {
+    out_str(" delay_max_ms=");
+    out_u32((uint32_t)s_sync_val[field]);
+    return;
+  }
+  AppDspParamDesc d;
+  if (!AppDsp_GetParamDesc((AppDspParamId)(field - 1u), &d))
+  {
+    return;
+  }
+  out_str(" ");
+  out_str(d.name);
+  out_str("=");
+  out_i32(s_sync_val[field]);
+}
+
+static void handle_status(const char *arg)
+{
+  uint32_t since = 0;
+  if ((arg != NULL) && !parse_u32(arg, &since))
+  {
+    send_line("ERR STATUS");
+    return;
+  }
+  sync_scan();
+  if (since > s_sync_now)
+  {
+    since = 0;
+  }
+
+  /* The full line outgrows the line buffer, so it goes out in pieces;
+   * only the last one ends the line.
+   */
+  out_begin("STATUS V=");
+  out_u32(s_sync_now);
+  out_str(" P=");
+  out_u32(s_sync_pver);
+  for (uint32_t f = 0; f < COM_SYNC_FIELDS; f++)
+  {
+    if (s_sync_ver[f] <= since)
+    {
+      continue;
+    }
+    if (s_out_len > (COM_OUT_MAX - COM_SYNC_ITEM_MAX))
+    {
+      out_part_wait();
+    }
+    out_sync_item(f);
+  }
+  out_line_wait();
+}
+
+static void handle_evt(const char *arg)
+{
+  char buf[48];
+  if (arg == NULL)
+  {
+    (void)snprintf(buf, sizeof(buf), "EVT %s V=%lu", s_evt_on ? "on" : "off", (unsigned long)s_sync_now);
+    send_line(buf);
+    return;
+  }
+  if ((strcmp(arg, "ON") != 0) && (strcmp(arg, "OFF") != 0))
+  {
+    send_line("ERR EVT");
+    return;
+  }
+  /* Changes up to now are the host's to fetch with STATUS <since>. */
+  sync_scan();
+  s_evt_on = (arg[1] == 'N') ? 1u : 0u;
+  s_evt_link = s_link;
+  s_evt_ver = s_sync_now;
+  (void)snprintf(buf, sizeof(buf), "OK EVT %s V=%lu", s_evt_on ? "on" : "off", (unsigned long)s_sync_now);
+  send_line(buf);
+}
+
+static void handle_command(char *line)
+{
+  if (line[0] == 0)
+  {
+    return;
+  }
+
+  tok_begin(line);
+  char *cmd = tok_next();
+  if (cmd == NULL)
+  {
+    return;
+  }
+
+  if (strcmp(cmd, "PING") == 0)
+  {
+    if (s_link == COM_LINK_UART)
+    {
+      s_baud_trial = 0; /* the host is talking at this rate */
+    }
+    const char *seq_s = tok_next();
+    uint32_t seq = 0;
+    if (seq_s == NULL)
+    {
+      send_line("PONG");
+      return;
+    }
+    if (!parse_u32(seq_s, &seq))
+    {
+      send_line("ERR PING");
+      return;
+    }
+    char buf[64];
+    (void)snprintf(buf, sizeof(buf), "PONG %lu ms=%lu cyc=%lu",
+                   (unsigned long)seq,
+                   (unsigned long)HAL_GetTick(),
+                   (unsigned long)DWT->CYCCNT);
+    send_line(buf);
+    return;
+  }
+
+  if (strcmp(cmd, "STATUS") == 0)
+  {
+    handle_status(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "EVT") == 0)
+  {
+    handle_evt(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "PLIST") == 0)
+  {
+    handle_plist(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "LOAD") == 0)
+  {
+    handle_load();
+    return;
+  }
+
+  if (strcmp(cmd, "CPU") == 0)
+  {
+    handle_cpu(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "DMODEL") == 0)
+  {
+    handle_dmodel();
+    return;
+  }
+
+  if (strcmp(cmd, "AERR") == 0)
+  {
+    handle_aerr();
+    return;
+  }
+
+  if (strcmp(cmd, "EVLOG") == 0)
+  {
+    handle_evlog(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "LATENCY") == 0)
+  {
+    handle_latency(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "ITEST") == 0)
+  {
+    handle_itest(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "LTEST") == 0)
+  {
+    handle_ltest(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "RESAMPLER") == 0)
+  {
+    handle_resampler(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "CLOCK") == 0)
+  {
+    handle_clock(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "JITTER") == 0)
+  {
+    handle_jitter(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "DTAP") == 0)
+  {
+    handle_dtap(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "BENCH") == 0)
+  {
+    handle_bench(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "MEM") == 0)
+  {
+    handle_mem(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "PROF") == 0)
+  {
+    handle_prof(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "CLIP") == 0)
+  {
+    handle_clip(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "FXMASK") == 0)
+  {
+    char *arg = tok_next();
+    uint32_t mask = 0;
+    if (!parse_u32(arg, &mask))
+    {
+      send_line("ERR FXMASK");
+      return;
+    }
+    if ((mask & APP_DSP_FX_BITS_MISSING) != 0u)
+    {
+      send_line("ERR FXMASK DISABLED");
+      return;
+    }
+    AppPower_Boost();
+    AppDsp_SetFxMask(mask);
+    APP_TRACE(APP_TRACE_FXMASK, mask);
+    if (quiet_ack())
+    {
+      return;
+    }
+
+    out_begin("OK FXMASK ");
+    out_u32(mask);
+    out_str(" P=");
+    out_u32(AppDsp_ParamsVersion());
+    out_line();
+    return;
+  }
+
+  if (strcmp(cmd, "BYPASS") == 0)
+  {
+    handle_bypass(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "BOOT") == 0)
+  {
+    handle_boot(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "UPDATE") == 0)
+  {
+    handle_update(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "CHAIN") == 0)
+  {
+    handle_chain(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "METER") == 0)
+  {
+    char *arg = tok_next();
+    uint32_t hz = 0;
+    if (!parse_u32(arg, &hz) || !sub_set(COM_TOPIC_METER, hz))
+    {
+      send_line("ERR METER");
+      return;
+    }
+
+    char buf[32];
+    (void)snprintf(buf, sizeof(buf), "OK METER %lu", (unsigned long)hz);
+    send_line(buf);
+    return;
+  }
+
+  if (strcmp(cmd, "SUB") == 0)
+  {
+    char *topic = tok_next();
+    handle_sub(topic, tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "UNSUB") == 0)
+  {
+    handle_unsub(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "LINK") == 0)
+  {
+    handle_link();
+    return;
+  }
+
+  if (strcmp(cmd, "CREDIT") == 0)
+  {
+    handle_credit(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "QUIET") == 0)
+  {
+    handle_quiet(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "CAPS") == 0)
+  {
+    handle_caps();
+    return;
+  }
+
+  if (strcmp(cmd, "BAUD") == 0)
+  {
+    char *arg = tok_next();
+    char buf[48];
+    if (arg == NULL)
+    {
+      (void)snprintf(buf, sizeof(buf), "BAUD %lu", (unsigned long)AppSerial_Baud());
+      send_line(buf);
+      return;
+    }
+    uint32_t rate = 0;
+    if (!parse_u32(arg, &rate) || !baud_supported(rate))
+    {
+      send_line("ERR BAUD");
+      return;
+    }
+    (void)snprintf(buf, sizeof(buf), "OK BAUD %lu", (unsigned long)rate);
+    send_line(buf);
+    if (rate != AppSerial_Baud())
+    {
+      s_baud_pending = rate;
+    }
+    return;
+  }
+
+  if (strcmp(cmd, "CAP") == 0)
+  {
+    handle_cap(cmd, tok_next(), 0u);
+    return;
+  }
+
+  if (strcmp(cmd, "INJ") == 0)
+  {
+    uint32_t inject = 0;
+    if (!parse_u32(tok_next(), &inject) || (inject == 0u))
+    {
+      send_line("ERR INJ");
+      return;
+    }
+    handle_cap(cmd, tok_next(), inject);
+    return;
+  }
+
+  if (strcmp(cmd, "DUMP") == 0)
+  {
+    handle_dump(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "STEST") == 0)
+  {
+    handle_stest(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "TRACE") == 0)
+  {
+    handle_trace(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "TELEM") == 0)
+  {
+    handle_telem(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "CABIR") == 0)
+  {
+    handle_cabir(tok_next());
+    return;
+  }
+  if (strcmp(cmd, "CABIIR") == 0)
+  {
+    handle_cabiir(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "LOOP") == 0)
+  {
+    handle_loop(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "TUNER") == 0)
+  {
+    handle_tuner(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "TAP") == 0)
+  {
+    char buf[32];
+    (void)snprintf(buf, sizeof(buf), "OK TAP bpm=%lu", (unsigned long)AppDsp_TapTempo(HAL_GetTick()));
+    send_line(buf);
+    return;
+  }
+
+  if (strcmp(cmd, "EXP") == 0)
+  {
+    handle_expr(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "MORPH") == 0)
+  {
+    handle_morph(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "SCHED") == 0)
+  {
+    handle_sched(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "MIDI") == 0)
+  {
+    handle_midi(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "USB") == 0)
+  {
+    handle_usb(tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "BLE") == 0)
+  {
+    handle_ble();
+    return;
+  }
+
+  if (strcmp(cmd, "FSW") == 0)
+  {
+    const char *idx = tok_next();
+    handle_fsw(idx, tok_next());
+    return;
+  }
+
+  if (strcmp(cmd, "PBANK") == 0)
+  {
+    handle_pbank();
+    return;
+  }
+
+  if ((strcmp(cmd, "PSAVE") == 0) || (strcmp(cmd, "PLOAD") == 0))
+  {
+    handle_preset(cmd, tok_next(), cmd[1] == 'S');
+    return;
+  }
+
+  if ((strcmp(cmd, "PSET") == 0) || (strcmp(cmd, "PSETM") == 0))
+  {
+    handle_pset(cmd, cmd[4] == 'M');
+    return;
+  }
+
+  out_begin("ERR UNKNOWN cmd=");
+  out_str(cmd);
+  out_str(" line=");
+  out_str(tok_line());
+  out_line();
+}
+
+/* Strips an optional "#<seq> " tag (see the protocol notes), which then
+ * prefixes every reply line of the command, and an optional "@<t> "
+ * latency probe after it.
+ */
+static void handle_line(char *line)
+{
+  const uint32_t rd = DWT->CYCCNT;
+  line = trim_inplace(line);
+
+  if (line[0] == '#')
+  {
+    size_t n = 1;
+    while ((n <= COM_TAG_DIGITS_MAX) && isdigit((unsigned char)line[n]))
+    {
+      n++;
+    }
+    if ((n > 1u) && ((line[n] == ' ') || (line[n] == '\t')))
+    {
+      memcpy(s_reply_tag, line, n);
+      s_reply_tag[n] = ' ';
+      s_reply_tag[n + 1u] = 0;
+      line += n;
+      while ((*line == ' ') || (*line == '\t'))
+      {
+        line++;
+      }
+    }
+  }
+
+  if ((line[0] == '@') && isdigit((unsigned char)line[1]))
+  {
+    char *end;
+    const uint32_t t = (uint32_t)strtoul(&line[1], &end, 10);
+    if ((*end == ' ') || (*end == '\t'))
+    {
+      s_lat_t = t;
+      s_lat_rd = rd;
+      s_lat_line = 1u;
+      line = end;
+      while ((*line == ' ') || (*line == '\t'))
+      {
+        line++;
+      }
+    }
+  }
+
+  handle_command(line);
+  s_reply_tag[0] = 0;
+  s_lat_line = 0;
+}
+
+/* ------------------------------ Binary frames ----------------------------- */
+
+static uint16_t crc16_ccitt(const uint8_t *p, uint16_t n)
+{
+  uint16_t crc = 0xFFFFu;
+  for (uint16_t i = 0; i < n; i++)
+  {
+    crc ^= (uint16_t)((uint16_t)p[i] << 8);
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static bool bin_get_varint(const uint8_t *p, uint16_t n, uint16_t *pos, int32_t *out)
+{
+  uint32_t v = 0;
+  for (uint32_t shift = 0; shift < 35u; shift += 7u)
+  {
+    if (*pos >= n)
+    {
+      return false;
+    }
+    uint8_t b = p[(*pos)++];
+    v |= (uint32_t)(b & 0x7Fu) << shift;
+    if ((b & 0x80u) == 0u)
+    {
+      *out = (int32_t)((v >> 1) ^ (0u - (v & 1u)));
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint16_t bin_put_varint(uint8_t *p, int32_t value)
+{
+  uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+  uint16_t n = 0;
+  while (v >= 0x80u)
+  {
+    p[n++] = (uint8_t)(v | 0x80u);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+/* Frames 'body' (<cmd> <payload>) with sync, length and CRC into f
+ * (COM_BIN_TX_MAX + 4 bytes). Returns the frame length, 0 if too long.
+ */
+static uint16_t bin_frame(uint8_t *f, const uint8_t *body, uint16_t n)
+{
+  if ((n == 0u) || (n > COM_BIN_TX_MAX))
+  {
+    return 0u;
+  }
+  f[0] = COM_BIN_SYNC;
+  f[1] = (uint8_t)n;
+  memcpy(&f[2], body, n);
+  uint16_t crc = crc16_ccitt(&f[1], (uint16_t)(1u + n));
+  f[2u + n] = (uint8_t)crc;
+  f[3u + n] = (uint8_t)(crc >> 8);
+  return (uint16_t)(4u + n);
+}
+
+/* Frames 'body' and queues it. */
+static void bin_send(const uint8_t *body, uint16_t n)
+{
+  uint8_t f[COM_BIN_TX_MAX + 4u];
+  const uint16_t len = bin_frame(f, body, n);
+  if (len != 0u)
+  {
+    tx_enqueue_bytes(f, len);
+  }
+}
+
+/* Stream frames (METER, DUMP, TRACE): to the probe while COM TELEM has a
+ * transport selected (app_telem.h), else queued once the TX ring still
+ * keeps 'reserve' bytes for replies. Returns 0 if the frame has to wait.
+ */
+static uint8_t bin_stream(AppTelemChannel ch, const uint8_t *body, uint16_t n, uint16_t reserve)
+{
+  if (AppTelem_Transport() == APP_TELEM_UART)
+  {
+    if (tx_ring_free() < (uint16_t)(4u + n + reserve))
+    {
+      return 0u;
+    }
+    bin_send(body, n);
+    return 1u;
+  }
+  uint8_t f[COM_BIN_TX_MAX + 4u];
+  const uint16_t len = bin_frame(f, body, n);
+  return (len == 0u) ? 1u : AppTelem_Write(ch, f, len);
+}
+
+static void bin_reply(uint8_t cmd, uint8_t status, const uint8_t *data, uint16_t n)
+{
+  uint8_t body[COM_BIN_TX_MAX];
+  if (n > (sizeof(body) - 2u))
+  {
+    return;
+  }
+  body[0] = (uint8_t)(cmd | COM_BIN_REPLY);
+  body[1] = status;
+  if (n > 0u)
+  {
+    memcpy(&body[2], data, n);
+  }
+  bin_send(body, (uint16_t)(2u + n));
+}
+
+static void put_u16(uint8_t *p, uint32_t v)
+{
+  if (v > 0xFFFFu)
+  {
+    v = 0xFFFFu;
+  }
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+/* Unsolicited METER frame, see the header comment. */
+static void pub_meter(void)
+{
+  AppMeterLevels m;
+  if (!AppMeter_Take(&m))
+  {
+    return;
+  }
+  uint8_t body[1u + (4u * APP_METER_TAP_COUNT) + 4u];
+  uint16_t pos = 0;
+  body[pos++] = COM_BIN_METER;
+  for (uint32_t t = 0; t < APP_METER_TAP_COUNT; t++)
+  {
+    put_u16(&body[pos], m.peak[t] >> 7);
+    put_u16(&body[pos + 2u], m.rms[t] >> 7);
+    pos = (uint16_t)(pos + 4u);
+  }
+  put_u16(&body[pos], (uint32_t)m.comp_gain_q15);
+  put_u16(&body[pos + 2u], (uint32_t)m.limiter_gain_q15);
+  pos = (uint16_t)(pos + 4u);
+  (void)bin_stream(APP_TELEM_CH_METER, body, pos, 0u);
+}
+
+/* Unsolicited SPECTRUM frame, see the header comment. The FFT runs here,
+ * at the topic's rate, never in the audio interrupt.
+ */
+static void pub_spectrum(void)
+{
+  AppSpectrumFrame f;
+  if (!AppSpectrum_Take(&f))
+  {
+    return;
+  }
+  uint8_t body[4u + (2u * APP_SPECTRUM_BANDS)];
+  uint16_t pos = 0;
+  body[pos++] = COM_BIN_SPECTRUM;
+  put_u16(&body[pos], f.bin_chz);
+  pos = (uint16_t)(pos + 2u);
+  body[pos++] = (uint8_t)APP_SPECTRUM_BANDS;
+  for (uint32_t b = 0; b < APP_SPECTRUM_BANDS; b++)
+  {
+    body[pos++] = f.top[b];
+    body[pos++] = f.level[b];
+  }
+  (void)bin_stream(APP_TELEM_CH_METER, body, pos, 0u);
+}
+
+/* x10 fixed value as "-12.3". */
+static void out_x10(int32_t v)
+{
+  const uint32_t a = (v < 0) ? ((uint32_t)0u - (uint32_t)v) : (uint32_t)v;
+  if (v < 0)
+  {
+    out_str("-");
+  }
+  out_u32(a / 10u);
+  out_str(".");
+  out_u32(a % 10u);
+}
+
+/* A PUB line only goes out whole, a sample is not worth a reply. */
+static void pub_line(void)
+{
+  if (tx_ring_free() > s_out_len)
+  {
+    out_line();
+  }
+  s_out_len = 0;
+}
+
+static void pub_load(void)
+{
+  AppAudioStats st;
+  AppDspShedInfo sh;
+  AppAudio_GetStats(&st);
+  AppDsp_GetShed(&sh);
+  out_begin("PUB load rx=");
+  out_x10((int32_t)load_permille(st.rx_avg_cycles, st.period_cycles));
+  out_str(" rx_max=");
+  out_x10((int32_t)load_permille(st.rx_max_cycles, st.period_cycles));
+  out_str(" tx=");
+  out_x10((int32_t)load_permille(st.tx_avg_cycles, st.period_cycles));
+  out_str(" miss=");
+  out_u32(st.deadline_miss);
+  out_str(" under=");
+  out_u32(st.ring_underrun);
+  out_str(" tier=");
+  out_u32(sh.tier);
+  out_str(" preset=");
+  out_u32(AppPreset_Current());
+  out_str(" P=");
+  out_u32(s_sync_pver);
+  pub_line();
+}
+
+static void pub_clock(void)
+{
+  AppAudioClockStats st;
+  AppAudio_GetClock(&st);
+  out_begin("PUB clock ppm=");
+  out_x10(st.sync_clock ? 0 : st.ppm_x10);
+  out_str(" est=");
+  out_x10(st.sync_clock ? 0 : st.est_ppm_x10);
+  out_str(" locked=");
+  out_u32(st.sync_clock ? 1u : st.locked);
+  pub_line();
+}
+
+static void pub_tuner(void)
+{
+#if APP_TUNER_ENABLE
+  AppTunerReading r;
+  AppTuner_Get(&r);
+  if (r.seq == s_sub_tuner_seq)
+  {
+    return;
+  }
+  out_begin("PUB tuner ");
+  out_str(k_tuner_mode_names[r.mode]);
+  out_str(" note=");
+  if (r.note >= 0)
+  {
+    out_str(k_note_names[r.note % 12]);
+    out_i32((r.note / 12) - 1);
+  }
+  else
+  {
+    out_str("-");
+  }
+  out_str(" cents=");
+  out_i32(r.cents);
+  out_str(" freq=");
+  out_u32(r.freq_mhz / 1000u);
+  out_str(".");
+  out_u32((r.freq_mhz / 100u) % 10u);
+  out_u32((r.freq_mhz / 10u) % 10u);
+  out_u32(r.freq_mhz % 10u);
+  if (tx_ring_free() > s_out_len)
+  {
+    s_sub_tuner_seq = r.seq;
+  }
+  pub_line();
+#endif
+}
+
+/* Scans the STATUS fields every APP_COM_EVT_MS and, while EVT is on,
+ * pushes the ones changed since the last push. A preset load can take
+ * several lines; if the TX ring is short the rest waits for the next
+ * period and the lines already out are sent again then (values are
+ * absolute, repeats are harmless).
+ */
+static void evt_poll(void)
+{
+  const uint32_t now = HAL_GetTick();
+  if ((now - s_sync_t0) < APP_COM_EVT_MS)
+  {
+    return;
+  }
+  s_sync_t0 = now;
+  sync_scan();
+  if (!s_evt_on || (s_evt_ver == s_sync_now))
+  {
+    return;
+  }
+
+  /* Untagged, whole lines: one more EVT V=<ver> line per full buffer. */
+  out_begin("EVT V=");
+  out_u32(s_sync_now);
+  out_str(" P=");
+  out_u32(s_sync_pver);
+  const uint16_t head = s_out_len;
+  for (uint32_t f = 0; f <= COM_SYNC_FIELDS; f++)
+  {
+    if ((f < COM_SYNC_FIELDS) && (s_sync_ver[f] <= s_evt_ver))
+    {
+      continue;
+    }
+    if ((f == COM_SYNC_FIELDS) || (s_out_len > (COM_OUT_MAX - COM_SYNC_ITEM_MAX)))
     {
-      s_line[s_line_len] = 0;
-      handle_line(s_line);
-      s_line_len = 0;
-      continue;
+      if (s_out_len == head)
+      {
+        break;
+      }
+      if (tx_ring_free() < (s_out_len + 1u))
+      {
+        return;
+      }
+      out_line();
+      out_begin("EVT V=");
+      out_u32(s_sync_now);
+      out_str(" P=");
+      out_u32(s_sync_pver);
+    }
+    if (f < COM_SYNC_FIELDS)
+    {
+      out_sync_item(f);
+    }
+  }
+  s_evt_ver = s_sync_now;
+}
+
+/* Streams the queued DUMP range, one frame per call while the TX ring
+ * keeps room for other replies.
+ */
+static void dump_poll(void)
+{
+  if (s_dump_pos >= s_dump_end)
+  {
+    return;
+  }
+  const int16_t *d = AppCapture_Data();
+  uint8_t body[COM_BIN_TX_MAX];
+  const uint32_t max = (COM_BIN_TX_MAX - 3u) / 2u;
+  uint32_t k = s_dump_end - s_dump_pos;
+  if (k > max)
+  {
+    k = max;
+  }
+  if (d == NULL)
+  {
+    return;
+  }
+  body[0] = COM_BIN_DUMP;
+  put_u16(&body[1], s_dump_pos);
+  for (uint32_t i = 0; i < k; i++)
+  {
+    put_u16(&body[3u + (2u * i)], (uint16_t)d[s_dump_pos + i]);
+  }
+  if (!bin_stream(APP_TELEM_CH_DUMP, body, (uint16_t)(3u + (2u * k)), 64u))
+  {
+    return;
+  }
+  s_dump_pos += k;
+
+  if (s_dump_pos >= s_dump_end)
+  {
+    char buf[32];
+    (void)snprintf(buf, sizeof(buf), "DUMP END %lu", (unsigned long)s_dump_end);
+    send_line(buf);
+  }
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+/* Streams the queued TRACE DUMP range like dump_poll(). */
+static void trace_poll(void)
+{
+  if (s_trace_pos >= s_trace_end)
+  {
+    return;
+  }
+  AppTraceEvent ev[(COM_BIN_TX_MAX - 3u) / 8u];
+  const uint32_t max = (uint32_t)(sizeof(ev) / sizeof(ev[0]));
+  uint32_t k = s_trace_end - s_trace_pos;
+  if (k > max)
+  {
+    k = max;
+  }
+  k = AppTrace_Read(s_trace_pos, ev, k);
+  if (k == 0u)
+  {
+    /* Re-armed meanwhile: the held events are gone. */
+    s_trace_end = 0;
+    send_line("TRACE END 0");
+    return;
+  }
+  uint8_t body[COM_BIN_TX_MAX];
+  body[0] = COM_BIN_TRACE;
+  put_u16(&body[1], s_trace_pos);
+  for (uint32_t i = 0; i < k; i++)
+  {
+    put_u32(&body[3u + (8u * i)], ev[i].cyc);
+    put_u32(&body[7u + (8u * i)], ev[i].word);
+  }
+  if (!bin_stream(APP_TELEM_CH_DUMP, body, (uint16_t)(3u + (8u * k)), 64u))
+  {
+    return;
+  }
+  s_trace_pos += k;
+
+  if (s_trace_pos >= s_trace_end)
+  {
+    char buf[32];
+    (void)snprintf(buf, sizeof(buf), "TRACE END %lu", (unsigned long)s_trace_end);
+    send_line(buf);
+  }
+}
+
+/* <offset u16> <s16> ... for CAPW and CABW. */
+static uint8_t bin_samples(const uint8_t *p, uint16_t n, uint8_t (*write)(uint32_t, const int16_t *, uint32_t))
+{
+  int16_t s[(APP_COM_BIN_MAX - 3u) / 2u];
+  if ((n < 4u) || ((n & 1u) != 0u) || (((n - 2u) / 2u) > (sizeof(s) / sizeof(s[0]))))
+  {
+    return COM_BIN_ST_PAYLOAD;
+  }
+  const uint16_t k = (uint16_t)((n - 2u) / 2u);
+  const uint32_t offset = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+  for (uint16_t i = 0; i < k; i++)
+  {
+    s[i] = (int16_t)((uint16_t)p[2u + (2u * i)] | (uint16_t)((uint16_t)p[3u + (2u * i)] << 8));
+  }
+  return write(offset, s, k) ? COM_BIN_ST_OK : COM_BIN_ST_FAILED;
+}
+
+static uint8_t bin_pset(const uint8_t *p, uint16_t n)
+{
+  /* Validate the whole frame before touching the DSP, like PSET lines. */
+  uint16_t pos = 0;
+  uint32_t count = 0;
+  while (pos < n)
+  {
+    int32_t v;
+    const uint8_t id = p[pos++];
+    if ((id >= (uint8_t)APP_DSP_PARAM_COUNT) || !bin_get_varint(p, n, &pos, &v))
+    {
+      return COM_BIN_ST_PAYLOAD;
+    }
+    if (!AppDsp_ParamBuilt((AppDspParamId)id, v))
+    {
+      return COM_BIN_ST_FAILED;
+    }
+    count++;
+  }
+  if (count == 0u)
+  {
+    return COM_BIN_ST_PAYLOAD;
+  }
+
+  AppDsp_BeginParams();
+  pos = 0;
+  while (pos < n)
+  {
+    AppDspParamId id = (AppDspParamId)p[pos++];
+    int32_t v = 0;
+    (void)bin_get_varint(p, n, &pos, &v);
+    AppDsp_SetParam(id, v);
+    APP_TRACE(APP_TRACE_PARAM, ((uint32_t)id << 16) | ((uint32_t)v & 0xFFFFu));
+  }
+  AppDsp_CommitParams();
+  return COM_BIN_ST_OK;
+}
+
+/* An ok reply with the parameter-set version the command landed in. */
+static void bin_reply_pver(uint8_t cmd, uint8_t status)
+{
+  uint8_t v[5];
+  const uint16_t vn = bin_put_varint(v, (int32_t)AppDsp_ParamsVersion());
+  bin_reply(cmd, status, v, vn);
+}
+
+static void handle_frame(const uint8_t *f)
+{
+  const uint8_t len = f[0];
+  const uint8_t cmd = f[1];
+  const uint8_t *p = &f[2];
+  const uint16_t n = (uint16_t)(len - 1u);
+
+  uint16_t crc = (uint16_t)f[1u + len] | (uint16_t)((uint16_t)f[2u + len] << 8);
+  if (crc != crc16_ccitt(f, (uint16_t)(1u + len)))
+  {
+    bin_reply(cmd, COM_BIN_ST_CRC, NULL, 0);
+    return;
+  }
+  if (s_link == COM_LINK_UART)
+  {
+    s_baud_trial = 0; /* a good frame confirms the rate just as PING does */
+  }
+
+  switch (cmd)
+  {
+    case COM_BIN_PING:
+      if (n == 4u)
+      {
+        uint8_t ts[12];
+        memcpy(ts, p, 4u);
+        put_u32(&ts[4], HAL_GetTick());
+        put_u32(&ts[8], DWT->CYCCNT);
+        bin_reply(cmd, COM_BIN_ST_OK, ts, sizeof(ts));
+      }
+      else
+      {
+        bin_reply(cmd, (n == 0u) ? COM_BIN_ST_OK : COM_BIN_ST_PAYLOAD, NULL, 0);
+      }
+      break;
+    case COM_BIN_PSET:
+    {
+      const uint8_t st = bin_pset(p, n);
+      if (st != COM_BIN_ST_OK)
+      {
+        bin_reply(cmd, st, NULL, 0);
+      }
+      else if (!quiet_ack())
+      {
+        bin_reply_pver(cmd, st);
+      }
+      break;
+    }
+    case COM_BIN_PGET:
+    {
+      if ((n != 1u) || (p[0] >= (uint8_t)APP_DSP_PARAM_COUNT))
+      {
+        bin_reply(cmd, COM_BIN_ST_PAYLOAD, NULL, 0);
+        break;
+      }
+      uint8_t v[5];
+      uint16_t vn = bin_put_varint(v, AppDsp_GetParam((AppDspParamId)p[0]));
+      bin_reply(cmd, COM_BIN_ST_OK, v, vn);
+      break;
+    }
+    case COM_BIN_FXMASK:
+      if (n != 1u)
+      {
+        bin_reply(cmd, COM_BIN_ST_PAYLOAD, NULL, 0);
+        break;
+      }
+      if ((p[0] & APP_DSP_FX_BITS_MISSING) != 0u)
+      {
+        bin_reply(cmd, COM_BIN_ST_FAILED, NULL, 0);
+        break;
+      }
+      AppPower_Boost();
+      AppDsp_SetFxMask(p[0]);
+      APP_TRACE(APP_TRACE_FXMASK, p[0]);
+      if (!quiet_ack())
+      {
+        bin_reply_pver(cmd, COM_BIN_ST_OK);
+      }
+      break;
+    case COM_BIN_PLOAD:
+    case COM_BIN_PSAVE:
+    {
+      if (n != 1u)
+      {
+        bin_reply(cmd, COM_BIN_ST_PAYLOAD, NULL, 0);
+        break;
+      }
+      uint8_t ok = (cmd == COM_BIN_PSAVE) ? AppPreset_Save(p[0]) : AppPreset_Load(p[0]);
+      bin_reply(cmd, ok ? COM_BIN_ST_OK : COM_BIN_ST_FAILED, NULL, 0);
+      break;
+    }
+    case COM_BIN_CAPW:
+      bin_reply(cmd, bin_samples(p, n, AppCapture_Write), NULL, 0);
+      break;
+    case COM_BIN_CABW:
+      bin_reply(cmd, bin_samples(p, n, AppCabIr_Write), NULL, 0);
+      break;
+    case COM_BIN_PREAD:
+    {
+      /* The reply names its chunk, so a host can keep several in flight. */
+      uint8_t d[COM_BIN_TX_MAX - 2u];
+      const uint32_t k = (n == 4u) ? p[3] : 0u;
+      if ((k == 0u) || (k > (sizeof(d) - 3u)))
+      {
+        bin_reply(cmd, COM_BIN_ST_PAYLOAD, NULL, 0);
+        break;
+      }
+      const uint32_t offset = (uint32_t)p[1] | ((uint32_t)p[2] << 8);
+      memcpy(d, p, 3u);
+      if (!AppPreset_ReadImage(p[0], offset, &d[3], k))
+      {
+        bin_reply(cmd, COM_BIN_ST_FAILED, d, 3u);
+        break;
+      }
+      bin_reply(cmd, COM_BIN_ST_OK, d, (uint16_t)(3u + k));
+      break;
+    }
+    case COM_BIN_PSTAGE:
+    {
+      if (n < 3u)
+      {
+        bin_reply(cmd, COM_BIN_ST_PAYLOAD, NULL, 0);
+        break;
+      }
+      const uint32_t offset = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+      const uint8_t ok = AppPreset_StageImage(offset, &p[2], (uint32_t)(n - 2u));
+      bin_reply(cmd, ok ? COM_BIN_ST_OK : COM_BIN_ST_FAILED, NULL, 0);
+      break;
+    }
+    case COM_BIN_PCOMMIT:
+    {
+      if (n != 5u)
+      {
+        bin_reply(cmd, COM_BIN_ST_PAYLOAD, NULL, 0);
+        break;
+      }
+      const uint32_t crc = (uint32_t)p[1] | ((uint32_t)p[2] << 8) | ((uint32_t)p[3] << 16) | ((uint32_t)p[4] << 24);
+      bin_reply(cmd, AppPreset_CommitImage(p[0], crc) ? COM_BIN_ST_OK : COM_BIN_ST_FAILED, NULL, 0);
+      break;
+    }
+    default:
+      bin_reply(cmd, COM_BIN_ST_UNKNOWN, NULL, 0);
+      break;
+  }
+}
+
+/* Collects one frame byte; a bad length drops the frame silently. */
+static void bin_rx_byte(ComRx *rx, uint8_t b)
+{
+  if ((rx->bin_len == 0u) && ((b == 0u) || (b > APP_COM_BIN_MAX)))
+  {
+    rx->bin_active = 0;
+    return;
+  }
+  rx->bin[rx->bin_len++] = b;
+  if (rx->bin_len == ((uint16_t)rx->bin[0] + 3u))
+  {
+    handle_frame(rx->bin);
+    rx->bin_active = 0;
+  }
+}
+
+/* One received byte: a frame's, or a line's, handled at its newline. */
+static void rx_byte(ComRx *rx, uint8_t b)
+{
+  if (rx->bin_active)
+  {
+    bin_rx_byte(rx, b);
+    return;
+  }
+
+  if ((b == COM_BIN_SYNC) && (rx->line_len == 0u))
+  {
+    rx->bin_active = 1;
+    rx->bin_len = 0;
+    rx->bin_t0 = HAL_GetTick();
+    return;
+  }
+
+  if (b == '\n')
+  {
+    rx->line[rx->line_len] = 0;
+    handle_line(rx->line);
+    rx->line_len = 0;
+    return;
+  }
+
+  if (b == '\r')
+  {
+    return;
+  }
+
+  if (rx->line_len + 1u < APP_COM_LINE_MAX)
+  {
+    rx->line[rx->line_len++] = (char)b;
+  }
+  else
+  {
+    /* Line too long: reset. */
+    rx->line_len = 0;
+  }
+}
+
+static void link_reset(ComLink l)
+{
+  k_rx[l]->line_len = 0;
+  k_rx[l]->bin_len = 0;
+  k_rx[l]->bin_active = 0;
+}
+
+/* A link opening greets the host as the UART does at boot; closing it
+ * stops the streams that went there.
+ */
+static void link_poll(ComLink l)
+{
+  if (k_links[l].is_open == NULL)
+  {
+    return;
+  }
+  const uint8_t open = k_links[l].is_open();
+  if (open == s_link_open[l])
+  {
+    return;
+  }
+  s_link_open[l] = open;
+  s_credit_on[l] = 0;
+  s_quiet[l] = 0;
+  s_quiet_n[l] = 0;
+  if (open)
+  {
+    link_reset(l);
+    const ComLink prev = s_link;
+    s_link = l;
+    send_line("READY");
+    s_link = prev;
+    return;
+  }
+  k_rx[l]->hold_len = 0;
+  k_rx[l]->hold_pos = 0;
+  for (uint32_t t = 0; t < COM_TOPIC_COUNT; t++)
+  {
+    if ((s_sub_link[t] == l) && (s_sub_hz[t] != 0u))
+    {
+      (void)sub_set((ComTopic)t, 0u);
+    }
+  }
+  if (s_dump_link == l)
+  {
+    s_dump_end = 0;
+  }
+  if (s_trace_link == l)
+  {
+    s_trace_end = 0;
+  }
+  if (s_evt_link == l)
+  {
+    s_evt_on = 0;
+  }
+}
+
+/* Takes what the link has received, up to its rx_max per pass. */
+static void link_rx(ComLink l)
+{
+  const ComLinkOps *ops = &k_links[l];
+  ComRx *rx = k_rx[l];
+  uint32_t total = 0;
+  s_link = l;
+  while (total < ops->rx_max)
+  {
+    if (rx->hold_pos == rx->hold_len)
+    {
+      if ((ops->restarted != NULL) && ops->restarted())
+      {
+        /* RX restarted after an error or a BAUD switch; the partial line
+         * is lost either way, and so is the credit count.
+         */
+        link_reset(l);
+        credit_stop(l);
+      }
+      const uint32_t got = ops->read(rx->hold, sizeof(rx->hold));
+      if (got == 0u)
+      {
+        break;
+      }
+      if ((ops->rx_stamp == NULL) || !ops->rx_stamp(&rx->hold_cyc))
+      {
+        rx->hold_cyc = DWT->CYCCNT;
+      }
+      rx->hold_len = (uint8_t)got;
+      rx->hold_pos = 0;
+      /* RTT opens with its first byte: READY before the first reply. */
+      link_poll(l);
+    }
+    /* With CREDIT on, the next command is only taken while a full reply
+     * line fits the TX queue: a host that does not read holds its own
+     * input back instead of losing replies.
+     */
+    if (s_credit_on[l] && (rx->line_len == 0u) && !rx->bin_active && (tx_ring_free() < COM_OUT_MAX))
+    {
+      break;
+    }
+    s_link_rx[l]++;
+    rx_byte(rx, rx->hold[rx->hold_pos++]);
+    total++;
+  }
+}
+
+/* A new limit goes out as CR once it moved a quarter window, or the input
+ * ran dry; a limit not sent for a full TX queue goes with a later one.
+ */
+static void credit_poll(ComLink l)
+{
+  if (!s_credit_on[l])
+  {
+    return;
+  }
+  const uint32_t limit = credit_limit(l);
+  const uint32_t moved = limit - s_credit_sent[l];
+  const uint8_t dry = (k_rx[l]->hold_pos == k_rx[l]->hold_len) && !k_links[l].pending();
+  if ((moved == 0u) || ((moved < (k_links[l].rx_window / 4u)) && !dry))
+  {
+    return;
+  }
+  s_link = l;
+  if (tx_ring_free() < 16u)
+  {
+    return;
+  }
+  out_begin("CR ");
+  out_u32(limit);
+  out_line();
+  s_credit_sent[l] = limit;
+}
+
+/* The QACK for what a link's QUIET commands owe, once APP_COM_EVT_MS
+ * passed since the first; it waits for room rather than being dropped.
+ */
+static void quiet_poll(ComLink l)
+{
+  if ((s_quiet_n[l] == 0u) || ((HAL_GetTick() - s_quiet_t0[l]) < APP_COM_EVT_MS))
+  {
+    return;
+  }
+  s_link = l;
+  sync_scan();
+  out_begin("QACK ");
+  out_u32(s_quiet_seq[l]);
+  out_str(" n=");
+  out_u32(s_quiet_n[l]);
+  out_str(" V=");
+  out_u32(s_sync_now);
+  out_str(" P=");
+  out_u32(AppDsp_ParamsVersion());
+  if (tx_ring_free() <= s_out_len)
+  {
+    s_out_len = 0;
+    return;
+  }
+  out_line();
+  s_quiet_n[l] = 0;
+}
+
+void AppCom_Init(void)
+{
+  for (uint32_t i = 0; i < COM_LINK_COUNT; i++)
+  {
+    link_reset((ComLink)i);
+    s_link_open[i] = 0;
+    s_link_rx[i] = 0;
+    s_link_tx[i] = 0;
+    s_link_drop[i] = 0;
+    s_credit_on[i] = 0;
+    s_quiet[i] = 0;
+    s_quiet_n[i] = 0;
+    s_quiet_seq[i] = 0;
+    k_rx[i]->hold_len = 0;
+    k_rx[i]->hold_pos = 0;
+  }
+  s_link = COM_LINK_UART;
+
+  s_baud_pending = 0;
+  s_baud_trial = 0;
+  for (uint32_t t = 0; t < COM_TOPIC_COUNT; t++)
+  {
+    (void)sub_set((ComTopic)t, 0u);
+  }
+  s_dump_pos = 0;
+  s_dump_end = 0;
+  s_trace_pos = 0;
+  s_trace_end = 0;
+  s_evt_on = 0;
+  sync_scan();
+  s_sync_t0 = HAL_GetTick();
+
+  send_line("READY");
+}
+
+void AppCom_Poll(void)
+{
+  baud_poll();
+  reboot_poll();
+  for (uint32_t i = 0; i < COM_LINK_COUNT; i++)
+  {
+    link_poll((ComLink)i);
+  }
+  s_link = s_dump_link;
+  dump_poll();
+  s_link = s_trace_link;
+  trace_poll();
+  s_link = s_evt_link;
+  evt_poll();
+  lat_poll();
+
+  for (uint32_t i = 0; i < COM_LINK_COUNT; i++)
+  {
+    if (k_rx[i]->bin_active && ((HAL_GetTick() - k_rx[i]->bin_t0) > APP_COM_BIN_TIMEOUT_MS))
+    {
+      k_rx[i]->bin_active = 0;
     }
+  }
+
+  for (uint32_t i = 0; i < COM_LINK_COUNT; i++)
+  {
+    link_rx((ComLink)i);
+    credit_poll((ComLink)i);
+    quiet_poll((ComLink)i);
+  }
+  s_link = COM_LINK_UART;
+}
 
-    if (b == '\r')
+void AppCom_Publish(void)
+{
+  const uint32_t now = HAL_GetTick();
+  for (uint32_t t = 0; t < COM_TOPIC_COUNT; t++)
+  {
+    if ((s_sub_hz[t] == 0u) || ((now - s_sub_t0[t]) < (1000u / s_sub_hz[t])))
     {
       continue;
     }
+    s_sub_t0[t] = now;
+    s_link = s_sub_link[t];
+    switch ((ComTopic)t)
+    {
+      case COM_TOPIC_METER:
+        pub_meter();
+        break;
+      case COM_TOPIC_LOAD:
+        pub_load();
+        break;
+      case COM_TOPIC_CLOCK:
+        pub_clock();
+        break;
+      case COM_TOPIC_TUNER:
+        pub_tuner();
+        break;
+      case COM_TOPIC_SPECTRUM:
+        pub_spectrum();
+        break;
+      default:
+        break;
+    }
+  }
+  s_link = COM_LINK_UART;
+}
 
-    if (s_line_len + 1u < APP_COM_LINE_MAX)
+uint8_t AppCom_Pending(void)
+{
+  for (uint32_t i = 0; i < COM_LINK_COUNT; i++)
+  {
+    if (k_links[i].pending() || (k_rx[i]->hold_pos != k_rx[i]->hold_len))
     {
-      s_line[s_line_len++] = (char)b;
+      return 1u;
     }
-    else
+    if ((k_links[i].is_open != NULL) && (k_links[i].is_open() != s_link_open[i]))
     {
-      /* Line too long: reset. */
-      s_line_len = 0;
+      return 1u;
     }
   }
+  return 0u;
 }
@@ -1,12 +1,50 @@
 #include "app_dsp.h"
 
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
+#include "app_arena.h"
+#include "app_cabir.h"
+#include "app_coef.h"
+#include "app_capture.h"
+#include "app_dline.h"
+#include "app_eq.h"
+#if APP_DSP_CAB_FMAC
+#include "app_fmac.h"
+#endif
+#include "app_fx.h"
+#include "app_lfo.h"
+#include "app_mem.h"
+#include "app_meter.h"
+#include "app_prof.h"
+#include "app_selftest.h"
+#include "app_shaper.h"
+#include "app_spectrum.h"
+#include "app_tables.h"
+#include "app_tuner.h"
+
+/* Cortex-M4 DSP extension (SSAT, ...) for the fixed-point helpers.
+ * Both paths give bit-identical output; the portable one keeps this file
+ * buildable on a host compiler. Override with -DDSP_USE_ARM_DSP=0/1.
+ */
+#ifndef DSP_USE_ARM_DSP
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define DSP_USE_ARM_DSP 1
+#else
+#define DSP_USE_ARM_DSP 0
+#endif
+#endif
+
+#if DSP_USE_ARM_DSP
+#include "cmsis_compiler.h"
+#endif
+
 /*
  * This file contains the "audio DSP" part of your project:
  * - DC blocker + gain staging + optional coloration
- * - FX blocks (distortion / delay / reverb)
+ * - FX blocks (distortion / delay / reverb), post-cab EQ
  * - makeup gain + fast limiter
  *
  * It is intentionally HAL-independent so it is easy to read and change.
@@ -21,25 +59,48 @@
 #define AUDIO_LIMITER_ENABLE           1
 #define AUDIO_LIMITER_THRESH_S24       6500000
 #define AUDIO_LIMITER_RELEASE_Q15      16
+#define AUDIO_LIMITER_LOOKAHEAD        (AUDIO_LIMITER_ENABLE && APP_DSP_LIMITER_LOOKAHEAD)
+/* Lookahead limiter: frames per sub-block (1 << shift) and the lookahead
+ * in sub-blocks (at least 2, see limiter_sub_end()).
+ */
+#define LIMITER_SUB_SHIFT              3U
+#define LIMITER_SUB                    (1U << LIMITER_SUB_SHIFT)
+#define LIMITER_LA_SUBS                2U
+#define LIMITER_LA_FRAMES              (LIMITER_SUB * LIMITER_LA_SUBS)
 
 #define INPUT_COLOR_ENABLE             1
 #define INPUT_COLOR_DRIVE_Q8           384
+/* Coloration on the distortion's halfband pair (APP_DSP_DIST_ISLAND). */
+#define DSP_ISLAND                     (INPUT_COLOR_ENABLE && APP_DSP_DIST_ISLAND)
 
 /* Clean-tone conditioning (always-on): helps electric guitar cleans.
  * - HPF removes handling rumble and tightens low end.
  * - Gentle compressor evens dynamics and adds sustain.
  */
 #define CLEAN_HPF_ENABLE               1
-/* 1st-order HPF coefficient R in Q15.
- * For fs=48kHz and fc~=90Hz: R ~= exp(-2*pi*fc/fs) ~= 0.9883 -> 32384.
- */
-#define CLEAN_HPF_R_Q15                32384
+/* 1st-order HPF corner (rate_init() designs the pole). */
+#define CLEAN_HPF_FC_HZ                90
+
+/* APP_DSP_FUSED_COND: DC blocker, clean HPF and input gain as one section. */
+#define DSP_FUSED_COND                 APP_DSP_FUSED_COND
+#if DSP_FUSED_COND && !CLEAN_HPF_ENABLE
+#error "APP_DSP_FUSED_COND fuses the clean HPF: needs CLEAN_HPF_ENABLE"
+#endif
+/* The separate stages clamp ahead of the input gain. */
+#define COND_CLAMP_S24                 ((int32_t)((8388607LL * AUDIO_INPUT_GAIN_Q8) >> 8))
+
+/* APP_DSP_HEADROOM: clamp-free tail stages where the block bound allows. */
+#define DSP_HEADROOM                   APP_DSP_HEADROOM
 
 #define CLEAN_COMP_ENABLE              1
-/* Threshold in signed 24-bit counts (0..8388607). */
-#define CLEAN_COMP_THRESH_S24          3000000
-/* Ratio: 2 means 2:1 (gentle). Must be >= 1. */
-#define CLEAN_COMP_RATIO               2
+/* Boot curve (runtime params comp_*): -8.9 dBFS, 2:1, hard knee. */
+#define CLEAN_COMP_THRESH_DB10         (-89)
+#define CLEAN_COMP_RATIO_X10           20
+#define CLEAN_COMP_KNEE_DB10           0
+/* Frames per gain-computer evaluation (power of two); the gain smoother
+ * still runs every sample.
+ */
+#define CLEAN_COMP_SUBBLOCK            8U
 /* Envelope follower coefficients in Q15 (bigger=faster). */
 #define CLEAN_COMP_ENV_ATTACK_Q15      4096
 #define CLEAN_COMP_ENV_RELEASE_Q15     256
@@ -48,21 +109,81 @@
 #define CLEAN_COMP_GAIN_RELEASE_Q15    512
 
 /* Guitar cab-sim (post-distortion): simple 2nd-order lowpass to remove fizz.
- * Designed for fs=48 kHz, fc~=5 kHz, Butterworth-ish (Q~0.707).
+ * 5 kHz Butterworth (CAB_LPF_FC_HZ, CAB_LPF_Q), designed for the build rate.
  */
 #define CABSIM_ENABLE                  1
+#define CABSIM_FMAC                    (CABSIM_ENABLE && APP_DSP_CAB_FMAC)
+/* With an IR stored (app_cabir.h) the convolver replaces the lowpass. */
+#define CABSIM_IR                      (CABSIM_ENABLE && APP_CABIR_ENABLE)
+/* Biquad states per channel: the user cab's sections, at least the lowpass. */
+#define CAB_BIQUADS                    ((APP_DSP_CAB_SECTIONS_MAX > 0U) ? APP_DSP_CAB_SECTIONS_MAX : 1U)
+
+/* Distortion oversampling halfbands (Q15 side taps, centre tap 0.5). The
+ * 1x<->2x pair is 15 taps (Kaiser beta 4, -0.2 dB at 8 kHz, -34 dB from
+ * 16 kHz). The 2x<->4x pair only has to reject images above 24 kHz and uses
+ * [-1 0 9 16 9 0 -1] / 32.
+ */
+#define DIST_HB1_TAPS                  4U
+#define DIST_HB2_TAPS                  2U
+#define DIST_HB_MASK                   7U
+/* Frames clipped and tone-shaped at a time, ahead of the cab. */
+#define DIST_CHUNK                     32U
+/* Output one-pole of the clipper, ~3.5 kHz; the tube model's, ~2.1 kHz. */
+#define DIST_LP_A_Q15                  12000
+#define DIST_TUBE_LP_A_Q15             8000
+/* Operating points of the biased models, s24 after the drive, and the
+ * fuzz's extra gain (x4).
+ */
+#define DIST_TUBE_BIAS                 300000
+#define DIST_FUZZ_BIAS                 150000
+#define DIST_FUZZ_GAIN_SHIFT           2U
+
+/* Reverb (fixed-point): 4-line feedback delay network + allpass diffuser.
+ * The line lengths are mutually prime, so no two lines share an echo period
+ * (the source of the old single comb's metallic ring), and the largest set
+ * that fits APP_DSP_REVERB_RAM_BYTES at the storage format is used.
+ */
+#define REVERB_FDN_LINES               4U
+/* One input channel into the tank (every line gets the same send). */
+#define REVERB_MONO_IN                 (APP_DSP_MONO_INPUT || APP_DSP_REVERB_MONO_SEND)
+#define REVERB_FDN_SAMPLES             APP_DLINE_FRAMES(APP_DSP_REVERB_RAM_BYTES, 1U, APP_DSP_REVERB_STORAGE)
+
+#if REVERB_FDN_SAMPLES >= 8070U
+/* 33..51 ms */
+#define REVERB_FDN_LEN0                1601U
+#define REVERB_FDN_LEN1                1873U
+#define REVERB_FDN_LEN2                2137U
+#define REVERB_FDN_LEN3                2459U
+#elif REVERB_FDN_SAMPLES >= 4026U
+/* 17..26 ms */
+#define REVERB_FDN_LEN0                797U
+#define REVERB_FDN_LEN1                937U
+#define REVERB_FDN_LEN2                1063U
+#define REVERB_FDN_LEN3                1229U
+#elif REVERB_FDN_SAMPLES >= 2000U
+/* 8..13 ms: small room */
+#define REVERB_FDN_LEN0                397U
+#define REVERB_FDN_LEN1                467U
+#define REVERB_FDN_LEN2                523U
+#define REVERB_FDN_LEN3                613U
+#else
+#error "APP_DSP_REVERB_RAM_BYTES is too small for the FDN reverb"
+#endif
 
-/* Reverb (fixed-point): feedback delay + allpass diffuser. */
-#define REVERB_DELAY_LEN               2048U
-#define REVERB_DELAY_MASK              (REVERB_DELAY_LEN - 1U)
-#define REVERB_AP_LEN                  128U
-#define REVERB_AP_MASK                 (REVERB_AP_LEN - 1U)
+#define REVERB_FDN_TOTAL               (REVERB_FDN_LEN0 + REVERB_FDN_LEN1 + REVERB_FDN_LEN2 + REVERB_FDN_LEN3)
+#define REVERB_FDN_BYTES               (APP_DLINE_WORDS(REVERB_FDN_TOTAL, 1U, APP_DSP_REVERB_STORAGE) * 4U)
 
-/* Split allpass buffer into two stages for more diffusion (warmer/less metallic). */
-#define REVERB_AP1_LEN                 64U
-#define REVERB_AP2_LEN                 64U
-#define REVERB_AP1_MASK                (REVERB_AP1_LEN - 1U)
-#define REVERB_AP2_MASK                (REVERB_AP2_LEN - 1U)
+/* Diffuser: reverb_diffusion stereo allpasses in series behind the FDN
+ * taps, lengths from k_reverb_ap_len (primes, so no two stages ring at a
+ * common period), the first two always on. All stages the build allows
+ * sit in one buffer in the arena with the tank.
+ */
+#define REVERB_AP_STAGES               APP_DSP_REVERB_AP_STAGES
+#define REVERB_AP_LEN                  (67U + 61U + ((REVERB_AP_STAGES > 2U) ? 43U : 0U) + \
+                                        ((REVERB_AP_STAGES > 3U) ? 37U : 0U) + \
+                                        ((REVERB_AP_STAGES > 4U) ? 29U : 0U) + \
+                                        ((REVERB_AP_STAGES > 5U) ? 23U : 0U))
+#define REVERB_AP_BYTES                (REVERB_AP_LEN * 8U)
 
 #define REVERB_FEEDBACK_Q15            22000   /* ~0.67 (tighter/less runaway) */
 #define REVERB_DAMP_Q15                8192    /* stronger damping (less harsh) */
@@ -72,18 +193,173 @@
 /* When stacking FX (ALL mode), keep space subtle so it stays punchy. */
 #define REVERB_MIX_ALL_Q15             4915    /* ~0.15 wet */
 
-/* Delay */
-#define DELAY_LEN                      1024U
-#define DELAY_MASK                     (DELAY_LEN - 1U)
+/* Delay: line length comes from the RAM budget in app_dsp.h (any size, the
+ * index wraps by compare). Default time is the original 1024-step line
+ * (~170 ms).
+ */
+#define DELAY_LEN                      APP_DLINE_FRAMES(APP_DSP_DELAY_RAM_BYTES, 2U, APP_DSP_DELAY_STORAGE)
+#define DELAY_WORDS                    APP_DLINE_WORDS(DELAY_LEN, 2U, APP_DSP_DELAY_STORAGE)
+#define DELAY_BYTES                    (DELAY_WORDS * 4U)
+#define DELAY_TIME_DEFAULT_STEPS       ((DELAY_LEN < (1024U * DSP_RATE_MUL)) ? DELAY_LEN : (1024U * DSP_RATE_MUL))
 #define DELAY_FEEDBACK_Q15             16384   /* 0.50 */
 #define DELAY_MIX_Q15                  11469   /* ~0.35 wet (solo delay mode) */
-#define DELAY_MIX_ALL_Q15              6554    /* legacy default; now scaled from delay_mix_q15 */
 
-/* Make the delay feel less "robotic": operate the delay line at a lower
- * effective sample rate (zero-order hold), which increases delay time and
- * naturally rolls off highs.
+/* The delay line runs at 1/8 rate (6 kHz at 48 kHz), which increases delay
+ * time and naturally rolls off highs. A 24-tap polyphase low-pass decimates
+ * on write and interpolates on read (3 MACs per channel each way).
  */
 #define DELAY_DECIM                    8U
+#define DELAY_RS_ROWS                  3U
+
+/* delay_time_ms changes glide: the read position moves 1/256 of the
+ * remaining distance per line step (~43 ms time constant at 48 kHz), at
+ * most 1/4 step per step (a pitch bend of at most 25%) instead of jumping
+ * and clicking.
+ */
+#define DELAY_GLIDE_SHIFT              8
+#define DELAY_GLIDE_MAX_Q16            16384
+
+#if DELAY_DECIM != 8U
+#error "k_delay_rs_q15 is designed for DELAY_DECIM == 8"
+#endif
+
+/* LFO phase leads (chorus and phaser spread): degrees to Q32 turns. */
+#define LFO_DEG_TO_Q32                 11930465U   /* 2^32 / 360 */
+
+/* Phaser: a cascade of first-order allpasses per channel, summed with the
+ * dry signal for stages/2 notches. The LFO sweeps the allpass corner
+ * exponentially, from phaser_freq_hz up to PHASER_SPAN_OCT octaves at full
+ * depth; the coefficients are recomputed every PHASER_SUB frames and each
+ * stage runs over such a sub-block at a time. w = pi * f / fs stands in
+ * for tan(pi * f / fs): the top of the sweep lands a little low, which
+ * only bends its shape, and it is capped at PHASER_W_MAX_Q20 (~9.8 kHz).
+ */
+#define PHASER_STAGES_MAX              8U
+#define PHASER_SUB                     16U
+#define PHASER_SPAN_OCT                5
+#define PHASER_ONE_Q20                 (1 << 20)
+#define PHASER_W_MAX_Q20               (3 << 18)   /* 0.75 */
+#define PHASER_HZ_TO_W_Q20(hz)         ((uint32_t)(((uint64_t)(hz) * 3294199U) / DSP_SAMPLE_RATE_HZ))   /* pi * 2^20 */
+#define PHASER_MIX_Q15                 16384   /* 0.50: deepest notches */
+#define PHASER_RATE_MHZ                400U
+#define PHASER_DEPTH_Q15               26214   /* ~0.80: 4 octaves */
+#define PHASER_FREQ_HZ                 200U
+#define PHASER_STAGES                  4U
+#define PHASER_SPREAD_DEG              90U
+
+/* Tremolo / auto-pan, folded into the output stage: per block one LFO
+ * step gives each side's gain at the block's end, and the output ramps to
+ * it, one multiply per sample and side.
+ */
+/* Half notes per cycle of each AppDspTremoloDiv, doubled: 1000 mHz * bpm
+ * / 60 per quarter note.
+ */
+#define TREMOLO_DIV_HALVES(div) \
+  (((div) == APP_DSP_TREMOLO_HALF) ? 1U : ((div) == APP_DSP_TREMOLO_QUARTER) ? 2U : \
+   ((div) == APP_DSP_TREMOLO_EIGHTH) ? 4U : ((div) == APP_DSP_TREMOLO_TRIPLET) ? 6U : 8U)
+#define TREMOLO_RATE_MHZ(bpm, div)     (((bpm) * TREMOLO_DIV_HALVES(div) * 25U) / 3U)
+#define TREMOLO_TEMPO_BPM              120U
+#define TREMOLO_DIV                    APP_DSP_TREMOLO_EIGHTH   /* 4 Hz at 120 bpm */
+
+/* Tempo sync (AppDspSyncDiv): each note value in twelfths of a beat, so
+ * a note lasts 5 * twelfths / bpm seconds and an LFO cycling once per
+ * note runs at 200 * bpm / twelfths mHz.
+ */
+static const uint8_t k_sync_twelfths[APP_DSP_SYNC_COUNT] = {0u, 24u, 12u, 9u, 6u, 4u, 3u};
+
+/* Tap tempo (AppDsp_TapTempo()). */
+#define TAP_INTERVALS                  4U
+#define TAP_BOUNCE_MS                  200U    /* 300 bpm */
+#define TAP_TIMEOUT_MS                 3000U   /* 20 bpm */
+
+/* Auto-wah: a Chamberlin state-variable bandpass whose centre follows the
+ * input envelope (the compressor's detector, DspBlockParams.mod_env). The
+ * centre moves every WAH_SUB frames, exponentially from wah_freq_hz up to
+ * WAH_SPAN_OCT octaves at full depth, capped at fs / 12 (f = 0.52) where
+ * the filter stays stable down to Q = 0.7. Phases are Q32 turns of
+ * AppTab_Sin(), which gives f = 2 sin(pi fc / fs).
+ */
+#define WAH_SUB                        8U
+#define WAH_SPAN_OCT                   4
+#define WAH_HZ_TO_PHASE(hz)            ((uint32_t)(((uint64_t)(hz) << 31) / DSP_SAMPLE_RATE_HZ))
+#define WAH_PHASE_MAX                  (0x80000000U / 12U)
+#define WAH_Q100_TO_DAMP_Q15(q100)     ((int32_t)(3276800 / (q100)))   /* 1 / Q */
+#define WAH_FREQ_HZ                    400U
+#define WAH_DEPTH_Q15                  24576   /* 0.75: 3 octaves */
+#define WAH_SENS_DB10                  (-240)
+#define WAH_Q100                       400
+
+/* Chorus/flanger: one mono line at half the frame rate behind the
+ * distortion's 4-tap halfband pair (k_dist_hb1_q15), S16, read by two
+ * LFO-modulated taps. It holds twice the longest centre distance (full
+ * depth) plus the interpolation neighbour. Depth, mix and feedback are
+ * Q15, the centre distance glides as the delay time does.
+ */
+#define CHORUS_FS_HZ                   (DSP_SAMPLE_RATE_HZ / 2U)
+#define CHORUS_STORAGE                 APP_DLINE_S16
+#define CHORUS_US_TO_Q16(us)           ((uint32_t)((((uint64_t)(us) * CHORUS_FS_HZ) << 16) / 1000000U))
+#define CHORUS_LEN                     (((2U * APP_DSP_CHORUS_TIME_MAX_US * (CHORUS_FS_HZ / 100U)) / 10000U) + 2U)
+#define CHORUS_WORDS                   APP_DLINE_WORDS(CHORUS_LEN, 1U, CHORUS_STORAGE)
+#define CHORUS_BYTES                   (APP_DSP_CHORUS_ENABLE ? (CHORUS_WORDS * 4U) : 0U)
+#define CHORUS_MIX_Q15                 16384   /* 0.50 */
+#define CHORUS_RATE_MHZ                800U
+#define CHORUS_DEPTH_Q15               9830    /* ~0.30 */
+#define CHORUS_TIME_US                 7000U
+#define CHORUS_SPREAD_DEG              90U     /* quadrature */
+
+/* Pitch shifter: a mono line at half the frame rate behind the same
+ * halfband pair as the chorus, S16, one window long. Two read heads half
+ * a window apart drift through the window at (1 - ratio) steps per step
+ * and each jumps back across it where its Hann weight is zero; the
+ * weights of the two always sum to one. The ratio is 2^(cents / 1200) in
+ * Q16; phases are Q32 fractions of the window.
+ */
+#define PITCH_FS_HZ                    (DSP_SAMPLE_RATE_HZ / 2U)
+#define PITCH_STORAGE                  APP_DLINE_S16
+#define PITCH_MS_TO_STEPS(ms)          (((ms) * PITCH_FS_HZ) / 1000U)
+#define PITCH_LEN                      (PITCH_MS_TO_STEPS(APP_DSP_PITCH_WINDOW_MAX_MS) + 2U)
+#define PITCH_WORDS                    APP_DLINE_WORDS(PITCH_LEN, 1U, PITCH_STORAGE)
+#define PITCH_BYTES                    (APP_DSP_PITCH_ENABLE ? (PITCH_WORDS * 4U) : 0U)
+#define PITCH_CENTS                    (-1200)   /* octave down */
+#define PITCH_WINDOW_MS                30U
+
+#define DSP_SAMPLE_RATE_HZ             APP_DSP_SAMPLE_RATE_HZ
+/* Frame counts and coefficients below are given at 48 kHz (see rate_init()). */
+#define DSP_RATE_BASE_HZ               48000U
+#define DSP_RATE_MUL                   ((int32_t)(DSP_SAMPLE_RATE_HZ / DSP_RATE_BASE_HZ))
+
+/* FX mask changes: distortion and phaser crossfade with the dry signal,
+ * chorus, delay and reverb fade their input send and keep ringing ("spillover"). Output
+ * mixes and the makeup gain ramp over the same 256 samples (~5 ms).
+ * The tail FX sleep once their input and wet output stayed below
+ * DSP_TAIL_FLOOR_S24 (~-90 dBFS) for two of their longest echo periods,
+ * whether they are switched on or not. A sleeping FX that is off drops out
+ * of the chain; one that is on only scales the dry signal and wakes at the
+ * first block with input above the floor.
+ */
+#define DSP_XFADE_FRAMES               (256 * DSP_RATE_MUL)
+#define DSP_TAIL_FLOOR_S24             256
+
+/* Continuous AppDsp_SetParam() values glide to a new setting over ~21 ms.
+ * The smoothed value is advanced once per block, so stages read a constant
+ * from the block snapshot and no stage does per-sample smoothing.
+ */
+#define DSP_PARAM_SMOOTH_FRAMES        (1024 * DSP_RATE_MUL)
+
+/* Noise gate: one mean-square value per block, after the DC blocker and
+ * without lookahead, so a note that opens it fades in over
+ * GATE_ATTACK_FRAMES. It closes at a quarter of the open threshold (-6 dB)
+ * after GATE_HOLD_FRAMES below it.
+ */
+#define GATE_HOLD_FRAMES               (2400 * DSP_RATE_MUL)    /* 50 ms */
+#define GATE_ATTACK_FRAMES             (48 * DSP_RATE_MUL)      /* 1 ms */
+#define GATE_HYST_SHIFT                2U
+#define GATE_RELEASE_MS                100
+#define GATE_CHANNELS                  (APP_DSP_MONO_INPUT ? 1U : 2U)
+
+#if DELAY_LEN < 1U
+#error "APP_DSP_DELAY_RAM_BYTES is too small for one delay step"
+#endif
 
 /* Gentle wet low-pass to remove harsh/metallic highs. */
 #define WET_LPF_A_Q15                  2048    /* ~0.062 */
@@ -91,44 +367,112 @@
 /* Delay feedback high-cut (bigger=faster/less dark). */
 #define DELAY_FB_LPF_A_Q15             1024    /* ~0.031 */
 
-/* Reverb modulation: small tap wobble reduces metallic ringing. */
-#define REVERB_MOD_STEP_L              65536U  /* kept for experimentation */
-#define REVERB_MOD_STEP_R              77824U  /* kept for experimentation */
-/* Set to 0 to disable modulation (removes audible "wummmm" wobble). */
-#define REVERB_MOD_AMP_SAMPLES         0
+/* Delay ducking (delay_duck_q15): the wet starts to drop at DUCK_THRESH
+ * input RMS and reaches the full duck DUCK_RANGE higher. The level it
+ * follows attacks within a block, is held no higher than the full duck and
+ * falls back by DUCK_RANGE over DUCK_RELEASE_MS, so the repeats are back
+ * that long into a gap however loud the playing was.
+ */
+#define DELAY_DUCK_THRESH_L2           APP_TAB_DB10_TO_L2(-450)
+#define DELAY_DUCK_RANGE_L2            (4 * 65536)              /* ~24 dB */
+#define DELAY_DUCK_RELEASE_MS          400U
+#define DELAY_DUCK_FALL_L2             ((int32_t)(((uint64_t)DELAY_DUCK_RANGE_L2 * 1000U) / \
+                                                  ((uint64_t)DELAY_DUCK_RELEASE_MS * DSP_SAMPLE_RATE_HZ)))
+/* Input level while nothing measures it. */
+#define DSP_LEVEL_FLOOR_L2             (-24 * 65536)
+
+/* Preset spillover (APP_DSP_SPILL_MS): the tail FX that ring out on the
+ * outgoing preset's parameters, and the longest they hold them against a
+ * new preset that selects them too.
+ */
+#define DSP_SPILL                      (APP_DSP_SPILL_MS != 0U)
+#define DSP_SPILL_FX                   (APP_FX_BIT_DELAY | APP_FX_BIT_REVERB)
+#define DSP_SPILL_FRAMES               ((APP_DSP_SPILL_MS * DSP_SAMPLE_RATE_HZ) / 1000U)
 
 /* Wet-return conditioning: high-pass wet paths so lows stay tight and feedback
  * doesn't turn into a boomy wash.
  */
 #define WET_HPF_ENABLE                 1
-/* For fs=48kHz and fc~=180Hz: R ~= exp(-2*pi*fc/fs) ~= 0.9767 -> ~32004 */
-#define WET_HPF_R_Q15                  32004
+#define WET_HPF_FC_HZ                  180
+
+/* APP_DSP_REVERB_HALF_RATE: the reverb wet path runs at half rate behind a
+ * 19-tap halfband pair (Kaiser beta 5, at 48 kHz -0.1 dB at 8 kHz, images
+ * above 16 kHz down >40 dB). Its wet filters get the coefficients for the
+ * same corners (rate_init()).
+ */
+#if APP_DSP_REVERB_HALF_RATE
+#define REVERB_HB_TAPS                 5U
+#define REVERB_HB_MASK                 15U
+#endif
+
+/* DC blocker corner. */
+#define DC_BLOCK_FC_HZ                 20
 
 /* ------------------------------- Internals -------------------------------- */
 
 static volatile AppFxMode s_mode = APP_FX_MODE_BYPASS;
 static volatile uint32_t s_button_last_ms = 0;
 
-static volatile AppFxMask s_fx_mask = 0;
+typedef struct
+{
+  uint32_t last_ms;
+  uint32_t taps;                 /* since the count started */
+  uint32_t interval_ms[TAP_INTERVALS];
+} DspTap;
+
+static DspTap s_tap;
+
+/* Per-sample coefficients at the build rate, one set for the whole chain
+ * (reverb wet filters at REVERB_FS_HZ, the delay feedback at the line rate).
+ * Filled in AppDsp_Init() by rate_init(): the filters with a corner are
+ * designed for their rate at compile time (app_coef.h), the smoothing steps
+ * and leaks are scaled from their 48 kHz tuning.
+ */
+typedef struct
+{
+  int32_t dc_r_q15;
+  int32_t clean_hpf_r_q15;
+  int32_t comp_env_attack_q15;
+  int32_t comp_env_release_q15;
+  int32_t comp_gain_attack_q15;
+  int32_t comp_gain_release_q15;
+  int32_t wet_hpf_r_q15;
+  int32_t wet_lpf_a_q15;
+  int32_t delay_fb_lpf_a_q15;
+  int32_t reverb_wet_hpf_r_q15;
+  int32_t reverb_wet_lpf_a_q15;
+  int32_t limiter_release_q15;
+  int32_t limiter_release_sub_q15;   /* per LIMITER_SUB frames */
+  int32_t cab_b_q28[3];
+  int32_t cab_a_q28[2];
+#if DSP_FUSED_COND
+  int32_t cond_g_q24;            /* input gain, numerator (1 - z^-1)^2 */
+  int32_t cond_a_q28[2];         /* DC blocker and clean HPF poles */
+#endif
+} DspRateCoeffs;
 
-/* Runtime parameters (defaults match previous compile-time constants). */
-static volatile int32_t s_dist_drive_q8 = 40960; /* was const in distortion_process_s24 */
-static volatile int32_t s_delay_mix_q15 = DELAY_MIX_Q15;
-static volatile int32_t s_delay_mix_all_q15 = DELAY_MIX_ALL_Q15;
-static volatile int32_t s_delay_feedback_q15 = DELAY_FEEDBACK_Q15;
-static volatile int32_t s_reverb_mix_q15 = REVERB_MIX_Q15;
-static volatile int32_t s_reverb_mix_all_q15 = REVERB_MIX_ALL_Q15;
-static volatile int32_t s_reverb_feedback_q15 = REVERB_FEEDBACK_Q15;
-static volatile int32_t s_reverb_damp_q15 = REVERB_DAMP_Q15;
+static DspRateCoeffs s_rate;
 
-/* Master output volume (Q15): 0=mute, 32768=unity. */
-static volatile int32_t s_gain_q15 = 32768;
+#if APP_DSP_CLIP && !DSP_USE_ARM_DSP
+/* Stands in for APSR.Q on the host (clip_take()). */
+static uint32_t s_clip_q;
+#define DSP_CLIP_HIT()                 (s_clip_q = 1U)
+#else
+#define DSP_CLIP_HIT()                 ((void)0)
+#endif
 
+/* The 64-bit products below already compile to SMULL/SMLAL on the M4;
+ * the branchy saturations are what the DSP extension replaces.
+ */
 static inline int32_t clamp_s24(int32_t x)
 {
-  if (x > 8388607) return 8388607;
-  if (x < -8388608) return -8388608;
+#if DSP_USE_ARM_DSP
+  return __SSAT(x, 24);
+#else
+  if (x > 8388607) { DSP_CLIP_HIT(); return 8388607; }
+  if (x < -8388608) { DSP_CLIP_HIT(); return -8388608; }
   return x;
+#endif
 }
 
 static inline int32_t gain_s32_q8(int32_t x, int32_t gain_q8)
@@ -136,28 +480,71 @@ static inline int32_t gain_s32_q8(int32_t x, int32_t gain_q8)
   return (int32_t)(((int64_t)x * (int64_t)gain_q8) >> 8);
 }
 
+/* Headroom bounds are on mag_s24(): x at or above 0, -x - 1 below (one EOR
+ * with the sign). clamp_s24() leaves every sample of a block alone exactly
+ * when the block's bound is at most DSP_MAG_S24.
+ */
+#define DSP_MAG_S24                    8388607
+
+static inline int32_t mag_s24(int32_t x)
+{
+  return x ^ (x >> 31);
+}
+
+/* Bound on mag_s24((x * g_q15) >> 15) for mag_s24(x) <= m, g_q15 >= 0.
+ * Unity or less never grows it (the shift floors towards -inf).
+ */
+static inline int32_t mag_gain_q15(int32_t m, int32_t g_q15)
+{
+  if (g_q15 <= 32768)
+  {
+    return m;
+  }
+  const int64_t v = (((((int64_t)m + 1) * g_q15) + 32767) >> 15) - 1;
+  return (v > INT32_MAX) ? INT32_MAX : (int32_t)v;
+}
+
+/* Whether a block with bound m needs its clamps. */
+static inline bool headroom_sat(int32_t m)
+{
+#if DSP_HEADROOM
+  return m > DSP_MAG_S24;
+#else
+  (void)m;
+  return true;
+#endif
+}
+
 static inline int32_t q15_mul(int32_t a, int32_t b)
 {
   return (int32_t)(((int64_t)a * b) >> 15);
 }
 
-static inline int32_t softclip_q15(int32_t xq15)
+/* Top word of a 32 x 32 product: one SMMUL on the M4 (the compilers map
+ * this form to it), where the 64-bit >> 15 of SMULL needs two more
+ * instructions to join the halves.
+ */
+static inline int32_t mul_hi32(int32_t a, int32_t b)
+{
+  return (int32_t)(((int64_t)a * b) >> 32);
+}
+
+/* (x * g_q15) >> 15, bit for bit, through mul_hi32(): x << 8 is the s24
+ * sample in Q31 and g_q15 << 9 moves the product's >> 15 to the top word.
+ * Only for a clamped s24 x and |g_q15| < 2^22.
+ */
+static inline int32_t mul_s24_q15(int32_t x, int32_t g_q15)
 {
-  /* Cubic soft clip: y = x - x^3/3 */
-  int32_t x2 = q15_mul(xq15, xq15);
-  int32_t x3 = q15_mul(x2, xq15);
-  return xq15 - (x3 / 3);
+  return mul_hi32((int32_t)((uint32_t)x << 8), g_q15 * 512);
 }
 
-static inline int32_t input_color_process_s24(int32_t x)
+static inline int32_t input_color_process_s24(int32_t x, const int16_t *curve)
 {
 #if INPUT_COLOR_ENABLE
   int32_t y = gain_s32_q8(x, INPUT_COLOR_DRIVE_Q8);
-  y = clamp_s24(y);
-  int32_t yq15 = y >> 8;
-  yq15 = softclip_q15(yq15);
-  return clamp_s24(yq15 << 8);
+  return AppShaper_S24(curve, clamp_s24(y));
 #else
+  (void)curve;
   return x;
 #endif
 }
@@ -165,16 +552,30 @@ static inline int32_t input_color_process_s24(int32_t x)
 typedef struct
 {
   int32_t gain_q15;
+#if AUDIO_LIMITER_LOOKAHEAD
+  int32_t step_q15;              /* per-frame gain ramp of this sub-block */
+  int32_t peak;                  /* of the sub-block coming in */
+  uint32_t pos;                  /* frame within the sub-block */
+  uint32_t line_idx;
+  uint32_t drain;                /* frames still to play out when idle */
+  /* Monotonic deque of the last LIMITER_LA_SUBS sub-block peaks: values
+   * decrease from head to tail, so the head is the window max.
+   */
+  int32_t dq_peak[LIMITER_LA_SUBS];
+  uint32_t dq_seq[LIMITER_LA_SUBS];
+  uint32_t dq_head;
+  uint32_t dq_len;
+  uint32_t seq;
+  AppStereoS24 line[LIMITER_LA_FRAMES];
+#endif
 } LimiterState;
 
-static LimiterState s_limiter = {32768};
-
 static inline int32_t abs_s32(int32_t x)
 {
   return (x >= 0) ? x : -x;
 }
 
-static inline void limiter_process_s24(int32_t *l, int32_t *r)
+static inline void limiter_process_s24(LimiterState *st, int32_t *l, int32_t *r)
 {
 #if AUDIO_LIMITER_ENABLE
   int32_t a = abs_s32(*l);
@@ -184,37 +585,27 @@ static inline void limiter_process_s24(int32_t *l, int32_t *r)
   int32_t target = 32768;
   if (peak > AUDIO_LIMITER_THRESH_S24)
   {
-    target = (int32_t)(((int64_t)AUDIO_LIMITER_THRESH_S24 << 15) / (int64_t)peak);
-    if (target < 0) target = 0;
+    target = (int32_t)AppTab_DivQ15((uint32_t)AUDIO_LIMITER_THRESH_S24, (uint32_t)peak);
     if (target > 32768) target = 32768;
   }
 
-  int32_t g = s_limiter.gain_q15;
+  int32_t g = st->gain_q15;
   if (target < g)
   {
     g = target; /* instant attack */
   }
   else
   {
-    g += (int32_t)(((int64_t)AUDIO_LIMITER_RELEASE_Q15 * (target - g)) >> 15);
+    g += (int32_t)(((int64_t)s_rate.limiter_release_q15 * (target - g)) >> 15);
     if (g > 32768) g = 32768;
   }
-  s_limiter.gain_q15 = g;
+  st->gain_q15 = g;
 
   *l = clamp_s24((int32_t)(((int64_t)(*l) * g) >> 15));
   *r = clamp_s24((int32_t)(((int64_t)(*r) * g) >> 15));
 #endif
 }
 
-static inline int16_t s24_to_s16(int32_t x)
-{
-  x = clamp_s24(x);
-  x >>= 8;
-  if (x > 32767) return 32767;
-  if (x < -32768) return -32768;
-  return (int16_t)x;
-}
-
 static inline int32_t mix_s24(int32_t dry, int32_t wet, int32_t mix_q15)
 {
   /* mix_q15: 0=dry, 32768=wet */
@@ -222,19 +613,246 @@ static inline int32_t mix_s24(int32_t dry, int32_t wet, int32_t mix_q15)
   return (int32_t)((((int64_t)dry * a) + ((int64_t)wet * mix_q15)) >> 15);
 }
 
+/* Wet/dry mix of a tail FX whose input send is faded: the dry share opens up
+ * as the send closes, the wet (tail) keeps its level. send 32768 is mix_s24().
+ */
+static inline int32_t mix_spill_s24(int32_t dry, int32_t wet, int32_t mix_q15, int32_t send_q15)
+{
+  int32_t a = 32768 - (int32_t)(((int64_t)mix_q15 * send_q15) >> 15);
+  return (int32_t)((((int64_t)dry * a) + ((int64_t)wet * mix_q15)) >> 15);
+}
+
+/* Linear ramp towards a block-rate target. Stepped per sample (ramp_next) or a
+ * block at a time (ramp_skip); the per-frame step is fixed by ramp_set_len().
+ */
 typedef struct
 {
-  int32_t x1;
-  int32_t y1;
+  int32_t cur;
+  int32_t target;
+  int32_t step;
+} DspRamp;
+
+static inline void ramp_set_len(DspRamp *r, int32_t target, int32_t frames)
+{
+  if (target == r->target)
+  {
+    return;
+  }
+  r->target = target;
+  r->step = (target - r->cur) / frames;
+  if (r->step == 0)
+  {
+    r->step = (target > r->cur) ? 1 : -1;
+  }
+}
+
+static inline void ramp_set(DspRamp *r, int32_t target)
+{
+  ramp_set_len(r, target, DSP_XFADE_FRAMES);
+}
+
+static inline int32_t ramp_next(DspRamp *r)
+{
+  int32_t c = r->cur;
+  if (c != r->target)
+  {
+    c += r->step;
+    if (((r->step > 0) && (c > r->target)) || ((r->step < 0) && (c < r->target)))
+    {
+      c = r->target;
+    }
+    r->cur = c;
+  }
+  return c;
+}
+
+static inline int32_t ramp_skip(DspRamp *r, uint32_t n)
+{
+  int32_t c = r->cur;
+  if (c != r->target)
+  {
+    int64_t v = (int64_t)c + ((int64_t)r->step * n);
+    if (((r->step > 0) && (v > r->target)) || ((r->step < 0) && (v < r->target)))
+    {
+      v = r->target;
+    }
+    c = (int32_t)v;
+    r->cur = c;
+  }
+  return c;
+}
+
+static inline void ramp_reset(DspRamp *r, int32_t value)
+{
+  r->cur = value;
+  r->target = value;
+  r->step = 0;
+}
+
+/* Per-FX switching state. send: distortion wet/dry blend or delay/reverb
+ * input send (Q15). quiet counts frames with both input and wet output under
+ * the floor; awake drops once it reaches the FX's hold time. spill: the
+ * tail rings out on the outgoing preset's parameters (DSP_SPILL).
+ */
+typedef struct
+{
+  DspRamp send;
+  uint32_t quiet;
+  uint8_t awake;
+  uint8_t spill;
+} FxFade;
+
+/* Tremolo / auto-pan: gain per side, Q15, ramped to each block's end value. */
+typedef struct
+{
+  AppLfo lfo;
+  uint32_t rate_mhz;
+  DspRamp gain_l;
+  DspRamp gain_r;
+} TremoloState;
+
+static inline int32_t abs_s24(int32_t x)
+{
+  return (x >= 0) ? x : -x;
+}
+
+static inline void fade_track_tail(FxFade *f, const AppStereoS24 *in, int32_t wl, int32_t wr)
+{
+  int32_t a = abs_s24(in->l) | abs_s24(in->r) | abs_s24(wl) | abs_s24(wr);
+  f->quiet = (a < DSP_TAIL_FLOOR_S24) ? (f->quiet + 1U) : 0U;
+}
+
+/* A sleeping tail FX wakes at once if this block has input above the floor.
+ * Returns 0 while it stays asleep.
+ */
+static inline uint8_t fade_wake(FxFade *f, const AppStereoS24 *x, uint32_t n)
+{
+  if (!f->awake)
+  {
+    int32_t a = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+      a |= abs_s24(x[i].l) | abs_s24(x[i].r);
+    }
+    if ((a < DSP_TAIL_FLOOR_S24) || (f->send.target == 0))
+    {
+      return 0u;
+    }
+    f->awake = 1u;
+    f->quiet = 0u;
+  }
+  return 1u;
+}
+
+/* Tail FX input. With headroom tracking the block is clamped here, and only
+ * when its bound says it can hold out-of-range samples; the per-sample dry
+ * clamps (tail_dry_s24) then go. Returns the bound after it.
+ */
+static inline int32_t tail_in_block(AppStereoS24 *x, uint32_t n, int32_t peak)
+{
+#if DSP_HEADROOM
+  if (headroom_sat(peak))
+  {
+    for (uint32_t i = 0; i < n; i++)
+    {
+      x[i].l = clamp_s24(x[i].l);
+      x[i].r = clamp_s24(x[i].r);
+    }
+    return DSP_MAG_S24;
+  }
+#else
+  (void)x;
+  (void)n;
+#endif
+  return peak;
+}
+
+static inline int32_t tail_dry_s24(int32_t x)
+{
+#if DSP_HEADROOM
+  return x;
+#else
+  return clamp_s24(x);
+#endif
+}
+
+/* Sleeping tail FX: the wet path is silent, only the dry level is applied.
+ * That level is at most unity, so the bound carries over.
+ */
+APP_CCM_CODE static void fade_sleep_block(AppStereoS24 *x, uint32_t n, FxFade *f, DspRamp *mix)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t send = ramp_next(&f->send);
+    int32_t m = ramp_next(mix);
+    x[i].l = mix_spill_s24(tail_dry_s24(x[i].l), 0, m, send);
+    x[i].r = mix_spill_s24(tail_dry_s24(x[i].r), 0, m, send);
+  }
+}
+
+/* Filter state word of the kernels below: s24 in the fixed-point build,
+ * float on the s24 scale with APP_DSP_FLOAT.
+ */
+#if APP_DSP_FLOAT
+typedef float DspFilt;
+
+#define DSP_Q15_F(q)                   ((float)(q) * (1.0f / 32768.0f))
+
+/* Truncates towards zero, so a decaying filter ends on 0 like the
+ * leak_q15() rounding below.
+ */
+static inline int32_t dsp_f_to_s24(float v)
+{
+  return clamp_s24((int32_t)v);
+}
+
+/* s24 range saturation where the fixed-point kernel saturates. */
+static inline float dsp_clamp_f(float v)
+{
+  if (v > 8388607.0f) return 8388607.0f;
+  if (v < -8388608.0f) return -8388608.0f;
+  return v;
+}
+#else
+typedef int32_t DspFilt;
+#endif
+
+typedef struct
+{
+  DspFilt x1;
+  DspFilt y1;
 } DcBlockState;
 
-static DcBlockState s_dc_l = {0, 0};
-static DcBlockState s_dc_r = {0, 0};
+/* R*y for the HPF feedback, rounded towards zero: a floored product keeps a
+ * silent input parked at y = -1 (then amplified by the compressor and the
+ * makeup gain) instead of letting it decay to 0.
+ */
+#if APP_DSP_FLOAT
+static inline int32_t hpf1_s24(DcBlockState *st, int32_t x, int32_t r_q15)
+{
+  /* 1st order HPF: y[n] = x[n] - x[n-1] + R*y[n-1] */
+  const float xf = (float)x;
+  const float y = (xf - st->x1) + (DSP_Q15_F(r_q15) * st->y1);
+  st->x1 = xf;
+  st->y1 = y;
+  return dsp_f_to_s24(y);
+}
+
+static inline int32_t dc_block_s24(DcBlockState *st, int32_t x)
+{
+  return hpf1_s24(st, x, s_rate.dc_r_q15);
+}
+#else
+static inline int32_t leak_q15(int32_t r_q15, int32_t y)
+{
+  int64_t v = (int64_t)r_q15 * y;
+  return (int32_t)((v + ((v < 0) ? 32767 : 0)) >> 15);
+}
 
 static inline int32_t dc_block_s24(DcBlockState *st, int32_t x)
 {
-  const int32_t r_q15 = 32684; /* ~0.997 at 48 kHz (~20 Hz corner) */
-  int32_t y = x - st->x1 + (int32_t)(((int64_t)r_q15 * st->y1) >> 15);
+  const int32_t r_q15 = s_rate.dc_r_q15;
+  int32_t y = x - st->x1 + leak_q15(r_q15, st->y1);
   st->x1 = x;
   st->y1 = y;
   return clamp_s24(y);
@@ -243,30 +861,61 @@ static inline int32_t dc_block_s24(DcBlockState *st, int32_t x)
 static inline int32_t hpf1_s24(DcBlockState *st, int32_t x, int32_t r_q15)
 {
   /* 1st order HPF: y[n] = x[n] - x[n-1] + R*y[n-1] */
-  int32_t y = x - st->x1 + (int32_t)(((int64_t)r_q15 * st->y1) >> 15);
+  int32_t y = x - st->x1 + leak_q15(r_q15, st->y1);
   st->x1 = x;
   st->y1 = y;
   return clamp_s24(y);
 }
-
-static DcBlockState s_clean_hpf_l = {0, 0};
-static DcBlockState s_clean_hpf_r = {0, 0};
-
-static DcBlockState s_wet_hpf_delay_l = {0, 0};
-static DcBlockState s_wet_hpf_delay_r = {0, 0};
-static DcBlockState s_wet_hpf_reverb_l = {0, 0};
-static DcBlockState s_wet_hpf_reverb_r = {0, 0};
+#endif
 
 typedef struct
 {
   int32_t env;
   int32_t gain_q15;
+  int32_t target_q15;            /* gain computer output, per sub-block */
 } CompState;
 
-static CompState s_comp_l = {0, 32768};
-static CompState s_comp_r = {0, 32768};
+/* Compressor curve in the log2 domain: levels are octaves re s24 full scale
+ * in Q16, derived from the comp_* params when they are set.
+ */
+typedef struct
+{
+  int32_t thresh_l2;
+  int32_t slope_q15;             /* 1 - 1/ratio */
+  int32_t knee_l2;               /* knee width, 0 = hard */
+  uint32_t knee_inv;             /* 2^32 / (2 * knee_l2) */
+  int32_t makeup_q12;
+} CompCurve;
+
+#define COMP_SLOPE_Q15(ratio_x10)      (32768 - (327680 / (ratio_x10)))
+#define COMP_KNEE_INV(knee_l2)         (((knee_l2) > 0) ? (0x80000000u / (uint32_t)(knee_l2)) : 0u)
+
+/* Static curve: no gain change below the knee, 'slope' octaves of
+ * reduction per octave over the threshold above it, and a quadratic blend
+ * across the knee width.
+ */
+static inline int32_t comp_target_q15(int32_t env, const CompCurve *k)
+{
+  if (env <= 0)
+  {
+    return 32768;
+  }
+  const int32_t over = AppTab_Log2(env) - k->thresh_l2;
+  const int32_t half = k->knee_l2 >> 1;
+  if (over <= -half)
+  {
+    return 32768;
+  }
+  int32_t red = over;
+  if (over < half)
+  {
+    const int64_t d = (int64_t)over + half;
+    red = (int32_t)(((d * d) * (int64_t)k->knee_inv) >> 32);
+  }
+  return AppTab_Exp2(-(int32_t)(((int64_t)red * k->slope_q15) >> 15));
+}
 
-static inline void clean_comp_process_one_s24(CompState *st, int32_t *x_s24)
+static inline void clean_comp_process_one_s24(CompState *st, int32_t *x_s24, int32_t makeup_q12)
 {
 #if CLEAN_COMP_ENABLE
   int32_t x = abs_s32(*x_s24);
@@ -274,47 +923,41 @@ static inline void clean_comp_process_one_s24(CompState *st, int32_t *x_s24)
   /* Envelope follower. */
   int32_t env = st->env;
   int32_t diff = x - env;
-  int32_t k_env = (diff > 0) ? CLEAN_COMP_ENV_ATTACK_Q15 : CLEAN_COMP_ENV_RELEASE_Q15;
+  int32_t k_env = (diff > 0) ? s_rate.comp_env_attack_q15 : s_rate.comp_env_release_q15;
   env += (int32_t)(((int64_t)k_env * (int64_t)diff) >> 15);
   if (env < 0) env = 0;
   st->env = env;
 
-  /* Compute target gain.
-   * If env <= threshold: unity.
-   * Else: output_env = thresh + (env - thresh)/ratio.
-   * gain = output_env / env.
-   */
-  int32_t target_gain_q15 = 32768;
-  if (env > CLEAN_COMP_THRESH_S24)
-  {
-    int32_t over = env - CLEAN_COMP_THRESH_S24;
-    int32_t out_env = CLEAN_COMP_THRESH_S24 + (over / CLEAN_COMP_RATIO);
-    target_gain_q15 = (int32_t)(((int64_t)out_env << 15) / (int64_t)env);
-    if (target_gain_q15 < 0) target_gain_q15 = 0;
-    if (target_gain_q15 > 32768) target_gain_q15 = 32768;
-  }
-
   /* Smooth gain changes to avoid pumping. */
   int32_t g = st->gain_q15;
-  int32_t gd = target_gain_q15 - g;
-  int32_t k_g = (gd < 0) ? CLEAN_COMP_GAIN_ATTACK_Q15 : CLEAN_COMP_GAIN_RELEASE_Q15;
+  int32_t gd = st->target_q15 - g;
+  int32_t k_g = (gd < 0) ? s_rate.comp_gain_attack_q15 : s_rate.comp_gain_release_q15;
   g += (int32_t)(((int64_t)k_g * (int64_t)gd) >> 15);
   if (g < 0) g = 0;
   if (g > 32768) g = 32768;
   st->gain_q15 = g;
 
-  *x_s24 = clamp_s24((int32_t)(((int64_t)(*x_s24) * (int64_t)g) >> 15));
+  /* Makeup after the smoother, so the meters report the reduction only. */
+  const int32_t gm = (int32_t)(((int64_t)g * makeup_q12) >> 12);
+  *x_s24 = clamp_s24((int32_t)(((int64_t)(*x_s24) * (int64_t)gm) >> 15));
+#else
+  (void)st;
+  (void)x_s24;
+  (void)makeup_q12;
 #endif
 }
 
-static inline void clean_comp_process_s24(int32_t *l, int32_t *r)
+/* One halfband x2 up/down pair; the rings advance once per low-rate sample
+ * (up) and once per output sample (down).
+ */
+typedef struct
 {
-#if CLEAN_COMP_ENABLE
-  /* Dual-mono: compress each input independently (no cross-ducking). */
-  clean_comp_process_one_s24(&s_comp_l, l);
-  clean_comp_process_one_s24(&s_comp_r, r);
-#endif
-}
+  int32_t up[DIST_HB_MASK + 1U];
+  int32_t dn_a[DIST_HB_MASK + 1U];
+  int32_t dn_b[DIST_HB_MASK + 1U];
+  uint32_t up_idx;
+  uint32_t dn_idx;
+} DistHbState;
 
 typedef struct
 {
@@ -322,539 +965,7382 @@ typedef struct
   int32_t hp_y1;
   int32_t lp_y1;
   int32_t os_x1;
+  int32_t crush_y;   /* sample the crush model holds */
+  uint32_t crush_n;  /* samples it still holds it */
+  DistHbState hb1;   /* 1x <-> 2x */
+  DistHbState hb2;   /* 2x <-> 4x */
 } DistState;
 
-static DistState s_dist_l = {0, 0, 0, 0};
-static DistState s_dist_r = {0, 0, 0, 0};
+static const int32_t k_dist_hb1_q15[DIST_HB1_TAPS] = {10055, -2497, 766, -132};
+static const int32_t k_dist_hb2_q15[DIST_HB2_TAPS] = {9216, -1024};
 
-static int32_t s_reverb_delay_l[REVERB_DELAY_LEN];
-static int32_t s_reverb_delay_r[REVERB_DELAY_LEN];
-static int32_t s_reverb_ap_l[REVERB_AP_LEN];
-static int32_t s_reverb_ap_r[REVERB_AP_LEN];
-static uint32_t s_reverb_delay_idx_l = 0;
-static uint32_t s_reverb_delay_idx_r = 0;
-static uint32_t s_reverb_ap1_idx_l = 0;
-static uint32_t s_reverb_ap1_idx_r = 0;
-static uint32_t s_reverb_ap2_idx_l = 0;
-static uint32_t s_reverb_ap2_idx_r = 0;
-static int32_t s_reverb_lp_l = 0;
-static int32_t s_reverb_lp_r = 0;
-static uint32_t s_reverb_lfo_l = 0;
-static uint32_t s_reverb_lfo_r = 0;
-
-static int16_t s_delay_buf_l[DELAY_LEN];
-static int16_t s_delay_buf_r[DELAY_LEN];
+/* All four FDN lines live back to back in one mono-sample buffer, in both
+ * the stereo and the mono-input build (the tank is fed L and R on alternate
+ * lines, see reverb_process_s24()). REVERB_FDN_BYTES from the FX arena.
+ */
+static uint32_t *s_reverb_fdn;
+typedef struct
+{
+  DspFilt l;
+  DspFilt r;
+} DspFiltStereo;
+
+static DspFiltStereo *s_reverb_ap;   /* REVERB_AP_BYTES from the FX arena, with the tank */
+
+_Static_assert((REVERB_AP_STAGES >= 2U) && (REVERB_AP_STAGES <= 6U), "APP_DSP_REVERB_AP_STAGES must be 2..6");
+static const uint16_t k_reverb_ap_len[6] = {67U, 61U, 43U, 37U, 29U, 23U};
+static const uint16_t k_reverb_ap_base[6] = {0U, 67U, 128U, 171U, 208U, 237U};
+
+static const uint32_t k_reverb_fdn_len[REVERB_FDN_LINES] = {
+  REVERB_FDN_LEN0, REVERB_FDN_LEN1, REVERB_FDN_LEN2, REVERB_FDN_LEN3
+};
+
+static const uint32_t k_reverb_fdn_base[REVERB_FDN_LINES] = {
+  0U,
+  REVERB_FDN_LEN0,
+  REVERB_FDN_LEN0 + REVERB_FDN_LEN1,
+  REVERB_FDN_LEN0 + REVERB_FDN_LEN1 + REVERB_FDN_LEN2
+};
+
+/* Early reflections (reverb_room): sparse taps on the tank's own lines,
+ * which hold the input for a full line length before any recirculated
+ * energy dominates, so they cost no memory. A tap sits 'pos' / 256 of its
+ * line behind the write index, which scales each room with the tank (the
+ * RAM tier); each side reads mostly its own lines (L feeds 0/2, R 1/3) and
+ * one crossed tap. The taps skip the diffuser and add to its output.
+ */
+#define REVERB_ER_TAPS                 4U
+#define REVERB_ER_TAP(k, pos, g)       {(k), (uint16_t)((REVERB_FDN_LEN##k * (pos)) / 256U), (g)}
 
 typedef struct
 {
-  uint32_t idx;
-  uint8_t phase;
-  int32_t last_out_s24;
-  int32_t fb_lp_s24;
-} DelayState;
+  uint16_t line;
+  uint16_t dist;                 /* samples behind the write index, 1..len - 1 */
+  int32_t gain_q15;
+} ReverbErTap;
+
+/* [room - 1][side][tap]: gains fall ~2.5 dB per tap with alternating sign. */
+static const ReverbErTap k_reverb_er[APP_DSP_REVERB_ROOM_COUNT - 1U][2][REVERB_ER_TAPS] = {
+  [APP_DSP_REVERB_ROOM_SMALL - 1U] = {
+    {REVERB_ER_TAP(0, 22, 15000), REVERB_ER_TAP(2, 41, -11200), REVERB_ER_TAP(1, 63, 8400),
+     REVERB_ER_TAP(0, 90, -6300)},
+    {REVERB_ER_TAP(1, 27, 15000), REVERB_ER_TAP(3, 36, -11200), REVERB_ER_TAP(0, 71, 8400),
+     REVERB_ER_TAP(3, 84, -6300)},
+  },
+  [APP_DSP_REVERB_ROOM_MEDIUM - 1U] = {
+    {REVERB_ER_TAP(0, 40, 14000), REVERB_ER_TAP(2, 66, -10500), REVERB_ER_TAP(1, 103, 7900),
+     REVERB_ER_TAP(2, 151, -5900)},
+    {REVERB_ER_TAP(1, 47, 14000), REVERB_ER_TAP(3, 61, -10500), REVERB_ER_TAP(0, 118, 7900),
+     REVERB_ER_TAP(3, 139, -5900)},
+  },
+  [APP_DSP_REVERB_ROOM_LARGE - 1U] = {
+    {REVERB_ER_TAP(0, 71, 13000), REVERB_ER_TAP(2, 109, -9800), REVERB_ER_TAP(1, 163, 7300),
+     REVERB_ER_TAP(2, 232, -5500)},
+    {REVERB_ER_TAP(1, 80, 13000), REVERB_ER_TAP(3, 98, -9800), REVERB_ER_TAP(0, 187, 7300),
+     REVERB_ER_TAP(3, 221, -5500)},
+  },
+};
+
+/* FDN read modulation (APP_DSP_REVERB_MOD_SAMPLES): the four lines swing
+ * in quadrature (+sin, -sin, +cos, -cos) by up to twice the depth towards
+ * newer samples, off one shared LFO segment per block.
+ */
+#define REVERB_MOD_ENABLE              (APP_DSP_REVERB_MOD_SAMPLES > 0U)
+#if APP_DSP_REVERB_HALF_RATE
+#define REVERB_FS_HZ                   (DSP_SAMPLE_RATE_HZ / 2U)
+#define REVERB_STEPS(n)                ((n) / 2U)
+#else
+#define REVERB_FS_HZ                   DSP_SAMPLE_RATE_HZ
+#define REVERB_STEPS(n)                (n)
+#endif
 
-static DelayState s_delay_l = {0, 0, 0, 0};
-static DelayState s_delay_r = {0, 0, 0, 0};
+typedef struct
+{
+  uint32_t idx[REVERB_FDN_LINES];
+  DspFilt lp[REVERB_FDN_LINES];
+  uint32_t ap_idx[REVERB_AP_STAGES];
+#if REVERB_MOD_ENABLE
+  AppLfoSeg mod;
+#endif
+} ReverbState;
 
-static int32_t s_wet_lpf_delay_l = 0;
-static int32_t s_wet_lpf_delay_r = 0;
-static int32_t s_wet_lpf_reverb_l = 0;
-static int32_t s_wet_lpf_reverb_r = 0;
+#if APP_DSP_REVERB_HALF_RATE
+/* Halfband side taps in Q15 (centre tap 0.5), outermost last. */
+static const int32_t k_reverb_hb_q15[REVERB_HB_TAPS] = {10154, -2697, 992, -300, 43};
 
-static inline int32_t hard_tube_clip_s24(int32_t x)
+/* Frames come in pairs: the first is held until the second arrives,
+ * then one half-rate frame runs through the reverb and the interpolator yields
+ * two outputs, the second held for the next frame. The three histories share
+ * one index, advanced once per pair.
+ */
+typedef struct
 {
-  const int32_t thr_pos = 1200000;
-  const int32_t thr_neg = 900000;
+  AppStereoS24 dec_a[REVERB_HB_MASK + 1U];  /* first frame of each pair */
+  AppStereoS24 dec_b[REVERB_HB_MASK + 1U];  /* second frame of each pair */
+  AppStereoS24 wet[REVERB_HB_MASK + 1U];    /* half-rate reverb output */
+  AppStereoS24 held_in;
+  AppStereoS24 held_out;
+  uint32_t idx;
+  uint32_t phase;
+} ReverbHalfState;
+#endif
 
-  if (x > thr_pos)
-  {
-    int32_t over = x - thr_pos;
-    return thr_pos + (over >> 10);
-  }
-  if (x < -thr_neg)
-  {
-    int32_t over = x + thr_neg;
-    return -thr_neg + (over >> 10);
-  }
-  return x;
-}
+#if APP_DSP_SPRING_ENABLE
+/* Spring (reverb_type spring): one spring as a loop of a modulated delay
+ * and a cascade of first-order allpasses. Their dispersion delays the lows
+ * more than the highs, so every pass smears a transient into the falling
+ * "drip" chirp, and each repeat smears it further. The spring runs at 1/4
+ * of the reverb rate (12 kHz, about a real tank's bandwidth), in chunks of
+ * SPRING_CHUNK samples with each stage over the whole chunk, one chunk
+ * behind. Its line is the head of the FDN buffer, which it has to itself,
+ * and its state (spring_state()) follows the line there: switching the
+ * type clears the buffer like an arena handoff, and a cleared state is a
+ * reset one.
+ */
+#define SPRING_DECIM                   4U
+#define SPRING_FS_HZ                   (REVERB_FS_HZ / SPRING_DECIM)
+#define SPRING_FIR_TAPS                16U
+#define SPRING_CHUNK                   8U
+#define SPRING_STAGES                  64U          /* the cost: ~60% of the FDN's per frame */
+#define SPRING_AP_Q15                  (-20316)     /* -0.62: ~4 samples of delay at DC, 0.23 at Nyquist */
+#define SPRING_DELAY_MS                38U
+#define SPRING_DELAY                   ((SPRING_FS_HZ * SPRING_DELAY_MS) / 1000U)
+#define SPRING_MOD_DEPTH_Q16           (3U << 15)   /* swing of +-1.5 samples */
+#define SPRING_LINE_LEN                (SPRING_DELAY + 4U)
+#define SPRING_MOD_INC                 ((uint32_t)((((uint64_t)900U << 32) * SPRING_CHUNK) / (1000ULL * SPRING_FS_HZ)))
+#define SPRING_LPF_Q15                 27500        /* loop lowpass, ~3.5 kHz */
+
+_Static_assert(SPRING_LINE_LEN <= REVERB_FDN_TOTAL, "the spring line must fit the FDN buffer");
+
+/* 4x decimator and interpolator, Kaiser (beta 5) windowed sinc, fc
+ * 4.8 kHz at 48 kHz (-6.5 dB at 5 kHz, -22 dB at 8 kHz); every phase sums
+ * to 8192.
+ */
+static const int32_t k_spring_fir_q15[SPRING_FIR_TAPS] = {
+  -52, -158, -148, 302, 1466, 3282, 5216, 6476, 6476, 5216, 3282, 1466, 302, -148, -158, -52
+};
 
-static inline int32_t onepole_lpf_s24(int32_t x, int32_t *st, int32_t a_q15)
+typedef struct
 {
-  int32_t y = *st;
-  y += (int32_t)(((int64_t)a_q15 * (int64_t)(x - y)) >> 15);
-  y = clamp_s24(y);
-  *st = y;
-  return y;
+  int32_t x1;
+  int32_t y1;
+} SpringApState;
+
+typedef struct
+{
+  int32_t hist[SPRING_FIR_TAPS];  /* reverb-rate input ring, newest at hidx */
+  int32_t out[SPRING_DECIM];      /* spring-rate output, newest first */
+  int32_t chunk_in[SPRING_CHUNK];
+  int32_t chunk_out[SPRING_CHUNK];
+  uint32_t hidx;
+  uint32_t phase;                 /* reverb frames since the last spring sample */
+  uint32_t pos;                   /* spring samples into the chunk */
+  uint32_t idx;                   /* line write index */
+  uint32_t mod_phase;
+  int32_t lp;
+  SpringApState ap[SPRING_STAGES];
+} SpringState;
+
+#define SPRING_LINE_WORDS              APP_DLINE_WORDS(SPRING_LINE_LEN, 1U, APP_DSP_REVERB_STORAGE)
+_Static_assert(((SPRING_LINE_WORDS * 4U) + sizeof(SpringState)) <= REVERB_FDN_BYTES,
+               "the spring's line and state must fit the FDN buffer");
+#endif
+
+/* Both channels share one write index and decimation phase, so the delay
+ * line stores L/R of a step together (one word per tap in S16).
+ * In CCM builds a line up to the default 4 KB stays in CCM; a larger one
+ * leaves CCM to the code and reverb AP and, like every line in SRAM, comes
+ * from the FX arena.
+ */
+#define DELAY_IN_ARENA                 (!APP_USE_CCM || (DELAY_BYTES > 4096U))
+#if DELAY_IN_ARENA
+static uint32_t *s_delay_buf;
+#else
+APP_CCM_BSS static uint32_t s_delay_buf[DELAY_WORDS];
+#endif
+
+/* FX arena: the large FX buffers in SRAM, carved from one pool at init.
+ * The delay, chorus and pitch lines first, then an overlay of the reverb
+ * tank and the cab IR line (APP_CABIR_ENABLE), which take turns
+ * (arena_handoff()).
+ * The pool is exactly the layout; each further overlay member only costs
+ * what it adds over the largest one.
+ */
+#define DSP_ARENA_DELAY_BYTES          (DELAY_IN_ARENA ? APP_ARENA_ALIGN(DELAY_BYTES) : 0U)
+#define DSP_ARENA_CHORUS_BYTES         APP_ARENA_ALIGN(CHORUS_BYTES)
+#define DSP_ARENA_PITCH_BYTES          APP_ARENA_ALIGN(PITCH_BYTES)
+#define DSP_ARENA_REVERB_BYTES         (APP_ARENA_ALIGN(REVERB_FDN_BYTES) + APP_ARENA_ALIGN(REVERB_AP_BYTES))
+#define DSP_ARENA_CABIR_BYTES          (CABSIM_IR ? APP_ARENA_ALIGN(APP_CABIR_FDL_BYTES) : 0U)
+#define DSP_ARENA_BYTES                (DSP_ARENA_DELAY_BYTES + DSP_ARENA_CHORUS_BYTES + DSP_ARENA_PITCH_BYTES + \
+                                        ((DSP_ARENA_REVERB_BYTES > DSP_ARENA_CABIR_BYTES) ? \
+                                         DSP_ARENA_REVERB_BYTES : DSP_ARENA_CABIR_BYTES))
+
+static uint64_t s_fx_arena_pool[DSP_ARENA_BYTES / 8U];
+static AppArena s_fx_arena;
+#if APP_DSP_CHORUS_ENABLE
+static uint32_t *s_chorus_buf;
+#endif
+#if APP_DSP_PITCH_ENABLE
+static uint32_t *s_pitch_buf;
+#endif
+#if CABSIM_IR
+static void *s_cabir_fdl;
+static uint8_t s_arena_reverb;   /* the tank has the overlay (audio side) */
+#endif
+
+/* Kaiser (beta 5) windowed-sinc low-pass, fc 2.4 kHz at 48 kHz, Q15:
+ * k_delay_rs_q15[j][p] = h[8j + p]. Symmetric, and every polyphase column
+ * sums to 4096 so both directions have exactly unity DC gain.
+ * Passband -0.9 dB at 1 kHz; images/aliases above 6 kHz < -50 dB.
+ */
+static const int32_t k_delay_rs_q15[DELAY_RS_ROWS][DELAY_DECIM] = {
+  {  -17,   -15,    29,   148,   374,   726,  1199,  1764},
+  { 2349,  2912,  3341,  3574,  3574,  3341,  2912,  2349},
+  { 1764,  1199,   726,   374,   148,    29,   -15,   -17},
+};
+
+typedef struct
+{
+  uint32_t idx;
+  uint32_t delay_q16;  /* smoothed read distance, Q16 line steps */
+  uint8_t phase;
+  int32_t last_out_l_s24;
+  int32_t last_out_r_s24;
+  DspFilt fb_lp_l;
+  DspFilt fb_lp_r;
+  /* Decimator partial sums for the current and next two line steps. */
+  int64_t dec_l[DELAY_RS_ROWS];
+  int64_t dec_r[DELAY_RS_ROWS];
+  /* Last line taps read, newest first, for the interpolator. */
+  AppStereoS24 hist[DELAY_RS_ROWS];
+  uint32_t rev_phase;  /* steps into the reverse window (DELAY_REVERSE) */
+} DelayState;
+
+/* Looper line: one mono step per DELAY_DECIM frames. The block is worked in
+ * chunks of LOOP_CHUNK_FRAMES: decimate, then read / overdub / write the
+ * chunk's steps on the line in one pass, then interpolate. req is written by
+ * the control side only (seq << 8 | AppDspLoopCmd), everything else by the
+ * audio side once the buffer is set.
+ */
+#define LOOP_CHUNK_FRAMES              64U
+#define LOOP_CHUNK_STEPS               (LOOP_CHUNK_FRAMES / DELAY_DECIM)
+
+typedef struct
+{
+  uint32_t *buf;
+  uint32_t cap;                  /* steps the buffer holds */
+  uint32_t bytes;
+  volatile AppDspLoopState state;
+  volatile uint32_t len;         /* loop length in steps (growing while recording) */
+  volatile uint32_t pos;
+  uint32_t req_seen;
+  uint8_t phase;
+  int64_t dec[DELAY_RS_ROWS];
+  int32_t hist[DELAY_RS_ROWS];
+  DspRamp gain;                  /* playback level, fades on play / stop */
+} LoopState;
+
+static LoopState s_loop;
+static volatile uint32_t s_loop_req;
+
+/* Recording, overdubbing, or playing (a stopped loop while it fades). */
+static inline bool loop_busy(void)
+{
+  return (s_loop.state == APP_DSP_LOOP_RECORD) || (s_loop.state == APP_DSP_LOOP_OVERDUB) ||
+         (s_loop.gain.cur != 0) || (s_loop.gain.target != 0);
+}
+
+typedef struct
+{
+  AppDspDelayTap tap[APP_DSP_DELAY_TAPS_MAX];
+  uint8_t cross;    /* ping-pong feedback */
+  uint8_t reverse;  /* output from delay_reverse_s24() instead of the taps */
+} DelayPattern;
+
+static const DelayPattern k_delay_patterns[APP_DSP_DELAY_PATTERN_COUNT] = {
+  /* SINGLE */   {{{4096, 16384, 32768}, {0, 16384, 0}, {0, 16384, 0}, {0, 16384, 0}}, 0, 0},
+  /* PINGPONG */ {{{4096, 16384, 32768}, {0, 16384, 0}, {0, 16384, 0}, {0, 16384, 0}}, 1, 0},
+  /* DOTTED */   {{{3072,  6554, 22938}, {4096, 26214, 32768}, {0, 16384, 0}, {0, 16384, 0}}, 0, 0},
+  /* QUAD */     {{{1024,  4096, 13107}, {2048, 28672, 19661}, {3072, 8192, 26214}, {4096, 24576, 32768}}, 0, 0},
+  /* REVERSE */  {{{4096, 16384, 32768}, {0, 16384, 0}, {0, 16384, 0}, {0, 16384, 0}}, 0, 1},
+};
+
+/* Mono input keeps its stereo delay image through ping-pong by default. */
+#if APP_DSP_MONO_INPUT
+#define DELAY_PATTERN_DEFAULT          APP_DSP_DELAY_PINGPONG
+#else
+#define DELAY_PATTERN_DEFAULT          APP_DSP_DELAY_SINGLE
+#endif
+
+/* State types of the modules a build may leave out. */
+#if APP_DSP_CHORUS_ENABLE
+#define DSP_CHORUS_STATE               ChorusFxState
+#else
+#define DSP_CHORUS_STATE               DspFxNoState
+#endif
+#if APP_DSP_PITCH_ENABLE
+#define DSP_PITCH_STATE                PitchFxState
+#else
+#define DSP_PITCH_STATE                DspFxNoState
+#endif
+
+/* The FX modules, in default chain order: X(state member, descriptor, state
+ * type, cycles). A new effect is one line here plus its descriptor (FX
+ * modules below); the chain compiler and the state block follow the list.
+ * cycles is the module's declared worst case per stereo frame on the M4 at
+ * -O3 from CCM (its BENCH KERNEL stage with every parameter at its most
+ * expensive), checked against the frame below (DSP_CHAIN_CYCLES).
+ */
+#define DSP_FX_REGISTRY(X) \
+  X(wah,        k_fx_wah,        WahFxState,    90U) \
+  X(pitch,      k_fx_pitch,      DSP_PITCH_STATE, (APP_DSP_PITCH_ENABLE ? 300U : 0U)) \
+  X(distortion, k_fx_distortion, DistFxState,   DIST_CYC_FRAME_MAX) \
+  X(eq,         k_fx_eq,         DspFxNoState,  120U) \
+  X(phaser,     k_fx_phaser,     PhaserFxState, 160U) \
+  X(chorus,     k_fx_chorus,     DSP_CHORUS_STATE, (APP_DSP_CHORUS_ENABLE ? 120U : 0U)) \
+  X(delay,      k_fx_delay,      DelayFxState,  100U) \
+  X(reverb,     k_fx_reverb,     ReverbFxState, (APP_DSP_REVERB_HALF_RATE ? 240U : 420U))
+
+typedef enum
+{
+#define DSP_FX_ID(m, d, T, c) DSP_FX_##m,
+  DSP_FX_REGISTRY(DSP_FX_ID)
+#undef DSP_FX_ID
+  DSP_FX_COUNT
+} DspFxId;
+
+/* One schedule per AppFxMask value. Without the chorus its bit never
+ * runs, so a mask with it shares the slot of the one without
+ * (chain_slot()).
+ */
+#define DSP_CHAIN_COUNT                32u
+#define DSP_SCHED_SLOTS                (APP_DSP_CHORUS_ENABLE ? DSP_CHAIN_COUNT : (DSP_CHAIN_COUNT / 2u))
+#define DSP_SLOT_LOW                   ((uint32_t)APP_FX_BIT_CHORUS - 1u)   /* the mask bits below the chorus's */
+
+/* Steps of one mask's schedule at most: per module its call, its tap and
+ * two routing steps, which also covers the split and the mono copy. A
+ * module left out of the build (chorus, pitch) adds none.
+ */
+#define DSP_FX_BUILT                   (DSP_FX_COUNT - (APP_DSP_CHORUS_ENABLE ? 0u : 1u) - \
+                                        (APP_DSP_PITCH_ENABLE ? 0u : 1u))
+#define DSP_SCHED_STEPS                (4u * DSP_FX_BUILT)
+
+/* The FX chain compiled for the audio path (chain_compile()): for each run
+ * mask, the steps to execute in order, as indices into a context's
+ * steps[]. The main loop builds it into the bank the front parameters do
+ * not use and publishes it with them. Every context runs the same one.
+ */
+typedef struct
+{
+  uint8_t count[DSP_SCHED_SLOTS];
+  uint8_t step[DSP_SCHED_SLOTS][DSP_SCHED_STEPS];
+  uint8_t bus;                   /* has a parallel group: uses the buses */
+  uint32_t island;               /* bit s: slot s may open the island (DSP_STEP_ISLAND) */
+  uint16_t lead[DSP_SCHED_SLOTS];  /* bit i: DspFxId i runs ahead of it, so must be idle */
+} DspSchedule;
+
+static inline uint32_t chain_slot(AppFxMask m)
+{
+  return APP_DSP_CHORUS_ENABLE ? m : ((m & DSP_SLOT_LOW) | ((m >> 1) & ~DSP_SLOT_LOW));
+}
+
+/* The mask a slot is compiled for, the chorus bit clear. */
+static inline AppFxMask chain_slot_mask(uint32_t slot)
+{
+  return APP_DSP_CHORUS_ENABLE ? slot : ((slot & DSP_SLOT_LOW) | ((slot & ~DSP_SLOT_LOW) << 1));
+}
+
+/* One bank per parameter copy: the front one, the queued ones and the edit. */
+#define DSP_PARAM_COPIES (2u + APP_DSP_PARAM_EVENTS)
+
+static DspSchedule s_sched[DSP_PARAM_COPIES];   /* s_sched[0] starts empty: no FX before init */
+
+/* Runtime parameters, written by the control side only (main loop).
+ *
+ * AppDsp_SetParam()/AppDsp_SetDelayTap()/AppDsp_SetFxMask() edit the back
+ * copy and publish it with one pointer store; the audio path picks its chain
+ * from the front one and copies it into DspBlockParams at the start of a
+ * block. A batch (AppDsp_BeginParams() .. AppDsp_CommitParams()) therefore
+ * lands in one block as a whole, FX mask included. The audio
+ * ISR only ever reads the front copy and the main loop only edits the back
+ * one, so neither needs a lock.
+ *
+ * A timed commit (AppDsp_CommitParamsAt()) queues its copy instead, with
+ * the frame it is due at; AppDsp_ProcessBlock() stores the front pointer
+ * there. The queue is single-producer single-consumer: the main loop fills
+ * an entry before it moves the head, the audio path stores the front before
+ * it moves the tail.
+ */
+typedef struct
+{
+  AppFxMask fx_mask;             /* selects the FX schedule (sched) */
+  uint8_t chain[DSP_FX_COUNT];   /* DspFxId in chain order */
+  uint8_t chain_par;             /* bit i: chain[i] is parallel to chain[i - 1] */
+  uint8_t chain_bus;             /* bit i: ... and shares its wet bus ('+', implies chain_par) */
+  const DspSchedule *sched;      /* compiled from chain[] when published */
+  int32_t dist_drive_q8;
+  uint32_t dist_os;
+  uint32_t dist_curve;
+  uint32_t dist_model;           /* AppDspDistModel */
+  uint32_t color_curve;
+  int32_t delay_mix_q15;
+  int32_t delay_feedback_q15;
+  int32_t delay_duck_q15;
+  uint32_t delay_steps;          /* line steps of DELAY_DECIM samples */
+  uint32_t delay_pattern_id;
+  DelayPattern delay_pattern;    /* loaded from k_delay_patterns in AppDsp_Init() */
+  int32_t reverb_mix_q15;
+  int32_t reverb_mix_all_q15;
+  int32_t reverb_feedback_q15;
+  int32_t reverb_damp_q15;
+  uint32_t reverb_decay_ms;      /* RT60, 0 = reverb_feedback_q15 on every line */
+  uint32_t reverb_hf_damp_hz;    /* 0 = reverb_damp_q15 on every line */
+  int32_t reverb_line_fb_q15[REVERB_FDN_LINES];    /* from the above in AppDsp_SetParam() */
+  int32_t reverb_line_damp_q15[REVERB_FDN_LINES];
+  uint32_t reverb_room;          /* AppDspReverbRoom */
+  uint32_t reverb_type;          /* AppDspReverbType */
+  uint32_t reverb_diffusion;     /* diffuser stages */
+  int32_t reverb_spring_fb_q15;  /* from reverb_decay_ms or reverb_feedback_q15 */
+  int32_t reverb_er_q15;
+  uint32_t reverb_freeze;        /* 1 = unity feedback, undamped, input shut */
+  int32_t chorus_mix_q15;
+  uint32_t chorus_rate_mhz;
+  int32_t chorus_depth_q15;
+  uint32_t chorus_time_us;
+  uint32_t chorus_time_q16;      /* centre distance, Q16 line steps (from chorus_time_us) */
+  int32_t chorus_feedback_q15;
+  uint32_t chorus_spread_deg;
+  int32_t phaser_mix_q15;
+  uint32_t phaser_rate_mhz;
+  int32_t phaser_depth_q15;
+  uint32_t phaser_freq_hz;
+  uint32_t phaser_w0_q20;        /* bottom of the sweep, pi * f / fs in Q20 (from phaser_freq_hz) */
+  uint32_t phaser_stages;
+  uint32_t phaser_spread_deg;
+  int32_t tremolo_depth_q15;
+  int32_t tremolo_pan_q15;
+  uint32_t tremolo_div;
+  uint32_t tempo_bpm;
+  uint32_t tremolo_rate_mhz;     /* from tempo_bpm and tremolo_div */
+  uint32_t delay_sync;           /* AppDspSyncDiv: delay_steps from tempo_bpm */
+  uint32_t chorus_sync;          /* ... chorus_rate_mhz */
+  uint32_t phaser_sync;          /* ... phaser_rate_mhz */
+  int32_t wah_mix_q15;
+  uint32_t wah_freq_hz;
+  uint32_t wah_w0;               /* bottom of the sweep, Q32 turns of AppTab_Sin() (from wah_freq_hz) */
+  int32_t wah_depth_q15;
+  int32_t wah_sens_db10;
+  int32_t wah_q100;
+  int32_t wah_damp_q15;          /* from wah_q100 */
+  int32_t pitch_mix_q15;
+  int32_t pitch_cents;
+  uint32_t pitch_window_ms;
+  uint32_t tone_model;           /* AppDspToneModel */
+  int32_t tone_bass_q15;
+  int32_t tone_mid_q15;
+  int32_t tone_treble_q15;
+  uint32_t cab_sections;         /* user cab, 0 = the fixed lowpass */
+  uint32_t cab_ir;               /* IR slot (app_cabir.h) */
+#if APP_DSP_CAB_SECTIONS_MAX
+  int32_t cab_sos[APP_DSP_CAB_SECTIONS_MAX][5];
+#endif
+  int32_t gain_q15;              /* master output volume: 0=mute, 32768=unity */
+  int32_t wet_width_q15;         /* wet bus side gain, 32768 = as the FX leave it */
+  AppEqBand eq[APP_EQ_BANDS];
+  AppEqCoeffs eq_coeffs;         /* designed from eq[] when published */
+  int32_t gate_thresh_db10;
+  uint32_t gate_release_ms;
+  uint64_t gate_open_ms;         /* s24 mean square opening the gate, 0 = off */
+  int32_t comp_thresh_db10;
+  int32_t comp_ratio_x10;
+  int32_t comp_knee_db10;
+  int32_t comp_makeup_db10;
+  CompCurve comp;                /* derived from comp_* in AppDsp_SetParam() */
+  uint8_t spill;                 /* published by AppDsp_CommitParamsSpill() */
+  uint32_t version;              /* stamped when published (AppDsp_ParamsVersion()) */
+} DspParams;
+
+/* Boot values, also reported as the descriptor defaults (PLIST). */
+#define DSP_FX_ID_ENTRY(m, d, T, c) DSP_FX_##m,
+static const DspParams k_params_boot = {
+  .fx_mask = 0u,
+  .chain = {DSP_FX_REGISTRY(DSP_FX_ID_ENTRY)},
+  .chain_par = 0u,
+  .chain_bus = 0u,
+  .sched = &s_sched[0],
+  .dist_drive_q8 = 40960,
+  .dist_os = APP_DSP_DIST_OVERSAMPLE_DEFAULT,
+  .dist_curve = APP_SHAPER_HARD,
+  .dist_model = APP_DSP_DIST_OVERDRIVE,
+  .color_curve = APP_SHAPER_SOFT,
+  .delay_mix_q15 = DELAY_MIX_Q15,
+  .delay_feedback_q15 = DELAY_FEEDBACK_Q15,
+  .delay_duck_q15 = 0,
+  .delay_steps = DELAY_TIME_DEFAULT_STEPS,
+  .delay_pattern_id = DELAY_PATTERN_DEFAULT,
+  .reverb_mix_q15 = REVERB_MIX_Q15,
+  .reverb_mix_all_q15 = REVERB_MIX_ALL_Q15,
+  .reverb_feedback_q15 = REVERB_FEEDBACK_Q15,
+  .reverb_damp_q15 = REVERB_DAMP_Q15,
+  .reverb_decay_ms = 0u,
+  .reverb_hf_damp_hz = 0u,
+  .reverb_line_fb_q15 = {REVERB_FEEDBACK_Q15, REVERB_FEEDBACK_Q15, REVERB_FEEDBACK_Q15, REVERB_FEEDBACK_Q15},
+  .reverb_line_damp_q15 = {REVERB_DAMP_Q15, REVERB_DAMP_Q15, REVERB_DAMP_Q15, REVERB_DAMP_Q15},
+  .reverb_room = APP_DSP_REVERB_ROOM_OFF,
+  .reverb_type = APP_DSP_REVERB_TYPE_FDN,
+  .reverb_diffusion = 2U,
+  .reverb_spring_fb_q15 = REVERB_FEEDBACK_Q15,
+  .reverb_er_q15 = 16384,
+  .reverb_freeze = 0u,
+  .chorus_mix_q15 = CHORUS_MIX_Q15,
+  .chorus_rate_mhz = CHORUS_RATE_MHZ,
+  .chorus_depth_q15 = CHORUS_DEPTH_Q15,
+  .chorus_time_us = CHORUS_TIME_US,
+  .chorus_time_q16 = CHORUS_US_TO_Q16(CHORUS_TIME_US),
+  .chorus_feedback_q15 = 0,
+  .chorus_spread_deg = CHORUS_SPREAD_DEG,
+  .phaser_mix_q15 = PHASER_MIX_Q15,
+  .phaser_rate_mhz = PHASER_RATE_MHZ,
+  .phaser_depth_q15 = PHASER_DEPTH_Q15,
+  .phaser_freq_hz = PHASER_FREQ_HZ,
+  .phaser_w0_q20 = PHASER_HZ_TO_W_Q20(PHASER_FREQ_HZ),
+  .phaser_stages = PHASER_STAGES,
+  .phaser_spread_deg = PHASER_SPREAD_DEG,
+  .tremolo_depth_q15 = 0,
+  .tremolo_pan_q15 = 0,
+  .tremolo_div = TREMOLO_DIV,
+  .tempo_bpm = TREMOLO_TEMPO_BPM,
+  .tremolo_rate_mhz = TREMOLO_RATE_MHZ(TREMOLO_TEMPO_BPM, TREMOLO_DIV),
+  .delay_sync = APP_DSP_SYNC_OFF,
+  .chorus_sync = APP_DSP_SYNC_OFF,
+  .phaser_sync = APP_DSP_SYNC_OFF,
+  .wah_mix_q15 = 0,
+  .wah_freq_hz = WAH_FREQ_HZ,
+  .wah_w0 = WAH_HZ_TO_PHASE(WAH_FREQ_HZ),
+  .wah_depth_q15 = WAH_DEPTH_Q15,
+  .wah_sens_db10 = WAH_SENS_DB10,
+  .wah_q100 = WAH_Q100,
+  .wah_damp_q15 = WAH_Q100_TO_DAMP_Q15(WAH_Q100),
+  .pitch_mix_q15 = 0,
+  .pitch_cents = PITCH_CENTS,
+  .pitch_window_ms = PITCH_WINDOW_MS,
+  .tone_model = APP_DSP_TONE_OFF,
+  .tone_bass_q15 = 16384,
+  .tone_mid_q15 = 16384,
+  .tone_treble_q15 = 16384,
+  .cab_sections = 0u,
+  .cab_ir = 0u,
+  .gain_q15 = 32768,
+  .wet_width_q15 = 32768,
+  .eq = {
+    [APP_EQ_LOW_SHELF] = {0, 120u, 71u},
+    [APP_EQ_MID1] = {0, 500u, 100u},
+    [APP_EQ_MID2] = {0, 2000u, 100u},
+    [APP_EQ_HIGH_SHELF] = {0, 5000u, 71u},
+  },
+  .eq_coeffs = {{0}, 0u},   /* all bands at 0 dB: flat */
+  .gate_thresh_db10 = 0,
+  .gate_release_ms = GATE_RELEASE_MS,
+  .gate_open_ms = 0u,
+  .comp_thresh_db10 = CLEAN_COMP_THRESH_DB10,
+  .comp_ratio_x10 = CLEAN_COMP_RATIO_X10,
+  .comp_knee_db10 = CLEAN_COMP_KNEE_DB10,
+  .comp_makeup_db10 = 0,
+  .comp = {
+    APP_TAB_DB10_TO_L2(CLEAN_COMP_THRESH_DB10),
+    COMP_SLOPE_Q15(CLEAN_COMP_RATIO_X10),
+    APP_TAB_DB10_TO_L2(CLEAN_COMP_KNEE_DB10),
+    COMP_KNEE_INV(APP_TAB_DB10_TO_L2(CLEAN_COMP_KNEE_DB10)),
+    4096,
+  },
+};
+#undef DSP_FX_ID_ENTRY
+
+static DspParams s_params[DSP_PARAM_COPIES];
+
+static const DspParams *volatile s_params_front = &k_params_boot;
+static DspParams *s_params_edit;   /* back copy with unpublished edits, or NULL */
+static uint8_t s_params_batch;
+static uint8_t s_params_eq_dirty;  /* eq[] edited since the last design */
+static uint8_t s_params_chain_dirty;  /* chain[] edited since the last compile */
+static uint32_t s_params_version;  /* last stamped; kept across AppDsp_Init() */
+static const DspParams *s_params_snap = &k_params_boot;  /* AppDsp_SnapshotParams() */
+/* AppDsp_WatchParams(): the version waited for (0: none), then the cycle
+ * count of the first block that ran on it or a later set.
+ */
+static volatile uint32_t s_params_watch;
+static volatile uint32_t s_params_watch_cyc;
+
+#if APP_DSP_PARAM_EVENTS
+typedef struct
+{
+  uint32_t frame;                /* s_frame_clock value it is due at */
+  const DspParams *params;
+} DspParamEvent;
+
+static DspParamEvent s_param_ev[APP_DSP_PARAM_EVENTS];
+static volatile uint8_t s_param_ev_head;   /* written by the main loop only */
+static volatile uint8_t s_param_ev_tail;   /* written by the audio path only */
+#endif
+static volatile uint32_t s_frame_clock;    /* frames through AppDsp_ProcessBlock() */
+
+/* Bypass tier: s_bypass as set, s_bypass_run as the audio path last took
+ * it (bypass_run()). A restarted chain is silent for its latency, the
+ * limiter lookahead, which the join holds its first frame over.
+ */
+#define DSP_BYPASS_JOIN_FRAMES         16U
+#if AUDIO_LIMITER_LOOKAHEAD
+#define DSP_BYPASS_HOLD_FRAMES         LIMITER_LA_FRAMES
+#else
+#define DSP_BYPASS_HOLD_FRAMES         0U
+#endif
+
+static volatile uint8_t s_bypass = APP_DSP_BYPASS_OFF;
+static uint8_t s_bypass_run = APP_DSP_BYPASS_OFF;
+static uint32_t s_bypass_hold;             /* frames the join still holds */
+static uint32_t s_bypass_join;             /* frames of the join still to go */
+static AppStereoS24 s_bypass_from;         /* output frame the join starts at */
+static AppStereoS24 s_bypass_last;         /* last output frame */
+
+static void chain_compile(const DspParams *c, DspSchedule *s);
+
+/* Keeps the compiler from sinking the back-copy stores past the publish. */
+#define DSP_COMPILER_BARRIER() __asm volatile("" ::: "memory")
+
+/* Copies and banks the audio path may still read, as bit masks over
+ * s_params[] and s_sched[]: the front one and every queued one. The tail
+ * is read before the front, so an event popped in between counts either
+ * way. Returns the newest of them, the seed for the next edit.
+ */
+static const DspParams *params_in_use(uint32_t *copies, uint32_t *banks)
+{
+  const DspParams *use[1u + APP_DSP_PARAM_EVENTS];
+  uint32_t n = 0u;
+#if APP_DSP_PARAM_EVENTS
+  const uint8_t head = s_param_ev_head;
+  const uint8_t tail = s_param_ev_tail;
+  DSP_COMPILER_BARRIER();
+  use[n++] = s_params_front;
+  for (uint8_t i = tail; i != head; i++)
+  {
+    use[n++] = s_param_ev[i % APP_DSP_PARAM_EVENTS].params;
+  }
+#else
+  use[n++] = s_params_front;
+#endif
+  *copies = 0u;
+  *banks = 0u;
+  for (uint32_t k = 0; k < n; k++)
+  {
+    for (uint32_t i = 0; i < DSP_PARAM_COPIES; i++)
+    {
+      *copies |= (use[k] == &s_params[i]) ? (1u << i) : 0u;
+      *banks |= (use[k]->sched == &s_sched[i]) ? (1u << i) : 0u;
+    }
+  }
+  return use[n - 1u];
+}
+
+static uint32_t params_free_index(uint32_t used)
+{
+  return (uint32_t)__builtin_ctz(~used);
+}
+
+/* Back copy for the next edit, seeded from the newest published one. */
+static DspParams *params_edit(void)
+{
+  if (s_params_edit == NULL)
+  {
+    uint32_t copies;
+    uint32_t banks;
+    const DspParams *seed = params_in_use(&copies, &banks);
+    DspParams *back = &s_params[params_free_index(copies)];
+    *back = *seed;
+    back->spill = 0u;
+    s_params_edit = back;
+  }
+  return s_params_edit;
+}
+
+/* Once per publish, so a preset redesigns the EQ once. */
+static void params_prepare(void)
+{
+  s_params_edit->version = ++s_params_version;
+  if (s_params_eq_dirty)
+  {
+    AppEq_Design(s_params_edit->eq, DSP_SAMPLE_RATE_HZ, &s_params_edit->eq_coeffs);
+    s_params_eq_dirty = 0u;
+  }
+  /* Into a bank no published copy is running from. */
+  if (s_params_chain_dirty)
+  {
+    uint32_t copies;
+    uint32_t banks;
+    (void)params_in_use(&copies, &banks);
+    DspSchedule *bank = &s_sched[params_free_index(banks)];
+    chain_compile(s_params_edit, bank);
+    s_params_edit->sched = bank;
+    s_params_chain_dirty = 0u;
+  }
+}
+
+#if APP_DSP_PARAM_EVENTS
+static uint8_t params_enqueue(uint32_t frame)
+{
+  const uint8_t head = s_param_ev_head;
+  if ((uint8_t)(head - s_param_ev_tail) >= APP_DSP_PARAM_EVENTS)
+  {
+    return 0u;
+  }
+  DspParamEvent *ev = &s_param_ev[head % APP_DSP_PARAM_EVENTS];
+  ev->frame = frame;
+  ev->params = s_params_edit;
+  DSP_COMPILER_BARRIER();
+  s_param_ev_head = (uint8_t)(head + 1u);
+  s_params_edit = NULL;
+  return 1u;
+}
+#endif
+
+static void params_publish(void)
+{
+  if ((s_params_edit != NULL) && (s_params_batch == 0u))
+  {
+    params_prepare();
+#if APP_DSP_PARAM_EVENTS
+    /* Due now, behind the pending events; a full queue keeps the edit for
+     * AppDsp_Poll().
+     */
+    if (s_param_ev_head != s_param_ev_tail)
+    {
+      (void)params_enqueue(s_frame_clock);
+      return;
+    }
+#endif
+    DSP_COMPILER_BARRIER();
+    s_params_front = s_params_edit;
+    s_params_edit = NULL;
+  }
+}
+
+/* Latest control-side values, published or not. */
+static const DspParams *params_view(void)
+{
+  return (s_params_edit != NULL) ? s_params_edit : s_params_front;
+}
+
+/* Feedback values under the tail floor are flushed to zero. The truncating
+ * multiplies and line storage round towards -inf, so without this a decaying
+ * loop settles on a small negative DC value instead of silence.
+ */
+static inline int32_t tail_flush_s24(int32_t x)
+{
+  return ((x < DSP_TAIL_FLOOR_S24) && (x > -DSP_TAIL_FLOOR_S24)) ? 0 : x;
+}
+
+#if APP_DSP_FLOAT
+static inline int32_t onepole_lpf_s24(int32_t x, DspFilt *st, int32_t a_q15)
+{
+  const float y = *st + (DSP_Q15_F(a_q15) * ((float)x - *st));
+  *st = y;
+  return dsp_f_to_s24(y);
+}
+
+static inline float allpass_one_f(float x, float *b)
+{
+  const float g = DSP_Q15_F(REVERB_AP_G_Q15);
+  const float y = *b - (g * x);
+  *b = dsp_clamp_f(x + (g * y));
+  return dsp_clamp_f(y);
+}
+
+/* Stereo allpass on an interleaved line: one frame load and store per tap. */
+static inline void allpass_process_stereo_f(float *l, float *r, DspFiltStereo *buf, uint32_t *idx, uint32_t len)
+{
+  uint32_t i = *idx;
+  DspFiltStereo b = buf[i];
+
+  *l = allpass_one_f(*l, &b.l);
+  *r = allpass_one_f(*r, &b.r);
+  buf[i] = b;
+
+  i++;
+  *idx = (i == len) ? 0U : i;
+}
+
+/* Per-line damping: one-pole low-pass on the line output. */
+static inline float reverb_damp_f(float y, float *lp, float damp)
+{
+  const float lpv = *lp + (damp * (y - *lp));
+  *lp = lpv;
+  return lpv;
+}
+#else
+static inline int32_t onepole_lpf_s24(int32_t x, int32_t *st, int32_t a_q15)
+{
+  int32_t y = *st;
+  y += (int32_t)(((int64_t)a_q15 * (int64_t)(x - y)) >> 15);
+  y = clamp_s24(y);
+  *st = y;
+  return y;
+}
+
+static inline int32_t allpass_one_s24(int32_t x, int32_t *b)
+{
+  int32_t y = *b - (int32_t)(((int64_t)REVERB_AP_G_Q15 * (int64_t)x) >> 15);
+  int32_t new_b = x + (int32_t)(((int64_t)REVERB_AP_G_Q15 * (int64_t)y) >> 15);
+  *b = clamp_s24(new_b);
+  return clamp_s24(y);
+}
+
+/* Stereo allpass on an interleaved line: one frame load and store per tap. */
+static inline void allpass_process_stereo_s24(AppStereoS24 *x, DspFiltStereo *buf, uint32_t *idx, uint32_t len)
+{
+  uint32_t i = *idx;
+  DspFiltStereo b = buf[i];
+
+  x->l = allpass_one_s24(x->l, &b.l);
+  x->r = allpass_one_s24(x->r, &b.r);
+  buf[i] = b;
+
+  i++;
+  *idx = (i == len) ? 0U : i;
+}
+
+/* Per-line damping: one-pole low-pass on the line output. */
+static inline int32_t reverb_damp_s24(int32_t y, int32_t *lp, int32_t damp_q15)
+{
+  int32_t lpv = *lp;
+  lpv += (int32_t)(((int64_t)damp_q15 * (int64_t)(y - lpv)) >> 15);
+  *lp = lpv;
+  return lpv;
+}
+#endif
+
+/* One FDN step. In: dry frame (only .l in mono-input mode). Out: wet frame.
+ *
+ * The damped line outputs are mixed by the orthonormal Hadamard matrix H4/2
+ * (adds, subtracts and one shift), scaled by the feedback and written back
+ * with the input. Left feeds lines 0/2 and right lines 1/3, and each output
+ * reads the same pair: the matrix spreads every echo over all four lines, so
+ * the sides decorrelate after the first pass. er (NULL = none) adds one
+ * side's early-reflection taps per output at er_q15, read before the write.
+ */
+/* Sum of one side's early-reflection taps (k_reverb_er), s24. */
+static inline int32_t reverb_er_s24(const uint32_t *lines, const uint32_t *idx, const ReverbErTap *t)
+{
+  int64_t acc = 0;
+  for (uint32_t j = 0; j < REVERB_ER_TAPS; j++)
+  {
+    const uint32_t k = t[j].line;
+    const uint32_t i = idx[k];
+    const uint32_t r = (i >= t[j].dist) ? (i - t[j].dist) : (i + k_reverb_fdn_len[k] - t[j].dist);
+    acc += (int64_t)t[j].gain_q15 * AppDline_Read1(lines, k_reverb_fdn_base[k] + r, APP_DSP_REVERB_STORAGE);
+  }
+  return (int32_t)(acc >> 15);
+}
+
+#if REVERB_MOD_ENABLE
+/* Line k read 'off_q16' samples newer than its full length, linear
+ * interpolation towards the next newer sample.
+ */
+static inline int32_t reverb_mod_read_s24(const uint32_t *lines, uint32_t k, uint32_t i, uint32_t off_q16)
+{
+  const uint32_t len = k_reverb_fdn_len[k];
+  uint32_t r0 = i + (off_q16 >> 16);
+  if (r0 >= len)
+  {
+    r0 -= len;
+  }
+  const uint32_t r1 = (r0 + 1U == len) ? 0U : (r0 + 1U);
+  const int32_t y0 = AppDline_Read1(lines, k_reverb_fdn_base[k] + r0, APP_DSP_REVERB_STORAGE);
+  const int32_t y1 = AppDline_Read1(lines, k_reverb_fdn_base[k] + r1, APP_DSP_REVERB_STORAGE);
+  return y0 + (int32_t)(((int64_t)(y1 - y0) * (int64_t)(off_q16 & 0xFFFFU)) >> 16);
+}
+
+/* Depth * (1 + v) in Q16 samples for an LFO value v in Q15. */
+static inline uint32_t reverb_mod_off_q16(int32_t v)
+{
+  if (v > 32767)
+  {
+    v = 32767;
+  }
+  else if (v < -32768)
+  {
+    v = -32768;
+  }
+  return (APP_DSP_REVERB_MOD_SAMPLES * (uint32_t)(v + 32768)) * 2U;
+}
+#endif
+
+#if APP_DSP_FLOAT
+static inline void reverb_process_s24(AppStereoS24 *x,
+                                      uint32_t *lines,
+                                      DspFiltStereo *ap_buf,
+                                      ReverbState *st,
+                                      const int32_t *feedback_q15,
+                                      const int32_t *damp_q15,
+                                      const ReverbErTap (*er)[REVERB_ER_TAPS],
+                                      int32_t er_q15,
+                                      uint32_t ap_stages,
+                                      bool frozen)
+{
+  float y[REVERB_FDN_LINES];
+  float d[REVERB_FDN_LINES];
+#if REVERB_MOD_ENABLE
+  const int32_t ms = st->mod.sin_q31 >> 16;
+  const int32_t mc = st->mod.cos_q31 >> 16;
+  st->mod.sin_q31 += st->mod.dsin_q31;
+  st->mod.cos_q31 += st->mod.dcos_q31;
+  const uint32_t off[REVERB_FDN_LINES] = {
+    reverb_mod_off_q16(ms), reverb_mod_off_q16(-ms), reverb_mod_off_q16(mc), reverb_mod_off_q16(-mc)
+  };
+#endif
+  for (uint32_t k = 0; k < REVERB_FDN_LINES; k++)
+  {
+#if REVERB_MOD_ENABLE
+    y[k] = (float)reverb_mod_read_s24(lines, k, st->idx[k], off[k]);
+#else
+    y[k] = (float)AppDline_Read1(lines, k_reverb_fdn_base[k] + st->idx[k], APP_DSP_REVERB_STORAGE);
+#endif
+    d[k] = frozen ? y[k] : reverb_damp_f(y[k], &st->lp[k], DSP_Q15_F(damp_q15[k]));
+  }
+  float el = 0.0f;
+  float er_r = 0.0f;
+  if (er != NULL)
+  {
+    el = DSP_Q15_F(er_q15) * (float)reverb_er_s24(lines, st->idx, er[0]);
+    er_r = DSP_Q15_F(er_q15) * (float)reverb_er_s24(lines, st->idx, er[1]);
+  }
+
+  const float s01 = d[0] + d[1];
+  const float d01 = d[0] - d[1];
+  const float s23 = d[2] + d[3];
+  const float d23 = d[2] - d[3];
+  const float m[REVERB_FDN_LINES] = {s01 + s23, d01 + d23, s01 - s23, d01 - d23};
+
+#if REVERB_MONO_IN
+  const float in[2] = {(float)x->l, (float)x->l};
+#else
+  const float in[2] = {(float)x->l, (float)x->r};
+#endif
+  for (uint32_t k = 0; k < REVERB_FDN_LINES; k++)
+  {
+    float fb = (DSP_Q15_F(feedback_q15[k]) * 0.5f) * m[k];   /* H4 / 2 folded in */
+    if ((fb < (float)DSP_TAIL_FLOOR_S24) && (fb > -(float)DSP_TAIL_FLOOR_S24))
+    {
+      fb = 0.0f;
+    }
+    uint32_t i = st->idx[k];
+    AppDline_Write1(lines, k_reverb_fdn_base[k] + i, dsp_f_to_s24(frozen ? fb : (in[k & 1U] + fb)),
+                    APP_DSP_REVERB_STORAGE);
+    i++;
+    st->idx[k] = (i == k_reverb_fdn_len[k]) ? 0U : i;
+  }
+
+  float wl = 0.5f * (y[0] + y[2]);
+  float wr = 0.5f * (y[1] + y[3]);
+
+  /* Diffusion, independent state per side. */
+  for (uint32_t k = 0; k < ap_stages; k++)
+  {
+    allpass_process_stereo_f(&wl, &wr, &ap_buf[k_reverb_ap_base[k]], &st->ap_idx[k], k_reverb_ap_len[k]);
+  }
+  x->l = dsp_f_to_s24(wl + el);
+  x->r = dsp_f_to_s24(wr + er_r);
+}
+#else
+static inline void reverb_process_s24(AppStereoS24 *x,
+                                      uint32_t *lines,
+                                      DspFiltStereo *ap_buf,
+                                      ReverbState *st,
+                                      const int32_t *feedback_q15,
+                                      const int32_t *damp_q15,
+                                      const ReverbErTap (*er)[REVERB_ER_TAPS],
+                                      int32_t er_q15,
+                                      uint32_t ap_stages,
+                                      bool frozen)
+{
+  int32_t y[REVERB_FDN_LINES];
+  int32_t d[REVERB_FDN_LINES];
+#if REVERB_MOD_ENABLE
+  const int32_t ms = st->mod.sin_q31 >> 16;
+  const int32_t mc = st->mod.cos_q31 >> 16;
+  st->mod.sin_q31 += st->mod.dsin_q31;
+  st->mod.cos_q31 += st->mod.dcos_q31;
+  const uint32_t off[REVERB_FDN_LINES] = {
+    reverb_mod_off_q16(ms), reverb_mod_off_q16(-ms), reverb_mod_off_q16(mc), reverb_mod_off_q16(-mc)
+  };
+#endif
+  for (uint32_t k = 0; k < REVERB_FDN_LINES; k++)
+  {
+#if REVERB_MOD_ENABLE
+    y[k] = reverb_mod_read_s24(lines, k, st->idx[k], off[k]);
+#else
+    y[k] = AppDline_Read1(lines, k_reverb_fdn_base[k] + st->idx[k], APP_DSP_REVERB_STORAGE);
+#endif
+    d[k] = frozen ? y[k] : reverb_damp_s24(y[k], &st->lp[k], damp_q15[k]);
+  }
+  int32_t el = 0;
+  int32_t er_r = 0;
+  if (er != NULL)
+  {
+    el = (int32_t)(((int64_t)er_q15 * reverb_er_s24(lines, st->idx, er[0])) >> 15);
+    er_r = (int32_t)(((int64_t)er_q15 * reverb_er_s24(lines, st->idx, er[1])) >> 15);
+  }
+
+  /* H4/2 = [1 1 1 1; 1 -1 1 -1; 1 1 -1 -1; 1 -1 -1 1] / 2 */
+  int32_t s01 = d[0] + d[1];
+  int32_t d01 = d[0] - d[1];
+  int32_t s23 = d[2] + d[3];
+  int32_t d23 = d[2] - d[3];
+  int32_t m[REVERB_FDN_LINES] = {
+    (s01 + s23) >> 1, (d01 + d23) >> 1, (s01 - s23) >> 1, (d01 - d23) >> 1
+  };
+
+#if REVERB_MONO_IN
+  const int32_t in[2] = {x->l, x->l};
+#else
+  const int32_t in[2] = {x->l, x->r};
+#endif
+  for (uint32_t k = 0; k < REVERB_FDN_LINES; k++)
+  {
+    uint32_t i = st->idx[k];
+    if (frozen)
+    {
+      AppDline_Write1(lines, k_reverb_fdn_base[k] + i, clamp_s24(m[k]), APP_DSP_REVERB_STORAGE);
+    }
+    else
+    {
+      int32_t fb = tail_flush_s24((int32_t)(((int64_t)feedback_q15[k] * (int64_t)m[k]) >> 15));
+      AppDline_Write1(lines, k_reverb_fdn_base[k] + i, clamp_s24(in[k & 1U] + fb), APP_DSP_REVERB_STORAGE);
+    }
+    i++;
+    st->idx[k] = (i == k_reverb_fdn_len[k]) ? 0U : i;
+  }
+
+  AppStereoS24 w;
+  w.l = (y[0] + y[2]) >> 1;
+  w.r = (y[1] + y[3]) >> 1;
+
+  /* Diffusion, independent state per side. */
+  for (uint32_t k = 0; k < ap_stages; k++)
+  {
+    allpass_process_stereo_s24(&w, &ap_buf[k_reverb_ap_base[k]], &st->ap_idx[k], k_reverb_ap_len[k]);
+  }
+  x->l = clamp_s24(w.l + el);
+  x->r = clamp_s24(w.r + er_r);
+}
+#endif
+
+#if APP_DSP_SPRING_ENABLE
+/* One allpass stage over a chunk in place, y = a (x - y1) + x1. */
+static inline void spring_ap_s24_len(int32_t *x, uint32_t len, SpringApState *st)
+{
+  int32_t x1 = st->x1;
+  int32_t y1 = st->y1;
+  for (uint32_t i = 0; i < len; i++)
+  {
+    const int32_t v = x[i];
+    y1 = x1 + (int32_t)(((int64_t)SPRING_AP_Q15 * (int64_t)(v - y1)) >> 15);
+    x1 = v;
+    x[i] = y1;
+  }
+  st->x1 = x1;
+  st->y1 = y1;
+}
+
+/* One chunk round the loop: the line read at the modulated delay
+ * (one LFO step per chunk), lowpassed and fed back under the input,
+ * then the stages one after the other, then written back.
+ */
+static void spring_chunk(SpringState *sp, uint32_t *line, int32_t fb_q15)
+{
+  int32_t v[SPRING_CHUNK];
+  const uint32_t dist_q16 = (SPRING_DELAY << 16) +
+                            (uint32_t)(((int64_t)AppTab_Sin(sp->mod_phase) * (int64_t)SPRING_MOD_DEPTH_Q16) >> 15);
+  sp->mod_phase += SPRING_MOD_INC;
+
+  uint32_t i = sp->idx;
+  int32_t lp = sp->lp;
+  for (uint32_t j = 0; j < SPRING_CHUNK; j++)
+  {
+    const int32_t y = AppDline_Tap1(line, SPRING_LINE_LEN, i, dist_q16, APP_DSP_REVERB_STORAGE);
+    lp += (int32_t)(((int64_t)SPRING_LPF_Q15 * (int64_t)(y - lp)) >> 15);
+    v[j] = sp->chunk_in[j] + tail_flush_s24(mul_s24_q15(lp, fb_q15));
+    i = (i + 1U == SPRING_LINE_LEN) ? 0U : (i + 1U);
+  }
+  sp->lp = lp;
+
+  for (uint32_t k = 0; k < SPRING_STAGES; k++)
+  {
+    spring_ap_s24_len(v, SPRING_CHUNK, &sp->ap[k]);
+  }
+
+  i = sp->idx;
+  for (uint32_t j = 0; j < SPRING_CHUNK; j++)
+  {
+    const int32_t y = clamp_s24(v[j]);
+    AppDline_Write1(line, i, y, APP_DSP_REVERB_STORAGE);
+    sp->chunk_out[j] = y;
+    i = (i + 1U == SPRING_LINE_LEN) ? 0U : (i + 1U);
+  }
+  sp->idx = i;
+}
+
+/* The spring's state, in the FDN buffer behind its line. */
+static inline SpringState *spring_state(void)
+{
+  return (SpringState *)(void *)(s_reverb_fdn + SPRING_LINE_WORDS);
+}
+
+/* One reverb-rate frame through the spring, mono in and out: the 4x
+ * decimator feeds the chunk, the interpolator reads the previous one.
+ */
+static inline int32_t spring_frame_s24(SpringState *sp, int32_t x, uint32_t *line, int32_t fb_q15)
+{
+  const uint32_t h = (sp->hidx + 1U) & (SPRING_FIR_TAPS - 1U);
+  sp->hidx = h;
+  sp->hist[h] = x;
+  uint32_t ph = sp->phase + 1U;
+  if (ph == SPRING_DECIM)
+  {
+    ph = 0U;
+    int64_t acc = 0;
+    for (uint32_t k = 0; k < SPRING_FIR_TAPS; k++)
+    {
+      acc += (int64_t)k_spring_fir_q15[k] * sp->hist[(h - k) & (SPRING_FIR_TAPS - 1U)];
+    }
+    const uint32_t pos = sp->pos;
+    sp->chunk_in[pos] = (int32_t)(acc >> 15);
+    for (uint32_t r = SPRING_DECIM - 1U; r > 0U; r--)
+    {
+      sp->out[r] = sp->out[r - 1U];
+    }
+    sp->out[0] = sp->chunk_out[pos];
+    if (pos + 1U == SPRING_CHUNK)
+    {
+      sp->pos = 0U;
+      spring_chunk(sp, line, fb_q15);
+    }
+    else
+    {
+      sp->pos = pos + 1U;
+    }
+  }
+  sp->phase = ph;
+
+  /* x4 for the zero stuffing. */
+  int64_t acc = 0;
+  for (uint32_t r = 0; r < SPRING_DECIM; r++)
+  {
+    acc += (int64_t)k_spring_fir_q15[ph + (SPRING_DECIM * r)] * sp->out[r];
+  }
+  return clamp_s24((int32_t)(acc >> 13));
+}
+#endif
+
+static inline int32_t delay_interp_s24(int32_t h0, int32_t h1, int32_t h2,
+                                       int32_t y0, int32_t y1, int32_t y2)
+{
+  int64_t acc = (int64_t)h0 * y0 + (int64_t)h1 * y1 + (int64_t)h2 * y2;
+  /* Q15 taps, x8 for the zero-stuffed upsampling. */
+  return clamp_s24((int32_t)(acc >> 12));
+}
+
+/* Read position 'delay_q16' line steps (Q16) behind write index i
+ * (AppDline_Tap2()).
+ */
+static inline AppStereoS24 delay_tap_s24(const uint32_t *delay, uint32_t i, uint32_t delay_q16)
+{
+  return AppDline_Tap2(delay, DELAY_LEN, i, delay_q16, APP_DSP_DELAY_STORAGE);
+}
+
+static inline uint32_t delay_glide_q16(uint32_t cur_q16, uint32_t target_q16)
+{
+  int32_t d = (int32_t)(target_q16 - cur_q16);
+  int32_t step = d / (1 << DELAY_GLIDE_SHIFT);
+  if (step == 0)
+  {
+    step = d; /* last fraction of a step */
+  }
+  if (step > DELAY_GLIDE_MAX_Q16) step = DELAY_GLIDE_MAX_Q16;
+  if (step < -DELAY_GLIDE_MAX_Q16) step = -DELAY_GLIDE_MAX_Q16;
+  return (uint32_t)((int32_t)cur_q16 + step);
+}
+
+/* Balance pan in Q15: centre leaves both sides at unity. */
+static inline int32_t pan_gain_l_q15(uint32_t pan_q15)
+{
+  int32_t g = 2 * (32768 - (int32_t)pan_q15);
+  return (g > 32768) ? 32768 : g;
+}
+
+static inline int32_t pan_gain_r_q15(uint32_t pan_q15)
+{
+  int32_t g = 2 * (int32_t)pan_q15;
+  return (g > 32768) ? 32768 : g;
+}
+
+/* Sum of all enabled taps for one line step, as one stereo frame. The
+ * full-time read 'main' is reused instead of read again.
+ */
+static inline AppStereoS24 delay_taps_mix_s24(const uint32_t *delay,
+                                              uint32_t i,
+                                              uint32_t delay_q16,
+                                              AppStereoS24 main,
+                                              const DelayPattern *pat)
+{
+  int64_t acc_l = 0;
+  int64_t acc_r = 0;
+  for (uint32_t k = 0; k < APP_DSP_DELAY_TAPS_MAX; k++)
+  {
+    const AppDspDelayTap *t = &pat->tap[k];
+    if (t->gain_q15 == 0)
+    {
+      continue;
+    }
+    AppStereoS24 y = main;
+    if (t->time_q12 != 4096U)
+    {
+      uint32_t d = (uint32_t)(((uint64_t)delay_q16 * t->time_q12) >> 12);
+      y = delay_tap_s24(delay, i, (d < 65536U) ? 65536U : d);
+    }
+    int32_t gl = (int32_t)(((int64_t)t->gain_q15 * pan_gain_l_q15(t->pan_q15)) >> 15);
+    int32_t gr = (int32_t)(((int64_t)t->gain_q15 * pan_gain_r_q15(t->pan_q15)) >> 15);
+    acc_l += (int64_t)y.l * gl;
+    acc_r += (int64_t)y.r * gr;
+  }
+  AppStereoS24 out = {clamp_s24((int32_t)(acc_l >> 15)), clamp_s24((int32_t)(acc_r >> 15))};
+  return out;
+}
+
+/* Reverse output for one line step: two heads play the line backwards,
+ * each over a window of w steps (the glided delay time, even, at most half
+ * the line), half a window apart. A head at phase ph reads 2 * ph + 1
+ * steps behind the writer, so while the writer moves on one step it moves
+ * back one; its triangular window is silent where it jumps to the newest
+ * step, and the two windows always sum to unity. Reads only the delay line
+ * the forward taps use: no extra memory.
+ */
+_Static_assert(DELAY_LEN <= 65536U, "reverse head distances are Q16 in 32 bits");
+
+static inline AppStereoS24 delay_reverse_s24(const uint32_t *delay, uint32_t i, DelayState *st)
+{
+  uint32_t w = st->delay_q16 >> 16;
+  w = (w < (DELAY_LEN / 2U)) ? w : (DELAY_LEN / 2U);
+  w = (w < 2U) ? 2U : (w & ~1U);
+  const uint32_t half = w >> 1;
+
+  uint32_t ph = st->rev_phase + 1U;
+  ph = (ph < w) ? ph : 0U;
+  st->rev_phase = ph;
+  const uint32_t ph_b = (ph + half < w) ? (ph + half) : (ph + half - w);
+
+  const uint32_t tri = (ph <= half) ? ph : (w - ph);
+  const int32_t g_a = (int32_t)((tri << 15) / half);
+  const int32_t g_b = 32768 - g_a;
+  const AppStereoS24 a = delay_tap_s24(delay, i, ((2U * ph) + 1U) << 16);
+  const AppStereoS24 b = delay_tap_s24(delay, i, ((2U * ph_b) + 1U) << 16);
+  AppStereoS24 out = {clamp_s24((int32_t)((((int64_t)a.l * g_a) + ((int64_t)b.l * g_b)) >> 15)),
+                      clamp_s24((int32_t)((((int64_t)a.r * g_a) + ((int64_t)b.r * g_b)) >> 15))};
+  return out;
+}
+
+static inline void delay_process_s24(int32_t xl,
+                                     int32_t xr,
+                                     uint32_t *delay,
+                                     DelayState *st,
+                                     uint32_t steps,
+                                     int32_t feedback_q15,
+                                     const DelayPattern *pat)
+{
+  const uint32_t p = st->phase;
+
+  /* Decimator: input sample at phase p lands on taps 7-p, 15-p and 23-p
+   * of the current and the two following line steps.
+   */
+  st->dec_l[0] += (int64_t)k_delay_rs_q15[2][p] * xl;
+  st->dec_l[1] += (int64_t)k_delay_rs_q15[1][p] * xl;
+  st->dec_l[2] += (int64_t)k_delay_rs_q15[0][p] * xl;
+#if APP_DSP_MONO_INPUT
+  (void)xr;
+#else
+  st->dec_r[0] += (int64_t)k_delay_rs_q15[2][p] * xr;
+  st->dec_r[1] += (int64_t)k_delay_rs_q15[1][p] * xr;
+  st->dec_r[2] += (int64_t)k_delay_rs_q15[0][p] * xr;
+#endif
+
+  if (p == (DELAY_DECIM - 1U))
+  {
+    int32_t in_l = (int32_t)(st->dec_l[0] >> 15);
+    int32_t in_r = (int32_t)(st->dec_r[0] >> 15);
+    st->dec_l[0] = st->dec_l[1];
+    st->dec_l[1] = st->dec_l[2];
+    st->dec_l[2] = 0;
+    st->dec_r[0] = st->dec_r[1];
+    st->dec_r[1] = st->dec_r[2];
+    st->dec_r[2] = 0;
+
+    uint32_t i = st->idx;
+    st->delay_q16 = delay_glide_q16(st->delay_q16, steps << 16);
+    AppStereoS24 tap = delay_tap_s24(delay, i, st->delay_q16);
+
+    /* Low-pass the feedback signal to avoid robotic high-frequency ringing. */
+    const int32_t lp_l = onepole_lpf_s24(tap.l, &st->fb_lp_l, s_rate.delay_fb_lpf_a_q15);
+    const int32_t lp_r = onepole_lpf_s24(tap.r, &st->fb_lp_r, s_rate.delay_fb_lpf_a_q15);
+    int32_t fbl = tail_flush_s24(mul_s24_q15(lp_l, feedback_q15));
+    int32_t fbr = tail_flush_s24(mul_s24_q15(lp_r, feedback_q15));
+
+    /* Output taps read before this step's write, like the feedback tap.
+     * Reverse keeps the forward feedback: the repeats build up as usual and
+     * each comes out backwards.
+     */
+    AppStereoS24 wet = pat->reverse ? delay_reverse_s24(delay, i, st) :
+                                      delay_taps_mix_s24(delay, i, st->delay_q16, tap, pat);
+
+    if (pat->cross)
+    {
+      /* Ping-pong: the input enters on L and every repeat crosses sides. */
+#if APP_DSP_MONO_INPUT
+      int32_t in_m = in_l;
+#else
+      int32_t in_m = (in_l + in_r) >> 1;
+#endif
+      AppDline_Write2(delay, i, clamp_s24(in_m + fbr), clamp_s24(fbl), APP_DSP_DELAY_STORAGE);
+    }
+    else
+    {
+      AppDline_Write2(delay, i, clamp_s24(in_l + fbl), clamp_s24(in_r + fbr), APP_DSP_DELAY_STORAGE);
+    }
+    i++;
+    st->idx = (i < DELAY_LEN) ? i : 0U;
+
+    st->hist[2] = st->hist[1];
+    st->hist[1] = st->hist[0];
+    st->hist[0] = wet;
+  }
+
+  /* Interpolator phase q runs one sample after the decimator phase, so the
+   * step just read is used from q = 0.
+   */
+  const uint32_t q = (p + 1U) & (DELAY_DECIM - 1U);
+  st->last_out_l_s24 = delay_interp_s24(k_delay_rs_q15[0][q], k_delay_rs_q15[1][q], k_delay_rs_q15[2][q],
+                                        st->hist[0].l, st->hist[1].l, st->hist[2].l);
+  st->last_out_r_s24 = delay_interp_s24(k_delay_rs_q15[0][q], k_delay_rs_q15[1][q], k_delay_rs_q15[2][q],
+                                        st->hist[0].r, st->hist[1].r, st->hist[2].r);
+
+  st->phase = (uint8_t)q;
+}
+
+/* Halfband x2 interpolator: pushes x and returns the two high-rate samples
+ * in time order, the in-between one in *y0 and the aligned one (taps - 1
+ * samples late) in *y1. x2 gain for the zero stuffing.
+ */
+static inline void dist_hb_up2(DistHbState *st, int32_t x, const int32_t *c, uint32_t taps,
+                               int32_t *y0, int32_t *y1)
+{
+  uint32_t i = (st->up_idx + 1U) & DIST_HB_MASK;
+  st->up_idx = i;
+  st->up[i] = x;
+
+  int64_t acc = 0;
+  for (uint32_t k = 0; k < taps; k++)
+  {
+    acc += (int64_t)c[k] * ((int64_t)st->up[(i - (taps - 1U) + k) & DIST_HB_MASK] +
+                            (int64_t)st->up[(i - taps - k) & DIST_HB_MASK]);
+  }
+  *y0 = (int32_t)(acc >> 14);
+  *y1 = st->up[(i - (taps - 1U)) & DIST_HB_MASK];
+}
+
+/* Halfband x2 decimator over the pair (a, b): centre tap on a, side taps
+ * on b.
+ */
+static inline int32_t dist_hb_down2(DistHbState *st, int32_t a, int32_t b, const int32_t *c, uint32_t taps)
+{
+  uint32_t i = (st->dn_idx + 1U) & DIST_HB_MASK;
+  st->dn_idx = i;
+  st->dn_a[i] = a;
+  st->dn_b[i] = b;
+
+  int64_t acc = (int64_t)st->dn_a[(i - (taps - 1U)) & DIST_HB_MASK] * 16384;
+  for (uint32_t k = 0; k < taps; k++)
+  {
+    acc += (int64_t)c[k] * ((int64_t)st->dn_b[(i - (taps - 1U) + k) & DIST_HB_MASK] +
+                            (int64_t)st->dn_b[(i - taps - k) & DIST_HB_MASK]);
+  }
+  return (int32_t)(acc >> 15);
+}
+
+/* Drive and clip one (oversampled) sample. The drive product is clamped in
+ * 64 bits: at drive 131072 (x512) it no longer fits an int32. bias shifts
+ * the operating point for an asymmetric clip; bias_y, the curve at bias,
+ * takes the DC step back out. Both are constants of the model (0 for the
+ * original circuit).
+ */
+static inline int32_t dist_shape_s24(int32_t x, int32_t drive_q8, const int16_t *curve, int32_t bias,
+                                     int32_t bias_y)
+{
+  int64_t d = (((int64_t)x * drive_q8) >> 8) + bias;
+  if (d > 8388607) d = 8388607;
+  if (d < -8388608) d = -8388608;
+  return AppShaper_S24(curve, (int32_t)d) - bias_y;
+}
+
+/* The input high-pass's pole per oversampling factor (1, 2, 4): ~150 Hz at
+ * each rate.
+ */
+static const int32_t k_dist_hp_r_q15[3] = {32113, 32439, 32603};
+
+static inline int32_t dist_hp_s24(DistState *st, int32_t x, int32_t r_q15)
+{
+  int32_t hp_y = x - st->hp_x1 + (int32_t)(((int64_t)r_q15 * st->hp_y1) >> 15);
+  st->hp_x1 = x;
+  st->hp_y1 = hp_y;
+  return hp_y;
+}
+
+/* One high-rate sample of the island: the input coloration and the
+ * high-pass ahead of the clipper when color is set, else the clipper only.
+ */
+static inline int32_t dist_island_s24(DistState *st, int32_t x, int32_t drive_q8, const int16_t *curve,
+                                      int32_t bias, int32_t bias_y, const int16_t *color, int32_t hp_r_q15)
+{
+  if (color != NULL)
+  {
+    x = dist_hp_s24(st, input_color_process_s24(x, color), hp_r_q15);
+  }
+  return dist_shape_s24(x, drive_q8, curve, bias, bias_y);
+}
+
+/* High-pass, clipper, low-pass (lp_a_q15) and level; bias and bias_y as
+ * dist_shape_s24().
+ * os: 1 keeps the original two-point average of the clipped sample, 2 and 4
+ * run the clipper at 96/192 kHz between halfband pairs so the harmonics
+ * above 24 kHz are filtered instead of folding back.
+ * color: the coloration curve to run on the same pair (the island,
+ * APP_DSP_DIST_ISLAND), NULL when color_block() has already run. The
+ * high-pass then follows it at the high rate, to keep the order.
+ */
+static inline int32_t dist_voiced_s24(DistState *st, int32_t x, int32_t drive_q8, uint32_t os,
+                                      const int16_t *curve, int32_t bias, int32_t bias_y, int32_t lp_a_q15,
+                                      const int16_t *color)
+{
+  if ((color != NULL) && (os < 2U))
+  {
+    x = input_color_process_s24(x, color);
+    color = NULL;
+  }
+  const int32_t hp_y = (color != NULL) ? x : dist_hp_s24(st, x, k_dist_hp_r_q15[0]);
+
+  int32_t y24;
+  if (os >= 4U)
+  {
+    const int32_t r = k_dist_hp_r_q15[2];
+    int32_t u0, u1, v0, v1, v2, v3;
+    dist_hb_up2(&st->hb1, hp_y, k_dist_hb1_q15, DIST_HB1_TAPS, &u0, &u1);
+    dist_hb_up2(&st->hb2, u0, k_dist_hb2_q15, DIST_HB2_TAPS, &v0, &v1);
+    dist_hb_up2(&st->hb2, u1, k_dist_hb2_q15, DIST_HB2_TAPS, &v2, &v3);
+    v0 = dist_island_s24(st, v0, drive_q8, curve, bias, bias_y, color, r);
+    v1 = dist_island_s24(st, v1, drive_q8, curve, bias, bias_y, color, r);
+    v2 = dist_island_s24(st, v2, drive_q8, curve, bias, bias_y, color, r);
+    v3 = dist_island_s24(st, v3, drive_q8, curve, bias, bias_y, color, r);
+    u0 = dist_hb_down2(&st->hb2, v0, v1, k_dist_hb2_q15, DIST_HB2_TAPS);
+    u1 = dist_hb_down2(&st->hb2, v2, v3, k_dist_hb2_q15, DIST_HB2_TAPS);
+    y24 = dist_hb_down2(&st->hb1, u0, u1, k_dist_hb1_q15, DIST_HB1_TAPS);
+  }
+  else if (os == 2U)
+  {
+    const int32_t r = k_dist_hp_r_q15[1];
+    int32_t u0, u1;
+    dist_hb_up2(&st->hb1, hp_y, k_dist_hb1_q15, DIST_HB1_TAPS, &u0, &u1);
+    u0 = dist_island_s24(st, u0, drive_q8, curve, bias, bias_y, color, r);
+    u1 = dist_island_s24(st, u1, drive_q8, curve, bias, bias_y, color, r);
+    y24 = dist_hb_down2(&st->hb1, u0, u1, k_dist_hb1_q15, DIST_HB1_TAPS);
+  }
+  else
+  {
+    int32_t d24 = (int32_t)(((int64_t)hp_y * drive_q8) >> 8);
+
+    int32_t d24_mid = (d24 + st->os_x1) >> 1;
+    st->os_x1 = d24;
+
+    if (bias != 0)
+    {
+      d24 = clamp_s24(d24) + bias;
+      d24_mid = clamp_s24(d24_mid) + bias;
+    }
+    int32_t y0 = AppShaper_S24(curve, clamp_s24(d24)) - bias_y;
+    int32_t y1 = AppShaper_S24(curve, clamp_s24(d24_mid)) - bias_y;
+    y24 = (y0 + y1) >> 1;
+  }
+
+  st->lp_y1 += (int32_t)(((int64_t)lp_a_q15 * (y24 - st->lp_y1)) >> 15);
+  y24 = st->lp_y1;
+
+  const int32_t level_q8 = 256;
+  y24 = (int32_t)(((int64_t)y24 * level_q8) >> 8);
+  return clamp_s24(y24);
+}
+
+/* The original circuit (APP_DSP_DIST_OVERDRIVE) on one sample. */
+static inline int32_t distortion_process_s24(DistState *st, int32_t x, int32_t drive_q8, uint32_t os,
+                                             const int16_t *curve, const int16_t *color)
+{
+  return dist_voiced_s24(st, x, drive_q8, os, curve, 0, 0, DIST_LP_A_Q15, color);
+}
+
+typedef struct
+{
+  DspFilt x1;
+  DspFilt x2;
+  DspFilt y1;
+  DspFilt y2;
+} BiquadState;
+
+/* Tone stack (AppTab_Tone()): the DC zero with the low pole, then the
+ * biquad. e1/e2 carry each section's truncation residue into its next
+ * sample, so the low pole (~0.996) does not pile up rounding noise.
+ */
+typedef struct
+{
+  int32_t x1;
+  int32_t y1;
+  int32_t e1;
+  int32_t bx1;
+  int32_t bx2;
+  int32_t by1;
+  int32_t by2;
+  int32_t e2;
+} ToneStackState;
+
+/* FX module states (app_fx.h), laid out back to back by DSP_FX_REGISTRY.
+ * The ones with a mask bit start with their FxFade.
+ */
+typedef struct
+{
+  FxFade fade;                   /* send: wet/dry blend while switching */
+  DistState l;
+  DistState r;
+  BiquadState cab_l[CAB_BIQUADS];   /* [0] also runs the fixed lowpass */
+  BiquadState cab_r[CAB_BIQUADS];
+  ToneStackState tone_l;
+  ToneStackState tone_r;
+} DistFxState;
+
+typedef struct
+{
+  FxFade fade;                   /* send: line input, the tail keeps ringing */
+  DspRamp mix;
+  DspRamp duck;                  /* wet gain, Q15, 32768 while not ducking */
+  int32_t duck_l2;               /* input level the duck follows, Q16 octaves */
+  DelayState line;
+  DcBlockState wet_hpf_l;
+  DcBlockState wet_hpf_r;
+  DspFilt wet_lpf_l;
+  DspFilt wet_lpf_r;
+} DelayFxState;
+
+typedef struct
+{
+  FxFade fade;                   /* send: line input, the tail rings out */
+  DspRamp mix;
+  AppLfo lfo;                    /* left tap; the right one leads by the spread */
+  uint32_t rate_mhz;             /* the LFO's rate */
+  uint32_t idx;                  /* line write position */
+  uint32_t time_q16;             /* centre distance, gliding to the parameter */
+  DistHbState hb_l;              /* decimator and left interpolator */
+  DistHbState hb_r;              /* right interpolator */
+  int32_t held_in;               /* first frame of the pair, mono */
+  AppStereoS24 held_out;         /* second output frame of the pair */
+  uint8_t phase;
+} ChorusFxState;
+
+typedef struct
+{
+  int32_t lp;
+  int32_t bp;
+} WahSvfState;
+
+typedef struct
+{
+  DspRamp pos;                   /* sweep position, Q15: 0 = wah_freq_hz, 32768 = top */
+  WahSvfState l;
+  WahSvfState r;
+} WahFxState;
+
+typedef struct
+{
+  uint32_t idx;                  /* line write position */
+  uint32_t fill;                 /* steps written since it last went on, up to PITCH_LEN */
+  uint32_t u;                    /* first head's place in the window, Q32 */
+  DistHbState hb;                /* decimator and interpolator */
+  int32_t held_in;               /* first frame of the pair */
+  int32_t held_out;              /* second output frame of the pair */
+  uint8_t phase;
+} PitchFxState;
+
+typedef struct
+{
+  int32_t x1;
+  int32_t y1;
+} PhaserApState;
+
+typedef struct
+{
+  FxFade fade;                   /* send: crossfades wet/dry on mask changes */
+  DspRamp mix;
+  AppLfo lfo;                    /* left channel; the right one leads by the spread */
+  uint32_t rate_mhz;             /* the LFO's rate */
+  PhaserApState ap_l[PHASER_STAGES_MAX];
+  PhaserApState ap_r[PHASER_STAGES_MAX];
+} PhaserFxState;
+
+typedef struct
+{
+  FxFade fade;                   /* send: tank input, the tail keeps ringing */
+  DspRamp mix;
+  ReverbState tank;
+  uint32_t type;                 /* AppDspReverbType the buffer holds */
+  uint32_t ap_stages;            /* diffuser stages with live state */
+  AppDlineClear clear;           /* the FDN after an arena handoff or a type switch; asleep until done */
+#if REVERB_MOD_ENABLE
+  AppLfo lfo;
+#endif
+#if APP_DSP_REVERB_HALF_RATE
+  ReverbHalfState half;
+#endif
+  DcBlockState wet_hpf_l;
+  DcBlockState wet_hpf_r;
+  DspFilt wet_lpf_l;
+  DspFilt wet_lpf_r;
+} ReverbFxState;
+
+/* Member for a module without state of its own (state_size 0). */
+typedef struct
+{
+  uint8_t none;
+} DspFxNoState;
+
+/* Cab lowpass, Q28 biquad designed for the build rate:
+ * y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
+ * A user cab (AppDsp_SetCabSection()) runs its sections on the same kernel.
+ */
+#define CAB_LPF_FC_HZ  5000
+#define CAB_LPF_Q      0.7071
+#define CAB_B0_Q28     APP_COEF_Q28(APP_COEF_LPF_B0(CAB_LPF_FC_HZ, CAB_LPF_Q, DSP_SAMPLE_RATE_HZ))
+#define CAB_B1_Q28     (2 * CAB_B0_Q28)
+#define CAB_B2_Q28     CAB_B0_Q28
+#define CAB_A1_Q28     APP_COEF_Q28(APP_COEF_LPF_A1(CAB_LPF_FC_HZ, CAB_LPF_Q, DSP_SAMPLE_RATE_HZ))
+#define CAB_A2_Q28     APP_COEF_Q28(APP_COEF_LPF_A2(CAB_LPF_FC_HZ, CAB_LPF_Q, DSP_SAMPLE_RATE_HZ))
+
+#if APP_DSP_FLOAT
+#define CAB_Q28_F(q)                   ((float)(q) * (1.0f / 268435456.0f))
+
+static inline int32_t cab_biquad_s24(BiquadState *st, const int32_t *b, const int32_t *a, int32_t x)
+{
+  const float xf = (float)x;
+  float y = CAB_Q28_F(b[0]) * xf;
+  y += CAB_Q28_F(b[1]) * st->x1;
+  y += CAB_Q28_F(b[2]) * st->x2;
+  y -= CAB_Q28_F(a[0]) * st->y1;
+  y -= CAB_Q28_F(a[1]) * st->y2;
+  y = dsp_clamp_f(y);
+
+  st->x2 = st->x1;
+  st->x1 = xf;
+  st->y2 = st->y1;
+  st->y1 = y;
+  return dsp_f_to_s24(y);
+}
+#else
+static inline int32_t cab_biquad_s24(BiquadState *st, const int32_t *b, const int32_t *a, int32_t x)
+{
+  int64_t acc = 0;
+  acc += (int64_t)b[0] * (int64_t)x;
+  acc += (int64_t)b[1] * (int64_t)st->x1;
+  acc += (int64_t)b[2] * (int64_t)st->x2;
+  acc -= (int64_t)a[0] * (int64_t)st->y1;
+  acc -= (int64_t)a[1] * (int64_t)st->y2;
+
+  int32_t y = (int32_t)(acc >> 28);
+  y = clamp_s24(y);
+
+  st->x2 = st->x1;
+  st->x1 = x;
+  st->y2 = st->y1;
+  st->y1 = y;
+  return y;
+}
+#endif
+
+#if CABSIM_FMAC
+/* Set when the FMAC took the cab filter at the last state reset; the
+ * software biquad runs otherwise.
+ */
+static uint8_t s_cab_fmac = 0;
+#endif
+
+/* ------------------------------ Block stages ------------------------------ */
+
+/* Everything the audio path reads from the control side, sampled once at the
+ * start of a block. The stage loops below only see these plain locals, so the
+ * volatile globals are loaded once per block instead of once per frame.
+ * Continuous parameters arrive already smoothed (DspParamSmooth below).
+ */
+typedef struct DspBlockParams
+{
+  AppFxMask mask;
+  const DspSchedule *sched;
+  uint32_t fx_count;
+  int32_t dist_drive_q8;
+  uint32_t dist_os;
+  uint32_t dist_model;
+  uint32_t cab_ir_shift;         /* convolve 1 / 2^shift of the cab IR's partitions */
+  const int16_t *dist_curve;
+  const int16_t *color_curve;
+  int32_t delay_mix_q15;
+  int32_t delay_feedback_q15;
+  int32_t delay_duck_q15;
+  uint32_t delay_steps;
+  DelayPattern delay_pattern;
+  int32_t reverb_mix_q15;
+  int32_t reverb_feedback_q15[REVERB_FDN_LINES];
+  int32_t reverb_damp_q15[REVERB_FDN_LINES];
+  const ReverbErTap (*reverb_er)[REVERB_ER_TAPS];  /* k_reverb_er[room - 1], NULL = off */
+  int32_t reverb_er_q15;
+  uint32_t reverb_type;
+  uint32_t reverb_diffusion;
+  int32_t reverb_spring_fb_q15;
+  int32_t reverb_in_q15;         /* tank input, glides to 0 on reverb_freeze */
+  uint8_t reverb_frozen;         /* the freeze glide has arrived: no input, no damping */
+  int32_t chorus_mix_q15;
+  uint32_t chorus_rate_mhz;
+  int32_t chorus_depth_q15;
+  uint32_t chorus_time_q16;
+  int32_t chorus_feedback_q15;
+  uint32_t chorus_spread;        /* right tap's LFO phase lead, Q32 turns */
+  int32_t phaser_mix_q15;
+  uint32_t phaser_rate_mhz;
+  int32_t phaser_depth_q15;
+  uint32_t phaser_w0_q20;
+  uint32_t phaser_stages;
+  uint32_t phaser_spread;        /* right channel's LFO phase lead, Q32 turns */
+  int32_t tremolo_depth_q15;
+  uint32_t tremolo_rate_mhz;
+  int32_t tremolo_pan_q15;
+  int32_t wah_mix_q15;
+  int32_t wah_depth_q15;
+  uint32_t wah_w0;
+  int32_t wah_top_s24;           /* envelope at the top of the sweep (from wah_sens_db10) */
+  int32_t wah_damp_q15;
+  int32_t pitch_mix_q15;         /* 0 outside the primary context (one line) */
+  uint32_t pitch_ratio_q16;      /* 2^(pitch_cents / 1200) */
+  uint32_t pitch_window;         /* line steps (from pitch_window_ms) */
+  uint32_t tone_model;           /* AppDspToneModel, APP_DSP_TONE_OFF = no stack */
+  AppTabTone tone;               /* interpolated from the smoothed knobs */
+  uint32_t cab_sections;
+  uint32_t cab_ir;
+#if APP_DSP_CAB_SECTIONS_MAX
+  const int32_t (*cab_sos)[5];   /* front copy, like eq */
+#endif
+  int32_t mod_env;               /* the context's input envelope (compressor detector) after the last block */
+  int32_t in_l2;                 /* the last block's input RMS (level detector), Q16 octaves re full scale */
+  int32_t makeup_q8;
+  int32_t gain_q15;
+  int32_t wet_width_q15;
+  const AppEqCoeffs *eq;         /* front copy; AppEq_Process() takes its own */
+  uint64_t gate_open_ms;
+  int32_t gate_release_frames;
+  CompCurve comp;
+  uint32_t shed_tier;            /* quality tier the block runs at, 0 = full */
+  uint8_t primary;               /* the default context: shared FX, cab hardware, taps */
+#if APP_DSP_BUS_FRAMES
+  struct DspWetBus *wet_bus;     /* the context's wet bus ('+' groups) */
+#endif
+#if DSP_SPILL
+  struct DspBlockParams *spill;  /* the outgoing preset's, NULL = no spill */
+#endif
+} DspBlockParams;
+
+/* The parameters a tail FX runs on this block. */
+static inline const DspBlockParams *fx_params(const FxFade *f, const DspBlockParams *p)
+{
+#if DSP_SPILL
+  return f->spill ? p->spill : p;
+#else
+  (void)f;
+  return p;
+#endif
+}
+
+/* Load shedding (APP_DSP_SHED): AppDsp_ReportLoad() moves the tier on the
+ * audio side after each block, block_params_snapshot() applies it to the
+ * next one through the modules' shed() hooks. The last block's load and
+ * its distortion's declared cost let shed_ahead() step down before a
+ * dearer distortion runs instead of after it.
+ */
+typedef struct
+{
+  uint32_t tier;
+  uint32_t tier_max;      /* deepest shed_tiers in the registry */
+  uint32_t calm_frames;   /* under the low mark since the last step */
+  uint32_t sheds;
+  uint32_t restores;
+  uint32_t cycles;        /* last block's, AppDsp_ReportLoad() */
+  uint32_t budget;
+  uint32_t frames;
+  uint32_t dist_cyc;      /* declared per frame in it, 0 = no distortion */
+} DspShed;
+
+static DspShed s_shed;
+
+static void shed_apply(DspBlockParams *p, uint32_t tier);
+
+/* Smoothed copies of the continuous parameters (DSP_PARAM_SMOOTH_FRAMES). */
+typedef struct
+{
+  DspRamp dist_drive_q8;
+  DspRamp delay_mix_q15;
+  DspRamp delay_feedback_q15;
+  DspRamp reverb_mix_q15;
+  DspRamp reverb_feedback_q15[REVERB_FDN_LINES];
+  DspRamp reverb_damp_q15[REVERB_FDN_LINES];
+  DspRamp reverb_er_q15;
+  DspRamp reverb_spring_fb_q15;
+  DspRamp reverb_in_q15;
+  DspRamp chorus_mix_q15;
+  DspRamp chorus_depth_q15;
+  DspRamp chorus_feedback_q15;
+  DspRamp phaser_mix_q15;
+  DspRamp phaser_depth_q15;
+  DspRamp tremolo_depth_q15;
+  DspRamp tremolo_pan_q15;
+  DspRamp wah_mix_q15;
+  DspRamp wah_depth_q15;
+  DspRamp pitch_mix_q15;
+  DspRamp tone_bass_q15;
+  DspRamp tone_mid_q15;
+  DspRamp tone_treble_q15;
+  DspRamp gain_q15;
+  DspRamp wet_width_q15;
+} DspParamSmooth;
+
+/* Retarget to the host value and advance by one block of n frames. */
+static inline int32_t smooth_block(DspRamp *r, int32_t target, uint32_t n)
+{
+  ramp_set_len(r, target, DSP_PARAM_SMOOTH_FRAMES);
+  return ramp_skip(r, n);
+}
+
+APP_CCM_CODE static void block_params_snapshot(DspParamSmooth *sm, DspBlockParams *p, const DspParams *c,
+                                               AppFxMask mask, uint32_t n)
+{
+  bool has_dist = (mask & APP_FX_BIT_DISTORTION) != 0;
+  bool has_rev  = (mask & APP_FX_BIT_REVERB) != 0;
+  bool has_del  = (mask & APP_FX_BIT_DELAY) != 0;
+  bool has_cho  = (mask & APP_FX_BIT_CHORUS) != 0;
+  bool has_pha  = (mask & APP_FX_BIT_PHASER) != 0;
+
+  p->mask = mask;
+  p->sched = c->sched;
+  p->fx_count = (has_dist ? 1u : 0u) + (has_rev ? 1u : 0u) + (has_del ? 1u : 0u) + (has_cho ? 1u : 0u) +
+                (has_pha ? 1u : 0u);
+  p->dist_drive_q8 = smooth_block(&sm->dist_drive_q8, c->dist_drive_q8, n);
+  p->dist_os = c->dist_os;
+  p->dist_model = c->dist_model;
+  p->cab_ir_shift = 0u;
+  p->dist_curve = AppShaper_Table((AppShaperCurve)c->dist_curve);
+  p->color_curve = AppShaper_Table((AppShaperCurve)c->color_curve);
+  p->delay_mix_q15 = smooth_block(&sm->delay_mix_q15, c->delay_mix_q15, n);
+  p->delay_feedback_q15 = smooth_block(&sm->delay_feedback_q15, c->delay_feedback_q15, n);
+  p->delay_duck_q15 = c->delay_duck_q15;
+  p->delay_steps = c->delay_steps;
+  p->delay_pattern = c->delay_pattern;
+  p->reverb_mix_q15 = smooth_block(&sm->reverb_mix_q15,
+                                   (p->fx_count > 1u) ? c->reverb_mix_all_q15 : c->reverb_mix_q15, n);
+  /* Freeze glides the tank to unity feedback, open dampers (a damping
+   * coefficient of 1 passes the line as it is) and no input; frozen once
+   * all of them are there.
+   */
+  const bool freeze = (c->reverb_freeze != 0u);
+  p->reverb_in_q15 = smooth_block(&sm->reverb_in_q15, freeze ? 0 : 32768, n);
+  bool frozen = freeze && (p->reverb_in_q15 == 0);
+  for (uint32_t k = 0; k < REVERB_FDN_LINES; k++)
+  {
+    p->reverb_feedback_q15[k] = smooth_block(&sm->reverb_feedback_q15[k],
+                                             freeze ? 32768 : c->reverb_line_fb_q15[k], n);
+    p->reverb_damp_q15[k] = smooth_block(&sm->reverb_damp_q15[k],
+                                         freeze ? 32768 : c->reverb_line_damp_q15[k], n);
+    frozen = frozen && (p->reverb_feedback_q15[k] == 32768) && (p->reverb_damp_q15[k] == 32768);
+  }
+  p->reverb_frozen = frozen ? 1u : 0u;
+  p->reverb_er = (c->reverb_room != APP_DSP_REVERB_ROOM_OFF) ? k_reverb_er[c->reverb_room - 1u] : NULL;
+  p->reverb_er_q15 = smooth_block(&sm->reverb_er_q15, c->reverb_er_q15, n);
+  p->reverb_type = c->reverb_type;
+  p->reverb_diffusion = c->reverb_diffusion;
+  p->reverb_spring_fb_q15 = smooth_block(&sm->reverb_spring_fb_q15, freeze ? 32768 : c->reverb_spring_fb_q15, n);
+  p->chorus_mix_q15 = smooth_block(&sm->chorus_mix_q15, c->chorus_mix_q15, n);
+  p->chorus_rate_mhz = c->chorus_rate_mhz;
+  p->chorus_depth_q15 = smooth_block(&sm->chorus_depth_q15, c->chorus_depth_q15, n);
+  p->chorus_time_q16 = c->chorus_time_q16;
+  p->chorus_feedback_q15 = smooth_block(&sm->chorus_feedback_q15, c->chorus_feedback_q15, n);
+  p->chorus_spread = c->chorus_spread_deg * LFO_DEG_TO_Q32;
+  p->phaser_mix_q15 = smooth_block(&sm->phaser_mix_q15, c->phaser_mix_q15, n);
+  p->phaser_rate_mhz = c->phaser_rate_mhz;
+  p->phaser_depth_q15 = smooth_block(&sm->phaser_depth_q15, c->phaser_depth_q15, n);
+  p->phaser_w0_q20 = c->phaser_w0_q20;
+  p->phaser_stages = c->phaser_stages;
+  p->phaser_spread = c->phaser_spread_deg * LFO_DEG_TO_Q32;
+  p->tremolo_depth_q15 = smooth_block(&sm->tremolo_depth_q15, c->tremolo_depth_q15, n);
+  p->tremolo_rate_mhz = c->tremolo_rate_mhz;
+  p->tremolo_pan_q15 = smooth_block(&sm->tremolo_pan_q15, c->tremolo_pan_q15, n);
+  p->wah_mix_q15 = smooth_block(&sm->wah_mix_q15, c->wah_mix_q15, n);
+  p->wah_depth_q15 = smooth_block(&sm->wah_depth_q15, c->wah_depth_q15, n);
+  p->wah_w0 = c->wah_w0;
+  p->wah_top_s24 = AppTab_Db10ToQ15(c->wah_sens_db10) << 8;
+  p->wah_damp_q15 = c->wah_damp_q15;
+  p->pitch_mix_q15 = smooth_block(&sm->pitch_mix_q15, c->pitch_mix_q15, n);
+  p->pitch_ratio_q16 = (uint32_t)AppTab_Exp2(((c->pitch_cents * 65536) / 1200) - 65536) << 2;
+  p->pitch_window = PITCH_MS_TO_STEPS(c->pitch_window_ms);
+  /* Knobs ramp like any gain, so the table is read once per block. */
+  p->tone_model = c->tone_model;
+  p->cab_sections = c->cab_sections;
+  p->cab_ir = c->cab_ir;
+#if APP_DSP_CAB_SECTIONS_MAX
+  p->cab_sos = c->cab_sos;
+#endif
+  const int32_t tb = smooth_block(&sm->tone_bass_q15, c->tone_bass_q15, n);
+  const int32_t tm = smooth_block(&sm->tone_mid_q15, c->tone_mid_q15, n);
+  const int32_t tt = smooth_block(&sm->tone_treble_q15, c->tone_treble_q15, n);
+  if (p->tone_model != APP_DSP_TONE_OFF)
+  {
+    AppTab_Tone(p->tone_model, tb, tm, tt, &p->tone);
+  }
+  /* Tuner mute rides the master volume ramp. */
+  p->gain_q15 = smooth_block(&sm->gain_q15, APP_TUNER_MUTED() ? 0 : c->gain_q15, n);
+  p->wet_width_q15 = smooth_block(&sm->wet_width_q15, c->wet_width_q15, n);
+  p->eq = &c->eq_coeffs;
+#if DSP_FUSED_COND
+  /* The gate sees the signal after the fused input gain. */
+  p->gate_open_ms = (c->gate_open_ms * (uint64_t)((AUDIO_INPUT_GAIN_Q8 * AUDIO_INPUT_GAIN_Q8) >> 8)) >> 8;
+#else
+  p->gate_open_ms = c->gate_open_ms;
+#endif
+  p->gate_release_frames = (int32_t)((c->gate_release_ms * DSP_SAMPLE_RATE_HZ) / 1000U);
+  p->comp = c->comp;
+
+  /* Makeup gain for overall loudness. */
+  p->makeup_q8 = AUDIO_MAKEUP_GAIN_Q8;
+  if (mask != 0)
+  {
+    p->makeup_q8 = (p->makeup_q8 * 3) / 4;
+  }
+
+  /* Let the UI knob actually control delay depth even when multiple FX are
+   * enabled. Keep a small attenuation in stacked mode so it doesn't swamp.
+   */
+  if (p->fx_count > 1u)
+  {
+    p->delay_mix_q15 = (p->delay_mix_q15 * 3) / 4; /* 0.75x */
+  }
+
+  p->shed_tier = s_shed.tier;
+  if (p->shed_tier != 0u)
+  {
+    shed_apply(p, p->shed_tier);
+  }
+}
+
+#if DSP_FUSED_COND
+/* The fused DC block + clean HPF + input gain (cond_process_s24()). */
+typedef struct
+{
+  DspFilt x1;
+  DspFilt x2;
+  DspFilt y1;
+  DspFilt y2;
+  int32_t e1;
+  int32_t e2;
+} CondState;
+#endif
+
+/* One input channel of the always-on conditioning. */
+typedef struct
+{
+#if DSP_FUSED_COND
+  CondState cond;
+#else
+  DcBlockState dc;
+  DcBlockState clean_hpf;
+#endif
+  CompState comp;
+} DspChanState;
+
+/* Block level detector: peak and sum of squares of the conditioned input,
+ * L and R pooled (L only in mono builds), taken in the DC blocker's loop
+ * while the samples are in registers. The gate decides on the energy and
+ * the input meter reads both, so neither makes a pass of its own; blocks
+ * with no reader skip it (dc_block_block() gets NULL).
+ */
+typedef struct
+{
+  uint32_t peak;
+  uint64_t sum_sq;
+} DspLevel;
+
+static inline void level_add(uint32_t *peak, uint64_t *sum_sq, int32_t v)
+{
+  const uint32_t a = (uint32_t)((v < 0) ? -v : v);
+  if (a > *peak) *peak = a;
+  *sum_sq += (uint64_t)((int64_t)v * v);
+}
+
+/* Always-on input conditioning:
+ * DC block + clean HPF -> input gain + compressor -> coloration.
+ * Kept as separate loops so each can be profiled on its own.
+ */
+#if DSP_FUSED_COND
+/* Both first-order HPFs and the input gain as one direct-form I section,
+ * G (1 - z^-1)^2 / ((1 - r1 z^-1)(1 - r2 z^-1)): the numerator is two
+ * subtractions, the gain one multiply. Fixed point feeds the dropped Q28
+ * fraction back through the same (1 - z^-1)^2: the poles sit so close to
+ * DC that plain rounding came out ~16000x louder.
+ */
+
+#if APP_DSP_FLOAT
+static inline int32_t cond_process_s24(CondState *st, int32_t x)
+{
+  const float xf = (float)x;
+  const float w = (xf - (2.0f * st->x1)) + st->x2;
+  float y = (w * ((float)s_rate.cond_g_q24 * (1.0f / 16777216.0f)))
+          - (CAB_Q28_F(s_rate.cond_a_q28[0]) * st->y1) - (CAB_Q28_F(s_rate.cond_a_q28[1]) * st->y2);
+  const float lim = (float)COND_CLAMP_S24;
+  if (y > lim) y = lim;
+  if (y < -lim) y = -lim;
+
+  st->x2 = st->x1;
+  st->x1 = xf;
+  st->y2 = st->y1;
+  st->y1 = y;
+  return (int32_t)y;
+}
+#else
+static inline int32_t cond_process_s24(CondState *st, int32_t x)
+{
+  const int32_t w = (x - (2 * st->x1)) + st->x2;
+  int64_t acc = ((int64_t)w * s_rate.cond_g_q24) * 16;
+  acc -= (int64_t)s_rate.cond_a_q28[0] * st->y1;
+  acc -= (int64_t)s_rate.cond_a_q28[1] * st->y2;
+  acc += (2 * (int64_t)st->e1) - st->e2;
+
+  int32_t y = (int32_t)(acc >> 28);
+  int32_t e = (int32_t)(acc & 0x0FFFFFFF);
+  if ((y > COND_CLAMP_S24) || (y < -COND_CLAMP_S24))
+  {
+    y = (y > 0) ? COND_CLAMP_S24 : -COND_CLAMP_S24;
+    e = 0;
+  }
+
+  st->x2 = st->x1;
+  st->x1 = x;
+  st->y2 = st->y1;
+  st->y1 = y;
+  st->e2 = st->e1;
+  st->e1 = e;
+  return y;
+}
+#endif
+
+/* Output is at the input gain already (comp_block() skips it). */
+APP_CCM_CODE static void dc_block_block(DspChanState *ch, AppStereoS24 *x, uint32_t n, DspLevel *lv)
+{
+  uint32_t peak = 0;
+  uint64_t sum_sq = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    AppStereoS24 v = x[i];
+    v.l = cond_process_s24(&ch[0].cond, v.l);
+#if !APP_DSP_MONO_INPUT
+    v.r = cond_process_s24(&ch[1].cond, v.r);
+#endif
+    x[i] = v;
+    if (lv != NULL)
+    {
+      level_add(&peak, &sum_sq, v.l);
+#if !APP_DSP_MONO_INPUT
+      level_add(&peak, &sum_sq, v.r);
+#endif
+    }
+  }
+  if (lv != NULL)
+  {
+    lv->peak = peak;
+    lv->sum_sq = sum_sq;
+  }
+}
+#else
+APP_CCM_CODE static void dc_block_block(DspChanState *ch, AppStereoS24 *x, uint32_t n, DspLevel *lv)
+{
+  uint32_t peak = 0;
+  uint64_t sum_sq = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    /* Remove DC/subsonic before any gain. */
+    AppStereoS24 v = x[i];
+    v.l = dc_block_s24(&ch[0].dc, v.l);
+#if !APP_DSP_MONO_INPUT
+    v.r = dc_block_s24(&ch[1].dc, v.r);
+#endif
+#if CLEAN_HPF_ENABLE
+    /* Clean rumble removal (tightens low end for guitar cleans). */
+    v.l = hpf1_s24(&ch[0].clean_hpf, v.l, s_rate.clean_hpf_r_q15);
+#if !APP_DSP_MONO_INPUT
+    v.r = hpf1_s24(&ch[1].clean_hpf, v.r, s_rate.clean_hpf_r_q15);
+#endif
+#endif
+    x[i] = v;
+    if (lv != NULL)
+    {
+      level_add(&peak, &sum_sq, v.l);
+#if !APP_DSP_MONO_INPUT
+      level_add(&peak, &sum_sq, v.r);
+#endif
+    }
+  }
+  if (lv != NULL)
+  {
+    lv->peak = peak;
+    lv->sum_sq = sum_sq;
+  }
+}
+#endif
+
+/* Noise gate state. gain is Q15; open follows the detector with hysteresis,
+ * hold counts the frames spent under the close threshold.
+ */
+typedef struct
+{
+  DspRamp gain;
+  uint32_t hold;
+  uint8_t open;
+} GateState;
+
+static inline void gate_reset(GateState *g)
+{
+  ramp_reset(&g->gain, 32768);
+  g->hold = 0U;
+  g->open = 1U;
+}
+
+/* Per-block decision on the detector's energy: opens at once, closes
+ * after the hold.
+ */
+static inline void gate_detect(GateState *g, uint64_t e, uint32_t n, const DspBlockParams *p)
+{
+  const uint64_t open_e = p->gate_open_ms * (uint64_t)(n * GATE_CHANNELS);
+  if (e >= open_e)
+  {
+    g->open = 1U;
+    g->hold = 0U;
+    ramp_set_len(&g->gain, 32768, GATE_ATTACK_FRAMES);
+  }
+  else if (e < (open_e >> GATE_HYST_SHIFT))
+  {
+    if (g->hold < GATE_HOLD_FRAMES)
+    {
+      g->hold += n;
+    }
+    else if (g->open)
+    {
+      g->open = 0U;
+      ramp_set_len(&g->gain, 0, (p->gate_release_frames > 0) ? p->gate_release_frames : 1);
+    }
+  }
+  else
+  {
+    g->hold = 0U;
+  }
+}
+
+/* Gate off ramps back to unity. Unity gain leaves the block untouched. */
+APP_CCM_CODE static void gate_block(GateState *g, AppStereoS24 *x, uint32_t n, const DspBlockParams *p,
+                                    const DspLevel *lv)
+{
+  if (p->gate_open_ms == 0u)
+  {
+    g->open = 1U;
+    g->hold = 0U;
+    ramp_set_len(&g->gain, 32768, GATE_ATTACK_FRAMES);
+  }
+  else
+  {
+    gate_detect(g, lv->sum_sq, n, p);
+  }
+
+  if ((g->gain.cur == 32768) && (g->gain.target == 32768))
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const int32_t gq = ramp_next(&g->gain);
+    x[i].l = mul_s24_q15(x[i].l, gq);
+#if !APP_DSP_MONO_INPUT
+    x[i].r = mul_s24_q15(x[i].r, gq);
+#endif
+  }
+}
+
+APP_CCM_CODE static void comp_block(DspChanState *ch, AppStereoS24 *x, uint32_t n, const DspBlockParams *p)
+{
+  const int32_t makeup_q12 = p->comp.makeup_q12;
+  for (uint32_t i = 0; i < n; i += CLEAN_COMP_SUBBLOCK)
+  {
+    /* Gain computer once per sub-block, on the envelope so far. */
+    const uint32_t end = ((n - i) < CLEAN_COMP_SUBBLOCK) ? n : (i + CLEAN_COMP_SUBBLOCK);
+#if CLEAN_COMP_ENABLE
+    ch[0].comp.target_q15 = comp_target_q15(ch[0].comp.env, &p->comp);
+#if !APP_DSP_MONO_INPUT
+    ch[1].comp.target_q15 = comp_target_q15(ch[1].comp.env, &p->comp);
+#endif
+#endif
+    for (uint32_t j = i; j < end; j++)
+    {
+      /* Gain staging: lift instrument level first. */
+      AppStereoS24 v = x[j];
+#if !DSP_FUSED_COND
+      v.l = gain_s32_q8(v.l, AUDIO_INPUT_GAIN_Q8);
+#endif
+
+      /* Gentle dual-mono compressor for smoother clean dynamics. */
+      clean_comp_process_one_s24(&ch[0].comp, &v.l, makeup_q12);
+#if !APP_DSP_MONO_INPUT
+#if !DSP_FUSED_COND
+      v.r = gain_s32_q8(v.r, AUDIO_INPUT_GAIN_Q8);
+#endif
+      clean_comp_process_one_s24(&ch[1].comp, &v.r, makeup_q12);
+#endif
+      x[j] = v;
+    }
+  }
+}
+
+APP_CCM_CODE static void color_block(AppStereoS24 *x, uint32_t n, const int16_t *curve)
+{
+  /* Subtle always-on coloration. */
+  for (uint32_t i = 0; i < n; i++)
+  {
+    AppStereoS24 v = x[i];
+    v.l = input_color_process_s24(v.l, curve);
+#if !APP_DSP_MONO_INPUT
+    v.r = input_color_process_s24(v.r, curve);
+#endif
+    x[i] = v;
+  }
+}
+
+/* The tone stack over len samples in place, each section's state kept in
+ * registers for the run:
+ *   u = (x - x1) + p * u1                      (Q30)
+ *   y = b0 u + b1 u1 + b2 u2 - a1 y1 - a2 y2   (Q28)
+ * The passive network only cuts, so u stays within the input and y within
+ * the makeup; y is clamped anyway.
+ */
+static inline void tone_stack_s24_len(int32_t *x, uint32_t len, const AppTabTone *c, ToneStackState *st)
+{
+  int32_t x1 = st->x1, u1 = st->y1, e1 = st->e1;
+  int32_t bx1 = st->bx1, bx2 = st->bx2, by1 = st->by1, by2 = st->by2, e2 = st->e2;
+  for (uint32_t i = 0; i < len; i++)
+  {
+    const int32_t in = x[i];
+    int64_t acc = ((int64_t)(in - x1) * (1 << 30)) + ((int64_t)c->p_q30 * u1) + e1;
+    const int32_t u = (int32_t)(acc >> 30);
+    e1 = (int32_t)(acc & 0x3FFFFFFF);
+    x1 = in;
+
+    acc = ((int64_t)c->b_q28[0] * u) + ((int64_t)c->b_q28[1] * bx1) + ((int64_t)c->b_q28[2] * bx2) -
+          ((int64_t)c->a_q28[0] * by1) - ((int64_t)c->a_q28[1] * by2) + e2;
+    const int32_t y = clamp_s24((int32_t)(acc >> 28));
+    e2 = (int32_t)(acc & 0x0FFFFFFF);
+    bx2 = bx1;
+    bx1 = u;
+    u1 = u;
+    by2 = by1;
+    by1 = y;
+    x[i] = y;
+  }
+  st->x1 = x1;
+  st->y1 = u1;
+  st->e1 = e1;
+  st->bx1 = bx1;
+  st->bx2 = bx2;
+  st->by1 = by1;
+  st->by2 = by2;
+  st->e2 = e2;
+}
+
+/* Distortion models (AppDspDistModel): one channel's m clamped samples in
+ * w, clipped in place. drive_q8, os and curve are the block's; color as
+ * distortion_process_s24().
+ */
+typedef void (*DistModelFn)(DistState *st, int32_t *w, uint32_t m, int32_t drive_q8, uint32_t os,
+                            const int16_t *curve, const int16_t *color);
+
+APP_CCM_CODE static void dist_overdrive_len(DistState *st, int32_t *w, uint32_t m, int32_t drive_q8, uint32_t os,
+                                            const int16_t *curve, const int16_t *color)
+{
+  for (uint32_t j = 0; j < m; j++)
+  {
+    w[j] = distortion_process_s24(st, w[j], drive_q8, os, curve, color);
+  }
+}
+
+APP_CCM_CODE static void dist_tube_len(DistState *st, int32_t *w, uint32_t m, int32_t drive_q8, uint32_t os,
+                                       const int16_t *curve, const int16_t *color)
+{
+  (void)curve;
+  const int16_t *tube = AppShaper_Table(APP_SHAPER_TUBE);
+  const int32_t bias_y = AppShaper_S24(tube, DIST_TUBE_BIAS);
+  for (uint32_t j = 0; j < m; j++)
+  {
+    w[j] = dist_voiced_s24(st, w[j], drive_q8, os, tube, DIST_TUBE_BIAS, bias_y, DIST_TUBE_LP_A_Q15, color);
+  }
+}
+
+APP_CCM_CODE static void dist_fuzz_len(DistState *st, int32_t *w, uint32_t m, int32_t drive_q8, uint32_t os,
+                                       const int16_t *curve, const int16_t *color)
+{
+  (void)curve;
+  const int16_t *fuzz = AppShaper_Table(APP_SHAPER_FUZZ);
+  const int32_t bias_y = AppShaper_S24(fuzz, DIST_FUZZ_BIAS);
+  const int32_t drive = drive_q8 << DIST_FUZZ_GAIN_SHIFT;
+  for (uint32_t j = 0; j < m; j++)
+  {
+    w[j] = dist_voiced_s24(st, w[j], drive, os, fuzz, DIST_FUZZ_BIAS, bias_y, DIST_LP_A_Q15, color);
+  }
+}
+
+/* High-pass and clipper at the base rate, whatever os says (the aliasing
+ * is the sound), then a sample-and-hold and a quantizer the drive sets:
+ * per octave of drive above x1 one bit less, from 12 bits down to 4, and
+ * every second octave one more sample held, up to 5 (9.6 kHz).
+ */
+APP_CCM_CODE static void dist_crush_len(DistState *st, int32_t *w, uint32_t m, int32_t drive_q8, uint32_t os,
+                                        const int16_t *curve, const int16_t *color)
+{
+  (void)os;
+  uint32_t oct = 0u;
+  for (uint32_t d = (uint32_t)drive_q8 >> 9; (d != 0u) && (oct < 8u); d >>= 1)
+  {
+    oct++;
+  }
+  const uint32_t shift = 12u + oct;
+  const uint32_t hold = 1u + (oct >> 1);
+  for (uint32_t j = 0; j < m; j++)
+  {
+    int32_t x = (color != NULL) ? input_color_process_s24(w[j], color) : w[j];
+    x = dist_hp_s24(st, x, k_dist_hp_r_q15[0]);
+    if (st->crush_n == 0u)
+    {
+      const int32_t y = dist_shape_s24(x, drive_q8, curve, 0, 0);
+      st->crush_y = (int32_t)((uint32_t)(y >> shift) << shift);
+      st->crush_n = hold;
+    }
+    st->crush_n--;
+    w[j] = st->crush_y;
+  }
+  /* The low-pass rests on the output, for a switch to another model. */
+  st->lp_y1 = st->crush_y;
+}
+
+/* cyc_sample: the declared cost (AppDsp_GetDistModel()), cycles per
+ * channel sample on the M4 at -O3 from CCM, at os 1, 2 and 4; the
+ * "distortion_s24*" and "dist_*" kernels of BENCH KERNEL measure them.
+ * DIST_CYC_SAMPLE_MAX is the largest entry; the module's worst frame adds
+ * the tone stack and cab-sim behind it (DSP_FX_REGISTRY).
+ */
+#define DIST_CYC_SAMPLE_MAX            216U
+#define DIST_CYC_FRAME_MAX             ((DIST_CYC_SAMPLE_MAX * (APP_DSP_MONO_INPUT ? 1U : 2U)) + 150U)
+
+typedef struct
+{
+  const char *name;
+  DistModelFn run;
+  uint16_t cyc_sample[3];
+} DistModel;
+
+static const DistModel k_dist_models[APP_DSP_DIST_MODEL_COUNT] = {
+  {"overdrive", dist_overdrive_len, {48u, 110u, 200u}},
+  {"tube", dist_tube_len, {52u, 118u, 216u}},
+  {"fuzz", dist_fuzz_len, {52u, 118u, 216u}},
+  {"crush", dist_crush_len, {36u, 36u, 36u}},
+};
+
+/* Cycles of one frame of a model at oversampling os. */
+static uint32_t dist_model_cycles(uint32_t model, uint32_t os)
+{
+  const uint32_t k = (os >= 4u) ? 2u : ((os == 2u) ? 1u : 0u);
+  return (uint32_t)k_dist_models[model].cyc_sample[k] * (APP_DSP_MONO_INPUT ? 1u : 2u);
+}
+
+/* Clips 0 < m <= DIST_CHUNK frames of f into wl/wr with the block's
+ * distortion model, then runs the tone stack over the chunk when a model
+ * is selected. f itself is left dry for
+ * the send crossfade. While off, the stack is kept resting on the clipper's
+ * output, so selecting a model does not step through its DC zero.
+ * color: as distortion_process_s24().
+ */
+static inline void dist_chunk(DistFxState *st, const AppStereoS24 *f, uint32_t m, int32_t *wl, int32_t *wr,
+                              const DspBlockParams *p, const int16_t *color)
+{
+  const DistModelFn run = k_dist_models[p->dist_model].run;
+  for (uint32_t j = 0; j < m; j++)
+  {
+    wl[j] = clamp_s24(f[j].l);
+#if !APP_DSP_MONO_INPUT
+    wr[j] = clamp_s24(f[j].r);
+#endif
+  }
+  run(&st->l, wl, m, p->dist_drive_q8, p->dist_os, p->dist_curve, color);
+#if !APP_DSP_MONO_INPUT
+  run(&st->r, wr, m, p->dist_drive_q8, p->dist_os, p->dist_curve, color);
+#endif
+  if (p->tone_model != APP_DSP_TONE_OFF)
+  {
+    tone_stack_s24_len(wl, m, &p->tone, &st->tone_l);
+#if !APP_DSP_MONO_INPUT
+    tone_stack_s24_len(wr, m, &p->tone, &st->tone_r);
+#endif
+  }
+  else
+  {
+    st->tone_l = (ToneStackState){.x1 = wl[m - 1u]};
+#if !APP_DSP_MONO_INPUT
+    st->tone_r = (ToneStackState){.x1 = wr[m - 1u]};
+#endif
+  }
+}
+
+#if CABSIM_FMAC
+/* distortion_block() with the cab on the FMAC: frame j goes in while frame
+ * j-1 comes out and is mixed with its input, still untouched in x.
+ */
+APP_CCM_CODE static void distortion_fmac_block(DistFxState *st, AppStereoS24 *x, uint32_t n, const DspBlockParams *p,
+                                                const int16_t *color)
+{
+  int32_t wl[DIST_CHUNK];
+  int32_t wr[DIST_CHUNK];
+  for (uint32_t i = 0; i < n; i += DIST_CHUNK)
+  {
+    AppStereoS24 *f = &x[i];
+    const uint32_t m = ((n - i) < DIST_CHUNK) ? (n - i) : DIST_CHUNK;
+    dist_chunk(st, f, m, wl, wr, p, color);
+    for (uint32_t j = 0; j <= m; j++)
+    {
+      if (j < m)
+      {
+        AppFmac_Put(wl[j]);
+#if !APP_DSP_MONO_INPUT
+        AppFmac_Put(wr[j]);
+#endif
+      }
+      if (j > 0u)
+      {
+        AppStereoS24 v = f[j - 1u];
+        int32_t g = ramp_next(&st->fade.send);
+        v.l = AppFmac_Get();
+#if !APP_DSP_MONO_INPUT
+        v.r = AppFmac_Get();
+#endif
+        if (g != 32768)
+        {
+          v.l = mix_s24(f[j - 1u].l, v.l, g);
+#if !APP_DSP_MONO_INPUT
+          v.r = mix_s24(f[j - 1u].r, v.r, g);
+#endif
+        }
+        f[j - 1u] = v;
+      }
+    }
+  }
+}
+#endif
+
+#if CABSIM_IR
+/* distortion_block() with the IR cab: each chunk, up to a partition
+ * boundary, is distorted into the convolver, convolved, and mixed with its
+ * input, still untouched in x.
+ */
+APP_CCM_CODE static void distortion_ir_block(DistFxState *st, AppStereoS24 *x, uint32_t n, const DspBlockParams *p,
+                                              const int16_t *color)
+{
+  int32_t wl[DIST_CHUNK];
+  int32_t wr[DIST_CHUNK];
+  uint32_t i = 0;
+  AppCabIr_Limit(p->cab_ir_shift);
+  while (i < n)
+  {
+    float *in[APP_CABIR_CHANNELS];
+    const float *out[APP_CABIR_CHANNELS];
+    AppStereoS24 *f = &x[i];
+    const uint32_t m = AppCabIr_Chunk(((n - i) < DIST_CHUNK) ? (n - i) : DIST_CHUNK, in);
+    dist_chunk(st, f, m, wl, wr, p, color);
+    for (uint32_t j = 0; j < m; j++)
+    {
+      in[0][j] = (float)wl[j];
+#if !APP_DSP_MONO_INPUT
+      in[1][j] = (float)wr[j];
+#endif
+    }
+    AppCabIr_Convolve(m, out);
+    for (uint32_t j = 0; j < m; j++)
+    {
+      AppStereoS24 v = f[j];
+      int32_t g = ramp_next(&st->fade.send);
+      v.l = AppCabIr_ToS24(out[0][j]);
+#if !APP_DSP_MONO_INPUT
+      v.r = AppCabIr_ToS24(out[1][j]);
+#endif
+      if (g != 32768)
+      {
+        v.l = mix_s24(f[j].l, v.l, g);
+#if !APP_DSP_MONO_INPUT
+        v.r = mix_s24(f[j].r, v.r, g);
+#endif
+      }
+      f[j] = v;
+    }
+    i += m;
+  }
+}
+#endif
+
+/* Bound after a stage that mixes its input with an in-range signal. */
+static inline int32_t mag_mix_s24(int32_t peak)
+{
+  return (peak > DSP_MAG_S24) ? peak : DSP_MAG_S24;
+}
+
+#if CABSIM_ENABLE
+/* The biquad cab over a chunk: the user cab's sections one after the other
+ * when it has any, else the fixed lowpass.
+ */
+static inline void cab_chunk(DistFxState *st, int32_t *wl, int32_t *wr, uint32_t m, const DspBlockParams *p)
+{
+  if (p->cab_sections == 0u)
+  {
+    for (uint32_t j = 0; j < m; j++)
+    {
+      wl[j] = cab_biquad_s24(&st->cab_l[0], s_rate.cab_b_q28, s_rate.cab_a_q28, wl[j]);
+#if !APP_DSP_MONO_INPUT
+      wr[j] = cab_biquad_s24(&st->cab_r[0], s_rate.cab_b_q28, s_rate.cab_a_q28, wr[j]);
+#endif
+    }
+    return;
+  }
+#if APP_DSP_CAB_SECTIONS_MAX
+  for (uint32_t k = 0; k < p->cab_sections; k++)
+  {
+    const int32_t *c = p->cab_sos[k];
+    for (uint32_t j = 0; j < m; j++)
+    {
+      wl[j] = cab_biquad_s24(&st->cab_l[k], &c[0], &c[3], wl[j]);
+    }
+#if !APP_DSP_MONO_INPUT
+    for (uint32_t j = 0; j < m; j++)
+    {
+      wr[j] = cab_biquad_s24(&st->cab_r[k], &c[0], &c[3], wr[j]);
+    }
+#endif
+  }
+#endif
+}
+#endif
+
+/* Per DIST_CHUNK frames: clipper, tone stack, cab. While switching, the
+ * result crossfades with the input. The IR and FMAC cabs are the default
+ * context's (the FMAC only for the fixed lowpass); the others run the
+ * biquad cab. color: as distortion_process_s24().
+ */
+static inline void distortion_run(DistFxState *st, AppStereoS24 *x, uint32_t n, const DspBlockParams *p,
+                                  const int16_t *color)
+{
+#if CABSIM_IR
+  if (p->primary && AppCabIr_Active(p->cab_ir))
+  {
+    distortion_ir_block(st, x, n, p, color);
+    return;
+  }
+#endif
+#if CABSIM_FMAC
+  if (p->primary && s_cab_fmac && (p->cab_sections == 0u))
+  {
+    distortion_fmac_block(st, x, n, p, color);
+    return;
+  }
+#endif
+  int32_t wl[DIST_CHUNK];
+  int32_t wr[DIST_CHUNK];
+  for (uint32_t i = 0; i < n; i += DIST_CHUNK)
+  {
+    AppStereoS24 *f = &x[i];
+    const uint32_t m = ((n - i) < DIST_CHUNK) ? (n - i) : DIST_CHUNK;
+    dist_chunk(st, f, m, wl, wr, p, color);
+#if CABSIM_ENABLE
+    cab_chunk(st, wl, wr, m, p);
+#endif
+    for (uint32_t j = 0; j < m; j++)
+    {
+      AppStereoS24 v = f[j];
+      int32_t g = ramp_next(&st->fade.send);
+      v.l = wl[j];
+#if !APP_DSP_MONO_INPUT
+      v.r = wr[j];
+#endif
+      if (g != 32768)
+      {
+        v.l = mix_s24(f[j].l, v.l, g);
+#if !APP_DSP_MONO_INPUT
+        v.r = mix_s24(f[j].r, v.r, g);
+#endif
+      }
+      f[j] = v;
+    }
+  }
+}
+
+APP_CCM_CODE static int32_t distortion_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  distortion_run((DistFxState *)state, x, n, p, NULL);
+  return mag_mix_s24(peak);
+}
+
+/* Post-cab EQ; returns at once while flat, saturates otherwise. Mono input:
+ * left channel only. The filter state is app_eq.c's own.
+ */
+APP_CCM_CODE static int32_t eq_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  (void)state;
+  AppEq_Process(p->eq, x, n, APP_DSP_MONO_INPUT ? 1u : 2u);
+  return mag_mix_s24(peak);
+}
+
+/* Mono input: copy L to R ahead of the first stereo module. */
+APP_CCM_CODE static void mono_to_stereo_block(AppStereoS24 *x, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    x[i].r = x[i].l;
+  }
+}
+
+#if APP_DSP_BUS_FRAMES
+/* Block buses, for one FX group at a time (AppDsp_SetChain()).
+ * Parallel group ('|'), one branch after the other on the block: the group
+ * input waits in dry, the finished branches' sum in wet.
+ * Wet-bus group ('+'): every member reads the same dry block and leaves it
+ * in place, adding its wet output times its mix to wet and its mix times
+ * send, the dry level it takes off, to duck. One HPF/LPF pair then
+ * conditions the sum (wet_bus_mix_step()) instead of one per member.
+ */
+typedef struct
+{
+  AppStereoS24 dry[APP_DSP_BUS_FRAMES];
+  AppStereoS24 wet[APP_DSP_BUS_FRAMES];
+  int32_t peak;                  /* bound on dry */
+} DspFxBus;
+
+typedef struct DspWetBus
+{
+  AppStereoS24 wet[APP_DSP_BUS_FRAMES];
+  int32_t duck[APP_DSP_BUS_FRAMES];
+} DspWetBus;
+
+typedef union
+{
+  DspFxBus par;
+  DspWetBus mix;
+} DspBus;
+
+/* The shared wet conditioning, at the frame rate. */
+typedef struct
+{
+  DcBlockState hpf_l;
+  DcBlockState hpf_r;
+  DspFilt lpf_l;
+  DspFilt lpf_r;
+} DspWetCond;
+
+static inline void wet_bus_add(DspWetBus *b, uint32_t i, int32_t wl, int32_t wr, int32_t mix_q15, int32_t send_q15)
+{
+  b->wet[i].l += (int32_t)(((int64_t)wl * mix_q15) >> 15);
+  b->wet[i].r += (int32_t)(((int64_t)wr * mix_q15) >> 15);
+  b->duck[i] += (int32_t)(((int64_t)mix_q15 * send_q15) >> 15);
+}
+
+/* fade_sleep_block() for a wet-bus member: only the dry level is taken. */
+static void fade_sleep_bus(DspWetBus *b, uint32_t n, FxFade *f, DspRamp *mix)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t send = ramp_next(&f->send);
+    int32_t m = ramp_next(mix);
+    b->duck[i] += (int32_t)(((int64_t)m * send) >> 15);
+  }
+}
+#endif
+
+/* sin(a + b) from sin/cos of a (segment values or steps, Q31) and of b
+ * (Q15), saturated: the rounding of both may add up past full scale.
+ */
+static inline int32_t lfo_turn_q31(int32_t s, int32_t c, int32_t sb, int32_t cb)
+{
+  int64_t v = (((int64_t)s * cb) + ((int64_t)c * sb)) >> 15;
+  v = (v > INT32_MAX) ? INT32_MAX : v;
+  v = (v < INT32_MIN) ? INT32_MIN : v;
+  return (int32_t)v;
+}
+
+/* One Chamberlin SVF step; returns the bandpass at unity peak gain
+ * (damp * bp). The states are not clamped: at resonance bp runs at Q
+ * times the input, well inside int32 for Q <= 10.
+ */
+static inline int32_t wah_svf_s24(WahSvfState *sv, int32_t x, int32_t f_q15, int32_t damp_q15)
+{
+  const int32_t lp = sv->lp + (int32_t)(((int64_t)f_q15 * sv->bp) >> 15);
+  const int32_t hp = x - lp - (int32_t)(((int64_t)damp_q15 * sv->bp) >> 15);
+  const int32_t bp = sv->bp + (int32_t)(((int64_t)f_q15 * hp) >> 15);
+  sv->lp = lp;
+  sv->bp = bp;
+  return clamp_s24((int32_t)(((int64_t)damp_q15 * bp) >> 15));
+}
+
+/* SVF coefficient f = 2 sin(pi fc / fs) in Q15 at sweep position pos. */
+static inline int32_t wah_coef_q15(int32_t pos, uint32_t w0, int32_t span_q16)
+{
+  const int32_t oct = (int32_t)(((int64_t)pos * span_q16) >> 15);
+  uint64_t w = ((uint64_t)w0 * (uint32_t)AppTab_Exp2(oct - (WAH_SPAN_OCT << 16))) >> (15 - WAH_SPAN_OCT);
+  w = (w > WAH_PHASE_MAX) ? WAH_PHASE_MAX : w;
+  return 2 * AppTab_Sin((uint32_t)w);
+}
+
+/* Mono module, ahead of the distortion. The sweep position glides over
+ * the block to the envelope's, and the coefficient follows it every
+ * WAH_SUB frames; left and right share it. Always in the chain, it passes
+ * the block untouched at mix 0.
+ */
+APP_CCM_CODE static int32_t wah_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  WahFxState *st = (WahFxState *)state;
+  if (p->wah_mix_q15 == 0)
+  {
+    return peak;
+  }
+
+  const uint32_t e = (p->mod_env > 0) ? (uint32_t)p->mod_env : 0U;
+  const uint32_t pos = (e > 0U) ? AppTab_DivQ15(e, (uint32_t)p->wah_top_s24) : 0U;
+  ramp_set_len(&st->pos, (pos > 32768U) ? 32768 : (int32_t)pos, (int32_t)n);
+  const int32_t span = p->wah_depth_q15 * (2 * WAH_SPAN_OCT);
+  const int32_t damp = p->wah_damp_q15;
+  const int32_t m = p->wah_mix_q15;
+
+  for (uint32_t i = 0; i < n; i += WAH_SUB)
+  {
+    const uint32_t end = ((n - i) < WAH_SUB) ? n : (i + WAH_SUB);
+    const int32_t f = wah_coef_q15(ramp_skip(&st->pos, end - i), p->wah_w0, span);
+    for (uint32_t j = i; j < end; j++)
+    {
+      x[j].l = mix_s24(x[j].l, wah_svf_s24(&st->l, clamp_s24(x[j].l), f, damp), m);
+#if !APP_DSP_MONO_INPUT
+      x[j].r = mix_s24(x[j].r, wah_svf_s24(&st->r, clamp_s24(x[j].r), f, damp), m);
+#endif
+    }
+  }
+  return mag_mix_s24(peak);
+}
+
+#if APP_DSP_PITCH_ENABLE
+/* One line step: decimated input v in, the pair's two output frames out
+ * (the in-between one returned, the aligned one in held_out). The write
+ * comes first, so distance 0 is v itself; no head reaches further back
+ * than what was written since the module went on, which spares clearing
+ * the line.
+ */
+static inline int32_t pitch_step_s24(PitchFxState *st, int32_t v, uint32_t window, int32_t du)
+{
+  AppDline_Write1(s_pitch_buf, st->idx, clamp_s24(v), PITCH_STORAGE);
+  st->fill += (st->fill < PITCH_LEN) ? 1U : 0U;
+  const uint32_t lim = (st->fill - 1U) << 16;
+  const uint32_t u = st->u;
+  uint32_t d1 = (uint32_t)(((uint64_t)u * window) >> 16);
+  uint32_t d2 = (uint32_t)(((uint64_t)(u + 0x80000000U) * window) >> 16);
+  d1 = (d1 < lim) ? d1 : lim;
+  d2 = (d2 < lim) ? d2 : lim;
+  const int32_t t1 = AppDline_Tap1(s_pitch_buf, PITCH_LEN, st->idx, d1, PITCH_STORAGE);
+  const int32_t t2 = AppDline_Tap1(s_pitch_buf, PITCH_LEN, st->idx, d2, PITCH_STORAGE);
+  st->idx = (st->idx + 1U < PITCH_LEN) ? (st->idx + 1U) : 0U;
+  st->u = u + (uint32_t)du;
+
+  /* Hann weights: sin^2(pi u) for the first head, cos^2 for the second. */
+  const int32_t s = AppTab_Sin(u >> 1);
+  const int32_t g1 = (s * s) >> 15;
+  const int32_t y = t2 + (int32_t)(((int64_t)(t1 - t2) * g1) >> 15);
+
+  int32_t w;
+  dist_hb_up2(&st->hb, y, k_dist_hb1_q15, DIST_HB1_TAPS, &w, &st->held_out);
+  return clamp_s24(w);
+}
+
+/* Mono module, ahead of the distortion: the L/R average is decimated by
+ * two into the line and the crossfaded heads interpolated back to the
+ * frame rate, mixed into both sides. One divide per block gives the
+ * heads' drift. The wet path trails the dry by ~13 frames of halfband
+ * delay on top of the heads' own. Always in the chain, it passes the
+ * block untouched at mix 0 and starts over from an empty line.
+ */
+APP_CCM_CODE static int32_t pitch_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p,
+                                        int32_t peak)
+{
+  PitchFxState *st = (PitchFxState *)state;
+  if (p->pitch_mix_q15 == 0)
+  {
+    if (st->fill != 0U)
+    {
+      memset(st, 0, sizeof(*st));
+    }
+    return peak;
+  }
+
+  const uint32_t window = p->pitch_window;
+  const int32_t du = (int32_t)((((int64_t)65536 - (int64_t)p->pitch_ratio_q16) * 65536) / (int64_t)window);
+  const int32_t m = p->pitch_mix_q15;
+  for (uint32_t i = 0; i < n; i++)
+  {
+#if APP_DSP_MONO_INPUT
+    const int32_t mono = clamp_s24(x[i].l);
+#else
+    const int32_t mono = (clamp_s24(x[i].l) >> 1) + (clamp_s24(x[i].r) >> 1);
+#endif
+    int32_t w;
+    if (st->phase == 0U)
+    {
+      st->held_in = mono;
+      w = st->held_out;
+      st->phase = 1U;
+    }
+    else
+    {
+      const int32_t v = dist_hb_down2(&st->hb, st->held_in, mono, k_dist_hb1_q15, DIST_HB1_TAPS);
+      w = pitch_step_s24(st, v, window, du);
+      st->phase = 0U;
+    }
+    x[i].l = mix_s24(x[i].l, w, m);
+#if !APP_DSP_MONO_INPUT
+    x[i].r = mix_s24(x[i].r, w, m);
+#endif
+  }
+  return mag_mix_s24(peak);
+}
+
+#endif
+
+/* One first-order allpass over len samples in place,
+ * y = c * (x - y1) + x1: the stage's state stays in registers for the
+ * whole run. Clamped per sample, as allpass_one_s24().
+ */
+static inline void allpass1_process_s24_len(int32_t *x, uint32_t len, int32_t c_q15, PhaserApState *ap)
+{
+  int32_t x1 = ap->x1;
+  int32_t y1 = ap->y1;
+  for (uint32_t i = 0; i < len; i++)
+  {
+    const int32_t in = x[i];
+    y1 = clamp_s24((int32_t)(((int64_t)c_q15 * (in - y1)) >> 15) + x1);
+    x1 = in;
+    x[i] = y1;
+  }
+  ap->x1 = x1;
+  ap->y1 = y1;
+}
+
+/* Allpass coefficient for LFO value v (Q15): the corner sits span_q16
+ * octaves above w0 at v = 1 and at w0 at v = -1, c = -(1 - w) / (1 + w).
+ */
+static inline int32_t phaser_coef_q15(int32_t v, uint32_t w0_q20, int32_t span_q16)
+{
+  const int32_t oct = (int32_t)(((int64_t)((v + 32768) >> 1) * span_q16) >> 15);
+  int32_t w = (int32_t)(((int64_t)w0_q20 * AppTab_Exp2(oct - (PHASER_SPAN_OCT << 16))) >> (15 - PHASER_SPAN_OCT));
+  w = (w > PHASER_W_MAX_Q20) ? PHASER_W_MAX_Q20 : w;
+  return -(int32_t)AppTab_DivQ15((uint32_t)(PHASER_ONE_Q20 - w), (uint32_t)(PHASER_ONE_Q20 + w));
+}
+
+/* Stereo: per PHASER_SUB frames, new coefficients from the LFO segment
+ * (the right channel's turned by the spread, as in chorus_block()), then
+ * each stage over the whole sub-block, left and right. The send fades the
+ * wet share in and out like distortion_block(); no tail, so the state
+ * just stops while off. Bounds as distortion_block().
+ */
+APP_CCM_CODE static int32_t phaser_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  PhaserFxState *st = (PhaserFxState *)state;
+  ramp_set(&st->mix, p->phaser_mix_q15);
+  if (st->rate_mhz != p->phaser_rate_mhz)
+  {
+    st->rate_mhz = p->phaser_rate_mhz;
+    AppLfo_SetRate(&st->lfo, st->rate_mhz, DSP_SAMPLE_RATE_HZ);
+  }
+
+  AppLfoSeg ml;
+  AppLfo_Block(&st->lfo, n, &ml);
+  int32_t sb;
+  int32_t cb;
+  AppLfo_SinCos(p->phaser_spread, &sb, &cb);
+  /* The positions run in uint32_t: the last step may wrap past full scale. */
+  uint32_t vl = (uint32_t)ml.sin_q31;
+  uint32_t vr = (uint32_t)lfo_turn_q31(ml.sin_q31, ml.cos_q31, sb, cb);
+  const uint32_t dvl = (uint32_t)ml.dsin_q31;
+  const uint32_t dvr = (uint32_t)lfo_turn_q31(ml.dsin_q31, ml.dcos_q31, sb, cb);
+  const int32_t span = p->phaser_depth_q15 * (2 * PHASER_SPAN_OCT);
+
+  int32_t wl[PHASER_SUB];
+  int32_t wr[PHASER_SUB];
+  for (uint32_t i = 0; i < n; i += PHASER_SUB)
+  {
+    const uint32_t len = ((n - i) < PHASER_SUB) ? (n - i) : PHASER_SUB;
+    const int32_t cl = phaser_coef_q15((int32_t)vl >> 16, p->phaser_w0_q20, span);
+    const int32_t cr = phaser_coef_q15((int32_t)vr >> 16, p->phaser_w0_q20, span);
+    vl += dvl * len;
+    vr += dvr * len;
+
+    for (uint32_t j = 0; j < len; j++)
+    {
+      wl[j] = clamp_s24(x[i + j].l);
+      wr[j] = clamp_s24(x[i + j].r);
+    }
+    for (uint32_t k = 0; k < p->phaser_stages; k++)
+    {
+      allpass1_process_s24_len(wl, len, cl, &st->ap_l[k]);
+      allpass1_process_s24_len(wr, len, cr, &st->ap_r[k]);
+    }
+    for (uint32_t j = 0; j < len; j++)
+    {
+      const int32_t send = ramp_next(&st->fade.send);
+      const int32_t m = (int32_t)(((int64_t)ramp_next(&st->mix) * send) >> 15);
+      x[i + j].l = mix_s24(x[i + j].l, wl[j], m);
+      x[i + j].r = mix_s24(x[i + j].r, wr[j], m);
+    }
+  }
+  return mag_mix_s24(peak);
+}
+
+#if APP_DSP_CHORUS_ENABLE
+/* Tap distance for LFO value v (Q15): centre * (1 + depth * v), at least
+ * one step so no tap reads the slot being written.
+ */
+static inline uint32_t chorus_dist_q16(uint32_t centre_q16, int32_t swing_q16, int32_t v)
+{
+  int32_t d = (int32_t)centre_q16 + (int32_t)(((int64_t)swing_q16 * v) >> 15);
+  return (d < 65536) ? 65536U : (uint32_t)d;
+}
+
+/* One line step: decimated mono input v in, the pair's two output frames
+ * out (the in-between one returned, the aligned one in held_out). Both
+ * taps read before the write; their average is the feedback.
+ */
+static inline AppStereoS24 chorus_step_s24(ChorusFxState *st, int32_t v, int32_t ml, int32_t mr,
+                                           const DspBlockParams *p)
+{
+  st->time_q16 = delay_glide_q16(st->time_q16, p->chorus_time_q16);
+  const int32_t swing = (int32_t)(((int64_t)st->time_q16 * p->chorus_depth_q15) >> 15);
+  const int32_t tl = AppDline_Tap1(s_chorus_buf, CHORUS_LEN, st->idx, chorus_dist_q16(st->time_q16, swing, ml),
+                                   CHORUS_STORAGE);
+  const int32_t tr = AppDline_Tap1(s_chorus_buf, CHORUS_LEN, st->idx, chorus_dist_q16(st->time_q16, swing, mr),
+                                   CHORUS_STORAGE);
+  const int32_t fb = mul_hi32((tl + tr) * 128, p->chorus_feedback_q15 * 512);   /* (tl + tr) * fb >> 16 */
+  AppDline_Write1(s_chorus_buf, st->idx, clamp_s24(v + fb), CHORUS_STORAGE);
+  st->idx = (st->idx + 1U < CHORUS_LEN) ? (st->idx + 1U) : 0U;
+
+  AppStereoS24 w;
+  dist_hb_up2(&st->hb_l, tl, k_dist_hb1_q15, DIST_HB1_TAPS, &w.l, &st->held_out.l);
+  dist_hb_up2(&st->hb_r, tr, k_dist_hb1_q15, DIST_HB1_TAPS, &w.r, &st->held_out.r);
+  w.l = clamp_s24(w.l);
+  w.r = clamp_s24(w.r);
+  return w;
+}
+
+/* Stereo out of a mono line: the send's L/R average is decimated by two
+ * into the line, two taps swept by one LFO in quadrature (chorus_spread)
+ * are interpolated back to the frame rate, one per side. One CORDIC call
+ * per block gives the left segment (app_lfo.h), one more turns it into the
+ * right one; per line step that is two adds. The wet path trails the dry
+ * by ~13 frames of halfband delay, which also bounds the shortest
+ * flanger distance. Bounds in and out as delay_block().
+ */
+APP_CCM_CODE static int32_t chorus_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  ChorusFxState *st = (ChorusFxState *)state;
+  ramp_set(&st->mix, p->chorus_mix_q15);
+  peak = tail_in_block(x, n, peak);
+  if (!fade_wake(&st->fade, x, n))
+  {
+    fade_sleep_block(x, n, &st->fade, &st->mix);
+    return peak;
+  }
+  if (st->rate_mhz != p->chorus_rate_mhz)
+  {
+    st->rate_mhz = p->chorus_rate_mhz;
+    AppLfo_SetRate(&st->lfo, st->rate_mhz, CHORUS_FS_HZ);
+  }
+
+  /* The block's line steps: the second frame of every pair. */
+  AppLfoSeg ml;
+  AppLfo_Block(&st->lfo, (n + st->phase) >> 1, &ml);
+  int32_t sb;
+  int32_t cb;
+  AppLfo_SinCos(p->chorus_spread, &sb, &cb);
+  /* The positions run in uint32_t: the last step may wrap past full scale. */
+  uint32_t vl = (uint32_t)ml.sin_q31;
+  uint32_t vr = (uint32_t)lfo_turn_q31(ml.sin_q31, ml.cos_q31, sb, cb);
+  const uint32_t dvl = (uint32_t)ml.dsin_q31;
+  const uint32_t dvr = (uint32_t)lfo_turn_q31(ml.dsin_q31, ml.dcos_q31, sb, cb);
+
+  int32_t mag = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    AppStereoS24 dry = {tail_dry_s24(x[i].l), tail_dry_s24(x[i].r)};
+    int32_t send = ramp_next(&st->fade.send);
+    int32_t mix = ramp_next(&st->mix);
+    AppStereoS24 in = {(int32_t)(((int64_t)dry.l * send) >> 15), (int32_t)(((int64_t)dry.r * send) >> 15)};
+    const int32_t mono = (in.l >> 1) + (in.r >> 1);
+    AppStereoS24 w;
+    if (st->phase == 0U)
+    {
+      st->held_in = mono;
+      w = st->held_out;
+      st->phase = 1U;
+    }
+    else
+    {
+      const int32_t v = dist_hb_down2(&st->hb_l, st->held_in, mono, k_dist_hb1_q15, DIST_HB1_TAPS);
+      w = chorus_step_s24(st, v, (int32_t)vl >> 16, (int32_t)vr >> 16, p);
+      vl += dvl;
+      vr += dvr;
+      st->phase = 0U;
+    }
+    fade_track_tail(&st->fade, &in, w.l, w.r);
+    x[i].l = mix_spill_s24(dry.l, w.l, mix, send);
+    x[i].r = mix_spill_s24(dry.r, w.r, mix, send);
+    mag |= mag_s24(x[i].l) | mag_s24(x[i].r);
+  }
+  return mag;
+}
+
+#endif
+
+/* Ducking, once per block: the wet gain ramps across the block towards
+ * the duck the input level asks for (the level detector's RMS of the
+ * last block, DspBlockParams.in_l2). Returns 0 while the gain is unity, so
+ * the loops skip it.
+ */
+static inline uint8_t delay_duck(DelayFxState *st, const DspBlockParams *p, uint32_t n)
+{
+  int32_t g = 32768;
+  if (p->delay_duck_q15 != 0)
+  {
+    const int32_t fall = st->duck_l2 - (DELAY_DUCK_FALL_L2 * (int32_t)n);
+    const int32_t in = (p->in_l2 < (DELAY_DUCK_THRESH_L2 + DELAY_DUCK_RANGE_L2)) ?
+                       p->in_l2 : (DELAY_DUCK_THRESH_L2 + DELAY_DUCK_RANGE_L2);
+    st->duck_l2 = (in > fall) ? in : ((fall > DSP_LEVEL_FLOOR_L2) ? fall : DSP_LEVEL_FLOOR_L2);
+    const int32_t over = st->duck_l2 - DELAY_DUCK_THRESH_L2;
+    if (over > 0)
+    {
+      const int32_t amount_q15 = (int32_t)(((int64_t)over * 32768) / DELAY_DUCK_RANGE_L2);
+      g = 32768 - (int32_t)(((int64_t)p->delay_duck_q15 * amount_q15) >> 15);
+    }
+  }
+  else
+  {
+    st->duck_l2 = DSP_LEVEL_FLOOR_L2;
+  }
+  ramp_set_len(&st->duck, g, (int32_t)n);
+  return ((st->duck.cur != 32768) || (g != 32768)) ? 1U : 0U;
+}
+
+/* Stereo: both channels go through the packed delay line together.
+ * peak bounds the input; returns the output's bound.
+ */
+APP_CCM_CODE static int32_t delay_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  DelayFxState *st = (DelayFxState *)state;
+  p = fx_params(&st->fade, p);
+  ramp_set(&st->mix, p->delay_mix_q15);
+  const uint8_t duck = delay_duck(st, p, n);
+  peak = tail_in_block(x, n, peak);
+  if (!fade_wake(&st->fade, x, n))
+  {
+    fade_sleep_block(x, n, &st->fade, &st->mix);
+    return peak;
+  }
+  /* The wet mix can spill past s24: OR of the magnitudes, exact against
+   * DSP_MAG_S24 (all low 23 bits set).
+   */
+  int32_t mag = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t dry_l = tail_dry_s24(x[i].l);
+    int32_t dry_r = tail_dry_s24(x[i].r);
+    int32_t send = ramp_next(&st->fade.send);
+    int32_t mix = ramp_next(&st->mix);
+    AppStereoS24 in = {(int32_t)(((int64_t)dry_l * send) >> 15), (int32_t)(((int64_t)dry_r * send) >> 15)};
+    delay_process_s24(in.l, in.r, s_delay_buf, &st->line, p->delay_steps, p->delay_feedback_q15, &p->delay_pattern);
+    int32_t wl = st->line.last_out_l_s24;
+    int32_t wr = st->line.last_out_r_s24;
+#if WET_HPF_ENABLE
+    wl = hpf1_s24(&st->wet_hpf_l, wl, s_rate.wet_hpf_r_q15);
+    wr = hpf1_s24(&st->wet_hpf_r, wr, s_rate.wet_hpf_r_q15);
+#endif
+    wl = onepole_lpf_s24(wl, &st->wet_lpf_l, s_rate.wet_lpf_a_q15);
+    wr = onepole_lpf_s24(wr, &st->wet_lpf_r, s_rate.wet_lpf_a_q15);
+    fade_track_tail(&st->fade, &in, wl, wr);
+    if (duck)
+    {
+      const int32_t g = ramp_next(&st->duck);
+      wl = mul_s24_q15(wl, g);
+      wr = mul_s24_q15(wr, g);
+    }
+    x[i].l = mix_spill_s24(dry_l, wl, mix, send);
+    x[i].r = mix_spill_s24(dry_r, wr, mix, send);
+    mag |= mag_s24(x[i].l) | mag_s24(x[i].r);
+  }
+  return mag;
+}
+
+#if APP_DSP_BUS_FRAMES
+/* delay_block() on the wet bus: the line output goes to the bus
+ * unconditioned and x keeps the dry input.
+ */
+APP_CCM_CODE static int32_t delay_bus_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  DelayFxState *st = (DelayFxState *)state;
+  p = fx_params(&st->fade, p);
+  DspWetBus *b = p->wet_bus;
+  ramp_set(&st->mix, p->delay_mix_q15);
+  const uint8_t duck = delay_duck(st, p, n);
+  peak = tail_in_block(x, n, peak);
+  if (!fade_wake(&st->fade, x, n))
+  {
+    fade_sleep_bus(b, n, &st->fade, &st->mix);
+    return peak;
+  }
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t send = ramp_next(&st->fade.send);
+    int32_t mix = ramp_next(&st->mix);
+    AppStereoS24 in = {(int32_t)(((int64_t)tail_dry_s24(x[i].l) * send) >> 15),
+                       (int32_t)(((int64_t)tail_dry_s24(x[i].r) * send) >> 15)};
+    delay_process_s24(in.l, in.r, s_delay_buf, &st->line, p->delay_steps, p->delay_feedback_q15, &p->delay_pattern);
+    fade_track_tail(&st->fade, &in, st->line.last_out_l_s24, st->line.last_out_r_s24);
+    int32_t wl = st->line.last_out_l_s24;
+    int32_t wr = st->line.last_out_r_s24;
+    if (duck)
+    {
+      const int32_t g = ramp_next(&st->duck);
+      wl = mul_s24_q15(wl, g);
+      wr = mul_s24_q15(wr, g);
+    }
+    wet_bus_add(b, i, wl, wr, mix, send);
+  }
+  return peak;
+}
+#endif
+
+/* Closes a recording at the current position. */
+static inline void loop_close(LoopState *st, AppDspLoopState next)
+{
+  st->len = st->pos;
+  st->pos = 0U;
+  st->state = (st->len != 0U) ? next : APP_DSP_LOOP_EMPTY;
+}
+
+/* Applies a command queued since the last block. */
+static void loop_request(LoopState *st)
+{
+  const uint32_t req = s_loop_req;
+  if ((req >> 8) == st->req_seen)
+  {
+    return;
+  }
+  st->req_seen = req >> 8;
+
+  const AppDspLoopState s = st->state;
+  switch ((AppDspLoopCmd)(req & 0xFFU))
+  {
+    case APP_DSP_LOOP_CMD_REC:
+      if (s == APP_DSP_LOOP_EMPTY)
+      {
+        st->pos = 0U;
+        st->len = 0U;
+        st->state = APP_DSP_LOOP_RECORD;
+      }
+      else if (s == APP_DSP_LOOP_RECORD)
+      {
+        loop_close(st, APP_DSP_LOOP_OVERDUB);
+      }
+      else if (s == APP_DSP_LOOP_OVERDUB)
+      {
+        st->state = APP_DSP_LOOP_PLAY;
+      }
+      else
+      {
+        if (s == APP_DSP_LOOP_STOPPED)
+        {
+          st->pos = 0U;
+        }
+        st->state = APP_DSP_LOOP_OVERDUB;
+      }
+      break;
+    case APP_DSP_LOOP_CMD_PLAY:
+      if (s == APP_DSP_LOOP_RECORD)
+      {
+        loop_close(st, APP_DSP_LOOP_PLAY);
+      }
+      else if (s != APP_DSP_LOOP_EMPTY)
+      {
+        if (s == APP_DSP_LOOP_STOPPED)
+        {
+          st->pos = 0U;
+        }
+        st->state = APP_DSP_LOOP_PLAY;
+      }
+      break;
+    case APP_DSP_LOOP_CMD_STOP:
+      if (s == APP_DSP_LOOP_RECORD)
+      {
+        loop_close(st, APP_DSP_LOOP_STOPPED);
+      }
+      else if (s != APP_DSP_LOOP_EMPTY)
+      {
+        st->state = APP_DSP_LOOP_STOPPED;
+      }
+      break;
+    default:
+      st->state = APP_DSP_LOOP_EMPTY;
+      st->len = 0U;
+      st->pos = 0U;
+      ramp_reset(&st->gain, 0);
+      break;
+  }
+  ramp_set(&st->gain, ((st->state == APP_DSP_LOOP_PLAY) || (st->state == APP_DSP_LOOP_OVERDUB)) ? 32768 : 0);
+}
+
+/* One pass over the chunk's k steps on the line: in[] are the new steps,
+ * out[] the loop as read before this pass wrote them.
+ */
+APP_CCM_CODE static void loop_steps(LoopState *st, const int32_t *in, int32_t *out, uint32_t k)
+{
+  uint32_t *buf = st->buf;
+  uint32_t pos = st->pos;
+  uint32_t len = st->len;
+
+  switch (st->state)
+  {
+    case APP_DSP_LOOP_RECORD:
+      for (uint32_t j = 0; j < k; j++)
+      {
+        out[j] = 0;
+        if (pos < st->cap)
+        {
+          AppDline_Write1(buf, pos, clamp_s24(in[j]), APP_DSP_LOOP_STORAGE);
+          pos++;
+        }
+      }
+      st->pos = pos;
+      st->len = pos;
+      if (pos >= st->cap)
+      {
+        /* Buffer full: the loop closes on itself and plays. */
+        loop_close(st, APP_DSP_LOOP_PLAY);
+        ramp_set(&st->gain, 32768);
+      }
+      return;
+    case APP_DSP_LOOP_OVERDUB:
+      for (uint32_t j = 0; j < k; j++)
+      {
+        const int32_t y = AppDline_Read1(buf, pos, APP_DSP_LOOP_STORAGE);
+        AppDline_Write1(buf, pos, clamp_s24(y + in[j]), APP_DSP_LOOP_STORAGE);
+        out[j] = y;
+        pos = (pos + 1U < len) ? (pos + 1U) : 0U;
+      }
+      break;
+    default:
+      for (uint32_t j = 0; j < k; j++)
+      {
+        out[j] = AppDline_Read1(buf, pos, APP_DSP_LOOP_STORAGE);
+        pos = (pos + 1U < len) ? (pos + 1U) : 0U;
+      }
+      break;
+  }
+  st->pos = pos;
+}
+
+/* Drops the loop and the resampler state; the buffer stays. */
+static void loop_reset(void)
+{
+  LoopState *st = &s_loop;
+  st->state = APP_DSP_LOOP_EMPTY;
+  st->len = 0U;
+  st->pos = 0U;
+  st->req_seen = s_loop_req >> 8;
+  st->phase = 0U;
+  memset(st->dec, 0, sizeof(st->dec));
+  memset(st->hist, 0, sizeof(st->hist));
+  ramp_reset(&st->gain, 0);
+}
+
+/* Bench: overdub over a loop of the whole buffer, the loaded path. */
+static void loop_bench(void)
+{
+  LoopState *st = &s_loop;
+  if (st->state != APP_DSP_LOOP_OVERDUB)
+  {
+    st->len = st->cap;
+    st->pos = 0U;
+    st->state = (st->cap != 0U) ? APP_DSP_LOOP_OVERDUB : APP_DSP_LOOP_EMPTY;
+    ramp_reset(&st->gain, 32768);
+  }
+}
+
+/* After the reverb: the mono sum goes to the line, the loop is added to both
+ * sides. Returns at once while there is nothing to record or play, with the
+ * bound peak unchanged; the mix saturates otherwise.
+ */
+APP_CCM_CODE static int32_t loop_block(AppStereoS24 *x, uint32_t n, int32_t peak)
+{
+  LoopState *st = &s_loop;
+  if (st->cap == 0U)
+  {
+    return peak;
+  }
+  loop_request(st);
+  if (!loop_busy())
+  {
+    return peak;
+  }
+
+  int32_t in[LOOP_CHUNK_STEPS + 1U];
+  int32_t out[LOOP_CHUNK_STEPS + 1U];
+  for (uint32_t c = 0; c < n; c += LOOP_CHUNK_FRAMES)
+  {
+    const uint32_t m = ((n - c) < LOOP_CHUNK_FRAMES) ? (n - c) : LOOP_CHUNK_FRAMES;
+    AppStereoS24 *f = &x[c];
+
+    /* Decimate, as on the delay line's write side. */
+    uint32_t p = st->phase;
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < m; i++)
+    {
+      const int32_t v = (clamp_s24(f[i].l) + clamp_s24(f[i].r)) >> 1;
+      st->dec[0] += (int64_t)k_delay_rs_q15[2][p] * v;
+      st->dec[1] += (int64_t)k_delay_rs_q15[1][p] * v;
+      st->dec[2] += (int64_t)k_delay_rs_q15[0][p] * v;
+      if (p == (DELAY_DECIM - 1U))
+      {
+        in[k++] = (int32_t)(st->dec[0] >> 15);
+        st->dec[0] = st->dec[1];
+        st->dec[1] = st->dec[2];
+        st->dec[2] = 0;
+      }
+      p = (p + 1U) & (DELAY_DECIM - 1U);
+    }
+
+    loop_steps(st, in, out, k);
+
+    /* Interpolate and mix; each step enters the history at the frame that
+     * produced it.
+     */
+    p = st->phase;
+    k = 0;
+    for (uint32_t i = 0; i < m; i++)
+    {
+      if (p == (DELAY_DECIM - 1U))
+      {
+        st->hist[2] = st->hist[1];
+        st->hist[1] = st->hist[0];
+        st->hist[0] = out[k++];
+      }
+      p = (p + 1U) & (DELAY_DECIM - 1U);
+      const int32_t y = delay_interp_s24(k_delay_rs_q15[0][p], k_delay_rs_q15[1][p], k_delay_rs_q15[2][p],
+                                         st->hist[0], st->hist[1], st->hist[2]);
+      const int32_t g = ramp_next(&st->gain);
+      const int32_t w = (int32_t)(((int64_t)y * g) >> 15);
+      f[i].l = clamp_s24(f[i].l + w);
+      f[i].r = clamp_s24(f[i].r + w);
+    }
+    st->phase = (uint8_t)p;
+  }
+  return DSP_MAG_S24;
+}
+
+/* FDN (tank: the block-local copy) or spring plus, unless on the wet bus,
+ * wet conditioning, at the reverb rate. cond is a constant in each instance.
+ */
+static inline __attribute__((always_inline)) void reverb_wet_s24(AppStereoS24 *w, ReverbFxState *rs, ReverbState *tank,
+                                                                 const DspBlockParams *p, bool cond)
+{
+#if APP_DSP_SPRING_ENABLE
+  if (p->reverb_type == APP_DSP_REVERB_TYPE_SPRING)
+  {
+#if REVERB_MONO_IN
+    const int32_t in = w->l;
+#else
+    const int32_t in = (w->l + w->r) >> 1;
+#endif
+    w->l = spring_frame_s24(spring_state(), in, s_reverb_fdn, p->reverb_spring_fb_q15);
+    w->r = w->l;
+  }
+  else
+#else
+  (void)rs;
+#endif
+  {
+    reverb_process_s24(w, s_reverb_fdn, s_reverb_ap, tank,
+                       p->reverb_feedback_q15, p->reverb_damp_q15, p->reverb_er, p->reverb_er_q15,
+                       p->reverb_diffusion, p->reverb_frozen != 0u);
+  }
+  if (!cond)
+  {
+    return;
+  }
+#if WET_HPF_ENABLE
+  w->l = hpf1_s24(&rs->wet_hpf_l, w->l, s_rate.reverb_wet_hpf_r_q15);
+  w->r = hpf1_s24(&rs->wet_hpf_r, w->r, s_rate.reverb_wet_hpf_r_q15);
+#endif
+  w->l = onepole_lpf_s24(w->l, &rs->wet_lpf_l, s_rate.reverb_wet_lpf_a_q15);
+  w->r = onepole_lpf_s24(w->r, &rs->wet_lpf_r, s_rate.reverb_wet_lpf_a_q15);
+}
+
+#if APP_DSP_REVERB_HALF_RATE
+/* Halfband decimator: the side taps fall on the second frame of each pair
+ * (10 pairs back), the centre tap on the first frame 4 pairs back.
+ */
+static inline AppStereoS24 reverb_hb_decim_s24(const ReverbHalfState *hs)
+{
+  uint32_t i = hs->idx;
+  AppStereoS24 c = hs->dec_a[(i - 4U) & REVERB_HB_MASK];
+  int64_t acc_l = (int64_t)c.l * 16384;
+  int64_t acc_r = (int64_t)c.r * 16384;
+  for (uint32_t k = 0; k < REVERB_HB_TAPS; k++)
+  {
+    AppStereoS24 b0 = hs->dec_b[(i - 4U + k) & REVERB_HB_MASK];
+    AppStereoS24 b1 = hs->dec_b[(i - 5U - k) & REVERB_HB_MASK];
+    acc_l += (int64_t)k_reverb_hb_q15[k] * (b0.l + b1.l);
+#if !REVERB_MONO_IN
+    acc_r += (int64_t)k_reverb_hb_q15[k] * (b0.r + b1.r);
+#endif
+  }
+  AppStereoS24 v;
+  v.l = clamp_s24((int32_t)(acc_l >> 15));
+#if REVERB_MONO_IN
+  (void)acc_r;
+  v.r = v.l;
+#else
+  v.r = clamp_s24((int32_t)(acc_r >> 15));
+#endif
+  return v;
+}
+
+/* Halfband interpolator (x2 gain for the zero stuffing): returns the
+ * in-between sample and leaves the aligned one in held_out.
+ */
+static inline AppStereoS24 reverb_hb_interp_s24(ReverbHalfState *hs)
+{
+  uint32_t i = hs->idx;
+  int64_t acc_l = 0;
+  int64_t acc_r = 0;
+  for (uint32_t k = 0; k < REVERB_HB_TAPS; k++)
+  {
+    AppStereoS24 w0 = hs->wet[(i - 4U + k) & REVERB_HB_MASK];
+    AppStereoS24 w1 = hs->wet[(i - 5U - k) & REVERB_HB_MASK];
+    acc_l += (int64_t)k_reverb_hb_q15[k] * (w0.l + w1.l);
+    acc_r += (int64_t)k_reverb_hb_q15[k] * (w0.r + w1.r);
+  }
+  hs->held_out = hs->wet[(i - 4U) & REVERB_HB_MASK];
+  AppStereoS24 y;
+  y.l = clamp_s24((int32_t)(acc_l >> 14));
+  y.r = clamp_s24((int32_t)(acc_r >> 14));
+  return y;
+}
+#endif
+
+/* One frame of send in, wet out, through the half-rate pair if built. */
+static inline __attribute__((always_inline)) AppStereoS24 reverb_frame_s24(ReverbFxState *rs, ReverbState *st, AppStereoS24 in,
+                                                                           const DspBlockParams *p, bool cond)
+{
+#if APP_DSP_REVERB_MONO_SEND && !APP_DSP_MONO_INPUT
+  in.l = (in.l + in.r) >> 1;
+  in.r = in.l;
+#endif
+#if APP_DSP_REVERB_HALF_RATE
+  ReverbHalfState *hs = &rs->half;
+  AppStereoS24 w;
+  if (hs->phase == 0U)
+  {
+    hs->held_in = in;
+    w = hs->held_out;
+    hs->phase = 1U;
+  }
+  else
+  {
+    uint32_t j = (hs->idx + 1U) & REVERB_HB_MASK;
+    hs->idx = j;
+    hs->dec_a[j] = hs->held_in;
+    hs->dec_b[j] = in;
+    /* Frozen: the input is silent, so is its decimator. */
+    AppStereoS24 v = {0, 0};
+    if (!p->reverb_frozen)
+    {
+      v = reverb_hb_decim_s24(hs);
+    }
+    reverb_wet_s24(&v, rs, st, p, cond);
+    hs->wet[j] = v;
+    w = reverb_hb_interp_s24(hs);
+    hs->phase = 0U;
+  }
+#else
+  AppStereoS24 w = in;
+  reverb_wet_s24(&w, rs, st, p, cond);
+#endif
+  return w;
+}
+
+/* The FDN and the spring share the buffer: on a switch the old tail is cut
+ * and the buffer cleared while the module sleeps (reverb_clear_step()).
+ */
+static void reverb_type_check(ReverbFxState *rs, const DspBlockParams *p)
+{
+  const uint32_t type = APP_DSP_SPRING_ENABLE ? p->reverb_type : (uint32_t)APP_DSP_REVERB_TYPE_FDN;
+  if (type == rs->type)
+  {
+    return;
+  }
+  rs->type = type;
+  memset(&rs->tank, 0, sizeof(rs->tank));
+#if APP_DSP_SPRING_ENABLE
+  memset(spring_state(), 0, sizeof(SpringState));
+#endif
+  memset(s_reverb_ap, 0, REVERB_AP_BYTES);
+  AppDline_ClearBegin(&rs->clear, s_reverb_fdn, REVERB_FDN_BYTES / 4U, 0U, APP_DSP_REVERB_STORAGE);
+}
+
+/* Stages that come in start from silence; the ones that go keep their
+ * state, which is cleared when they come back.
+ */
+static void reverb_ap_check(ReverbFxState *rs, const DspBlockParams *p)
+{
+  const uint32_t want = p->reverb_diffusion;
+  if (want > rs->ap_stages)
+  {
+    const uint32_t from = k_reverb_ap_base[rs->ap_stages];
+    memset(&s_reverb_ap[from], 0, (k_reverb_ap_base[want - 1U] + k_reverb_ap_len[want - 1U] - from) * 8U);
+    for (uint32_t k = rs->ap_stages; k < want; k++)
+    {
+      rs->tank.ap_idx[k] = 0U;
+    }
+  }
+  rs->ap_stages = want;
+}
+
+/* The FDN state is kept in a local across the block so the line indices and
+ * dampers stay in registers. Bounds in and out as delay_block().
+ */
+APP_CCM_CODE static int32_t reverb_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  ReverbFxState *rs = (ReverbFxState *)state;
+  p = fx_params(&rs->fade, p);
+  ramp_set(&rs->mix, p->reverb_mix_q15);
+  peak = tail_in_block(x, n, peak);
+  reverb_type_check(rs, p);
+  reverb_ap_check(rs, p);
+  if ((rs->clear.left != 0U) || !fade_wake(&rs->fade, x, n))
+  {
+    fade_sleep_block(x, n, &rs->fade, &rs->mix);
+    return peak;
+  }
+  int32_t mag = 0;
+  ReverbState st = rs->tank;
+#if REVERB_MOD_ENABLE
+  AppLfo_Block(&rs->lfo, REVERB_STEPS(n), &st.mod);
+#endif
+  /* The send times the freeze's input gain, which moves once a block. */
+  const int32_t feed = p->reverb_in_q15;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    AppStereoS24 dry = {tail_dry_s24(x[i].l), tail_dry_s24(x[i].r)};
+    int32_t send = ramp_next(&rs->fade.send);
+    int32_t mix = ramp_next(&rs->mix);
+    AppStereoS24 in = {0, 0};
+    if (feed != 0)
+    {
+      const int32_t g = (int32_t)(((int64_t)send * feed) >> 15);
+      in.l = (int32_t)(((int64_t)dry.l * g) >> 15);
+      in.r = (int32_t)(((int64_t)dry.r * g) >> 15);
+    }
+    AppStereoS24 w = reverb_frame_s24(rs, &st, in, p, true);
+    fade_track_tail(&rs->fade, &in, w.l, w.r);
+    x[i].l = mix_spill_s24(dry.l, w.l, mix, send);
+    x[i].r = mix_spill_s24(dry.r, w.r, mix, send);
+    mag |= mag_s24(x[i].l) | mag_s24(x[i].r);
+  }
+  rs->tank = st;
+  return mag;
+}
+
+#if APP_DSP_BUS_FRAMES
+/* reverb_block() on the wet bus, as delay_bus_block(). */
+APP_CCM_CODE static int32_t reverb_bus_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  ReverbFxState *rs = (ReverbFxState *)state;
+  p = fx_params(&rs->fade, p);
+  DspWetBus *b = p->wet_bus;
+  ramp_set(&rs->mix, p->reverb_mix_q15);
+  peak = tail_in_block(x, n, peak);
+  reverb_type_check(rs, p);
+  reverb_ap_check(rs, p);
+  if ((rs->clear.left != 0U) || !fade_wake(&rs->fade, x, n))
+  {
+    fade_sleep_bus(b, n, &rs->fade, &rs->mix);
+    return peak;
+  }
+  ReverbState st = rs->tank;
+#if REVERB_MOD_ENABLE
+  AppLfo_Block(&rs->lfo, REVERB_STEPS(n), &st.mod);
+#endif
+  const int32_t feed = p->reverb_in_q15;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t send = ramp_next(&rs->fade.send);
+    int32_t mix = ramp_next(&rs->mix);
+    AppStereoS24 in = {0, 0};
+    if (feed != 0)
+    {
+      const int32_t g = (int32_t)(((int64_t)send * feed) >> 15);
+      in.l = (int32_t)(((int64_t)tail_dry_s24(x[i].l) * g) >> 15);
+      in.r = (int32_t)(((int64_t)tail_dry_s24(x[i].r) * g) >> 15);
+    }
+    AppStereoS24 w = reverb_frame_s24(rs, &st, in, p, false);
+    fade_track_tail(&rs->fade, &in, w.l, w.r);
+    wet_bus_add(b, i, w.l, w.r, mix, send);
+  }
+  rs->tank = st;
+  return peak;
+}
+#endif
+
+/* -------------------------------- FX modules ------------------------------ */
+
+static void distortion_reset(void *state, uint32_t zeroed)
+{
+  if (!zeroed)
+  {
+    memset(state, 0, sizeof(DistFxState));
+#if CABSIM_IR
+    AppCabIr_Reset();
+#endif
+  }
+#if CABSIM_FMAC
+  s_cab_fmac = AppFmac_IirStart(s_rate.cab_b_q28, s_rate.cab_a_q28, 2u, APP_DSP_MONO_INPUT ? 1u : 2u);
+#endif
+}
+
+static AppProfStage distortion_prof_stage(const DspBlockParams *p)
+{
+  return (p->dist_os >= 4U) ? APP_PROF_STAGE_DIST_OS4 :
+         (p->dist_os == 2U) ? APP_PROF_STAGE_DIST_OS2 : APP_PROF_STAGE_DISTORTION;
+}
+
+/* Tier 1: oversampling capped at 2x, half the cab IR. Tier 2: no
+ * oversampling, a quarter of the IR.
+ */
+static void distortion_shed(DspBlockParams *p, uint32_t tier)
+{
+  const uint32_t os = (tier >= 2u) ? 1u : 2u;
+  if (p->dist_os > os)
+  {
+    p->dist_os = os;
+  }
+  p->cab_ir_shift = tier;
+}
+
+static const AppDspParamId k_fx_distortion_params[] = {
+  APP_DSP_PARAM_DIST_DRIVE_Q8, APP_DSP_PARAM_DIST_OVERSAMPLE, APP_DSP_PARAM_DIST_CURVE,
+};
+
+static const AppFxModule k_fx_distortion = {
+  .name = "distortion",
+  .bit = APP_FX_BIT_DISTORTION,
+  .stereo = 0u,
+  .meter_tap = APP_METER_TAP_DIST,
+  .state_size = sizeof(DistFxState),
+  .init = NULL,
+  .reset = distortion_reset,
+  .process_block = distortion_block,
+  .bus_block = NULL,
+  .prof_stage = distortion_prof_stage,
+  .tail_frames = NULL,
+  .idle = NULL,
+  .clear_step = NULL,
+  .shed = distortion_shed,
+  .shed_tiers = 2u,
+  .params = k_fx_distortion_params,
+  .param_count = sizeof(k_fx_distortion_params) / sizeof(k_fx_distortion_params[0]),
+};
+
+static void eq_reset(void *state, uint32_t zeroed)
+{
+  (void)state;
+  (void)zeroed;
+  AppEq_Reset();
+}
+
+static AppProfStage eq_prof_stage(const DspBlockParams *p)
+{
+  (void)p;
+  return APP_PROF_STAGE_EQ;
+}
+
+static const AppDspParamId k_fx_eq_params[] = {
+  APP_DSP_PARAM_EQ_LOW_GAIN_DB10, APP_DSP_PARAM_EQ_LOW_FREQ_HZ,
+  APP_DSP_PARAM_EQ_MID1_GAIN_DB10, APP_DSP_PARAM_EQ_MID1_FREQ_HZ, APP_DSP_PARAM_EQ_MID1_Q100,
+  APP_DSP_PARAM_EQ_MID2_GAIN_DB10, APP_DSP_PARAM_EQ_MID2_FREQ_HZ, APP_DSP_PARAM_EQ_MID2_Q100,
+  APP_DSP_PARAM_EQ_HIGH_GAIN_DB10, APP_DSP_PARAM_EQ_HIGH_FREQ_HZ,
+};
+
+static const AppFxModule k_fx_eq = {
+  .name = "eq",
+  .bit = 0u,
+  .stereo = 0u,
+  .meter_tap = -1,
+  .state_size = 0u,
+  .init = NULL,
+  .reset = eq_reset,
+  .process_block = eq_block,
+  .bus_block = NULL,
+  .prof_stage = eq_prof_stage,
+  .tail_frames = NULL,
+  .idle = NULL,
+  .clear_step = NULL,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_eq_params,
+  .param_count = sizeof(k_fx_eq_params) / sizeof(k_fx_eq_params[0]),
+};
+
+static void wah_reset(void *state, uint32_t zeroed)
+{
+  if (!zeroed)
+  {
+    memset(state, 0, sizeof(WahFxState));
+  }
+}
+
+static AppProfStage wah_prof_stage(const DspBlockParams *p)
+{
+  (void)p;
+  return APP_PROF_STAGE_WAH;
+}
+
+/* As wah_block() returns at once. */
+static uint8_t wah_idle(const DspBlockParams *p)
+{
+  return (p->wah_mix_q15 == 0) ? 1u : 0u;
+}
+
+static const AppDspParamId k_fx_wah_params[] = {
+  APP_DSP_PARAM_WAH_MIX_Q15, APP_DSP_PARAM_WAH_FREQ_HZ, APP_DSP_PARAM_WAH_DEPTH_Q15,
+  APP_DSP_PARAM_WAH_SENS_DB10, APP_DSP_PARAM_WAH_Q100,
+};
+
+static const AppFxModule k_fx_wah = {
+  .name = "wah",
+  .bit = 0u,
+  .stereo = 0u,
+  .meter_tap = -1,
+  .state_size = sizeof(WahFxState),
+  .init = NULL,
+  .reset = wah_reset,
+  .process_block = wah_block,
+  .bus_block = NULL,
+  .prof_stage = wah_prof_stage,
+  .tail_frames = NULL,
+  .idle = wah_idle,
+  .clear_step = NULL,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_wah_params,
+  .param_count = sizeof(k_fx_wah_params) / sizeof(k_fx_wah_params[0]),
+};
+
+static const AppDspParamId k_fx_pitch_params[] = {
+  APP_DSP_PARAM_PITCH_MIX_Q15, APP_DSP_PARAM_PITCH_CENTS, APP_DSP_PARAM_PITCH_WINDOW_MS,
+};
+
+#if APP_DSP_PITCH_ENABLE
+/* The line needs no clearing: pitch_step_s24() never reads past fill. */
+static void pitch_reset(void *state, uint32_t zeroed)
+{
+  if (!zeroed)
+  {
+    memset(state, 0, sizeof(PitchFxState));
+  }
+}
+
+static AppProfStage pitch_prof_stage(const DspBlockParams *p)
+{
+  (void)p;
+  return APP_PROF_STAGE_PITCH;
+}
+
+/* As pitch_block() returns at once. */
+static uint8_t pitch_idle(const DspBlockParams *p)
+{
+  return (p->pitch_mix_q15 == 0) ? 1u : 0u;
+}
+
+static const AppFxModule k_fx_pitch = {
+  .name = "pitch",
+  .bit = 0u,
+  .stereo = 0u,
+  .meter_tap = -1,
+  .state_size = sizeof(PitchFxState),
+  .init = NULL,
+  .reset = pitch_reset,
+  .process_block = pitch_block,
+  .bus_block = NULL,
+  .prof_stage = pitch_prof_stage,
+  .tail_frames = NULL,
+  .idle = pitch_idle,
+  .clear_step = NULL,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_pitch_params,
+  .param_count = sizeof(k_fx_pitch_params) / sizeof(k_fx_pitch_params[0]),
+};
+#else
+/* Left out of the build (APP_DSP_PITCH_ENABLE): never scheduled. */
+static const AppFxModule k_fx_pitch = {
+  .name = "pitch",
+  .bit = 0u,
+  .stereo = 0u,
+  .meter_tap = -1,
+  .state_size = 0u,
+  .init = NULL,
+  .reset = NULL,
+  .process_block = NULL,
+  .bus_block = NULL,
+  .prof_stage = NULL,
+  .tail_frames = NULL,
+  .idle = NULL,
+  .clear_step = NULL,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_pitch_params,
+  .param_count = sizeof(k_fx_pitch_params) / sizeof(k_fx_pitch_params[0]),
+};
+#endif
+
+static void phaser_reset(void *state, uint32_t zeroed)
+{
+  PhaserFxState *st = (PhaserFxState *)state;
+  const DspParams *c = s_params_front;
+  if (!zeroed)
+  {
+    memset(st, 0, sizeof(*st));
+  }
+  st->rate_mhz = c->phaser_rate_mhz;
+  AppLfo_Reset(&st->lfo, st->rate_mhz, DSP_SAMPLE_RATE_HZ, 0U);
+  ramp_reset(&st->mix, c->phaser_mix_q15);
+}
+
+static AppProfStage phaser_prof_stage(const DspBlockParams *p)
+{
+  (void)p;
+  return APP_PROF_STAGE_PHASER;
+}
+
+/* Tier 1: four stages at most. */
+static void phaser_shed(DspBlockParams *p, uint32_t tier)
+{
+  if ((tier >= 1u) && (p->phaser_stages > 4U))
+  {
+    p->phaser_stages = 4U;
+  }
+}
+
+static const AppDspParamId k_fx_phaser_params[] = {
+  APP_DSP_PARAM_PHASER_MIX_Q15, APP_DSP_PARAM_PHASER_RATE_MHZ, APP_DSP_PARAM_PHASER_DEPTH_Q15,
+  APP_DSP_PARAM_PHASER_FREQ_HZ, APP_DSP_PARAM_PHASER_STAGES, APP_DSP_PARAM_PHASER_SPREAD_DEG,
+  APP_DSP_PARAM_PHASER_SYNC,
+};
+
+static const AppFxModule k_fx_phaser = {
+  .name = "phaser",
+  .bit = APP_FX_BIT_PHASER,
+  .stereo = 1u,
+  .meter_tap = -1,
+  .state_size = sizeof(PhaserFxState),
+  .init = NULL,
+  .reset = phaser_reset,
+  .process_block = phaser_block,
+  .bus_block = NULL,
+  .prof_stage = phaser_prof_stage,
+  .tail_frames = NULL,
+  .idle = NULL,
+  .clear_step = NULL,
+  .shed = phaser_shed,
+  .shed_tiers = 1u,
+  .params = k_fx_phaser_params,
+  .param_count = sizeof(k_fx_phaser_params) / sizeof(k_fx_phaser_params[0]),
+};
+
+static const AppDspParamId k_fx_chorus_params[] = {
+  APP_DSP_PARAM_CHORUS_MIX_Q15, APP_DSP_PARAM_CHORUS_RATE_MHZ, APP_DSP_PARAM_CHORUS_DEPTH_Q15,
+  APP_DSP_PARAM_CHORUS_TIME_US, APP_DSP_PARAM_CHORUS_FEEDBACK_Q15, APP_DSP_PARAM_CHORUS_SPREAD_DEG,
+  APP_DSP_PARAM_CHORUS_SYNC,
+};
+
+#if APP_DSP_CHORUS_ENABLE
+static void chorus_reset(void *state, uint32_t zeroed)
+{
+  ChorusFxState *st = (ChorusFxState *)state;
+  const DspParams *c = s_params_front;
+  if (!zeroed)
+  {
+    AppDline_Clear(s_chorus_buf, CHORUS_WORDS, CHORUS_STORAGE);
+    memset(st, 0, sizeof(*st));
+  }
+  st->rate_mhz = c->chorus_rate_mhz;
+  AppLfo_Reset(&st->lfo, st->rate_mhz, CHORUS_FS_HZ, 0U);
+  st->time_q16 = c->chorus_time_q16;
+  ramp_reset(&st->mix, c->chorus_mix_q15);
+}
+
+static AppProfStage chorus_prof_stage(const DspBlockParams *p)
+{
+  (void)p;
+  return APP_PROF_STAGE_CHORUS;
+}
+
+/* Two passes of the whole line (feedback keeps it ringing), in frames. */
+static uint32_t chorus_tail_frames(const DspBlockParams *p)
+{
+  (void)p;
+  return 4U * CHORUS_LEN;
+}
+
+static const AppFxModule k_fx_chorus = {
+  .name = "chorus",
+  .bit = APP_FX_BIT_CHORUS,
+  .stereo = 1u,
+  .meter_tap = -1,
+  .state_size = sizeof(ChorusFxState),
+  .init = NULL,
+  .reset = chorus_reset,
+  .process_block = chorus_block,
+  .bus_block = NULL,
+  .prof_stage = chorus_prof_stage,
+  .tail_frames = chorus_tail_frames,
+  .idle = NULL,
+  .clear_step = NULL,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_chorus_params,
+  .param_count = sizeof(k_fx_chorus_params) / sizeof(k_fx_chorus_params[0]),
+};
+#else
+/* Left out of the build (APP_DSP_CHORUS_ENABLE): never scheduled. */
+static const AppFxModule k_fx_chorus = {
+  .name = "chorus",
+  .bit = 0u,
+  .stereo = 0u,
+  .meter_tap = -1,
+  .state_size = 0u,
+  .init = NULL,
+  .reset = NULL,
+  .process_block = NULL,
+  .bus_block = NULL,
+  .prof_stage = NULL,
+  .tail_frames = NULL,
+  .idle = NULL,
+  .clear_step = NULL,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_chorus_params,
+  .param_count = sizeof(k_fx_chorus_params) / sizeof(k_fx_chorus_params[0]),
+};
+#endif
+
+static void delay_reset(void *state, uint32_t zeroed)
+{
+  DelayFxState *st = (DelayFxState *)state;
+  const DspParams *c = s_params_front;
+  if (!zeroed || (APP_DSP_DELAY_STORAGE == APP_DLINE_ULAW))
+  {
+    AppDline_Clear(s_delay_buf, DELAY_WORDS, APP_DSP_DELAY_STORAGE);
+  }
+  if (!zeroed)
+  {
+    memset(st, 0, sizeof(*st));
+  }
+  st->line.delay_q16 = c->delay_steps << 16;
+  ramp_reset(&st->mix, c->delay_mix_q15);
+  ramp_reset(&st->duck, 32768);
+  st->duck_l2 = DSP_LEVEL_FLOOR_L2;
+}
+
+static AppProfStage delay_prof_stage(const DspBlockParams *p)
+{
+  (void)p;
+  return APP_PROF_STAGE_DELAY;
+}
+
+/* Two echo periods. */
+static uint32_t delay_tail_frames(const DspBlockParams *p)
+{
+  return 2U * p->delay_steps * DELAY_DECIM;
+}
+
+static const AppDspParamId k_fx_delay_params[] = {
+  APP_DSP_PARAM_DELAY_MIX_Q15, APP_DSP_PARAM_DELAY_FEEDBACK_Q15,
+  APP_DSP_PARAM_DELAY_TIME_MS, APP_DSP_PARAM_DELAY_PATTERN, APP_DSP_PARAM_DELAY_SYNC,
+  APP_DSP_PARAM_DELAY_DUCK_Q15,
+};
+
+static const AppFxModule k_fx_delay = {
+  .name = "delay",
+  .bit = APP_FX_BIT_DELAY,
+  .stereo = 1u,
+  .meter_tap = APP_METER_TAP_DELAY,
+  .state_size = sizeof(DelayFxState),
+  .init = NULL,
+  .reset = delay_reset,
+  .process_block = delay_block,
+#if APP_DSP_BUS_FRAMES
+  .bus_block = delay_bus_block,
+#else
+  .bus_block = NULL,
+#endif
+  .prof_stage = delay_prof_stage,
+  .tail_frames = delay_tail_frames,
+  .idle = NULL,
+  .clear_step = NULL,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_delay_params,
+  .param_count = sizeof(k_fx_delay_params) / sizeof(k_fx_delay_params[0]),
+};
+
+/* Everything but the FDN lines. */
+static void reverb_reset_state(ReverbFxState *rs, uint32_t zeroed)
+{
+  const DspParams *c = s_params_front;
+  if (!zeroed)
+  {
+    memset(s_reverb_ap, 0, REVERB_AP_BYTES);
+    memset(rs, 0, sizeof(*rs));
+  }
+#if REVERB_MOD_ENABLE
+  AppLfo_Reset(&rs->lfo, APP_DSP_REVERB_MOD_RATE_MHZ, REVERB_FS_HZ, 0U);
+#endif
+  ramp_reset(&rs->mix, c->reverb_mix_q15);
+}
+
+static void reverb_reset(void *state, uint32_t zeroed)
+{
+  if (!zeroed || (APP_DSP_REVERB_STORAGE == APP_DLINE_ULAW))
+  {
+    AppDline_Clear(s_reverb_fdn, REVERB_FDN_BYTES / 4U, APP_DSP_REVERB_STORAGE);
+  }
+  reverb_reset_state((ReverbFxState *)state, zeroed);
+}
+
+static AppProfStage reverb_prof_stage(const DspBlockParams *p)
+{
+  (void)p;
+  return APP_PROF_STAGE_REVERB;
+}
+
+/* Two periods of the longest line, in frames. */
+static uint32_t reverb_tail_frames(const DspBlockParams *p)
+{
+  (void)p;
+#if APP_DSP_REVERB_HALF_RATE
+  return 4U * REVERB_FDN_LEN3;
+#else
+  return 2U * REVERB_FDN_LEN3;
+#endif
+}
+
+/* A tank that sleeps has rung out below the floor; only the arena handoff
+ * leaves foreign data in the lines (arena_handoff()). The delay needs no
+ * such step: it sleeps after two echo periods of silence and its read
+ * distance glides by at most 1/4 step per step, so on waking it never
+ * reaches what is older.
+ */
+static void reverb_clear_step(void *state, uint32_t n)
+{
+  ReverbFxState *rs = (ReverbFxState *)state;
+  if (rs->clear.left != 0U)
+  {
+    (void)AppDline_ClearStep(&rs->clear, n * APP_DSP_LINE_CLEAR_WORDS);
+  }
+}
+
+static const AppDspParamId k_fx_reverb_params[] = {
+  APP_DSP_PARAM_REVERB_MIX_Q15, APP_DSP_PARAM_REVERB_FEEDBACK_Q15, APP_DSP_PARAM_REVERB_DAMP_Q15,
+  APP_DSP_PARAM_REVERB_DECAY_MS, APP_DSP_PARAM_REVERB_HF_DAMP_HZ, APP_DSP_PARAM_REVERB_ROOM,
+  APP_DSP_PARAM_REVERB_ER_Q15, APP_DSP_PARAM_REVERB_TYPE, APP_DSP_PARAM_REVERB_DIFFUSION,
+};
+
+static const AppFxModule k_fx_reverb = {
+  .name = "reverb",
+  .bit = APP_FX_BIT_REVERB,
+  .stereo = 1u,
+  .meter_tap = APP_METER_TAP_REVERB,
+  .state_size = sizeof(ReverbFxState),
+  .init = NULL,
+  .reset = reverb_reset,
+  .process_block = reverb_block,
+#if APP_DSP_BUS_FRAMES
+  .bus_block = reverb_bus_block,
+#else
+  .bus_block = NULL,
+#endif
+  .prof_stage = reverb_prof_stage,
+  .tail_frames = reverb_tail_frames,
+  .idle = NULL,
+  .clear_step = reverb_clear_step,
+  .shed = NULL,
+  .shed_tiers = 0u,
+  .params = k_fx_reverb_params,
+  .param_count = sizeof(k_fx_reverb_params) / sizeof(k_fx_reverb_params[0]),
+};
+
+/* Every module's state, back to back in registry order. */
+typedef struct
+{
+#define DSP_FX_STATE_MEMBER(m, d, T, c) T m;
+  DSP_FX_REGISTRY(DSP_FX_STATE_MEMBER)
+#undef DSP_FX_STATE_MEMBER
+} DspFxStates;
+
+#define DSP_FX_MODULE_ENTRY(m, d, T, c) &d,
+static const AppFxModule *const k_fx_modules[] =
+{
+  DSP_FX_REGISTRY(DSP_FX_MODULE_ENTRY)
+};
+#undef DSP_FX_MODULE_ENTRY
+
+#define DSP_FX_STATE_ENTRY(m, d, T, c) (uint16_t)offsetof(DspFxStates, m),
+static const uint16_t k_fx_state_offs[] =
+{
+  DSP_FX_REGISTRY(DSP_FX_STATE_ENTRY)
+};
+#undef DSP_FX_STATE_ENTRY
+
+/* Cycle budget (app_profile.h): the fixed stages around the FX (DC block,
+ * gate, compressor, coloration, looper, output and limiter, declared like
+ * the modules) and every module of the registry at its worst must fit a
+ * frame at full HCLK below the shedder's threshold, so no mask of a
+ * 48 kHz build depends on shedding. At 96 kHz the full chain is over the
+ * halved frame by design and the shedder is what keeps it in time.
+ */
+#define DSP_CORE_CYCLES                600U
+#define DSP_FX_CYCLES_ENTRY(m, d, T, c) + (c)
+#define DSP_CHAIN_CYCLES               (DSP_CORE_CYCLES DSP_FX_REGISTRY(DSP_FX_CYCLES_ENTRY))
+#if DSP_SAMPLE_RATE_HZ == 48000U
+_Static_assert(DSP_CHAIN_CYCLES <= APP_PROFILE_FRAME_CYCLES(DSP_SAMPLE_RATE_HZ, APP_DSP_SHED_HIGH_PERMILLE),
+               "the declared FX cycles outgrew the frame budget");
+#endif
+
+/* State of module i in a context's state block. */
+static inline void *fx_state(DspFxStates *fx, uint32_t i)
+{
+  return (uint8_t *)fx + k_fx_state_offs[i];
+}
+
+/* Switching state of module i (modules with a mask bit only). */
+static inline FxFade *fx_fade(DspFxStates *fx, uint32_t i)
+{
+  return (FxFade *)fx_state(fx, i);
+}
+
+/* No module with a tail is awake. */
+static inline bool fx_tails_asleep(DspFxStates *fx)
+{
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    if ((k_fx_modules[i]->tail_frames != NULL) && fx_fade(fx, i)->awake)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* ----------------------------- Load shedding ------------------------------ */
+
+#define SHED_HOLD_FRAMES  ((APP_DSP_SHED_HOLD_MS * DSP_SAMPLE_RATE_HZ) / 1000U)
+
+static void shed_apply(DspBlockParams *p, uint32_t tier)
+{
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    const AppFxModule *m = k_fx_modules[i];
+    if ((m->shed != NULL) && (m->shed_tiers != 0u))
+    {
+      m->shed(p, (tier < m->shed_tiers) ? tier : m->shed_tiers);
+    }
+  }
+}
+
+static void shed_init(void)
+{
+  memset(&s_shed, 0, sizeof(s_shed));
+#if APP_DSP_SHED
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    if ((k_fx_modules[i]->shed != NULL) && (k_fx_modules[i]->shed_tiers > s_shed.tier_max))
+    {
+      s_shed.tier_max = k_fx_modules[i]->shed_tiers;
+    }
+  }
+#endif
+}
+
+/* Primary context, ahead of its block: when the parameters ask for a
+ * distortion that declares more cycles than the last block's (a model,
+ * oversampling or mask change), the difference goes on the last load.
+ * Past the high mark the tier steps down now, so the block already runs
+ * the cheaper fallbacks; it comes back by the usual hold.
+ */
+static void shed_ahead(const DspParams *c, AppFxMask mask)
+{
+#if APP_DSP_SHED
+  const uint32_t cyc = ((mask & APP_FX_BIT_DISTORTION) != 0u) ? dist_model_cycles(c->dist_model, c->dist_os) : 0u;
+  if ((cyc > s_shed.dist_cyc) && (s_shed.budget != 0u) && (s_shed.tier < s_shed.tier_max))
+  {
+    const uint64_t load = ((uint64_t)s_shed.cycles + ((uint64_t)(cyc - s_shed.dist_cyc) * s_shed.frames)) * 1000U;
+    if (load > ((uint64_t)s_shed.budget * APP_DSP_SHED_HIGH_PERMILLE))
+    {
+      s_shed.calm_frames = 0u;
+      s_shed.tier++;
+      s_shed.sheds++;
+    }
+  }
+  s_shed.dist_cyc = cyc;
+#else
+  (void)c;
+  (void)mask;
+#endif
+}
+
+/* Down a tier at once on a late-looking block; up one only after the load
+ * stayed well clear of the deadline for the hold time, so a tier that just
+ * fits is not given back on the first quiet block.
+ */
+void AppDsp_ReportLoad(uint32_t cycles, uint32_t budget, uint32_t n)
+{
+#if APP_DSP_SHED
+  s_shed.cycles = cycles;
+  s_shed.budget = budget;
+  s_shed.frames = n;
+  const uint64_t load = (uint64_t)cycles * 1000U;
+  if (load > ((uint64_t)budget * APP_DSP_SHED_HIGH_PERMILLE))
+  {
+    s_shed.calm_frames = 0u;
+    if (s_shed.tier < s_shed.tier_max)
+    {
+      s_shed.tier++;
+      s_shed.sheds++;
+    }
+  }
+  else if ((load < ((uint64_t)budget * APP_DSP_SHED_LOW_PERMILLE)) && (s_shed.tier != 0u))
+  {
+    s_shed.calm_frames += n;
+    if (s_shed.calm_frames >= SHED_HOLD_FRAMES)
+    {
+      s_shed.calm_frames = 0u;
+      s_shed.tier--;
+      s_shed.restores++;
+    }
+  }
+  else
+  {
+    s_shed.calm_frames = 0u;
+  }
+#else
+  (void)cycles;
+  (void)budget;
+  (void)n;
+#endif
+}
+
+void AppDsp_GetShed(AppDspShedInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->tier = s_shed.tier;
+  out->tier_max = s_shed.tier_max;
+  out->sheds = s_shed.sheds;
+  out->restores = s_shed.restores;
+}
+
+uint8_t AppDsp_GetDistModel(uint32_t model, AppDspDistModelInfo *out)
+{
+  if ((model >= (uint32_t)APP_DSP_DIST_MODEL_COUNT) || (out == NULL))
+  {
+    return 0u;
+  }
+  out->name = k_dist_models[model].name;
+  for (uint32_t k = 0; k < 3u; k++)
+  {
+    out->cyc_sample[k] = k_dist_models[model].cyc_sample[k];
+  }
+  return 1u;
+}
+
+uint32_t AppDsp_DistModelCycles(uint32_t model, uint32_t os)
+{
+  return (model < (uint32_t)APP_DSP_DIST_MODEL_COUNT) ? dist_model_cycles(model, os) : 0u;
+}
+
+/* ------------------------------ Clip counters ----------------------------- */
+
+#if APP_DSP_CLIP
+static volatile uint32_t s_clip[APP_PROF_STAGE_COUNT];
+static volatile uint32_t s_clip_runs;
+
+/* Whether a clamp saturated since the last call; clears the flag. APSR.Q
+ * is saved and restored with the xPSR on exception entry and return, so
+ * preempting ISRs never leak into it. The memory clobbers keep the stage's
+ * stores (and so its SSATs) on their side of the read.
+ */
+static inline uint32_t clip_take(void)
+{
+#if DSP_USE_ARM_DSP
+  uint32_t apsr;
+  __ASM volatile ("MRS %0, apsr" : "=r" (apsr) : : "memory");
+  __ASM volatile ("MSR apsr_nzcvq, %0" : : "r" (0U) : "cc", "memory");
+  return (apsr >> 27) & 1U;
+#else
+  const uint32_t q = s_clip_q;
+  s_clip_q = 0U;
+  return q;
+#endif
+}
+
+#define DSP_CLIP_BEGIN()               do { (void)clip_take(); s_clip_runs++; } while (0)
+#define DSP_CLIP_STAGE(stage)          do { if (clip_take()) { s_clip[(stage)]++; } } while (0)
+#else
+#define DSP_CLIP_BEGIN()               do { } while (0)
+#define DSP_CLIP_STAGE(stage)          do { } while (0)
+#endif
+
+uint8_t AppDsp_GetClip(uint32_t stage, uint32_t *blocks, uint32_t *runs)
+{
+#if APP_DSP_CLIP
+  if (stage >= (uint32_t)APP_PROF_STAGE_COUNT)
+  {
+    return 0u;
+  }
+  *blocks = s_clip[stage];
+  *runs = s_clip_runs;
+  return 1u;
+#else
+  (void)stage;
+  (void)blocks;
+  (void)runs;
+  return 0u;
+#endif
+}
+
+void AppDsp_ResetClip(void)
+{
+#if APP_DSP_CLIP
+  for (uint32_t i = 0; i < (uint32_t)APP_PROF_STAGE_COUNT; i++)
+  {
+    s_clip[i] = 0u;
+  }
+  s_clip_runs = 0u;
+#endif
+}
+
+/* ------------------------------ FX schedule ------------------------------- */
+
+/* One step of a compiled chain (DspSchedule): fn(state, x, n, p, peak) on
+ * the block in place. A context's steps[] hold every step a schedule can
+ * name: the modules in registry order, their wet-bus variants, the meter
+ * taps, then the routing.
+ */
+typedef struct
+{
+  AppFxProcessFn fn;
+  void *state;
+#if APP_PROF_ENABLE || APP_DSP_CLIP
+  const AppFxModule *fx;         /* PROF/CLIP stage it counts under; routing (NULL) joins the next */
+#endif
+} DspStep;
+
+enum
+{
+  DSP_STEP_FX = 0,
+  DSP_STEP_BUS_FX = DSP_STEP_FX + DSP_FX_COUNT,
+  DSP_STEP_TAP = DSP_STEP_BUS_FX + DSP_FX_COUNT,        /* + 2 * tap + mono */
+  DSP_STEP_STEREO = DSP_STEP_TAP + (2 * APP_METER_TAP_COUNT),
+  DSP_STEP_SPLIT,
+  DSP_STEP_BRANCH,
+  DSP_STEP_MERGE,
+  DSP_STEP_WET_OPEN,
+  DSP_STEP_WET_MIX,
+  DSP_STEP_ISLAND,               /* the distortion with the coloration, DSP_ISLAND */
+  DSP_STEP_COUNT
+};
+
+/* Everything one chain keeps from block to block. The default context,
+ * s_ctx, is the pedal's chain behind AppDsp_ProcessBlock(); more can be
+ * placed with AppDsp_ContextCreate(). Shared by every context: the
+ * parameters, the rate tables, the load shedding tier and the PROF/CLIP
+ * counters. Left to the default one (primary): the delay line, the reverb
+ * tank and the arena, the EQ (app_eq keeps its own state), the looper, the
+ * FMAC and IR cab, and the meter, capture, tuner and self-test taps.
+ */
+struct AppDspContext
+{
+  DspChanState ch[2];
+  GateState gate;
+  LimiterState limiter;
+  DspRamp makeup_q15;
+  TremoloState tremolo;
+  DspParamSmooth smooth;
+  DspFxStates fx;
+#if APP_DSP_BUS_FRAMES
+  DspBus bus;
+  DspWetCond wet_cond;
+#endif
+  DspStep steps[DSP_STEP_COUNT];
+  int32_t in_l2;                 /* DspBlockParams.in_l2 for the next block */
+#if DSP_SPILL
+  DspBlockParams bp[2];          /* this block's and, alternately, the last one's */
+  DspBlockParams *spill;         /* the one held for a spill, NULL = none */
+  const DspParams *seen;         /* the copy the last block ran on */
+  uint32_t spill_frames;         /* since the spill began */
+  uint8_t bp_cur;
+#endif
+#if DSP_ISLAND
+  uint8_t island;                /* this block colors on the island */
+#endif
+  uint8_t primary;
+};
+
+static AppDspContext s_ctx;
+
+/* FX a secondary context may run: the ones whose state is all in it. */
+#define DSP_CTX_SECONDARY_FX           (APP_FX_BIT_DISTORTION | APP_FX_BIT_PHASER)
+
+#define DSP_SCHED_TAPS                 (APP_METER_ENABLE || APP_CAPTURE_ENABLE)
+
+/* Meter and capture tap; the state pointer carries the AppMeterTap. */
+static int32_t tap_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  (void)state;
+  (void)x;
+  (void)n;
+  (void)p;
+  APP_METER_BLOCK((AppMeterTap)(uintptr_t)state, x, n, 0u);
+  APP_CAPTURE_TAP((AppMeterTap)(uintptr_t)state, x, n, 0u);
+  return peak;
+}
+
+/* Taps ahead of the mono copy only carry the left channel. */
+static int32_t tap_mono_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  (void)state;
+  (void)x;
+  (void)n;
+  (void)p;
+  APP_METER_BLOCK((AppMeterTap)(uintptr_t)state, x, n, 1u);
+  APP_CAPTURE_TAP((AppMeterTap)(uintptr_t)state, x, n, 1u);
+  return peak;
+}
+
+static int32_t stereo_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  (void)state;
+  (void)p;
+  mono_to_stereo_block(x, n);
+  return peak;
+}
+
+#if APP_DSP_BUS_FRAMES
+static int32_t bus_split_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  DspFxBus *b = (DspFxBus *)state;
+  (void)p;
+  memcpy(b->dry, x, n * sizeof(*x));
+  b->peak = peak;
+  return peak;
+}
+
+/* Park the branches so far and restart from the group input. */
+static int32_t bus_branch_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  DspFxBus *b = (DspFxBus *)state;
+  (void)p;
+  (void)peak;
+  memcpy(b->wet, x, n * sizeof(*x));
+  memcpy(x, b->dry, n * sizeof(*x));
+  return b->peak;
+}
+
+/* Add the branch to the parked ones, the dry signal counted once. Each
+ * term stays well inside int32; the sum is clamped, so the bound is s24.
+ */
+static int32_t bus_merge_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  const DspFxBus *b = (const DspFxBus *)state;
+  (void)p;
+  (void)peak;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    x[i].l = clamp_s24(x[i].l + b->wet[i].l - b->dry[i].l);
+    x[i].r = clamp_s24(x[i].r + b->wet[i].r - b->dry[i].r);
+  }
+  return DSP_MAG_S24;
+}
+
+static int32_t wet_bus_open_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  DspWetBus *b = (DspWetBus *)state;
+  (void)x;
+  (void)p;
+  memset(b->wet, 0, n * sizeof(b->wet[0]));
+  memset(b->duck, 0, n * sizeof(b->duck[0]));
+  return peak;
+}
+
+/* Conditions the members' wet sum once, sets its width and adds it to the
+ * ducked dry. The sum may spill past s24 like a member's own mix; returns
+ * its bound. The state is the context, for its bus and its conditioning.
+ */
+static int32_t wet_bus_mix_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  AppDspContext *ctx = (AppDspContext *)state;
+  const DspWetBus *b = &ctx->bus.mix;
+  DspWetCond *w = &ctx->wet_cond;
+  const int32_t width = p->wet_width_q15;
+  int32_t mag = 0;
+  (void)peak;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t wl = b->wet[i].l;
+    int32_t wr = b->wet[i].r;
+#if WET_HPF_ENABLE
+    wl = hpf1_s24(&w->hpf_l, wl, s_rate.wet_hpf_r_q15);
+    wr = hpf1_s24(&w->hpf_r, wr, s_rate.wet_hpf_r_q15);
+#endif
+    wl = onepole_lpf_s24(wl, &w->lpf_l, s_rate.wet_lpf_a_q15);
+    wr = onepole_lpf_s24(wr, &w->lpf_r, s_rate.wet_lpf_a_q15);
+    if (width != 32768)
+    {
+      /* Mid/side: the mid as it is, the side (l - r) / 2 times width. */
+      const int32_t mid = (wl + wr) >> 1;
+      const int32_t side = (int32_t)(((int64_t)(wl - wr) * width) >> 16);
+      wl = mid + side;
+      wr = mid - side;
+    }
+    const int32_t a = 32768 - b->duck[i];
+    x[i].l = (int32_t)(((int64_t)tail_dry_s24(x[i].l) * a) >> 15) + wl;
+    x[i].r = (int32_t)(((int64_t)tail_dry_s24(x[i].r) * a) >> 15) + wr;
+    mag |= mag_s24(x[i].l) | mag_s24(x[i].r);
+  }
+  return mag;
+}
+#endif
+
+/* Stands in for the EQ and the taps in a secondary context. */
+static int32_t skip_step(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p, int32_t peak)
+{
+  (void)state;
+  (void)x;
+  (void)n;
+  (void)p;
+  return peak;
+}
+
+#if DSP_ISLAND
+/* The distortion on the island (DSP_STEP_ISLAND); the state is the
+ * context, whose island flag says chain_run() left the coloration to it.
+ */
+APP_CCM_CODE static int32_t distortion_island_block(void *state, AppStereoS24 *x, uint32_t n, const DspBlockParams *p,
+                                                    int32_t peak)
+{
+  AppDspContext *ctx = (AppDspContext *)state;
+  distortion_run(&ctx->fx.distortion, x, n, p, ctx->island ? p->color_curve : NULL);
+  return mag_mix_s24(peak);
+}
+#endif
+
+static void sched_steps_init(AppDspContext *ctx)
+{
+  DspStep *s = ctx->steps;
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    s[DSP_STEP_FX + i].fn = k_fx_modules[i]->process_block;
+    s[DSP_STEP_FX + i].state = fx_state(&ctx->fx, i);
+    s[DSP_STEP_BUS_FX + i].fn = k_fx_modules[i]->bus_block;
+    s[DSP_STEP_BUS_FX + i].state = fx_state(&ctx->fx, i);
+#if APP_PROF_ENABLE || APP_DSP_CLIP
+    s[DSP_STEP_FX + i].fx = k_fx_modules[i];
+    s[DSP_STEP_BUS_FX + i].fx = k_fx_modules[i];
+#endif
+  }
+  for (uint32_t t = 0; t < (uint32_t)APP_METER_TAP_COUNT; t++)
+  {
+    s[DSP_STEP_TAP + (2u * t)].fn = ctx->primary ? tap_step : skip_step;
+    s[DSP_STEP_TAP + (2u * t)].state = (void *)(uintptr_t)t;
+    s[DSP_STEP_TAP + (2u * t) + 1u].fn = ctx->primary ? tap_mono_step : skip_step;
+    s[DSP_STEP_TAP + (2u * t) + 1u].state = (void *)(uintptr_t)t;
+  }
+  if (!ctx->primary)
+  {
+    /* The rest of the modules a secondary context may not run are off its
+     * mask (DSP_CTX_SECONDARY_FX).
+     */
+    s[DSP_STEP_FX + DSP_FX_eq].fn = skip_step;
+  }
+  s[DSP_STEP_STEREO].fn = stereo_step;
+#if APP_DSP_BUS_FRAMES
+  s[DSP_STEP_SPLIT].fn = bus_split_step;
+  s[DSP_STEP_SPLIT].state = &ctx->bus.par;
+  s[DSP_STEP_BRANCH].fn = bus_branch_step;
+  s[DSP_STEP_BRANCH].state = &ctx->bus.par;
+  s[DSP_STEP_MERGE].fn = bus_merge_step;
+  s[DSP_STEP_MERGE].state = &ctx->bus.par;
+  s[DSP_STEP_WET_OPEN].fn = wet_bus_open_step;
+  s[DSP_STEP_WET_OPEN].state = &ctx->bus.mix;
+  s[DSP_STEP_WET_MIX].fn = wet_bus_mix_step;
+  s[DSP_STEP_WET_MIX].state = ctx;
+#endif
+#if DSP_ISLAND
+  s[DSP_STEP_ISLAND].fn = distortion_island_block;
+  s[DSP_STEP_ISLAND].state = ctx;
+#if APP_PROF_ENABLE || APP_DSP_CLIP
+  s[DSP_STEP_ISLAND].fx = k_fx_modules[DSP_FX_distortion];
+#endif
+#endif
+}
+
+static inline void sched_push(DspSchedule *s, uint32_t m, uint32_t step)
+{
+  s->step[m][s->count[m]++] = (uint8_t)step;
+}
+
+static inline void sched_push_tap(DspSchedule *s, uint32_t m, const AppFxModule *fx, uint32_t stereo)
+{
+#if DSP_SCHED_TAPS
+  if (fx->meter_tap >= 0)
+  {
+    sched_push(s, m, DSP_STEP_TAP + (2u * (uint32_t)fx->meter_tap) + (stereo ? 0u : 1u));
+  }
+#else
+  (void)s;
+  (void)m;
+  (void)fx;
+  (void)stereo;
+#endif
+}
+
+static inline bool fx_runs(const AppFxModule *fx, AppFxMask m)
+{
+  return (fx->process_block != NULL) && ((fx->bit == 0u) || ((m & fx->bit) != 0u));
+}
+
+/* Lays c->chain out for every run mask. A stage is a module and the ones
+ * parallel to it; modules the mask leaves out are dropped, so a group down
+ * to one member runs serial. Their taps still read the stage's output.
+ * A wet-bus group stays on its bus down to one member, so the shared
+ * filters keep their state while members come and go; all its taps read
+ * the stage's output.
+ * Mono input turns stereo ahead of the first stage with a stereo module
+ * (AppDsp_SetChain() keeps mono modules ahead of it), or at the end.
+ * A serial distortion that only modules with an idle() hook run ahead of
+ * may take the coloration in with it (DSP_STEP_ISLAND): while they are
+ * idle nothing runs between the two nonlinearities, so they can share the
+ * distortion's resampling pair (island_open()).
+ */
+static void chain_compile(const DspParams *c, DspSchedule *s)
+{
+  s->bus = 0u;
+  s->island = 0u;
+  for (uint32_t m = 0; m < DSP_SCHED_SLOTS; m++)
+  {
+    const AppFxMask run = chain_slot_mask(m);
+    uint32_t stereo = APP_DSP_MONO_INPUT ? 0u : 1u;
+    s->count[m] = 0u;
+    s->lead[m] = 0u;
+#if DSP_ISLAND
+    uint32_t lead_steps = 0u;   /* all of them lead modules so far */
+#endif
+    for (uint32_t i = 0; i < DSP_FX_COUNT;)
+    {
+      uint32_t end = i + 1u;
+      while ((end < DSP_FX_COUNT) && (((c->chain_par >> end) & 1u) != 0u))
+      {
+        end++;
+      }
+
+      uint32_t runs = 0u;
+      uint32_t wants_stereo = 0u;
+      for (uint32_t k = i; k < end; k++)
+      {
+        const AppFxModule *fx = k_fx_modules[c->chain[k]];
+        wants_stereo |= fx->stereo;
+        runs += fx_runs(fx, run) ? 1u : 0u;
+      }
+      if (wants_stereo && !stereo)
+      {
+        sched_push(s, m, DSP_STEP_STEREO);
+        stereo = 1u;
+      }
+      if ((end > (i + 1u)) && (((c->chain_bus >> (i + 1u)) & 1u) != 0u))
+      {
+        if (runs > 0u)
+        {
+          sched_push(s, m, DSP_STEP_WET_OPEN);
+          for (uint32_t k = i; k < end; k++)
+          {
+            if (fx_runs(k_fx_modules[c->chain[k]], run))
+            {
+              sched_push(s, m, DSP_STEP_BUS_FX + c->chain[k]);
+            }
+          }
+          sched_push(s, m, DSP_STEP_WET_MIX);
+          s->bus = 1u;
+        }
+        for (uint32_t k = i; k < end; k++)
+        {
+          sched_push_tap(s, m, k_fx_modules[c->chain[k]], stereo);
+        }
+        i = end;
+        continue;
+      }
+      if (runs > 1u)
+      {
+        sched_push(s, m, DSP_STEP_SPLIT);
+        s->bus = 1u;
+      }
+
+      uint32_t branch = 0u;
+      for (uint32_t k = i; k < end; k++)
+      {
+        const AppFxModule *fx = k_fx_modules[c->chain[k]];
+        if (!fx_runs(fx, run))
+        {
+          continue;
+        }
+        if (branch > 0u)
+        {
+          sched_push(s, m, DSP_STEP_BRANCH);
+        }
+#if DSP_ISLAND
+        if ((s->count[m] == lead_steps) && (c->chain[k] == DSP_FX_distortion))
+        {
+          sched_push(s, m, DSP_STEP_ISLAND);
+          s->island |= 1u << m;
+        }
+        else if ((s->count[m] == lead_steps) && (fx->idle != NULL))
+        {
+          sched_push(s, m, DSP_STEP_FX + c->chain[k]);
+          s->lead[m] |= (uint16_t)(1u << c->chain[k]);
+          lead_steps++;
+        }
+        else
+#endif
+        {
+          sched_push(s, m, DSP_STEP_FX + c->chain[k]);
+        }
+        sched_push_tap(s, m, fx, stereo);
+        if (branch > 0u)
+        {
+          sched_push(s, m, DSP_STEP_MERGE);
+        }
+        branch++;
+      }
+      for (uint32_t k = i; k < end; k++)
+      {
+        const AppFxModule *fx = k_fx_modules[c->chain[k]];
+        if (!fx_runs(fx, run))
+        {
+          sched_push_tap(s, m, fx, stereo);
+        }
+      }
+      i = end;
+    }
+    if (!stereo)
+    {
+      sched_push(s, m, DSP_STEP_STEREO);
+    }
+  }
+}
+
+/* Gate shut, every tail asleep and the looper idle: the rest of the chain
+ * would only turn zeros into zeros.
+ */
+static inline bool gate_idle(AppDspContext *ctx)
+{
+  return (ctx->gate.gain.cur == 0) && (ctx->gate.gain.target == 0) && fx_tails_asleep(&ctx->fx) &&
+         !(ctx->primary && loop_busy());
+}
+
+/* clamp_s24() where sat; sat is a constant in each instance. */
+static inline __attribute__((always_inline)) int32_t sat_s24(int32_t x, bool sat)
+{
+  return sat ? clamp_s24(x) : x;
+}
+
+static inline __attribute__((always_inline)) void output_run(DspRamp *makeup, TremoloState *trem, AppStereoS24 *x,
+                                                             uint32_t n, const DspBlockParams *p, bool sat,
+                                                             bool tremolo)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t makeup_q15 = ramp_next(makeup);
+#if DSP_FUSED_COND
+    /* Makeup and master volume as one gain. */
+    const int64_t g = ((int64_t)makeup_q15 * p->gain_q15) >> 15;
+    int32_t lv = (int32_t)(((int64_t)x[i].l * g) >> 15);
+    int32_t rv = (int32_t)(((int64_t)x[i].r * g) >> 15);
+#else
+    int32_t lv = (int32_t)(((int64_t)x[i].l * makeup_q15) >> 15);
+    int32_t rv = (int32_t)(((int64_t)x[i].r * makeup_q15) >> 15);
+
+    /* Master volume control (unity by default). */
+    lv = (int32_t)(((int64_t)lv * (int64_t)p->gain_q15) >> 15);
+    rv = (int32_t)(((int64_t)rv * (int64_t)p->gain_q15) >> 15);
+#endif
+    if (tremolo)
+    {
+      lv = (int32_t)(((int64_t)lv * ramp_next(&trem->gain_l)) >> 15);
+      rv = (int32_t)(((int64_t)rv * ramp_next(&trem->gain_r)) >> 15);
+    }
+    x[i].l = sat_s24(lv, sat);
+    x[i].r = sat_s24(rv, sat);
+  }
+}
+
+/* Tremolo gain for LFO value v (Q15): the sine swings the gain between
+ * 1 - depth and 1.
+ */
+static inline int32_t tremolo_gain_q15(int32_t v, int32_t depth_q15)
+{
+  return 32768 - (int32_t)(((int64_t)depth_q15 * (32768 - v)) >> 16);
+}
+
+/* Advances the LFO by the block and points the gain ramps at its end.
+ * Returns false while the tremolo is off and its gains rest at unity.
+ */
+static bool tremolo_block(TremoloState *st, uint32_t n, const DspBlockParams *p)
+{
+  if ((p->tremolo_depth_q15 == 0) && (st->gain_l.cur == 32768) && (st->gain_r.cur == 32768))
+  {
+    return false;
+  }
+  if (st->rate_mhz != p->tremolo_rate_mhz)
+  {
+    st->rate_mhz = p->tremolo_rate_mhz;
+    AppLfo_SetRate(&st->lfo, st->rate_mhz, DSP_SAMPLE_RATE_HZ);
+  }
+  AppLfoSeg seg;
+  AppLfo_Block(&st->lfo, n, &seg);
+
+  const int32_t v = st->lfo.sin_q15;
+  const int32_t vr = (int32_t)(((int64_t)v * (32768 - (2 * p->tremolo_pan_q15))) >> 15);
+  ramp_set_len(&st->gain_l, tremolo_gain_q15(v, p->tremolo_depth_q15), (int32_t)n);
+  ramp_set_len(&st->gain_r, tremolo_gain_q15(vr, p->tremolo_depth_q15), (int32_t)n);
+  return true;
+}
+
+/* Makeup gain -> master volume -> tremolo. The ramp is linear, so its
+ * larger end and the volume bound the gain over the block; at unity or
+ * below the output of an in-range block needs no clamp. The tremolo only
+ * ever attenuates.
+ */
+APP_CCM_CODE static void output_block(DspRamp *makeup, TremoloState *trem, AppStereoS24 *x, uint32_t n,
+                                      const DspBlockParams *p, int32_t peak)
+{
+  const int32_t makeup_max = (makeup->cur > makeup->target) ? makeup->cur : makeup->target;
+#if DSP_FUSED_COND
+  const int32_t bound = mag_gain_q15(peak, (int32_t)(((int64_t)makeup_max * p->gain_q15) >> 15));
+#else
+  const int32_t bound = mag_gain_q15(mag_gain_q15(peak, makeup_max), p->gain_q15);
+#endif
+  const bool sat = headroom_sat(bound);
+  if (tremolo_block(trem, n, p))
+  {
+    if (sat)
+    {
+      output_run(makeup, trem, x, n, p, true, true);
+    }
+    else
+    {
+      output_run(makeup, trem, x, n, p, false, true);
+    }
+  }
+  else if (sat)
+  {
+    output_run(makeup, trem, x, n, p, true, false);
+  }
+  else
+  {
+    output_run(makeup, trem, x, n, p, false, false);
+  }
+}
+
+#if AUDIO_LIMITER_LOOKAHEAD
+/* Pushes the peak of the sub-block just completed and returns the max of
+ * the last LIMITER_LA_SUBS ones.
+ */
+static inline int32_t limiter_window_max(LimiterState *st, int32_t peak)
+{
+  const uint32_t seq = st->seq++;
+  if ((st->dq_len != 0u) && ((seq - st->dq_seq[st->dq_head]) >= LIMITER_LA_SUBS))
+  {
+    st->dq_head = (st->dq_head + 1u) % LIMITER_LA_SUBS;
+    st->dq_len--;
+  }
+  while ((st->dq_len != 0u) && (st->dq_peak[(st->dq_head + st->dq_len - 1u) % LIMITER_LA_SUBS] <= peak))
+  {
+    st->dq_len--;
+  }
+  const uint32_t tail = (st->dq_head + st->dq_len) % LIMITER_LA_SUBS;
+  st->dq_peak[tail] = peak;
+  st->dq_seq[tail] = seq;
+  st->dq_len++;
+  return st->dq_peak[st->dq_head];
+}
+
+/* Sets the ramp for the next LIMITER_SUB output frames, which are the
+ * oldest sub-block of the window. Its end gain is under thresh / peak of
+ * the current window and the ramp starts from the previous end gain,
+ * which was under that of the window before, one sub-block older: with
+ * two or more sub-blocks of lookahead both bound the frames played next,
+ * so the whole (linear) ramp does. One reciprocal lookup per sub-block.
+ */
+static inline void limiter_sub_end(LimiterState *st)
+{
+  const int32_t m = limiter_window_max(st, st->peak);
+  st->peak = 0;
+
+  int32_t target = 32768;
+  if (m > AUDIO_LIMITER_THRESH_S24)
+  {
+    target = (int32_t)AppTab_DivQ15((uint32_t)AUDIO_LIMITER_THRESH_S24, (uint32_t)m);
+  }
+
+  const int32_t g = st->gain_q15;
+  int32_t end = target;
+  if (target > g)
+  {
+    /* Release: one-pole per sub-block, from below the target. */
+    end = g + (int32_t)(((int64_t)s_rate.limiter_release_sub_q15 * (target - g)) >> 15);
+  }
+  st->step_q15 = (end - g) >> LIMITER_SUB_SHIFT;
+}
+
+/* Final protection against transient overload (stereo-linked), with
+ * LIMITER_LA_FRAMES of lookahead: the gain glides down over a sub-block
+ * ahead of a peak instead of clamping at it.
+ */
+APP_CCM_CODE static void limiter_block(LimiterState *st, AppStereoS24 *x, uint32_t n)
+{
+  int32_t g = st->gain_q15;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const AppStereoS24 in = x[i];
+    const int32_t a = abs_s32(in.l);
+    const int32_t b = abs_s32(in.r);
+    const int32_t pk = (a > b) ? a : b;
+    if (pk > st->peak)
+    {
+      st->peak = pk;
+    }
+
+    const AppStereoS24 v = st->line[st->line_idx];
+    st->line[st->line_idx] = in;
+    st->line_idx = (st->line_idx + 1u) % LIMITER_LA_FRAMES;
+
+    /* The line only holds output_block() frames, which are in range, and g
+     * stays at or under unity: the product needs no clamp.
+     */
+    g += st->step_q15;
+    x[i].l = sat_s24((int32_t)(((int64_t)v.l * g) >> 15), !DSP_HEADROOM);
+    x[i].r = sat_s24((int32_t)(((int64_t)v.r * g) >> 15), !DSP_HEADROOM);
+
+    if (++st->pos == LIMITER_SUB)
+    {
+      st->pos = 0u;
+      st->gain_q15 = g = (g > 32768) ? 32768 : g;
+      limiter_sub_end(st);
+    }
+  }
+  st->gain_q15 = g;
+  st->drain = LIMITER_LA_FRAMES;
+}
+#else
+/* Final protection against transient overload (stereo-linked). */
+APP_CCM_CODE static void limiter_block(LimiterState *st, AppStereoS24 *x, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    /* In range from output_block(), and the gain is at most unity. */
+    AppStereoS24 v = x[i];
+    limiter_process_s24(st, &v.l, &v.r);
+    v.l = sat_s24(v.l, !DSP_HEADROOM);
+    v.r = sat_s24(v.r, !DSP_HEADROOM);
+    x[i] = v;
+  }
+}
+#endif
+
+/* ------------------------------- Public API ------------------------------- */
+
+/* One-pole pole or leak r tuned at 48 kHz, for the same corner (time
+ * constant) at fs_hz: r^(48 kHz / fs). Exact at 48 kHz.
+ */
+static int32_t rate_pole_q15(int32_t r_q15, uint32_t fs_hz)
+{
+  const float k = (float)DSP_RATE_BASE_HZ / (float)fs_hz;
+  return (int32_t)((powf((float)r_q15 * (1.0f / 32768.0f), k) * 32768.0f) + 0.5f);
+}
+
+/* One-pole smoothing step a (y += a (x - y)): 1 - (1 - a)^(48 kHz / fs). */
+static int32_t rate_step_q15(int32_t a_q15, uint32_t fs_hz)
+{
+  const int32_t a = 32768 - rate_pole_q15(32768 - a_q15, fs_hz);
+  return (a < 1) ? 1 : a;
+}
+
+static void rate_init(void)
+{
+  const uint32_t fs = DSP_SAMPLE_RATE_HZ;
+  s_rate.dc_r_q15 = APP_COEF_Q15(APP_COEF_POLE(DC_BLOCK_FC_HZ, DSP_SAMPLE_RATE_HZ));
+  s_rate.clean_hpf_r_q15 = APP_COEF_Q15(APP_COEF_POLE(CLEAN_HPF_FC_HZ, DSP_SAMPLE_RATE_HZ));
+  s_rate.comp_env_attack_q15 = rate_step_q15(CLEAN_COMP_ENV_ATTACK_Q15, fs);
+  s_rate.comp_env_release_q15 = rate_step_q15(CLEAN_COMP_ENV_RELEASE_Q15, fs);
+  s_rate.comp_gain_attack_q15 = rate_step_q15(CLEAN_COMP_GAIN_ATTACK_Q15, fs);
+  s_rate.comp_gain_release_q15 = rate_step_q15(CLEAN_COMP_GAIN_RELEASE_Q15, fs);
+  s_rate.wet_hpf_r_q15 = APP_COEF_Q15(APP_COEF_POLE(WET_HPF_FC_HZ, DSP_SAMPLE_RATE_HZ));
+  s_rate.wet_lpf_a_q15 = rate_step_q15(WET_LPF_A_Q15, fs);
+  /* At fs / DELAY_DECIM, which scales by the same ratio. */
+  s_rate.delay_fb_lpf_a_q15 = rate_step_q15(DELAY_FB_LPF_A_Q15, fs);
+  s_rate.reverb_wet_hpf_r_q15 = APP_COEF_Q15(APP_COEF_POLE(WET_HPF_FC_HZ, REVERB_FS_HZ));
+  s_rate.reverb_wet_lpf_a_q15 = rate_step_q15(WET_LPF_A_Q15, REVERB_FS_HZ);
+  s_rate.limiter_release_q15 = rate_step_q15(AUDIO_LIMITER_RELEASE_Q15, fs);
+  s_rate.limiter_release_sub_q15 = rate_step_q15(AUDIO_LIMITER_RELEASE_Q15, fs / LIMITER_SUB);
+  s_rate.cab_b_q28[0] = CAB_B0_Q28;
+  s_rate.cab_b_q28[1] = CAB_B1_Q28;
+  s_rate.cab_b_q28[2] = CAB_B2_Q28;
+  s_rate.cab_a_q28[0] = CAB_A1_Q28;
+  s_rate.cab_a_q28[1] = CAB_A2_Q28;
+#if DSP_FUSED_COND
+  /* (1 - r1 z^-1)(1 - r2 z^-1): a1 = -(r1 + r2), a2 = r1 r2. */
+  const int32_t r1 = s_rate.dc_r_q15;
+  const int32_t r2 = s_rate.clean_hpf_r_q15;
+  s_rate.cond_g_q24 = AUDIO_INPUT_GAIN_Q8 << 16;
+  s_rate.cond_a_q28[0] = -((r1 + r2) << 13);
+  s_rate.cond_a_q28[1] = (int32_t)(((int64_t)r1 * r2) >> 2);
+#endif
+}
+
+/* A context's own filters, gains and ramps, FX aside; the ramps start at
+ * the current parameters.
+ */
+static void ctx_reset(AppDspContext *ctx)
+{
+  const DspParams *c = s_params_front;
+
+#if AUDIO_LIMITER_LOOKAHEAD
+  memset(&ctx->limiter, 0, sizeof(ctx->limiter));
+#endif
+  ctx->limiter.gain_q15 = 32768;
+#if APP_DSP_BUS_FRAMES
+  memset(&ctx->wet_cond, 0, sizeof(ctx->wet_cond));
+#endif
+  gate_reset(&ctx->gate);
+  ctx->in_l2 = DSP_LEVEL_FLOOR_L2;
+#if DSP_SPILL
+  ctx->spill = NULL;
+  ctx->seen = c;
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    if ((k_fx_modules[i]->bit & DSP_SPILL_FX) != 0u)
+    {
+      fx_fade(&ctx->fx, i)->spill = 0u;
+    }
+  }
+#endif
+
+  ramp_reset(&ctx->makeup_q15, AUDIO_MAKEUP_GAIN_Q8 * 128);
+  ctx->tremolo.rate_mhz = c->tremolo_rate_mhz;
+  AppLfo_Reset(&ctx->tremolo.lfo, ctx->tremolo.rate_mhz, DSP_SAMPLE_RATE_HZ, 0U);
+  ramp_reset(&ctx->tremolo.gain_l, 32768);
+  ramp_reset(&ctx->tremolo.gain_r, 32768);
+
+  DspParamSmooth *sm = &ctx->smooth;
+  ramp_reset(&sm->dist_drive_q8, c->dist_drive_q8);
+  ramp_reset(&sm->delay_mix_q15, c->delay_mix_q15);
+  ramp_reset(&sm->delay_feedback_q15, c->delay_feedback_q15);
+  ramp_reset(&sm->reverb_mix_q15, c->reverb_mix_q15);
+  for (uint32_t k = 0; k < REVERB_FDN_LINES; k++)
+  {
+    ramp_reset(&sm->reverb_feedback_q15[k], c->reverb_line_fb_q15[k]);
+    ramp_reset(&sm->reverb_damp_q15[k], c->reverb_line_damp_q15[k]);
+  }
+  ramp_reset(&sm->reverb_er_q15, c->reverb_er_q15);
+  ramp_reset(&sm->reverb_spring_fb_q15, c->reverb_spring_fb_q15);
+  ramp_reset(&sm->reverb_in_q15, c->reverb_freeze ? 0 : 32768);
+  ramp_reset(&sm->chorus_mix_q15, c->chorus_mix_q15);
+  ramp_reset(&sm->chorus_depth_q15, c->chorus_depth_q15);
+  ramp_reset(&sm->chorus_feedback_q15, c->chorus_feedback_q15);
+  ramp_reset(&sm->phaser_mix_q15, c->phaser_mix_q15);
+  ramp_reset(&sm->phaser_depth_q15, c->phaser_depth_q15);
+  ramp_reset(&sm->tremolo_depth_q15, c->tremolo_depth_q15);
+  ramp_reset(&sm->tremolo_pan_q15, c->tremolo_pan_q15);
+  ramp_reset(&sm->wah_mix_q15, c->wah_mix_q15);
+  ramp_reset(&sm->wah_depth_q15, c->wah_depth_q15);
+  ramp_reset(&sm->pitch_mix_q15, c->pitch_mix_q15);
+  ramp_reset(&sm->tone_bass_q15, c->tone_bass_q15);
+  ramp_reset(&sm->tone_mid_q15, c->tone_mid_q15);
+  ramp_reset(&sm->tone_treble_q15, c->tone_treble_q15);
+  ramp_reset(&sm->gain_q15, c->gain_q15);
+  ramp_reset(&sm->wet_width_q15, c->wet_width_q15);
+
+  for (uint32_t i = 0; i < 2u; i++)
+  {
+    DspChanState *ch = &ctx->ch[i];
+#if DSP_FUSED_COND
+    memset(&ch->cond, 0, sizeof(ch->cond));
+#else
+    ch->dc.x1 = ch->dc.y1 = 0;
+    ch->clean_hpf.x1 = ch->clean_hpf.y1 = 0;
+#endif
+    ch->comp.env = 0;
+    ch->comp.gain_q15 = 32768;
+    ch->comp.target_q15 = 32768;
+  }
+}
+
+/* The FX lines and states of the primary context. */
+static void fx_state_reset(uint32_t zeroed)
+{
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    if (k_fx_modules[i]->reset != NULL)
+    {
+      k_fx_modules[i]->reset(fx_state(&s_ctx.fx, i), zeroed);
+    }
+  }
+#if CABSIM_IR
+  /* The tank was just cleared; the IR cab gets the overlay back at the
+   * first block without the reverb.
+   */
+  AppCabIr_Attach(NULL);
+  s_arena_reverb = 1u;
+#endif
+}
+
+/* Clears every filter, line and ramp; the ramps start at the current
+ * parameters.
+ */
+/* zeroed: the buffers and filter states are known to be all-zero already
+ * (first init after reset), so only the non-zero state is written.
+ */
+static void dsp_state_reset(uint32_t zeroed)
+{
+  fx_state_reset(zeroed);
+  loop_reset();
+  s_shed.tier = 0u;
+  s_shed.calm_frames = 0u;
+  s_shed.budget = 0u;      /* no last block to predict from */
+  s_shed.dist_cyc = 0u;
+  AppMeter_Reset();
+  ctx_reset(&s_ctx);
+}
+
+/* Same layout on every call: the pointers never move once audio runs. */
+static void arena_layout(void)
+{
+  AppArena *a = &s_fx_arena;
+  AppArena_Init(a, s_fx_arena_pool, (uint32_t)sizeof(s_fx_arena_pool));
+#if DELAY_IN_ARENA
+  s_delay_buf = (uint32_t *)AppArena_Alloc(a, DELAY_BYTES);
+#endif
+#if APP_DSP_CHORUS_ENABLE
+  s_chorus_buf = (uint32_t *)AppArena_Alloc(a, CHORUS_BYTES);
+#endif
+#if APP_DSP_PITCH_ENABLE
+  s_pitch_buf = (uint32_t *)AppArena_Alloc(a, PITCH_BYTES);
+#endif
+  AppArena_OverlayBegin(a);
+  s_reverb_fdn = (uint32_t *)AppArena_Alloc(a, REVERB_FDN_BYTES);
+  s_reverb_ap = (DspFiltStereo *)AppArena_Alloc(a, REVERB_AP_BYTES);
+#if CABSIM_IR
+  AppArena_OverlayNext(a);
+  s_cabir_fdl = AppArena_Alloc(a, APP_CABIR_FDL_BYTES);
+#endif
+  AppArena_OverlayEnd(a);
+}
+
+static void dsp_init(uint32_t zeroed)
+{
+  s_mode = APP_FX_MODE_BYPASS;
+  s_button_last_ms = 0;
+  s_tap.taps = 0u;
+
+  s_params[0] = k_params_boot;
+  s_params_front = &s_params[0];
+  s_params_edit = NULL;
+  s_params_batch = 0u;
+#if APP_DSP_PARAM_EVENTS
+  s_param_ev_head = 0u;
+  s_param_ev_tail = 0u;
+#endif
+  s_frame_clock = 0u;
+  s_bypass = APP_DSP_BYPASS_OFF;
+  s_bypass_run = APP_DSP_BYPASS_OFF;
+  s_bypass_hold = 0u;
+  s_bypass_join = 0u;
+  rate_init();
+  DspParams *e = params_edit();
+  e->fx_mask = 0u;
+  e->delay_pattern = k_delay_patterns[e->delay_pattern_id];
+  s_ctx.primary = 1u;
+  sched_steps_init(&s_ctx);
+  s_params_chain_dirty = 1u;
+  params_publish();
+  arena_layout();
+
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    if (k_fx_modules[i]->init != NULL)
+    {
+      k_fx_modules[i]->init(fx_state(&s_ctx.fx, i));
+    }
+  }
+  shed_init();
+  dsp_state_reset(zeroed);
+}
+
+void AppDsp_Init(void)
+{
+  dsp_init(0U);
+}
+
+void AppDsp_InitAtBoot(void)
+{
+  dsp_init(1U);
+}
+
+void AppDsp_OnButtonPress(uint32_t now_ms)
+{
+  /* Debounce: ignore edges within 300 ms. */
+  if ((now_ms - s_button_last_ms) < 300U)
+  {
+    return;
+  }
+  s_button_last_ms = now_ms;
+
+  switch (s_mode)
+  {
+    case APP_FX_MODE_BYPASS:
+      s_mode = APP_FX_MODE_DISTORTION;
+      break;
+    case APP_FX_MODE_DISTORTION:
+      s_mode = APP_FX_MODE_REVERB;
+      break;
+    case APP_FX_MODE_REVERB:
+      s_mode = APP_FX_MODE_DELAY;
+      break;
+    case APP_FX_MODE_DELAY:
+      s_mode = APP_FX_MODE_ALL;
+      break;
+    default:
+      s_mode = APP_FX_MODE_BYPASS;
+      break;
+  }
+
+  /* Keep mask consistent with legacy mode cycling. */
+  AppFxMask mask = 0;
+  if (s_mode == APP_FX_MODE_DISTORTION) mask = APP_FX_BIT_DISTORTION;
+  else if (s_mode == APP_FX_MODE_REVERB) mask = APP_FX_BIT_REVERB;
+  else if (s_mode == APP_FX_MODE_DELAY) mask = APP_FX_BIT_DELAY;
+  else if (s_mode == APP_FX_MODE_ALL) mask = APP_FX_BIT_DISTORTION | APP_FX_BIT_REVERB | APP_FX_BIT_DELAY;
+  params_edit()->fx_mask = mask;
+  params_publish();
+}
+
+AppFxMode AppDsp_GetMode(void)
+{
+  return (AppFxMode)s_mode;
+}
+
+uint32_t AppDsp_TapTempo(uint32_t now_ms)
+{
+  const uint32_t gap = now_ms - s_tap.last_ms;
+  if ((s_tap.taps != 0u) && (gap < TAP_BOUNCE_MS))
+  {
+    return 0u;
+  }
+  s_tap.last_ms = now_ms;
+  if ((s_tap.taps == 0u) || (gap > TAP_TIMEOUT_MS))
+  {
+    s_tap.taps = 1u;
+    return 0u;
+  }
+  s_tap.interval_ms[(s_tap.taps - 1u) % TAP_INTERVALS] = gap;
+  s_tap.taps++;
+
+  const uint32_t n = ((s_tap.taps - 1u) < TAP_INTERVALS) ? (s_tap.taps - 1u) : TAP_INTERVALS;
+  uint32_t sum = 0u;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    sum += s_tap.interval_ms[i];
+  }
+  AppDsp_SetParam(APP_DSP_PARAM_TEMPO_BPM, (int32_t)(((60000U * n) + (sum / 2U)) / sum));
+  return (uint32_t)AppDsp_GetParam(APP_DSP_PARAM_TEMPO_BPM);
+}
+
+uint8_t AppDsp_ParamBuilt(AppDspParamId id, int32_t value)
+{
+#if APP_DSP_SPRING_ENABLE
+  (void)value;
+#endif
+  switch (id)
+  {
+    case APP_DSP_PARAM_CHORUS_MIX_Q15:
+    case APP_DSP_PARAM_CHORUS_RATE_MHZ:
+    case APP_DSP_PARAM_CHORUS_DEPTH_Q15:
+    case APP_DSP_PARAM_CHORUS_TIME_US:
+    case APP_DSP_PARAM_CHORUS_FEEDBACK_Q15:
+    case APP_DSP_PARAM_CHORUS_SPREAD_DEG:
+    case APP_DSP_PARAM_CHORUS_SYNC:
+      return APP_DSP_CHORUS_ENABLE ? 1u : 0u;
+    case APP_DSP_PARAM_PITCH_MIX_Q15:
+    case APP_DSP_PARAM_PITCH_CENTS:
+    case APP_DSP_PARAM_PITCH_WINDOW_MS:
+      return APP_DSP_PITCH_ENABLE ? 1u : 0u;
+    case APP_DSP_PARAM_WET_WIDTH_Q15:
+      return (APP_DSP_BUS_FRAMES > 0u) ? 1u : 0u;
+#if !APP_DSP_SPRING_ENABLE
+    case APP_DSP_PARAM_REVERB_TYPE:
+      /* AppDsp_SetParam() clamps anything above into the spring. */
+      return (value >= (int32_t)APP_DSP_REVERB_TYPE_SPRING) ? 0u : 1u;
+#endif
+    default:
+      return 1u;
+  }
+}
+
+void AppDsp_SetFxMask(AppFxMask mask)
+{
+  mask &= (AppFxMask)(APP_FX_BIT_DISTORTION | APP_FX_BIT_REVERB | APP_FX_BIT_DELAY |
+                      (APP_DSP_CHORUS_ENABLE ? APP_FX_BIT_CHORUS : 0u) | APP_FX_BIT_PHASER);
+  params_edit()->fx_mask = mask;
+  params_publish();
+
+  /* Update legacy mode for existing status/LED timing logic. */
+  if (mask == 0)
+  {
+    s_mode = APP_FX_MODE_BYPASS;
+  }
+  else if (mask == APP_FX_BIT_DISTORTION)
+  {
+    s_mode = APP_FX_MODE_DISTORTION;
+  }
+  else if (mask == APP_FX_BIT_REVERB)
+  {
+    s_mode = APP_FX_MODE_REVERB;
+  }
+  else if (mask == APP_FX_BIT_DELAY)
+  {
+    s_mode = APP_FX_MODE_DELAY;
+  }
+  else
+  {
+    s_mode = APP_FX_MODE_ALL;
+  }
+}
+
+AppFxMask AppDsp_GetFxMask(void)
+{
+  return params_view()->fx_mask;
+}
+
+void AppDsp_SetBypass(AppDspBypass tier)
+{
+  if ((uint32_t)tier < (uint32_t)APP_DSP_BYPASS_COUNT)
+  {
+    s_bypass = (uint8_t)tier;
+  }
+}
+
+AppDspBypass AppDsp_GetBypass(void)
+{
+  return (AppDspBypass)s_bypass;
+}
+
+uint8_t AppDsp_SetChain(const char *spec)
+{
+  if (spec == NULL)
+  {
+    return 0u;
+  }
+
+  uint8_t chain[DSP_FX_COUNT];
+  uint32_t par = 0u;
+  uint32_t bus = 0u;
+  uint32_t used = 0u;
+  uint32_t count = 0u;
+  char sep = '>';
+  char joined = '>';             /* how the current group is joined */
+  for (;;)
+  {
+    size_t len = strcspn(spec, ">|+");
+    uint32_t id = 0u;
+    while ((id < DSP_FX_COUNT) &&
+           ((strlen(k_fx_modules[id]->name) != len) || (strncmp(k_fx_modules[id]->name, spec, len) != 0)))
+    {
+      id++;
+    }
+    if ((id >= DSP_FX_COUNT) || ((used & (1u << id)) != 0u))
+    {
+      return 0u;
+    }
+    if (sep != '>')
+    {
+      /* One kind of join per group; wet-bus members need a bus variant. */
+      if (((joined != '>') && (joined != sep)) ||
+          ((sep == '+') && ((k_fx_modules[id]->bus_block == NULL) || (k_fx_modules[chain[count - 1u]]->bus_block == NULL))))
+      {
+        return 0u;
+      }
+      par |= 1u << count;
+      bus |= (sep == '+') ? (1u << count) : 0u;
+    }
+    joined = sep;
+    used |= 1u << id;
+    chain[count++] = (uint8_t)id;
+    if (spec[len] == 0)
+    {
+      break;
+    }
+    sep = spec[len];
+    spec += len + 1u;
+  }
+  if (count != DSP_FX_COUNT)
+  {
+    return 0u;
+  }
+#if !APP_DSP_BUS_FRAMES
+  if (par != 0u)
+  {
+    return 0u;
+  }
+#endif
+#if APP_DSP_MONO_INPUT
+  /* Mono modules only process L: none may follow or join a stereo one. */
+  uint32_t stereo = 0u;
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    const uint32_t st = k_fx_modules[chain[i]]->stereo;
+    if ((stereo && !st) || ((((par >> i) & 1u) != 0u) && (st != k_fx_modules[chain[i - 1u]]->stereo)))
+    {
+      return 0u;
+    }
+    stereo |= st;
+  }
+#endif
+
+  DspParams *e = params_edit();
+  memcpy(e->chain, chain, sizeof(chain));
+  e->chain_par = (uint8_t)par;
+  e->chain_bus = (uint8_t)bus;
+  s_params_chain_dirty = 1u;
+  params_publish();
+  return 1u;
+}
+
+void AppDsp_GetChain(char *out, uint32_t size)
+{
+  if ((out == NULL) || (size == 0u))
+  {
+    return;
+  }
+  const DspParams *c = params_view();
+  uint32_t k = 0u;
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    const char *name = k_fx_modules[c->chain[i]]->name;
+    const size_t len = strlen(name);
+    if ((k + len + 2u) > size)
+    {
+      break;
+    }
+    if (i > 0u)
+    {
+      out[k++] = (((c->chain_bus >> i) & 1u) != 0u) ? '+' :
+                 (((c->chain_par >> i) & 1u) != 0u) ? '|' : '>';
+    }
+    memcpy(&out[k], name, len);
+    k += (uint32_t)len;
+  }
+  out[k] = 0;
+}
+
+static inline int32_t clamp_q15(int32_t x)
+{
+  if (x < 0) return 0;
+  if (x > 32768) return 32768;
+  return x;
+}
+
+uint32_t AppDsp_GetDelayMaxMs(void)
+{
+  return (DELAY_LEN * DELAY_DECIM * 1000U) / DSP_SAMPLE_RATE_HZ;
+}
+
+uint8_t AppDsp_SetDelayTap(uint32_t index, const AppDspDelayTap *tap)
+{
+  if ((index >= APP_DSP_DELAY_TAPS_MAX) || (tap == NULL))
+  {
+    return 0;
+  }
+
+  AppDspDelayTap t = *tap;
+  if (t.time_q12 > 4096U) t.time_q12 = 4096U;
+  if (t.pan_q15 > 32768U) t.pan_q15 = 32768U;
+  t.gain_q15 = clamp_q15(t.gain_q15);
+  params_edit()->delay_pattern.tap[index] = t;
+  params_publish();
+  return 1;
+}
+
+uint8_t AppDsp_GetDelayTap(uint32_t index, AppDspDelayTap *out)
+{
+  if ((index >= APP_DSP_DELAY_TAPS_MAX) || (out == NULL))
+  {
+    return 0;
+  }
+  *out = params_view()->delay_pattern.tap[index];
+  return 1;
+}
+
+uint8_t AppDsp_SetCabSection(uint32_t index, const int32_t sos[5])
+{
+#if APP_DSP_CAB_SECTIONS_MAX
+  if ((index >= APP_DSP_CAB_SECTIONS_MAX) || (sos == NULL))
+  {
+    return 0;
+  }
+  /* Stability triangle: |a2| < 1 and |a1| < 1 + a2. */
+  const int64_t one = (int64_t)1 << 28;
+  const int64_t a1 = sos[3];
+  const int64_t a2 = sos[4];
+  if ((a2 >= one) || (a2 <= -one) || (a1 >= (one + a2)) || (-a1 >= (one + a2)))
+  {
+    return 0;
+  }
+  (void)memcpy(params_edit()->cab_sos[index], sos, 5u * sizeof(int32_t));
+  params_publish();
+  return 1;
+#else
+  (void)index;
+  (void)sos;
+  return 0;
+#endif
+}
+
+uint8_t AppDsp_GetCabSection(uint32_t index, int32_t sos[5])
+{
+#if APP_DSP_CAB_SECTIONS_MAX
+  if ((index >= APP_DSP_CAB_SECTIONS_MAX) || (sos == NULL))
+  {
+    return 0;
+  }
+  (void)memcpy(sos, params_view()->cab_sos[index], 5u * sizeof(int32_t));
+  return 1;
+#else
+  (void)index;
+  (void)sos;
+  return 0;
+#endif
+}
+
+uint8_t AppDsp_SetCabSections(uint32_t count)
+{
+  if (count > APP_DSP_CAB_SECTIONS_MAX)
+  {
+    return 0;
+  }
+  params_edit()->cab_sections = count;
+  params_publish();
+  return 1;
+}
+
+uint32_t AppDsp_GetCabSections(void)
+{
+  return params_view()->cab_sections;
+}
+
+void AppDsp_SetLoopBuffer(uint32_t *buf, uint32_t bytes)
+{
+  s_loop.buf = buf;
+  s_loop.bytes = (buf != NULL) ? bytes : 0U;
+  /* Whole S12 pairs only: the mono writes rewrite both halves. */
+  s_loop.cap = APP_DLINE_FRAMES(s_loop.bytes, 1U, APP_DSP_LOOP_STORAGE) & ~1U;
+  loop_reset();
+}
+
+uint8_t AppDsp_LoopCommand(AppDspLoopCmd cmd)
+{
+  if ((s_loop.cap == 0U) || ((uint32_t)cmd > (uint32_t)APP_DSP_LOOP_CMD_CLEAR))
+  {
+    return 0;
+  }
+  s_loop_req = (((s_loop_req >> 8) + 1U) << 8) | (uint32_t)cmd;
+  return 1;
+}
+
+void AppDsp_GetLoopInfo(AppDspLoopInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->state = s_loop.state;
+  out->len_ms = (s_loop.len * DELAY_DECIM * 1000U) / DSP_SAMPLE_RATE_HZ;
+  out->pos_ms = (s_loop.pos * DELAY_DECIM * 1000U) / DSP_SAMPLE_RATE_HZ;
+  out->max_ms = (s_loop.cap * DELAY_DECIM * 1000U) / DSP_SAMPLE_RATE_HZ;
+  out->bytes = s_loop.bytes;
+}
+
+void AppDsp_BeginParams(void)
+{
+  s_params_batch = 1u;
+}
+
+void AppDsp_CommitParams(void)
+{
+  s_params_batch = 0u;
+  params_publish();
+}
+
+void AppDsp_CommitParamsSpill(void)
+{
+#if DSP_SPILL
+  params_edit()->spill = 1u;
+#endif
+  AppDsp_CommitParams();
+}
+
+uint32_t AppDsp_Now(void)
+{
+  return s_frame_clock;
+}
+
+uint8_t AppDsp_CommitParamsAt(uint32_t frame)
+{
+#if APP_DSP_PARAM_EVENTS
+  if (s_params_edit != NULL)
+  {
+    params_prepare();
+    if (!params_enqueue(frame))
+    {
+      return 0u;
+    }
+  }
+  s_params_batch = 0u;
+#else
+  (void)frame;
+  AppDsp_CommitParams();
+#endif
+  return 1u;
+}
+
+uint8_t AppDsp_SetParamAt(AppDspParamId id, int32_t value, uint32_t frame)
+{
+  AppDsp_BeginParams();
+  AppDsp_SetParam(id, value);
+  return AppDsp_CommitParamsAt(frame);
+}
+
+void AppDsp_Poll(void)
+{
+  params_publish();
+}
+
+/* Static half of AppDspParamDesc, one entry per APP_DSP_PARAM_LIST line. */
+typedef struct
+{
+  const char *name;
+  const char *unit;
+  int32_t min;
+  int32_t max;
+  uint8_t smoothed;
+  uint8_t clamp;
+} DspParamInfo;
+
+static const DspParamInfo k_dsp_params[APP_DSP_PARAM_COUNT] = {
+#define DSP_PARAM_INFO(id, name, min, max, unit, smoothed, clamp) \
+  [APP_DSP_PARAM_##id] = {name, unit, (min), (max), (smoothed), (clamp)},
+  APP_DSP_PARAM_LIST(DSP_PARAM_INFO)
+#undef DSP_PARAM_INFO
+};
+
+/* FNV-1a of each name, filled on the first lookup. */
+static uint32_t s_param_hash[APP_DSP_PARAM_COUNT];
+static uint8_t s_param_hash_ready;
+
+static uint32_t param_name_hash(const char *s)
+{
+  uint32_t h = 2166136261u;
+  while (*s != 0)
+  {
+    h = (h ^ (uint8_t)*s++) * 16777619u;
+  }
+  return h;
+}
+
+static int32_t param_max(AppDspParamId id)
+{
+  return (id == APP_DSP_PARAM_DELAY_TIME_MS) ? (int32_t)AppDsp_GetDelayMaxMs() : k_dsp_params[id].max;
+}
+
+/* EQ parameter -> band (AppEqBandId) and field. */
+static uint32_t eq_param_band(AppDspParamId id)
+{
+  switch (id)
+  {
+    case APP_DSP_PARAM_EQ_LOW_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_LOW_FREQ_HZ:
+      return APP_EQ_LOW_SHELF;
+    case APP_DSP_PARAM_EQ_MID1_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_MID1_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_MID1_Q100:
+      return APP_EQ_MID1;
+    case APP_DSP_PARAM_EQ_MID2_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_MID2_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_MID2_Q100:
+      return APP_EQ_MID2;
+    default:
+      return APP_EQ_HIGH_SHELF;
+  }
+}
+
+static bool eq_param_is_gain(AppDspParamId id)
+{
+  return (id == APP_DSP_PARAM_EQ_LOW_GAIN_DB10) || (id == APP_DSP_PARAM_EQ_MID1_GAIN_DB10) ||
+         (id == APP_DSP_PARAM_EQ_MID2_GAIN_DB10) || (id == APP_DSP_PARAM_EQ_HIGH_GAIN_DB10);
+}
+
+static bool eq_param_is_q(AppDspParamId id)
+{
+  return (id == APP_DSP_PARAM_EQ_MID1_Q100) || (id == APP_DSP_PARAM_EQ_MID2_Q100);
+}
+
+static int32_t param_get(const DspParams *c, AppDspParamId id)
+{
+  switch (id)
+  {
+    case APP_DSP_PARAM_DIST_DRIVE_Q8:
+      return c->dist_drive_q8;
+    case APP_DSP_PARAM_DELAY_MIX_Q15:
+      return c->delay_mix_q15;
+    case APP_DSP_PARAM_DELAY_FEEDBACK_Q15:
+      return c->delay_feedback_q15;
+    case APP_DSP_PARAM_DELAY_DUCK_Q15:
+      return c->delay_duck_q15;
+    case APP_DSP_PARAM_REVERB_MIX_Q15:
+      return c->reverb_mix_q15;
+    case APP_DSP_PARAM_REVERB_FEEDBACK_Q15:
+      return c->reverb_feedback_q15;
+    case APP_DSP_PARAM_REVERB_DAMP_Q15:
+      return c->reverb_damp_q15;
+    case APP_DSP_PARAM_GAIN_Q15:
+      return c->gain_q15;
+    case APP_DSP_PARAM_DELAY_TIME_MS:
+      return (int32_t)((c->delay_steps * DELAY_DECIM * 1000U) / DSP_SAMPLE_RATE_HZ);
+    case APP_DSP_PARAM_DELAY_PATTERN:
+      return (int32_t)c->delay_pattern_id;
+    case APP_DSP_PARAM_DIST_OVERSAMPLE:
+      return (int32_t)c->dist_os;
+    case APP_DSP_PARAM_DIST_CURVE:
+      return (int32_t)c->dist_curve;
+    case APP_DSP_PARAM_REVERB_FREEZE:
+      return (int32_t)c->reverb_freeze;
+    case APP_DSP_PARAM_DIST_MODEL:
+      return (int32_t)c->dist_model;
+    case APP_DSP_PARAM_COLOR_CURVE:
+      return (int32_t)c->color_curve;
+    case APP_DSP_PARAM_EQ_LOW_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_MID1_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_MID2_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_HIGH_GAIN_DB10:
+      return c->eq[eq_param_band(id)].gain_db10;
+    case APP_DSP_PARAM_EQ_LOW_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_MID1_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_MID2_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_HIGH_FREQ_HZ:
+      return c->eq[eq_param_band(id)].freq_hz;
+    case APP_DSP_PARAM_EQ_MID1_Q100:
+    case APP_DSP_PARAM_EQ_MID2_Q100:
+      return c->eq[eq_param_band(id)].q100;
+    case APP_DSP_PARAM_GATE_THRESH_DB10:
+      return c->gate_thresh_db10;
+    case APP_DSP_PARAM_GATE_RELEASE_MS:
+      return (int32_t)c->gate_release_ms;
+    case APP_DSP_PARAM_COMP_THRESH_DB10:
+      return c->comp_thresh_db10;
+    case APP_DSP_PARAM_COMP_RATIO_X10:
+      return c->comp_ratio_x10;
+    case APP_DSP_PARAM_COMP_KNEE_DB10:
+      return c->comp_knee_db10;
+    case APP_DSP_PARAM_COMP_MAKEUP_DB10:
+      return c->comp_makeup_db10;
+    case APP_DSP_PARAM_CHORUS_MIX_Q15:
+      return c->chorus_mix_q15;
+    case APP_DSP_PARAM_CHORUS_RATE_MHZ:
+      return (int32_t)c->chorus_rate_mhz;
+    case APP_DSP_PARAM_CHORUS_DEPTH_Q15:
+      return c->chorus_depth_q15;
+    case APP_DSP_PARAM_CHORUS_TIME_US:
+      return (int32_t)c->chorus_time_us;
+    case APP_DSP_PARAM_CHORUS_FEEDBACK_Q15:
+      return c->chorus_feedback_q15;
+    case APP_DSP_PARAM_CHORUS_SPREAD_DEG:
+      return (int32_t)c->chorus_spread_deg;
+    case APP_DSP_PARAM_PHASER_MIX_Q15:
+      return c->phaser_mix_q15;
+    case APP_DSP_PARAM_PHASER_RATE_MHZ:
+      return (int32_t)c->phaser_rate_mhz;
+    case APP_DSP_PARAM_PHASER_DEPTH_Q15:
+      return c->phaser_depth_q15;
+    case APP_DSP_PARAM_PHASER_FREQ_HZ:
+      return (int32_t)c->phaser_freq_hz;
+    case APP_DSP_PARAM_PHASER_STAGES:
+      return (int32_t)c->phaser_stages;
+    case APP_DSP_PARAM_PHASER_SPREAD_DEG:
+      return (int32_t)c->phaser_spread_deg;
+    case APP_DSP_PARAM_TREMOLO_DEPTH_Q15:
+      return c->tremolo_depth_q15;
+    case APP_DSP_PARAM_TREMOLO_PAN_Q15:
+      return c->tremolo_pan_q15;
+    case APP_DSP_PARAM_TREMOLO_DIV:
+      return (int32_t)c->tremolo_div;
+    case APP_DSP_PARAM_TEMPO_BPM:
+      return (int32_t)c->tempo_bpm;
+    case APP_DSP_PARAM_WAH_MIX_Q15:
+      return c->wah_mix_q15;
+    case APP_DSP_PARAM_WAH_FREQ_HZ:
+      return (int32_t)c->wah_freq_hz;
+    case APP_DSP_PARAM_WAH_DEPTH_Q15:
+      return c->wah_depth_q15;
+    case APP_DSP_PARAM_WAH_SENS_DB10:
+      return c->wah_sens_db10;
+    case APP_DSP_PARAM_WAH_Q100:
+      return c->wah_q100;
+    case APP_DSP_PARAM_PITCH_MIX_Q15:
+      return c->pitch_mix_q15;
+    case APP_DSP_PARAM_PITCH_CENTS:
+      return c->pitch_cents;
+    case APP_DSP_PARAM_PITCH_WINDOW_MS:
+      return (int32_t)c->pitch_window_ms;
+    case APP_DSP_PARAM_TONE_MODEL:
+      return (int32_t)c->tone_model;
+    case APP_DSP_PARAM_TONE_BASS_Q15:
+      return c->tone_bass_q15;
+    case APP_DSP_PARAM_TONE_MID_Q15:
+      return c->tone_mid_q15;
+    case APP_DSP_PARAM_TONE_TREBLE_Q15:
+      return c->tone_treble_q15;
+    case APP_DSP_PARAM_REVERB_ROOM:
+      return (int32_t)c->reverb_room;
+    case APP_DSP_PARAM_REVERB_ER_Q15:
+      return c->reverb_er_q15;
+    case APP_DSP_PARAM_REVERB_DECAY_MS:
+      return (int32_t)c->reverb_decay_ms;
+    case APP_DSP_PARAM_REVERB_HF_DAMP_HZ:
+      return (int32_t)c->reverb_hf_damp_hz;
+    case APP_DSP_PARAM_REVERB_TYPE:
+      return (int32_t)c->reverb_type;
+    case APP_DSP_PARAM_REVERB_DIFFUSION:
+      return (int32_t)c->reverb_diffusion;
+    case APP_DSP_PARAM_WET_WIDTH_Q15:
+      return c->wet_width_q15;
+    case APP_DSP_PARAM_CAB_IR:
+      return (int32_t)c->cab_ir;
+    case APP_DSP_PARAM_DELAY_SYNC:
+      return (int32_t)c->delay_sync;
+    case APP_DSP_PARAM_CHORUS_SYNC:
+      return (int32_t)c->chorus_sync;
+    case APP_DSP_PARAM_PHASER_SYNC:
+      return (int32_t)c->phaser_sync;
+    default:
+      return 0;
+  }
+}
+
+static uint32_t sync_rate_mhz(const DspParams *c, uint32_t div, AppDspParamId id)
+{
+  const int32_t mhz = (int32_t)((200U * c->tempo_bpm) / k_sync_twelfths[div]);
+  return (uint32_t)((mhz > k_dsp_params[id].max) ? k_dsp_params[id].max : mhz);
+}
+
+/* Tempo-synced times and rates, whenever the tempo or a sync changes. */
+static void tempo_sync(DspParams *c)
+{
+  if (c->delay_sync != APP_DSP_SYNC_OFF)
+  {
+    uint32_t steps = (DSP_SAMPLE_RATE_HZ * 5U * k_sync_twelfths[c->delay_sync]) / (c->tempo_bpm * DELAY_DECIM);
+    while (steps > DELAY_LEN)
+    {
+      steps >>= 1;
+    }
+    c->delay_steps = (steps < 1U) ? 1U : steps;
+  }
+  if (c->chorus_sync != APP_DSP_SYNC_OFF)
+  {
+    c->chorus_rate_mhz = sync_rate_mhz(c, c->chorus_sync, APP_DSP_PARAM_CHORUS_RATE_MHZ);
+  }
+  if (c->phaser_sync != APP_DSP_SYNC_OFF)
+  {
+    c->phaser_rate_mhz = sync_rate_mhz(c, c->phaser_sync, APP_DSP_PARAM_PHASER_RATE_MHZ);
+  }
+}
+
+/* Per-line FDN coefficients from the RT60 controls, in the main loop.
+ * A pass through line k of L samples must lose 60 dB * L / (fs * T60), so
+ * every line decays at the same rate whatever its length. The damping
+ * lowpass of each line then loses that much again at reverb_hf_damp_hz,
+ * which halves the decay time there: for a one-pole y += a (x - y) with
+ * gain G at w, b = 1 - a solves (1 - G^2) b^2 - 2 (1 - G^2 cos w) b +
+ * (1 - G^2) = 0. The spring's loop gets the broadband part only.
+ */
+static void reverb_decay_design(DspParams *c)
+{
+  c->reverb_spring_fb_q15 = c->reverb_feedback_q15;
+#if APP_DSP_SPRING_ENABLE
+  if (c->reverb_decay_ms != 0u)
+  {
+    const float g = powf(10.0f, (-3000.0f * (float)SPRING_DELAY) / ((float)SPRING_FS_HZ * (float)c->reverb_decay_ms));
+    c->reverb_spring_fb_q15 = (int32_t)((g * 32768.0f) + 0.5f);
+  }
+#endif
+  for (uint32_t k = 0; k < REVERB_FDN_LINES; k++)
+  {
+    float g = (float)c->reverb_feedback_q15 * (1.0f / 32768.0f);
+    if (c->reverb_decay_ms != 0u)
+    {
+      g = powf(10.0f, (-3000.0f * (float)k_reverb_fdn_len[k]) / ((float)REVERB_FS_HZ * (float)c->reverb_decay_ms));
+      c->reverb_line_fb_q15[k] = (int32_t)((g * 32768.0f) + 0.5f);
+    }
+    else
+    {
+      c->reverb_line_fb_q15[k] = c->reverb_feedback_q15;
+    }
+
+    if (c->reverb_hf_damp_hz == 0u)
+    {
+      c->reverb_line_damp_q15[k] = c->reverb_damp_q15;
+      continue;
+    }
+    const float w = (2.0f * 3.14159265f * (float)c->reverb_hf_damp_hz) / (float)REVERB_FS_HZ;
+    const float g2 = g * g;
+    const float a2 = 1.0f - g2;
+    const float b2 = 1.0f - (g2 * cosf(w));
+    const float b = a2 / (b2 + sqrtf((b2 * b2) - (a2 * a2)));
+    int32_t a_q15 = (int32_t)(((1.0f - b) * 32768.0f) + 0.5f);
+    c->reverb_line_damp_q15[k] = (a_q15 < 1) ? 1 : a_q15;
+  }
+}
+
+void AppDsp_SetParam(AppDspParamId id, int32_t value)
+{
+  if ((uint32_t)id >= (uint32_t)APP_DSP_PARAM_COUNT)
+  {
+    return;
+  }
+
+  /* Range check from the descriptor; the switch below only stores. */
+  const DspParamInfo *d = &k_dsp_params[id];
+  const int32_t max = param_max(id);
+  if ((value < d->min) || (value > max))
+  {
+    if (!d->clamp)
+    {
+      return;
+    }
+    value = (value < d->min) ? d->min : max;
+  }
+
+  DspParams *c = params_edit();
+  switch (id)
+  {
+    case APP_DSP_PARAM_DIST_DRIVE_Q8:
+      c->dist_drive_q8 = value;
+      break;
+    case APP_DSP_PARAM_DELAY_MIX_Q15:
+      c->delay_mix_q15 = value;
+      break;
+    case APP_DSP_PARAM_DELAY_FEEDBACK_Q15:
+      c->delay_feedback_q15 = value;
+      break;
+    case APP_DSP_PARAM_DELAY_DUCK_Q15:
+      c->delay_duck_q15 = value;
+      break;
+    case APP_DSP_PARAM_REVERB_MIX_Q15:
+      c->reverb_mix_q15 = value;
+      break;
+    case APP_DSP_PARAM_REVERB_FEEDBACK_Q15:
+      c->reverb_feedback_q15 = value;
+      reverb_decay_design(c);
+      break;
+    case APP_DSP_PARAM_REVERB_DAMP_Q15:
+      c->reverb_damp_q15 = value;
+      reverb_decay_design(c);
+      break;
+    case APP_DSP_PARAM_GAIN_Q15:
+      /* Up to 2.0x for extra output volume. */
+      c->gain_q15 = value;
+      break;
+    case APP_DSP_PARAM_DELAY_TIME_MS:
+    {
+      uint32_t steps = ((uint32_t)value * DSP_SAMPLE_RATE_HZ) / (1000U * DELAY_DECIM);
+      if (steps < 1U) steps = 1U;
+      if (steps > DELAY_LEN) steps = DELAY_LEN;
+      c->delay_steps = steps;
+      break;
+    }
+    case APP_DSP_PARAM_DIST_OVERSAMPLE:
+      if (value != 3)
+      {
+        c->dist_os = (uint32_t)value;
+      }
+      break;
+    case APP_DSP_PARAM_DIST_CURVE:
+      c->dist_curve = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_DIST_MODEL:
+      c->dist_model = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_REVERB_FREEZE:
+      c->reverb_freeze = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_COLOR_CURVE:
+      c->color_curve = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_DELAY_PATTERN:
+      c->delay_pattern = k_delay_patterns[value];
+      c->delay_pattern_id = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_EQ_LOW_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_MID1_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_MID2_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_HIGH_GAIN_DB10:
+    case APP_DSP_PARAM_EQ_LOW_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_MID1_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_MID2_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_HIGH_FREQ_HZ:
+    case APP_DSP_PARAM_EQ_MID1_Q100:
+    case APP_DSP_PARAM_EQ_MID2_Q100:
+    {
+      AppEqBand *b = &c->eq[eq_param_band(id)];
+      if (eq_param_is_gain(id)) b->gain_db10 = (int16_t)value;
+      else if (eq_param_is_q(id)) b->q100 = (uint16_t)value;
+      else b->freq_hz = (uint16_t)value;
+      s_params_eq_dirty = 1u;
+      break;
+    }
+    case APP_DSP_PARAM_GATE_THRESH_DB10:
+      /* dBFS of the block RMS -> s24 mean square, full scale 2^46. */
+      c->gate_thresh_db10 = value;
+      c->gate_open_ms = (value == 0) ? 0u : (uint64_t)(70368744177664.0f * powf(10.0f, (float)value / 100.0f));
+      break;
+    case APP_DSP_PARAM_GATE_RELEASE_MS:
+      c->gate_release_ms = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_COMP_THRESH_DB10:
+      c->comp_thresh_db10 = value;
+      c->comp.thresh_l2 = APP_TAB_DB10_TO_L2(value);
+      break;
+    case APP_DSP_PARAM_COMP_RATIO_X10:
+      c->comp_ratio_x10 = value;
+      c->comp.slope_q15 = COMP_SLOPE_Q15(value);
+      break;
+    case APP_DSP_PARAM_COMP_KNEE_DB10:
+      c->comp_knee_db10 = value;
+      c->comp.knee_l2 = APP_TAB_DB10_TO_L2(value);
+      c->comp.knee_inv = COMP_KNEE_INV(c->comp.knee_l2);
+      break;
+    case APP_DSP_PARAM_COMP_MAKEUP_DB10:
+      c->comp_makeup_db10 = value;
+      c->comp.makeup_q12 = (int32_t)(4096.0f * powf(10.0f, (float)value / 200.0f) + 0.5f);
+      break;
+    case APP_DSP_PARAM_CHORUS_MIX_Q15:
+      c->chorus_mix_q15 = value;
+      break;
+    case APP_DSP_PARAM_CHORUS_RATE_MHZ:
+      c->chorus_rate_mhz = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_CHORUS_DEPTH_Q15:
+      c->chorus_depth_q15 = value;
+      break;
+    case APP_DSP_PARAM_CHORUS_TIME_US:
+      c->chorus_time_us = (uint32_t)value;
+      c->chorus_time_q16 = CHORUS_US_TO_Q16(value);
+      break;
+    case APP_DSP_PARAM_CHORUS_FEEDBACK_Q15:
+      c->chorus_feedback_q15 = value;
+      break;
+    case APP_DSP_PARAM_CHORUS_SPREAD_DEG:
+      c->chorus_spread_deg = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_PHASER_MIX_Q15:
+      c->phaser_mix_q15 = value;
+      break;
+    case APP_DSP_PARAM_PHASER_RATE_MHZ:
+      c->phaser_rate_mhz = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_PHASER_DEPTH_Q15:
+      c->phaser_depth_q15 = value;
+      break;
+    case APP_DSP_PARAM_PHASER_FREQ_HZ:
+      c->phaser_freq_hz = (uint32_t)value;
+      c->phaser_w0_q20 = PHASER_HZ_TO_W_Q20(value);
+      break;
+    case APP_DSP_PARAM_PHASER_STAGES:
+      if ((value & 1) == 0)
+      {
+        c->phaser_stages = (uint32_t)value;
+      }
+      break;
+    case APP_DSP_PARAM_PHASER_SPREAD_DEG:
+      c->phaser_spread_deg = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_TREMOLO_DEPTH_Q15:
+      c->tremolo_depth_q15 = value;
+      break;
+    case APP_DSP_PARAM_TREMOLO_PAN_Q15:
+      c->tremolo_pan_q15 = value;
+      break;
+    case APP_DSP_PARAM_TREMOLO_DIV:
+      c->tremolo_div = (uint32_t)value;
+      c->tremolo_rate_mhz = TREMOLO_RATE_MHZ(c->tempo_bpm, c->tremolo_div);
+      break;
+    case APP_DSP_PARAM_TEMPO_BPM:
+      c->tempo_bpm = (uint32_t)value;
+      c->tremolo_rate_mhz = TREMOLO_RATE_MHZ(c->tempo_bpm, c->tremolo_div);
+      tempo_sync(c);
+      break;
+    case APP_DSP_PARAM_WAH_MIX_Q15:
+      c->wah_mix_q15 = value;
+      break;
+    case APP_DSP_PARAM_WAH_FREQ_HZ:
+      c->wah_freq_hz = (uint32_t)value;
+      c->wah_w0 = WAH_HZ_TO_PHASE(value);
+      break;
+    case APP_DSP_PARAM_WAH_DEPTH_Q15:
+      c->wah_depth_q15 = value;
+      break;
+    case APP_DSP_PARAM_WAH_SENS_DB10:
+      c->wah_sens_db10 = value;
+      break;
+    case APP_DSP_PARAM_WAH_Q100:
+      c->wah_q100 = value;
+      c->wah_damp_q15 = WAH_Q100_TO_DAMP_Q15(value);
+      break;
+    case APP_DSP_PARAM_PITCH_MIX_Q15:
+      c->pitch_mix_q15 = value;
+      break;
+    case APP_DSP_PARAM_PITCH_CENTS:
+      c->pitch_cents = value;
+      break;
+    case APP_DSP_PARAM_PITCH_WINDOW_MS:
+      c->pitch_window_ms = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_TONE_MODEL:
+      c->tone_model = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_TONE_BASS_Q15:
+      c->tone_bass_q15 = value;
+      break;
+    case APP_DSP_PARAM_TONE_MID_Q15:
+      c->tone_mid_q15 = value;
+      break;
+    case APP_DSP_PARAM_TONE_TREBLE_Q15:
+      c->tone_treble_q15 = value;
+      break;
+    case APP_DSP_PARAM_REVERB_ROOM:
+      c->reverb_room = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_REVERB_ER_Q15:
+      c->reverb_er_q15 = value;
+      break;
+    case APP_DSP_PARAM_REVERB_DECAY_MS:
+      c->reverb_decay_ms = (uint32_t)value;
+      reverb_decay_design(c);
+      break;
+    case APP_DSP_PARAM_REVERB_HF_DAMP_HZ:
+      c->reverb_hf_damp_hz = (uint32_t)value;
+      reverb_decay_design(c);
+      break;
+    case APP_DSP_PARAM_REVERB_DIFFUSION:
+      c->reverb_diffusion = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_WET_WIDTH_Q15:
+      c->wet_width_q15 = value;
+      break;
+    case APP_DSP_PARAM_CAB_IR:
+      c->cab_ir = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_REVERB_TYPE:
+      c->reverb_type = (uint32_t)value;
+      break;
+    case APP_DSP_PARAM_DELAY_SYNC:
+      c->delay_sync = (uint32_t)value;
+      tempo_sync(c);
+      break;
+    case APP_DSP_PARAM_CHORUS_SYNC:
+      c->chorus_sync = (uint32_t)value;
+      tempo_sync(c);
+      break;
+    case APP_DSP_PARAM_PHASER_SYNC:
+      c->phaser_sync = (uint32_t)value;
+      tempo_sync(c);
+      break;
+    default:
+      break;
+  }
+  params_publish();
+}
+
+int32_t AppDsp_GetParam(AppDspParamId id)
+{
+  return param_get(params_view(), id);
+}
+
+uint32_t AppDsp_ParamsVersion(void)
+{
+  uint32_t copies;
+  uint32_t banks;
+  return params_in_use(&copies, &banks)->version;
+}
+
+uint32_t AppDsp_SnapshotParams(void)
+{
+  s_params_snap = s_params_front;
+  return s_params_snap->version;
+}
+
+int32_t AppDsp_SnapshotParam(AppDspParamId id)
+{
+  return param_get(s_params_snap, id);
+}
+
+AppFxMask AppDsp_SnapshotFxMask(void)
+{
+  return s_params_snap->fx_mask;
+}
+
+void AppDsp_WatchParams(uint32_t version)
+{
+  s_params_watch = version;
+}
+
+uint8_t AppDsp_WatchedBlock(uint32_t *cycles)
+{
+  if (s_params_watch != 0u)
+  {
+    return 0u;
+  }
+  DSP_COMPILER_BARRIER();
+  *cycles = s_params_watch_cyc;
+  return 1u;
+}
+
+uint8_t AppDsp_GetParamDesc(AppDspParamId id, AppDspParamDesc *out)
+{
+  if (((uint32_t)id >= (uint32_t)APP_DSP_PARAM_COUNT) || (out == NULL))
+  {
+    return 0;
+  }
+  const DspParamInfo *d = &k_dsp_params[id];
+  out->name = d->name;
+  out->unit = d->unit;
+  out->min = d->min;
+  out->max = param_max(id);
+  out->def = param_get(&k_params_boot, id);
+  out->smooth_ms = d->smoothed ? (uint16_t)((DSP_PARAM_SMOOTH_FRAMES * 1000U) / DSP_SAMPLE_RATE_HZ) : 0u;
+  out->clamp = d->clamp;
+  return 1;
+}
+
+uint8_t AppDsp_FindParam(const char *name, AppDspParamId *out)
+{
+  if ((name == NULL) || (out == NULL))
+  {
+    return 0;
+  }
+  if (!s_param_hash_ready)
+  {
+    for (uint32_t i = 0; i < (uint32_t)APP_DSP_PARAM_COUNT; i++)
+    {
+      s_param_hash[i] = param_name_hash(k_dsp_params[i].name);
+    }
+    s_param_hash_ready = 1u;
+  }
+
+  const uint32_t h = param_name_hash(name);
+  for (uint32_t i = 0; i < (uint32_t)APP_DSP_PARAM_COUNT; i++)
+  {
+    if ((s_param_hash[i] == h) && (strcmp(k_dsp_params[i].name, name) == 0))
+    {
+      *out = (AppDspParamId)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void AppDsp_ProcessFrame(int32_t *l_s24, int32_t *r_s24)
+{
+  AppStereoS24 f = {*l_s24, *r_s24};
+  AppDsp_ProcessBlock(&f, 1u);
+  *l_s24 = f.l;
+  *r_s24 = f.r;
+}
+
+static inline void meter_gains(const AppDspContext *ctx, uint32_t n)
+{
+  const CompState *l = &ctx->ch[0].comp;
+#if APP_DSP_MONO_INPUT
+  APP_METER_GAINS(l->gain_q15, ctx->limiter.gain_q15, n);
+#else
+  const CompState *r = &ctx->ch[1].comp;
+  APP_METER_GAINS((l->gain_q15 < r->gain_q15) ? l->gain_q15 : r->gain_q15, ctx->limiter.gain_q15, n);
+  (void)r;
+#endif
+  (void)l;
+  (void)n;
+}
+
+/* The detector's RMS in Q16 octaves re full scale, referred back to the
+ * ADC level like the gate threshold; ms >> 23 keeps ~7 bits at -45 dBFS.
+ */
+static int32_t level_l2(const DspLevel *lv, uint32_t n)
+{
+  const uint64_t ms = lv->sum_sq / (n * GATE_CHANNELS);
+  const uint64_t m = ms >> 23;
+  if (m == 0u)
+  {
+    return DSP_LEVEL_FLOOR_L2;
+  }
+  int32_t l2 = AppTab_Log2((m > 0x7FFFFFFFu) ? 0x7FFFFFFF : (int32_t)m) >> 1;
+#if DSP_FUSED_COND
+  l2 -= AppTab_Log2(AUDIO_INPUT_GAIN_Q8 << 15);
+#endif
+  return (l2 > DSP_LEVEL_FLOOR_L2) ? l2 : DSP_LEVEL_FLOOR_L2;
+}
+
+/* The input tap from the level detector, referred back to the ADC level
+ * where the fused section applied the input gain (its square for the
+ * energy).
+ */
+static inline void meter_input(const DspLevel *lv, uint32_t n)
+{
+  const uint32_t samples = APP_DSP_MONO_INPUT ? n : (2u * n);
+#if DSP_FUSED_COND
+  APP_METER_LEVEL(APP_METER_TAP_INPUT, (uint32_t)(((uint64_t)lv->peak * 256u) / AUDIO_INPUT_GAIN_Q8),
+                  lv->sum_sq / (((uint64_t)AUDIO_INPUT_GAIN_Q8 * AUDIO_INPUT_GAIN_Q8) >> 16), samples);
+#else
+  APP_METER_LEVEL(APP_METER_TAP_INPUT, lv->peak, lv->sum_sq, samples);
+#endif
+  (void)lv;
+  (void)samples;
+}
+
+/* The chain past a shut gate: silence, still fed to the later taps. */
+APP_CCM_CODE static void idle_block(AppDspContext *ctx, AppStereoS24 *x, uint32_t n)
+{
+  memset(x, 0, n * sizeof(*x));
+#if AUDIO_LIMITER_LOOKAHEAD
+  /* Play out what the lookahead line still holds. */
+  if (ctx->limiter.drain != 0u)
+  {
+    const uint32_t drain = ctx->limiter.drain;
+    limiter_block(&ctx->limiter, x, n);
+    ctx->limiter.drain = (drain > n) ? (drain - n) : 0u;
+  }
+#endif
+  if (!ctx->primary)
+  {
+    return;
+  }
+  APP_METER_BLOCK(APP_METER_TAP_DIST, x, n, APP_DSP_MONO_INPUT);
+  APP_CAPTURE_TAP(APP_METER_TAP_DIST, x, n, APP_DSP_MONO_INPUT);
+  APP_METER_BLOCK(APP_METER_TAP_DELAY, x, n, 0u);
+  APP_CAPTURE_TAP(APP_METER_TAP_DELAY, x, n, 0u);
+  APP_METER_BLOCK(APP_METER_TAP_REVERB, x, n, 0u);
+  APP_CAPTURE_TAP(APP_METER_TAP_REVERB, x, n, 0u);
+  APP_METER_BLOCK(APP_METER_TAP_OUTPUT, x, n, 0u);
+  APP_CAPTURE_TAP(APP_METER_TAP_OUTPUT, x, n, 0u);
+  APP_SPECTRUM_BLOCK(x, n);
+  meter_gains(ctx, n);
+}
+
+/* Bound after the coloration shaper, whose table is s24; the FX modules
+ * carry it on (the distortion mixes two in-range signals, the EQ
+ * saturates). Without the shaper the tail clamps its input as before.
+ */
+#if INPUT_COLOR_ENABLE
+#define DSP_DRY_MAG                    DSP_MAG_S24
+#else
+#define DSP_DRY_MAG                    INT32_MAX
+#endif
+
+#if DSP_ISLAND
+/* The schedule has the island for the mask, the modules ahead of it are
+ * idle this block, and the distortion is not crossfading: a crossfade
+ * mixes in its input, which wants the coloration at the base rate.
+ */
+static inline bool island_open(const AppDspContext *ctx, const DspBlockParams *p, AppFxMask mask)
+{
+  const uint32_t slot = chain_slot(mask);
+  if ((((p->sched->island >> slot) & 1u) == 0u) || (ctx->fx.distortion.fade.send.cur != 32768) ||
+      (ctx->fx.distortion.fade.send.target != 32768))
+  {
+    return false;
+  }
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    if ((((p->sched->lead[slot] >> i) & 1u) != 0u) && !k_fx_modules[i]->idle(p))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
+/* The whole chain for one run mask. The FX section is the mask's compiled
+ * schedule (chain_compile()), a flat list of calls. The default FX order,
+ * Distortion -> EQ -> Delay -> Reverb, keeps cab-sim right after
+ * distortion, the EQ on the dry tone and space FX last; the looper follows
+ * the FX. The gate sits ahead of the input gain, on the DC-blocked input.
+ */
+APP_CCM_CODE static void chain_run(AppDspContext *ctx, AppStereoS24 *x, uint32_t n, const DspBlockParams *p,
+                                   AppFxMask mask)
+{
+  APP_PROF_DECLARE(prof_t0);
+  APP_PROF_DECLARE(prof_t);
+
+  if (ctx->primary)
+  {
+    APP_CAPTURE_INPUT(x, n);
+
+    /* Taps ahead of mono_to_stereo_block() only carry the left channel. */
+    APP_CAPTURE_TAP(APP_METER_TAP_INPUT, x, n, APP_DSP_MONO_INPUT);
+    APP_TUNER_BLOCK(x, n);
+  }
+  DSP_CLIP_BEGIN();
+
+  /* The detector runs for the gate, the input meter and the delay duck
+   * only.
+   */
+  const uint8_t meter = ctx->primary && APP_METER_ON();
+  const uint8_t duck = ((mask & APP_FX_BIT_DELAY) != 0u) && (p->delay_duck_q15 != 0);
+  DspLevel lv;
+  dc_block_block(ctx->ch, x, n, (meter || duck || (p->gate_open_ms != 0u)) ? &lv : NULL);
+  APP_PROF_STAGE(prof_t, APP_PROF_STAGE_DC_BLOCK, n);
+  DSP_CLIP_STAGE(APP_PROF_STAGE_DC_BLOCK);
+  if (meter)
+  {
+    meter_input(&lv, n);
+  }
+  ctx->in_l2 = duck ? level_l2(&lv, n) : DSP_LEVEL_FLOOR_L2;
+
+  gate_block(&ctx->gate, x, n, p, &lv);
+  APP_PROF_STAGE(prof_t, APP_PROF_STAGE_GATE, n);
+  DSP_CLIP_STAGE(APP_PROF_STAGE_GATE);
+
+  if (gate_idle(ctx))
+  {
+    idle_block(ctx, x, n);
+    APP_PROF_CHAIN(prof_t0, mask, n);
+    return;
+  }
+
+  comp_block(ctx->ch, x, n, p);
+  APP_PROF_STAGE(prof_t, APP_PROF_STAGE_COMP, n);
+  DSP_CLIP_STAGE(APP_PROF_STAGE_COMP);
+
+#if DSP_ISLAND
+  /* On the island the distortion step colors the block instead. */
+  ctx->island = island_open(ctx, p, mask) ? 1u : 0u;
+  if (!ctx->island)
+#endif
+  {
+    color_block(x, n, p->color_curve);
+  }
+  APP_PROF_STAGE(prof_t, APP_PROF_STAGE_COLOR, n);
+  DSP_CLIP_STAGE(APP_PROF_STAGE_COLOR);
+
+  /* Bound on mag_s24() of the block from here on (headroom tracking). */
+  int32_t peak = DSP_DRY_MAG;
+
+  const uint8_t *step = p->sched->step[chain_slot(mask)];
+  const uint32_t steps = p->sched->count[chain_slot(mask)];
+  for (uint32_t i = 0; i < steps; i++)
+  {
+    const DspStep *st = &ctx->steps[step[i]];
+    peak = st->fn(st->state, x, n, p, peak);
+#if APP_PROF_ENABLE || APP_DSP_CLIP
+    if (st->fx != NULL)
+    {
+      APP_PROF_STAGE(prof_t, st->fx->prof_stage(p), n);
+      DSP_CLIP_STAGE(st->fx->prof_stage(p));
+    }
+#endif
+  }
+
+  if (ctx->primary)
+  {
+    peak = loop_block(x, n, peak);
+    APP_PROF_STAGE(prof_t, APP_PROF_STAGE_LOOP, n);
+    DSP_CLIP_STAGE(APP_PROF_STAGE_LOOP);
+  }
+
+  output_block(&ctx->makeup_q15, &ctx->tremolo, x, n, p, peak);
+  APP_PROF_STAGE(prof_t, APP_PROF_STAGE_OUTPUT, n);
+  DSP_CLIP_STAGE(APP_PROF_STAGE_OUTPUT);
+
+  limiter_block(&ctx->limiter, x, n);
+  APP_PROF_STAGE(prof_t, APP_PROF_STAGE_LIMITER, n);
+  DSP_CLIP_STAGE(APP_PROF_STAGE_LIMITER);
+
+  if (ctx->primary)
+  {
+    APP_METER_BLOCK(APP_METER_TAP_OUTPUT, x, n, 0u);
+    APP_CAPTURE_TAP(APP_METER_TAP_OUTPUT, x, n, 0u);
+    APP_SPECTRUM_BLOCK(x, n);
+    meter_gains(ctx, n);
+  }
+
+  APP_PROF_CHAIN(prof_t0, mask, n);
+}
+
+#if DSP_SPILL
+/* Preset spillover. Each block snapshots into the other of two copies, so
+ * the last block's parameters are at hand when a spill commit lands: they
+ * become the outgoing set, and the delay and reverb, if awake, ring out on
+ * it with their send shut. The copies stop alternating until spill_end()
+ * has let the last of them go. The delay line and the tank are single, so
+ * the new preset's input reaches an FX only once its old tail is gone.
+ */
+APP_CCM_CODE static DspBlockParams *spill_begin(AppDspContext *ctx, const DspParams *c)
+{
+  const uint8_t landed = (c != ctx->seen) && c->spill && ctx->primary;
+  ctx->seen = c;
+  if (ctx->spill != NULL)
+  {
+    return &ctx->bp[ctx->bp_cur];
+  }
+  ctx->bp_cur ^= 1u;
+  if (landed)
+  {
+    uint8_t any = 0u;
+    for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+    {
+      if ((k_fx_modules[i]->bit & DSP_SPILL_FX) != 0u)
+      {
+        FxFade *f = fx_fade(&ctx->fx, i);
+        f->spill = f->awake;
+        any |= f->awake;
+      }
+    }
+    if (any)
+    {
+      ctx->spill = &ctx->bp[ctx->bp_cur ^ 1u];
+      ctx->spill->spill = NULL;
+      ctx->spill_frames = 0U;
+    }
+  }
+  return &ctx->bp[ctx->bp_cur];
+}
+
+/* An FX stops spilling once its tail has gone to sleep or, when the new
+ * preset selects it too, after DSP_SPILL_FRAMES; it then glides to the new
+ * parameters and its send opens.
+ */
+APP_CCM_CODE static void spill_end(AppDspContext *ctx, const DspBlockParams *p, uint32_t n)
+{
+  ctx->spill_frames += n;
+  uint8_t left = 0u;
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    const AppFxModule *fx = k_fx_modules[i];
+    if ((fx->bit & DSP_SPILL_FX) == 0u)
+    {
+      continue;
+    }
+    FxFade *f = fx_fade(&ctx->fx, i);
+    if (f->spill &&
+        (!f->awake || (((p->mask & fx->bit) != 0u) && (ctx->spill_frames >= DSP_SPILL_FRAMES))))
+    {
+      f->spill = 0u;
+    }
+    left |= f->spill;
+  }
+  if (!left)
+  {
+    ctx->spill = NULL;
+  }
+}
+#endif
+
+/* Block-rate half of the FX switching: point the ramps at this block's
+ * targets and return the mask of FX that must run, the selected ones plus
+ * any that are still fading out or ringing.
+ */
+APP_CCM_CODE static AppFxMask fade_begin(AppDspContext *ctx, const DspBlockParams *p)
+{
+  AppFxMask m = p->mask;
+  AppFxMask run = m;
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    const AppFxModule *fx = k_fx_modules[i];
+    if (fx->bit == 0u)
+    {
+      continue;
+    }
+    FxFade *f = fx_fade(&ctx->fx, i);
+    ramp_set(&f->send, (((m & fx->bit) != 0u) && !f->spill) ? 32768 : 0);
+    if ((fx->tail_frames != NULL) ? (f->awake != 0u) : (f->send.cur != 0))
+    {
+      run |= fx->bit;
+    }
+  }
+  ramp_set(&ctx->makeup_q15, p->makeup_q8 * 128);
+  return run;
+}
+
+/* Put tail FX to sleep once they have been silent for their tail_frames()
+ * and their send has settled, then give each its slice of line clearing.
+ */
+APP_CCM_CODE static void fade_end(AppDspContext *ctx, const DspBlockParams *p, uint32_t n)
+{
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
+  {
+    const AppFxModule *fx = k_fx_modules[i];
+    if (fx->tail_frames == NULL)
+    {
+      continue;
+    }
+    FxFade *f = fx_fade(&ctx->fx, i);
+    if ((f->quiet >= fx->tail_frames(fx_params(f, p))) && (f->send.cur == f->send.target))
+    {
+      f->awake = 0u;
+    }
+    if (fx->clear_step != NULL)
+    {
+      fx->clear_step(fx_state(&ctx->fx, i), n);
+    }
+  }
+#if DSP_SPILL
+  if (ctx->spill != NULL)
+  {
+    spill_end(ctx, p, n);
+  }
+#endif
+}
+
+#if CABSIM_IR
+/* The reverb tank and the cab IR line share the arena overlay. The reverb
+ * has it while selected, fading or ringing, the IR cab otherwise (the
+ * biquad cab stands in meanwhile). Whoever takes it starts from a cleared
+ * history, once per switch. The tank, ~16 KB, is cleared a slice per
+ * block (reverb_clear_step()) and stays asleep, dry only, until it is
+ * done; only its state and the diffusers are reset here.
+ */
+APP_CCM_CODE static void arena_handoff(AppDspContext *ctx, const DspBlockParams *p)
+{
+  const FxFade *f = fx_fade(&ctx->fx, DSP_FX_reverb);
+  const uint8_t reverb = (((p->mask & APP_FX_BIT_REVERB) != 0u) || (f->awake != 0u) || (f->send.cur != 0)) ? 1u : 0u;
+  if (reverb == s_arena_reverb)
+  {
+    return;
+  }
+  s_arena_reverb = reverb;
+  if (reverb)
+  {
+    ReverbFxState *rs = (ReverbFxState *)fx_state(&ctx->fx, DSP_FX_reverb);
+    AppCabIr_Attach(NULL);
+    reverb_reset_state(rs, 0U);
+    AppDline_ClearBegin(&rs->clear, s_reverb_fdn, REVERB_FDN_BYTES / 4U, 0U, APP_DSP_REVERB_STORAGE);
+  }
+  else
+  {
+    /* An unfinished clear would run on into the IR line. */
+    ((ReverbFxState *)fx_state(&ctx->fx, DSP_FX_reverb))->clear.left = 0U;
+    AppCabIr_Attach(s_cabir_fdl);
+  }
+}
+#endif
+
+/* block_params_snapshot() for a context: its ramps, its bus, and in a
+ * secondary one only the FX it may run.
+ */
+APP_CCM_CODE static void ctx_snapshot(AppDspContext *ctx, DspBlockParams *p, const DspParams *c, AppFxMask mask,
+                                      uint32_t n)
+{
+  if (!ctx->primary)
+  {
+    mask &= DSP_CTX_SECONDARY_FX;
+  }
+  block_params_snapshot(&ctx->smooth, p, c, mask, n);
+  p->primary = ctx->primary;
+  if (!ctx->primary)
+  {
+    p->pitch_mix_q15 = 0;
+  }
+#if APP_DSP_MONO_INPUT
+  p->mod_env = ctx->ch[0].comp.env;
+#else
+  p->mod_env = (ctx->ch[0].comp.env > ctx->ch[1].comp.env) ? ctx->ch[0].comp.env : ctx->ch[1].comp.env;
+#endif
+  p->in_l2 = ctx->in_l2;
+#if APP_DSP_BUS_FRAMES
+  p->wet_bus = &ctx->bus.mix;
+#endif
+#if DSP_SPILL
+  /* The outgoing set follows the input level, for the delay duck. */
+  p->spill = ctx->spill;
+  if (ctx->spill != NULL)
+  {
+    ctx->spill->in_l2 = ctx->in_l2;
+  }
+#endif
+}
+
+APP_CCM_CODE void AppDsp_ContextProcess(AppDspContext *ctx, AppStereoS24 *x, uint32_t n)
+{
+  if ((ctx == NULL) || (x == NULL) || (n == 0u))
+  {
+    return;
+  }
+
+  /* One pointer load selects the mask, the schedule and the parameters
+   * together, so a concurrent change takes effect at the next block
+   * boundary. The chain that runs may be a superset while switched-off FX
+   * fade out or ring.
+   */
+  const DspParams *c = s_params_front;
+#if APP_DSP_BUS_FRAMES
+  /* A parallel group stages the block in the buses. */
+  if ((n > APP_DSP_BUS_FRAMES) && c->sched->bus)
+  {
+    for (uint32_t i = 0; i < n; i += APP_DSP_BUS_FRAMES)
+    {
+      AppDsp_ContextProcess(ctx, &x[i], ((n - i) < APP_DSP_BUS_FRAMES) ? (n - i) : APP_DSP_BUS_FRAMES);
+    }
+    return;
+  }
+#endif
+
+#if DSP_SPILL
+  DspBlockParams *p = spill_begin(ctx, c);
+#else
+  DspBlockParams bp;
+  DspBlockParams *p = &bp;
+#endif
+  const AppFxMask mask = (s_bypass == APP_DSP_BYPASS_COND) ? 0u : c->fx_mask;
+  if (ctx->primary)
+  {
+    shed_ahead(c, mask);
+  }
+  ctx_snapshot(ctx, p, c, mask, n);
+#if CABSIM_IR
+  if (ctx->primary)
+  {
+    arena_handoff(ctx, p);
+  }
+#endif
+  AppFxMask run = fade_begin(ctx, p);
+  if (ctx->primary)
+  {
+    APP_SELFTEST_INPUT(x, n);
+  }
+  chain_run(ctx, x, n, p, run);
+  fade_end(ctx, p, n);
+  if (ctx->primary)
+  {
+    APP_SELFTEST_OUTPUT(x, n);
+  }
+}
+
+/* The primary chain at the bypass tier. TRUE leaves x as it came in. Out
+ * of TRUE the chain restarts cleared, its frozen tails and filter states
+ * being stale by then; into and out of it the first frames are joined to
+ * the last output frame, linearly over DSP_BYPASS_JOIN_FRAMES (after
+ * DSP_BYPASS_HOLD_FRAMES on the way out).
+ */
+APP_CCM_CODE static void bypass_run(AppStereoS24 *x, uint32_t n)
+{
+  const uint8_t tier = s_bypass;
+  if (tier != s_bypass_run)
+  {
+    const uint8_t was_true = (s_bypass_run == APP_DSP_BYPASS_TRUE) ? 1u : 0u;
+    s_bypass_run = tier;
+    s_bypass_hold = 0U;
+    if (was_true)
+    {
+      fx_state_reset(0U);
+      ctx_reset(&s_ctx);
+      s_bypass_hold = DSP_BYPASS_HOLD_FRAMES;
+    }
+    if (was_true || (tier == APP_DSP_BYPASS_TRUE))
+    {
+      s_bypass_from = s_bypass_last;
+      s_bypass_join = DSP_BYPASS_JOIN_FRAMES;
+    }
+  }
+  if (tier != APP_DSP_BYPASS_TRUE)
+  {
+    AppDsp_ContextProcess(&s_ctx, x, n);
+  }
+  for (uint32_t i = 0; (i < n) && (s_bypass_join != 0U); i++)
+  {
+    if (s_bypass_hold != 0U)
+    {
+      s_bypass_hold--;
+      x[i] = s_bypass_from;
+      continue;
+    }
+    const int32_t g = (int32_t)(((DSP_BYPASS_JOIN_FRAMES + 1U - s_bypass_join) * 32768U) / DSP_BYPASS_JOIN_FRAMES);
+    s_bypass_join--;
+    x[i].l = s_bypass_from.l + (int32_t)(((int64_t)(x[i].l - s_bypass_from.l) * g) >> 15);
+    x[i].r = s_bypass_from.r + (int32_t)(((int64_t)(x[i].r - s_bypass_from.r) * g) >> 15);
+  }
+  s_bypass_last = x[n - 1U];
 }
 
-static inline int32_t allpass_process_s24_len(int32_t x, int32_t *buf, uint32_t *idx, uint32_t mask)
+/* Stamps the block that first runs on the watched set. */
+APP_CCM_CODE static void params_watch(void)
 {
-  uint32_t i = *idx;
-  int32_t b = buf[i];
-
-  int32_t y = b - (int32_t)(((int64_t)REVERB_AP_G_Q15 * (int64_t)x) >> 15);
-  int32_t new_b = x + (int32_t)(((int64_t)REVERB_AP_G_Q15 * (int64_t)y) >> 15);
-  buf[i] = clamp_s24(new_b);
-
-  *idx = (i + 1U) & mask;
-  return clamp_s24(y);
+  const uint32_t v = s_params_watch;
+  if ((v != 0u) && ((int32_t)(s_params_front->version - v) >= 0))
+  {
+    s_params_watch_cyc = AppProf_Cycles();
+    DSP_COMPILER_BARRIER();
+    s_params_watch = 0u;
+  }
 }
 
-static inline int32_t triangle_lfo_offset_q8(uint32_t *phase, uint32_t step, int32_t amp_samples)
+APP_CCM_CODE void AppDsp_ProcessBlock(AppStereoS24 *x, uint32_t n)
 {
-  *phase += step;
-  uint8_t t = (uint8_t)(*phase >> 24);
-  uint8_t tri = (t < 128) ? t : (uint8_t)(255 - t);
-
-  /* Map tri 0..127 to signed [-amp..+amp] in Q8 (1/256 sample).
-   * Using a fractional delay offset allows interpolation and removes the
-   * stepping noise that sounds like a quiet "motor" or "prrrmmm".
-   */
-  int32_t off = (int32_t)tri - 64; /* -64..+63 */
-  int32_t off_q8 = (off * (amp_samples * 256)) / 64;
-  const int32_t lim = amp_samples * 256;
-  if (off_q8 > lim) off_q8 = lim;
-  if (off_q8 < -lim) off_q8 = -lim;
-  return off_q8;
-}
-
-static inline int32_t reverb_process_s24(int32_t x,
-                                        int32_t *delay,
-                                        uint32_t *delay_idx,
-                                        int32_t *lp,
-                                        int32_t *ap_buf,
-                                        uint32_t *ap1_idx,
-                                        uint32_t *ap2_idx,
-                                        uint32_t *lfo_phase,
-                                        uint32_t lfo_step)
-{
-  uint32_t i = *delay_idx;
-  int32_t mod_q8 = triangle_lfo_offset_q8(lfo_phase, lfo_step, REVERB_MOD_AMP_SAMPLES);
-  int32_t mod_i = (mod_q8 >> 8);
-  uint32_t frac = (uint32_t)(mod_q8 & 0xFF);
-
-  /* Fractional tap read with linear interpolation to avoid stepping artifacts. */
-  int32_t ri0 = (int32_t)i + mod_i;
-  ri0 = (ri0 + (int32_t)REVERB_DELAY_LEN) & (int32_t)REVERB_DELAY_MASK;
-  int32_t ri1 = (ri0 + 1) & (int32_t)REVERB_DELAY_MASK;
-
-  int32_t d0 = delay[(uint32_t)ri0];
-  int32_t d1 = delay[(uint32_t)ri1];
-  int32_t d = d0 + (int32_t)(((int64_t)(d1 - d0) * (int64_t)frac) >> 8);
-
-  int32_t lpv = *lp;
-  lpv += (int32_t)(((int64_t)s_reverb_damp_q15 * (int64_t)(d - lpv)) >> 15);
-  *lp = lpv;
+  if (x == NULL)
+  {
+    return;
+  }
+#if APP_DSP_PARAM_EVENTS
+  /* Pending timed commits cut the block at their frame. */
+  while (n > 0u)
+  {
+    uint32_t run = n;
+    const uint8_t tail = s_param_ev_tail;
+    if (tail != s_param_ev_head)
+    {
+      const DspParamEvent *ev = &s_param_ev[tail % APP_DSP_PARAM_EVENTS];
+      const int32_t due = (int32_t)(ev->frame - s_frame_clock);
+      if (due <= 0)
+      {
+        s_params_front = ev->params;
+        DSP_COMPILER_BARRIER();
+        s_param_ev_tail = (uint8_t)(tail + 1u);
+        continue;
+      }
+      run = ((uint32_t)due < n) ? (uint32_t)due : n;
+    }
+    params_watch();
+    bypass_run(x, run);
+    s_frame_clock += run;
+    x += run;
+    n -= run;
+  }
+#else
+  if (n != 0u)
+  {
+    params_watch();
+    bypass_run(x, n);
+  }
+  s_frame_clock += n;
+#endif
+}
 
-  int32_t fb = (int32_t)(((int64_t)s_reverb_feedback_q15 * (int64_t)lpv) >> 15);
-  delay[i] = clamp_s24(x + fb);
-  *delay_idx = (i + 1U) & REVERB_DELAY_MASK;
+AppDspContext *AppDsp_DefaultContext(void)
+{
+  return &s_ctx;
+}
 
-  /* Two-stage diffusion. */
-  int32_t y = allpass_process_s24_len(d, &ap_buf[0], ap1_idx, REVERB_AP1_MASK);
-  y = allpass_process_s24_len(y, &ap_buf[REVERB_AP1_LEN], ap2_idx, REVERB_AP2_MASK);
-  return y;
+uint32_t AppDsp_ContextBytes(void)
+{
+  return (uint32_t)sizeof(AppDspContext);
 }
 
-static inline int32_t delay_process_s24(int32_t x, int16_t *delay, DelayState *st)
+/* A secondary context starts from cleared FX states instead of their
+ * reset(), which would also clear the shared lines and restart the FMAC.
+ * Every FX it may run is all-zero at rest.
+ */
+AppDspContext *AppDsp_ContextCreate(void *mem, uint32_t bytes)
 {
-  /* Update delay at a lower effective sample rate to increase delay time and
-   * naturally roll off highs (warmer, less metallic).
-   */
-  if (st->phase == 0)
+  if ((mem == NULL) || (bytes < sizeof(AppDspContext)) || (((uintptr_t)mem & 7u) != 0u))
   {
-    uint32_t i = st->idx;
-    int32_t d = ((int32_t)delay[i]) << 8;
-
-    /* Low-pass the feedback signal to avoid robotic high-frequency ringing. */
-    st->fb_lp_s24 = onepole_lpf_s24(d, &st->fb_lp_s24, DELAY_FB_LPF_A_Q15);
-    int32_t fb = (int32_t)(((int64_t)s_delay_feedback_q15 * (int64_t)st->fb_lp_s24) >> 15);
-
-    delay[i] = s24_to_s16(clamp_s24(x + fb));
-    st->idx = (i + 1U) & DELAY_MASK;
-    st->last_out_s24 = d;
+    return NULL;
   }
-
-  st->phase = (uint8_t)((st->phase + 1U) % (uint8_t)DELAY_DECIM);
-  return st->last_out_s24;
+  AppDspContext *ctx = (AppDspContext *)mem;
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->primary = 0u;
+  sched_steps_init(ctx);
+  AppDsp_ContextReset(ctx);
+  return ctx;
 }
 
-static inline int32_t distortion_process_s24(DistState *st, int32_t x)
+void AppDsp_ContextReset(AppDspContext *ctx)
 {
-  const int32_t hp_r_q15 = 32113; /* ~150 Hz corner */
-  int32_t hp_y = x - st->hp_x1 + (int32_t)(((int64_t)hp_r_q15 * st->hp_y1) >> 15);
-  st->hp_x1 = x;
-  st->hp_y1 = hp_y;
-
-  int32_t d24 = (int32_t)(((int64_t)hp_y * s_dist_drive_q8) >> 8);
-
-  int32_t d24_mid = (d24 + st->os_x1) >> 1;
-  st->os_x1 = d24;
-
-  int32_t y0 = hard_tube_clip_s24(clamp_s24(d24));
-  int32_t y1 = hard_tube_clip_s24(clamp_s24(d24_mid));
-  int32_t y24 = (y0 + y1) >> 1;
-
-  const int32_t lp_a_q15 = 12000;
-  st->lp_y1 += (int32_t)(((int64_t)lp_a_q15 * (y24 - st->lp_y1)) >> 15);
-  y24 = st->lp_y1;
-
-  const int32_t level_q8 = 256;
-  y24 = (int32_t)(((int64_t)y24 * level_q8) >> 8);
-  return clamp_s24(y24);
+  if (ctx == NULL)
+  {
+    return;
+  }
+  if (ctx->primary)
+  {
+    dsp_state_reset(0U);
+    return;
+  }
+  memset(&ctx->fx, 0, sizeof(ctx->fx));
+  ctx_reset(ctx);
 }
 
-typedef struct
-{
-  int32_t x1;
-  int32_t x2;
-  int32_t y1;
-  int32_t y2;
-} BiquadState;
-
-static BiquadState s_cab_l = {0, 0, 0, 0};
-static BiquadState s_cab_r = {0, 0, 0, 0};
+/* ------------------------------- Benchmark -------------------------------- */
 
-/* Q28 biquad coefficients for lowpass @ ~5kHz, fs=48kHz.
- * Difference equation:
- * y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
+/* Fixed bench input: a 110 Hz saw at -6 dBFS plus noise at -30 dBFS, so
+ * the comp, limiter and tail FX take their loaded paths.
  */
-#define CAB_B0_Q28   ((int32_t)19407624)   /* ~0.0723 */
-#define CAB_B1_Q28   ((int32_t)38815248)   /* ~0.1446 */
-#define CAB_B2_Q28   ((int32_t)19407624)   /* ~0.0723 */
-#define CAB_A1_Q28   ((int32_t)-297323915) /* ~-1.108 */
-#define CAB_A2_Q28   ((int32_t)106689359)  /* ~0.3976 */
-
-static inline int32_t cab_lpf_process_s24(BiquadState *st, int32_t x)
+static void bench_fill(AppStereoS24 *x, uint32_t n, uint32_t *phase, uint32_t *rng)
 {
-  int64_t acc = 0;
-  acc += (int64_t)CAB_B0_Q28 * (int64_t)x;
-  acc += (int64_t)CAB_B1_Q28 * (int64_t)st->x1;
-  acc += (int64_t)CAB_B2_Q28 * (int64_t)st->x2;
-  acc -= (int64_t)CAB_A1_Q28 * (int64_t)st->y1;
-  acc -= (int64_t)CAB_A2_Q28 * (int64_t)st->y2;
-
-  int32_t y = (int32_t)(acc >> 28);
-  y = clamp_s24(y);
-
-  st->x2 = st->x1;
-  st->x1 = x;
-  st->y2 = st->y1;
-  st->y1 = y;
-  return y;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    *phase += (uint32_t)((110ull << 32) / DSP_SAMPLE_RATE_HZ);
+    *rng = (*rng * 1664525u) + 1013904223u;
+    const int32_t saw = (int32_t)*phase >> 9;
+    const int32_t noise = (int32_t)*rng >> 13;
+    x[i].l = saw + noise;
+    x[i].r = saw - noise;
+  }
 }
 
-/* ------------------------------- Public API ------------------------------- */
-
-void AppDsp_Init(void)
+static const AppEqBand k_eq_bench_bands[APP_EQ_BANDS] =
 {
-  s_mode = APP_FX_MODE_BYPASS;
-  s_button_last_ms = 0;
-  s_fx_mask = 0;
-
-  s_dist_l.hp_x1 = s_dist_l.hp_y1 = s_dist_l.lp_y1 = s_dist_l.os_x1 = 0;
-  s_dist_r.hp_x1 = s_dist_r.hp_y1 = s_dist_r.lp_y1 = s_dist_r.os_x1 = 0;
-
-  memset(s_reverb_delay_l, 0, sizeof(s_reverb_delay_l));
-  memset(s_reverb_delay_r, 0, sizeof(s_reverb_delay_r));
-  memset(s_reverb_ap_l, 0, sizeof(s_reverb_ap_l));
-  memset(s_reverb_ap_r, 0, sizeof(s_reverb_ap_r));
-  s_reverb_delay_idx_l = 0;
-  s_reverb_delay_idx_r = 0;
-  s_reverb_ap1_idx_l = 0;
-  s_reverb_ap1_idx_r = 0;
-  s_reverb_ap2_idx_l = 0;
-  s_reverb_ap2_idx_r = 0;
-  s_reverb_lp_l = 0;
-  s_reverb_lp_r = 0;
-  s_reverb_lfo_l = 0;
-  s_reverb_lfo_r = 0;
-
-  memset(s_delay_buf_l, 0, sizeof(s_delay_buf_l));
-  memset(s_delay_buf_r, 0, sizeof(s_delay_buf_r));
-  s_delay_l.idx = 0;
-  s_delay_l.phase = 0;
-  s_delay_l.last_out_s24 = 0;
-  s_delay_l.fb_lp_s24 = 0;
-  s_delay_r.idx = 0;
-  s_delay_r.phase = 0;
-  s_delay_r.last_out_s24 = 0;
-  s_delay_r.fb_lp_s24 = 0;
-
-  s_wet_lpf_delay_l = 0;
-  s_wet_lpf_delay_r = 0;
-  s_wet_lpf_reverb_l = 0;
-  s_wet_lpf_reverb_r = 0;
-
-  s_limiter.gain_q15 = 32768;
-
-  s_dc_l.x1 = s_dc_l.y1 = 0;
-  s_dc_r.x1 = s_dc_r.y1 = 0;
-
-  s_clean_hpf_l.x1 = s_clean_hpf_l.y1 = 0;
-  s_clean_hpf_r.x1 = s_clean_hpf_r.y1 = 0;
-
-  s_wet_hpf_delay_l.x1 = s_wet_hpf_delay_l.y1 = 0;
-  s_wet_hpf_delay_r.x1 = s_wet_hpf_delay_r.y1 = 0;
-  s_wet_hpf_reverb_l.x1 = s_wet_hpf_reverb_l.y1 = 0;
-  s_wet_hpf_reverb_r.x1 = s_wet_hpf_reverb_r.y1 = 0;
-
-  s_comp_l.env = 0;
-  s_comp_l.gain_q15 = 32768;
-  s_comp_r.env = 0;
-  s_comp_r.gain_q15 = 32768;
-
-  s_cab_l.x1 = s_cab_l.x2 = s_cab_l.y1 = s_cab_l.y2 = 0;
-  s_cab_r.x1 = s_cab_r.x2 = s_cab_r.y1 = s_cab_r.y2 = 0;
-}
+  {60, 120u, 71u}, {60, 500u, 100u}, {60, 2000u, 100u}, {60, 5000u, 71u},
+};
 
-void AppDsp_OnButtonPress(uint32_t now_ms)
+/* stage >= APP_PROF_STAGE_COUNT runs the chain of mask (stage - count). */
+static uint64_t bench_run(uint32_t stage, AppStereoS24 *x, uint32_t n, uint32_t blocks)
 {
-  /* Debounce: ignore edges within 300 ms. */
-  if ((now_ms - s_button_last_ms) < 300U)
+  const bool chain = (stage >= (uint32_t)APP_PROF_STAGE_COUNT);
+  const AppFxMask mask = chain ? (AppFxMask)(stage - (uint32_t)APP_PROF_STAGE_COUNT) : (AppFxMask)(DSP_CHAIN_COUNT - 1u);
+  uint32_t phase = 0;
+  uint32_t rng = 1u;
+  uint64_t cycles = 0;
+
+  /* The EQ stage runs every band at +6 dB, whatever the EQ is set to. */
+  AppEqCoeffs eq_bench;
+  AppEq_Design(k_eq_bench_bands, DSP_SAMPLE_RATE_HZ, &eq_bench);
+
+  /* Tail FX start awake at full send, as in steady playing. The reverb
+   * keeps the arena overlay, so an IR cab is benched as the biquad.
+   */
+  AppDspContext *ctx = &s_ctx;
+  DspFxStates *fx = &ctx->fx;
+  dsp_state_reset(0U);
+  for (uint32_t i = 0; i < DSP_FX_COUNT; i++)
   {
-    return;
+    if (k_fx_modules[i]->bit != 0u)
+    {
+      ramp_reset(&fx_fade(fx, i)->send, 32768);
+    }
+    if (k_fx_modules[i]->tail_frames != NULL)
+    {
+      fx_fade(fx, i)->awake = 1u;
+    }
   }
-  s_button_last_ms = now_ms;
 
-  switch (s_mode)
+  for (uint32_t b = 0; b < blocks; b++)
   {
-    case APP_FX_MODE_BYPASS:
-      s_mode = APP_FX_MODE_DISTORTION;
-      break;
-    case APP_FX_MODE_DISTORTION:
-      s_mode = APP_FX_MODE_REVERB;
-      break;
-    case APP_FX_MODE_REVERB:
-      s_mode = APP_FX_MODE_DELAY;
-      break;
-    case APP_FX_MODE_DELAY:
-      s_mode = APP_FX_MODE_ALL;
-      break;
-    default:
-      s_mode = APP_FX_MODE_BYPASS;
-      break;
+    DspBlockParams p;
+    ctx_snapshot(ctx, &p, s_params_front, mask, n);
+    (void)fade_begin(ctx, &p);
+    bench_fill(x, n, &phase, &rng);
+    DspLevel lv = {0u, 0u};
+
+    const uint32_t t0 = AppProf_Cycles();
+    switch (chain ? (uint32_t)APP_PROF_STAGE_COUNT : stage)
+    {
+      case APP_PROF_STAGE_DC_BLOCK: dc_block_block(ctx->ch, x, n, &lv); break;
+      case APP_PROF_STAGE_GATE:   /* -90 dBFS, at the threshold: open */
+        p.gate_open_ms = 70369u;
+        lv.sum_sq = (uint64_t)p.gate_open_ms * (n * GATE_CHANNELS);
+        gate_block(&ctx->gate, x, n, &p, &lv);
+        break;
+      case APP_PROF_STAGE_COMP: comp_block(ctx->ch, x, n, &p); break;
+      case APP_PROF_STAGE_COLOR: color_block(x, n, p.color_curve); break;
+      case APP_PROF_STAGE_WAH: p.wah_mix_q15 = 32768; (void)wah_block(&fx->wah, x, n, &p, DSP_MAG_S24); break;
+#if APP_DSP_PITCH_ENABLE
+      case APP_PROF_STAGE_PITCH: p.pitch_mix_q15 = 32768; (void)pitch_block(&fx->pitch, x, n, &p, DSP_MAG_S24); break;
+#endif
+      case APP_PROF_STAGE_DISTORTION: p.dist_os = 1u; (void)distortion_block(&fx->distortion, x, n, &p, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_DIST_OS2: p.dist_os = 2u; (void)distortion_block(&fx->distortion, x, n, &p, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_DIST_OS4: p.dist_os = 4u; (void)distortion_block(&fx->distortion, x, n, &p, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_EQ: p.eq = &eq_bench; (void)eq_block(&fx->eq, x, n, &p, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_PHASER: (void)phaser_block(&fx->phaser, x, n, &p, DSP_MAG_S24); break;
+#if APP_DSP_CHORUS_ENABLE
+      case APP_PROF_STAGE_CHORUS: (void)chorus_block(&fx->chorus, x, n, &p, DSP_MAG_S24); break;
+#endif
+      case APP_PROF_STAGE_DELAY: (void)delay_block(&fx->delay, x, n, &p, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_REVERB: (void)reverb_block(&fx->reverb, x, n, &p, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_LOOP: loop_bench(); (void)loop_block(x, n, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_OUTPUT: output_block(&ctx->makeup_q15, &ctx->tremolo, x, n, &p, DSP_MAG_S24); break;
+      case APP_PROF_STAGE_LIMITER: limiter_block(&ctx->limiter, x, n); break;
+      default: chain_run(ctx, x, n, &p, mask); break;
+    }
+    cycles += AppProf_Cycles() - t0;
   }
 
-  /* Keep mask consistent with legacy mode cycling. */
-  if (s_mode == APP_FX_MODE_BYPASS) s_fx_mask = 0;
-  else if (s_mode == APP_FX_MODE_DISTORTION) s_fx_mask = APP_FX_BIT_DISTORTION;
-  else if (s_mode == APP_FX_MODE_REVERB) s_fx_mask = APP_FX_BIT_REVERB;
-  else if (s_mode == APP_FX_MODE_DELAY) s_fx_mask = APP_FX_BIT_DELAY;
-  else if (s_mode == APP_FX_MODE_ALL) s_fx_mask = (APP_FX_BIT_DISTORTION | APP_FX_BIT_REVERB | APP_FX_BIT_DELAY);
+  dsp_state_reset(0U);
+  return cycles;
 }
 
-AppFxMode AppDsp_GetMode(void)
+uint64_t AppDsp_BenchStage(uint32_t stage, AppStereoS24 *x, uint32_t n, uint32_t blocks)
 {
-  return (AppFxMode)s_mode;
+  if ((x == NULL) || (n == 0u) || (stage >= (uint32_t)APP_PROF_STAGE_COUNT))
+  {
+    return 0u;
+  }
+  return bench_run(stage, x, n, blocks);
 }
 
-void AppDsp_SetFxMask(AppFxMask mask)
+uint64_t AppDsp_BenchChain(AppFxMask mask, AppStereoS24 *x, uint32_t n, uint32_t blocks)
 {
-  mask &= (AppFxMask)(APP_FX_BIT_DISTORTION | APP_FX_BIT_REVERB | APP_FX_BIT_DELAY);
-  s_fx_mask = mask;
-
-  /* Update legacy mode for existing status/LED timing logic. */
-  if (mask == 0)
+  if ((x == NULL) || (n == 0u) || (mask >= DSP_CHAIN_COUNT))
   {
-    s_mode = APP_FX_MODE_BYPASS;
+    return 0u;
   }
-  else if (mask == APP_FX_BIT_DISTORTION)
+#if APP_DSP_BUS_FRAMES
+  if ((n > APP_DSP_BUS_FRAMES) && s_params_front->sched->bus)
   {
-    s_mode = APP_FX_MODE_DISTORTION;
+    return 0u;
   }
-  else if (mask == APP_FX_BIT_REVERB)
+#endif
+  return bench_run((uint32_t)APP_PROF_STAGE_COUNT + mask, x, n, blocks);
+}
+
+/* Kernel benches (AppDspKernel): each per-sample kernel alone in a loop
+ * over the frames, on the state of the module that runs it. The frame
+ * variant calls the loop once per frame through a pointer, as
+ * AppDsp_ProcessFrame() pays a call per frame; the block variant once.
+ */
+typedef void (*DspKernelFn)(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n);
+
+static void kernel_dc_block(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
+{
+  ReverbFxState *rs = &fx->reverb;
+  for (uint32_t i = 0; i < n; i++)
   {
-    s_mode = APP_FX_MODE_REVERB;
+    x[i].l = dc_block_s24(&rs->wet_hpf_l, x[i].l);
+    x[i].r = dc_block_s24(&rs->wet_hpf_r, x[i].r);
   }
-  else if (mask == APP_FX_BIT_DELAY)
+}
+
+static void kernel_hpf1(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
+{
+  ReverbFxState *rs = &fx->reverb;
+  for (uint32_t i = 0; i < n; i++)
   {
-    s_mode = APP_FX_MODE_DELAY;
+    x[i].l = hpf1_s24(&rs->wet_hpf_l, x[i].l, s_rate.clean_hpf_r_q15);
+    x[i].r = hpf1_s24(&rs->wet_hpf_r, x[i].r, s_rate.clean_hpf_r_q15);
   }
-  else
+}
+
+/* The fixed cab lowpass, as distortion_block() runs it without a user cab. */
+static void kernel_cab_biquad(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
+{
+  DistFxState *d = &fx->distortion;
+  for (uint32_t i = 0; i < n; i++)
   {
-    s_mode = APP_FX_MODE_ALL;
+    x[i].l = cab_biquad_s24(&d->cab_l[0], s_rate.cab_b_q28, s_rate.cab_a_q28, x[i].l);
+    x[i].r = cab_biquad_s24(&d->cab_r[0], s_rate.cab_b_q28, s_rate.cab_a_q28, x[i].r);
   }
 }
 
-AppFxMask AppDsp_GetFxMask(void)
+/* One phaser stage at a fixed coefficient, in PHASER_SUB runs as
+ * phaser_block() feeds it.
+ */
+static void kernel_allpass1(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
 {
-  return (AppFxMask)s_fx_mask;
+  PhaserFxState *ph = &fx->phaser;
+  int32_t wl[PHASER_SUB];
+  int32_t wr[PHASER_SUB];
+  for (uint32_t i = 0; i < n; i += PHASER_SUB)
+  {
+    const uint32_t len = ((n - i) < PHASER_SUB) ? (n - i) : PHASER_SUB;
+    for (uint32_t j = 0; j < len; j++)
+    {
+      wl[j] = x[i + j].l;
+      wr[j] = x[i + j].r;
+    }
+    allpass1_process_s24_len(wl, len, -16384, &ph->ap_l[0]);
+    allpass1_process_s24_len(wr, len, -16384, &ph->ap_r[0]);
+    for (uint32_t j = 0; j < len; j++)
+    {
+      x[i + j].l = wl[j];
+      x[i + j].r = wr[j];
+    }
+  }
 }
 
-static inline int32_t clamp_q15(int32_t x)
+/* The reverb diffuser's first stereo allpass. */
+static void kernel_allpass_stereo(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
 {
-  if (x < 0) return 0;
-  if (x > 32768) return 32768;
-  return x;
+  ReverbState *st = &fx->reverb.tank;
+  for (uint32_t i = 0; i < n; i++)
+  {
+#if APP_DSP_FLOAT
+    float l = (float)x[i].l;
+    float r = (float)x[i].r;
+    allpass_process_stereo_f(&l, &r, s_reverb_ap, &st->ap_idx[0], k_reverb_ap_len[0]);
+    x[i].l = dsp_f_to_s24(l);
+    x[i].r = dsp_f_to_s24(r);
+#else
+    allpass_process_stereo_s24(&x[i], s_reverb_ap, &st->ap_idx[0], k_reverb_ap_len[0]);
+#endif
+  }
 }
 
-static inline int32_t clamp_gain_q15(int32_t x)
+/* The FDN tank with early reflections and diffuser, at the full rate. */
+static void kernel_reverb(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
 {
-  /* Allow master gain > 1.0x for extra output volume.
-   * 32768 = 1.0x, 65536 = 2.0x.
-   */
-  if (x < 0) return 0;
-  if (x > 65536) return 65536;
-  return x;
+  ReverbFxState *rs = &fx->reverb;
+  ReverbState st = rs->tank;
+#if REVERB_MOD_ENABLE
+  AppLfo_Block(&rs->lfo, n, &st.mod);
+#endif
+  for (uint32_t i = 0; i < n; i++)
+  {
+    reverb_process_s24(&x[i], s_reverb_fdn, s_reverb_ap, &st,
+                       p->reverb_feedback_q15, p->reverb_damp_q15, p->reverb_er, p->reverb_er_q15,
+                       p->reverb_diffusion, false);
+  }
+  rs->tank = st;
 }
 
-void AppDsp_SetParam(AppDspParamId id, int32_t value)
+static void kernel_distortion(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
 {
-  switch (id)
+  DistFxState *d = &fx->distortion;
+  for (uint32_t i = 0; i < n; i++)
   {
-    case APP_DSP_PARAM_DIST_DRIVE_Q8:
-      if (value < 0) value = 0;
-      if (value > 131072) value = 131072;
-      s_dist_drive_q8 = value;
-      break;
-    case APP_DSP_PARAM_DELAY_MIX_Q15:
-      s_delay_mix_q15 = clamp_q15(value);
-      break;
-    case APP_DSP_PARAM_DELAY_FEEDBACK_Q15:
-      s_delay_feedback_q15 = clamp_q15(value);
-      break;
-    case APP_DSP_PARAM_REVERB_MIX_Q15:
-      s_reverb_mix_q15 = clamp_q15(value);
-      break;
-    case APP_DSP_PARAM_REVERB_FEEDBACK_Q15:
-      s_reverb_feedback_q15 = clamp_q15(value);
-      break;
-    case APP_DSP_PARAM_REVERB_DAMP_Q15:
-      s_reverb_damp_q15 = clamp_q15(value);
-      break;
-    case APP_DSP_PARAM_GAIN_Q15:
-      s_gain_q15 = clamp_gain_q15(value);
-      break;
-    default:
-      break;
+    x[i].l = distortion_process_s24(&d->l, x[i].l, p->dist_drive_q8, 1u, p->dist_curve, NULL);
+    x[i].r = distortion_process_s24(&d->r, x[i].r, p->dist_drive_q8, 1u, p->dist_curve, NULL);
   }
 }
 
-int32_t AppDsp_GetParam(AppDspParamId id)
+static void kernel_distortion_os4(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
 {
-  switch (id)
+  DistFxState *d = &fx->distortion;
+  for (uint32_t i = 0; i < n; i++)
   {
-    case APP_DSP_PARAM_DIST_DRIVE_Q8:
-      return s_dist_drive_q8;
-    case APP_DSP_PARAM_DELAY_MIX_Q15:
-      return s_delay_mix_q15;
-    case APP_DSP_PARAM_DELAY_FEEDBACK_Q15:
-      return s_delay_feedback_q15;
-    case APP_DSP_PARAM_REVERB_MIX_Q15:
-      return s_reverb_mix_q15;
-    case APP_DSP_PARAM_REVERB_FEEDBACK_Q15:
-      return s_reverb_feedback_q15;
-    case APP_DSP_PARAM_REVERB_DAMP_Q15:
-      return s_reverb_damp_q15;
-    case APP_DSP_PARAM_GAIN_Q15:
-      return s_gain_q15;
-    default:
-      return 0;
+    x[i].l = distortion_process_s24(&d->l, x[i].l, p->dist_drive_q8, 4u, p->dist_curve, NULL);
+    x[i].r = distortion_process_s24(&d->r, x[i].r, p->dist_drive_q8, 4u, p->dist_curve, NULL);
   }
 }
 
-void AppDsp_ProcessFrame(int32_t *l_s24, int32_t *r_s24)
+/* A distortion model's kernel over x in DIST_CHUNK pieces, as dist_chunk()
+ * runs it.
+ */
+static void kernel_dist_model(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n,
+                              uint32_t model, uint32_t os)
 {
-  int32_t l = *l_s24;
-  int32_t r = *r_s24;
-
-  AppFxMask mask = (AppFxMask)s_fx_mask;
-  bool has_dist = (mask & APP_FX_BIT_DISTORTION) != 0;
-  bool has_rev  = (mask & APP_FX_BIT_REVERB) != 0;
-  bool has_del  = (mask & APP_FX_BIT_DELAY) != 0;
-  uint32_t fx_count = (has_dist ? 1u : 0u) + (has_rev ? 1u : 0u) + (has_del ? 1u : 0u);
-
-  /* Remove DC/subsonic before any gain. */
-  l = dc_block_s24(&s_dc_l, l);
-  r = dc_block_s24(&s_dc_r, r);
+  DistFxState *d = &fx->distortion;
+  int32_t wl[DIST_CHUNK];
+  int32_t wr[DIST_CHUNK];
+  for (uint32_t i = 0; i < n; i += DIST_CHUNK)
+  {
+    const uint32_t m = ((n - i) < DIST_CHUNK) ? (n - i) : DIST_CHUNK;
+    for (uint32_t j = 0; j < m; j++)
+    {
+      wl[j] = x[i + j].l;
+      wr[j] = x[i + j].r;
+    }
+    k_dist_models[model].run(&d->l, wl, m, p->dist_drive_q8, os, p->dist_curve, NULL);
+    k_dist_models[model].run(&d->r, wr, m, p->dist_drive_q8, os, p->dist_curve, NULL);
+    for (uint32_t j = 0; j < m; j++)
+    {
+      x[i + j].l = wl[j];
+      x[i + j].r = wr[j];
+    }
+  }
+}
 
-#if CLEAN_HPF_ENABLE
-  /* Clean rumble removal (tightens low end for guitar cleans). */
-  l = hpf1_s24(&s_clean_hpf_l, l, CLEAN_HPF_R_Q15);
-  r = hpf1_s24(&s_clean_hpf_r, r, CLEAN_HPF_R_Q15);
-#endif
+static void kernel_dist_tube(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
+{
+  kernel_dist_model(fx, p, x, n, APP_DSP_DIST_TUBE, 4u);
+}
 
-  /* Gain staging: lift instrument level first. */
-  l = gain_s32_q8(l, AUDIO_INPUT_GAIN_Q8);
-  r = gain_s32_q8(r, AUDIO_INPUT_GAIN_Q8);
+static void kernel_dist_fuzz(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
+{
+  kernel_dist_model(fx, p, x, n, APP_DSP_DIST_FUZZ, 4u);
+}
 
-  /* Gentle dual-mono compressor for smoother clean dynamics. */
-  clean_comp_process_s24(&l, &r);
+static void kernel_dist_crush(DspFxStates *fx, const DspBlockParams *p, AppStereoS24 *x, uint32_t n)
+{
+  kernel_dist_model(fx, p, x, n, APP_DSP_DIST_CRUSH, 1u);
+}
 
-  /* Subtle always-on coloration. */
-  l = input_color_process_s24(l);
-  r = input_color_process_s24(r);
+static const struct
+{
+  const char *name;
+  DspKernelFn fn;
+} k_dsp_kernels[APP_DSP_KERNEL_COUNT] =
+{
+  {"dc_block_s24", kernel_dc_block},
+  {"hpf1_s24", kernel_hpf1},
+  {"cab_biquad_s24", kernel_cab_biquad},
+  {"allpass1_s24_len", kernel_allpass1},
+  {"allpass_stereo_s24", kernel_allpass_stereo},
+  {"reverb_process_s24", kernel_reverb},
+  {"distortion_s24", kernel_distortion},
+  {"distortion_s24_os4", kernel_distortion_os4},
+  {"dist_tube_os4", kernel_dist_tube},
+  {"dist_fuzz_os4", kernel_dist_fuzz},
+  {"dist_crush", kernel_dist_crush},
+};
+
+const char *AppDsp_KernelName(AppDspKernel kernel)
+{
+  return ((uint32_t)kernel < (uint32_t)APP_DSP_KERNEL_COUNT) ? k_dsp_kernels[kernel].name : "?";
+}
 
-  /* FX chain order: Distortion -> Delay -> Reverb.
-   * This keeps cab-sim right after distortion and keeps space FX last.
-   */
-  if (has_dist)
+uint64_t AppDsp_BenchKernel(AppDspKernel kernel, uint8_t per_frame, AppStereoS24 *x, uint32_t n, uint32_t blocks)
+{
+  if ((x == NULL) || (n == 0u) || ((uint32_t)kernel >= (uint32_t)APP_DSP_KERNEL_COUNT))
   {
-    l = distortion_process_s24(&s_dist_l, clamp_s24(l));
-    r = distortion_process_s24(&s_dist_r, clamp_s24(r));
-
-#if CABSIM_ENABLE
-    l = cab_lpf_process_s24(&s_cab_l, l);
-    r = cab_lpf_process_s24(&s_cab_r, r);
-#endif
+    return 0u;
   }
-
-  if (has_del)
+  /* Read per call, so the frame variant keeps its call. */
+  DspKernelFn volatile fn = k_dsp_kernels[kernel].fn;
+  AppDspContext *ctx = &s_ctx;
+  uint32_t phase = 0;
+  uint32_t rng = 1u;
+  uint64_t cycles = 0;
+
+  dsp_state_reset(0U);
+  for (uint32_t b = 0; b < blocks; b++)
   {
-    int32_t wl = delay_process_s24(clamp_s24(l), s_delay_buf_l, &s_delay_l);
-    int32_t wr = delay_process_s24(clamp_s24(r), s_delay_buf_r, &s_delay_r);
-#if WET_HPF_ENABLE
-    wl = hpf1_s24(&s_wet_hpf_delay_l, wl, WET_HPF_R_Q15);
-    wr = hpf1_s24(&s_wet_hpf_delay_r, wr, WET_HPF_R_Q15);
-#endif
-    wl = onepole_lpf_s24(wl, &s_wet_lpf_delay_l, WET_LPF_A_Q15);
-    wr = onepole_lpf_s24(wr, &s_wet_lpf_delay_r, WET_LPF_A_Q15);
+    DspBlockParams p;
+    ctx_snapshot(ctx, &p, s_params_front, (AppFxMask)(DSP_CHAIN_COUNT - 1u), n);
+    bench_fill(x, n, &phase, &rng);
 
-    /* Let the UI knob actually control delay depth even when multiple FX are
-     * enabled. Keep a small attenuation in stacked mode so it doesn't swamp.
-     */
-    int32_t mix = s_delay_mix_q15;
-    if (fx_count > 1u)
+    const uint32_t t0 = AppProf_Cycles();
+    if (per_frame != 0u)
+    {
+      for (uint32_t i = 0; i < n; i++)
+      {
+        fn(&ctx->fx, &p, &x[i], 1u);
+      }
+    }
+    else
     {
-      mix = (mix * 3) / 4; /* 0.75x */
+      fn(&ctx->fx, &p, x, n);
     }
-    l = mix_s24(clamp_s24(l), wl, mix);
-    r = mix_s24(clamp_s24(r), wr, mix);
+    cycles += AppProf_Cycles() - t0;
   }
 
-  if (has_rev)
-  {
-    int32_t wl = reverb_process_s24(clamp_s24(l), s_reverb_delay_l, &s_reverb_delay_idx_l, &s_reverb_lp_l, s_reverb_ap_l, &s_reverb_ap1_idx_l, &s_reverb_ap2_idx_l, &s_reverb_lfo_l, REVERB_MOD_STEP_L);
-    int32_t wr = reverb_process_s24(clamp_s24(r), s_reverb_delay_r, &s_reverb_delay_idx_r, &s_reverb_lp_r, s_reverb_ap_r, &s_reverb_ap1_idx_r, &s_reverb_ap2_idx_r, &s_reverb_lfo_r, REVERB_MOD_STEP_R);
-#if WET_HPF_ENABLE
-    wl = hpf1_s24(&s_wet_hpf_reverb_l, wl, WET_HPF_R_Q15);
-    wr = hpf1_s24(&s_wet_hpf_reverb_r, wr, WET_HPF_R_Q15);
+  dsp_state_reset(0U);
+  return cycles;
+}
+
+static const AppMemItem k_dsp_mem[] =
+{
+  APP_MEM_ITEM("dsp.arena", s_fx_arena_pool),
+  APP_MEM_ITEM("dsp.ctx", s_ctx),
+  APP_MEM_ITEM("dsp.sched", s_sched),
+#if !DELAY_IN_ARENA
+  APP_MEM_ITEM("dsp.delay", s_delay_buf),
 #endif
-    wl = onepole_lpf_s24(wl, &s_wet_lpf_reverb_l, WET_LPF_A_Q15);
-    wr = onepole_lpf_s24(wr, &s_wet_lpf_reverb_r, WET_LPF_A_Q15);
-    int32_t mix = (fx_count > 1u) ? s_reverb_mix_all_q15 : s_reverb_mix_q15;
-    l = mix_s24(clamp_s24(l), wl, mix);
-    r = mix_s24(clamp_s24(r), wr, mix);
-  }
+  APP_MEM_ITEM("dsp.params", s_params),
+  APP_MEM_ITEM("dsp.param_hash", s_param_hash),
+};
 
-  /* Makeup gain for overall loudness. */
-  int32_t makeup_q8 = AUDIO_MAKEUP_GAIN_Q8;
-  if (mask != 0)
-  {
-    makeup_q8 = (makeup_q8 * 3) / 4;
-  }
-  l = gain_s32_q8(l, makeup_q8);
-  r = gain_s32_q8(r, makeup_q8);
+#if DELAY_IN_ARENA
+#define DSP_DELAY_STATIC_BYTES         0U
+#else
+#define DSP_DELAY_STATIC_BYTES         sizeof(s_delay_buf)
+#endif
 
-  /* Master volume control (unity by default). */
-  l = clamp_s24((int32_t)(((int64_t)l * (int64_t)s_gain_q15) >> 15));
-  r = clamp_s24((int32_t)(((int64_t)r * (int64_t)s_gain_q15) >> 15));
+/* The share is the target's: host builds (tools/dsp_host) have wider
+ * pointers in the context and the steps.
+ */
+_Static_assert((sizeof(void *) > 4U) ||
+               ((sizeof(s_fx_arena_pool) + DSP_DELAY_STATIC_BYTES + sizeof(s_ctx) + sizeof(s_sched) +
+                 sizeof(s_params) + sizeof(s_param_hash)) <= APP_DSP_RAM_BYTES),
+               "the DSP buffers outgrew APP_DSP_RAM_BYTES");
+
+uint32_t AppDsp_MemMap(const AppMemItem **items)
+{
+  *items = k_dsp_mem;
+  return (uint32_t)(sizeof(k_dsp_mem) / sizeof(k_dsp_mem[0]));
+}
 
-  /* Final protection against transient overload. */
-  limiter_process_s24(&l, &r);
+void *AppDsp_ArenaScratch(uint32_t *bytes)
+{
+  *bytes = (uint32_t)sizeof(s_fx_arena_pool);
+  return s_fx_arena_pool;
+}
 
-  *l_s24 = clamp_s24(l);
-  *r_s24 = clamp_s24(r);
+void AppDsp_GetArena(AppDspArenaInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->size = s_fx_arena.size;
+  out->used = s_fx_arena.used;
+  out->shared = s_fx_arena.wanted - s_fx_arena.used;
+#if CABSIM_IR
+  out->owner = s_arena_reverb ? "reverb" : "cabir";
+#else
+  out->owner = "reverb";
+#endif
 }
@@ -0,0 +1,312 @@
+#include "app_eq.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "app_mem.h"
+
+#if APP_EQ_USE_CMSIS
+#include "arm_math.h"
+#endif
+
+/*
+ * Parametric EQ.
+ * - Design: RBJ cookbook biquads, normalised by a0 and stored in Q28
+ *   (APP_EQ_POST_SHIFT), feedback terms negated for the CMSIS convention.
+ *   Bands at 0 dB are dropped, so 'stages' counts only the active ones;
+ *   those under APP_EQ_FAST_MIN_HZ go first, on the 64-bit state kernel.
+ * - Process: the set is copied once per call, then the block is split
+ *   into EQ_CHUNK-frame pieces, deinterleaved into q31 scratch on the stack
+ *   (128 bytes), filtered in place per channel and written back saturated
+ *   to s24. CMSIS allows pSrc == pDst.
+ * - One state array per channel serves both kernels: 4 q63 words per
+ *   high-precision stage, then 4 q31 words per fast stage.
+ * - The fast q31 kernel keeps 32 bits in the accumulator and expects its
+ *   input well below full scale; s24 << APP_EQ_HEADROOM_BITS puts full
+ *   scale at 2^27.
+ */
+
+#define EQ_CHUNK        16u
+#define EQ_COEFF_MAX_Q  (8.0f - (1.0f / 268435456.0f))
+#define EQ_PI           3.14159265f
+
+typedef union
+{
+  int64_t hp[4u * APP_EQ_BANDS];
+  int32_t fast[8u * APP_EQ_BANDS];
+} EqState;
+
+static EqState s_eq_state[2];
+static AppEqCoeffs s_eq_active;   /* audio-side copy of the current set */
+
+static int32_t eq_coeff_q28(float v)
+{
+  if (v > EQ_COEFF_MAX_Q) v = EQ_COEFF_MAX_Q;
+  if (v < -EQ_COEFF_MAX_Q) v = -EQ_COEFF_MAX_Q;
+  return (int32_t)((v * 268435456.0f) + ((v >= 0.0f) ? 0.5f : -0.5f));
+}
+
+/* One band -> {b0, b1, b2, -a1, -a2} / a0. */
+static void eq_design_band(AppEqBandId id, const AppEqBand *b, uint32_t fs_hz, int32_t *out)
+{
+  float f = (float)b->freq_hz;
+  const float f_max = 0.45f * (float)fs_hz;
+  if (f > f_max) f = f_max;
+  if (f < 10.0f) f = 10.0f;
+
+  const float a = powf(10.0f, (float)b->gain_db10 / 400.0f);
+  const float w0 = (2.0f * EQ_PI * f) / (float)fs_hz;
+  const float cs = cosf(w0);
+  const float sn = sinf(w0);
+  float b0, b1, b2, a0, a1, a2;
+
+  if ((id == APP_EQ_LOW_SHELF) || (id == APP_EQ_HIGH_SHELF))
+  {
+    /* Shelf slope S = 1: alpha = sin(w0) / sqrt(2). */
+    const float k = 2.0f * sqrtf(a) * (sn * 0.70710678f);
+    const float ap = a + 1.0f;
+    const float am = a - 1.0f;
+    if (id == APP_EQ_LOW_SHELF)
+    {
+      b0 = a * ((ap - (am * cs)) + k);
+      b1 = 2.0f * a * (am - (ap * cs));
+      b2 = a * ((ap - (am * cs)) - k);
+      a0 = (ap + (am * cs)) + k;
+      a1 = -2.0f * (am + (ap * cs));
+      a2 = (ap + (am * cs)) - k;
+    }
+    else
+    {
+      b0 = a * ((ap + (am * cs)) + k);
+      b1 = -2.0f * a * (am + (ap * cs));
+      b2 = a * ((ap + (am * cs)) - k);
+      a0 = (ap - (am * cs)) + k;
+      a1 = 2.0f * (am - (ap * cs));
+      a2 = (ap - (am * cs)) - k;
+    }
+  }
+  else
+  {
+    const float q = (b->q100 != 0u) ? ((float)b->q100 / 100.0f) : 0.707f;
+    const float alpha = sn / (2.0f * q);
+    b0 = 1.0f + (alpha * a);
+    b1 = -2.0f * cs;
+    b2 = 1.0f - (alpha * a);
+    a0 = 1.0f + (alpha / a);
+    a1 = -2.0f * cs;
+    a2 = 1.0f - (alpha / a);
+  }
+
+  const float inv = 1.0f / a0;
+  out[0] = eq_coeff_q28(b0 * inv);
+  out[1] = eq_coeff_q28(b1 * inv);
+  out[2] = eq_coeff_q28(b2 * inv);
+  out[3] = eq_coeff_q28(-a1 * inv);
+  out[4] = eq_coeff_q28(-a2 * inv);
+}
+
+void AppEq_Design(const AppEqBand *bands, uint32_t fs_hz, AppEqCoeffs *out)
+{
+  if ((bands == NULL) || (out == NULL) || (fs_hz == 0u))
+  {
+    return;
+  }
+
+  uint32_t stages = 0;
+  for (uint32_t pass = 0; pass < 2u; pass++)
+  {
+    for (uint32_t i = 0; i < APP_EQ_BANDS; i++)
+    {
+      const uint8_t hp = (bands[i].freq_hz < APP_EQ_FAST_MIN_HZ) ? 1u : 0u;
+      if ((bands[i].gain_db10 != 0) && (hp == (pass == 0u)))
+      {
+        eq_design_band((AppEqBandId)i, &bands[i], fs_hz, &out->coeff[5u * stages]);
+        stages++;
+      }
+    }
+    if (pass == 0u)
+    {
+      out->stages_hp = stages;
+    }
+  }
+  out->stages = stages;
+}
+
+void AppEq_Reset(void)
+{
+  memset(s_eq_state, 0, sizeof(s_eq_state));
+}
+
+#if !APP_EQ_USE_CMSIS
+/* arm_biquad_cas_df1_32x64_q31() without loop unrolling. */
+static inline int64_t eq_mul_32x64(int64_t x, int32_t y)
+{
+  return (((x & 0xFFFFFFFFLL) * y) >> 32) + ((x >> 32) * y);
+}
+
+static void eq_cascade_hp_q31(const int32_t *coeff, int64_t *state, uint32_t stages, int32_t *buf, uint32_t n)
+{
+  for (uint32_t s = 0; s < stages; s++)
+  {
+    const int32_t b0 = coeff[0];
+    const int32_t b1 = coeff[1];
+    const int32_t b2 = coeff[2];
+    const int32_t a1 = coeff[3];
+    const int32_t a2 = coeff[4];
+    int32_t x1 = (int32_t)state[0];
+    int32_t x2 = (int32_t)state[1];
+    int64_t y1 = state[2];
+    int64_t y2 = state[3];
+    for (uint32_t i = 0; i < n; i++)
+    {
+      const int32_t x0 = buf[i];
+      int64_t acc = (int64_t)x0 * b0;
+      acc += (int64_t)x1 * b1;
+      acc += (int64_t)x2 * b2;
+      acc += eq_mul_32x64(y1, a1);
+      acc += eq_mul_32x64(y2, a2);
+      x2 = x1;
+      x1 = x0;
+      y2 = y1;
+      y1 = (int64_t)((uint64_t)acc << (APP_EQ_POST_SHIFT + 1u));
+      buf[i] = (int32_t)(uint32_t)((uint64_t)acc >> (31u - APP_EQ_POST_SHIFT));
+    }
+    state[0] = x1;
+    state[1] = x2;
+    state[2] = y1;
+    state[3] = y2;
+    coeff += 5;
+    state += 4;
+  }
+}
+
+/* arm_biquad_cascade_df1_fast_q31() without loop unrolling. */
+static inline int32_t eq_mac_q31(int32_t acc, int32_t a, int32_t b)
+{
+  return (int32_t)((((int64_t)acc * 4294967296LL) + ((int64_t)a * b) + 0x80000000LL) >> 32);
+}
+
+static void eq_cascade_q31(const int32_t *coeff, int32_t *state, uint32_t stages, int32_t *buf, uint32_t n)
+{
+  for (uint32_t s = 0; s < stages; s++)
+  {
+    const int32_t b0 = coeff[0];
+    const int32_t b1 = coeff[1];
+    const int32_t b2 = coeff[2];
+    const int32_t a1 = coeff[3];
+    const int32_t a2 = coeff[4];
+    int32_t x1 = state[0];
+    int32_t x2 = state[1];
+    int32_t y1 = state[2];
+    int32_t y2 = state[3];
+    for (uint32_t i = 0; i < n; i++)
+    {
+      const int32_t x0 = buf[i];
+      int32_t acc = eq_mac_q31(0, b0, x0);
+      acc = eq_mac_q31(acc, b1, x1);
+      acc = eq_mac_q31(acc, b2, x2);
+      acc = eq_mac_q31(acc, a1, y1);
+      acc = eq_mac_q31(acc, a2, y2);
+      const int32_t y0 = (int32_t)((uint32_t)acc << (APP_EQ_POST_SHIFT + 1u));
+      x2 = x1;
+      x1 = x0;
+      y2 = y1;
+      y1 = y0;
+      buf[i] = y0;
+    }
+    state[0] = x1;
+    state[1] = x2;
+    state[2] = y1;
+    state[3] = y2;
+    coeff += 5;
+    state += 4;
+  }
+}
+#endif
+
+static inline int32_t eq_out_s24(int32_t y)
+{
+  y >>= APP_EQ_HEADROOM_BITS;
+  if (y > 8388607) return 8388607;
+  if (y < -8388608) return -8388608;
+  return y;
+}
+
+APP_CCM_CODE void AppEq_Process(const AppEqCoeffs *c, AppStereoS24 *x, uint32_t n, uint32_t channels)
+{
+  /* Own copy, so the control side may rewrite c once this block has
+   * started, like every other parameter the block snapshot copies.
+   */
+  if ((c->stages != s_eq_active.stages) || (c->stages_hp != s_eq_active.stages_hp))
+  {
+    AppEq_Reset();
+  }
+  s_eq_active = *c;
+  c = &s_eq_active;
+  if (c->stages == 0u)
+  {
+    return;
+  }
+  if (channels > 2u)
+  {
+    channels = 2u;
+  }
+
+  const uint32_t hp = c->stages_hp;
+  const uint32_t fast = c->stages - hp;
+  const int32_t *coeff_fast = &c->coeff[5u * hp];
+  int32_t *state_fast[2] = {&s_eq_state[0].fast[8u * hp], &s_eq_state[1].fast[8u * hp]};
+#if APP_EQ_USE_CMSIS
+  const arm_biquad_cas_df1_32x64_ins_q31 hp_inst[2] =
+  {
+    {(uint8_t)hp, s_eq_state[0].hp, c->coeff, (uint8_t)APP_EQ_POST_SHIFT},
+    {(uint8_t)hp, s_eq_state[1].hp, c->coeff, (uint8_t)APP_EQ_POST_SHIFT},
+  };
+  const arm_biquad_casd_df1_inst_q31 fast_inst[2] =
+  {
+    {fast, state_fast[0], coeff_fast, (uint8_t)APP_EQ_POST_SHIFT},
+    {fast, state_fast[1], coeff_fast, (uint8_t)APP_EQ_POST_SHIFT},
+  };
+#endif
+  int32_t l[EQ_CHUNK];
+  int32_t r[EQ_CHUNK];
+
+  for (uint32_t i = 0; i < n; i += EQ_CHUNK)
+  {
+    const uint32_t m = ((n - i) < EQ_CHUNK) ? (n - i) : EQ_CHUNK;
+    AppStereoS24 *f = &x[i];
+    for (uint32_t j = 0; j < m; j++)
+    {
+      l[j] = f[j].l * (1 << APP_EQ_HEADROOM_BITS);
+      r[j] = f[j].r * (1 << APP_EQ_HEADROOM_BITS);
+    }
+
+    for (uint32_t ch = 0; ch < channels; ch++)
+    {
+      int32_t *buf = (ch == 0u) ? l : r;
+#if APP_EQ_USE_CMSIS
+      if (hp != 0u)
+      {
+        arm_biquad_cas_df1_32x64_q31(&hp_inst[ch], buf, buf, m);
+      }
+      if (fast != 0u)
+      {
+        arm_biquad_cascade_df1_fast_q31(&fast_inst[ch], buf, buf, m);
+      }
+#else
+      eq_cascade_hp_q31(c->coeff, s_eq_state[ch].hp, hp, buf, m);
+      eq_cascade_q31(coeff_fast, state_fast[ch], fast, buf, m);
+#endif
+    }
+
+    for (uint32_t j = 0; j < m; j++)
+    {
+      f[j].l = eq_out_s24(l[j]);
+      if (channels > 1u)
+      {
+        f[j].r = eq_out_s24(r[j]);
+      }
+    }
+  }
+}
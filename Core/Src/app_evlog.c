@@ -0,0 +1,365 @@
+#include "app_evlog.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "app_audio.h"
+#include "app_cabir.h"
+#include "app_dsp.h"
+#include "app_preset.h"
+#include "app_restart.h"
+#include "stm32g4xx_hal.h"
+
+/* Page layout: a header record, then records up to the first erased one.
+ * A record interrupted by a power loss leaves its first double-word, so
+ * it is skipped rather than written over.
+ */
+#define EVLOG_MAGIC          0x474C5645u  /* "EVLG" */
+#define EVLOG_RECS_PER_PAGE  ((FLASH_PAGE_SIZE / sizeof(AppEvLogRecord)) - 1u)
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t seq;            /* pages in the order they were started */
+  uint16_t boot;           /* boot that started it */
+  uint16_t rsvd;
+  uint32_t seq_inv;        /* ~seq */
+} EvLogHead;
+
+_Static_assert(sizeof(AppEvLogRecord) == 16u, "an event record is two flash double-words");
+_Static_assert(sizeof(EvLogHead) == sizeof(AppEvLogRecord), "the page header takes one record slot");
+_Static_assert((APP_EVLOG_PAGES >= 2u) && (APP_EVLOG_PAGES <= 8u), "the log needs 2..8 pages");
+_Static_assert((APP_EVLOG_FLASH_ADDR + (APP_EVLOG_PAGES * FLASH_PAGE_SIZE)) <= APP_CABIR_FLASH_ADDR,
+               "the event log pages must end below the cab IR");
+
+static const char *const k_type_names[APP_EVLOG_TYPE_COUNT] =
+{
+  "boot", "underrun", "overflow", "i2s_err", "dsp_late", "miss", "shed"
+};
+
+#if APP_EVLOG_ENABLE
+static uint32_t s_seq[APP_EVLOG_PAGES];    /* header seq, 0 = no valid header */
+static uint32_t s_used[APP_EVLOG_PAGES];   /* record slots taken */
+static uint32_t s_page;                    /* page taking appends */
+static uint16_t s_boot;
+static uint8_t s_stopped;                  /* no room left this boot */
+static uint32_t s_lost;
+static uint32_t s_last[APP_EVLOG_TYPE_COUNT];     /* counters at the last poll */
+static uint32_t s_pend[APP_EVLOG_TYPE_COUNT];     /* counted, not yet written */
+static uint32_t s_wrote_ms[APP_EVLOG_TYPE_COUNT];
+static uint8_t s_wrote[APP_EVLOG_TYPE_COUNT];     /* written this boot */
+
+static const EvLogHead *head_at(uint32_t page)
+{
+  return (const EvLogHead *)(uintptr_t)(APP_EVLOG_FLASH_ADDR + (page * FLASH_PAGE_SIZE));
+}
+
+static const AppEvLogRecord *rec_at(uint32_t page, uint32_t index)
+{
+  return (const AppEvLogRecord *)(uintptr_t)(APP_EVLOG_FLASH_ADDR + (page * FLASH_PAGE_SIZE) +
+                                             ((index + 1u) * sizeof(AppEvLogRecord)));
+}
+
+static uint8_t rec_erased(const AppEvLogRecord *r)
+{
+  const uint32_t *w = (const uint32_t *)r;
+  return (w[0] == 0xFFFFFFFFu) && (w[1] == 0xFFFFFFFFu);
+}
+
+static uint8_t flash_erase_page(uint32_t page)
+{
+  FLASH_EraseInitTypeDef erase = {0};
+  uint32_t bad_page = 0;
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Banks = FLASH_BANK_1;
+  erase.Page = ((APP_EVLOG_FLASH_ADDR - FLASH_BASE) / FLASH_PAGE_SIZE) + page;
+  erase.NbPages = 1;
+
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  HAL_StatusTypeDef st = HAL_FLASHEx_Erase(&erase, &bad_page);
+  HAL_FLASH_Lock();
+  return (st == HAL_OK) ? 1u : 0u;
+}
+
+/* One 16-byte slot: both double-words, then a read-back. */
+static uint8_t flash_write16(const void *dst, const void *src)
+{
+  HAL_StatusTypeDef st = HAL_OK;
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  for (uint32_t i = 0; (i < 2u) && (st == HAL_OK); i++)
+  {
+    uint64_t dw;
+    memcpy(&dw, (const uint8_t *)src + (i * 8u), sizeof(dw));
+    st = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, (uint32_t)(uintptr_t)dst + (i * 8u), dw);
+  }
+  HAL_FLASH_Lock();
+  return ((st == HAL_OK) && (memcmp(dst, src, 16u) == 0)) ? 1u : 0u;
+}
+
+/* Erases a page and heads it with the next sequence number. */
+static uint8_t page_start(uint32_t page, uint32_t seq)
+{
+  s_seq[page] = 0;
+  s_used[page] = 0;
+  const EvLogHead h = {EVLOG_MAGIC, seq, s_boot, 0xFFFFu, ~seq};
+  if (!flash_erase_page(page) || !flash_write16(head_at(page), &h))
+  {
+    return 0u;
+  }
+  s_seq[page] = seq;
+  return 1u;
+}
+
+static uint32_t seq_max(void)
+{
+  uint32_t m = 0;
+  for (uint32_t p = 0; p < APP_EVLOG_PAGES; p++)
+  {
+    if (s_seq[p] > m)
+    {
+      m = s_seq[p];
+    }
+  }
+  return m;
+}
+
+/* The page after the current one, started and still empty. */
+static uint8_t next_ready(void)
+{
+  const uint32_t next = (s_page + 1u) % APP_EVLOG_PAGES;
+  return (s_seq[next] == (s_seq[s_page] + 1u)) && (s_used[next] == 0u);
+}
+
+static void append(AppEvLogType type, uint32_t count)
+{
+  if (!s_stopped && (s_used[s_page] >= EVLOG_RECS_PER_PAGE))
+  {
+    if (next_ready())
+    {
+      s_page = (s_page + 1u) % APP_EVLOG_PAGES;
+    }
+    else
+    {
+      s_stopped = 1u;
+    }
+  }
+  if (s_stopped || (s_seq[s_page] == 0u))
+  {
+    s_lost += count;
+    return;
+  }
+
+  AppAudioStats st;
+  AppAudio_GetStats(&st);
+  uint32_t load = (st.period_cycles != 0u)
+                      ? (uint32_t)(((uint64_t)(st.rx_avg_cycles + st.tx_avg_cycles) * 1000u) / st.period_cycles)
+                      : 0u;
+  AppEvLogRecord r;
+  r.ms = HAL_GetTick();
+  r.boot = s_boot;
+  r.type = (uint8_t)type;
+  r.preset = (uint8_t)AppPreset_Current();
+  r.fx_mask = (uint8_t)AppDsp_GetFxMask();
+  r.hclk_mhz = (uint8_t)(SystemCoreClock / 1000000u);
+  r.load = (uint16_t)((load > 0xFFFFu) ? 0xFFFFu : load);
+  r.count = count;
+
+  /* The slot is used either way: a failed write must not be retried in place. */
+  const AppEvLogRecord *dst = rec_at(s_page, s_used[s_page]);
+  s_used[s_page]++;
+  if (!flash_write16(dst, &r))
+  {
+    s_lost += count;
+  }
+}
+
+/* The counters the log follows, by AppEvLogType (BOOT has none). */
+static void counters(uint32_t v[APP_EVLOG_TYPE_COUNT])
+{
+  AppAudioStats st;
+  AppAudio_GetStats(&st);
+  AppDspShedInfo sh;
+  AppDsp_GetShed(&sh);
+  v[APP_EVLOG_BOOT] = 0;
+  v[APP_EVLOG_UNDERRUN] = st.ring_underrun;
+  v[APP_EVLOG_OVERFLOW] = st.ring_overflow;
+  v[APP_EVLOG_I2S_ERROR] = st.i2s_error_count;
+  v[APP_EVLOG_DSP_LATE] = st.dsp_late;
+  v[APP_EVLOG_MISS] = st.deadline_miss;
+  v[APP_EVLOG_SHED] = sh.sheds;
+}
+#endif
+
+void AppEvLog_Init(void)
+{
+#if APP_EVLOG_ENABLE
+  uint32_t boot = 0;
+  for (uint32_t p = 0; p < APP_EVLOG_PAGES; p++)
+  {
+    const EvLogHead *h = head_at(p);
+    s_seq[p] = ((h->magic == EVLOG_MAGIC) && (h->seq_inv == ~h->seq)) ? h->seq : 0u;
+    s_used[p] = 0;
+    if (s_seq[p] == 0u)
+    {
+      continue;
+    }
+    if (h->boot > boot)
+    {
+      boot = h->boot;
+    }
+    while ((s_used[p] < EVLOG_RECS_PER_PAGE) && !rec_erased(rec_at(p, s_used[p])))
+    {
+      const AppEvLogRecord *r = rec_at(p, s_used[p]);
+      if ((r->type == (uint8_t)APP_EVLOG_BOOT) && (r->boot > boot) && (r->boot != 0xFFFFu))
+      {
+        boot = r->boot;
+      }
+      s_used[p]++;
+    }
+    if ((s_seq[p] > s_seq[s_page]) || (s_seq[s_page] == 0u))
+    {
+      s_page = p;
+    }
+  }
+  s_boot = (uint16_t)((boot >= 0xFFFEu) ? 1u : (boot + 1u));
+
+  /* Erases only here, before the audio: a full page moves on, a page half
+   * full gets its successor ready.
+   */
+  if (s_seq[s_page] == 0u)
+  {
+    s_page = 0;
+    (void)page_start(0u, 1u);
+  }
+  else if (s_used[s_page] >= EVLOG_RECS_PER_PAGE)
+  {
+    const uint32_t seq = seq_max() + 1u;
+    s_page = (s_page + 1u) % APP_EVLOG_PAGES;
+    (void)page_start(s_page, seq);
+  }
+  if ((s_used[s_page] >= (EVLOG_RECS_PER_PAGE / 2u)) && !next_ready())
+  {
+    (void)page_start((s_page + 1u) % APP_EVLOG_PAGES, s_seq[s_page] + 1u);
+  }
+
+  AppRestartInfo ri;
+  AppRestart_GetInfo(&ri);
+  append(APP_EVLOG_BOOT, (uint32_t)ri.reset | ((uint32_t)ri.boot << 8));
+  counters(s_last);
+#endif
+}
+
+void AppEvLog_Poll(void)
+{
+#if APP_EVLOG_ENABLE
+  uint32_t v[APP_EVLOG_TYPE_COUNT];
+  counters(v);
+  const uint32_t now = HAL_GetTick();
+  uint8_t wrote = 0;
+  for (uint32_t t = 1u; t < APP_EVLOG_TYPE_COUNT; t++)
+  {
+    /* A counter that went back (audio restarted fresh) counts from 0. */
+    s_pend[t] += (v[t] >= s_last[t]) ? (v[t] - s_last[t]) : v[t];
+    s_last[t] = v[t];
+    /* One record per poll, so the flash stalls stay apart. */
+    if (!wrote && (s_pend[t] != 0u) && (!s_wrote[t] || ((now - s_wrote_ms[t]) >= APP_EVLOG_HOLD_MS)))
+    {
+      append((AppEvLogType)t, s_pend[t]);
+      s_pend[t] = 0;
+      s_wrote[t] = 1u;
+      s_wrote_ms[t] = now;
+      wrote = 1u;
+    }
+  }
+#endif
+}
+
+uint8_t AppEvLog_Get(uint32_t i, AppEvLogRecord *out)
+{
+#if APP_EVLOG_ENABLE
+  /* Pages oldest first. */
+  uint32_t after = 0;
+  for (uint32_t k = 0; k < APP_EVLOG_PAGES; k++)
+  {
+    uint32_t page = APP_EVLOG_PAGES;
+    for (uint32_t p = 0; p < APP_EVLOG_PAGES; p++)
+    {
+      if ((s_seq[p] > after) && ((page == APP_EVLOG_PAGES) || (s_seq[p] < s_seq[page])))
+      {
+        page = p;
+      }
+    }
+    if (page == APP_EVLOG_PAGES)
+    {
+      break;
+    }
+    if (i < s_used[page])
+    {
+      memcpy(out, rec_at(page, i), sizeof(*out));
+      return 1u;
+    }
+    i -= s_used[page];
+    after = s_seq[page];
+  }
+#else
+  (void)i;
+  (void)out;
+#endif
+  return 0u;
+}
+
+void AppEvLog_GetInfo(AppEvLogInfo *out)
+{
+  memset(out, 0, sizeof(*out));
+#if APP_EVLOG_ENABLE
+  for (uint32_t p = 0; p < APP_EVLOG_PAGES; p++)
+  {
+    out->records += s_used[p];
+  }
+  if (!s_stopped)
+  {
+    out->room = EVLOG_RECS_PER_PAGE - s_used[s_page];
+    if (next_ready())
+    {
+      out->room += EVLOG_RECS_PER_PAGE;
+    }
+  }
+  out->lost = s_lost;
+  out->boot = s_boot;
+  out->pages = (uint8_t)APP_EVLOG_PAGES;
+#endif
+}
+
+const char *AppEvLog_TypeName(uint32_t type)
+{
+  return (type < APP_EVLOG_TYPE_COUNT) ? k_type_names[type] : "?";
+}
+
+uint8_t AppEvLog_Clear(void)
+{
+#if APP_EVLOG_ENABLE
+  const uint32_t seq = seq_max() + 1u;
+  uint8_t ok = 1u;
+  for (uint32_t p = 1u; p < APP_EVLOG_PAGES; p++)
+  {
+    s_seq[p] = 0;
+    s_used[p] = 0;
+    if (!flash_erase_page(p))
+    {
+      ok = 0u;
+    }
+  }
+  s_page = 0;
+  if (!page_start(0u, seq))
+  {
+    ok = 0u;
+  }
+  s_stopped = 0;
+  s_lost = 0;
+  return ok;
+#else
+  return 0u;
+#endif
+}
@@ -0,0 +1,167 @@
+#include "app_expr.h"
+
+#include <stddef.h>
+
+#include "app_mem.h"
+#include "app_preset.h"
+
+/* Conversions the tick averages: the last ~2 ms at the ADC's rate. */
+#define EXPR_DMA_WORDS  4u
+
+/* Default ends, a little inside the rails so a worn pot still reaches them. */
+#define EXPR_HEEL_RAW   1024u
+#define EXPR_TOE_RAW    64511u
+
+APP_DMA_BSS static uint16_t s_dma[EXPR_DMA_WORDS];
+static volatile uint8_t s_running;
+static uint32_t s_filt;            /* raw << APP_EXPR_SMOOTH_SHIFT, tick only */
+static volatile uint32_t s_raw;
+static volatile int32_t s_pos_q15;
+static uint32_t s_heel = EXPR_HEEL_RAW;
+static uint32_t s_toe = EXPR_TOE_RAW;
+
+static AppExprTarget s_target;
+static AppDspParamId s_param;
+static int32_t s_lo;
+static int32_t s_hi;
+static uint8_t s_morph_a;
+static uint8_t s_morph_b;
+static int32_t s_last_q15 = -1;    /* position last published, -1 = none */
+
+void AppExpr_Init(ADC_HandleTypeDef *hadc)
+{
+#if APP_EXPR_ENABLE
+  if ((hadc == NULL) ||
+      (HAL_ADCEx_Calibration_Start(hadc, ADC_SINGLE_ENDED) != HAL_OK) ||
+      (HAL_ADC_Start_DMA(hadc, (uint32_t *)s_dma, EXPR_DMA_WORDS) != HAL_OK))
+  {
+    return;
+  }
+  /* The channel's NVIC line stays off: the buffer is only ever read. */
+  s_running = 1u;
+#else
+  (void)hadc;
+#endif
+}
+
+static int32_t expr_scale(uint32_t raw, uint32_t heel, uint32_t toe)
+{
+  const int32_t span = (int32_t)toe - (int32_t)heel;
+  if (span == 0)
+  {
+    return 0;
+  }
+  int32_t q15 = (int32_t)(((int64_t)((int32_t)raw - (int32_t)heel) * 32768) / span);
+  q15 = (q15 < 0) ? 0 : q15;
+  return (q15 > 32768) ? 32768 : q15;
+}
+
+void AppExpr_Sample(void)
+{
+  if (!s_running)
+  {
+    return;
+  }
+  uint32_t sum = 0u;
+  for (uint32_t i = 0; i < EXPR_DMA_WORDS; i++)
+  {
+    sum += s_dma[i];
+  }
+  const uint32_t x = sum / EXPR_DMA_WORDS;
+  if (s_filt == 0u)
+  {
+    s_filt = x << APP_EXPR_SMOOTH_SHIFT;   /* no glide up from 0 at start */
+  }
+  s_filt = s_filt - (s_filt >> APP_EXPR_SMOOTH_SHIFT) + x;
+  const uint32_t raw = s_filt >> APP_EXPR_SMOOTH_SHIFT;
+  s_raw = raw;
+  s_pos_q15 = expr_scale(raw, s_heel, s_toe);
+}
+
+void AppExpr_Poll(void)
+{
+  if (!s_running || (s_target == APP_EXPR_TARGET_OFF))
+  {
+    return;
+  }
+  const int32_t pos = s_pos_q15;
+  const int32_t moved = (s_last_q15 < 0) ? 32768 : ((pos > s_last_q15) ? (pos - s_last_q15) : (s_last_q15 - pos));
+  /* The ends always land, however small the last step. */
+  const uint8_t end = ((pos == 0) || (pos == 32768)) && (pos != s_last_q15);
+  if ((moved < APP_EXPR_DEADBAND_Q15) && !end)
+  {
+    return;
+  }
+  s_last_q15 = pos;
+  if (s_target == APP_EXPR_TARGET_MORPH)
+  {
+    (void)AppPreset_Morph(s_morph_a, s_morph_b, pos);
+  }
+  else
+  {
+    AppDsp_SetParam(s_param, s_lo + (int32_t)(((int64_t)(s_hi - s_lo) * pos) >> 15));
+  }
+}
+
+uint8_t AppExpr_MapParam(AppDspParamId id, int32_t lo, int32_t hi)
+{
+  if (id >= APP_DSP_PARAM_COUNT)
+  {
+    return 0u;
+  }
+  s_param = id;
+  s_lo = lo;
+  s_hi = hi;
+  s_last_q15 = -1;
+  s_target = APP_EXPR_TARGET_PARAM;
+  return 1u;
+}
+
+uint8_t AppExpr_MapMorph(uint32_t a, uint32_t b)
+{
+  if (!APP_PRESET_MORPH_ENABLE || !AppPreset_IsStored(a) || !AppPreset_IsStored(b))
+  {
+    return 0u;
+  }
+  s_morph_a = (uint8_t)a;
+  s_morph_b = (uint8_t)b;
+  s_last_q15 = -1;
+  s_target = APP_EXPR_TARGET_MORPH;
+  return 1u;
+}
+
+void AppExpr_Off(void)
+{
+  s_target = APP_EXPR_TARGET_OFF;
+}
+
+void AppExpr_Calibrate(uint8_t toe)
+{
+  if (toe)
+  {
+    s_toe = s_raw;
+  }
+  else
+  {
+    s_heel = s_raw;
+  }
+  s_last_q15 = -1;
+}
+
+void AppExpr_Get(AppExprInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->raw = s_raw;
+  out->pos_q15 = s_pos_q15;
+  out->heel = s_heel;
+  out->toe = s_toe;
+  out->target = s_target;
+  out->param = s_param;
+  out->lo = s_lo;
+  out->hi = s_hi;
+  out->morph_a = s_morph_a;
+  out->morph_b = s_morph_b;
+}
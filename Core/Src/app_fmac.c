@@ -0,0 +1,112 @@
+#include "app_fmac.h"
+
+#include <string.h>
+
+/*
+ * FMAC local memory (256 x 16 bit) layout: X1 at 0, coefficients after it,
+ * Y after those. X1 holds the P-sample history plus the samples written
+ * ahead of the computation, Y the Q-sample history plus the outputs not yet
+ * read; APP_FMAC_AHEAD plus one spare covers both.
+ */
+#define FMAC_TAPS_MAX     (2u * APP_FMAC_ORDER_MAX + 1u)   /* interleaved, order 3 */
+#define FMAC_X1_SIZE      (FMAC_TAPS_MAX + APP_FMAC_AHEAD + 1u)
+#define FMAC_Y_SIZE       (FMAC_TAPS_MAX + APP_FMAC_AHEAD + 1u)
+#define FMAC_COEFF_BASE   FMAC_X1_SIZE
+#define FMAC_Y_BASE       (FMAC_COEFF_BASE + 2u * FMAC_TAPS_MAX)
+
+static FMAC_HandleTypeDef *s_fmac = NULL;
+
+/* Q28 -> q1.15 with the R = 1 gain taken out. */
+static int16_t coeff_q15(int32_t c_q28)
+{
+  int32_t v = (c_q28 + (1 << 13)) >> 14;
+  if (v > 32767)
+  {
+    v = 32767;
+  }
+  else if (v < -32768)
+  {
+    v = -32768;
+  }
+  return (int16_t)v;
+}
+
+void AppFmac_Init(FMAC_HandleTypeDef *hfmac)
+{
+  s_fmac = hfmac;
+}
+
+void AppFmac_Stop(void)
+{
+  if (s_fmac != NULL)
+  {
+    (void)HAL_FMAC_FilterStop(s_fmac);
+  }
+}
+
+uint8_t AppFmac_IirStart(const int32_t *b_q28, const int32_t *a_q28, uint32_t order, uint32_t channels)
+{
+  if ((s_fmac == NULL) || (b_q28 == NULL) || (a_q28 == NULL) || (order == 0u) ||
+      (order > APP_FMAC_ORDER_MAX) || (channels == 0u) || (channels > 2u))
+  {
+    return 0;
+  }
+
+  /* Taps spaced by 'channels': the zeros in between skip the other channel. */
+  const uint32_t p = order * channels + 1u;
+  const uint32_t q = order * channels;
+  int16_t coeff_b[FMAC_TAPS_MAX];
+  int16_t coeff_a[FMAC_TAPS_MAX];
+  int16_t zeros[FMAC_TAPS_MAX];
+  memset(coeff_b, 0, sizeof(coeff_b));
+  memset(coeff_a, 0, sizeof(coeff_a));
+  memset(zeros, 0, sizeof(zeros));
+  for (uint32_t k = 0; k <= order; k++)
+  {
+    coeff_b[k * channels] = coeff_q15(b_q28[k]);
+  }
+  for (uint32_t k = 1; k <= order; k++)
+  {
+    /* FMAC adds the feedback terms. */
+    coeff_a[k * channels - 1u] = coeff_q15(-a_q28[k - 1u]);
+  }
+
+  (void)HAL_FMAC_FilterStop(s_fmac);
+
+  FMAC_FilterConfigTypeDef cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.InputBaseAddress = 0u;
+  cfg.InputBufferSize = (uint8_t)FMAC_X1_SIZE;
+  cfg.InputThreshold = FMAC_THRESHOLD_1;
+  cfg.CoeffBaseAddress = (uint8_t)FMAC_COEFF_BASE;
+  cfg.CoeffBufferSize = (uint8_t)(p + q);
+  cfg.OutputBaseAddress = (uint8_t)FMAC_Y_BASE;
+  cfg.OutputBufferSize = (uint8_t)FMAC_Y_SIZE;
+  cfg.OutputThreshold = FMAC_THRESHOLD_1;
+  cfg.pCoeffA = coeff_a;
+  cfg.CoeffASize = (uint8_t)q;
+  cfg.pCoeffB = coeff_b;
+  cfg.CoeffBSize = (uint8_t)p;
+  cfg.InputAccess = FMAC_BUFFER_ACCESS_POLLING;
+  cfg.OutputAccess = FMAC_BUFFER_ACCESS_POLLING;
+  cfg.Clip = FMAC_CLIP_ENABLED;
+  cfg.Filter = FMAC_FUNC_IIR_DIRECT_FORM_1;
+  cfg.P = (uint8_t)p;
+  cfg.Q = (uint8_t)q;
+  cfg.R = 1u;
+  if (HAL_FMAC_FilterConfig(s_fmac, &cfg) != HAL_OK)
+  {
+    return 0;
+  }
+
+  /* Zero history: x[n-1..n-P+1] and y[n-1..n-Q], so the first sample
+   * written produces the first output.
+   */
+  if (HAL_FMAC_FilterPreload(s_fmac, zeros, (uint8_t)(p - 1u), zeros, (uint8_t)q) != HAL_OK)
+  {
+    return 0;
+  }
+
+  /* No output buffer: the audio code reads RDATA itself. */
+  return (HAL_FMAC_FilterStart(s_fmac, NULL, NULL) == HAL_OK) ? 1u : 0u;
+}
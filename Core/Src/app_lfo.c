@@ -0,0 +1,76 @@
+#include "app_lfo.h"
+
+#include <stddef.h>
+
+#include "app_tables.h"
+
+/*
+ * LFO service.
+ * - CORDIC: SINE function, q1.15 in and out, both arguments (angle, modulus)
+ *   in one WDATA write and both results (sine, cosine) in one RDATA read.
+ *   Reading before the result is ready stalls the bus instead of polling a
+ *   flag (zero-overhead mode). 4 cycles of 4 iterations is full q1.15
+ *   precision.
+ * - Only the audio path calls AppLfo_Block(), so the unit needs no locking.
+ */
+
+#if APP_LFO_USE_CORDIC
+static uint8_t s_cordic_ready = 0;
+
+void AppLfo_Init(CORDIC_HandleTypeDef *hcordic)
+{
+  CORDIC_ConfigTypeDef cfg;
+  cfg.Function = CORDIC_FUNCTION_SINE;
+  cfg.Scale = CORDIC_SCALE_0;
+  cfg.InSize = CORDIC_INSIZE_16BITS;
+  cfg.OutSize = CORDIC_OUTSIZE_16BITS;
+  cfg.NbWrite = CORDIC_NBWRITE_1;
+  cfg.NbRead = CORDIC_NBREAD_1;
+  cfg.Precision = CORDIC_PRECISION_4CYCLES;
+  s_cordic_ready = ((hcordic != NULL) && (HAL_CORDIC_Configure(hcordic, &cfg) == HAL_OK)) ? 1u : 0u;
+}
+#endif
+
+void AppLfo_SinCos(uint32_t phase, int32_t *sin_q15, int32_t *cos_q15)
+{
+#if APP_LFO_USE_CORDIC
+  if (s_cordic_ready)
+  {
+    /* Angle q1.15 in units of pi: the top half of the Q32 turn. */
+    CORDIC->WDATA = (0x7FFFu << 16) | (phase >> 16);
+    const uint32_t r = CORDIC->RDATA;
+    *sin_q15 = (int16_t)(r & 0xFFFFu);
+    *cos_q15 = (int16_t)(r >> 16);
+    return;
+  }
+#endif
+  *sin_q15 = AppTab_Sin(phase);
+  *cos_q15 = AppTab_Sin(phase + 0x40000000u);
+}
+
+void AppLfo_Reset(AppLfo *lfo, uint32_t rate_mhz, uint32_t fs_hz, uint32_t phase)
+{
+  lfo->phase = phase;
+  AppLfo_SetRate(lfo, rate_mhz, fs_hz);
+  AppLfo_SinCos(phase, &lfo->sin_q15, &lfo->cos_q15);
+}
+
+void AppLfo_SetRate(AppLfo *lfo, uint32_t rate_mhz, uint32_t fs_hz)
+{
+  lfo->inc = (fs_hz != 0u) ? (uint32_t)((((uint64_t)rate_mhz << 32) / 1000u) / fs_hz) : 0u;
+}
+
+void AppLfo_Block(AppLfo *lfo, uint32_t n, AppLfoSeg *seg)
+{
+  int32_t s1;
+  int32_t c1;
+  lfo->phase += lfo->inc * n;
+  AppLfo_SinCos(lfo->phase, &s1, &c1);
+
+  seg->sin_q31 = lfo->sin_q15 * 65536;
+  seg->cos_q31 = lfo->cos_q15 * 65536;
+  seg->dsin_q31 = (n != 0u) ? (int32_t)(((int64_t)(s1 - lfo->sin_q15) * 65536) / (int64_t)n) : 0;
+  seg->dcos_q31 = (n != 0u) ? (int32_t)(((int64_t)(c1 - lfo->cos_q15) * 65536) / (int64_t)n) : 0;
+  lfo->sin_q15 = s1;
+  lfo->cos_q15 = c1;
+}
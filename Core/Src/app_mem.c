@@ -0,0 +1,169 @@
+#include "app_mem.h"
+
+#include <stddef.h>
+
+#include "app_audio.h"
+#include "app_ble.h"
+#include "app_cabir.h"
+#include "app_capture.h"
+#include "app_cdc.h"
+#include "app_dsp.h"
+#include "app_selftest.h"
+#include "app_serial.h"
+#include "app_spectrum.h"
+#include "app_telem.h"
+#include "app_trace.h"
+#include "app_tuner.h"
+#include "app_uac.h"
+#include "stm32g4xx_hal.h"
+
+/*
+ * RAM usage telemetry.
+ * - The stack is the STACK area of startup_stm32g431xx.s (Stack_Size), the
+ *   heap the HEAP area; armlink provides their bounds as section symbols.
+ * - Region use comes from the load regions of the image: RW_IRAM1 for the
+ *   default target (no scatter file, IRAM 0x20000000-0x20007DFF in the
+ *   target dialog); RW_IRAM1 (SRAM1), RW_IRAM2 (SRAM2) and RW_CCMRAM with
+ *   stm32g431_ccm.sct. Neither reaches the retained block above them
+ *   (APP_MEM_RETAIN_ADDR).
+ * - Past the ZI limit of a RAM region nothing is placed (stack and heap are
+ *   ZI sections inside one), so the tail up to the region end is free for
+ *   AppMem_ClaimFree(), which takes the larger one.
+ * - Painting stops MEM_PAINT_MARGIN bytes below the caller's SP so the
+ *   paint loop never overwrites its own frame. Words below are only ever
+ *   compared, never trusted: a frame that stores the pattern itself reads
+ *   back as unused, which under-reports by at most that frame.
+ */
+
+#define MEM_PAINT_WORD    0xC5C5C5C5u
+#define MEM_PAINT_MARGIN  64u
+
+#define MEM_RAM_BASE      0x20000000u
+#if APP_USE_CCM
+#define MEM_RAM_SIZE      0x5800u   /* RW_IRAM1 + RW_IRAM2 in stm32g431_ccm.sct */
+#define MEM_RAM1_SIZE     0x4000u
+#define MEM_RAM2_BASE     0x20004000u
+#define MEM_CCM_BASE      0x10000000u
+#define MEM_CCM_SIZE      0x2600u   /* RW_CCMRAM, the retained block above */
+#else
+#define MEM_RAM_SIZE      0x7E00u   /* SRAM1 + SRAM2 + CCM alias at 0x20005800 */
+#define MEM_RAM1_SIZE     MEM_RAM_SIZE
+#endif
+
+/* The profile's static RAM (app_profile.h): every module's share, the
+ * statics outside them, the stack and the heap. Each module asserts its
+ * own buffers against its share.
+ */
+#define MEM_SHARES_BYTES  (APP_AUDIO_RAM_BYTES + APP_DSP_RAM_BYTES + APP_SERIAL_RAM_BYTES + APP_BLE_RAM_BYTES + \
+                           APP_CDC_RAM_BYTES + APP_UAC_RAM_BYTES + APP_CABIR_RAM_BYTES + APP_CAPTURE_RAM_BYTES + \
+                           APP_SPECTRUM_RAM_BYTES + APP_TUNER_RAM_BYTES + APP_TRACE_RAM_BYTES + \
+                           APP_TELEM_RAM_BYTES + APP_SELFTEST_RAM_BYTES)
+
+_Static_assert(APP_PROFILE_RAM_BYTES == (APP_MEM_RETAIN_ADDR - MEM_RAM_BASE),
+               "APP_PROFILE_RAM_BYTES must end at the retained block");
+_Static_assert((MEM_SHARES_BYTES + APP_PROFILE_RAM_OTHER_BYTES + APP_PROFILE_STACK_BYTES + APP_PROFILE_HEAP_BYTES) <=
+               APP_PROFILE_RAM_BYTES, "the profile's static RAM outgrew the part (app_profile.h)");
+
+#if defined(__ARMCC_VERSION)
+extern uint32_t STACK$$Base[];
+extern uint32_t STACK$$Limit[];
+extern uint32_t HEAP$$Base[];
+extern uint32_t HEAP$$Limit[];
+extern uint8_t Image$$RW_IRAM1$$ZI$$Limit[];
+#if APP_USE_CCM
+extern uint8_t Image$$RW_IRAM2$$ZI$$Limit[];
+extern uint8_t Image$$RW_CCMRAM$$ZI$$Limit[];
+#endif
+
+#define MEM_STACK_BASE    ((uint32_t *)STACK$$Base)
+#define MEM_STACK_LIMIT   ((uint32_t *)STACK$$Limit)
+#define MEM_HEAP_BYTES    ((uint32_t)((uintptr_t)HEAP$$Limit - (uintptr_t)HEAP$$Base))
+#define MEM_RAM_END       ((uintptr_t)Image$$RW_IRAM1$$ZI$$Limit)
+#if APP_USE_CCM
+#define MEM_RAM2_END      ((uintptr_t)Image$$RW_IRAM2$$ZI$$Limit)
+#endif
+
+/* Bytes past a region's ZI limit taken by AppMem_ClaimFree(). */
+static uint32_t s_claimed = 0;
+#endif
+
+void AppMem_PaintStack(void)
+{
+#if defined(__ARMCC_VERSION)
+  uint32_t *p = MEM_STACK_BASE;
+  uint32_t *end = (uint32_t *)((__get_MSP() - MEM_PAINT_MARGIN) & ~3u);
+  while (p < end)
+  {
+    *p++ = MEM_PAINT_WORD;
+  }
+#endif
+}
+
+void *AppMem_ClaimFree(uint32_t *bytes)
+{
+  *bytes = 0;
+#if defined(__ARMCC_VERSION)
+  if (s_claimed == 0u)
+  {
+    uintptr_t limit = MEM_RAM_END;
+    uintptr_t end = MEM_RAM_BASE + MEM_RAM1_SIZE;
+#if APP_USE_CCM
+    if ((MEM_RAM_BASE + MEM_RAM_SIZE - MEM_RAM2_END) > (end - limit))
+    {
+      limit = MEM_RAM2_END;
+      end = MEM_RAM_BASE + MEM_RAM_SIZE;
+    }
+#endif
+    const uintptr_t base = (limit + 3u) & ~(uintptr_t)3u;
+    if (base < end)
+    {
+      s_claimed = (uint32_t)(end - limit);
+      *bytes = (uint32_t)(end - base);
+      return (void *)base;
+    }
+  }
+#endif
+  return NULL;
+}
+
+void AppMem_GetStats(AppMemStats *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+
+  out->ram_size = MEM_RAM_SIZE;
+#if APP_USE_CCM
+  out->ccm_size = MEM_CCM_SIZE;
+#else
+  out->ccm_size = 0;
+#endif
+  out->ccm_used = 0;
+
+#if defined(__ARMCC_VERSION)
+  /* Stack and heap are ZI sections: counted in whichever region .ANY put
+   * them (RW_IRAM1 without a scatter file). CCM use includes the code
+   * copied to .ccmram_text.
+   */
+  out->ram_used = (uint32_t)(MEM_RAM_END - MEM_RAM_BASE) + s_claimed;
+#if APP_USE_CCM
+  out->ram_used += (uint32_t)(MEM_RAM2_END - MEM_RAM2_BASE);
+  out->ccm_used = (uint32_t)((uintptr_t)Image$$RW_CCMRAM$$ZI$$Limit - MEM_CCM_BASE);
+#endif
+  out->heap_size = MEM_HEAP_BYTES;
+  out->stack_size = (uint32_t)((uintptr_t)MEM_STACK_LIMIT - (uintptr_t)MEM_STACK_BASE);
+
+  const uint32_t *p = MEM_STACK_BASE;
+  while ((p < MEM_STACK_LIMIT) && (*p == MEM_PAINT_WORD))
+  {
+    p++;
+  }
+  out->stack_peak = (uint32_t)((uintptr_t)MEM_STACK_LIMIT - (uintptr_t)p);
+#else
+  out->ram_used = 0;
+  out->heap_size = 0;
+  out->stack_size = 0;
+  out->stack_peak = 0;
+#endif
+}
@@ -0,0 +1,156 @@
+#include "app_meter.h"
+
+#include <string.h>
+
+#include "app_mem.h"
+#include "stm32g4xx_hal.h"
+
+/*
+ * Level metering.
+ * - The audio ISR folds each block into s_acc: a max for the peaks and the
+ *   gains, a 64-bit sum of squares for the RMS (one SMLAL per sample).
+ * - AppMeter_Take() swaps the window out with IRQs masked for the copy only;
+ *   the square roots run afterwards in the main loop.
+ */
+
+typedef struct
+{
+  uint32_t peak[APP_METER_TAP_COUNT];
+  uint64_t sum_sq[APP_METER_TAP_COUNT];
+  uint32_t samples[APP_METER_TAP_COUNT];
+  int32_t comp_gain_q15;
+  int32_t limiter_gain_q15;
+  uint32_t frames;
+} MeterAcc;
+
+APP_CCM_BSS static MeterAcc s_acc;
+static volatile uint8_t s_on;
+
+static void acc_reset(MeterAcc *a)
+{
+  memset(a, 0, sizeof(*a));
+  a->comp_gain_q15 = 32768;
+  a->limiter_gain_q15 = 32768;
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+  uint64_t r = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+  while (bit > v)
+  {
+    bit >>= 2;
+  }
+  while (bit != 0u)
+  {
+    if (v >= r + bit)
+    {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    }
+    else
+    {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)r;
+}
+
+void AppMeter_Reset(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  acc_reset(&s_acc);
+  if (!primask)
+  {
+    __enable_irq();
+  }
+}
+
+void AppMeter_Enable(uint8_t on)
+{
+  AppMeter_Reset();
+  s_on = on;
+}
+
+APP_CCM_CODE void AppMeter_Block(AppMeterTap tap, const AppStereoS24 *x, uint32_t n, uint8_t mono)
+{
+  if (!s_on)
+  {
+    return;
+  }
+  uint32_t peak = s_acc.peak[tap];
+  uint64_t sum = s_acc.sum_sq[tap];
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const int32_t l = x[i].l;
+    const uint32_t al = (uint32_t)((l < 0) ? -l : l);
+    if (al > peak) peak = al;
+    sum += (uint64_t)((int64_t)l * l);
+    if (!mono)
+    {
+      const int32_t r = x[i].r;
+      const uint32_t ar = (uint32_t)((r < 0) ? -r : r);
+      if (ar > peak) peak = ar;
+      sum += (uint64_t)((int64_t)r * r);
+    }
+  }
+  s_acc.peak[tap] = peak;
+  s_acc.sum_sq[tap] = sum;
+  s_acc.samples[tap] += mono ? n : (2u * n);
+}
+
+APP_CCM_CODE void AppMeter_Level(AppMeterTap tap, uint32_t peak, uint64_t sum_sq, uint32_t samples)
+{
+  if (!s_on)
+  {
+    return;
+  }
+  if (peak > s_acc.peak[tap]) s_acc.peak[tap] = peak;
+  s_acc.sum_sq[tap] += sum_sq;
+  s_acc.samples[tap] += samples;
+}
+
+uint8_t AppMeter_IsOn(void)
+{
+  return s_on;
+}
+
+APP_CCM_CODE void AppMeter_Gains(int32_t comp_gain_q15, int32_t limiter_gain_q15, uint32_t n)
+{
+  if (!s_on)
+  {
+    return;
+  }
+  if (comp_gain_q15 < s_acc.comp_gain_q15) s_acc.comp_gain_q15 = comp_gain_q15;
+  if (limiter_gain_q15 < s_acc.limiter_gain_q15) s_acc.limiter_gain_q15 = limiter_gain_q15;
+  s_acc.frames += n;
+}
+
+uint8_t AppMeter_Take(AppMeterLevels *out)
+{
+  MeterAcc a;
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  a = s_acc;
+  acc_reset(&s_acc);
+  if (!primask)
+  {
+    __enable_irq();
+  }
+
+  if ((out == NULL) || (a.frames == 0u))
+  {
+    return 0;
+  }
+  for (uint32_t t = 0; t < APP_METER_TAP_COUNT; t++)
+  {
+    out->peak[t] = a.peak[t];
+    out->rms[t] = (a.samples[t] != 0u) ? isqrt64(a.sum_sq[t] / a.samples[t]) : 0u;
+  }
+  out->comp_gain_q15 = a.comp_gain_q15;
+  out->limiter_gain_q15 = a.limiter_gain_q15;
+  out->frames = a.frames;
+  return 1;
+}
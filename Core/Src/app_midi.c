@@ -0,0 +1,429 @@
+#include "app_midi.h"
+
+#include <stddef.h>
+
+#include "app_mem.h"
+#include "app_preset.h"
+
+/* 82 ms of a saturated line: a power of two, indexed by the byte count.
+ * Like the SysEx rings below, a token one in a build without MIDI.
+ */
+#define MIDI_RX_SIZE        (APP_MIDI_ENABLE ? 256u : 16u)
+#define MIDI_CLOCKS_PER_BEAT 24u
+#define MIDI_CC_FREE        0xFFu
+
+#define MIDI_CLOCK          0xF8u
+#define MIDI_START          0xFAu
+#define MIDI_CONTINUE       0xFBu
+#define MIDI_STOP           0xFCu
+#define MIDI_NOTE_OFF       0x80u
+#define MIDI_CONTROL        0xB0u
+#define MIDI_PROGRAM        0xC0u
+#define MIDI_PRESSURE       0xD0u
+#define MIDI_SYSEX          0xF0u
+#define MIDI_EOX            0xF7u
+
+/* SysEx COM link: both rings powers of two, indexed by running counts. */
+#define MIDI_COM_RX_SIZE    (APP_MIDI_ENABLE ? 128u : 16u)
+#define MIDI_COM_TX_SIZE    (APP_MIDI_ENABLE ? 256u : 16u)
+
+typedef enum
+{
+  SYSEX_NONE = 0,
+  SYSEX_ID,                /* after F0, the manufacturer ID is next */
+  SYSEX_COM,               /* ours: data bytes are COM text */
+  SYSEX_SKIP               /* someone else's */
+} SysexState;
+
+APP_DMA_BSS static uint8_t s_rx[MIDI_RX_SIZE];
+static UART_HandleTypeDef *s_uart;
+static volatile uint8_t s_running_dma;
+
+/* Tick side. */
+static uint32_t s_tick_pos;              /* DMA write index at the last tick */
+static volatile uint32_t s_rx_total;     /* bytes received, as of the last tick */
+static uint8_t s_clock_phase;            /* clocks into the current beat */
+static volatile uint32_t s_beats;
+static volatile uint32_t s_beat_ms;      /* tick of the latest beat's first clock */
+static volatile uint8_t s_transport;
+
+/* Main loop side. */
+static uint32_t s_parsed;                /* bytes parsed, same count as s_rx_total */
+static uint32_t s_beats_handled;
+static uint8_t s_status;                 /* running status, 0 = none */
+static uint8_t s_data[2];
+static uint8_t s_ndata;
+static uint8_t s_channel = APP_MIDI_CHANNEL;
+static uint32_t s_lost;
+static uint32_t s_errors;
+static uint32_t s_programs;
+static uint32_t s_controls;
+static SysexState s_sysex;
+
+/* SysEx COM link (main loop). TX drains from the tick. */
+static uint8_t s_com_rx[MIDI_COM_RX_SIZE];
+static uint32_t s_com_rx_w;
+static uint32_t s_com_rx_r;
+static uint8_t s_com_tx[MIDI_COM_TX_SIZE];
+static volatile uint32_t s_com_tx_w;
+static volatile uint32_t s_com_tx_r;
+static uint8_t s_com_tx_open;            /* F0 ID sent, F7 not yet */
+
+/* General MIDI's reverb and chorus sends at boot. */
+static const AppMidiCcMap k_cc_boot[] = {
+  {91u, APP_DSP_PARAM_REVERB_MIX_Q15, 0, 32768},
+  {93u, APP_DSP_PARAM_CHORUS_MIX_Q15, 0, 32768},
+};
+#define MIDI_CC_BOOT (sizeof(k_cc_boot) / sizeof(k_cc_boot[0]))
+
+static AppMidiCcMap s_cc_map[APP_MIDI_CC_MAPS];
+
+void AppMidi_Init(UART_HandleTypeDef *huart)
+{
+  for (uint32_t i = 0; i < APP_MIDI_CC_MAPS; i++)
+  {
+    if (i < MIDI_CC_BOOT)
+    {
+      s_cc_map[i] = k_cc_boot[i];
+    }
+    else
+    {
+      s_cc_map[i].cc = MIDI_CC_FREE;
+    }
+  }
+#if APP_MIDI_ENABLE
+  if ((huart == NULL) || (HAL_UART_Receive_DMA(huart, s_rx, (uint16_t)MIDI_RX_SIZE) != HAL_OK))
+  {
+    return;
+  }
+  /* USART1 and its DMA channel keep their NVIC lines off: the buffer is
+   * only ever read, and a line error does not stop the DMA (DDRE = 0).
+   */
+  s_uart = huart;
+  s_running_dma = 1u;
+#else
+  (void)huart;
+#endif
+}
+
+void AppMidi_Sample(void)
+{
+  if (!s_running_dma)
+  {
+    return;
+  }
+  const uint32_t pos = (MIDI_RX_SIZE - __HAL_DMA_GET_COUNTER(s_uart->hdmarx)) % MIDI_RX_SIZE;
+  uint32_t i = s_tick_pos;
+  s_tick_pos = pos;
+  s_rx_total += (pos - i) % MIDI_RX_SIZE;
+  for (; i != pos; i = (i + 1u) % MIDI_RX_SIZE)
+  {
+    switch (s_rx[i])
+    {
+      case MIDI_CLOCK:
+        if (s_clock_phase == 0u)
+        {
+          s_beat_ms = HAL_GetTick();
+          s_beats++;
+        }
+        s_clock_phase = (uint8_t)((s_clock_phase + 1u) % MIDI_CLOCKS_PER_BEAT);
+        break;
+      case MIDI_START:
+        s_clock_phase = 0u;   /* the next clock is the downbeat */
+        s_transport = 1u;
+        break;
+      case MIDI_CONTINUE:
+        s_transport = 1u;
+        break;
+      case MIDI_STOP:
+        s_transport = 0u;
+        break;
+      default:
+        break;
+    }
+  }
+
+  /* MIDI out: the SysEx replies, as far as the TX FIFO takes them (8
+   * bytes, more than the line moves in a ms).
+   */
+  while ((s_com_tx_r != s_com_tx_w) && __HAL_UART_GET_FLAG(s_uart, UART_FLAG_TXFNF))
+  {
+    s_uart->Instance->TDR = s_com_tx[s_com_tx_r % MIDI_COM_TX_SIZE];
+    s_com_tx_r++;
+  }
+}
+
+static void midi_control(uint8_t cc, uint8_t value)
+{
+  for (uint32_t i = 0; i < APP_MIDI_CC_MAPS; i++)
+  {
+    const AppMidiCcMap *m = &s_cc_map[i];
+    if (m->cc == cc)
+    {
+      AppDsp_SetParam(m->param, m->lo + (int32_t)(((int64_t)(m->hi - m->lo) * value) / 127));
+      s_controls++;
+      return;
+    }
+  }
+}
+
+static void midi_message(void)
+{
+  const uint8_t channel = (uint8_t)((s_status & 0x0Fu) + 1u);
+  if ((s_channel != 0u) && (channel != s_channel))
+  {
+    return;
+  }
+  switch (s_status & 0xF0u)
+  {
+    case MIDI_PROGRAM:
+      if ((s_data[0] < APP_PRESET_COUNT) && AppPreset_IsStored(s_data[0]) && AppPreset_Load(s_data[0]))
+      {
+        s_programs++;
+      }
+      break;
+    case MIDI_CONTROL:
+      midi_control(s_data[0], s_data[1]);
+      break;
+    default:
+      break;
+  }
+}
+
+static void midi_byte(uint8_t b)
+{
+  if (b >= MIDI_CLOCK)
+  {
+    return;              /* real-time: the tick has seen it */
+  }
+  if (b >= MIDI_NOTE_OFF)
+  {
+    /* Any status byte ends a SysEx, F7 or not; ours ends a line too. */
+    if ((s_sysex == SYSEX_COM) && (s_com_rx_w != s_com_rx_r) &&
+        (s_com_rx[(s_com_rx_w - 1u) % MIDI_COM_RX_SIZE] != '\n') &&
+        ((s_com_rx_w - s_com_rx_r) < MIDI_COM_RX_SIZE))
+    {
+      s_com_rx[s_com_rx_w % MIDI_COM_RX_SIZE] = '\n';
+      s_com_rx_w++;
+    }
+    s_sysex = (b == MIDI_SYSEX) ? SYSEX_ID : SYSEX_NONE;
+  }
+  if (b >= 0xF0u)
+  {
+    s_status = 0u;       /* SysEx and system common end running status */
+    return;
+  }
+  if (b >= MIDI_NOTE_OFF)
+  {
+    s_status = b;
+    s_ndata = 0u;
+    return;
+  }
+  if (s_sysex != SYSEX_NONE)
+  {
+    if (s_sysex == SYSEX_ID)
+    {
+      s_sysex = (b == APP_MIDI_SYSEX_ID) ? SYSEX_COM : SYSEX_SKIP;
+    }
+    else if ((s_sysex == SYSEX_COM) && ((s_com_rx_w - s_com_rx_r) < MIDI_COM_RX_SIZE))
+    {
+      s_com_rx[s_com_rx_w % MIDI_COM_RX_SIZE] = b;
+      s_com_rx_w++;
+    }
+    return;
+  }
+  if (s_status == 0u)
+  {
+    return;
+  }
+  s_data[s_ndata++] = b;
+  const uint8_t need = (((s_status & 0xF0u) == MIDI_PROGRAM) || ((s_status & 0xF0u) == MIDI_PRESSURE)) ? 1u : 2u;
+  if (s_ndata == need)
+  {
+    s_ndata = 0u;
+    midi_message();
+  }
+}
+
+void AppMidi_Poll(void)
+{
+  if (!s_running_dma)
+  {
+    return;
+  }
+  const uint32_t total = s_rx_total;
+  if ((total - s_parsed) > MIDI_RX_SIZE)
+  {
+    /* The DMA lapped the parser: skip to the newer half and resync on the
+     * next status byte.
+     */
+    const uint32_t keep = total - (MIDI_RX_SIZE / 2u);
+    s_lost += keep - s_parsed;
+    s_parsed = keep;
+    s_status = 0u;
+  }
+  while (s_parsed != total)
+  {
+    midi_byte(s_rx[s_parsed % MIDI_RX_SIZE]);
+    s_parsed++;
+  }
+
+  const uint32_t beats = s_beats;
+  if (beats != s_beats_handled)
+  {
+    s_beats_handled = beats;
+    (void)AppDsp_TapTempo(s_beat_ms);
+  }
+
+  if (__HAL_UART_GET_FLAG(s_uart, UART_FLAG_FE) || __HAL_UART_GET_FLAG(s_uart, UART_FLAG_NE))
+  {
+    __HAL_UART_CLEAR_FLAG(s_uart, UART_CLEAR_FEF | UART_CLEAR_NEF);
+    s_errors++;
+  }
+}
+
+uint8_t AppMidi_SetChannel(uint8_t channel)
+{
+  if (channel > 16u)
+  {
+    return 0u;
+  }
+  s_channel = channel;
+  return 1u;
+}
+
+uint8_t AppMidi_MapCc(uint8_t cc, AppDspParamId id, int32_t lo, int32_t hi)
+{
+  if ((cc > 127u) || (id >= APP_DSP_PARAM_COUNT))
+  {
+    return 0u;
+  }
+  AppMidiCcMap *slot = NULL;
+  for (uint32_t i = 0; i < APP_MIDI_CC_MAPS; i++)
+  {
+    if (s_cc_map[i].cc == cc)
+    {
+      slot = &s_cc_map[i];
+      break;
+    }
+    if ((slot == NULL) && (s_cc_map[i].cc == MIDI_CC_FREE))
+    {
+      slot = &s_cc_map[i];
+    }
+  }
+  if (slot == NULL)
+  {
+    return 0u;
+  }
+  slot->param = id;
+  slot->lo = lo;
+  slot->hi = hi;
+  slot->cc = cc;
+  return 1u;
+}
+
+void AppMidi_UnmapCc(uint8_t cc)
+{
+  for (uint32_t i = 0; i < APP_MIDI_CC_MAPS; i++)
+  {
+    if (s_cc_map[i].cc == cc)
+    {
+      s_cc_map[i].cc = MIDI_CC_FREE;
+    }
+  }
+}
+
+uint8_t AppMidi_GetCcMap(uint32_t i, AppMidiCcMap *out)
+{
+  if ((i >= APP_MIDI_CC_MAPS) || (s_cc_map[i].cc == MIDI_CC_FREE) || (out == NULL))
+  {
+    return 0u;
+  }
+  *out = s_cc_map[i];
+  return 1u;
+}
+
+uint32_t AppMidi_ComRead(uint8_t *dst, uint32_t max)
+{
+  uint32_t n = 0;
+  for (; (n < max) && (s_com_rx_r != s_com_rx_w); n++)
+  {
+    dst[n] = s_com_rx[s_com_rx_r % MIDI_COM_RX_SIZE];
+    s_com_rx_r++;
+  }
+  return n;
+}
+
+uint8_t AppMidi_ComPending(void)
+{
+  return (s_com_rx_r != s_com_rx_w) ? 1u : 0u;
+}
+
+uint32_t AppMidi_ComTxFree(void)
+{
+  /* Less the F0 ID ... F7 around a line. */
+  const uint32_t room = MIDI_COM_TX_SIZE - (s_com_tx_w - s_com_tx_r);
+  return (room > 3u) ? (room - 3u) : 0u;
+}
+
+static void com_tx_put(uint8_t b)
+{
+  s_com_tx[s_com_tx_w % MIDI_COM_TX_SIZE] = b;
+  s_com_tx_w++;
+}
+
+uint8_t AppMidi_ComWrite(const uint8_t *p, uint32_t n)
+{
+  /* Text only: a byte with the top bit set (a binary frame) does not fit
+   * in SysEx data, and is discarded like everything without a MIDI out.
+   */
+  uint32_t lines = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (p[i] >= 0x80u)
+    {
+      return 1u;
+    }
+    lines += (p[i] == '\n') ? 1u : 0u;
+  }
+  if (!s_running_dma)
+  {
+    return 1u;
+  }
+  if ((n + (3u * (lines + 1u))) > (MIDI_COM_TX_SIZE - (s_com_tx_w - s_com_tx_r)))
+  {
+    return 0u;
+  }
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (!s_com_tx_open)
+    {
+      com_tx_put(MIDI_SYSEX);
+      com_tx_put(APP_MIDI_SYSEX_ID);
+      s_com_tx_open = 1u;
+    }
+    com_tx_put(p[i]);
+    if (p[i] == '\n')
+    {
+      com_tx_put(MIDI_EOX);
+      s_com_tx_open = 0u;
+    }
+  }
+  return 1u;
+}
+
+void AppMidi_Get(AppMidiInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->channel = s_channel;
+  out->bytes = s_rx_total;
+  out->lost = s_lost;
+  out->errors = s_errors;
+  out->programs = s_programs;
+  out->controls = s_controls;
+  out->beats = s_beats;
+  out->running = s_transport;
+}
@@ -0,0 +1,225 @@
+#include "app_power.h"
+
+#include <stddef.h>
+
+#include "app_audio.h"
+#include "app_com.h"
+#include "app_dsp.h"
+#include "stm32g4xx_hal.h"
+
+/* TIM2 is the HAL time base: 1 MHz counter, update (tick) every 1000. A
+ * sleep never spans a tick, since the update wakes it, so the counter
+ * difference modulo one period is the sleep time.
+ */
+#define POWER_TICK_US 1000u
+
+static uint32_t s_sleep_us = 0;
+static uint32_t s_window_t0_ms = 0;
+
+static AppPowerClockMode s_mode = APP_POWER_CLOCK_AUTO;
+static uint8_t s_step = 0;           /* index in k_steps */
+static uint32_t s_load = 0;
+static uint32_t s_steps_up = 0;
+static uint32_t s_steps_down = 0;
+static uint32_t s_step_time_ms[2] = {0, 0};
+
+#if APP_POWER_GOVERNOR
+/* Clock steps: AHB prescaler and flash wait states (RM0440, range 1 boost:
+ * 2 WS up to 102 MHz, 4 WS up to 170 MHz).
+ */
+typedef struct
+{
+  uint32_t hpre;
+  uint32_t latency;
+  uint32_t div;
+} PowerStep;
+
+static const PowerStep k_steps[] =
+{
+  {RCC_SYSCLK_DIV1, FLASH_LATENCY_4, 1u},
+  {RCC_SYSCLK_DIV2, FLASH_LATENCY_2, 2u},
+};
+
+/* Time after a step before its load is read: the RX/TX averages are
+ * smoothed over 16 blocks and still hold cycles of the old clock.
+ */
+#define POWER_SETTLE_MS 100u
+
+static uint32_t s_step_ms = 0;       /* last step change */
+static uint32_t s_calm_ms = 0;       /* start of the low-load run at full clock */
+static uint32_t s_seen_ms = 0;
+static uint32_t s_chain = 0;         /* effect mask and bypass tier last poll */
+static uint32_t s_trouble = 0;       /* misses, late blocks and sheds last poll */
+#endif
+
+void AppPower_Idle(void)
+{
+#if APP_POWER_SLEEP
+  /* Interrupts masked across the check: an event that lands after it still
+   * ends the WFI, and its handler runs right after the unmask.
+   */
+  __disable_irq();
+  if (!AppCom_Pending())
+  {
+    const uint32_t t0 = TIM2->CNT;
+    __DSB();
+    __WFI();
+    const uint32_t t1 = TIM2->CNT;
+    s_sleep_us += ((t1 + POWER_TICK_US) - t0) % POWER_TICK_US;
+  }
+  __enable_irq();
+#endif
+}
+
+uint32_t AppPower_TakeIdle(uint32_t *window_ms)
+{
+  const uint32_t now = HAL_GetTick();
+  const uint32_t ms = now - s_window_t0_ms;
+  const uint32_t sleep_us = s_sleep_us;
+  s_window_t0_ms = now;
+  s_sleep_us = 0;
+
+  if (window_ms != NULL)
+  {
+    *window_ms = ms;
+  }
+  if (ms == 0u)
+  {
+    return 0u;
+  }
+  /* us asleep per ms is already 0.1 %. */
+  const uint32_t permille = sleep_us / ms;
+  return (permille > 1000u) ? 1000u : permille;
+}
+
+#if APP_POWER_GOVERNOR
+/* Moves HCLK to a step. Wait states go up before the clock does and down
+ * after it; TIM2 (APB1 / 1, so HCLK) gets its 1 us prescaler, which the
+ * timer loads at the next tick.
+ */
+static void clock_step(uint8_t step)
+{
+  const PowerStep *st = &k_steps[step];
+  const uint32_t hclk = HAL_RCC_GetSysClockFreq() / st->div;
+
+  __disable_irq();
+  if (st->latency > __HAL_FLASH_GET_LATENCY())
+  {
+    __HAL_FLASH_SET_LATENCY(st->latency);
+    while (__HAL_FLASH_GET_LATENCY() != st->latency)
+    {
+    }
+  }
+  MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, st->hpre);
+  while ((RCC->CFGR & RCC_CFGR_HPRE) != st->hpre)
+  {
+  }
+  __HAL_FLASH_SET_LATENCY(st->latency);
+  TIM2->PSC = (hclk / 1000000u) - 1u;
+  SystemCoreClock = hclk;
+  __enable_irq();
+
+  AppAudio_ClockChanged();
+  if (step > s_step)
+  {
+    s_steps_down++;
+  }
+  else if (step < s_step)
+  {
+    s_steps_up++;
+  }
+  s_step = step;
+  s_step_ms = HAL_GetTick();
+  s_calm_ms = s_step_ms;
+}
+#endif
+
+void AppPower_Poll(void)
+{
+#if APP_POWER_GOVERNOR
+  const uint32_t now = HAL_GetTick();
+  s_step_time_ms[s_step] += now - s_seen_ms;
+  s_seen_ms = now;
+
+  AppAudioStats st;
+  AppAudio_GetStats(&st);
+  AppDspShedInfo sh;
+  AppDsp_GetShed(&sh);
+  s_load = (st.period_cycles != 0u)
+               ? (uint32_t)(((uint64_t)(st.rx_avg_cycles + st.tx_avg_cycles) * 1000u) / st.period_cycles)
+               : 0u;
+  const uint32_t chain = (uint32_t)AppDsp_GetFxMask() | ((uint32_t)AppDsp_GetBypass() << 8);
+  const uint32_t trouble = st.deadline_miss + st.dsp_late + sh.sheds;
+  const uint8_t changed = (chain != s_chain) || (trouble != s_trouble);
+  const uint8_t settled = (now - s_step_ms) >= POWER_SETTLE_MS;
+  s_chain = chain;
+  s_trouble = trouble;
+
+  uint8_t want = s_step;
+  if (s_mode != APP_POWER_CLOCK_AUTO)
+  {
+    want = (s_mode == APP_POWER_CLOCK_HALF) ? 1u : 0u;
+  }
+  else if (s_step != 0u)
+  {
+    if (changed || (settled && (s_load > APP_POWER_UP_PERMILLE)))
+    {
+      want = 0u;
+    }
+  }
+  else if (changed || !settled || (s_load >= APP_POWER_DOWN_PERMILLE))
+  {
+    s_calm_ms = now;
+  }
+  else if ((now - s_calm_ms) >= APP_POWER_HOLD_MS)
+  {
+    want = 1u;
+  }
+  if (want != s_step)
+  {
+    clock_step(want);
+  }
+#endif
+}
+
+void AppPower_Boost(void)
+{
+#if APP_POWER_GOVERNOR
+  if (s_mode != APP_POWER_CLOCK_AUTO)
+  {
+    return;
+  }
+  if (s_step != 0u)
+  {
+    clock_step(0u);
+  }
+  s_calm_ms = HAL_GetTick();
+#endif
+}
+
+uint8_t AppPower_SetClockMode(AppPowerClockMode mode)
+{
+#if APP_POWER_GOVERNOR
+  if ((uint32_t)mode > (uint32_t)APP_POWER_CLOCK_HALF)
+  {
+    return 0u;
+  }
+  s_mode = mode;
+  AppPower_Poll();
+  return 1u;
+#else
+  (void)mode;
+  return 0u;
+#endif
+}
+
+void AppPower_GetClock(AppPowerClockInfo *out)
+{
+  out->mode = s_mode;
+  out->hclk_hz = SystemCoreClock;
+  out->load_permille = s_load;
+  out->steps_up = s_steps_up;
+  out->steps_down = s_steps_down;
+  out->full_ms = s_step_time_ms[0];
+  out->half_ms = s_step_time_ms[1];
+}
@@ -0,0 +1,910 @@
+#include "app_preset.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "app_dsp.h"
+#include "app_power.h"
+#include "app_restart.h"
+#include "app_shaper.h"
+#include "app_trace.h"
+#include "stm32g4xx_hal.h"
+
+/*
+ * Log-structured preset bank.
+ * - Each record is a whole number of flash double-words (the G4 programming
+ *   unit) and is written once; a slot is updated by appending a newer copy.
+ * - s_latest[] points at the newest valid record of each slot, found by the
+ *   scan in AppPreset_Init() (sequence numbers compare with wrap-around).
+ * - page_advance() erases a page that holds no live record and copies the
+ *   live ones into it before the new record goes in, so at least
+ *   PRESET_RECS_PER_PAGE - APP_PRESET_COUNT saves fit between two erases.
+ * - A record is a flash header (slot, size, sequence number) followed by
+ *   the preset file (app_preset.h), the same bytes COM transfers and the
+ *   app keeps; its CRC covers the file. The file header and the section
+ *   headers are fixed for a build (s_head), so a record is checked by one
+ *   compare and read at fixed offsets; the sections exist for the app,
+ *   which reads records of other builds.
+ * - A parameter whose range spans at most 65536 values is stored in 16 bits
+ *   as its offset from the minimum, the few wider ones in 32 (in
+ *   AppDspParamId order within each group). That keeps the APP_PRESET_COUNT
+ *   + 1 records a page must hold inside 2 KB as parameters are added.
+ *   delay_time_ms (no static max) stays far under 65536.
+ * - Last-slot marks fill the tail of a page the records leave over, one
+ *   double-word each: the slot (and its complement) and a sequence number
+ *   of their own. The newest valid one anywhere in the bank wins. A mark
+ *   goes into the first erased tail entry of any page. With all of them
+ *   used it waits for the next page_advance() (a save) instead of taking
+ *   one itself: that is a page erase while audio runs. A page_advance()
+ *   that erases the newest mark writes it again into the fresh page.
+ */
+
+#define PRESET_MAGIC  0x5052u  /* "PR" */
+
+#define PRESET_SECTION_FX      1u
+#define PRESET_SECTION_PARAMS  2u
+#define PRESET_SECTION_TAPS    3u
+
+#define PRESET_PARAM_WIDE(id, name, min, max, unit, smoothed, clamp)  (((max) - (min)) > 65535)
+#define PRESET_WIDE_ONE(id, name, min, max, unit, smoothed, clamp) \
+  + (PRESET_PARAM_WIDE(id, name, min, max, unit, smoothed, clamp) ? 1u : 0u)
+
+#define PRESET_WIDE_COUNT     (0u APP_DSP_PARAM_LIST(PRESET_WIDE_ONE))
+#define PRESET_NARROW_COUNT   ((uint32_t)APP_DSP_PARAM_COUNT - PRESET_WIDE_COUNT)
+/* Zero-padded so the record stays a whole number of double-words: with
+ * every other part a multiple of 8 bytes, the params section (its header
+ * included) is padded to 4 mod 8 to match the CRC.
+ */
+#define PRESET_PARAM_BYTES    ((((4u * PRESET_WIDE_COUNT) + (2u * PRESET_NARROW_COUNT) + 4u + 7u) & ~7u) - 4u)
+#define PRESET_NARROW_SLOTS   ((PRESET_PARAM_BYTES - (4u * PRESET_WIDE_COUNT)) / 2u)
+
+static const int32_t k_param_min[APP_DSP_PARAM_COUNT] = {
+#define PRESET_PARAM_MIN(id, name, min, max, unit, smoothed, clamp) [APP_DSP_PARAM_##id] = (min),
+  APP_DSP_PARAM_LIST(PRESET_PARAM_MIN)
+#undef PRESET_PARAM_MIN
+};
+
+static const uint8_t k_param_wide[APP_DSP_PARAM_COUNT] = {
+#define PRESET_PARAM_WIDE_ENTRY(id, name, min, max, unit, smoothed, clamp) \
+  [APP_DSP_PARAM_##id] = PRESET_PARAM_WIDE(id, name, min, max, unit, smoothed, clamp) ? 1u : 0u,
+  APP_DSP_PARAM_LIST(PRESET_PARAM_WIDE_ENTRY)
+#undef PRESET_PARAM_WIDE_ENTRY
+};
+
+typedef struct
+{
+  uint8_t type;            /* PRESET_SECTION_* */
+  uint8_t info;            /* params: wide count; taps: tap count */
+  uint16_t bytes;          /* payload after this header */
+} PresetSection;
+
+typedef struct
+{
+  uint16_t magic;
+  uint8_t slot;
+  uint8_t size_dw;         /* record size in double-words (layout check) */
+  uint32_t seq;
+  /* The preset file from here on. */
+  uint16_t file_magic;     /* APP_PRESET_FILE_MAGIC */
+  uint8_t version;         /* APP_PRESET_FILE_VERSION */
+  uint8_t sections;
+  uint32_t param_hash;     /* AppPreset_ParamHash() */
+  PresetSection fx_head;
+  uint32_t fx_mask;
+  PresetSection param_head;
+  int32_t wide[PRESET_WIDE_COUNT];
+  uint16_t narrow[PRESET_NARROW_SLOTS];   /* value - min */
+  PresetSection tap_head;
+  AppDspDelayTap tap[APP_DSP_DELAY_TAPS_MAX];
+  uint32_t crc;            /* CRC-32 of the file up to here */
+} PresetRecord;
+
+_Static_assert((sizeof(PresetRecord) % 8u) == 0u, "PresetRecord must be a whole number of double-words");
+_Static_assert(sizeof(AppDspDelayTap) == 8u, "the preset image has 8-byte taps");
+_Static_assert((offsetof(PresetRecord, tap_head) - offsetof(PresetRecord, wide)) == PRESET_PARAM_BYTES,
+               "the params section must have no padding");
+
+/* The transfer image is the file: the record after its flash header. */
+#define PRESET_IMAGE_OFS      offsetof(PresetRecord, file_magic)
+#define PRESET_IMAGE_BYTES    (sizeof(PresetRecord) - PRESET_IMAGE_OFS)
+
+#define PRESET_RECS_PER_PAGE  (FLASH_PAGE_SIZE / sizeof(PresetRecord))
+
+_Static_assert(PRESET_IMAGE_BYTES <= APP_RESTART_IMAGE_MAX, "the preset image must fit the retained RAM (APP_RESTART_IMAGE_MAX)");
+
+_Static_assert(PRESET_RECS_PER_PAGE > APP_PRESET_COUNT, "a flash page must hold every live preset plus one");
+
+#define PRESET_MARK_MAGIC  0x4C53u  /* "LS" */
+
+typedef struct
+{
+  uint16_t magic;
+  uint8_t slot;
+  uint8_t slot_inv;        /* ~slot */
+  uint32_t seq;
+} PresetMark;
+
+#define PRESET_MARKS_OFS       (PRESET_RECS_PER_PAGE * sizeof(PresetRecord))
+#define PRESET_MARKS_PER_PAGE  ((FLASH_PAGE_SIZE - PRESET_MARKS_OFS) / sizeof(PresetMark))
+
+_Static_assert(sizeof(PresetMark) == 8u, "a last-slot mark is one flash double-word");
+_Static_assert(PRESET_MARKS_PER_PAGE >= 2u, "the page tail must hold a few last-slot marks");
+
+#if APP_PRESET_MORPH_ENABLE
+/* Preset morph (AppPreset_Morph()): the two records, validated when they
+ * were picked up, and the position last published.
+ */
+typedef struct
+{
+  const PresetRecord *ra;
+  const PresetRecord *rb;
+  uint8_t a;
+  uint8_t b;
+  uint8_t active;          /* a morph has been published */
+  uint8_t gliding;
+  int32_t pos_q15;
+  int32_t from_q15;
+  int32_t to_q15;
+  uint32_t t0_ms;
+  uint32_t glide_ms;
+} PresetMorph;
+#endif
+
+static const PresetRecord *s_latest[APP_PRESET_COUNT];
+static PresetRecord s_head;  /* file and section headers of this build */
+static uint32_t s_seq;    /* last sequence number written */
+static uint32_t s_page;   /* page taking appends */
+static uint32_t s_next;   /* next record index in s_page */
+static uint32_t s_current;  /* slot last loaded */
+static PresetRecord s_stage;  /* upload being staged (image part only) */
+#if APP_PRESET_MORPH_ENABLE
+static uint8_t s_param_steps[APP_DSP_PARAM_COUNT];  /* enum / count: no in-between */
+static PresetMorph s_morph;
+#endif
+static uint32_t s_mark_page;      /* page of the newest last-slot mark, APP_PRESET_PAGES = none */
+static uint32_t s_mark_seq;
+static uint32_t s_mark_slot;      /* slot it names, 0 without one */
+static uint8_t s_mark_full;       /* every tail entry used: marks wait for a page_advance() */
+static uint32_t s_current_t0;     /* when s_current last changed */
+
+static const PresetRecord *rec_at(uint32_t page, uint32_t index)
+{
+  return (const PresetRecord *)(APP_PRESET_FLASH_ADDR + (page * FLASH_PAGE_SIZE) + (index * sizeof(PresetRecord)));
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++)
+  {
+    crc ^= p[i];
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return crc;
+}
+
+static uint32_t rec_crc(const PresetRecord *r)
+{
+  return ~crc32_update(0xFFFFFFFFu, (const uint8_t *)r + PRESET_IMAGE_OFS,
+                       (uint32_t)(offsetof(PresetRecord, crc) - PRESET_IMAGE_OFS));
+}
+
+/* Copies this build's file and section headers into r. */
+static void rec_head(PresetRecord *r)
+{
+  r->file_magic = s_head.file_magic;
+  r->version = s_head.version;
+  r->sections = s_head.sections;
+  r->param_hash = s_head.param_hash;
+  r->fx_head = s_head.fx_head;
+  r->param_head = s_head.param_head;
+  r->tap_head = s_head.tap_head;
+}
+
+/* The headers are what this build writes: same version, same param table. */
+static uint8_t rec_head_ok(const PresetRecord *r)
+{
+  return (memcmp(&r->file_magic, &s_head.file_magic, 8u) == 0) &&
+         (memcmp(&r->fx_head, &s_head.fx_head, sizeof(PresetSection)) == 0) &&
+         (memcmp(&r->param_head, &s_head.param_head, sizeof(PresetSection)) == 0) &&
+         (memcmp(&r->tap_head, &s_head.tap_head, sizeof(PresetSection)) == 0);
+}
+
+static uint8_t rec_erased(const PresetRecord *r)
+{
+  const uint32_t *w = (const uint32_t *)r;
+  for (uint32_t i = 0; i < (sizeof(PresetRecord) / 4u); i++)
+  {
+    if (w[i] != 0xFFFFFFFFu)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static uint8_t rec_valid(const PresetRecord *r)
+{
+  return (r->magic == PRESET_MAGIC) &&
+         (r->size_dw == (sizeof(PresetRecord) / 8u)) &&
+         (r->slot < APP_PRESET_COUNT) &&
+         rec_head_ok(r) &&
+         (r->crc == rec_crc(r));
+}
+
+static uint8_t rec_page(const PresetRecord *r)
+{
+  return (uint8_t)(((uintptr_t)r - APP_PRESET_FLASH_ADDR) / FLASH_PAGE_SIZE);
+}
+
+static uint8_t flash_erase_page(uint32_t page)
+{
+  FLASH_EraseInitTypeDef erase = {0};
+  uint32_t bad_page = 0;
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Banks = FLASH_BANK_1;
+  erase.Page = ((APP_PRESET_FLASH_ADDR - FLASH_BASE) / FLASH_PAGE_SIZE) + page;
+  erase.NbPages = 1;
+
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  HAL_StatusTypeDef st = HAL_FLASHEx_Erase(&erase, &bad_page);
+  HAL_FLASH_Lock();
+  return (st == HAL_OK) ? 1u : 0u;
+}
+
+/* Appends r (seq and crc are filled in here) at s_page/s_next. */
+static const PresetRecord *rec_append(PresetRecord *r)
+{
+  const PresetRecord *dst = rec_at(s_page, s_next);
+  r->seq = s_seq + 1u;
+  r->crc = rec_crc(r);
+
+  HAL_StatusTypeDef st = HAL_OK;
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  for (uint32_t i = 0; (i < (sizeof(PresetRecord) / 8u)) && (st == HAL_OK); i++)
+  {
+    uint64_t dw;
+    memcpy(&dw, (const uint8_t *)r + (i * 8u), sizeof(dw));
+    st = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, (uint32_t)(uintptr_t)dst + (i * 8u), dw);
+  }
+  HAL_FLASH_Lock();
+
+  /* The slot is used either way: a failed write must not be retried in place. */
+  s_next++;
+  if ((st != HAL_OK) || (memcmp(dst, r, sizeof(*r)) != 0))
+  {
+    return NULL;
+  }
+  s_seq = r->seq;
+  return dst;
+}
+
+static const PresetMark *mark_at(uint32_t page, uint32_t index)
+{
+  return (const PresetMark *)(APP_PRESET_FLASH_ADDR + (page * FLASH_PAGE_SIZE) + PRESET_MARKS_OFS +
+                              (index * sizeof(PresetMark)));
+}
+
+static uint8_t mark_valid(const PresetMark *m)
+{
+  return (m->magic == PRESET_MARK_MAGIC) && (m->slot < APP_PRESET_COUNT) && ((uint32_t)(m->slot ^ m->slot_inv) == 0xFFu);
+}
+
+static uint8_t mark_erased(const PresetMark *m)
+{
+  const uint32_t *w = (const uint32_t *)m;
+  return (w[0] == 0xFFFFFFFFu) && (w[1] == 0xFFFFFFFFu);
+}
+
+/* Programs a mark for 'slot' into the first erased tail entry of 'page'.
+ * Returns 0 when the tail is full or the write failed (the entry is used
+ * either way).
+ */
+static uint8_t mark_program(uint32_t page, uint32_t slot)
+{
+  uint32_t i = 0;
+  while ((i < PRESET_MARKS_PER_PAGE) && !mark_erased(mark_at(page, i)))
+  {
+    i++;
+  }
+  if (i >= PRESET_MARKS_PER_PAGE)
+  {
+    return 0;
+  }
+  PresetMark m;
+  m.magic = PRESET_MARK_MAGIC;
+  m.slot = (uint8_t)slot;
+  m.slot_inv = (uint8_t)~slot;
+  m.seq = s_mark_seq + 1u;
+  uint64_t dw;
+  memcpy(&dw, &m, sizeof(dw));
+
+  const PresetMark *dst = mark_at(page, i);
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  HAL_StatusTypeDef st = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, (uint32_t)(uintptr_t)dst, dw);
+  HAL_FLASH_Lock();
+  if ((st != HAL_OK) || (memcmp(dst, &m, sizeof(m)) != 0))
+  {
+    return 0;
+  }
+  s_mark_page = page;
+  s_mark_seq = m.seq;
+  s_mark_slot = slot;
+  return 1;
+}
+
+/* Moves appends to a freshly erased page and copies the live records of
+ * every slot except 'skip' into it.
+ */
+static uint8_t page_advance(uint32_t skip)
+{
+  /* Prefer the next page in the ring that holds no live record; one always
+   * exists unless an interrupted compaction left them spread out.
+   */
+  uint32_t page = (s_page + 1u) % APP_PRESET_PAGES;
+  for (uint32_t k = 1u; k < APP_PRESET_PAGES; k++)
+  {
+    uint32_t cand = (s_page + k) % APP_PRESET_PAGES;
+    uint8_t live = 0;
+    for (uint32_t slot = 0; slot < APP_PRESET_COUNT; slot++)
+    {
+      if ((s_latest[slot] != NULL) && (rec_page(s_latest[slot]) == cand))
+      {
+        live = 1;
+      }
+    }
+    if (!live)
+    {
+      page = cand;
+      break;
+    }
+  }
+
+  if (!flash_erase_page(page))
+  {
+    return 0;
+  }
+  s_page = page;
+  s_next = 0;
+  s_mark_full = 0;
+  if (s_mark_page == page)
+  {
+    (void)mark_program(page, s_mark_slot);
+  }
+
+  for (uint32_t slot = 0; slot < APP_PRESET_COUNT; slot++)
+  {
+    if ((s_latest[slot] != NULL) && (rec_page(s_latest[slot]) == page))
+    {
+      s_latest[slot] = NULL; /* erased above */
+    }
+    if ((slot == skip) || (s_latest[slot] == NULL))
+    {
+      continue;
+    }
+    PresetRecord copy = *s_latest[slot];
+    const PresetRecord *dst = rec_append(&copy);
+    if (dst == NULL)
+    {
+      return 0;
+    }
+    s_latest[slot] = dst;
+  }
+  return 1;
+}
+
+static uint32_t fnv1a(uint32_t h, const uint8_t *p, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    h = (h ^ p[i]) * 16777619u;
+  }
+  return h;
+}
+
+/* The file header of this build; the params' kind (enum / count) too. */
+static void head_init(void)
+{
+  uint32_t h = 2166136261u;
+  for (uint32_t id = 0; id < APP_DSP_PARAM_COUNT; id++)
+  {
+    AppDspParamDesc d;
+    if (!AppDsp_GetParamDesc((AppDspParamId)id, &d))
+    {
+      continue;
+    }
+#if APP_PRESET_MORPH_ENABLE
+    s_param_steps[id] = ((strcmp(d.unit, "enum") == 0) || (strcmp(d.unit, "x") == 0)) ? 1u : 0u;
+#endif
+    const uint8_t min_width[5] = {(uint8_t)d.min, (uint8_t)((uint32_t)d.min >> 8), (uint8_t)((uint32_t)d.min >> 16),
+                                  (uint8_t)((uint32_t)d.min >> 24), k_param_wide[id] ? 4u : 2u};
+    h = fnv1a(h, (const uint8_t *)d.name, (uint32_t)strlen(d.name) + 1u);
+    h = fnv1a(h, min_width, sizeof(min_width));
+  }
+
+  memset(&s_head, 0, sizeof(s_head));
+  s_head.file_magic = APP_PRESET_FILE_MAGIC;
+  s_head.version = APP_PRESET_FILE_VERSION;
+  s_head.sections = 3u;
+  s_head.param_hash = h;
+  s_head.fx_head.type = PRESET_SECTION_FX;
+  s_head.fx_head.bytes = (uint16_t)sizeof(s_head.fx_mask);
+  s_head.param_head.type = PRESET_SECTION_PARAMS;
+  s_head.param_head.info = (uint8_t)PRESET_WIDE_COUNT;
+  s_head.param_head.bytes = (uint16_t)PRESET_PARAM_BYTES;
+  s_head.tap_head.type = PRESET_SECTION_TAPS;
+  s_head.tap_head.info = (uint8_t)APP_DSP_DELAY_TAPS_MAX;
+  s_head.tap_head.bytes = (uint16_t)sizeof(s_head.tap);
+}
+
+void AppPreset_Init(void)
+{
+  uint8_t any = 0;
+  s_seq = 0;
+  s_page = 0;
+  s_mark_page = APP_PRESET_PAGES;
+  s_mark_seq = 0;
+  s_mark_slot = 0;
+  s_mark_full = 0;
+  memset(s_latest, 0, sizeof(s_latest));
+  head_init();
+
+  for (uint32_t page = 0; page < APP_PRESET_PAGES; page++)
+  {
+    for (uint32_t i = 0; i < PRESET_RECS_PER_PAGE; i++)
+    {
+      const PresetRecord *r = rec_at(page, i);
+      if (rec_erased(r) || !rec_valid(r))
+      {
+        continue;
+      }
+      const PresetRecord *cur = s_latest[r->slot];
+      if ((cur == NULL) || ((int32_t)(r->seq - cur->seq) > 0))
+      {
+        s_latest[r->slot] = r;
+      }
+      if (!any || ((int32_t)(r->seq - s_seq) > 0))
+      {
+        s_seq = r->seq;
+        s_page = page;
+        any = 1;
+      }
+    }
+    for (uint32_t i = 0; i < PRESET_MARKS_PER_PAGE; i++)
+    {
+      const PresetMark *m = mark_at(page, i);
+      if (mark_valid(m) && ((s_mark_page == APP_PRESET_PAGES) || ((int32_t)(m->seq - s_mark_seq) > 0)))
+      {
+        s_mark_page = page;
+        s_mark_seq = m->seq;
+        s_mark_slot = m->slot;
+      }
+    }
+  }
+
+  /* Append after the last used record of the newest page. */
+  s_next = PRESET_RECS_PER_PAGE;
+  while ((s_next > 0u) && rec_erased(rec_at(s_page, s_next - 1u)))
+  {
+    s_next--;
+  }
+}
+
+/* Fills in the header of r (its image part is set) and appends it as the
+ * newest copy of 'slot'.
+ */
+static uint8_t rec_store(uint32_t slot, PresetRecord *r)
+{
+  r->magic = PRESET_MAGIC;
+  r->slot = (uint8_t)slot;
+  r->size_dw = (uint8_t)(sizeof(PresetRecord) / 8u);
+
+  if ((s_next >= PRESET_RECS_PER_PAGE) || !rec_erased(rec_at(s_page, s_next)))
+  {
+    if (!page_advance(slot))
+    {
+      return 0;
+    }
+  }
+  const PresetRecord *dst = rec_append(r);
+  if (dst == NULL)
+  {
+    return 0;
+  }
+  s_latest[slot] = dst;
+  return 1;
+}
+
+/* The image part of r from the current DSP settings. */
+static void rec_capture(PresetRecord *r)
+{
+  memset(r, 0, sizeof(*r));
+  rec_head(r);
+  r->fx_mask = AppDsp_GetFxMask();
+  uint32_t w = 0;
+  uint32_t k = 0;
+  for (uint32_t id = 0; id < APP_DSP_PARAM_COUNT; id++)
+  {
+    const int32_t v = AppDsp_GetParam((AppDspParamId)id);
+    if (k_param_wide[id])
+    {
+      r->wide[w++] = v;
+    }
+    else
+    {
+      r->narrow[k++] = (uint16_t)(v - k_param_min[id]);
+    }
+  }
+  for (uint32_t t = 0; t < APP_DSP_DELAY_TAPS_MAX; t++)
+  {
+    (void)AppDsp_GetDelayTap(t, &r->tap[t]);
+  }
+}
+
+uint8_t AppPreset_Save(uint32_t slot)
+{
+  if (slot >= APP_PRESET_COUNT)
+  {
+    return 0;
+  }
+
+  PresetRecord r;
+  rec_capture(&r);
+  return rec_store(slot, &r);
+}
+
+uint8_t AppPreset_IsStored(uint32_t slot)
+{
+  return (slot < APP_PRESET_COUNT) && (s_latest[slot] != NULL);
+}
+
+static void current_set(uint32_t slot)
+{
+  if (slot != s_current)
+  {
+    s_current = slot;
+    s_current_t0 = HAL_GetTick();
+  }
+}
+
+/* Publishes a + (b - a) * pos as one batch: continuous parameters in
+ * between, the FX mask, the taps and the enum / count parameters from the
+ * nearer end. a alone (b = a, pos 0) is a plain recall; spill lets its
+ * delay and reverb tails ring out (AppDsp_CommitParamsSpill()).
+ */
+static void rec_apply(const PresetRecord *a, const PresetRecord *b, int32_t pos_q15, uint8_t spill)
+{
+  const PresetRecord *nearer = (pos_q15 < 16384) ? a : b;
+
+  /* The pattern parameter reloads the tap table, so the stored taps go in
+   * after the parameters.
+   */
+  AppDsp_BeginParams();
+  uint32_t w = 0;
+  uint32_t k = 0;
+  for (uint32_t id = 0; id < APP_DSP_PARAM_COUNT; id++)
+  {
+    int32_t va;
+    int32_t vb;
+    if (k_param_wide[id])
+    {
+      va = a->wide[w];
+      vb = b->wide[w];
+      w++;
+    }
+    else
+    {
+      va = k_param_min[id] + (int32_t)a->narrow[k];
+      vb = k_param_min[id] + (int32_t)b->narrow[k];
+      k++;
+    }
+    int32_t v = (pos_q15 < 16384) ? va : vb;
+#if APP_PRESET_MORPH_ENABLE
+    if (!s_param_steps[id])
+    {
+      v = va + (int32_t)(((int64_t)(vb - va) * pos_q15) >> 15);
+    }
+#endif
+    AppDsp_SetParam((AppDspParamId)id, v);
+  }
+  for (uint32_t t = 0; t < APP_DSP_DELAY_TAPS_MAX; t++)
+  {
+    (void)AppDsp_SetDelayTap(t, &nearer->tap[t]);
+  }
+  AppDsp_SetFxMask(nearer->fx_mask);
+  if (spill)
+  {
+    AppDsp_CommitParamsSpill();
+  }
+  else
+  {
+    AppDsp_CommitParams();
+  }
+}
+
+uint8_t AppPreset_Load(uint32_t slot)
+{
+  if (!AppPreset_IsStored(slot) || !rec_valid(s_latest[slot]))
+  {
+    return 0;
+  }
+#if APP_PRESET_MORPH_ENABLE
+  s_morph.gliding = 0u;
+#endif
+  AppPower_Boost();
+  rec_apply(s_latest[slot], s_latest[slot], 0, 1u);
+  current_set(slot);
+  APP_TRACE(APP_TRACE_PRESET, slot);
+  return 1;
+}
+
+#if APP_PRESET_MORPH_ENABLE
+/* Checks a record once, when the morph picks it up (after a save or a page
+ * compaction it is a new record).
+ */
+static const PresetRecord *morph_rec(uint32_t slot, const PresetRecord *held)
+{
+  if (!AppPreset_IsStored(slot))
+  {
+    return NULL;
+  }
+  const PresetRecord *r = s_latest[slot];
+  return ((r == held) || rec_valid(r)) ? r : NULL;
+}
+
+static uint8_t morph_publish(int32_t pos_q15)
+{
+  const PresetRecord *ra = morph_rec(s_morph.a, s_morph.ra);
+  const PresetRecord *rb = morph_rec(s_morph.b, s_morph.rb);
+  if ((ra == NULL) || (rb == NULL))
+  {
+    s_morph.gliding = 0u;
+    return 0;
+  }
+  s_morph.ra = ra;
+  s_morph.rb = rb;
+  if (s_morph.active && (pos_q15 == s_morph.pos_q15))
+  {
+    return 1;
+  }
+  rec_apply(ra, rb, pos_q15, 0u);
+  s_morph.active = 1u;
+  s_morph.pos_q15 = pos_q15;
+  current_set((pos_q15 < 16384) ? s_morph.a : s_morph.b);
+  return 1;
+}
+
+/* Picks up a new pair; the position restarts from a unless it is the
+ * pair already morphing.
+ */
+static uint8_t morph_pair(uint32_t a, uint32_t b)
+{
+  if (!AppPreset_IsStored(a) || !AppPreset_IsStored(b))
+  {
+    return 0;
+  }
+  if (!s_morph.active || (s_morph.a != a) || (s_morph.b != b))
+  {
+    s_morph.a = (uint8_t)a;
+    s_morph.b = (uint8_t)b;
+    s_morph.ra = NULL;
+    s_morph.rb = NULL;
+    s_morph.active = 0u;
+    s_morph.pos_q15 = 0;
+  }
+  return 1;
+}
+
+static int32_t morph_clamp(int32_t pos_q15)
+{
+  return (pos_q15 < 0) ? 0 : ((pos_q15 > 32768) ? 32768 : pos_q15);
+}
+
+uint8_t AppPreset_Morph(uint32_t a, uint32_t b, int32_t pos_q15)
+{
+  if (!morph_pair(a, b))
+  {
+    return 0;
+  }
+  s_morph.gliding = 0u;
+  return morph_publish(morph_clamp(pos_q15));
+}
+
+static void morph_poll(void);
+
+uint8_t AppPreset_MorphGlide(uint32_t a, uint32_t b, int32_t pos_q15, uint32_t ms)
+{
+  if (!morph_pair(a, b))
+  {
+    return 0;
+  }
+  s_morph.from_q15 = s_morph.pos_q15;
+  s_morph.to_q15 = morph_clamp(pos_q15);
+  s_morph.t0_ms = HAL_GetTick();
+  s_morph.glide_ms = ms;
+  s_morph.gliding = 1u;
+  morph_poll();
+  return s_morph.active;
+}
+
+static void morph_poll(void)
+{
+  if (!s_morph.gliding)
+  {
+    return;
+  }
+  const uint32_t t = HAL_GetTick() - s_morph.t0_ms;
+  int32_t pos = s_morph.to_q15;
+  if (t < s_morph.glide_ms)
+  {
+    pos = s_morph.from_q15 + (int32_t)(((int64_t)(s_morph.to_q15 - s_morph.from_q15) * t) / s_morph.glide_ms);
+  }
+  else
+  {
+    s_morph.gliding = 0u;
+  }
+  (void)morph_publish(pos);
+}
+#else
+uint8_t AppPreset_Morph(uint32_t a, uint32_t b, int32_t pos_q15)
+{
+  (void)a;
+  (void)b;
+  (void)pos_q15;
+  return 0u;
+}
+
+uint8_t AppPreset_MorphGlide(uint32_t a, uint32_t b, int32_t pos_q15, uint32_t ms)
+{
+  (void)a;
+  (void)b;
+  (void)pos_q15;
+  (void)ms;
+  return 0u;
+}
+#endif
+
+/* Marks the current slot once it has stayed put for
+ * APP_PRESET_LAST_SETTLE_MS. With every tail entry used the mark waits for
+ * the next save's page_advance() rather than erasing a page under running
+ * audio; until then a power-up comes back on the slot marked before.
+ */
+static void mark_poll(void)
+{
+  if (s_mark_full || (s_current == s_mark_slot) || ((HAL_GetTick() - s_current_t0) < APP_PRESET_LAST_SETTLE_MS))
+  {
+    return;
+  }
+  for (uint32_t k = 0; k < APP_PRESET_PAGES; k++)
+  {
+    if (mark_program((s_page + k) % APP_PRESET_PAGES, s_current))
+    {
+      return;
+    }
+  }
+  s_mark_full = 1;
+}
+
+void AppPreset_Poll(void)
+{
+#if APP_PRESET_MORPH_ENABLE
+  morph_poll();
+#endif
+  mark_poll();
+}
+
+uint32_t AppPreset_LastSlot(void)
+{
+  return s_mark_slot;
+}
+
+void AppPreset_GetMorph(AppPresetMorphInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+#if APP_PRESET_MORPH_ENABLE
+  out->a = s_morph.a;
+  out->b = s_morph.b;
+  out->active = s_morph.active;
+  out->gliding = s_morph.gliding;
+  out->pos_q15 = s_morph.pos_q15;
+  out->to_q15 = s_morph.gliding ? s_morph.to_q15 : s_morph.pos_q15;
+#else
+  memset(out, 0, sizeof(*out));
+#endif
+}
+
+uint32_t AppPreset_Current(void)
+{
+  return s_current;
+}
+
+uint32_t AppPreset_ImageSize(void)
+{
+  return (uint32_t)PRESET_IMAGE_BYTES;
+}
+
+/* The image is copied as bytes: the record fields are little-endian on the
+ * M4 and have no padding from the file header to the CRC.
+ */
+uint8_t AppPreset_ReadImage(uint32_t slot, uint32_t offset, uint8_t *dst, uint32_t n)
+{
+  if (!AppPreset_IsStored(slot) || (offset > PRESET_IMAGE_BYTES) || (n > (PRESET_IMAGE_BYTES - offset)))
+  {
+    return 0;
+  }
+  memcpy(dst, (const uint8_t *)s_latest[slot] + PRESET_IMAGE_OFS + offset, n);
+  return 1;
+}
+
+uint8_t AppPreset_StageImage(uint32_t offset, const uint8_t *src, uint32_t n)
+{
+  if ((offset > PRESET_IMAGE_BYTES) || (n > (PRESET_IMAGE_BYTES - offset)))
+  {
+    return 0;
+  }
+  memcpy((uint8_t *)&s_stage + PRESET_IMAGE_OFS + offset, src, n);
+  return 1;
+}
+
+uint8_t AppPreset_CommitImage(uint32_t slot, uint32_t crc)
+{
+  if (slot >= APP_PRESET_COUNT)
+  {
+    return 0;
+  }
+  if ((s_stage.crc != crc) || (rec_crc(&s_stage) != crc) || !rec_head_ok(&s_stage))
+  {
+    return 0;
+  }
+  PresetRecord r = s_stage;
+  return rec_store(slot, &r);
+}
+
+void AppPreset_CaptureImage(uint8_t *dst)
+{
+  PresetRecord r;
+  rec_capture(&r);
+  r.crc = rec_crc(&r);
+  memcpy(dst, (const uint8_t *)&r + PRESET_IMAGE_OFS, PRESET_IMAGE_BYTES);
+}
+
+uint8_t AppPreset_ApplyImage(const uint8_t *src, uint32_t slot)
+{
+  PresetRecord r;
+  memset(&r, 0, sizeof(r));
+  memcpy((uint8_t *)&r + PRESET_IMAGE_OFS, src, PRESET_IMAGE_BYTES);
+  if (!rec_head_ok(&r) || (r.crc != rec_crc(&r)))
+  {
+    return 0;
+  }
+#if APP_PRESET_MORPH_ENABLE
+  s_morph.gliding = 0u;
+#endif
+  rec_apply(&r, &r, 0, 0u);
+  current_set((slot < APP_PRESET_COUNT) ? slot : 0u);
+  return 1;
+}
+
+uint32_t AppPreset_ParamHash(void)
+{
+  return s_head.param_hash;
+}
+
+static const AppMemItem k_preset_mem[] =
+{
+  APP_MEM_ITEM("preset.stage", s_stage),
+};
+
+uint32_t AppPreset_MemMap(const AppMemItem **items)
+{
+  *items = k_preset_mem;
+  return (uint32_t)(sizeof(k_preset_mem) / sizeof(k_preset_mem[0]));
+}
@@ -0,0 +1,175 @@
+#include "app_prof.h"
+
+#include <string.h>
+
+#include "app_audio.h"
+#include "stm32g4xx_hal.h"
+
+/*
+ * DWT-based cycle profiling.
+ * - AppProf_Init() turns on the cycle counter (needed by LOAD telemetry too).
+ * - With APP_PROF_ENABLE, app_dsp.c records cycles per stage and per full
+ *   chain (keyed by FX mask) for every processed block.
+ *
+ * Records come from the audio ISR, readers run in the main loop; readers and
+ * reset mask IRQs only for the few words they copy.
+ */
+
+#if APP_PROF_ENABLE
+static AppProfStat s_stage[APP_PROF_STAGE_COUNT];
+static AppProfStat s_chain[APP_PROF_MASK_COUNT];
+#endif
+
+static const char *const s_stage_names[APP_PROF_STAGE_COUNT] =
+{
+  "dc_block",
+  "gate",
+  "comp",
+  "color",
+  "wah",
+  "pitch",
+  "distortion",
+  "dist_os2",
+  "dist_os4",
+  "eq",
+  "phaser",
+  "chorus",
+  "delay",
+  "reverb",
+  "loop",
+  "output",
+  "limiter",
+};
+
+#if APP_PROF_ENABLE
+static void stat_reset(AppProfStat *st, uint32_t n)
+{
+  memset(st, 0, n * sizeof(*st));
+  for (uint32_t i = 0; i < n; i++)
+  {
+    st[i].min = 0xFFFFFFFFu;
+  }
+}
+
+static inline void stat_add(AppProfStat *st, uint32_t cycles, uint32_t frames)
+{
+  st->count++;
+  st->last = cycles;
+  st->sum += cycles;
+  st->frames += frames;
+  if (cycles < st->min) st->min = cycles;
+  if (cycles > st->max) st->max = cycles;
+}
+
+static uint8_t stat_copy(const AppProfStat *src, AppProfStat *out)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *out = *src;
+  if (!primask)
+  {
+    __enable_irq();
+  }
+
+  if (out->count == 0u)
+  {
+    out->min = 0u;
+  }
+  return 1u;
+}
+#endif
+
+void AppProf_Init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0u;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  AppProf_Reset();
+}
+
+void AppProf_Reset(void)
+{
+#if APP_PROF_ENABLE
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  stat_reset(s_stage, APP_PROF_STAGE_COUNT);
+  stat_reset(s_chain, APP_PROF_MASK_COUNT);
+  if (!primask)
+  {
+    __enable_irq();
+  }
+#endif
+}
+
+void AppProf_RecordStage(AppProfStage stage, uint32_t cycles, uint32_t frames)
+{
+#if APP_PROF_ENABLE
+  if ((uint32_t)stage < (uint32_t)APP_PROF_STAGE_COUNT)
+  {
+    stat_add(&s_stage[stage], cycles, frames);
+  }
+#else
+  (void)stage;
+  (void)cycles;
+  (void)frames;
+#endif
+}
+
+void AppProf_RecordChain(uint32_t fx_mask, uint32_t cycles, uint32_t frames)
+{
+#if APP_PROF_ENABLE
+  if (fx_mask < APP_PROF_MASK_COUNT)
+  {
+    stat_add(&s_chain[fx_mask], cycles, frames);
+  }
+#else
+  (void)fx_mask;
+  (void)cycles;
+  (void)frames;
+#endif
+}
+
+uint8_t AppProf_GetStage(AppProfStage stage, AppProfStat *out)
+{
+#if APP_PROF_ENABLE
+  if (((uint32_t)stage >= (uint32_t)APP_PROF_STAGE_COUNT) || (out == NULL))
+  {
+    return 0u;
+  }
+  return stat_copy(&s_stage[stage], out);
+#else
+  (void)stage;
+  (void)out;
+  return 0u;
+#endif
+}
+
+uint8_t AppProf_GetChain(uint32_t fx_mask, AppProfStat *out)
+{
+#if APP_PROF_ENABLE
+  if ((fx_mask >= APP_PROF_MASK_COUNT) || (out == NULL))
+  {
+    return 0u;
+  }
+  return stat_copy(&s_chain[fx_mask], out);
+#else
+  (void)fx_mask;
+  (void)out;
+  return 0u;
+#endif
+}
+
+const char *AppProf_StageName(AppProfStage stage)
+{
+  if ((uint32_t)stage >= (uint32_t)APP_PROF_STAGE_COUNT)
+  {
+    return "?";
+  }
+  return s_stage_names[stage];
+}
+
+uint32_t AppProf_CyclesPerFrame(void)
+{
+  return SystemCoreClock / APP_AUDIO_SAMPLE_RATE_HZ;
+}
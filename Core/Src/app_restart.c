@@ -0,0 +1,269 @@
+#include "app_restart.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "app_mem.h"
+#include "app_preset.h"
+#include "stm32g4xx_hal.h"
+
+/*
+ * Warm restart.
+ * - The retained block is a header (magic, warm restarts in a row and a
+ *   check word over both, the image size of the firmware that wrote it)
+ *   and two copies of the settings. Nothing else
+ *   writes it and nothing initialises it: a header or copy that fails its
+ *   check is noise from a power-up.
+ * - A copy is written whole and its CRC last, into the older of the two;
+ *   the newer valid one (sequence numbers with wrap-around) is restored.
+ * - Poll compares a fresh capture with the newest copy and writes only on
+ *   a difference, so a pedal left alone does not rewrite the block.
+ * - The IWDG counts the LSI / 32 (~1 ms) down from APP_RESTART_WDG_MS; no
+ *   window, so any feed in time will do.
+ * - On the G4 every reset also sets PINRSTF (the reset drives NRST), so
+ *   the other flags are looked at first.
+ */
+
+#define RESTART_MAGIC  0x52535431u  /* "RST1" */
+
+typedef struct
+{
+  uint32_t seq;
+  uint32_t slot;
+  uint8_t image[APP_RESTART_IMAGE_MAX];
+  uint32_t crc;            /* CRC-32 of everything above */
+} RestartCopy;
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t restarts;
+  uint32_t check;          /* ~(magic ^ restarts) */
+  uint32_t image_bytes;    /* layout check: AppPreset_ImageSize() */
+  RestartCopy copy[2];
+} RestartRam;
+
+_Static_assert(sizeof(RestartRam) <= APP_MEM_RETAIN_BYTES, "the warm-restart state must fit APP_MEM_RETAIN_BYTES");
+_Static_assert((APP_RESTART_WDG_MS >= 1u) && (APP_RESTART_WDG_MS <= 4095u), "APP_RESTART_WDG_MS must be 1..4095");
+
+#define s_ram  ((RestartRam *)(uintptr_t)APP_MEM_RETAIN_ADDR)
+
+static uint8_t s_boot = APP_RESTART_BOOT_COLD;
+static uint8_t s_reset = APP_RESTART_RESET_POWER;
+static uint8_t s_restarts = 0;
+static uint8_t s_wdg = 0;
+static int32_t s_newest = -1;   /* copy written last, -1 = none */
+static uint32_t s_t0 = 0;
+static uint32_t s_saved_ms = 0;
+#if APP_RESTART_ENABLE
+static IWDG_HandleTypeDef s_iwdg;
+#endif
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++)
+  {
+    crc ^= p[i];
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return crc;
+}
+
+static uint32_t copy_crc(const RestartCopy *c)
+{
+  return ~crc32_update(0xFFFFFFFFu, (const uint8_t *)c, (uint32_t)offsetof(RestartCopy, crc));
+}
+
+static uint8_t copy_valid(const RestartCopy *c)
+{
+  return (c->crc == copy_crc(c)) && (c->slot < APP_PRESET_COUNT);
+}
+
+static void header_set(uint32_t restarts)
+{
+  s_ram->magic = RESTART_MAGIC;
+  s_ram->restarts = restarts;
+  s_ram->check = ~(RESTART_MAGIC ^ restarts);
+  s_ram->image_bytes = AppPreset_ImageSize();
+}
+
+static uint8_t reset_cause(void)
+{
+  if (__HAL_RCC_GET_FLAG(RCC_FLAG_BORRST) != 0u)
+  {
+    return APP_RESTART_RESET_POWER;
+  }
+  if (__HAL_RCC_GET_FLAG(RCC_FLAG_IWDGRST) != 0u)
+  {
+    return APP_RESTART_RESET_WATCHDOG;
+  }
+  if (__HAL_RCC_GET_FLAG(RCC_FLAG_SFTRST) != 0u)
+  {
+    return APP_RESTART_RESET_SOFTWARE;
+  }
+  if ((__HAL_RCC_GET_FLAG(RCC_FLAG_WWDGRST) != 0u) || (__HAL_RCC_GET_FLAG(RCC_FLAG_LPWRRST) != 0u) ||
+      (__HAL_RCC_GET_FLAG(RCC_FLAG_OBLRST) != 0u))
+  {
+    return APP_RESTART_RESET_OTHER;
+  }
+  return APP_RESTART_RESET_PIN;
+}
+
+void AppRestart_Init(void)
+{
+  s_reset = reset_cause();
+  __HAL_RCC_CLEAR_RESET_FLAGS();
+  s_t0 = HAL_GetTick();
+  if (!APP_RESTART_ENABLE)
+  {
+    return;
+  }
+
+  const uint8_t header_ok = (s_ram->magic == RESTART_MAGIC) && (s_ram->check == ~(RESTART_MAGIC ^ s_ram->restarts)) &&
+                            (s_ram->image_bytes == AppPreset_ImageSize());
+  const RestartCopy *c0 = &s_ram->copy[0];
+  const RestartCopy *c1 = &s_ram->copy[1];
+  const uint8_t v0 = header_ok && copy_valid(c0);
+  const uint8_t v1 = header_ok && copy_valid(c1);
+
+  if ((s_reset == APP_RESTART_RESET_POWER) || !(v0 || v1))
+  {
+    memset(s_ram, 0, sizeof(*s_ram));
+    header_set(0u);
+    s_boot = APP_RESTART_BOOT_COLD;
+    return;
+  }
+
+  const uint32_t restarts = s_ram->restarts + 1u;
+  if (restarts > APP_RESTART_MAX)
+  {
+    /* The fault came back with the state: start clean and let the next
+     * one stop in the blink.
+     */
+    memset(s_ram, 0, sizeof(*s_ram));
+    header_set(0u);
+    s_boot = APP_RESTART_BOOT_FALLBACK;
+    s_restarts = (uint8_t)((restarts > 255u) ? 255u : restarts);
+    return;
+  }
+
+  header_set(restarts);
+  s_restarts = (uint8_t)restarts;
+  if (v0 && v1)
+  {
+    s_newest = ((int32_t)(c1->seq - c0->seq) > 0) ? 1 : 0;
+  }
+  else
+  {
+    s_newest = v1 ? 1 : 0;
+  }
+  s_boot = APP_RESTART_BOOT_WARM;
+}
+
+AppRestartBoot AppRestart_Restore(void)
+{
+  if (s_boot == APP_RESTART_BOOT_WARM)
+  {
+    const RestartCopy *c = &s_ram->copy[s_newest];
+    if (AppPreset_ApplyImage(c->image, c->slot))
+    {
+      return (AppRestartBoot)s_boot;
+    }
+    /* Written by a build with other params (a firmware update). */
+    s_boot = APP_RESTART_BOOT_COLD;
+  }
+  if ((s_boot == APP_RESTART_BOOT_FALLBACK) || !AppPreset_Load(AppPreset_LastSlot()))
+  {
+    (void)AppPreset_Load(0u);
+  }
+  return (AppRestartBoot)s_boot;
+}
+
+void AppRestart_Start(void)
+{
+#if APP_RESTART_ENABLE
+  if (s_boot == APP_RESTART_BOOT_FALLBACK)
+  {
+    return;
+  }
+  __HAL_DBGMCU_FREEZE_IWDG();
+  s_iwdg.Instance = IWDG;
+  s_iwdg.Init.Prescaler = IWDG_PRESCALER_32;
+  s_iwdg.Init.Window = IWDG_WINDOW_DISABLE;
+  s_iwdg.Init.Reload = APP_RESTART_WDG_MS;
+  if (HAL_IWDG_Init(&s_iwdg) == HAL_OK)
+  {
+    s_wdg = 1u;
+  }
+#endif
+}
+
+void AppRestart_Feed(void)
+{
+#if APP_RESTART_ENABLE
+  if (s_wdg)
+  {
+    (void)HAL_IWDG_Refresh(&s_iwdg);
+  }
+#endif
+}
+
+void AppRestart_Poll(void)
+{
+#if APP_RESTART_ENABLE
+  AppRestart_Feed();
+
+  const uint32_t now = HAL_GetTick();
+  if ((s_ram->restarts != 0u) && ((now - s_t0) >= APP_RESTART_STABLE_MS))
+  {
+    header_set(0u);
+  }
+  if ((now - s_saved_ms) < APP_RESTART_SAVE_MS)
+  {
+    return;
+  }
+  s_saved_ms = now;
+
+  uint8_t image[APP_RESTART_IMAGE_MAX];
+  const uint32_t bytes = AppPreset_ImageSize();
+  const uint32_t slot = AppPreset_Current();
+  AppPreset_CaptureImage(image);
+  if (s_newest >= 0)
+  {
+    const RestartCopy *last = &s_ram->copy[s_newest];
+    if ((last->slot == slot) && (memcmp(last->image, image, bytes) == 0))
+    {
+      return;
+    }
+  }
+
+  const int32_t next = (s_newest == 0) ? 1 : 0;
+  RestartCopy *c = &s_ram->copy[next];
+  c->seq = (s_newest >= 0) ? (s_ram->copy[s_newest].seq + 1u) : 1u;
+  c->slot = slot;
+  memcpy(c->image, image, bytes);
+  memset(c->image + bytes, 0, APP_RESTART_IMAGE_MAX - bytes);
+  c->crc = copy_crc(c);
+  s_newest = next;
+#endif
+}
+
+void AppRestart_GetInfo(AppRestartInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->boot = s_boot;
+  out->reset = s_reset;
+  out->restarts = s_restarts;
+  out->wdg = s_wdg;
+}
+
+void AppRestart_Reboot(void)
+{
+  NVIC_SystemReset();
+}
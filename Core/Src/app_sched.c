@@ -0,0 +1,158 @@
+#include "app_sched.h"
+
+#include <stddef.h>
+
+#include "app_prof.h"
+#include "stm32g4xx_hal.h"
+
+typedef struct
+{
+  const char *name;
+  AppSchedFn fn;
+  uint8_t prio;
+  uint8_t due;
+  uint16_t period_ms;
+  uint16_t budget_us;
+  uint32_t next_ms;        /* tick the next periodic run is due */
+  uint32_t runs;
+  uint32_t over;
+  uint32_t late;
+  uint32_t max_cyc;
+  uint64_t sum_cyc;
+} SchedTask;
+
+static SchedTask s_tasks[APP_SCHED_MAX_TASKS];
+static uint32_t s_count;
+
+static uint32_t cycles_per_us(void)
+{
+  const uint32_t c = SystemCoreClock / 1000000u;
+  return (c != 0u) ? c : 1u;
+}
+
+uint8_t AppSched_Add(const char *name, AppSchedFn fn, AppSchedPrio prio, uint16_t period_ms,
+                     uint16_t budget_us)
+{
+  if ((s_count >= APP_SCHED_MAX_TASKS) || (fn == NULL) || (prio >= APP_SCHED_PRIO_COUNT))
+  {
+    return 0u;
+  }
+  SchedTask *t = &s_tasks[s_count];
+  t->name = name;
+  t->fn = fn;
+  t->prio = (uint8_t)prio;
+  t->period_ms = period_ms;
+  t->budget_us = budget_us;
+  t->next_ms = HAL_GetTick() + period_ms;
+  s_count++;
+  return 1u;
+}
+
+/* Highest-priority due task, NULL when none is. */
+static SchedTask *sched_pick(void)
+{
+  SchedTask *best = NULL;
+  for (uint32_t i = 0; i < s_count; i++)
+  {
+    SchedTask *t = &s_tasks[i];
+    if (t->due && ((best == NULL) || (t->prio < best->prio)))
+    {
+      best = t;
+    }
+  }
+  return best;
+}
+
+void AppSched_Run(void)
+{
+  const uint32_t now = HAL_GetTick();
+  for (uint32_t i = 0; i < s_count; i++)
+  {
+    SchedTask *t = &s_tasks[i];
+    if (t->period_ms == 0u)
+    {
+      t->due = 1u;
+    }
+    else if ((int32_t)(now - t->next_ms) >= 0)
+    {
+      t->due = 1u;
+      if ((now - t->next_ms) >= t->period_ms)
+      {
+        t->late++;
+        t->next_ms = now + t->period_ms;
+      }
+      else
+      {
+        t->next_ms += t->period_ms;
+      }
+    }
+  }
+
+  const uint32_t budget_scale = cycles_per_us();
+  SchedTask *t;
+  while ((t = sched_pick()) != NULL)
+  {
+    t->due = 0u;
+    const uint32_t t0 = AppProf_Cycles();
+    t->fn();
+    const uint32_t cyc = AppProf_Cycles() - t0;
+
+    t->runs++;
+    t->sum_cyc += cyc;
+    t->max_cyc = (cyc > t->max_cyc) ? cyc : t->max_cyc;
+    if ((t->budget_us != 0u) && (cyc > ((uint32_t)t->budget_us * budget_scale)))
+    {
+      t->over++;
+    }
+
+    /* Polls above a periodic task get another look before the next one. */
+    if (t->period_ms != 0u)
+    {
+      for (uint32_t i = 0; i < s_count; i++)
+      {
+        if ((s_tasks[i].period_ms == 0u) && (s_tasks[i].prio < t->prio))
+        {
+          s_tasks[i].due = 1u;
+        }
+      }
+    }
+  }
+}
+
+uint32_t AppSched_Count(void)
+{
+  return s_count;
+}
+
+uint8_t AppSched_Get(uint32_t i, AppSchedInfo *out)
+{
+  if ((i >= s_count) || (out == NULL))
+  {
+    return 0u;
+  }
+  const SchedTask *t = &s_tasks[i];
+  const uint32_t scale = cycles_per_us();
+  out->name = t->name;
+  out->prio = (AppSchedPrio)t->prio;
+  out->period_ms = t->period_ms;
+  out->budget_us = t->budget_us;
+  out->runs = t->runs;
+  out->over = t->over;
+  out->late = t->late;
+  out->avg_us = (t->runs != 0u) ? (uint32_t)((t->sum_cyc / t->runs) / scale) : 0u;
+  out->max_us = t->max_cyc / scale;
+  return 1u;
+}
+
+void AppSched_Reset(void)
+{
+  for (uint32_t i = 0; i < s_count; i++)
+  {
+    SchedTask *t = &s_tasks[i];
+    t->runs = 0u;
+    t->over = 0u;
+    t->late = 0u;
+    t->max_cyc = 0u;
+    t->sum_cyc = 0u;
+  }
+}
@@ -0,0 +1,364 @@
+#include "app_selftest.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "app_lfo.h"
+
+/*
+ * Self-test generator / analyzer.
+ * - The main loop sets a run up and flips s_state to RUNNING last; the audio
+ *   side measures the points and ends it (DONE). A result is written before
+ *   s_done counts it, so the main loop reads finished points unmasked.
+ * - Input generates the whole block with one phase increment and keeps the
+ *   block's start phase, so Output rebuilds each sample's reference phase
+ *   exactly. The next tone starts at the following block; the settle time
+ *   covers the rest of the current one.
+ * - Tone k sits on bin s_bin[k] of APP_SELFTEST_LEN, i.e. its increment is
+ *   bin * 2^32 / LEN and the window holds a whole number of periods: the
+ *   correlation sums are exact DFT bins. Sums stay in int64: |y| < 2^23,
+ *   the references < 2^15, LEN <= 2^14.
+ */
+
+#if APP_SELFTEST_ENABLE
+
+#define STEST_HARMONICS                5u
+#define STEST_BIN_INC                  ((uint32_t)(0x100000000ull / APP_SELFTEST_LEN))
+
+static volatile AppSelfTestState s_state = APP_SELFTEST_IDLE;
+static AppSelfTestMode s_mode = APP_SELFTEST_TONE;
+static int32_t s_level_db = 0;
+static uint32_t s_points = 0;
+static volatile uint32_t s_done = 0;
+static int32_t s_amp_q15 = 0;
+static uint16_t s_bin[APP_SELFTEST_POINTS];
+static AppSelfTestPoint s_res[APP_SELFTEST_POINTS];
+
+/* Audio side. */
+static uint32_t s_point = 0;
+static uint32_t s_pos = 0;         /* sample of the current point, settle first */
+static uint32_t s_phase = 0;
+static uint32_t s_inc = 0;
+static uint32_t s_harm = 0;        /* harmonics below fs / 2, 1..STEST_HARMONICS */
+static uint32_t s_rng = 1;
+static uint32_t s_blk_phase = 0;
+static uint32_t s_blk_inc = 0;
+static int64_t s_sy = 0;
+static int64_t s_syy = 0;
+static int64_t s_sx = 0;           /* noise: the stimulus too */
+static int64_t s_sxx = 0;
+static int64_t s_ss[STEST_HARMONICS];
+static int64_t s_sc[STEST_HARMONICS];
+static int64_t s_rss[STEST_HARMONICS];  /* the references' own energy */
+static int64_t s_rcc[STEST_HARMONICS];
+
+static void point_begin(uint32_t point)
+{
+  const uint32_t bin = s_bin[point];
+  s_point = point;
+  s_pos = 0;
+  s_phase = 0;
+  s_inc = bin * STEST_BIN_INC;
+  s_harm = 1u;
+  while ((s_harm < STEST_HARMONICS) && (((s_harm + 1u) * bin) < (APP_SELFTEST_LEN / 2u)))
+  {
+    s_harm++;
+  }
+  s_sy = 0;
+  s_syy = 0;
+  s_sx = 0;
+  s_sxx = 0;
+  memset(s_ss, 0, sizeof(s_ss));
+  memset(s_sc, 0, sizeof(s_sc));
+  memset(s_rss, 0, sizeof(s_rss));
+  memset(s_rcc, 0, sizeof(s_rcc));
+}
+
+/* Power ratio in dB, in units of 1/scale, floored at -200 dB. */
+static int32_t db_ratio(double num, double den, float scale)
+{
+  const double r = ((num > 0.0) && (den > 0.0)) ? (num / den) : 0.0;
+  const float db = (r > 1e-20) ? (10.0f * log10f((float)r)) : -200.0f;
+  return (int32_t)lroundf(db * scale);
+}
+
+/* Once per point, in audio context: a few dozen double operations (soft
+ * float on the M4) and three float calls.
+ */
+static void point_finish(void)
+{
+  const double m = (double)APP_SELFTEST_LEN;
+  const double mean = (double)s_sy / m;
+  const double pac = ((double)s_syy / m) - (mean * mean);
+  AppSelfTestPoint *r = &s_res[s_point];
+
+  if (s_mode == APP_SELFTEST_NOISE)
+  {
+    const double xmean = (double)s_sx / m;
+    const double pin = ((double)s_sxx / m) - (xmean * xmean);
+    r->freq_x10 = 0u;
+    r->gain_x100 = db_ratio(pac, pin, 100.0f);
+    r->phase_x10 = 0;
+    r->thd_x10 = 0;
+    r->thdn_x10 = 0;
+  }
+  else
+  {
+    /* Power of the output's projection on harmonic k's sine and cosine
+     * (least squares, so the references' exact amplitude drops out).
+     */
+    double ph[STEST_HARMONICS];
+    double harm = 0.0;
+    for (uint32_t k = 0; k < s_harm; k++)
+    {
+      const double s = (double)s_ss[k];
+      const double c = (double)s_sc[k];
+      ph[k] = (((s * s) / (double)s_rss[k]) + ((c * c) / (double)s_rcc[k])) / m;
+      if (k != 0u)
+      {
+        harm += ph[k];
+      }
+    }
+    /* The stimulus is the fundamental's sine reference times amp / 128. */
+    const double amp = (double)s_amp_q15 / 128.0;
+    const double pin = (amp * amp) * (double)s_rss[0] / m;
+    r->freq_x10 = (uint32_t)(((uint64_t)s_bin[s_point] * APP_DSP_SAMPLE_RATE_HZ * 10u + (APP_SELFTEST_LEN / 2u)) / APP_SELFTEST_LEN);
+    r->gain_x100 = db_ratio(ph[0], pin, 100.0f);
+    r->phase_x10 = (int32_t)lroundf(atan2f((float)s_sc[0], (float)s_ss[0]) * (1800.0f / 3.14159265f));
+    r->thd_x10 = db_ratio(harm, ph[0], 10.0f);
+    r->thdn_x10 = db_ratio(pac - ph[0], ph[0], 10.0f);
+  }
+
+  s_done = s_point + 1u;
+  if (s_done >= s_points)
+  {
+    s_state = APP_SELFTEST_DONE;
+    return;
+  }
+  point_begin(s_point + 1u);
+}
+
+uint8_t AppSelfTest_Start(AppSelfTestMode mode, uint32_t f1, uint32_t f2, uint32_t points, int32_t level_db)
+{
+  const uint32_t nyq = APP_DSP_SAMPLE_RATE_HZ / 2u;
+  if (mode != APP_SELFTEST_SWEEP)
+  {
+    f2 = f1;
+    points = 1u;
+  }
+  if ((s_state == APP_SELFTEST_RUNNING) || ((uint32_t)mode >= (uint32_t)APP_SELFTEST_MODE_COUNT) ||
+      (level_db < -90) || (level_db > 0))
+  {
+    return 0;
+  }
+  if ((mode != APP_SELFTEST_NOISE) &&
+      ((f1 == 0u) || (f1 >= nyq) || (f2 == 0u) || (f2 >= nyq) ||
+       (points == 0u) || (points > APP_SELFTEST_POINTS) || ((mode == APP_SELFTEST_SWEEP) && (points < 2u))))
+  {
+    return 0;
+  }
+
+  /* Log-spaced, rounded to bins 1..LEN/2-1. */
+  for (uint32_t i = 0; i < points; i++)
+  {
+    const float t = (points > 1u) ? ((float)i / (float)(points - 1u)) : 0.0f;
+    const float f = (float)f1 * powf((float)f2 / (float)f1, t);
+    int32_t bin = (int32_t)lroundf((f * (float)APP_SELFTEST_LEN) / (float)APP_DSP_SAMPLE_RATE_HZ);
+    if (bin < 1)
+    {
+      bin = 1;
+    }
+    if (bin > (int32_t)(APP_SELFTEST_LEN / 2u - 1u))
+    {
+      bin = (int32_t)(APP_SELFTEST_LEN / 2u - 1u);
+    }
+    s_bin[i] = (uint16_t)bin;
+  }
+
+  s_mode = mode;
+  s_level_db = level_db;
+  s_points = points;
+  s_done = 0;
+  s_amp_q15 = (int32_t)lroundf(32767.0f * powf(10.0f, (float)level_db / 20.0f));
+  s_rng = 1u;
+  point_begin(0u);
+  s_state = APP_SELFTEST_RUNNING;
+  return 1;
+}
+
+void AppSelfTest_Stop(void)
+{
+  s_state = APP_SELFTEST_IDLE;
+}
+
+void AppSelfTest_GetInfo(AppSelfTestInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->state = s_state;
+  out->mode = s_mode;
+  out->level_db = s_level_db;
+  out->points = s_points;
+  out->done = s_done;
+}
+
+uint8_t AppSelfTest_GetPoint(uint32_t index, AppSelfTestPoint *out)
+{
+  if ((out == NULL) || (index >= s_done))
+  {
+    return 0;
+  }
+  *out = s_res[index];
+  return 1;
+}
+
+void AppSelfTest_Input(AppStereoS24 *x, uint32_t n)
+{
+  if (s_state != APP_SELFTEST_RUNNING)
+  {
+    return;
+  }
+  s_blk_phase = s_phase;
+  s_blk_inc = s_inc;
+  const int32_t amp = s_amp_q15;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    int32_t v;
+    if (s_mode == APP_SELFTEST_NOISE)
+    {
+      /* xorshift32, uniform over +-amp. */
+      uint32_t r = s_rng;
+      r ^= r << 13;
+      r ^= r >> 17;
+      r ^= r << 5;
+      s_rng = r;
+      v = (int32_t)(((int64_t)((int32_t)r >> 8) * amp) >> 15);
+      const uint32_t pos = s_pos + i;
+      if ((pos >= APP_SELFTEST_SETTLE) && (pos < (APP_SELFTEST_SETTLE + APP_SELFTEST_LEN)))
+      {
+        s_sx += v;
+        s_sxx += (int64_t)v * v;
+      }
+    }
+    else
+    {
+      int32_t s;
+      int32_t c;
+      AppLfo_SinCos(s_phase, &s, &c);
+      s_phase += s_inc;
+      v = (s * amp) >> 7;
+    }
+    x[i].l = v;
+    x[i].r = v;
+  }
+}
+
+void AppSelfTest_Output(const AppStereoS24 *x, uint32_t n)
+{
+  if (s_state != APP_SELFTEST_RUNNING)
+  {
+    return;
+  }
+  const uint8_t tone = (s_mode != APP_SELFTEST_NOISE) ? 1u : 0u;
+  uint32_t pos = s_pos;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (pos >= APP_SELFTEST_SETTLE)
+    {
+      const int32_t y = (x[i].l + x[i].r) >> 1;
+      s_sy += y;
+      s_syy += (int64_t)y * y;
+      if (tone)
+      {
+        const uint32_t ph = s_blk_phase + (i * s_blk_inc);
+        for (uint32_t k = 0; k < s_harm; k++)
+        {
+          int32_t s;
+          int32_t c;
+          AppLfo_SinCos(ph * (k + 1u), &s, &c);
+          s_ss[k] += (int64_t)y * s;
+          s_sc[k] += (int64_t)y * c;
+          s_rss[k] += s * s;
+          s_rcc[k] += c * c;
+        }
+      }
+    }
+    if (++pos == (APP_SELFTEST_SETTLE + APP_SELFTEST_LEN))
+    {
+      point_finish();
+      if (s_state != APP_SELFTEST_RUNNING)
+      {
+        return;
+      }
+      pos = 0;   /* the next tone's settle, still the old one's stimulus */
+    }
+  }
+  s_pos = pos;
+}
+
+static const AppMemItem k_selftest_mem[] =
+{
+  APP_MEM_ITEM("selftest.res", s_res),
+};
+
+_Static_assert(sizeof(s_res) <= APP_SELFTEST_RAM_BYTES, "the self-test results outgrew APP_SELFTEST_RAM_BYTES");
+
+uint32_t AppSelfTest_MemMap(const AppMemItem **items)
+{
+  *items = k_selftest_mem;
+  return 1u;
+}
+
+#else
+
+uint8_t AppSelfTest_Start(AppSelfTestMode mode, uint32_t f1, uint32_t f2, uint32_t points, int32_t level_db)
+{
+  (void)mode;
+  (void)f1;
+  (void)f2;
+  (void)points;
+  (void)level_db;
+  return 0;
+}
+
+void AppSelfTest_Stop(void)
+{
+}
+
+void AppSelfTest_GetInfo(AppSelfTestInfo *out)
+{
+  if (out != NULL)
+  {
+    memset(out, 0, sizeof(*out));
+  }
+}
+
+uint8_t AppSelfTest_GetPoint(uint32_t index, AppSelfTestPoint *out)
+{
+  (void)index;
+  (void)out;
+  return 0;
+}
+
+void AppSelfTest_Input(AppStereoS24 *x, uint32_t n)
+{
+  (void)x;
+  (void)n;
+}
+
+void AppSelfTest_Output(const AppStereoS24 *x, uint32_t n)
+{
+  (void)x;
+  (void)n;
+}
+
+uint32_t AppSelfTest_MemMap(const AppMemItem **items)
+{
+  *items = NULL;
+  return 0u;
+}
+
+#endif /* APP_SELFTEST_ENABLE */
@@ -0,0 +1,473 @@
+#include "app_serial.h"
+
+#include <stddef.h>
+
+#include "app_ring.h"
+#include "app_trace.h"
+
+#if (APP_SERIAL_RX_RING_SIZE & (APP_SERIAL_RX_RING_SIZE - 1u)) || \
+    (APP_SERIAL_TX_RING_SIZE & (APP_SERIAL_TX_RING_SIZE - 1u))
+#error "APP_SERIAL ring sizes must be powers of two"
+#endif
+
+#define RX_MASK (APP_SERIAL_RX_RING_SIZE - 1u)
+
+typedef enum
+{
+  APP_SERIAL_RX_MODE_BYTE = 0,
+  APP_SERIAL_RX_MODE_IDLE_IT = 1,
+  APP_SERIAL_RX_MODE_IDLE_DMA = 2,
+} AppSerialRxMode;
+
+static UART_HandleTypeDef *s_uart = NULL;
+
+/* RX indices are ring positions (the DMA counter is one) and one byte
+ * stays free; the interrupt or the DMA moves wr, AppSerial_Read() rd.
+ */
+APP_DMA_BSS static volatile uint8_t s_rx_ring[APP_SERIAL_RX_RING_SIZE];
+static volatile uint16_t s_rx_wr = 0;
+static volatile uint16_t s_rx_rd = 0;
+/* Set when the RX DMA restarted at the ring start: the reader skips back. */
+static volatile uint8_t s_rx_resync = 0;
+
+static uint8_t s_rx_byte = 0;
+static uint8_t s_rx_chunk[APP_SERIAL_RX_IT_SIZE];
+static volatile AppSerialRxMode s_rx_mode = APP_SERIAL_RX_MODE_BYTE;
+
+/* TX indices run free; AppSerial_Write() moves w, the completion
+ * interrupt r. busy is claimed by whichever side starts a chunk
+ * (AppRing_Claim()), len is the chunk in flight. The error interrupt
+ * only raises stuck: it cannot tell a chunk in flight from a main-loop
+ * kick it interrupted, so the main loop resets TX (tx_recover()).
+ */
+APP_DMA_BSS static uint8_t s_tx_ring[APP_SERIAL_TX_RING_SIZE];
+static volatile uint32_t s_tx_w = 0;
+static volatile uint32_t s_tx_r = 0;
+static volatile uint8_t s_tx_busy = 0;
+static volatile uint16_t s_tx_len = 0;
+static volatile uint8_t s_tx_stuck = 0;
+
+/* Set by every UART hook, cleared by AppSerial_Read(). */
+static volatile uint8_t s_wake = 0;
+
+/* DWT cycles of the last RX hook; s_rx_stamped until AppSerial_RxStamp(). */
+static volatile uint32_t s_rx_cyc = 0;
+static volatile uint8_t s_rx_stamped = 0;
+
+static uint16_t s_rx_peak = 0;
+static uint16_t s_tx_peak = 0;
+
+static uint32_t tx_ring_free(void)
+{
+  return APP_SERIAL_TX_RING_SIZE - (s_tx_w - s_tx_r);
+}
+
+/* Copies the IT staging buffer into the ring; what does not fit is
+ * dropped.
+ */
+static void rx_put(const uint8_t *p, uint16_t n)
+{
+  const uint16_t wr = s_rx_wr;
+  const uint16_t room = (uint16_t)((s_rx_rd - wr - 1u) & RX_MASK);
+  if (n > room)
+  {
+    n = room;
+  }
+  AppRing_Write((uint8_t *)s_rx_ring, APP_SERIAL_RX_RING_SIZE, wr, p, n);
+  s_rx_wr = (uint16_t)((wr + n) & RX_MASK);
+}
+
+/* Starts the next contiguous chunk unless one is in flight; from the main
+ * loop after a write and from the completion interrupt.
+ */
+static void tx_kick(void)
+{
+  if (s_uart == NULL)
+  {
+    return;
+  }
+  if (!AppRing_Claim(&s_tx_busy))
+  {
+    return;
+  }
+
+  const uint32_t r = s_tx_r;
+  const uint32_t queued = s_tx_w - r;
+  if (queued == 0u)
+  {
+    s_tx_busy = 0;
+    return;
+  }
+
+  /* Send the largest contiguous chunk (until the ring end or w). */
+  const uint32_t at = r & (APP_SERIAL_TX_RING_SIZE - 1u);
+  const uint32_t to_end = APP_SERIAL_TX_RING_SIZE - at;
+  const uint16_t len = (uint16_t)((queued < to_end) ? queued : to_end);
+
+  s_tx_len = len;
+  HAL_StatusTypeDef st;
+  if (s_uart->hdmatx != NULL)
+  {
+    st = HAL_UART_Transmit_DMA(s_uart, &s_tx_ring[at], len);
+    if (st == HAL_OK)
+    {
+      /* Only the transfer-complete interrupt is needed. */
+      __HAL_DMA_DISABLE_IT(s_uart->hdmatx, DMA_IT_HT);
+    }
+  }
+  else
+  {
+    st = HAL_UART_Transmit_IT(s_uart, &s_tx_ring[at], len);
+  }
+  if (st != HAL_OK)
+  {
+    s_tx_len = 0;
+    s_tx_busy = 0;
+  }
+}
+
+/* After a UART error, from the main loop, which is not inside tx_kick()
+ * here: the blocking abort also stops TX DMA and the completion interrupt,
+ * so nothing else owns busy, and the chunk that was cut off goes again
+ * (r only moves on completion).
+ */
+static void tx_recover(void)
+{
+  if (!s_tx_stuck || (s_uart == NULL))
+  {
+    return;
+  }
+  s_tx_stuck = 0;
+  (void)HAL_UART_AbortTransmit(s_uart);
+  s_tx_len = 0;
+  __DMB();
+  s_tx_busy = 0;
+  tx_kick();
+}
+
+/* Circular DMA straight into s_rx_ring. The HAL reports idle, half and
+ * complete events, which only move s_rx_wr (AppSerial_OnUartRxEvent()).
+ */
+static HAL_StatusTypeDef rx_dma_start(void)
+{
+  return HAL_UARTEx_ReceiveToIdle_DMA(s_uart, (uint8_t *)s_rx_ring, (uint16_t)APP_SERIAL_RX_RING_SIZE);
+}
+
+/* Restarts RX in the current mode, degrading DMA -> idle IT -> byte IT if
+ * a mode can't start.
+ */
+static void rx_restart(void)
+{
+  (void)HAL_UART_AbortReceive_IT(s_uart);
+  (void)HAL_UART_AbortReceive(s_uart);
+
+  if (s_rx_mode == APP_SERIAL_RX_MODE_IDLE_DMA && s_uart->hdmarx != NULL)
+  {
+    if (rx_dma_start() == HAL_OK)
+    {
+      s_rx_wr = 0;
+      s_rx_resync = 1;
+      return;
+    }
+    /* DMA path failed, degrade. */
+    s_rx_mode = APP_SERIAL_RX_MODE_IDLE_IT;
+  }
+
+  if (s_rx_mode == APP_SERIAL_RX_MODE_IDLE_IT)
+  {
+    if (HAL_UARTEx_ReceiveToIdle_IT(s_uart, s_rx_chunk, (uint16_t)APP_SERIAL_RX_IT_SIZE) == HAL_OK)
+    {
+      return;
+    }
+    /* Idle IT failed, degrade to byte mode. */
+    s_rx_mode = APP_SERIAL_RX_MODE_BYTE;
+  }
+
+  (void)HAL_UART_Receive_IT(s_uart, &s_rx_byte, 1);
+}
+
+void AppSerial_Init(UART_HandleTypeDef *huart)
+{
+  s_uart = huart;
+  s_rx_wr = 0;
+  s_rx_rd = 0;
+  s_rx_resync = 0;
+  s_tx_w = 0;
+  s_tx_r = 0;
+  s_tx_busy = 0;
+  s_tx_len = 0;
+  s_tx_stuck = 0;
+
+  if (s_uart == NULL)
+  {
+    return;
+  }
+  /* Robust RX without spamming byte IRQs:
+   * - Prefer circular ReceiveToIdle DMA into the ring when DMA is configured.
+   * - Else use ReceiveToIdle IT (no DMA required).
+   * - Fall back to byte-by-byte RX only if idle-mode can't start.
+   */
+  s_rx_mode = APP_SERIAL_RX_MODE_BYTE;
+
+  if (s_uart->hdmarx != NULL)
+  {
+    if (rx_dma_start() == HAL_OK)
+    {
+      s_rx_mode = APP_SERIAL_RX_MODE_IDLE_DMA;
+    }
+  }
+
+  if (s_rx_mode == APP_SERIAL_RX_MODE_BYTE)
+  {
+    if (HAL_UARTEx_ReceiveToIdle_IT(s_uart, s_rx_chunk, (uint16_t)APP_SERIAL_RX_IT_SIZE) == HAL_OK)
+    {
+      s_rx_mode = APP_SERIAL_RX_MODE_IDLE_IT;
+    }
+  }
+
+  if (s_rx_mode == APP_SERIAL_RX_MODE_BYTE)
+  {
+    (void)HAL_UART_Receive_IT(s_uart, &s_rx_byte, 1);
+  }
+}
+
+uint8_t AppSerial_Restarted(void)
+{
+  if (!s_rx_resync)
+  {
+    return 0u;
+  }
+  /* The RX DMA restarted at the ring start after an error or a BAUD
+   * switch; the partial line is lost either way.
+   */
+  s_rx_resync = 0;
+  s_rx_rd = 0;
+  return 1u;
+}
+
+uint32_t AppSerial_Read(uint8_t *dst, uint32_t max)
+{
+  s_wake = 0;
+  tx_recover();
+  if ((s_rx_mode == APP_SERIAL_RX_MODE_IDLE_DMA) && (s_uart != NULL) && (s_uart->hdmarx != NULL))
+  {
+    /* Pick up bytes that have not raised an idle/half/complete event yet. */
+    s_rx_wr = (uint16_t)((APP_SERIAL_RX_RING_SIZE - __HAL_DMA_GET_COUNTER(s_uart->hdmarx)) & RX_MASK);
+  }
+
+  const uint16_t rd = s_rx_rd;
+  const uint16_t rx_fill = (uint16_t)((s_rx_wr - rd) & RX_MASK);
+  if (rx_fill > s_rx_peak)
+  {
+    s_rx_peak = rx_fill;
+  }
+  if (s_rx_resync)
+  {
+    return 0u;
+  }
+
+  const uint32_t n = (rx_fill < max) ? rx_fill : max;
+  AppRing_Read((const uint8_t *)s_rx_ring, APP_SERIAL_RX_RING_SIZE, rd, dst, n);
+  s_rx_rd = (uint16_t)((rd + n) & RX_MASK);
+  return n;
+}
+
+uint8_t AppSerial_RxStamp(uint32_t *cyc)
+{
+  if (!s_rx_stamped)
+  {
+    return 0u;
+  }
+  s_rx_stamped = 0;
+  *cyc = s_rx_cyc;
+  return 1u;
+}
+
+uint8_t AppSerial_Write(const uint8_t *p, uint32_t n)
+{
+  if ((s_uart == NULL) || (p == NULL) || (n == 0u))
+  {
+    return 1u;
+  }
+
+  if (tx_ring_free() < n)
+  {
+    /* Drop if TX ring is full; prefer dropping replies over blocking audio/DSP. */
+    return 0u;
+  }
+
+  tx_recover();
+  const uint32_t w = s_tx_w;
+  AppRing_Write(s_tx_ring, APP_SERIAL_TX_RING_SIZE, w, p, n);
+  s_tx_w = w + n;
+  const uint32_t used = s_tx_w - s_tx_r;
+  if (used > s_tx_peak)
+  {
+    s_tx_peak = (uint16_t)used;
+  }
+
+  tx_kick();
+  return 1u;
+}
+
+uint32_t AppSerial_TxFree(void)
+{
+  return tx_ring_free();
+}
+
+uint8_t AppSerial_Pending(void)
+{
+  return (s_wake || (s_rx_rd != s_rx_wr)) ? 1u : 0u;
+}
+
+uint32_t AppSerial_Baud(void)
+{
+  return (s_uart != NULL) ? s_uart->Init.BaudRate : 0u;
+}
+
+uint8_t AppSerial_TxDone(void)
+{
+  return ((s_uart != NULL) && (s_tx_r == s_tx_w) && !s_tx_busy && __HAL_UART_GET_FLAG(s_uart, UART_FLAG_TC))
+             ? 1u
+             : 0u;
+}
+
+void AppSerial_SetBaud(uint32_t rate)
+{
+  if (s_uart == NULL)
+  {
+    return;
+  }
+  const uint32_t prev = s_uart->Init.BaudRate;
+  (void)HAL_UART_AbortReceive(s_uart);
+  s_uart->Init.BaudRate = rate;
+  if (HAL_UART_Init(s_uart) != HAL_OK)
+  {
+    /* Reconfiguration only fails on a bad handle: stay on the old rate. */
+    s_uart->Init.BaudRate = prev;
+    (void)HAL_UART_Init(s_uart);
+  }
+
+  /* Whatever arrived around the switch is garbage. */
+  rx_restart();
+}
+
+void AppSerial_Get(AppSerialInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->rx_peak = s_rx_peak;
+  out->tx_peak = s_tx_peak;
+}
+
+void AppSerial_ResetPeaks(void)
+{
+  s_rx_peak = 0;
+  s_tx_peak = 0;
+}
+
+static const AppMemItem k_serial_mem[] =
+{
+  APP_MEM_ITEM("serial.rx_ring", s_rx_ring),
+  APP_MEM_ITEM("serial.tx_ring", s_tx_ring),
+  APP_MEM_ITEM("serial.rx_chunk", s_rx_chunk),
+};
+
+_Static_assert((sizeof(s_rx_ring) + sizeof(s_tx_ring) + sizeof(s_rx_chunk)) <= APP_SERIAL_RAM_BYTES,
+               "the UART buffers outgrew APP_SERIAL_RAM_BYTES");
+
+uint32_t AppSerial_MemMap(const AppMemItem **items)
+{
+  *items = k_serial_mem;
+  return (uint32_t)(sizeof(k_serial_mem) / sizeof(k_serial_mem[0]));
+}
+
+void AppSerial_OnUartTxCplt(UART_HandleTypeDef *huart)
+{
+  if (s_uart == NULL || huart != s_uart)
+  {
+    return;
+  }
+
+  s_wake = 1;
+
+  /* Free the chunk that went out, then give busy back for the next one. */
+  s_tx_r += s_tx_len;
+  s_tx_len = 0;
+  __DMB();
+  s_tx_busy = 0;
+
+  tx_kick();
+}
+
+void AppSerial_OnUartRxCplt(UART_HandleTypeDef *huart)
+{
+  if (s_uart == NULL || huart != s_uart)
+  {
+    return;
+  }
+
+  s_wake = 1;
+  s_rx_cyc = DWT->CYCCNT;
+  s_rx_stamped = 1;
+
+  if (s_rx_mode != APP_SERIAL_RX_MODE_BYTE)
+  {
+    /* RX is handled by RxEvent callback in idle mode. */
+    return;
+  }
+
+  rx_put(&s_rx_byte, 1u);
+
+  (void)HAL_UART_Receive_IT(s_uart, &s_rx_byte, 1);
+}
+
+void AppSerial_OnUartRxEvent(UART_HandleTypeDef *huart, uint16_t size)
+{
+  if (s_uart == NULL || huart != s_uart)
+  {
+    return;
+  }
+
+  s_wake = 1;
+  s_rx_cyc = DWT->CYCCNT;
+  s_rx_stamped = 1;
+  APP_TRACE(APP_TRACE_UART_RX, size);
+
+  if (s_rx_mode == APP_SERIAL_RX_MODE_BYTE)
+  {
+    return;
+  }
+
+  if (s_rx_mode == APP_SERIAL_RX_MODE_IDLE_DMA)
+  {
+    /* size is the DMA position in the ring (RING_SIZE on wrap). */
+    s_rx_wr = (uint16_t)(size & RX_MASK);
+    return;
+  }
+
+  rx_put(s_rx_chunk, (size > (uint16_t)APP_SERIAL_RX_IT_SIZE) ? (uint16_t)APP_SERIAL_RX_IT_SIZE : size);
+
+  /* Restart RX-to-idle IT for next burst. */
+  (void)HAL_UARTEx_ReceiveToIdle_IT(s_uart, s_rx_chunk, (uint16_t)APP_SERIAL_RX_IT_SIZE);
+}
+
+void AppSerial_OnUartError(UART_HandleTypeDef *huart)
+{
+  if (s_uart == NULL || huart != s_uart)
+  {
+    return;
+  }
+
+  s_wake = 1;
+
+  /* Try to recover by restarting RX. */
+  rx_restart();
+
+  /* TX may be stuck too; the main loop restarts it (s_wake brings it to
+   * AppSerial_Read()).
+   */
+  s_tx_stuck = 1;
+}
@@ -0,0 +1,31 @@
+#include "app_shaper.h"
+
+#include "app_tables.h"
+
+static const char *const s_shaper_names[APP_SHAPER_CURVE_COUNT] =
+{
+  "soft",
+  "hard",
+  "tube",
+  "diode",
+  "fuzz",
+  "asym",
+};
+
+const int16_t *AppShaper_Table(AppShaperCurve curve)
+{
+  if ((uint32_t)curve >= (uint32_t)APP_SHAPER_CURVE_COUNT)
+  {
+    curve = APP_SHAPER_SOFT;
+  }
+  return AppTab_ShaperLut[curve];
+}
+
+const char *AppShaper_Name(AppShaperCurve curve)
+{
+  if ((uint32_t)curve >= (uint32_t)APP_SHAPER_CURVE_COUNT)
+  {
+    return "?";
+  }
+  return s_shaper_names[curve];
+}
@@ -0,0 +1,282 @@
+#include "app_spectrum.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#if APP_SPECTRUM_ENABLE
+
+#if APP_SPECTRUM_USE_CMSIS
+#include "arm_common_tables.h"
+#include "arm_const_structs.h"
+#include "arm_math.h"
+#endif
+
+/*
+ * Spectrum.
+ * - Decimator: a boxcar of APP_SPECTRUM_DECIM frames of (L + R) / 2, s24 >> 8
+ *   into int16. Meant for a display: what the boxcar lets alias from the
+ *   top octave lands a few dB under the real content.
+ * - Handoff without a lock: the audio side fills s_win while s_filled ==
+ *   s_taken and bumps s_filled when it is full; Take copies it out and
+ *   moves s_taken up to match. Each counter has one writer.
+ * - The FFT is float, as the cab IR's: arm_rfft_fast_f32() over the CFFT of
+ *   N / 2, filled by hand so only the 256-point tables are linked (the same
+ *   ones APP_CABIR_PARTITION 128 uses). The q15 RFFT would pull the 8192-
+ *   entry real coefficient tables in whatever the length.
+ * - Band edges are log-spaced between bin 1 and bin N / 2 - 1, at least one
+ *   bin wide, built with the Hann table on the first Enable.
+ */
+
+#define SPECTRUM_N        APP_SPECTRUM_FFT_LEN
+#define SPECTRUM_FS_HZ    (APP_DSP_SAMPLE_RATE_HZ / APP_SPECTRUM_DECIM)
+#define SPECTRUM_TOP_BIN  ((SPECTRUM_N / 2u) - 1u)
+/* |X| of a full-scale sine through the Hann window (coherent gain 1/2). */
+#define SPECTRUM_FS_MAG   (32768.0f * (float)SPECTRUM_N * 0.25f)
+
+_Static_assert((APP_SPECTRUM_BANDS >= 1u) && (APP_SPECTRUM_BANDS <= 30u), "APP_SPECTRUM_BANDS must be 1..30");
+_Static_assert(APP_SPECTRUM_DECIM >= 1u, "APP_SPECTRUM_DECIM must be at least 1");
+
+static volatile uint8_t s_on = 0;
+static volatile uint32_t s_filled = 0;
+static volatile uint32_t s_taken = 0;
+
+static int16_t s_win[SPECTRUM_N];
+static uint8_t s_active = 0;
+static int32_t s_acc = 0;
+static uint32_t s_acc_n = 0;
+static uint32_t s_fill = 0;
+
+static float s_work[SPECTRUM_N];
+static float s_spec[SPECTRUM_N];
+static float s_hann[(SPECTRUM_N / 2u) + 1u];   /* w[N - i] = w[i] */
+static uint8_t s_top[APP_SPECTRUM_BANDS];
+static uint8_t s_ready = 0;
+
+#if APP_SPECTRUM_USE_CMSIS
+static arm_rfft_fast_instance_f32 s_rfft;
+
+static void spectrum_fft_init(void)
+{
+  s_rfft.Sint = arm_cfft_sR_f32_len128;
+  s_rfft.fftLenRFFT = (uint16_t)SPECTRUM_N;
+  s_rfft.pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_256;
+}
+
+/* Packed spectrum {X0.re, X(N/2).re, X1.re, X1.im, ...}; 'in' is scratch. */
+static void spectrum_rfft(float *in, float *out)
+{
+  arm_rfft_fast_f32(&s_rfft, in, out, 0u);
+}
+#else
+/* arm_rfft_fast_f32() as a plain DFT, O(N^2): host builds only. */
+static float s_dft_cos[SPECTRUM_N];
+
+static void spectrum_fft_init(void)
+{
+  for (uint32_t i = 0; i < SPECTRUM_N; i++)
+  {
+    s_dft_cos[i] = (float)cos((6.283185307179586 * (double)i) / (double)SPECTRUM_N);
+  }
+}
+
+static void spectrum_rfft(float *in, float *out)
+{
+  const uint32_t n = SPECTRUM_N;
+  const uint32_t quarter = n / 4u;   /* sin(a) = cos(a - pi/2) */
+  for (uint32_t k = 0; k <= (n / 2u); k++)
+  {
+    float re = 0.0f;
+    float im = 0.0f;
+    for (uint32_t t = 0; t < n; t++)
+    {
+      const uint32_t a = (k * t) % n;
+      re += in[t] * s_dft_cos[a];
+      im -= in[t] * s_dft_cos[(a + n - quarter) % n];
+    }
+    if (k == 0u)
+    {
+      out[0] = re;
+    }
+    else if (k == (n / 2u))
+    {
+      out[1] = re;
+    }
+    else
+    {
+      out[2u * k] = re;
+      out[(2u * k) + 1u] = im;
+    }
+  }
+}
+#endif
+
+static void spectrum_tables(void)
+{
+  spectrum_fft_init();
+  for (uint32_t i = 0; i <= (SPECTRUM_N / 2u); i++)
+  {
+    s_hann[i] = 0.5f - (0.5f * cosf((6.2831853f * (float)i) / (float)SPECTRUM_N));
+  }
+  uint32_t prev = 0;
+  for (uint32_t b = 0; b < APP_SPECTRUM_BANDS; b++)
+  {
+    const float e = (float)(b + 1u) / (float)APP_SPECTRUM_BANDS;
+    uint32_t top = (uint32_t)(powf((float)SPECTRUM_TOP_BIN, e) + 0.5f);
+    if (top <= prev)
+    {
+      top = prev + 1u;
+    }
+    if (top > SPECTRUM_TOP_BIN)
+    {
+      top = SPECTRUM_TOP_BIN;
+    }
+    s_top[b] = (uint8_t)top;
+    prev = top;
+  }
+  s_ready = 1u;
+}
+
+void AppSpectrum_Enable(uint8_t on)
+{
+  if (on && !s_ready)
+  {
+    spectrum_tables();
+  }
+  s_taken = s_filled;   /* a window left over from before is stale */
+  s_on = on ? 1u : 0u;
+}
+
+/* 0.5 dB steps from a squared magnitude, 255 = full scale. */
+static uint8_t spectrum_level(float power)
+{
+  const float ref = SPECTRUM_FS_MAG * SPECTRUM_FS_MAG;
+  if (power <= (ref * 1e-13f))
+  {
+    return 0u;
+  }
+  const float v = 255.0f + (20.0f * log10f(power / ref));
+  if (v <= 0.0f)
+  {
+    return 0u;
+  }
+  return (v >= 255.0f) ? 255u : (uint8_t)(v + 0.5f);
+}
+
+uint8_t AppSpectrum_Take(AppSpectrumFrame *out)
+{
+  if ((out == NULL) || !s_on || (s_filled == s_taken))
+  {
+    return 0u;
+  }
+  for (uint32_t i = 0; i < SPECTRUM_N; i++)
+  {
+    const uint32_t w = (i <= (SPECTRUM_N / 2u)) ? i : (SPECTRUM_N - i);
+    s_work[i] = (float)s_win[i] * s_hann[w];
+  }
+  s_taken = s_filled;
+
+  spectrum_rfft(s_work, s_spec);
+
+  out->bin_chz = (uint16_t)((SPECTRUM_FS_HZ * 100u) / SPECTRUM_N);
+  uint32_t k = 1;
+  for (uint32_t b = 0; b < APP_SPECTRUM_BANDS; b++)
+  {
+    float peak = 0.0f;
+    for (; k <= s_top[b]; k++)
+    {
+      const float re = s_spec[2u * k];
+      const float im = s_spec[(2u * k) + 1u];
+      const float p = (re * re) + (im * im);
+      if (p > peak)
+      {
+        peak = p;
+      }
+    }
+    out->top[b] = s_top[b];
+    out->level[b] = spectrum_level(peak);
+  }
+  return 1u;
+}
+
+APP_CCM_CODE void AppSpectrum_Block(const AppStereoS24 *x, uint32_t n)
+{
+  if (!s_on)
+  {
+    s_active = 0u;
+    return;
+  }
+  if (!s_active)
+  {
+    s_active = 1u;
+    s_acc = 0;
+    s_acc_n = 0;
+    s_fill = 0;
+  }
+  if (s_filled != s_taken)
+  {
+    return;
+  }
+
+  for (uint32_t i = 0; i < n; i++)
+  {
+    s_acc += (x[i].l >> 1) + (x[i].r >> 1);
+    if (++s_acc_n < APP_SPECTRUM_DECIM)
+    {
+      continue;
+    }
+    s_win[s_fill] = (int16_t)(s_acc / (int32_t)(APP_SPECTRUM_DECIM * 256u));
+    s_acc = 0;
+    s_acc_n = 0;
+    if (++s_fill == SPECTRUM_N)
+    {
+      s_fill = 0;
+      s_filled = s_filled + 1u;
+      return;
+    }
+  }
+}
+
+static const AppMemItem k_spectrum_mem[] =
+{
+  APP_MEM_ITEM("spectrum.win", s_win),
+  APP_MEM_ITEM("spectrum.work", s_work),
+  APP_MEM_ITEM("spectrum.spec", s_spec),
+  APP_MEM_ITEM("spectrum.hann", s_hann),
+};
+
+_Static_assert((sizeof(s_win) + sizeof(s_work) + sizeof(s_spec) + sizeof(s_hann)) <= APP_SPECTRUM_RAM_BYTES,
+               "the spectrum buffers outgrew APP_SPECTRUM_RAM_BYTES");
+
+uint32_t AppSpectrum_MemMap(const AppMemItem **items)
+{
+  *items = k_spectrum_mem;
+  return (uint32_t)(sizeof(k_spectrum_mem) / sizeof(k_spectrum_mem[0]));
+}
+
+#else
+
+void AppSpectrum_Enable(uint8_t on)
+{
+  (void)on;
+}
+
+uint8_t AppSpectrum_Take(AppSpectrumFrame *out)
+{
+  (void)out;
+  return 0u;
+}
+
+void AppSpectrum_Block(const AppStereoS24 *x, uint32_t n)
+{
+  (void)x;
+  (void)n;
+}
+
+uint32_t AppSpectrum_MemMap(const AppMemItem **items)
+{
+  *items = NULL;
+  return 0u;
+}
+
+#endif /* APP_SPECTRUM_ENABLE */
@@ -0,0 +1,197 @@
+#include "app_switch.h"
+
+#include "app_dsp.h"
+#include "app_power.h"
+#include "app_preset.h"
+#include "stm32g4xx_hal.h"
+
+typedef struct
+{
+  GPIO_TypeDef *port;
+  uint16_t pin;
+  uint8_t active_high;   /* closed reads 1 (else 0, with the pull-up) */
+  uint8_t action;        /* AppSwitchAction at boot */
+} SwitchPin;
+
+/* B1 on the Nucleo has its own resistor and reads high when pressed; the
+ * jacks short a pulled-up pin to ground.
+ */
+static const SwitchPin k_switch_pins[APP_SWITCH_COUNT] = {
+  {GPIOC, GPIO_PIN_13, 1u, APP_SWITCH_PRESET_NEXT},
+  {GPIOB, GPIO_PIN_4, 0u, APP_SWITCH_PRESET_PREV},
+  {GPIOB, GPIO_PIN_5, 0u, APP_SWITCH_BYPASS},
+  {GPIOB, GPIO_PIN_7, 0u, APP_SWITCH_TAP},
+};
+
+typedef struct
+{
+  uint8_t closed;        /* debounced state */
+  uint16_t holdoff;      /* ms left before the pin is read again */
+  volatile uint32_t presses;   /* written by the tick only */
+  uint32_t handled;      /* presses the main loop has run */
+  uint32_t press_ms;     /* tick of the latest press */
+} SwitchState;
+
+static SwitchState s_sw[APP_SWITCH_COUNT];
+static uint8_t s_action[APP_SWITCH_COUNT];
+static AppFxMask s_bypass_mask;
+static uint8_t s_bypassed;
+static volatile uint8_t s_ready;   /* pins configured: the tick runs from HAL_Init() */
+
+static uint8_t pin_closed(const SwitchPin *sp)
+{
+  const uint8_t level = ((sp->port->IDR & sp->pin) != 0u) ? 1u : 0u;
+  return (level == sp->active_high) ? 1u : 0u;
+}
+
+void AppSwitch_Init(void)
+{
+  for (uint32_t i = 0; i < APP_SWITCH_COUNT; i++)
+  {
+    s_action[i] = k_switch_pins[i].action;
+  }
+#if APP_SWITCH_ENABLE
+  __HAL_RCC_GPIOB_CLK_ENABLE();
+  __HAL_RCC_GPIOC_CLK_ENABLE();
+  GPIO_InitTypeDef init = {0};
+  init.Mode = GPIO_MODE_INPUT;
+  init.Speed = GPIO_SPEED_FREQ_LOW;
+  for (uint32_t i = 0; i < APP_SWITCH_COUNT; i++)
+  {
+    init.Pin = k_switch_pins[i].pin;
+    init.Pull = k_switch_pins[i].active_high ? GPIO_NOPULL : GPIO_PULLUP;
+    HAL_GPIO_Init(k_switch_pins[i].port, &init);
+  }
+  /* A switch held through boot is not a press. */
+  for (uint32_t i = 0; i < APP_SWITCH_COUNT; i++)
+  {
+    s_sw[i].closed = pin_closed(&k_switch_pins[i]);
+  }
+  s_ready = 1u;
+#endif
+}
+
+void AppSwitch_Sample(void)
+{
+#if APP_SWITCH_ENABLE
+  if (!s_ready)
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < APP_SWITCH_COUNT; i++)
+  {
+    SwitchState *st = &s_sw[i];
+    if (st->holdoff != 0u)
+    {
+      st->holdoff--;
+      continue;
+    }
+    const uint8_t closed = pin_closed(&k_switch_pins[i]);
+    if (closed != st->closed)
+    {
+      st->closed = closed;
+      st->holdoff = APP_SWITCH_HOLDOFF_MS;
+      if (closed)
+      {
+        st->press_ms = HAL_GetTick();
+        st->presses++;
+      }
+    }
+  }
+#endif
+}
+
+/* Next stored slot from the current one in direction dir (+1 / -1). */
+static void preset_step(int32_t dir)
+{
+  const uint32_t cur = AppPreset_Current();
+  for (uint32_t k = 1; k <= APP_PRESET_COUNT; k++)
+  {
+    const uint32_t slot = (uint32_t)((int32_t)cur + (dir * (int32_t)k) + (int32_t)APP_PRESET_COUNT) % APP_PRESET_COUNT;
+    if (AppPreset_IsStored(slot))
+    {
+      if (AppPreset_Load(slot))
+      {
+        s_bypassed = 0u;   /* the preset brought its own FX mask */
+      }
+      return;
+    }
+  }
+}
+
+static void run_action(AppSwitchAction action, uint32_t press_ms)
+{
+  switch (action)
+  {
+    case APP_SWITCH_PRESET_NEXT:
+      preset_step(1);
+      break;
+    case APP_SWITCH_PRESET_PREV:
+      preset_step(-1);
+      break;
+    case APP_SWITCH_BYPASS:
+      if (s_bypassed)
+      {
+        AppPower_Boost();
+        AppDsp_SetFxMask(s_bypass_mask);
+        s_bypassed = 0u;
+      }
+      else
+      {
+        s_bypass_mask = AppDsp_GetFxMask();
+        AppDsp_SetFxMask(0u);
+        s_bypassed = 1u;
+      }
+      break;
+    case APP_SWITCH_TAP:
+      (void)AppDsp_TapTempo(press_ms);
+      break;
+    case APP_SWITCH_FREEZE:
+      AppDsp_SetParam(APP_DSP_PARAM_REVERB_FREEZE, (AppDsp_GetParam(APP_DSP_PARAM_REVERB_FREEZE) != 0) ? 0 : 1);
+      break;
+    default:
+      break;
+  }
+}
+
+void AppSwitch_Poll(void)
+{
+  for (uint32_t i = 0; i < APP_SWITCH_COUNT; i++)
+  {
+    SwitchState *st = &s_sw[i];
+    /* Presses that piled up behind a slow pass run once: a tap keeps its
+     * latest time, a preset step is not worth repeating.
+     */
+    const uint32_t presses = st->presses;
+    if (presses != st->handled)
+    {
+      st->handled = presses;
+      run_action((AppSwitchAction)s_action[i], st->press_ms);
+    }
+  }
+}
+
+uint8_t AppSwitch_SetAction(uint32_t sw, AppSwitchAction action)
+{
+  if ((sw >= APP_SWITCH_COUNT) || (action >= APP_SWITCH_ACTION_COUNT))
+  {
+    return 0u;
+  }
+  s_action[sw] = (uint8_t)action;
+  return 1u;
+}
+
+AppSwitchAction AppSwitch_GetAction(uint32_t sw)
+{
+  return (sw < APP_SWITCH_COUNT) ? (AppSwitchAction)s_action[sw] : APP_SWITCH_NONE;
+}
+
+uint32_t AppSwitch_Presses(uint32_t sw)
+{
+  return (sw < APP_SWITCH_COUNT) ? s_sw[sw].presses : 0u;
+}
+
+uint8_t AppSwitch_Pressed(uint32_t sw)
+{
+  return (sw < APP_SWITCH_COUNT) ? s_sw[sw].closed : 0u;
+}
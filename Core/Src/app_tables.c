@@ -0,0 +1,794 @@
+/* Generated by tools/dsp_host/gen_tables.c, do not edit (app_tables.h). */
+
+#include "app_tables.h"
+
+/* Waveshaper curves, sampled at x = -1 + k/256 (k = 0..512, full scale = 1)
+ * and rounded to Q15. a = 1.2M / 2^23 and b = 0.9M / 2^23 are the old hard
+ * clip knees.
+ *
+ *   soft   x - x^3/3
+ *   hard   x inside [-b, a], beyond it the knee plus 1/1024 of the excess
+ *   tube   a*tanh(x/a) for x >= 0, b*tanh(x/b) below
+ *   diode  x / (1 + |x/a|^2.5)^0.4
+ *   fuzz   a*(1 - e^(-6x/a)) for x >= 0, -0.6a*(1 - e^(6x/0.6a)) below
+ *   asym   a*tanh(x/a) for x >= 0, x / (1 + |x|/0.5a) below
+ */
+const int16_t AppTab_ShaperLut[APP_SHAPER_CURVE_COUNT][APP_SHAPER_LUT_SIZE] =
+{
+  /* soft: cubic x - x^3/3 over full scale (input colour) */
+  {
+    -21845, -21845, -21843, -21841, -21837, -21833, -21827, -21821, -21814, -21805, -21796, -21786,
+    -21774, -21762, -21749, -21735, -21720, -21704, -21687, -21669, -21651, -21631, -21610, -21589,
+    -21566, -21543, -21519, -21494, -21468, -21441, -21413, -21384, -21355, -21324, -21293, -21261,
+    -21228, -21194, -21159, -21123, -21087, -21050, -21012, -20973, -20933, -20892, -20851, -20808,
+    -20765, -20721, -20677, -20631, -20585, -20538, -20490, -20441, -20392, -20341, -20290, -20239,
+    -20186, -20133, -20078, -20024, -19968, -19912, -19855, -19797, -19738, -19679, -19619, -19558,
+    -19496, -19434, -19371, -19307, -19243, -19178, -19112, -19046, -18979, -18911, -18842, -18773,
+    -18703, -18633, -18561, -18490, -18417, -18344, -18270, -18195, -18120, -18045, -17968, -17891,
+    -17813, -17735, -17656, -17577, -17496, -17416, -17334, -17252, -17170, -17086, -17003, -16918,
+    -16833, -16748, -16662, -16575, -16488, -16400, -16312, -16223, -16134, -16044, -15953, -15862,
+    -15770, -15678, -15586, -15492, -15399, -15304, -15210, -15114, -15019, -14922, -14826, -14728,
+    -14631, -14532, -14434, -14335, -14235, -14135, -14034, -13933, -13832, -13730, -13627, -13525,
+    -13421, -13318, -13213, -13109, -13004, -12898, -12793, -12686, -12580, -12473, -12365, -12257,
+    -12149, -12040, -11931, -11822, -11712, -11602, -11491, -11380, -11269, -11157, -11045, -10933,
+    -10820, -10707, -10594, -10480, -10366, -10252, -10137, -10022, -9907, -9791, -9675, -9559,
+    -9442, -9325, -9208, -9091, -8973, -8855, -8737, -8618, -8499, -8380, -8261, -8141,
+    -8021, -7901, -7781, -7660, -7539, -7418, -7297, -7175, -7054, -6932, -6809, -6687,
+    -6564, -6442, -6319, -6195, -6072, -5948, -5825, -5701, -5577, -5452, -5328, -5203,
+    -5078, -4953, -4828, -4703, -4578, -4452, -4326, -4201, -4075, -3949, -3822, -3696,
+    -3570, -3443, -3317, -3190, -3063, -2936, -2809, -2682, -2555, -2428, -2300, -2173,
+    -2045, -1918, -1790, -1663, -1535, -1407, -1279, -1152, -1024, -896, -768, -640,
+    -512, -384, -256, -128, 0, 128, 256, 384, 512, 640, 768, 896,
+    1024, 1152, 1279, 1407, 1535, 1663, 1790, 1918, 2045, 2173, 2300, 2428,
+    2555, 2682, 2809, 2936, 3063, 3190, 3317, 3443, 3570, 3696, 3822, 3949,
+    4075, 4201, 4326, 4452, 4578, 4703, 4828, 4953, 5078, 5203, 5328, 5452,
+    5577, 5701, 5825, 5948, 6072, 6195, 6319, 6442, 6564, 6687, 6809, 6932,
+    7054, 7175, 7297, 7418, 7539, 7660, 7781, 7901, 8021, 8141, 8261, 8380,
+    8499, 8618, 8737, 8855, 8973, 9091, 9208, 9325, 9442, 9559, 9675, 9791,
+    9907, 10022, 10137, 10252, 10366, 10480, 10594, 10707, 10820, 10933, 11045, 11157,
+    11269, 11380, 11491, 11602, 11712, 11822, 11931, 12040, 12149, 12257, 12365, 12473,
+    12580, 12686, 12793, 12898, 13004, 13109, 13213, 13318, 13421, 13525, 13627, 13730,
+    13832, 13933, 14034, 14135, 14235, 14335, 14434, 14532, 14631, 14728, 14826, 14922,
+    15019, 15114, 15210, 15304, 15399, 15492, 15586, 15678, 15770, 15862, 15953, 16044,
+    16134, 16223, 16312, 16400, 16488, 16575, 16662, 16748, 16833, 16918, 17003, 17086,
+    17170, 17252, 17334, 17416, 17496, 17577, 17656, 17735, 17813, 17891, 17968, 18045,
+    18120, 18195, 18270, 18344, 18417, 18490, 18561, 18633, 18703, 18773, 18842, 18911,
+    18979, 19046, 19112, 19178, 19243, 19307, 19371, 19434, 19496, 19558, 19619, 19679,
+    19738, 19797, 19855, 19912, 19968, 20024, 20078, 20133, 20186, 20239, 20290, 20341,
+    20392, 20441, 20490, 20538, 20585, 20631, 20677, 20721, 20765, 20808, 20851, 20892,
+    20933, 20973, 21012, 21050, 21087, 21123, 21159, 21194, 21228, 21261, 21293, 21324,
+    21355, 21384, 21413, 21441, 21468, 21494, 21519, 21543, 21566, 21589, 21610, 21631,
+    21651, 21669, 21687, 21704, 21720, 21735, 21749, 21762, 21774, 21786, 21796, 21805,
+    21814, 21821, 21827, 21833, 21837, 21841, 21843, 21845, 21845
+  },
+  /* hard: the original hard_tube_clip_s24 knees (+1.2M / -0.9M, 1/1024 slope) */
+  {
+    -3544, -3544, -3544, -3544, -3544, -3544, -3543, -3543, -3543, -3543, -3543, -3543,
+    -3543, -3543, -3542, -3542, -3542, -3542, -3542, -3542, -3542, -3542, -3541, -3541,
+    -3541, -3541, -3541, -3541, -3541, -3541, -3540, -3540, -3540, -3540, -3540, -3540,
+    -3540, -3540, -3539, -3539, -3539, -3539, -3539, -3539, -3539, -3539, -3538, -3538,
+    -3538, -3538, -3538, -3538, -3538, -3538, -3537, -3537, -3537, -3537, -3537, -3537,
+    -3537, -3537, -3536, -3536, -3536, -3536, -3536, -3536, -3536, -3536, -3535, -3535,
+    -3535, -3535, -3535, -3535, -3535, -3535, -3534, -3534, -3534, -3534, -3534, -3534,
+    -3534, -3534, -3533, -3533, -3533, -3533, -3533, -3533, -3533, -3533, -3532, -3532,
+    -3532, -3532, -3532, -3532, -3532, -3532, -3531, -3531, -3531, -3531, -3531, -3531,
+    -3531, -3531, -3530, -3530, -3530, -3530, -3530, -3530, -3530, -3530, -3529, -3529,
+    -3529, -3529, -3529, -3529, -3529, -3529, -3528, -3528, -3528, -3528, -3528, -3528,
+    -3528, -3528, -3527, -3527, -3527, -3527, -3527, -3527, -3527, -3527, -3526, -3526,
+    -3526, -3526, -3526, -3526, -3526, -3526, -3525, -3525, -3525, -3525, -3525, -3525,
+    -3525, -3525, -3524, -3524, -3524, -3524, -3524, -3524, -3524, -3524, -3523, -3523,
+    -3523, -3523, -3523, -3523, -3523, -3523, -3522, -3522, -3522, -3522, -3522, -3522,
+    -3522, -3522, -3521, -3521, -3521, -3521, -3521, -3521, -3521, -3521, -3520, -3520,
+    -3520, -3520, -3520, -3520, -3520, -3520, -3519, -3519, -3519, -3519, -3519, -3519,
+    -3519, -3519, -3518, -3518, -3518, -3518, -3518, -3518, -3518, -3518, -3517, -3517,
+    -3517, -3517, -3517, -3517, -3517, -3517, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3456, -3328, -3200, -3072, -2944, -2816, -2688, -2560, -2432, -2304, -2176,
+    -2048, -1920, -1792, -1664, -1536, -1408, -1280, -1152, -1024, -896, -768, -640,
+    -512, -384, -256, -128, 0, 128, 256, 384, 512, 640, 768, 896,
+    1024, 1152, 1280, 1408, 1536, 1664, 1792, 1920, 2048, 2176, 2304, 2432,
+    2560, 2688, 2816, 2944, 3072, 3200, 3328, 3456, 3584, 3712, 3840, 3968,
+    4096, 4224, 4352, 4480, 4608, 4688, 4688, 4688, 4688, 4688, 4688, 4688,
+    4688, 4689, 4689, 4689, 4689, 4689, 4689, 4689, 4689, 4690, 4690, 4690,
+    4690, 4690, 4690, 4690, 4690, 4691, 4691, 4691, 4691, 4691, 4691, 4691,
+    4691, 4692, 4692, 4692, 4692, 4692, 4692, 4692, 4692, 4693, 4693, 4693,
+    4693, 4693, 4693, 4693, 4693, 4694, 4694, 4694, 4694, 4694, 4694, 4694,
+    4694, 4695, 4695, 4695, 4695, 4695, 4695, 4695, 4695, 4696, 4696, 4696,
+    4696, 4696, 4696, 4696, 4696, 4697, 4697, 4697, 4697, 4697, 4697, 4697,
+    4697, 4698, 4698, 4698, 4698, 4698, 4698, 4698, 4698, 4699, 4699, 4699,
+    4699, 4699, 4699, 4699, 4699, 4700, 4700, 4700, 4700, 4700, 4700, 4700,
+    4700, 4701, 4701, 4701, 4701, 4701, 4701, 4701, 4701, 4702, 4702, 4702,
+    4702, 4702, 4702, 4702, 4702, 4703, 4703, 4703, 4703, 4703, 4703, 4703,
+    4703, 4704, 4704, 4704, 4704, 4704, 4704, 4704, 4704, 4705, 4705, 4705,
+    4705, 4705, 4705, 4705, 4705, 4706, 4706, 4706, 4706, 4706, 4706, 4706,
+    4706, 4707, 4707, 4707, 4707, 4707, 4707, 4707, 4707, 4708, 4708, 4708,
+    4708, 4708, 4708, 4708, 4708, 4709, 4709, 4709, 4709, 4709, 4709, 4709,
+    4709, 4710, 4710, 4710, 4710, 4710, 4710, 4710, 4710, 4711, 4711, 4711,
+    4711, 4711, 4711, 4711, 4711, 4712, 4712, 4712, 4712, 4712, 4712, 4712,
+    4712, 4713, 4713, 4713, 4713, 4713, 4713, 4713, 4713, 4714, 4714, 4714,
+    4714, 4714, 4714, 4714, 4714, 4715, 4715, 4715, 4715
+  },
+  /* tube: tanh knee, +1.2M / -0.9M saturation */
+  {
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516,
+    -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3516, -3515, -3515,
+    -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515,
+    -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515, -3515,
+    -3515, -3515, -3515, -3515, -3514, -3514, -3514, -3514, -3514, -3514, -3514, -3514,
+    -3514, -3513, -3513, -3513, -3513, -3513, -3513, -3512, -3512, -3512, -3511, -3511,
+    -3511, -3510, -3510, -3510, -3509, -3509, -3508, -3508, -3507, -3506, -3506, -3505,
+    -3504, -3503, -3502, -3501, -3500, -3499, -3498, -3496, -3495, -3493, -3492, -3490,
+    -3488, -3486, -3484, -3481, -3479, -3476, -3473, -3470, -3466, -3463, -3459, -3454,
+    -3450, -3445, -3439, -3434, -3428, -3421, -3414, -3407, -3398, -3390, -3380, -3370,
+    -3360, -3348, -3336, -3323, -3309, -3293, -3277, -3260, -3241, -3221, -3200, -3178,
+    -3153, -3127, -3100, -3070, -3039, -3006, -2970, -2932, -2892, -2850, -2804, -2757,
+    -2706, -2652, -2595, -2536, -2473, -2406, -2336, -2263, -2187, -2106, -2022, -1935,
+    -1844, -1749, -1651, -1550, -1445, -1337, -1226, -1112, -996, -877, -756, -633,
+    -508, -382, -256, -128, 0, 128, 256, 383, 510, 636, 761, 885,
+    1008, 1129, 1249, 1367, 1483, 1597, 1710, 1819, 1927, 2032, 2135, 2235,
+    2333, 2428, 2520, 2610, 2697, 2781, 2862, 2941, 3018, 3091, 3162, 3231,
+    3297, 3360, 3421, 3480, 3536, 3590, 3642, 3692, 3739, 3785, 3828, 3870,
+    3910, 3948, 3984, 4019, 4052, 4084, 4114, 4143, 4170, 4196, 4221, 4244,
+    4267, 4288, 4309, 4328, 4346, 4364, 4381, 4396, 4411, 4426, 4439, 4452,
+    4464, 4476, 4487, 4497, 4507, 4517, 4526, 4534, 4542, 4550, 4557, 4564,
+    4570, 4576, 4582, 4588, 4593, 4598, 4603, 4607, 4611, 4615, 4619, 4623,
+    4626, 4629, 4633, 4635, 4638, 4641, 4643, 4646, 4648, 4650, 4652, 4654,
+    4656, 4657, 4659, 4660, 4662, 4663, 4664, 4666, 4667, 4668, 4669, 4670,
+    4671, 4672, 4673, 4673, 4674, 4675, 4676, 4676, 4677, 4677, 4678, 4678,
+    4679, 4679, 4680, 4680, 4681, 4681, 4681, 4682, 4682, 4682, 4683, 4683,
+    4683, 4683, 4683, 4684, 4684, 4684, 4684, 4684, 4685, 4685, 4685, 4685,
+    4685, 4685, 4685, 4686, 4686, 4686, 4686, 4686, 4686, 4686, 4686, 4686,
+    4686, 4686, 4686, 4686, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687
+  },
+  /* diode: sharper knee x / (1 + |x/a|^2.5)^0.4, symmetric */
+  {
+    -4673, -4673, -4673, -4673, -4672, -4672, -4672, -4672, -4672, -4672, -4672, -4671,
+    -4671, -4671, -4671, -4671, -4671, -4670, -4670, -4670, -4670, -4670, -4669, -4669,
+    -4669, -4669, -4669, -4668, -4668, -4668, -4668, -4668, -4667, -4667, -4667, -4667,
+    -4666, -4666, -4666, -4666, -4665, -4665, -4665, -4665, -4664, -4664, -4664, -4664,
+    -4663, -4663, -4663, -4662, -4662, -4662, -4662, -4661, -4661, -4661, -4660, -4660,
+    -4660, -4659, -4659, -4658, -4658, -4658, -4657, -4657, -4656, -4656, -4656, -4655,
+    -4655, -4654, -4654, -4653, -4653, -4652, -4652, -4651, -4651, -4650, -4650, -4649,
+    -4649, -4648, -4648, -4647, -4647, -4646, -4645, -4645, -4644, -4643, -4643, -4642,
+    -4641, -4641, -4640, -4639, -4638, -4638, -4637, -4636, -4635, -4634, -4633, -4632,
+    -4632, -4631, -4630, -4629, -4628, -4627, -4626, -4625, -4623, -4622, -4621, -4620,
+    -4619, -4618, -4616, -4615, -4614, -4612, -4611, -4609, -4608, -4606, -4605, -4603,
+    -4601, -4600, -4598, -4596, -4594, -4592, -4591, -4589, -4586, -4584, -4582, -4580,
+    -4578, -4575, -4573, -4570, -4568, -4565, -4562, -4559, -4556, -4553, -4550, -4547,
+    -4543, -4540, -4536, -4533, -4529, -4525, -4521, -4517, -4512, -4508, -4503, -4498,
+    -4493, -4488, -4482, -4477, -4471, -4465, -4459, -4452, -4445, -4438, -4431, -4423,
+    -4416, -4407, -4399, -4390, -4381, -4371, -4361, -4350, -4339, -4328, -4316, -4303,
+    -4290, -4277, -4263, -4248, -4232, -4216, -4199, -4181, -4162, -4143, -4122, -4101,
+    -4078, -4055, -4030, -4004, -3977, -3948, -3918, -3887, -3854, -3819, -3782, -3744,
+    -3704, -3661, -3617, -3571, -3522, -3471, -3417, -3361, -3302, -3240, -3176, -3109,
+    -3038, -2965, -2889, -2809, -2726, -2640, -2551, -2459, -2364, -2266, -2164, -2060,
+    -1953, -1843, -1731, -1617, -1500, -1381, -1261, -1138, -1015, -890, -765, -638,
+    -511, -384, -256, -128, 0, 128, 256, 384, 511, 638, 765, 890,
+    1015, 1138, 1261, 1381, 1500, 1617, 1731, 1843, 1953, 2060, 2164, 2266,
+    2364, 2459, 2551, 2640, 2726, 2809, 2889, 2965, 3038, 3109, 3176, 3240,
+    3302, 3361, 3417, 3471, 3522, 3571, 3617, 3661, 3704, 3744, 3782, 3819,
+    3854, 3887, 3918, 3948, 3977, 4004, 4030, 4055, 4078, 4101, 4122, 4143,
+    4162, 4181, 4199, 4216, 4232, 4248, 4263, 4277, 4290, 4303, 4316, 4328,
+    4339, 4350, 4361, 4371, 4381, 4390, 4399, 4407, 4416, 4423, 4431, 4438,
+    4445, 4452, 4459, 4465, 4471, 4477, 4482, 4488, 4493, 4498, 4503, 4508,
+    4512, 4517, 4521, 4525, 4529, 4533, 4536, 4540, 4543, 4547, 4550, 4553,
+    4556, 4559, 4562, 4565, 4568, 4570, 4573, 4575, 4578, 4580, 4582, 4584,
+    4586, 4589, 4591, 4592, 4594, 4596, 4598, 4600, 4601, 4603, 4605, 4606,
+    4608, 4609, 4611, 4612, 4614, 4615, 4616, 4618, 4619, 4620, 4621, 4622,
+    4623, 4625, 4626, 4627, 4628, 4629, 4630, 4631, 4632, 4632, 4633, 4634,
+    4635, 4636, 4637, 4638, 4638, 4639, 4640, 4641, 4641, 4642, 4643, 4643,
+    4644, 4645, 4645, 4646, 4647, 4647, 4648, 4648, 4649, 4649, 4650, 4650,
+    4651, 4651, 4652, 4652, 4653, 4653, 4654, 4654, 4655, 4655, 4656, 4656,
+    4656, 4657, 4657, 4658, 4658, 4658, 4659, 4659, 4660, 4660, 4660, 4661,
+    4661, 4661, 4662, 4662, 4662, 4662, 4663, 4663, 4663, 4664, 4664, 4664,
+    4664, 4665, 4665, 4665, 4665, 4666, 4666, 4666, 4666, 4667, 4667, 4667,
+    4667, 4668, 4668, 4668, 4668, 4668, 4669, 4669, 4669, 4669, 4669, 4670,
+    4670, 4670, 4670, 4670, 4671, 4671, 4671, 4671, 4671, 4671, 4672, 4672,
+    4672, 4672, 4672, 4672, 4672, 4673, 4673, 4673, 4673
+  },
+  /* fuzz: exponential, near-square, negative side at 60% */
+  {
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812,
+    -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2812, -2811,
+    -2811, -2811, -2810, -2809, -2808, -2807, -2806, -2803, -2801, -2797, -2792, -2785,
+    -2777, -2766, -2751, -2732, -2706, -2673, -2629, -2572, -2496, -2397, -2266, -2094,
+    -1869, -1573, -1184, -672, 0, 708, 1310, 1820, 2253, 2621, 2934, 3199,
+    3424, 3615, 3777, 3914, 4031, 4130, 4215, 4286, 4347, 4398, 4442, 4479,
+    4511, 4537, 4560, 4579, 4596, 4610, 4621, 4631, 4640, 4647, 4653, 4658,
+    4663, 4666, 4670, 4672, 4675, 4677, 4678, 4680, 4681, 4682, 4683, 4683,
+    4684, 4685, 4685, 4685, 4686, 4686, 4686, 4686, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4688, 4688, 4688, 4688, 4688, 4688, 4688,
+    4688, 4688, 4688, 4688, 4688, 4688, 4688, 4688, 4688, 4688, 4688, 4688,
+    4688, 4688, 4688, 4688, 4688, 4688, 4688, 4688, 4688
+  },
+  /* asym: tanh on +, softer 1/x knee on - (even harmonics) */
+  {
+    -2187, -2187, -2186, -2186, -2185, -2184, -2184, -2183, -2183, -2182, -2181, -2181,
+    -2180, -2180, -2179, -2178, -2178, -2177, -2176, -2176, -2175, -2174, -2174, -2173,
+    -2172, -2172, -2171, -2170, -2170, -2169, -2168, -2167, -2167, -2166, -2165, -2164,
+    -2164, -2163, -2162, -2161, -2161, -2160, -2159, -2158, -2157, -2157, -2156, -2155,
+    -2154, -2153, -2152, -2152, -2151, -2150, -2149, -2148, -2147, -2146, -2145, -2144,
+    -2144, -2143, -2142, -2141, -2140, -2139, -2138, -2137, -2136, -2135, -2134, -2133,
+    -2132, -2131, -2130, -2128, -2127, -2126, -2125, -2124, -2123, -2122, -2121, -2119,
+    -2118, -2117, -2116, -2115, -2113, -2112, -2111, -2110, -2108, -2107, -2106, -2104,
+    -2103, -2102, -2100, -2099, -2098, -2096, -2095, -2093, -2092, -2090, -2089, -2087,
+    -2086, -2084, -2083, -2081, -2079, -2078, -2076, -2074, -2073, -2071, -2069, -2067,
+    -2066, -2064, -2062, -2060, -2058, -2056, -2054, -2052, -2050, -2048, -2046, -2044,
+    -2042, -2040, -2038, -2036, -2033, -2031, -2029, -2027, -2024, -2022, -2019, -2017,
+    -2014, -2012, -2009, -2007, -2004, -2001, -1999, -1996, -1993, -1990, -1987, -1984,
+    -1981, -1978, -1975, -1972, -1968, -1965, -1962, -1958, -1955, -1951, -1948, -1944,
+    -1940, -1936, -1932, -1928, -1924, -1920, -1916, -1912, -1907, -1903, -1898, -1893,
+    -1889, -1884, -1879, -1874, -1869, -1863, -1858, -1852, -1847, -1841, -1835, -1829,
+    -1822, -1816, -1809, -1803, -1796, -1789, -1781, -1774, -1766, -1758, -1750, -1742,
+    -1733, -1725, -1716, -1706, -1697, -1687, -1676, -1666, -1655, -1644, -1632, -1620,
+    -1608, -1595, -1582, -1568, -1554, -1539, -1523, -1507, -1491, -1473, -1455, -1437,
+    -1417, -1397, -1375, -1353, -1329, -1305, -1279, -1252, -1224, -1194, -1162, -1128,
+    -1093, -1055, -1016, -973, -928, -880, -828, -772, -713, -648, -578, -503,
+    -420, -330, -231, -121, 0, 128, 256, 383, 510, 636, 761, 885,
+    1008, 1129, 1249, 1367, 1483, 1597, 1710, 1819, 1927, 2032, 2135, 2235,
+    2333, 2428, 2520, 2610, 2697, 2781, 2862, 2941, 3018, 3091, 3162, 3231,
+    3297, 3360, 3421, 3480, 3536, 3590, 3642, 3692, 3739, 3785, 3828, 3870,
+    3910, 3948, 3984, 4019, 4052, 4084, 4114, 4143, 4170, 4196, 4221, 4244,
+    4267, 4288, 4309, 4328, 4346, 4364, 4381, 4396, 4411, 4426, 4439, 4452,
+    4464, 4476, 4487, 4497, 4507, 4517, 4526, 4534, 4542, 4550, 4557, 4564,
+    4570, 4576, 4582, 4588, 4593, 4598, 4603, 4607, 4611, 4615, 4619, 4623,
+    4626, 4629, 4633, 4635, 4638, 4641, 4643, 4646, 4648, 4650, 4652, 4654,
+    4656, 4657, 4659, 4660, 4662, 4663, 4664, 4666, 4667, 4668, 4669, 4670,
+    4671, 4672, 4673, 4673, 4674, 4675, 4676, 4676, 4677, 4677, 4678, 4678,
+    4679, 4679, 4680, 4680, 4681, 4681, 4681, 4682, 4682, 4682, 4683, 4683,
+    4683, 4683, 4683, 4684, 4684, 4684, 4684, 4684, 4685, 4685, 4685, 4685,
+    4685, 4685, 4685, 4686, 4686, 4686, 4686, 4686, 4686, 4686, 4686, 4686,
+    4686, 4686, 4686, 4686, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687,
+    4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687, 4687
+  },
+};
+
+/* log2(1 + i/32), Q16 octaves. */
+const int32_t AppTab_Log2Lut[(1u << APP_TAB_LOG2_BITS) + 1u] =
+{
+  0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711,
+  27936, 30109, 32234, 34312, 36346, 38336, 40286, 42196, 44068, 45904, 47705,
+  49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047, 65536
+};
+
+/* 2^(i/32), Q15. */
+const int32_t AppTab_Exp2Lut[(1u << APP_TAB_LOG2_BITS) + 1u] =
+{
+  32768, 33486, 34219, 34968, 35734, 36516, 37316, 38133, 38968, 39821, 40693,
+  41584, 42495, 43425, 44376, 45348, 46341, 47356, 48393, 49452, 50535, 51642,
+  52773, 53928, 55109, 56316, 57549, 58809, 60097, 61413, 62757, 64132, 65536
+};
+
+/* sin(pi/2 * i/256), Q15 (unsigned: the last entry is 32768). */
+const uint16_t AppTab_SinLut[(1u << APP_TAB_SIN_BITS) + 1u] =
+{
+  0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809, 2009, 2210,
+  2411, 2611, 2811, 3012, 3212, 3412, 3612, 3812, 4011, 4211, 4410, 4609,
+  4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195, 6393, 6590, 6787, 6983,
+  7180, 7376, 7571, 7767, 7962, 8157, 8351, 8546, 8740, 8933, 9127, 9319,
+  9512, 9704, 9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+  11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+  14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269, 15447, 15624, 15800, 15976,
+  16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+  18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001,
+  20160, 20318, 20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+  22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312, 23453, 23593,
+  23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+  25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674,
+  26791, 26906, 27020, 27133, 27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+  28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+  29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+  30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050,
+  31114, 31177, 31238, 31298, 31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+  31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251,
+  32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+  32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753,
+  32758, 32762, 32766, 32767, 32768
+};
+
+/* 1 / (1 + i/256), Q30. */
+const uint32_t AppTab_RecipLut[(1u << APP_TAB_RECIP_BITS) + 1u] =
+{
+  1073741824, 1069563840, 1065418244, 1061304660, 1057222719, 1053172057, 1049152317, 1045163144,
+  1041204193, 1037275121, 1033375590, 1029505269, 1025663832, 1021850955, 1018066322, 1014309620,
+  1010580540, 1006878780, 1003204040, 999556025, 995934445, 992339014, 988769449, 985225473,
+  981706811, 978213192, 974744351, 971300025, 967879954, 964483884, 961111563, 957762742,
+  954437177, 951134626, 947854852, 944597618, 941362695, 938149853, 934958867, 931789515,
+  928641578, 925514838, 922409084, 919324103, 916259690, 913215638, 910191745, 907187812,
+  904203641, 901239039, 898293814, 895367775, 892460737, 889572514, 886702926, 883851791,
+  881018933, 878204176, 875407347, 872628276, 869866794, 867122735, 864395934, 861686229,
+  858993459, 856317467, 853658096, 851015192, 848388602, 845778175, 843183764, 840605220,
+  838042399, 835495158, 832963354, 830446849, 827945503, 825459180, 822987745, 820531066,
+  818089009, 815661445, 813248245, 810849283, 808464432, 806093569, 803736570, 801393315,
+  799063683, 796747556, 794444818, 792155351, 789879043, 787615779, 785365448, 783127940,
+  780903145, 778690955, 776491263, 774303963, 772128952, 769966126, 767815383, 765676621,
+  763549742, 761434645, 759331235, 757239413, 755159085, 753090156, 751032533, 748986122,
+  746950834, 744926577, 742913262, 740910800, 738919105, 736938088, 734967666, 733007752,
+  731058263, 729119117, 727190230, 725271522, 723362913, 721464323, 719575673, 717696885,
+  715827883, 713968589, 712118930, 710278829, 708448214, 706627010, 704815146, 703012550,
+  701219150, 699434878, 697659662, 695893435, 694136129, 692387675, 690648007, 688917060,
+  687194767, 685481065, 683775888, 682079174, 680390859, 678710881, 677039180, 675375693,
+  673720360, 672073122, 670433919, 668802693, 667179386, 665563939, 663956297, 662356402,
+  660764199, 659179633, 657602648, 656033191, 654471207, 652916644, 651369448, 649829567,
+  648296950, 646771546, 645253303, 643742171, 642238100, 640741042, 639250946, 637767766,
+  636291451, 634821956, 633359233, 631903234, 630453915, 629011229, 627575130, 626145574,
+  624722516, 623305911, 621895717, 620491889, 619094385, 617703162, 616318177, 614939389,
+  613566757, 612200238, 610839793, 609485381, 608136962, 606794497, 605457945, 604127268,
+  602802428, 601483385, 600170102, 598862542, 597560667, 596264440, 594973825, 593688784,
+  592409282, 591135284, 589866753, 588603655, 587345955, 586093618, 584846611, 583604898,
+  582368447, 581137224, 579911196, 578690330, 577474594, 576263956, 575058383, 573857843,
+  572662306, 571471740, 570286114, 569105397, 567929560, 566758571, 565592401, 564431020,
+  563274399, 562122509, 560975320, 559832804, 558694933, 557561677, 556433010, 555308903,
+  554189329, 553074259, 551963669, 550857529, 549755814, 548658497, 547565552, 546476952,
+  545392673, 544312687, 543236970, 542165497, 541098242, 540035181, 538976288, 537921540,
+  536870912
+};
+
+/* Amp tone stacks: the passive network bilinear-transformed at the build
+ * rate on a 9 x 9 grid of bass (audio taper) and mid knob positions,
+ * treble as b + t * bt. Makeup puts the peak at noon on 0 dB.
+ */
+const AppTabToneNode AppTab_ToneLut[APP_DSP_TONE_MODEL_COUNT - 1u][APP_TAB_TONE_GRID][APP_TAB_TONE_GRID] =
+{
+#if APP_DSP_SAMPLE_RATE_HZ == 96000u
+  /* fender: '59 Bassman, makeup +4.4 dB */
+  {
+    {
+      {1069352531, {-483161803, 216493065}, {2858035, 314736, -2543299}, {408826083, -802106776, 393352650}},
+      {1069492459, {-482482133, 215973641}, {30125276, -49896192, 20510056}, {383656321, -750897763, 367317423}},
+      {1069626000, {-481369796, 215076691}, {54227854, -93967961, 40616223}, {361407788, -705139436, 343813468}},
+      {1069753261, {-479655054, 213658171}, {75685634, -132761510, 58130744}, {341600606, -663703117, 322192763}},
+      {1069874422, {-477020031, 211447026}, {94909909, -166845610, 73236982}, {323855122, -625518201, 301765801}},
+      {1069989711, {-472816622, 207889432}, {112229636, -196434083, 85871477}, {307867681, -589347250, 281601713}},
+      {1070099384, {-465517069, 201678696}, {127909139, -221082348, 95446031}, {293394294, -553221431, 259982512}},
+      {1070203715, {-450503160, 188863487}, {142156192, -238349108, 99675197}, {280243168, -512285935, 232265875}},
+      {1070302979, {-404399047, 149441335}, {155090465, -234147452, 86190929}, {268303839, -443696121, 175822348}},
+    },
+    {
+      {1069518194, {-485356000, 218349232}, {2870214, 316077, -2554137}, {408814840, -805533085, 396774237}},
+      {1069643615, {-485199655, 218276942}, {30138850, -50177420, 20744416}, {383643792, -754859647, 371273381}},
+      {1069764216, {-484816264, 218002783}, {54243469, -94639047, 41188787}, {361393374, -709853549, 348520040}},
+      {1069879933, {-484162859, 217491112}, {75704289, -134003151, 59198231}, {341583387, -669512551, 327992366}},
+      {1069990784, {-483164929, 216678997}, {94933279, -168980815, 75079621}, {323833549, -633007558, 309241865}},
+      {1070096852, {-481694845, 215457783}, {112260835, -200093953, 89036912}, {307838882, -599614289, 291849761}},
+      {1070198265, {-479526119, 213633920}, {127954846, -227678064, 101159057}, {293352103, -568637885, 275369406}},
+      {1070295179, {-476226599, 210837438}, {142234448, -251831619, 111365450}, {280170931, -539293977, 259220471}},
+      {1070387772, {-470870427, 206275041}, {155279751, -272228766, 119235297}, {268129114, -510438669, 242429067}},
+    },
+    {
+      {1069800586, {-487503773, 220166227}, {2882300, 317408, -2564892}, {408803684, -808932970, 400169437}},
+      {1069903018, {-487725483, 220417859}, {30151612, -50441845, 20964772}, {383632011, -758584804, 374992967}},
+      {1070002818, {-487822804, 220555458}, {54257223, -95230159, 41693119}, {361380678, -714005883, 352665732}},
+      {1070099735, {-487795515, 220580006}, {75719443, -135011788, 60065395}, {341569398, -674231800, 332703630}},
+      {1070193607, {-487636899, 220486662}, {94950399, -170544933, 76429424}, {323817747, -638493792, 314718360}},
+      {1070284337, {-487332553, 220263792}, {112280751, -202430258, 91057591}, {307820498, -606168329, 298391678}},
+      {1070371886, {-486857946, 219890923}, {127978866, -231144340, 104161451}, {293329930, -576739764, 283455752}},
+      {1070456259, {-486173969, 219334938}, {142264806, -257061824, 115900394}, {280142909, -549771076, 269676837}},
+      {1070537492, {-485218861, 218543172}, {155320703, -280467770, 126384542}, {268091312, -524878614, 256839626}},
+    },
+    {
+      {1070255547, {-489272064, 221662368}, {2892553, 318537, -2574016}, {408794220, -811817378, 403049871}},
+      {1070326111, {-489713786, 222103336}, {30161928, -50655583, 21142889}, {383622488, -761595893, 377999553}},
+      {1070396320, {-490068930, 222462668}, {54267739, -95682142, 42078747}, {361370971, -717180883, 355835653}},
+      {1070465861, {-490347365, 222750024}, {75730305, -135734808, 60687004}, {341559371, -677614693, 336080799}},
+      {1070534472, {-490556075, 222972335}, {94961771, -171583969, 77326091}, {323807249, -642138271, 318356370}},
+      {1070601943, {-490699659, 223134300}, {112292826, -203846738, 92282710}, {307809352, -610141984, 302357982}},
+      {1070668103, {-490780633, 223238680}, {127991883, -233022764, 105788490}, {293317914, -581130286, 287837856}},
+      {1070732822, {-490799553, 223286443}, {142279076, -259520301, 118032060}, {280129737, -554695874, 274591890}},
+      {1070796004, {-490754998, 223276767}, {155336647, -283675413, 129167916}, {268076594, -530500434, 262450005}},
+    },
+    {
+      {1070905165, {-490505481, 222706227}, {2900157, 319375, -2580783}, {408787200, -813956619, 405186165}},
+      {1070941972, {-491055193, 223240695}, {30169295, -50808212, 21270082}, {383615688, -763746100, 380146544}},
+      {1070979582, {-491529169, 223702811}, {54274943, -95991763, 42342913}, {361364321, -719355853, 358007144}},
+      {1071017820, {-491939022, 224103746}, {75737413, -136207903, 61093741}, {341552810, -679828225, 338290585}},
+      {1071056522, {-492293869, 224452274}, {94968843, -172230103, 77883690}, {323800721, -644404620, 320618697}},
+      {1071095532, {-492600924, 224755354}, {112299920, -204678854, 93002411}, {307802804, -612476320, 304688001}},
+      {1071134709, {-492865939, 225018538}, {127999055, -234057660, 106684887}, {293311294, -583549192, 290252124}},
+      {1071173919, {-493093507, 225246279}, {142286384, -260779318, 119123714}, {280122991, -557217925, 277108950}},
+      {1071213045, {-493287300, 225442143}, {155344152, -285185412, 130478191}, {268069666, -533146908, 265091093}},
+    },
+    {
+      {1071662961, {-491251420, 223337822}, {2905253, 319936, -2585317}, {408782496, -815390199, 406617770}},
+      {1071676481, {-491847461, 223912730}, {30174102, -50907820, 21353089}, {383611251, -765149347, 381547692}},
+      {1071690602, {-492370489, 224417593}, {54279514, -96188225, 42510532}, {361360101, -720735918, 359385002}},
+      {1071705291, {-492832345, 224863785}, {75741791, -136499254, 61344227}, {341548769, -681191411, 339651465}},
+      {1071720509, {-493242396, 225260307}, {94973062, -172615549, 78216323}, {323796827, -645756595, 321968271}},
+      {1071736219, {-493608156, 225614375}, {112304010, -205158645, 93417384}, {307799028, -613822278, 306031470}},
+      {1071752381, {-493935709, 225931840}, {128003042, -234633015, 107183244}, {293307614, -584893995, 291594348}},
+      {1071768954, {-494230042, 226217493}, {142290290, -261452385, 119707308}, {280119385, -558566206, 278454564}},
+      {1071785898, {-494495271, 226475290}, {155347999, -285959256, 131149680}, {268066116, -534503172, 266444597}},
+    },
+    {
+      {1072359333, {-491662324, 223685962}, {2908440, 320287, -2588154}, {408779554, -816286767, 407513102}},
+      {1072362983, {-492275823, 224276303}, {30177058, -50969059, 21404122}, {383608522, -766012074, 382409129}},
+      {1072366836, {-492816967, 224797132}, {54282275, -96306891, 42611777}, {361357553, -721569497, 360217247}},
+      {1072370888, {-493297622, 225259851}, {75744386, -136672031, 61492770}, {341546373, -681999806, 340458491}},
+      {1072375138, {-493727185, 225673492}, {94975516, -172839807, 78409853}, {323794561, -646543192, 322753473}},
+      {1072379582, {-494113197, 226045301}, {112306343, -205432316, 93654083}, {307796875, -614590008, 306797779}},
+      {1072384218, {-494461776, 226381157}, {128005270, -234954499, 107461705}, {293305558, -585645414, 292344327}},
+      {1072389041, {-494777940, 226685883}, {142292427, -261820481, 120026473}, {280117413, -559303573, 279190471}},
+      {1072394047, {-495065843, 226963471}, {155350056, -286373106, 131508790}, {268064217, -535228498, 267168446}},
+    },
+    {
+      {1072884057, {-491881338, 223871644}, {2910348, 320497, -2589851}, {408777793, -816823478, 408049074}},
+      {1072884867, {-492500792, 224467366}, {30178809, -51005338, 21434355}, {383606906, -766523165, 382919455}},
+      {1072885724, {-493048030, 224993671}, {54283894, -96376444, 42671119}, {361356059, -722058084, 360705053}},
+      {1072886628, {-493534923, 225461971}, {75745891, -136772204, 61578893}, {341544984, -682468500, 340926393}},
+      {1072887578, {-493970874, 225881305}, {94976924, -172968389, 78520817}, {323793262, -646994203, 323203683}},
+      {1072888576, {-494363426, 226258925}, {112307665, -205587455, 93788264}, {307795654, -615025221, 307232188}},
+      {1072889621, {-494718705, 226600717}, {128006518, -235134636, 107617735}, {293304405, -586066457, 292764562}},
+      {1072890713, {-495041730, 226911508}, {142293610, -262024297, 120203195}, {280116321, -559711855, 279597945}},
+      {1072891852, {-495336662, 227195297}, {155351181, -286599483, 131705225}, {268063178, -535625253, 267564394}},
+    },
+    {
+      {1073231769, {-491998580, 223971094}, {2911460, 320619, -2590841}, {408776767, -817136390, 408361554}},
+      {1073231931, {-492619982, 224568643}, {30179824, -51026360, 21451873}, {383605970, -766819310, 383215157}},
+      {1073232102, {-493169189, 225096779}, {54284826, -96416496, 42705291}, {361355198, -722339430, 360985949}},
+      {1073232282, {-493658075, 225566917}, {75746753, -136829525, 61628174}, {341544189, -682736693, 341194132}},
+      {1073232472, {-494096043, 225988099}, {94977724, -173041497, 78583907}, {323792523, -647250633, 323459657}},
+      {1073232671, {-494490640, 226367580}, {112308413, -205675094, 93864062}, {307794964, -615271074, 307477585}},
+      {1073232879, {-494847990, 226711250}, {128007219, -235235731, 107705300}, {293303759, -586302750, 293000402}},
+      {1073233097, {-495173117, 227023938}, {142294270, -262137924, 120301717}, {280115712, -559939472, 279825112}},
+      {1073233324, {-495470180, 227309643}, {155351804, -286724842, 131814003}, {268062603, -535844962, 267783656}},
+    },
+  },
+  /* marshall: JCM800, makeup +3.4 dB */
+  {
+    {
+      {1067423227, {-497569997, 230338035}, {3579756, 272548, -3307208}, {376536399, -738399708, 361967824}},
+      {1067686070, {-496868381, 229724505}, {37081134, -63011686, 26552851}, {344641586, -674191174, 329657087}},
+      {1067935617, {-495709116, 228690933}, {65347804, -116029107, 51400874}, {317730449, -619582631, 301965282}},
+      {1068171358, {-493936100, 227096224}, {89516755, -160836551, 72167052}, {294720525, -572290931, 277692564}},
+      {1068393316, {-491247066, 224666145}, {110417233, -198806965, 89413425}, {274822334, -530505424, 255819417}},
+      {1068601864, {-487023761, 220838976}, {128667517, -230698721, 103316290}, {257447245, -492572706, 235284456}},
+      {1068797585, {-479826971, 214306377}, {144736044, -256430809, 113409292}, {242149287, -456490266, 214539055}},
+      {1068981184, {-465431259, 201226382}, {158977452, -273824093, 117401394}, {228590829, -418319908, 190005888}},
+      {1069153416, {-423941861, 163508665}, {171625359, -269886780, 103208349}, {216549455, -362250219, 146205413}},
+    },
+    {
+      {1067829763, {-499962447, 232500971}, {3596805, 273846, -3322959}, {376520167, -741929522, 365488496}},
+      {1068046270, {-499838678, 232412759}, {37099357, -63397547, 26890402}, {344624236, -678153779, 333608569}},
+      {1068255505, {-499474040, 232101465}, {65368009, -116924295, 52202841}, {317711213, -624170606, 306539539}},
+      {1068456289, {-498843102, 231544785}, {89540094, -162449683, 73623367}, {294698305, -577799236, 283183539}},
+      {1068647966, {-497890631, 230693067}, {110445550, -201509164, 91862151}, {274795375, -537423657, 262714948}},
+      {1068830269, {-496516481, 229455629}, {128704115, -235203439, 107407524}, {257412402, -501797520, 244477910}},
+      {1069003204, {-494542778, 227670939}, {144787773, -264291627, 120558952}, {242100039, -469903255, 227905050}},
+      {1069166969, {-491639785, 225039177}, {159062028, -289211972, 131411428}, {228510309, -440823615, 212428676}},
+      {1069321886, {-487138839, 220952009}, {171813704, -309988898, 139747132}, {216370142, -413562846, 197329303}},
+    },
+    {
+      {1068483782, {-502144661, 234474106}, {3612841, 275067, -3337774}, {376504901, -745249359, 368799735}},
+      {1068635720, {-502411051, 234741114}, {37115553, -63740463, 27190384}, {344608818, -681675353, 337120258}},
+      {1068786765, {-502532714, 234872444}, {65384780, -117667354, 52868520}, {317695246, -627978895, 310336441}},
+      {1068935517, {-502522372, 234880515}, {89557906, -163680724, 74734735}, {294681348, -582002830, 287373906}},
+      {1069080907, {-502383904, 234769467}, {110464977, -203363014, 93542105}, {274776879, -542169925, 267445640}},
+      {1069222160, {-502113040, 234535863}, {128725938, -237889591, 109847116}, {257391626, -507298252, 249959941}},
+      {1069358745, {-501696764, 234168189}, {144813144, -268147121, 124065645}, {242075885, -476481920, 234460667}},
+      {1069490332, {-501111234, 233644992}, {159092799, -294810512, 136508669}, {228481013, -449011090, 220586710}},
+      {1069616747, {-500317578, 232931068}, {171853174, -318392742, 147404240}, {216332565, -424315976, 208042881}},
+    },
+    {
+      {1069422205, {-503806595, 235977218}, {3625806, 276054, -3349752}, {376492557, -747933483, 371476908}},
+      {1069504233, {-504288923, 236441222}, {37128028, -64004609, 27421458}, {344596941, -684388005, 339825296}},
+      {1069588812, {-504658618, 236798730}, {65397005, -118209001, 53353763}, {317683607, -630754923, 313104168}},
+      {1069675117, {-504936245, 237069314}, {89570090, -164522822, 75494971}, {294669748, -584878314, 290240343}},
+      {1069762389, {-505136186, 237266689}, {110477316, -204540488, 94609129}, {274765132, -545184523, 270450345}},
+      {1069849954, {-505268444, 237400424}, {128738632, -239452051, 111266159}, {257379540, -510497876, 253148688}},
+      {1069937224, {-505339761, 237477007}, {144826412, -270163328, 125899449}, {242063253, -479922195, 237888889}},
+      {1070023704, {-505354305, 237500504}, {159106897, -297375501, 138843987}, {228467591, -452762209, 224324342}},
+      {1070108986, {-505314080, 237472948}, {171868421, -321639234, 150362260}, {216318049, -428470022, 212181648}},
+    },
+    {
+      {1070534597, {-504883064, 236951268}, {3635066, 276759, -3358307}, {376483741, -749850567, 373389027}},
+      {1070566155, {-505466360, 237507629}, {37136620, -64186538, 27580610}, {344588760, -686256327, 341688374}},
+      {1070599741, {-505945985, 237965620}, {65405099, -118567575, 53674997}, {317675902, -632592668, 314936418}},
+      {1070635168, {-506343649, 238345871}, {89577813, -165056646, 75976901}, {294662395, -586701145, 292057438}},
+      {1070672232, {-506675139, 238663383}, {110484773, -205252139, 95254025}, {274758032, -547006507, 272266350}},
+      {1070710725, {-506952184, 238929307}, {128745910, -240347790, 112079679}, {257372612, -512332183, 254976759}},
+      {1070750436, {-507183651, 239152073}, {144833583, -271253082, 126890613}, {242056426, -481781651, 239741830}},
+      {1070791153, {-507376339, 239338147}, {159114029, -298673053, 140025354}, {228460801, -454659788, 226215097}},
+      {1070832671, {-507535513, 239492542}, {171875576, -323162651, 151750312}, {216311237, -430419309, 214123766}},
+    },
+    {
+      {1071581479, {-505505462, 237514802}, {3641110, 277219, -3363890}, {376477987, -751101838, 374637057}},
+      {1071590371, {-506129172, 238108282}, {37142092, -64302392, 27681959}, {344583551, -687446094, 342874802}},
+      {1071599987, {-506651512, 238605455}, {65410120, -118790060, 53874313}, {317671122, -633732936, 316073278}},
+      {1071610314, {-507094339, 239027093}, {89582476, -165378893, 76267821}, {294657956, -587801511, 293154342}},
+      {1071621333, {-507473598, 239388350}, {110489146, -205669414, 95632159}, {274753869, -548074825, 273331162}},
+      {1071633025, {-507801193, 239700538}, {128750047, -240857038, 112542183}, {257368673, -513375026, 256016056}},
+      {1071645365, {-508086188, 239972272}, {144837528, -271852612, 127435905}, {242052670, -482804637, 240761231}},
+      {1071658328, {-508335606, 240210227}, {159117818, -299362335, 140652917}, {228457195, -455667815, 227219500}},
+      {1071671884, {-508554970, 240419650}, {171879237, -323942168, 152460563}, {216307751, -431416739, 215117526}},
+    },
+    {
+      {1072388341, {-505847354, 237824556}, {3644826, 277502, -3367324}, {376474449, -751871193, 375404420}},
+      {1072390374, {-506485426, 238431322}, {37145404, -64372527, 27743313}, {344580398, -688166346, 343593032}},
+      {1072392580, {-507022635, 238942217}, {65413112, -118922600, 53993051}, {317668273, -634412228, 316750538}},
+      {1072394962, {-507480866, 239378045}, {89585208, -165567706, 76438279}, {294655355, -588446244, 293797046}},
+      {1072397519, {-507876092, 239753989}, {110491665, -205909748, 95849948}, {274751471, -548690132, 273944451}},
+      {1072400251, {-508220241, 240081388}, {128752388, -241145183, 112803880}, {257366444, -513965092, 256604116}},
+      {1072403158, {-508522402, 240368880}, {144839720, -272185662, 127738825}, {242050583, -483372922, 241327526}},
+      {1072406239, {-508789621, 240623164}, {159119882, -299738016, 140994960}, {228455229, -456217223, 227766932}},
+      {1072409493, {-509027444, 240849512}, {171881194, -324358716, 152840099}, {216305889, -431949733, 215648560}},
+    },
+    {
+      {1072931858, {-506033532, 237993319}, {3647027, 277670, -3369358}, {376472353, -752326991, 375859038}},
+      {1072932271, {-506676429, 238604603}, {37147348, -64413691, 27779323}, {344578547, -688589076, 344014575}},
+      {1072932720, {-507218544, 239120073}, {65414851, -118999652, 54062079}, {317666618, -634807130, 317144260}},
+      {1072933203, {-507681771, 239560545}, {89586780, -165676409, 76536415}, {294653858, -588817428, 294167063}},
+      {1072933723, {-508082092, 239941213}, {110493100, -206046747, 95974097}, {274750104, -549040881, 274294048}},
+      {1072934278, {-508431442, 240273424}, {128753709, -241307783, 112951555}, {257365187, -514298067, 256935960}},
+      {1072934869, {-508738915, 240565824}, {144840944, -272371675, 127908009}, {242049418, -483690318, 241643809}},
+      {1072935497, {-509011563, 240825115}, {159121024, -299945644, 141183996}, {228454142, -456520864, 228069481}},
+      {1072936161, {-509254936, 241056577}, {171882263, -324586471, 153047616}, {216304870, -432241157, 215938912}},
+    },
+    {
+      {1073269998, {-506135614, 238085885}, {3648303, 277767, -3370536}, {376471139, -752591106, 376122468}},
+      {1073270077, {-506780122, 238698708}, {37148469, -64437413, 27800075}, {344577480, -688832690, 344257505}},
+      {1073270162, {-507323847, 239215706}, {65415847, -119043811, 54101639}, {317665669, -635033449, 317369902}},
+      {1073270254, {-507788689, 239657703}, {89587677, -165738359, 76592343}, {294653004, -589028966, 294377935}},
+      {1073270353, {-508190634, 240039897}, {110493914, -206124382, 96044449}, {274749330, -549239643, 274492158}},
+      {1073270459, {-508541620, 240373639}, {128754453, -241399400, 113034763}, {257364478, -514485681, 257122936}},
+      {1073270571, {-508850743, 240667579}, {144841630, -272475877, 128002785}, {242048765, -483868120, 241820989}},
+      {1073270690, {-509125057, 240928422}, {159121659, -300061276, 141289275}, {228453537, -456689968, 228237977}},
+      {1073270816, {-509370114, 241161448}, {171882855, -324712564, 153162505}, {216304307, -432402499, 216099660}},
+    },
+  },
+#else
+  /* fender: '59 Bassman, makeup +4.4 dB */
+  {
+    {
+      {1064981143, {-436160172, 174139308}, {5437657, 1135123, -4302535}, {375641274, -723119882, 347738124}},
+      {1065259878, {-434766549, 173318536}, {31957994, -43935509, 14640043}, {352909557, -676117465, 323481606}},
+      {1065525922, {-432574155, 171891192}, {55444766, -83272889, 30977771}, {332778038, -633636033, 301152135}},
+      {1065779486, {-429273387, 169634744}, {76387261, -117535756, 44929117}, {314827328, -594552579, 280048713}},
+      {1066020924, {-424294489, 166135779}, {95172785, -147048804, 56517842}, {298725450, -557686875, 259327846}},
+      {1066250686, {-416500529, 160565823}, {112109586, -171656266, 65448826}, {284208193, -521486372, 237710635}},
+      {1066469280, {-403294216, 151028756}, {127439895, -190203162, 70707250}, {271067928, -483202237, 212677376}},
+      {1066677245, {-377235183, 132088877}, {141335279, -198477210, 69000827}, {259157599, -435862136, 177464334}},
+      {1066875129, {-305076128, 79450938}, {153797130, -176331852, 45053599}, {248476012, -349631762, 102513290}},
+    },
+    {
+      {1065311145, {-440371605, 177144235}, {5483159, 1144621, -4338538}, {375602273, -729200250, 353800744}},
+      {1065561017, {-439966066, 177043248}, {32008624, -44456396, 15003162}, {352866160, -683131591, 330473694}},
+      {1065801316, {-439141113, 176611962}, {55502850, -84521114, 31887969}, {332728252, -641953085, 309441414}},
+      {1066031907, {-437815043, 175794132}, {76456356, -119839630, 46633231}, {314768104, -604751581, 290211865}},
+      {1066252825, {-435849055, 174490872}, {95258779, -150987442, 59451518}, {298651741, -570741742, 272334765}},
+      {1066464233, {-433008896, 172532716}, {112223226, -178340483, 70448028}, {284110787, -539192842, 255349552}},
+      {1066666380, {-428884899, 169621093}, {127603601, -202048656, 79590567}, {270927608, -509333912, 238705984}},
+      {1066859579, {-422709160, 165194323}, {141606753, -221927874, 86620694}, {258924906, -480184277, 221606454}},
+      {1067044180, {-412876556, 158076357}, {154399980, -237135176, 90803040}, {247959284, -450151592, 202614046}},
+    },
+    {
+      {1065873788, {-444526614, 180109216}, {5528678, 1154123, -4374555}, {375563256, -735283077, 359865816}},
+      {1066077912, {-444845136, 180538700}, {32056696, -44950965, 15347935}, {352824955, -689791331, 337112511}},
+      {1066276809, {-444937459, 180779041}, {55554626, -85633794, 32699328}, {332683872, -649366982, 316830556}},
+      {1066469980, {-444800950, 180831930}, {76513331, -121739388, 48038431}, {314719268, -613161608, 298592330}},
+      {1066657095, {-444421250, 180689666}, {95323007, -153929162, 61642643}, {298596689, -580492260, 282049470}},
+      {1066837965, {-443769953, 180333633}, {112297705, -182721285, 73724480}, {284046948, -550797574, 266910009}},
+      {1067012508, {-442800066, 179731081}, {127692999, -208517350, 84441649}, {270850981, -523604132, 252919920}},
+      {1067180732, {-441437847, 178829201}, {141718928, -231617839, 93901335}, {258828757, -498498469, 239846261}},
+      {1067342709, {-439568188, 177544426}, {154549605, -252226397, 102157927}, {247831033, -475100342, 227458783}},
+    },
+    {
+      {1066780572, {-447971835, 182568280}, {5567588, 1162246, -4405342}, {375529905, -740482645, 365050208}},
+      {1066921247, {-448717512, 183313477}, {32095888, -45354183, 15629025}, {352791362, -695220947, 342525068}},
+      {1067061223, {-449309398, 183922595}, {55594611, -86493064, 33325902}, {332649600, -655092383, 322536838}},
+      {1067199877, {-449763993, 184411435}, {76554648, -123117070, 49057466}, {314683853, -619260458, 304669742}},
+      {1067336687, {-450092821, 184791379}, {95366264, -155910420, 63118373}, {298559611, -587059264, 288592355}},
+      {1067471230, {-450303240, 185070168}, {112343620, -185421973, 75744355}, {284007592, -557951688, 274036830}},
+      {1067603168, {-450398913, 185252377}, {127742459, -212096189, 87125534}, {270808587, -531499204, 260783853}},
+      {1067732241, {-450379984, 185339642}, {141773080, -236295660, 97416058}, {258782340, -507339628, 248651510}},
+      {1067858255, {-450242990, 185330665}, {154609999, -258317678, 106741109}, {247779267, -485170425, 237486883}},
+    },
+    {
+      {1068075990, {-450387773, 184293546}, {5596620, 1168306, -4428314}, {375505020, -744362293, 368918532}},
+      {1068149412, {-451345613, 185197471}, {32124061, -45644028, 15831081}, {352767214, -699123929, 346415787}},
+      {1068224436, {-452170683, 185980704}, {55622201, -87085986, 33758257}, {332625951, -659043083, 326474346}},
+      {1068300717, {-452882862, 186661577}, {76581902, -124025815, 49729640}, {314660493, -623283372, 308678515}},
+      {1068377927, {-453497786, 187254542}, {95393406, -157153575, 64044331}, {298536346, -591179781, 292697737}},
+      {1068455755, {-454027855, 187771092}, {112370865, -187024541, 76942934}, {283984239, -562196885, 278265831}},
+      {1068533916, {-454482957, 188220429}, {127770020, -214090490, 88621125}, {270784963, -535898721, 265166017}},
+      {1068612148, {-454870989, 188609946}, {141801176, -238722653, 99239601}, {258758258, -511926684, 253219936}},
+      {1068690214, {-455198242, 188945583}, {154638862, -261228791, 108931480}, {247754527, -489983066, 242279460}},
+    },
+    {
+      {1069588120, {-451853694, 185341325}, {5616160, 1172385, -4443775}, {375488272, -746973399, 371522015}},
+      {1069615107, {-452903454, 186315133}, {32142531, -45834050, 15963548}, {352751382, -701682706, 348966525}},
+      {1069643296, {-453825756, 187172053}, {55639793, -87464037, 34033929}, {332610872, -661562071, 328984923}},
+      {1069672616, {-454640921, 187930776}, {76598773, -124588354, 50145735}, {314646032, -625773673, 311160063}},
+      {1069702996, {-455365088, 188606148}, {95409687, -157899266, 64599755}, {298522391, -593651422, 295160301}},
+      {1069734357, {-456011237, 189210112}, {112386668, -187954030, 77638110}, {283970694, -564659098, 280718651}},
+      {1069766620, {-456589917, 189752377}, {127785440, -215206268, 89457883}, {270771746, -538360174, 267617762}},
+      {1069799706, {-457109787, 190240914}, {141816298, -240028983, 100221123}, {258745296, -514395669, 255678892}},
+      {1069833533, {-457578013, 190682325}, {154653763, -262731697, 110062291}, {247741755, -492467664, 244753700}},
+    },
+    {
+      {1070978621, {-452662534, 185920159}, {5628415, 1174944, -4453471}, {375477768, -748610997, 373154834}},
+      {1070985912, {-453747261, 186921210}, {32153919, -45951218, 16045227}, {352741621, -703260456, 350539318}},
+      {1070993607, {-454705797, 187806201}, {55650451, -87693076, 34200944}, {332601736, -663088184, 330505940}},
+      {1071001701, {-455558519, 188593885}, {76608809, -124922999, 50393263}, {314637430, -627255112, 312636294}},
+      {1071010190, {-456321629, 189299172}, {95419191, -158334538, 64923965}, {298514245, -595094158, 296597737}},
+      {1071019067, {-457008165, 189934061}, {112395712, -188486009, 78035983}, {283962941, -566068310, 282122485}},
+      {1071028327, {-457628743, 190508322}, {127794087, -215831924, 89927082}, {270764334, -539740398, 268992542}},
+      {1071037961, {-458192089, 191029985}, {141824599, -240746041, 100759891}, {258738181, -515750920, 257028639}},
+      {1071047961, {-458705443, 191505716}, {154661762, -263538537, 110669371}, {247734898, -493801529, 246082004}},
+    },
+    {
+      {1072026976, {-453093939, 186229274}, {5635763, 1176478, -4459286}, {375471469, -749593009, 374133980}},
+      {1072028594, {-454190739, 187240128}, {32160678, -46020752, 16093701}, {352735828, -704196792, 351472712}},
+      {1072030306, {-455161599, 188135028}, {55656709, -87827567, 34299013}, {332596372, -663984309, 331399072}},
+      {1072032112, {-456026913, 188932752}, {76614639, -125117381, 50537042}, {314632433, -628115617, 313493775}},
+      {1072034012, {-456802893, 189648228}, {95424650, -158584582, 65110209}, {298509566, -595922943, 297423478}},
+      {1072036006, {-457502591, 190293476}, {112400849, -188788163, 78261967}, {283958538, -566868715, 282919838}},
+      {1072038094, {-458136631, 190878279}, {127798941, -216183191, 90190509}, {270760173, -540515309, 269764397}},
+      {1072040276, {-458713751, 191410682}, {141829205, -241143882, 101058813}, {258734233, -516502847, 257777512}},
+      {1072042553, {-459241202, 191897362}, {154666147, -263980797, 111002135}, {247731140, -494532672, 246810099}},
+    },
+    {
+      {1072721957, {-453324928, 186394951}, {5640052, 1177373, -4462679}, {375467793, -750166127, 374705425}},
+      {1072722280, {-454425752, 187409299}, {32164598, -46061085, 16121818}, {352732467, -704739905, 352014119}},
+      {1072722622, {-455400664, 188307661}, {55660317, -87905093, 34355545}, {332593280, -664500873, 331913911}},
+      {1072722982, {-456270064, 189108828}, {76617978, -125228727, 50619402}, {314629571, -628608535, 313984960}},
+      {1072723361, {-457050168, 189827741}, {95427758, -158726902, 65216215}, {298506902, -596394673, 297893476}},
+      {1072723759, {-457754034, 190476425}, {112403754, -188959037, 78389766}, {283956048, -567321360, 283370756}},
+      {1072724176, {-458392290, 191064673}, {127801669, -216380545, 90338511}, {270757836, -540950680, 270198051}},
+      {1072724611, {-458973676, 191600535}, {141831775, -241365928, 101225649}, {258732030, -516922517, 258195478}},
+      {1072725065, {-459505445, 192090694}, {154668578, -264225984, 111186618}, {247729056, -494938014, 247213751}},
+    },
+  },
+  /* marshall: JCM800, makeup +3.4 dB */
+  {
+    {
+      {1061141704, {-461466491, 197511967}, {6897595, 1011793, -5885802}, {356291624, -685153449, 329249821}},
+      {1061664373, {-460095609, 196462845}, {39686789, -57546623, 20167321}, {326503345, -624826776, 298722038}},
+      {1062160723, {-457873744, 194697236}, {67407395, -106345902, 41601355}, {301319769, -573050675, 272149442}},
+      {1062629717, {-454518424, 191984554}, {91146699, -147165015, 59143959}, {279753121, -527646316, 248343856}},
+      {1063071384, {-449490729, 187881521}, {111699334, -181080180, 73139535}, {261081492, -486775966, 226195025}},
+      {1063486449, {-441710177, 181496773}, {129657032, -208435233, 83461608}, {244767309, -448569767, 204381909}},
+      {1063876060, {-428736429, 170814761}, {145463182, -228388957, 89095799}, {230407761, -410422599, 180727650}},
+      {1064241604, {-403766633, 150214392}, {159435879, -236933287, 86465172}, {217713866, -366735114, 149992910}},
+      {1064584574, {-338264626, 96113499}, {171700924, -215065612, 59578787}, {206571336, -296208464, 91291171}},
+    },
+    {
+      {1061950164, {-466039732, 201246496}, {6962019, 1021243, -5940776}, {356233096, -691601077, 335663120}},
+      {1062380848, {-465759356, 201098159}, {39755548, -58269767, 20722408}, {326440879, -632049951, 305903740}},
+      {1062797146, {-465026965, 200562494}, {67483423, -108027183, 42953172}, {301250700, -581386898, 280434864}},
+      {1063196708, {-463794572, 199602602}, {91234147, -150185733, 61608668}, {279673676, -537607643, 258241476}},
+      {1063578217, {-461959947, 198135924}, {111804744, -186109993, 77272941}, {260985730, -499201441, 238537795}},
+      {1063941129, {-459339799, 196012278}, {129791916, -216738686, 90313875}, {244644770, -464968514, 220667767}},
+      {1064285449, {-455612352, 192966471}, {145650762, -242646409, 100893736}, {230237349, -433876575, 204015458}},
+      {1064611564, {-450189918, 188512910}, {159733471, -264014680, 108917859}, {217443510, -404908531, 187889070}},
+      {1064920105, {-441905354, 181686103}, {172314756, -280434306, 113851422}, {206013682, -376814275, 171298685}},
+    },
+    {
+      {1063251426, {-470245575, 204681922}, {7023149, 1030210, -5992939}, {356177561, -697718994, 341748462}},
+      {1063553840, {-470713717, 205153722}, {39817302, -58919240, 21220945}, {326384776, -638537248, 312353788}},
+      {1063854520, {-470910579, 205387489}, {67547344, -109440747, 44089733}, {301192628, -588395713, 287400968}},
+      {1064150675, {-470858820, 205404806}, {91301956, -152528031, 63519830}, {279612073, -545331765, 265916200}},
+      {1064440178, {-470564862, 205213042}, {111878559, -189632162, 80167395}, {260918671, -507902487, 247180925}},
+      {1064721480, {-470020076, 204806566}, {129874590, -221828106, 94513822}, {244569662, -475019769, 230649829}},
+      {1064993521, {-469199625, 204165946}, {145746465, -249920549, 106913034}, {230150405, -445842774, 215896879}},
+      {1065255640, {-468058659, 203254884}, {159848819, -274511571, 117620639}, {217338718, -419704750, 202577821}},
+      {1065507486, {-466524660, 202013936}, {172461320, -296042280, 126810008}, {205880532, -396060390, 190401945}},
+    },
+    {
+      {1065119930, {-473470550, 207317551}, {7072959, 1037516, -6035442}, {356132310, -702704024, 346706949}},
+      {1065283334, {-474359384, 208139288}, {39865293, -59423960, 21608369}, {326341178, -643578678, 317366272}},
+      {1065451832, {-475038294, 208773695}, {67594413, -110481625, 44926639}, {301149867, -593556649, 292530453}},
+      {1065623783, {-475544852, 209254750}, {91348887, -154149162, 64842567}, {279569438, -550677718, 271227964}},
+      {1065797675, {-475905380, 209606350}, {111926091, -191900260, 82031275}, {260875489, -513505517, 252746661}},
+      {1065972164, {-476138182, 209845222}, {129923477, -224837563, 96997319}, {244525250, -480963237, 236552382}},
+      {1066146081, {-476255557, 209982741}, {145797528, -253801737, 110124689}, {230104015, -452227456, 222236327}},
+      {1066318437, {-476265043, 210026072}, {159903021, -279444001, 121710026}, {217289478, -426657409, 209479982}},
+      {1066488418, {-476170138, 209978830}, {172519852, -302275543, 131985201}, {205827357, -403746596, 198031100}},
+    },
+    {
+      {1067336935, {-475569132, 209034191}, {7108748, 1042766, -6065982}, {356099796, -706285847, 350269701}},
+      {1067399864, {-476657319, 210022627}, {39898562, -59773853, 21876948}, {326310954, -647073607, 320841135}},
+      {1067466840, {-477552865, 210837938}, {67625795, -111175610, 45484631}, {301121357, -596997606, 295950442}},
+      {1067537487, {-478295585, 211516010}, {91378870, -155184889, 65687653}, {279542198, -554093205, 274621608}},
+      {1067611403, {-478914533, 212083034}, {111955068, -193282942, 83167537}, {260849164, -516921245, 256139653}},
+      {1067688171, {-479431357, 212558536}, {129951773, -226579456, 98434783}, {244499544, -484403356, 239968820}},
+      {1067767370, {-479862465, 212957322}, {145825425, -255922117, 111879288}, {230078671, -455715551, 225699709}},
+      {1067848579, {-480220457, 213290775}, {159930773, -281969546, 123803910}, {217264265, -430217370, 213014087}},
+      {1067931390, {-480515106, 213567736}, {172547700, -305241148, 134447407}, {205802057, -407403469, 201660830}},
+    },
+    {
+      {1069425477, {-476785651, 210030517}, {7132204, 1046207, -6085997}, {356078487, -708633358, 352604713}},
+      {1069443225, {-477954647, 211087073}, {39919841, -59997642, 22048729}, {326291622, -649308935, 323063628}},
+      {1069462419, {-478935399, 211974032}, {67645357, -111608196, 45832447}, {301103586, -599142479, 298082244}},
+      {1069483030, {-479768034, 212727571}, {91397059, -155813171, 66200290}, {279525674, -556165069, 276680221}},
+      {1069505025, {-480481937, 213374180}, {111972147, -194097879, 83837237}, {260833648, -518934438, 258139446}},
+      {1069528363, {-481099113, 213933697}, {129967948, -227575219, 99256518}, {244484849, -486369920, 241921846}},
+      {1069552996, {-481636366, 214421273}, {145840863, -257095503, 112850256}, {230064646, -457645809, 227616292}},
+      {1069578871, {-482106742, 214848671}, {159945609, -283319581, 124923199}, {217250787, -432120354, 214903249}},
+      {1069605930, {-482520525, 215225164}, {172562046, -306768820, 135715764}, {205789025, -409287234, 203530613}},
+    },
+    {
+      {1071036563, {-477454731, 210579168}, {7146664, 1048328, -6098336}, {356065350, -710080559, 354044208}},
+      {1071040623, {-478652902, 211660657}, {39932757, -60133487, 22153004}, {326279888, -650665835, 324412737}},
+      {1071045031, {-479663732, 212573208}, {67657043, -111866628, 46040237}, {301092969, -600423849, 299355805}},
+      {1071049789, {-480527430, 213353085}, {91407747, -156182373, 66501534}, {279515964, -557382574, 277889940}},
+      {1071054896, {-481273447, 214026850}, {111982013, -194568669, 84224124}, {260824685, -520097462, 259294729}},
+      {1071060353, {-481923850, 214614403}, {129977129, -228140411, 99722932}, {244476508, -487486136, 243030377}},
+      {1071066159, {-482495498, 215130950}, {145849467, -257749455, 113391397}, {230056830, -458721582, 228684443}},
+      {1071072313, {-483001493, 215588308}, {159953721, -284057873, 125535303}, {217243417, -433161036, 215936373}},
+      {1071078814, {-483452170, 215995797}, {172569738, -307588014, 136395903}, {205782036, -410297378, 204533259}},
+    },
+    {
+      {1072122502, {-477819275, 210878394}, {7155245, 1049587, -6105658}, {356057555, -710939317, 354898394}},
+      {1072123328, {-479027484, 211968657}, {39940351, -60213348, 22214305}, {326272989, -651463528, 325205850}},
+      {1072124225, {-480048447, 212890000}, {67663849, -112017116, 46161235}, {301086787, -601170010, 300097419}},
+      {1072125192, {-480922407, 213678729}, {91413911, -156395290, 66675261}, {279510364, -558084706, 278587582}},
+      {1072126230, {-481678841, 214361436}, {111987647, -194837503, 84445046}, {260819566, -520761579, 259954426}},
+      {1072127339, {-482339839, 214958050}, {129982320, -228459916, 99986597}, {244471793, -488117135, 243657032}},
+      {1072128521, {-482922275, 215483793}, {145854281, -258115357, 113694178}, {230052456, -459323502, 229282099}},
+      {1072129775, {-483439266, 215950500}, {159958214, -284466657, 125874219}, {217239336, -433737250, 216508402}},
+      {1072131102, {-483901161, 216367506}, {172573952, -308036766, 136768481}, {205778208, -410850732, 205082506}},
+    },
+    {
+      {1072798378, {-478019202, 211042612}, {7160222, 1050317, -6109905}, {356053033, -711437397, 355393822}},
+      {1072798536, {-479230890, 212136020}, {39944731, -60259415, 22249666}, {326269010, -651923666, 325663346}},
+      {1072798707, {-480255291, 213060438}, {67667752, -112103445, 46230647}, {301083240, -601598049, 300522849}},
+      {1072798892, {-481132666, 213852195}, {91417427, -156516750, 66774365}, {279507170, -558485242, 278985556}},
+      {1072799089, {-481892509, 214537900}, {111990843, -194989996, 84570363}, {260816663, -521138294, 260328633}},
+      {1072799301, {-482556917, 215137494}, {129985247, -228640119, 100135306}, {244469133, -488473023, 244010471}},
+      {1072799525, {-483142775, 215666213}, {145856980, -258320539, 113863965}, {230050004, -459661034, 229617239}},
+      {1072799763, {-483663205, 216135897}, {159960718, -284694550, 126063161}, {217237061, -434058484, 216827302}},
+      {1072800015, {-484128563, 216555888}, {172576287, -308285467, 136974967}, {205776087, -411157404, 205386902}},
+    },
+  },
+#endif
+};
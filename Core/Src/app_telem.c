@@ -0,0 +1,381 @@
+#include "app_telem.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "main.h"
+
+/*
+ * Telemetry transports.
+ * - ITM: a stimulus port reads 1 when its FIFO takes a word. Frames from
+ *   the main loop wait for it a bounded number of polls (a frame torn by a
+ *   timeout fails its CRC on the host); a live event is one word, sent only
+ *   if the FIFO is ready, so an ISR never waits. Each channel has its own
+ *   port, so an event between two words of a frame does not tear it.
+ * - RTT: the SEGGER layout of the control block and buffers; the target
+ *   only moves WrOff, the probe only RdOff. Each up buffer has one writer
+ *   (frames: main loop, events: AppTrace_Log() with IRQs masked). The
+ *   "Commands" pair is the COM link: the probe writes command bytes into
+ *   down buffer 0 and reads the replies from up buffer 2, both moved by the
+ *   main loop only on this side.
+ */
+
+/* Polls of a busy ITM port before a frame word is given up. */
+#define TELEM_ITM_SPIN                 2000u
+
+static volatile AppTelemTransport s_transport = APP_TELEM_UART;
+/* Frame counters: main loop only; event counters: AppTrace_Log() only. */
+static volatile uint32_t s_frames = 0;
+static volatile uint32_t s_frames_dropped = 0;
+static volatile uint32_t s_events = 0;
+static volatile uint32_t s_events_dropped = 0;
+
+#if APP_TELEM_ITM
+static uint8_t itm_enabled(uint32_t port)
+{
+  return (uint8_t)((((ITM->TCR & ITM_TCR_ITMENA_Msk) != 0U) && ((ITM->TER & (1UL << port)) != 0UL)) ? 1U : 0U);
+}
+
+static uint8_t itm_wait(uint32_t port)
+{
+  for (uint32_t i = 0; i < TELEM_ITM_SPIN; i++)
+  {
+    if (ITM->PORT[port].u32 != 0UL)
+    {
+      return 1U;
+    }
+  }
+  return 0U;
+}
+
+static uint8_t itm_write(uint32_t port, const uint8_t *p, uint32_t n)
+{
+  if (!itm_enabled(port))
+  {
+    return 0U;
+  }
+  uint32_t i = 0;
+  for (; (i + 4U) <= n; i += 4U)
+  {
+    uint32_t w;
+    memcpy(&w, &p[i], sizeof(w));
+    if (!itm_wait(port))
+    {
+      return 0U;
+    }
+    ITM->PORT[port].u32 = w;
+  }
+  for (; i < n; i++)
+  {
+    if (!itm_wait(port))
+    {
+      return 0U;
+    }
+    ITM->PORT[port].u8 = p[i];
+  }
+  return 1U;
+}
+#endif
+
+#if APP_TELEM_RTT
+typedef struct
+{
+  const char *name;
+  uint8_t *buf;
+  uint32_t size;
+  volatile uint32_t wr_off;
+  volatile uint32_t rd_off;
+  uint32_t flags;          /* 0: skip writes that do not fit */
+} RttBuffer;
+
+typedef struct
+{
+  char id[16];
+  int32_t max_up;
+  int32_t max_down;
+  RttBuffer up[3];
+  RttBuffer down[1];
+} RttControlBlock;
+
+static uint8_t s_rtt_frames[APP_TELEM_RTT_BYTES];
+static uint8_t s_rtt_trace[APP_TELEM_RTT_TRACE_BYTES];
+static uint8_t s_rtt_com_up[APP_TELEM_RTT_COM_BYTES];
+static uint8_t s_rtt_com_down[APP_TELEM_RTT_COM_BYTES];
+static RttControlBlock s_rtt;
+static uint32_t s_rtt_rd_seen = 0;
+static uint8_t s_rtt_read = 0;
+static uint8_t s_rtt_com_open = 0;       /* the probe has sent a command byte */
+
+/* The id goes in last and in two pieces, so the probe never finds a half
+ * set up block and the image holds no second copy of it.
+ */
+static void rtt_init(void)
+{
+  if (s_rtt.max_up != 0)
+  {
+    return;
+  }
+  s_rtt.max_up = 3;
+  s_rtt.max_down = 1;
+  s_rtt.up[0] = (RttBuffer){"Telemetry", s_rtt_frames, sizeof(s_rtt_frames), 0U, 0U, 0U};
+  s_rtt.up[1] = (RttBuffer){"Trace", s_rtt_trace, sizeof(s_rtt_trace), 0U, 0U, 0U};
+  s_rtt.up[2] = (RttBuffer){"Commands", s_rtt_com_up, sizeof(s_rtt_com_up), 0U, 0U, 0U};
+  s_rtt.down[0] = (RttBuffer){"Commands", s_rtt_com_down, sizeof(s_rtt_com_down), 0U, 0U, 0U};
+  memcpy(&s_rtt.id[7], "RTT", 4U);
+  __DMB();
+  memcpy(&s_rtt.id[0], "SEGGER ", 7U);
+  __DMB();
+}
+
+static uint8_t rtt_write(RttBuffer *b, const uint8_t *p, uint32_t n)
+{
+  const uint32_t wr = b->wr_off;
+  const uint32_t rd = b->rd_off;
+  const uint32_t room = (rd > wr) ? (rd - wr - 1U) : (b->size - wr + rd - 1U);
+  if (n > room)
+  {
+    return 0U;
+  }
+  const uint32_t first = ((b->size - wr) < n) ? (b->size - wr) : n;
+  memcpy(&b->buf[wr], p, first);
+  memcpy(&b->buf[0], &p[first], n - first);
+  __DMB(); /* data before the offset that publishes it */
+  b->wr_off = (wr + n) % b->size;
+  return 1U;
+}
+
+static uint32_t rtt_room(const RttBuffer *b)
+{
+  const uint32_t wr = b->wr_off;
+  const uint32_t rd = b->rd_off;
+  return (rd > wr) ? (rd - wr - 1U) : (b->size - wr + rd - 1U);
+}
+#endif
+
+uint8_t AppTelem_Select(AppTelemTransport t)
+{
+  switch (t)
+  {
+    case APP_TELEM_UART:
+      break;
+#if APP_TELEM_ITM
+    case APP_TELEM_ITM_SWO:
+      break;
+#endif
+#if APP_TELEM_RTT
+    case APP_TELEM_RTT_MEM:
+      rtt_init();
+      s_rtt_rd_seen = s_rtt.up[0].rd_off;
+      s_rtt_read = 0U;
+      break;
+#endif
+    default:
+      return 0U;
+  }
+  s_transport = t;
+  s_frames = 0U;
+  s_frames_dropped = 0U;
+  s_events = 0U;
+  s_events_dropped = 0U;
+  return 1U;
+}
+
+AppTelemTransport AppTelem_Transport(void)
+{
+  return s_transport;
+}
+
+void AppTelem_GetStats(AppTelemStats *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  memset(out, 0, sizeof(*out));
+  out->transport = s_transport;
+  out->frames = s_frames;
+  out->events = s_events;
+  out->dropped = s_frames_dropped + s_events_dropped;
+#if APP_TELEM_ITM
+  if (s_transport == APP_TELEM_ITM_SWO)
+  {
+    out->attached = itm_enabled(APP_TELEM_ITM_PORT);
+  }
+#endif
+#if APP_TELEM_RTT
+  if (s_transport == APP_TELEM_RTT_MEM)
+  {
+    if (s_rtt.up[0].rd_off != s_rtt_rd_seen)
+    {
+      s_rtt_read = 1U;
+    }
+    out->attached = s_rtt_read;
+  }
+#endif
+}
+
+uint8_t AppTelem_Write(AppTelemChannel ch, const uint8_t *p, uint32_t n)
+{
+  uint8_t ok = 0U;
+  switch (s_transport)
+  {
+#if APP_TELEM_ITM
+    case APP_TELEM_ITM_SWO:
+      ok = itm_write(APP_TELEM_ITM_PORT + (uint32_t)ch, p, n);
+      break;
+#endif
+#if APP_TELEM_RTT
+    case APP_TELEM_RTT_MEM:
+      ok = rtt_write(&s_rtt.up[0], p, n);
+      if (!ok && (ch == APP_TELEM_CH_DUMP))
+      {
+        return 0U;
+      }
+      break;
+#endif
+    default:
+      break;
+  }
+  if (ok)
+  {
+    s_frames++;
+  }
+  else
+  {
+    s_frames_dropped++;
+  }
+  return 1U;
+}
+
+void AppTelem_Event(uint32_t cyc, uint32_t word)
+{
+  uint8_t ok = 0U;
+  switch (s_transport)
+  {
+#if APP_TELEM_ITM
+    case APP_TELEM_ITM_SWO:
+    {
+      /* Stamped by the ITM's own timestamp packets, not cyc. */
+      const uint32_t port = APP_TELEM_ITM_PORT + (uint32_t)APP_TELEM_CH_TRACE;
+      if (itm_enabled(port) && (ITM->PORT[port].u32 != 0UL))
+      {
+        ITM->PORT[port].u32 = word;
+        ok = 1U;
+      }
+      (void)cyc;
+      break;
+    }
+#endif
+#if APP_TELEM_RTT
+    case APP_TELEM_RTT_MEM:
+    {
+      const uint32_t ev[2] = {cyc, word};
+      ok = rtt_write(&s_rtt.up[1], (const uint8_t *)ev, sizeof(ev));
+      break;
+    }
+#endif
+    default:
+      return;
+  }
+  if (ok)
+  {
+    s_events++;
+  }
+  else
+  {
+    s_events_dropped++;
+  }
+}
+
+uint32_t AppTelem_ComRead(uint8_t *dst, uint32_t max)
+{
+#if APP_TELEM_RTT
+  rtt_init();
+  RttBuffer *b = &s_rtt.down[0];
+  const uint32_t wr = b->wr_off;
+  uint32_t rd = b->rd_off;
+  uint32_t n = 0;
+  for (; (n < max) && (rd != wr); n++)
+  {
+    dst[n] = b->buf[rd];
+    rd = (rd + 1U) % b->size;
+  }
+  if (n != 0U)
+  {
+    __DMB(); /* data read before the offset that frees it */
+    b->rd_off = rd;
+    s_rtt_com_open = 1U;
+  }
+  return n;
+#else
+  (void)dst;
+  (void)max;
+  return 0u;
+#endif
+}
+
+uint8_t AppTelem_ComPending(void)
+{
+#if APP_TELEM_RTT
+  return (s_rtt.down[0].wr_off != s_rtt.down[0].rd_off) ? 1U : 0U;
+#else
+  return 0u;
+#endif
+}
+
+uint8_t AppTelem_ComIsOpen(void)
+{
+#if APP_TELEM_RTT
+  return s_rtt_com_open;
+#else
+  return 0u;
+#endif
+}
+
+uint8_t AppTelem_ComWrite(const uint8_t *p, uint32_t n)
+{
+#if APP_TELEM_RTT
+  if (!s_rtt_com_open)
+  {
+    return 1U;
+  }
+  return rtt_write(&s_rtt.up[2], p, n);
+#else
+  (void)p;
+  (void)n;
+  return 1u;
+#endif
+}
+
+uint32_t AppTelem_ComTxFree(void)
+{
+#if APP_TELEM_RTT
+  return s_rtt_com_open ? rtt_room(&s_rtt.up[2]) : sizeof(s_rtt_com_up);
+#else
+  return 0u;
+#endif
+}
+
+#if APP_TELEM_RTT
+static const AppMemItem k_telem_mem[] =
+{
+  APP_MEM_ITEM("telem.rtt", s_rtt_frames),
+  APP_MEM_ITEM("telem.rtt_trace", s_rtt_trace),
+  APP_MEM_ITEM("telem.rtt_com_up", s_rtt_com_up),
+  APP_MEM_ITEM("telem.rtt_com_down", s_rtt_com_down),
+};
+
+_Static_assert((sizeof(s_rtt_frames) + sizeof(s_rtt_trace) + sizeof(s_rtt_com_up) + sizeof(s_rtt_com_down)) <=
+               APP_TELEM_RAM_BYTES, "the RTT buffers outgrew APP_TELEM_RAM_BYTES");
+#endif
+
+uint32_t AppTelem_MemMap(const AppMemItem **items)
+{
+#if APP_TELEM_RTT
+  *items = k_telem_mem;
+  return (uint32_t)(sizeof(k_telem_mem) / sizeof(k_telem_mem[0]));
+#else
+  *items = NULL;
+  return 0u;
+#endif
+}
@@ -0,0 +1,186 @@
+#include "app_trace.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "app_prof.h"
+#include "app_telem.h"
+#include "main.h"
+
+/*
+ * Event trace ring.
+ * - s_seq counts the events logged since the arm; event k sits in slot
+ *   k % APP_TRACE_EVENTS. Claiming the slot and bumping s_seq happen with
+ *   IRQs masked, so loggers at different priorities never share a slot.
+ * - Every event also goes to AppTelem_Event(), frozen or not: out live on
+ *   the probe while COM TELEM has ITM or RTT selected.
+ * - A trigger moves RUNNING to TRIGGERED and leaves s_post events to go;
+ *   the last of them freezes the ring. Frozen, nothing writes it, so the
+ *   main loop reads it unmasked.
+ */
+
+#if APP_TRACE_ENABLE
+
+#define TRACE_MASK                     (APP_TRACE_EVENTS - 1u)
+
+static AppTraceEvent s_buf[APP_TRACE_EVENTS];
+static volatile AppTraceState s_state = APP_TRACE_RUNNING;
+static volatile uint32_t s_seq = 0;
+static uint32_t s_trig_mask = APP_TRACE_TRIG_DEFAULT;
+static uint32_t s_trig_seq = 0;
+static uint32_t s_trig_id = (uint32_t)APP_TRACE_ID_COUNT;  /* none */
+static uint32_t s_post = 0;
+
+void AppTrace_Log(AppTraceId id, uint32_t arg)
+{
+  const uint32_t cyc = AppProf_Cycles();
+  const uint32_t primask = __get_PRIMASK();
+  const uint32_t word = (uint32_t)id | (arg << 8);
+  __disable_irq();
+  AppTelem_Event(cyc, word);
+  if (s_state != APP_TRACE_FROZEN)
+  {
+    const uint32_t seq = s_seq;
+    AppTraceEvent *e = &s_buf[seq & TRACE_MASK];
+    e->cyc = cyc;
+    e->word = word;
+    s_seq = seq + 1u;
+    if (s_state == APP_TRACE_TRIGGERED)
+    {
+      if (--s_post == 0u)
+      {
+        s_state = APP_TRACE_FROZEN;
+      }
+    }
+    else if ((s_trig_mask & APP_TRACE_BIT(id)) != 0u)
+    {
+      s_trig_seq = seq;
+      s_trig_id = (uint32_t)id;
+      s_post = APP_TRACE_POST;
+      s_state = APP_TRACE_TRIGGERED;
+    }
+  }
+  __set_PRIMASK(primask);
+}
+
+void AppTrace_Arm(uint32_t trig_mask)
+{
+  __disable_irq();
+  s_trig_mask = trig_mask;
+  s_trig_id = (uint32_t)APP_TRACE_ID_COUNT;
+  s_seq = 0;
+  s_state = APP_TRACE_RUNNING;
+  __enable_irq();
+}
+
+void AppTrace_Freeze(void)
+{
+  __disable_irq();
+  if (s_state == APP_TRACE_RUNNING)
+  {
+    s_trig_seq = s_seq;
+    s_trig_id = (uint32_t)APP_TRACE_ID_COUNT;
+  }
+  s_state = APP_TRACE_FROZEN;
+  __enable_irq();
+}
+
+void AppTrace_GetInfo(AppTraceInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  __disable_irq();
+  const AppTraceState state = s_state;
+  const uint32_t seq = s_seq;
+  const uint32_t trig_seq = s_trig_seq;
+  out->trig_id = s_trig_id;
+  __enable_irq();
+
+  const uint32_t held = (seq < APP_TRACE_EVENTS) ? seq : APP_TRACE_EVENTS;
+  const uint32_t oldest = seq - held;
+  out->state = state;
+  out->trig_mask = s_trig_mask;
+  out->seq = seq;
+  out->held = held;
+  out->trig = ((state != APP_TRACE_RUNNING) && (trig_seq >= oldest) && (trig_seq < seq)) ? (trig_seq - oldest) : held;
+}
+
+uint32_t AppTrace_Read(uint32_t first, AppTraceEvent *out, uint32_t n)
+{
+  if (s_state != APP_TRACE_FROZEN)
+  {
+    return 0u;
+  }
+  const uint32_t seq = s_seq;
+  const uint32_t held = (seq < APP_TRACE_EVENTS) ? seq : APP_TRACE_EVENTS;
+  if (first >= held)
+  {
+    return 0u;
+  }
+  if (n > (held - first))
+  {
+    n = held - first;
+  }
+  const uint32_t oldest = seq - held;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    out[i] = s_buf[(oldest + first + i) & TRACE_MASK];
+  }
+  return n;
+}
+
+static const AppMemItem k_trace_mem[] =
+{
+  APP_MEM_ITEM("trace.buf", s_buf),
+};
+
+_Static_assert(sizeof(s_buf) <= APP_TRACE_RAM_BYTES, "the trace buffer outgrew APP_TRACE_RAM_BYTES");
+
+uint32_t AppTrace_MemMap(const AppMemItem **items)
+{
+  *items = k_trace_mem;
+  return 1u;
+}
+
+#else
+
+void AppTrace_Log(AppTraceId id, uint32_t arg)
+{
+  (void)id;
+  (void)arg;
+}
+
+void AppTrace_Arm(uint32_t trig_mask)
+{
+  (void)trig_mask;
+}
+
+void AppTrace_Freeze(void)
+{
+}
+
+void AppTrace_GetInfo(AppTraceInfo *out)
+{
+  if (out != NULL)
+  {
+    memset(out, 0, sizeof(*out));
+  }
+}
+
+uint32_t AppTrace_Read(uint32_t first, AppTraceEvent *out, uint32_t n)
+{
+  (void)first;
+  (void)out;
+  (void)n;
+  return 0u;
+}
+
+uint32_t AppTrace_MemMap(const AppMemItem **items)
+{
+  *items = NULL;
+  return 0u;
+}
+
+#endif /* APP_TRACE_ENABLE */
@@ -0,0 +1,278 @@
+#include "app_tuner.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Tuner.
+ * - Decimator: two one-pole lowpasses (~1 kHz) then a boxcar of APP_TUNER_DECIM
+ *   frames, whose first null sits on the 4 kHz output rate; s24 >> 8 into
+ *   int16. Runs on every block while on, so the filter state stays warm
+ *   across analysis passes.
+ * - FILL stores decimated samples until the frame holds the window plus the
+ *   largest lag, summing the window energy on the way. SEARCH then adds
+ *   lags 1, 2, ... to the cumulative mean normalised difference
+ *   d'(t) = d(t) t / sum(d(1..t)), a budget per block, and stops at the
+ *   first local minimum under TUNER_THRESH (YIN steps 2-4). Samples that
+ *   come in during the search are dropped.
+ * - One writer per field: the main loop owns s_mode, the audio side
+ *   everything else; the result is published as one aligned word
+ *   (s_period_q16, 0 = no pitch) before s_seq moves.
+ */
+
+#define TUNER_FS_HZ      (APP_DSP_SAMPLE_RATE_HZ / APP_TUNER_DECIM)
+#define TUNER_TAU_MIN    (TUNER_FS_HZ / APP_TUNER_FMAX_HZ)
+#define TUNER_TAU_MAX    APP_TUNER_TAU_MAX
+#define TUNER_FRAME      (APP_TUNER_WINDOW + TUNER_TAU_MAX + 1u)
+#if APP_DSP_SAMPLE_RATE_HZ > 48000u
+#define TUNER_LP_SHIFT   4u          /* 1 - 1/16 per 96 kHz frame: ~1 kHz */
+#else
+#define TUNER_LP_SHIFT   3u          /* 1 - 1/8 per 48 kHz frame: ~1 kHz */
+#endif
+#define TUNER_THRESH     0.15f
+
+#if (TUNER_TAU_MIN < 2u)
+#error "APP_TUNER_FMAX_HZ too high for the decimated rate"
+#endif
+
+typedef enum
+{
+  TUNER_FILL = 0,
+  TUNER_SEARCH,
+} TunerPhase;
+
+#if APP_TUNER_ENABLE
+
+static volatile AppTunerMode s_mode = APP_TUNER_OFF;
+static volatile uint32_t s_period_q16 = 0;
+static volatile uint32_t s_seq = 0;
+
+static int16_t s_frame[TUNER_FRAME];
+static float s_cmnd[TUNER_TAU_MAX + 2u];
+static uint8_t s_active = 0;
+static TunerPhase s_phase = TUNER_FILL;
+static int32_t s_lp[2];
+static int32_t s_acc = 0;
+static uint32_t s_acc_n = 0;
+static uint32_t s_fill = 0;
+static uint64_t s_energy = 0;
+static uint32_t s_tau = 0;
+static float s_dsum = 0.0f;
+static float s_d[3];              /* d(t - 2), d(t - 1), d(t) */
+
+void AppTuner_SetMode(AppTunerMode mode)
+{
+  s_mode = mode;
+}
+
+void AppTuner_Get(AppTunerReading *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->mode = s_mode;
+  out->seq = s_seq;
+  out->freq_mhz = 0u;
+  out->note = -1;
+  out->cents = 0;
+
+  const uint32_t period_q16 = s_period_q16;
+  if ((out->mode == APP_TUNER_OFF) || (period_q16 == 0u))
+  {
+    return;
+  }
+  const float f = ((float)TUNER_FS_HZ * 65536.0f) / (float)period_q16;
+  const float semis = 69.0f + (12.0f * log2f(f / (float)APP_TUNER_A4_HZ));
+  const float note = floorf(semis + 0.5f);
+  out->freq_mhz = (uint32_t)((f * 1000.0f) + 0.5f);
+  out->note = (int32_t)note;
+  out->cents = (int32_t)floorf(((semis - note) * 100.0f) + 0.5f);
+}
+
+uint8_t AppTuner_Muted(void)
+{
+  return (s_mode == APP_TUNER_MUTE) ? 1u : 0u;
+}
+
+static void tuner_restart(void)
+{
+  s_phase = TUNER_FILL;
+  s_fill = 0;
+  s_energy = 0;
+}
+
+/* Period from the minimum at t, refined by a parabola through the raw
+ * d(t - 1 .. t + 1) (the normalisation would bias it upwards).
+ */
+static uint32_t tuner_period_q16(uint32_t t)
+{
+  const float a = s_d[0];
+  const float b = s_d[1];
+  const float c = s_d[2];
+  const float den = (a - (2.0f * b)) + c;
+  float off = (den > 0.0f) ? ((0.5f * (a - c)) / den) : 0.0f;
+  if (off > 0.5f) off = 0.5f;
+  if (off < -0.5f) off = -0.5f;
+  return (uint32_t)((((float)t + off) * 65536.0f) + 0.5f);
+}
+
+static void tuner_publish(uint32_t period_q16)
+{
+  s_period_q16 = period_q16;
+  s_seq = s_seq + 1u;
+  tuner_restart();
+}
+
+/* YIN difference d(t) over the window; int16 differences, squares summed
+ * in 64 bits.
+ */
+APP_CCM_CODE static float tuner_diff(uint32_t t)
+{
+  const int16_t *a = s_frame;
+  const int16_t *b = &s_frame[t];
+  int64_t d = 0;
+  for (uint32_t j = 0; j < APP_TUNER_WINDOW; j++)
+  {
+    const int32_t e = (int32_t)a[j] - (int32_t)b[j];
+    d += (int64_t)e * e;
+  }
+  return (float)d;
+}
+
+APP_CCM_CODE static void tuner_search(uint32_t budget)
+{
+  while (budget-- != 0u)
+  {
+    const uint32_t t = ++s_tau;
+    const float d = tuner_diff(t);
+    s_dsum += d;
+    s_d[0] = s_d[1];
+    s_d[1] = s_d[2];
+    s_d[2] = d;
+    s_cmnd[t] = (s_dsum > 0.0f) ? ((d * (float)t) / s_dsum) : 1.0f;
+
+    /* t - 1 is the first local minimum under the threshold. */
+    const uint32_t m = t - 1u;
+    if ((m >= TUNER_TAU_MIN) && (s_cmnd[m] < TUNER_THRESH) && (s_cmnd[t] >= s_cmnd[m]))
+    {
+      tuner_publish(tuner_period_q16(m));
+      return;
+    }
+    if (t > TUNER_TAU_MAX)
+    {
+      tuner_publish(0u);
+      return;
+    }
+  }
+}
+
+APP_CCM_CODE void AppTuner_Block(const AppStereoS24 *x, uint32_t n)
+{
+  if (s_mode == APP_TUNER_OFF)
+  {
+    s_active = 0u;
+    return;
+  }
+  if (!s_active)
+  {
+    s_active = 1u;
+    s_lp[0] = 0;
+    s_lp[1] = 0;
+    s_acc = 0;
+    s_acc_n = 0;
+    s_period_q16 = 0u;
+    s_seq = 0u;
+    tuner_restart();
+  }
+
+  for (uint32_t i = 0; i < n; i++)
+  {
+    s_lp[0] += (x[i].l - s_lp[0]) >> TUNER_LP_SHIFT;
+    s_lp[1] += (s_lp[0] - s_lp[1]) >> TUNER_LP_SHIFT;
+    s_acc += s_lp[1];
+    if (++s_acc_n < APP_TUNER_DECIM)
+    {
+      continue;
+    }
+    const int32_t v = s_acc / (int32_t)(APP_TUNER_DECIM * 256u);
+    s_acc = 0;
+    s_acc_n = 0;
+    if (s_phase != TUNER_FILL)
+    {
+      continue;
+    }
+    s_frame[s_fill] = (int16_t)v;
+    if (s_fill < APP_TUNER_WINDOW)
+    {
+      s_energy += (uint64_t)((int64_t)v * v);
+    }
+    if (++s_fill == TUNER_FRAME)
+    {
+      /* Too quiet to trust: report no pitch and start over. */
+      if (s_energy < ((uint64_t)APP_TUNER_MIN_LEVEL * APP_TUNER_MIN_LEVEL * APP_TUNER_WINDOW))
+      {
+        tuner_publish(0u);
+        continue;
+      }
+      s_phase = TUNER_SEARCH;
+      s_tau = 0;
+      s_dsum = 0.0f;
+    }
+  }
+
+  if (s_phase == TUNER_SEARCH)
+  {
+    tuner_search(((n + 15u) / 16u) * APP_TUNER_LAGS_PER_16);
+  }
+}
+
+static const AppMemItem k_tuner_mem[] =
+{
+  APP_MEM_ITEM("tuner.frame", s_frame),
+  APP_MEM_ITEM("tuner.cmnd", s_cmnd),
+};
+
+_Static_assert((sizeof(s_frame) + sizeof(s_cmnd)) <= APP_TUNER_RAM_BYTES, "the tuner buffers outgrew APP_TUNER_RAM_BYTES");
+
+uint32_t AppTuner_MemMap(const AppMemItem **items)
+{
+  *items = k_tuner_mem;
+  return (uint32_t)(sizeof(k_tuner_mem) / sizeof(k_tuner_mem[0]));
+}
+
+#else
+
+void AppTuner_SetMode(AppTunerMode mode)
+{
+  (void)mode;
+}
+
+void AppTuner_Get(AppTunerReading *out)
+{
+  if (out != NULL)
+  {
+    memset(out, 0, sizeof(*out));
+    out->note = -1;
+  }
+}
+
+void AppTuner_Block(const AppStereoS24 *x, uint32_t n)
+{
+  (void)x;
+  (void)n;
+}
+
+uint8_t AppTuner_Muted(void)
+{
+  return 0u;
+}
+
+uint32_t AppTuner_MemMap(const AppMemItem **items)
+{
+  *items = NULL;
+  return 0u;
+}
+
+#endif /* APP_TUNER_ENABLE */
@@ -0,0 +1,312 @@
+#include "app_uac.h"
+
+#include <stddef.h>
+
+#include "app_audio.h"
+
+/* A power of two, indexed by the running frame counts; with the mirror
+ * 1.8 KB.
+ */
+#define UAC_FIFO_FRAMES      APP_UAC_FIFO_FRAMES
+#define UAC_FIFO_MASK        (UAC_FIFO_FRAMES - 1u)
+/* The first packet's frames again past the end, so a packet that wraps
+ * goes out in one piece; a build without the interface has no packets.
+ */
+#define UAC_FIFO_MIRROR      (APP_UAC_ENABLE ? APP_UAC_PACKET_MAX : 0u)
+#define UAC_TARGET_MARGIN    96u     /* frames above half a block */
+
+/* Packet-size loop, per 1 ms packet: the fill error (Q8 frames) << KP is
+ * the proportional part and >> KI feeds the rate it learns (Q16 extra
+ * frames per packet). Holds ±1.5 % between the clocks without a dry FIFO.
+ */
+#define UAC_RATE_ONE_Q16     65536
+#define UAC_FILL_SHIFT       5       /* fill average, ~32 packets */
+#define UAC_KP_SHIFT         2
+#define UAC_KI_SHIFT         5
+
+/* Audio class requests (UAC1 5.2). */
+#define UAC_REQ_SET_CUR      0x01u
+#define UAC_REQ_GET_CUR      0x81u
+#define UAC_REQ_GET_MIN      0x82u
+#define UAC_REQ_GET_MAX      0x83u
+#define UAC_REQ_GET_RES      0x84u
+#define UAC_SAMPLING_FREQ    0x01u   /* endpoint control selector */
+
+static uint8_t s_fifo[(UAC_FIFO_FRAMES + UAC_FIFO_MIRROR) * APP_UAC_FRAME_BYTES];
+static const uint8_t k_silence[APP_UAC_PACKET_FRAMES * APP_UAC_FRAME_BYTES];
+static uint8_t s_rate_buf[3];
+
+/* Producer (audio interrupt). */
+static volatile uint32_t s_w;            /* frames written */
+static int32_t s_dry[APP_UAC_ENABLE ? APP_AUDIO_MAX_FRAMES_PER_HALF : 1u];
+
+/* Consumer (USB interrupt). */
+static volatile uint32_t s_r;            /* frames sent */
+static volatile uint8_t s_streaming;
+static uint8_t s_priming;                /* silence until the fill reaches the target */
+static int32_t s_fill_q8;
+static int32_t s_rate_q16;               /* learned clock offset, extra frames per packet */
+static int32_t s_rate_acc_q16;
+
+static volatile AppUacSource s_source = APP_UAC_SOURCE;
+static volatile uint32_t s_packets;
+static volatile uint32_t s_short;
+static volatile uint32_t s_long;
+static volatile uint32_t s_underruns;
+static volatile uint32_t s_overflows;
+
+static uint32_t uac_target(void)
+{
+  return (AppAudio_GetFramesPerHalf() / 2u) + UAC_TARGET_MARGIN;
+}
+
+static inline void put_s24(uint8_t *p, int32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+}
+
+void AppUac_DryBlock(const AppStereoS24 *x, uint32_t frames)
+{
+  if (!s_streaming || (s_source != APP_UAC_SOURCE_WET_DRY))
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    s_dry[i] = x[i].l;
+  }
+}
+
+void AppUac_Block(const AppStereoS24 *x, uint32_t frames)
+{
+  if (!s_streaming)
+  {
+    return;
+  }
+  uint32_t w = s_w;
+  if (((w - s_r) + frames) > UAC_FIFO_FRAMES)
+  {
+    s_overflows++;
+    return;
+  }
+  const uint8_t dry = (s_source == APP_UAC_SOURCE_WET_DRY);
+  for (uint32_t i = 0; i < frames; i++, w++)
+  {
+    const uint32_t slot = w & UAC_FIFO_MASK;
+    uint8_t *p = &s_fifo[slot * APP_UAC_FRAME_BYTES];
+    put_s24(p, x[i].l);
+    put_s24(p + APP_UAC_SAMPLE_BYTES, dry ? s_dry[i] : x[i].r);
+    if (APP_UAC_ENABLE && (slot < APP_UAC_PACKET_MAX))
+    {
+      uint8_t *m = &s_fifo[(UAC_FIFO_FRAMES + slot) * APP_UAC_FRAME_BYTES];
+      for (uint32_t b = 0; b < APP_UAC_FRAME_BYTES; b++)
+      {
+        m[b] = p[b];
+      }
+    }
+  }
+  s_w = w;
+}
+
+/* Next packet: 48 frames, one more or one less to hold the fill. */
+static void uac_send(void)
+{
+  const uint32_t fill = s_w - s_r;
+  const uint32_t target = uac_target();
+  if (s_priming)
+  {
+    if (fill < target)
+    {
+      AppUsb_Transmit(APP_UAC_EP_IN, k_silence, (uint16_t)sizeof(k_silence));
+      return;
+    }
+    s_priming = 0u;
+    s_fill_q8 = (int32_t)(target << 8);
+    s_rate_acc_q16 = 0;
+  }
+
+  /* The learned rate plus the fill error is the extra frames for this
+   * packet, dithered into whole frames by the accumulator.
+   */
+  s_fill_q8 += ((int32_t)(fill << 8) - s_fill_q8) >> UAC_FILL_SHIFT;
+  const int32_t err_q8 = s_fill_q8 - (int32_t)(target << 8);
+  s_rate_q16 += err_q8 >> UAC_KI_SHIFT;
+  if (s_rate_q16 > UAC_RATE_ONE_Q16)
+  {
+    s_rate_q16 = UAC_RATE_ONE_Q16;
+  }
+  else if (s_rate_q16 < -UAC_RATE_ONE_Q16)
+  {
+    s_rate_q16 = -UAC_RATE_ONE_Q16;
+  }
+  s_rate_acc_q16 += s_rate_q16 + (err_q8 * (1 << UAC_KP_SHIFT));
+  uint32_t n = APP_UAC_PACKET_FRAMES;
+  if (s_rate_acc_q16 >= UAC_RATE_ONE_Q16)
+  {
+    s_rate_acc_q16 -= UAC_RATE_ONE_Q16;
+    n++;
+    s_long++;
+  }
+  else if (s_rate_acc_q16 <= -UAC_RATE_ONE_Q16)
+  {
+    s_rate_acc_q16 += UAC_RATE_ONE_Q16;
+    n--;
+    s_short++;
+  }
+  /* Past a frame a packet, the error stays in the accumulator, no further. */
+  if (s_rate_acc_q16 > UAC_RATE_ONE_Q16)
+  {
+    s_rate_acc_q16 = UAC_RATE_ONE_Q16;
+  }
+  else if (s_rate_acc_q16 < -UAC_RATE_ONE_Q16)
+  {
+    s_rate_acc_q16 = -UAC_RATE_ONE_Q16;
+  }
+
+  if (fill < n)
+  {
+    s_underruns++;
+    s_priming = 1u;
+    AppUsb_Transmit(APP_UAC_EP_IN, k_silence, (uint16_t)sizeof(k_silence));
+    return;
+  }
+  const uint32_t r = s_r;
+  AppUsb_Transmit(APP_UAC_EP_IN, &s_fifo[(r & UAC_FIFO_MASK) * APP_UAC_FRAME_BYTES],
+                  (uint16_t)(n * APP_UAC_FRAME_BYTES));
+  s_r = r + n;
+  s_packets++;
+}
+
+void AppUac_DataIn(void)
+{
+  if (s_streaming)
+  {
+    uac_send();
+  }
+}
+
+void AppUac_Reset(void)
+{
+  s_streaming = 0u;
+}
+
+uint8_t AppUac_SetInterface(uint16_t iface, uint16_t alt)
+{
+  if ((iface == APP_UAC_IF_CONTROL) && (alt == 0u))
+  {
+    return 1u;
+  }
+  if ((iface != APP_UAC_IF_STREAM) || (alt > 1u))
+  {
+    return 0u;
+  }
+  if ((alt == 1u) && !s_streaming)
+  {
+    /* Start from an empty FIFO: drop what is left of the last stream,
+     * prime with silence, and have the first packet queued for the next
+     * frame.
+     */
+    s_r = s_w;
+    s_rate_q16 = 0;
+    s_priming = 1u;
+    s_streaming = 1u;
+    uac_send();
+  }
+  else if (alt == 0u)
+  {
+    s_streaming = 0u;
+  }
+  return 1u;
+}
+
+uint8_t AppUac_GetInterface(uint16_t iface, uint8_t *alt)
+{
+  if (iface == APP_UAC_IF_CONTROL)
+  {
+    *alt = 0u;
+    return 1u;
+  }
+  if (iface == APP_UAC_IF_STREAM)
+  {
+    *alt = s_streaming;
+    return 1u;
+  }
+  return 0u;
+}
+
+uint8_t AppUac_Setup(const AppUsbSetup *req)
+{
+  /* The one control is the endpoint's sampling rate, which has a single
+   * value.
+   */
+  if (((req->type & 0x1Fu) != 0x02u) || ((req->index & 0xFFu) != APP_UAC_EP_IN) ||
+      ((req->value >> 8) != UAC_SAMPLING_FREQ))
+  {
+    return 0u;
+  }
+  switch (req->request)
+  {
+    case UAC_REQ_SET_CUR:
+      AppUsb_CtlRecv(sizeof(s_rate_buf));
+      return 1u;
+    case UAC_REQ_GET_CUR:
+    case UAC_REQ_GET_MIN:
+    case UAC_REQ_GET_MAX:
+    case UAC_REQ_GET_RES:
+      put_s24(s_rate_buf, (req->request == UAC_REQ_GET_RES) ? 1 : (int32_t)APP_DSP_SAMPLE_RATE_HZ);
+      AppUsb_CtlSend(s_rate_buf, sizeof(s_rate_buf));
+      return 1u;
+    default:
+      return 0u;
+  }
+}
+
+void AppUac_CtlOut(const uint8_t *data, uint16_t len)
+{
+  /* SET_CUR of the rate: 48000 is the only one, nothing to change. */
+  (void)data;
+  (void)len;
+}
+
+uint8_t AppUac_SetSource(AppUacSource source)
+{
+  if (source >= APP_UAC_SOURCE_COUNT)
+  {
+    return 0u;
+  }
+  s_source = source;
+  return 1u;
+}
+
+void AppUac_Get(AppUacInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->streaming = s_streaming;
+  out->source = s_source;
+  out->fill = s_w - s_r;
+  out->target = uac_target();
+  out->packets = s_packets;
+  out->short_packets = s_short;
+  out->long_packets = s_long;
+  out->underruns = s_underruns;
+  out->overflows = s_overflows;
+}
+
+static const AppMemItem k_uac_mem[] =
+{
+  APP_MEM_ITEM("uac.fifo", s_fifo),
+  APP_MEM_ITEM("uac.dry", s_dry),
+};
+
+_Static_assert((sizeof(s_fifo) + sizeof(s_dry)) <= APP_UAC_RAM_BYTES, "the USB audio buffers outgrew APP_UAC_RAM_BYTES");
+
+uint32_t AppUac_MemMap(const AppMemItem **items)
+{
+  *items = k_uac_mem;
+  return (uint32_t)(sizeof(k_uac_mem) / sizeof(k_uac_mem[0]));
+}
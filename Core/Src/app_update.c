@@ -0,0 +1,462 @@
+#include "app_update.h"
+
+#include <stddef.h>
+
+#include "app_dsp.h"
+#include "app_evlog.h"
+#include "stm32g4xx_hal.h"
+
+/*
+ * Firmware updater.
+ * - Everything the updater runs is in the section "app_update_ram"; armlink
+ *   gives its bounds, AppUpdate_Enter() copies it to the FX arena and jumps
+ *   to the copy. Calls inside the section are PC-relative and move with
+ *   it. Nothing in there may reach outside: no libc (copies go through
+ *   volatile pointers so they are not turned into memcpy() calls), no HAL,
+ *   only registers, and the IWDG is fed with a plain key write.
+ * - The frame buffer and the page buffer follow the code in the arena; the
+ *   stack stays where the main loop left it (IRQs are off for good).
+ * - Caches are off while running, so flash read back is what was written.
+ * - Byte timeouts count loop passes (SysTick is stopped): ~0.2 s at 170
+ *   MHz, only inside a frame; the wait for a frame start has none.
+ * - A page is erased and programmed only if one of its words differs;
+ *   double-words that stay erased are not programmed. Programming is
+ *   verified by reading the page back.
+ */
+
+#define UPD_PAGE          FLASH_PAGE_SIZE
+#define UPD_FRAME_BYTES   (3u + APP_UPDATE_FRAME_MAX + 4u)
+#define UPD_TIMEOUT       4000000u
+#define UPD_IWDG_FEED()   (IWDG->KR = 0xAAAAu)
+
+#define UPD_FN  __attribute__((section("app_update_ram"), noinline, used))
+
+typedef struct
+{
+  uint8_t frame[UPD_FRAME_BYTES];
+  uint32_t page[UPD_PAGE / 4u];
+} UpdateWork;
+
+#if APP_UPDATE_ENABLE && defined(__ARMCC_VERSION)
+extern uint8_t app_update_ram$$Base[];
+extern uint8_t app_update_ram$$Limit[];
+#define UPD_CODE_BASE   ((uintptr_t)app_update_ram$$Base)
+#define UPD_CODE_BYTES  ((uint32_t)((uintptr_t)app_update_ram$$Limit - (uintptr_t)app_update_ram$$Base))
+#endif
+
+uint32_t AppUpdate_MaxBytes(void)
+{
+  return APP_EVLOG_FLASH_ADDR - FLASH_BASE;
+}
+
+#if APP_UPDATE_ENABLE
+
+static UPD_FN void upd_tx(uint8_t b)
+{
+  while ((USART2->ISR & USART_ISR_TXE_TXFNF) == 0u)
+  {
+  }
+  USART2->TDR = b;
+}
+
+/* -1 on timeout (wait = 1) or a line error. */
+static UPD_FN int32_t upd_rx(uint32_t wait)
+{
+  uint32_t n = 0;
+  while ((USART2->ISR & USART_ISR_RXNE_RXFNE) == 0u)
+  {
+    if ((++n & 0xFFFu) == 0u)
+    {
+      UPD_IWDG_FEED();
+    }
+    if (wait && (n >= UPD_TIMEOUT))
+    {
+      return -1;
+    }
+  }
+  const uint32_t isr = USART2->ISR;
+  const int32_t b = (int32_t)(USART2->RDR & 0xFFu);
+  if ((isr & (USART_ISR_ORE | USART_ISR_FE | USART_ISR_NE | USART_ISR_PE)) != 0u)
+  {
+    USART2->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF | USART_ICR_PECF;
+    return -1;
+  }
+  return b;
+}
+
+static UPD_FN uint32_t upd_crc32(uint32_t crc, const volatile uint8_t *p, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++)
+  {
+    crc ^= p[i];
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return crc;
+}
+
+static UPD_FN uint32_t upd_rd32(const volatile uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* One frame into w->frame (type, len, payload). Returns the payload
+ * length, or -1 when it was damaged or timed out.
+ */
+static UPD_FN int32_t upd_frame(UpdateWork *w)
+{
+  volatile uint8_t *f = w->frame;
+  while (upd_rx(0u) != 'U')
+  {
+  }
+  for (uint32_t i = 0; i < 3u; i++)
+  {
+    const int32_t b = upd_rx(1u);
+    if (b < 0)
+    {
+      return -1;
+    }
+    f[i] = (uint8_t)b;
+  }
+  const uint32_t len = (uint32_t)f[1] | ((uint32_t)f[2] << 8);
+  if (len > APP_UPDATE_FRAME_MAX)
+  {
+    return -1;
+  }
+  for (uint32_t i = 0; i < (len + 4u); i++)
+  {
+    const int32_t b = upd_rx(1u);
+    if (b < 0)
+    {
+      return -1;
+    }
+    f[3u + i] = (uint8_t)b;
+  }
+  if (~upd_crc32(0xFFFFFFFFu, f, 3u + len) != upd_rd32(&f[3u + len]))
+  {
+    return -1;
+  }
+  return (int32_t)len;
+}
+
+static UPD_FN uint8_t upd_flash_wait(void)
+{
+  while ((FLASH->SR & FLASH_SR_BSY) != 0u)
+  {
+    UPD_IWDG_FEED();
+  }
+  const uint32_t err = FLASH->SR & FLASH_FLAG_SR_ERRORS;
+  FLASH->SR = err;
+  return (err == 0u) ? 1u : 0u;
+}
+
+/* Writes the page at image offset 'at' unless flash already holds it. */
+static UPD_FN uint8_t upd_flush(UpdateWork *w, uint32_t at)
+{
+  volatile uint32_t *dst = (volatile uint32_t *)(FLASH_BASE + at);
+  const volatile uint32_t *pg = w->page;
+  uint32_t same = 1u;
+  for (uint32_t i = 0; i < (UPD_PAGE / 4u); i++)
+  {
+    if (dst[i] != pg[i])
+    {
+      same = 0u;
+      break;
+    }
+  }
+  if (same)
+  {
+    return 1u;
+  }
+
+  (void)upd_flash_wait();
+  FLASH->CR = (FLASH->CR & ~(FLASH_CR_PNB | FLASH_CR_PG | FLASH_CR_MER1)) | FLASH_CR_PER |
+              ((at / UPD_PAGE) << FLASH_CR_PNB_Pos);
+  FLASH->CR |= FLASH_CR_STRT;
+  uint8_t ok = upd_flash_wait();
+  FLASH->CR &= ~(FLASH_CR_PER | FLASH_CR_PNB);
+
+  FLASH->CR |= FLASH_CR_PG;
+  for (uint32_t i = 0; ok && (i < (UPD_PAGE / 4u)); i += 2u)
+  {
+    if ((pg[i] == 0xFFFFFFFFu) && (pg[i + 1u] == 0xFFFFFFFFu))
+    {
+      continue;
+    }
+    dst[i] = pg[i];
+    __ISB();
+    dst[i + 1u] = pg[i + 1u];
+    ok = upd_flash_wait();
+  }
+  FLASH->CR &= ~FLASH_CR_PG;
+
+  for (uint32_t i = 0; ok && (i < (UPD_PAGE / 4u)); i++)
+  {
+    ok = (dst[i] == pg[i]) ? 1u : 0u;
+  }
+  return ok;
+}
+
+/* Byte 'at' of the new image while 'pos' bytes are out: the open page is
+ * in the buffer, everything before it already in flash.
+ */
+static UPD_FN uint8_t upd_get(UpdateWork *w, uint32_t at, uint32_t pos)
+{
+  const uint32_t start = pos & ~(UPD_PAGE - 1u);
+  if (at >= start)
+  {
+    return ((const volatile uint8_t *)w->page)[at - start];
+  }
+  return *(const volatile uint8_t *)(FLASH_BASE + at);
+}
+
+static UPD_FN uint8_t upd_put(UpdateWork *w, uint32_t *pos, uint8_t b)
+{
+  ((volatile uint8_t *)w->page)[*pos & (UPD_PAGE - 1u)] = b;
+  *pos += 1u;
+  if ((*pos & (UPD_PAGE - 1u)) == 0u)
+  {
+    return upd_flush(w, *pos - UPD_PAGE);
+  }
+  return 1u;
+}
+
+/* LZ4 block format: token (literal run << 4 | match length - 4), 255-
+ * continued lengths, u16 offsets; the block ends after a literal run.
+ */
+static UPD_FN uint8_t upd_block(UpdateWork *w, const volatile uint8_t *in, uint32_t n, uint32_t *pos, uint32_t size)
+{
+  const volatile uint8_t *end = in + n;
+  while (in < end)
+  {
+    const uint32_t token = *in++;
+    uint32_t run = token >> 4;
+    if (run == 15u)
+    {
+      uint32_t b;
+      do
+      {
+        if (in >= end)
+        {
+          return 0u;
+        }
+        b = *in++;
+        run += b;
+      } while (b == 255u);
+    }
+    if ((run > (uint32_t)(end - in)) || (run > (size - *pos)))
+    {
+      return 0u;
+    }
+    for (uint32_t i = 0; i < run; i++)
+    {
+      if (!upd_put(w, pos, *in++))
+      {
+        return 0u;
+      }
+    }
+    if (in >= end)
+    {
+      break;
+    }
+
+    if ((end - in) < 2)
+    {
+      return 0u;
+    }
+    const uint32_t off = (uint32_t)in[0] | ((uint32_t)in[1] << 8);
+    in += 2;
+    run = (token & 15u) + 4u;
+    if ((token & 15u) == 15u)
+    {
+      uint32_t b;
+      do
+      {
+        if (in >= end)
+        {
+          return 0u;
+        }
+        b = *in++;
+        run += b;
+      } while (b == 255u);
+    }
+    if ((off == 0u) || (off > *pos) || (run > (size - *pos)))
+    {
+      return 0u;
+    }
+    for (uint32_t i = 0; i < run; i++)
+    {
+      if (!upd_put(w, pos, upd_get(w, *pos - off, *pos)))
+      {
+        return 0u;
+      }
+    }
+  }
+  return 1u;
+}
+
+static UPD_FN void upd_reset(void)
+{
+  while ((USART2->ISR & USART_ISR_TC) == 0u)
+  {
+  }
+  __DSB();
+  SCB->AIRCR = (0x5FAu << SCB_AIRCR_VECTKEY_Pos) | (SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk) | SCB_AIRCR_SYSRESETREQ_Msk;
+  __DSB();
+  for (;;)
+  {
+  }
+}
+
+static UPD_FN void upd_run(UpdateWork *w)
+{
+  const uint32_t max = APP_EVLOG_FLASH_ADDR - FLASH_BASE;
+  uint32_t size = 0;
+  uint32_t crc = 0;
+  uint32_t pos = 0;
+  uint32_t seq = 0;
+  uint32_t started = 0;
+
+  upd_tx('R');
+  for (;;)
+  {
+    const int32_t len = upd_frame(w);
+    if (len < 0)
+    {
+      upd_tx('E');
+      continue;
+    }
+    const volatile uint8_t *p = &w->frame[3];
+    const uint8_t type = w->frame[0];
+
+    if ((type == 'B') && (len == 8))
+    {
+      size = upd_rd32(p);
+      crc = upd_rd32(p + 4);
+      pos = 0;
+      seq = 0;
+      started = ((size != 0u) && (size <= max)) ? 1u : 0u;
+      upd_tx(started ? 'K' : 'S');
+    }
+    else if ((type == 'D') && started && (len >= 1))
+    {
+      if (p[0] == (uint8_t)(seq - 1u))
+      {
+        upd_tx('K');
+      }
+      else if ((p[0] == (uint8_t)seq) && upd_block(w, p + 1, (uint32_t)len - 1u, &pos, size))
+      {
+        seq++;
+        upd_tx('K');
+      }
+      else
+      {
+        started = 0;
+        upd_tx('S');
+      }
+    }
+    else if ((type == 'E') && started && (pos == size))
+    {
+      uint8_t ok = 1u;
+      if ((pos & (UPD_PAGE - 1u)) != 0u)
+      {
+        for (uint32_t i = pos; (i & (UPD_PAGE - 1u)) != 0u; i++)
+        {
+          ((volatile uint8_t *)w->page)[i & (UPD_PAGE - 1u)] = 0xFFu;
+        }
+        ok = upd_flush(w, pos & ~(UPD_PAGE - 1u));
+      }
+      started = 0;
+      if (ok && (~upd_crc32(0xFFFFFFFFu, (const volatile uint8_t *)FLASH_BASE, size) == crc))
+      {
+        upd_tx('D');
+        upd_reset();
+      }
+      upd_tx('C');
+    }
+    else if (type == 'X')
+    {
+      upd_tx('K');
+      upd_reset();
+    }
+    else
+    {
+      started = 0;
+      upd_tx('S');
+    }
+  }
+}
+
+#if defined(__ARMCC_VERSION)
+static uint32_t upd_need(void)
+{
+  return ((UPD_CODE_BYTES + 7u) & ~7u) + (uint32_t)sizeof(UpdateWork);
+}
+#endif
+
+uint8_t AppUpdate_Check(uint32_t bytes)
+{
+#if defined(__ARMCC_VERSION)
+  uint32_t scratch;
+  (void)AppDsp_ArenaScratch(&scratch);
+  return ((bytes != 0u) && (bytes <= AppUpdate_MaxBytes()) && (upd_need() <= scratch)) ? 1u : 0u;
+#else
+  (void)bytes;
+  return 0u;
+#endif
+}
+
+void AppUpdate_Enter(void)
+{
+#if defined(__ARMCC_VERSION)
+  uint32_t scratch;
+  uint8_t *ram = (uint8_t *)AppDsp_ArenaScratch(&scratch);
+  if (upd_need() > scratch)
+  {
+    return;
+  }
+
+  __disable_irq();
+  SysTick->CTRL = 0u;
+  /* The UART's DMA would take the bytes the updater polls for. */
+  USART2->CR3 &= ~(USART_CR3_DMAR | USART_CR3_DMAT);
+  USART2->CR1 &= ~(USART_CR1_RXNEIE_RXFNEIE | USART_CR1_TXEIE_TXFNFIE | USART_CR1_TCIE | USART_CR1_IDLEIE);
+  USART2->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF | USART_ICR_PECF | USART_ICR_IDLECF;
+  FLASH->ACR &= ~(FLASH_ACR_ICEN | FLASH_ACR_DCEN);
+  if ((FLASH->CR & FLASH_CR_LOCK) != 0u)
+  {
+    FLASH->KEYR = FLASH_KEY1;
+    FLASH->KEYR = FLASH_KEY2;
+  }
+
+  volatile uint8_t *dst = ram;
+  const volatile uint8_t *src = (const volatile uint8_t *)UPD_CODE_BASE;
+  for (uint32_t i = 0; i < UPD_CODE_BYTES; i++)
+  {
+    dst[i] = src[i];
+  }
+  __DSB();
+  __ISB();
+
+  UpdateWork *w = (UpdateWork *)(void *)(ram + ((UPD_CODE_BYTES + 7u) & ~7u));
+  const uintptr_t entry = (uintptr_t)ram + (((uintptr_t)upd_run & ~(uintptr_t)1u) - UPD_CODE_BASE);
+  void (*run)(UpdateWork *) = (void (*)(UpdateWork *))(entry | 1u);
+  run(w);
+#endif
+}
+
+#else
+
+uint8_t AppUpdate_Check(uint32_t bytes)
+{
+  (void)bytes;
+  return 0u;
+}
+
+void AppUpdate_Enter(void)
+{
+}
+
+#endif /* APP_UPDATE_ENABLE */
@@ -0,0 +1,566 @@
+#include "app_usb.h"
+
+#include <stddef.h>
+
+#include "app_cdc.h"
+#include "app_uac.h"
+
+#define USB_VID              0x0483u   /* ST's, with a PID of our own */
+#define USB_PID              0x5730u
+
+#define USB_PMA_EP0_OUT      0x040u
+#define USB_PMA_EP0_IN       0x080u
+#define USB_PMA_EP1_IN_0     0x0C0u
+#define USB_PMA_EP1_IN_1     (USB_PMA_EP1_IN_0 + 296u)
+#define USB_PMA_EP2_IN       0x310u
+#define USB_PMA_EP3_OUT      0x320u
+#define USB_PMA_EP3_IN       0x360u
+
+/* Standard requests (USB 2.0 9.4). */
+#define USB_REQ_GET_STATUS        0x00u
+#define USB_REQ_CLEAR_FEATURE     0x01u
+#define USB_REQ_SET_FEATURE       0x03u
+#define USB_REQ_SET_ADDRESS       0x05u
+#define USB_REQ_GET_DESCRIPTOR    0x06u
+#define USB_REQ_GET_CONFIGURATION 0x08u
+#define USB_REQ_SET_CONFIGURATION 0x09u
+#define USB_REQ_GET_INTERFACE     0x0Au
+#define USB_REQ_SET_INTERFACE     0x0Bu
+
+#define USB_DESC_DEVICE      0x01u
+#define USB_DESC_CONFIG      0x02u
+#define USB_DESC_STRING      0x03u
+#define USB_DESC_IAD         0x0Bu
+
+#define USB_TYPE_MASK        0x60u
+#define USB_TYPE_STANDARD    0x00u
+#define USB_TYPE_CLASS       0x20u
+#define USB_RECIP_MASK       0x1Fu
+#define USB_RECIP_DEVICE     0x00u
+#define USB_RECIP_INTERFACE  0x01u
+
+#define LO(x)                ((uint8_t)((x) & 0xFFu))
+#define HI(x)                ((uint8_t)(((x) >> 8) & 0xFFu))
+
+typedef enum
+{
+  CTL_IDLE = 0,
+  CTL_DATA_IN,               /* sending a data stage, then the status OUT */
+  CTL_DATA_OUT,              /* receiving one, then the status IN */
+  CTL_STATUS_IN
+} CtlStage;
+
+static const uint8_t k_device_desc[18] = {
+  18u, USB_DESC_DEVICE,
+  0x00u, 0x02u,              /* USB 2.0 */
+  0xEFu, 0x02u, 0x01u,       /* composite: functions in association descriptors */
+  APP_USB_EP0_SIZE,
+  LO(USB_VID), HI(USB_VID),
+  LO(USB_PID), HI(USB_PID),
+  0x00u, 0x01u,              /* release 1.00 */
+  1u, 2u, 3u,                /* manufacturer, product, serial strings */
+  1u,                        /* configurations */
+};
+
+#if APP_UAC_ENABLE
+#define UAC_AC_LEN           (9u + 12u + 9u)
+#define UAC_CONFIG_LEN       (8u + 9u + UAC_AC_LEN + 9u + 9u + 7u + 11u + 9u + 7u)
+#define UAC_INTERFACES       2u
+#else
+#define UAC_CONFIG_LEN       0u
+#define UAC_INTERFACES       0u
+#endif
+#if APP_CDC_ENABLE
+#define CDC_CONFIG_LEN       (8u + 9u + 5u + 5u + 4u + 5u + 7u + 9u + 7u + 7u)
+#define CDC_INTERFACES       2u
+#else
+#define CDC_CONFIG_LEN       0u
+#define CDC_INTERFACES       0u
+#endif
+#define CONFIG_LEN           (9u + UAC_CONFIG_LEN + CDC_CONFIG_LEN)
+
+static const uint8_t k_config_desc[CONFIG_LEN] = {
+  9u, USB_DESC_CONFIG, LO(CONFIG_LEN), HI(CONFIG_LEN),
+  UAC_INTERFACES + CDC_INTERFACES,
+  1u, 0u,
+  0xC0u, 50u,                /* self powered (the pedal's supply), 100 mA at most */
+
+#if APP_UAC_ENABLE
+  8u, USB_DESC_IAD, APP_UAC_IF_CONTROL, 2u, 0x01u, 0x00u, 0x00u, 0u,
+
+  /* Audio control: input terminal (the pedal's output) -> USB stream. */
+  9u, 0x04u, APP_UAC_IF_CONTROL, 0u, 0u, 0x01u, 0x01u, 0x00u, 0u,
+  9u, 0x24u, 0x01u, 0x00u, 0x01u, LO(UAC_AC_LEN), HI(UAC_AC_LEN), 1u, APP_UAC_IF_STREAM,
+  12u, 0x24u, 0x02u, 1u, 0x03u, 0x06u, 0u, APP_UAC_CHANNELS, 0x03u, 0x00u, 0u, 0u,
+  9u, 0x24u, 0x03u, 2u, 0x01u, 0x01u, 0u, 1u, 0u,
+
+  /* Audio streaming: setting 0 idle, setting 1 streaming. */
+  9u, 0x04u, APP_UAC_IF_STREAM, 0u, 0u, 0x01u, 0x02u, 0x00u, 0u,
+  9u, 0x04u, APP_UAC_IF_STREAM, 1u, 1u, 0x01u, 0x02u, 0x00u, 0u,
+  7u, 0x24u, 0x01u, 2u, 1u, 0x01u, 0x00u,                  /* from terminal 2, PCM */
+  11u, 0x24u, 0x02u, 0x01u, APP_UAC_CHANNELS, APP_UAC_SAMPLE_BYTES, 24u,
+  1u, LO(APP_DSP_SAMPLE_RATE_HZ), HI(APP_DSP_SAMPLE_RATE_HZ), (uint8_t)(APP_DSP_SAMPLE_RATE_HZ >> 16),
+  9u, 0x05u, APP_UAC_EP_IN, 0x05u, LO(APP_UAC_EP_SIZE), HI(APP_UAC_EP_SIZE), 1u, 0u, 0u,
+  7u, 0x25u, 0x01u, 0x01u, 0u, 0u, 0u,                     /* sampling rate control */
+#endif
+
+#if APP_CDC_ENABLE
+  8u, USB_DESC_IAD, APP_CDC_IF_COMM, 2u, 0x02u, 0x02u, 0x01u, 0u,
+
+  /* Communication: ACM with line coding and line state, a notification
+   * endpoint the host polls (nothing is ever sent on it).
+   */
+  9u, 0x04u, APP_CDC_IF_COMM, 0u, 1u, 0x02u, 0x02u, 0x01u, 0u,
+  5u, 0x24u, 0x00u, 0x10u, 0x01u,                          /* header, CDC 1.10 */
+  5u, 0x24u, 0x01u, 0x00u, APP_CDC_IF_DATA,                /* call management */
+  4u, 0x24u, 0x02u, 0x02u,                                 /* ACM: line coding, line state */
+  5u, 0x24u, 0x06u, APP_CDC_IF_COMM, APP_CDC_IF_DATA,      /* union */
+  7u, 0x05u, APP_CDC_EP_NOTIFY, 0x03u, APP_CDC_NOTIFY_SIZE, 0u, 16u,
+
+  /* Data: bulk OUT and IN. */
+  9u, 0x04u, APP_CDC_IF_DATA, 0u, 2u, 0x0Au, 0x00u, 0x00u, 0u,
+  7u, 0x05u, APP_CDC_EP_OUT, 0x02u, APP_CDC_EP_SIZE, 0u, 0u,
+  7u, 0x05u, APP_CDC_EP_IN, 0x02u, APP_CDC_EP_SIZE, 0u, 0u,
+#endif
+};
+
+static const uint8_t k_string_lang[4] = {4u, USB_DESC_STRING, 0x09u, 0x04u};
+static const char *const k_strings[] = {"DSP legacy", "DSP legacy pedal"};
+#define USB_STRINGS (sizeof(k_strings) / sizeof(k_strings[0]))
+
+static PCD_HandleTypeDef *s_pcd;
+static volatile AppUsbState s_state;
+static AppUsbState s_state_before_suspend;
+static uint8_t s_config;
+static volatile uint32_t s_resets;
+static volatile uint32_t s_setups;
+static volatile uint32_t s_stalls;
+
+static AppUsbSetup s_req;
+static CtlStage s_stage;
+static const uint8_t *s_ctl_ptr;
+static uint16_t s_ctl_rem;
+static uint8_t s_ctl_zlp;                /* end the data stage with a zero-length packet */
+static uint8_t s_ctl_buf[APP_USB_ENABLE ? APP_USB_EP0_SIZE : 1u];  /* a placeholder byte without USB */
+static uint8_t s_ctl_cdc;                /* the data stage being received is the CDC's */
+
+void AppUsb_Init(PCD_HandleTypeDef *hpcd)
+{
+#if APP_USB_ENABLE
+  s_pcd = hpcd;
+  (void)HAL_PCDEx_PMAConfig(hpcd, 0x00u, PCD_SNG_BUF, USB_PMA_EP0_OUT);
+  (void)HAL_PCDEx_PMAConfig(hpcd, 0x80u, PCD_SNG_BUF, USB_PMA_EP0_IN);
+#if APP_UAC_ENABLE
+  (void)HAL_PCDEx_PMAConfig(hpcd, APP_UAC_EP_IN, PCD_DBL_BUF,
+                            USB_PMA_EP1_IN_0 | (USB_PMA_EP1_IN_1 << 16));
+#endif
+#if APP_CDC_ENABLE
+  (void)HAL_PCDEx_PMAConfig(hpcd, APP_CDC_EP_NOTIFY, PCD_SNG_BUF, USB_PMA_EP2_IN);
+  (void)HAL_PCDEx_PMAConfig(hpcd, APP_CDC_EP_OUT, PCD_SNG_BUF, USB_PMA_EP3_OUT);
+  (void)HAL_PCDEx_PMAConfig(hpcd, APP_CDC_EP_IN, PCD_SNG_BUF, USB_PMA_EP3_IN);
+#endif
+  (void)HAL_PCD_Start(hpcd);
+#else
+  (void)hpcd;
+#endif
+}
+
+void AppUsb_Get(AppUsbInfo *out)
+{
+  if (out == NULL)
+  {
+    return;
+  }
+  out->state = s_state;
+  out->resets = s_resets;
+  out->setups = s_setups;
+  out->stalls = s_stalls;
+}
+
+void AppUsb_Transmit(uint8_t ep, const uint8_t *data, uint16_t len)
+{
+  (void)HAL_PCD_EP_Transmit(s_pcd, ep, (uint8_t *)data, len);
+}
+
+void AppUsb_Receive(uint8_t ep, uint8_t *buf, uint16_t len)
+{
+  (void)HAL_PCD_EP_Receive(s_pcd, ep, buf, len);
+}
+
+static void ctl_send_chunk(void)
+{
+  const uint16_t n = (s_ctl_rem > APP_USB_EP0_SIZE) ? (uint16_t)APP_USB_EP0_SIZE : s_ctl_rem;
+  AppUsb_Transmit(0x80u, s_ctl_ptr, n);
+  s_ctl_ptr += n;
+  s_ctl_rem -= n;
+}
+
+void AppUsb_CtlSend(const uint8_t *data, uint16_t len)
+{
+  if (len > s_req.length)
+  {
+    len = s_req.length;
+  }
+  /* A reply shorter than asked for that fills its last packet needs a
+   * zero-length one to end it.
+   */
+  s_ctl_zlp = (len < s_req.length) && ((len % APP_USB_EP0_SIZE) == 0u);
+  s_ctl_ptr = data;
+  s_ctl_rem = len;
+  s_stage = CTL_DATA_IN;
+  ctl_send_chunk();
+}
+
+void AppUsb_CtlRecv(uint16_t len)
+{
+  if (len > sizeof(s_ctl_buf))
+  {
+    len = sizeof(s_ctl_buf);
+  }
+  s_stage = CTL_DATA_OUT;
+  (void)HAL_PCD_EP_Receive(s_pcd, 0x00u, s_ctl_buf, len);
+}
+
+void AppUsb_CtlStatus(void)
+{
+  s_stage = CTL_STATUS_IN;
+  AppUsb_Transmit(0x80u, NULL, 0u);
+}
+
+static void ctl_stall(void)
+{
+  s_stalls++;
+  s_stage = CTL_IDLE;
+  (void)HAL_PCD_EP_SetStall(s_pcd, 0x80u);
+  (void)HAL_PCD_EP_SetStall(s_pcd, 0x00u);
+}
+
+/* String n as a descriptor in s_ctl_buf; the serial is the chip's unique
+ * ID in hex.
+ */
+static uint8_t string_desc(uint8_t n)
+{
+  uint32_t len = 2u;
+  if ((n >= 1u) && (n <= USB_STRINGS))
+  {
+    for (const char *c = k_strings[n - 1u]; (*c != '\0') && (len < sizeof(s_ctl_buf)); c++)
+    {
+      s_ctl_buf[len++] = (uint8_t)*c;
+      s_ctl_buf[len++] = 0u;
+    }
+  }
+  else if (n == (USB_STRINGS + 1u))
+  {
+    static const char k_hex[] = "0123456789ABCDEF";
+    const uint32_t *uid = (const uint32_t *)UID_BASE;
+    for (uint32_t w = 0; w < 3u; w++)
+    {
+      for (int32_t shift = 28; shift >= 0; shift -= 4)
+      {
+        s_ctl_buf[len++] = (uint8_t)k_hex[(uid[w] >> shift) & 0xFu];
+        s_ctl_buf[len++] = 0u;
+      }
+    }
+  }
+  else
+  {
+    return 0u;
+  }
+  s_ctl_buf[0] = (uint8_t)len;
+  s_ctl_buf[1] = USB_DESC_STRING;
+  return (uint8_t)len;
+}
+
+static uint8_t get_descriptor(void)
+{
+  const uint8_t index = LO(s_req.value);
+  switch (HI(s_req.value))
+  {
+    case USB_DESC_DEVICE:
+      AppUsb_CtlSend(k_device_desc, sizeof(k_device_desc));
+      return 1u;
+    case USB_DESC_CONFIG:
+      AppUsb_CtlSend(k_config_desc, sizeof(k_config_desc));
+      return 1u;
+    case USB_DESC_STRING:
+    {
+      if (index == 0u)
+      {
+        AppUsb_CtlSend(k_string_lang, sizeof(k_string_lang));
+        return 1u;
+      }
+      const uint8_t len = string_desc(index);
+      if (len == 0u)
+      {
+        return 0u;
+      }
+      AppUsb_CtlSend(s_ctl_buf, len);
+      return 1u;
+    }
+    default:
+      /* No device qualifier: a full-speed-only device stalls it. */
+      return 0u;
+  }
+}
+
+#if APP_CDC_ENABLE
+static void cdc_close(PCD_HandleTypeDef *hpcd)
+{
+  AppCdc_Reset();
+  (void)HAL_PCD_EP_Close(hpcd, APP_CDC_EP_NOTIFY);
+  (void)HAL_PCD_EP_Close(hpcd, APP_CDC_EP_OUT);
+  (void)HAL_PCD_EP_Close(hpcd, APP_CDC_EP_IN);
+}
+#endif
+
+static uint8_t is_cdc_interface(uint16_t iface)
+{
+  return APP_CDC_ENABLE && ((iface == APP_CDC_IF_COMM) || (iface == APP_CDC_IF_DATA));
+}
+
+static uint8_t set_configuration(uint8_t config)
+{
+  if (config > 1u)
+  {
+    return 0u;
+  }
+#if APP_UAC_ENABLE
+  if (s_config != 0u)
+  {
+    AppUac_Reset();
+    (void)HAL_PCD_EP_Close(s_pcd, APP_UAC_EP_IN);
+  }
+  if (config != 0u)
+  {
+    (void)HAL_PCD_EP_Open(s_pcd, APP_UAC_EP_IN, APP_UAC_EP_SIZE, EP_TYPE_ISOC);
+  }
+#endif
+#if APP_CDC_ENABLE
+  if (s_config != 0u)
+  {
+    cdc_close(s_pcd);
+  }
+  if (config != 0u)
+  {
+    (void)HAL_PCD_EP_Open(s_pcd, APP_CDC_EP_NOTIFY, APP_CDC_NOTIFY_SIZE, EP_TYPE_INTR);
+    (void)HAL_PCD_EP_Open(s_pcd, APP_CDC_EP_OUT, APP_CDC_EP_SIZE, EP_TYPE_BULK);
+    (void)HAL_PCD_EP_Open(s_pcd, APP_CDC_EP_IN, APP_CDC_EP_SIZE, EP_TYPE_BULK);
+    AppCdc_Start();
+  }
+#endif
+  s_config = config;
+  s_state = (config != 0u) ? APP_USB_STATE_CONFIGURED : APP_USB_STATE_ADDRESSED;
+  return 1u;
+}
+
+static uint8_t standard_request(void)
+{
+  switch (s_req.request)
+  {
+    case USB_REQ_GET_STATUS:
+      s_ctl_buf[0] = ((s_req.type & USB_RECIP_MASK) == USB_RECIP_DEVICE) ? 1u : 0u;   /* self powered */
+      s_ctl_buf[1] = 0u;
+      AppUsb_CtlSend(s_ctl_buf, 2u);
+      return 1u;
+    case USB_REQ_CLEAR_FEATURE:
+    case USB_REQ_SET_FEATURE:
+      /* Remote wakeup is not offered and no endpoint is ever halted. */
+      AppUsb_CtlStatus();
+      return 1u;
+    case USB_REQ_SET_ADDRESS:
+      /* The HAL sets the address once the status stage has gone out. */
+      (void)HAL_PCD_SetAddress(s_pcd, (uint8_t)(s_req.value & 0x7Fu));
+      s_state = ((s_req.value & 0x7Fu) != 0u) ? APP_USB_STATE_ADDRESSED : APP_USB_STATE_DEFAULT;
+      AppUsb_CtlStatus();
+      return 1u;
+    case USB_REQ_GET_DESCRIPTOR:
+      return get_descriptor();
+    case USB_REQ_GET_CONFIGURATION:
+      s_ctl_buf[0] = s_config;
+      AppUsb_CtlSend(s_ctl_buf, 1u);
+      return 1u;
+    case USB_REQ_SET_CONFIGURATION:
+      if (!set_configuration(LO(s_req.value)))
+      {
+        return 0u;
+      }
+      AppUsb_CtlStatus();
+      return 1u;
+    case USB_REQ_GET_INTERFACE:
+      if (s_config == 0u)
+      {
+        return 0u;
+      }
+      if (is_cdc_interface(LO(s_req.index)))
+      {
+        s_ctl_buf[0] = 0u;
+      }
+      else if (!AppUac_GetInterface(LO(s_req.index), &s_ctl_buf[0]))
+      {
+        return 0u;
+      }
+      AppUsb_CtlSend(s_ctl_buf, 1u);
+      return 1u;
+    case USB_REQ_SET_INTERFACE:
+      if ((s_config == 0u) ||
+          (is_cdc_interface(LO(s_req.index)) ? (s_req.value != 0u)
+                                             : !AppUac_SetInterface(LO(s_req.index), s_req.value)))
+      {
+        return 0u;
+      }
+      AppUsb_CtlStatus();
+      return 1u;
+    default:
+      return 0u;
+  }
+}
+
+/* Class requests go to the function that owns the interface they name;
+ * the audio one also takes those to its endpoint.
+ */
+static uint8_t class_request(void)
+{
+  if (s_config == 0u)
+  {
+    return 0u;
+  }
+  s_ctl_cdc = ((s_req.type & USB_RECIP_MASK) == USB_RECIP_INTERFACE) && is_cdc_interface(LO(s_req.index));
+  if (s_ctl_cdc)
+  {
+    return AppCdc_Setup(&s_req);
+  }
+  return AppUac_Setup(&s_req);
+}
+
+void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
+{
+  const uint8_t *p = (const uint8_t *)hpcd->Setup;
+  s_req.type = p[0];
+  s_req.request = p[1];
+  s_req.value = (uint16_t)(p[2] | (p[3] << 8));
+  s_req.index = (uint16_t)(p[4] | (p[5] << 8));
+  s_req.length = (uint16_t)(p[6] | (p[7] << 8));
+  s_setups++;
+  s_stage = CTL_IDLE;
+
+  uint8_t handled = 0u;
+  switch (s_req.type & USB_TYPE_MASK)
+  {
+    case USB_TYPE_STANDARD:
+      handled = standard_request();
+      break;
+    case USB_TYPE_CLASS:
+      handled = class_request();
+      break;
+    default:
+      break;
+  }
+  if (!handled)
+  {
+    ctl_stall();
+  }
+}
+
+void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+  (void)hpcd;
+  if (epnum == (APP_UAC_EP_IN & 0x7Fu))
+  {
+    AppUac_DataIn();
+    return;
+  }
+  if (epnum == (APP_CDC_EP_IN & 0x7Fu))
+  {
+    AppCdc_DataIn();
+    return;
+  }
+  if ((epnum != 0u) || (s_stage != CTL_DATA_IN))
+  {
+    s_stage = CTL_IDLE;
+    return;
+  }
+  if (s_ctl_rem != 0u)
+  {
+    ctl_send_chunk();
+  }
+  else if (s_ctl_zlp)
+  {
+    s_ctl_zlp = 0u;
+    AppUsb_Transmit(0x80u, NULL, 0u);
+  }
+  else
+  {
+    /* Data stage done: the host's zero-length OUT ends the request. */
+    s_stage = CTL_IDLE;
+    (void)HAL_PCD_EP_Receive(s_pcd, 0x00u, NULL, 0u);
+  }
+}
+
+void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+  if (epnum == APP_CDC_EP_OUT)
+  {
+    AppCdc_DataOut((uint16_t)HAL_PCD_EP_GetRxCount(hpcd, APP_CDC_EP_OUT));
+    return;
+  }
+  if ((epnum != 0u) || (s_stage != CTL_DATA_OUT))
+  {
+    return;
+  }
+  const uint16_t len = (uint16_t)HAL_PCD_EP_GetRxCount(hpcd, 0x00u);
+  if (s_ctl_cdc)
+  {
+    AppCdc_CtlOut(s_ctl_buf, len);
+  }
+  else
+  {
+    AppUac_CtlOut(s_ctl_buf, len);
+  }
+  AppUsb_CtlStatus();
+}
+
+void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
+{
+#if APP_UAC_ENABLE
+  AppUac_Reset();
+  if (s_config != 0u)
+  {
+    (void)HAL_PCD_EP_Close(hpcd, APP_UAC_EP_IN);
+  }
+#endif
+#if APP_CDC_ENABLE
+  if (s_config != 0u)
+  {
+    cdc_close(hpcd);
+  }
+  else
+  {
+    AppCdc_Reset();
+  }
+#endif
+  s_config = 0u;
+  s_stage = CTL_IDLE;
+  (void)HAL_PCD_EP_Open(hpcd, 0x00u, APP_USB_EP0_SIZE, EP_TYPE_CTRL);
+  (void)HAL_PCD_EP_Open(hpcd, 0x80u, APP_USB_EP0_SIZE, EP_TYPE_CTRL);
+  s_state = APP_USB_STATE_DEFAULT;
+  s_resets++;
+}
+
+void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
+{
+  (void)hpcd;
+  if (s_state != APP_USB_STATE_SUSPENDED)
+  {
+    s_state_before_suspend = s_state;
+    s_state = APP_USB_STATE_SUSPENDED;
+  }
+}
+
+void HAL_PCD_ResumeCallback(PCD_HandleTypeDef *hpcd)
+{
+  (void)hpcd;
+  if (s_state == APP_USB_STATE_SUSPENDED)
+  {
+    s_state = s_state_before_suspend;
+  }
+}
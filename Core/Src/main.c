@@ -23,9 +23,25 @@
 /* USER CODE BEGIN Includes */
 
 #include "app_audio.h"
+#include "app_ble.h"
+#include "app_cabir.h"
 #include "app_com.h"
 #include "app_dsp.h"
 #include "app_error.h"
+#include "app_evlog.h"
+#include "app_expr.h"
+#include "app_fmac.h"
+#include "app_lfo.h"
+#include "app_mem.h"
+#include "app_midi.h"
+#include "app_power.h"
+#include "app_preset.h"
+#include "app_prof.h"
+#include "app_restart.h"
+#include "app_sched.h"
+#include "app_serial.h"
+#include "app_switch.h"
+#include "app_usb.h"
 
 /* USER CODE END Includes */
 
@@ -50,7 +66,22 @@ I2S_HandleTypeDef hi2s3;
 DMA_HandleTypeDef hdma_spi2_rx;
 DMA_HandleTypeDef hdma_spi3_tx;
 DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 UART_HandleTypeDef huart2;
+#if APP_MIDI_ENABLE
+DMA_HandleTypeDef hdma_usart1_rx;
+UART_HandleTypeDef huart1;
+#endif
+#if APP_BLE_ENABLE
+UART_HandleTypeDef huart3;
+#endif
+CORDIC_HandleTypeDef hcordic;
+FMAC_HandleTypeDef hfmac;
+#if APP_USB_ENABLE
+PCD_HandleTypeDef hpcd_USB_FS;
+#endif
+ADC_HandleTypeDef hadc1;
+DMA_HandleTypeDef hdma_adc1;
 
 /* USER CODE BEGIN PV */
 
@@ -65,6 +96,18 @@ static void MX_DMA_Init(void);
 static void MX_I2S2_Init(void);
 static void MX_I2S3_Init(void);
 static void MX_USART2_UART_Init(void);
+static void MX_CORDIC_Init(void);
+static void MX_FMAC_Init(void);
+static void MX_ADC1_Init(void);
+#if APP_MIDI_ENABLE
+static void MX_USART1_UART_Init(void);
+#endif
+#if APP_BLE_ENABLE
+static void MX_USART3_UART_Init(void);
+#endif
+#if APP_USB_ENABLE
+static void MX_USB_PCD_Init(void);
+#endif
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -74,6 +117,36 @@ static void MX_USART2_UART_Init(void);
 
 /* All DSP/audio moved to app_audio.c + app_dsp.c. */
 
+/* Status LED, a housekeeping task. */
+static void led_task(void)
+{
+  static uint32_t last_blink_ms;
+  uint32_t now = HAL_GetTick();
+  uint32_t interval_ms = 500U;
+
+  if (AppAudio_StartFailed() || AppAudio_RuntimeFailed())
+  {
+    /* Fast blink means audio did not (re)start (HAL_I2S_*_DMA failed). */
+    interval_ms = 100U;
+  }
+  else
+  {
+    /* Slow blink means main loop alive; vary with FX mode for debugging. */
+    AppFxMode mode = AppDsp_GetMode();
+    if (mode == APP_FX_MODE_DISTORTION) interval_ms = 150U;
+    else if (mode == APP_FX_MODE_REVERB) interval_ms = 250U;
+    else if (mode == APP_FX_MODE_DELAY) interval_ms = 350U;
+    else if (mode == APP_FX_MODE_ALL) interval_ms = 425U;
+    else interval_ms = 500U;
+  }
+
+  if ((now - last_blink_ms) >= interval_ms)
+  {
+    HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
+    last_blink_ms = now;
+  }
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -84,7 +157,7 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+  AppMem_PaintStack();
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -100,7 +173,7 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  AppRestart_Init();
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
@@ -108,54 +181,100 @@ int main(void)
   MX_DMA_Init();
   MX_I2S2_Init();
   MX_I2S3_Init();
-  MX_USART2_UART_Init();
+  MX_CORDIC_Init();
+  MX_FMAC_Init();
+  MX_ADC1_Init();
+#if APP_MIDI_ENABLE
+  MX_USART1_UART_Init();
+#endif
+#if APP_USB_ENABLE
+  MX_USB_PCD_Init();
+#endif
   /* USER CODE BEGIN 2 */
 
-  AppDsp_Init();
-  AppCom_Init(&huart2);
+  AppProf_Init();
+  AppFmac_Init(&hfmac);
+#if APP_LFO_USE_CORDIC
+  AppLfo_Init(&hcordic);
+#endif
+  AppDsp_InitAtBoot();
+  {
+    /* The looper gets whatever SRAM the image leaves. */
+    uint32_t loop_bytes;
+    uint32_t *loop_buf = (uint32_t *)AppMem_ClaimFree(&loop_bytes);
+    AppDsp_SetLoopBuffer(loop_buf, loop_bytes);
+  }
+  /* Power-up sound, before the audio starts: the slot last in use (preset
+   * 0 if none was marked, defaults if it is empty too); after a watchdog
+   * or software reset the settings that were live (app_restart.h).
+   */
+  AppPreset_Init();
+  (void)AppRestart_Restore();
+  /* The event log's page erases, if any, happen here, before the audio. */
+  AppEvLog_Init();
+  AppSwitch_Init();
+  AppExpr_Init(&hadc1);
+#if APP_MIDI_ENABLE
+  AppMidi_Init(&huart1);
+#else
+  AppMidi_Init(NULL);
+#endif
+#if APP_USB_ENABLE
+  AppUsb_Init(&hpcd_USB_FS);
+#endif
   AppAudio_Init(&hi2s2, &hi2s3);
   AppAudio_Start();
 
+  /* Audio runs from here (silence first, then the fade-in); the rest of
+   * the boot is off its path. The cab IR check runs the CRC over the whole
+   * stored IR, and the biquad cab plays until it is active. USART2 (and
+   * USART3, the BLE module) is set up here rather than with the other
+   * peripherals above.
+   */
+  MX_USART2_UART_Init();
+  AppCabIr_Init();
+  AppSerial_Init(&huart2);
+#if APP_BLE_ENABLE
+  MX_USART3_UART_Init();
+  AppBle_Init(&huart3);
+#else
+  AppBle_Init(NULL);
+#endif
+  AppCom_Init();
+
+  /* Main-loop work by priority (app_sched.h): the I2S restart after an
+   * error and COM first, then MIDI, the footswitches, the expression
+   * pedal, a parameter publish that waited on the timed queue, a
+   * preset-morph glide and last-slot mark, the COM SUB topics and the
+   * watchdog feed, the clock governor, then the event log and the LED. All of it is non-blocking.
+   */
+  (void)AppSched_Add("audio", AppAudio_Poll, APP_SCHED_PRIO_HIGH, 0U, 50U);
+  (void)AppSched_Add("com", AppCom_Poll, APP_SCHED_PRIO_HIGH, 0U, 500U);
+  (void)AppSched_Add("midi", AppMidi_Poll, APP_SCHED_PRIO_CONTROL, 1U, 200U);
+  (void)AppSched_Add("switch", AppSwitch_Poll, APP_SCHED_PRIO_CONTROL, 1U, 200U);
+  (void)AppSched_Add("expr", AppExpr_Poll, APP_SCHED_PRIO_CONTROL, 1U, 100U);
+  (void)AppSched_Add("dsp", AppDsp_Poll, APP_SCHED_PRIO_CONTROL, 0U, 100U);
+  (void)AppSched_Add("preset", AppPreset_Poll, APP_SCHED_PRIO_CONTROL, 10U, 300U);
+  (void)AppSched_Add("pub", AppCom_Publish, APP_SCHED_PRIO_CONTROL, 1U, 200U);
+  (void)AppSched_Add("restart", AppRestart_Poll, APP_SCHED_PRIO_CONTROL, 10U, 300U);
+  (void)AppSched_Add("clock", AppPower_Poll, APP_SCHED_PRIO_CONTROL, 1U, 50U);
+  (void)AppSched_Add("evlog", AppEvLog_Poll, APP_SCHED_PRIO_HOUSEKEEPING, APP_EVLOG_POLL_MS, 300U);
+  (void)AppSched_Add("led", led_task, APP_SCHED_PRIO_HOUSEKEEPING, 10U, 20U);
+  AppRestart_Start();
+
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
-  uint32_t last_blink_ms = HAL_GetTick();
   while (1)
   {
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-    /* Handle any incoming COM commands (non-blocking). */
-    AppCom_Poll();
-
-    /* Non-blocking status LED: never stall the main loop, otherwise UART COM
-     * parsing/ack (and therefore the PC UI) becomes very sluggish.
-     */
-    uint32_t now = HAL_GetTick();
-    uint32_t interval_ms = 500U;
-
-    if (AppAudio_StartFailed() || AppAudio_RuntimeFailed())
-    {
-      /* Fast blink means audio did not start (HAL_I2S_*_DMA failed). */
-      interval_ms = 100U;
-    }
-    else
-    {
-      /* Slow blink means main loop alive; vary with FX mode for debugging. */
-      AppFxMode mode = AppDsp_GetMode();
-      if (mode == APP_FX_MODE_DISTORTION) interval_ms = 150U;
-      else if (mode == APP_FX_MODE_REVERB) interval_ms = 250U;
-      else if (mode == APP_FX_MODE_DELAY) interval_ms = 350U;
-      else if (mode == APP_FX_MODE_ALL) interval_ms = 425U;
-      else interval_ms = 500U;
-    }
-
-    if ((now - last_blink_ms) >= interval_ms)
-    {
-      HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-      last_blink_ms = now;
-    }
+    AppSched_Run();
+
+    /* Sleep until the next UART, audio or tick interrupt. */
+    AppPower_Idle();
   }
   /* USER CODE END 3 */
 }
@@ -176,8 +295,9 @@ void SystemClock_Config(void)
   /** Initializes the RCC Oscillators according to the specified parameters
   * in the RCC_OscInitTypeDef structure.
   */
-  RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+  RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI|RCC_OSCILLATORTYPE_HSI48;
   RCC_OscInitStruct.HSIState = RCC_HSI_ON;
+  RCC_OscInitStruct.HSI48State = RCC_HSI48_ON;
   RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
   RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
   RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
@@ -233,7 +353,23 @@ static void MX_I2S2_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN I2S2_Init 2 */
-
+#if (APP_AUDIO_SAMPLE_RATE_HZ != 48000u) || APP_AUDIO_EXT_CLOCK
+  /* CubeMX keeps 48 kHz; the build rate comes from app_dsp.h. The external
+   * clock has no divider left for MCLK out (see app_audio.h).
+   */
+  if (HAL_I2S_DeInit(&hi2s2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  hi2s2.Init.AudioFreq = APP_AUDIO_SAMPLE_RATE_HZ;
+#if APP_AUDIO_EXT_CLOCK
+  hi2s2.Init.MCLKOutput = I2S_MCLKOUTPUT_DISABLE;
+#endif
+  if (HAL_I2S_Init(&hi2s2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+#endif
   /* USER CODE END I2S2_Init 2 */
 
 }
@@ -265,7 +401,30 @@ static void MX_I2S3_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN I2S3_Init 2 */
-
+#if APP_AUDIO_SAMPLE_RATE_HZ != 48000u
+  if (HAL_I2S_DeInit(&hi2s3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  hi2s3.Init.AudioFreq = APP_AUDIO_SAMPLE_RATE_HZ;
+  if (HAL_I2S_Init(&hi2s3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+#endif
+#if APP_AUDIO_SYNC_CLOCK
+  /* Single clock domain: DAC interface follows the I2S2 CK/WS (see app_audio.h). */
+  if (HAL_I2S_DeInit(&hi2s3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  hi2s3.Init.Mode = I2S_MODE_SLAVE_TX;
+  hi2s3.Init.MCLKOutput = I2S_MCLKOUTPUT_DISABLE;
+  if (HAL_I2S_Init(&hi2s3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+#endif
   /* USER CODE END I2S3_Init 2 */
 
 }
@@ -292,6 +451,10 @@ static void MX_DMA_Init(void)
   HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 1, 0);
   HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
 
+  /* DMA1_Channel4_IRQn interrupt configuration (USART2 TX) */
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 2, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+
 }
 
 /**
@@ -335,22 +498,25 @@ static void MX_GPIO_Init(void)
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
-  AppCom_OnUartRxCplt(huart);
+  AppSerial_OnUartRxCplt(huart);
 }
 
 void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
-  AppCom_OnUartRxEvent(huart, Size);
+  AppSerial_OnUartRxEvent(huart, Size);
+  AppBle_OnUartRxEvent(huart, Size);
 }
 
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
-  AppCom_OnUartTxCplt(huart);
+  AppSerial_OnUartTxCplt(huart);
+  AppBle_OnUartTxCplt(huart);
 }
 
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
-  AppCom_OnUartError(huart);
+  AppSerial_OnUartError(huart);
+  AppBle_OnUartError(huart);
 }
 
 void HAL_I2S_RxHalfCpltCallback(I2S_HandleTypeDef *hi2s)
@@ -415,6 +581,200 @@ static void MX_USART2_UART_Init(void)
   /* USER CODE END USART2_Init 2 */
 }
 
+#if APP_MIDI_ENABLE
+/**
+  * @brief USART1 Initialization Function: MIDI in on PA10, read from
+  * circular DMA, and MIDI out on PA9 for the COM SysEx replies, fed from the
+  * TX FIFO (app_midi.h).
+  * @param None
+  * @retval None
+  */
+static void MX_USART1_UART_Init(void)
+{
+  huart1.Instance = USART1;
+  huart1.Init.BaudRate = 31250;
+  huart1.Init.WordLength = UART_WORDLENGTH_8B;
+  huart1.Init.StopBits = UART_STOPBITS_1;
+  huart1.Init.Parity = UART_PARITY_NONE;
+  huart1.Init.Mode = UART_MODE_TX_RX;
+  huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+  huart1.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+  /* Nothing services an overrun; the DMA keeps up with 3125 bytes/s. */
+  huart1.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_RXOVERRUNDISABLE_INIT;
+  huart1.AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
+  if (HAL_UART_Init(&huart1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_UARTEx_EnableFifoMode(&huart1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+#endif
+
+#if APP_BLE_ENABLE
+/**
+  * @brief USART3 Initialization Function: the BLE UART module on PB10/PB11
+  * (app_ble.h), interrupt-driven through the FIFOs.
+  * @param None
+  * @retval None
+  */
+static void MX_USART3_UART_Init(void)
+{
+  huart3.Instance = USART3;
+  huart3.Init.BaudRate = APP_BLE_BAUD;
+  huart3.Init.WordLength = UART_WORDLENGTH_8B;
+  huart3.Init.StopBits = UART_STOPBITS_1;
+  huart3.Init.Parity = UART_PARITY_NONE;
+  huart3.Init.Mode = UART_MODE_TX_RX;
+  huart3.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  huart3.Init.OverSampling = UART_OVERSAMPLING_16;
+  huart3.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+  huart3.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
+  if (HAL_UART_Init(&huart3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_UARTEx_EnableFifoMode(&huart3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+#endif
+
+#if APP_USB_ENABLE
+/**
+  * @brief USB Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_USB_PCD_Init(void)
+{
+  hpcd_USB_FS.Instance = USB;
+  hpcd_USB_FS.Init.dev_endpoints = 8;
+  hpcd_USB_FS.Init.speed = PCD_SPEED_FULL;
+  hpcd_USB_FS.Init.phy_itface = PCD_PHY_EMBEDDED;
+  hpcd_USB_FS.Init.Sof_enable = DISABLE;
+  hpcd_USB_FS.Init.low_power_enable = DISABLE;
+  hpcd_USB_FS.Init.lpm_enable = DISABLE;
+  hpcd_USB_FS.Init.battery_charging_enable = DISABLE;
+  if (HAL_PCD_Init(&hpcd_USB_FS) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+#endif
+
+/**
+  * @brief CORDIC Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_CORDIC_Init(void)
+{
+  /* USER CODE BEGIN CORDIC_Init 0 */
+
+  /* USER CODE END CORDIC_Init 0 */
+
+  /* USER CODE BEGIN CORDIC_Init 1 */
+
+  /* USER CODE END CORDIC_Init 1 */
+
+  hcordic.Instance = CORDIC;
+  if (HAL_CORDIC_Init(&hcordic) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  /* USER CODE BEGIN CORDIC_Init 2 */
+
+  /* USER CODE END CORDIC_Init 2 */
+}
+
+/**
+  * @brief FMAC Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_FMAC_Init(void)
+{
+  /* USER CODE BEGIN FMAC_Init 0 */
+
+  /* USER CODE END FMAC_Init 0 */
+
+  /* USER CODE BEGIN FMAC_Init 1 */
+
+  /* USER CODE END FMAC_Init 1 */
+
+  hfmac.Instance = FMAC;
+  if (HAL_FMAC_Init(&hfmac) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  /* USER CODE BEGIN FMAC_Init 2 */
+
+  /* USER CODE END FMAC_Init 2 */
+}
+
+/**
+  * @brief ADC1 Initialization Function: the expression pedal on PA0,
+  * converted continuously with 32x oversampling into circular DMA
+  * (app_expr.h).
+  * @param None
+  * @retval None
+  */
+static void MX_ADC1_Init(void)
+{
+  ADC_MultiModeTypeDef multimode = {0};
+  ADC_ChannelConfTypeDef sConfig = {0};
+
+  hadc1.Instance = ADC1;
+  hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
+  hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+  hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+  hadc1.Init.GainCompensation = 0;
+  hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;
+  hadc1.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+  hadc1.Init.LowPowerAutoWait = DISABLE;
+  hadc1.Init.ContinuousConvMode = ENABLE;
+  hadc1.Init.NbrOfConversion = 1;
+  hadc1.Init.DiscontinuousConvMode = DISABLE;
+  hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+  hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+  hadc1.Init.DMAContinuousRequests = ENABLE;
+  hadc1.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+  /* 32 x 12 bits >> 1: 16-bit results at ~2 kHz (42.5 MHz / 653 / 32). */
+  hadc1.Init.OversamplingMode = ENABLE;
+  hadc1.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO_32;
+  hadc1.Init.Oversampling.RightBitShift = ADC_RIGHTBITSHIFT_1;
+  hadc1.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+  hadc1.Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+  if (HAL_ADC_Init(&hadc1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  multimode.Mode = ADC_MODE_INDEPENDENT;
+  if (HAL_ADCEx_MultiModeConfigChannel(&hadc1, &multimode) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  sConfig.Channel = ADC_CHANNEL_1;
+  sConfig.Rank = ADC_REGULAR_RANK_1;
+  sConfig.SamplingTime = ADC_SAMPLETIME_640CYCLES_5;
+  sConfig.SingleDiff = ADC_SINGLE_ENDED;
+  sConfig.OffsetNumber = ADC_OFFSET_NONE;
+  sConfig.Offset = 0;
+  if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
 /**
   * @brief  Period elapsed callback in non blocking mode
   * @note   This function is called  when TIM2 interrupt took place, inside
@@ -430,6 +790,9 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
   if (htim->Instance == TIM2)
   {
     HAL_IncTick();
+    AppSwitch_Sample();
+    AppExpr_Sample();
+    AppMidi_Sample();
   }
   /* USER CODE BEGIN Callback 1 */
 
@@ -21,6 +21,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 /* USER CODE BEGIN Includes */
+#include "app_audio.h"
+#include "app_midi.h"
 
 /* USER CODE END Includes */
 extern DMA_HandleTypeDef hdma_spi2_rx;
@@ -29,6 +31,14 @@ extern DMA_HandleTypeDef hdma_spi3_tx;
 
 extern DMA_HandleTypeDef hdma_usart2_rx;
 
+extern DMA_HandleTypeDef hdma_usart2_tx;
+
+#if APP_MIDI_ENABLE
+extern DMA_HandleTypeDef hdma_usart1_rx;
+#endif
+
+extern DMA_HandleTypeDef hdma_adc1;
+
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN TD */
 
@@ -155,6 +165,26 @@ void HAL_I2S_MspInit(I2S_HandleTypeDef* hi2s)
     __HAL_LINKDMA(hi2s,hdmarx,hdma_spi2_rx);
 
     /* USER CODE BEGIN SPI2_MspInit 1 */
+#if APP_AUDIO_EXT_CLOCK
+    /* Kernel clock from the audio crystal (app_audio.h); HAL_I2S_Init()
+     * computes the dividers after this, from EXTERNAL_CLOCK_VALUE.
+     */
+    PeriphClkInit.I2sClockSelection = RCC_I2SCLKSOURCE_EXT;
+    if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    /**I2S_CKIN GPIO Configuration
+    PC9     ------> I2S_CKIN
+    */
+    GPIO_InitStruct.Pin = GPIO_PIN_9;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF5_SPI2;
+    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+#endif
 
     /* USER CODE END SPI2_MspInit 1 */
   }
@@ -216,6 +246,14 @@ void HAL_I2S_MspInit(I2S_HandleTypeDef* hi2s)
     __HAL_LINKDMA(hi2s,hdmatx,hdma_spi3_tx);
 
     /* USER CODE BEGIN SPI3_MspInit 1 */
+#if APP_AUDIO_EXT_CLOCK
+    /* Same kernel clock mux as I2S2: keep it on the crystal. */
+    PeriphClkInit.I2sClockSelection = RCC_I2SCLKSOURCE_EXT;
+    if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
+    {
+      Error_Handler();
+    }
+#endif
 
     /* USER CODE END SPI3_MspInit 1 */
   }
@@ -290,8 +328,12 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
 {
   GPIO_InitTypeDef GPIO_InitStruct = {0};
 
+  /* The USARTs take SYSCLK rather than PCLK, so the AppPower clock steps
+   * (HCLK / 2) leave the baud rates alone; the same 170 MHz at full clock.
+   */
   if (huart->Instance == USART2)
   {
+    __HAL_RCC_USART2_CONFIG(RCC_USART2CLKSOURCE_SYSCLK);
     __HAL_RCC_USART2_CLK_ENABLE();
     __HAL_RCC_GPIOA_CLK_ENABLE();
 
@@ -314,7 +356,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
     hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
     hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_usart2_rx.Init.Mode = DMA_NORMAL;
+    hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
     hdma_usart2_rx.Init.Priority = DMA_PRIORITY_MEDIUM;
     if (HAL_DMA_Init(&hdma_usart2_rx) != HAL_OK)
     {
@@ -323,9 +365,82 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
 
     __HAL_LINKDMA(huart, hdmarx, hdma_usart2_rx);
 
+    /* USART2 TX DMA Init */
+    hdma_usart2_tx.Instance = DMA1_Channel4;
+    hdma_usart2_tx.Init.Request = DMA_REQUEST_USART2_TX;
+    hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart2_tx.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_usart2_tx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(huart, hdmatx, hdma_usart2_tx);
+
     HAL_NVIC_SetPriority(USART2_IRQn, 2, 0);
     HAL_NVIC_EnableIRQ(USART2_IRQn);
   }
+#if APP_MIDI_ENABLE
+  else if (huart->Instance == USART1)
+  {
+    __HAL_RCC_USART1_CONFIG(RCC_USART1CLKSOURCE_SYSCLK);
+    __HAL_RCC_USART1_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    /**USART1 GPIO Configuration
+    PA9     ------> USART1_TX (MIDI out)
+    PA10     ------> USART1_RX (MIDI in)
+    */
+    GPIO_InitStruct.Pin = GPIO_PIN_9 | GPIO_PIN_10;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /* USART1 RX DMA Init: circular, read by the 1 kHz tick, no interrupt */
+    hdma_usart1_rx.Instance = DMA1_Channel6;
+    hdma_usart1_rx.Init.Request = DMA_REQUEST_USART1_RX;
+    hdma_usart1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_usart1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart1_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.Mode = DMA_CIRCULAR;
+    hdma_usart1_rx.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(huart, hdmarx, hdma_usart1_rx);
+  }
+#endif
+  else if (huart->Instance == USART3)
+  {
+    __HAL_RCC_USART3_CONFIG(RCC_USART3CLKSOURCE_SYSCLK);
+    __HAL_RCC_USART3_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    /**USART3 GPIO Configuration
+    PB10     ------> USART3_TX (BLE module RX)
+    PB11     ------> USART3_RX (BLE module TX)
+    */
+    GPIO_InitStruct.Pin = GPIO_PIN_10 | GPIO_PIN_11;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF7_USART3;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    HAL_NVIC_SetPriority(USART3_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(USART3_IRQn);
+  }
 }
 
 /**
@@ -340,8 +455,185 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
     __HAL_RCC_USART2_CLK_DISABLE();
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_2 | GPIO_PIN_3);
     HAL_DMA_DeInit(huart->hdmarx);
+    HAL_DMA_DeInit(huart->hdmatx);
     HAL_NVIC_DisableIRQ(USART2_IRQn);
   }
+  else if (huart->Instance == USART1)
+  {
+    __HAL_RCC_USART1_CLK_DISABLE();
+    HAL_GPIO_DeInit(GPIOA, GPIO_PIN_9 | GPIO_PIN_10);
+    HAL_DMA_DeInit(huart->hdmarx);
+  }
+  else if (huart->Instance == USART3)
+  {
+    __HAL_RCC_USART3_CLK_DISABLE();
+    HAL_GPIO_DeInit(GPIOB, GPIO_PIN_10 | GPIO_PIN_11);
+    HAL_NVIC_DisableIRQ(USART3_IRQn);
+  }
+}
+
+/**
+  * @brief CORDIC MSP Initialization
+  * This function configures the hardware resources used for CORDIC
+  * @param hcordic: CORDIC handle pointer
+  * @retval None
+  */
+void HAL_CORDIC_MspInit(CORDIC_HandleTypeDef* hcordic)
+{
+  if (hcordic->Instance == CORDIC)
+  {
+    __HAL_RCC_CORDIC_CLK_ENABLE();
+  }
+}
+
+/**
+  * @brief CORDIC MSP De-Initialization
+  * @param hcordic: CORDIC handle pointer
+  * @retval None
+  */
+void HAL_CORDIC_MspDeInit(CORDIC_HandleTypeDef* hcordic)
+{
+  if (hcordic->Instance == CORDIC)
+  {
+    __HAL_RCC_CORDIC_CLK_DISABLE();
+  }
+}
+
+/**
+  * @brief FMAC MSP Initialization
+  * This function configures the hardware resources used for FMAC
+  * @param hfmac: FMAC handle pointer
+  * @retval None
+  */
+void HAL_FMAC_MspInit(FMAC_HandleTypeDef* hfmac)
+{
+  if (hfmac->Instance == FMAC)
+  {
+    __HAL_RCC_FMAC_CLK_ENABLE();
+  }
+}
+
+/**
+  * @brief FMAC MSP De-Initialization
+  * @param hfmac: FMAC handle pointer
+  * @retval None
+  */
+void HAL_FMAC_MspDeInit(FMAC_HandleTypeDef* hfmac)
+{
+  if (hfmac->Instance == FMAC)
+  {
+    __HAL_RCC_FMAC_CLK_DISABLE();
+  }
+}
+
+/**
+  * @brief ADC MSP Initialization
+  * This function configures the hardware resources used for the ADC
+  * @param hadc: ADC handle pointer
+  * @retval None
+  */
+void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+  if (hadc->Instance == ADC1)
+  {
+    __HAL_RCC_ADC12_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    /**ADC1 GPIO Configuration
+    PA0     ------> ADC1_IN1
+    */
+    GPIO_InitStruct.Pin = GPIO_PIN_0;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /* ADC1 DMA Init: circular, read by the 1 kHz tick, no interrupt */
+    hdma_adc1.Instance = DMA1_Channel5;
+    hdma_adc1.Init.Request = DMA_REQUEST_ADC1;
+    hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_adc1.Init.Mode = DMA_CIRCULAR;
+    hdma_adc1.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_adc1) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(hadc, DMA_Handle, hdma_adc1);
+  }
+}
+
+/**
+  * @brief ADC MSP De-Initialization
+  * @param hadc: ADC handle pointer
+  * @retval None
+  */
+void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
+{
+  if (hadc->Instance == ADC1)
+  {
+    __HAL_RCC_ADC12_CLK_DISABLE();
+    HAL_GPIO_DeInit(GPIOA, GPIO_PIN_0);
+    HAL_DMA_DeInit(hadc->DMA_Handle);
+  }
+}
+
+/**
+  * @brief PCD MSP Initialization
+  * This function configures the hardware resources used for USB
+  * @param hpcd: PCD handle pointer
+  * @retval None
+  */
+void HAL_PCD_MspInit(PCD_HandleTypeDef* hpcd)
+{
+  RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
+  RCC_CRSInitTypeDef CrsInit = {0};
+  if (hpcd->Instance == USB)
+  {
+    /* 48 MHz from HSI48, trimmed to the host's 1 kHz start-of-frame by the
+     * CRS. PA11 / PA12 need no setup: the USB block takes them over.
+     */
+    PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USB;
+    PeriphClkInit.UsbClockSelection = RCC_USBCLKSOURCE_HSI48;
+    if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_RCC_CRS_CLK_ENABLE();
+    CrsInit.Prescaler = RCC_CRS_SYNC_DIV1;
+    CrsInit.Source = RCC_CRS_SYNC_SOURCE_USB;
+    CrsInit.Polarity = RCC_CRS_SYNC_POLARITY_RISING;
+    CrsInit.ReloadValue = __HAL_RCC_CRS_RELOADVALUE_CALCULATE(HSI48_VALUE, 1000U);
+    CrsInit.ErrorLimitValue = RCC_CRS_ERRORLIMIT_DEFAULT;
+    CrsInit.HSI48CalibrationValue = RCC_CRS_HSI48CALIBRATION_DEFAULT;
+    HAL_RCCEx_CRSConfig(&CrsInit);
+
+    __HAL_RCC_USB_CLK_ENABLE();
+
+    /* Above the DSP in PendSV, below the I2S DMA. */
+    HAL_NVIC_SetPriority(USB_LP_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(USB_LP_IRQn);
+  }
+}
+
+/**
+  * @brief PCD MSP De-Initialization
+  * @param hpcd: PCD handle pointer
+  * @retval None
+  */
+void HAL_PCD_MspDeInit(PCD_HandleTypeDef* hpcd)
+{
+  if (hpcd->Instance == USB)
+  {
+    __HAL_RCC_USB_CLK_DISABLE();
+    __HAL_RCC_CRS_CLK_DISABLE();
+    HAL_NVIC_DisableIRQ(USB_LP_IRQn);
+  }
 }
 
 /* USER CODE BEGIN 1 */
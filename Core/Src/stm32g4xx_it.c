@@ -22,6 +22,9 @@
 #include "stm32g4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "app_audio.h"
+#include "app_ble.h"
+#include "app_usb.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -58,8 +61,15 @@
 extern DMA_HandleTypeDef hdma_spi2_rx;
 extern DMA_HandleTypeDef hdma_spi3_tx;
 extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
 extern TIM_HandleTypeDef htim2;
 extern UART_HandleTypeDef huart2;
+#if APP_BLE_ENABLE
+extern UART_HandleTypeDef huart3;
+#endif
+#if APP_USB_ENABLE
+extern PCD_HandleTypeDef hpcd_USB_FS;
+#endif
 
 /* USER CODE BEGIN EV */
 
@@ -175,7 +185,7 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+  AppAudio_OnPendSV();
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
 
@@ -209,7 +219,12 @@ void SysTick_Handler(void)
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
-
+#if APP_AUDIO_LEAN_IRQ
+  if (AppAudio_OnTxDmaIrq())
+  {
+    return;
+  }
+#endif
   /* USER CODE END DMA1_Channel1_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi3_tx);
   /* USER CODE BEGIN DMA1_Channel1_IRQn 1 */
@@ -223,7 +238,12 @@ void DMA1_Channel1_IRQHandler(void)
 void DMA1_Channel2_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel2_IRQn 0 */
-
+#if APP_AUDIO_LEAN_IRQ
+  if (AppAudio_OnRxDmaIrq())
+  {
+    return;
+  }
+#endif
   /* USER CODE END DMA1_Channel2_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi2_rx);
   /* USER CODE BEGIN DMA1_Channel2_IRQn 1 */
@@ -245,6 +265,20 @@ void DMA1_Channel3_IRQHandler(void)
   /* USER CODE END DMA1_Channel3_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 channel4 global interrupt.
+  */
+void DMA1_Channel4_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
+
+  /* USER CODE END DMA1_Channel4_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM2 global interrupt.
   */
@@ -275,6 +309,26 @@ void USART2_IRQHandler(void)
   HAL_UART_IRQHandler(&huart2);
 }
 
+/**
+  * @brief This function handles USART3 global interrupt (the BLE module).
+  */
+void USART3_IRQHandler(void)
+{
+#if APP_BLE_ENABLE
+  HAL_UART_IRQHandler(&huart3);
+#endif
+}
+
+/**
+  * @brief This function handles USB low priority interrupt remap.
+  */
+void USB_LP_IRQHandler(void)
+{
+#if APP_USB_ENABLE
+  HAL_PCD_IRQHandler(&hpcd_USB_FS);
+#endif
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
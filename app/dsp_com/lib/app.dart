@@ -1,6 +1,8 @@
 import 'package:flutter/material.dart';
 
-import 'home/home_page.dart';
+// The web build has no dart:io (ports, files): it gets the WebSerial page.
+import 'home/app_home.dart'
+    if (dart.library.js_interop) 'web/web_home_page.dart';
 
 class DspComApp extends StatelessWidget {
   const DspComApp({super.key});
@@ -26,7 +28,7 @@ class DspComApp extends StatelessWidget {
         ),
       ),
       theme: ThemeData(useMaterial3: true),
-      home: const HomePage(),
+      home: appHome(),
     );
   }
 }
@@ -0,0 +1,217 @@
+import 'dart:io';
+
+import 'package:flutter/material.dart';
+
+import '../utils/startup_clock.dart';
+import 'link_bench.dart';
+
+/// Runs [LinkBench] on a port the app is not connected to and shows the
+/// numbers per baud rate and encoding, with how long this launch took to
+/// a usable, connected UI ([StartupClock]); Export writes them as CSV to
+/// `bench/` (one summary file, one with every PING round trip, one with
+/// the startup steps).
+class BenchPage extends StatefulWidget {
+  const BenchPage({
+    super.key,
+    required this.portName,
+    required this.baudRate,
+    required this.baudRates,
+  });
+
+  final String portName;
+
+  /// The rate the pedal is at now; the benchmark starts and ends there.
+  final int baudRate;
+  final List<int> baudRates;
+
+  @override
+  State<BenchPage> createState() => _BenchPageState();
+}
+
+class _BenchPageState extends State<BenchPage> {
+  static const int _kLogLines = 8;
+
+  late final Set<int> _bauds = widget.baudRates
+      .where((b) => b >= widget.baudRate)
+      .toSet();
+  LinkBench? _bench;
+  List<BenchResult> _results = const [];
+  final List<String> _log = <String>[];
+
+  bool get _running => _bench != null;
+
+  void _progress(String message) {
+    if (!mounted) return;
+    setState(() {
+      _log.add(message);
+      if (_log.length > _kLogLines) _log.removeAt(0);
+    });
+  }
+
+  Future<void> _run() async {
+    final bench = LinkBench(
+      portName: widget.portName,
+      baudRate: widget.baudRate,
+      onProgress: _progress,
+    );
+    setState(() {
+      _bench = bench;
+      _results = const [];
+      _log.clear();
+    });
+    try {
+      final bauds = widget.baudRates.where(_bauds.contains).toList();
+      final results = await bench.run(bauds);
+      if (!mounted) return;
+      setState(() => _results = results);
+      _progress('Done');
+    } catch (e) {
+      _progress('Failed: $e');
+    } finally {
+      if (mounted) setState(() => _bench = null);
+    }
+  }
+
+  Future<void> _export() async {
+    final sep = Platform.pathSeparator;
+    final dir = Directory('${Directory.current.path}${sep}bench');
+    final ts = DateTime.now()
+        .toIso8601String()
+        .split('.')
+        .first
+        .replaceAll(':', '-');
+    final summary = StringBuffer('${BenchResult.csvHeader}\n');
+    final samples = StringBuffer('${BenchSample.csvHeader}\n');
+    final startup = StringBuffer('step,ms\n');
+    for (final MapEntry(:key, :value) in StartupClock.marks.entries) {
+      startup.writeln('$key,${value.inMilliseconds}');
+    }
+    for (final r in _results) {
+      summary.writeln(r.toCsv());
+      for (var i = 0; i < r.samples.length; i++) {
+        final s = r.samples[i];
+        samples.writeln(
+          '${r.baud},${r.encoding.name},$i,${s.rttUs},'
+          '${s.deviceMs},${s.deviceCyc}',
+        );
+      }
+    }
+    try {
+      await dir.create(recursive: true);
+      final path = '${dir.path}${sep}bench-$ts';
+      await File('$path.csv').writeAsString(summary.toString());
+      await File('$path-samples.csv').writeAsString(samples.toString());
+      await File('$path-startup.csv').writeAsString(startup.toString());
+      _progress('Exported $path.csv');
+    } on FileSystemException catch (e) {
+      _progress('Export failed: ${e.message}');
+    }
+  }
+
+  @override
+  void dispose() {
+    _bench?.cancel();
+    super.dispose();
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    String ms(int us) => (us / 1000).toStringAsFixed(2);
+    final startup = [
+      for (final MapEntry(:key, :value) in StartupClock.marks.entries)
+        '$key ${value.inMilliseconds} ms',
+    ].join(', ');
+    return Scaffold(
+      appBar: AppBar(
+        toolbarHeight: 48,
+        title: Text('Link benchmark: ${widget.portName}'),
+      ),
+      body: SingleChildScrollView(
+        padding: const EdgeInsets.all(16),
+        child: Column(
+          crossAxisAlignment: CrossAxisAlignment.start,
+          children: [
+            Wrap(
+              spacing: 8,
+              runSpacing: 4,
+              children: [
+                for (final b in widget.baudRates)
+                  FilterChip(
+                    label: Text('$b'),
+                    selected: _bauds.contains(b),
+                    onSelected: _running
+                        ? null
+                        : (on) => setState(() {
+                            if (on) {
+                              _bauds.add(b);
+                            } else {
+                              _bauds.remove(b);
+                            }
+                          }),
+                  ),
+              ],
+            ),
+            const SizedBox(height: 12),
+            Row(
+              children: [
+                FilledButton(
+                  onPressed: _running
+                      ? () => _bench?.cancel()
+                      : _bauds.isEmpty
+                      ? null
+                      : _run,
+                  child: Text(_running ? 'Stop' : 'Run'),
+                ),
+                const SizedBox(width: 12),
+                OutlinedButton(
+                  onPressed: _running || _results.isEmpty ? null : _export,
+                  child: const Text('Export CSV'),
+                ),
+              ],
+            ),
+            const SizedBox(height: 12),
+            Text('Startup: $startup'),
+            const SizedBox(height: 12),
+            for (final line in _log) Text(line),
+            const SizedBox(height: 12),
+            if (_results.isNotEmpty)
+              SingleChildScrollView(
+                scrollDirection: Axis.horizontal,
+                child: DataTable(
+                  columns: const [
+                    DataColumn(label: Text('Baud')),
+                    DataColumn(label: Text('Encoding')),
+                    DataColumn(label: Text('RTT p50 ms')),
+                    DataColumn(label: Text('RTT p95 ms')),
+                    DataColumn(label: Text('RTT max ms')),
+                    DataColumn(label: Text('Lost')),
+                    DataColumn(label: Text('Cmd/s')),
+                    DataColumn(label: Text('Cmd/s (pedal)')),
+                    DataColumn(label: Text('PSET/s')),
+                  ],
+                  rows: [
+                    for (final r in _results)
+                      DataRow(
+                        cells: [
+                          DataCell(Text('${r.baud}')),
+                          DataCell(Text(r.encoding.name)),
+                          DataCell(Text(ms(r.rtt.quantile(0.5)))),
+                          DataCell(Text(ms(r.rtt.quantile(0.95)))),
+                          DataCell(Text(ms(r.rtt.quantile(1)))),
+                          DataCell(Text('${r.rtt.lost}')),
+                          DataCell(Text(r.cmdsPerSec.toStringAsFixed(0))),
+                          DataCell(
+                            Text(r.deviceCmdsPerSec.toStringAsFixed(0)),
+                          ),
+                          DataCell(Text('${r.psetMaxPerSec}')),
+                        ],
+                      ),
+                  ],
+                ),
+              ),
+          ],
+        ),
+      ),
+    );
+  }
+}
@@ -0,0 +1,410 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import '../serial/device_caps.dart';
+import '../serial/param_desc.dart';
+import '../serial/serial_link.dart';
+import '../serial/session_log.dart';
+
+/// How the benchmark's commands are encoded: ASCII lines or binary frames
+/// (app_com.c), both over whichever port was picked (UART or USB).
+enum BenchEncoding { ascii, binary }
+
+/// The numbers for one baud rate and encoding.
+class BenchResult {
+  BenchResult(this.port, this.baud, this.encoding);
+
+  final String port;
+  final int baud;
+  final BenchEncoding encoding;
+
+  /// Round trips of single PINGs, one at a time.
+  final RttStats rtt = RttStats();
+  final List<BenchSample> samples = <BenchSample>[];
+
+  /// Timestamped PINGs answered per second with a window in flight, as the
+  /// app sees them and as the pedal's clock spaced its replies.
+  double cmdsPerSec = 0;
+  double deviceCmdsPerSec = 0;
+
+  /// Highest PSET rate tried that was acked in full with a p95 under
+  /// [LinkBench.psetP95Us]; 0 if none held.
+  int psetMaxPerSec = 0;
+
+  static const String csvHeader =
+      'port,baud,encoding,rtt_n,rtt_min_ms,rtt_p50_ms,rtt_p95_ms,'
+      'rtt_max_ms,lost,cmds_per_s,device_cmds_per_s,pset_max_per_s';
+
+  String toCsv() {
+    String ms(int us) => (us / 1000).toStringAsFixed(3);
+    return '$port,$baud,${encoding.name},${rtt.count},'
+        '${ms(rtt.quantile(0))},${ms(rtt.quantile(0.5))},'
+        '${ms(rtt.quantile(0.95))},${ms(rtt.quantile(1))},${rtt.lost},'
+        '${cmdsPerSec.toStringAsFixed(1)},'
+        '${deviceCmdsPerSec.toStringAsFixed(1)},$psetMaxPerSec';
+  }
+}
+
+/// One PING round trip and the pedal's time as it answered.
+class BenchSample {
+  const BenchSample(this.rttUs, this.deviceMs, this.deviceCyc);
+
+  final int rttUs;
+  final int deviceMs;
+  final int deviceCyc;
+
+  static const String csvHeader =
+      'baud,encoding,i,rtt_us,device_ms,device_cyc';
+}
+
+/// Link benchmark: opens the port on its own (the app is disconnected),
+/// walks the baud rates with BAUD, and at each measures with both
+/// encodings:
+///   - the round trip of [_kRttCount] timestamped PINGs (`PING <seq>`, or
+///     a PING frame with a seq), one at a time;
+///   - [_kThroughputCount] of them with [_kWindow] in flight;
+///   - PSETs of [_kPsetParam] (its current value, so nothing is heard) at
+///     rising rates for [_kPsetStep] each, until one does not hold.
+/// It ends back at the rate it started at. Needs CAPS feat pingts.
+class LinkBench {
+  LinkBench({
+    required this.portName,
+    required this.baudRate,
+    this.onProgress,
+  });
+
+  static const int _kRttCount = 100;
+  static const int _kThroughputCount = 400;
+  static const int _kWindow = 8;
+  static const Duration _kTimeout = Duration(milliseconds: 500);
+  static const List<int> _kPsetRates = <int>[50, 100, 200, 400, 800, 1600];
+  static const Duration _kPsetStep = Duration(seconds: 1);
+  static const String _kPsetParam = 'gain_q15';
+  static const int psetP95Us = 50000;
+
+  // Binary commands (app_com.c); replies are cmd | 0x80.
+  static const int _kBinPing = 0x01;
+  static const int _kBinPset = 0x02;
+  static const int _kBinReply = 0x80;
+
+  // The firmware goes back to the old rate when a BAUD switch is not
+  // confirmed within APP_COM_BAUD_CONFIRM_MS.
+  static const Duration _kBaudRevert = Duration(milliseconds: 3200);
+
+  static final RegExp _pongLine = RegExp(r'^PONG (\d+) ms=(\d+) cyc=(\d+)');
+  static final RegExp _plistDone = RegExp(r'next=(\d+) count=(\d+)');
+
+  final String portName;
+  final int baudRate;
+  final void Function(String message)? onProgress;
+
+  final SerialLink _link = SerialLink();
+  final Stopwatch _clock = Stopwatch()..start();
+  void Function(LinkEvent event, int tUs)? _tap;
+  int _baud = 0;
+  int _seq = 0;
+  bool _cancelled = false;
+
+  /// Stops after the step under way; [run] still restores the rate.
+  void cancel() => _cancelled = true;
+
+  Future<List<BenchResult>> run(List<int> bauds) async {
+    final results = <BenchResult>[];
+    await _open(baudRate);
+    try {
+      if (!await _ping()) {
+        throw StateError('No PONG on $portName at $baudRate');
+      }
+      final capsLine = await _request(
+        () => _link.sendLine('CAPS'),
+        (e) => e is LineEvent && e.line.startsWith('CAPS '),
+      );
+      final caps = capsLine is LineEvent
+          ? DeviceCaps.tryParse(capsLine.line)
+          : null;
+      if (caps == null || !caps.has('pingts')) {
+        throw StateError('This firmware has no timestamped PING');
+      }
+      final param = await _findParam(_kPsetParam);
+      if (param == null) throw StateError('No $_kPsetParam in PLIST');
+      final value = await _readParam(_kPsetParam) ?? param.def;
+      // Nothing but the replies measured.
+      _link.sendLine('QUIET OFF');
+      _link.sendLine('EVT OFF');
+
+      for (final baud in bauds) {
+        if (_cancelled) break;
+        if (caps.maxBaud > 0 && baud > caps.maxBaud) continue;
+        if (!await _switchBaud(baud)) {
+          onProgress?.call('$baud: not confirmed, skipped');
+          continue;
+        }
+        for (final enc in BenchEncoding.values) {
+          if (_cancelled) break;
+          final r = BenchResult(portName, baud, enc);
+          onProgress?.call('$baud ${enc.name}: round trips');
+          await _measureRtt(r);
+          onProgress?.call('$baud ${enc.name}: throughput');
+          await _measureThroughput(r);
+          onProgress?.call('$baud ${enc.name}: PSET rate');
+          await _measurePset(r, param, value);
+          results.add(r);
+        }
+      }
+      await _switchBaud(baudRate);
+    } finally {
+      _link.close();
+      await _link.closed;
+    }
+    return results;
+  }
+
+  Future<void> _open(int baud) async {
+    await _link.open(
+      portName: portName,
+      baudRate: baud,
+      onEvent: (e) => _tap?.call(e, _clock.elapsedMicroseconds),
+    );
+    _baud = baud;
+  }
+
+  // Sends with [send] and waits for the first event [match] takes, or
+  // null after [timeout]. The benchmark runs one step at a time, so one
+  // listener is enough.
+  Future<LinkEvent?> _request(
+    void Function() send,
+    bool Function(LinkEvent e) match, [
+    Duration timeout = _kTimeout,
+  ]) {
+    final done = Completer<LinkEvent?>();
+    final timer = Timer(timeout, () {
+      if (!done.isCompleted) done.complete(null);
+    });
+    _tap = (e, _) {
+      if (!done.isCompleted && match(e)) {
+        timer.cancel();
+        done.complete(e);
+      }
+    };
+    send();
+    return done.future.whenComplete(() => _tap = null);
+  }
+
+  Future<bool> _ping() async {
+    final e = await _request(
+      () => _link.sendLine('PING'),
+      (e) => e is LineEvent && e.line.startsWith('PONG'),
+    );
+    return e != null;
+  }
+
+  Future<ParamDesc?> _findParam(String name) async {
+    ParamDesc? found;
+    var next = 0;
+    while (found == null) {
+      final done = await _request(() => _link.sendLine('PLIST $next'), (e) {
+        if (e is ParamEvent && e.desc.name == name) found = e.desc;
+        return e is LineEvent && e.line.startsWith('OK PLIST');
+      });
+      final m = done is LineEvent ? _plistDone.firstMatch(done.line) : null;
+      if (m == null) break;
+      next = int.parse(m.group(1)!);
+      if (next >= int.parse(m.group(2)!)) break;
+    }
+    return found;
+  }
+
+  Future<int?> _readParam(String name) async {
+    final e = await _request(
+      () => _link.sendLine('STATUS'),
+      (e) => e is StatusEvent && e is! ChangeEvent,
+    );
+    return e is StatusEvent ? e.values[name] : null;
+  }
+
+  // BAUD <rate>, then the port reopened at it and a PING to confirm. Not
+  // confirmed, the pedal is waited for at the old rate again.
+  Future<bool> _switchBaud(int baud) async {
+    if (baud == _baud) return true;
+    final ok = await _request(
+      () => _link.sendLine('BAUD $baud'),
+      (e) =>
+          e is LineEvent &&
+          (e.line == 'OK BAUD $baud' || e.line.startsWith('ERR')),
+    );
+    if (ok is! LineEvent || !ok.line.startsWith('OK')) return false;
+    final old = _baud;
+    // The UART switches once the reply has left.
+    await Future<void>.delayed(const Duration(milliseconds: 50));
+    await _open(baud);
+    for (var i = 0; i < 5; i++) {
+      if (await _ping()) return true;
+    }
+    await _open(old);
+    await Future<void>.delayed(_kBaudRevert);
+    if (!await _ping()) {
+      throw StateError('Lost the pedal switching to $baud');
+    }
+    return false;
+  }
+
+  void _sendPing(BenchEncoding enc, int seq) {
+    if (enc == BenchEncoding.ascii) {
+      _link.sendLine('PING $seq');
+    } else {
+      _link.sendFrame(
+        _kBinPing,
+        (ByteData(4)..setUint32(0, seq, Endian.little)).buffer.asUint8List(),
+      );
+    }
+  }
+
+  // (seq, pedal ms, pedal cycles) of a timestamped PONG, else null.
+  static (int, int, int)? _pong(LinkEvent e) {
+    if (e is FrameEvent) {
+      final p = e.payload;
+      if (e.cmd != (_kBinPing | _kBinReply) || p.length < 13 || p[0] != 0) {
+        return null;
+      }
+      final b = ByteData.sublistView(p);
+      return (
+        b.getUint32(1, Endian.little),
+        b.getUint32(5, Endian.little),
+        b.getUint32(9, Endian.little),
+      );
+    }
+    if (e is LineEvent) {
+      final m = _pongLine.firstMatch(e.line);
+      if (m == null) return null;
+      return (
+        int.parse(m.group(1)!),
+        int.parse(m.group(2)!),
+        int.parse(m.group(3)!),
+      );
+    }
+    return null;
+  }
+
+  Future<void> _measureRtt(BenchResult r) async {
+    for (var i = 0; i < _kRttCount && !_cancelled; i++) {
+      final seq = ++_seq;
+      final t0 = _clock.elapsedMicroseconds;
+      final e = await _request(
+        () => _sendPing(r.encoding, seq),
+        (e) => _pong(e)?.$1 == seq,
+      );
+      final p = e == null ? null : _pong(e);
+      if (p == null) {
+        r.rtt.lost++;
+        continue;
+      }
+      final us = _clock.elapsedMicroseconds - t0;
+      r.rtt.add(us);
+      r.samples.add(BenchSample(us, p.$2, p.$3));
+    }
+  }
+
+  Future<void> _measureThroughput(BenchResult r) async {
+    final done = Completer<void>();
+    var sent = 0;
+    var got = 0;
+    int? firstMs;
+    var lastMs = 0;
+    void fill() {
+      while (sent < _kThroughputCount && sent - got < _kWindow) {
+        _sendPing(r.encoding, ++_seq);
+        sent++;
+      }
+    }
+
+    _tap = (e, _) {
+      final p = _pong(e);
+      if (p == null) return;
+      got++;
+      firstMs ??= p.$2;
+      lastMs = p.$2;
+      if (got >= _kThroughputCount) {
+        if (!done.isCompleted) done.complete();
+      } else {
+        fill();
+      }
+    };
+    final t0 = _clock.elapsedMicroseconds;
+    fill();
+    // A lost reply stalls the window: what came by then counts.
+    await done.future.timeout(const Duration(seconds: 10), onTimeout: () {});
+    final us = _clock.elapsedMicroseconds - t0;
+    _tap = null;
+    r.cmdsPerSec = got * 1e6 / us;
+    final first = firstMs;
+    if (got > 1 && first != null && lastMs > first) {
+      r.deviceCmdsPerSec = (got - 1) * 1000 / (lastMs - first);
+    }
+  }
+
+  Future<void> _measurePset(BenchResult r, ParamDesc param, int value) async {
+    for (final rate in _kPsetRates) {
+      if (_cancelled || !await _psetStep(r.encoding, param, value, rate)) {
+        return;
+      }
+      r.psetMaxPerSec = rate;
+    }
+  }
+
+  // [rate] PSETs a second for [_kPsetStep]; true if every one was acked
+  // OK with a p95 round trip under [psetP95Us].
+  Future<bool> _psetStep(
+    BenchEncoding enc,
+    ParamDesc param,
+    int value,
+    int rate,
+  ) async {
+    final stats = RttStats();
+    final tags = <int, int>{};
+    final frames = <int>[];
+    var failed = false;
+    _tap = (e, t) {
+      if (e is LineEvent && e.seq != null) {
+        final sent = tags.remove(e.seq);
+        if (sent == null) return;
+        if (!e.line.startsWith('OK')) failed = true;
+        stats.add(t - sent);
+      } else if (e is FrameEvent &&
+          e.cmd == (_kBinPset | _kBinReply) &&
+          frames.isNotEmpty) {
+        if (e.payload.isEmpty || e.payload[0] != 0) failed = true;
+        stats.add(t - frames.removeAt(0));
+      }
+    };
+
+    final payload = <int>[param.id, ...LinkFrame.varint(value)];
+    final total = rate * _kPsetStep.inMilliseconds ~/ 1000;
+    final start = _clock.elapsedMicroseconds;
+    var sent = 0;
+    while (sent < total && !_cancelled) {
+      final due = (_clock.elapsedMicroseconds - start) * rate ~/ 1000000 + 1;
+      while (sent < due && sent < total) {
+        final t = _clock.elapsedMicroseconds;
+        if (enc == BenchEncoding.ascii) {
+          final seq = ++_seq;
+          tags[seq] = t;
+          _link.sendLine('#$seq PSET ${param.name} $value');
+        } else {
+          frames.add(t);
+          _link.sendFrame(_kBinPset, payload);
+        }
+        sent++;
+      }
+      await Future<void>.delayed(const Duration(milliseconds: 5));
+    }
+    final end = _clock.elapsedMicroseconds + _kTimeout.inMicroseconds;
+    while ((tags.isNotEmpty || frames.isNotEmpty) &&
+        _clock.elapsedMicroseconds < end) {
+      await Future<void>.delayed(const Duration(milliseconds: 5));
+    }
+    _tap = null;
+    stats.lost = tags.length + frames.length;
+    onProgress?.call('  PSET $rate/s ${enc.name}: $stats');
+    return !failed && stats.lost == 0 && stats.quantile(0.95) <= psetP95Us;
+  }
+}
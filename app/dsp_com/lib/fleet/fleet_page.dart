@@ -0,0 +1,239 @@
+import 'dart:io';
+
+import 'package:flutter/material.dart';
+// ignore: depend_on_referenced_packages
+import 'package:libserialport/libserialport.dart';
+
+import '../presets/preset_library.dart';
+import '../presets/preset_record.dart';
+import '../serial/port_probe.dart';
+import 'fleet_pedal.dart';
+import 'telemetry_page.dart';
+import 'telemetry_store.dart';
+
+/// Many pedals at once: Scan probes every port ([PortProbe.findAll]) and
+/// connects to each pedal found on its own link, one reader isolate each.
+/// The table shows each pedal's DSP load, underruns and clock drift as they
+/// stream in. Push setlist writes the library's setlist into every bank,
+/// and Update firmware runs the host updater on every pedal, all of them
+/// in parallel. Every load sample is kept in [TelemetryStore]; the chart
+/// button opens its query view.
+///
+/// The firmware image is `firmware/dsp.bin` next to the working directory
+/// and the updater `fw_update` (tools/dsp_host) there or on the PATH; the
+/// updater needs termios, so the button is for Linux and macOS.
+class FleetPage extends StatefulWidget {
+  const FleetPage({super.key, required this.bauds, this.library});
+
+  /// Rates to probe each port at, in this order.
+  final List<int> bauds;
+  final PresetLibrary? library;
+
+  @override
+  State<FleetPage> createState() => _FleetPageState();
+}
+
+class _FleetPageState extends State<FleetPage> {
+  final List<FleetPedal> _pedals = <FleetPedal>[];
+  final TelemetryStore _store = TelemetryStore();
+  bool _busy = false;
+  String _status = '';
+
+  @override
+  void dispose() {
+    for (final p in _pedals) {
+      p.close();
+      p.telemetry?.close();
+    }
+    super.dispose();
+  }
+
+  void _changed() {
+    if (mounted) setState(() {});
+  }
+
+  Future<void> _scan() async {
+    setState(() {
+      _busy = true;
+      _status = 'Scanning...';
+    });
+    await Future.wait([for (final p in _pedals) p.close()]);
+    for (final p in _pedals) {
+      p.telemetry?.close();
+    }
+    _pedals.clear();
+    final sw = Stopwatch()..start();
+    final ports = SerialPort.availablePorts;
+    final hits = await PortProbe.findAll(ports, widget.bauds);
+    final pedals = [
+      for (final h in hits)
+        FleetPedal(
+          h,
+          onChanged: _changed,
+          telemetry: _store.writer(PortProbe.serialOf(h.port) ?? h.port),
+        ),
+    ];
+    _pedals.addAll(pedals);
+    await _each(pedals, (p) => p.connect());
+    if (!mounted) return;
+    setState(() {
+      _busy = false;
+      _status = '${pedals.length} pedals in ${sw.elapsedMilliseconds} ms';
+    });
+  }
+
+  // Runs [action] on every pedal at once; a failure is that pedal's
+  // status, not the others'.
+  Future<void> _each(
+    List<FleetPedal> pedals,
+    Future<void> Function(FleetPedal p) action,
+  ) => Future.wait([
+    for (final p in pedals)
+      action(p).catchError((Object e) {
+        p.status = '$e';
+        _changed();
+      }),
+  ]);
+
+  Future<void> _pushSetlist() async {
+    final lib = widget.library;
+    if (lib == null) return;
+    setState(() => _busy = true);
+    final slots = <int, PresetFile>{};
+    final setlist = lib.bank;
+    for (var slot = 0; slot < setlist.length; slot++) {
+      final id = setlist[slot];
+      final file = id == null ? null : await lib.loadFile(id);
+      if (file != null) slots[slot] = file;
+    }
+    final sw = Stopwatch()..start();
+    await _each(_pedals, (p) => p.pushBank(slots));
+    if (!mounted) return;
+    setState(() {
+      _busy = false;
+      _status =
+          'Setlist (${slots.length} presets) pushed to ${_pedals.length} '
+          'pedals in ${sw.elapsedMilliseconds} ms';
+    });
+  }
+
+  Future<void> _updateFirmware() async {
+    final sep = Platform.pathSeparator;
+    final dir = Directory.current.path;
+    final image = '$dir${sep}firmware${sep}dsp.bin';
+    final local = '$dir${sep}fw_update';
+    final tool = File(local).existsSync() ? local : 'fw_update';
+    if (!File(image).existsSync()) {
+      setState(() => _status = 'No firmware image at $image');
+      return;
+    }
+    setState(() => _busy = true);
+    final sw = Stopwatch()..start();
+    await _each(_pedals, (p) => p.updateFirmware(tool, image));
+    if (!mounted) return;
+    setState(() {
+      _busy = false;
+      _status =
+          'Firmware update on ${_pedals.length} pedals took '
+          '${(sw.elapsedMilliseconds / 1000).toStringAsFixed(1)} s';
+    });
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    String num(double? v, [int digits = 1]) =>
+        v == null ? '-' : v.toStringAsFixed(digits);
+    final some = _pedals.isNotEmpty && !_busy;
+    return Scaffold(
+      appBar: AppBar(
+        toolbarHeight: 48,
+        title: const Text('Fleet'),
+        actions: [
+          IconButton(
+            tooltip: 'Telemetry',
+            icon: const Icon(Icons.query_stats),
+            onPressed: () => Navigator.of(context).push(
+              MaterialPageRoute<void>(
+                builder: (_) =>
+                    TelemetryPage(store: _store, library: widget.library),
+              ),
+            ),
+          ),
+        ],
+      ),
+      body: SingleChildScrollView(
+        padding: const EdgeInsets.all(16),
+        child: Column(
+          crossAxisAlignment: CrossAxisAlignment.start,
+          children: [
+            Wrap(
+              spacing: 12,
+              runSpacing: 8,
+              children: [
+                FilledButton(
+                  onPressed: _busy ? null : _scan,
+                  child: const Text('Scan'),
+                ),
+                OutlinedButton(
+                  onPressed: some && widget.library != null
+                      ? _pushSetlist
+                      : null,
+                  child: const Text('Push setlist'),
+                ),
+                OutlinedButton(
+                  onPressed: some && (Platform.isLinux || Platform.isMacOS)
+                      ? _updateFirmware
+                      : null,
+                  child: const Text('Update firmware'),
+                ),
+              ],
+            ),
+            const SizedBox(height: 8),
+            if (_status.isNotEmpty) Text(_status),
+            const SizedBox(height: 12),
+            SingleChildScrollView(
+              scrollDirection: Axis.horizontal,
+              child: DataTable(
+                columns: const [
+                  DataColumn(label: Text('Port')),
+                  DataColumn(label: Text('Firmware')),
+                  DataColumn(label: Text('Load %')),
+                  DataColumn(label: Text('Max %')),
+                  DataColumn(label: Text('Underruns')),
+                  DataColumn(label: Text('Missed')),
+                  DataColumn(label: Text('Drift ppm')),
+                  DataColumn(label: Text('Locked')),
+                  DataColumn(label: Text('Status')),
+                ],
+                rows: [
+                  for (final p in _pedals)
+                    DataRow(
+                      cells: [
+                        DataCell(Text(p.port)),
+                        DataCell(Text(p.caps?.firmware ?? '-')),
+                        DataCell(Text(num(p.loadPct))),
+                        DataCell(Text(num(p.loadMaxPct))),
+                        DataCell(Text('${p.underruns ?? '-'}')),
+                        DataCell(Text('${p.missed ?? '-'}')),
+                        DataCell(Text(num(p.driftPpm))),
+                        DataCell(
+                          Text(
+                            switch (p.clockLocked) {
+                              null => '-',
+                              true => 'yes',
+                              false => 'no',
+                            },
+                          ),
+                        ),
+                        DataCell(Text(p.status)),
+                      ],
+                    ),
+                ],
+              ),
+            ),
+          ],
+        ),
+      ),
+    );
+  }
+}
@@ -0,0 +1,215 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import '../presets/preset_record.dart';
+import '../serial/device_caps.dart';
+import '../serial/param_desc.dart';
+import '../serial/port_probe.dart';
+import '../serial/preset_bank.dart';
+import '../serial/serial_link.dart';
+import 'telemetry_store.dart';
+
+/// One pedal of the fleet page: its own [SerialLink] (its own reader
+/// isolate, through libserialport on every platform) and what the page
+/// shows of it. On connect it reads CAPS, PBANK and PLIST and subscribes
+/// to the load and clock topics ([_kTelemetryHz]); a PUB sample updates
+/// the fields and calls [onChanged], and each load sample goes to
+/// [telemetry].
+class FleetPedal {
+  FleetPedal(this.probe, {required this.onChanged, this.telemetry});
+
+  final ProbeHit probe;
+  final void Function() onChanged;
+  final TelemetryWriter? telemetry;
+
+  static const int _kTelemetryHz = 2;
+  static const Duration _kTimeout = Duration(milliseconds: 500);
+  static final RegExp _plistDone = RegExp(r'next=(\d+) count=(\d+)');
+
+  final SerialLink _link = SerialLink();
+  late final PresetBankTransfer _bank = PresetBankTransfer(_link.sendFrame);
+  final Map<int, ParamDesc> _descs = {};
+  void Function(LineEvent line)? _waiter;
+
+  String get port => probe.port;
+  DeviceCaps? get caps => probe.caps;
+  bool get isOpen => _link.isOpen;
+
+  /// From PBANK, null for firmware without preset files.
+  PresetBankLayout? bank;
+
+  /// What it is doing or what went wrong last.
+  String status = '';
+
+  // PUB load: % of the block period; blocks missed and underruns since
+  // boot; the preset slot in use. PUB clock: the I2S clock against the
+  // host's, ppm.
+  double? loadPct;
+  double? loadMaxPct;
+  int? underruns;
+  int? missed;
+  double? driftPpm;
+  bool? clockLocked;
+  int? preset;
+
+  Future<void> connect() async {
+    _setStatus('connecting');
+    await _link.open(
+      portName: port,
+      baudRate: probe.baudRate,
+      native: false,
+      onEvent: _onEvent,
+    );
+    final bankLine = await _ask('PBANK', 'PBANK ');
+    bank = bankLine == null ? null : PresetBankLayout.tryParse(bankLine);
+    await _readParams();
+    if (caps?.has('sub') ?? false) {
+      _link.sendLine('SUB load $_kTelemetryHz');
+      _link.sendLine('SUB clock $_kTelemetryHz');
+    }
+    _setStatus('ready');
+  }
+
+  Future<void> close() async {
+    _link.close();
+    await _link.closed;
+  }
+
+  /// Writes [slots] (bank slot -> preset) into the pedal bank; slots past
+  /// the end of this pedal's bank are left out.
+  Future<void> pushBank(Map<int, PresetFile> slots) async {
+    final layout = bank;
+    if (layout == null) throw StateError('no preset bank');
+    _setStatus('pushing presets');
+    final sw = Stopwatch()..start();
+    final fits = {
+      for (final e in slots.entries)
+        if (e.key < layout.slots) e.key: e.value,
+    };
+    await _bank.upload(layout, _descs, fits);
+    final after = await _ask('PBANK', 'PBANK ');
+    if (after != null) bank = PresetBankLayout.tryParse(after) ?? bank;
+    _setStatus(
+      'pushed ${fits.length} presets in ${sw.elapsedMilliseconds} ms',
+    );
+  }
+
+  /// Runs the host updater ([tool], tools/dsp_host/fw_update.c) on this
+  /// pedal's port with [image], the link closed meanwhile; the pedal
+  /// reboots into it and is connected again.
+  Future<void> updateFirmware(String tool, String image) async {
+    await close();
+    _setStatus('updating firmware');
+    final proc = await Process.start(tool, [
+      '-d',
+      port,
+      '-r',
+      '${probe.baudRate}',
+      image,
+    ]);
+    // Its progress and errors are lines on stderr; the last one shows.
+    final out = proc.stdout.drain<void>();
+    await proc.stderr
+        .transform(utf8.decoder)
+        .transform(const LineSplitter())
+        .forEach((line) => _setStatus(line.trim()));
+    await out;
+    final code = await proc.exitCode;
+    if (code != 0) throw StateError('fw_update exited with $code: $status');
+    // The reset and the boot before the pedal answers again.
+    await Future<void>.delayed(const Duration(seconds: 2));
+    await connect();
+  }
+
+  void _setStatus(String s) {
+    status = s;
+    onChanged();
+  }
+
+  void _onEvent(LinkEvent e) {
+    switch (e) {
+      case FrameEvent():
+        _bank.onFrame(e);
+      case LineEvent(:final line):
+        if (line.startsWith('PUB ')) {
+          _onPub(line);
+        } else {
+          _waiter?.call(e);
+        }
+      case LinkErrorEvent(:final message):
+        _setStatus('link error: $message');
+      case MeterEvent():
+        break;
+    }
+  }
+
+  void _onPub(String line) {
+    final kv = <String, double>{};
+    for (final p in line.split(' ').skip(2)) {
+      final eq = p.indexOf('=');
+      final v = eq > 0 ? double.tryParse(p.substring(eq + 1)) : null;
+      if (v != null) kv[p.substring(0, eq)] = v;
+    }
+    if (line.startsWith('PUB load ')) {
+      loadPct = kv['rx'];
+      loadMaxPct = kv['rx_max'];
+      underruns = kv['under']?.toInt();
+      missed = kv['miss']?.toInt();
+      preset = kv['preset']?.toInt();
+      final load = loadPct;
+      final loadMax = loadMaxPct;
+      final miss = missed;
+      final under = underruns;
+      if (load != null && loadMax != null && miss != null && under != null) {
+        // Firmware from before preset= counts as slot 0.
+        telemetry?.sample(
+          load: load,
+          loadMax: loadMax,
+          missed: miss,
+          underruns: under,
+          driftPpm: driftPpm ?? 0,
+          preset: preset ?? 0,
+        );
+      }
+    } else if (line.startsWith('PUB clock ')) {
+      driftPpm = kv['ppm'];
+      clockLocked = kv['locked'] == null ? null : kv['locked'] != 0;
+    }
+    onChanged();
+  }
+
+  // Sends [cmd] and returns the first reply line starting with [prefix]
+  // (null after a timeout); [each] sees every line until then.
+  Future<String?> _ask(
+    String cmd,
+    String prefix, [
+    void Function(LineEvent line)? each,
+  ]) {
+    final done = Completer<String?>();
+    _waiter = (e) {
+      each?.call(e);
+      if (!done.isCompleted && e.line.startsWith(prefix)) {
+        done.complete(e.line);
+      }
+    };
+    _link.sendLine(cmd);
+    return done.future
+        .timeout(_kTimeout, onTimeout: () => null)
+        .whenComplete(() => _waiter = null);
+  }
+
+  Future<void> _readParams() async {
+    _descs.clear();
+    var next = 0;
+    while (true) {
+      final done = await _ask('PLIST $next', 'OK PLIST', (e) {
+        if (e is ParamEvent) _descs[e.desc.id] = e.desc;
+      });
+      final m = done == null ? null : _plistDone.firstMatch(done);
+      if (m == null) return;
+      next = int.parse(m.group(1)!);
+      if (next >= int.parse(m.group(2)!)) return;
+    }
+  }
+}
@@ -0,0 +1,137 @@
+import 'package:flutter/material.dart';
+
+import '../presets/preset_library.dart';
+import 'telemetry_store.dart';
+
+/// Which pedals overran during which presets: the fleet telemetry
+/// ([TelemetryStore]) over the last hour, day, week or month, one row per
+/// pedal and preset slot, most deadline misses and underruns first.
+class TelemetryPage extends StatefulWidget {
+  const TelemetryPage({super.key, required this.store, this.library});
+
+  final TelemetryStore store;
+
+  /// Names the slots after the setlist when there is one.
+  final PresetLibrary? library;
+
+  @override
+  State<TelemetryPage> createState() => _TelemetryPageState();
+}
+
+class _TelemetryPageState extends State<TelemetryPage> {
+  static const List<(String, Duration)> _ranges = [
+    ('1 h', Duration(hours: 1)),
+    ('24 h', Duration(days: 1)),
+    ('7 d', Duration(days: 7)),
+    ('30 d', Duration(days: 30)),
+  ];
+
+  Duration _range = const Duration(days: 1);
+  bool _onlyOverruns = true;
+  List<PresetOverrun>? _rows;
+
+  @override
+  void initState() {
+    super.initState();
+    _query();
+  }
+
+  Future<void> _query() async {
+    setState(() => _rows = null);
+    final rows = await widget.store.overruns(_range);
+    if (!mounted) return;
+    setState(() => _rows = rows);
+  }
+
+  String _presetName(int slot) {
+    final lib = widget.library;
+    final bank = lib?.bank ?? const <String?>[];
+    final id = slot < bank.length ? bank[slot] : null;
+    for (final e in lib?.entries ?? const <PresetEntry>[]) {
+      if (e.id == id) return '$slot ${e.name}';
+    }
+    return '$slot';
+  }
+
+  static String _duration(int ms) {
+    final d = Duration(milliseconds: ms);
+    if (d.inHours > 0) return '${d.inHours} h ${d.inMinutes % 60} min';
+    if (d.inMinutes > 0) return '${d.inMinutes} min';
+    return '${d.inSeconds} s';
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final rows = _rows;
+    final shown = rows == null
+        ? const <PresetOverrun>[]
+        : [
+            for (final r in rows)
+              if (!_onlyOverruns || r.overruns > 0) r,
+          ];
+    return Scaffold(
+      appBar: AppBar(toolbarHeight: 48, title: const Text('Telemetry')),
+      body: SingleChildScrollView(
+        padding: const EdgeInsets.all(16),
+        child: Column(
+          crossAxisAlignment: CrossAxisAlignment.start,
+          children: [
+            Wrap(
+              spacing: 8,
+              runSpacing: 4,
+              crossAxisAlignment: WrapCrossAlignment.center,
+              children: [
+                for (final (label, range) in _ranges)
+                  ChoiceChip(
+                    label: Text(label),
+                    selected: _range == range,
+                    onSelected: (_) {
+                      _range = range;
+                      _query();
+                    },
+                  ),
+                FilterChip(
+                  label: const Text('Only overruns'),
+                  selected: _onlyOverruns,
+                  onSelected: (on) => setState(() => _onlyOverruns = on),
+                ),
+              ],
+            ),
+            const SizedBox(height: 12),
+            if (rows == null)
+              const LinearProgressIndicator()
+            else if (shown.isEmpty)
+              const Text('Nothing recorded in this range.')
+            else
+              SingleChildScrollView(
+                scrollDirection: Axis.horizontal,
+                child: DataTable(
+                  columns: const [
+                    DataColumn(label: Text('Pedal')),
+                    DataColumn(label: Text('Preset')),
+                    DataColumn(label: Text('Time on it')),
+                    DataColumn(label: Text('Missed')),
+                    DataColumn(label: Text('Underruns')),
+                    DataColumn(label: Text('Peak load %')),
+                  ],
+                  rows: [
+                    for (final r in shown)
+                      DataRow(
+                        cells: [
+                          DataCell(Text(r.pedal)),
+                          DataCell(Text(_presetName(r.preset))),
+                          DataCell(Text(_duration(r.durMs))),
+                          DataCell(Text('${r.missed}')),
+                          DataCell(Text('${r.underruns}')),
+                          DataCell(Text(r.loadMax.toStringAsFixed(1))),
+                        ],
+                      ),
+                  ],
+                ),
+              ),
+          ],
+        ),
+      ),
+    );
+  }
+}
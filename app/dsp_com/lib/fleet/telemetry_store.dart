@@ -0,0 +1,385 @@
+import 'dart:async';
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import '../utils/debug_log.dart';
+
+/// How finely a range is kept: every PUB load sample, or rolled up into
+/// minute and hour rows (a row also ends where the preset changes, so
+/// every row has one preset).
+enum TelemetryLevel {
+  raw(0),
+  minute(60 * 1000),
+  hour(60 * 60 * 1000);
+
+  const TelemetryLevel(this.bucketMs);
+
+  final int bucketMs;
+
+  /// The finest level that keeps a [span] within a few thousand rows.
+  static TelemetryLevel forSpan(Duration span) {
+    if (span <= const Duration(hours: 1)) return raw;
+    if (span <= const Duration(days: 3)) return minute;
+    return hour;
+  }
+}
+
+/// A run of rows of one pedal at one level, column by column. Each row is
+/// [durMs] of running from [tMs] (ms since the epoch) on one [preset]:
+/// mean and peak DSP load (% of the block period), the deadline misses
+/// and ring underruns within it and the mean clock drift.
+class TelemetryColumns {
+  TelemetryColumns({
+    required this.tMs,
+    required this.durMs,
+    required this.load,
+    required this.loadMax,
+    required this.missed,
+    required this.underruns,
+    required this.driftPpm,
+    required this.preset,
+  });
+
+  final Int64List tMs;
+  final Uint32List durMs;
+  final Float32List load;
+  final Float32List loadMax;
+  final Uint32List missed;
+  final Uint32List underruns;
+  final Float32List driftPpm;
+  final Uint16List preset;
+
+  int get length => tMs.length;
+
+  // File name and bytes per row of each column, in field order.
+  static const List<(String, int)> _files = [
+    ('t.i64', 8),
+    ('dur.u32', 4),
+    ('load.f32', 4),
+    ('load_max.f32', 4),
+    ('missed.u32', 4),
+    ('under.u32', 4),
+    ('ppm.f32', 4),
+    ('preset.u16', 2),
+  ];
+
+  List<TypedData> get _columns => [
+    tMs,
+    durMs,
+    load,
+    loadMax,
+    missed,
+    underruns,
+    driftPpm,
+    preset,
+  ];
+
+  static TelemetryColumns _of(List<ByteBuffer> b, int offset, int n) =>
+      TelemetryColumns(
+        tMs: b[0].asInt64List(offset * 8, n),
+        durMs: b[1].asUint32List(offset * 4, n),
+        load: b[2].asFloat32List(offset * 4, n),
+        loadMax: b[3].asFloat32List(offset * 4, n),
+        missed: b[4].asUint32List(offset * 4, n),
+        underruns: b[5].asUint32List(offset * 4, n),
+        driftPpm: b[6].asFloat32List(offset * 4, n),
+        preset: b[7].asUint16List(offset * 2, n),
+      );
+
+  static TelemetryColumns _from(List<_Row> rows) {
+    final n = rows.length;
+    final c = TelemetryColumns(
+      tMs: Int64List(n),
+      durMs: Uint32List(n),
+      load: Float32List(n),
+      loadMax: Float32List(n),
+      missed: Uint32List(n),
+      underruns: Uint32List(n),
+      driftPpm: Float32List(n),
+      preset: Uint16List(n),
+    );
+    for (var i = 0; i < n; i++) {
+      final r = rows[i];
+      c.tMs[i] = r.tMs;
+      c.durMs[i] = r.durMs;
+      c.load[i] = r.load;
+      c.loadMax[i] = r.loadMax;
+      c.missed[i] = r.missed;
+      c.underruns[i] = r.underruns;
+      c.driftPpm[i] = r.driftPpm;
+      c.preset[i] = r.preset;
+    }
+    return c;
+  }
+
+  /// The rows of [dir] from [fromMs] up to [toMs]. Each column file is
+  /// read whole and looked at in place through a typed view, so a range
+  /// costs one read per column and a binary search, no decoding. A row
+  /// only some columns got to before a crash is left out.
+  static Future<TelemetryColumns> read(
+    Directory dir, {
+    int fromMs = 0,
+    int? toMs,
+  }) async {
+    final bytes = await Future.wait([
+      for (final (name, _) in _files)
+        File('${dir.path}${Platform.pathSeparator}$name')
+            .readAsBytes()
+            .catchError((Object _) => Uint8List(0)),
+    ]);
+    var n = 1 << 62;
+    for (var i = 0; i < _files.length; i++) {
+      n = min(n, bytes[i].length ~/ _files[i].$2);
+    }
+    // readAsBytes hands back buffers of their own, aligned for any view.
+    final all = _of([for (final b in bytes) b.buffer], 0, n);
+    final lo = all._lowerBound(fromMs);
+    final hi = toMs == null ? n : all._lowerBound(toMs);
+    return _of([for (final b in bytes) b.buffer], lo, max(0, hi - lo));
+  }
+
+  int _lowerBound(int t) {
+    var lo = 0;
+    var hi = length;
+    while (lo < hi) {
+      final mid = (lo + hi) >> 1;
+      if (tMs[mid] < t) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+}
+
+class _Row {
+  _Row(this.tMs, this.preset);
+
+  final int tMs;
+  final int preset;
+  int durMs = 0;
+  double load = 0;
+  double loadMax = 0;
+  int missed = 0;
+  int underruns = 0;
+  double driftPpm = 0;
+  // Samples folded into a rollup row.
+  int n = 0;
+
+  void fold(_Row r) {
+    // Mean over the samples; a rollup row spans whole samples.
+    load += (r.load - load) / (n + 1);
+    driftPpm += (r.driftPpm - driftPpm) / (n + 1);
+    loadMax = max(loadMax, r.loadMax);
+    durMs += r.durMs;
+    missed += r.missed;
+    underruns += r.underruns;
+    n++;
+  }
+}
+
+// One level's column files: rows wait in [_pending] for the next flush;
+// a rollup level folds samples into [_open] until the bucket or the
+// preset changes.
+class _LevelWriter {
+  _LevelWriter(this.dir, this.level);
+
+  final Directory dir;
+  final TelemetryLevel level;
+  final List<_Row> _pending = [];
+  _Row? _open;
+  int _openBucket = 0;
+
+  void add(_Row r) {
+    if (level == TelemetryLevel.raw) {
+      _pending.add(r);
+      return;
+    }
+    final bucket = r.tMs - r.tMs % level.bucketMs;
+    final o = _open;
+    if (o != null && (bucket != _openBucket || r.preset != o.preset)) {
+      _pending.add(o);
+      _open = null;
+    }
+    if (_open == null) _openBucket = bucket;
+    (_open ??= _Row(r.tMs, r.preset)).fold(r);
+  }
+
+  void flush({bool close = false}) {
+    final o = _open;
+    if (close && o != null) {
+      _pending.add(o);
+      _open = null;
+    }
+    if (_pending.isEmpty) return;
+    final cols = TelemetryColumns._from(_pending)._columns;
+    _pending.clear();
+    dir.createSync(recursive: true);
+    for (var i = 0; i < cols.length; i++) {
+      final f = File(
+        '${dir.path}${Platform.pathSeparator}${TelemetryColumns._files[i].$1}',
+      );
+      final c = cols[i];
+      f.writeAsBytesSync(
+        c.buffer.asUint8List(c.offsetInBytes, c.lengthInBytes),
+        mode: FileMode.append,
+      );
+    }
+  }
+}
+
+/// Appends one pedal's PUB load samples to its store, raw and rolled up,
+/// flushing once a second ([_kFlushEvery]); [close] writes the rows still
+/// open.
+class TelemetryWriter {
+  TelemetryWriter._(Directory dir)
+    : _levels = [
+        for (final l in TelemetryLevel.values)
+          _LevelWriter(
+            Directory('${dir.path}${Platform.pathSeparator}${l.name}'),
+            l,
+          ),
+      ] {
+    _flushTimer = Timer.periodic(_kFlushEvery, (_) => _flush());
+  }
+
+  static const Duration _kFlushEvery = Duration(seconds: 1);
+
+  final List<_LevelWriter> _levels;
+  Timer? _flushTimer;
+  int? _lastMs;
+  int? _lastMissed;
+  int? _lastUnderruns;
+
+  /// A PUB load sample with the counters since boot as it reports them;
+  /// stored as what happened since the previous sample. The first sample
+  /// only sets the baseline, and a counter going down means a reboot.
+  void sample({
+    required double load,
+    required double loadMax,
+    required int missed,
+    required int underruns,
+    required double driftPpm,
+    required int preset,
+  }) {
+    if (_flushTimer == null) return;
+    final now = DateTime.now().millisecondsSinceEpoch;
+    int delta(int v, int? prev) =>
+        prev == null ? 0 : (v >= prev ? v - prev : v);
+    final r = _Row(now, preset)
+      ..durMs = _lastMs == null ? 0 : now - _lastMs!
+      ..load = load
+      ..loadMax = loadMax
+      ..missed = delta(missed, _lastMissed)
+      ..underruns = delta(underruns, _lastUnderruns)
+      ..driftPpm = driftPpm;
+    _lastMs = now;
+    _lastMissed = missed;
+    _lastUnderruns = underruns;
+    for (final l in _levels) {
+      l.add(r);
+    }
+  }
+
+  void close() {
+    _flushTimer?.cancel();
+    _flushTimer = null;
+    _flush(close: true);
+  }
+
+  void _flush({bool close = false}) {
+    try {
+      for (final l in _levels) {
+        l.flush(close: close);
+      }
+    } on FileSystemException catch (e) {
+      dlogState(() => 'telemetry not written: $e');
+    }
+  }
+}
+
+/// What one pedal did on one preset over a range.
+class PresetOverrun {
+  PresetOverrun(this.pedal, this.preset);
+
+  final String pedal;
+  final int preset;
+  int durMs = 0;
+  int missed = 0;
+  int underruns = 0;
+  double loadMax = 0;
+
+  int get overruns => missed + underruns;
+}
+
+/// Every pedal's telemetry under `telemetry/<pedal>/<level>/`, one
+/// append-only file per column in host byte order, so a range reads back
+/// as typed views over the file bytes ([TelemetryColumns.read]). A pedal
+/// is named by its USB serial number, or its port without one.
+class TelemetryStore {
+  TelemetryStore([Directory? root])
+    : root =
+          root ??
+          Directory(
+            '${Directory.current.path}${Platform.pathSeparator}telemetry',
+          );
+
+  final Directory root;
+
+  static String _dirName(String pedal) =>
+      pedal.replaceAll(RegExp(r'[^A-Za-z0-9._-]'), '_');
+
+  Directory _dir(String pedal, TelemetryLevel level) => Directory(
+    '${root.path}${Platform.pathSeparator}${_dirName(pedal)}'
+    '${Platform.pathSeparator}${level.name}',
+  );
+
+  TelemetryWriter writer(String pedal) => TelemetryWriter._(
+    Directory('${root.path}${Platform.pathSeparator}${_dirName(pedal)}'),
+  );
+
+  Future<List<String>> pedals() async {
+    try {
+      return [
+        await for (final e in root.list())
+          if (e is Directory) e.uri.pathSegments.lastWhere((s) => s != ''),
+      ]..sort();
+    } on FileSystemException {
+      return const [];
+    }
+  }
+
+  Future<TelemetryColumns> read(
+    String pedal,
+    TelemetryLevel level, {
+    int fromMs = 0,
+    int? toMs,
+  }) => TelemetryColumns.read(_dir(pedal, level), fromMs: fromMs, toMs: toMs);
+
+  /// Which pedals overran on which presets since [since]: one entry per
+  /// pedal and preset, most overruns first, from the level that suits the
+  /// range (the row still open in a rollup is not in it yet).
+  Future<List<PresetOverrun>> overruns(Duration since) async {
+    final from = DateTime.now().subtract(since).millisecondsSinceEpoch;
+    final level = TelemetryLevel.forSpan(since);
+    final out = <PresetOverrun>[];
+    for (final pedal in await pedals()) {
+      final c = await read(pedal, level, fromMs: from);
+      final byPreset = <int, PresetOverrun>{};
+      for (var i = 0; i < c.length; i++) {
+        final s = byPreset.putIfAbsent(
+          c.preset[i],
+          () => PresetOverrun(pedal, c.preset[i]),
+        );
+        s.durMs += c.durMs[i];
+        s.missed += c.missed[i];
+        s.underruns += c.underruns[i];
+        s.loadMax = max(s.loadMax, c.loadMax[i]);
+      }
+      out.addAll(byPreset.values);
+    }
+    return out..sort((a, b) => b.overruns.compareTo(a.overruns));
+  }
+}
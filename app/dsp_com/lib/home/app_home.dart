@@ -0,0 +1,16 @@
+import 'package:flutter/foundation.dart';
+import 'package:flutter/widgets.dart';
+
+import '../serial/ble_link.dart';
+import '../tuning/tuning_page.dart';
+import 'home_page.dart';
+
+/// The home of the dart:io builds: the full HomePage on the desktop, where
+/// the pedal is on a serial port, and the tuning page over BLE on a phone,
+/// which has none.
+Widget appHome() => switch (defaultTargetPlatform) {
+  TargetPlatform.android || TargetPlatform.iOS => TuningPage(link: _ble),
+  _ => const HomePage(),
+};
+
+final BleLink _ble = BleLink();
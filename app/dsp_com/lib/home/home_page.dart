@@ -1,14 +1,31 @@
 import 'dart:async';
+import 'dart:io';
 
 import 'package:flutter/material.dart';
 // ignore: depend_on_referenced_packages
 import 'package:libserialport/libserialport.dart';
 
+import '../bench/bench_page.dart';
+import '../fleet/fleet_page.dart';
+import '../presets/preset_library.dart';
+import '../presets/preset_record.dart';
 import '../presets/presets.dart';
+import '../preview/dsp_preview.dart';
+import '../serial/control_latency.dart';
+import '../serial/device_caps.dart';
+import '../serial/link_rate.dart';
+import '../serial/meter_frame.dart';
+import '../serial/param_desc.dart';
+import '../serial/port_probe.dart';
+import '../serial/preset_bank.dart';
 import '../serial/serial_link.dart';
+import '../serial/session_log.dart';
 import '../utils/debouncer.dart';
 import '../utils/debug_log.dart';
+import '../utils/startup_clock.dart';
 import 'widgets/connection_section.dart';
+import 'widgets/library_section.dart';
+import 'widgets/meter_section.dart';
 import 'widgets/pedal_section.dart';
 
 class HomePage extends StatefulWidget {
@@ -18,12 +35,18 @@ class HomePage extends StatefulWidget {
   State<HomePage> createState() => _HomePageState();
 }
 
-class _HomePageState extends State<HomePage> {
+class _HomePageState extends State<HomePage>
+    with WidgetsBindingObserver {
   static const String _kPedalBgAsset = 'assets/background.jpg';
   static const String _kKnobAsset = 'assets/figma/empress_knob.png';
+  // Matches APP_COM_PSET_MAX in the firmware.
+  static const int _kPsetmMaxPairs = 8;
+  // Level meter stream rate requested from the firmware (SUB meter <hz>).
+  static const int _kMeterHz = 20;
 
   final SerialLink _link = SerialLink();
-  // Send params only when the user stops turning the knob.
+  // Knob values are saved to disk once the user stops turning; they go to
+  // the pedal as fast as _rate allows.
   final Debouncer _paramDebounce = Debouncer(const Duration(milliseconds: 220));
 
   bool _deviceReady = false;
@@ -32,12 +55,25 @@ class _HomePageState extends State<HomePage> {
   Timer? _healthTimer;
   DateTime? _lastRxAt;
 
-  // TX coalescing: keep only the latest desired values, and send at most one
-  // command at a time (wait for OK/ERR/timeout before sending the next).
-  Timer? _txAckTimer;
-  _PendingCmd? _pendingCmd;
+  // TX coalescing: keep only the latest desired values. Commands go out
+  // sequence-tagged ("#<seq> <cmd>"; the firmware starts every reply line
+  // with the same tag), each retired by its OK/ERR or a timeout. A value
+  // already in flight is not sent again. How many may be in flight (up to
+  // _kTxWindow), how far apart they go and when one times out follow the
+  // measured round trips (_rate).
+  static const int _kTxWindow = 4;
+  final Map<int, _PendingCmd> _inflight = {};
+  int _nextSeq = 1;
+  final LinkRate _rate = LinkRate(maxWindow: _kTxWindow);
+  final Stopwatch _sinceSend = Stopwatch()..start();
+  // Bytes of the reply line being handled, for _rate's wire time.
+  int _rxBytes = 0;
+  // Knob-to-DSP time per stage, from PSETM lines that carry the
+  // firmware's latency probe (one in flight at a time).
+  final ControlLatency _latency = ControlLatency();
 
   Timer? _retryTimer;
+  Timer? _paceTimer;
   bool _pumpScheduled = false;
 
   int _lastAppliedFxMask = 0;
@@ -46,17 +82,70 @@ class _HomePageState extends State<HomePage> {
   final Map<String, int> _lastAppliedParams = {};
   final Map<String, int> _desiredParams = {};
 
+  // Highest STATUS/EVT version seen (0 = none yet): a resync only fetches
+  // the fields changed after it.
+  int _syncVer = 0;
+
+  // Parameter-set versions (P=): the one the last STATUS/EVT values were
+  // read from, and the highest any line reported (acks included). Equal
+  // means _lastAppliedParams is the pedal's newest set.
+  int _paramVer = 0;
+  int _paramVerSeen = 0;
+
+  // Parameter limits reported by the firmware (PLIST), keyed by name.
+  final Map<String, ParamDesc> _paramDescs = {};
+
+  // What the firmware speaks (CAPS, null for firmware without it), and the
+  // CAPS hash _paramDescs were fetched under: a reconnect to the same
+  // build skips PLIST.
+  DeviceCaps? _caps;
+  int? _paramDescsHash;
+
+  // Named presets on disk and the pedal bank (PBANK) they sync with.
+  PresetLibrary? _library;
+  late final PresetBankTransfer _bank = PresetBankTransfer(_link.sendFrame);
+  PresetBankLayout? _bankLayout;
+  bool _bankBusy = false;
+  String _bankStatus = '';
+
+  // Session logs (sessions/*.dsl, SessionLog): the next connection is
+  // recorded while _recordSession is set; a replay has the port to itself.
+  bool _recordSession = false;
+  bool _replayBusy = false;
+
+  // Auto-connect (PortProbe): the pedal used last, and the replug watch
+  // that runs while it is remembered but not connected, until the user
+  // disconnects on purpose. At launch the remembered port is opened
+  // straight away, the probe only if it stays quiet for _kDirectWait.
+  static const Duration _kPlugPoll = Duration(milliseconds: 500);
+  static const Duration _kDirectWait = Duration(seconds: 1);
+  LinkMemory? _memory;
+  Timer? _plugTimer;
+  bool _probing = false;
+  Completer<void>? _readyWaiter;
+
+  // Latest METER frame, null until the stream starts.
+  MeterFrame? _meter;
+
+  // The meter is only subscribed while the window is on screen; the rate
+  // last asked for, null when the device has not been asked yet.
+  bool _appVisible = true;
+  int? _meterSubHz;
+
   // Anti-spam: at most 2 attempts (send + one retry) per param/value.
   final Map<String, _PsetAttempts> _psetAttempts = {};
 
   void _clearPendingAcks() {
-    dlogState(() => 'clearPendingAcks (pending=${_pendingCmd?.type})');
-    _txAckTimer?.cancel();
-    _txAckTimer = null;
-    _pendingCmd = null;
+    dlogState(() => 'clearPendingAcks (inflight=${_inflight.length})');
+    for (final cmd in _inflight.values) {
+      cmd.timer?.cancel();
+    }
+    _inflight.clear();
 
     _retryTimer?.cancel();
     _retryTimer = null;
+    _paceTimer?.cancel();
+    _paceTimer = null;
 
     _pumpScheduled = false;
 
@@ -65,7 +154,7 @@ class _HomePageState extends State<HomePage> {
 
   void _scheduleRetry() {
     _retryTimer?.cancel();
-    _retryTimer = Timer(const Duration(milliseconds: 80), () {
+    _retryTimer = Timer(_rate.retry, () {
       if (!mounted) return;
       dlogState(() => 'retry pumpTx');
       _requestPump();
@@ -82,82 +171,200 @@ class _HomePageState extends State<HomePage> {
     });
   }
 
-  void _requestStatusSync({required String reason}) {
+  // Sends [line] tagged with the next sequence number and starts its ack
+  // timeout.
+  void _sendCmd(_PendingCmd cmd, String line, void Function() onTimeout) {
+    final seq = _nextSeq;
+    _nextSeq = (_nextSeq % 99999999) + 1;
+    final tagged = '#$seq $line';
+    _inflight[seq] = cmd;
+    cmd.txBytes = tagged.length + 1;
+    cmd.sent.start();
+    cmd.timer = Timer(_rate.rto, () {
+      if (!mounted) return;
+      if (_inflight.remove(seq) == null) return;
+      _rate.onTimeout();
+      dlogState(() => 'timeout, link $_rate');
+      onTimeout();
+    });
+    _sinceSend.reset();
+    _link.sendLine(tagged);
+  }
+
+  void _acked(_PendingCmd cmd) {
+    cmd.timer?.cancel();
+    _rate.onAck(cmd.sent.elapsedMicroseconds, cmd.txBytes + _rxBytes);
+  }
+
+  // Retires the command a reply belongs to: the one tagged [seq], or for an
+  // untagged reply the oldest in flight of [type]. Null if none matches.
+  _PendingCmd? _completeCmd(int? seq, [_PendingCmdType? type]) {
+    var key = seq;
+    if (key == null) {
+      for (final e in _inflight.entries) {
+        if (type == null || e.value.type == type) {
+          key = e.key;
+          break;
+        }
+      }
+    }
+    final cmd = key == null ? null : _inflight[key];
+    if (cmd == null || (type != null && cmd.type != type)) return null;
+    _inflight.remove(key);
+    _acked(cmd);
+    return cmd;
+  }
+
+  // QACK <seq> (QUIET mode): every PSETM and FXMASK sent up to tag <seq>
+  // is done and applied as sent; EVT pushes correct any value the
+  // firmware clamped.
+  void _completeQuiet(int seq) {
+    if (!_inflight.containsKey(seq)) return;
+    final done = <int>[];
+    for (final MapEntry(:key, value: cmd) in _inflight.entries) {
+      if (cmd.type != _PendingCmdType.status) done.add(key);
+      if (key == seq) break;
+    }
+    var applied = 0;
+    for (final key in done) {
+      final cmd = _inflight.remove(key)!;
+      // Only the tagged one is answered now; the others waited for it.
+      if (key == seq) {
+        _acked(cmd);
+      } else {
+        cmd.timer?.cancel();
+      }
+      final mask = cmd.fxMask;
+      if (mask != null) _lastAppliedFxMask = mask;
+      for (final MapEntry(:key, :value) in (cmd.params ?? {}).entries) {
+        _lastAppliedParams[key] = value;
+        _psetAttempts.remove(key);
+        applied++;
+      }
+    }
+    _lastAction = 'Params applied ($applied)';
+    dlogState(() => 'QACK $seq (${done.length} commands)');
+    _requestPump();
+  }
+
+  bool _inFlight(bool Function(_PendingCmd cmd) test) =>
+      _inflight.values.any(test);
+
+  // P= of a reply line, if it has one.
+  void _notePver(String line) {
+    for (final p in line.split(RegExp(r'\s+'))) {
+      if (p.startsWith('P=')) {
+        final v = int.tryParse(p.substring(2));
+        if (v != null && v > _paramVerSeen) _paramVerSeen = v;
+      }
+    }
+  }
+
+  // [ifBehind]: only when the values held are older than a set the pedal
+  // reported, as after a rejected command (which publishes nothing).
+  void _requestStatusSync({required String reason, bool ifBehind = false}) {
     if (!_link.isOpen) return;
-    if (_pendingCmd != null) return;
+    if (_inFlight((c) => c.type == _PendingCmdType.status)) return;
+    if (ifBehind && _paramVer != 0 && _paramVer == _paramVerSeen) {
+      dlogState(() => 'STATUS skipped (reason=$reason, P=$_paramVer current)');
+      return;
+    }
 
-    dlogTx(() => 'STATUS (reason=$reason)');
-    _pendingCmd = _PendingCmd.status();
-    _link.sendLine('STATUS');
-    _txAckTimer?.cancel();
-    _txAckTimer = Timer(const Duration(milliseconds: 300), () {
-      if (!mounted) return;
+    final line = _syncVer > 0 ? 'STATUS $_syncVer' : 'STATUS';
+    dlogTx(() => '$line (reason=$reason)');
+    _sendCmd(_PendingCmd.status(), line, () {
       dlogState(() => 'STATUS timeout');
-      _pendingCmd = null;
       _scheduleRetry();
     });
   }
 
   void _pumpTx() {
     if (!_link.isOpen || !_deviceReady) return;
-    if (_pendingCmd != null) return;
+    while (_inflight.length < _rate.window) {
+      // Spaced by the link's pace: what changes meanwhile is coalesced
+      // into the next command.
+      final wait = _rate.pace - _sinceSend.elapsed;
+      if (wait > Duration.zero) {
+        _paceTimer ??= Timer(wait, () {
+          _paceTimer = null;
+          _requestPump();
+        });
+        return;
+      }
+      if (!_sendNextCmd()) return;
+    }
+  }
 
+  // Sends the most urgent outstanding change; false if there is none.
+  bool _sendNextCmd() {
     // Priority 1: FXMASK changes.
     final desiredMask = _desiredFxMask;
-    if (desiredMask != null && desiredMask != _lastAppliedFxMask) {
+    if (desiredMask != null &&
+        desiredMask != _lastAppliedFxMask &&
+        !_inFlight(
+          (c) => c.type == _PendingCmdType.fxmask && c.fxMask == desiredMask,
+        )) {
       dlogTx(
         () =>
             'FXMASK send desired=$desiredMask lastApplied=$_lastAppliedFxMask',
       );
-      _pendingCmd = _PendingCmd.fxmask(desiredMask);
-      _link.sendLine('FXMASK $desiredMask');
-      _txAckTimer?.cancel();
-      _txAckTimer = Timer(const Duration(milliseconds: 250), () {
-        if (!mounted) return;
-        setState(() {
-          _lastAction = 'FXMASK timeout (no ack)';
-        });
-        dlogState(() => 'FXMASK timeout desired=$desiredMask');
-        _pendingCmd = null;
-        // Don't spam resend blindly; sync state then retry only if needed.
-        _requestStatusSync(reason: 'fxmask-timeout');
-      });
-      return;
+      _sendCmd(
+        _PendingCmd.fxmask(desiredMask),
+        'FXMASK $desiredMask',
+        () {
+          setState(() {
+            _lastAction = 'FXMASK timeout (no ack)';
+          });
+          dlogState(() => 'FXMASK timeout desired=$desiredMask');
+          // Don't spam resend blindly; sync state then retry only if needed.
+          _requestStatusSync(reason: 'fxmask-timeout');
+        },
+      );
+      return true;
     }
 
-    // Priority 2: PSET changes, one param at a time.
+    // Priority 2: PSET changes. Every changed param goes out in one PSETM
+    // line, which the firmware applies in a single DSP block and acks once.
+    final batch = <String, int>{};
     for (final entry in _desiredParams.entries) {
+      if (batch.length >= _kPsetmMaxPairs) break;
       final param = entry.key;
       final value = entry.value;
-      final last = _lastAppliedParams[param];
-      if (last != value) {
-        final attempts = _psetAttempts[param];
-        if (attempts != null &&
-            attempts.value == value &&
-            attempts.count >= 2) {
-          continue;
-        }
-
-        _psetAttempts[param] = _PsetAttempts.bump(prev: attempts, value: value);
-
-        dlogTx(() => 'PSET send $param=$value lastApplied=${last ?? 'null'}');
-        _pendingCmd = _PendingCmd.pset(param, value);
-        _link.sendLine('PSET $param $value');
-        _txAckTimer?.cancel();
-        _txAckTimer = Timer(const Duration(milliseconds: 250), () {
-          if (!mounted) return;
-          setState(() {
-            _lastAction = 'PSET timeout ($param, sent $value)';
-          });
-          dlogState(() => 'PSET timeout $param=$value');
+      if (_lastAppliedParams[param] == value) continue;
+      if (_inFlight(
+        (c) => c.type == _PendingCmdType.pset && c.params![param] == value,
+      )) {
+        continue;
+      }
 
-          _pendingCmd = null;
-          // Don't spam resend blindly; sync state then retry only if needed.
-          _requestStatusSync(reason: 'pset-timeout');
-        });
-        return;
+      final attempts = _psetAttempts[param];
+      if (attempts != null && attempts.value == value && attempts.count >= 2) {
+        continue;
       }
+      _psetAttempts[param] = _PsetAttempts.bump(prev: attempts, value: value);
+      batch[param] = value;
     }
+    if (batch.isEmpty) return false;
+
+    final pairs = batch.entries.map((e) => '${e.key}=${e.value}').join(' ');
+    final probe = _latency.begin(
+      batch.keys,
+      enabled: _caps?.has('lat') ?? false,
+    );
+    dlogTx(() => '${probe}PSETM send $pairs');
+    _sendCmd(
+      _PendingCmd.pset(batch),
+      '${probe}PSETM $pairs',
+      () {
+        setState(() {
+          _lastAction = 'PSET timeout (${batch.length} params)';
+        });
+        dlogState(() => 'PSETM timeout $pairs');
+        // Don't spam resend blindly; sync state then retry only if needed.
+        _requestStatusSync(reason: 'pset-timeout');
+      },
+    );
+    return true;
   }
 
   void _setDesiredFxMask(int mask) {
@@ -165,16 +372,11 @@ class _HomePageState extends State<HomePage> {
 
     dlogState(
       () =>
-          'desired FXMASK=$mask (pending=${_pendingCmd?.type}, lastApplied=$_lastAppliedFxMask)',
+          'desired FXMASK=$mask (inflight=${_inflight.length}, lastApplied=$_lastAppliedFxMask)',
     );
 
-    // Effect changes must be instant: don't let them wait behind a knob write.
-    if (_pendingCmd != null && _pendingCmd!.type == _PendingCmdType.pset) {
-      dlogState(() => 'preempt in-flight PSET for FXMASK');
-      _txAckTimer?.cancel();
-      _txAckTimer = null;
-      _pendingCmd = null;
-    }
+    // Effect changes must be instant: FXMASK takes the next free window
+    // slot ahead of any knob write.
 
     setState(() {
       _lastAction = 'Applying effects...';
@@ -183,8 +385,11 @@ class _HomePageState extends State<HomePage> {
   }
 
   void _setDesiredParam(String param, int value) {
+    final desc = _paramDescs[param];
+    if (desc != null && desc.clamp) value = desc.clampValue(value);
     dlogState(() => 'desired PSET $param=$value');
     _desiredParams[param] = value;
+    _latency.noteChange(param);
     // New user value => allow send/retry again.
     _psetAttempts.remove(param);
     _requestPump();
@@ -196,20 +401,22 @@ class _HomePageState extends State<HomePage> {
       if (!mounted) return;
       if (!_link.isOpen) return;
 
-      // Ping only when not busy with parameter/effect updates.
-      if (_pendingCmd == null &&
+      // Consider the device alive if we received *any* line recently.
+      // During FX/PSET bursts we may intentionally not send PINGs.
+      final last = _lastRxAt;
+      final quiet = last == null ? null : DateTime.now().difference(last);
+      final isFresh = quiet != null && quiet < const Duration(seconds: 3);
+
+      // Ping only when the link has been quiet (METER frames and EVT pushes
+      // already prove the device is alive) and not busy with
+      // parameter/effect updates.
+      if ((quiet == null || quiet >= const Duration(seconds: 1)) &&
+          _inflight.isEmpty &&
           (_desiredFxMask == null || _desiredFxMask == _lastAppliedFxMask)) {
         dlogTx(() => 'PING');
         _link.sendLine('PING');
       }
 
-      // Consider the device alive if we received *any* line recently.
-      // During FX/PSET bursts we may intentionally not send PINGs.
-      final last = _lastRxAt;
-      final isFresh =
-          last != null &&
-          DateTime.now().difference(last) < const Duration(seconds: 3);
-
       // If we haven't seen PONG/READY recently, mark as lost.
       if (_deviceReady && !isFresh) {
         dlogState(
@@ -250,6 +457,10 @@ class _HomePageState extends State<HomePage> {
   bool _dist = false;
   bool _rev = false;
   bool _del = false;
+  // Bit 3; only a build whose CAPS lists `chorus` has the switch.
+  bool _cho = false;
+  // Set on connect until the first full STATUS reply is taken over.
+  bool _adoptPending = false;
 
   Presets _presets = Presets.defaults();
   String _lastDeviceLine = '';
@@ -259,15 +470,30 @@ class _HomePageState extends State<HomePage> {
   @override
   void initState() {
     super.initState();
+    WidgetsBinding.instance.addObserver(this);
+    WidgetsBinding.instance.addPostFrameCallback(
+      (_) => StartupClock.mark(StartupClock.firstFrame),
+    );
     _refreshPorts();
     PresetStore.load().then((p) {
       if (!mounted) return;
       setState(() => _presets = p);
     });
+    PresetLibrary.open().then((lib) {
+      if (!mounted) return;
+      setState(() => _library = lib);
+    });
+    LinkMemory.load().then((m) async {
+      _memory = m;
+      await _autoConnect(any: true);
+      if (m != null) _startPlugWatch();
+    });
   }
 
   @override
   void dispose() {
+    WidgetsBinding.instance.removeObserver(this);
+    _stopPlugWatch();
     _paramDebounce.dispose();
     _stopHealthWatchdog();
     _clearPendingAcks();
@@ -275,6 +501,26 @@ class _HomePageState extends State<HomePage> {
     super.dispose();
   }
 
+  @override
+  void didChangeAppLifecycleState(AppLifecycleState state) {
+    // Inactive is still on screen (a desktop window without focus).
+    _appVisible =
+        state == AppLifecycleState.resumed ||
+        state == AppLifecycleState.inactive;
+    _syncMeterSub();
+  }
+
+  void _syncMeterSub() {
+    if (!_link.isOpen || !_deviceReady) return;
+    final hz = _appVisible ? _kMeterHz : 0;
+    if (hz == _meterSubHz) return;
+    _meterSubHz = hz;
+    // METER is the same subscription on firmware from before SUB.
+    _link.sendLine(
+      _caps?.has('sub') ?? false ? 'SUB meter $hz' : 'METER $hz',
+    );
+  }
+
   void _refreshPorts() {
     final ports = SerialPort.availablePorts;
     setState(() {
@@ -283,15 +529,20 @@ class _HomePageState extends State<HomePage> {
     });
   }
 
+  bool get _hasChorus => _caps?.has('chorus') ?? false;
+
   int _fxMask() {
     var mask = 0;
     if (_dist) mask |= 1 << 0;
     if (_rev) mask |= 1 << 1;
     if (_del) mask |= 1 << 2;
+    if (_cho && _hasChorus) mask |= 1 << 3;
     return mask;
   }
 
   Future<void> _connectOrDisconnect() async {
+    if (_replayBusy) return;
+    _stopPlugWatch();
     if (_link.isOpen) {
       dlogState(() => 'disconnect requested');
       _link.close();
@@ -302,6 +553,7 @@ class _HomePageState extends State<HomePage> {
         _lastDeviceLine = '';
         _deviceReady = false;
         _initialSyncDone = false;
+        _meter = null;
       });
       return;
     }
@@ -314,148 +566,44 @@ class _HomePageState extends State<HomePage> {
     await _link.open(
       portName: port,
       baudRate: _baudRate,
-      onLine: (line) {
+      recordPath: _recordSession ? _newSessionPath() : null,
+      onEvent: (event) {
         if (!mounted) return;
-        setState(() {
-          _lastRxAt = DateTime.now();
-          _lastDeviceLine = line;
-
-          dlogRx(() => line);
-
-          // Basic device handshake: the serial port can be open even if the DSP
-          // is not ready to accept commands yet.
-          if (line == 'READY' || line == 'PONG' || line.startsWith('OK PING')) {
-            _deviceReady = true;
-            _lastAction = 'Device ready';
-
-            dlogState(() => 'device ready (line=$line)');
-
-            if (!_initialSyncDone) {
-              _initialSyncDone = true;
-              _setDesiredFxMask(_fxMask());
-              _pushAllParams();
-              _requestPump();
-              _link.sendLine('STATUS');
-            }
-          }
-
-          if (line.startsWith('STATUS ')) {
-            // Example:
-            // STATUS FXMASK=<n> dist_drive_q8=<n> delay_mix_q15=<n> ...
-            final parts = line.split(RegExp(r'\s+'));
-            for (final p in parts.skip(1)) {
-              final eq = p.indexOf('=');
-              if (eq <= 0) continue;
-              final key = p.substring(0, eq);
-              final val = int.tryParse(p.substring(eq + 1));
-              if (val == null) continue;
-
-              if (key == 'FXMASK') {
-                _lastAppliedFxMask = val;
-              } else {
-                _lastAppliedParams[key] = val;
-              }
-            }
-
-            final pending = _pendingCmd;
-            if (pending != null && pending.type == _PendingCmdType.status) {
-              _txAckTimer?.cancel();
-              _txAckTimer = null;
-              _pendingCmd = null;
-              dlogState(
-                () =>
-                    'STATUS sync applied fx=$_lastAppliedFxMask dist=${_lastAppliedParams['dist_drive_q8']}',
-              );
-              _requestPump();
-            }
-          }
-
-          // "See if effect is changed or not": confirm FXMASK ack.
-          if (line.startsWith('OK FXMASK')) {
-            final parts = line.split(RegExp(r'\s+'));
-            if (parts.length >= 3) {
-              final n = int.tryParse(parts[2]);
-              final pending = _pendingCmd;
-              if (pending != null && pending.type == _PendingCmdType.fxmask) {
-                _txAckTimer?.cancel();
-                _txAckTimer = null;
-                _pendingCmd = null;
-              }
-              if (n != null) {
-                _lastAppliedFxMask = n;
-                _lastAction = 'Effect applied (FXMASK=$n)';
-                dlogState(() => 'ack FXMASK=$n');
-              }
-              _requestPump();
-            }
-          }
-
-          if (line.startsWith('ERR FXMASK')) {
-            _txAckTimer?.cancel();
-            _txAckTimer = null;
-            _pendingCmd = null;
-            _lastAction = 'FXMASK rejected by device';
-            dlogState(() => 'ERR FXMASK');
-            _requestStatusSync(reason: 'fxmask-err');
-          }
-
-          if (line.startsWith('OK PSET')) {
-            final parts = line.split(RegExp(r'\s+'));
-            if (parts.length >= 4) {
-              final pname = parts[2];
-              final v = int.tryParse(parts[3]);
-              final pending = _pendingCmd;
-              if (pending != null && pending.type == _PendingCmdType.pset) {
-                _txAckTimer?.cancel();
-                _txAckTimer = null;
-                _pendingCmd = null;
-              }
-              if (v != null) {
-                _lastAppliedParams[pname] = v;
-                _psetAttempts.remove(pname);
-                _lastAction = 'Param applied ($pname=$v)';
-                dlogState(() => 'ack PSET $pname=$v');
-              } else {
-                _lastAction = 'Param applied ($pname=???)';
-                dlogState(() => 'ack PSET $pname=???');
-              }
-              _requestPump();
-            }
-          }
-
-          if (line.startsWith('ERR PSET')) {
-            // Firmware doesn't tell which param failed.
-            _txAckTimer?.cancel();
-            _txAckTimer = null;
-            _pendingCmd = null;
-            _lastAction = 'PSET rejected by device';
-            dlogState(() => 'ERR PSET ($line)');
-            _requestStatusSync(reason: 'pset-err');
-          }
-
-          if (line.startsWith('ERR UNKNOWN')) {
-            // Treat as immediate failure of whatever was in-flight; this is
-            // usually command corruption / dropped bytes.
-            final hadPending = _pendingCmd != null;
-            _txAckTimer?.cancel();
-            _txAckTimer = null;
-            _pendingCmd = null;
-            _lastAction = 'Device parse error';
-            dlogState(() => 'ERR UNKNOWN ($line) pending=$hadPending');
-            _requestStatusSync(reason: 'unknown-err');
-          }
-        });
+        switch (event) {
+          case MeterEvent(:final frame):
+            setState(() {
+              _lastRxAt = DateTime.now();
+              _meter = frame;
+            });
+          case LineEvent():
+            _onLine(event);
+          case FrameEvent():
+            _bank.onFrame(event);
+          case LinkErrorEvent(:final message):
+            dlogState(() => 'link error: $message');
+            _stopHealthWatchdog();
+            _clearPendingAcks();
+            setState(() {
+              _lastAction = 'Serial error: $message';
+              _deviceReady = false;
+              _initialSyncDone = false;
+              _meter = null;
+            });
+            // A cable bump: back as soon as the pedal is.
+            _startPlugWatch();
+        }
       },
     );
 
+    StartupClock.mark(StartupClock.portOpen);
     _lastRxAt = DateTime.now();
+    _rate.reset(_baudRate);
+    _latency.reset();
     _startHealthWatchdog();
 
-    // On connect: force clean and push stored params.
+    // On connect: the pedal comes up on its last preset, so its state wins;
+    // the first STATUS reply is adopted (_adoptDeviceState()).
     setState(() {
-      _dist = false;
-      _rev = false;
-      _del = false;
       _deviceReady = false;
       _initialSyncDone = false;
       _lastAction = 'Port open: $port @ $_baudRate (waiting for device...)';
@@ -465,6 +613,378 @@ class _HomePageState extends State<HomePage> {
     _link.sendLine('PING');
   }
 
+  // Finds the pedal and connects: the remembered one where it is plugged
+  // in now, or with [any] whichever port answers first. The rates tried
+  // are the one it was left at, the one picked and the boot default.
+  Future<void> _autoConnect({bool any = false}) async {
+    if (_probing || _link.isOpen || _replayBusy || !mounted) return;
+    _probing = true;
+    try {
+      final ports = SerialPort.availablePorts;
+      final mem = _memory;
+      final bauds = {?mem?.baudRate, _baudRate, 115200}.toList();
+      final known = mem?.locate(ports);
+      if (any && mem != null && known != null) {
+        if (await _connectDirect(known, ports, mem.baudRate)) return;
+      }
+      var hit = known == null ? null : await PortProbe.find([known], bauds);
+      if (hit == null && any) hit = await PortProbe.find(ports, bauds);
+      if (hit == null || !mounted || _link.isOpen || _replayBusy) return;
+      final found = hit;
+      dlogState(() => 'pedal found on ${found.port} @ ${found.baudRate}');
+      setState(() {
+        _ports = ports;
+        _selectedPort = found.port;
+        _baudRate = found.baudRate;
+      });
+      await _connectOrDisconnect();
+    } catch (e) {
+      dlogState(() => 'auto-connect failed: $e');
+      _startPlugWatch();
+    } finally {
+      _probing = false;
+    }
+  }
+
+  // Connects to [port] at [baud] without probing it first and waits for
+  // the pedal's answer; false, with the port closed again, if none comes
+  // within _kDirectWait.
+  Future<bool> _connectDirect(String port, List<String> ports, int baud) async {
+    setState(() {
+      _ports = ports;
+      _selectedPort = port;
+      _baudRate = baud;
+    });
+    final ready = _readyWaiter = Completer<void>();
+    await _connectOrDisconnect();
+    final ok = await ready.future
+        .timeout(_kDirectWait)
+        .then((_) => true)
+        .catchError((Object _) => false);
+    _readyWaiter = null;
+    if (!ok && mounted && _link.isOpen) {
+      await _connectOrDisconnect();
+      await _link.closed;
+    }
+    return ok;
+  }
+
+  void _startPlugWatch() {
+    if (_memory == null || _plugTimer != null) return;
+    _plugTimer = Timer.periodic(_kPlugPoll, (_) {
+      if (_link.isOpen) {
+        _stopPlugWatch();
+      } else {
+        _autoConnect();
+      }
+    });
+  }
+
+  void _stopPlugWatch() {
+    _plugTimer?.cancel();
+    _plugTimer = null;
+  }
+
+  // The pedal answered on this port: the next start and any replug go
+  // straight to it.
+  void _rememberLink() {
+    final port = _link.portName;
+    if (port == null) return;
+    final mem = LinkMemory(
+      port: port,
+      serial: PortProbe.serialOf(port),
+      baudRate: _baudRate,
+    );
+    _memory = mem;
+    mem.save();
+  }
+
+  static Directory get _sessionsDir =>
+      Directory('${Directory.current.path}${Platform.pathSeparator}sessions');
+
+  static String _newSessionPath() {
+    final ts = DateTime.now().toIso8601String().split('.').first;
+    return '${_sessionsDir.path}${Platform.pathSeparator}'
+        'session-${ts.replaceAll(':', '-')}${SessionLog.extension}';
+  }
+
+  // The newest recorded session (not a replay of one).
+  static Future<File?> _lastSession() async {
+    final dir = _sessionsDir;
+    if (!await dir.exists()) return null;
+    File? last;
+    await for (final e in dir.list()) {
+      final name = e.uri.pathSegments.last;
+      if (e is! File ||
+          !name.startsWith('session-') ||
+          !name.endsWith(SessionLog.extension) ||
+          name.endsWith('.replay${SessionLog.extension}')) {
+        continue;
+      }
+      if (last == null || e.path.compareTo(last.path) > 0) last = e;
+    }
+    return last;
+  }
+
+  // Sends the last recorded session to the selected port at its original
+  // timing and reports the round trips of the replay next to the
+  // recording's.
+  Future<void> _replayLastSession() async {
+    final port = _selectedPort;
+    if (port == null || _link.isOpen || _replayBusy) return;
+    final file = await _lastSession();
+    final log = file == null ? null : await SessionLog.read(file);
+    if (!mounted) return;
+    if (file == null || log == null) {
+      setState(() => _lastAction = 'No recorded session to replay');
+      return;
+    }
+    final name = file.uri.pathSegments.last;
+    setState(() {
+      _replayBusy = true;
+      _lastAction = 'Replaying $name...';
+    });
+    String result;
+    try {
+      final replay = await SessionReplay.run(
+        log: log,
+        portName: port,
+        baudRate: _baudRate,
+        recordPath: file.path.replaceFirst(
+          RegExp(r'\.dsl$'),
+          '.replay${SessionLog.extension}',
+        ),
+      );
+      final recorded = log.analyze();
+      result = replay == null
+          ? 'Replay of $name not recorded; recorded RTT $recorded'
+          : 'Replay RTT ${replay.analyze()}; recorded $recorded';
+    } catch (e) {
+      result = 'Replay failed: $e';
+    }
+    dlogState(() => result);
+    if (!mounted) return;
+    setState(() {
+      _replayBusy = false;
+      _lastAction = result;
+    });
+  }
+
+  void _onLine(LineEvent event) {
+    final line = event.line;
+    final seq = event.seq;
+    _rxBytes = line.length + 1 + (seq == null ? 0 : '#$seq '.length);
+    setState(() {
+      _lastRxAt = DateTime.now();
+      _lastDeviceLine = line;
+
+      dlogRx(() => line);
+
+      // Basic device handshake: the serial port can be open even if the DSP
+      // is not ready to accept commands yet.
+      if (line == 'READY' || line == 'PONG' || line.startsWith('OK PING')) {
+        _deviceReady = true;
+        _lastAction = 'Device ready';
+
+        dlogState(() => 'device ready (line=$line)');
+
+        if (!_initialSyncDone) {
+          _initialSyncDone = true;
+          StartupClock.mark(StartupClock.pedalReady);
+          _readyWaiter?.complete();
+          _readyWaiter = null;
+          _rememberLink();
+          _syncVer = 0;
+          _paramVer = 0;
+          _paramVerSeen = 0;
+          _adoptPending = true;
+          // Changes are pushed from here on; STATUS brings the pedal's
+          // state, which the knobs and switches then show.
+          _link.sendLine('EVT ON');
+          _link.sendLine('STATUS');
+          _link.sendLine('CAPS');
+          _link.sendLine('PBANK');
+          _meterSubHz = null;
+          _syncMeterSub();
+        }
+      }
+
+      final caps = DeviceCaps.tryParse(line);
+      if (caps != null) {
+        _caps = caps;
+        dlogState(
+          () => 'caps fw=${caps.firmware} proto=${caps.protocol} '
+              'feat=${caps.features.join(',')}',
+        );
+        if (caps.has('quiet')) {
+          // Knob sweeps then get one QACK per few commands, not an echo
+          // per PSETM.
+          _link.sendLine('QUIET ON');
+        }
+        if (caps.paramHash == _paramDescsHash &&
+            caps.params == _paramDescs.length) {
+          dlogState(() => 'param table unchanged, PLIST skipped');
+        } else {
+          _paramDescs.clear();
+          _paramDescsHash = null;
+          _link.sendLine('PLIST');
+        }
+      }
+      if (line == 'ERR UNKNOWN cmd=CAPS') {
+        // Firmware from before CAPS: fetch everything.
+        _caps = null;
+        _paramDescs.clear();
+        _paramDescsHash = null;
+        _link.sendLine('PLIST');
+      }
+
+      final bank = PresetBankLayout.tryParse(line);
+      if (bank != null) _bankLayout = bank;
+
+      if (event is ParamEvent) {
+        final desc = event.desc;
+        _paramDescs[desc.name] = desc;
+        dlogState(() => 'param ${desc.name} ${desc.min}..${desc.max}');
+      }
+
+      if (line.startsWith('OK PLIST')) {
+        // The firmware stops when its TX ring is full; fetch the rest.
+        final next = int.tryParse(
+          RegExp(r'next=(\d+)').firstMatch(line)?.group(1) ?? '',
+        );
+        final count = int.tryParse(
+          RegExp(r'count=(\d+)').firstMatch(line)?.group(1) ?? '',
+        );
+        if (next != null && count != null && next < count) {
+          _link.sendLine('PLIST $next');
+        } else if (count != null && count == _paramDescs.length) {
+          _paramDescsHash = _caps?.paramHash;
+        }
+      }
+
+      if (event is StatusEvent) {
+        // Fields decoded by the reader isolate (all of them or, for EVT and
+        // STATUS <since>, the changed ones):
+        // STATUS V=<ver> P=<pver> FXMASK=<n> dist_drive_q8=<n> ...
+        for (final MapEntry(:key, value: val) in event.values.entries) {
+          if (key == 'V') {
+            // Lines arrive in firmware order, so the latest V is the
+            // current one (lower after a device restart, whose STATUS
+            // reply is then a full one).
+            _syncVer = val;
+          } else if (key == 'P') {
+            _paramVer = val;
+            if (val > _paramVerSeen) _paramVerSeen = val;
+          } else if (key == 'FXMASK') {
+            _lastAppliedFxMask = val;
+          } else {
+            _lastAppliedParams[key] = val;
+          }
+        }
+
+        if (_adoptPending && event is! ChangeEvent) _adoptDeviceState();
+
+        if (event is ChangeEvent) {
+          _requestPump();
+        } else if (_completeCmd(seq, _PendingCmdType.status) != null) {
+          dlogState(
+            () =>
+                'STATUS sync applied fx=$_lastAppliedFxMask dist=${_lastAppliedParams['dist_drive_q8']}',
+          );
+          _requestPump();
+        }
+      }
+
+      if (line.startsWith('QACK ') || line.startsWith('OK ')) {
+        _notePver(line);
+      }
+
+      if (line.startsWith('LAT ') && _latency.onReport(line)) {
+        dlogState(() => 'latency $_latency');
+      }
+
+      if (line.startsWith('QACK ')) {
+        final qseq = int.tryParse(line.split(RegExp(r'\s+'))[1]);
+        if (qseq != null) _completeQuiet(qseq);
+      }
+
+      // "See if effect is changed or not": confirm FXMASK ack.
+      if (line.startsWith('OK FXMASK')) {
+        final parts = line.split(RegExp(r'\s+'));
+        if (parts.length >= 3) {
+          final n = int.tryParse(parts[2]);
+          _completeCmd(seq, _PendingCmdType.fxmask);
+          if (n != null) {
+            _lastAppliedFxMask = n;
+            _lastAction = 'Effect applied (FXMASK=$n)';
+            dlogState(() => 'ack FXMASK=$n');
+          }
+          _requestPump();
+        }
+      }
+
+      if (line.startsWith('ERR FXMASK')) {
+        _completeCmd(seq, _PendingCmdType.fxmask);
+        _lastAction = 'FXMASK rejected by device';
+        dlogState(() => 'ERR FXMASK');
+        _requestStatusSync(reason: 'fxmask-err', ifBehind: true);
+      }
+
+      if (line.startsWith('OK PSETM')) {
+        _completeCmd(seq, _PendingCmdType.pset);
+        var applied = 0;
+        for (final pair in line.split(RegExp(r'\s+')).skip(2)) {
+          final eq = pair.indexOf('=');
+          if (eq <= 0) continue;
+          final v = int.tryParse(pair.substring(eq + 1));
+          if (v == null) continue;
+          final pname = pair.substring(0, eq);
+          if (pname == 'P') continue;
+          _lastAppliedParams[pname] = v;
+          _psetAttempts.remove(pname);
+          applied++;
+        }
+        _lastAction = 'Params applied ($applied)';
+        dlogState(() => 'ack PSETM ($applied params)');
+        _requestPump();
+      } else if (line.startsWith('OK PSET')) {
+        final parts = line.split(RegExp(r'\s+'));
+        if (parts.length >= 4) {
+          final pname = parts[2];
+          final v = int.tryParse(parts[3]);
+          _completeCmd(seq, _PendingCmdType.pset);
+          if (v != null) {
+            _lastAppliedParams[pname] = v;
+            _psetAttempts.remove(pname);
+            _lastAction = 'Param applied ($pname=$v)';
+            dlogState(() => 'ack PSET $pname=$v');
+          } else {
+            _lastAction = 'Param applied ($pname=???)';
+            dlogState(() => 'ack PSET $pname=???');
+          }
+          _requestPump();
+        }
+      }
+
+      if (line.startsWith('ERR PSET')) {
+        // Firmware doesn't tell which param failed.
+        _completeCmd(seq, _PendingCmdType.pset);
+        _lastAction = 'PSET rejected by device';
+        dlogState(() => 'ERR PSET ($line)');
+        _requestStatusSync(reason: 'pset-err', ifBehind: true);
+      }
+
+      if (line.startsWith('ERR UNKNOWN') && line != 'ERR UNKNOWN cmd=CAPS') {
+        // Treat as immediate failure of whatever was in-flight; this is
+        // usually command corruption / dropped bytes.
+        final hadPending = _completeCmd(seq) != null;
+        _lastAction = 'Device parse error';
+        dlogState(() => 'ERR UNKNOWN ($line) pending=$hadPending');
+        _requestStatusSync(reason: 'unknown-err');
+      }
+    });
+  }
+
   void _applyFxMask(int mask) {
     if (!_link.isOpen || !_deviceReady) {
       setState(() => _lastAction = 'Not ready: connect to device first');
@@ -473,15 +993,129 @@ class _HomePageState extends State<HomePage> {
     _setDesiredFxMask(mask);
   }
 
-  void _pushAllParams() {
-    if (!_link.isOpen || !_deviceReady) return;
-    _setDesiredParam('dist_drive_q8', _presets.distDriveQ8);
-    _setDesiredParam('gain_q15', _presets.gainQ15);
-    _setDesiredParam('delay_mix_q15', _presets.delayMixQ15);
-    _setDesiredParam('delay_feedback_q15', _presets.delayFeedbackQ15);
-    _setDesiredParam('reverb_mix_q15', _presets.reverbMixQ15);
-    _setDesiredParam('reverb_feedback_q15', _presets.reverbFeedbackQ15);
-    _setDesiredParam('reverb_damp_q15', _presets.reverbDampQ15);
+  // Takes over what the pedal plays: the switches and knobs follow the
+  // first STATUS after connect, and nothing queued from before goes out.
+  void _adoptDeviceState() {
+    _adoptPending = false;
+    StartupClock.mark(StartupClock.stateShown);
+    final mask = _lastAppliedFxMask;
+    _dist = (mask & (1 << 0)) != 0;
+    _rev = (mask & (1 << 1)) != 0;
+    _del = (mask & (1 << 2)) != 0;
+    _cho = (mask & (1 << 3)) != 0;
+    _desiredFxMask = mask;
+    _desiredParams.clear();
+    _psetAttempts.clear();
+    int? v(String name) => _lastAppliedParams[name];
+    _presets
+      ..distDriveQ8 = v('dist_drive_q8') ?? _presets.distDriveQ8
+      ..gainQ15 = v('gain_q15') ?? _presets.gainQ15
+      ..delayMixQ15 = v('delay_mix_q15') ?? _presets.delayMixQ15
+      ..delayFeedbackQ15 = v('delay_feedback_q15') ?? _presets.delayFeedbackQ15
+      ..reverbMixQ15 = v('reverb_mix_q15') ?? _presets.reverbMixQ15
+      ..reverbFeedbackQ15 =
+          v('reverb_feedback_q15') ?? _presets.reverbFeedbackQ15
+      ..reverbDampQ15 = v('reverb_damp_q15') ?? _presets.reverbDampQ15;
+    _lastAction = 'Synced with pedal';
+    dlogState(() => 'adopted pedal state fx=$mask');
+  }
+
+  Map<int, ParamDesc> _descsById() => {
+    for (final d in _paramDescs.values) d.id: d,
+  };
+
+  int _bankStoredCount() {
+    final layout = _bankLayout;
+    if (layout == null) return 0;
+    var n = 0;
+    for (var slot = 0; slot < layout.slots; slot++) {
+      if (layout.isStored(slot)) n++;
+    }
+    return n;
+  }
+
+  // Copies every stored pedal slot into the library: over the preset its
+  // setlist entry names, else into a new one.
+  Future<void> _pullBank() async {
+    final lib = _library;
+    final layout = _bankLayout;
+    if (lib == null || layout == null || _bankBusy) return;
+    setState(() => _bankBusy = true);
+    final sw = Stopwatch()..start();
+    try {
+      final slots = await _bank.download(layout, _descsById());
+      for (final MapEntry(key: slot, value: file) in slots.entries) {
+        final id = slot < lib.bank.length ? lib.bank[slot] : null;
+        final name =
+            (id != null ? lib.entry(id)?.name : null) ??
+            'Pedal slot ${slot + 1}';
+        final saved = await lib.save(name, file.data, id: id, file: file);
+        if (saved != id) await lib.assign(slot, saved);
+      }
+      _bankStatus =
+          'Pulled ${slots.length} presets in ${sw.elapsedMilliseconds} ms';
+    } catch (e) {
+      _bankStatus = 'Pull failed: $e';
+    }
+    if (!mounted) return;
+    setState(() => _bankBusy = false);
+  }
+
+  // Writes the setlist to the pedal bank, slot by slot.
+  Future<void> _pushBank() async {
+    final lib = _library;
+    final layout = _bankLayout;
+    if (lib == null || layout == null || _bankBusy) return;
+    setState(() => _bankBusy = true);
+    final sw = Stopwatch()..start();
+    try {
+      final slots = <int, PresetFile>{};
+      final setlist = lib.bank.take(layout.slots).toList();
+      for (var slot = 0; slot < setlist.length; slot++) {
+        final id = setlist[slot];
+        final file = id == null ? null : await lib.loadFile(id);
+        if (file != null) slots[slot] = file;
+      }
+      await _bank.upload(layout, _descsById(), slots);
+      _bankStatus =
+          'Pushed ${slots.length} presets in ${sw.elapsedMilliseconds} ms';
+    } catch (e) {
+      _bankStatus = 'Push failed: $e';
+    }
+    _link.sendLine('PBANK');
+    if (!mounted) return;
+    setState(() => _bankBusy = false);
+  }
+
+  // Renders clips/di.wav (next to the working directory) through the
+  // current settings with the firmware chain built for the desktop, and
+  // hands the result to the system player.
+  Future<void> _previewCurrent() async {
+    final sep = Platform.pathSeparator;
+    final dir = Directory.current.path;
+    final out = '$dir${sep}previews${sep}current.wav';
+    final data = PresetData(
+      fxMask: _lastAppliedFxMask,
+      params: Map.of(_lastAppliedParams),
+      taps: const [],
+    );
+    try {
+      final speed = await renderPreviewFile(
+        data,
+        '$dir${sep}clips${sep}di.wav',
+        out,
+      );
+      _bankStatus = 'Preview ${speed.toStringAsFixed(0)}x real time: $out';
+      if (Platform.isWindows) {
+        await Process.start('cmd', ['/c', 'start', '', out]);
+      } else {
+        await Process.start('xdg-open', [out]);
+      }
+    } catch (e) {
+      _bankStatus = 'Preview failed: $e';
+    }
+    if (!mounted) return;
+    setState(() {});
   }
 
   Future<void> _persistPresets() async {
@@ -512,6 +1146,8 @@ class _HomePageState extends State<HomePage> {
     // BALANCE         -> reverb_feedback_q15
     // FILTER          -> reverb_damp_q15
 
+    // The knobs show their own value while turned, so a turn does not
+    // rebuild the page; the next rebuild hands them the same values.
     return PedalSection(
       ready: ready,
       pedalBgAsset: _kPedalBgAsset,
@@ -523,69 +1159,55 @@ class _HomePageState extends State<HomePage> {
       balancePct: _q15ToPct(_presets.reverbFeedbackQ15),
       filterPct: _q15ToPct(_presets.reverbDampQ15),
       onTimeChanged: (pct) {
-        setState(() => _presets.delayMixQ15 = _pctToQ15(pct));
-        _paramDebounce.run(() {
-          _persistPresets();
-          if (ready) {
-            _setDesiredParam('delay_mix_q15', _presets.delayMixQ15);
-          }
-        });
+        _presets.delayMixQ15 = _pctToQ15(pct);
+        if (ready) {
+          _setDesiredParam('delay_mix_q15', _presets.delayMixQ15);
+        }
+        _paramDebounce.run(_persistPresets);
       },
       onMixChanged: (pct) {
-        setState(() => _presets.reverbMixQ15 = _pctToQ15(pct));
-        _paramDebounce.run(() {
-          _persistPresets();
-          if (ready) {
-            _setDesiredParam('reverb_mix_q15', _presets.reverbMixQ15);
-          }
-        });
+        _presets.reverbMixQ15 = _pctToQ15(pct);
+        if (ready) {
+          _setDesiredParam('reverb_mix_q15', _presets.reverbMixQ15);
+        }
+        _paramDebounce.run(_persistPresets);
       },
       onFeedbackChanged: (pct) {
-        setState(() => _presets.delayFeedbackQ15 = _pctToQ15(pct));
-        _paramDebounce.run(() {
-          _persistPresets();
-          if (ready) {
-            _setDesiredParam('delay_feedback_q15', _presets.delayFeedbackQ15);
-          }
-        });
+        _presets.delayFeedbackQ15 = _pctToQ15(pct);
+        if (ready) {
+          _setDesiredParam('delay_feedback_q15', _presets.delayFeedbackQ15);
+        }
+        _paramDebounce.run(_persistPresets);
       },
       onOffssetChanged: (pct) {
-        setState(() => _presets.distDriveQ8 = _pctToDrive(pct));
-        _paramDebounce.run(() {
-          _persistPresets();
-          if (ready) {
-            _setDesiredParam('dist_drive_q8', _presets.distDriveQ8);
-          }
-        });
+        _presets.distDriveQ8 = _pctToDrive(pct);
+        if (ready) {
+          _setDesiredParam('dist_drive_q8', _presets.distDriveQ8);
+        }
+        _paramDebounce.run(_persistPresets);
       },
       onBalanceChanged: (pct) {
-        setState(() => _presets.reverbFeedbackQ15 = _pctToQ15(pct));
-        _paramDebounce.run(() {
-          _persistPresets();
-          if (ready) {
-            _setDesiredParam('reverb_feedback_q15', _presets.reverbFeedbackQ15);
-          }
-        });
+        _presets.reverbFeedbackQ15 = _pctToQ15(pct);
+        if (ready) {
+          _setDesiredParam('reverb_feedback_q15', _presets.reverbFeedbackQ15);
+        }
+        _paramDebounce.run(_persistPresets);
       },
       onFilterChanged: (pct) {
-        setState(() => _presets.reverbDampQ15 = _pctToQ15(pct));
-        _paramDebounce.run(() {
-          _persistPresets();
-          if (ready) {
-            _setDesiredParam('reverb_damp_q15', _presets.reverbDampQ15);
-          }
-        });
+        _presets.reverbDampQ15 = _pctToQ15(pct);
+        if (ready) {
+          _setDesiredParam('reverb_damp_q15', _presets.reverbDampQ15);
+        }
+        _paramDebounce.run(_persistPresets);
       },
       volumePct: _gainToPct(_presets.gainQ15),
       volumeMaxPct: 200,
       onVolumeChanged: (pct) {
-        setState(() => _presets.gainQ15 = _pctToGain(pct));
-        _paramDebounce.run(() {
-          _persistPresets();
-          if (ready) {
-            _setDesiredParam('gain_q15', _presets.gainQ15);
-          }
-        });
+        _presets.gainQ15 = _pctToGain(pct);
+        if (ready) {
+          _setDesiredParam('gain_q15', _presets.gainQ15);
+        }
+        _paramDebounce.run(_persistPresets);
       },
       distortion: _dist,
       reverb: _rev,
@@ -614,6 +1236,43 @@ class _HomePageState extends State<HomePage> {
       appBar: AppBar(
         toolbarHeight: 48,
         actions: [
+          IconButton(
+            tooltip: 'Link benchmark',
+            icon: const Icon(Icons.speed),
+            // The benchmark opens the port itself.
+            onPressed: connected || _replayBusy || _selectedPort == null
+                ? null
+                : () => Navigator.of(context).push(
+                    MaterialPageRoute<void>(
+                      builder: (_) => BenchPage(
+                        portName: _selectedPort!,
+                        baudRate: _baudRate,
+                        baudRates: _baudRates,
+                      ),
+                    ),
+                  ),
+          ),
+          IconButton(
+            tooltip: 'Fleet',
+            icon: const Icon(Icons.hub),
+            // The fleet opens every port it finds; the plug watch would
+            // race it for the remembered one.
+            onPressed: connected || _replayBusy
+                ? null
+                : () {
+                    _stopPlugWatch();
+                    Navigator.of(context)
+                        .push(
+                          MaterialPageRoute<void>(
+                            builder: (_) => FleetPage(
+                              bauds: {_baudRate, 115200}.toList(),
+                              library: _library,
+                            ),
+                          ),
+                        )
+                        .then((_) => _startPlugWatch());
+                  },
+          ),
           IconButton(
             tooltip: 'Connection',
             icon: const Icon(Icons.settings_input_antenna),
@@ -689,6 +1348,21 @@ class _HomePageState extends State<HomePage> {
                                 },
                                 connected: connected,
                                 ready: ready,
+                                record: _recordSession,
+                                onRecordChanged: (v) {
+                                  setState(() => _recordSession = v);
+                                  setSheetState(() {});
+                                },
+                                onReplayPressed: connected || _replayBusy
+                                    ? null
+                                    : () async {
+                                        await _replayLastSession();
+                                        setSheetState(() {});
+                                      },
+                                onFindPressed: () async {
+                                  await _autoConnect(any: true);
+                                  setSheetState(() {});
+                                },
                                 onConnectPressed: () async {
                                   try {
                                     await _connectOrDisconnect();
@@ -708,6 +1382,41 @@ class _HomePageState extends State<HomePage> {
                                 ),
                               if (_lastDeviceLine.isNotEmpty)
                                 Text('Device: $_lastDeviceLine'),
+                              if (ready) Text('Link: $_rate'),
+                              if (ready && _latency.count > 0)
+                                Text('Control: $_latency'),
+                              const SizedBox(height: 16),
+                              LibrarySection(
+                                presetCount: _library?.entries.length ?? 0,
+                                setlistCount:
+                                    _library?.bank
+                                        .where((id) => id != null)
+                                        .length ??
+                                    0,
+                                bankSlots: _bankLayout?.slots ?? 0,
+                                bankStored: _bankStoredCount(),
+                                enabled:
+                                    ready &&
+                                    !_bankBusy &&
+                                    _library != null &&
+                                    _bankLayout != null,
+                                status: _bankStatus,
+                                onPullPressed: () async {
+                                  await _pullBank();
+                                  setSheetState(() {});
+                                },
+                                onPushPressed: () async {
+                                  await _pushBank();
+                                  setSheetState(() {});
+                                },
+                                onPreviewPressed:
+                                    Platform.isLinux || Platform.isWindows
+                                    ? () async {
+                                        await _previewCurrent();
+                                        setSheetState(() {});
+                                      }
+                                    : null,
+                              ),
                             ],
                           ),
                         );
@@ -722,7 +1431,7 @@ class _HomePageState extends State<HomePage> {
       ),
       body: LayoutBuilder(
         builder: (context, c) {
-          return Padding(
+          final pedal = Padding(
             padding: const EdgeInsets.all(16),
             child: Center(
               child: Container(
@@ -751,6 +1460,25 @@ class _HomePageState extends State<HomePage> {
               ),
             ),
           );
+          if (!ready) return pedal;
+          return Column(
+            children: [
+              Expanded(child: pedal),
+              if (_hasChorus)
+                FilterChip(
+                  label: const Text('Chorus'),
+                  selected: _cho,
+                  onSelected: (v) {
+                    setState(() => _cho = v);
+                    _applyFxMask(_fxMask());
+                  },
+                ),
+              Padding(
+                padding: const EdgeInsets.fromLTRB(16, 0, 16, 16),
+                child: MeterSection(frame: _meter),
+              ),
+            ],
+          );
         },
       ),
     );
@@ -762,16 +1490,20 @@ enum _PendingCmdType { fxmask, pset, status }
 class _PendingCmd {
   final _PendingCmdType type;
   final int? fxMask;
-  final String? param;
-  final int? value;
+  final Map<String, int>? params;
+  // Ack timeout, running while the command is in flight.
+  Timer? timer;
+  // Since it went out, and its length with the tag, for LinkRate.
+  final Stopwatch sent = Stopwatch();
+  int txBytes = 0;
 
-  _PendingCmd._({required this.type, this.fxMask, this.param, this.value});
+  _PendingCmd._({required this.type, this.fxMask, this.params});
 
   factory _PendingCmd.fxmask(int mask) =>
       _PendingCmd._(type: _PendingCmdType.fxmask, fxMask: mask);
 
-  factory _PendingCmd.pset(String param, int value) =>
-      _PendingCmd._(type: _PendingCmdType.pset, param: param, value: value);
+  factory _PendingCmd.pset(Map<String, int> params) =>
+      _PendingCmd._(type: _PendingCmdType.pset, params: params);
 
   factory _PendingCmd.status() => _PendingCmd._(type: _PendingCmdType.status);
 }
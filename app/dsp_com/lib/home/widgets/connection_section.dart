@@ -14,6 +14,16 @@ class ConnectionSection extends StatelessWidget {
 
   final VoidCallback onConnectPressed;
 
+  /// Probes the ports for the pedal and connects to it; no Find button
+  /// without it.
+  final VoidCallback? onFindPressed;
+
+  /// Record the next connection to a session log; replay the last one
+  /// (disabled when null). No session row without [onRecordChanged].
+  final bool record;
+  final ValueChanged<bool>? onRecordChanged;
+  final VoidCallback? onReplayPressed;
+
   const ConnectionSection({
     super.key,
     required this.ports,
@@ -25,6 +35,10 @@ class ConnectionSection extends StatelessWidget {
     required this.connected,
     required this.ready,
     required this.onConnectPressed,
+    this.onFindPressed,
+    this.record = false,
+    this.onRecordChanged,
+    this.onReplayPressed,
   });
 
   @override
@@ -66,13 +80,36 @@ class ConnectionSection extends StatelessWidget {
               ),
             ),
             const SizedBox(width: 12),
+            if (onFindPressed case final onFind?) ...[
+              OutlinedButton(
+                onPressed: connected ? null : onFind,
+                child: const Text('Find'),
+              ),
+              const SizedBox(width: 12),
+            ],
             FilledButton(
               onPressed: onConnectPressed,
               child: Text(connected ? 'Disconnect' : 'Connect'),
             ),
           ],
         ),
-        const SizedBox(height: 10),
+        const SizedBox(height: 4),
+        if (onRecordChanged case final onRecord?)
+          Row(
+            children: [
+              Checkbox(
+                value: record,
+                onChanged: connected ? null : (v) => onRecord(v ?? false),
+              ),
+              const Text('Record session'),
+              const Spacer(),
+              TextButton(
+                onPressed: onReplayPressed,
+                child: const Text('Replay last session'),
+              ),
+            ],
+          ),
+        const SizedBox(height: 4),
         Text(
           'Status: ${ready
               ? 'Connected'
@@ -1,8 +1,16 @@
 import 'dart:math' as math;
+import 'dart:ui' as ui;
 
 import 'package:flutter/gestures.dart';
 import 'package:flutter/material.dart';
+import 'package:flutter/scheduler.dart';
 
+import '../../serial/control_latency.dart';
+
+/// A knob turned by a vertical drag or the mouse wheel. Many are on the
+/// pedal page at once, so a turn costs no rebuild: the value lives in a
+/// notifier, steps are applied once per frame (and [onChanged] called
+/// then), and only the indicator's transform changes.
 class ImageKnob extends StatefulWidget {
   final String assetPath;
   final double size;
@@ -30,44 +38,66 @@ class ImageKnob extends StatefulWidget {
 }
 
 class _ImageKnobState extends State<ImageKnob> {
-  late double _value;
+  // The value the knob shows; a drag step changes it without a rebuild.
+  late final ValueNotifier<double> _value = ValueNotifier(widget.valuePct);
   bool _isDragging = false;
-
-  @override
-  void initState() {
-    super.initState();
-    _value = widget.valuePct;
-  }
+  // Drag and wheel steps since the last frame, applied once per frame.
+  double _pendingDy = 0;
+  bool _frameScheduled = false;
 
   @override
   void didUpdateWidget(covariant ImageKnob oldWidget) {
     super.didUpdateWidget(oldWidget);
     if (!_isDragging && oldWidget.valuePct != widget.valuePct) {
-      _value = widget.valuePct;
+      _value.value = widget.valuePct;
     }
   }
 
-  void _setValue(double next) {
-    final clamped = next.clamp(widget.minPct, widget.maxPct);
-    if (clamped == _value) return;
-    setState(() => _value = clamped);
-    widget.onChanged(_value);
+  @override
+  void dispose() {
+    _value.dispose();
+    super.dispose();
   }
 
   void _applyDeltaDy(double dy) {
-    _setValue(_value + (-dy) * widget.dragSensitivity);
+    _pendingDy += dy;
+    if (_frameScheduled) return;
+    _frameScheduled = true;
+    ControlLatency.markInput();
+    SchedulerBinding.instance.scheduleFrameCallback((_) {
+      _frameScheduled = false;
+      if (!mounted) return;
+      final dy = _pendingDy;
+      _pendingDy = 0;
+      final next = (_value.value + (-dy) * widget.dragSensitivity).clamp(
+        widget.minPct,
+        widget.maxPct,
+      );
+      if (next == _value.value) {
+        ControlLatency.takeInput();
+        return;
+      }
+      _value.value = next;
+      widget.onChanged(next);
+    });
   }
 
-  @override
-  Widget build(BuildContext context) {
+  double _angle(double value) {
     final range = (widget.maxPct - widget.minPct);
     final t = range <= 0
         ? 0.0
-        : ((_value - widget.minPct) / range).clamp(0.0, 1.0);
+        : ((value - widget.minPct) / range).clamp(0.0, 1.0);
+    return (t - 0.5) * widget.maxRotationDeg * math.pi / 180.0;
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final size = widget.size;
+    final face = _KnobFace.of(size, MediaQuery.devicePixelRatioOf(context));
 
     return SizedBox(
-      width: widget.size,
-      height: widget.size,
+      width: size,
+      height: size,
       child: Listener(
         behavior: HitTestBehavior.opaque,
         onPointerSignal: (signal) {
@@ -77,15 +107,38 @@ class _ImageKnobState extends State<ImageKnob> {
         },
         child: GestureDetector(
           behavior: HitTestBehavior.opaque,
-          onPanStart: (_) => setState(() => _isDragging = true),
-          onPanEnd: (_) => setState(() => _isDragging = false),
-          onPanCancel: () => setState(() => _isDragging = false),
+          onPanStart: (_) => _isDragging = true,
+          onPanEnd: (_) => _isDragging = false,
+          onPanCancel: () => _isDragging = false,
           onPanUpdate: (details) => _applyDeltaDy(details.delta.dy),
-          child: CustomPaint(
-            size: Size(widget.size, widget.size),
-            painter: _AggressiveKnobPainter(
-              value: t,
-              maxRotationDeg: widget.maxRotationDeg,
+          // The face is a picture rastered once per size; a turn only
+          // moves the indicator's layer, repainting nothing past this
+          // boundary.
+          child: RepaintBoundary(
+            child: Stack(
+              clipBehavior: Clip.none,
+              children: [
+                Positioned(
+                  left: -_KnobFace.pad,
+                  top: -_KnobFace.pad,
+                  child: RawImage(
+                    image: face,
+                    width: size + 2 * _KnobFace.pad,
+                    height: size + 2 * _KnobFace.pad,
+                  ),
+                ),
+                ValueListenableBuilder<double>(
+                  valueListenable: _value,
+                  builder: (context, value, child) =>
+                      Transform.rotate(angle: _angle(value), child: child),
+                  child: RepaintBoundary(
+                    child: CustomPaint(
+                      size: Size(size, size),
+                      painter: const _IndicatorPainter(),
+                    ),
+                  ),
+                ),
+              ],
             ),
           ),
         ),
@@ -94,89 +147,105 @@ class _ImageKnobState extends State<ImageKnob> {
   }
 }
 
-class _AggressiveKnobPainter extends CustomPainter {
-  final double value;
-  final double maxRotationDeg;
+/// The knob without its indicator, rastered at the device pixel size the
+/// first time a knob of that size is built and shared by all of them.
+/// [pad] leaves room for the drop shadow around the knob.
+class _KnobFace {
+  static const double pad = 16;
+  static final Map<(double, double), ui.Image> _cache = {};
+
+  static ui.Image of(double size, double dpr) =>
+      _cache.putIfAbsent((size, dpr), () {
+        final full = size + 2 * pad;
+        final recorder = ui.PictureRecorder();
+        final canvas = Canvas(recorder)
+          ..scale(dpr)
+          ..translate(pad, pad);
+        _paintFace(canvas, Size(size, size));
+        final picture = recorder.endRecording();
+        final image = picture.toImageSync(
+          (full * dpr).ceil(),
+          (full * dpr).ceil(),
+        );
+        picture.dispose();
+        return image;
+      });
+}
+
+void _paintFace(Canvas canvas, Size size) {
+  final center = Offset(size.width / 2, size.height / 2);
+  final radius = size.width / 2;
+
+  // Outer shadow for depth
+  final shadowPaint = Paint()
+    // ignore: deprecated_member_use
+    ..color = Colors.black.withOpacity(0.5)
+    ..maskFilter = const MaskFilter.blur(BlurStyle.normal, 8);
+  canvas.drawCircle(center + const Offset(2, 4), radius * 0.88, shadowPaint);
+
+  // Main knob body - sleek matte black
+  final knobPaint = Paint()
+    ..shader = RadialGradient(
+      center: const Alignment(-0.25, -0.35),
+      colors: [
+        const Color(0xFF404040),
+        const Color(0xFF2A2A2A),
+        const Color(0xFF1C1C1C),
+      ],
+      stops: const [0.0, 0.5, 1.0],
+    ).createShader(Rect.fromCircle(center: center, radius: radius));
+  canvas.drawCircle(center, radius * 0.88, knobPaint);
+
+  // Subtle rim highlight
+  final rimPaint = Paint()
+    ..style = PaintingStyle.stroke
+    ..strokeWidth = 1.0
+    ..shader = SweepGradient(
+      startAngle: -math.pi / 3,
+      colors: [
+        // ignore: deprecated_member_use
+        Colors.white.withOpacity(0.15),
+        Colors.transparent,
+        Colors.transparent,
+        // ignore: deprecated_member_use
+        Colors.white.withOpacity(0.08),
+      ],
+      stops: const [0.0, 0.25, 0.75, 1.0],
+    ).createShader(Rect.fromCircle(center: center, radius: radius * 0.88));
+  canvas.drawCircle(center, radius * 0.87, rimPaint);
+
+  // Tiny center dimple
+  final dimplePaint = Paint()
+    ..shader = RadialGradient(
+      colors: [
+        const Color(0xFF1A1A1A),
+        const Color(0xFF2A2A2A),
+      ],
+    ).createShader(Rect.fromCircle(center: center, radius: radius * 0.1));
+  canvas.drawCircle(center, radius * 0.1, dimplePaint);
+}
 
-  _AggressiveKnobPainter({required this.value, this.maxRotationDeg = 270});
+/// The indicator line pointing straight up; [ImageKnob] turns it.
+class _IndicatorPainter extends CustomPainter {
+  const _IndicatorPainter();
 
   @override
   void paint(Canvas canvas, Size size) {
     final center = Offset(size.width / 2, size.height / 2);
     final radius = size.width / 2;
 
-    // Outer shadow for depth
-    final shadowPaint = Paint()
-      // ignore: deprecated_member_use
-      ..color = Colors.black.withOpacity(0.5)
-      ..maskFilter = const MaskFilter.blur(BlurStyle.normal, 8);
-    canvas.drawCircle(center + const Offset(2, 4), radius * 0.88, shadowPaint);
-
-    // Main knob body - sleek matte black
-    final knobPaint = Paint()
-      ..shader = RadialGradient(
-        center: const Alignment(-0.25, -0.35),
-        colors: [
-          const Color(0xFF404040),
-          const Color(0xFF2A2A2A),
-          const Color(0xFF1C1C1C),
-        ],
-        stops: const [0.0, 0.5, 1.0],
-      ).createShader(Rect.fromCircle(center: center, radius: radius));
-    canvas.drawCircle(center, radius * 0.88, knobPaint);
-
-    // Subtle rim highlight
-    final rimPaint = Paint()
-      ..style = PaintingStyle.stroke
-      ..strokeWidth = 1.0
-      ..shader = SweepGradient(
-        startAngle: -math.pi / 3,
-        colors: [
-          // ignore: deprecated_member_use
-          Colors.white.withOpacity(0.15),
-          Colors.transparent,
-          Colors.transparent,
-          // ignore: deprecated_member_use
-          Colors.white.withOpacity(0.08),
-        ],
-        stops: const [0.0, 0.25, 0.75, 1.0],
-      ).createShader(Rect.fromCircle(center: center, radius: radius * 0.88));
-    canvas.drawCircle(center, radius * 0.87, rimPaint);
-
-    // Indicator line position
-    final maxRad = (maxRotationDeg * math.pi) / 180.0;
-    final angle = -math.pi / 2 + (value - 0.5) * maxRad;
-
-    final indicatorStart = center +
-        Offset(
-          math.cos(angle) * (radius * 0.30),
-          math.sin(angle) * (radius * 0.30),
-        );
-    final indicatorEnd = center +
-        Offset(
-          math.cos(angle) * (radius * 0.72),
-          math.sin(angle) * (radius * 0.72),
-        );
-
     // Clean cream indicator line
     final indicatorPaint = Paint()
-      ..color = const Color(0xFFF5F0E6)  // Cream matching artwork
+      ..color = const Color(0xFFF5F0E6) // Cream matching artwork
       ..strokeWidth = 2.5
       ..strokeCap = StrokeCap.round;
-    canvas.drawLine(indicatorStart, indicatorEnd, indicatorPaint);
-
-    // Tiny center dimple
-    final dimplePaint = Paint()
-      ..shader = RadialGradient(
-        colors: [
-          const Color(0xFF1A1A1A),
-          const Color(0xFF2A2A2A),
-        ],
-      ).createShader(Rect.fromCircle(center: center, radius: radius * 0.1));
-    canvas.drawCircle(center, radius * 0.1, dimplePaint);
+    canvas.drawLine(
+      center - Offset(0, radius * 0.30),
+      center - Offset(0, radius * 0.72),
+      indicatorPaint,
+    );
   }
 
   @override
-  bool shouldRepaint(_AggressiveKnobPainter oldDelegate) =>
-      oldDelegate.value != value;
+  bool shouldRepaint(_IndicatorPainter oldDelegate) => false;
 }
@@ -0,0 +1,74 @@
+import 'package:flutter/material.dart';
+
+class LibrarySection extends StatelessWidget {
+  final int presetCount;
+  final int setlistCount;
+  final int bankSlots;
+  final int bankStored;
+
+  final bool enabled;
+  final String status;
+
+  final VoidCallback onPullPressed;
+  final VoidCallback onPushPressed;
+
+  /// Renders the current settings on the desktop (null: not available).
+  final VoidCallback? onPreviewPressed;
+
+  const LibrarySection({
+    super.key,
+    required this.presetCount,
+    required this.setlistCount,
+    required this.bankSlots,
+    required this.bankStored,
+    required this.enabled,
+    required this.status,
+    required this.onPullPressed,
+    required this.onPushPressed,
+    this.onPreviewPressed,
+  });
+
+  @override
+  Widget build(BuildContext context) {
+    return Column(
+      crossAxisAlignment: CrossAxisAlignment.start,
+      children: [
+        const Text(
+          'Preset library',
+          style: TextStyle(fontSize: 18, fontWeight: FontWeight.w600),
+        ),
+        const SizedBox(height: 8),
+        Text(
+          '$presetCount presets, setlist $setlistCount/$bankSlots, '
+          'pedal $bankStored/$bankSlots stored',
+        ),
+        const SizedBox(height: 8),
+        Row(
+          children: [
+            OutlinedButton(
+              onPressed: enabled ? onPullPressed : null,
+              child: const Text('Pull bank'),
+            ),
+            const SizedBox(width: 12),
+            FilledButton(
+              onPressed: enabled && setlistCount > 0 ? onPushPressed : null,
+              child: const Text('Push setlist'),
+            ),
+            if (onPreviewPressed != null) ...[
+              const SizedBox(width: 12),
+              OutlinedButton(
+                onPressed: onPreviewPressed,
+                child: const Text('Preview'),
+              ),
+            ],
+          ],
+        ),
+        if (status.isNotEmpty)
+          Padding(
+            padding: const EdgeInsets.only(top: 8),
+            child: Text(status),
+          ),
+      ],
+    );
+  }
+}
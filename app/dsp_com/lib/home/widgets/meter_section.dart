@@ -0,0 +1,73 @@
+import 'package:flutter/material.dart';
+
+import '../../serial/meter_frame.dart';
+
+/// Peak/RMS bars per tap (dBFS, -60..0) and the dynamics gain reduction.
+class MeterSection extends StatelessWidget {
+  final MeterFrame? frame;
+
+  const MeterSection({super.key, required this.frame});
+
+  static const double _floorDb = -60.0;
+
+  double _frac(double db) => ((db - _floorDb) / -_floorDb).clamp(0.0, 1.0);
+
+  @override
+  Widget build(BuildContext context) {
+    final f = frame;
+    final bars = <Widget>[];
+    for (var t = 0; t < MeterFrame.tapNames.length; t++) {
+      final peakDb = f == null ? _floorDb : MeterFrame.levelDb(f.peak[t]);
+      final rmsDb = f == null ? _floorDb : MeterFrame.levelDb(f.rms[t]);
+      bars.add(
+        Padding(
+          padding: const EdgeInsets.symmetric(vertical: 2),
+          child: Row(
+            children: [
+              SizedBox(width: 52, child: Text(MeterFrame.tapNames[t])),
+              Expanded(
+                child: Stack(
+                  children: [
+                    LinearProgressIndicator(
+                      value: _frac(peakDb),
+                      minHeight: 8,
+                      color: peakDb > -1.0 ? Colors.red : Colors.orange,
+                    ),
+                    LinearProgressIndicator(
+                      value: _frac(rmsDb),
+                      minHeight: 8,
+                      color: Colors.green,
+                      backgroundColor: Colors.transparent,
+                    ),
+                  ],
+                ),
+              ),
+              SizedBox(
+                width: 64,
+                child: Text(
+                  '${peakDb.toStringAsFixed(1)} dB',
+                  textAlign: TextAlign.right,
+                ),
+              ),
+            ],
+          ),
+        ),
+      );
+    }
+
+    final comp = f == null ? 0.0 : MeterFrame.gainDb(f.compGainQ15);
+    final lim = f == null ? 0.0 : MeterFrame.gainDb(f.limiterGainQ15);
+    return Column(
+      crossAxisAlignment: CrossAxisAlignment.start,
+      mainAxisSize: MainAxisSize.min,
+      children: [
+        ...bars,
+        const SizedBox(height: 4),
+        Text(
+          'Comp ${comp.toStringAsFixed(1)} dB   '
+          'Limiter ${lim.toStringAsFixed(1)} dB',
+        ),
+      ],
+    );
+  }
+}
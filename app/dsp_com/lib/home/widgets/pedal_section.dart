@@ -209,6 +209,13 @@ class PedalSection extends StatelessWidget {
           final w = c.maxWidth;
           final h = c.maxHeight;
 
+          // The background is taller than the pedal, so it covers it at
+          // the pedal's width: decoded at that many device pixels rather
+          // than the asset's full 800x2000.
+          final bgWidth = w.isFinite
+              ? (w * MediaQuery.devicePixelRatioOf(context)).round()
+              : null;
+
           final knobSmall = w * 0.24;
           final knobLarge = w * 0.30;
 
@@ -241,6 +248,7 @@ class PedalSection extends StatelessWidget {
                 child: Image.asset(
                   pedalBgAsset,
                   fit: BoxFit.cover,
+                  cacheWidth: bgWidth,
                   errorBuilder: (context, _, _) {
                     return DecoratedBox(
                       decoration: BoxDecoration(
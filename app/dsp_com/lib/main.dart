@@ -1,8 +1,10 @@
 import 'package:flutter/widgets.dart';
 
 import 'app.dart';
+import 'utils/startup_clock.dart';
 
 void main() {
+  StartupClock.start();
   WidgetsFlutterBinding.ensureInitialized();
   runApp(const DspComApp());
 }
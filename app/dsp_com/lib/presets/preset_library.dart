@@ -0,0 +1,279 @@
+import 'dart:convert';
+import 'dart:io';
+
+import 'preset_record.dart';
+
+/// One delay tap as the firmware stores it (DTAP fields).
+class PresetTap {
+  const PresetTap({
+    required this.timeQ12,
+    required this.panQ15,
+    required this.gainQ15,
+  });
+
+  final int timeQ12;
+  final int panQ15;
+  final int gainQ15;
+
+  List<int> toJson() => [timeQ12, panQ15, gainQ15];
+
+  static PresetTap? fromJson(Object? json) {
+    if (json is! List || json.length != 3 || json.any((v) => v is! num)) {
+      return null;
+    }
+    return PresetTap(
+      timeQ12: (json[0] as num).round(),
+      panQ15: (json[1] as num).round(),
+      gainQ15: (json[2] as num).round(),
+    );
+  }
+}
+
+/// A complete pedal preset: what one flash bank slot holds. Params are
+/// keyed by name, so a preset survives firmware builds that renumber them.
+class PresetData {
+  const PresetData({
+    required this.fxMask,
+    required this.params,
+    required this.taps,
+  });
+
+  final int fxMask;
+  final Map<String, int> params;
+  final List<PresetTap> taps;
+
+  Map<String, dynamic> toJson() => {
+    'fx_mask': fxMask,
+    'params': params,
+    'taps': [for (final t in taps) t.toJson()],
+  };
+
+  static PresetData fromJson(Map<String, dynamic> json) {
+    final params = <String, int>{};
+    final p = json['params'];
+    if (p is Map) {
+      for (final MapEntry(:key, :value) in p.entries) {
+        if (key is String && value is num) params[key] = value.round();
+      }
+    }
+    final taps = <PresetTap>[];
+    final t = json['taps'];
+    if (t is List) {
+      for (final e in t) {
+        final tap = PresetTap.fromJson(e);
+        if (tap != null) taps.add(tap);
+      }
+    }
+    final fx = json['fx_mask'];
+    return PresetData(
+      fxMask: fx is num ? fx.round() : 0,
+      params: params,
+      taps: taps,
+    );
+  }
+}
+
+/// Index entry of a library preset; its data is loaded on demand.
+class PresetEntry {
+  const PresetEntry({
+    required this.id,
+    required this.name,
+    required this.updated,
+  });
+
+  final String id;
+  final String name;
+  final DateTime updated;
+
+  Map<String, dynamic> toJson() => {
+    'id': id,
+    'name': name,
+    'updated': updated.toIso8601String(),
+  };
+
+  static PresetEntry? fromJson(Object? json) {
+    if (json is! Map) return null;
+    final id = json['id'];
+    final name = json['name'];
+    if (id is! String || name is! String) return null;
+    return PresetEntry(
+      id: id,
+      name: name,
+      updated:
+          DateTime.tryParse('${json['updated']}') ??
+          DateTime.fromMillisecondsSinceEpoch(0),
+    );
+  }
+}
+
+/// Named presets on disk: `presets/index.json` lists the entries and the
+/// setlist (which preset goes to which pedal bank slot), each preset is its
+/// own `presets/<id>.pst` ([PresetFile], the pedal's binary record plus
+/// the keys it was written with). Opening reads the index only; [load]
+/// reads a preset the first time it is asked for and caches it. Presets
+/// from before the binary files (`<id>.json`) still load and are written
+/// as `.pst` on their next save; [exportJson] writes the JSON form.
+class PresetLibrary {
+  PresetLibrary._(this._dir, this._entries, this._bank);
+
+  final Directory _dir;
+  final List<PresetEntry> _entries;
+  // Preset id per bank slot, null = slot left alone.
+  final List<String?> _bank;
+  final Map<String, PresetFile> _cache = {};
+  int _nextId = 1;
+
+  List<PresetEntry> get entries => List.unmodifiable(_entries);
+  List<String?> get bank => List.unmodifiable(_bank);
+
+  static Future<PresetLibrary> open({Directory? dir}) async {
+    final d =
+        dir ??
+        Directory('${Directory.current.path}${Platform.pathSeparator}presets');
+    final entries = <PresetEntry>[];
+    final bank = <String?>[];
+    try {
+      final f = File('${d.path}${Platform.pathSeparator}index.json');
+      if (await f.exists()) {
+        final obj = jsonDecode(await f.readAsString());
+        if (obj is Map) {
+          final list = obj['presets'];
+          if (list is List) {
+            for (final e in list) {
+              final entry = PresetEntry.fromJson(e);
+              if (entry != null) entries.add(entry);
+            }
+          }
+          final b = obj['bank'];
+          if (b is List) {
+            for (final id in b) {
+              bank.add(id is String ? id : null);
+            }
+          }
+        }
+      }
+    } catch (_) {
+      // A broken index starts an empty library; preset files stay.
+    }
+    final lib = PresetLibrary._(d, entries, bank);
+    for (final e in entries) {
+      final n = int.tryParse(e.id.replaceFirst('p', ''));
+      if (n != null && n >= lib._nextId) lib._nextId = n + 1;
+    }
+    return lib;
+  }
+
+  PresetEntry? entry(String id) {
+    for (final e in _entries) {
+      if (e.id == id) return e;
+    }
+    return null;
+  }
+
+  Future<PresetData?> load(String id) async => (await loadFile(id))?.data;
+
+  Future<PresetFile?> loadFile(String id) async {
+    final cached = _cache[id];
+    if (cached != null) return cached;
+    try {
+      final f = _file(id);
+      if (await f.exists()) {
+        final file = PresetFile.parse(await f.readAsBytes());
+        return file == null ? null : _cache[id] = file;
+      }
+      final obj = jsonDecode(await _jsonFile(id).readAsString());
+      if (obj is! Map<String, dynamic>) return null;
+      final data = PresetData.fromJson(obj);
+      return _cache[id] = PresetFile.build(
+        data,
+        PresetKey.forParams(data.params.keys),
+        data.taps.length,
+      );
+    } catch (_) {
+      return null;
+    }
+  }
+
+  /// Stores [data] as preset [id], or as a new preset when [id] is null.
+  /// [file] is the record as the pedal sent it, kept byte for byte; without
+  /// one every param is stored whole. Returns the id.
+  Future<String> save(
+    String name,
+    PresetData data, {
+    String? id,
+    PresetFile? file,
+  }) async {
+    final pid = id ?? 'p${(_nextId++).toString().padLeft(4, '0')}';
+    final pf =
+        file ??
+        PresetFile.build(
+          data,
+          PresetKey.forParams(data.params.keys),
+          data.taps.length,
+        );
+    await _dir.create(recursive: true);
+    await _file(pid).writeAsBytes(pf.toBytes());
+    try {
+      await _jsonFile(pid).delete();
+    } catch (_) {}
+    _cache[pid] = pf;
+    final entry = PresetEntry(id: pid, name: name, updated: DateTime.now());
+    final i = _entries.indexWhere((e) => e.id == pid);
+    if (i < 0) {
+      _entries.add(entry);
+    } else {
+      _entries[i] = entry;
+    }
+    await _writeIndex();
+    return pid;
+  }
+
+  Future<void> delete(String id) async {
+    _entries.removeWhere((e) => e.id == id);
+    _cache.remove(id);
+    for (var i = 0; i < _bank.length; i++) {
+      if (_bank[i] == id) _bank[i] = null;
+    }
+    for (final f in [_file(id), _jsonFile(id)]) {
+      try {
+        await f.delete();
+      } catch (_) {}
+    }
+    await _writeIndex();
+  }
+
+  /// Writes preset [id] as JSON (`fx_mask`, `params` by name, `taps`).
+  Future<bool> exportJson(String id, File out) async {
+    final data = await load(id);
+    if (data == null) return false;
+    await out.writeAsString(
+      const JsonEncoder.withIndent('  ').convert(data.toJson()),
+    );
+    return true;
+  }
+
+  /// Puts preset [id] (null = none) in bank [slot] of the setlist.
+  Future<void> assign(int slot, String? id) async {
+    while (_bank.length <= slot) {
+      _bank.add(null);
+    }
+    _bank[slot] = id;
+    await _writeIndex();
+  }
+
+  File _file(String id) => File('${_dir.path}${Platform.pathSeparator}$id.pst');
+
+  File _jsonFile(String id) =>
+      File('${_dir.path}${Platform.pathSeparator}$id.json');
+
+  Future<void> _writeIndex() async {
+    await _dir.create(recursive: true);
+    final f = File('${_dir.path}${Platform.pathSeparator}index.json');
+    await f.writeAsString(
+      const JsonEncoder.withIndent('  ').convert({
+        'presets': [for (final e in _entries) e.toJson()],
+        'bank': _bank,
+      }),
+    );
+  }
+}
@@ -0,0 +1,293 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'preset_library.dart';
+
+/// One param as a preset file lays it out: the firmware's PLIST name, min
+/// and max. A range over 65536 values is stored whole (s32), the others as
+/// value - min (u16).
+class PresetKey {
+  const PresetKey(this.name, this.min, this.max, {this.def});
+
+  final String name;
+  final int min;
+  final int max;
+
+  /// Value for a preset that lacks the param (PLIST def).
+  final int? def;
+
+  bool get wide => max - min > 65535;
+
+  /// Keys for presets written without a pedal: every param whole.
+  static List<PresetKey> forParams(Iterable<String> names) => [
+    for (final n in names) PresetKey(n, -0x80000000, 0x7FFFFFFF),
+  ];
+}
+
+/// The preset file of app_preset.h, the pedal's flash record without its
+/// flash header: `PF`, version, section count, param hash, then the FX,
+/// PARAMS and TAPS sections, each `<type> <info> <bytes u16>` and a payload,
+/// and the CRC-32 of it all. The same bytes are PREAD from and PCOMMITted to
+/// the pedal, kept in the retained RAM over a warm restart and stored by the
+/// library ([PresetFile] appends the keys).
+class PresetRecord {
+  static const int magic = 0x4650; // "PF"
+  static const int version = 1;
+
+  static const int _kFx = 1;
+  static const int _kParams = 2;
+  static const int _kTaps = 3;
+
+  /// FNV-1a over each key: name, NUL, min (s32), width (2 or 4). The pedal
+  /// reports its own as PBANK hash=.
+  static int paramHash(List<PresetKey> keys) {
+    var h = 0x811C9DC5;
+    void add(int b) => h = ((h ^ (b & 0xFF)) * 0x01000193) & 0xFFFFFFFF;
+    for (final k in keys) {
+      utf8.encode(k.name).forEach(add);
+      add(0);
+      for (var i = 0; i < 4; i++) {
+        add(k.min >> (8 * i));
+      }
+      add(k.wide ? 4 : 2);
+    }
+    return h;
+  }
+
+  // Padded as the pedal pads it: the params section with its header ends
+  // at 4 mod 8, which keeps its flash record whole double-words.
+  static int _paramBytes(List<PresetKey> keys) {
+    final wide = keys.where((k) => k.wide).length;
+    return ((4 * wide + 2 * (keys.length - wide) + 4 + 7) & ~7) - 4;
+  }
+
+  /// Bytes of a record for [keys] and [taps] (PBANK image=).
+  static int size(List<PresetKey> keys, int taps) =>
+      8 + (4 + 4) + (4 + _paramBytes(keys)) + (4 + 8 * taps) + 4;
+
+  /// [keys] in the firmware's id order; [taps] the tap slots to write.
+  static Uint8List encode(PresetData data, List<PresetKey> keys, int taps) {
+    final wide = keys.where((k) => k.wide).toList();
+    final narrow = keys.where((k) => !k.wide).toList();
+    final paramBytes = _paramBytes(keys);
+    final b = ByteData(size(keys, taps));
+    b.setUint16(0, magic, Endian.little);
+    b.setUint8(2, version);
+    b.setUint8(3, 3);
+    b.setUint32(4, paramHash(keys), Endian.little);
+
+    var o = 8;
+    o = _section(b, o, _kFx, 0, 4);
+    b.setUint32(o, data.fxMask, Endian.little);
+    o += 4;
+
+    o = _section(b, o, _kParams, wide.length, paramBytes);
+    final end = o + paramBytes;
+    int value(PresetKey k) => data.params[k.name] ?? k.def ?? k.min;
+    for (final k in wide) {
+      b.setInt32(o, value(k).clamp(k.min, k.max), Endian.little);
+      o += 4;
+    }
+    for (final k in narrow) {
+      b.setUint16(o, value(k).clamp(k.min, k.max) - k.min, Endian.little);
+      o += 2;
+    }
+    o = end;
+
+    o = _section(b, o, _kTaps, taps, 8 * taps);
+    for (var t = 0; t < taps && t < data.taps.length; t++) {
+      final tap = data.taps[t];
+      b.setUint16(o + 8 * t, tap.timeQ12, Endian.little);
+      b.setUint16(o + 8 * t + 2, tap.panQ15, Endian.little);
+      b.setInt32(o + 8 * t + 4, tap.gainQ15, Endian.little);
+    }
+    o += 8 * taps;
+
+    final bytes = b.buffer.asUint8List();
+    b.setUint32(o, crc32(bytes.sublist(0, o)), Endian.little);
+    return bytes;
+  }
+
+  /// The param hash of a well-formed record (magic, version, CRC), else
+  /// null.
+  static int? hashOf(Uint8List rec) {
+    if (rec.length < 12) return null;
+    final b = ByteData.sublistView(rec);
+    if (b.getUint16(0, Endian.little) != magic || rec[2] != version) {
+      return null;
+    }
+    final n = rec.length - 4;
+    if (crc32(rec.sublist(0, n)) != b.getUint32(n, Endian.little)) {
+      return null;
+    }
+    return b.getUint32(4, Endian.little);
+  }
+
+  /// Decodes a record written against [keys] (same hash), or returns null.
+  static PresetData? decode(Uint8List rec, List<PresetKey> keys) {
+    if (hashOf(rec) != paramHash(keys)) return null;
+    final b = ByteData.sublistView(rec);
+    var fx = 0;
+    final params = <String, int>{};
+    final taps = <PresetTap>[];
+    var o = 8;
+    for (var s = 0; s < rec[3]; s++) {
+      if (o + 4 > rec.length - 4) return null;
+      final type = rec[o];
+      final info = rec[o + 1];
+      final bytes = b.getUint16(o + 2, Endian.little);
+      o += 4;
+      if (o + bytes > rec.length - 4) return null;
+      switch (type) {
+        case _kFx:
+          fx = b.getUint32(o, Endian.little);
+        case _kParams:
+          var p = o;
+          final wide = keys.where((k) => k.wide).toList();
+          final narrow = keys.where((k) => !k.wide).toList();
+          if (info != wide.length ||
+              4 * wide.length + 2 * narrow.length > bytes) {
+            return null;
+          }
+          for (final k in wide) {
+            params[k.name] = b.getInt32(p, Endian.little);
+            p += 4;
+          }
+          for (final k in narrow) {
+            params[k.name] = k.min + b.getUint16(p, Endian.little);
+            p += 2;
+          }
+        case _kTaps:
+          for (var t = 0; t < info && 8 * t + 8 <= bytes; t++) {
+            taps.add(
+              PresetTap(
+                timeQ12: b.getUint16(o + 8 * t, Endian.little),
+                panQ15: b.getUint16(o + 8 * t + 2, Endian.little),
+                gainQ15: b.getInt32(o + 8 * t + 4, Endian.little),
+              ),
+            );
+          }
+      }
+      // Unknown section types are skipped.
+      o += bytes;
+    }
+    return PresetData(fxMask: fx, params: params, taps: taps);
+  }
+
+  static int _section(ByteData b, int o, int type, int info, int bytes) {
+    b.setUint8(o, type);
+    b.setUint8(o + 1, info);
+    b.setUint16(o + 2, bytes, Endian.little);
+    return o + 4;
+  }
+
+  // CRC-32 (reflected 0xEDB88320), the one the preset records use.
+  static int crc32(List<int> p) {
+    var crc = 0xFFFFFFFF;
+    for (final byte in p) {
+      crc ^= byte;
+      for (var i = 0; i < 8; i++) {
+        crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+      }
+    }
+    return crc ^ 0xFFFFFFFF;
+  }
+}
+
+/// A library preset file (`presets/<id>.pst`): the [PresetRecord], then the
+/// keys it was written against, so it reads back whatever the pedal's
+/// params are now:
+///
+///   `PK` <count u16> per key <name length u8> <name> <min s32> <max s32>,
+///   then the CRC-32 of the keys block.
+///
+/// The record stays the file's first bytes: a file pulled from the pedal
+/// goes back byte for byte while the pedal's param hash is the same.
+class PresetFile {
+  const PresetFile(this.record, this.keys, this.data);
+
+  final Uint8List record;
+  final List<PresetKey> keys;
+  final PresetData data;
+
+  static const int _kKeysMagic = 0x4B50; // "PK"
+
+  static PresetFile build(PresetData data, List<PresetKey> keys, int taps) =>
+      PresetFile(PresetRecord.encode(data, keys, taps), keys, data);
+
+  Uint8List toBytes() {
+    final out = BytesBuilder()..add(record);
+    final k = BytesBuilder();
+    final head = ByteData(4)
+      ..setUint16(0, _kKeysMagic, Endian.little)
+      ..setUint16(2, keys.length, Endian.little);
+    k.add(head.buffer.asUint8List());
+    for (final key in keys) {
+      final name = utf8.encode(key.name);
+      k.addByte(name.length);
+      k.add(name);
+      final v = ByteData(8)
+        ..setInt32(0, key.min, Endian.little)
+        ..setInt32(4, key.max, Endian.little);
+      k.add(v.buffer.asUint8List());
+    }
+    final keyBytes = k.toBytes();
+    out.add(keyBytes);
+    final crc = ByteData(4)
+      ..setUint32(0, PresetRecord.crc32(keyBytes), Endian.little);
+    out.add(crc.buffer.asUint8List());
+    return out.toBytes();
+  }
+
+  /// Parses a whole file, or returns null.
+  static PresetFile? parse(Uint8List bytes) {
+    if (bytes.length < 12) return null;
+    final b = ByteData.sublistView(bytes);
+    // The record's size follows from its section headers.
+    var o = 8;
+    for (var s = 0; s < bytes[3]; s++) {
+      if (o + 4 > bytes.length) return null;
+      o += 4 + b.getUint16(o + 2, Endian.little);
+    }
+    o += 4;
+    if (o + 8 > bytes.length) return null;
+    final record = Uint8List.sublistView(bytes, 0, o);
+    if (PresetRecord.hashOf(record) == null ||
+        b.getUint16(o, Endian.little) != _kKeysMagic) {
+      return null;
+    }
+    final count = b.getUint16(o + 2, Endian.little);
+    final keys = <PresetKey>[];
+    var p = o + 4;
+    for (var i = 0; i < count; i++) {
+      if (p + 1 > bytes.length) return null;
+      final n = bytes[p];
+      if (p + 1 + n + 8 > bytes.length) return null;
+      final name = utf8.decode(bytes.sublist(p + 1, p + 1 + n));
+      keys.add(
+        PresetKey(
+          name,
+          b.getInt32(p + 1 + n, Endian.little),
+          b.getInt32(p + 5 + n, Endian.little),
+        ),
+      );
+      p += 1 + n + 8;
+    }
+    if (p + 4 != bytes.length ||
+        PresetRecord.crc32(bytes.sublist(o, p)) !=
+            b.getUint32(p, Endian.little)) {
+      return null;
+    }
+    final data = PresetRecord.decode(Uint8List.fromList(record), keys);
+    if (data == null) return null;
+    return PresetFile(Uint8List.fromList(record), keys, data);
+  }
+
+  /// The record for a pedal with [keys] and [taps]: this one as it is when
+  /// the hash matches, else the data encoded again.
+  Uint8List recordFor(List<PresetKey> keys, int taps) =>
+      PresetRecord.hashOf(record) == PresetRecord.paramHash(keys) &&
+          record.length == PresetRecord.size(keys, taps)
+      ? record
+      : PresetRecord.encode(data, keys, taps);
+}
@@ -1,6 +1,9 @@
 import 'dart:convert';
 import 'dart:io';
 
+import 'preset_library.dart';
+import 'preset_record.dart';
+
 class Presets {
   Presets({
     required this.distDriveQ8,
@@ -30,6 +33,45 @@ class Presets {
     reverbDampQ15: 8192,
   );
 
+  // The knobs as firmware params (PLIST names and ranges).
+  static const List<PresetKey> keys = [
+    PresetKey('dist_drive_q8', 0, 131072),
+    PresetKey('gain_q15', 0, 65536),
+    PresetKey('delay_mix_q15', 0, 32768),
+    PresetKey('delay_feedback_q15', 0, 32768),
+    PresetKey('reverb_mix_q15', 0, 32768),
+    PresetKey('reverb_feedback_q15', 0, 32768),
+    PresetKey('reverb_damp_q15', 0, 32768),
+  ];
+
+  PresetData toData() => PresetData(
+    fxMask: 0,
+    params: {
+      'dist_drive_q8': distDriveQ8,
+      'gain_q15': gainQ15,
+      'delay_mix_q15': delayMixQ15,
+      'delay_feedback_q15': delayFeedbackQ15,
+      'reverb_mix_q15': reverbMixQ15,
+      'reverb_feedback_q15': reverbFeedbackQ15,
+      'reverb_damp_q15': reverbDampQ15,
+    },
+    taps: const [],
+  );
+
+  static Presets fromData(PresetData data) {
+    final p = Presets.defaults();
+    int v(String name, int def) => data.params[name] ?? def;
+    return p
+      ..distDriveQ8 = v('dist_drive_q8', p.distDriveQ8)
+      ..gainQ15 = v('gain_q15', p.gainQ15)
+      ..delayMixQ15 = v('delay_mix_q15', p.delayMixQ15)
+      ..delayFeedbackQ15 = v('delay_feedback_q15', p.delayFeedbackQ15)
+      ..reverbMixQ15 = v('reverb_mix_q15', p.reverbMixQ15)
+      ..reverbFeedbackQ15 = v('reverb_feedback_q15', p.reverbFeedbackQ15)
+      ..reverbDampQ15 = v('reverb_damp_q15', p.reverbDampQ15);
+  }
+
+  /// The nested JSON the app used to keep; an export now.
   Map<String, dynamic> toJson() => {
     'master': {'gain_q15': gainQ15},
     'distortion': {'dist_drive_q8': distDriveQ8},
@@ -84,16 +126,23 @@ class Presets {
   }
 }
 
+/// The knobs between runs, as a preset file (`effects_presets.pst`, see
+/// [PresetFile]); `effects_presets.json` from older versions is read once.
 class PresetStore {
-  static File _file() {
+  static File _file(String ext) {
     return File(
-      '${Directory.current.path}${Platform.pathSeparator}effects_presets.json',
+      '${Directory.current.path}${Platform.pathSeparator}effects_presets.$ext',
     );
   }
 
   static Future<Presets> load() async {
     try {
-      final f = _file();
+      final pst = _file('pst');
+      if (await pst.exists()) {
+        final file = PresetFile.parse(await pst.readAsBytes());
+        return file == null ? Presets.defaults() : Presets.fromData(file.data);
+      }
+      final f = _file('json');
       if (!await f.exists()) {
         return Presets.defaults();
       }
@@ -109,8 +158,7 @@ class PresetStore {
   }
 
   static Future<void> save(Presets presets) async {
-    final f = _file();
-    final txt = const JsonEncoder.withIndent('  ').convert(presets.toJson());
-    await f.writeAsString(txt);
+    final file = PresetFile.build(presets.toData(), Presets.keys, 0);
+    await _file('pst').writeAsBytes(file.toBytes());
   }
 }
@@ -0,0 +1,256 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import '../presets/preset_library.dart';
+
+/// The firmware DSP chain on the desktop: dart:ffi bindings of
+/// tools/dsp_host/dsp_preview.h (built and bundled by the Linux and Windows
+/// runners). Renders a stored DI clip through a preset with the same
+/// app_dsp.c as the pedal, block by block, far faster than real time.
+///
+/// The engine is one set of statics in the library: use it from one
+/// isolate at a time ([renderPreviewFile] runs a whole render on its own).
+class DspPreview {
+  DspPreview._(DynamicLibrary lib)
+    : _sampleRate = lib.lookupFunction<Uint32 Function(), int Function()>(
+        'dsp_preview_sample_rate',
+      ),
+      _paramCount = lib.lookupFunction<Uint32 Function(), int Function()>(
+        'dsp_preview_param_count',
+      ),
+      _paramName = lib
+          .lookupFunction<
+            Pointer<Uint8> Function(Uint32),
+            Pointer<Uint8> Function(int)
+          >('dsp_preview_param_name'),
+      _reset = lib.lookupFunction<Void Function(), void Function()>(
+        'dsp_preview_reset',
+      ),
+      _begin = lib.lookupFunction<Void Function(), void Function()>(
+        'dsp_preview_begin',
+      ),
+      _setParam = lib
+          .lookupFunction<
+            Void Function(Uint32, Int32),
+            void Function(int, int)
+          >('dsp_preview_set_param'),
+      _setTap = lib
+          .lookupFunction<
+            Void Function(Uint32, Uint32, Uint32, Int32),
+            void Function(int, int, int, int)
+          >('dsp_preview_set_tap'),
+      _setFxMask = lib
+          .lookupFunction<Void Function(Uint32), void Function(int)>(
+            'dsp_preview_set_fx_mask',
+          ),
+      _commit = lib.lookupFunction<Void Function(), void Function()>(
+        'dsp_preview_commit',
+      ),
+      _buffer = lib
+          .lookupFunction<
+            Pointer<Int32> Function(Uint32),
+            Pointer<Int32> Function(int)
+          >('dsp_preview_buffer'),
+      _process = lib
+          .lookupFunction<
+            Uint64 Function(Uint32, Uint32),
+            int Function(int, int)
+          >('dsp_preview_process');
+
+  final int Function() _sampleRate;
+  final int Function() _paramCount;
+  final Pointer<Uint8> Function(int) _paramName;
+  final void Function() _reset;
+  final void Function() _begin;
+  final void Function(int, int) _setParam;
+  final void Function(int, int, int, int) _setTap;
+  final void Function(int) _setFxMask;
+  final void Function() _commit;
+  final Pointer<Int32> Function(int) _buffer;
+  final int Function(int, int) _process;
+
+  late final Map<String, int> _ids = {
+    for (var id = 0; id < _paramCount(); id++)
+      if (_name(id) case final name?) name: id,
+  };
+
+  // Silence run before the clip so the parameter glides have settled.
+  static const int _kPrerollMs = 50;
+
+  /// Opens the library bundled next to the executable.
+  static DspPreview open() {
+    final sep = Platform.pathSeparator;
+    final dir = File(Platform.resolvedExecutable).parent.path;
+    final path = Platform.isWindows
+        ? '$dir${sep}dsp_preview.dll'
+        : '$dir${sep}lib${sep}libdsp_preview.so';
+    return DspPreview._(DynamicLibrary.open(path));
+  }
+
+  int get sampleRate => _sampleRate();
+
+  /// Renders [clip] (interleaved s24 L/R at [sampleRate]) through [preset]
+  /// from a freshly initialised chain.
+  PreviewResult render(PresetData preset, Int32List clip) {
+    _reset();
+    _begin();
+    for (final MapEntry(:key, :value) in preset.params.entries) {
+      final id = _ids[key];
+      if (id != null) _setParam(id, value);
+    }
+    for (var t = 0; t < preset.taps.length; t++) {
+      final tap = preset.taps[t];
+      _setTap(t, tap.timeQ12, tap.panQ15, tap.gainQ15);
+    }
+    _setFxMask(preset.fxMask);
+    _commit();
+
+    final frames = clip.length ~/ 2;
+    final preroll = (sampleRate * _kPrerollMs) ~/ 1000;
+    final capacity = frames > preroll ? frames : preroll;
+    final buf = _buffer(capacity);
+    if (buf == nullptr) throw StateError('dsp_preview: out of memory');
+
+    final view = buf.asTypedList(2 * capacity);
+    view.fillRange(0, 2 * preroll, 0);
+    _process(preroll, 0);
+    view.setRange(0, 2 * frames, clip);
+    final ns = _process(frames, 0);
+    return PreviewResult(
+      view.sublist(0, 2 * frames),
+      Duration(microseconds: ns ~/ 1000),
+      Duration(microseconds: (frames * 1000000) ~/ sampleRate),
+    );
+  }
+
+  String? _name(int id) {
+    final p = _paramName(id);
+    if (p == nullptr) return null;
+    var n = 0;
+    while (p[n] != 0) {
+      n++;
+    }
+    return String.fromCharCodes(p.asTypedList(n));
+  }
+}
+
+class PreviewResult {
+  const PreviewResult(this.samples, this.dspTime, this.clipTime);
+
+  /// Interleaved s24 L/R.
+  final Int32List samples;
+  final Duration dspTime;
+  final Duration clipTime;
+
+  double get realtimeFactor =>
+      dspTime.inMicroseconds == 0
+          ? double.infinity
+          : clipTime.inMicroseconds / dspTime.inMicroseconds;
+}
+
+/// Renders the WAV at [clipPath] through [preset] into a 24-bit stereo WAV
+/// at [outPath], on a background isolate. Returns how many times faster
+/// than real time the chain ran.
+Future<double> renderPreviewFile(
+  PresetData preset,
+  String clipPath,
+  String outPath,
+) {
+  return Isolate.run(() {
+    final dsp = DspPreview.open();
+    final clip = readWavS24(File(clipPath).readAsBytesSync(), dsp.sampleRate);
+    final r = dsp.render(preset, clip);
+    File(outPath)
+      ..parent.createSync(recursive: true)
+      ..writeAsBytesSync(writeWavS24(r.samples, dsp.sampleRate));
+    return r.realtimeFactor;
+  });
+}
+
+/// PCM 16/24-bit mono or stereo WAV to interleaved s24 stereo (mono feeds
+/// both sides, like dsp_host). The clip must be at the firmware rate.
+Int32List readWavS24(Uint8List bytes, int sampleRate) {
+  final b = ByteData.sublistView(bytes);
+  String tag(int at) => String.fromCharCodes(bytes.sublist(at, at + 4));
+  if (bytes.length < 12 || tag(0) != 'RIFF' || tag(8) != 'WAVE') {
+    throw const FormatException('not a RIFF/WAVE file');
+  }
+  int? channels, rate, bits;
+  int fmt = 0;
+  Uint8List? data;
+  for (var pos = 12; pos + 8 <= bytes.length;) {
+    var len = b.getUint32(pos + 4, Endian.little);
+    if (pos + 8 + len > bytes.length) len = bytes.length - pos - 8;
+    if (tag(pos) == 'fmt ' && len >= 16) {
+      fmt = b.getUint16(pos + 8, Endian.little);
+      channels = b.getUint16(pos + 10, Endian.little);
+      rate = b.getUint32(pos + 12, Endian.little);
+      bits = b.getUint16(pos + 22, Endian.little);
+      // WAVE_FORMAT_EXTENSIBLE: the sub-format GUID starts with the tag.
+      if (fmt == 0xFFFE && len >= 26) {
+        fmt = b.getUint16(pos + 32, Endian.little);
+      }
+    } else if (tag(pos) == 'data') {
+      data = Uint8List.sublistView(bytes, pos + 8, pos + 8 + len);
+    }
+    pos += 8 + len + (len & 1);
+  }
+  if (data == null || fmt != 1 || (bits != 16 && bits != 24)) {
+    throw const FormatException('need a 16- or 24-bit PCM WAV');
+  }
+  if (channels != 1 && channels != 2) {
+    throw const FormatException('need a mono or stereo WAV');
+  }
+  if (rate != sampleRate) {
+    throw FormatException('clip is $rate Hz, the DSP runs at $sampleRate Hz');
+  }
+
+  final width = bits! ~/ 8;
+  final frames = data.length ~/ (width * channels!);
+  final d = ByteData.sublistView(data);
+  int sample(int i) => width == 2
+      ? d.getInt16(i * 2, Endian.little) << 8
+      : (d.getUint8(i * 3) |
+                (d.getUint8(i * 3 + 1) << 8) |
+                (d.getInt8(i * 3 + 2) << 16));
+  final out = Int32List(frames * 2);
+  for (var f = 0; f < frames; f++) {
+    out[2 * f] = sample(f * channels);
+    out[2 * f + 1] = sample(f * channels + channels - 1);
+  }
+  return out;
+}
+
+/// Interleaved s24 stereo to a 24-bit PCM WAV.
+Uint8List writeWavS24(Int32List samples, int sampleRate) {
+  final dataLen = samples.length * 3;
+  final b = ByteData(44 + dataLen);
+  void tag(int at, String s) {
+    for (var i = 0; i < 4; i++) {
+      b.setUint8(at + i, s.codeUnitAt(i));
+    }
+  }
+
+  tag(0, 'RIFF');
+  b.setUint32(4, 36 + dataLen, Endian.little);
+  tag(8, 'WAVE');
+  tag(12, 'fmt ');
+  b.setUint32(16, 16, Endian.little);
+  b.setUint16(20, 1, Endian.little);
+  b.setUint16(22, 2, Endian.little);
+  b.setUint32(24, sampleRate, Endian.little);
+  b.setUint32(28, sampleRate * 6, Endian.little);
+  b.setUint16(32, 6, Endian.little);
+  b.setUint16(34, 24, Endian.little);
+  tag(36, 'data');
+  b.setUint32(40, dataLen, Endian.little);
+  for (var i = 0; i < samples.length; i++) {
+    final v = samples[i];
+    b.setUint8(44 + i * 3, v & 0xFF);
+    b.setUint8(45 + i * 3, (v >> 8) & 0xFF);
+    b.setUint8(46 + i * 3, (v >> 16) & 0xFF);
+  }
+  return b.buffer.asUint8List();
+}
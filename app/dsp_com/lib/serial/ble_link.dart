@@ -0,0 +1,215 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter_blue_plus/flutter_blue_plus.dart';
+
+import 'link_codec.dart';
+import 'link_event.dart';
+
+export 'link_codec.dart' show LinkFrame, PedalLink, PickerLink;
+export 'link_event.dart';
+
+/// The pedal through its BLE UART module (app_ble.h) on Android and iOS:
+/// the Nordic UART Service, whose RX characteristic takes the phone's
+/// writes and whose TX characteristic notifies what the firmware sends.
+///
+/// A BLE write costs a connection interval (7.5..30 ms) whatever it
+/// carries, so commands are never sent one per write: a [WriteBatcher]
+/// packs everything queued within a microtask, and everything queued while
+/// a write is in flight, into writes of up to the negotiated MTU payload,
+/// sent without response. The CREDIT gate in front keeps those writes
+/// within what the firmware's RX ring holds, which write-with-response
+/// would otherwise have paced at one round trip per write. On Android the
+/// link asks for a 247-byte MTU and the high connection priority (iOS
+/// negotiates both itself). Notifications go through the same
+/// [LinkDecoder] as the serial links.
+class BleLink implements PickerLink {
+  static final Guid _kService = Guid('6e400001-b5a3-f393-e0a9-e50e24dcca9e');
+  static final Guid _kRx = Guid('6e400002-b5a3-f393-e0a9-e50e24dcca9e');
+  static final Guid _kTx = Guid('6e400003-b5a3-f393-e0a9-e50e24dcca9e');
+  static const Duration _kScan = Duration(seconds: 4);
+  static const Duration _kConnectTimeout = Duration(seconds: 10);
+  static const int _kMtu = 247;
+  // ATT header of a write.
+  static const int _kAttHeader = 3;
+
+  BluetoothDevice? _chosen;
+  BluetoothDevice? _device;
+  String? _portName;
+  Future<void>? _exited;
+  final List<StreamSubscription<Object?>> _subs = [];
+  CreditGate? _credit;
+  WriteBatcher? _batcher;
+
+  @override
+  String? get unavailableReason => null;
+
+  @override
+  bool get isOpen => _device != null;
+  @override
+  String? get portName => _portName;
+
+  @override
+  Future<void> get closed => _exited ?? Future<void>.value();
+
+  @override
+  bool get hasPort => _chosen != null;
+
+  /// Scans for pedals advertising the UART service and takes the one with
+  /// the strongest signal (the one next to the phone). False if none
+  /// answered within the scan, or Bluetooth is off.
+  @override
+  Future<bool> choose() async {
+    if (!await FlutterBluePlus.isSupported) return false;
+    if (defaultTargetPlatform == TargetPlatform.android) {
+      try {
+        await FlutterBluePlus.turnOn();
+      } catch (_) {}
+    }
+    final seen = <DeviceIdentifier, ScanResult>{};
+    final sub = FlutterBluePlus.onScanResults.listen((results) {
+      for (final r in results) {
+        seen[r.device.remoteId] = r;
+      }
+    });
+    try {
+      await FlutterBluePlus.startScan(
+        withServices: [_kService],
+        timeout: _kScan,
+      );
+      await FlutterBluePlus.isScanning.where((on) => !on).first;
+    } catch (_) {
+      return false;
+    } finally {
+      await sub.cancel();
+    }
+    if (seen.isEmpty) return false;
+    final best = seen.values.reduce((a, b) => a.rssi >= b.rssi ? a : b);
+    _chosen = best.device;
+    return true;
+  }
+
+  /// Takes a pedal the system already holds a connection to (this app's
+  /// last session, or another app's), without a scan.
+  @override
+  Future<bool> restore() async {
+    try {
+      final devices = await FlutterBluePlus.systemDevices([_kService]);
+      if (devices.isEmpty) return false;
+      _chosen = devices.first;
+      return true;
+    } catch (_) {
+      return false;
+    }
+  }
+
+  @override
+  Future<void> open({
+    required void Function(LinkEvent event) onEvent,
+    int? baudRate,
+  }) async {
+    close();
+    await _exited;
+    final device = _chosen;
+    if (device == null) throw StateError('No pedal chosen');
+
+    final BluetoothCharacteristic rx;
+    final BluetoothCharacteristic tx;
+    try {
+      await device.connect(timeout: _kConnectTimeout, autoConnect: false);
+      if (defaultTargetPlatform == TargetPlatform.android) {
+        await device.requestMtu(_kMtu);
+        await device.requestConnectionPriority(
+          connectionPriorityRequest: ConnectionPriority.high,
+        );
+      }
+      final services = await device.discoverServices();
+      final uart = services.firstWhere(
+        (s) => s.uuid == _kService,
+        orElse: () => throw StateError('No UART service'),
+      );
+      BluetoothCharacteristic char(Guid id) => uart.characteristics
+          .firstWhere(
+            (c) => c.uuid == id,
+            orElse: () => throw StateError('No UART characteristic $id'),
+          );
+      rx = char(_kRx);
+      tx = char(_kTx);
+      await tx.setNotifyValue(true);
+    } catch (e) {
+      await device.disconnect().catchError((_) {});
+      throw StateError('BLE connect failed ($e)');
+    }
+
+    final decoder = LinkDecoder();
+    final batcher = WriteBatcher(
+      (b) => rx.write(b, withoutResponse: true),
+      maxChunk: device.mtuNow - _kAttHeader,
+    );
+    final credit = CreditGate(batcher.add);
+    _device = device;
+    _batcher = batcher;
+    _credit = credit;
+    _portName = device.platformName.isEmpty
+        ? device.remoteId.str
+        : device.platformName;
+    _exited = null;
+
+    _subs
+      ..add(
+        tx.onValueReceived.listen((value) {
+          final data = Uint8List.fromList(value);
+          final events = decoder.ingest(data)..removeWhere(credit.take);
+          for (final e in events) {
+            onEvent(e);
+          }
+        }),
+      )
+      ..add(device.mtu.listen((mtu) => batcher.maxChunk = mtu - _kAttHeader))
+      ..add(
+        device.connectionState.listen((state) {
+          if (state == BluetoothConnectionState.disconnected &&
+              _device == device) {
+            onEvent(const LinkErrorEvent('Pedal disconnected'));
+            close();
+          }
+        }),
+      );
+    credit.start();
+  }
+
+  @override
+  void sendLine(String line) {
+    if (!isOpen) return;
+    _credit!.write(Uint8List.fromList(utf8.encode('$line\n')));
+  }
+
+  @override
+  void sendBytes(Uint8List bytes) => _credit?.write(bytes);
+
+  @override
+  void sendFrame(int cmd, List<int> payload) =>
+      _credit?.write(LinkFrame.encode(cmd, payload));
+
+  @override
+  void close() {
+    final device = _device;
+    if (device == null) return;
+    _credit?.dispose();
+    _credit = null;
+    _batcher?.close();
+    _batcher = null;
+    _device = null;
+    _portName = null;
+    final subs = List.of(_subs);
+    _subs.clear();
+    _exited = () async {
+      for (final s in subs) {
+        await s.cancel();
+      }
+      await device.disconnect().catchError((_) {});
+    }();
+  }
+}
@@ -0,0 +1,161 @@
+/// Where the time from a knob move to the pedal's output goes, stage by
+/// stage, from the firmware's latency probe (CAPS feat `lat`):
+///
+///   #<seq> @<t> PSETM ...   the command, <t> this clock in microseconds
+///   LAT <t> rd=<us> ap=<us> blk=<us> tx=<us> ramp=<us> P=<pver>
+///
+/// The LAT times count from the line's arrival at the pedal. One probe is
+/// in flight at a time, so a knob sweep samples its commands rather than
+/// adding a line per command. Per probe:
+///
+/// - input: the first knob step of a frame to its onChanged (the knob
+///   applies its steps once per frame, [markInput]);
+/// - queue: onChanged to the line handed to the link (the pump's pacing
+///   and window);
+/// - link: one way on the wire, half of the round trip less the pedal's
+///   dwell (tx=);
+/// - poll: arrival to the parser (the main loop reaching AppCom_Poll);
+/// - apply: parser to the committed batch;
+/// - block: commit to the first audio block on that set;
+/// - ramp: the glide of the smoothed params to their new value.
+///
+/// The pedal's clocks are not synced with this one: only the link stage
+/// mixes the two, through the round trip both ends measure.
+class ControlLatency {
+  static const List<String> stages = [
+    'input',
+    'queue',
+    'link',
+    'poll',
+    'apply',
+    'block',
+    'ramp',
+  ];
+
+  static const int _kKeep = 32;
+  static const int _kProbeTimeoutUs = 1000000;
+
+  static final Stopwatch _clock = Stopwatch()..start();
+  static int? _inputUs;
+
+  /// Now on the probe clock, in microseconds.
+  static int get nowUs => _clock.elapsedMicroseconds;
+
+  /// A knob step waits for the next frame: the first since the last
+  /// [takeInput] is when the user moved it.
+  static void markInput() => _inputUs ??= nowUs;
+
+  /// When the change being handed over started: the marked knob step, or
+  /// now for a change that did not come from one.
+  static int takeInput() {
+    final t = _inputUs ?? nowUs;
+    _inputUs = null;
+    return t;
+  }
+
+  // Per param: input and onChanged of the oldest change not sent yet.
+  final Map<String, (int, int)> _changed = {};
+
+  // The probe in flight: its <t>, input and onChanged times.
+  int? _probeT;
+  int _probeInput = 0;
+  int _probeChanged = 0;
+
+  final List<List<int>> _samples = [];
+
+  /// Breakdowns received so far (up to the last 32 are kept).
+  int count = 0;
+
+  void reset() {
+    _changed.clear();
+    _probeT = null;
+    _samples.clear();
+    count = 0;
+  }
+
+  /// [param] was set to a new value by the user or the app.
+  void noteChange(String param) {
+    final input = takeInput();
+    _changed.putIfAbsent(param, () => (input, nowUs));
+  }
+
+  /// A command for [params] goes out: returns the "@<t> " prefix when it
+  /// is to carry the probe, else ''. The changes are sent either way;
+  /// without [enabled] (firmware without `lat`) none is.
+  String begin(Iterable<String> params, {required bool enabled}) {
+    (int, int)? oldest;
+    for (final p in params) {
+      final c = _changed.remove(p);
+      if (c != null && (oldest == null || c.$1 < oldest.$1)) oldest = c;
+    }
+    final now = nowUs;
+    final t = _probeT;
+    if (!enabled ||
+        oldest == null ||
+        (t != null && (now - t) & 0xFFFFFFFF < _kProbeTimeoutUs)) {
+      return '';
+    }
+    _probeT = now & 0xFFFFFFFF;
+    _probeInput = oldest.$1;
+    _probeChanged = oldest.$2;
+    return '@$_probeT ';
+  }
+
+  /// Handles a LAT line; false if [line] is not one for the probe in
+  /// flight.
+  bool onReport(String line) {
+    final parts = line.split(RegExp(r'\s+'));
+    if (parts.length < 2 || parts[0] != 'LAT') return false;
+    final t = int.tryParse(parts[1]);
+    if (t == null || t != _probeT) return false;
+    _probeT = null;
+
+    final kv = <String, int>{};
+    for (final p in parts.skip(2)) {
+      final eq = p.indexOf('=');
+      if (eq <= 0) continue;
+      final v = int.tryParse(p.substring(eq + 1));
+      if (v != null) kv[p.substring(0, eq)] = v;
+    }
+    final rd = kv['rd'], ap = kv['ap'], blk = kv['blk'], tx = kv['tx'];
+    if (rd == null || ap == null || blk == null || tx == null) return false;
+
+    final rtt = (nowUs - t) & 0xFFFFFFFF;
+    _samples.add([
+      _probeChanged - _probeInput,
+      (t - _probeChanged) & 0xFFFFFFFF,
+      rtt > tx ? (rtt - tx) ~/ 2 : 0,
+      rd,
+      ap - rd,
+      blk - ap,
+      kv['ramp'] ?? 0,
+    ]);
+    if (_samples.length > _kKeep) _samples.removeAt(0);
+    count++;
+    return true;
+  }
+
+  /// Median of each stage over the kept probes, in microseconds (empty
+  /// before the first). The sum up to block is when the pedal's DSP runs
+  /// on the new value; the output buffer (LATENCY) follows.
+  List<int> get medians {
+    if (_samples.isEmpty) return const [];
+    return [
+      for (var s = 0; s < stages.length; s++)
+        (_samples.map((e) => e[s]).toList()..sort())[_samples.length ~/ 2],
+    ];
+  }
+
+  @override
+  String toString() {
+    final m = medians;
+    if (m.isEmpty) return 'no probes yet';
+    String ms(int us) => (us / 1000).toStringAsFixed(us < 10000 ? 2 : 1);
+    final dsp = m.take(6).reduce((a, b) => a + b);
+    final each = [
+      for (var s = 0; s < m.length; s++) '${stages[s]} ${ms(m[s])}',
+    ];
+    return '${each.join(' · ')} ms; DSP after ${ms(dsp)} ms, '
+        'settled ${ms(dsp + m[6])} ms (median of ${_samples.length})';
+  }
+}
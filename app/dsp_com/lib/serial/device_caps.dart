@@ -0,0 +1,62 @@
+/// `CAPS fw=<version> proto=<n> feat=<name>,... baud=<max> rate=<hz>
+/// block=<frames> line=<n> bin=<n> rx=<n> tx=<n> params=<n> hash=<n>`:
+/// what the firmware build speaks (app_com.c), asked once on connect.
+/// Besides the protocol features, `feat` names the optional FX the build
+/// carries (`pitch`, `chorus`, `spring`, `spill`, `bus`, `ucab`); a page
+/// shows a control for one only when [has] it.
+class DeviceCaps {
+  const DeviceCaps({
+    required this.firmware,
+    required this.protocol,
+    required this.features,
+    required this.maxBaud,
+    required this.sampleRate,
+    required this.blockFrames,
+    required this.lineMax,
+    required this.params,
+    required this.paramHash,
+  });
+
+  final String firmware;
+  final int protocol;
+  final Set<String> features;
+  final int maxBaud;
+  final int sampleRate;
+  final int blockFrames;
+  final int lineMax;
+  final int params;
+
+  /// Over the PLIST descriptors: the same [params] and [paramHash] mean
+  /// the same table.
+  final int paramHash;
+
+  bool has(String feature) => features.contains(feature);
+
+  static DeviceCaps? tryParse(String line) {
+    if (!line.startsWith('CAPS ')) return null;
+    final kv = <String, String>{};
+    for (final p in line.split(RegExp(r'\s+')).skip(1)) {
+      final eq = p.indexOf('=');
+      if (eq > 0) kv[p.substring(0, eq)] = p.substring(eq + 1);
+    }
+    int? num(String key) => int.tryParse(kv[key] ?? '');
+    final protocol = num('proto');
+    final params = num('params');
+    final hash = num('hash');
+    if (protocol == null || params == null || hash == null) return null;
+    return DeviceCaps(
+      firmware: kv['fw'] ?? '',
+      protocol: protocol,
+      features: (kv['feat'] ?? '')
+          .split(',')
+          .where((f) => f.isNotEmpty)
+          .toSet(),
+      maxBaud: num('baud') ?? 0,
+      sampleRate: num('rate') ?? 0,
+      blockFrames: num('block') ?? 0,
+      lineMax: num('line') ?? 0,
+      params: params,
+      paramHash: hash,
+    );
+  }
+}
@@ -0,0 +1,50 @@
+/// One distortion model with its declared cost, as reported by `DMODEL`:
+///
+///   DMODEL <id> <name> cyc=<os1>/<os2>/<os4> cyc_frame=<n> load=<x.y>%
+///
+/// cyc= is cycles per channel sample at each oversampling factor;
+/// cyc_frame= and load= are one frame's cost at the pedal's dist_os, the
+/// latter as a share of the frame at its current clock.
+class DistModel {
+  const DistModel({
+    required this.id,
+    required this.name,
+    required this.cycSample,
+    required this.cycFrame,
+    required this.loadPct,
+  });
+
+  /// The dist_model value that selects it.
+  final int id;
+  final String name;
+  final List<int> cycSample;
+  final int cycFrame;
+  final double loadPct;
+
+  /// Parses one `DMODEL <id> ...` line, or returns null for anything else.
+  static DistModel? tryParse(String line) {
+    final parts = line.split(RegExp(r'\s+'));
+    if (parts.length < 3 || parts[0] != 'DMODEL') return null;
+    final id = int.tryParse(parts[1]);
+    if (id == null) return null;
+
+    final kv = <String, String>{};
+    for (final p in parts.skip(3)) {
+      final eq = p.indexOf('=');
+      if (eq > 0) kv[p.substring(0, eq)] = p.substring(eq + 1);
+    }
+    final cycFrame = int.tryParse(kv['cyc_frame'] ?? '');
+    final load = double.tryParse((kv['load'] ?? '').replaceAll('%', ''));
+    if (cycFrame == null || load == null) return null;
+
+    return DistModel(
+      id: id,
+      name: parts[2],
+      cycSample: [
+        for (final c in (kv['cyc'] ?? '').split('/')) int.tryParse(c) ?? 0,
+      ],
+      cycFrame: cycFrame,
+      loadPct: load,
+    );
+  }
+}
@@ -0,0 +1,337 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'link_event.dart';
+import 'meter_frame.dart';
+import 'param_desc.dart';
+
+/// What the UI drives a pedal through, whichever transport carries it:
+/// [SerialLink] (a worker isolate on a native or libserialport port) or
+/// [WebSerialLink] (the browser's WebSerial). Opening differs per
+/// transport; replies come back through the `onEvent` given to open.
+abstract interface class PedalLink {
+  bool get isOpen;
+  String? get portName;
+
+  /// Completes once the port is closed.
+  Future<void> get closed;
+
+  void sendLine(String line);
+  void sendBytes(Uint8List bytes);
+
+  /// Sends one binary frame ([LinkFrame]).
+  void sendFrame(int cmd, List<int> payload);
+
+  void close();
+}
+
+/// A [PedalLink] whose port the platform picks rather than a name: the
+/// browser's port picker ([WebSerialLink]) or a BLE scan ([BleLink]).
+abstract interface class PickerLink implements PedalLink {
+  /// Why this device cannot open a link at all, else null.
+  String? get unavailableReason;
+
+  /// True once [choose] or [restore] found a port; [open] opens it.
+  bool get hasPort;
+
+  /// Lets the user (or the scan) pick a port; false if none was.
+  Future<bool> choose();
+
+  /// Takes a port granted or paired before, without asking; false if none.
+  Future<bool> restore();
+
+  /// [baudRate] is for transports that have one (the BLE module's UART
+  /// rate is the firmware's business).
+  Future<void> open({
+    required void Function(LinkEvent event) onEvent,
+    int? baudRate,
+  });
+}
+
+/// Byte stream to events: lines (tagged replies, STATUS and EVT, PLIST)
+/// and binary frames. The serial isolate runs it on what it reads; it also
+/// decodes bytes read elsewhere (a recorded session, [SessionLog.analyze];
+/// the browser's WebSerial link).
+class LinkDecoder {
+  static const int frameSync = LinkFrame.sync;
+
+  final StringBuffer _rxBuf = StringBuffer();
+
+  // Binary frame (0xA5 <len> <cmd> <payload> <crc16>) being received; the
+  // firmware only starts one at a line boundary.
+  final List<int> _frame = <int>[];
+  bool _inFrame = false;
+
+  static final RegExp _tag = RegExp(r'^#(\d+) ');
+
+  List<LinkEvent> ingest(Uint8List data) {
+    final out = <LinkEvent>[];
+    for (final b in data) {
+      if (_inFrame) {
+        _frame.add(b);
+        // _frame holds <len> <cmd> <payload> <crc lo> <crc hi>.
+        if (_frame.length == _frame[0] + 3) {
+          _inFrame = false;
+          final n = _frame[0];
+          final crc = _frame[n + 1] | (_frame[n + 2] << 8);
+          if (n > 0 && crc == LinkFrame.crc16(_frame, n + 1)) {
+            out.add(
+              _frameEvent(
+                _frame[1],
+                Uint8List.fromList(_frame.sublist(2, n + 1)),
+              ),
+            );
+          }
+          _frame.clear();
+        }
+      } else if (b == frameSync && _rxBuf.isEmpty) {
+        _inFrame = true;
+        _frame.clear();
+      } else if (b == 10) {
+        final line = _rxBuf.toString().trim();
+        _rxBuf.clear();
+        if (line.isNotEmpty) {
+          out.add(_lineEvent(line));
+        }
+      } else if (b == 13) {
+        // ignore CR
+      } else {
+        _rxBuf.writeCharCode(b);
+      }
+    }
+    return out;
+  }
+
+  static LinkEvent _frameEvent(int cmd, Uint8List payload) {
+    if (cmd == MeterFrame.cmd) {
+      final m = MeterFrame.tryParse(payload);
+      if (m != null) return MeterEvent(m);
+    }
+    return FrameEvent(cmd, payload);
+  }
+
+  static LineEvent _lineEvent(String line) {
+    // Replies to tagged commands start with "#<seq> ".
+    int? seq;
+    final tag = _tag.firstMatch(line);
+    if (tag != null) {
+      seq = int.parse(tag.group(1)!);
+      line = line.substring(tag.end);
+    }
+
+    final push = line.startsWith('EVT V=');
+    if (push || line.startsWith('STATUS ')) {
+      // STATUS V=<ver> P=<pver> FXMASK=<n> dist_drive_q8=<n> ...
+      // EVT V=<ver> P=<pver> <changed field>=<n> ...
+      final values = <String, int>{};
+      for (final p in line.split(RegExp(r'\s+')).skip(1)) {
+        final eq = p.indexOf('=');
+        if (eq <= 0) continue;
+        final val = int.tryParse(p.substring(eq + 1));
+        if (val == null) continue;
+        values[p.substring(0, eq)] = val;
+      }
+      return push
+          ? ChangeEvent(line, values)
+          : StatusEvent(line, values, seq: seq);
+    }
+
+    if (line.startsWith('PLIST ')) {
+      final desc = ParamDesc.tryParse(line);
+      if (desc != null) return ParamEvent(line, desc, seq: seq);
+    }
+
+    return LineEvent(line, seq: seq);
+  }
+}
+
+/// Binary frames (app_com.c): `0xA5 <len> <cmd> <payload> <crc16>`; the
+/// firmware answers `cmd | 0x80`.
+abstract final class LinkFrame {
+  static const int sync = 0xA5;
+
+  static Uint8List encode(int cmd, List<int> payload) {
+    final body = <int>[payload.length + 1, cmd, ...payload];
+    final crc = crc16(body, body.length);
+    return Uint8List.fromList([sync, ...body, crc & 0xFF, crc >> 8]);
+  }
+
+  /// Zigzag LEB128, as bin_get_varint() reads it.
+  static List<int> varint(int v) {
+    var z = ((v << 1) ^ (v >> 31)) & 0xFFFFFFFF;
+    final out = <int>[];
+    do {
+      var b = z & 0x7F;
+      z >>= 7;
+      if (z != 0) b |= 0x80;
+      out.add(b);
+    } while (z != 0);
+    return out;
+  }
+
+  // CRC-16/CCITT-FALSE over the first n bytes of p (same as the firmware).
+  static int crc16(List<int> p, int n) {
+    var crc = 0xFFFF;
+    for (var i = 0; i < n; i++) {
+      crc ^= p[i] << 8;
+      for (var b = 0; b < 8; b++) {
+        crc = (crc & 0x8000) != 0 ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        crc &= 0xFFFF;
+      }
+    }
+    return crc;
+  }
+}
+
+/// Coalesces writes for transports where each write costs a round trip
+/// (a promise, a BLE packet): bytes added within one microtask go out as
+/// one [send], and so does everything added while a send is in flight,
+/// cut into pieces of at most [maxChunk] bytes.
+class WriteBatcher {
+  WriteBatcher(this._send, {this.maxChunk});
+
+  final Future<void> Function(Uint8List bytes) _send;
+
+  /// Largest single send (a BLE write's MTU payload); null: no limit.
+  int? maxChunk;
+
+  final BytesBuilder _out = BytesBuilder(copy: false);
+  bool _flushing = false;
+  bool _closed = false;
+
+  void add(Uint8List bytes) {
+    if (_closed) return;
+    _out.add(bytes);
+    if (_flushing) return;
+    _flushing = true;
+    scheduleMicrotask(_flush);
+  }
+
+  /// Drops what is queued; later adds are ignored.
+  void close() {
+    _closed = true;
+    _out.clear();
+  }
+
+  Future<void> _flush() async {
+    while (!_closed && _out.isNotEmpty) {
+      final bytes = _out.takeBytes();
+      final max = maxChunk ?? bytes.length;
+      try {
+        for (var i = 0; i < bytes.length && !_closed; i += max) {
+          final end = i + max < bytes.length ? i + max : bytes.length;
+          await _send(Uint8List.sublistView(bytes, i, end));
+        }
+      } catch (_) {
+        // The transport reports its own failure (the read side sees the
+        // port go); what was queued goes with it.
+        _out.clear();
+        break;
+      }
+    }
+    _flushing = false;
+  }
+}
+
+/// CREDIT flow control (app_com.c): the firmware grants a byte limit
+/// counted from its "OK CREDIT on" and moves it with "CR <limit>" as it
+/// parses; writes past the limit wait here instead of overrunning its RX
+/// ring. Firmware without CREDIT (an ERR, or no answer in time) is written
+/// to unlimited as before. The firmware drops CREDIT on a reset or a lost
+/// count ("READY", "CREDIT off"), and it is asked for again.
+class CreditGate {
+  CreditGate(this._write);
+
+  static const Duration _kAckTimeout = Duration(milliseconds: 500);
+  static final RegExp _cr = RegExp(r'cr=(\d+)');
+
+  final void Function(Uint8List bytes) _write;
+  final List<Uint8List> _queue = <Uint8List>[];
+  Timer? _ackTimer;
+  bool _waiting = false;
+  int _sent = 0;
+  int? _limit; // null: unlimited
+
+  void start() {
+    _waiting = true;
+    _limit = null;
+    _write(Uint8List.fromList(utf8.encode('CREDIT ON\n')));
+    _ackTimer?.cancel();
+    _ackTimer = Timer(_kAckTimeout, () => _grant(null));
+  }
+
+  void dispose() => _ackTimer?.cancel();
+
+  void write(Uint8List bytes) {
+    _queue.add(bytes);
+    _drain();
+  }
+
+  /// True for the untagged lines that are this gate's (not for the UI).
+  bool take(LinkEvent e) {
+    if (e is! LineEvent || e.seq != null) return false;
+    final line = e.line;
+    if (line.startsWith('CR ')) {
+      final limit = int.tryParse(line.substring(3));
+      if (limit != null && _limit != null) {
+        _limit = limit;
+        _drain();
+      }
+      return true;
+    }
+    if (line.startsWith('OK CREDIT ')) {
+      final cr = _cr.firstMatch(line);
+      if (!_waiting && _limit == null && cr != null && cr.group(1) != '0') {
+        // Granted after the wait timed out: what went out since is not
+        // counted here, so turn it off again.
+        _write(Uint8List.fromList(utf8.encode('CREDIT OFF\n')));
+        return true;
+      }
+      _grant(line.startsWith('OK CREDIT on') && cr != null
+          ? int.parse(cr.group(1)!)
+          : null);
+      return true;
+    }
+    if (line == 'ERR CREDIT' || line == 'ERR UNKNOWN cmd=CREDIT') {
+      if (!_waiting) return false;
+      _grant(null);
+      return true;
+    }
+    if (line == 'CREDIT off') {
+      if (!_waiting) start();
+      return true;
+    }
+    if (line == 'READY' && !_waiting) start();
+    return false;
+  }
+
+  void _grant(int? limit) {
+    _ackTimer?.cancel();
+    _waiting = false;
+    _sent = 0;
+    _limit = limit;
+    _drain();
+  }
+
+  void _drain() {
+    while (_queue.isNotEmpty && !_waiting) {
+      final bytes = _queue.first;
+      final limit = _limit;
+      if (limit != null) {
+        // The firmware counts in uint32.
+        final room = (limit - _sent) & 0xFFFFFFFF;
+        if (room == 0 || room > 0x7FFFFFFF) return;
+        if (bytes.length > room) {
+          _write(Uint8List.sublistView(bytes, 0, room));
+          _queue[0] = Uint8List.sublistView(bytes, room);
+          _sent = (_sent + room) & 0xFFFFFFFF;
+          return;
+        }
+      }
+      _queue.removeAt(0);
+      _write(bytes);
+      _sent = (_sent + bytes.length) & 0xFFFFFFFF;
+    }
+  }
+}
@@ -0,0 +1,62 @@
+import 'dart:typed_data';
+
+import 'meter_frame.dart';
+import 'param_desc.dart';
+
+/// Decoded firmware traffic, produced by the [SerialLink] reader isolate.
+sealed class LinkEvent {
+  const LinkEvent();
+}
+
+/// One text line. [seq] is the `#<seq>` tag of the command it answers
+/// (null for untagged lines); the tag is already stripped from [line].
+class LineEvent extends LinkEvent {
+  const LineEvent(this.line, {this.seq});
+
+  final String line;
+  final int? seq;
+}
+
+/// `STATUS V=<ver> P=<pver> FXMASK=<n> <param>=<value> ...`, with the
+/// integer fields split out. P is the parameter-set version the values
+/// were read from.
+class StatusEvent extends LineEvent {
+  const StatusEvent(super.line, this.values, {super.seq});
+
+  final Map<String, int> values;
+}
+
+/// `EVT V=<ver> P=<pver> <field>=<value> ...`: fields the firmware pushed
+/// because they changed (after `EVT ON`). Same layout as a partial STATUS.
+class ChangeEvent extends StatusEvent {
+  const ChangeEvent(super.line, super.values);
+}
+
+/// One `PLIST <id> ...` descriptor line.
+class ParamEvent extends LineEvent {
+  const ParamEvent(super.line, this.desc, {super.seq});
+
+  final ParamDesc desc;
+}
+
+/// One METER frame.
+class MeterEvent extends LinkEvent {
+  const MeterEvent(this.frame);
+
+  final MeterFrame frame;
+}
+
+/// Any other binary frame that passed its CRC.
+class FrameEvent extends LinkEvent {
+  const FrameEvent(this.cmd, this.payload);
+
+  final int cmd;
+  final Uint8List payload;
+}
+
+/// The reader failed (port unplugged, driver error); the link is closed.
+class LinkErrorEvent extends LinkEvent {
+  const LinkErrorEvent(this.message);
+
+  final String message;
+}
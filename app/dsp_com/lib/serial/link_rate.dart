@@ -0,0 +1,111 @@
+import 'dart:math';
+
+/// How fast tagged commands may go out, learned from their acks the way
+/// TCP learns it (RFC 6298 for the timeout, slow start and additive
+/// increase for the window):
+///
+/// - every ack gives a round-trip sample; the smoothed RTT and its mean
+///   deviation set the ack timeout [rto] = srtt + 4 * rttvar;
+/// - the time the firmware spent on the command is the sample less the
+///   bytes' time on the wire at the link's baud rate, smoothed the same
+///   way ([processing]);
+/// - the [window] of commands in flight starts at 1, grows by one per ack
+///   up to half the window last lost (then by one per window of acks), up
+///   to [maxWindow]; a timeout halves it and doubles [rto] until the next
+///   ack (Karn);
+/// - commands are spaced [pace] = srtt / window apart, so a knob sweep is
+///   coalesced to one command per slot the link can take instead of
+///   queueing in the firmware's RX ring.
+class LinkRate {
+  LinkRate({required this.maxWindow}) {
+    reset(115200);
+  }
+
+  static const int _kInitialRtoUs = 250000;
+  static const int _kMinRtoUs = 40000;
+  static const int _kMaxRtoUs = 2000000;
+  static const int _kMinRetryUs = 20000;
+  static const int _kMaxRetryUs = 250000;
+
+  final int maxWindow;
+
+  late int _baud;
+  int? _srttUs;
+  late int _rttvarUs;
+  late int _procUs;
+  late int _backoff;
+  late double _cwnd;
+  late double _ssthresh;
+
+  /// Forgets what was learned: a new connection at [baud].
+  void reset(int baud) {
+    _baud = baud;
+    _srttUs = null;
+    _rttvarUs = 0;
+    _procUs = 0;
+    _backoff = 1;
+    _cwnd = 1;
+    _ssthresh = maxWindow.toDouble();
+  }
+
+  int get window => min(maxWindow, max(1, _cwnd.floor()));
+
+  Duration get srtt => Duration(microseconds: _srttUs ?? 0);
+
+  Duration get processing => Duration(microseconds: _procUs);
+
+  Duration get rto {
+    final s = _srttUs;
+    final base = s == null
+        ? _kInitialRtoUs
+        : max(_kMinRtoUs, s + 4 * _rttvarUs);
+    return Duration(microseconds: min(_kMaxRtoUs, base * _backoff));
+  }
+
+  Duration get pace => Duration(microseconds: (_srttUs ?? 0) ~/ window);
+
+  /// How long to wait before looking again at what could not be sent.
+  Duration get retry => Duration(
+    microseconds: (_srttUs ?? _kMaxRetryUs).clamp(_kMinRetryUs, _kMaxRetryUs),
+  );
+
+  /// An ack [rttUs] after its command went out; [wireBytes] is the command
+  /// and reply length.
+  void onAck(int rttUs, int wireBytes) {
+    final s = _srttUs;
+    // 10 bits per byte on the UART; USB is faster, which only makes the
+    // processing estimate an upper bound.
+    final wireUs = wireBytes * 10 * 1000000 ~/ _baud;
+    final proc = max(0, rttUs - wireUs);
+    if (s == null) {
+      _srttUs = rttUs;
+      _rttvarUs = rttUs ~/ 2;
+      _procUs = proc;
+    } else {
+      _rttvarUs += ((rttUs - s).abs() - _rttvarUs) ~/ 4;
+      _srttUs = s + (rttUs - s) ~/ 8;
+      _procUs += (proc - _procUs) ~/ 8;
+    }
+    _backoff = 1;
+    if (_cwnd < _ssthresh) {
+      _cwnd += 1;
+    } else {
+      _cwnd += 1 / _cwnd;
+    }
+    _cwnd = min(_cwnd, maxWindow.toDouble());
+  }
+
+  /// An ack that never came.
+  void onTimeout() {
+    _ssthresh = max(1, _cwnd / 2);
+    _cwnd = _ssthresh;
+    _backoff = min(_backoff * 2, 16);
+  }
+
+  @override
+  String toString() {
+    String ms(Duration d) => (d.inMicroseconds / 1000).toStringAsFixed(1);
+    return 'rtt=${ms(srtt)} ms proc=${ms(processing)} ms '
+        'rto=${ms(rto)} ms window=$window';
+  }
+}
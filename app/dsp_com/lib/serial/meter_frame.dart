@@ -0,0 +1,50 @@
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+/// One unsolicited binary METER frame (cmd 0x40), streamed after `METER <hz>`:
+///
+///   <peak u16> <rms u16> x 5 taps, <comp gain u16> <limiter gain u16>
+///
+/// Levels are s24 >> 7 (65535 = full scale), gains are q15 (32768 = unity).
+class MeterFrame {
+  const MeterFrame({
+    required this.peak,
+    required this.rms,
+    required this.compGainQ15,
+    required this.limiterGainQ15,
+  });
+
+  static const int cmd = 0x40;
+
+  /// Tap order of the firmware's AppMeterTap.
+  static const List<String> tapNames = [
+    'In',
+    'Dist',
+    'Delay',
+    'Reverb',
+    'Out',
+  ];
+
+  final List<int> peak;
+  final List<int> rms;
+  final int compGainQ15;
+  final int limiterGainQ15;
+
+  static double levelDb(int v) =>
+      v <= 0 ? -96.0 : 20 * math.log(v / 65535.0) / math.ln10;
+
+  static double gainDb(int q15) =>
+      q15 <= 0 ? -96.0 : 20 * math.log(q15 / 32768.0) / math.ln10;
+
+  static MeterFrame? tryParse(Uint8List p) {
+    final n = tapNames.length;
+    if (p.length < (4 * n) + 4) return null;
+    final d = ByteData.sublistView(p);
+    return MeterFrame(
+      peak: [for (var t = 0; t < n; t++) d.getUint16(4 * t, Endian.little)],
+      rms: [for (var t = 0; t < n; t++) d.getUint16((4 * t) + 2, Endian.little)],
+      compGainQ15: d.getUint16(4 * n, Endian.little),
+      limiterGainQ15: d.getUint16((4 * n) + 2, Endian.little),
+    );
+  }
+}
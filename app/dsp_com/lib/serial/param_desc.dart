@@ -0,0 +1,58 @@
+/// One firmware parameter descriptor, as reported by `PLIST`:
+///
+///   PLIST <id> <name> min=<n> max=<n> def=<n> unit=<u> smooth_ms=<n> clamp=<0|1>
+class ParamDesc {
+  const ParamDesc({
+    required this.id,
+    required this.name,
+    required this.min,
+    required this.max,
+    required this.def,
+    required this.unit,
+    required this.smoothMs,
+    required this.clamp,
+  });
+
+  final int id;
+  final String name;
+  final int min;
+  final int max;
+  final int def;
+  final String unit;
+  final int smoothMs;
+
+  /// True if the firmware clamps out-of-range values, false if it ignores
+  /// them (discrete selections).
+  final bool clamp;
+
+  int clampValue(int v) => v < min ? min : (v > max ? max : v);
+
+  /// Parses one `PLIST <id> ...` line, or returns null for anything else.
+  static ParamDesc? tryParse(String line) {
+    final parts = line.split(RegExp(r'\s+'));
+    if (parts.length < 3 || parts[0] != 'PLIST') return null;
+    final id = int.tryParse(parts[1]);
+    if (id == null) return null;
+
+    final kv = <String, String>{};
+    for (final p in parts.skip(3)) {
+      final eq = p.indexOf('=');
+      if (eq > 0) kv[p.substring(0, eq)] = p.substring(eq + 1);
+    }
+    final min = int.tryParse(kv['min'] ?? '');
+    final max = int.tryParse(kv['max'] ?? '');
+    final def = int.tryParse(kv['def'] ?? '');
+    if (min == null || max == null || def == null) return null;
+
+    return ParamDesc(
+      id: id,
+      name: parts[2],
+      min: min,
+      max: max,
+      def: def,
+      unit: kv['unit'] ?? '',
+      smoothMs: int.tryParse(kv['smooth_ms'] ?? '') ?? 0,
+      clamp: kv['clamp'] != '0',
+    );
+  }
+}
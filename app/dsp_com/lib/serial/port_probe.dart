@@ -0,0 +1,189 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+// ignore: depend_on_referenced_packages
+import 'package:libserialport/libserialport.dart';
+
+import 'device_caps.dart';
+
+/// The pedal connected last: its port, the USB serial number of the
+/// adapter or the pedal's own USB port (null when it reports none) and the
+/// rate, in `dsp_com_link.json`. The serial number finds it again when a
+/// replug enumerates it under another name.
+class LinkMemory {
+  const LinkMemory({required this.port, this.serial, required this.baudRate});
+
+  final String port;
+  final String? serial;
+  final int baudRate;
+
+  static File get _file => File(
+    '${Directory.current.path}${Platform.pathSeparator}dsp_com_link.json',
+  );
+
+  static Future<LinkMemory?> load() async {
+    try {
+      final obj = jsonDecode(await _file.readAsString());
+      if (obj is! Map) return null;
+      final port = obj['port'];
+      final baud = obj['baud'];
+      final serial = obj['serial'];
+      if (port is! String || baud is! int) return null;
+      return LinkMemory(
+        port: port,
+        serial: serial is String ? serial : null,
+        baudRate: baud,
+      );
+    } catch (_) {
+      return null;
+    }
+  }
+
+  Future<void> save() async {
+    try {
+      await _file.writeAsString(
+        jsonEncode({'port': port, 'serial': serial, 'baud': baudRate}),
+      );
+    } on FileSystemException {
+      // Only costs the next connect its shortcut.
+    }
+  }
+
+  /// Where the pedal is among [ports]: the one with its serial number,
+  /// else the one with its name; null if it is not plugged in.
+  String? locate(List<String> ports) {
+    final s = serial;
+    if (s != null) {
+      for (final p in ports) {
+        if (PortProbe.serialOf(p) == s) return p;
+      }
+    }
+    return ports.contains(port) ? port : null;
+  }
+}
+
+/// A port where the pedal answered.
+class ProbeHit {
+  const ProbeHit(this.port, this.baudRate, this.caps);
+
+  final String port;
+  final int baudRate;
+
+  /// Null for firmware without CAPS.
+  final DeviceCaps? caps;
+}
+
+/// Finds the pedal: every candidate port is opened at once, each in its
+/// own isolate through libserialport (also on the desktops, whose runner
+/// transport holds one port), and asked `PING` at each rate in turn with a
+/// short timeout; the first `PONG` wins, and `CAPS` is asked on it. A port
+/// that answers nothing costs [_kTimeout] per rate, in parallel with the
+/// others.
+class PortProbe {
+  static const Duration _kTimeout = Duration(milliseconds: 300);
+
+  /// The USB serial number of [port], null if there is none or the port
+  /// is gone.
+  static String? serialOf(String port) {
+    final p = SerialPort(port);
+    try {
+      return p.serialNumber;
+    } catch (_) {
+      return null;
+    } finally {
+      p.dispose();
+    }
+  }
+
+  /// The first of [ports] that answers at one of [bauds] (tried in that
+  /// order), or null when none does.
+  static Future<ProbeHit?> find(List<String> ports, List<int> bauds) {
+    final done = Completer<ProbeHit?>();
+    var left = ports.length;
+    if (left == 0) return Future.value();
+    for (final port in ports) {
+      Isolate.run(() => _probe(port, bauds))
+          .then((hit) {
+            if (hit != null && !done.isCompleted) done.complete(hit);
+          })
+          .catchError((Object _) {})
+          .whenComplete(() {
+            if (--left == 0 && !done.isCompleted) done.complete(null);
+          });
+    }
+    return done.future;
+  }
+
+  /// Every one of [ports] that answers, probed all at once.
+  static Future<List<ProbeHit>> findAll(
+    List<String> ports,
+    List<int> bauds,
+  ) async {
+    final hits = await Future.wait([
+      for (final port in ports)
+        Isolate.run(
+          () => _probe(port, bauds),
+        ).catchError((Object _) => null),
+    ]);
+    return [for (final h in hits) ?h];
+  }
+
+  // Runs on its own isolate; the port is closed again before it returns,
+  // so the caller can open it.
+  static ProbeHit? _probe(String name, List<int> bauds) {
+    final port = SerialPort(name);
+    try {
+      if (!port.openReadWrite()) return null;
+      for (final baud in bauds) {
+        final config = SerialPortConfig()
+          ..baudRate = baud
+          ..bits = 8
+          ..stopBits = 1
+          ..parity = SerialPortParity.none
+          ..setFlowControl(SerialPortFlowControl.none);
+        port.config = config;
+        port.flush();
+        // The newline first ends whatever a previous host left half-sent.
+        if (_ask(port, '\nPING', 'PONG') == null) continue;
+        final caps = _ask(port, 'CAPS', 'CAPS ');
+        return ProbeHit(
+          name,
+          baud,
+          caps == null ? null : DeviceCaps.tryParse(caps),
+        );
+      }
+      return null;
+    } finally {
+      if (port.isOpen) port.close();
+      port.dispose();
+    }
+  }
+
+  // Sends [cmd] and returns the first line starting with [reply] within
+  // _kTimeout, or null.
+  static String? _ask(SerialPort port, String cmd, String reply) {
+    port.write(Uint8List.fromList(latin1.encode('$cmd\n')), timeout: 50);
+    final deadline = DateTime.now().add(_kTimeout);
+    final buf = StringBuffer();
+    while (true) {
+      final left = deadline.difference(DateTime.now()).inMilliseconds;
+      if (left <= 0) return null;
+      // A blocking read waits for all it asks for: one byte, or what
+      // is already there.
+      final avail = port.bytesAvailable;
+      final chunk = port.read(avail > 0 ? avail : 1, timeout: left);
+      for (final b in chunk) {
+        if (b == 10) {
+          final line = buf.toString().trim();
+          buf.clear();
+          if (line.startsWith(reply)) return line;
+        } else if (b != 13) {
+          buf.writeCharCode(b);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,240 @@
+import 'dart:async';
+import 'dart:math';
+import 'dart:typed_data';
+
+import '../presets/preset_record.dart';
+import 'link_event.dart';
+import 'param_desc.dart';
+
+/// `PBANK slots=<n> image=<bytes> params=<n> taps=<n> stored=<mask>
+/// fmt=<version> hash=<param hash>`: the pedal bank and the preset files
+/// its slots hold ([PresetRecord], app_preset.h).
+class PresetBankLayout {
+  const PresetBankLayout({
+    required this.slots,
+    required this.imageBytes,
+    required this.params,
+    required this.taps,
+    required this.stored,
+    required this.hash,
+  });
+
+  final int slots;
+  final int imageBytes;
+  final int params;
+  final int taps;
+  final int stored;
+  final int hash;
+
+  bool isStored(int slot) => ((stored >> slot) & 1) != 0;
+
+  static PresetBankLayout? tryParse(String line) {
+    if (!line.startsWith('PBANK ')) return null;
+    final kv = <String, int>{};
+    for (final p in line.split(RegExp(r'\s+')).skip(1)) {
+      final eq = p.indexOf('=');
+      final v = eq > 0 ? int.tryParse(p.substring(eq + 1)) : null;
+      if (v != null) kv[p.substring(0, eq)] = v;
+    }
+    final slots = kv['slots'];
+    final image = kv['image'];
+    final params = kv['params'];
+    final taps = kv['taps'];
+    final hash = kv['hash'];
+    if (slots == null ||
+        image == null ||
+        params == null ||
+        taps == null ||
+        hash == null) {
+      return null;
+    }
+    // Firmware from before the preset files, or a version this app does
+    // not know.
+    if (kv['fmt'] != PresetRecord.version) return null;
+    return PresetBankLayout(
+      slots: slots,
+      imageBytes: image,
+      params: params,
+      taps: taps,
+      stored: kv['stored'] ?? 0,
+      hash: hash,
+    );
+  }
+
+  /// The pedal's keys from its PLIST, checked against its param hash and
+  /// record size.
+  List<PresetKey> keys(Map<int, ParamDesc> descs) {
+    final keys = <PresetKey>[];
+    for (var id = 0; id < params; id++) {
+      final d = descs[id];
+      if (d == null) throw StateError('PLIST incomplete (param $id)');
+      keys.add(PresetKey(d.name, d.min, d.max, def: d.def));
+    }
+    if (PresetRecord.paramHash(keys) != hash ||
+        PresetRecord.size(keys, taps) != imageBytes) {
+      throw StateError('PLIST does not match the pedal bank');
+    }
+    return keys;
+  }
+}
+
+/// Moves whole presets between the library and the pedal bank with the
+/// binary PREAD / PSTAGE / PCOMMIT frames instead of PSET lines: a slot is
+/// a ~200-byte preset file, a few frames each way, and the same bytes the
+/// library stores.
+///
+/// Downloads keep [_kReadWindow] chunk reads in flight (the replies name
+/// their slot and offset); uploads send a slot's PSTAGE chunks and its
+/// PCOMMIT back to back and wait only for the commit, which the firmware
+/// checks against the CRC-32 of the whole image.
+class PresetBankTransfer {
+  PresetBankTransfer(this._send);
+
+  final void Function(int cmd, List<int> payload) _send;
+
+  static const int _kRead = 0x09;
+  static const int _kStage = 0x0A;
+  static const int _kCommit = 0x0B;
+  static const int _kReply = 0x80;
+
+  static const int _kReadChunk = 56;
+  static const int _kStageChunk = 40;
+  // ~60-byte PREAD replies in flight together; they must fit the
+  // firmware's 512-byte TX ring next to the METER stream.
+  static const int _kReadWindow = 6;
+  // Covers a commit that has to erase a page and copy the bank forward.
+  static const Duration _kTimeout = Duration(milliseconds: 500);
+
+  final List<_Wait> _waits = [];
+
+  /// Feeds a frame from the link. Returns true if it was a bank reply.
+  bool onFrame(FrameEvent e) {
+    if (e.cmd < (_kRead | _kReply) || e.cmd > (_kCommit | _kReply)) {
+      return false;
+    }
+    final cmd = e.cmd & ~_kReply;
+    for (var i = 0; i < _waits.length; i++) {
+      final w = _waits[i];
+      if (w.cmd == cmd && (w.match == null || w.match!(e.payload))) {
+        _waits.removeAt(i);
+        w.done.complete(e.payload);
+        break;
+      }
+    }
+    return true;
+  }
+
+  /// Reads every stored slot. [descs] maps the firmware's param ids to
+  /// names (PLIST).
+  Future<Map<int, PresetFile>> download(
+    PresetBankLayout layout,
+    Map<int, ParamDesc> descs,
+  ) async {
+    final keys = layout.keys(descs);
+    final images = <int, Uint8List>{
+      for (var slot = 0; slot < layout.slots; slot++)
+        if (layout.isStored(slot)) slot: Uint8List(layout.imageBytes),
+    };
+    final chunks = <(int, int)>[
+      for (final slot in images.keys)
+        for (var off = 0; off < layout.imageBytes; off += _kReadChunk)
+          (slot, off),
+    ];
+
+    var next = 0;
+    Future<void> reader() async {
+      while (next < chunks.length) {
+        final (slot, off) = chunks[next++];
+        final n = min(_kReadChunk, layout.imageBytes - off);
+        // <st> <slot> <offset u16> <bytes>
+        final r = await _request(
+          _kRead,
+          [slot, off & 0xFF, off >> 8, n],
+          match: (p) =>
+              p.length >= 4 && p[1] == slot && (p[2] | (p[3] << 8)) == off,
+        );
+        if (r[0] != 0 || r.length != 4 + n) {
+          throw StateError('PREAD slot $slot failed (st=${r[0]})');
+        }
+        images[slot]!.setRange(off, off + n, r, 4);
+      }
+    }
+
+    await Future.wait([for (var i = 0; i < _kReadWindow; i++) reader()]);
+    final files = <int, PresetFile>{};
+    for (final MapEntry(:key, :value) in images.entries) {
+      final data = PresetRecord.decode(value, keys);
+      if (data == null) throw StateError('slot $key is not a preset file');
+      files[key] = PresetFile(value, keys, data);
+    }
+    return files;
+  }
+
+  /// Writes [slots] (bank slot -> preset): as stored when it was written
+  /// against the pedal's params, else converted by param name. Params the
+  /// preset lacks get the firmware default.
+  Future<void> upload(
+    PresetBankLayout layout,
+    Map<int, ParamDesc> descs,
+    Map<int, PresetFile> slots,
+  ) async {
+    final keys = layout.keys(descs);
+    for (final MapEntry(key: slot, value: file) in slots.entries) {
+      if (slot >= layout.slots) continue;
+      final image = file.recordFor(keys, layout.taps);
+      final crc = ByteData.sublistView(
+        image,
+        image.length - 4,
+      ).getUint32(0, Endian.little);
+      for (var attempt = 0; ; attempt++) {
+        final acks = <Future<Uint8List>>[
+          for (var off = 0; off < image.length; off += _kStageChunk)
+            _request(_kStage, [
+              off & 0xFF,
+              off >> 8,
+              ...image.sublist(off, min(off + _kStageChunk, image.length)),
+            ]),
+          _request(_kCommit, [
+            slot,
+            crc & 0xFF,
+            (crc >> 8) & 0xFF,
+            (crc >> 16) & 0xFF,
+            (crc >> 24) & 0xFF,
+          ]),
+        ];
+        try {
+          final replies = await Future.wait(acks);
+          if (replies.last[0] == 0) break;
+        } on TimeoutException {
+          // Lost frame: resend the slot.
+        }
+        if (attempt == 1) throw StateError('upload of slot $slot failed');
+      }
+    }
+  }
+
+  Future<Uint8List> _request(
+    int cmd,
+    List<int> payload, {
+    bool Function(Uint8List payload)? match,
+  }) {
+    final w = _Wait(cmd, match);
+    _waits.add(w);
+    _send(cmd, payload);
+    return w.done.future.timeout(
+      _kTimeout,
+      onTimeout: () {
+        _waits.remove(w);
+        throw TimeoutException('bank frame 0x${cmd.toRadixString(16)}');
+      },
+    );
+  }
+}
+
+class _Wait {
+  _Wait(this.cmd, this.match);
+
+  final int cmd;
+  final bool Function(Uint8List payload)? match;
+  final Completer<Uint8List> done = Completer<Uint8List>();
+}
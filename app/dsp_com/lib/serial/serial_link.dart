@@ -1,29 +1,268 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:io';
+import 'dart:isolate';
 import 'dart:typed_data';
 
+import 'package:flutter/services.dart';
 // ignore: depend_on_referenced_packages
 import 'package:libserialport/libserialport.dart';
 
-class SerialLink {
-  SerialPort? _port;
-  SerialPortReader? _reader;
-  StreamSubscription<Uint8List>? _sub;
+import 'link_codec.dart';
+import 'link_event.dart';
+import 'session_log.dart';
 
-  final StringBuffer _rxBuf = StringBuffer();
+export 'link_codec.dart' show LinkDecoder, LinkFrame, PedalLink;
+export 'link_event.dart';
 
-  bool get isOpen => _port?.isOpen ?? false;
-  String? get portName => _port?.name;
+/// Serial port owned by a background isolate. The isolate reads the port,
+/// frames ASCII lines and binary frames, decodes them and hands the UI
+/// batches of [LinkEvent]s, so no byte-level work runs on the UI isolate.
+/// [sendLine] goes to the isolate, which writes the port. On the desktops
+/// the port itself is the runner's native transport (Windows: overlapped
+/// I/O woken by comm events; Linux and macOS: a raw termios tty woken by
+/// epoll or kqueue); other platforms read it through libserialport, and so
+/// does any desktop with `native: false`, as the runner transport holds
+/// one port at a time (the fleet page has many). With a `recordPath` the
+/// worker also records the session ([SessionLog]).
+class SerialLink implements PedalLink {
+  ReceivePort? _fromWorker;
+  SendPort? _toWorker;
+  Future<void>? _exited;
+  String? _portName;
+
+  @override
+  bool get isOpen => _toWorker != null;
+  @override
+  String? get portName => _portName;
+
+  /// Completes once the worker is gone and the port and the session log
+  /// are closed.
+  @override
+  Future<void> get closed => _exited ?? Future<void>.value();
 
   Future<void> open({
     required String portName,
     required int baudRate,
-    required void Function(String line) onLine,
+    required void Function(LinkEvent event) onEvent,
+    String? recordPath,
+    bool native = true,
   }) async {
     close();
+    await _exited;
+
+    final fromWorker = ReceivePort();
+    final exit = ReceivePort();
+    final opened = Completer<SendPort>();
+    _fromWorker = fromWorker;
+    _exited = exit.first.then((_) => exit.close());
+
+    fromWorker.listen((msg) {
+      if (msg is SendPort) {
+        opened.complete(msg);
+      } else if (msg is _OpenFailed) {
+        opened.completeError(StateError(msg.message));
+      } else if (msg is List<LinkEvent>) {
+        for (final e in msg) {
+          if (e is LinkErrorEvent) _detach();
+          onEvent(e);
+        }
+      }
+    });
+
+    await Isolate.spawn(
+      _workerMain,
+      _WorkerArgs(
+        fromWorker.sendPort,
+        portName,
+        baudRate,
+        recordPath,
+        native ? RootIsolateToken.instance : null,
+      ),
+      onExit: exit.sendPort,
+      debugName: 'serial $portName',
+    );
+
+    try {
+      _toWorker = await opened.future;
+      _portName = portName;
+    } catch (_) {
+      _detach();
+      rethrow;
+    }
+  }
+
+  @override
+  void sendLine(String line) => _toWorker?.send(line);
+
+  /// Sends bytes as they are (a recorded command, [SessionReplay]).
+  @override
+  void sendBytes(Uint8List bytes) => _toWorker?.send(bytes);
+
+  /// Sends one binary frame (`0xA5 <len> <cmd> <payload> <crc16>`, see
+  /// app_com.c); the firmware answers with `cmd | 0x80`.
+  @override
+  void sendFrame(int cmd, List<int> payload) =>
+      _toWorker?.send(LinkFrame.encode(cmd, payload));
+
+  /// Stops the reader isolate; the port is closed once it exits, which
+  /// the next [open] waits for.
+  @override
+  void close() {
+    _toWorker?.send(null);
+    _detach();
+  }
+
+  void _detach() {
+    _fromWorker?.close();
+    _fromWorker = null;
+    _toWorker = null;
+    _portName = null;
+  }
+}
+
+class _WorkerArgs {
+  const _WorkerArgs(
+    this.toUi,
+    this.portName,
+    this.baudRate,
+    this.recordPath,
+    this.token,
+  );
+
+  final SendPort toUi;
+  final String portName;
+  final int baudRate;
+  final String? recordPath;
+  // Lets the worker reach the runner's platform channels (desktops).
+  final RootIsolateToken? token;
+}
+
+class _OpenFailed {
+  const _OpenFailed(this.message);
+
+  final String message;
+}
+
+Future<void> _workerMain(_WorkerArgs args) async {
+  final _Port port;
+  try {
+    port = await _Port.open(args);
+  } catch (e) {
+    args.toUi.send(_OpenFailed('$e'));
+    Isolate.exit();
+  }
+
+  final decoder = LinkDecoder();
+  final credit = CreditGate(port.write);
+  final commands = ReceivePort();
+  final path = args.recordPath;
+  final recorder = path == null
+      ? null
+      : SessionRecorder.open(path, args.baudRate);
+  StreamSubscription<Uint8List>? sub;
+
+  Future<void> shutdown() async {
+    credit.dispose();
+    await sub?.cancel();
+    commands.close();
+    recorder?.close();
+    await port.close();
+    Isolate.exit();
+  }
 
+  sub = port.rx.listen(
+    (data) {
+      recorder?.rx(data);
+      final events = decoder.ingest(data)..removeWhere(credit.take);
+      if (events.isNotEmpty) args.toUi.send(events);
+    },
+    onError: (Object e) {
+      args.toUi.send(<LinkEvent>[LinkErrorEvent('$e')]);
+      shutdown();
+    },
+  );
+
+  commands.listen((msg) {
+    if (msg is String) {
+      final bytes = Uint8List.fromList(utf8.encode('$msg\n'));
+      recorder?.tx(bytes);
+      credit.write(bytes);
+    } else if (msg is Uint8List) {
+      recorder?.tx(msg);
+      credit.write(msg);
+    } else {
+      shutdown();
+    }
+  });
+
+  credit.start();
+  args.toUi.send(commands.sendPort);
+}
+
+/// The port as the worker sees it.
+abstract class _Port {
+  /// The runner's transport on the desktops, libserialport elsewhere.
+  static Future<_Port> open(_WorkerArgs args) {
+    final token = args.token;
+    final desktop = Platform.isWindows || Platform.isLinux || Platform.isMacOS;
+    if (desktop && token != null) {
+      BackgroundIsolateBinaryMessenger.ensureInitialized(token);
+      return _NativePort.open(args.portName, args.baudRate);
+    }
+    return Future.value(_LibSerialPort.open(args.portName, args.baudRate));
+  }
+
+  Stream<Uint8List> get rx;
+  void write(Uint8List bytes);
+  Future<void> close();
+}
+
+/// windows/runner/serial_transport.cpp, linux/runner/serial_transport.cc,
+/// macos/Runner/SerialTransport.swift: reads come in as batches, coalesced
+/// on the native side, so one event can carry several lines and frames.
+class _NativePort implements _Port {
+  _NativePort._();
+
+  static const MethodChannel _method = MethodChannel('dsp_com/serial');
+  static const EventChannel _events = EventChannel('dsp_com/serial/rx');
+
+  static Future<_Port> open(String portName, int baudRate) async {
+    try {
+      await _method.invokeMethod<void>('open', <String, Object>{
+        'port': portName,
+        'baud': baudRate,
+      });
+    } on PlatformException catch (e) {
+      throw StateError('Failed to open $portName: ${e.message}');
+    }
+    return _NativePort._();
+  }
+
+  @override
+  Stream<Uint8List> get rx =>
+      _events.receiveBroadcastStream().map((e) => e as Uint8List);
+
+  @override
+  void write(Uint8List bytes) {
+    // A failed write shows up as a read error soon after.
+    _method.invokeMethod<void>('write', bytes).catchError((Object _) {});
+  }
+
+  @override
+  Future<void> close() => _method.invokeMethod<void>('close');
+}
+
+class _LibSerialPort implements _Port {
+  _LibSerialPort._(this._port) : _reader = SerialPortReader(_port);
+
+  final SerialPort _port;
+  final SerialPortReader _reader;
+
+  static _Port open(String portName, int baudRate) {
     final port = SerialPort(portName);
     if (!port.openReadWrite()) {
+      port.dispose();
       throw StateError('Failed to open $portName');
     }
 
@@ -34,38 +273,18 @@ class SerialLink {
     config.parity = SerialPortParity.none;
     config.setFlowControl(SerialPortFlowControl.none);
     port.config = config;
-
-    _port = port;
-    _reader = SerialPortReader(port);
-    _sub = _reader!.stream.listen((data) {
-      _ingest(data, onLine);
-    });
+    return _LibSerialPort._(port);
   }
 
-  void _ingest(Uint8List data, void Function(String line) onLine) {
-    for (final b in data) {
-      if (b == 10) {
-        final line = _rxBuf.toString().trim();
-        _rxBuf.clear();
-        if (line.isNotEmpty) {
-          onLine(line);
-        }
-      } else if (b == 13) {
-        // ignore CR
-      } else {
-        _rxBuf.writeCharCode(b);
-      }
-    }
-  }
+  @override
+  Stream<Uint8List> get rx => _reader.stream;
 
-  void sendLine(String line) {
-    final port = _port;
-    if (port == null || !port.isOpen) return;
-    final bytes = Uint8List.fromList(utf8.encode('$line\n'));
+  @override
+  void write(Uint8List bytes) {
     var offset = 0;
     while (offset < bytes.length) {
       final chunk = Uint8List.sublistView(bytes, offset);
-      final written = port.write(chunk);
+      final written = _port.write(chunk);
       if (written <= 0) {
         // If we can't write, bail to avoid spinning.
         break;
@@ -74,15 +293,10 @@ class SerialLink {
     }
   }
 
-  void close() {
-    _sub?.cancel();
-    _sub = null;
-    _reader = null;
-    final p = _port;
-    _port = null;
-    if (p != null && p.isOpen) {
-      p.close();
-    }
-    _rxBuf.clear();
+  @override
+  Future<void> close() async {
+    _reader.close();
+    if (_port.isOpen) _port.close();
+    _port.dispose();
   }
 }
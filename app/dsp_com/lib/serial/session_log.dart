@@ -0,0 +1,314 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import '../utils/debug_log.dart';
+import 'serial_link.dart';
+
+/// A recorded serial session (`sessions/<name>.dsl`), for reproducing a
+/// sluggish link and comparing protocol changes on the same workload.
+///
+/// The reader isolate writes it ([SessionRecorder]): every command the app
+/// sends, as one entry, when the worker takes it (before the CREDIT gate,
+/// whose own lines are not recorded), and every chunk read from the port,
+/// each with its time since the port opened. All little-endian:
+///
+///   header  `DSPS` <version u8> <0 u8> <0 u16> <baud u32>
+///           <start, microseconds since the epoch u64>
+///   entry   <microseconds since open u64> <dir u8: 'T' or 'R'> <0 u8>
+///           <length u16> <bytes>
+///
+/// [SessionReplay] sends the T entries of a session to a pedal again at
+/// their original times, recording the replay the same way, and both logs
+/// go through the same [analyze], so the round trips compare like for like.
+class SessionLog {
+  const SessionLog(this.baudRate, this.started, this.entries);
+
+  static const int magic = 0x53505344; // "DSPS"
+  static const int version = 1;
+  static const int headerBytes = 20;
+  static const int entryHeaderBytes = 12;
+  static const int tx = 0x54; // 'T'
+  static const int rx = 0x52; // 'R'
+  static const String extension = '.dsl';
+
+  final int baudRate;
+  final DateTime started;
+  final List<SessionEntry> entries;
+
+  /// Reads a whole log; an entry cut short (a crash while recording) ends
+  /// it. Null if [file] is not a session log.
+  static Future<SessionLog?> read(File file) async {
+    final Uint8List bytes;
+    try {
+      bytes = await file.readAsBytes();
+    } on FileSystemException {
+      return null;
+    }
+    if (bytes.length < headerBytes) return null;
+    final b = ByteData.sublistView(bytes);
+    if (b.getUint32(0, Endian.little) != magic || bytes[4] != version) {
+      return null;
+    }
+    final entries = <SessionEntry>[];
+    var o = headerBytes;
+    while (o + entryHeaderBytes <= bytes.length) {
+      final n = b.getUint16(o + 10, Endian.little);
+      final end = o + entryHeaderBytes + n;
+      if (end > bytes.length) break;
+      entries.add(
+        SessionEntry(
+          b.getUint64(o, Endian.little),
+          bytes[o + 8] == tx,
+          Uint8List.sublistView(bytes, o + entryHeaderBytes, end),
+        ),
+      );
+      o = end;
+    }
+    return SessionLog(
+      b.getUint32(8, Endian.little),
+      DateTime.fromMicrosecondsSinceEpoch(b.getUint64(12, Endian.little)),
+      entries,
+    );
+  }
+
+  /// Round trips of the commands in the log: a `#<seq>` tagged line to the
+  /// first reply with its tag (a QACK answers every tag up to its own), a
+  /// binary frame to the next frame of `cmd | 0x80`. Untagged lines have no
+  /// reply to match and are not counted; a command with no reply by the
+  /// end is lost.
+  RttStats analyze() {
+    final stats = RttStats();
+    final tags = <int, int>{};
+    final frames = <int, List<int>>{};
+    final decoder = LinkDecoder();
+
+    for (final e in entries) {
+      if (e.tx) {
+        if (e.bytes.isEmpty) continue;
+        if (e.bytes[0] == LinkDecoder.frameSync) {
+          if (e.bytes.length > 2) {
+            frames.putIfAbsent(e.bytes[2], () => <int>[]).add(e.tUs);
+          }
+          continue;
+        }
+        final tag = _tag.firstMatch(latin1.decode(e.bytes));
+        if (tag != null) tags[int.parse(tag.group(1)!)] = e.tUs;
+        continue;
+      }
+      for (final ev in decoder.ingest(e.bytes)) {
+        if (ev is LineEvent) {
+          final seq = ev.seq;
+          if (seq != null) {
+            final sent = tags.remove(seq);
+            if (sent != null) stats.add(e.tUs - sent);
+          } else if (ev.line.startsWith('QACK ')) {
+            final upTo = int.tryParse(ev.line.substring(5).trim());
+            if (upTo == null || !tags.containsKey(upTo)) continue;
+            for (final k in tags.keys.toList()) {
+              stats.add(e.tUs - tags.remove(k)!);
+              if (k == upTo) break;
+            }
+          }
+        } else if (ev is FrameEvent) {
+          final sent = frames[ev.cmd & 0x7F];
+          if (sent != null && sent.isNotEmpty) {
+            stats.add(e.tUs - sent.removeAt(0));
+          }
+        }
+      }
+    }
+    stats.lost = tags.length + frames.values.fold(0, (n, l) => n + l.length);
+    return stats;
+  }
+
+  static final RegExp _tag = RegExp(r'^#(\d+) ');
+}
+
+class SessionEntry {
+  const SessionEntry(this.tUs, this.tx, this.bytes);
+
+  /// Microseconds since the port opened.
+  final int tUs;
+  final bool tx;
+  final Uint8List bytes;
+}
+
+/// Round-trip times in microseconds, and the commands never answered.
+class RttStats {
+  final List<int> _us = <int>[];
+  bool _sorted = true;
+  int lost = 0;
+
+  int get count => _us.length;
+
+  void add(int us) {
+    _us.add(us);
+    _sorted = false;
+  }
+
+  /// The [p] quantile (0..1) by nearest rank, 0 when empty.
+  int quantile(double p) {
+    if (_us.isEmpty) return 0;
+    if (!_sorted) {
+      _us.sort();
+      _sorted = true;
+    }
+    return _us[((p * _us.length).ceil() - 1).clamp(0, _us.length - 1)];
+  }
+
+  @override
+  String toString() {
+    String ms(int us) => (us / 1000).toStringAsFixed(2);
+    return 'n=$count min=${ms(quantile(0))} p50=${ms(quantile(0.5))} '
+        'p95=${ms(quantile(0.95))} max=${ms(quantile(1))} ms lost=$lost';
+  }
+}
+
+/// Writes a [SessionLog] on the reader isolate. Entries collect in a block
+/// and go to the file when it fills, and at least every [_kFlushEvery], so
+/// a crash loses at most that much and the port is never held up by the
+/// disk. A failed write ends the recording, not the link.
+class SessionRecorder {
+  SessionRecorder._(this._file) {
+    _clock.start();
+    _flushTimer = Timer.periodic(_kFlushEvery, (_) => _flush());
+  }
+
+  static const int _kBlock = 64 * 1024;
+  static const Duration _kFlushEvery = Duration(seconds: 1);
+
+  RandomAccessFile? _file;
+  final Stopwatch _clock = Stopwatch();
+  final Uint8List _buf = Uint8List(_kBlock);
+  late final ByteData _b = ByteData.sublistView(_buf);
+  int _n = 0;
+  Timer? _flushTimer;
+
+  /// Starts a log at [path] (its directory is created), or returns null
+  /// when it cannot be written.
+  static SessionRecorder? open(String path, int baudRate) {
+    try {
+      final file = File(path);
+      file.parent.createSync(recursive: true);
+      final raf = file.openSync(mode: FileMode.write);
+      final head = ByteData(SessionLog.headerBytes)
+        ..setUint32(0, SessionLog.magic, Endian.little)
+        ..setUint8(4, SessionLog.version)
+        ..setUint32(8, baudRate, Endian.little)
+        ..setUint64(
+          12,
+          DateTime.now().microsecondsSinceEpoch,
+          Endian.little,
+        );
+      raf.writeFromSync(head.buffer.asUint8List());
+      return SessionRecorder._(raf);
+    } on FileSystemException catch (e) {
+      dlogState(() => 'session log not started: $e');
+      return null;
+    }
+  }
+
+  void tx(Uint8List bytes) => _add(SessionLog.tx, bytes);
+  void rx(Uint8List bytes) => _add(SessionLog.rx, bytes);
+
+  void _add(int dir, Uint8List bytes) {
+    if (_file == null) return;
+    final t = _clock.elapsedMicroseconds;
+    var o = 0;
+    do {
+      final n = min(bytes.length - o, _kBlock - SessionLog.entryHeaderBytes);
+      if (_n + SessionLog.entryHeaderBytes + n > _kBlock) _flush();
+      _b
+        ..setUint64(_n, t, Endian.little)
+        ..setUint8(_n + 8, dir)
+        ..setUint8(_n + 9, 0)
+        ..setUint16(_n + 10, n, Endian.little);
+      _n += SessionLog.entryHeaderBytes;
+      _buf.setRange(_n, _n + n, bytes, o);
+      _n += n;
+      o += n;
+    } while (o < bytes.length);
+  }
+
+  void _flush() {
+    final f = _file;
+    if (f == null || _n == 0) return;
+    try {
+      f.writeFromSync(_buf, 0, _n);
+    } on FileSystemException catch (e) {
+      dlogState(() => 'session log stopped: $e');
+      _stop();
+    }
+    _n = 0;
+  }
+
+  void _stop() {
+    _flushTimer?.cancel();
+    try {
+      _file?.closeSync();
+    } on FileSystemException {
+      // Nothing more to lose.
+    }
+    _file = null;
+  }
+
+  void close() {
+    _flush();
+    _stop();
+  }
+}
+
+/// Sends a recorded session to a pedal again at its original timing.
+class SessionReplay {
+  // How long the replay waits for replies after its last command: until
+  // the link is quiet this long, at most _kDrainMax.
+  static const Duration _kQuiet = Duration(milliseconds: 500);
+  static const Duration _kDrainMax = Duration(seconds: 3);
+
+  /// Opens [portName], replays [log] into it and records the replay to
+  /// [recordPath]; returns the replay's log, or null if it could not be
+  /// read back. [onEvent] sees the pedal's traffic as it comes.
+  static Future<SessionLog?> run({
+    required SessionLog log,
+    required String portName,
+    required int baudRate,
+    required String recordPath,
+    void Function(LinkEvent event)? onEvent,
+  }) async {
+    final link = SerialLink();
+    final clock = Stopwatch();
+    var lastRx = Duration.zero;
+    await link.open(
+      portName: portName,
+      baudRate: baudRate,
+      recordPath: recordPath,
+      onEvent: (e) {
+        lastRx = clock.elapsed;
+        onEvent?.call(e);
+      },
+    );
+    clock.start();
+
+    final sends = log.entries.where((e) => e.tx).toList();
+    final t0 = sends.isEmpty ? 0 : sends.first.tUs;
+    for (final e in sends) {
+      final wait = e.tUs - t0 - clock.elapsedMicroseconds;
+      if (wait > 0) await Future<void>.delayed(Duration(microseconds: wait));
+      if (!link.isOpen) break;
+      link.sendBytes(e.bytes);
+    }
+
+    final end = clock.elapsed + _kDrainMax;
+    while (link.isOpen &&
+        clock.elapsed < end &&
+        clock.elapsed - lastRx < _kQuiet) {
+      await Future<void>.delayed(const Duration(milliseconds: 20));
+    }
+    link.close();
+    await link.closed;
+    return SessionLog.read(File(recordPath));
+  }
+}
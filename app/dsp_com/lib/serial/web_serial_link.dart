@@ -0,0 +1,256 @@
+import 'dart:convert';
+import 'dart:js_interop';
+import 'dart:typed_data';
+
+import 'link_codec.dart';
+import 'link_event.dart';
+
+export 'link_codec.dart' show LinkFrame, PedalLink, PickerLink;
+export 'link_event.dart';
+
+/// The pedal through the browser's WebSerial (Chrome, Edge, ChromeOS), for
+/// the web build, where there is neither libserialport nor an isolate.
+/// One streaming reader feeds [LinkDecoder] on the UI isolate as chunks
+/// arrive; writes go through a [WriteBatcher], so a knob turn's PSET frames
+/// and their CREDIT accounting cost a single promise round trip. The
+/// firmware is driven as over [SerialLink], binary frames included.
+class WebSerialLink implements PickerLink {
+  // The browser's default stream buffer is 255 bytes; a larger one lets a
+  // burst (PLIST, METER frames at full rate) land in one read.
+  static const int _kBufferBytes = 4096;
+  static const int _kDefaultBaud = 115200;
+
+  _SerialPort? _chosen;
+  _SerialPort? _port;
+  _Reader? _reader;
+  _Writer? _writer;
+  String? _portName;
+  Future<void>? _exited;
+  Future<void>? _reading;
+
+  CreditGate? _credit;
+  WriteBatcher? _batcher;
+
+  @override
+  String? get unavailableReason => _serial == null
+      ? 'This browser has no WebSerial; use Chrome or Edge.'
+      : null;
+
+  @override
+  bool get isOpen => _port != null;
+  @override
+  String? get portName => _portName;
+
+  @override
+  Future<void> get closed => _exited ?? Future<void>.value();
+
+  @override
+  bool get hasPort => _chosen != null;
+
+  /// Asks the user for a port. The browser only shows its picker from a
+  /// user gesture, so call this straight from a button press. False if
+  /// the picker was dismissed.
+  @override
+  Future<bool> choose() async {
+    final serial = _serial;
+    if (serial == null) return false;
+    try {
+      _chosen = await serial.requestPort().toDart;
+      return true;
+    } catch (_) {
+      return false;
+    }
+  }
+
+  /// Takes the first port this site was already granted, so a reload
+  /// reconnects without the picker. False if there is none.
+  @override
+  Future<bool> restore() async {
+    final serial = _serial;
+    if (serial == null) return false;
+    final ports = (await serial.getPorts().toDart).toDart;
+    if (ports.isEmpty) return false;
+    _chosen = ports.first;
+    return true;
+  }
+
+  @override
+  Future<void> open({
+    required void Function(LinkEvent event) onEvent,
+    int? baudRate,
+  }) async {
+    close();
+    await _exited;
+    final port = _chosen;
+    if (port == null) throw StateError('No port chosen');
+
+    try {
+      await port
+          .open(
+            _SerialOptions(
+              baudRate: baudRate ?? _kDefaultBaud,
+              bufferSize: _kBufferBytes,
+            ),
+          )
+          .toDart;
+    } catch (e) {
+      throw StateError('Port open failed ($e)');
+    }
+    final readable = port.readable;
+    final writable = port.writable;
+    if (readable == null || writable == null) {
+      await port.close().toDart;
+      throw StateError('Port has no streams');
+    }
+
+    final reader = readable.getReader();
+    final writer = writable.getWriter();
+    final batcher = WriteBatcher((b) => writer.write(b.toJS).toDart);
+    final credit = CreditGate(batcher.add);
+    _port = port;
+    _reader = reader;
+    _writer = writer;
+    _batcher = batcher;
+    _credit = credit;
+    _portName = _nameOf(port);
+    _exited = null;
+    _reading = _readLoop(reader, LinkDecoder(), credit, onEvent);
+    credit.start();
+  }
+
+  Future<void> _readLoop(
+    _Reader reader,
+    LinkDecoder decoder,
+    CreditGate credit,
+    void Function(LinkEvent event) onEvent,
+  ) async {
+    try {
+      while (true) {
+        final chunk = await reader.read().toDart;
+        if (chunk.done) break;
+        final data = chunk.value?.toDart;
+        if (data == null || data.isEmpty) continue;
+        final events = decoder.ingest(data)..removeWhere(credit.take);
+        for (final e in events) {
+          onEvent(e);
+        }
+      }
+    } catch (e) {
+      // A cancel from close() ends the read as done; anything else is the
+      // port failing under us (unplugged).
+      if (_reader == reader) {
+        onEvent(LinkErrorEvent('$e'));
+        close();
+      }
+    }
+  }
+
+  @override
+  void sendLine(String line) {
+    if (!isOpen) return;
+    _credit!.write(Uint8List.fromList(utf8.encode('$line\n')));
+  }
+
+  @override
+  void sendBytes(Uint8List bytes) => _credit?.write(bytes);
+
+  @override
+  void sendFrame(int cmd, List<int> payload) =>
+      _credit?.write(LinkFrame.encode(cmd, payload));
+
+  @override
+  void close() {
+    final port = _port;
+    if (port == null) return;
+    final reader = _reader!;
+    final writer = _writer!;
+    final reading = _reading!;
+    _credit?.dispose();
+    _credit = null;
+    _batcher?.close();
+    _batcher = null;
+    _port = null;
+    _reader = null;
+    _writer = null;
+    _reading = null;
+    _portName = null;
+    _exited = _shutdown(port, reader, writer, reading);
+  }
+
+  static Future<void> _shutdown(
+    _SerialPort port,
+    _Reader reader,
+    _Writer writer,
+    Future<void> reading,
+  ) async {
+    try {
+      await reader.cancel().toDart;
+    } catch (_) {}
+    await reading;
+    reader.releaseLock();
+    writer.releaseLock();
+    try {
+      await port.close().toDart;
+    } catch (_) {}
+  }
+
+  static String _nameOf(_SerialPort port) {
+    final info = port.getInfo();
+    final vid = info.usbVendorId;
+    final pid = info.usbProductId;
+    if (vid == null || pid == null) return 'serial';
+    String hex(int v) => v.toRadixString(16).padLeft(4, '0');
+    return 'USB ${hex(vid)}:${hex(pid)}';
+  }
+}
+
+// WebSerial (https://wicg.github.io/serial/), only what the link uses.
+
+@JS('navigator.serial')
+external _Serial? get _serial;
+
+extension type _Serial._(JSObject _) implements JSObject {
+  external JSPromise<_SerialPort> requestPort();
+  external JSPromise<JSArray<_SerialPort>> getPorts();
+}
+
+extension type _SerialPort._(JSObject _) implements JSObject {
+  external JSPromise<JSAny?> open(_SerialOptions options);
+  external JSPromise<JSAny?> close();
+  external _ReadableStream? get readable;
+  external _WritableStream? get writable;
+  external _PortInfo getInfo();
+}
+
+extension type _SerialOptions._(JSObject _) implements JSObject {
+  external factory _SerialOptions({int baudRate, int bufferSize});
+}
+
+extension type _PortInfo._(JSObject _) implements JSObject {
+  external int? get usbVendorId;
+  external int? get usbProductId;
+}
+
+extension type _ReadableStream._(JSObject _) implements JSObject {
+  external _Reader getReader();
+}
+
+extension type _Reader._(JSObject _) implements JSObject {
+  external JSPromise<_ReadResult> read();
+  external JSPromise<JSAny?> cancel();
+  external void releaseLock();
+}
+
+extension type _ReadResult._(JSObject _) implements JSObject {
+  external bool get done;
+  external JSUint8Array? get value;
+}
+
+extension type _WritableStream._(JSObject _) implements JSObject {
+  external _Writer getWriter();
+}
+
+extension type _Writer._(JSObject _) implements JSObject {
+  external JSPromise<JSAny?> write(JSUint8Array chunk);
+  external void releaseLock();
+}
@@ -0,0 +1,378 @@
+import 'dart:async';
+
+import 'package:flutter/material.dart';
+
+import '../home/widgets/meter_section.dart';
+import '../home/widgets/pedal_section.dart';
+import '../serial/device_caps.dart';
+import '../serial/dist_model.dart';
+import '../serial/meter_frame.dart';
+import '../serial/param_desc.dart';
+import '../serial/link_codec.dart';
+import '../serial/link_event.dart';
+import '../utils/startup_clock.dart';
+
+/// The pedal's knobs, footswitches and meters over a [PickerLink], for the
+/// builds without the desktop HomePage: WebSerial in a browser, BLE on a
+/// phone. Knob turns go out as binary PSET frames and the footswitches as
+/// binary FXMASK, and the firmware's EVT pushes keep the page in step with
+/// the pedal. Presets, sessions, the bench and the fleet stay desktop-only.
+class TuningPage extends StatefulWidget {
+  const TuningPage({super.key, required this.link, this.bauds = const []});
+
+  final PickerLink link;
+
+  /// Line rates to offer; empty for a link that has none (BLE).
+  final List<int> bauds;
+
+  @override
+  State<TuningPage> createState() => _TuningPageState();
+}
+
+class _TuningPageState extends State<TuningPage> {
+  static const String _kPedalBgAsset = 'assets/background.jpg';
+  static const String _kKnobAsset = 'assets/figma/empress_knob.png';
+
+  static const int _kBinPset = 0x02;
+  static const int _kBinFxMask = 0x04;
+  static const int _kBinReply = 0x80;
+  static const int _kMeterHz = 20;
+
+  // Full scale of each knob's parameter (100 %); the volume knob goes to
+  // 200 %, the rest stop at 100 %.
+  static const Map<String, int> _kFullScale = {
+    'delay_mix_q15': 32768,
+    'reverb_mix_q15': 32768,
+    'delay_feedback_q15': 32768,
+    'dist_drive_q8': 131072,
+    'reverb_feedback_q15': 32768,
+    'reverb_damp_q15': 32768,
+    'gain_q15': 32768,
+  };
+
+  // A knob turned this recently keeps its own value over the firmware's
+  // EVT echo of an earlier step.
+  static const Duration _kEchoHold = Duration(milliseconds: 500);
+
+  late final PickerLink _link = widget.link;
+  late int? _baudRate = widget.bauds.isEmpty ? null : widget.bauds.first;
+  bool _busy = false;
+  bool _ready = false;
+  String _status = '';
+
+  final Map<String, ParamDesc> _descs = {};
+  final List<DistModel> _models = [];
+  final Map<String, int> _values = {};
+  final Map<String, int> _pending = {};
+  final Map<String, Stopwatch> _turned = {};
+  bool _flushScheduled = false;
+  int _fxMask = 0;
+  DeviceCaps? _caps;
+  MeterFrame? _meter;
+
+  @override
+  void initState() {
+    super.initState();
+    WidgetsBinding.instance.addPostFrameCallback(
+      (_) => StartupClock.mark(StartupClock.firstFrame),
+    );
+    final unavailable = _link.unavailableReason;
+    if (unavailable != null) {
+      _status = unavailable;
+      return;
+    }
+    // A port granted on an earlier visit (a pedal still connected to the
+    // phone) opens without the picker.
+    _link.restore().then((ok) {
+      if (ok && mounted) _open();
+    });
+  }
+
+  @override
+  void dispose() {
+    _link.close();
+    super.dispose();
+  }
+
+  Future<void> _connectOrDisconnect() async {
+    if (_link.isOpen) {
+      _link.close();
+      setState(() {
+        _ready = false;
+        _meter = null;
+        _status = 'Disconnected';
+      });
+      return;
+    }
+    // The browser's picker needs this button press, so it comes before
+    // any await.
+    setState(() => _status = 'Looking for the pedal...');
+    if (!await _link.choose()) {
+      if (mounted) setState(() => _status = 'No pedal chosen');
+      return;
+    }
+    await _open();
+  }
+
+  Future<void> _open() async {
+    setState(() {
+      _busy = true;
+      _ready = false;
+      _status = 'Opening...';
+    });
+    try {
+      await _link.open(baudRate: _baudRate, onEvent: _onEvent);
+    } catch (e) {
+      if (!mounted) return;
+      setState(() {
+        _busy = false;
+        _status = '$e';
+      });
+      return;
+    }
+    StartupClock.mark(StartupClock.portOpen);
+    _descs.clear();
+    _models.clear();
+    _caps = null;
+    _link.sendLine('EVT ON');
+    _link.sendLine('CAPS');
+    _link.sendLine('PLIST');
+    _link.sendLine('STATUS');
+    _link.sendLine('DMODEL');
+    _link.sendLine('METER $_kMeterHz');
+    if (!mounted) return;
+    setState(() {
+      _busy = false;
+      _status = _baudRate == null
+          ? 'Connected: ${_link.portName}'
+          : 'Port open: ${_link.portName} @ $_baudRate';
+    });
+  }
+
+  void _onEvent(LinkEvent event) {
+    switch (event) {
+      case MeterEvent(:final frame):
+        setState(() => _meter = frame);
+      case FrameEvent(:final cmd, :final payload):
+        final st = payload.isEmpty ? -1 : payload[0];
+        if ((cmd == (_kBinPset | _kBinReply) ||
+                cmd == (_kBinFxMask | _kBinReply)) &&
+            st != 0) {
+          setState(() => _status = 'Rejected by the pedal (status $st)');
+        }
+      case LinkErrorEvent(:final message):
+        setState(() {
+          _ready = false;
+          _meter = null;
+          _status = 'Link lost: $message';
+        });
+      case ParamEvent(:final desc):
+        _descs[desc.name] = desc;
+      case StatusEvent(:final values):
+        for (final MapEntry(:key, value: v) in values.entries) {
+          if (key == 'FXMASK') {
+            _fxMask = v;
+          } else if (key == 'dist_os' && _values[key] != v) {
+            // The model costs are quoted at dist_os.
+            _values[key] = v;
+            if (_models.isNotEmpty) _link.sendLine('DMODEL');
+          } else if (key != 'V' && key != 'P' && !_heldByKnob(key)) {
+            _values[key] = v;
+          }
+        }
+        if (!_ready && event is! ChangeEvent) {
+          StartupClock.mark(StartupClock.pedalReady);
+          WidgetsBinding.instance.addPostFrameCallback(
+            (_) => StartupClock.mark(StartupClock.stateShown),
+          );
+        }
+        setState(() => _ready = _ready || event is! ChangeEvent);
+      case LineEvent(:final line):
+        final model = DistModel.tryParse(line);
+        final caps = DeviceCaps.tryParse(line);
+        if (caps != null) {
+          setState(() => _caps = caps);
+        } else if (model != null) {
+          setState(() {
+            _models
+              ..removeWhere((m) => m.id == model.id)
+              ..add(model);
+          });
+        } else if (line.startsWith('OK PLIST')) {
+          // The firmware stops when its TX ring is full; fetch the rest.
+          final next = int.tryParse(
+            RegExp(r'next=(\d+)').firstMatch(line)?.group(1) ?? '',
+          );
+          final count = int.tryParse(
+            RegExp(r'count=(\d+)').firstMatch(line)?.group(1) ?? '',
+          );
+          if (next != null && count != null && next < count) {
+            _link.sendLine('PLIST $next');
+          }
+        } else if (line == 'READY') {
+          // The pedal restarted: its state is the boot one again.
+          _link.sendLine('EVT ON');
+          _link.sendLine('STATUS');
+          _link.sendLine('METER $_kMeterHz');
+        }
+    }
+  }
+
+  bool _heldByKnob(String name) {
+    final t = _turned[name];
+    return t != null && t.elapsed < _kEchoHold;
+  }
+
+  double _pct(String name) =>
+      (_values[name] ?? 0) / _kFullScale[name]! * 100.0;
+
+  void _setPct(String name, double pct, {double maxPct = 100}) {
+    final v = pct.clamp(0, maxPct) / 100.0 * _kFullScale[name]!;
+    _setValue(name, v.round());
+  }
+
+  void _setValue(String name, int v) {
+    final desc = _descs[name];
+    if (desc != null) v = desc.clampValue(v);
+    _values[name] = v;
+    _pending[name] = v;
+    (_turned[name] ??= Stopwatch())
+      ..reset()
+      ..start();
+    if (_flushScheduled) return;
+    _flushScheduled = true;
+    scheduleMicrotask(_flushParams);
+  }
+
+  // Everything turned since the last flush, as one PSET frame.
+  void _flushParams() {
+    _flushScheduled = false;
+    if (!_ready) {
+      _pending.clear();
+      return;
+    }
+    final payload = <int>[];
+    for (final MapEntry(:key, value: v) in _pending.entries) {
+      final desc = _descs[key];
+      if (desc == null) continue; // no PLIST entry: firmware without it
+      payload
+        ..add(desc.id)
+        ..addAll(LinkFrame.varint(v));
+    }
+    _pending.clear();
+    if (payload.isNotEmpty) _link.sendFrame(_kBinPset, payload);
+  }
+
+  void _setFx(int bit, bool on) {
+    setState(() => _fxMask = on ? _fxMask | bit : _fxMask & ~bit);
+    if (_ready) _link.sendFrame(_kBinFxMask, [_fxMask]);
+  }
+
+  // The distortion models with the share of the frame each would take, so
+  // the cost shows before one is picked.
+  Widget _distModels(bool ready) {
+    final sel = _values['dist_model'] ?? 0;
+    return Wrap(
+      spacing: 8,
+      runSpacing: 4,
+      children: [
+        for (final m in _models)
+          ChoiceChip(
+            label: Text('${m.name} ${m.loadPct.toStringAsFixed(1)} %'),
+            tooltip: '${m.cycFrame} cycles per frame',
+            selected: m.id == sel,
+            onSelected: ready
+                ? (_) => setState(() => _setValue('dist_model', m.id))
+                : null,
+          ),
+      ],
+    );
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final connected = _link.isOpen;
+    final ready = connected && _ready;
+    return Scaffold(
+      appBar: AppBar(
+        toolbarHeight: 48,
+        title: const Text('DSP COM'),
+        actions: [
+          if (widget.bauds.isNotEmpty) ...[
+            DropdownButton<int>(
+              value: _baudRate,
+              items: [
+                for (final b in widget.bauds)
+                  DropdownMenuItem(value: b, child: Text('$b')),
+              ],
+              onChanged: connected || _busy
+                  ? null
+                  : (b) => setState(() => _baudRate = b ?? _baudRate),
+            ),
+            const SizedBox(width: 8),
+          ],
+          FilledButton(
+            onPressed: _link.unavailableReason != null || _busy
+                ? null
+                : _connectOrDisconnect,
+            child: Text(connected ? 'Disconnect' : 'Connect'),
+          ),
+          const SizedBox(width: 12),
+        ],
+      ),
+      body: ListView(
+        padding: const EdgeInsets.all(16),
+        children: [
+          Text(_status),
+          const SizedBox(height: 12),
+          PedalSection(
+            ready: ready,
+            pedalBgAsset: _kPedalBgAsset,
+            knobAsset: _kKnobAsset,
+            timePct: _pct('delay_mix_q15'),
+            mixPct: _pct('reverb_mix_q15'),
+            feedbackPct: _pct('delay_feedback_q15'),
+            offssetPct: _pct('dist_drive_q8'),
+            balancePct: _pct('reverb_feedback_q15'),
+            filterPct: _pct('reverb_damp_q15'),
+            onTimeChanged: (pct) => _setPct('delay_mix_q15', pct),
+            onMixChanged: (pct) => _setPct('reverb_mix_q15', pct),
+            onFeedbackChanged: (pct) => _setPct('delay_feedback_q15', pct),
+            onOffssetChanged: (pct) => _setPct('dist_drive_q8', pct),
+            onBalanceChanged: (pct) => _setPct('reverb_feedback_q15', pct),
+            onFilterChanged: (pct) => _setPct('reverb_damp_q15', pct),
+            volumePct: _pct('gain_q15'),
+            volumeMaxPct: 200,
+            onVolumeChanged: (pct) => _setPct('gain_q15', pct, maxPct: 200),
+            distortion: _fxMask & (1 << 0) != 0,
+            reverb: _fxMask & (1 << 1) != 0,
+            delay: _fxMask & (1 << 2) != 0,
+            onDistortionChanged: (v) => _setFx(1 << 0, v),
+            onReverbChanged: (v) => _setFx(1 << 1, v),
+            onDelayChanged: (v) => _setFx(1 << 2, v),
+          ),
+          // Switches for the FX a build may leave out, shown only when
+          // its CAPS lists them.
+          if (_caps?.has('chorus') ?? false) ...[
+            const SizedBox(height: 12),
+            Wrap(
+              children: [
+                FilterChip(
+                  label: const Text('Chorus'),
+                  selected: _fxMask & (1 << 3) != 0,
+                  onSelected: ready ? (v) => _setFx(1 << 3, v) : null,
+                ),
+              ],
+            ),
+          ],
+          if (_models.isNotEmpty) ...[
+            const SizedBox(height: 12),
+            _distModels(ready),
+          ],
+          const SizedBox(height: 12),
+          MeterSection(frame: connected ? _meter : null),
+        ],
+      ),
+    );
+  }
+}
@@ -0,0 +1,20 @@
+/// Time from main() to each step of startup, the first time it is reached:
+/// the first frame, the port open, the pedal answering and its state shown
+/// (a usable, connected UI). The benchmark page shows and exports them.
+class StartupClock {
+  static const String firstFrame = 'first frame';
+  static const String portOpen = 'port open';
+  static const String pedalReady = 'pedal ready';
+  static const String stateShown = 'state shown';
+
+  static final Stopwatch _clock = Stopwatch();
+  static final Map<String, Duration> _marks = {};
+
+  static void start() => _clock.start();
+
+  static void mark(String step) =>
+      _marks.putIfAbsent(step, () => _clock.elapsed);
+
+  /// Steps reached so far, in the order they were.
+  static Map<String, Duration> get marks => Map.unmodifiable(_marks);
+}
@@ -0,0 +1,14 @@
+import 'package:flutter/widgets.dart';
+
+import '../serial/web_serial_link.dart';
+import '../tuning/tuning_page.dart';
+
+/// The web build's home (app.dart imports it in place of the desktop one,
+/// which needs dart:io): the tuning page over WebSerial, for tuning from a
+/// browser without the desktop app.
+Widget appHome() => TuningPage(
+  link: _link,
+  bauds: const [115200, 230400, 460800, 921600],
+);
+
+final WebSerialLink _link = WebSerialLink();
@@ -0,0 +1,343 @@
+#include "serial_transport.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace {
+
+constexpr size_t kReadChunkBytes = 4096;
+constexpr int kWriteTimeoutMs = 1000;
+
+std::string ErrnoText(const char* what) {
+  return std::string(what) + " failed (" + std::strerror(errno) + ")";
+}
+
+bool SpeedOf(int64_t baud, speed_t* speed) {
+  switch (baud) {
+    case 9600: *speed = B9600; return true;
+    case 19200: *speed = B19200; return true;
+    case 38400: *speed = B38400; return true;
+    case 57600: *speed = B57600; return true;
+    case 115200: *speed = B115200; return true;
+    case 230400: *speed = B230400; return true;
+    case 460800: *speed = B460800; return true;
+    case 921600: *speed = B921600; return true;
+    default: return false;
+  }
+}
+
+// ASYNC_LOW_LATENCY where the driver has it; cdc_acm (the pedal's own USB
+// port) has no latency timer to shorten and says no, which is fine.
+void RequestLowLatency(int fd) {
+  struct serial_struct ss = {};
+  if (ioctl(fd, TIOCGSERIAL, &ss) == 0) {
+    ss.flags |= ASYNC_LOW_LATENCY;
+    ioctl(fd, TIOCSSERIAL, &ss);
+  }
+}
+
+}  // namespace
+
+SerialTransport::SerialTransport(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+
+  method_ = fl_method_channel_new(messenger, "dsp_com/serial",
+                                  FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(method_, OnMethodCall, this,
+                                            nullptr);
+
+  events_ = fl_event_channel_new(messenger, "dsp_com/serial/rx",
+                                 FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(events_, OnListen, OnCancel, this,
+                                       nullptr);
+}
+
+SerialTransport::~SerialTransport() {
+  Close();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_ != 0) {
+      g_source_remove(idle_);
+      idle_ = 0;
+    }
+  }
+  fl_method_channel_set_method_call_handler(method_, nullptr, nullptr,
+                                            nullptr);
+  fl_event_channel_set_stream_handlers(events_, nullptr, nullptr, nullptr,
+                                       nullptr);
+  g_object_unref(method_);
+  g_object_unref(events_);
+}
+
+void SerialTransport::OnMethodCall(FlMethodChannel* channel,
+                                   FlMethodCall* call, gpointer user_data) {
+  auto* self = static_cast<SerialTransport*>(user_data);
+  const gchar* name = fl_method_call_get_name(call);
+  FlValue* args = fl_method_call_get_args(call);
+  std::string error;
+
+  if (strcmp(name, "open") == 0) {
+    const bool is_map =
+        args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP;
+    FlValue* port = is_map ? fl_value_lookup_string(args, "port") : nullptr;
+    FlValue* baud = is_map ? fl_value_lookup_string(args, "baud") : nullptr;
+    if (port == nullptr || fl_value_get_type(port) != FL_VALUE_TYPE_STRING ||
+        baud == nullptr || fl_value_get_type(baud) != FL_VALUE_TYPE_INT) {
+      fl_method_call_respond_error(call, "bad_args", "open needs {port, baud}",
+                                   nullptr, nullptr);
+      return;
+    }
+    error = self->Open(fl_value_get_string(port), fl_value_get_int(baud));
+  } else if (strcmp(name, "write") == 0) {
+    if (args == nullptr ||
+        fl_value_get_type(args) != FL_VALUE_TYPE_UINT8_LIST) {
+      fl_method_call_respond_error(call, "bad_args",
+                                   "write needs a Uint8List", nullptr,
+                                   nullptr);
+      return;
+    }
+    error = self->Write(fl_value_get_uint8_list(args),
+                        fl_value_get_length(args));
+  } else if (strcmp(name, "close") == 0) {
+    self->Close();
+  } else {
+    fl_method_call_respond_not_implemented(call, nullptr);
+    return;
+  }
+
+  if (error.empty()) {
+    fl_method_call_respond_success(call, nullptr, nullptr);
+  } else {
+    fl_method_call_respond_error(call, name, error.c_str(), nullptr, nullptr);
+  }
+}
+
+FlMethodErrorResponse* SerialTransport::OnListen(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  auto* self = static_cast<SerialTransport*>(user_data);
+  self->listening_ = true;
+  // Bytes read before the listener came up go out now.
+  std::lock_guard<std::mutex> lock(self->mutex_);
+  if (!self->pending_.empty() || !self->error_.empty()) {
+    self->PostLocked();
+  }
+  return nullptr;
+}
+
+FlMethodErrorResponse* SerialTransport::OnCancel(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  static_cast<SerialTransport*>(user_data)->listening_ = false;
+  return nullptr;
+}
+
+std::string SerialTransport::Open(const std::string& name, int64_t baud) {
+  Close();
+
+  speed_t speed;
+  if (!SpeedOf(baud, &speed)) {
+    return "unsupported baud rate " + std::to_string(baud);
+  }
+  const int fd =
+      open(name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    return ErrnoText("open");
+  }
+
+  struct termios tio = {};
+  bool ok = ioctl(fd, TIOCEXCL) == 0 && tcgetattr(fd, &tio) == 0;
+  if (ok) {
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+    // Readable from the first byte: a larger VMIN, or a VTIME inter-byte
+    // timer, would hold a short ack back waiting for more.
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    ok = cfsetispeed(&tio, speed) == 0 && cfsetospeed(&tio, speed) == 0 &&
+         tcsetattr(fd, TCSANOW, &tio) == 0;
+  }
+  if (!ok) {
+    const std::string error = ErrnoText("Port setup");
+    close(fd);
+    return error;
+  }
+  RequestLowLatency(fd);
+  tcflush(fd, TCIOFLUSH);
+
+  const int stop = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  const int ep = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+  ok = stop >= 0 && ep >= 0 && epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) == 0;
+  ev.data.fd = stop;
+  ok = ok && epoll_ctl(ep, EPOLL_CTL_ADD, stop, &ev) == 0;
+  if (!ok) {
+    const std::string error = ErrnoText("epoll setup");
+    if (stop >= 0) close(stop);
+    if (ep >= 0) close(ep);
+    close(fd);
+    return error;
+  }
+
+  port_ = fd;
+  stop_ = stop;
+  epoll_ = ep;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+    error_.clear();
+  }
+  reader_ = std::thread(&SerialTransport::ReadLoop, this);
+  return std::string();
+}
+
+std::string SerialTransport::Write(const uint8_t* data, size_t n) {
+  if (port_ < 0) {
+    return "port not open";
+  }
+  // Command lines are a few dozen bytes and go into the tty buffer at
+  // once; only a full buffer waits here, up to kWriteTimeoutMs.
+  size_t done = 0;
+  while (done < n) {
+    const ssize_t w = write(port_, data + done, n - done);
+    if (w > 0) {
+      done += static_cast<size_t>(w);
+    } else if (w < 0 && errno == EAGAIN) {
+      struct pollfd p = {port_, POLLOUT, 0};
+      const int r = poll(&p, 1, kWriteTimeoutMs);
+      if (r == 0) {
+        return "write timed out";
+      }
+      if (r < 0 && errno != EINTR) {
+        return ErrnoText("poll");
+      }
+    } else if (w == 0 || errno != EINTR) {
+      return ErrnoText("write");
+    }
+  }
+  return std::string();
+}
+
+void SerialTransport::Close() {
+  if (port_ < 0) {
+    return;
+  }
+  const uint64_t one = 1;
+  if (write(stop_, &one, sizeof(one)) < 0) {
+    // Not reachable for an eventfd below its limit; the join would hang.
+    g_warning("serial: stop signal failed: %s", std::strerror(errno));
+  }
+  if (reader_.joinable()) {
+    reader_.join();
+  }
+  close(epoll_);
+  close(stop_);
+  close(port_);
+  port_ = -1;
+  stop_ = -1;
+  epoll_ = -1;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.clear();
+  error_.clear();
+}
+
+void SerialTransport::ReadLoop() {
+  std::vector<uint8_t> buf(kReadChunkBytes);
+  struct epoll_event ev[2];
+
+  for (;;) {
+    const int n = epoll_wait(epoll_, ev, 2, -1);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      Fail(ErrnoText("epoll_wait"));
+      return;
+    }
+    for (int i = 0; i < n; i++) {
+      if (ev[i].data.fd == stop_) {
+        return;
+      }
+    }
+
+    // Drain the port; EAGAIN means it is time to wait again. A hangup
+    // (the adapter unplugged) reads as 0 bytes or EIO.
+    for (;;) {
+      const ssize_t got = read(port_, buf.data(), buf.size());
+      if (got > 0) {
+        Deliver(buf.data(), static_cast<size_t>(got));
+        continue;
+      }
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      if (got < 0 && errno == EAGAIN) {
+        break;
+      }
+      Fail(got == 0 ? std::string("port closed") : ErrnoText("read"));
+      return;
+    }
+  }
+}
+
+void SerialTransport::Deliver(const uint8_t* data, size_t n) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.insert(pending_.end(), data, data + n);
+  PostLocked();
+}
+
+void SerialTransport::Fail(const std::string& message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  error_ = message;
+  PostLocked();
+}
+
+void SerialTransport::PostLocked() {
+  // One idle source at a time: later reads join its batch.
+  if (idle_ == 0) {
+    idle_ = g_idle_add_full(G_PRIORITY_DEFAULT, OnIdle, this, nullptr);
+  }
+}
+
+gboolean SerialTransport::OnIdle(gpointer user_data) {
+  static_cast<SerialTransport*>(user_data)->Flush();
+  return G_SOURCE_REMOVE;
+}
+
+void SerialTransport::Flush() {
+  std::vector<uint8_t> batch;
+  std::string error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_ = 0;
+    if (!listening_) {
+      // Held for OnListen.
+      return;
+    }
+    batch.swap(pending_);
+    error.swap(error_);
+  }
+  if (!batch.empty()) {
+    g_autoptr(FlValue) value =
+        fl_value_new_uint8_list(batch.data(), batch.size());
+    fl_event_channel_send(events_, value, nullptr, nullptr);
+  }
+  if (!error.empty()) {
+    fl_event_channel_send_error(events_, "io", error.c_str(), nullptr, nullptr,
+                                nullptr);
+  }
+}
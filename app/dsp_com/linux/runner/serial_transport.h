@@ -0,0 +1,73 @@
+#ifndef RUNNER_SERIAL_TRANSPORT_H_
+#define RUNNER_SERIAL_TRANSPORT_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Native serial port for the Dart SerialLink on Linux; the same channels as
+// windows/runner/serial_transport.h.
+//
+// The tty is raw (termios) with VMIN=1/VTIME=0, so the line discipline
+// makes it readable on the first byte rather than holding bytes back for a
+// count or an inter-byte timer, and ASYNC_LOW_LATENCY is asked for where
+// the driver has it (ftdi_sio turns it into a 1 ms latency timer instead
+// of 16 ms). A reader thread sleeps in epoll_wait() on the port and an
+// eventfd (the stop signal), drains the port with non-blocking reads and
+// appends to a pending batch; the first append after a flush adds an idle
+// source to the main loop, and the platform thread sends whatever has piled
+// up by then as one EventChannel event.
+//
+//   MethodChannel "dsp_com/serial":    open {port, baud}, write <bytes>, close
+//   EventChannel  "dsp_com/serial/rx": Uint8List batches; an error event when
+//                                      the port fails under the reader
+class SerialTransport {
+ public:
+  explicit SerialTransport(FlBinaryMessenger* messenger);
+  ~SerialTransport();
+
+  SerialTransport(const SerialTransport&) = delete;
+  SerialTransport& operator=(const SerialTransport&) = delete;
+
+ private:
+  static void OnMethodCall(FlMethodChannel* channel, FlMethodCall* call,
+                           gpointer user_data);
+  static FlMethodErrorResponse* OnListen(FlEventChannel* channel,
+                                         FlValue* args, gpointer user_data);
+  static FlMethodErrorResponse* OnCancel(FlEventChannel* channel,
+                                         FlValue* args, gpointer user_data);
+  static gboolean OnIdle(gpointer user_data);
+
+  // Returns an empty string on success, else what failed.
+  std::string Open(const std::string& name, int64_t baud);
+  std::string Write(const uint8_t* data, size_t n);
+  void Close();
+
+  // Reader thread and its hand-off to the platform thread.
+  void ReadLoop();
+  void Deliver(const uint8_t* data, size_t n);
+  void Fail(const std::string& message);
+  void PostLocked();
+  void Flush();
+
+  FlMethodChannel* method_ = nullptr;
+  FlEventChannel* events_ = nullptr;
+  bool listening_ = false;
+
+  int port_ = -1;
+  int stop_ = -1;
+  int epoll_ = -1;
+  std::thread reader_;
+
+  // Guarded by mutex_: the reader appends, the platform thread flushes.
+  std::mutex mutex_;
+  std::vector<uint8_t> pending_;
+  std::string error_;
+  guint idle_ = 0;
+};
+
+#endif  // RUNNER_SERIAL_TRANSPORT_H_
@@ -2,6 +2,9 @@ import Cocoa
 import FlutterMacOS
 
 class MainFlutterWindow: NSWindow {
+  // Native serial port behind the app's SerialLink.
+  private var serial: SerialTransport?
+
   override func awakeFromNib() {
     let flutterViewController = FlutterViewController()
     let windowFrame = self.frame
@@ -9,6 +12,8 @@ class MainFlutterWindow: NSWindow {
     self.setFrame(windowFrame, display: true)
 
     RegisterGeneratedPlugins(registry: flutterViewController)
+    serial = SerialTransport(
+      messenger: flutterViewController.engine.binaryMessenger)
 
     super.awakeFromNib()
   }
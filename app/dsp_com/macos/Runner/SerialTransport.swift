@@ -0,0 +1,280 @@
+import Darwin
+import FlutterMacOS
+import Foundation
+
+// Native serial port for the Dart SerialLink on macOS; the same channels as
+// windows/runner/serial_transport.h.
+//
+// The tty is raw (termios) with VMIN=1/VTIME=0, so it is readable on the
+// first byte; rates past B230400 are set with IOSSIOSPEED, and IOSSDATALAT
+// asks the driver to hand received bytes up after 1 us rather than at its
+// own latency (the counterpart of Linux's ASYNC_LOW_LATENCY). A read
+// DispatchSource (a kqueue EVFILT_READ) on a serial queue drains the port
+// with non-blocking reads into a pending batch; the first append after a
+// flush queues one block on the main queue, which sends whatever has piled
+// up by then as one EventChannel event.
+//
+//   MethodChannel "dsp_com/serial":    open {port, baud}, write <bytes>, close
+//   EventChannel  "dsp_com/serial/rx": Uint8List batches; an error event when
+//                                      the port fails under the reader
+class SerialTransport: NSObject, FlutterStreamHandler {
+  // <sys/ioctl.h> and <IOKit/serial/ioss.h> macros Swift does not import:
+  // _IO('t', 13), _IOW('T', 2, speed_t), _IOW('T', 0, unsigned long).
+  private static let tiocexcl: UInt = 0x2000_740D
+  private static let iossiospeed: UInt = 0x8008_5402
+  private static let iossdatalat: UInt = 0x8008_5400
+  private static let readChunkBytes = 4096
+  private static let writeTimeoutMs: Int32 = 1000
+
+  private let method: FlutterMethodChannel
+  private let events: FlutterEventChannel
+  private var sink: FlutterEventSink?
+
+  private let queue = DispatchQueue(label: "dsp_com.serial")
+  private var port: Int32 = -1
+  private var source: DispatchSourceRead?
+  private var closed: DispatchSemaphore?
+
+  // Guarded by lock: the reader appends, the main queue flushes.
+  private let lock = NSLock()
+  private var pending = Data()
+  private var error: String?
+  private var posted = false
+
+  init(messenger: FlutterBinaryMessenger) {
+    method = FlutterMethodChannel(
+      name: "dsp_com/serial", binaryMessenger: messenger)
+    events = FlutterEventChannel(
+      name: "dsp_com/serial/rx", binaryMessenger: messenger)
+    super.init()
+    method.setMethodCallHandler { [weak self] call, result in
+      self?.handle(call, result: result)
+    }
+    events.setStreamHandler(self)
+  }
+
+  deinit {
+    close()
+  }
+
+  func onListen(
+    withArguments arguments: Any?, eventSink events: @escaping FlutterEventSink
+  ) -> FlutterError? {
+    sink = events
+    // Bytes read before the listener came up go out now.
+    lock.lock()
+    if !pending.isEmpty || error != nil {
+      postLocked()
+    }
+    lock.unlock()
+    return nil
+  }
+
+  func onCancel(withArguments arguments: Any?) -> FlutterError? {
+    sink = nil
+    return nil
+  }
+
+  private func handle(_ call: FlutterMethodCall, result: FlutterResult) {
+    switch call.method {
+    case "open":
+      guard let args = call.arguments as? [String: Any],
+        let name = args["port"] as? String,
+        let baud = args["baud"] as? Int
+      else {
+        result(
+          FlutterError(
+            code: "bad_args", message: "open needs {port, baud}", details: nil))
+        return
+      }
+      reply(result, "open", open(name, baud: baud))
+    case "write":
+      guard let data = call.arguments as? FlutterStandardTypedData else {
+        result(
+          FlutterError(
+            code: "bad_args", message: "write needs a Uint8List", details: nil))
+        return
+      }
+      reply(result, "write", write(data.data))
+    case "close":
+      close()
+      result(nil)
+    default:
+      result(FlutterMethodNotImplemented)
+    }
+  }
+
+  private func reply(_ result: FlutterResult, _ code: String, _ error: String?) {
+    result(error.map { FlutterError(code: code, message: $0, details: nil) })
+  }
+
+  // Returns nil on success, else what failed.
+  private func open(_ name: String, baud: Int) -> String? {
+    close()
+
+    let fd = Darwin.open(name, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)
+    if fd < 0 {
+      return errnoText("open")
+    }
+
+    var tio = termios()
+    var ok = ioctl(fd, Self.tiocexcl) == 0 && tcgetattr(fd, &tio) == 0
+    if ok {
+      cfmakeraw(&tio)
+      tio.c_cflag |= tcflag_t(CLOCAL | CREAD)
+      tio.c_cflag &= ~tcflag_t(CSTOPB | CRTSCTS)
+      tio.c_iflag &= ~tcflag_t(IXON | IXOFF | IXANY)
+      // Readable from the first byte: a larger VMIN, or a VTIME inter-byte
+      // timer, would hold a short ack back waiting for more.
+      withUnsafeMutableBytes(of: &tio.c_cc) { cc in
+        cc[Int(VMIN)] = 1
+        cc[Int(VTIME)] = 0
+      }
+      // termios takes a standard rate; the real one follows.
+      cfsetspeed(&tio, speed_t(B9600))
+      var speed = speed_t(baud)
+      ok = tcsetattr(fd, TCSANOW, &tio) == 0
+        && ioctl(fd, Self.iossiospeed, &speed) == 0
+    }
+    if !ok {
+      let error = errnoText("Port setup")
+      Darwin.close(fd)
+      return error
+    }
+    // Drivers without it keep their own latency.
+    var latencyUs: UInt = 1
+    _ = ioctl(fd, Self.iossdatalat, &latencyUs)
+    tcflush(fd, TCIOFLUSH)
+
+    lock.lock()
+    pending.removeAll()
+    error = nil
+    lock.unlock()
+
+    let closed = DispatchSemaphore(value: 0)
+    let src = DispatchSource.makeReadSource(fileDescriptor: fd, queue: queue)
+    src.setEventHandler { [weak self] in
+      self?.drain(fd, src)
+    }
+    // The descriptor stays open until the source lets go of it.
+    src.setCancelHandler {
+      Darwin.close(fd)
+      closed.signal()
+    }
+    port = fd
+    source = src
+    self.closed = closed
+    src.resume()
+    return nil
+  }
+
+  private func write(_ data: Data) -> String? {
+    let fd = port
+    if fd < 0 {
+      return "port not open"
+    }
+    // Command lines are a few dozen bytes and go into the tty buffer at
+    // once; only a full buffer waits here, up to writeTimeoutMs.
+    return data.withUnsafeBytes { (raw: UnsafeRawBufferPointer) -> String? in
+      var done = 0
+      while done < raw.count {
+        let w = Darwin.write(fd, raw.baseAddress! + done, raw.count - done)
+        if w > 0 {
+          done += w
+        } else if w < 0 && errno == EAGAIN {
+          var p = pollfd(fd: fd, events: Int16(POLLOUT), revents: 0)
+          let r = poll(&p, 1, Self.writeTimeoutMs)
+          if r == 0 {
+            return "write timed out"
+          }
+          if r < 0 && errno != EINTR {
+            return errnoText("poll")
+          }
+        } else if w == 0 || errno != EINTR {
+          return errnoText("write")
+        }
+      }
+      return nil
+    }
+  }
+
+  private func close() {
+    guard let src = source else {
+      return
+    }
+    src.cancel()
+    closed?.wait()
+    source = nil
+    closed = nil
+    port = -1
+
+    lock.lock()
+    pending.removeAll()
+    error = nil
+    lock.unlock()
+  }
+
+  // Reader queue: drains the port; EAGAIN means it is time to wait again.
+  // A hangup (the adapter unplugged) reads as 0 bytes or ENXIO.
+  private func drain(_ fd: Int32, _ src: DispatchSourceRead) {
+    var buf = [UInt8](repeating: 0, count: Self.readChunkBytes)
+    while true {
+      let got = Darwin.read(fd, &buf, buf.count)
+      if got > 0 {
+        lock.lock()
+        pending.append(contentsOf: buf[0..<got])
+        postLocked()
+        lock.unlock()
+        continue
+      }
+      if got < 0 && errno == EINTR {
+        continue
+      }
+      if got < 0 && errno == EAGAIN {
+        return
+      }
+      lock.lock()
+      error = got == 0 ? "port closed" : errnoText("read")
+      postLocked()
+      lock.unlock()
+      src.cancel()
+      return
+    }
+  }
+
+  private func postLocked() {
+    // One block in flight at a time: later reads join its batch.
+    if !posted {
+      posted = true
+      DispatchQueue.main.async { [weak self] in
+        self?.flush()
+      }
+    }
+  }
+
+  private func flush() {
+    lock.lock()
+    posted = false
+    guard let sink = sink else {
+      // Held for onListen.
+      lock.unlock()
+      return
+    }
+    let batch = pending
+    let failure = error
+    pending = Data()
+    error = nil
+    lock.unlock()
+
+    if !batch.isEmpty {
+      sink(FlutterStandardTypedData(bytes: batch))
+    }
+    if let failure = failure {
+      sink(FlutterError(code: "io", message: failure, details: nil))
+    }
+  }
+}
+
+private func errnoText(_ what: String) -> String {
+  return "\(what) failed (\(String(cString: strerror(errno))))"
+}
@@ -0,0 +1,312 @@
+#include "serial_transport.h"
+
+#include <flutter/event_stream_handler_functions.h>
+#include <flutter/standard_method_codec.h>
+
+#include <variant>
+
+namespace {
+
+constexpr DWORD kDriverQueueBytes = 4096;
+constexpr DWORD kReadChunkBytes = 4096;
+constexpr DWORD kWriteTimeoutMs = 1000;
+
+std::string LastErrorText(const char* what) {
+  return std::string(what) + " failed (" + std::to_string(GetLastError()) +
+         ")";
+}
+
+const flutter::EncodableValue* MapValue(const flutter::EncodableMap& map,
+                                        const char* key) {
+  auto it = map.find(flutter::EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+}  // namespace
+
+SerialTransport::SerialTransport(flutter::BinaryMessenger* messenger,
+                                 HWND window)
+    : window_(window) {
+  const auto& codec = flutter::StandardMethodCodec::GetInstance();
+
+  method_ = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+      messenger, "dsp_com/serial", &codec);
+  method_->SetMethodCallHandler([this](const auto& call, auto result) {
+    HandleMethodCall(call, std::move(result));
+  });
+
+  events_ = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+      messenger, "dsp_com/serial/rx", &codec);
+  events_->SetStreamHandler(
+      std::make_unique<
+          flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue*, auto&& events)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            sink_ = std::move(events);
+            // Bytes read before the listener came up go out now.
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!pending_.empty() || !error_.empty()) {
+              PostLocked();
+            }
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue*)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            sink_ = nullptr;
+            return nullptr;
+          }));
+}
+
+SerialTransport::~SerialTransport() {
+  Close();
+  method_->SetMethodCallHandler(nullptr);
+  events_->SetStreamHandler(nullptr);
+}
+
+void SerialTransport::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    std::unique_ptr<MethodResult> result) {
+  const std::string& name = call.method_name();
+
+  if (name == "open") {
+    const auto* args = std::get_if<flutter::EncodableMap>(call.arguments());
+    const flutter::EncodableValue* port =
+        args ? MapValue(*args, "port") : nullptr;
+    const flutter::EncodableValue* baud =
+        args ? MapValue(*args, "baud") : nullptr;
+    if (!port || !std::holds_alternative<std::string>(*port) || !baud) {
+      result->Error("bad_args", "open needs {port, baud}");
+      return;
+    }
+    const std::string error =
+        Open(std::get<std::string>(*port), static_cast<DWORD>(baud->LongValue()));
+    if (error.empty()) {
+      result->Success();
+    } else {
+      result->Error("open", error);
+    }
+  } else if (name == "write") {
+    const auto* data = std::get_if<std::vector<uint8_t>>(call.arguments());
+    if (!data) {
+      result->Error("bad_args", "write needs a Uint8List");
+      return;
+    }
+    const std::string error = Write(*data);
+    if (error.empty()) {
+      result->Success();
+    } else {
+      result->Error("write", error);
+    }
+  } else if (name == "close") {
+    Close();
+    result->Success();
+  } else {
+    result->NotImplemented();
+  }
+}
+
+std::string SerialTransport::Open(const std::string& name, DWORD baud) {
+  Close();
+
+  // The \\.\ prefix is what makes COM10 and up openable.
+  const std::string path = "\\\\.\\" + name;
+  HANDLE port = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED,
+                            nullptr);
+  if (port == INVALID_HANDLE_VALUE) {
+    return LastErrorText("CreateFile");
+  }
+
+  DCB dcb = {};
+  dcb.DCBlength = sizeof(dcb);
+  COMMTIMEOUTS timeouts = {};
+  // Reads return at once with whatever the driver holds; the reader waits
+  // on WaitCommEvent instead of a read timeout.
+  timeouts.ReadIntervalTimeout = MAXDWORD;
+  timeouts.WriteTotalTimeoutConstant = kWriteTimeoutMs;
+
+  bool ok = SetupComm(port, kDriverQueueBytes, kDriverQueueBytes) &&
+            GetCommState(port, &dcb);
+  if (ok) {
+    dcb.BaudRate = baud;
+    dcb.ByteSize = 8;
+    dcb.Parity = NOPARITY;
+    dcb.StopBits = ONESTOPBIT;
+    dcb.fBinary = TRUE;
+    dcb.fParity = FALSE;
+    dcb.fOutxCtsFlow = FALSE;
+    dcb.fOutxDsrFlow = FALSE;
+    dcb.fDtrControl = DTR_CONTROL_ENABLE;
+    dcb.fRtsControl = RTS_CONTROL_ENABLE;
+    dcb.fOutX = FALSE;
+    dcb.fInX = FALSE;
+    dcb.fAbortOnError = FALSE;
+    ok = SetCommState(port, &dcb) && SetCommTimeouts(port, &timeouts) &&
+         SetCommMask(port, EV_RXCHAR | EV_ERR) &&
+         PurgeComm(port, PURGE_RXCLEAR | PURGE_TXCLEAR);
+  }
+  if (!ok) {
+    const std::string error = LastErrorText("Port setup");
+    CloseHandle(port);
+    return error;
+  }
+
+  port_ = port;
+  stop_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  write_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+    error_.clear();
+  }
+  reader_ = std::thread(&SerialTransport::ReadLoop, this);
+  return std::string();
+}
+
+std::string SerialTransport::Write(const std::vector<uint8_t>& data) {
+  if (port_ == INVALID_HANDLE_VALUE) {
+    return "port not open";
+  }
+  // Command lines are a few dozen bytes: the driver takes them at once, so
+  // waiting here does not hold the platform thread for the wire time.
+  OVERLAPPED ov = {};
+  ov.hEvent = write_event_;
+  ResetEvent(ov.hEvent);
+  DWORD written = 0;
+  if (!WriteFile(port_, data.data(), static_cast<DWORD>(data.size()), nullptr,
+                 &ov) &&
+      GetLastError() != ERROR_IO_PENDING) {
+    return LastErrorText("WriteFile");
+  }
+  if (!GetOverlappedResult(port_, &ov, &written, TRUE)) {
+    return LastErrorText("WriteFile");
+  }
+  if (written != data.size()) {
+    return "write timed out";
+  }
+  return std::string();
+}
+
+void SerialTransport::Close() {
+  if (port_ == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  SetEvent(stop_);
+  if (reader_.joinable()) {
+    reader_.join();
+  }
+  CloseHandle(port_);
+  CloseHandle(stop_);
+  CloseHandle(write_event_);
+  port_ = INVALID_HANDLE_VALUE;
+  stop_ = nullptr;
+  write_event_ = nullptr;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.clear();
+  error_.clear();
+}
+
+void SerialTransport::ReadLoop() {
+  OVERLAPPED ov = {};
+  ov.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  std::vector<uint8_t> buf(kReadChunkBytes);
+
+  for (;;) {
+    // Drain the driver buffer; a read that comes back empty means it is
+    // time to wait for the next character.
+    DWORD got = 0;
+    ResetEvent(ov.hEvent);
+    if (!ReadFile(port_, buf.data(), kReadChunkBytes, nullptr, &ov) &&
+        GetLastError() != ERROR_IO_PENDING) {
+      Fail(LastErrorText("ReadFile"));
+      break;
+    }
+    if (!WaitIo(&ov, &got)) {
+      break;
+    }
+    if (got > 0) {
+      Deliver(buf.data(), got);
+      continue;
+    }
+
+    DWORD mask = 0;
+    ResetEvent(ov.hEvent);
+    if (!WaitCommEvent(port_, &mask, &ov) &&
+        GetLastError() != ERROR_IO_PENDING) {
+      Fail(LastErrorText("WaitCommEvent"));
+      break;
+    }
+    if (!WaitIo(&ov, &got)) {
+      break;
+    }
+    if (mask & EV_ERR) {
+      // Framing or overrun: clear it, the decoder resynchronises on the
+      // next line or frame.
+      DWORD errors = 0;
+      ClearCommError(port_, &errors, nullptr);
+    }
+  }
+
+  CloseHandle(ov.hEvent);
+}
+
+// Waits for the overlapped operation or the stop event. Returns false when
+// the reader should leave: stopped (the request is cancelled) or failed
+// (reported through Fail()).
+bool SerialTransport::WaitIo(OVERLAPPED* ov, DWORD* transferred) {
+  HANDLE handles[2] = {ov->hEvent, stop_};
+  const DWORD woke = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+  if (woke != WAIT_OBJECT_0) {
+    CancelIoEx(port_, ov);
+    GetOverlappedResult(port_, ov, transferred, TRUE);
+    return false;
+  }
+  if (!GetOverlappedResult(port_, ov, transferred, FALSE)) {
+    Fail(LastErrorText("Serial I/O"));
+    return false;
+  }
+  return true;
+}
+
+void SerialTransport::Deliver(const uint8_t* data, DWORD n) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.insert(pending_.end(), data, data + n);
+  PostLocked();
+}
+
+void SerialTransport::Fail(const std::string& message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  error_ = message;
+  PostLocked();
+}
+
+void SerialTransport::PostLocked() {
+  // One message in flight at a time: later reads join its batch.
+  if (!posted_) {
+    posted_ = PostMessage(window_, kMessage, 0, 0) != FALSE;
+  }
+}
+
+void SerialTransport::OnMessage() {
+  std::vector<uint8_t> batch;
+  std::string error;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    posted_ = false;
+    if (!sink_) {
+      // Held for OnListen.
+      return;
+    }
+    batch.swap(pending_);
+    error.swap(error_);
+  }
+  if (!batch.empty()) {
+    sink_->Success(flutter::EncodableValue(std::move(batch)));
+  }
+  if (!error.empty()) {
+    sink_->Error("io", error);
+  }
+}
@@ -0,0 +1,79 @@
+#ifndef RUNNER_SERIAL_TRANSPORT_H_
+#define RUNNER_SERIAL_TRANSPORT_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Native serial port for the Dart SerialLink on Windows.
+//
+// A reader thread sleeps in an overlapped WaitCommEvent (EV_RXCHAR) and then
+// drains the driver buffer with overlapped ReadFile calls that return at
+// once. Received bytes are appended to a pending batch; the first append
+// after a flush posts kMessage to the window, and the platform thread sends
+// whatever has piled up by then as one EventChannel event, so a burst of
+// meter frames costs one channel hop rather than one per read.
+//
+//   MethodChannel "dsp_com/serial":    open {port, baud}, write <bytes>, close
+//   EventChannel  "dsp_com/serial/rx": Uint8List batches; an error event when
+//                                      the port fails under the reader
+class SerialTransport {
+ public:
+  // Posted to the window when a batch is waiting.
+  static constexpr UINT kMessage = WM_APP + 0x51;
+
+  SerialTransport(flutter::BinaryMessenger* messenger, HWND window);
+  ~SerialTransport();
+
+  SerialTransport(const SerialTransport&) = delete;
+  SerialTransport& operator=(const SerialTransport&) = delete;
+
+  // Called by the window procedure for kMessage (platform thread).
+  void OnMessage();
+
+ private:
+  using MethodResult = flutter::MethodResult<flutter::EncodableValue>;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      std::unique_ptr<MethodResult> result);
+
+  // Returns an empty string on success, else what failed.
+  std::string Open(const std::string& name, DWORD baud);
+  std::string Write(const std::vector<uint8_t>& data);
+  void Close();
+
+  // Reader thread and its hand-off to the platform thread.
+  void ReadLoop();
+  bool WaitIo(OVERLAPPED* ov, DWORD* transferred);
+  void Deliver(const uint8_t* data, DWORD n);
+  void Fail(const std::string& message);
+  void PostLocked();
+
+  HWND window_;
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> method_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> events_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> sink_;
+
+  HANDLE port_ = INVALID_HANDLE_VALUE;
+  HANDLE stop_ = nullptr;
+  HANDLE write_event_ = nullptr;
+  std::thread reader_;
+
+  // Guarded by mutex_: the reader appends, the platform thread flushes.
+  std::mutex mutex_;
+  std::vector<uint8_t> pending_;
+  std::string error_;
+  bool posted_ = false;
+};
+
+#endif  // RUNNER_SERIAL_TRANSPORT_H_
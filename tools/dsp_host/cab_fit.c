@@ -0,0 +1,463 @@
+/*
+ * Cab IR -> biquad cascade for the user cab (AppDsp_SetCabSection()).
+ * - The IR's magnitude response is taken on a log grid (48 points per
+ *   octave, 30 Hz to 0.45 fs) and smoothed over 1/6 octave: a few biquads
+ *   cannot follow the comb of a real cab and should not try.
+ * - The model is a highpass, a lowpass and peaking sections in between
+ *   (RBJ shapes), all minimum phase, so the cascade keeps the IR's
+ *   magnitude and drops its excess phase and delay. Each peak goes where
+ *   the error is largest, then every section is refined by coordinate
+ *   descent on the dB error, the level solved in closed form.
+ * - The result is scaled to peak at 0 dB like the fixed lowpass (-k keeps
+ *   the IR's level, limited to +12 dB) and printed as the COM lines that
+ *   load it: CABIIR N 0, one CABIIR <k> line per section in Q28, CABIIR N
+ *   <n>. The fitted and target curves go to stderr with -v.
+ *
+ * Usage: cab_fit [-n sections] [-k] [-v] ir.wav
+ *   sections: 2..6 (default 6, the firmware's default
+ *   APP_DSP_CAB_SECTIONS_MAX, which the MINIMAL profile builds; a pedal
+ *   built with fewer reports its max in CABIIR, one without answers ERR
+ *   CABIIR DISABLED). The IR is read at the build rate (host_wav warns on
+ *   a mismatch).
+ *
+ * On the pedal a section costs 5 multiply-adds per channel and frame.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_dsp.h"
+#include "host_wav.h"
+
+#define FIT_FS          ((double)APP_DSP_SAMPLE_RATE_HZ)
+#define FIT_PI          3.14159265358979323846
+#define FIT_F_LO        30.0
+#define FIT_PER_OCT     48u
+#define FIT_SMOOTH      4u           /* +-1/12 octave */
+#define FIT_POINTS_MAX  1024u
+#define FIT_IR_MAX      16384u       /* 0.34 s at 48 kHz, longer cabs are room */
+#define FIT_GAIN_MAX_DB 18.0
+#define FIT_RANGE_DB    40.0         /* below the target's peak, where the error stops counting */
+#define FIT_ROUNDS      200u
+#define FIT_SECTIONS_MAX 6u          /* the most -n takes */
+
+typedef enum
+{
+  SEC_HP = 0,
+  SEC_LP,
+  SEC_PEAK,
+} SecType;
+
+typedef struct
+{
+  SecType type;
+  double lf;                         /* log2(f) */
+  double lq;                         /* log2(Q) */
+  double g;                          /* dB, peaks only */
+} Section;
+
+typedef struct
+{
+  double b[3];
+  double a[3];
+} Biquad;
+
+static double s_w[FIT_POINTS_MAX];      /* rad/sample */
+static double s_target[FIT_POINTS_MAX]; /* dB */
+static double s_floor;                  /* dB, FIT_RANGE_DB under the target's peak */
+static uint32_t s_points;
+
+static Biquad sec_design(const Section *s)
+{
+  const double f0 = pow(2.0, s->lf);
+  const double q = pow(2.0, s->lq);
+  const double w = 2.0 * FIT_PI * f0 / FIT_FS;
+  const double cw = cos(w);
+  const double al = sin(w) / (2.0 * q);
+  Biquad z;
+  switch (s->type)
+  {
+    case SEC_HP:
+      z.b[0] = (1.0 + cw) / 2.0;
+      z.b[1] = -(1.0 + cw);
+      z.b[2] = (1.0 + cw) / 2.0;
+      z.a[0] = 1.0 + al;
+      z.a[1] = -2.0 * cw;
+      z.a[2] = 1.0 - al;
+      break;
+    case SEC_LP:
+      z.b[0] = (1.0 - cw) / 2.0;
+      z.b[1] = 1.0 - cw;
+      z.b[2] = (1.0 - cw) / 2.0;
+      z.a[0] = 1.0 + al;
+      z.a[1] = -2.0 * cw;
+      z.a[2] = 1.0 - al;
+      break;
+    default:
+    {
+      const double A = pow(10.0, s->g / 40.0);
+      z.b[0] = 1.0 + (al * A);
+      z.b[1] = -2.0 * cw;
+      z.b[2] = 1.0 - (al * A);
+      z.a[0] = 1.0 + (al / A);
+      z.a[1] = -2.0 * cw;
+      z.a[2] = 1.0 - (al / A);
+      break;
+    }
+  }
+  for (uint32_t k = 0; k < 3u; k++)
+  {
+    z.b[k] /= z.a[0];
+  }
+  z.a[1] /= z.a[0];
+  z.a[2] /= z.a[0];
+  z.a[0] = 1.0;
+  return z;
+}
+
+static double biquad_db(const Biquad *z, double w)
+{
+  const double c1 = cos(w), s1 = sin(w), c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+  const double nr = z->b[0] + (z->b[1] * c1) + (z->b[2] * c2);
+  const double ni = -(z->b[1] * s1) - (z->b[2] * s2);
+  const double dr = 1.0 + (z->a[1] * c1) + (z->a[2] * c2);
+  const double di = -(z->a[1] * s1) - (z->a[2] * s2);
+  return 10.0 * log10(((nr * nr) + (ni * ni) + 1e-30) / ((dr * dr) + (di * di)));
+}
+
+/* Cascade response on the grid, without the level. */
+static void cascade_db(const Section *s, uint32_t n, double *out)
+{
+  memset(out, 0, s_points * sizeof(out[0]));
+  for (uint32_t k = 0; k < n; k++)
+  {
+    const Biquad z = sec_design(&s[k]);
+    for (uint32_t i = 0; i < s_points; i++)
+    {
+      out[i] += biquad_db(&z, s_w[i]);
+    }
+  }
+}
+
+/* Squared dB error with the level that matches the two above the floor;
+ * *level gets that level. Under the floor both curves count as the floor,
+ * so the sections are not spent on the depth of the top octave's rolloff.
+ */
+static double fit_error(const Section *s, uint32_t n, double *level)
+{
+  static double h[FIT_POINTS_MAX];
+  cascade_db(s, n, h);
+  double mean = 0.0;
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < s_points; i++)
+  {
+    if (s_target[i] > s_floor)
+    {
+      mean += s_target[i] - h[i];
+      count++;
+    }
+  }
+  mean /= (double)count;
+  double e = 0.0;
+  for (uint32_t i = 0; i < s_points; i++)
+  {
+    const double d = fmax(h[i] + mean, s_floor) - fmax(s_target[i], s_floor);
+    e += d * d;
+  }
+  if (level != NULL)
+  {
+    *level = mean;
+  }
+  return e / (double)s_points;
+}
+
+static int sec_valid(const Section *s)
+{
+  const double f = pow(2.0, s->lf);
+  return (f >= 20.0) && (f <= 0.45 * FIT_FS) && (s->lq >= -2.0) && (s->lq <= 4.0) &&
+         (fabs(s->g) <= FIT_GAIN_MAX_DB);
+}
+
+/* Coordinate descent: each parameter of each section tries +-step and keeps
+ * what lowers the error; steps halve when a round finds nothing.
+ */
+static double refine(Section *s, uint32_t n)
+{
+  double step[3] = {0.25, 0.5, 2.0};
+  double best = fit_error(s, n, NULL);
+  for (uint32_t round = 0; round < FIT_ROUNDS; round++)
+  {
+    int moved = 0;
+    for (uint32_t k = 0; k < n; k++)
+    {
+      for (uint32_t v = 0; v < 3u; v++)
+      {
+        if ((v == 2u) && (s[k].type != SEC_PEAK))
+        {
+          continue;
+        }
+        for (int dir = -1; dir <= 1; dir += 2)
+        {
+          Section t = s[k];
+          double *pv = (v == 0u) ? &t.lf : (v == 1u) ? &t.lq : &t.g;
+          *pv += dir * step[v];
+          if (!sec_valid(&t))
+          {
+            continue;
+          }
+          const Section keep = s[k];
+          s[k] = t;
+          const double e = fit_error(s, n, NULL);
+          if (e < best)
+          {
+            best = e;
+            moved = 1;
+            break;
+          }
+          s[k] = keep;
+        }
+      }
+    }
+    if (!moved)
+    {
+      step[0] *= 0.5;
+      step[1] *= 0.5;
+      step[2] *= 0.5;
+      if (step[0] < 1e-3)
+      {
+        break;
+      }
+    }
+  }
+  return best;
+}
+
+/* Magnitude of the IR on the log grid, smoothed over 2 * FIT_SMOOTH + 1
+ * points in power.
+ */
+static void measure(const double *h, uint32_t len)
+{
+  static double raw[FIT_POINTS_MAX];
+  const double f_hi = 0.45 * FIT_FS;
+  s_points = 0;
+  for (double f = FIT_F_LO; (f < f_hi) && (s_points < FIT_POINTS_MAX); f *= pow(2.0, 1.0 / FIT_PER_OCT))
+  {
+    const double w = 2.0 * FIT_PI * f / FIT_FS;
+    double re = 0.0, im = 0.0;
+    for (uint32_t k = 0; k < len; k++)
+    {
+      re += h[k] * cos(w * (double)k);
+      im -= h[k] * sin(w * (double)k);
+    }
+    s_w[s_points] = w;
+    raw[s_points] = (re * re) + (im * im);
+    s_points++;
+  }
+  for (uint32_t i = 0; i < s_points; i++)
+  {
+    const uint32_t lo = (i >= FIT_SMOOTH) ? (i - FIT_SMOOTH) : 0u;
+    const uint32_t hi = ((i + FIT_SMOOTH) < s_points) ? (i + FIT_SMOOTH) : (s_points - 1u);
+    double p = 0.0;
+    for (uint32_t j = lo; j <= hi; j++)
+    {
+      p += raw[j];
+    }
+    s_target[i] = 10.0 * log10((p / (double)(hi - lo + 1u)) + 1e-20);
+  }
+  s_floor = s_target[0];
+  for (uint32_t i = 1; i < s_points; i++)
+  {
+    s_floor = fmax(s_floor, s_target[i]);
+  }
+  s_floor -= FIT_RANGE_DB;
+}
+
+static double grid_hz(uint32_t i)
+{
+  return s_w[i] * FIT_FS / (2.0 * FIT_PI);
+}
+
+/* Highpass and lowpass corners where the target falls 6 dB under its
+ * median, then peaks one at a time where the residual is largest.
+ */
+static double fit(Section *s, uint32_t n)
+{
+  static double sorted[FIT_POINTS_MAX];
+  memcpy(sorted, s_target, s_points * sizeof(sorted[0]));
+  for (uint32_t i = 1; i < s_points; i++)
+  {
+    for (uint32_t j = i; (j > 0u) && (sorted[j - 1u] > sorted[j]); j--)
+    {
+      const double t = sorted[j];
+      sorted[j] = sorted[j - 1u];
+      sorted[j - 1u] = t;
+    }
+  }
+  const double floor_db = sorted[s_points / 2u] - 6.0;
+  uint32_t lo = 0;
+  while ((lo + 1u < s_points) && (s_target[lo] < floor_db))
+  {
+    lo++;
+  }
+  uint32_t hi = s_points - 1u;
+  while ((hi > lo) && (s_target[hi] < floor_db))
+  {
+    hi--;
+  }
+  s[0] = (Section){SEC_HP, log2(grid_hz(lo)), -0.5, 0.0};
+  s[1] = (Section){SEC_LP, log2(grid_hz(hi)), -0.5, 0.0};
+  double e = refine(s, 2u);
+
+  static double h[FIT_POINTS_MAX];
+  for (uint32_t k = 2; k < n; k++)
+  {
+    double level = 0.0;
+    (void)fit_error(s, k, &level);
+    cascade_db(s, k, h);
+    uint32_t worst = 0;
+    double worst_d = 0.0;
+    for (uint32_t i = 0; i < s_points; i++)
+    {
+      const double d = fmax(s_target[i], s_floor) - fmax(h[i] + level, s_floor);
+      if (fabs(d) > fabs(worst_d))
+      {
+        worst_d = d;
+        worst = i;
+      }
+    }
+    const double g = fmax(-FIT_GAIN_MAX_DB, fmin(FIT_GAIN_MAX_DB, worst_d));
+    s[k] = (Section){SEC_PEAK, log2(grid_hz(worst)), 1.0, g};
+    e = refine(s, k + 1u);
+  }
+  return e;
+}
+
+static int32_t q28(double v)
+{
+  return (int32_t)lround(v * 268435456.0);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t n = FIT_SECTIONS_MAX;
+  int keep_level = 0;
+  int verbose = 0;
+  const char *path = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-n") == 0) && ((i + 1) < argc))
+    {
+      n = (uint32_t)atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-k") == 0)
+    {
+      keep_level = 1;
+    }
+    else if (strcmp(argv[i], "-v") == 0)
+    {
+      verbose = 1;
+    }
+    else if (argv[i][0] != '-')
+    {
+      path = argv[i];
+    }
+    else
+    {
+      path = NULL;
+      break;
+    }
+  }
+  if ((path == NULL) || (n < 2u) || (n > FIT_SECTIONS_MAX))
+  {
+    fprintf(stderr, "usage: cab_fit [-n sections 2..%u] [-k] [-v] ir.wav\n", (unsigned)FIT_SECTIONS_MAX);
+    return 2;
+  }
+
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+  {
+    perror(path);
+    return 1;
+  }
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *img = malloc((size_t)size);
+  if ((img == NULL) || (fread(img, 1, (size_t)size, f) != (size_t)size))
+  {
+    fprintf(stderr, "%s: read error\n", path);
+    fclose(f);
+    return 1;
+  }
+  fclose(f);
+
+  HostWav w;
+  if (!host_wav_parse(path, img, (size_t)size, &w))
+  {
+    return 1;
+  }
+  AppStereoS24 *x = malloc((size_t)w.frames * sizeof(*x));
+  static double h[FIT_IR_MAX];
+  const uint32_t len = (w.frames < FIT_IR_MAX) ? w.frames : FIT_IR_MAX;
+  if ((x == NULL) || (len == 0u))
+  {
+    fprintf(stderr, "%s: empty IR\n", path);
+    return 1;
+  }
+  host_wav_decode(&w, x);
+  for (uint32_t i = 0; i < len; i++)
+  {
+    h[i] = (double)x[i].l / 8388608.0;
+  }
+
+  measure(h, len);
+  Section s[FIT_SECTIONS_MAX];
+  const double err = fit(s, n);
+  double level = 0.0;
+  (void)fit_error(s, n, &level);
+
+  static double resp[FIT_POINTS_MAX];
+  cascade_db(s, n, resp);
+  double peak = -1e9;
+  for (uint32_t i = 0; i < s_points; i++)
+  {
+    peak = fmax(peak, resp[i]);
+  }
+  const double gain_db = keep_level ? fmin(level, 12.0 - peak) : -peak;
+
+  fprintf(stderr, "%s: %u taps, %u sections, rms error %.2f dB, level %+.1f dB\n", path, (unsigned)len,
+          (unsigned)n, sqrt(err), gain_db);
+  printf("CABIIR N 0\n");
+  for (uint32_t k = 0; k < n; k++)
+  {
+    Biquad z = sec_design(&s[k]);
+    if (k == 0u)
+    {
+      const double g = pow(10.0, gain_db / 20.0);
+      z.b[0] *= g;
+      z.b[1] *= g;
+      z.b[2] *= g;
+    }
+    fprintf(stderr, "  %-4s %7.0f Hz  Q %5.2f  %+5.1f dB\n",
+            (s[k].type == SEC_HP) ? "hp" : (s[k].type == SEC_LP) ? "lp" : "peak", pow(2.0, s[k].lf),
+            pow(2.0, s[k].lq), s[k].g);
+    printf("CABIIR %u %ld %ld %ld %ld %ld\n", (unsigned)k, (long)q28(z.b[0]), (long)q28(z.b[1]), (long)q28(z.b[2]),
+           (long)q28(z.a[1]), (long)q28(z.a[2]));
+  }
+  printf("CABIIR N %u\n", (unsigned)n);
+
+  if (verbose)
+  {
+    for (uint32_t i = 0; i < s_points; i += 8u)
+    {
+      fprintf(stderr, "  %7.0f Hz  target %+6.1f  fit %+6.1f\n", grid_hz(i), s_target[i] - level,
+              resp[i]);
+    }
+  }
+  free(x);
+  free(img);
+  return 0;
+}
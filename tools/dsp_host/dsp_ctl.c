@@ -0,0 +1,1185 @@
+/*
+ * Headless control of pedals over their COM links (app_com.c), for the
+ * production bench and scripts: the same script runs on every device given,
+ * one thread per device, and the replies come back as one JSON array.
+ * - Every command goes out as "#<seq> <command>" followed by "#<seq> PING";
+ *   the lines tagged <seq> up to its PONG are the command's reply, whatever
+ *   its shape (one line, a list and its OK, an ERR). Untagged lines (READY,
+ *   EVT, CR) are skipped, binary frames in between are kept.
+ * - The first step is always CAPS, so each result says what it talked to.
+ * - With -b the link first switches to a faster rate (BAUD, then PING at
+ *   the new one), as in fw_update.
+ *
+ * Script lines (-c, one per option, then -f file, "-" for stdin):
+ *   <command>                  any COM command, e.g. LOAD, PROF, BENCH 200
+ *   FRAME <cmd> [<byte> ...]   a binary frame (hex bytes, e.g. FRAME 04 07
+ *                              for FXMASK 7); the frames back are the reply
+ *   SWEEP <param> <from> <to> <step> [<command>]
+ *                              PSET <param> to each value in turn, and run
+ *                              <command> at each (e.g. LOAD)
+ *   PRESET <file> [<slot>]     <param>=<value> tokens from <file> (# to the
+ *                              end of a line is a comment) as PSETM lines,
+ *                              then PSAVE <slot>
+ *   WAIT <ms>
+ *   FLOOD <ms> [<command>]     <command> (PING by default; one reply line,
+ *                              no side effects) tagged and sent back to back
+ *                              for <ms> as fast as the link takes it, the
+ *                              replies read meanwhile; LINK before and after.
+ *                              Its reply is one line, "FLOOD sent=<n>
+ *                              replies=<n> lost=<n> bytes=<n> rx=<n>
+ *                              dropped_bytes=<n> fw_drop=<n> rate=<n>":
+ *                              replies that never came, bytes sent that the
+ *                              pedal's parser never took, replies it dropped
+ *                              on a full TX queue, commands per second
+ *   CHECK <key><op><number>    op is = != < <= > >=; every <key>= in the
+ *                              replies of the step before (all values of a
+ *                              SWEEP) must hold, and at least one must be
+ *                              there; a failed check fails the device
+ *   # ...                      comment
+ * A reply with an ERR line fails the device too; the script stops there.
+ *
+ * Output: [{"device": ..., "ok": ..., "error": ..., "steps": [...]}, ...],
+ * one step per command ({"cmd", "ms", "reply": [...], "frames": [...]};
+ * each reply line an object with its text and its key=value tokens, as
+ * numbers where they are, % dropped) and per CHECK ({"check", "values",
+ * "pass"}). Exit status 1 when any device failed.
+ *
+ * Usage: dsp_ctl [-r rate] [-b rate] [-t ms] [-c line]... [-f script] device...
+ *   -r the rate the links run at now (115200), -b the rate to run at,
+ *   -t the most one command may take (5000 ms; BENCH stops audio for a
+ *   while).
+ *   dsp_ctl -c "BENCH" -c "CHECK load<80" -c "LATENCY" -c "LOAD" \
+ *     -c "CHECK miss=0" /dev/ttyACM*
+ * Stress test, audio integrity under a COM flood (ITEST in app_com.c): a
+ * quiet run as the reference, then the same run flooded, e.g. at 2 Mbaud
+ *   dsp_ctl -b 2000000 -c "ITEST RUN 3000" -c "WAIT 5000" \
+ *     -c "ITEST RUN 3000" -c "FLOOD 4500 LOAD" -c "CHECK lost=0" \
+ *     -c "CHECK dropped_bytes=0" -c "WAIT 500" -c "ITEST" -c "CHECK match=1" \
+ *     -c "CHECK underrun=0" -c "CHECK miss=0" -c "CHECK dsp_late=0" /dev/ttyUSB0
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CTL_LINE_MAX     512u
+#define CTL_SCRIPT_MAX   1024u
+#define CTL_BIN_SYNC     0xA5u
+#define CTL_BIN_MAX      255u
+#define CTL_PSET_MAX     8u        /* APP_COM_PSET_MAX */
+#define CTL_CMD_MAX      256u      /* APP_COM_LINE_MAX */
+#define CTL_BAUD_MS      2000
+
+typedef struct
+{
+  uint8_t cmd;
+  uint8_t len;
+  uint8_t payload[CTL_BIN_MAX];
+} Frame;
+
+/* One command's reply: its lines (tag stripped) and the frames around it. */
+typedef struct
+{
+  char **lines;
+  size_t n_lines;
+  Frame *frames;
+  size_t n_frames;
+  double ms;
+  int err;                   /* an ERR line came back */
+} Reply;
+
+typedef struct
+{
+  const char *path;
+  int fd;
+  uint32_t seq;
+  uint8_t buf[512];
+  size_t pos;
+  size_t end;
+  uint64_t sent;             /* bytes written */
+  uint64_t sent_cmd;         /* ... up to the end of the last command line */
+  FILE *out;                 /* this device's JSON object */
+  char *json;
+  size_t json_len;
+  int first_step;
+  Reply *last;               /* the previous step's replies, for CHECK */
+  size_t n_last;
+  int ok;
+} Dev;
+
+static const char *s_script[CTL_SCRIPT_MAX];
+static size_t s_n_script;
+static uint32_t s_rate = 115200u;
+static uint32_t s_fast;
+static int s_timeout_ms = 5000;
+
+static double now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec * 1e-6;
+}
+
+static uint16_t crc16_ccitt(const uint8_t *p, size_t n)
+{
+  uint16_t crc = 0xFFFFu;
+  for (size_t i = 0; i < n; i++)
+  {
+    crc ^= (uint16_t)((uint16_t)p[i] << 8);
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/* ---- JSON ---- */
+
+static void json_str(FILE *f, const char *s)
+{
+  fputc('"', f);
+  for (; *s != '\0'; s++)
+  {
+    const unsigned char c = (unsigned char)*s;
+    if ((c == '"') || (c == '\\'))
+    {
+      fprintf(f, "\\%c", c);
+    }
+    else if (c < 0x20u)
+    {
+      fprintf(f, "\\u%04x", c);
+    }
+    else
+    {
+      fputc(c, f);
+    }
+  }
+  fputc('"', f);
+}
+
+/* A value token as a number: decimal, optionally with a trailing %. */
+static int token_num(const char *s, size_t n, double *v)
+{
+  char tmp[64];
+  if ((n == 0u) || (n >= sizeof(tmp)))
+  {
+    return 0;
+  }
+  memcpy(tmp, s, n);
+  tmp[n] = '\0';
+  if (tmp[n - 1u] == '%')
+  {
+    tmp[--n] = '\0';
+  }
+  const char *d = (tmp[0] == '-') ? &tmp[1] : tmp;
+  if ((*d < '0') || (*d > '9'))
+  {
+    return 0;
+  }
+  char *end;
+  *v = strtod(tmp, &end);
+  return (n != 0u) && (*end == '\0');
+}
+
+/* {"text": line, "<key>": <value>, ...} for the key=value tokens. */
+static void json_line(FILE *f, const char *line)
+{
+  fputs("{\"text\": ", f);
+  json_str(f, line);
+  const char *p = line;
+  while (*p != '\0')
+  {
+    while (*p == ' ')
+    {
+      p++;
+    }
+    const char *tok = p;
+    while ((*p != ' ') && (*p != '\0'))
+    {
+      p++;
+    }
+    const char *eq = memchr(tok, '=', (size_t)(p - tok));
+    if ((eq == NULL) || (eq == tok))
+    {
+      continue;
+    }
+    fputs(", \"", f);
+    fwrite(tok, 1, (size_t)(eq - tok), f);
+    fputs("\": ", f);
+    double v;
+    char val[CTL_LINE_MAX];
+    const size_t vn = (size_t)(p - eq - 1);
+    if (token_num(eq + 1, vn, &v))
+    {
+      fprintf(f, "%.15g", v);
+    }
+    else
+    {
+      memcpy(val, eq + 1, vn);
+      val[vn] = '\0';
+      json_str(f, val);
+    }
+  }
+  fputc('}', f);
+}
+
+static void step_begin(Dev *d)
+{
+  fputs(d->first_step ? "\n    " : ",\n    ", d->out);
+  d->first_step = 0;
+}
+
+static void json_reply(Dev *d, const char *cmd, const char *sweep, double value, const Reply *r)
+{
+  FILE *f = d->out;
+  step_begin(d);
+  fputs("{\"cmd\": ", f);
+  json_str(f, cmd);
+  if (sweep != NULL)
+  {
+    fputs(", \"sweep\": ", f);
+    json_str(f, sweep);
+    fprintf(f, ", \"value\": %.15g", value);
+  }
+  fprintf(f, ", \"ms\": %.3f, \"reply\": [", r->ms);
+  for (size_t i = 0; i < r->n_lines; i++)
+  {
+    fputs((i != 0u) ? ", " : "", f);
+    json_line(f, r->lines[i]);
+  }
+  fputs("], \"frames\": [", f);
+  for (size_t i = 0; i < r->n_frames; i++)
+  {
+    fprintf(f, "%s{\"cmd\": %u, \"payload\": \"", (i != 0u) ? ", " : "", r->frames[i].cmd);
+    for (uint32_t k = 0; k < r->frames[i].len; k++)
+    {
+      fprintf(f, "%02x", r->frames[i].payload[k]);
+    }
+    fputs("\"}", f);
+  }
+  fputs("]}", f);
+}
+
+/* ---- serial link ---- */
+
+static speed_t tty_speed(uint32_t rate)
+{
+  switch (rate)
+  {
+  case 115200u: return B115200;
+  case 230400u: return B230400;
+  case 460800u: return B460800;
+  case 921600u: return B921600;
+  case 1000000u: return B1000000;
+  case 2000000u: return B2000000;
+  default: return 0;
+  }
+}
+
+static int tty_rate(int fd, uint32_t rate)
+{
+  struct termios t;
+  const speed_t sp = tty_speed(rate);
+  if ((sp == 0) || (tcgetattr(fd, &t) != 0))
+  {
+    return -1;
+  }
+  cfmakeraw(&t);
+  t.c_cflag |= CLOCAL | CREAD;
+  t.c_cflag &= ~(CRTSCTS | CSTOPB);
+  t.c_cc[VMIN] = 0;
+  t.c_cc[VTIME] = 0;
+  cfsetispeed(&t, sp);
+  cfsetospeed(&t, sp);
+  return tcsetattr(fd, TCSANOW, &t);
+}
+
+static int tty_write(int fd, const void *p, size_t n)
+{
+  const uint8_t *b = p;
+  while (n > 0u)
+  {
+    const ssize_t w = write(fd, b, n);
+    if (w < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return -1;
+    }
+    b += w;
+    n -= (size_t)w;
+  }
+  return 0;
+}
+
+/* A byte, or -1 once the deadline has passed. */
+static int dev_byte(Dev *d, double deadline)
+{
+  while (d->pos == d->end)
+  {
+    const double left = deadline - now_ms();
+    struct pollfd p = {d->fd, POLLIN, 0};
+    if ((left <= 0.0) || (poll(&p, 1, (int)left + 1) <= 0))
+    {
+      return -1;
+    }
+    const ssize_t n = read(d->fd, d->buf, sizeof(d->buf));
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return -1;
+    }
+    d->pos = 0;
+    d->end = (size_t)n;
+  }
+  return d->buf[d->pos++];
+}
+
+static void reply_free(Reply *r)
+{
+  for (size_t i = 0; i < r->n_lines; i++)
+  {
+    free(r->lines[i]);
+  }
+  free(r->lines);
+  free(r->frames);
+  memset(r, 0, sizeof(*r));
+}
+
+/* Sends a tagged command (or a binary frame) and its PING fence, and
+ * collects the reply up to the fence's PONG. 0, or -1 on silence.
+ */
+static int dev_run(Dev *d, const char *cmd, const uint8_t *frame, size_t frame_len, Reply *r)
+{
+  char tag[16];
+  char out[CTL_CMD_MAX + 32u];
+  memset(r, 0, sizeof(*r));
+  d->seq = (d->seq % 99999999u) + 1u;
+  const int tn = snprintf(tag, sizeof(tag), "#%u ", (unsigned)d->seq);
+  int n = 0;
+  if (cmd != NULL)
+  {
+    n = snprintf(out, sizeof(out), "%s%s\n", tag, cmd);
+  }
+  n += snprintf(&out[n], sizeof(out) - (size_t)n, "%sPING\n", tag);
+  const double t0 = now_ms();
+  if (((frame != NULL) && (tty_write(d->fd, frame, frame_len) != 0)) || (tty_write(d->fd, out, (size_t)n) != 0))
+  {
+    return -1;
+  }
+  d->sent += frame_len + (size_t)n;
+  d->sent_cmd = d->sent - (size_t)tn - 5u;
+
+  const double deadline = t0 + (double)s_timeout_ms;
+  char line[CTL_LINE_MAX];
+  size_t len = 0;
+  for (;;)
+  {
+    int c = dev_byte(d, deadline);
+    if (c < 0)
+    {
+      return -1;
+    }
+    if ((len == 0u) && (c == (int)CTL_BIN_SYNC))
+    {
+      uint8_t f[2u + CTL_BIN_MAX + 2u];
+      c = dev_byte(d, deadline);
+      if (c <= 0)
+      {
+        continue;
+      }
+      f[0] = (uint8_t)c;
+      size_t i = 1;
+      for (; i < (size_t)f[0] + 3u; i++)
+      {
+        if ((c = dev_byte(d, deadline)) < 0)
+        {
+          return -1;
+        }
+        f[i] = (uint8_t)c;
+      }
+      const uint16_t crc = (uint16_t)(f[i - 2u] | (f[i - 1u] << 8));
+      if (crc != crc16_ccitt(f, (size_t)f[0] + 1u))
+      {
+        continue;
+      }
+      Frame *fr = realloc(r->frames, (r->n_frames + 1u) * sizeof(Frame));
+      if (fr == NULL)
+      {
+        return -1;
+      }
+      r->frames = fr;
+      fr = &fr[r->n_frames++];
+      fr->cmd = f[1];
+      fr->len = (uint8_t)(f[0] - 1u);
+      memcpy(fr->payload, &f[2], fr->len);
+      continue;
+    }
+    if (c == '\r')
+    {
+      continue;
+    }
+    if (c != '\n')
+    {
+      if (len + 1u < sizeof(line))
+      {
+        line[len++] = (char)c;
+      }
+      continue;
+    }
+    line[len] = '\0';
+    len = 0;
+    if (strncmp(line, tag, (size_t)tn) != 0)
+    {
+      continue;
+    }
+    const char *body = &line[tn];
+    if (strncmp(body, "PONG", 4) == 0)
+    {
+      r->ms = now_ms() - t0;
+      return 0;
+    }
+    char **lines = realloc(r->lines, (r->n_lines + 1u) * sizeof(char *));
+    if ((lines == NULL) || ((lines[r->n_lines] = strdup(body)) == NULL))
+    {
+      r->lines = lines;
+      return -1;
+    }
+    r->lines = lines;
+    r->n_lines++;
+    if (strncmp(body, "ERR", 3) == 0)
+    {
+      r->err = 1;
+    }
+  }
+}
+
+static int dev_open(Dev *d)
+{
+  d->fd = open(d->path, O_RDWR | O_NOCTTY);
+  if ((d->fd < 0) || (tty_rate(d->fd, s_rate) != 0))
+  {
+    return -1;
+  }
+  (void)tcflush(d->fd, TCIOFLUSH);
+  if ((s_fast == 0u) || (s_fast == s_rate))
+  {
+    return 0;
+  }
+  /* The OK goes out at the old rate before the switch: untagged, and no
+   * fence after it.
+   */
+  char cmd[32];
+  Reply r;
+  const int n = snprintf(cmd, sizeof(cmd), "BAUD %u\n", (unsigned)s_fast);
+  char line[CTL_LINE_MAX];
+  size_t len = 0;
+  const double deadline = now_ms() + CTL_BAUD_MS;
+  if (tty_write(d->fd, cmd, (size_t)n) != 0)
+  {
+    return -1;
+  }
+  for (;;)
+  {
+    const int c = dev_byte(d, deadline);
+    if (c < 0)
+    {
+      return -1;
+    }
+    if ((c == '\r') || (c == '\n'))
+    {
+      line[len] = '\0';
+      if (strncmp(line, "ERR", 3) == 0)
+      {
+        return -1;
+      }
+      if (strncmp(line, "OK BAUD", 7) == 0)
+      {
+        break;
+      }
+      len = 0;
+    }
+    else if (len + 1u < sizeof(line))
+    {
+      line[len++] = (char)c;
+    }
+  }
+  if ((tcdrain(d->fd) != 0) || (tty_rate(d->fd, s_fast) != 0))
+  {
+    return -1;
+  }
+  usleep(50000);
+  (void)tcflush(d->fd, TCIFLUSH);
+  d->pos = d->end = 0;
+  const int rc = dev_run(d, NULL, NULL, 0, &r);
+  reply_free(&r);
+  return rc;
+}
+
+/* ---- script ---- */
+
+static void last_set(Dev *d, Reply *r, size_t n)
+{
+  for (size_t i = 0; i < d->n_last; i++)
+  {
+    reply_free(&d->last[i]);
+  }
+  free(d->last);
+  d->last = r;
+  d->n_last = n;
+}
+
+/* Runs one command as a step of its own; 0, or -1 when the device failed. */
+static int step_cmd(Dev *d, const char *cmd, const char *sweep, double value, Reply *r)
+{
+  if (dev_run(d, cmd, NULL, 0, r) != 0)
+  {
+    fprintf(stderr, "%s: no answer to %s\n", d->path, cmd);
+    reply_free(r);
+    return -1;
+  }
+  json_reply(d, cmd, sweep, value, r);
+  if (r->err)
+  {
+    fprintf(stderr, "%s: %s: %s\n", d->path, cmd, r->lines[r->n_lines - 1u]);
+    return -1;
+  }
+  return 0;
+}
+
+static int do_frame(Dev *d, const char *line)
+{
+  uint8_t f[2u + CTL_BIN_MAX + 2u];
+  size_t n = 0;
+  const char *p = line + 5;
+  char *end;
+  for (unsigned long v = strtoul(p, &end, 16); end != p; v = strtoul(p, &end, 16))
+  {
+    if ((v > 0xFFu) || (n + 1u >= CTL_BIN_MAX))
+    {
+      return -1;
+    }
+    f[2u + n++] = (uint8_t)v;
+    p = end;
+  }
+  if (n == 0u)
+  {
+    return -1;
+  }
+  f[0] = CTL_BIN_SYNC;
+  f[1] = (uint8_t)n;
+  const uint16_t crc = crc16_ccitt(&f[1], n + 1u);
+  f[2u + n] = (uint8_t)crc;
+  f[3u + n] = (uint8_t)(crc >> 8);
+  Reply *r = calloc(1, sizeof(Reply));
+  if ((r == NULL) || (dev_run(d, NULL, f, n + 4u, r) != 0))
+  {
+    fprintf(stderr, "%s: no answer to %s\n", d->path, line);
+    free(r);
+    return -1;
+  }
+  last_set(d, r, 1);
+  json_reply(d, line, NULL, 0.0, r);
+  /* A reply frame's first payload byte is its status. */
+  for (size_t i = 0; i < r->n_frames; i++)
+  {
+    if ((r->frames[i].cmd == (uint8_t)(f[2] | 0x80u)) && (r->frames[i].len != 0u) && (r->frames[i].payload[0] != 0u))
+    {
+      fprintf(stderr, "%s: %s: status %u\n", d->path, line, r->frames[i].payload[0]);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int do_sweep(Dev *d, const char *line)
+{
+  char param[64];
+  double from, to, step;
+  int at = 0;
+  if ((sscanf(line, "SWEEP %63s %lf %lf %lf %n", param, &from, &to, &step, &at) != 4) || (step == 0.0) ||
+      ((to - from) / step < 0.0))
+  {
+    return -1;
+  }
+  const char *then = &line[at];
+  const size_t n = (size_t)((to - from) / step + 1e-9) + 1u;
+  Reply *rs = calloc(n, sizeof(Reply));
+  if (rs == NULL)
+  {
+    return -1;
+  }
+  last_set(d, rs, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    const double v = from + step * (double)i;
+    char cmd[CTL_CMD_MAX];
+    Reply r;
+    (void)snprintf(cmd, sizeof(cmd), "PSET %s %.0f", param, v);
+    if (step_cmd(d, cmd, param, v, (*then != '\0') ? &r : &rs[i]) != 0)
+    {
+      return -1;
+    }
+    if (*then != '\0')
+    {
+      reply_free(&r);
+      if (step_cmd(d, then, param, v, &rs[i]) != 0)
+      {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+static int do_preset(Dev *d, const char *line)
+{
+  char path[512];
+  int slot = -1;
+  if (sscanf(line, "PRESET %511s %d", path, &slot) < 1)
+  {
+    return -1;
+  }
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+  {
+    fprintf(stderr, "%s: %s: cannot read\n", d->path, path);
+    return -1;
+  }
+  char cmd[CTL_CMD_MAX];
+  size_t len = 0;
+  uint32_t pairs = 0;
+  char text[CTL_LINE_MAX];
+  Reply *r = calloc(1, sizeof(Reply));
+  int rc = (r != NULL) ? 0 : -1;
+  last_set(d, r, (r != NULL) ? 1u : 0u);
+  while ((rc == 0) && (fgets(text, sizeof(text), f) != NULL))
+  {
+    char *hash = strchr(text, '#');
+    if (hash != NULL)
+    {
+      *hash = '\0';
+    }
+    for (char *tok = strtok(text, " \t\r\n"); (rc == 0) && (tok != NULL); tok = strtok(NULL, " \t\r\n"))
+    {
+      if (strchr(tok, '=') == NULL)
+      {
+        continue;
+      }
+      /* At most CTL_PSET_MAX pairs, and a line the parser takes. */
+      if ((pairs == CTL_PSET_MAX) || ((len != 0u) && (len + 1u + strlen(tok) >= CTL_CMD_MAX)))
+      {
+        reply_free(r);
+        rc = step_cmd(d, cmd, NULL, 0.0, r);
+        pairs = 0;
+        len = 0;
+      }
+      if (len == 0u)
+      {
+        len = (size_t)snprintf(cmd, sizeof(cmd), "PSETM");
+      }
+      len += (size_t)snprintf(&cmd[len], sizeof(cmd) - len, " %s", tok);
+      pairs++;
+    }
+  }
+  fclose(f);
+  if ((rc == 0) && (pairs != 0u))
+  {
+    reply_free(r);
+    rc = step_cmd(d, cmd, NULL, 0.0, r);
+  }
+  if ((rc == 0) && (slot >= 0))
+  {
+    reply_free(r);
+    (void)snprintf(cmd, sizeof(cmd), "PSAVE %d", slot);
+    rc = step_cmd(d, cmd, NULL, 0.0, r);
+  }
+  return rc;
+}
+
+/* LINK, for the asking link's rx= and drop= counters; 0, or -1. */
+static int link_counts(Dev *d, unsigned long *rx, unsigned long *drop)
+{
+  Reply r;
+  if (dev_run(d, "LINK", NULL, 0, &r) != 0)
+  {
+    return -1;
+  }
+  char name[16] = "";
+  for (size_t i = 0; i < r.n_lines; i++)
+  {
+    (void)sscanf(r.lines[i], "OK LINK this=%15s", name);
+  }
+  int rc = -1;
+  for (size_t i = 0; (name[0] != '\0') && (i < r.n_lines); i++)
+  {
+    const char *l = r.lines[i];
+    const size_t nl = strlen(name);
+    const char *prx = strstr(l, " rx=");
+    const char *pdrop = strstr(l, " drop=");
+    if ((strncmp(l, "LINK ", 5) == 0) && (strncmp(&l[5], name, nl) == 0) && (l[5 + nl] == ' ') && (prx != NULL) &&
+        (pdrop != NULL))
+    {
+      *rx = strtoul(prx + 4, NULL, 10);
+      *drop = strtoul(pdrop + 6, NULL, 10);
+      rc = 0;
+    }
+  }
+  reply_free(&r);
+  return rc;
+}
+
+/* Counts a tagged reply line of the flood (first line per tag only). */
+static void flood_line(const char *line, uint32_t first, uint32_t count, uint8_t *seen, uint32_t *replies)
+{
+  char *end;
+  if (line[0] != '#')
+  {
+    return;
+  }
+  const unsigned long seq = strtoul(&line[1], &end, 10);
+  if ((end == &line[1]) || (*end != ' ') || (seq < first) || (seq - first >= count) || seen[seq - first])
+  {
+    return;
+  }
+  seen[seq - first] = 1u;
+  (*replies)++;
+}
+
+static int do_flood(Dev *d, const char *line)
+{
+  int ms = 0;
+  int at = 0;
+  if ((sscanf(line, "FLOOD %d %n", &ms, &at) < 1) || (ms <= 0))
+  {
+    return -1;
+  }
+  const char *cmd = (line[at] != '\0') ? &line[at] : "PING";
+  unsigned long rx0, drop0, rx1, drop1;
+  if (link_counts(d, &rx0, &drop0) != 0)
+  {
+    fprintf(stderr, "%s: no LINK answer\n", d->path);
+    return -1;
+  }
+  const uint64_t sent0 = d->sent_cmd;
+
+  /* Sequence numbers from here on, not wrapped during the flood. */
+  const uint32_t first = d->seq + 1u;
+  uint32_t count = 0;
+  uint32_t replies = 0;
+  size_t cap = 4096;
+  uint8_t *seen = calloc(cap, 1);
+  char pend[CTL_CMD_MAX + 16u];
+  size_t pend_len = 0;
+  size_t pend_pos = 0;
+  char text[CTL_LINE_MAX];
+  size_t len = 0;
+  uint64_t bytes = 0;
+  d->pos = d->end = 0;
+
+  const double t0 = now_ms();
+  const double t_end = t0 + (double)ms;
+  double quiet_until = 0.0;
+  int rc = (seen != NULL) ? 0 : -1;
+  while (rc == 0)
+  {
+    const double now = now_ms();
+    const int sending = (now < t_end) || (pend_pos < pend_len);
+    if (!sending)
+    {
+      /* Done once every reply is in, or after 200 ms without a byte. */
+      if ((replies == count) ||
+          ((quiet_until != 0.0) && ((now >= quiet_until) || (now >= t_end + (double)s_timeout_ms))))
+      {
+        break;
+      }
+      if (quiet_until == 0.0)
+      {
+        quiet_until = now + 200.0;
+      }
+    }
+    if (sending && (pend_pos == pend_len))
+    {
+      if (count == cap)
+      {
+        uint8_t *more = realloc(seen, cap * 2u);
+        if (more == NULL)
+        {
+          rc = -1;
+          break;
+        }
+        memset(&more[cap], 0, cap);
+        seen = more;
+        cap *= 2u;
+      }
+      pend_len = (size_t)snprintf(pend, sizeof(pend), "#%u %s\n", (unsigned)(first + count), cmd);
+      pend_pos = 0;
+      count++;
+    }
+    struct pollfd p = {d->fd, (short)(POLLIN | ((pend_pos < pend_len) ? POLLOUT : 0)), 0};
+    if (poll(&p, 1, 1) < 0)
+    {
+      if (errno != EINTR)
+      {
+        rc = -1;
+      }
+      continue;
+    }
+    if (p.revents & POLLOUT)
+    {
+      const ssize_t w = write(d->fd, &pend[pend_pos], pend_len - pend_pos);
+      if ((w < 0) && (errno != EINTR) && (errno != EAGAIN))
+      {
+        rc = -1;
+        break;
+      }
+      if (w > 0)
+      {
+        pend_pos += (size_t)w;
+        bytes += (uint64_t)w;
+      }
+    }
+    if (p.revents & POLLIN)
+    {
+      uint8_t b[512];
+      const ssize_t n = read(d->fd, b, sizeof(b));
+      for (ssize_t i = 0; i < n; i++)
+      {
+        if (b[i] == '\n')
+        {
+          text[len] = '\0';
+          flood_line(text, first, count, seen, &replies);
+          len = 0;
+        }
+        else if ((b[i] != '\r') && (len + 1u < sizeof(text)))
+        {
+          text[len++] = (char)b[i];
+        }
+      }
+      if (n > 0)
+      {
+        quiet_until = (quiet_until != 0.0) ? now_ms() + 200.0 : 0.0;
+      }
+    }
+  }
+  const double took = now_ms() - t0;
+  free(seen);
+  d->seq = (first + count - 1u) % 99999999u;
+  d->sent += bytes;
+  if ((rc != 0) || (link_counts(d, &rx1, &drop1) != 0))
+  {
+    fprintf(stderr, "%s: %s: link failed\n", d->path, line);
+    return -1;
+  }
+
+  /* The parser has taken everything up to the second LINK's newline. */
+  const uint64_t expect = d->sent_cmd - sent0;
+  const unsigned long got = rx1 - rx0;
+  Reply *r = calloc(1, sizeof(Reply));
+  char *out = malloc(CTL_LINE_MAX);
+  if ((r == NULL) || (out == NULL) || ((r->lines = malloc(sizeof(char *))) == NULL))
+  {
+    free(r);
+    free(out);
+    return -1;
+  }
+  (void)snprintf(out, CTL_LINE_MAX,
+                 "FLOOD sent=%u replies=%u lost=%u bytes=%llu rx=%lu dropped_bytes=%lld fw_drop=%lu rate=%.0f",
+                 (unsigned)count, (unsigned)replies, (unsigned)(count - replies), (unsigned long long)bytes, got,
+                 (long long)expect - (long long)got, drop1 - drop0, (double)count * 1000.0 / (double)ms);
+  r->lines[0] = out;
+  r->n_lines = 1u;
+  r->ms = took;
+  last_set(d, r, 1);
+  json_reply(d, line, NULL, 0.0, r);
+  return 0;
+}
+
+/* 1 pass, 0 fail, -1 malformed. */
+static int do_check(Dev *d, const char *line)
+{
+  const char *p = line + 6;
+  char key[64];
+  size_t klen = 0;
+  while (((*p >= 'a') && (*p <= 'z')) || ((*p >= 'A') && (*p <= 'Z')) || ((*p >= '0') && (*p <= '9')) ||
+         (*p == '_'))
+  {
+    if (klen + 1u < sizeof(key))
+    {
+      key[klen++] = *p;
+    }
+    p++;
+  }
+  key[klen] = '\0';
+  char op[3] = {0};
+  for (size_t i = 0; (i < 2u) && (strchr("=!<>", *p) != NULL) && (*p != '\0'); i++)
+  {
+    op[i] = *p++;
+  }
+  char *end;
+  const double want = strtod(p, &end);
+  if ((klen == 0u) || (end == p) || (*end != '\0'))
+  {
+    return -1;
+  }
+
+  FILE *out = d->out;
+  step_begin(d);
+  fputs("{\"check\": ", out);
+  json_str(out, line + 6);
+  fputs(", \"values\": [", out);
+  int pass = 1;
+  size_t seen = 0;
+  for (size_t i = 0; i < d->n_last; i++)
+  {
+    for (size_t l = 0; l < d->last[i].n_lines; l++)
+    {
+      for (const char *s = d->last[i].lines[l]; (s = strstr(s, key)) != NULL; s += klen)
+      {
+        if (((s != d->last[i].lines[l]) && (s[-1] != ' ')) || (s[klen] != '='))
+        {
+          continue;
+        }
+        const char *v = &s[klen + 1u];
+        double got;
+        if (!token_num(v, strcspn(v, " "), &got))
+        {
+          continue;
+        }
+        fprintf(out, "%s%.15g", (seen != 0u) ? ", " : "", got);
+        seen++;
+        int ok;
+        if ((strcmp(op, "=") == 0) || (strcmp(op, "==") == 0)) ok = (got == want);
+        else if (strcmp(op, "!=") == 0) ok = (got != want);
+        else if (strcmp(op, "<") == 0) ok = (got < want);
+        else if (strcmp(op, "<=") == 0) ok = (got <= want);
+        else if (strcmp(op, ">") == 0) ok = (got > want);
+        else if (strcmp(op, ">=") == 0) ok = (got >= want);
+        else return -1;
+        pass = pass && ok;
+      }
+    }
+  }
+  pass = pass && (seen != 0u);
+  fprintf(out, "], \"pass\": %s}", pass ? "true" : "false");
+  if (!pass)
+  {
+    fprintf(stderr, "%s: CHECK %s failed\n", d->path, line + 6);
+  }
+  return pass;
+}
+
+/* 0 next line, 1 failed check (go on), -1 stop. */
+static int do_line(Dev *d, const char *line)
+{
+  if (strncmp(line, "FRAME ", 6) == 0)
+  {
+    return do_frame(d, line);
+  }
+  if (strncmp(line, "SWEEP ", 6) == 0)
+  {
+    return do_sweep(d, line);
+  }
+  if (strncmp(line, "PRESET ", 7) == 0)
+  {
+    return do_preset(d, line);
+  }
+  if (strncmp(line, "FLOOD ", 6) == 0)
+  {
+    return do_flood(d, line);
+  }
+  if (strncmp(line, "WAIT ", 5) == 0)
+  {
+    usleep((useconds_t)strtoul(line + 5, NULL, 10) * 1000u);
+    return 0;
+  }
+  if (strncmp(line, "CHECK ", 6) == 0)
+  {
+    const int c = do_check(d, line);
+    return (c < 0) ? -1 : (c == 0) ? 1 : 0;
+  }
+  Reply *r = calloc(1, sizeof(Reply));
+  if (r == NULL)
+  {
+    return -1;
+  }
+  last_set(d, r, 1);
+  return step_cmd(d, line, NULL, 0.0, r);
+}
+
+static void *dev_thread(void *arg)
+{
+  Dev *d = arg;
+  d->out = open_memstream(&d->json, &d->json_len);
+  if (d->out == NULL)
+  {
+    return NULL;
+  }
+  fputs("{\"device\": ", d->out);
+  json_str(d->out, d->path);
+  fputs(", \"steps\": [", d->out);
+  d->first_step = 1;
+
+  const char *error = NULL;
+  int failed = 0;
+  if (dev_open(d) != 0)
+  {
+    error = "cannot open or switch rate";
+  }
+  else if (do_line(d, "CAPS") != 0)
+  {
+    error = "no CAPS";
+  }
+  for (size_t i = 0; (error == NULL) && (i < s_n_script); i++)
+  {
+    const int rc = do_line(d, s_script[i]);
+    if (rc < 0)
+    {
+      error = s_script[i];
+    }
+    failed |= rc;
+  }
+  last_set(d, NULL, 0);
+  if (d->fd >= 0)
+  {
+    close(d->fd);
+  }
+
+  d->ok = (error == NULL) && !failed;
+  fprintf(d->out, "\n  ], \"ok\": %s, \"error\": ", d->ok ? "true" : "false");
+  if (error != NULL)
+  {
+    json_str(d->out, error);
+  }
+  else
+  {
+    fputs("null", d->out);
+  }
+  fputc('}', d->out);
+  fclose(d->out);
+  return NULL;
+}
+
+static int script_add(const char *line)
+{
+  while ((*line == ' ') || (*line == '\t'))
+  {
+    line++;
+  }
+  if ((*line == '\0') || (*line == '#'))
+  {
+    return 0;
+  }
+  if (s_n_script == CTL_SCRIPT_MAX)
+  {
+    fprintf(stderr, "script longer than %u lines\n", CTL_SCRIPT_MAX);
+    return -1;
+  }
+  s_script[s_n_script++] = line;
+  return 0;
+}
+
+static int script_file(const char *path)
+{
+  FILE *f = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+  if (f == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+  char text[CTL_LINE_MAX];
+  int rc = 0;
+  while ((rc == 0) && (fgets(text, sizeof(text), f) != NULL))
+  {
+    text[strcspn(text, "\r\n")] = '\0';
+    char *line = strdup(text);
+    rc = (line != NULL) ? script_add(line) : -1;
+  }
+  if (f != stdin)
+  {
+    fclose(f);
+  }
+  return rc;
+}
+
+int main(int argc, char **argv)
+{
+  static const char usage[] = "usage: %s [-r rate] [-b rate] [-t ms] [-c line]... [-f script] device...\n";
+  const char *file = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:b:t:c:f:h")) != -1)
+  {
+    switch (opt)
+    {
+    case 'r': s_rate = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case 'b': s_fast = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case 't': s_timeout_ms = atoi(optarg); break;
+    case 'c':
+      if (script_add(optarg) != 0)
+      {
+        return 2;
+      }
+      break;
+    case 'f': file = optarg; break;
+    default:
+      fprintf(stderr, usage, argv[0]);
+      return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((optind == argc) || (s_timeout_ms <= 0) || ((file != NULL) && (script_file(file) != 0)))
+  {
+    fprintf(stderr, usage, argv[0]);
+    return 2;
+  }
+
+  const int n = argc - optind;
+  Dev *devs = calloc((size_t)n, sizeof(Dev));
+  pthread_t *th = calloc((size_t)n, sizeof(pthread_t));
+  uint8_t *started = calloc((size_t)n, 1);
+  if ((devs == NULL) || (th == NULL) || (started == NULL))
+  {
+    return 1;
+  }
+  for (int i = 0; i < n; i++)
+  {
+    devs[i].path = argv[optind + i];
+    devs[i].fd = -1;
+    started[i] = (pthread_create(&th[i], NULL, dev_thread, &devs[i]) == 0);
+    if (!started[i])
+    {
+      (void)dev_thread(&devs[i]);
+    }
+  }
+
+  int all_ok = 1;
+  fputs("[", stdout);
+  for (int i = 0; i < n; i++)
+  {
+    if (started[i])
+    {
+      pthread_join(th[i], NULL);
+    }
+    printf("%s\n  %s", (i != 0) ? "," : "", (devs[i].json != NULL) ? devs[i].json : "null");
+    all_ok = all_ok && devs[i].ok;
+    free(devs[i].json);
+  }
+  fputs("\n]\n", stdout);
+  free(started);
+  free(th);
+  free(devs);
+  return all_ok ? 0 : 1;
+}
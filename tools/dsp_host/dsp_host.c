@@ -0,0 +1,621 @@
+/*
+ * Host harness for the DSP chain.
+ * - Runs a WAV file or a synthetic signal through the unchanged app_dsp.c,
+ *   once per FX mask, each from a fresh AppDsp_Init().
+ * - Reports ns per frame of the processing call alone and a 64-bit FNV-1a
+ *   hash of the output, optionally writes the output as 24-bit WAV.
+ * - A golden file (-G to write, -g to check) holds one "mask <m> n <frames>
+ *   <hash>" line per mask and call size: record it on the commit before a
+ *   DSP change, check it after with the same signal and -p options to
+ *   prove the change is bit-exact. Exit status 2 on a mismatch.
+ * - -c compares against the -o output of another build (e.g. dsp_host vs
+ *   dsp_host_float): largest difference in LSB and the difference power
+ *   relative to the reference. With -s sine each mask also reports the
+ *   THD+N of its output. Host ns/frame is only a rough guide to the M4F;
+ *   COM BENCH gives the target cycles of either build, and tools/m4_bench
+ *   the emulated instruction count of the same kernels without a board.
+ * - -K <blocks> runs the chains of COM BENCH and the DSP kernels of
+ *   BENCH KERNEL instead (AppDsp_BenchChain(), AppDsp_BenchKernel(); the
+ *   audio-path kernels need the HAL), <blocks> blocks of -n frames each (64 if -n
+ *   is 1), best of -r, and prints them as BENCH lines in ns_frame= for
+ *   tools/m4_bench/bench_diff.sh.
+ *
+ * Usage: dsp_host [-i in.wav | -s sine|noise|impulse|sweep|pluck] [-t sec]
+ *                 [-m mask] [-n frames] [-p name=value]... [-o prefix]
+ *                 [-g golden.txt | -G golden.txt] [-c prefix] [-r repeats]
+ *                 [-x chain] [-C cab.txt] [-K blocks]
+ *   -n 1 (default) calls AppDsp_ProcessFrame(), more calls
+ *   AppDsp_ProcessBlock() with that block size.
+ *   -x sets the FX order (AppDsp_SetChain(), e.g.
+ *   wah>pitch>distortion>eq>phaser>chorus>delay|reverb).
+ *   -C loads a user cab from the CABIIR lines cab_fit prints.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "app_dsp.h"
+#include "host_wav.h"
+
+#define HOST_SAMPLE_RATE APP_DSP_SAMPLE_RATE_HZ
+#define HOST_BLOCK_MAX   256u
+#define HOST_PARAMS_MAX  16u
+#define HOST_MASK_ALL    0xFFFFFFFFu
+#define HOST_MASK_COUNT  32u      /* every AppFxBit combination */
+#define HOST_SINE_HZ     440.0
+#define HOST_SINE_WINDOW (1200u * (HOST_SAMPLE_RATE / 48000u))   /* 11 whole periods of HOST_SINE_HZ */
+
+typedef struct
+{
+  AppStereoS24 *x;
+  uint32_t frames;
+} HostSignal;
+
+typedef struct
+{
+  const char *in_path;
+  const char *synth;
+  double seconds;
+  uint32_t mask;
+  uint32_t block;
+  uint32_t repeats;
+  const char *out_prefix;
+  const char *golden_check;
+  const char *golden_write;
+  const char *compare_prefix;
+  const char *chain;
+  const char *cab_path;
+  uint32_t bench_blocks;
+  uint32_t param_count;
+  AppDspParamId param_id[HOST_PARAMS_MAX];
+  int32_t param_value[HOST_PARAMS_MAX];
+} HostOptions;
+
+/* ------------------------------- WAV I/O --------------------------------- */
+
+static int32_t clamp_s24(int64_t v)
+{
+  if (v > 8388607)
+  {
+    return 8388607;
+  }
+  if (v < -8388608)
+  {
+    return -8388608;
+  }
+  return (int32_t)v;
+}
+
+/* Whole file into memory, decoded by host_wav (mono feeds both sides). */
+static int wav_read(const char *path, HostSignal *sig)
+{
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *buf = (size > 12) ? (uint8_t *)malloc((size_t)size) : NULL;
+  if ((buf == NULL) || (fread(buf, 1, (size_t)size, f) != (size_t)size))
+  {
+    fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+    fclose(f);
+    free(buf);
+    return 0;
+  }
+  fclose(f);
+  HostWav w;
+  if (!host_wav_parse(path, buf, (size_t)size, &w))
+  {
+    free(buf);
+    return 0;
+  }
+
+  sig->frames = w.frames;
+  sig->x = (AppStereoS24 *)calloc(sig->frames ? sig->frames : 1u, sizeof(AppStereoS24));
+  host_wav_decode(&w, sig->x);
+  free(buf);
+  return 1;
+}
+
+/* --------------------------- Synthetic signals --------------------------- */
+
+static uint32_t s_rng = 1u;
+
+static int32_t rng_s24(void)
+{
+  s_rng = (s_rng * 1664525u) + 1013904223u;
+  return (int32_t)(s_rng >> 8) - 8388608;
+}
+
+/* Deterministic stimuli at -6 dBFS (noise at -12 dBFS). 'pluck' is a train
+ * of decaying saw notes across the guitar range, the closest to real use.
+ */
+static int synth(const char *name, double seconds, HostSignal *sig)
+{
+  const double amp = 4194304.0;
+  sig->frames = (uint32_t)(seconds * HOST_SAMPLE_RATE);
+  sig->x = (AppStereoS24 *)calloc(sig->frames ? sig->frames : 1u, sizeof(AppStereoS24));
+  s_rng = 1u;
+  double ph = 0.0;
+  for (uint32_t i = 0; i < sig->frames; i++)
+  {
+    const double t = (double)i / HOST_SAMPLE_RATE;
+    double v;
+    if (strcmp(name, "sine") == 0)
+    {
+      v = amp * sin(2.0 * M_PI * HOST_SINE_HZ * t);
+    }
+    else if (strcmp(name, "noise") == 0)
+    {
+      v = (double)(rng_s24() / 4);
+    }
+    else if (strcmp(name, "impulse") == 0)
+    {
+      v = ((i % HOST_SAMPLE_RATE) == 0u) ? amp : 0.0;
+    }
+    else if (strcmp(name, "sweep") == 0)
+    {
+      /* Log sweep 20 Hz..20 kHz over the whole signal. */
+      const double k = log(1000.0) / seconds;
+      v = amp * sin(2.0 * M_PI * 20.0 * (exp(k * t) - 1.0) / k);
+    }
+    else if (strcmp(name, "pluck") == 0)
+    {
+      static const double k_notes[] = {82.41, 110.0, 146.83, 196.0, 246.94, 329.63};
+      const uint32_t note = (i / (HOST_SAMPLE_RATE / 2u)) % 6u;
+      const double tn = (double)(i % (HOST_SAMPLE_RATE / 2u)) / HOST_SAMPLE_RATE;
+      ph += k_notes[note] / HOST_SAMPLE_RATE;
+      ph -= floor(ph);
+      v = amp * ((2.0 * ph) - 1.0) * exp(-6.0 * tn);
+    }
+    else
+    {
+      fprintf(stderr, "unknown signal '%s'\n", name);
+      return 0;
+    }
+    sig->x[i].l = clamp_s24((int64_t)lrint(v));
+    sig->x[i].r = sig->x[i].l;
+  }
+  return 1;
+}
+
+/* --------------------------------- Run ----------------------------------- */
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t fnv1a64(const AppStereoS24 *x, uint32_t frames)
+{
+  uint64_t h = 0xCBF29CE484222325u;
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    const int32_t s[2] = {x[i].l, x[i].r};
+    for (uint32_t c = 0; c < 2u; c++)
+    {
+      for (uint32_t b = 0; b < 4u; b++)
+      {
+        h ^= (uint8_t)((uint32_t)s[c] >> (8u * b));
+        h *= 0x100000001B3u;
+      }
+    }
+  }
+  return h;
+}
+
+/* THD+N of the left channel of a HOST_SINE_HZ output, in dB: DC and the
+ * fundamental are projected out over the whole windows of the second half,
+ * past the filter and compressor settling, and the rest is distortion and
+ * noise. 0 if the signal is too short.
+ */
+static double thdn_db(const AppStereoS24 *x, uint32_t frames)
+{
+  const uint32_t len = ((frames / 2u) / HOST_SINE_WINDOW) * HOST_SINE_WINDOW;
+  if (len == 0u)
+  {
+    return 0.0;
+  }
+  const uint32_t start = frames - len;
+  const double w = 2.0 * M_PI * HOST_SINE_HZ / HOST_SAMPLE_RATE;
+  double dc = 0.0, a = 0.0, b = 0.0;
+  for (uint32_t i = start; i < frames; i++)
+  {
+    const double v = (double)x[i].l;
+    dc += v;
+    a += v * cos(w * (double)i);
+    b += v * sin(w * (double)i);
+  }
+  dc /= (double)len;
+  a *= 2.0 / (double)len;
+  b *= 2.0 / (double)len;
+  double res = 0.0;
+  for (uint32_t i = start; i < frames; i++)
+  {
+    const double e = (double)x[i].l - dc - (a * cos(w * (double)i)) - (b * sin(w * (double)i));
+    res += e * e;
+  }
+  const double fund = 0.5 * ((a * a) + (b * b)) * (double)len;
+  return (fund > 0.0) ? (10.0 * log10((res + 1e-30) / fund)) : 0.0;
+}
+
+/* Difference against ref: largest |out - ref| in LSB, power in dB re ref. */
+static void compare(const AppStereoS24 *x, const HostSignal *ref, uint32_t frames, int32_t *max_lsb, double *db)
+{
+  const uint32_t n = (ref->frames < frames) ? ref->frames : frames;
+  double err = 0.0, sig = 0.0;
+  int32_t m = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const int32_t d[2] = {x[i].l - ref->x[i].l, x[i].r - ref->x[i].r};
+    for (uint32_t c = 0; c < 2u; c++)
+    {
+      const int32_t v = (d[c] < 0) ? -d[c] : d[c];
+      m = (v > m) ? v : m;
+      err += (double)d[c] * (double)d[c];
+    }
+    sig += ((double)ref->x[i].l * ref->x[i].l) + ((double)ref->x[i].r * ref->x[i].r);
+  }
+  *max_lsb = m;
+  *db = (sig > 0.0) ? (10.0 * log10((err + 1e-30) / sig)) : 0.0;
+}
+
+/* The CABIIR lines of cab_fit, applied as COM would (inside the batch). */
+static int cab_load(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+  {
+    perror(path);
+    return 0;
+  }
+  char line[160];
+  int ok = 1;
+  while (ok && (fgets(line, sizeof(line), f) != NULL))
+  {
+    long c[5];
+    unsigned long k;
+    if (sscanf(line, "CABIIR N %lu", &k) == 1)
+    {
+      ok = AppDsp_SetCabSections((uint32_t)k);
+    }
+    else if (sscanf(line, "CABIIR %lu %ld %ld %ld %ld %ld", &k, &c[0], &c[1], &c[2], &c[3], &c[4]) == 6)
+    {
+      const int32_t sos[5] = {(int32_t)c[0], (int32_t)c[1], (int32_t)c[2], (int32_t)c[3], (int32_t)c[4]};
+      ok = AppDsp_SetCabSection((uint32_t)k, sos);
+    }
+  }
+  fclose(f);
+  if (!ok)
+  {
+    fprintf(stderr, "%s: bad CABIIR line: %s", path, line);
+  }
+  return ok;
+}
+
+static void dsp_setup(const HostOptions *o, uint32_t mask)
+{
+  AppDsp_Init();
+  AppDsp_BeginParams();
+  for (uint32_t i = 0; i < o->param_count; i++)
+  {
+    AppDsp_SetParam(o->param_id[i], o->param_value[i]);
+  }
+  AppDsp_SetFxMask(mask);
+  if ((o->chain != NULL) && !AppDsp_SetChain(o->chain))
+  {
+    fprintf(stderr, "bad chain '%s'\n", o->chain);
+    exit(1);
+  }
+  if ((o->cab_path != NULL) && !cab_load(o->cab_path))
+  {
+    exit(1);
+  }
+  AppDsp_CommitParams();
+}
+
+/* Processes sig into out; returns the time spent in the DSP calls. */
+static uint64_t dsp_run(const HostOptions *o, const HostSignal *sig, AppStereoS24 *out)
+{
+  memcpy(out, sig->x, sig->frames * sizeof(AppStereoS24));
+  uint64_t t0 = now_ns();
+  if (o->block <= 1u)
+  {
+    for (uint32_t i = 0; i < sig->frames; i++)
+    {
+      AppDsp_ProcessFrame(&out[i].l, &out[i].r);
+    }
+  }
+  else
+  {
+    for (uint32_t i = 0; i < sig->frames; i += o->block)
+    {
+      const uint32_t n = ((sig->frames - i) < o->block) ? (sig->frames - i) : o->block;
+      AppDsp_ProcessBlock(&out[i], n);
+    }
+  }
+  return now_ns() - t0;
+}
+
+/* -K: one BENCH item, best of o->repeats; kind 0 chain, 1 kernel per
+ * frame, 2 kernel per block.
+ */
+static void bench_item(const HostOptions *o, uint32_t kind, uint32_t i, const char *name, AppStereoS24 *x, uint32_t n)
+{
+  uint64_t best = UINT64_MAX;
+  for (uint32_t r = 0; r < o->repeats; r++)
+  {
+    uint64_t ns;
+    switch (kind)
+    {
+      case 0: ns = AppDsp_BenchChain((AppFxMask)i, x, n, o->bench_blocks); break;
+      default: ns = AppDsp_BenchKernel((AppDspKernel)i, (kind == 1u) ? 1u : 0u, x, n, o->bench_blocks); break;
+    }
+    if (ns < best)
+    {
+      best = ns;
+    }
+  }
+  static const char *const k_kind[] = {"chain", "kernel", "kernel"};
+  printf("BENCH %s %s ns_frame=%.2f\n", k_kind[kind], name, (double)best / ((double)o->bench_blocks * n));
+}
+
+static void bench_all(const HostOptions *o)
+{
+  const uint32_t n = (o->block > 1u) ? o->block : 64u;
+  AppStereoS24 x[HOST_BLOCK_MAX];
+  char name[48];
+  dsp_setup(o, HOST_MASK_COUNT - 1u);
+  for (uint32_t m = 0; m < HOST_MASK_COUNT; m++)
+  {
+    (void)snprintf(name, sizeof(name), "fxmask=%lu", (unsigned long)m);
+    bench_item(o, 0u, m, name, x, n);
+  }
+  for (uint32_t k = 0; k < (uint32_t)APP_DSP_KERNEL_COUNT; k++)
+  {
+    (void)snprintf(name, sizeof(name), "%s/frame", AppDsp_KernelName((AppDspKernel)k));
+    bench_item(o, 1u, k, name, x, n);
+    (void)snprintf(name, sizeof(name), "%s/block", AppDsp_KernelName((AppDspKernel)k));
+    bench_item(o, 2u, k, name, x, n);
+  }
+  printf("OK BENCH blocks=%lu frames=%lu\n", (unsigned long)o->bench_blocks, (unsigned long)n);
+}
+
+static int golden_lookup(const char *path, uint32_t mask, uint32_t block, uint64_t *out)
+{
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+  {
+    return 0;
+  }
+  char line[128];
+  int found = 0;
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    unsigned long m, n;
+    unsigned long long h;
+    if ((sscanf(line, "mask %lu n %lu %llx", &m, &n, &h) == 3) && (m == mask) && (n == block))
+    {
+      *out = (uint64_t)h;
+      found = 1;
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: dsp_host [-i in.wav | -s sine|noise|impulse|sweep|pluck] [-t sec]\n"
+          "                [-m mask] [-n frames] [-p name=value]... [-o prefix]\n"
+          "                [-g golden.txt | -G golden.txt] [-c prefix] [-r repeats]\n"
+          "                [-x chain] [-C cab.txt] [-K blocks]\n");
+}
+
+static int parse_args(int argc, char **argv, HostOptions *o)
+{
+  memset(o, 0, sizeof(*o));
+  o->synth = "pluck";
+  o->seconds = 3.0;
+  o->mask = HOST_MASK_ALL;
+  o->block = 1u;
+  o->repeats = 1u;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *a = argv[i];
+    const char *v = ((i + 1) < argc) ? argv[i + 1] : NULL;
+    if ((a[0] != '-') || (a[1] == 0) || (a[2] != 0) || ((a[1] != 'h') && (v == NULL)))
+    {
+      usage();
+      return 0;
+    }
+    i++;
+    switch (a[1])
+    {
+      case 'i': o->in_path = v; break;
+      case 's': o->synth = v; break;
+      case 't': o->seconds = atof(v); break;
+      case 'm': o->mask = (uint32_t)strtoul(v, NULL, 0); break;
+      case 'n': o->block = (uint32_t)strtoul(v, NULL, 0); break;
+      case 'r': o->repeats = (uint32_t)strtoul(v, NULL, 0); break;
+      case 'o': o->out_prefix = v; break;
+      case 'g': o->golden_check = v; break;
+      case 'G': o->golden_write = v; break;
+      case 'c': o->compare_prefix = v; break;
+      case 'x': o->chain = v; break;
+      case 'C': o->cab_path = v; break;
+      case 'K': o->bench_blocks = (uint32_t)strtoul(v, NULL, 0); break;
+      case 'p':
+      {
+        char name[48];
+        const char *eq = strchr(v, '=');
+        AppDspParamId id;
+        if ((eq == NULL) || ((size_t)(eq - v) >= sizeof(name)) || (o->param_count >= HOST_PARAMS_MAX))
+        {
+          usage();
+          return 0;
+        }
+        memcpy(name, v, (size_t)(eq - v));
+        name[eq - v] = 0;
+        if (!AppDsp_FindParam(name, &id))
+        {
+          fprintf(stderr, "unknown param '%s'\n", name);
+          return 0;
+        }
+        o->param_id[o->param_count] = id;
+        o->param_value[o->param_count] = (int32_t)strtol(eq + 1, NULL, 0);
+        o->param_count++;
+        break;
+      }
+      default:
+        usage();
+        return 0;
+    }
+  }
+  if (o->block == 0u)
+  {
+    o->block = 1u;
+  }
+  if ((o->block > HOST_BLOCK_MAX) || (o->repeats == 0u) || ((o->mask != HOST_MASK_ALL) && (o->mask >= HOST_MASK_COUNT)))
+  {
+    usage();
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  HostOptions o;
+  if (!parse_args(argc, argv, &o))
+  {
+    return 1;
+  }
+
+  if (o.bench_blocks != 0u)
+  {
+    bench_all(&o);
+    return 0;
+  }
+
+  HostSignal sig;
+  if (!(o.in_path ? wav_read(o.in_path, &sig) : synth(o.synth, o.seconds, &sig)) || (sig.frames == 0u))
+  {
+    return 1;
+  }
+  AppStereoS24 *out = (AppStereoS24 *)malloc(sig.frames * sizeof(AppStereoS24));
+  FILE *golden = NULL;
+  if (o.golden_write != NULL)
+  {
+    golden = fopen(o.golden_write, "w");
+    if (golden == NULL)
+    {
+      fprintf(stderr, "%s: %s\n", o.golden_write, strerror(errno));
+      return 1;
+    }
+  }
+
+  printf("%s: %lu frames, %s\n", o.in_path ? o.in_path : o.synth, (unsigned long)sig.frames,
+         (o.block <= 1u) ? "ProcessFrame" : "ProcessBlock");
+  int mismatch = 0;
+  for (uint32_t mask = 0; mask < HOST_MASK_COUNT; mask++)
+  {
+    if ((o.mask != HOST_MASK_ALL) && (mask != o.mask))
+    {
+      continue;
+    }
+
+    /* Best of 'repeats' runs; each starts from the same state, so the
+     * output (and hash) is the same every time.
+     */
+    uint64_t best = UINT64_MAX;
+    for (uint32_t r = 0; r < o.repeats; r++)
+    {
+      dsp_setup(&o, mask);
+      uint64_t ns = dsp_run(&o, &sig, out);
+      if (ns < best)
+      {
+        best = ns;
+      }
+    }
+    const uint64_t hash = fnv1a64(out, sig.frames);
+
+    const char *verdict = "";
+    uint64_t want;
+    if (o.golden_check != NULL)
+    {
+      if (!golden_lookup(o.golden_check, mask, o.block, &want))
+      {
+        verdict = " golden=missing";
+        mismatch = 1;
+      }
+      else if (want != hash)
+      {
+        verdict = " golden=MISMATCH";
+        mismatch = 1;
+      }
+      else
+      {
+        verdict = " golden=ok";
+      }
+    }
+    printf("mask %lu  %7.2f ns/frame  hash %016llx%s", (unsigned long)mask,
+           (double)best / (double)sig.frames, (unsigned long long)hash, verdict);
+    if ((o.in_path == NULL) && (strcmp(o.synth, "sine") == 0))
+    {
+      printf("  thdn %6.1f dB", thdn_db(out, sig.frames));
+    }
+    if (o.compare_prefix != NULL)
+    {
+      char path[512];
+      HostSignal ref;
+      (void)snprintf(path, sizeof(path), "%s_m%lu.wav", o.compare_prefix, (unsigned long)mask);
+      if (!wav_read(path, &ref))
+      {
+        return 1;
+      }
+      int32_t max_lsb;
+      double db;
+      compare(out, &ref, sig.frames, &max_lsb, &db);
+      printf("  diff max %ld lsb %6.1f dB", (long)max_lsb, db);
+      free(ref.x);
+    }
+    printf("\n");
+
+    if (golden != NULL)
+    {
+      fprintf(golden, "mask %lu n %lu %016llx\n", (unsigned long)mask, (unsigned long)o.block,
+              (unsigned long long)hash);
+    }
+    if (o.out_prefix != NULL)
+    {
+      char path[512];
+      (void)snprintf(path, sizeof(path), "%s_m%lu.wav", o.out_prefix, (unsigned long)mask);
+      if (!host_wav_write(path, out, sig.frames))
+      {
+        return 1;
+      }
+    }
+  }
+
+  if (golden != NULL)
+  {
+    fclose(golden);
+  }
+  free(out);
+  free(sig.x);
+  return mismatch ? 2 : 0;
+}
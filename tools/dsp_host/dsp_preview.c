@@ -0,0 +1,121 @@
+/*
+ * Preview library around the unchanged app_dsp.c (see dsp_preview.h).
+ * - Only the block API: the app renders clips the way the audio ISR does,
+ *   at the default DMA half-block unless told otherwise.
+ * - The buffer grows on demand and is reused, so rendering A and B of the
+ *   same clip allocates once.
+ */
+
+#include "dsp_preview.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "app_dsp.h"
+
+/* APP_AUDIO_MAX_FRAMES_PER_HALF of the default firmware build. */
+#define DSP_PREVIEW_BLOCK 64u
+
+static AppStereoS24 *s_buf = NULL;
+static uint32_t s_buf_frames = 0;
+
+/* timespec_get() rather than clock_gettime(): the library also builds with
+ * MSVC for the Windows runner.
+ */
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  (void)timespec_get(&ts, TIME_UTC);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t dsp_preview_sample_rate(void)
+{
+  return APP_DSP_SAMPLE_RATE_HZ;
+}
+
+uint32_t dsp_preview_param_count(void)
+{
+  return (uint32_t)APP_DSP_PARAM_COUNT;
+}
+
+const char *dsp_preview_param_name(uint32_t id)
+{
+  AppDspParamDesc d;
+  if ((id >= (uint32_t)APP_DSP_PARAM_COUNT) || !AppDsp_GetParamDesc((AppDspParamId)id, &d))
+  {
+    return NULL;
+  }
+  return d.name;
+}
+
+void dsp_preview_reset(void)
+{
+  AppDsp_Init();
+}
+
+void dsp_preview_begin(void)
+{
+  AppDsp_BeginParams();
+}
+
+void dsp_preview_set_param(uint32_t id, int32_t value)
+{
+  if (id < (uint32_t)APP_DSP_PARAM_COUNT)
+  {
+    AppDsp_SetParam((AppDspParamId)id, value);
+  }
+}
+
+void dsp_preview_set_tap(uint32_t index, uint32_t time_q12, uint32_t pan_q15, int32_t gain_q15)
+{
+  AppDspDelayTap tap;
+  tap.time_q12 = (uint16_t)((time_q12 > 0xFFFFu) ? 0xFFFFu : time_q12);
+  tap.pan_q15 = (uint16_t)((pan_q15 > 0xFFFFu) ? 0xFFFFu : pan_q15);
+  tap.gain_q15 = gain_q15;
+  (void)AppDsp_SetDelayTap(index, &tap);
+}
+
+void dsp_preview_set_fx_mask(uint32_t mask)
+{
+  AppDsp_SetFxMask(mask);
+}
+
+void dsp_preview_commit(void)
+{
+  AppDsp_CommitParams();
+}
+
+int32_t *dsp_preview_buffer(uint32_t frames)
+{
+  if (frames > s_buf_frames)
+  {
+    AppStereoS24 *p = (AppStereoS24 *)realloc(s_buf, (size_t)frames * sizeof(AppStereoS24));
+    if (p == NULL)
+    {
+      return NULL;
+    }
+    s_buf = p;
+    s_buf_frames = frames;
+  }
+  return (int32_t *)s_buf;
+}
+
+uint64_t dsp_preview_process(uint32_t frames, uint32_t block)
+{
+  if (block == 0u)
+  {
+    block = DSP_PREVIEW_BLOCK;
+  }
+  if (frames > s_buf_frames)
+  {
+    frames = s_buf_frames;
+  }
+  const uint64_t t0 = now_ns();
+  for (uint32_t i = 0; i < frames; i += block)
+  {
+    const uint32_t n = ((frames - i) < block) ? (frames - i) : block;
+    AppDsp_ProcessBlock(&s_buf[i], n);
+  }
+  return now_ns() - t0;
+}
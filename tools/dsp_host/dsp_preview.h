@@ -0,0 +1,56 @@
+#ifndef DSP_PREVIEW_H
+#define DSP_PREVIEW_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The DSP chain of the firmware as a shared library, for the desktop app
+ * (dart:ffi, app/dsp_com/lib/preview/dsp_preview.dart): app_dsp.c and its
+ * modules built exactly as for dsp_host, driven through the block API.
+ *
+ * One engine per process (the firmware keeps its state in statics). The
+ * caller fills the buffer from dsp_preview_buffer() with interleaved s24
+ * L/R frames, sets a preset between begin and commit, and processes the
+ * buffer in place; a preset change lands at the next block boundary and
+ * glides like on the pedal, so reset first for a clean render.
+ */
+#if defined(_WIN32)
+#define DSP_PREVIEW_API __declspec(dllexport)
+#else
+#define DSP_PREVIEW_API __attribute__((visibility("default")))
+#endif
+
+DSP_PREVIEW_API uint32_t dsp_preview_sample_rate(void);
+
+/* AppDspParamId range and names (NULL past the end). */
+DSP_PREVIEW_API uint32_t dsp_preview_param_count(void);
+DSP_PREVIEW_API const char *dsp_preview_param_name(uint32_t id);
+
+/* Fresh AppDsp_Init(): default params, FX off, delay lines cleared. */
+DSP_PREVIEW_API void dsp_preview_reset(void);
+
+DSP_PREVIEW_API void dsp_preview_begin(void);
+DSP_PREVIEW_API void dsp_preview_set_param(uint32_t id, int32_t value);
+DSP_PREVIEW_API void dsp_preview_set_tap(uint32_t index, uint32_t time_q12, uint32_t pan_q15, int32_t gain_q15);
+DSP_PREVIEW_API void dsp_preview_set_fx_mask(uint32_t mask);
+DSP_PREVIEW_API void dsp_preview_commit(void);
+
+/* Buffer of at least 'frames' frames, kept until the next call; NULL if it
+ * cannot be allocated.
+ */
+DSP_PREVIEW_API int32_t *dsp_preview_buffer(uint32_t frames);
+
+/* Runs AppDsp_ProcessBlock() over the first 'frames' frames of the buffer
+ * in calls of 'block' frames (the firmware's DMA half-block if 0). Returns
+ * the nanoseconds spent in the DSP calls, as dsp_host reports them.
+ */
+DSP_PREVIEW_API uint64_t dsp_preview_process(uint32_t frames, uint32_t block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSP_PREVIEW_H */
@@ -0,0 +1,967 @@
+/*
+ * Offline renderer: every preset against every clip, on all cores.
+ * - Presets are the desktop app's library files: presets/<id>.pst (the
+ *   preset file of app_preset.h and the keys it was written with) or the
+ *   JSON export (fx_mask, params by name, taps); a directory argument takes
+ *   each *.pst and *.json in it except index.json. Params are matched by
+ *   name, so a file from another build renders too. The preset name is the
+ *   file stem.
+ * - Clips are mapped read-only before the workers start and decoded per
+ *   job, so every worker reads the same pages of the input.
+ * - app_dsp.c keeps the parameters, the delay line, the reverb tank and
+ *   the EQ once per process (an AppDspContext only holds the chain state),
+ *   so the workers are forked processes with one engine each. They take
+ *   (preset x clip) jobs off one atomic cursor in shared memory, the
+ *   longest clips first, so no worker is left with a long job at the end.
+ * - Per job: AppDsp_Init(), the preset as one batch, a context reset so the
+ *   ramps start at the preset instead of gliding to it, then the clip and
+ *   -T seconds of silence for the tails, in -n frame calls as on the
+ *   pedal. The report has one CSV row per job: peak and RMS over both
+ *   channels in dBFS, the CPU time of the DSP calls and the real-time
+ *   factor. Jobs whose worker died are reported as failed.
+ *
+ * Usage: dsp_render -p preset.pst|preset.json|dir ... -i clip.wav ... [-o outdir]
+ *                   [-c report.csv] [-j workers] [-n frames] [-T sec]
+ *                   [-x chain]
+ *   Without -o nothing but the report is written; without -c it goes to
+ *   stdout. Outputs are <outdir>/<preset>__<clip>.wav, 24-bit stereo.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "app_dsp.h"
+#include "app_preset.h"
+#include "host_wav.h"
+
+#define RENDER_BLOCK_DEFAULT 64u     /* APP_AUDIO_MAX_FRAMES_PER_HALF of the default build */
+#define RENDER_BLOCK_MAX     4096u
+#define RENDER_NAME_MAX      64u
+
+typedef struct
+{
+  char name[RENDER_NAME_MAX];
+  uint32_t fx_mask;
+  uint32_t param_count;
+  AppDspParamId param_id[APP_DSP_PARAM_COUNT];
+  int32_t param_value[APP_DSP_PARAM_COUNT];
+  uint32_t tap_count;
+  AppDspDelayTap tap[APP_DSP_DELAY_TAPS_MAX];
+} RenderPreset;
+
+typedef struct
+{
+  char name[RENDER_NAME_MAX];
+  HostWav wav;
+} RenderClip;
+
+typedef enum
+{
+  RENDER_PENDING = 0,
+  RENDER_DONE,
+  RENDER_WRITE_FAILED,
+} RenderState;
+
+/* One job's outcome, written by the worker that ran it. */
+typedef struct
+{
+  uint32_t state;
+  uint32_t frames;
+  int32_t peak;
+  double sum_sq;
+  uint64_t cpu_ns;
+} RenderResult;
+
+/* Shared with the workers (MAP_SHARED): the cursor, then the results. */
+typedef struct
+{
+  atomic_uint next;              /* next entry of the schedule to take */
+  RenderResult result[];
+} RenderShared;
+
+typedef struct
+{
+  const char *out_dir;
+  const char *report;
+  const char *chain;
+  uint32_t workers;
+  uint32_t block;
+  double tail_seconds;
+} RenderOptions;
+
+static RenderPreset *s_presets = NULL;
+static uint32_t s_preset_count = 0;
+static RenderClip *s_clips = NULL;
+static uint32_t s_clip_count = 0;
+
+/* File name without directory and extension, cut to RENDER_NAME_MAX. */
+static void path_stem(const char *path, char *out)
+{
+  const char *base = strrchr(path, '/');
+  base = (base != NULL) ? (base + 1) : path;
+  const char *dot = strrchr(base, '.');
+  size_t n = (dot != NULL) ? (size_t)(dot - base) : strlen(base);
+  if (n >= RENDER_NAME_MAX)
+  {
+    n = RENDER_NAME_MAX - 1u;
+  }
+  memcpy(out, base, n);
+  out[n] = 0;
+}
+
+/* ------------------------------ Preset files ----------------------------- */
+
+/* Just enough JSON for the library files: objects, arrays, strings without
+ * escapes beyond \" and \\, numbers; anything else is skipped as a value.
+ */
+typedef struct
+{
+  const char *p;
+  const char *end;
+} Json;
+
+static void js_ws(Json *j)
+{
+  while ((j->p < j->end) && ((*j->p == ' ') || (*j->p == '\t') || (*j->p == '\n') || (*j->p == '\r')))
+  {
+    j->p++;
+  }
+}
+
+static int js_peek(Json *j, char c)
+{
+  js_ws(j);
+  return (j->p < j->end) && (*j->p == c);
+}
+
+static int js_take(Json *j, char c)
+{
+  if (!js_peek(j, c))
+  {
+    return 0;
+  }
+  j->p++;
+  return 1;
+}
+
+static int js_string(Json *j, char *out, size_t n)
+{
+  if (!js_take(j, '"'))
+  {
+    return 0;
+  }
+  size_t k = 0;
+  while ((j->p < j->end) && (*j->p != '"'))
+  {
+    char c = *j->p++;
+    if ((c == '\\') && (j->p < j->end))
+    {
+      c = *j->p++;
+    }
+    if ((k + 1u) < n)
+    {
+      out[k++] = c;
+    }
+  }
+  if (n != 0u)
+  {
+    out[k] = 0;
+  }
+  return js_take(j, '"');
+}
+
+static int js_number(Json *j, double *v)
+{
+  js_ws(j);
+  char *e = NULL;
+  *v = strtod(j->p, &e);
+  if ((e == j->p) || (e > j->end))
+  {
+    return 0;
+  }
+  j->p = e;
+  return 1;
+}
+
+static int js_skip(Json *j, uint32_t depth)
+{
+  js_ws(j);
+  if ((j->p >= j->end) || (depth > 32u))
+  {
+    return 0;
+  }
+  const char c = *j->p;
+  if (c == '"')
+  {
+    return js_string(j, NULL, 0u);
+  }
+  if ((c == '{') || (c == '['))
+  {
+    const char close = (c == '{') ? '}' : ']';
+    j->p++;
+    if (js_take(j, close))
+    {
+      return 1;
+    }
+    do
+    {
+      if ((c == '{') && !(js_string(j, NULL, 0u) && js_take(j, ':')))
+      {
+        return 0;
+      }
+      if (!js_skip(j, depth + 1u))
+      {
+        return 0;
+      }
+    } while (js_take(j, ','));
+    return js_take(j, close);
+  }
+  /* Number, true, false, null. */
+  while ((j->p < j->end) && (strchr(",}] \t\r\n", *j->p) == NULL))
+  {
+    j->p++;
+  }
+  return 1;
+}
+
+static int preset_params(Json *j, RenderPreset *pr, const char *path)
+{
+  if (!js_take(j, '{'))
+  {
+    return 0;
+  }
+  if (js_take(j, '}'))
+  {
+    return 1;
+  }
+  do
+  {
+    char name[64];
+    double v;
+    if (!js_string(j, name, sizeof(name)) || !js_take(j, ':') || !js_number(j, &v))
+    {
+      return 0;
+    }
+    AppDspParamId id;
+    if (!AppDsp_FindParam(name, &id))
+    {
+      fprintf(stderr, "%s: unknown param '%s', skipped\n", path, name);
+    }
+    else if (pr->param_count < (uint32_t)APP_DSP_PARAM_COUNT)
+    {
+      pr->param_id[pr->param_count] = id;
+      pr->param_value[pr->param_count] = (int32_t)lrint(v);
+      pr->param_count++;
+    }
+  } while (js_take(j, ','));
+  return js_take(j, '}');
+}
+
+/* [[time_q12, pan_q15, gain_q15], ...] */
+static int preset_taps(Json *j, RenderPreset *pr)
+{
+  if (!js_take(j, '['))
+  {
+    return 0;
+  }
+  if (js_take(j, ']'))
+  {
+    return 1;
+  }
+  do
+  {
+    double v[3];
+    if (!js_take(j, '[') || !js_number(j, &v[0]) || !js_take(j, ',') || !js_number(j, &v[1]) ||
+        !js_take(j, ',') || !js_number(j, &v[2]) || !js_take(j, ']'))
+    {
+      return 0;
+    }
+    if (pr->tap_count < APP_DSP_DELAY_TAPS_MAX)
+    {
+      AppDspDelayTap *t = &pr->tap[pr->tap_count++];
+      t->time_q12 = (uint16_t)((v[0] < 0.0) ? 0.0 : ((v[0] > 65535.0) ? 65535.0 : v[0]));
+      t->pan_q15 = (uint16_t)((v[1] < 0.0) ? 0.0 : ((v[1] > 65535.0) ? 65535.0 : v[1]));
+      t->gain_q15 = (int32_t)lrint(v[2]);
+    }
+  } while (js_take(j, ','));
+  return js_take(j, ']');
+}
+
+static uint32_t rd_u16(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t rd_u32(const uint8_t *p)
+{
+  return rd_u16(p) | (rd_u16(p + 2) << 16);
+}
+
+static uint32_t pst_crc32(const uint8_t *p, size_t n)
+{
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < n; i++)
+  {
+    crc ^= p[i];
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+/* A .pst file: the record, then "PK" <count u16> and per key <name length
+ * u8> <name> <min s32> <max s32>, then the keys' CRC-32 (the app's
+ * PresetFile). The params section holds the wide keys (range over 65536
+ * values, s32) and then the others (u16 above min), each in key order.
+ */
+static int preset_load_pst(const uint8_t *b, size_t size, RenderPreset *pr, const char *path)
+{
+  size_t o = 8u;
+  if ((size < 12u) || (rd_u16(b) != APP_PRESET_FILE_MAGIC) || (b[2] != APP_PRESET_FILE_VERSION))
+  {
+    return 0;
+  }
+  for (uint32_t s = 0; s < b[3]; s++)
+  {
+    if (o + 4u > size)
+    {
+      return 0;
+    }
+    o += 4u + rd_u16(&b[o + 2u]);
+  }
+  if ((o + 4u + 4u > size) || (pst_crc32(b, o) != rd_u32(&b[o])))
+  {
+    return 0;
+  }
+  const size_t rec_end = o;
+  o += 4u;
+  const size_t keys_ofs = o;
+  if (rd_u16(&b[o]) != 0x4B50u)
+  {
+    return 0;
+  }
+  const uint32_t count = rd_u16(&b[o + 2u]);
+
+  /* Keys: name offset, width; walk once to find the wide ones first. */
+  size_t *name_ofs = (size_t *)calloc(count + 1u, sizeof(size_t));
+  if (name_ofs == NULL)
+  {
+    return 0;
+  }
+  o += 4u;
+  for (uint32_t k = 0; k < count; k++)
+  {
+    if ((o >= size) || (o + 1u + b[o] + 8u > size))
+    {
+      free(name_ofs);
+      return 0;
+    }
+    name_ofs[k] = o;
+    o += 1u + b[o] + 8u;
+  }
+  if ((o + 4u != size) || (pst_crc32(&b[keys_ofs], o - keys_ofs) != rd_u32(&b[o])))
+  {
+    free(name_ofs);
+    return 0;
+  }
+
+  o = 8u;
+  for (uint32_t s = 0; s < b[3]; s++)
+  {
+    const uint32_t type = b[o];
+    const uint32_t info = b[o + 1u];
+    const size_t bytes = rd_u16(&b[o + 2u]);
+    const uint8_t *p = &b[o + 4u];
+    o += 4u + bytes;
+    if (o > rec_end)
+    {
+      break;
+    }
+    if ((type == 1u) && (bytes >= 4u))
+    {
+      pr->fx_mask = rd_u32(p);
+    }
+    else if (type == 2u)
+    {
+      /* Wide keys first, then narrow: two passes over the keys. */
+      size_t at = 0;
+      for (uint32_t pass = 0; pass < 2u; pass++)
+      {
+        for (uint32_t k = 0; k < count; k++)
+        {
+          const uint8_t *key = &b[name_ofs[k]];
+          const int32_t kmin = (int32_t)rd_u32(key + 1u + key[0]);
+          const int32_t kmax = (int32_t)rd_u32(key + 5u + key[0]);
+          const uint32_t wide = (((int64_t)kmax - kmin) > 65535) ? 1u : 0u;
+          if (wide != (pass == 0u))
+          {
+            continue;
+          }
+          const size_t w = wide ? 4u : 2u;
+          if (at + w > bytes)
+          {
+            break;
+          }
+          const int32_t v = wide ? (int32_t)rd_u32(&p[at]) : (kmin + (int32_t)rd_u16(&p[at]));
+          at += w;
+          char name[64];
+          const size_t n = (key[0] < sizeof(name)) ? key[0] : (sizeof(name) - 1u);
+          memcpy(name, key + 1u, n);
+          name[n] = 0;
+          AppDspParamId id;
+          if (!AppDsp_FindParam(name, &id))
+          {
+            fprintf(stderr, "%s: unknown param '%s', skipped\n", path, name);
+          }
+          else if (pr->param_count < (uint32_t)APP_DSP_PARAM_COUNT)
+          {
+            pr->param_id[pr->param_count] = id;
+            pr->param_value[pr->param_count] = v;
+            pr->param_count++;
+          }
+        }
+      }
+    }
+    else if (type == 3u)
+    {
+      for (uint32_t t = 0; (t < info) && ((8u * t) + 8u <= bytes) && (pr->tap_count < APP_DSP_DELAY_TAPS_MAX); t++)
+      {
+        AppDspDelayTap *tap = &pr->tap[pr->tap_count++];
+        tap->time_q12 = (uint16_t)rd_u16(&p[8u * t]);
+        tap->pan_q15 = (uint16_t)rd_u16(&p[(8u * t) + 2u]);
+        tap->gain_q15 = (int32_t)rd_u32(&p[(8u * t) + 4u]);
+      }
+    }
+  }
+  free(name_ofs);
+  return 1;
+}
+
+static int preset_load(const char *path, RenderPreset *pr)
+{
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *buf = (size > 0) ? (char *)malloc((size_t)size + 1u) : NULL;
+  if ((buf == NULL) || (fread(buf, 1, (size_t)size, f) != (size_t)size))
+  {
+    fprintf(stderr, "%s: cannot read\n", path);
+    fclose(f);
+    free(buf);
+    return 0;
+  }
+  fclose(f);
+  buf[size] = 0;
+
+  memset(pr, 0, sizeof(*pr));
+  path_stem(path, pr->name);
+  const size_t len = strlen(path);
+  if ((len > 4u) && (strcmp(path + len - 4u, ".pst") == 0))
+  {
+    const int ok = preset_load_pst((const uint8_t *)buf, (size_t)size, pr, path);
+    free(buf);
+    if (!ok)
+    {
+      fprintf(stderr, "%s: not a preset file\n", path);
+    }
+    return ok;
+  }
+  Json j = {buf, buf + size};
+  int ok = js_take(&j, '{');
+  if (ok && !js_take(&j, '}'))
+  {
+    do
+    {
+      char key[32];
+      double v;
+      if (!js_string(&j, key, sizeof(key)) || !js_take(&j, ':'))
+      {
+        ok = 0;
+      }
+      else if (strcmp(key, "fx_mask") == 0)
+      {
+        ok = js_number(&j, &v);
+        pr->fx_mask = (uint32_t)v;
+      }
+      else if (strcmp(key, "params") == 0)
+      {
+        ok = preset_params(&j, pr, path);
+      }
+      else if (strcmp(key, "taps") == 0)
+      {
+        ok = preset_taps(&j, pr);
+      }
+      else
+      {
+        ok = js_skip(&j, 0u);
+      }
+    } while (ok && js_take(&j, ','));
+    ok = ok && js_take(&j, '}');
+  }
+  free(buf);
+  if (!ok)
+  {
+    fprintf(stderr, "%s: not a preset file\n", path);
+  }
+  return ok;
+}
+
+static int preset_add(const char *path)
+{
+  RenderPreset *p = (RenderPreset *)realloc(s_presets, (s_preset_count + 1u) * sizeof(RenderPreset));
+  if (p == NULL)
+  {
+    return 0;
+  }
+  s_presets = p;
+  if (!preset_load(path, &s_presets[s_preset_count]))
+  {
+    return 0;
+  }
+  s_preset_count++;
+  return 1;
+}
+
+static int cmp_str(const void *a, const void *b)
+{
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* A file, or every *.pst and *.json of a library directory in name order. */
+static int presets_add(const char *path)
+{
+  struct stat st;
+  if (stat(path, &st) != 0)
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  if (!S_ISDIR(st.st_mode))
+  {
+    return preset_add(path);
+  }
+  DIR *d = opendir(path);
+  if (d == NULL)
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  char **names = NULL;
+  uint32_t n = 0;
+  const struct dirent *e;
+  while ((e = readdir(d)) != NULL)
+  {
+    const size_t len = strlen(e->d_name);
+    const int pst = (len > 4u) && (strcmp(e->d_name + len - 4u, ".pst") == 0);
+    if (pst || ((len > 5u) && (strcmp(e->d_name + len - 5u, ".json") == 0) && (strcmp(e->d_name, "index.json") != 0)))
+    {
+      char **p = (char **)realloc(names, (n + 1u) * sizeof(char *));
+      if (p == NULL)
+      {
+        break;
+      }
+      names = p;
+      names[n] = (char *)malloc(strlen(path) + len + 2u);
+      sprintf(names[n], "%s/%s", path, e->d_name);
+      n++;
+    }
+  }
+  closedir(d);
+  qsort(names, n, sizeof(char *), cmp_str);
+  int ok = 1;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    ok = ok && preset_add(names[i]);
+    free(names[i]);
+  }
+  free(names);
+  if (n == 0u)
+  {
+    fprintf(stderr, "%s: no presets\n", path);
+  }
+  return ok;
+}
+
+/* -------------------------------- Clips ---------------------------------- */
+
+/* Mapped for the lifetime of the process; the workers inherit the mapping. */
+static int clip_add(const char *path)
+{
+  const int fd = open(path, O_RDONLY);
+  struct stat st;
+  if ((fd < 0) || (fstat(fd, &st) != 0))
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    return 0;
+  }
+  void *map = (st.st_size > 0) ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    fprintf(stderr, "%s: cannot map\n", path);
+    return 0;
+  }
+  RenderClip *c = (RenderClip *)realloc(s_clips, (s_clip_count + 1u) * sizeof(RenderClip));
+  if (c == NULL)
+  {
+    return 0;
+  }
+  s_clips = c;
+  c = &s_clips[s_clip_count];
+  if (!host_wav_parse(path, (const uint8_t *)map, (size_t)st.st_size, &c->wav))
+  {
+    munmap(map, (size_t)st.st_size);
+    return 0;
+  }
+  path_stem(path, c->name);
+  s_clip_count++;
+  return 1;
+}
+
+/* --------------------------------- Jobs ---------------------------------- */
+
+static uint64_t cpu_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t wall_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static int dsp_chain(const char *chain)
+{
+  return (chain == NULL) || AppDsp_SetChain(chain);
+}
+
+static void preset_apply(const RenderOptions *o, const RenderPreset *pr)
+{
+  AppDsp_Init();
+  AppDsp_BeginParams();
+  for (uint32_t i = 0; i < pr->param_count; i++)
+  {
+    AppDsp_SetParam(pr->param_id[i], pr->param_value[i]);
+  }
+  for (uint32_t i = 0; i < pr->tap_count; i++)
+  {
+    (void)AppDsp_SetDelayTap(i, &pr->tap[i]);
+  }
+  AppDsp_SetFxMask((AppFxMask)pr->fx_mask);
+  (void)dsp_chain(o->chain);
+  AppDsp_CommitParams();
+  AppDsp_ContextReset(AppDsp_DefaultContext());
+}
+
+/* Job j is preset j / clips against clip j % clips. buf holds at least the
+ * clip and its tail.
+ */
+static void job_run(const RenderOptions *o, uint32_t job, AppStereoS24 *buf, RenderResult *r)
+{
+  const RenderPreset *pr = &s_presets[job / s_clip_count];
+  const RenderClip *cl = &s_clips[job % s_clip_count];
+  const uint32_t frames = cl->wav.frames + (uint32_t)(o->tail_seconds * APP_DSP_SAMPLE_RATE_HZ);
+
+  memset(buf, 0, frames * sizeof(AppStereoS24));
+  host_wav_decode(&cl->wav, buf);
+  preset_apply(o, pr);
+
+  const uint64_t t0 = cpu_ns();
+  for (uint32_t i = 0; i < frames; i += o->block)
+  {
+    const uint32_t n = ((frames - i) < o->block) ? (frames - i) : o->block;
+    AppDsp_ProcessBlock(&buf[i], n);
+  }
+  r->cpu_ns = cpu_ns() - t0;
+
+  int32_t peak = 0;
+  double sum_sq = 0.0;
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    const int32_t s[2] = {buf[i].l, buf[i].r};
+    for (uint32_t c = 0; c < 2u; c++)
+    {
+      const int32_t a = (s[c] < 0) ? -s[c] : s[c];
+      peak = (a > peak) ? a : peak;
+      sum_sq += (double)s[c] * (double)s[c];
+    }
+  }
+  r->frames = frames;
+  r->peak = peak;
+  r->sum_sq = sum_sq;
+
+  r->state = RENDER_DONE;
+  if (o->out_dir != NULL)
+  {
+    char path[1024];
+    (void)snprintf(path, sizeof(path), "%s/%s__%s.wav", o->out_dir, pr->name, cl->name);
+    if (!host_wav_write(path, buf, frames))
+    {
+      r->state = RENDER_WRITE_FAILED;
+    }
+  }
+}
+
+static void worker(const RenderOptions *o, RenderShared *sh, const uint32_t *order, uint32_t jobs)
+{
+  uint32_t cap = 0;
+  for (uint32_t i = 0; i < s_clip_count; i++)
+  {
+    cap = (s_clips[i].wav.frames > cap) ? s_clips[i].wav.frames : cap;
+  }
+  cap += (uint32_t)(o->tail_seconds * APP_DSP_SAMPLE_RATE_HZ);
+  AppStereoS24 *buf = (AppStereoS24 *)malloc((size_t)(cap ? cap : 1u) * sizeof(AppStereoS24));
+  if (buf == NULL)
+  {
+    return;
+  }
+  for (;;)
+  {
+    const uint32_t k = atomic_fetch_add(&sh->next, 1u);
+    if (k >= jobs)
+    {
+      break;
+    }
+    job_run(o, order[k], buf, &sh->result[order[k]]);
+  }
+  free(buf);
+}
+
+/* Schedule: longest clip first; ties keep preset order. */
+static int cmp_job(const void *a, const void *b)
+{
+  const uint32_t ja = *(const uint32_t *)a;
+  const uint32_t jb = *(const uint32_t *)b;
+  const uint32_t fa = s_clips[ja % s_clip_count].wav.frames;
+  const uint32_t fb = s_clips[jb % s_clip_count].wav.frames;
+  if (fa != fb)
+  {
+    return (fa > fb) ? -1 : 1;
+  }
+  return (ja > jb) - (ja < jb);
+}
+
+/* ------------------------------- Report ---------------------------------- */
+
+static double level_db(double v)
+{
+  return (v > 0.0) ? (20.0 * log10(v / 8388608.0)) : -200.0;
+}
+
+/* Quoted if it holds a comma or a quote. */
+static void csv_field(FILE *f, const char *s)
+{
+  if (strpbrk(s, ",\"") == NULL)
+  {
+    fputs(s, f);
+    return;
+  }
+  fputc('"', f);
+  for (; *s != 0; s++)
+  {
+    if (*s == '"')
+    {
+      fputc('"', f);
+    }
+    fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+static uint32_t report_write(FILE *f, const RenderResult *res)
+{
+  static const char *const k_state[] = {"failed", "ok", "write_failed"};
+  uint32_t failed = 0;
+  fprintf(f, "preset,clip,frames,peak_dbfs,rms_dbfs,cpu_ms,x_realtime,status\n");
+  for (uint32_t job = 0; job < (s_preset_count * s_clip_count); job++)
+  {
+    const RenderResult *r = &res[job];
+    csv_field(f, s_presets[job / s_clip_count].name);
+    fputc(',', f);
+    csv_field(f, s_clips[job % s_clip_count].name);
+    if (r->state == RENDER_DONE || r->state == RENDER_WRITE_FAILED)
+    {
+      const double cpu_s = (double)r->cpu_ns * 1e-9;
+      const double audio_s = (double)r->frames / APP_DSP_SAMPLE_RATE_HZ;
+      fprintf(f, ",%lu,%.2f,%.2f,%.3f,%.1f,%s\n", (unsigned long)r->frames, level_db((double)r->peak),
+              level_db(sqrt(r->sum_sq / (2.0 * (double)r->frames))), cpu_s * 1e3,
+              (cpu_s > 0.0) ? (audio_s / cpu_s) : 0.0, k_state[r->state]);
+    }
+    else
+    {
+      fprintf(f, ",,,,,,%s\n", k_state[RENDER_PENDING]);
+    }
+    failed += (r->state != RENDER_DONE) ? 1u : 0u;
+  }
+  return failed;
+}
+
+/* --------------------------------- Main ---------------------------------- */
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: dsp_render -p preset.pst|preset.json|dir ... -i clip.wav ... [-o outdir]\n"
+          "                  [-c report.csv] [-j workers] [-n frames] [-T sec]\n"
+          "                  [-x chain]\n");
+}
+
+int main(int argc, char **argv)
+{
+  RenderOptions o;
+  memset(&o, 0, sizeof(o));
+  o.block = RENDER_BLOCK_DEFAULT;
+  o.tail_seconds = 2.0;
+  const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  o.workers = (cores > 0) ? (uint32_t)cores : 1u;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *a = argv[i];
+    const char *v = ((i + 1) < argc) ? argv[i + 1] : NULL;
+    if ((a[0] != '-') || (a[1] == 0) || (a[2] != 0) || (v == NULL))
+    {
+      usage();
+      return 1;
+    }
+    i++;
+    int ok = 1;
+    switch (a[1])
+    {
+      case 'p': ok = presets_add(v); break;
+      case 'i': ok = clip_add(v); break;
+      case 'o': o.out_dir = v; break;
+      case 'c': o.report = v; break;
+      case 'j': o.workers = (uint32_t)strtoul(v, NULL, 0); break;
+      case 'n': o.block = (uint32_t)strtoul(v, NULL, 0); break;
+      case 'T': o.tail_seconds = atof(v); break;
+      case 'x': o.chain = v; break;
+      default: usage(); return 1;
+    }
+    if (!ok)
+    {
+      return 1;
+    }
+  }
+  if ((s_preset_count == 0u) || (s_clip_count == 0u) || (o.workers == 0u) || (o.block == 0u) ||
+      (o.block > RENDER_BLOCK_MAX) || (o.tail_seconds < 0.0))
+  {
+    usage();
+    return 1;
+  }
+  AppDsp_Init();
+  AppDsp_BeginParams();
+  const int chain_ok = dsp_chain(o.chain);
+  AppDsp_CommitParams();
+  if (!chain_ok)
+  {
+    fprintf(stderr, "bad chain '%s'\n", o.chain);
+    return 1;
+  }
+  if ((o.out_dir != NULL) && (mkdir(o.out_dir, 0777) != 0) && (errno != EEXIST))
+  {
+    fprintf(stderr, "%s: %s\n", o.out_dir, strerror(errno));
+    return 1;
+  }
+
+  const uint32_t jobs = s_preset_count * s_clip_count;
+  uint32_t *order = (uint32_t *)malloc(jobs * sizeof(uint32_t));
+  const size_t shared_bytes = sizeof(RenderShared) + (jobs * sizeof(RenderResult));
+  RenderShared *sh = (RenderShared *)mmap(NULL, shared_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if ((order == NULL) || (sh == MAP_FAILED))
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (uint32_t j = 0; j < jobs; j++)
+  {
+    order[j] = j;
+  }
+  qsort(order, jobs, sizeof(uint32_t), cmp_job);
+  atomic_init(&sh->next, 0u);
+
+  /* stdout is flushed first, or every worker would repeat what it holds. */
+  fflush(NULL);
+  const uint32_t workers = (o.workers < jobs) ? o.workers : jobs;
+  const uint64_t t0 = wall_ns();
+  uint32_t started = 0;
+  for (; started < workers; started++)
+  {
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+      worker(&o, sh, order, jobs);
+      _exit(0);
+    }
+    if (pid < 0)
+    {
+      fprintf(stderr, "fork: %s\n", strerror(errno));
+      break;
+    }
+  }
+  if (started == 0u)
+  {
+    worker(&o, sh, order, jobs);
+  }
+  uint32_t crashed = 0;
+  int status;
+  while (wait(&status) > 0)
+  {
+    crashed += (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) ? 1u : 0u;
+  }
+  const double wall_s = (double)(wall_ns() - t0) * 1e-9;
+
+  FILE *f = stdout;
+  if ((o.report != NULL) && ((f = fopen(o.report, "w")) == NULL))
+  {
+    fprintf(stderr, "%s: %s\n", o.report, strerror(errno));
+    return 1;
+  }
+  const uint32_t failed = report_write(f, sh->result);
+  if (f != stdout)
+  {
+    fclose(f);
+  }
+
+  uint64_t cpu = 0;
+  for (uint32_t j = 0; j < jobs; j++)
+  {
+    cpu += sh->result[j].cpu_ns;
+  }
+  fprintf(stderr, "%lu presets x %lu clips: %lu jobs on %lu workers, %.2f s wall, %.2f s DSP CPU, %lu failed\n",
+          (unsigned long)s_preset_count, (unsigned long)s_clip_count, (unsigned long)jobs,
+          (unsigned long)(started ? started : 1u), wall_s, (double)cpu * 1e-9, (unsigned long)failed);
+  if (crashed != 0u)
+  {
+    fprintf(stderr, "%lu workers died\n", (unsigned long)crashed);
+  }
+  return (failed != 0u) ? 2 : 0;
+}
@@ -0,0 +1,517 @@
+/*
+ * Field firmware update over the pedal's COM UART (app_update.h).
+ * - The image is the raw .bin the MDK build leaves (fromelf --bin), written
+ *   from the start of flash; it must stay below the cab IR pages (max= in
+ *   the OK UPDATE reply).
+ * - It goes as LZ4 blocks of at most one frame each. The blocks are
+ *   dependent: a match may copy from anywhere in the 64 KB before it, since
+ *   the pedal reads what it decoded back from flash, so the compression is
+ *   that of one stream. Greedy, one hash probe per position: the link, not
+ *   the ratio, is the limit.
+ * - With -b the link is first switched to a faster rate (COM BAUD, then
+ *   PING at the new one); the updater keeps whatever rate it was entered at.
+ * - The pedal's 'R' follows its last text line and nothing follows it until
+ *   the first frame, which tells it from an 'R' inside a line.
+ * - A damaged or lost frame is sent again (a lost ack resends a D frame the
+ *   pedal acks again without decoding it); 'S' and 'C' start over from B.
+ *
+ * Usage: fw_update -d /dev/ttyACM0 [-r rate] [-b rate] image.bin
+ *   -r the rate the link runs at now (115200), -b the rate to update at.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UPD_FRAME_MAX_DEFAULT 1024u
+#define UPD_WINDOW            65535u
+#define UPD_MIN_MATCH         4u
+#define UPD_HASH_BITS         16u
+#define UPD_RETRIES           10u
+#define UPD_RESTARTS          3u
+#define UPD_ACK_MS            2000
+#define UPD_LINE_MS           2000
+#define UPD_LINE_MAX          256u
+
+static int s_fd = -1;
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= p[i];
+    for (uint32_t b = 0; b < 8u; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return crc;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+/* ---- LZ4 blocks ---- */
+
+typedef struct
+{
+  const uint8_t *img;
+  size_t size;
+  int32_t *head;             /* last position per hash, -1 = none */
+} Lz;
+
+static uint32_t lz_hash(const uint8_t *p)
+{
+  const uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  return (v * 2654435761u) >> (32u - UPD_HASH_BITS);
+}
+
+static size_t lz_len(uint8_t *out, size_t o, size_t n)
+{
+  while (n >= 255u)
+  {
+    out[o++] = 255u;
+    n -= 255u;
+  }
+  out[o++] = (uint8_t)n;
+  return o;
+}
+
+/* Literals lit..pos and then a match (mlen 0: none, the block's end). */
+static size_t lz_seq(const Lz *lz, uint8_t *out, size_t o, size_t lit, size_t pos, size_t off, size_t mlen)
+{
+  const size_t run = pos - lit;
+  const size_t ml = (mlen != 0u) ? (mlen - UPD_MIN_MATCH) : 0u;
+  out[o++] = (uint8_t)(((run < 15u) ? run : 15u) << 4 | ((ml < 15u) ? ml : 15u));
+  if (run >= 15u)
+  {
+    o = lz_len(out, o, run - 15u);
+  }
+  memcpy(&out[o], &lz->img[lit], run);
+  o += run;
+  if (mlen != 0u)
+  {
+    out[o++] = (uint8_t)off;
+    out[o++] = (uint8_t)(off >> 8);
+    if (ml >= 15u)
+    {
+      o = lz_len(out, o, ml - 15u);
+    }
+  }
+  return o;
+}
+
+/* Compresses img[start..start+raw) into out, matches reaching back into
+ * the bytes before start. Returns the block size; out holds room for the
+ * worst case (raw + raw / 255 + 16).
+ */
+static size_t lz_block(Lz *lz, size_t start, size_t raw, uint8_t *out)
+{
+  const size_t end = start + raw;
+  size_t o = 0;
+  size_t lit = start;
+  size_t pos = start;
+  while (pos + UPD_MIN_MATCH <= end)
+  {
+    const uint32_t h = lz_hash(&lz->img[pos]);
+    const int32_t cand = lz->head[h];
+    lz->head[h] = (int32_t)pos;
+    if ((cand < 0) || ((size_t)cand >= pos) || ((pos - (size_t)cand) > UPD_WINDOW) ||
+        (memcmp(&lz->img[cand], &lz->img[pos], UPD_MIN_MATCH) != 0))
+    {
+      pos++;
+      continue;
+    }
+    size_t mlen = UPD_MIN_MATCH;
+    while ((pos + mlen < end) && (lz->img[(size_t)cand + mlen] == lz->img[pos + mlen]))
+    {
+      mlen++;
+    }
+    o = lz_seq(lz, out, o, lit, pos, pos - (size_t)cand, mlen);
+    for (size_t i = pos + 1u; (i < pos + mlen) && (i + UPD_MIN_MATCH <= lz->size); i++)
+    {
+      lz->head[lz_hash(&lz->img[i])] = (int32_t)i;
+    }
+    pos += mlen;
+    lit = pos;
+  }
+  return lz_seq(lz, out, o, lit, end, 0u, 0u);
+}
+
+/* ---- serial link ---- */
+
+static speed_t tty_speed(uint32_t rate)
+{
+  switch (rate)
+  {
+  case 115200u: return B115200;
+  case 230400u: return B230400;
+  case 460800u: return B460800;
+  case 921600u: return B921600;
+  case 1000000u: return B1000000;
+  case 2000000u: return B2000000;
+  default: return 0;
+  }
+}
+
+static int tty_rate(uint32_t rate)
+{
+  struct termios t;
+  const speed_t sp = tty_speed(rate);
+  if ((sp == 0) || (tcgetattr(s_fd, &t) != 0))
+  {
+    return -1;
+  }
+  cfmakeraw(&t);
+  t.c_cflag |= CLOCAL | CREAD;
+  t.c_cflag &= ~(CRTSCTS | CSTOPB);
+  t.c_cc[VMIN] = 0;
+  t.c_cc[VTIME] = 0;
+  cfsetispeed(&t, sp);
+  cfsetospeed(&t, sp);
+  return tcsetattr(s_fd, TCSANOW, &t);
+}
+
+static int tty_write(const void *p, size_t n)
+{
+  const uint8_t *b = p;
+  while (n > 0u)
+  {
+    const ssize_t w = write(s_fd, b, n);
+    if (w < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return -1;
+    }
+    b += w;
+    n -= (size_t)w;
+  }
+  return 0;
+}
+
+/* A byte, or -1 after ms of silence. */
+static int tty_byte(int ms)
+{
+  struct pollfd p = {s_fd, POLLIN, 0};
+  if (poll(&p, 1, ms) <= 0)
+  {
+    return -1;
+  }
+  uint8_t b;
+  return (read(s_fd, &b, 1) == 1) ? b : -1;
+}
+
+/* The next line starting with one of the prefixes; its index, or -1. */
+static int tty_line(const char *a, const char *b, char *line)
+{
+  size_t n = 0;
+  for (;;)
+  {
+    const int c = tty_byte(UPD_LINE_MS);
+    if (c < 0)
+    {
+      return -1;
+    }
+    if (c == '\r')
+    {
+      continue;
+    }
+    if (c != '\n')
+    {
+      if (n + 1u < UPD_LINE_MAX)
+      {
+        line[n++] = (char)c;
+      }
+      continue;
+    }
+    line[n] = '\0';
+    n = 0;
+    if (strncmp(line, a, strlen(a)) == 0)
+    {
+      return 0;
+    }
+    if ((b != NULL) && (strncmp(line, b, strlen(b)) == 0))
+    {
+      return 1;
+    }
+  }
+}
+
+static int tty_cmd(const char *cmd, const char *ok, const char *err, char *line)
+{
+  if ((tty_write(cmd, strlen(cmd)) != 0) || (tty_write("\n", 1) != 0))
+  {
+    return -1;
+  }
+  return tty_line(ok, err, line);
+}
+
+/* The updater's 'R': after a newline (or first) and then silence. */
+static int wait_ready(void)
+{
+  int prev = '\n';
+  for (;;)
+  {
+    const int c = tty_byte(UPD_LINE_MS);
+    if (c < 0)
+    {
+      return -1;
+    }
+    if ((c == 'R') && (prev == '\n'))
+    {
+      const int next = tty_byte(100);
+      if (next < 0)
+      {
+        return 0;
+      }
+      prev = next;
+      continue;
+    }
+    prev = c;
+  }
+}
+
+/* Sends one frame until the pedal takes it; returns its reply ('K', 'S',
+ * 'C', 'D') or -1 when it gave no usable one UPD_RETRIES times.
+ */
+static int send_frame(uint8_t type, const uint8_t *payload, size_t len)
+{
+  uint8_t f[1u + 3u + UPD_FRAME_MAX_DEFAULT + 4u];
+  f[0] = 'U';
+  f[1] = type;
+  f[2] = (uint8_t)len;
+  f[3] = (uint8_t)(len >> 8);
+  if (len != 0u)
+  {
+    memcpy(&f[4], payload, len);
+  }
+  put32(&f[4 + len], ~crc32_update(0xFFFFFFFFu, &f[1], 3u + len));
+  for (uint32_t t = 0; t < UPD_RETRIES; t++)
+  {
+    if (tty_write(f, 8u + len) != 0)
+    {
+      return -1;
+    }
+    const int r = tty_byte(UPD_ACK_MS);
+    if ((r == 'K') || (r == 'S') || (r == 'C') || (r == 'D'))
+    {
+      return r;
+    }
+    /* 'E', silence or noise: again. */
+    (void)tcdrain(s_fd);
+    usleep(20000);
+    (void)tcflush(s_fd, TCIFLUSH);
+  }
+  return -1;
+}
+
+static double now_s(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* One pass from B to E: 0 done, 1 start over, -1 give up. */
+static int update_pass(const uint8_t *img, size_t size, uint32_t crc, size_t frame_max, size_t *sent)
+{
+  uint8_t b[8];
+  put32(b, (uint32_t)size);
+  put32(b + 4, crc);
+  int r = send_frame('B', b, sizeof(b));
+  if (r != 'K')
+  {
+    return (r == 'S') ? -1 : 1;
+  }
+
+  int32_t *head = malloc(sizeof(int32_t) << UPD_HASH_BITS);
+  uint8_t *out = malloc(1u + (frame_max * 32u) + (frame_max * 32u) / 255u + 16u);
+  if ((head == NULL) || (out == NULL))
+  {
+    free(head);
+    free(out);
+    return -1;
+  }
+  for (size_t i = 0; i < ((size_t)1 << UPD_HASH_BITS); i++)
+  {
+    head[i] = -1;
+  }
+  Lz lz = {img, size, head};
+
+  size_t pos = 0;
+  uint8_t seq = 0;
+  size_t raw = frame_max * 8u;
+  *sent = 0;
+  r = 'K';
+  while ((pos < size) && (r == 'K'))
+  {
+    /* The most raw bytes whose block fits one frame: halve until it does,
+     * and grow again after a fit.
+     */
+    size_t n;
+    size_t blen;
+    for (;;)
+    {
+      n = (raw < size - pos) ? raw : (size - pos);
+      blen = lz_block(&lz, pos, n, out + 1);
+      if ((blen + 1u <= frame_max) || (n == 1u))
+      {
+        break;
+      }
+      raw = (n / 2u) ? (n / 2u) : 1u;
+    }
+    out[0] = seq;
+    r = send_frame('D', out, blen + 1u);
+    pos += n;
+    seq++;
+    *sent += blen + 9u;
+    raw += raw / 4u + 1u;
+    if (raw > frame_max * 32u)
+    {
+      raw = frame_max * 32u;
+    }
+    fprintf(stderr, "\r%zu / %zu bytes", pos, size);
+  }
+  fprintf(stderr, "\n");
+  free(head);
+  free(out);
+  if (r != 'K')
+  {
+    return (r == 'S') ? 1 : -1;
+  }
+
+  r = send_frame('E', NULL, 0);
+  if (r == 'D')
+  {
+    return 0;
+  }
+  if (r == 'C')
+  {
+    fprintf(stderr, "image CRC mismatch on the pedal\n");
+  }
+  return (r < 0) ? -1 : 1;
+}
+
+int main(int argc, char **argv)
+{
+  const char *dev = NULL;
+  uint32_t rate = 115200u;
+  uint32_t fast = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:r:b:h")) != -1)
+  {
+    switch (opt)
+    {
+    case 'd': dev = optarg; break;
+    case 'r': rate = (uint32_t)strtoul(optarg, NULL, 10); break;
+    case 'b': fast = (uint32_t)strtoul(optarg, NULL, 10); break;
+    default:
+      fprintf(stderr, "usage: %s -d device [-r rate] [-b rate] image.bin\n", argv[0]);
+      return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((dev == NULL) || (optind + 1 != argc))
+  {
+    fprintf(stderr, "usage: %s -d device [-r rate] [-b rate] image.bin\n", argv[0]);
+    return 2;
+  }
+
+  FILE *f = fopen(argv[optind], "rb");
+  if (f == NULL)
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+  (void)fseek(f, 0, SEEK_END);
+  const long flen = ftell(f);
+  (void)fseek(f, 0, SEEK_SET);
+  uint8_t *img = (flen > 0) ? malloc((size_t)flen) : NULL;
+  if ((img == NULL) || (fread(img, 1, (size_t)flen, f) != (size_t)flen))
+  {
+    fprintf(stderr, "%s: cannot read\n", argv[optind]);
+    fclose(f);
+    return 1;
+  }
+  fclose(f);
+  const size_t size = (size_t)flen;
+  const uint32_t crc = ~crc32_update(0xFFFFFFFFu, img, size);
+
+  s_fd = open(dev, O_RDWR | O_NOCTTY);
+  if ((s_fd < 0) || (tty_rate(rate) != 0))
+  {
+    fprintf(stderr, "%s: cannot open at %u\n", dev, (unsigned)rate);
+    return 1;
+  }
+  (void)tcflush(s_fd, TCIOFLUSH);
+
+  char line[UPD_LINE_MAX];
+  char cmd[48];
+  if ((fast != 0u) && (fast != rate))
+  {
+    (void)snprintf(cmd, sizeof(cmd), "BAUD %u", (unsigned)fast);
+    if ((tty_cmd(cmd, "OK BAUD", "ERR BAUD", line) != 0) || (tcdrain(s_fd) != 0) || (tty_rate(fast) != 0))
+    {
+      fprintf(stderr, "BAUD %u refused\n", (unsigned)fast);
+      return 1;
+    }
+    usleep(50000);
+    (void)tcflush(s_fd, TCIFLUSH);
+    if (tty_cmd("PING", "PONG", NULL, line) != 0)
+    {
+      fprintf(stderr, "no PONG at %u\n", (unsigned)fast);
+      return 1;
+    }
+  }
+
+  (void)snprintf(cmd, sizeof(cmd), "UPDATE %zu", size);
+  if (tty_cmd(cmd, "OK UPDATE", "ERR UPDATE", line) != 0)
+  {
+    fprintf(stderr, "UPDATE refused (%s): too large, wrong link or not in this build\n", line);
+    return 1;
+  }
+  size_t frame_max = UPD_FRAME_MAX_DEFAULT;
+  const char *fm = strstr(line, "frame=");
+  if ((fm != NULL) && (strtoul(fm + 6, NULL, 10) < frame_max))
+  {
+    frame_max = strtoul(fm + 6, NULL, 10);
+  }
+  if (wait_ready() != 0)
+  {
+    fprintf(stderr, "no answer from the updater\n");
+    return 1;
+  }
+
+  const double t0 = now_s();
+  size_t sent = 0;
+  int r = 1;
+  for (uint32_t pass = 0; (r == 1) && (pass < UPD_RESTARTS); pass++)
+  {
+    r = update_pass(img, size, crc, frame_max, &sent);
+  }
+  if (r != 0)
+  {
+    fprintf(stderr, "update failed; the pedal waits in the updater, run again\n");
+    return 1;
+  }
+  const double dt = now_s() - t0;
+  printf("%zu bytes as %zu on the wire (%.0f%%) in %.1f s, pedal resetting\n", size, sent,
+         100.0 * (double)sent / (double)size, dt);
+  free(img);
+  close(s_fd);
+  return 0;
+}
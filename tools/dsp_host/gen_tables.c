@@ -0,0 +1,377 @@
+/*
+ * Writes Core/Src/app_tables.c, the shared lookup tables (app_tables.h),
+ * to stdout. Run by the app_tables target:
+ *   cmake --build build/dsp_host --target app_tables
+ * Every value is computed in double and rounded to nearest, so the output
+ * only changes when a definition below does.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "app_tables.h"
+
+static long q_round(double v)
+{
+  return (long)floor(v + 0.5);
+}
+
+/* One initializer body, row values per line at the given indent. */
+static void emit_values(const long *v, uint32_t n, uint32_t row, const char *indent)
+{
+  for (uint32_t i = 0; i < n; i++)
+  {
+    printf("%s%ld%s", ((i % row) == 0u) ? indent : "", v[i],
+           (i + 1u == n) ? "\n" : (((i % row) == (row - 1u)) ? ",\n" : ", "));
+  }
+}
+
+/* ---------------------------- Waveshaper curves -------------------------- */
+
+/* Sampled at x = -1 + k/256 (k = 0..512, full scale = 1) and rounded to
+ * Q15. a = 1.2M / 2^23 and b = 0.9M / 2^23 are the old hard clip knees.
+ */
+#define SHAPER_A (1.2e6 / 8388608.0)
+#define SHAPER_B (0.9e6 / 8388608.0)
+
+static double shaper_soft(double x)
+{
+  return x - ((x * x * x) / 3.0);
+}
+
+static double shaper_hard(double x)
+{
+  if (x > SHAPER_A)
+  {
+    return SHAPER_A + ((x - SHAPER_A) / 1024.0);
+  }
+  if (x < -SHAPER_B)
+  {
+    return -SHAPER_B + ((x + SHAPER_B) / 1024.0);
+  }
+  return x;
+}
+
+static double shaper_tube(double x)
+{
+  return (x >= 0.0) ? (SHAPER_A * tanh(x / SHAPER_A)) : (SHAPER_B * tanh(x / SHAPER_B));
+}
+
+static double shaper_diode(double x)
+{
+  return x / pow(1.0 + pow(fabs(x / SHAPER_A), 2.5), 0.4);
+}
+
+static double shaper_fuzz(double x)
+{
+  const double n = 0.6 * SHAPER_A;
+  return (x >= 0.0) ? (SHAPER_A * (1.0 - exp((-6.0 * x) / SHAPER_A))) : (-n * (1.0 - exp((6.0 * x) / n)));
+}
+
+static double shaper_asym(double x)
+{
+  return (x >= 0.0) ? (SHAPER_A * tanh(x / SHAPER_A)) : (x / (1.0 + (fabs(x) / (0.5 * SHAPER_A))));
+}
+
+typedef struct
+{
+  double (*fn)(double x);
+  const char *comment;
+} ShaperDef;
+
+/* In AppShaperCurve order. */
+static const ShaperDef k_shapers[APP_SHAPER_CURVE_COUNT] = {
+  {shaper_soft, "soft: cubic x - x^3/3 over full scale (input colour)"},
+  {shaper_hard, "hard: the original hard_tube_clip_s24 knees (+1.2M / -0.9M, 1/1024 slope)"},
+  {shaper_tube, "tube: tanh knee, +1.2M / -0.9M saturation"},
+  {shaper_diode, "diode: sharper knee x / (1 + |x/a|^2.5)^0.4, symmetric"},
+  {shaper_fuzz, "fuzz: exponential, near-square, negative side at 60%"},
+  {shaper_asym, "asym: tanh on +, softer 1/x knee on - (even harmonics)"},
+};
+
+static void emit_shaper(void)
+{
+  printf("/* Waveshaper curves, sampled at x = -1 + k/256 (k = 0..512, full scale = 1)\n"
+         " * and rounded to Q15. a = 1.2M / 2^23 and b = 0.9M / 2^23 are the old hard\n"
+         " * clip knees.\n"
+         " *\n"
+         " *   soft   x - x^3/3\n"
+         " *   hard   x inside [-b, a], beyond it the knee plus 1/1024 of the excess\n"
+         " *   tube   a*tanh(x/a) for x >= 0, b*tanh(x/b) below\n"
+         " *   diode  x / (1 + |x/a|^2.5)^0.4\n"
+         " *   fuzz   a*(1 - e^(-6x/a)) for x >= 0, -0.6a*(1 - e^(6x/0.6a)) below\n"
+         " *   asym   a*tanh(x/a) for x >= 0, x / (1 + |x|/0.5a) below\n"
+         " */\n"
+         "const int16_t AppTab_ShaperLut[APP_SHAPER_CURVE_COUNT][APP_SHAPER_LUT_SIZE] =\n{\n");
+  for (uint32_t c = 0; c < (uint32_t)APP_SHAPER_CURVE_COUNT; c++)
+  {
+    long v[APP_SHAPER_LUT_SIZE];
+    for (uint32_t k = 0; k < APP_SHAPER_LUT_SIZE; k++)
+    {
+      v[k] = q_round(k_shapers[c].fn(-1.0 + ((double)k / 256.0)) * 32768.0);
+    }
+    printf("  /* %s */\n  {\n", k_shapers[c].comment);
+    emit_values(v, APP_SHAPER_LUT_SIZE, 12u, "    ");
+    printf("  },\n");
+  }
+  printf("};\n");
+}
+
+/* ------------------------------ Math tables ------------------------------ */
+
+static void emit_table(const char *comment, const char *decl, double (*fn)(double u), uint32_t bits, double scale,
+                       uint32_t row)
+{
+  const uint32_t n = (1u << bits) + 1u;
+  long v[(1u << 8) + 1u];
+  for (uint32_t i = 0; i < n; i++)
+  {
+    v[i] = q_round(fn((double)i / (double)(1u << bits)) * scale);
+  }
+  printf("\n/* %s */\n%s =\n{\n", comment, decl);
+  emit_values(v, n, row, "  ");
+  printf("};\n");
+}
+
+static double tab_log2(double u)
+{
+  return log2(1.0 + u);
+}
+
+static double tab_exp2(double u)
+{
+  return exp2(u);
+}
+
+static double tab_sin(double u)
+{
+  return sin(1.5707963267948966 * u);
+}
+
+static double tab_recip(double u)
+{
+  return 1.0 / (1.0 + u);
+}
+
+/* ------------------------------- Tone stacks ----------------------------- */
+
+/* The passive bass/mid/treble network (D. Yeh, "Digital Implementation of
+ * Musical Distortion Circuits by Analysis and Simulation", 2009): R1
+ * treble, R2 bass, R3 mid pot, R4 slope resistor. l, m, t are the pot
+ * fractions; H(s) = (b1 s + b2 s^2 + b3 s^3) / (1 + a1 s + a2 s^2 + a3 s^3).
+ */
+typedef struct
+{
+  double r1, r2, r3, r4, c1, c2, c3;
+  const char *comment;
+} ToneStackDef;
+
+/* In AppDspToneModel order, from APP_DSP_TONE_FENDER. */
+static const ToneStackDef k_tone_stacks[APP_DSP_TONE_MODEL_COUNT - 1u] = {
+  {250e3, 1e6, 25e3, 56e3, 250e-12, 20e-9, 20e-9, "fender: '59 Bassman"},
+  {220e3, 1e6, 22e3, 33e3, 470e-12, 22e-9, 22e-9, "marshall: JCM800"},
+};
+
+static void tone_analog(const ToneStackDef *d, double l, double m, double t, double b[4], double a[4])
+{
+  const double r1 = d->r1, r2 = d->r2, r3 = d->r3, r4 = d->r4, c1 = d->c1, c2 = d->c2, c3 = d->c3;
+  b[0] = 0.0;
+  b[1] = (t * c1 * r1) + (m * c3 * r3) + (l * ((c1 * r2) + (c2 * r2))) + ((c1 * r3) + (c2 * r3));
+  b[2] = (t * ((c1 * c2 * r1 * r4) + (c1 * c3 * r1 * r4))) - (m * m * ((c1 * c3 * r3 * r3) + (c2 * c3 * r3 * r3))) +
+         (m * ((c1 * c3 * r1 * r3) + (c1 * c3 * r3 * r3) + (c2 * c3 * r3 * r3))) +
+         (l * ((c1 * c2 * r1 * r2) + (c1 * c2 * r2 * r4) + (c1 * c3 * r2 * r4))) +
+         (l * m * ((c1 * c3 * r2 * r3) + (c2 * c3 * r2 * r3))) +
+         ((c1 * c2 * r1 * r3) + (c1 * c2 * r3 * r4) + (c1 * c3 * r3 * r4));
+  b[3] = (l * m * ((c1 * c2 * c3 * r1 * r2 * r3) + (c1 * c2 * c3 * r2 * r3 * r4))) -
+         (m * m * ((c1 * c2 * c3 * r1 * r3 * r3) + (c1 * c2 * c3 * r3 * r3 * r4))) +
+         (m * ((c1 * c2 * c3 * r1 * r3 * r3) + (c1 * c2 * c3 * r3 * r3 * r4))) + (t * c1 * c2 * c3 * r1 * r3 * r4) -
+         (t * m * c1 * c2 * c3 * r1 * r3 * r4) + (t * l * c1 * c2 * c3 * r1 * r2 * r4);
+  a[0] = 1.0;
+  a[1] = ((c1 * r1) + (c1 * r3) + (c2 * r3) + (c2 * r4) + (c3 * r4)) + (m * c3 * r3) + (l * ((c1 * r2) + (c2 * r2)));
+  a[2] = (m * ((c1 * c3 * r1 * r3) - (c2 * c3 * r3 * r4) + (c1 * c3 * r3 * r3) + (c2 * c3 * r3 * r3))) +
+         (l * m * ((c1 * c3 * r2 * r3) + (c2 * c3 * r2 * r3))) - (m * m * ((c1 * c3 * r3 * r3) + (c2 * c3 * r3 * r3))) +
+         (l * ((c1 * c2 * r2 * r4) + (c1 * c2 * r1 * r2) + (c1 * c3 * r2 * r4) + (c2 * c3 * r2 * r4))) +
+         ((c1 * c2 * r1 * r4) + (c1 * c3 * r1 * r4) + (c1 * c2 * r3 * r4) + (c1 * c2 * r1 * r3) + (c1 * c3 * r3 * r4) +
+          (c2 * c3 * r3 * r4));
+  a[3] = (l * m * ((c1 * c2 * c3 * r1 * r2 * r3) + (c1 * c2 * c3 * r2 * r3 * r4))) -
+         (m * m * ((c1 * c2 * c3 * r1 * r3 * r3) + (c1 * c2 * c3 * r3 * r3 * r4))) +
+         (m * ((c1 * c2 * c3 * r3 * r3 * r4) + (c1 * c2 * c3 * r1 * r3 * r3) - (c1 * c2 * c3 * r1 * r3 * r4))) +
+         (l * c1 * c2 * c3 * r1 * r2 * r4) + (c1 * c2 * c3 * r1 * r3 * r4);
+}
+
+/* Coefficients of z^-j, j = 0..n, of (1 - z^-1)^k (1 + z^-1)^(n - k). */
+static void tone_bilinear_term(uint32_t k, uint32_t n, double *out)
+{
+  for (uint32_t j = 0; j <= n; j++)
+  {
+    out[j] = (j == 0u) ? 1.0 : 0.0;
+  }
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const double s = (i < k) ? -1.0 : 1.0;
+    for (uint32_t j = i + 1u; j > 0u; j--)
+    {
+      out[j] += s * out[j - 1u];
+    }
+  }
+}
+
+/* Knob (0..1) to pot fraction: bass on an audio taper (10% at noon), mid
+ * linear. The ends stay off the network's degenerate corner (bass 0 with
+ * mid 1 drops an order).
+ */
+static double tone_taper_bass(double k)
+{
+  return 0.002 + (0.998 * (pow(10.0, 2.0 * k) - 1.0) / 99.0);
+}
+
+static double tone_taper_mid(double k)
+{
+  return 0.98 * k;
+}
+
+typedef struct
+{
+  double p;
+  double a[2];
+  double b[3];
+  double bt[3];
+} ToneNode;
+
+/* One grid node: bilinear transform at fs (no prewarp), the DC zero and
+ * the lowest pole split off, the rest kept as one biquad.
+ */
+static void tone_node(const ToneStackDef *d, double kb, double km, double fs, double gain, ToneNode *o)
+{
+  const double c = 2.0 * fs;
+  double b0[4], b1[4], a[4];
+  tone_analog(d, tone_taper_bass(kb), tone_taper_mid(km), 0.0, b0, a);
+  tone_analog(d, tone_taper_bass(kb), tone_taper_mid(km), 1.0, b1, a);
+
+  double den[4] = {0.0, 0.0, 0.0, 0.0};
+  double q0[3] = {0.0, 0.0, 0.0};
+  double q1[3] = {0.0, 0.0, 0.0};
+  double ck = 1.0;
+  for (uint32_t k = 0; k <= 3u; k++)
+  {
+    double t[4];
+    tone_bilinear_term(k, 3u, t);
+    for (uint32_t j = 0; j <= 3u; j++)
+    {
+      den[j] += a[k] * ck * t[j];
+    }
+    if (k > 0u)
+    {
+      /* s = c (1 - z^-1) / (1 + z^-1): one (1 - z^-1) of every term is the DC zero. */
+      tone_bilinear_term(k - 1u, 2u, t);
+      for (uint32_t j = 0; j <= 2u; j++)
+      {
+        q0[j] += b0[k] * ck * t[j];
+        q1[j] += b1[k] * ck * t[j];
+      }
+    }
+    ck *= c;
+  }
+
+  /* All three poles are real: Newton from z = 1 falls onto the largest. */
+  const double d1 = den[1] / den[0], d2 = den[2] / den[0], d3 = den[3] / den[0];
+  double z = 1.0;
+  for (uint32_t i = 0; i < 100u; i++)
+  {
+    z -= ((((z + d1) * z) + d2) * z + d3) / ((((3.0 * z) + (2.0 * d1)) * z) + d2);
+  }
+  o->p = z;
+  o->a[0] = d1 + z;
+  o->a[1] = d2 + (z * o->a[0]);
+  for (uint32_t j = 0; j < 3u; j++)
+  {
+    o->b[j] = (q0[j] / den[0]) * gain;
+    o->bt[j] = ((q1[j] - q0[j]) / den[0]) * gain;
+  }
+}
+
+static double tone_node_db(const ToneNode *n, double t, double f, double fs)
+{
+  const double w = (2.0 * 3.141592653589793 * f) / fs;
+  const double cw = cos(w), sw = sin(w), c2w = cos(2.0 * w), s2w = sin(2.0 * w);
+  double nr = 0.0, ni = 0.0;
+  const double bc[3] = {n->b[0] + (t * n->bt[0]), n->b[1] + (t * n->bt[1]), n->b[2] + (t * n->bt[2])};
+  nr = bc[0] + (bc[1] * cw) + (bc[2] * c2w);
+  ni = -(bc[1] * sw) - (bc[2] * s2w);
+  const double dr = 1.0 + (n->a[0] * cw) + (n->a[1] * c2w);
+  const double di = -(n->a[0] * sw) - (n->a[1] * s2w);
+  /* (1 - z^-1) / (1 - p z^-1) */
+  const double hr = 1.0 - cw, hi = sw;
+  const double pr = 1.0 - (n->p * cw), pi = n->p * sw;
+  const double mag2 = (((nr * nr) + (ni * ni)) * ((hr * hr) + (hi * hi))) / (((dr * dr) + (di * di)) * ((pr * pr) + (pi * pi)));
+  return 10.0 * log10(mag2);
+}
+
+static void emit_tone_rate(double fs)
+{
+  const uint32_t g = APP_TAB_TONE_GRID;
+  for (uint32_t mdl = 0; mdl < (APP_DSP_TONE_MODEL_COUNT - 1u); mdl++)
+  {
+    const ToneStackDef *d = &k_tone_stacks[mdl];
+
+    /* Makeup: all knobs at noon peaks at 0 dB. */
+    ToneNode noon;
+    tone_node(d, 0.5, 0.5, fs, 1.0, &noon);
+    double peak = -1e9;
+    for (double f = 20.0; f < 20000.0; f *= 1.01)
+    {
+      const double db = tone_node_db(&noon, 0.5, f, fs);
+      peak = (db > peak) ? db : peak;
+    }
+    const double gain = pow(10.0, -peak / 20.0);
+
+    printf("  /* %s, makeup %+.1f dB */\n  {\n", d->comment, -peak);
+    for (uint32_t i = 0; i < g; i++)
+    {
+      printf("    {\n");
+      for (uint32_t j = 0; j < g; j++)
+      {
+        ToneNode n;
+        tone_node(d, (double)i / (double)(g - 1u), (double)j / (double)(g - 1u), fs, gain, &n);
+        printf("      {%ld, {%ld, %ld}, {%ld, %ld, %ld}, {%ld, %ld, %ld}},\n", q_round(n.p * 1073741824.0),
+               q_round(n.a[0] * 268435456.0), q_round(n.a[1] * 268435456.0), q_round(n.b[0] * 268435456.0),
+               q_round(n.b[1] * 268435456.0), q_round(n.b[2] * 268435456.0), q_round(n.bt[0] * 268435456.0),
+               q_round(n.bt[1] * 268435456.0), q_round(n.bt[2] * 268435456.0));
+      }
+      printf("    },\n");
+    }
+    printf("  },\n");
+  }
+}
+
+static void emit_tone(void)
+{
+  printf("\n/* Amp tone stacks: the passive network bilinear-transformed at the build\n"
+         " * rate on a 9 x 9 grid of bass (audio taper) and mid knob positions,\n"
+         " * treble as b + t * bt. Makeup puts the peak at noon on 0 dB.\n"
+         " */\n"
+         "const AppTabToneNode AppTab_ToneLut[APP_DSP_TONE_MODEL_COUNT - 1u][APP_TAB_TONE_GRID][APP_TAB_TONE_GRID] =\n"
+         "{\n#if APP_DSP_SAMPLE_RATE_HZ == 96000u\n");
+  emit_tone_rate(96000.0);
+  printf("#else\n");
+  emit_tone_rate(48000.0);
+  printf("#endif\n};\n");
+}
+
+int main(void)
+{
+  printf("/* Generated by tools/dsp_host/gen_tables.c, do not edit (app_tables.h). */\n\n"
+         "#include \"app_tables.h\"\n\n");
+  emit_shaper();
+  emit_table("log2(1 + i/32), Q16 octaves.", "const int32_t AppTab_Log2Lut[(1u << APP_TAB_LOG2_BITS) + 1u]",
+             tab_log2, APP_TAB_LOG2_BITS, 65536.0, 11u);
+  emit_table("2^(i/32), Q15.", "const int32_t AppTab_Exp2Lut[(1u << APP_TAB_LOG2_BITS) + 1u]",
+             tab_exp2, APP_TAB_LOG2_BITS, 32768.0, 11u);
+  emit_table("sin(pi/2 * i/256), Q15 (unsigned: the last entry is 32768).",
+             "const uint16_t AppTab_SinLut[(1u << APP_TAB_SIN_BITS) + 1u]", tab_sin, APP_TAB_SIN_BITS, 32768.0, 12u);
+  emit_table("1 / (1 + i/256), Q30.", "const uint32_t AppTab_RecipLut[(1u << APP_TAB_RECIP_BITS) + 1u]",
+             tab_recip, APP_TAB_RECIP_BITS, 1073741824.0, 8u);
+  emit_tone();
+  return 0;
+}
@@ -0,0 +1,169 @@
+#include "host_wav.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t rd_u16(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t rd_u32(const uint8_t *p)
+{
+  return rd_u16(p) | (rd_u16(p + 2) << 16);
+}
+
+static int32_t clamp_s24(int64_t v)
+{
+  if (v > 8388607)
+  {
+    return 8388607;
+  }
+  if (v < -8388608)
+  {
+    return -8388608;
+  }
+  return (int32_t)v;
+}
+
+int host_wav_parse(const char *path, const uint8_t *buf, size_t size, HostWav *w)
+{
+  if ((size <= 12u) || (memcmp(buf, "RIFF", 4) != 0) || (memcmp(buf + 8, "WAVE", 4) != 0))
+  {
+    fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+    return 0;
+  }
+
+  uint32_t fmt = 0, channels = 0, rate = 0, bits = 0;
+  const uint8_t *data = NULL;
+  uint32_t data_len = 0;
+  for (size_t pos = 12; (pos + 8u) <= size;)
+  {
+    const uint8_t *ck = buf + pos;
+    uint32_t len = rd_u32(ck + 4);
+    if ((uint64_t)pos + 8u + len > (uint64_t)size)
+    {
+      len = (uint32_t)(size - pos - 8u);
+    }
+    if ((memcmp(ck, "fmt ", 4) == 0) && (len >= 16u))
+    {
+      fmt = rd_u16(ck + 8);
+      channels = rd_u16(ck + 10);
+      rate = rd_u32(ck + 12);
+      bits = rd_u16(ck + 22);
+      if ((fmt == 0xFFFEu) && (len >= 26u))
+      {
+        fmt = rd_u16(ck + 32); /* WAVE_FORMAT_EXTENSIBLE sub-format */
+      }
+    }
+    else if (memcmp(ck, "data", 4) == 0)
+    {
+      data = ck + 8;
+      data_len = len;
+    }
+    pos += 8u + (size_t)len + (size_t)(len & 1u);
+  }
+
+  const uint32_t bytes = bits / 8u;
+  if ((data == NULL) || ((channels != 1u) && (channels != 2u)) ||
+      !(((fmt == 1u) && ((bits == 16u) || (bits == 24u) || (bits == 32u))) || ((fmt == 3u) && (bits == 32u))))
+  {
+    fprintf(stderr, "%s: need PCM 16/24/32 or float32, mono or stereo\n", path);
+    return 0;
+  }
+  if (rate != APP_DSP_SAMPLE_RATE_HZ)
+  {
+    fprintf(stderr, "%s: warning: %lu Hz, processed as %u Hz\n", path, (unsigned long)rate, APP_DSP_SAMPLE_RATE_HZ);
+  }
+
+  w->fmt = fmt;
+  w->channels = channels;
+  w->rate = rate;
+  w->bits = bits;
+  w->frames = data_len / (bytes * channels);
+  w->data = data;
+  return 1;
+}
+
+void host_wav_decode(const HostWav *w, AppStereoS24 *x)
+{
+  const uint32_t bytes = w->bits / 8u;
+  for (uint32_t i = 0; i < w->frames; i++)
+  {
+    int32_t s[2] = {0, 0};
+    for (uint32_t c = 0; c < w->channels; c++)
+    {
+      const uint8_t *p = w->data + ((i * w->channels) + c) * bytes;
+      if (w->fmt == 3u)
+      {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        s[c] = clamp_s24((int64_t)lrint((double)v * 8388608.0));
+      }
+      else if (w->bits == 16u)
+      {
+        s[c] = (int32_t)(int16_t)rd_u16(p) * 256;
+      }
+      else if (w->bits == 24u)
+      {
+        s[c] = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+      }
+      else
+      {
+        s[c] = (int32_t)rd_u32(p) >> 8;
+      }
+    }
+    x[i].l = s[0];
+    x[i].r = (w->channels == 2u) ? s[1] : s[0];
+  }
+}
+
+static void wr_u16(FILE *f, uint32_t v)
+{
+  fputc((int)(v & 0xFFu), f);
+  fputc((int)((v >> 8) & 0xFFu), f);
+}
+
+static void wr_u32(FILE *f, uint32_t v)
+{
+  wr_u16(f, v & 0xFFFFu);
+  wr_u16(f, v >> 16);
+}
+
+int host_wav_write(const char *path, const AppStereoS24 *x, uint32_t frames)
+{
+  FILE *f = fopen(path, "wb");
+  if (f == NULL)
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 0;
+  }
+  const uint32_t data_len = frames * 6u;
+  fwrite("RIFF", 1, 4, f);
+  wr_u32(f, 36u + data_len);
+  fwrite("WAVEfmt ", 1, 8, f);
+  wr_u32(f, 16u);
+  wr_u16(f, 1u);
+  wr_u16(f, 2u);
+  wr_u32(f, APP_DSP_SAMPLE_RATE_HZ);
+  wr_u32(f, APP_DSP_SAMPLE_RATE_HZ * 6u);
+  wr_u16(f, 6u);
+  wr_u16(f, 24u);
+  fwrite("data", 1, 4, f);
+  wr_u32(f, data_len);
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    const int32_t s[2] = {x[i].l, x[i].r};
+    for (uint32_t c = 0; c < 2u; c++)
+    {
+      fputc(s[c] & 0xFF, f);
+      fputc((s[c] >> 8) & 0xFF, f);
+      fputc((s[c] >> 16) & 0xFF, f);
+    }
+  }
+  int ok = (ferror(f) == 0);
+  fclose(f);
+  return ok;
+}
@@ -0,0 +1,34 @@
+#ifndef HOST_WAV_H
+#define HOST_WAV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_dsp.h"
+
+/* WAV files for the host tools (dsp_host, dsp_render). Parsing works on a
+ * file image in memory, read or mapped by the caller: PCM 16/24/32-bit or
+ * float 32-bit, mono or stereo. Output is always 24-bit PCM stereo at the
+ * build rate.
+ */
+typedef struct
+{
+  uint32_t fmt;                  /* 1 PCM, 3 float */
+  uint32_t channels;
+  uint32_t rate;
+  uint32_t bits;
+  uint32_t frames;
+  const uint8_t *data;           /* into the image */
+} HostWav;
+
+/* Returns 0 with a message on stderr if the image is not a supported WAV;
+ * warns if the rate is not the build rate (processed as that anyway).
+ */
+int host_wav_parse(const char *path, const uint8_t *buf, size_t size, HostWav *w);
+
+/* All frames as s24 stereo into x (mono feeds both sides). */
+void host_wav_decode(const HostWav *w, AppStereoS24 *x);
+
+int host_wav_write(const char *path, const AppStereoS24 *x, uint32_t frames);
+
+#endif /* HOST_WAV_H */
@@ -0,0 +1,22 @@
+#ifndef DSP_HOST_STM32G4XX_HAL_H
+#define DSP_HOST_STM32G4XX_HAL_H
+
+#include <stdint.h>
+
+/* Host stand-in for the HAL header: only the interrupt mask intrinsics the
+ * DSP-side modules (app_meter.c) use. One thread, so they do nothing.
+ */
+static inline uint32_t __get_PRIMASK(void)
+{
+  return 0u;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+static inline void __enable_irq(void)
+{
+}
+
+#endif /* DSP_HOST_STM32G4XX_HAL_H */
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Compares two captures of BENCH lines: a baseline and a new run, from COM
+# BENCH or BENCH KERNEL (a terminal log or dsp_ctl output will do; "#<seq>"
+# tags are dropped), m4_bench.sh or dsp_host -K. Items pair up by kind and
+# name; the figure compared is the first <unit>_frame= of the line
+# (cyc_frame= or ns_frame=). Prints one row per item,
+#
+#   kernel  reverb_process_s24/block   412.0   398.5   -3.3%  faster
+#
+# and exits with status 2 if one got slower by more than -t percent
+# (default 1) or is missing from either side. Target and emulator counts
+# repeat exactly; host ns do not, so give dsp_host runs a wider -t.
+#
+# Usage: tools/m4_bench/bench_diff.sh [-t pct] [-a] baseline.txt new.txt
+#   -a lists unchanged items too
+
+set -e
+
+tol=1
+all=0
+while getopts t:ah opt; do
+  case $opt in
+    t) tol=$OPTARG ;;
+    a) all=1 ;;
+    *) sed -n '2,16p' "$0" >&2; exit 2 ;;
+  esac
+done
+shift $((OPTIND - 1))
+[ $# -eq 2 ] || { sed -n '2,16p' "$0" >&2; exit 2; }
+
+awk -v tol="$tol" -v all="$all" '
+  function val(   i) { for (i = 4; i <= NF; i++) if ($i ~ /_frame=/) { sub(/.*=/, "", $i); return $i + 0 } return 0 }
+  function pct(a, b) { return (a > 0) ? (b / a - 1) * 100 : 0 }
+  function row(k, a, b, what) { printf "%-7s %-32s %9.1f %9.1f %+7.1f%%  %s\n", kind[k], name[k], a, b, pct(a, b), what }
+  { sub(/^#[0-9]+ /, "") }
+  $1 != "BENCH" { next }
+  { k = $2 " " $3; kind[k] = $2; name[k] = $3 }
+  FNR == NR { base[k] = val(); order[++nb] = k; next }
+  {
+    now = val(); seen[k] = 1
+    if (!(k in base)) { printf "%-7s %-32s %9s %9.1f %8s  new\n", $2, $3, "-", now, ""; bad = 1; next }
+    if (now > base[k] * (1 + tol / 100)) { row(k, base[k], now, "SLOWER"); bad = 1 }
+    else if (now < base[k]) row(k, base[k], now, "faster")
+    else if (now > base[k]) row(k, base[k], now, "within " tol "%")
+    else if (all) row(k, base[k], now, "same")
+  }
+  END {
+    for (i = 1; i <= nb; i++) if (!(order[i] in seen)) { printf "%-7s %-32s %9.1f %9s %8s  MISSING\n", kind[order[i]], name[order[i]], base[order[i]], "-", ""; bad = 1 }
+    exit bad ? 2 : 0
+  }' "$1" "$2"
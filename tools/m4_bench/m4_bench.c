@@ -0,0 +1,182 @@
+/*
+ * Cycle benchmark of the DSP kernels on an emulated Cortex-M4 (Renode), so
+ * a change can be checked for a cycle regression without a board.
+ * - Runs what COM BENCH runs: AppDsp_BenchStage() for every stage kernel
+ *   and AppDsp_BenchChain() for every FX mask, over the firmware's own
+ *   app_dsp.c built with its target flags (CMakeLists.txt), and prints
+ *   the same "BENCH stage|chain <name> cyc_frame=<x.y> load=<x.y>%" lines,
+ *   then the DSP half of COM BENCH KERNEL (AppDsp_BenchKernel(), per frame
+ *   and per block; the audio-path kernels need the HAL and run on the
+ *   board only), and "OK BENCH ..." on USART2, on which m4_bench.resc quits.
+ * - Renode executes one instruction per cycle and its DWT counts at the
+ *   instruction rate (m4_bench.repl), so cyc_frame= is instructions per
+ *   frame: no flash wait states, no load/store or branch penalties, no
+ *   bus contention. It reads below the board's BENCH, but it is exact and
+ *   repeatable, and it moves with every change to the code the kernels
+ *   run, which is what a regression check needs (m4_bench.sh -g).
+ * - M4_BENCH_BLOCKS and M4_BENCH_FRAMES are BENCH's <blocks> and <frames>;
+ *   the count does not vary from block to block here, so a few blocks do.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_dsp.h"
+#include "app_prof.h"
+
+#ifndef M4_BENCH_BLOCKS
+#define M4_BENCH_BLOCKS 10u
+#endif
+
+#ifndef M4_BENCH_FRAMES
+#define M4_BENCH_FRAMES 64u          /* APP_AUDIO_LATENCY_SAFE, the default */
+#endif
+
+/* The firmware's HCLK (SystemClock_Config(): HSI 16 MHz / 4 * 85 / 2). */
+uint32_t SystemCoreClock = 170000000u;
+
+/* ---- USART2, polled (the register layout of the G4 USART) ---- */
+
+#define USART2_BASE_ADDR 0x40004400UL
+#define USART_CR1        (*(volatile uint32_t *)(USART2_BASE_ADDR + 0x00u))
+#define USART_BRR        (*(volatile uint32_t *)(USART2_BASE_ADDR + 0x0Cu))
+#define USART_ISR        (*(volatile uint32_t *)(USART2_BASE_ADDR + 0x1Cu))
+#define USART_TDR        (*(volatile uint32_t *)(USART2_BASE_ADDR + 0x28u))
+#define USART_CR1_UE     (1u << 0)
+#define USART_CR1_TE     (1u << 3)
+#define USART_ISR_TXE    (1u << 7)
+
+static void uart_init(void)
+{
+  USART_BRR = SystemCoreClock / 115200u;
+  USART_CR1 = USART_CR1_UE | USART_CR1_TE;
+}
+
+static void uart_line(const char *s)
+{
+  for (; *s != '\0'; s++)
+  {
+    while ((USART_ISR & USART_ISR_TXE) == 0u)
+    {
+    }
+    USART_TDR = (uint8_t)*s;
+  }
+  while ((USART_ISR & USART_ISR_TXE) == 0u)
+  {
+  }
+  USART_TDR = '\n';
+}
+
+/* As send_bench() in app_com.c. */
+static void bench_line(const char *kind, const char *name, uint64_t cycles, uint64_t frames)
+{
+  const uint32_t cyc_x10 = (frames != 0u) ? (uint32_t)((cycles * 10u) / frames) : 0u;
+  const uint32_t budget = AppProf_CyclesPerFrame();
+  const uint32_t load_pm = (budget != 0u) ? (uint32_t)((cyc_x10 * 100ull) / budget) : 0u;
+
+  char buf[96];
+  (void)snprintf(buf, sizeof(buf), "BENCH %s %s cyc_frame=%lu.%lu load=%lu.%lu%%",
+                 kind, name,
+                 (unsigned long)(cyc_x10 / 10u), (unsigned long)(cyc_x10 % 10u),
+                 (unsigned long)(load_pm / 10u), (unsigned long)(load_pm % 10u));
+  uart_line(buf);
+}
+
+static AppStereoS24 s_x[M4_BENCH_FRAMES];
+
+int main(void)
+{
+  uart_init();
+  AppProf_Init();
+  AppDsp_InitAtBoot();
+
+  const uint64_t total = (uint64_t)M4_BENCH_BLOCKS * M4_BENCH_FRAMES;
+  for (uint32_t i = 0; i < (uint32_t)APP_PROF_STAGE_COUNT; i++)
+  {
+    bench_line("stage", AppProf_StageName((AppProfStage)i),
+               AppDsp_BenchStage(i, s_x, M4_BENCH_FRAMES, M4_BENCH_BLOCKS), total);
+  }
+  for (uint32_t m = 0; m < APP_PROF_MASK_COUNT; m++)
+  {
+    char name[16];
+    (void)snprintf(name, sizeof(name), "fxmask=%lu", (unsigned long)m);
+    bench_line("chain", name, AppDsp_BenchChain((AppFxMask)m, s_x, M4_BENCH_FRAMES, M4_BENCH_BLOCKS), total);
+  }
+  for (uint32_t k = 0; k < (uint32_t)APP_DSP_KERNEL_COUNT; k++)
+  {
+    for (uint32_t v = 0; v < 2u; v++)
+    {
+      const uint8_t per_frame = (v == 0u) ? 1u : 0u;
+      char name[40];
+      (void)snprintf(name, sizeof(name), "%s/%s", AppDsp_KernelName((AppDspKernel)k), per_frame ? "frame" : "block");
+      bench_line("kernel", name, AppDsp_BenchKernel((AppDspKernel)k, per_frame, s_x, M4_BENCH_FRAMES, M4_BENCH_BLOCKS),
+                 total);
+    }
+  }
+
+  char buf[80];
+  (void)snprintf(buf, sizeof(buf), "OK BENCH blocks=%lu frames=%lu budget_cyc=%lu",
+                 (unsigned long)M4_BENCH_BLOCKS, (unsigned long)M4_BENCH_FRAMES,
+                 (unsigned long)AppProf_CyclesPerFrame());
+  uart_line(buf);
+  for (;;)
+  {
+  }
+}
+
+/* ---- startup ---- */
+
+extern uint32_t _estack;
+extern uint32_t _sidata, _sdata, _edata;
+extern uint32_t _siccm, _sccm, _eccm;
+extern uint32_t _sbss, _ebss;
+extern uint32_t _sccmbss, _eccmbss;
+
+#define SCB_CPACR (*(volatile uint32_t *)0xE000ED88UL)
+
+void Reset_Handler(void);
+
+static void Default_Handler(void)
+{
+  for (;;)
+  {
+  }
+}
+
+/* Initial SP, reset and the 14 core exceptions; nothing here takes an IRQ. */
+__attribute__((section(".isr_vector"), used))
+static void (*const s_vectors[16])(void) =
+{
+  (void (*)(void))(uintptr_t)&_estack,
+  Reset_Handler,
+  Default_Handler, Default_Handler, Default_Handler, Default_Handler, Default_Handler,
+  Default_Handler, Default_Handler, Default_Handler, Default_Handler, Default_Handler,
+  Default_Handler, Default_Handler, Default_Handler, Default_Handler,
+};
+
+void Reset_Handler(void)
+{
+  /* FPU on (CP10, CP11 full access) before any code that may use it. */
+  SCB_CPACR |= 0xFu << 20;
+  __asm volatile ("dsb\n\tisb" ::: "memory");
+
+  for (uint32_t *s = &_sidata, *d = &_sdata; d < &_edata;)
+  {
+    *d++ = *s++;
+  }
+  for (uint32_t *s = &_siccm, *d = &_sccm; d < &_eccm;)
+  {
+    *d++ = *s++;
+  }
+  for (uint32_t *d = &_sbss; d < &_ebss;)
+  {
+    *d++ = 0u;
+  }
+  for (uint32_t *d = &_sccmbss; d < &_eccmbss;)
+  {
+    *d++ = 0u;
+  }
+  (void)main();
+  Default_Handler();
+}
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Builds m4_bench, runs it in Renode and prints its BENCH lines.
+# -G file saves them as the baseline; -g file checks them against one
+# with bench_diff.sh: a stage, chain or kernel whose cyc_frame= grew by
+# more than -t percent (default 1; the counts are exact, so 0 works too),
+# or one missing from either side, fails with exit status 2, as dsp_host
+# -g does. Record the baseline on the commit before a change, check after.
+#
+# Usage: tools/m4_bench/m4_bench.sh [-B builddir] [-t pct] [-D def]...
+#                                   [-g baseline | -G baseline]
+#   -D adds a firmware definition (M4_BENCH_DEFINES), e.g. -D APP_USE_CCM=1
+# Needs arm-none-eabi-gcc and renode on PATH.
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+build=build/m4_bench
+tol=1
+defs=
+check=
+write=
+while getopts B:t:D:g:G:h opt; do
+  case $opt in
+    B) build=$OPTARG ;;
+    t) tol=$OPTARG ;;
+    D) defs="${defs:+$defs;}$OPTARG" ;;
+    g) check=$OPTARG ;;
+    G) write=$OPTARG ;;
+    *) sed -n '2,12p' "$0" >&2; exit 2 ;;
+  esac
+done
+
+cmake -S "$here" -B "$build" -DCMAKE_TOOLCHAIN_FILE="$here/arm-none-eabi.cmake" \
+  -DM4_BENCH_DEFINES="$defs" >/dev/null
+cmake --build "$build" >/dev/null
+
+out="$build/bench.txt"
+rm -f "$out"
+# Renode quits on OK BENCH; the timeout only catches a hang.
+timeout 600 renode --disable-xwt --console --plain \
+  -e "\$elf=@$build/m4_bench.elf; \$out=@$out; include @$here/m4_bench.resc" >/dev/null
+grep -q '^OK BENCH' "$out" || { echo "m4_bench: no OK BENCH in $out" >&2; exit 1; }
+grep '^BENCH\|^OK BENCH' "$out"
+
+if [ -n "$write" ]; then
+  grep '^BENCH' "$out" > "$write"
+fi
+if [ -n "$check" ]; then
+  "$here/bench_diff.sh" -t "$tol" "$check" "$out" >&2
+fi